@@ -0,0 +1,101 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file AggregateGroups.h
+ *
+ * The results of an aggregate for all the groups of its relation, indexed by
+ * the values of the columns the aggregate is bound to.
+ *
+ * An aggregate nested in a loop is otherwise evaluated anew for every tuple
+ * of the loop, scanning the same range of its relation again where tuples of
+ * the loop bind it to the same values. Computing the results of all groups
+ * in a single pass over the relation instead turns each evaluation into a
+ * lookup. Threads fold the tuples of their part of the relation into groups
+ * of their own, merged into the shared groups once they are done.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "CompiledTuple.h"
+#include "ParallelUtils.h"
+#include "RamTypes.h"
+
+#include <cstddef>
+#include <unordered_map>
+
+namespace souffle {
+
+/**
+ * The aggregated values of the groups of a relation, each group being
+ * identified by a key of the given arity.
+ */
+template <size_t Arity>
+class AggregateGroups {
+public:
+    using key_type = ram::Tuple<RamDomain, Arity>;
+
+    /**
+     * Returns the value of a group, inserting it with the given initial value
+     * of the aggregate if it is not yet present.
+     */
+    RamDomain& get(const key_type& key, RamDomain init) {
+        return groups.emplace(key, init).first->second;
+    }
+
+    /**
+     * Merges the groups of another table into this one, combining the values
+     * of the groups present in both. Threads may merge concurrently.
+     */
+    template <typename Combine>
+    void merge(const AggregateGroups& other, Combine combine) {
+        auto lease = lock.acquire();
+        (void)lease;
+        for (const auto& cur : other.groups) {
+            auto pos = groups.emplace(cur.first, cur.second);
+            if (!pos.second) {
+                pos.first->second = combine(pos.first->second, cur.second);
+            }
+        }
+    }
+
+    /**
+     * Returns the value of a group, or the initial value of the aggregate if
+     * no tuple falls into the group.
+     */
+    RamDomain find(const key_type& key, RamDomain init) const {
+        auto pos = groups.find(key);
+        return pos == groups.end() ? init : pos->second;
+    }
+
+    /** Marks the groups as computed for all the tuples of the relation */
+    void complete() {
+        completed = true;
+    }
+
+    /** Whether the groups have been computed, such that lookups replace evaluating the aggregate */
+    bool isComplete() const {
+        return completed;
+    }
+
+    size_t size() const {
+        return groups.size();
+    }
+
+private:
+    std::unordered_map<key_type, RamDomain> groups;
+
+    /** guards merging the groups of threads */
+    Lock lock;
+
+    bool completed = false;
+};
+
+}  // namespace souffle
@@ -0,0 +1,345 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file AppendBuffer.h
+ *
+ * A concurrent, append-only buffer of fixed length integer tuples, for
+ * collecting tuples that are only scanned and merged into other relations.
+ *
+ * Tuples are stored column-wise in cache-line aligned blocks. Every
+ * operation context owns the block it is appending to, such that threads
+ * only synchronize when they need a fresh block and never write to the same
+ * cache line. Duplicates are not detected on insertion; consolidating the
+ * buffer sorts its content and removes duplicates, after which the tuples
+ * may be merged into an ordered index in sequence.
+ *
+ * Multiple insert operations can be conducted concurrently on a buffer, as
+ * can read-only operations. However, inserts and read operations may not be
+ * conducted at the same time.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "CompiledTuple.h"
+#include "ParallelUtils.h"
+#include "RamTypes.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * An unordered collection of tuples of the given arity, stored column-wise
+ * in blocks of a fixed number of tuples.
+ *
+ * @tparam N the arity of the stored tuples
+ */
+template <unsigned N>
+class AppendBuffer {
+public:
+    using entry_type = ram::Tuple<RamDomain, N>;
+    using element_type = entry_type;
+
+private:
+    // the size of a cache line, the alignment of blocks and columns
+    enum { CACHE_LINE = 64 };
+
+    // the number of tuples per block, such that each column covers whole cache lines
+    enum { BLOCK_SIZE = 256 };
+
+    /**
+     * A block of tuples. The fill level is kept in a cache line of its own,
+     * followed by the columns.
+     */
+    struct Block {
+        // the number of tuples in this block
+        std::size_t used;
+
+        // padding separating the fill level from the content
+        char padding[CACHE_LINE - sizeof(std::size_t)];
+
+        // the values of the tuples, column by column
+        RamDomain columns[N][BLOCK_SIZE];
+
+        bool isFull() const {
+            return used == BLOCK_SIZE;
+        }
+
+        void append(const entry_type& t) {
+            for (unsigned i = 0; i < N; ++i) {
+                columns[i][used] = t[i];
+            }
+            used++;
+        }
+
+        void get(std::size_t pos, entry_type& t) const {
+            for (unsigned i = 0; i < N; ++i) {
+                t[i] = columns[i][pos];
+            }
+        }
+    };
+
+    // creates an empty, cache-line aligned block
+    static Block* createBlock() {
+        void* res = nullptr;
+        if (posix_memalign(&res, CACHE_LINE, sizeof(Block)) != 0) {
+            throw std::bad_alloc();
+        }
+        auto* block = static_cast<Block*>(res);
+        block->used = 0;
+        return block;
+    }
+
+    // the blocks of this buffer, in order of their creation
+    std::vector<Block*> blocks;
+
+    // a lock synchronizing the creation of blocks
+    Lock lock;
+
+public:
+    /**
+     * The context of insertions, referencing the block currently appended to.
+     * A context must not be shared among threads, and is invalidated by
+     * clearing or consolidating the buffer.
+     */
+    struct op_context {
+        Block* block = nullptr;
+    };
+
+private:
+    // the context of insertions conducted without a context
+    op_context sharedContext;
+
+    // a lock synchronizing insertions conducted without a context
+    Lock sharedLock;
+
+    // appends a fresh block to the list of blocks
+    Block* addBlock() {
+        Block* res = createBlock();
+        auto lease = lock.acquire();
+        (void)lease;
+        blocks.push_back(res);
+        return res;
+    }
+
+public:
+    /**
+     * An iterator over the tuples of a buffer, block by block.
+     */
+    class iterator : public std::iterator<std::forward_iterator_tag, entry_type> {
+        // the current block, null for the end of the buffer
+        Block* const* block = nullptr;
+
+        // the block following the last one to be visited
+        Block* const* last = nullptr;
+
+        // the position within the current block
+        std::size_t pos = 0;
+
+        // the current tuple
+        entry_type value;
+
+        // moves forward to the next block holding tuples, if the current one is exhausted
+        void normalize() {
+            while (block != last && pos == (*block)->used) {
+                ++block;
+                pos = 0;
+            }
+            if (block == last) {
+                block = nullptr;
+                pos = 0;
+                return;
+            }
+            (*block)->get(pos, value);
+        }
+
+    public:
+        iterator() = default;
+
+        iterator(Block* const* block, Block* const* last) : block(block), last(last) {
+            normalize();
+        }
+
+        bool operator==(const iterator& other) const {
+            return block == other.block && pos == other.pos;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+        const entry_type& operator*() const {
+            return value;
+        }
+
+        const entry_type* operator->() const {
+            return &value;
+        }
+
+        iterator& operator++() {
+            ++pos;
+            normalize();
+            return *this;
+        }
+
+        iterator operator++(int) {
+            auto res = *this;
+            ++(*this);
+            return res;
+        }
+    };
+
+    using const_iterator = iterator;
+
+    AppendBuffer() = default;
+
+    AppendBuffer(const AppendBuffer&) = delete;
+    AppendBuffer& operator=(const AppendBuffer&) = delete;
+
+    ~AppendBuffer() {
+        clear();
+    }
+
+    /**
+     * Appends the given tuple to this buffer.
+     *
+     * @return true, since duplicates are only removed when consolidating
+     */
+    bool insert(const entry_type& t) {
+        auto lease = sharedLock.acquire();
+        (void)lease;
+        return insert(t, sharedContext);
+    }
+
+    /**
+     * Appends the given tuple to the block of the given context.
+     *
+     * @return true, since duplicates are only removed when consolidating
+     */
+    bool insert(const entry_type& t, op_context& ctxt) {
+        if (ctxt.block == nullptr || ctxt.block->isFull()) {
+            ctxt.block = addBlock();
+        }
+        ctxt.block->append(t);
+        return true;
+    }
+
+    /**
+     * Appends all tuples of the given buffer to this buffer.
+     */
+    void insertAll(const AppendBuffer& other) {
+        if (this == &other) {
+            return;
+        }
+        op_context ctxt;
+        for (const auto& cur : other) {
+            insert(cur, ctxt);
+        }
+    }
+
+    /**
+     * Sorts the content of this buffer lexicographically and eliminates
+     * duplicates, packing the tuples into as few blocks as possible.
+     */
+    void consolidate() {
+        std::vector<entry_type> content(begin(), end());
+        std::sort(content.begin(), content.end());
+        content.erase(std::unique(content.begin(), content.end()), content.end());
+
+        // refill the existing blocks in order, releasing the surplus
+        std::size_t numBlocks = (content.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        for (std::size_t i = numBlocks; i < blocks.size(); ++i) {
+            std::free(blocks[i]);
+        }
+        blocks.resize(numBlocks);
+        auto cur = content.begin();
+        for (Block* block : blocks) {
+            block->used = 0;
+            for (; cur != content.end() && !block->isFull(); ++cur) {
+                block->append(*cur);
+            }
+        }
+        sharedContext = op_context();
+    }
+
+    /**
+     * Partitions this buffer into approximately the given number of ranges,
+     * each covering whole blocks.
+     */
+    std::vector<range<iterator>> partition(std::size_t num) const {
+        std::vector<range<iterator>> res;
+        const std::size_t step = std::max<std::size_t>(1, blocks.size() / std::max<std::size_t>(1, num));
+        Block* const* first = blocks.data();
+        Block* const* last = first + blocks.size();
+        for (Block* const* cur = first; cur < last; cur += std::min<std::size_t>(step, last - cur)) {
+            Block* const* next = cur + std::min<std::size_t>(step, last - cur);
+            iterator a(cur, next);
+            if (a != iterator()) {
+                res.push_back(range<iterator>(a, iterator()));
+            }
+        }
+        return res;
+    }
+
+    iterator begin() const {
+        return iterator(blocks.data(), blocks.data() + blocks.size());
+    }
+
+    iterator end() const {
+        return iterator();
+    }
+
+    bool empty() const {
+        for (const Block* block : blocks) {
+            if (block->used != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Obtains the number of tuples in this buffer, including duplicates unless consolidated.
+     */
+    std::size_t size() const {
+        std::size_t res = 0;
+        for (const Block* block : blocks) {
+            res += block->used;
+        }
+        return res;
+    }
+
+    /**
+     * Obtains an estimate of the number of bytes occupied by this buffer.
+     */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) + blocks.capacity() * sizeof(Block*) + blocks.size() * sizeof(Block);
+    }
+
+    /**
+     * Removes all tuples from this buffer.
+     */
+    void clear() {
+        for (Block* block : blocks) {
+            std::free(block);
+        }
+        blocks.clear();
+        sharedContext = op_context();
+    }
+};
+
+}  // end namespace souffle
@@ -0,0 +1,129 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file AstFactTable.h
+ *
+ * Defines a compact table of the ground facts of a relation.
+ *
+ * Generated programs may list millions of facts. The parser keeps the facts
+ * of a declared relation whose constants match the types of its attributes
+ * in a table of plain tuples rather than as clauses, such that they neither
+ * occupy the AST nor pass through its transformations, and are translated
+ * straight into insertions.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "AstArgument.h"
+#include "AstClause.h"
+#include "AstLiteral.h"
+#include "AstRelationIdentifier.h"
+#include "RamTypes.h"
+#include "SrcLocation.h"
+#include "SymbolTable.h"
+
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * The ground facts of a relation, each being a tuple of numbers and of
+ * the indexes of symbols in the symbol table.
+ */
+class AstFactTable {
+public:
+    /** Creates an empty table of the given columns, located at its first fact */
+    AstFactTable(std::vector<bool> symbolic, SymbolTable& symbolTable, SrcLocation loc)
+            : symbolic(std::move(symbolic)), symbolTable(symbolTable), loc(std::move(loc)) {
+        assert(!this->symbolic.empty() && "Nullary facts are kept as clauses");
+    }
+
+    /** Returns the number of columns of the facts */
+    size_t getArity() const {
+        return symbolic.size();
+    }
+
+    /** Returns the number of facts */
+    size_t size() const {
+        return values.size() / getArity();
+    }
+
+    /** Whether the given column holds symbols rather than numbers */
+    bool isSymbolic(size_t column) const {
+        return symbolic[column];
+    }
+
+    /** Returns the location of the first fact of the table */
+    const SrcLocation& getSrcLoc() const {
+        return loc;
+    }
+
+    /** Returns the values of the i-th fact */
+    const RamDomain* operator[](size_t i) const {
+        return &values[i * getArity()];
+    }
+
+    /** Appends a fact */
+    void insert(const std::vector<RamDomain>& tuple) {
+        assert(tuple.size() == getArity() && "Fact of another arity");
+        values.insert(values.end(), tuple.begin(), tuple.end());
+    }
+
+    /** Creates the clause of the i-th fact of the given relation */
+    std::unique_ptr<AstClause> getClause(const AstRelationIdentifier& name, size_t i) const {
+        auto head = std::make_unique<AstAtom>(name);
+        head->setSrcLoc(loc);
+        const RamDomain* tuple = (*this)[i];
+        for (size_t j = 0; j < getArity(); j++) {
+            std::unique_ptr<AstArgument> arg;
+            if (symbolic[j]) {
+                arg = std::make_unique<AstStringConstant>(symbolTable, symbolTable.resolve(tuple[j]));
+            } else {
+                arg = std::make_unique<AstNumberConstant>(tuple[j]);
+            }
+            arg->setSrcLoc(loc);
+            head->addArgument(std::move(arg));
+        }
+        auto fact = std::make_unique<AstClause>();
+        fact->setHead(std::move(head));
+        fact->setSrcLoc(loc);
+        return fact;
+    }
+
+    /** Prints the facts as clauses of the given relation */
+    void print(std::ostream& os, const AstRelationIdentifier& name) const {
+        for (size_t i = 0; i < size(); i++) {
+            os << *getClause(name, i) << "\n\n";
+        }
+    }
+
+    bool operator==(const AstFactTable& other) const {
+        return symbolic == other.symbolic && values == other.values;
+    }
+
+private:
+    /** Whether each column holds symbols rather than numbers */
+    std::vector<bool> symbolic;
+
+    /** The values of the facts, one after the other */
+    std::vector<RamDomain> values;
+
+    /** The symbol table holding the symbols of the facts */
+    SymbolTable& symbolTable;
+
+    /** The location of the first fact */
+    SrcLocation loc;
+};
+
+}  // end of namespace souffle
@@ -11,15 +11,20 @@
  * @file AstPragma.cpp
  *
  * Define the class AstPragma to update global options based on parameter.
+ * The "representations" pragma, as in "A=brie,B=btree", overrides the
+ * representations of the relations it names.
  *
  ***********************************************************************/
 
 #include "AstPragma.h"
 #include "AstProgram.h"
+#include "AstRelation.h"
 #include "AstTranslationUnit.h"
 #include "AstVisitor.h"
 #include "Global.h"
+#include "RelationRepresentation.h"
 #include "Util.h"
+#include <map>
 
 namespace souffle {
 bool AstPragmaChecker::transform(AstTranslationUnit& translationUnit) {
@@ -54,6 +59,38 @@ bool AstPragmaChecker::transform(AstTranslationUnit& translationUnit) {
         }
     });
 
+    // Override the representations of relations
+    if (Global::config().has("representations")) {
+        const std::map<std::string, RelationRepresentation> representations = {
+                {"btree", RelationRepresentation::BTREE}, {"brie", RelationRepresentation::BRIE},
+                {"eqrel", RelationRepresentation::EQREL}, {"hashset", RelationRepresentation::HASHSET},
+                {"compressed", RelationRepresentation::COMPRESSED}, {"mmap", RelationRepresentation::MMAP},
+                {"bitmap", RelationRepresentation::BITMAP}};
+        for (const std::string& entry : splitString(Global::config().get("representations"), ',')) {
+            size_t splitPoint = entry.find('=');
+            std::string name = entry.substr(0, splitPoint);
+            std::string value = (splitPoint == std::string::npos) ? "" : entry.substr(splitPoint + 1);
+            auto representation = representations.find(value);
+            if (representation == representations.end()) {
+                translationUnit.getErrorReport().addError(
+                        "Unknown representation " + value + " of relation " + name, SrcLocation());
+                continue;
+            }
+            bool found = false;
+            for (AstRelation* rel : program->getRelations()) {
+                if (toString(rel->getName()) == name) {
+                    rel->setRepresentation(representation->second);
+                    changed = true;
+                    found = true;
+                }
+            }
+            if (!found) {
+                translationUnit.getErrorReport().addWarning(
+                        "Representation of undefined relation " + name, SrcLocation());
+            }
+        }
+    }
+
     return changed;
 }
 }  // end of namespace souffle
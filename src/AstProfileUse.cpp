@@ -36,6 +36,16 @@ void AstProfileUse::run(const AstTranslationUnit& translationUnit) {
         std::string filename = Global::config().get("profile-use");
         profile::Reader(filename, programRun).processFile();
     }
+    if (Global::config().has("statistics")) {
+        statistics = std::make_unique<StatisticsCatalog>(Global::config().get("statistics"));
+    }
+}
+
+/**
+ * Get the statistics of a relation
+ */
+const RelationStatistics* AstProfileUse::getStatistics(const AstRelationIdentifier& rel) const {
+    return (statistics != nullptr) ? statistics->getRelation(rel.getName()) : nullptr;
 }
 
 /**
@@ -47,7 +57,7 @@ void AstProfileUse::print(std::ostream& os) const {}
  * Check whether relation size is defined in profile
  */
 bool AstProfileUse::hasRelationSize(const AstRelationIdentifier& rel) {
-    return programRun->getRelation(rel.getName()) != nullptr;
+    return programRun->getRelation(rel.getName()) != nullptr || getStatistics(rel) != nullptr;
 }
 
 /**
@@ -56,9 +66,130 @@ bool AstProfileUse::hasRelationSize(const AstRelationIdentifier& rel) {
 size_t AstProfileUse::getRelationSize(const AstRelationIdentifier& rel) {
     if (const auto* profRel = programRun->getRelation(rel.getName())) {
         return profRel->size();
+    } else if (const auto* stats = getStatistics(rel)) {
+        return stats->size;
     } else {
         return std::numeric_limits<size_t>::max();
     }
 }
 
+/**
+ * Get average size of the delta of a relation per iteration from profile
+ */
+size_t AstProfileUse::getDeltaSize(const AstRelationIdentifier& rel) {
+    const auto* profRel = programRun->getRelation(rel.getName());
+    if (profRel == nullptr) {
+        // the statistics only bound the delta by the final size of the relation
+        const auto* stats = getStatistics(rel);
+        return (stats != nullptr) ? stats->size : std::numeric_limits<size_t>::max();
+    }
+    const auto& iterations = profRel->getIterations();
+    if (iterations.empty()) {
+        return profRel->size();
+    }
+    size_t total = 0;
+    for (const auto& iter : iterations) {
+        total += iter->size();
+    }
+    return (total + iterations.size() - 1) / iterations.size();
+}
+
+/**
+ * Check whether the number of distinct values of a column is defined in profile
+ */
+bool AstProfileUse::hasDistinctValues(const AstRelationIdentifier& rel, size_t column) {
+    const auto* profRel = programRun->getRelation(rel.getName());
+    if (profRel != nullptr && profRel->hasDistinctValues(column)) {
+        return true;
+    }
+    const auto* stats = getStatistics(rel);
+    return stats != nullptr && column < stats->columns.size();
+}
+
+/**
+ * Get the number of distinct values of a column from profile
+ */
+size_t AstProfileUse::getDistinctValues(const AstRelationIdentifier& rel, size_t column) {
+    const auto* profRel = programRun->getRelation(rel.getName());
+    if (profRel != nullptr && profRel->hasDistinctValues(column)) {
+        return profRel->getDistinctValues(column);
+    }
+    const auto* stats = getStatistics(rel);
+    return (stats != nullptr && column < stats->columns.size()) ? stats->columns[column].distinct : 0;
+}
+
+/**
+ * Check whether the frequent values of a column are defined in the statistics
+ */
+bool AstProfileUse::hasValueMatches(const AstRelationIdentifier& rel, size_t column) {
+    const auto* stats = getStatistics(rel);
+    return stats != nullptr && column < stats->columns.size();
+}
+
+/**
+ * Get the estimated number of tuples holding a value in a column from the statistics
+ */
+double AstProfileUse::getValueMatches(
+        const AstRelationIdentifier& rel, size_t column, const std::string& value) {
+    const auto* stats = getStatistics(rel);
+    return (stats != nullptr) ? stats->getMatches(column, value) : 0;
+}
+
+/**
+ * Check whether the accesses of the indexes of a relation are defined in profile
+ */
+bool AstProfileUse::hasIndexStatistics(const AstRelationIdentifier& rel) {
+    const auto* profRel = programRun->getRelation(rel.getName());
+    return profRel != nullptr && !profRel->getIndexStatistics().empty();
+}
+
+/**
+ * Get a statistic of the accesses of all indexes of a relation from profile
+ */
+size_t AstProfileUse::getIndexStatistic(const AstRelationIdentifier& rel, const std::string& statistic) {
+    const auto* profRel = programRun->getRelation(rel.getName());
+    if (profRel == nullptr) {
+        return 0;
+    }
+    size_t total = 0;
+    for (const auto& index : profRel->getIndexStatistics()) {
+        auto pos = index.second.find(statistic);
+        if (pos != index.second.end()) {
+            total += pos->second;
+        }
+    }
+    return total;
+}
+
+/**
+ * Check whether the memory of a relation is defined in profile
+ */
+bool AstProfileUse::hasMemoryUsage(const AstRelationIdentifier& rel) {
+    const auto* profRel = programRun->getRelation(rel.getName());
+    return profRel != nullptr && !profRel->getMemory().empty();
+}
+
+/**
+ * Get the peak memory of all indexes of a relation from profile
+ */
+size_t AstProfileUse::getMemoryUsage(const AstRelationIdentifier& rel) {
+    const auto* profRel = programRun->getRelation(rel.getName());
+    if (profRel == nullptr) {
+        return 0;
+    }
+    size_t total = 0;
+    for (const auto& index : profRel->getMemory()) {
+        total += index.second;
+    }
+    return total;
+}
+
+/**
+ * Get the number of indexes of a relation whose memory is defined in profile
+ */
+size_t AstProfileUse::getIndexCount(const AstRelationIdentifier& rel) {
+    const auto* profRel = programRun->getRelation(rel.getName());
+    return (profRel != nullptr) ? profRel->getMemory().size() : 0;
+}
+
 }  // end of namespace souffle
@@ -19,21 +19,31 @@
 
 #include "AstAnalysis.h"
 #include "AstRelationIdentifier.h"
+#include "StatisticsCatalog.h"
 #include "profile/ProgramRun.h"
 #include <cstddef>
 #include <iostream>
 #include <memory>
+#include <string>
 
 namespace souffle {
 
 /**
  * AstAnalysis that loads profile data and has a profile query interface.
+ * The sizes and distinct values of relations missing in the profile are
+ * taken from the statistics catalog of --statistics, if any.
  */
 class AstProfileUse : public AstAnalysis {
 private:
     /** performance model of profile run */
     std::shared_ptr<profile::ProgramRun> programRun;
 
+    /** statistics of previous runs */
+    std::unique_ptr<StatisticsCatalog> statistics;
+
+    /** Get the statistics of a relation, or nullptr if none were collected */
+    const RelationStatistics* getStatistics(const AstRelationIdentifier& rel) const;
+
 public:
     /** Name of analysis */
     static constexpr const char* name = "profile-use";
@@ -51,6 +61,36 @@ public:
 
     /** Return size of relation in the profile */
     size_t getRelationSize(const AstRelationIdentifier& rel);
+
+    /** Return the average number of tuples a recursive relation gained per iteration in the profile */
+    size_t getDeltaSize(const AstRelationIdentifier& rel);
+
+    /** Check whether the number of distinct values of a column exists in profile */
+    bool hasDistinctValues(const AstRelationIdentifier& rel, size_t column);
+
+    /** Return the number of distinct values of a column in the profile */
+    size_t getDistinctValues(const AstRelationIdentifier& rel, size_t column);
+
+    /** Check whether the frequent values of a column exist in the statistics */
+    bool hasValueMatches(const AstRelationIdentifier& rel, size_t column);
+
+    /** Return the estimated number of tuples holding a value, a symbol or a number, in a column */
+    double getValueMatches(const AstRelationIdentifier& rel, size_t column, const std::string& value);
+
+    /** Check whether the accesses of the indexes of a relation exist in profile */
+    bool hasIndexStatistics(const AstRelationIdentifier& rel);
+
+    /** Return a statistic (probes, empty-probes, scans or tuples) summed over all indexes of a relation */
+    size_t getIndexStatistic(const AstRelationIdentifier& rel, const std::string& statistic);
+
+    /** Check whether the memory of a relation exists in profile */
+    bool hasMemoryUsage(const AstRelationIdentifier& rel);
+
+    /** Return the peak memory of all indexes of a relation in the profile in bytes */
+    size_t getMemoryUsage(const AstRelationIdentifier& rel);
+
+    /** Return the number of indexes of a relation whose memory is in the profile */
+    size_t getIndexCount(const AstRelationIdentifier& rel);
 };
 
 }  // end of namespace souffle
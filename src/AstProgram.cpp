@@ -208,6 +208,9 @@ void AstProgram::print(std::ostream& os) const {
         for (const auto clause : rel->getClauses()) {
             os << *clause << "\n\n";
         }
+        if (const AstFactTable* facts = rel->getFactTable()) {
+            facts->print(os, rel->getName());
+        }
         for (const auto ioDirective : rel->getLoads()) {
             os << *ioDirective << "\n\n";
         }
@@ -19,6 +19,7 @@
 
 #include "AstAttribute.h"
 #include "AstClause.h"
+#include "AstFactTable.h"
 #include "AstIO.h"
 #include "AstNode.h"
 #include "AstRelationIdentifier.h"
@@ -59,11 +60,39 @@
 /* Relation uses a union relation */
 #define EQREL_RELATION (0x100)
 
+/* Relation uses a delta-encoded data structure */
+#define COMPRESSED_RELATION (0x200)
+
+/* Relation uses a hash-based data structure */
+#define HASHSET_RELATION (0x400)
+
 /* Relation warnings are suppressed */
 #define SUPPRESSED_RELATION (0x800)
 
+/* Relation uses a sorted array in a memory-mapped file */
+#define MMAP_RELATION (0x1000)
+
+/* Relation uses compressed bitmaps of its second column */
+#define BITMAP_RELATION (0x2000)
+
 namespace souffle {
 
+/**
+ * A column of a subsumptive relation, in which a tuple dominates the tuples agreeing with it
+ * on all other columns by a lesser (or greater) value.
+ */
+struct AstDominance {
+    /** The name of the attribute of the column */
+    std::string attribute;
+
+    /** Whether lesser values dominate, rather than greater ones */
+    bool minimise = true;
+
+    bool operator==(const AstDominance& other) const {
+        return attribute == other.attribute && minimise == other.minimise;
+    }
+};
+
 /*!
  * @class Relation
  * @brief Intermediate representation of a datalog relation
@@ -94,6 +123,12 @@ public:
         attributes.push_back(std::move(attr));
     }
 
+    /** Remove the attribute at position @p idx */
+    void removeAttribute(size_t idx) {
+        assert(idx < attributes.size() && "Attribute index out of bounds");
+        attributes.erase(attributes.begin() + idx);
+    }
+
     /** Return the arity of this relation */
     size_t getArity() const {
         return attributes.size();
@@ -123,6 +158,14 @@ public:
             representation = RelationRepresentation::BRIE;
         } else if (q & BTREE_RELATION) {
             representation = RelationRepresentation::BTREE;
+        } else if (q & COMPRESSED_RELATION) {
+            representation = RelationRepresentation::COMPRESSED;
+        } else if (q & HASHSET_RELATION) {
+            representation = RelationRepresentation::HASHSET;
+        } else if (q & MMAP_RELATION) {
+            representation = RelationRepresentation::MMAP;
+        } else if (q & BITMAP_RELATION) {
+            representation = RelationRepresentation::BITMAP;
         }
 
         if (q & INPUT_RELATION) {
@@ -151,6 +194,17 @@ public:
         this->representation = representation;
     }
 
+    /** Return the name of the storage provider of this relation, empty unless it uses one */
+    const std::string& getStorage() const {
+        return storage;
+    }
+
+    /** Store this relation in the storage created by the named provider */
+    void setStorage(const std::string& provider) {
+        representation = RelationRepresentation::STORAGE;
+        storage = provider;
+    }
+
     /** Check whether relation is an overridable relation */
     bool isOverridable() const {
         return (qualifier & OVERRIDABLE_RELATION) != 0;
@@ -166,6 +220,26 @@ public:
         return (qualifier & INLINE_RELATION) != 0;
     }
 
+    /** Add a column in which the tuples of this relation dominate, such that dominated tuples are dropped */
+    void addDominance(const AstDominance& column) {
+        dominance.push_back(column);
+    }
+
+    /** Return the columns in which the tuples of this relation dominate */
+    const std::vector<AstDominance>& getDominance() const {
+        return dominance;
+    }
+
+    /** Check whether relation keeps only the tuples not dominated by others */
+    bool isSubsumptive() const {
+        return !dominance.empty();
+    }
+
+    /** Check whether relation carries the rule and level columns of provenance */
+    bool hasProvenanceColumns() const {
+        return getArity() >= 2 && attributes.back()->getAttributeName() == "@level_number";
+    }
+
     /** Check whether relation has a record in its head */
     bool hasRecordInHead() const {
         for (auto& cur : clauses) {
@@ -207,7 +281,19 @@ public:
         if (isInline()) {
             os << "inline ";
         }
-        os << representation << " ";
+        if (representation == RelationRepresentation::STORAGE) {
+            os << "storage(" << storage << ") ";
+        } else {
+            os << representation << " ";
+        }
+        if (isSubsumptive()) {
+            os << "subsume(";
+            for (size_t i = 0; i < dominance.size(); ++i) {
+                os << (i > 0 ? "," : "") << (dominance[i].minimise ? "min " : "max ")
+                   << dominance[i].attribute;
+            }
+            os << ") ";
+        }
     }
 
     /** Creates a clone of this AST sub-structure */
@@ -227,7 +313,13 @@ public:
         for (const auto& cur : loads) {
             res->loads.emplace_back(cur->clone());
         }
+        if (factTable) {
+            res->factTable = std::make_unique<AstFactTable>(*factTable);
+        }
         res->qualifier = qualifier;
+        res->representation = representation;
+        res->storage = storage;
+        res->dominance = dominance;
         return res;
     }
 
@@ -282,6 +374,31 @@ public:
         return clauses.size();
     }
 
+    /** Returns the table of the ground facts kept apart from the clauses, if any */
+    AstFactTable* getFactTable() const {
+        return factTable.get();
+    }
+
+    /** Sets the table of the ground facts kept apart from the clauses */
+    void setFactTable(std::unique_ptr<AstFactTable> table) {
+        factTable = std::move(table);
+    }
+
+    /** Whether any clause or fact table defines tuples of this relation */
+    bool hasClausesOrFacts() const {
+        return !clauses.empty() || factTable;
+    }
+
+    /** Turns the facts of the fact table back into clauses */
+    void materialiseFacts() {
+        if (factTable) {
+            for (size_t i = 0; i < factTable->size(); i++) {
+                clauses.push_back(factTable->getClause(name, i));
+            }
+            factTable.reset();
+        }
+    }
+
     /** Obtains a list of all embedded child nodes */
     std::vector<const AstNode*> getChildNodes() const override {
         std::vector<const AstNode*> res;
@@ -337,15 +454,26 @@ protected:
     std::vector<std::unique_ptr<AstStore>> stores;
     std::vector<std::unique_ptr<AstLoad>> loads;
 
+    /** Ground facts kept apart from the clauses */
+    std::unique_ptr<AstFactTable> factTable;
+
     /** Datastructure to use for this relation */
     RelationRepresentation representation{RelationRepresentation::DEFAULT};
 
+    /** The storage provider of the relation, if its representation is STORAGE */
+    std::string storage;
+
+    /** Columns in which tuples dominate, none unless the relation is subsumptive */
+    std::vector<AstDominance> dominance;
+
     /** Implements the node comparison for this node type */
     bool equal(const AstNode& node) const override {
         assert(nullptr != dynamic_cast<const AstRelation*>(&node));
         const auto& other = static_cast<const AstRelation&>(node);
         return name == other.name && equal_targets(attributes, other.attributes) &&
-               equal_targets(clauses, other.clauses);
+               equal_targets(clauses, other.clauses) && dominance == other.dominance &&
+               (factTable && other.factTable ? *factTable == *other.factTable
+                                             : !factTable && !other.factTable);
     }
 };
 
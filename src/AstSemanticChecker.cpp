@@ -44,6 +44,7 @@
 #include "Util.h"
 #include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <cstddef>
 #include <iostream>
 #include <map>
@@ -660,6 +661,58 @@ void AstSemanticChecker::checkRelation(ErrorReport& report, const TypeEnvironmen
         }
     }
 
+    // memory-mapped relations are sorted once loaded, thus they cannot be derived
+    if (relation.getRepresentation() == RelationRepresentation::MMAP) {
+        for (const AstClause* c : relation.getClauses()) {
+            if (!c->isFact()) {
+                report.addError("Memory-mapped relation " + toString(relation.getName()) +
+                                        " may only be defined by facts and inputs",
+                        c->getSrcLoc());
+            }
+        }
+    }
+
+    // bitmap relations index the values of their second column by the values of their first column
+    if (relation.getRepresentation() == RelationRepresentation::BITMAP && relation.getArity() != 2) {
+        report.addError("Bitmap relation " + toString(relation.getName()) + " is not binary",
+                relation.getSrcLoc());
+    }
+
+    // the name of a storage provider is part of the names of the types of generated relations
+    if (relation.getRepresentation() == RelationRepresentation::STORAGE &&
+            relation.getStorage().find('?') != std::string::npos) {
+        report.addError("Storage provider " + relation.getStorage() + " of relation " +
+                                toString(relation.getName()) + " is not a valid name",
+                relation.getSrcLoc());
+    }
+
+    // subsumptive relations drop dominated tuples by rebuilding their own tuples and deltas
+    if (relation.isSubsumptive()) {
+        const std::string name = toString(relation.getName());
+        if (relation.getRepresentation() == RelationRepresentation::EQREL ||
+                relation.getRepresentation() == RelationRepresentation::MMAP || relation.isInline()) {
+            report.addError("Subsumptive relation " + name + " must not be inlined, an equivalence " +
+                                    "relation, or memory-mapped",
+                    relation.getSrcLoc());
+        }
+        if (Global::config().has("provenance") || Global::config().has("incremental")) {
+            report.addError("Subsumptive relation " + name + " cannot be combined with provenance or " +
+                                    "incremental updates",
+                    relation.getSrcLoc());
+        }
+        for (const AstDominance& column : relation.getDominance()) {
+            for (const AstAttribute* attr : relation.getAttributes()) {
+                const AstTypeIdentifier& typeName = attr->getTypeName();
+                if (attr->getAttributeName() == column.attribute && typeEnv.isType(typeName) &&
+                        !isNumberType(typeEnv.getType(typeName))) {
+                    report.addError("Non-numeric attribute " + column.attribute + " in subsumption of " +
+                                            "relation " + name,
+                            attr->getSrcLoc());
+                }
+            }
+        }
+    }
+
     // start with declaration
     checkRelationDeclaration(report, typeEnv, program, relation, ioTypes);
 
@@ -669,7 +722,7 @@ void AstSemanticChecker::checkRelation(ErrorReport& report, const TypeEnvironmen
     }
 
     // check whether this relation is empty
-    if (relation.clauseSize() == 0 && !ioTypes.isInput(&relation) && !relation.isSuppressed()) {
+    if (!relation.hasClausesOrFacts() && !ioTypes.isInput(&relation) && !relation.isSuppressed()) {
         report.addWarning(
                 "No rules/facts defined for relation " + toString(relation.getName()), relation.getSrcLoc());
     }
@@ -940,6 +993,16 @@ void AstSemanticChecker::checkIODirectives(ErrorReport& report, const AstProgram
     }
     for (const auto& directive : program.getStores()) {
         checkIODirective(directive.get());
+
+        // the number of tuples an output is limited to
+        auto it = directive->getIODirectiveMap().find("limit");
+        if (it != directive->getIODirectiveMap().end()) {
+            const std::string& limit = it->second;
+            if (limit.empty() || limit.size() > 9 || !std::all_of(limit.begin(), limit.end(), ::isdigit) ||
+                    std::stoi(limit) == 0) {
+                report.addError("Invalid output limit " + limit, directive->getSrcLoc());
+            }
+        }
     }
 }
 
@@ -1134,8 +1197,8 @@ std::vector<AstRelationIdentifier> findInlineCycle(const PrecedenceGraph& preced
     }
 
     // Check neighbours
-    const AstRelationSet& successors = precedenceGraph.graph().successors(current);
-    for (const AstRelation* successor : successors) {
+    for (const size_t id : precedenceGraph.successors(current)) {
+        const AstRelation* successor = precedenceGraph.getRelation(id);
         // Only care about inlined neighbours in the graph
         if (successor->isInline()) {
             if (visited.find(successor) != visited.end()) {
@@ -16,7 +16,9 @@
 
 #include "AstTransformer.h"
 #include "AstTranslationUnit.h"
+#include "DebugReport.h"
 #include "ErrorReport.h"
+#include "Global.h"
 #include <chrono>
 #include <cstdlib>
 #include <iostream>
@@ -24,9 +26,20 @@
 namespace souffle {
 
 bool AstTransformer::apply(AstTranslationUnit& translationUnit) {
+    // meta transformers are accounted for by the passes they apply
+    bool record = !Global::config().get("debug-report").empty() && !dynamic_cast<MetaTransformer*>(this);
+    size_t memory = record ? DebugReport::getPeakMemory() : 0;
+    auto start = std::chrono::high_resolution_clock::now();
     bool changed = transform(translationUnit);
-    if (changed) {
-        translationUnit.invalidateAnalyses();
+    // the passes applied by a meta transformer invalidate the analyses they affect themselves
+    if (changed && !dynamic_cast<MetaTransformer*>(this)) {
+        translationUnit.invalidateAnalyses(getPreservedAnalyses());
+    }
+    if (record) {
+        auto end = std::chrono::high_resolution_clock::now();
+        translationUnit.getDebugReport().addPassStatistics(getName(),
+                std::chrono::duration<double>(end - start).count(), DebugReport::getPeakMemory() - memory,
+                changed);
     }
     return changed;
 }
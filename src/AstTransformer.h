@@ -33,6 +33,14 @@ public:
     bool apply(AstTranslationUnit& translationUnit);
 
     virtual std::string getName() const = 0;
+
+    /**
+     * The names of the analyses that remain valid when the transformer changes the program, all
+     * other cached analyses are invalidated. Analyses referring to each other are preserved together.
+     */
+    virtual std::set<std::string> getPreservedAnalyses() const {
+        return {};
+    }
 };
 
 /**
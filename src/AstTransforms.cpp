@@ -32,10 +32,12 @@
 #include "GraphUtils.h"
 #include "PrecedenceGraph.h"
 #include "TypeSystem.h"
+#include <algorithm>
 #include <cstddef>
 #include <functional>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <ostream>
 #include <set>
 
@@ -91,7 +93,8 @@ bool RemoveRelationCopiesTransformer::removeRelationCopies(AstTranslationUnit& t
 
     // search for relations only defined by a single rule ..
     for (AstRelation* rel : program.getRelations()) {
-        if (!ioType->isIO(rel) && rel->getClauses().size() == 1u) {
+        if (!ioType->isIO(rel) && rel->getClauses().size() == 1u && !rel->getFactTable() &&
+                !rel->isSubsumptive()) {
             // .. of shape r(x,y,..) :- s(x,y,..)
             AstClause* cl = rel->getClause(0);
             if (!cl->isFact() && cl->getBodySize() == 1u && cl->getAtoms().size() == 1u) {
@@ -392,7 +395,7 @@ bool RemoveEmptyRelationsTransformer::removeEmptyRelations(AstTranslationUnit& t
     auto* ioTypes = translationUnit.getAnalysis<IOType>();
     bool changed = false;
     for (auto rel : program.getRelations()) {
-        if (rel->clauseSize() > 0 || ioTypes->isInput(rel)) {
+        if (rel->hasClausesOrFacts() || ioTypes->isInput(rel)) {
             continue;
         }
         changed |= removeEmptyRelationUses(translationUnit, rel);
@@ -880,7 +883,7 @@ bool ReduceExistentialsTransformer::transform(AstTranslationUnit& translationUni
     // All other relations are necessarily existential
     std::set<AstRelationIdentifier> existentialRelations;
     for (AstRelation* relation : program.getRelations()) {
-        if (!relation->getClauses().empty() && relation->getArity() != 0 &&
+        if (relation->hasClausesOrFacts() && relation->getArity() != 0 &&
                 irreducibleRelations.find(relation->getName()) == irreducibleRelations.end()) {
             existentialRelations.insert(relation->getName());
         }
@@ -920,6 +923,15 @@ bool ReduceExistentialsTransformer::transform(AstTranslationUnit& translationUni
             }
         }
 
+        // the ground facts amount to a single fact
+        const AstFactTable* facts = originalRelation->getFactTable();
+        if (facts != nullptr && facts->size() > 0) {
+            auto fact = std::make_unique<AstClause>();
+            fact->setSrcLoc(facts->getSrcLoc());
+            fact->setHead(std::make_unique<AstAtom>(newRelationName.str()));
+            newRelation->addClause(std::move(fact));
+        }
+
         program.appendRelation(std::move(newRelation));
     }
 
@@ -956,6 +968,100 @@ bool ReduceExistentialsTransformer::transform(AstTranslationUnit& translationUni
     return changed;
 }
 
+bool ProjectDeadColumnsTransformer::transform(AstTranslationUnit& translationUnit) {
+    AstProgram& program = *translationUnit.getProgram();
+    auto* ioType = translationUnit.getAnalysis<IOType>();
+
+    // the columns of each relation read by some rule, all of them for relations to be kept as they are
+    std::map<AstRelationIdentifier, std::vector<bool>> read;
+    for (AstRelation* rel : program.getRelations()) {
+        const bool kept = ioType->isIO(rel) || rel->getRepresentation() == RelationRepresentation::EQREL ||
+                          rel->isSubsumptive() || rel->getFactTable() != nullptr;
+        read[rel->getName()] = std::vector<bool>(rel->getArity(), kept);
+    }
+
+    for (AstRelation* rel : program.getRelations()) {
+        for (AstClause* clause : rel->getClauses()) {
+            std::map<std::string, size_t> occurrences;
+            visitDepthFirst(*clause, [&](const AstVariable& var) { occurrences[var.getName()]++; });
+
+            // tuples aggregated are distinguished by all their columns
+            std::set<const AstAtom*> aggregated;
+            visitDepthFirst(*clause, [&](const AstAggregator& aggr) {
+                visitDepthFirst(aggr, [&](const AstAtom& atom) { aggregated.insert(&atom); });
+            });
+
+            visitDepthFirst(clause->getBodyLiterals(), [&](const AstAtom& atom) {
+                auto pos = read.find(atom.getName());
+                if (pos == read.end()) {
+                    return;
+                }
+                std::vector<bool>& columns = pos->second;
+                for (size_t i = 0; i < atom.getArity() && i < columns.size(); i++) {
+                    const AstArgument* arg = atom.getArgument(i);
+                    bool unused = dynamic_cast<const AstUnnamedVariable*>(arg) != nullptr;
+                    if (const auto* var = dynamic_cast<const AstVariable*>(arg)) {
+                        unused = occurrences[var->getName()] == 1;
+                    }
+                    if (!unused || aggregated.count(&atom) > 0) {
+                        columns[i] = true;
+                    }
+                }
+            });
+        }
+    }
+
+    // remove the unread columns from the relations
+    std::map<AstRelationIdentifier, std::vector<bool>> projected;
+    for (const auto& cur : read) {
+        const std::vector<bool>& columns = cur.second;
+        if (std::find(columns.begin(), columns.end(), false) == columns.end()) {
+            continue;
+        }
+        AstRelation* rel = program.getRelation(cur.first);
+        for (size_t i = columns.size(); i-- > 0;) {
+            if (!columns[i]) {
+                rel->removeAttribute(i);
+            }
+        }
+        projected.insert(cur);
+    }
+    if (projected.empty()) {
+        return false;
+    }
+
+    // Mapper removing the unread arguments from the atoms of projected relations
+    struct projectAtoms : public AstNodeMapper {
+        const std::map<AstRelationIdentifier, std::vector<bool>>& projected;
+
+        projectAtoms(const std::map<AstRelationIdentifier, std::vector<bool>>& projected)
+                : projected(projected) {}
+
+        std::unique_ptr<AstNode> operator()(std::unique_ptr<AstNode> node) const override {
+            if (auto* atom = dynamic_cast<AstAtom*>(node.get())) {
+                auto pos = projected.find(atom->getName());
+                if (pos != projected.end()) {
+                    auto newAtom = std::make_unique<AstAtom>(atom->getName());
+                    newAtom->setSrcLoc(atom->getSrcLoc());
+                    for (size_t i = 0; i < atom->getArity(); i++) {
+                        if (pos->second[i]) {
+                            newAtom->addArgument(std::unique_ptr<AstArgument>(atom->getArgument(i)->clone()));
+                        }
+                    }
+                    newAtom->apply(*this);
+                    return std::move(newAtom);
+                }
+            }
+            node->apply(*this);
+            return node;
+        }
+    };
+
+    projectAtoms update(projected);
+    program.apply(update);
+    return true;
+}
+
 bool ReplaceSingletonVariablesTransformer::transform(AstTranslationUnit& translationUnit) {
     bool changed = false;
 
@@ -1026,6 +1132,13 @@ bool ReplaceSingletonVariablesTransformer::transform(AstTranslationUnit& transla
     return changed;
 }
 
+std::set<std::string> RemoveRedundantSumsTransformer::getPreservedAnalyses() const {
+    // aggregates are replaced within their clauses, keeping their bodies and the dependencies
+    auto preserved = getRelationDependencyAnalyses();
+    preserved.insert({RecursiveClauses::name, TypeEnvironmentAnalysis::name});
+    return preserved;
+}
+
 bool RemoveRedundantSumsTransformer::transform(AstTranslationUnit& translationUnit) {
     struct ReplaceSumWithCount : public AstNodeMapper {
         ReplaceSumWithCount() {}
@@ -1066,9 +1179,14 @@ bool RemoveRedundantSumsTransformer::transform(AstTranslationUnit& translationUn
     return update.changed;
 }
 
-bool NormaliseConstraintsTransformer::transform(AstTranslationUnit& translationUnit) {
-    bool changed = false;
+std::set<std::string> NormaliseConstraintsTransformer::getPreservedAnalyses() const {
+    // constants and underscores are replaced within their clauses, keeping the dependencies
+    auto preserved = getRelationDependencyAnalyses();
+    preserved.insert({RecursiveClauses::name, TypeEnvironmentAnalysis::name});
+    return preserved;
+}
 
+bool NormaliseConstraintsTransformer::transform(AstTranslationUnit& translationUnit) {
     // set a prefix for variables bound by magic-set for identification later
     // prepended by + to avoid conflict with user-defined variables
     static constexpr const char* boundPrefix = "+abdul";
@@ -1079,14 +1197,17 @@ bool NormaliseConstraintsTransformer::transform(AstTranslationUnit& translationU
      * with named variables.
      *
      * The mapper keeps track of constraints that should be added to the original
-     * clause it is being applied on in a given constraint set.
+     * clause it is being applied on in a given constraint set. In counting mode,
+     * the mapper only counts the constants and underscores, leaving the clause as is.
      */
     struct constraintNormaliser : public AstNodeMapper {
         std::set<AstBinaryConstraint*>& constraints;
         mutable int changeCount;
+        bool counting;
 
-        constraintNormaliser(std::set<AstBinaryConstraint*>& constraints, int changeCount)
-                : constraints(constraints), changeCount(changeCount) {}
+        constraintNormaliser(
+                std::set<AstBinaryConstraint*>& constraints, int changeCount, bool counting = false)
+                : constraints(constraints), changeCount(changeCount), counting(counting) {}
 
         bool hasChanged() const {
             return changeCount > 0;
@@ -1097,7 +1218,14 @@ bool NormaliseConstraintsTransformer::transform(AstTranslationUnit& translationU
         }
 
         std::unique_ptr<AstNode> operator()(std::unique_ptr<AstNode> node) const override {
-            if (auto* stringConstant = dynamic_cast<AstStringConstant*>(node.get())) {
+            if (counting) {
+                if (dynamic_cast<AstStringConstant*>(node.get()) ||
+                        dynamic_cast<AstNumberConstant*>(node.get()) ||
+                        dynamic_cast<AstUnnamedVariable*>(node.get())) {
+                    changeCount++;
+                    return node;
+                }
+            } else if (auto* stringConstant = dynamic_cast<AstStringConstant*>(node.get())) {
                 // string constant found
                 changeCount++;
 
@@ -1147,29 +1275,50 @@ bool NormaliseConstraintsTransformer::transform(AstTranslationUnit& translationU
         }
     };
 
-    int changeCount = 0;  // number of constants and underscores seen so far
-
-    // apply the change to all clauses in the program
+    // collect the clauses to normalise, facts are not normalised
+    std::vector<AstClause*> clauses;
     for (AstRelation* rel : program.getRelations()) {
         for (AstClause* clause : rel->getClauses()) {
-            if (clause->isFact()) {
-                continue;  // don't normalise facts
+            if (!clause->isFact()) {
+                clauses.push_back(clause);
             }
+        }
+    }
 
-            std::set<AstBinaryConstraint*> constraints;
-            constraintNormaliser update(constraints, changeCount);
-            clause->apply(update);
-
-            changeCount = update.getChangeCount();
-            changed = changed || update.hasChanged();
+    // number the constants and underscores of each clause as if the clauses were normalised one after
+    // the other, such that the clauses can be normalised in parallel and yet get the same variables
+    int numClauses = clauses.size();
+    std::vector<int> changeCounts(numClauses + 1, 0);
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < numClauses; i++) {
+        std::set<AstBinaryConstraint*> constraints;
+        constraintNormaliser counter(constraints, 0, true);
+        clauses[i]->apply(counter);
+        changeCounts[i + 1] = counter.getChangeCount();
+    }
+    std::partial_sum(changeCounts.begin(), changeCounts.end(), changeCounts.begin());
 
-            for (AstBinaryConstraint* constraint : constraints) {
-                clause->addToBody(std::unique_ptr<AstBinaryConstraint>(constraint));
-            }
+    // apply the change to all clauses in the program
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < numClauses; i++) {
+        std::set<AstBinaryConstraint*> constraints;
+        constraintNormaliser update(constraints, changeCounts[i]);
+        clauses[i]->apply(update);
+
+        for (AstBinaryConstraint* constraint : constraints) {
+            clauses[i]->addToBody(std::unique_ptr<AstBinaryConstraint>(constraint));
         }
     }
 
-    return changed;
+    // number of constants and underscores seen in all clauses
+    return changeCounts[numClauses] > 0;
+}
+
+std::set<std::string> RemoveTypecastsTransformer::getPreservedAnalyses() const {
+    // arguments are replaced within their clauses, keeping the dependencies
+    auto preserved = getRelationDependencyAnalyses();
+    preserved.insert({RecursiveClauses::name, TypeEnvironmentAnalysis::name});
+    return preserved;
 }
 
 bool RemoveTypecastsTransformer::transform(AstTranslationUnit& translationUnit) {
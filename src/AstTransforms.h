@@ -45,6 +45,8 @@ public:
         return "ResolveAliasesTransformer";
     }
 
+    std::set<std::string> getPreservedAnalyses() const override;
+
     /**
      * Converts the given clause into a version without variables aliasing
      * grounded variables.
@@ -244,6 +246,110 @@ private:
     bool transform(AstTranslationUnit& translationUnit) override;
 };
 
+/**
+ * Transformation pass to partition relations whose rules all derive a constant
+ * at one column into one relation per constant without the column.
+ * E.g. fact(1,x) :- a(x). and fact(2,x) :- b(x). become fact+part0(x) :- a(x).
+ * and fact+part1(x) :- b(x); uses binding the column to a constant are rewritten
+ * to the partition, and the relation is kept as the union of its partitions for
+ * the others.
+ */
+class PartitionRelationsTransformer : public AstTransformer {
+public:
+    std::string getName() const override {
+        return "PartitionRelationsTransformer";
+    }
+
+private:
+    bool transform(AstTranslationUnit& translationUnit) override;
+};
+
+/**
+ * Transformation pass to materialise the fields of record columns as columns of
+ * their relation, such that atoms searching the contents of a record use an index
+ * on its fields instead of unpacking the record of each tuple. E.g. for
+ * r([x,y]) :- a(x,y). and s(y) :- b(x), r([x,y]). the rules become
+ * r([x,y],x,y) :- a(x,y). and s(y) :- b(x), r(_,x,y). A column qualifies if every
+ * rule of its relation derives a record at it and a body atom searches its fields.
+ */
+class RecordIndexesTransformer : public AstTransformer {
+public:
+    std::string getName() const override {
+        return "RecordIndexesTransformer";
+    }
+
+private:
+    bool transform(AstTranslationUnit& translationUnit) override;
+};
+
+/**
+ * Transformation pass to materialise join prefixes shared by several rules
+ * into new relations if the saved work is estimated to outweigh the cost of
+ * storing the join.
+ * E.g. a(x) :- b(x,y), c(y), d(x). and e(z) :- b(z,w), c(w), f(z). share the join
+ * of b and c, which is computed once by newrel(x) :- b(x,y), c(y). and then used
+ * as a(x) :- newrel(x), d(x). and e(z) :- newrel(z), f(z).
+ */
+class MaterializeSharedJoinsTransformer : public AstTransformer {
+public:
+    std::string getName() const override {
+        return "MaterializeSharedJoinsTransformer";
+    }
+
+private:
+    bool transform(AstTranslationUnit& translationUnit) override;
+};
+
+/**
+ * Transformation pass to reduce the large relations joined by a rule to the
+ * tuples agreeing with a small relation of the same rule, before the join.
+ * E.g. a(x,z) :- b(x,y), c(y,z), d(z). where d is small, is transformed into
+ *      - a(x,z) :- b(x,y), newrel(y,z), d(z).
+ *      - newrel(y,z) :- c(y,z), d(z).
+ * Each large atom is reduced by the smallest atom sharing a variable with it,
+ * as the first pass of the semi-join reduction of Yannakakis' algorithm, if the
+ * reduction is estimated to at least halve it.
+ */
+class SemiJoinReductionTransformer : public AstTransformer {
+public:
+    std::string getName() const override {
+        return "SemiJoinReductionTransformer";
+    }
+
+private:
+    bool transform(AstTranslationUnit& translationUnit) override;
+};
+
+/**
+ * Transformation pass to store the relations that are only counted, by
+ * .printsize or as the only atom of count aggregates, in hash sets
+ * deduplicating their tuples instead of b-trees.
+ */
+class CountOnlyRelationsTransformer : public AstTransformer {
+public:
+    std::string getName() const override {
+        return "CountOnlyRelationsTransformer";
+    }
+
+private:
+    bool transform(AstTranslationUnit& translationUnit) override;
+};
+
+/**
+ * Transformation pass to select the representation of relations from the
+ * index accesses and memory recorded in a profile, overriding the declared
+ * b-tree or brie where the profile favours the other one.
+ */
+class SelectRepresentationTransformer : public AstTransformer {
+public:
+    std::string getName() const override {
+        return "SelectRepresentationTransformer";
+    }
+
+private:
+    bool transform(AstTranslationUnit& translationUnit) override;
+};
+
 /**
  * Transformation pass to move literals into new clauses
  * if they are independent of remaining literals.
@@ -276,6 +382,26 @@ private:
     bool transform(AstTranslationUnit& translationUnit) override;
 };
 
+/**
+ * Transformation pass to remove the columns of intermediate relations that no rule reads.
+ * E.g.: a(x) :- b(x,_). b(x,y) :- c(x,y). -> a(x) :- b(x). b(x) :- c(x,_).
+ *
+ * A column is read unless each atom of the relation in a rule body has an unnamed variable
+ * or a variable occurring nowhere else in the clause in it. Atoms within aggregates read
+ * all columns, as tuples differing only in an unread column are counted and summed apart.
+ * Relations subject to I/O, equivalence relations, subsumptive relations and relations
+ * with a fact table keep all their columns.
+ */
+class ProjectDeadColumnsTransformer : public AstTransformer {
+public:
+    std::string getName() const override {
+        return "ProjectDeadColumnsTransformer";
+    }
+
+private:
+    bool transform(AstTranslationUnit& translationUnit) override;
+};
+
 /**
  * Transformation pass to replace singleton variables
  * with unnamed variables.
@@ -300,6 +426,8 @@ public:
         return "ReorderLiteralsTransformer";
     }
 
+    std::set<std::string> getPreservedAnalyses() const override;
+
 private:
     bool transform(AstTranslationUnit& translationUnit) override;
 };
@@ -314,6 +442,8 @@ public:
         return "NormaliseConstraintsTransformer";
     }
 
+    std::set<std::string> getPreservedAnalyses() const override;
+
 private:
     bool transform(AstTranslationUnit& translationUnit) override;
 };
@@ -330,6 +460,8 @@ public:
         return "RemoveRedundantSumsTransformer";
     }
 
+    std::set<std::string> getPreservedAnalyses() const override;
+
 private:
     bool transform(AstTranslationUnit& translationUnit) override;
 };
@@ -358,6 +490,8 @@ public:
     std::string getName() const override {
         return "RemoveTypecastsTransformer";
     }
+
+    std::set<std::string> getPreservedAnalyses() const override;
 };
 
 /**
@@ -26,6 +26,8 @@
 
 #include <map>
 #include <memory>
+#include <set>
+#include <string>
 
 namespace souffle {
 
@@ -89,6 +91,17 @@ public:
         analyses.clear();
     }
 
+    /** destroy the cached analyses of translation unit except for the given ones */
+    void invalidateAnalyses(const std::set<std::string>& preserved) {
+        for (auto it = analyses.begin(); it != analyses.end();) {
+            if (preserved.count(it->first) == 0) {
+                it = analyses.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
     /** get debug report */
     DebugReport& getDebugReport() {
         return debugReport;
@@ -18,6 +18,7 @@
 #include "AstArgument.h"
 #include "AstAttribute.h"
 #include "AstClause.h"
+#include "AstFactTable.h"
 #include "AstFunctorDeclaration.h"
 #include "AstIO.h"
 #include "AstLiteral.h"
@@ -96,6 +97,16 @@ void AstTranslator::makeIODirective(IODirectives& ioDirective, const AstRelation
         if (ioDirective.getIOType() == "file" && ioDirective.getFileName().front() != '/') {
             ioDirective.setFileName(filePath + "/" + ioDirective.getFileName());
         }
+    } else if (IODirectives::isFileType(ioDirective.getIOType())) {
+        // binary and columnar files are named by their relation, found through the same directories
+        static const std::map<std::string, std::string> extensions = {
+                {"binary", ".bin"}, {"arrow", ".arrow"}, {"parquet", ".parquet"}};
+        if (!ioDirective.has("filename")) {
+            ioDirective.setFileName(ioDirective.getRelationName() + extensions.at(ioDirective.getIOType()));
+        }
+        if (ioDirective.getFileName().front() != '/') {
+            ioDirective.setFileName(filePath + "/" + ioDirective.getFileName());
+        }
     }
 }
 
@@ -124,6 +135,9 @@ std::vector<IODirectives> AstTranslator::getInputIODirectives(
 
     for (auto& ioDirective : inputDirectives) {
         makeIODirective(ioDirective, rel, inputFilePath, inputFileExt, isIntermediate);
+        if (Global::config().has("parallel-load") && !ioDirective.has("parallel")) {
+            ioDirective.set("parallel", "true");
+        }
     }
 
     return inputDirectives;
@@ -138,6 +152,11 @@ std::vector<IODirectives> AstTranslator::getOutputIODirectives(
         bool hasOutput = false;
         for (const auto* current : rel->getStores()) {
             IODirectives ioDirectives;
+            // keep the number of tuples the output is limited to
+            auto limit = current->getIODirectiveMap().find("limit");
+            if (limit != current->getIODirectiveMap().end()) {
+                ioDirectives.set("limit", limit->second);
+            }
             if (dynamic_cast<const AstPrintSize*>(current) != nullptr) {
                 ioDirectives.setIOType("stdoutprintsize");
                 outputDirectives.push_back(ioDirectives);
@@ -182,7 +201,7 @@ std::vector<IODirectives> AstTranslator::getOutputIODirectives(
                 attributeNames.push_back(rel->getAttribute(i)->getAttributeName());
             }
 
-            if (Global::config().has("provenance")) {
+            if (rel->hasProvenanceColumns()) {
                 std::vector<std::string> originalAttributeNames(
                         attributeNames.begin(), attributeNames.end() - 2);
                 ioDirective.set("attributeNames", toString(join(originalAttributeNames, delimiter)));
@@ -197,11 +216,12 @@ std::vector<IODirectives> AstTranslator::getOutputIODirectives(
 
 std::unique_ptr<RamRelationReference> AstTranslator::createRelationReference(const std::string name,
         const size_t arity, const std::vector<std::string> attributeNames,
-        const std::vector<std::string> attributeTypeQualifiers, const RelationRepresentation representation) {
+        const std::vector<std::string> attributeTypeQualifiers, const RelationRepresentation representation,
+        const std::string& storage) {
     const RamRelation* ramRel = ramProg->getRelation(name);
     if (ramRel == nullptr) {
         ramProg->addRelation(std::make_unique<RamRelation>(
-                name, arity, attributeNames, attributeTypeQualifiers, representation));
+                name, arity, attributeNames, attributeTypeQualifiers, representation, storage));
         ramRel = ramProg->getRelation(name);
         assert(ramRel != nullptr && "cannot find relation");
     }
@@ -234,7 +254,12 @@ std::unique_ptr<RamRelationReference> AstTranslator::translateRelation(
     }
 
     return createRelationReference(relationNamePrefix + getRelationName(rel->getName()), rel->getArity(),
-            attributeNames, attributeTypeQualifiers, rel->getRepresentation());
+            attributeNames, attributeTypeQualifiers, rel->getRepresentation(), rel->getStorage());
+}
+
+bool AstTranslator::hasProvenanceColumns(const AstAtom* atom) {
+    // the RAM relation also covers atoms renamed to temporary relations
+    return translateRelation(atom)->get()->hasProvenanceColumns();
 }
 
 std::unique_ptr<RamRelationReference> AstTranslator::translateDeltaRelation(const AstRelation* rel) {
@@ -245,6 +270,14 @@ std::unique_ptr<RamRelationReference> AstTranslator::translateNewRelation(const
     return translateRelation(rel, "@new_");
 }
 
+std::unique_ptr<RamRelationReference> AstTranslator::translateAddedRelation(const AstRelation* rel) {
+    return translateRelation(rel, "@added_");
+}
+
+std::unique_ptr<RamRelationReference> AstTranslator::translateDeletedRelation(const AstRelation* rel) {
+    return translateRelation(rel, "@deleted_");
+}
+
 std::unique_ptr<RamExpression> AstTranslator::translateValue(
         const AstArgument* arg, const ValueIndex& index) {
     if (arg == nullptr) {
@@ -346,7 +379,8 @@ std::unique_ptr<RamCondition> AstTranslator::translateConstraint(
             auto arity = atom->getArity();
 
             // account for two extra provenance columns
-            if (Global::config().has("provenance")) {
+            const bool provenance = translator.hasProvenanceColumns(atom);
+            if (provenance) {
                 arity -= 2;
             }
 
@@ -357,7 +391,7 @@ std::unique_ptr<RamCondition> AstTranslator::translateConstraint(
             }
 
             // we don't care about the provenance columns when doing the existence check
-            if (Global::config().has("provenance")) {
+            if (provenance) {
                 values.push_back(std::make_unique<RamUndefValue>());
                 values.push_back(std::make_unique<RamUndefValue>());
             }
@@ -378,7 +412,8 @@ std::unique_ptr<RamCondition> AstTranslator::translateConstraint(
             auto arity = atom->getArity();
 
             // account for two extra provenance columns
-            if (Global::config().has("provenance")) {
+            const bool provenance = translator.hasProvenanceColumns(atom);
+            if (provenance) {
                 arity -= 2;
             }
 
@@ -391,7 +426,7 @@ std::unique_ptr<RamCondition> AstTranslator::translateConstraint(
             }
 
             // we don't care about the provenance columns when doing the existence check
-            if (Global::config().has("provenance")) {
+            if (provenance) {
                 values.push_back(std::make_unique<RamUndefValue>());
                 // add the height annotation for provenanceNotExists
                 values.push_back(translator.translateValue(atom->getArgument(arity + 1), index));
@@ -541,7 +576,7 @@ std::unique_ptr<RamOperation> AstTranslator::ClauseTranslator::createOperation(c
 
     // check existence for original tuple if we have provenance
     // only if we don't compile
-    if (Global::config().has("provenance") &&
+    if (translator.hasProvenanceColumns(head) &&
             ((!Global::config().has("compile") && !Global::config().has("dl-program") &&
                     !Global::config().has("generate")))) {
         auto arity = head->getArity() - 2;
@@ -579,7 +614,11 @@ std::unique_ptr<RamOperation> AstTranslator::ProvenanceClauseTranslator::createO
     std::vector<std::unique_ptr<RamExpression>> values;
 
     // get all values in the body
+    int count = 0;
     for (AstLiteral* lit : clause.getBodyLiterals()) {
+        if (literals >= 0 && count++ == literals) {
+            break;
+        }
         if (auto atom = dynamic_cast<AstAtom*>(lit)) {
             for (AstArgument* arg : atom->getArguments()) {
                 values.push_back(translator.translateValue(arg, valueIndex));
@@ -601,6 +640,11 @@ std::unique_ptr<RamOperation> AstTranslator::ProvenanceClauseTranslator::createO
         }
     }
 
+    // separate the derivations, as a lazy search reads all of them
+    if (literals >= 0) {
+        values.push_back(std::make_unique<RamUndefValue>());
+    }
+
     return std::make_unique<RamSubroutineReturnValue>(std::move(values));
 }
 
@@ -824,8 +868,14 @@ std::unique_ptr<RamStatement> AstTranslator::ClauseTranslator::translateClause(
                             std::make_unique<RamNegation>(
                                     std::make_unique<RamEmptinessCheck>(translator.translateRelation(head))),
                             std::move(op));
+                } else if (size_t limit = (level == 0) ? translator.getOutputLimit(head) : 0) {
+                    // leave the outermost loop once enough tuples are derived for the output
+                    op = std::make_unique<RamBreak>(
+                            std::make_unique<RamSizeCheck>(translator.translateRelation(head), limit),
+                            std::move(op));
                 }
-                if (Global::config().has("profile")) {
+                // sampling avoids counting the tuples of each scan
+                if (Global::config().has("profile") && !Global::config().has("profile-sampling")) {
                     std::stringstream ss;
                     ss << head->getName();
                     ss.str("");
@@ -878,6 +928,251 @@ std::unique_ptr<RamStatement> AstTranslator::ClauseTranslator::translateClause(
     }
 }
 
+/** generate RAM code for a rule as a multi-way join over its variables */
+std::unique_ptr<RamStatement> AstTranslator::ClauseTranslator::translateGenericJoin(
+        const AstClause& clause, const AstClause& originalClause) {
+    const AstAtom* head = clause.getHead();
+
+    // the atoms, those reading a delta relation first
+    std::vector<const AstAtom*> atoms;
+    for (bool delta : {true, false}) {
+        for (const AstAtom* atom : clause.getAtoms()) {
+            const std::string name = translator.translateRelation(atom)->get()->getName();
+            if ((name.find("@delta_") == 0) == delta) {
+                atoms.push_back(atom);
+            }
+        }
+    }
+
+    // variables occurring once are not bound, like unnamed variables
+    std::map<std::string, int> occurrences;
+    visitDepthFirst(clause, [&](const AstVariable& var) { occurrences[var.getName()]++; });
+
+    // the variables in the order of their first occurrence, each bound at its own level
+    std::vector<const AstVariable*> variables;
+    std::map<std::string, int> varLevel;
+    for (const AstAtom* atom : atoms) {
+        for (const AstArgument* arg : atom->getArguments()) {
+            const auto* var = dynamic_cast<const AstVariable*>(arg);
+            if (var != nullptr && occurrences[var->getName()] > 1 && varLevel.count(var->getName()) == 0) {
+                varLevel[var->getName()] = variables.size();
+                valueIndex.addVarReference(*var, variables.size(), 0);
+                variables.push_back(var);
+            }
+        }
+    }
+
+    // -- create RAM statement --
+
+    std::unique_ptr<RamOperation> op = createOperation(clause);
+
+    /* add conditions caused by negations and binary relations */
+    for (const auto& lit : clause.getBodyLiterals()) {
+        if (auto condition = translator.translateConstraint(lit, valueIndex)) {
+            op = std::make_unique<RamFilter>(std::move(condition), std::move(op));
+        }
+    }
+
+    // build an intersection of the atoms containing the variable per level, bottom-up
+    for (int cur = variables.size() - 1; cur >= 0; --cur) {
+        if (head->getArity() == 0) {
+            op = std::make_unique<RamBreak>(std::make_unique<RamNegation>(std::make_unique<RamEmptinessCheck>(
+                                                    translator.translateRelation(head))),
+                    std::move(op));
+        } else if (size_t limit = (cur == 0) ? translator.getOutputLimit(head) : 0) {
+            op = std::make_unique<RamBreak>(
+                    std::make_unique<RamSizeCheck>(translator.translateRelation(head), limit), std::move(op));
+        }
+        auto intersect = std::make_unique<RamIntersect>(cur, std::move(op));
+        for (const AstAtom* atom : atoms) {
+            for (size_t pos = 0; pos < atom->argSize(); ++pos) {
+                const auto* var = dynamic_cast<const AstVariable*>(atom->getArgument(pos));
+                if (var == nullptr || var->getName() != variables[cur]->getName()) {
+                    continue;
+                }
+
+                // constants and variables of outer levels are bound
+                std::vector<std::unique_ptr<RamExpression>> pattern;
+                for (const AstArgument* arg : atom->getArguments()) {
+                    const auto* other = dynamic_cast<const AstVariable*>(arg);
+                    if (const auto* c = dynamic_cast<const AstConstant*>(arg)) {
+                        pattern.push_back(std::make_unique<RamNumber>(c->getIndex()));
+                    } else if (other != nullptr && varLevel.count(other->getName()) != 0 &&
+                               varLevel[other->getName()] < cur) {
+                        pattern.push_back(std::make_unique<RamTupleElement>(varLevel[other->getName()], 0));
+                    } else {
+                        pattern.push_back(std::make_unique<RamUndefValue>());
+                    }
+                }
+                intersect->add(translator.translateRelation(atom), std::move(pattern), pos);
+            }
+        }
+        op = std::move(intersect);
+    }
+
+    // add checks for emptiness for the atoms
+    for (auto it = atoms.rbegin(); it != atoms.rend(); ++it) {
+        op = std::make_unique<RamFilter>(std::make_unique<RamNegation>(std::make_unique<RamEmptinessCheck>(
+                                                 translator.translateRelation(*it))),
+                std::move(op));
+    }
+
+    /* generate the final RAM Insert statement */
+    std::unique_ptr<RamCondition> cond = createCondition(originalClause);
+    if (cond != nullptr) {
+        return std::make_unique<RamQuery>(std::make_unique<RamFilter>(std::move(cond), std::move(op)));
+    } else {
+        return std::make_unique<RamQuery>(std::move(op));
+    }
+}
+
+bool AstTranslator::useGenericJoin(const AstClause& clause) const {
+    const std::string mode =
+            Global::config().has("generic-join") ? Global::config().get("generic-join") : "auto";
+    if (mode == "off" || Global::config().has("provenance") || !clause.isRule() ||
+            clause.getExecutionPlan() != nullptr || clause.hasFixedExecutionPlan()) {
+        return false;
+    }
+
+    // aggregates are evaluated by nested operations
+    bool hasAggregator = false;
+    visitDepthFirst(clause, [&](const AstAggregator& agg) { hasAggregator = true; });
+    const std::vector<AstAtom*> atoms = clause.getAtoms();
+    if (hasAggregator || atoms.size() < 2) {
+        return false;
+    }
+
+    std::map<std::string, int> occurrences;
+    visitDepthFirst(clause, [&](const AstVariable& var) { occurrences[var.getName()]++; });
+
+    // the variables of each atom occurring elsewhere, the edges of the query hypergraph
+    std::vector<std::set<std::string>> edges;
+    std::set<std::string> atomVariables;
+    for (const AstAtom* atom : atoms) {
+        // intersections require the signed order of b-trees; compiled relations of a larger
+        // arity are indirect indexes
+        const AstRelation* rel = getAtomRelation(atom, program);
+        if (rel == nullptr || !(rel->getRepresentation() == RelationRepresentation::BTREE ||
+                                       (rel->getRepresentation() == RelationRepresentation::DEFAULT &&
+                                               rel->getArity() <= 6))) {
+            return false;
+        }
+
+        // arguments are distinct variables, unnamed variables, or constants
+        std::set<std::string> names;
+        std::set<std::string> edge;
+        for (const AstArgument* arg : atom->getArguments()) {
+            if (const auto* var = dynamic_cast<const AstVariable*>(arg)) {
+                if (!names.insert(var->getName()).second) {
+                    return false;
+                }
+                atomVariables.insert(var->getName());
+                if (occurrences[var->getName()] > 1) {
+                    edge.insert(var->getName());
+                }
+            } else if (dynamic_cast<const AstUnnamedVariable*>(arg) == nullptr &&
+                       dynamic_cast<const AstConstant*>(arg) == nullptr) {
+                return false;
+            }
+        }
+        if (edge.empty()) {
+            return false;
+        }
+        edges.push_back(edge);
+    }
+
+    // all other variables must be bound by the atoms
+    for (const auto& cur : occurrences) {
+        if (atomVariables.count(cur.first) == 0) {
+            return false;
+        }
+    }
+    if (mode == "all") {
+        return true;
+    }
+
+    // by default, only rules with cyclic bodies are joined by intersections, which is
+    // determined by a GYO reduction failing to reduce the edges to a single one
+    bool changed = true;
+    while (changed && edges.size() > 1) {
+        changed = false;
+
+        // remove variables contained in a single edge
+        std::map<std::string, int> degree;
+        for (const auto& edge : edges) {
+            for (const std::string& var : edge) {
+                degree[var]++;
+            }
+        }
+        for (auto& edge : edges) {
+            for (auto it = edge.begin(); it != edge.end();) {
+                if (degree[*it] == 1) {
+                    it = edge.erase(it);
+                    changed = true;
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        // remove edges contained in another edge
+        for (auto it = edges.begin(); it != edges.end();) {
+            bool contained = false;
+            for (auto other = edges.begin(); other != edges.end() && !contained; ++other) {
+                contained = other != it &&
+                            std::includes(other->begin(), other->end(), it->begin(), it->end());
+            }
+            if (contained) {
+                it = edges.erase(it);
+                changed = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+    return edges.size() > 1;
+}
+
+size_t AstTranslator::getOutputLimit(const AstAtom* head) const {
+    auto pos = outputLimits.find(head->getName());
+    return (pos != outputLimits.end()) ? pos->second : 0;
+}
+
+void AstTranslator::computeOutputLimits() {
+    outputLimits.clear();
+
+    // provenance and incremental evaluation require the complete relations
+    if (Global::config().has("provenance") || Global::config().has("incremental")) {
+        return;
+    }
+
+    // relations read by rules are complete for the strata depending on them
+    std::set<AstRelationIdentifier> read;
+    for (const AstRelation* rel : program->getRelations()) {
+        for (const AstClause* clause : rel->getClauses()) {
+            for (const AstLiteral* lit : clause->getBodyLiterals()) {
+                visitDepthFirst(*lit, [&](const AstAtom& atom) { read.insert(atom.getName()); });
+            }
+        }
+    }
+
+    for (const AstRelation* rel : program->getRelations()) {
+        size_t limit = 0;
+        for (const AstStore* store : rel->getStores()) {
+            const auto& directives = store->getIODirectiveMap();
+            auto pos = directives.find("limit");
+            if (pos == directives.end()) {
+                limit = 0;
+                break;
+            }
+            limit = std::max<size_t>(limit, std::stoul(pos->second));
+        }
+        if (limit > 0 && read.count(rel->getName()) == 0) {
+            outputLimits[rel->getName()] = limit;
+        }
+    }
+}
+
 /* utility for appending statements */
 void AstTranslator::appendStmt(std::unique_ptr<RamStatement>& stmtList, std::unique_ptr<RamStatement> stmt) {
     if (stmt) {
@@ -911,7 +1206,9 @@ std::unique_ptr<RamStatement> AstTranslator::translateNonRecursiveRelation(
         }
 
         // translate clause
-        std::unique_ptr<RamStatement> rule = ClauseTranslator(*this).translateClause(*clause, *clause);
+        std::unique_ptr<RamStatement> rule =
+                useGenericJoin(*clause) ? ClauseTranslator(*this).translateGenericJoin(*clause, *clause)
+                                        : ClauseTranslator(*this).translateClause(*clause, *clause);
 
         // add logging
         if (Global::config().has("profile")) {
@@ -922,8 +1219,13 @@ std::unique_ptr<RamStatement> AstTranslator::translateNonRecursiveRelation(
                     LogStatement::tNonrecursiveRule(relationName, srcLocation, clauseText);
             const std::string logSizeStatement =
                     LogStatement::nNonrecursiveRule(relationName, srcLocation, clauseText);
-            rule = std::make_unique<RamSequence>(std::make_unique<RamLogRelationTimer>(std::move(rule),
-                    logTimerStatement, std::unique_ptr<RamRelationReference>(rrel->clone())));
+            if (Global::config().has("profile-sampling")) {
+                rule = std::make_unique<RamLogTimer>(
+                        std::move(rule), LogStatement::sRule(relationName, srcLocation, clauseText));
+            } else {
+                rule = std::make_unique<RamSequence>(std::make_unique<RamLogRelationTimer>(std::move(rule),
+                        logTimerStatement, std::unique_ptr<RamRelationReference>(rrel->clone())));
+            }
         }
 
         // add debug info
@@ -936,6 +1238,31 @@ std::unique_ptr<RamStatement> AstTranslator::translateNonRecursiveRelation(
         appendStmt(res, std::move(rule));
     }
 
+    // insert the facts of the fact table, sharing a single debug record
+    if (const AstFactTable* facts = rel.getFactTable()) {
+        std::unique_ptr<RamStatement> inserts;
+        for (size_t i = 0; i < facts->size(); i++) {
+            const RamDomain* tuple = (*facts)[i];
+            std::vector<std::unique_ptr<RamExpression>> values;
+            for (size_t j = 0; j < facts->getArity(); j++) {
+                values.push_back(std::make_unique<RamNumber>(tuple[j]));
+            }
+            auto fact = std::make_unique<RamFact>(
+                    std::unique_ptr<RamRelationReference>(rrel->clone()), std::move(values));
+            appendStmt(inserts, std::move(fact));
+        }
+        if (inserts) {
+            std::ostringstream ds;
+            ds << facts->size() << " facts of " << rel.getName() << "\nin file " << facts->getSrcLoc();
+            appendStmt(res, std::make_unique<RamDebugInfo>(std::move(inserts), ds.str()));
+        }
+    }
+
+    // drop the tuples dominated by others
+    if (rel.isSubsumptive()) {
+        appendStmt(res, translateSubsumption(rel));
+    }
+
     // add logging for entire relation
     if (Global::config().has("profile")) {
         const std::string& relationName = toString(rel.getName());
@@ -959,6 +1286,85 @@ std::unique_ptr<RamStatement> AstTranslator::translateNonRecursiveRelation(
     return res;
 }
 
+/** generate RAM code copying the tuples of a subsumptive relation that as many tuples dominate or equal */
+std::unique_ptr<RamStatement> AstTranslator::translateDominanceFilter(const AstRelation& rel,
+        const AstRelationIdentifier& source, const AstRelationIdentifier& target,
+        const std::vector<std::pair<AstRelationIdentifier, AstDomain>>& dominating) {
+    // the column in which tuples dominate for each attribute, if any
+    std::vector<const AstDominance*> columns(rel.getArity(), nullptr);
+    for (size_t i = 0; i < rel.getArity(); ++i) {
+        for (const AstDominance& column : rel.getDominance()) {
+            if (column.attribute == rel.getAttribute(i)->getAttributeName()) {
+                columns[i] = &column;
+            }
+        }
+    }
+
+    // an atom over the variables of the tuple, those of dominating columns renamed by the prefix
+    auto makeAtom = [&](const AstRelationIdentifier& name, const std::string& prefix) {
+        auto atom = std::make_unique<AstAtom>(name);
+        for (size_t i = 0; i < rel.getArity(); ++i) {
+            const std::string name = (columns[i] != nullptr) ? prefix : "+v";
+            atom->addArgument(std::make_unique<AstVariable>(name + std::to_string(i)));
+        }
+        return atom;
+    };
+
+    auto clause = std::make_unique<AstClause>();
+    clause->setHead(makeAtom(target, "+v"));
+    clause->addToBody(makeAtom(source, "+v"));
+    for (const auto& cur : dominating) {
+        auto count = std::make_unique<AstAggregator>(AstAggregator::count);
+        count->addBodyLiteral(makeAtom(cur.first, "+w"));
+        for (size_t i = 0; i < rel.getArity(); ++i) {
+            if (columns[i] != nullptr) {
+                count->addBodyLiteral(std::make_unique<AstBinaryConstraint>(
+                        columns[i]->minimise ? BinaryConstraintOp::LE : BinaryConstraintOp::GE,
+                        std::make_unique<AstVariable>("+w" + std::to_string(i)),
+                        std::make_unique<AstVariable>("+v" + std::to_string(i))));
+            }
+        }
+        clause->addToBody(std::make_unique<AstBinaryConstraint>(BinaryConstraintOp::EQ,
+                std::make_unique<AstNumberConstant>(cur.second), std::move(count)));
+    }
+
+    std::ostringstream ds;
+    ds << "subsumption of " << rel.getName() << "\nin file " << rel.getSrcLoc();
+    return std::make_unique<RamDebugInfo>(
+            ClauseTranslator(*this).translateClause(*clause, *clause), ds.str());
+}
+
+/** generate RAM code dropping the tuples of a subsumptive relation dominated by others */
+std::unique_ptr<RamStatement> AstTranslator::translateSubsumption(const AstRelation& rel) {
+    // the tuples dominated by none but themselves are collected in the delta relation
+    const std::string deltaName = translateDeltaRelation(&rel)->get()->getName();
+    std::unique_ptr<RamStatement> res = std::make_unique<RamClear>(translateDeltaRelation(&rel));
+    appendStmt(res, translateDominanceFilter(rel, rel.getName(), deltaName, {{rel.getName(), 1}}));
+    appendStmt(res, std::make_unique<RamClear>(translateRelation(&rel)));
+    appendStmt(res, std::make_unique<RamMerge>(translateRelation(&rel), translateDeltaRelation(&rel)));
+    appendStmt(res, std::make_unique<RamClear>(translateDeltaRelation(&rel)));
+    return res;
+}
+
+/** generate RAM code updating a subsumptive relation by the new tuples of an iteration */
+std::unique_ptr<RamStatement> AstTranslator::translateSubsumptiveUpdate(const AstRelation& rel) {
+    // the new tuples, swapped into the delta relation, are filtered back into the new relation as
+    // long as no tuple of the relation or other new tuple dominates them, keeping the swaps of the
+    // delta and new relations that their shared indexes rely on
+    const std::string deltaName = translateDeltaRelation(&rel)->get()->getName();
+    const std::string newName = translateNewRelation(&rel)->get()->getName();
+    std::unique_ptr<RamStatement> res =
+            std::make_unique<RamSwap>(translateDeltaRelation(&rel), translateNewRelation(&rel));
+    appendStmt(res, std::make_unique<RamClear>(translateNewRelation(&rel)));
+    appendStmt(res, translateDominanceFilter(rel, deltaName, newName, {{rel.getName(), 0}, {deltaName, 1}}));
+    appendStmt(res, std::make_unique<RamSwap>(translateDeltaRelation(&rel), translateNewRelation(&rel)));
+    appendStmt(res, std::make_unique<RamClear>(translateNewRelation(&rel)));
+
+    // the relation keeps the tuples the new ones dominate until its final subsumption
+    appendStmt(res, std::make_unique<RamMerge>(translateRelation(&rel), translateDeltaRelation(&rel)));
+    return res;
+}
+
 /**
  * A utility function assigning names to unnamed variables such that enclosing
  * constructs may be cloned without losing the variable-identity.
@@ -992,6 +1398,89 @@ void AstTranslator::nameUnnamedVariables(AstClause* clause) {
     }
 }
 
+/** generate RAM code for a version of a recursive clause with alternative join orders */
+std::unique_ptr<RamStatement> AstTranslator::translateAdaptiveClause(const AstClause& clause,
+        const AstClause& originalClause, const int version, const unsigned int deltaAtom) {
+    const unsigned int numAtoms = clause.getAtoms().size();
+
+    // the alternatives: the given order, the delta relation first, and the delta relation last
+    std::vector<std::vector<unsigned int>> orders(1);
+    for (unsigned int i = 0; i < numAtoms; i++) {
+        orders[0].push_back(i);
+    }
+    for (bool deltaFirst : {true, false}) {
+        std::vector<unsigned int> order;
+        if (deltaFirst) {
+            order.push_back(deltaAtom);
+        }
+        for (unsigned int i = 0; i < numAtoms; i++) {
+            if (i != deltaAtom) {
+                order.push_back(i);
+            }
+        }
+        if (!deltaFirst) {
+            order.push_back(deltaAtom);
+        }
+        if (!contains(orders, order)) {
+            orders.push_back(order);
+        }
+    }
+
+    if (orders.size() == 1) {
+        return ClauseTranslator(*this).translateClause(clause, originalClause, version);
+    }
+
+    auto planSwitch = std::make_unique<RamPlanSwitch>();
+    for (const auto& order : orders) {
+        std::unique_ptr<AstClause> reorderedClause(clause.clone());
+        reorderedClause->reorderAtoms(order);
+
+        // record how many attributes of each atom are bound by the preceding atoms or are constant
+        std::set<std::string> boundVariables;
+        std::vector<std::unique_ptr<RamRelationReference>> relations;
+        std::vector<size_t> boundAttributes;
+        for (const AstAtom* atom : reorderedClause->getAtoms()) {
+            size_t numBound = 0;
+            for (const AstArgument* arg : atom->getArguments()) {
+                bool isBound = true;
+                visitDepthFirst(*arg, [&](const AstVariable& var) {
+                    if (boundVariables.find(var.getName()) == boundVariables.end()) {
+                        isBound = false;
+                    }
+                });
+                numBound += isBound ? 1 : 0;
+            }
+            for (const AstArgument* arg : atom->getArguments()) {
+                if (const auto* var = dynamic_cast<const AstVariable*>(arg)) {
+                    boundVariables.insert(var->getName());
+                }
+            }
+            relations.push_back(translateRelation(atom));
+            boundAttributes.push_back(numBound);
+        }
+
+        planSwitch->add(ClauseTranslator(*this).translateClause(*reorderedClause, originalClause, version),
+                std::move(relations), std::move(boundAttributes));
+    }
+    return std::move(planSwitch);
+}
+
+#ifdef USE_MPI
+bool AstTranslator::isPartitioned(const std::set<const AstRelation*>& scc) const {
+    if (Global::config().get("engine") != "mpi" || !Global::config().has("mpi-partitions") ||
+            std::stoi(Global::config().get("mpi-partitions")) < 2) {
+        return false;
+    }
+    // equivalence relations close the tuples inserted, which would not be confined to a partition
+    for (const AstRelation* rel : scc) {
+        if (rel->getRepresentation() == RelationRepresentation::EQREL) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
 /** generate RAM code for recursive relations in a strongly-connected component */
 std::unique_ptr<RamStatement> AstTranslator::translateRecursiveRelation(
         const std::set<const AstRelation*>& scc, const RecursiveClauses* recursiveClauses) {
@@ -1000,8 +1489,21 @@ std::unique_ptr<RamStatement> AstTranslator::translateRecursiveRelation(
     std::unique_ptr<RamSequence> updateTable(new RamSequence());
     std::unique_ptr<RamStatement> postamble;
 
+    // the LVM may re-plan the versions of recursive clauses in every iteration
+    const bool adaptiveJoinOrders = Global::config().get("interpreter") == "LVM" &&
+                                    !Global::config().has("compile") && !Global::config().has("generate") &&
+                                    !Global::config().has("provenance") &&
+                                    !Global::config().has("disable-lvm-replanning");
+
     // --- create preamble ---
 
+#ifdef USE_MPI
+    // the ranks of a partitioned component evaluate the rules over their partitions of the delta
+    // relations and exchange the new tuples in each iteration
+    const bool partitioned = isPartitioned(scc);
+    std::unique_ptr<RamStatement> exchange;
+#endif
+
     // mappings for temporary relations
     std::map<const AstRelation*, std::unique_ptr<RamRelationReference>> rrel;
     std::map<const AstRelation*, std::unique_ptr<RamRelationReference>> relDelta;
@@ -1018,15 +1520,48 @@ std::unique_ptr<RamStatement> AstTranslator::translateRecursiveRelation(
         relNew[rel] = translateNewRelation(rel);
 
         /* create update statements for fixpoint (even iteration) */
-        appendStmt(updateRelTable,
-                std::make_unique<RamSequence>(
-                        std::make_unique<RamMerge>(std::unique_ptr<RamRelationReference>(rrel[rel]->clone()),
-                                std::unique_ptr<RamRelationReference>(relNew[rel]->clone())),
-                        std::make_unique<RamSwap>(
-                                std::unique_ptr<RamRelationReference>(relDelta[rel]->clone()),
-                                std::unique_ptr<RamRelationReference>(relNew[rel]->clone())),
-                        std::make_unique<RamClear>(
-                                std::unique_ptr<RamRelationReference>(relNew[rel]->clone()))));
+        if (rel->isSubsumptive()) {
+            appendStmt(updateRelTable, translateSubsumptiveUpdate(*rel));
+#ifdef USE_MPI
+            if (partitioned) {
+                appendStmt(exchange, std::make_unique<RamExchange>(
+                                             std::unique_ptr<RamRelationReference>(relNew[rel]->clone())));
+                appendStmt(updateRelTable,
+                        std::make_unique<RamPartition>(
+                                std::unique_ptr<RamRelationReference>(relDelta[rel]->clone())));
+            }
+#endif
+        } else
+#ifdef USE_MPI
+                if (partitioned) {
+            appendStmt(exchange, std::make_unique<RamExchange>(
+                                         std::unique_ptr<RamRelationReference>(relNew[rel]->clone())));
+            appendStmt(updateRelTable,
+                    std::make_unique<RamSequence>(
+                            std::make_unique<RamMerge>(
+                                    std::unique_ptr<RamRelationReference>(rrel[rel]->clone()),
+                                    std::unique_ptr<RamRelationReference>(relNew[rel]->clone())),
+                            std::make_unique<RamPartition>(
+                                    std::unique_ptr<RamRelationReference>(relNew[rel]->clone())),
+                            std::make_unique<RamSwap>(
+                                    std::unique_ptr<RamRelationReference>(relDelta[rel]->clone()),
+                                    std::unique_ptr<RamRelationReference>(relNew[rel]->clone())),
+                            std::make_unique<RamClear>(
+                                    std::unique_ptr<RamRelationReference>(relNew[rel]->clone()))));
+        } else
+#endif
+        {
+            appendStmt(updateRelTable,
+                    std::make_unique<RamSequence>(
+                            std::make_unique<RamMerge>(
+                                    std::unique_ptr<RamRelationReference>(rrel[rel]->clone()),
+                                    std::unique_ptr<RamRelationReference>(relNew[rel]->clone())),
+                            std::make_unique<RamSwap>(
+                                    std::unique_ptr<RamRelationReference>(relDelta[rel]->clone()),
+                                    std::unique_ptr<RamRelationReference>(relNew[rel]->clone())),
+                            std::make_unique<RamClear>(
+                                    std::unique_ptr<RamRelationReference>(relNew[rel]->clone()))));
+        }
 
         /* measure update time for each relation */
         if (Global::config().has("profile")) {
@@ -1035,7 +1570,10 @@ std::unique_ptr<RamStatement> AstTranslator::translateRecursiveRelation(
                     std::unique_ptr<RamRelationReference>(relNew[rel]->clone()));
         }
 
-        /* drop temporary tables after recursion */
+        /* drop the tuples dominated by those derived later, then temporary tables after recursion */
+        if (rel->isSubsumptive()) {
+            appendStmt(postamble, translateSubsumption(*rel));
+        }
         appendStmt(postamble, std::make_unique<RamSequence>(
                                       std::make_unique<RamDrop>(
                                               std::unique_ptr<RamRelationReference>(relDelta[rel]->clone())),
@@ -1049,6 +1587,12 @@ std::unique_ptr<RamStatement> AstTranslator::translateRecursiveRelation(
         appendStmt(preamble,
                 std::make_unique<RamMerge>(std::unique_ptr<RamRelationReference>(relDelta[rel]->clone()),
                         std::unique_ptr<RamRelationReference>(rrel[rel]->clone())));
+#ifdef USE_MPI
+        if (partitioned) {
+            appendStmt(preamble, std::make_unique<RamPartition>(
+                                         std::unique_ptr<RamRelationReference>(relDelta[rel]->clone())));
+        }
+#endif
 
         /* Add update operations of relations to parallel statements */
         updateTable->add(std::move(updateRelTable));
@@ -1092,7 +1636,7 @@ std::unique_ptr<RamStatement> AstTranslator::translateRecursiveRelation(
                 std::unique_ptr<AstClause> r1(cl->clone());
                 r1->getHead()->setName(relNew[rel]->get()->getName());
                 r1->getAtoms()[j]->setName(relDelta[atomRelation]->get()->getName());
-                if (Global::config().has("provenance")) {
+                if (rel->hasProvenanceColumns()) {
                     r1->addToBody(std::make_unique<AstProvenanceNegation>(
                             std::unique_ptr<AstAtom>(cl->getHead()->clone())));
                 } else {
@@ -1114,8 +1658,14 @@ std::unique_ptr<RamStatement> AstTranslator::translateRecursiveRelation(
                     }
                 }
 
-                std::unique_ptr<RamStatement> rule =
-                        ClauseTranslator(*this).translateClause(*r1, *cl, version);
+                std::unique_ptr<RamStatement> rule;
+                if (useGenericJoin(*cl)) {
+                    rule = ClauseTranslator(*this).translateGenericJoin(*r1, *cl);
+                } else if (adaptiveJoinOrders && cl->getExecutionPlan() == nullptr) {
+                    rule = translateAdaptiveClause(*r1, *cl, version, j);
+                } else {
+                    rule = ClauseTranslator(*this).translateClause(*r1, *cl, version);
+                }
 
                 /* add logging */
                 if (Global::config().has("profile")) {
@@ -1126,9 +1676,14 @@ std::unique_ptr<RamStatement> AstTranslator::translateRecursiveRelation(
                             LogStatement::tRecursiveRule(relationName, version, srcLocation, clauseText);
                     const std::string logSizeStatement =
                             LogStatement::nRecursiveRule(relationName, version, srcLocation, clauseText);
-                    rule = std::make_unique<RamSequence>(
-                            std::make_unique<RamLogRelationTimer>(std::move(rule), logTimerStatement,
-                                    std::unique_ptr<RamRelationReference>(relNew[rel]->clone())));
+                    if (Global::config().has("profile-sampling")) {
+                        rule = std::make_unique<RamLogTimer>(
+                                std::move(rule), LogStatement::sRule(relationName, srcLocation, clauseText));
+                    } else {
+                        rule = std::make_unique<RamSequence>(
+                                std::make_unique<RamLogRelationTimer>(std::move(rule), logTimerStatement,
+                                        std::unique_ptr<RamRelationReference>(relNew[rel]->clone())));
+                    }
                 }
 
                 // add debug info
@@ -1181,8 +1736,16 @@ std::unique_ptr<RamStatement> AstTranslator::translateRecursiveRelation(
     std::unique_ptr<RamStatement> res;
     if (preamble) appendStmt(res, std::move(preamble));
     if (!loopSeq->getStatements().empty() && exitCond && updateTable) {
-        appendStmt(res, std::make_unique<RamLoop>(std::move(loopSeq),
-                                std::make_unique<RamExit>(std::move(exitCond)), std::move(updateTable)));
+#ifdef USE_MPI
+        if (exchange) {
+            appendStmt(res, std::make_unique<RamLoop>(std::move(loopSeq), std::move(exchange),
+                                    std::make_unique<RamExit>(std::move(exitCond)), std::move(updateTable)));
+        } else
+#endif
+        {
+            appendStmt(res, std::make_unique<RamLoop>(std::move(loopSeq),
+                                    std::make_unique<RamExit>(std::move(exitCond)), std::move(updateTable)));
+        }
     }
     if (postamble) {
         appendStmt(res, std::move(postamble));
@@ -1193,6 +1756,338 @@ std::unique_ptr<RamStatement> AstTranslator::translateRecursiveRelation(
     return nullptr;
 }
 
+const AstRelation* AstTranslator::getClosureSource(const std::set<const AstRelation*>& scc) const {
+    if (!Global::config().has("transitive-closure") || Global::config().has("incremental") ||
+            Global::config().has("provenance") || Global::config().has("engine") || scc.size() != 1) {
+        return nullptr;
+    }
+    const AstRelation* rel = *scc.begin();
+    if (rel->getArity() != 2 || rel->isSubsumptive() || rel->getFactTable() != nullptr ||
+            rel->getRepresentation() == RelationRepresentation::EQREL) {
+        return nullptr;
+    }
+
+    // the names of the arguments of a binary atom if they are distinct variables
+    auto getVariables = [](const AstAtom* atom, std::string& first, std::string& second) {
+        const auto* x = dynamic_cast<const AstVariable*>(atom->getArgument(0));
+        const auto* y = dynamic_cast<const AstVariable*>(atom->getArgument(1));
+        if (x == nullptr || y == nullptr || x->getName() == y->getName()) {
+            return false;
+        }
+        first = x->getName();
+        second = y->getName();
+        return true;
+    };
+
+    // rel(x, y) :- source(x, y) once, and rel(x, z) :- a(x, y), b(y, z) for a and b each rel or source
+    const AstRelation* source = nullptr;
+    std::vector<const AstRelation*> joined;
+    for (const AstClause* clause : rel->getClauses()) {
+        std::string x, y;
+        if (!clause->isRule() || !getVariables(clause->getHead(), x, y)) {
+            return nullptr;
+        }
+        std::vector<const AstAtom*> atoms;
+        for (const AstLiteral* lit : clause->getBodyLiterals()) {
+            const auto* atom = dynamic_cast<const AstAtom*>(lit);
+            if (atom == nullptr || atom->getArity() != 2) {
+                return nullptr;
+            }
+            atoms.push_back(atom);
+        }
+        std::string a, b, c, d;
+        if (atoms.size() == 1) {
+            const AstRelation* base = getAtomRelation(atoms[0], program);
+            if (source != nullptr || base == nullptr || base == rel || !getVariables(atoms[0], a, b) ||
+                    a != x || b != y) {
+                return nullptr;
+            }
+            source = base;
+        } else if (atoms.size() == 2) {
+            if (!getVariables(atoms[0], a, b) || !getVariables(atoms[1], c, d) || a != x || d != y ||
+                    b != c) {
+                return nullptr;
+            }
+            joined.push_back(getAtomRelation(atoms[0], program));
+            joined.push_back(getAtomRelation(atoms[1], program));
+        } else {
+            return nullptr;
+        }
+    }
+    if (source == nullptr) {
+        return nullptr;
+    }
+    for (const AstRelation* cur : joined) {
+        if (cur != rel && cur != source) {
+            return nullptr;
+        }
+    }
+    for (size_t i = 0; i < 2; i++) {
+        if (source->getAttribute(i)->getTypeName() != rel->getAttribute(i)->getTypeName()) {
+            return nullptr;
+        }
+    }
+    return source;
+}
+
+std::unique_ptr<RamStatement> AstTranslator::translateTransitiveClosure(
+        const AstRelation& rel, const AstRelation& source) {
+    std::unique_ptr<RamStatement> res =
+            std::make_unique<RamTransitiveClosure>(translateRelation(&rel), translateRelation(&source));
+
+    // add debug info
+    std::ostringstream ds;
+    ds << "transitive closure of " << source.getName() << " into " << rel.getName() << "\nin file "
+       << rel.getSrcLoc();
+    res = std::make_unique<RamDebugInfo>(std::move(res), ds.str());
+
+    // the closure is evaluated at once, like a non-recursive relation
+    if (Global::config().has("profile")) {
+        const std::string logTimerStatement =
+                LogStatement::tNonrecursiveRelation(toString(rel.getName()), rel.getSrcLoc());
+        res = std::make_unique<RamLogRelationTimer>(
+                std::move(res), logTimerStatement, translateRelation(&rel));
+    }
+    return res;
+}
+
+/** generate RAM code for a version of a clause maintaining relations incrementally */
+std::unique_ptr<RamStatement> AstTranslator::translateIncrementalClause(
+        AstClause& version, const AstClause& clause) {
+    nameUnnamedVariables(&version);
+    std::ostringstream ds;
+    ds << toString(clause) << "\nin file " << clause.getSrcLoc();
+    return std::make_unique<RamDebugInfo>(ClauseTranslator(*this).translateClause(version, clause), ds.str());
+}
+
+/** generate RAM code for the semi-naive loop of an incremental update of a strongly-connected component */
+std::unique_ptr<RamStatement> AstTranslator::translateIncrementalLoop(const std::set<const AstRelation*>& scc,
+        const RecursiveClauses* recursiveClauses, const IncrementalVersion& translateVersion,
+        const IncrementalTargets& targets) {
+    auto loopSeq = std::make_unique<RamParallel>();
+    auto updateTable = std::make_unique<RamSequence>();
+    std::unique_ptr<RamCondition> exitCond;
+    std::unique_ptr<RamStatement> postamble;
+    for (const AstRelation* rel : scc) {
+        std::unique_ptr<RamStatement> loopRelSeq;
+        for (const AstClause* cl : rel->getClauses()) {
+            if (!recursiveClauses->recursive(cl)) {
+                continue;
+            }
+            const auto& atoms = cl->getAtoms();
+            for (size_t j = 0; j < atoms.size(); ++j) {
+                const AstRelation* atomRelation = getAtomRelation(atoms[j], program);
+                if (scc.count(atomRelation) == 0) {
+                    continue;
+                }
+                const std::string deltaName = translateDeltaRelation(atomRelation)->get()->getName();
+                appendStmt(loopRelSeq, translateVersion(*cl, rel, j, deltaName));
+            }
+        }
+        if (loopRelSeq) {
+            loopSeq->add(std::move(loopRelSeq));
+        }
+
+        std::unique_ptr<RamStatement> updateRelTable;
+        for (auto& target : targets(rel)) {
+            appendStmt(
+                    updateRelTable, std::make_unique<RamMerge>(std::move(target), translateNewRelation(rel)));
+        }
+        appendStmt(updateRelTable,
+                std::make_unique<RamSwap>(translateDeltaRelation(rel), translateNewRelation(rel)));
+        appendStmt(updateRelTable, std::make_unique<RamClear>(translateNewRelation(rel)));
+        updateTable->add(std::move(updateRelTable));
+
+        std::unique_ptr<RamCondition> empty = std::make_unique<RamEmptinessCheck>(translateNewRelation(rel));
+        exitCond = exitCond ? std::make_unique<RamConjunction>(std::move(exitCond), std::move(empty))
+                            : std::move(empty);
+
+        appendStmt(postamble, std::make_unique<RamClear>(translateDeltaRelation(rel)));
+    }
+    std::unique_ptr<RamStatement> res;
+    if (!loopSeq->getStatements().empty()) {
+        res = std::make_unique<RamLoop>(
+                std::move(loopSeq), std::make_unique<RamExit>(std::move(exitCond)), std::move(updateTable));
+    }
+    appendStmt(res, std::move(postamble));
+    return res;
+}
+
+/** generate RAM code over-deleting the tuples of a strongly-connected component incrementally */
+std::unique_ptr<RamStatement> AstTranslator::translateOverDeletion(
+        const std::set<const AstRelation*>& scc, bool isRecursive, const RecursiveClauses* recursiveClauses) {
+    std::unique_ptr<RamStatement> res;
+
+    // a version of a clause reading the atom at the given position from the given relation, writing the
+    // tuples of the relation of its head not deleted yet to its new relation
+    auto translateVersion = [&](const AstClause& cl, const AstRelation* rel, size_t j,
+                                    const std::string& atomName) {
+        std::unique_ptr<AstClause> r1(cl.clone());
+        r1->getHead()->setName(translateNewRelation(rel)->get()->getName());
+        r1->getAtoms()[j]->setName(atomName);
+        r1->addToBody(std::unique_ptr<AstAtom>(cl.getHead()->clone()));
+        if (r1->getHead()->getArity() > 0) {
+            std::unique_ptr<AstAtom> deleted(cl.getHead()->clone());
+            deleted->setName(translateDeletedRelation(rel)->get()->getName());
+            r1->addToBody(std::make_unique<AstNegation>(std::move(deleted)));
+        }
+        return translateIncrementalClause(*r1, cl);
+    };
+
+    // the tuples derived from those deleted from the relations of the preceding components
+    for (const AstRelation* rel : scc) {
+        for (const AstClause* cl : rel->getClauses()) {
+            const auto& atoms = cl->getAtoms();
+            for (size_t j = 0; j < atoms.size(); ++j) {
+                const AstRelation* atomRelation = getAtomRelation(atoms[j], program);
+                if (atomRelation != nullptr && scc.count(atomRelation) == 0) {
+                    appendStmt(res, translateVersion(*cl, rel, j,
+                                            translateDeletedRelation(atomRelation)->get()->getName()));
+                }
+            }
+        }
+    }
+    if (!res && !isRecursive) {
+        return nullptr;
+    }
+
+    // together with the tuples deleted from the relations themselves, they seed the fixpoint
+    for (const AstRelation* rel : scc) {
+        appendStmt(res, std::make_unique<RamMerge>(translateDeletedRelation(rel), translateNewRelation(rel)));
+        appendStmt(res, std::make_unique<RamClear>(translateNewRelation(rel)));
+        if (isRecursive) {
+            appendStmt(res,
+                    std::make_unique<RamMerge>(translateDeltaRelation(rel), translateDeletedRelation(rel)));
+        }
+    }
+    if (isRecursive) {
+        appendStmt(res, translateIncrementalLoop(scc, recursiveClauses, translateVersion,
+                                [&](const AstRelation* rel) {
+                                    std::vector<std::unique_ptr<RamRelationReference>> targets;
+                                    targets.push_back(translateDeletedRelation(rel));
+                                    return targets;
+                                }));
+    }
+    return res;
+}
+
+/** generate RAM code updating the relations of a strongly-connected component incrementally */
+std::unique_ptr<RamStatement> AstTranslator::translateIncrementalRelation(
+        const std::set<const AstRelation*>& scc, bool isRecursive, bool recompute,
+        const RecursiveClauses* recursiveClauses) {
+    std::unique_ptr<RamStatement> res;
+
+    // negations and aggregates may invalidate tuples computed before, hence the relations are recomputed,
+    // all their tuples being considered deleted and added for the components depending on them
+    if (recompute) {
+        for (const AstRelation* rel : scc) {
+            appendStmt(
+                    res, std::make_unique<RamMerge>(translateDeletedRelation(rel), translateRelation(rel)));
+            appendStmt(res, std::make_unique<RamClear>(translateRelation(rel)));
+        }
+        appendStmt(res, isRecursive ? translateRecursiveRelation(scc, recursiveClauses)
+                                    : translateNonRecursiveRelation(**scc.begin(), recursiveClauses));
+        for (const AstRelation* rel : scc) {
+            appendStmt(res, std::make_unique<RamMerge>(translateAddedRelation(rel), translateRelation(rel)));
+        }
+        return res;
+    }
+
+    // the tuples over-deleted are removed by copying the others, once there are any
+    for (const AstRelation* rel : scc) {
+        auto removal = std::make_unique<AstClause>();
+        std::unique_ptr<AstAtom> head =
+                std::make_unique<AstAtom>(translateNewRelation(rel)->get()->getName());
+        std::unique_ptr<AstAtom> kept = std::make_unique<AstAtom>(rel->getName());
+        std::unique_ptr<AstAtom> deleted =
+                std::make_unique<AstAtom>(translateDeletedRelation(rel)->get()->getName());
+        for (size_t i = 0; i < rel->getArity(); ++i) {
+            const std::string var = "x" + std::to_string(i);
+            head->addArgument(std::make_unique<AstVariable>(var));
+            kept->addArgument(std::make_unique<AstVariable>(var));
+            deleted->addArgument(std::make_unique<AstVariable>(var));
+        }
+        removal->setHead(std::move(head));
+        removal->addToBody(std::move(kept));
+        removal->addToBody(std::make_unique<AstNegation>(std::move(deleted)));
+
+        std::unique_ptr<RamStatement> copy =
+                std::make_unique<RamExit>(std::make_unique<RamEmptinessCheck>(translateDeletedRelation(rel)));
+        appendStmt(copy, ClauseTranslator(*this).translateClause(*removal, *removal));
+        appendStmt(copy, std::make_unique<RamClear>(translateRelation(rel)));
+        appendStmt(copy, std::make_unique<RamMerge>(translateRelation(rel), translateNewRelation(rel)));
+        appendStmt(copy, std::make_unique<RamClear>(translateNewRelation(rel)));
+        appendStmt(copy, std::make_unique<RamExit>(std::make_unique<RamTrue>()));
+        appendStmt(res, std::make_unique<RamLoop>(std::move(copy)));
+    }
+
+    // a version of a clause reading the atom at the given position from the given relation, writing
+    // the tuples not known yet to the new relation of its head
+    auto translateVersion = [&](const AstClause& cl, const AstRelation* rel, size_t j,
+                                    const std::string& atomName) {
+        std::unique_ptr<AstClause> r1(cl.clone());
+        r1->getHead()->setName(translateNewRelation(rel)->get()->getName());
+        r1->getAtoms()[j]->setName(atomName);
+        if (r1->getHead()->getArity() > 0) {
+            r1->addToBody(std::make_unique<AstNegation>(std::unique_ptr<AstAtom>(cl.getHead()->clone())));
+        }
+        return translateIncrementalClause(*r1, cl);
+    };
+
+    for (const AstRelation* rel : scc) {
+        for (const AstClause* cl : rel->getClauses()) {
+            // the tuples over-deleted still derivable from the remaining ones are rederived
+            auto rederivation = std::make_unique<AstClause>();
+            rederivation->setHead(std::unique_ptr<AstAtom>(cl->getHead()->clone()));
+            rederivation->getHead()->setName(translateNewRelation(rel)->get()->getName());
+            std::unique_ptr<AstAtom> deleted(cl->getHead()->clone());
+            deleted->setName(translateDeletedRelation(rel)->get()->getName());
+            rederivation->addToBody(std::move(deleted));
+            for (const AstLiteral* literal : cl->getBodyLiterals()) {
+                rederivation->addToBody(std::unique_ptr<AstLiteral>(literal->clone()));
+            }
+            if (cl->getHead()->getArity() > 0) {
+                rederivation->addToBody(
+                        std::make_unique<AstNegation>(std::unique_ptr<AstAtom>(cl->getHead()->clone())));
+            }
+            appendStmt(res, translateIncrementalClause(*rederivation, *cl));
+
+            // the tuples derived from those added to the relations of the preceding components
+            const auto& atoms = cl->getAtoms();
+            for (size_t j = 0; j < atoms.size(); ++j) {
+                const AstRelation* atomRelation = getAtomRelation(atoms[j], program);
+                if (atomRelation != nullptr && scc.count(atomRelation) == 0) {
+                    appendStmt(res, translateVersion(*cl, rel, j,
+                                            translateAddedRelation(atomRelation)->get()->getName()));
+                }
+            }
+        }
+    }
+
+    // together with the tuples inserted into the relations themselves, they seed the fixpoint
+    for (const AstRelation* rel : scc) {
+        appendStmt(res, std::make_unique<RamMerge>(translateRelation(rel), translateNewRelation(rel)));
+        appendStmt(res, std::make_unique<RamMerge>(translateAddedRelation(rel), translateNewRelation(rel)));
+        appendStmt(res, std::make_unique<RamClear>(translateNewRelation(rel)));
+        if (isRecursive) {
+            appendStmt(res,
+                    std::make_unique<RamMerge>(translateDeltaRelation(rel), translateAddedRelation(rel)));
+        }
+    }
+
+    // continue the semi-naive evaluation from the relations computed before
+    if (isRecursive) {
+        appendStmt(res, translateIncrementalLoop(scc, recursiveClauses, translateVersion,
+                                [&](const AstRelation* rel) {
+                                    std::vector<std::unique_ptr<RamRelationReference>> targets;
+                                    targets.push_back(translateRelation(rel));
+                                    targets.push_back(translateAddedRelation(rel));
+                                    return targets;
+                                }));
+    }
+    return res;
+}
+
 /** make a subroutine to search for subproofs */
 std::unique_ptr<RamStatement> AstTranslator::makeSubproofSubroutine(const AstClause& clause) {
     // make intermediate clause with constraints
@@ -1201,9 +2096,13 @@ std::unique_ptr<RamStatement> AstTranslator::makeSubproofSubroutine(const AstCla
     // name unnamed variables
     nameUnnamedVariables(intermediateClause.get());
 
-    // add constraint for each argument in head of atom
+    // without provenance columns, the subroutine returns every derivation of the tuple by the clause
     AstAtom* head = intermediateClause->getHead();
-    for (size_t i = 0; i < head->getArguments().size() - 2; i++) {
+    const bool lazy = !hasProvenanceColumns(head);
+    const size_t columns = lazy ? 0 : 2;
+
+    // add constraint for each argument in head of atom
+    for (size_t i = 0; i < head->getArguments().size() - columns; i++) {
         auto arg = head->getArgument(i);
 
         if (auto var = dynamic_cast<AstVariable*>(arg)) {
@@ -1215,7 +2114,21 @@ std::unique_ptr<RamStatement> AstTranslator::makeSubproofSubroutine(const AstCla
         } else if (auto rec = dynamic_cast<AstRecordInit*>(arg)) {
             intermediateClause->addToBody(std::make_unique<AstBinaryConstraint>(BinaryConstraintOp::EQ,
                     std::unique_ptr<AstArgument>(rec->clone()), std::make_unique<AstSubroutineArgument>(i)));
+        } else if (auto cst = dynamic_cast<AstConstant*>(arg)) {
+            // the clause of a lazily explained tuple is not known, so its constants are checked as well
+            intermediateClause->addToBody(std::make_unique<AstBinaryConstraint>(BinaryConstraintOp::EQ,
+                    std::unique_ptr<AstArgument>(cst->clone()), std::make_unique<AstSubroutineArgument>(i)));
+        }
+    }
+
+    if (lazy) {
+        // a nullary fact is still a fact, whereas the subroutine has to return its single derivation
+        if (intermediateClause->getBodyLiterals().empty()) {
+            intermediateClause->addToBody(std::make_unique<AstBinaryConstraint>(BinaryConstraintOp::EQ,
+                    std::make_unique<AstNumberConstant>(0), std::make_unique<AstNumberConstant>(0)));
         }
+        return ProvenanceClauseTranslator(*this, clause.getBodyLiterals().size())
+                .translateClause(*intermediateClause, clause);
     }
 
     // index of level argument in argument list
@@ -1330,14 +2243,16 @@ std::unique_ptr<RamStatement> AstTranslator::makeNegationSubproofSubroutine(cons
             atom->apply(varsToArgs);
 
             // add each value (subroutine argument) to the search query
-            for (size_t i = 0; i < atom->getArity() - 2; i++) {
+            const size_t columns = hasProvenanceColumns(atom) ? 2 : 0;
+            for (size_t i = 0; i < atom->getArity() - columns; i++) {
                 auto arg = atom->getArgument(i);
                 query.push_back(translateValue(arg, ValueIndex()));
             }
 
             // fill up query with nullptrs for the provenance columns
-            query.push_back(std::make_unique<RamUndefValue>());
-            query.push_back(std::make_unique<RamUndefValue>());
+            for (size_t i = 0; i < columns; i++) {
+                query.push_back(std::make_unique<RamUndefValue>());
+            }
 
             // ensure the length of query tuple is correct
             assert(query.size() == atom->getArity() && "wrong query tuple size");
@@ -1358,7 +2273,7 @@ std::unique_ptr<RamStatement> AstTranslator::makeNegationSubproofSubroutine(cons
             std::vector<std::unique_ptr<RamExpression>> returnAtom;
             returnAtom.push_back(std::make_unique<RamUndefValue>());
             // the actual atom
-            for (size_t i = 0; i < atom->getArity() - 2; i++) {
+            for (size_t i = 0; i < atom->getArity() - columns; i++) {
                 returnAtom.push_back(translateValue(atom->getArgument(i), ValueIndex()));
             }
 
@@ -1395,7 +2310,8 @@ std::unique_ptr<RamStatement> AstTranslator::makeNegationSubproofSubroutine(cons
                 returnLit.push_back(translateValue(binaryConstraint->getRHS(), ValueIndex()));
             } else if (auto negation = dynamic_cast<AstNegation*>(con)) {
                 auto vals = negation->getAtom()->getArguments();
-                for (size_t i = 0; i < vals.size() - 2; i++) {
+                const size_t columns = hasProvenanceColumns(negation->getAtom()) ? 2 : 0;
+                for (size_t i = 0; i < vals.size() - columns; i++) {
                     returnLit.push_back(translateValue(vals[i], ValueIndex()));
                 }
             }
@@ -1421,6 +2337,9 @@ void AstTranslator::translateProgram(const AstTranslationUnit& translationUnit)
     // obtain type environment from analysis
     typeEnv = &translationUnit.getAnalysis<TypeEnvironmentAnalysis>()->getTypeEnvironment();
 
+    // obtain the limits of outputs that may stop growing early
+    computeOutputLimits();
+
     // obtain recursive clauses from analysis
     const auto* recursiveClauses = translationUnit.getAnalysis<RecursiveClauses>();
 
@@ -1477,10 +2396,17 @@ void AstTranslator::translateProgram(const AstTranslationUnit& translationUnit)
         appendStmt(current, std::make_unique<RamDrop>(translateRelation(relation)));
     };
 
-#ifdef USE_MPI
-    const auto& makeRamSend = [&](std::unique_ptr<RamStatement>& current, const AstRelation* relation,
-                                      const std::set<size_t> destinationStrata) {
-        appendStmt(current, std::make_unique<RamSend>(translateRelation(relation), destinationStrata));
+    const auto& makeRamLogDistinctValues = [&](std::unique_ptr<RamStatement>& current,
+                                                   const AstRelation* relation) {
+        std::vector<std::string> messages;
+        for (size_t i = 0; i < relation->getArity(); ++i) {
+            messages.push_back(LogStatement::nRelationColumn(
+                    toString(relation->getName()), i, relation->getSrcLoc()));
+        }
+        if (!messages.empty()) {
+            appendStmt(current,
+                    std::make_unique<RamLogDistinctValues>(translateRelation(relation), std::move(messages)));
+        }
     };
 
     const auto& makeRamRecv = [&](std::unique_ptr<RamStatement>& current, const AstRelation* relation,
@@ -1488,6 +2414,12 @@ void AstTranslator::translateProgram(const AstTranslationUnit& translationUnit)
         appendStmt(current, std::make_unique<RamRecv>(translateRelation(relation), sourceStrata));
     };
 
+#ifdef USE_MPI
+    const auto& makeRamSend = [&](std::unique_ptr<RamStatement>& current, const AstRelation* relation,
+                                      const std::set<size_t> destinationStrata) {
+        appendStmt(current, std::make_unique<RamSend>(translateRelation(relation), destinationStrata));
+    };
+
     const auto& makeRamNotify = [&](std::unique_ptr<RamStatement>& current) {
         appendStmt(current, std::make_unique<RamNotify>());
     };
@@ -1500,6 +2432,10 @@ void AstTranslator::translateProgram(const AstTranslationUnit& translationUnit)
     // maintain the index of the SCC within the topological order
     size_t indexOfScc = 0;
 
+    // the relations of components recomputed by incremental updates, as they may lose tuples
+    const bool incremental = Global::config().has("incremental");
+    std::set<const AstRelation*> recomputed;
+
     // iterate over each SCC according to the topological order
     for (const auto& scc : sccOrder.order()) {
         // make a new ram statement for the current SCC
@@ -1516,30 +2452,40 @@ void AstTranslator::translateProgram(const AstTranslationUnit& translationUnit)
         const auto& externOutPreds = sccGraph.getExternalOutputPredecessorRelations(scc);
         const auto& externNonOutPreds = sccGraph.getExternalNonOutputPredecessorRelations(scc);
 
-        // const auto& externPreds = sccGraph.getExternalPredecessorRelations(scc);
-        // const auto& internsWithExternSuccs = sccGraph.getInternalRelationsWithExternalSuccessors(scc);
+        const auto& externPreds = sccGraph.getExternalPredecessorRelations(scc);
+        const auto& internsWithExternSuccs = sccGraph.getInternalRelationsWithExternalSuccessors(scc);
         const auto& internNonOutsWithExternSuccs =
                 sccGraph.getInternalNonOutputRelationsWithExternalSuccessors(scc);
 
         // make a variable for all relations that are expired at the current SCC
         const auto& internExps = expirySchedule.at(indexOfScc).expired();
 
+        // a component computing the transitive closure of a relation it does not load needs no fixpoint
+        const AstRelation* closureSource =
+                (isRecursive && internIns.empty()) ? getClosureSource(allInterns) : nullptr;
+
         // create all internal relations of the current scc
         for (const auto& relation : allInterns) {
             appendStmt(current, std::make_unique<RamCreate>(
                                         std::unique_ptr<RamRelationReference>(translateRelation(relation))));
             // create new and delta relations if required
-            if (isRecursive) {
+            if ((isRecursive && closureSource == nullptr) || incremental) {
                 appendStmt(current, std::make_unique<RamCreate>(std::unique_ptr<RamRelationReference>(
                                             translateDeltaRelation(relation))));
                 appendStmt(current, std::make_unique<RamCreate>(std::unique_ptr<RamRelationReference>(
                                             translateNewRelation(relation))));
             }
+            // the delta relation of a non-recursive subsumptive relation holds the tuples not dominated
+            if (!isRecursive && !incremental && relation->isSubsumptive()) {
+                appendStmt(current, std::make_unique<RamCreate>(translateDeltaRelation(relation)));
+            }
+            if (incremental) {
+                appendStmt(current, std::make_unique<RamCreate>(translateAddedRelation(relation)));
+                appendStmt(current, std::make_unique<RamCreate>(translateDeletedRelation(relation)));
+            }
         }
 
 #ifdef USE_MPI
-        const auto& externPreds = sccGraph.getExternalPredecessorRelations(scc);
-        const auto& internsWithExternSuccs = sccGraph.getInternalRelationsWithExternalSuccessors(scc);
         // note that the order of receives is first by relation then second destination
         if (Global::config().get("engine") == "mpi") {
             // first, recv all internal input relations from the master process
@@ -1552,7 +2498,16 @@ void AstTranslator::translateProgram(const AstTranslationUnit& translationUnit)
             }
         } else
 #endif
-        {
+                if (Global::config().get("engine") == "shm") {
+            // load all internal input relations from the facts dir with a .facts extension
+            for (const auto& relation : internIns) {
+                makeRamLoad(current, relation, "fact-dir", ".facts");
+            }
+            // predecessor relations are shared in memory, only await their source strata
+            for (const auto& relation : externPreds) {
+                makeRamRecv(current, relation, sccOrder.indexOfScc(sccGraph.getSCC(relation)));
+            }
+        } else {
             // load all internal input relations from the facts dir with a .facts extension
             for (const auto& relation : internIns) {
                 makeRamLoad(current, relation, "fact-dir", ".facts");
@@ -1573,11 +2528,30 @@ void AstTranslator::translateProgram(const AstTranslationUnit& translationUnit)
             }
         }
         // compute the relations themselves
-        std::unique_ptr<RamStatement> bodyStatement =
-                (!isRecursive) ? translateNonRecursiveRelation(
-                                         *((const AstRelation*)*allInterns.begin()), recursiveClauses)
-                               : translateRecursiveRelation(allInterns, recursiveClauses);
+        std::unique_ptr<RamStatement> bodyStatement;
+        if (closureSource != nullptr) {
+            bodyStatement = translateTransitiveClosure(**allInterns.begin(), *closureSource);
+        } else {
+            bodyStatement = (!isRecursive) ? translateNonRecursiveRelation(
+                                                     *((const AstRelation*)*allInterns.begin()),
+                                                     recursiveClauses)
+                                           : translateRecursiveRelation(allInterns, recursiveClauses);
+        }
         appendStmt(current, std::move(bodyStatement));
+        if (!isRecursive && !incremental) {
+            for (const auto& relation : allInterns) {
+                if (relation->isSubsumptive()) {
+                    appendStmt(current, std::make_unique<RamDrop>(translateDeltaRelation(relation)));
+                }
+            }
+        }
+
+        // record the column statistics of the relations for profile-guided optimisations
+        if (Global::config().has("profile")) {
+            for (const auto& relation : allInterns) {
+                makeRamLogDistinctValues(current, relation);
+            }
+        }
 #ifdef USE_MPI
         // note that the order of sends is first by relation then second destination
         if (Global::config().get("engine") == "mpi") {
@@ -1594,7 +2568,12 @@ void AstTranslator::translateProgram(const AstTranslationUnit& translationUnit)
             }
         } else
 #endif
-        {
+                if (Global::config().get("engine") == "shm") {
+            // store all internal output relations, the others are passed on in memory
+            for (const auto& relation : internOuts) {
+                makeRamStore(current, relation, "output-dir", ".csv");
+            }
+        } else {
             // if a communication engine is enabled...
             if (Global::config().has("engine")) {
                 // store all internal non-output relations with external successors to the output dir with
@@ -1610,10 +2589,18 @@ void AstTranslator::translateProgram(const AstTranslationUnit& translationUnit)
             }
         }
 
-        // if provenance is not enabled...
-        if (!Global::config().has("provenance")) {
-            // if a communication engine is enabled...
-            if (Global::config().has("engine")) {
+        // if provenance is not enabled, and the strata do not save their relations into a cache after
+        // their evaluation nor keep them for the next evaluation of a watched program...
+        if (!Global::config().has("provenance") && !Global::config().has("stratum-cache") &&
+                !Global::config().has("watch")) {
+            if (Global::config().get("engine") == "shm") {
+                // drop the internal relations no other stratum reads, as strata may run concurrently
+                for (const auto& relation : allInterns) {
+                    if (internsWithExternSuccs.count(relation) == 0) {
+                        makeRamDrop(current, relation);
+                    }
+                }
+            } else if (Global::config().has("engine")) {
                 // drop all internal relations
                 for (const auto& relation : allInterns) {
                     makeRamDrop(current, relation);
@@ -1634,6 +2621,30 @@ void AstTranslator::translateProgram(const AstTranslationUnit& translationUnit)
             }
         }
 
+        // the incremental update of the stratum, a component negating or aggregating relations that may
+        // change or reading relations recomputed being recomputed itself
+        if (incremental) {
+            bool recompute = false;
+            for (const AstRelation* relation : allInterns) {
+                visitDepthFirst(relation->getClauses(), [&](const AstNegation& negation) {
+                    const AstRelation* negated = getAtomRelation(negation.getAtom(), program);
+                    recompute = recompute || allInterns.count(negated) == 0;
+                });
+                visitDepthFirst(relation->getClauses(), [&](const AstAggregator&) { recompute = true; });
+                visitDepthFirst(relation->getClauses(), [&](const AstAtom& atom) {
+                    recompute = recompute || recomputed.count(getAtomRelation(&atom, program)) > 0;
+                });
+            }
+            if (recompute) {
+                recomputed.insert(allInterns.begin(), allInterns.end());
+            } else if (auto deletion = translateOverDeletion(allInterns, isRecursive, recursiveClauses)) {
+                ramProg->addSubroutine(
+                        "incremental_delete_" + std::to_string(indexOfScc), std::move(deletion));
+            }
+            ramProg->addSubroutine("incremental_" + std::to_string(indexOfScc),
+                    translateIncrementalRelation(allInterns, isRecursive, recompute, recursiveClauses));
+        }
+
         if (current) {
             // append the current SCC as a stratum to the sequence
             appendStmt(res, std::make_unique<RamStratum>(std::move(current), indexOfScc));
@@ -1669,8 +2680,14 @@ void AstTranslator::translateProgram(const AstTranslationUnit& translationUnit)
             ++indexOfScc;
         }
 
-        // wait for notifications from all slaves
-        makeRamWait(current, sccGraph.getNumberOfSCCs());
+        // wait for notifications from all slaves, including the additional ranks of partitioned strata
+        size_t numberOfSlaves = sccGraph.getNumberOfSCCs();
+        for (const auto scc : sccOrder.order()) {
+            if (sccGraph.isRecursive(scc) && isPartitioned(sccGraph.getInternalRelations(scc))) {
+                numberOfSlaves += std::stoi(Global::config().get("mpi-partitions")) - 1;
+            }
+        }
+        makeRamWait(current, numberOfSlaves);
 
         // recv all internal output relations from their slave processes
         indexOfScc = 0;
@@ -1711,8 +2728,16 @@ void AstTranslator::translateProgram(const AstTranslationUnit& translationUnit)
             std::stringstream relName;
             relName << clause.getHead()->getName();
 
-            // do not add subroutines for info relations or facts
-            if (relName.str().find("@info") != std::string::npos || clause.getBodyLiterals().empty()) {
+            // do not add subroutines for info relations, relations without provenance, or facts, except
+            // for lazy provenance, which numbers all clauses and searches the proofs of facts as well
+            if (relName.str().find("@info") != std::string::npos) {
+                return;
+            }
+            if (Global::config().has("provenance-lazy")) {
+                if (clause.getClauseNum() == 0) {
+                    return;
+                }
+            } else if (clause.getBodyLiterals().empty() || !hasProvenanceColumns(clause.getHead())) {
                 return;
             }
 
@@ -1734,15 +2759,15 @@ std::unique_ptr<RamTranslationUnit> AstTranslator::translateUnit(AstTranslationU
     SymbolTable& symTab = tu.getSymbolTable();
     ErrorReport& errReport = tu.getErrorReport();
     DebugReport& debugReport = tu.getDebugReport();
-    if (!Global::config().get("debug-report").empty()) {
+    if (!Global::config().get("debug-report").empty() && DebugReport::isSelected("ram")) {
         if (ramProg) {
             auto ram_end = std::chrono::high_resolution_clock::now();
             std::string runtimeStr =
                     "(" + std::to_string(std::chrono::duration<double>(ram_end - ram_start).count()) + "s)";
             std::stringstream ramProgStr;
             ramProgStr << *ramProg;
-            debugReport.addSection(DebugReporter::getCodeSection(
-                    "ram-program", "RAM Program " + runtimeStr, ramProgStr.str()));
+            debugReport.addSection(debugReport.getCodeVersionSection(
+                    "ram", "ram-program", "RAM Program " + runtimeStr, ramProgStr.str()));
         }
     }
     return std::make_unique<RamTranslationUnit>(std::move(ramProg), symTab, errReport, debugReport);
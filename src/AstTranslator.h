@@ -22,12 +22,14 @@
 #include "RelationRepresentation.h"
 #include "Util.h"
 #include <cassert>
+#include <functional>
 #include <map>
 #include <memory>
 #include <ostream>
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace souffle {
 
@@ -69,6 +71,9 @@ private:
     /** RAM program */
     std::unique_ptr<RamProgram> ramProg;
 
+    /** The numbers of tuples the relations whose outputs are all limited are evaluated up to */
+    std::map<AstRelationIdentifier, size_t> outputLimits;
+
     /**
      * Concrete attribute
      */
@@ -294,7 +299,8 @@ private:
     /** create a reference to a RAM relation */
     std::unique_ptr<RamRelationReference> createRelationReference(const std::string name, const size_t arity,
             const std::vector<std::string> attributeNames,
-            const std::vector<std::string> attributeTypeQualifiers, const RelationRepresentation structure);
+            const std::vector<std::string> attributeTypeQualifiers, const RelationRepresentation structure,
+            const std::string& storage = "");
 
     /** create a reference to a RAM relation */
     std::unique_ptr<RamRelationReference> createRelationReference(const std::string name, const size_t arity);
@@ -306,12 +312,21 @@ private:
     std::unique_ptr<RamRelationReference> translateRelation(
             const AstRelation* rel, const std::string relationNamePrefix = "");
 
+    /** check whether the relation of an atom carries the columns of provenance */
+    bool hasProvenanceColumns(const AstAtom* atom);
+
     /** translate a temporary `delta` relation to a RAM relation for semi-naive evaluation */
     std::unique_ptr<RamRelationReference> translateDeltaRelation(const AstRelation* rel);
 
     /** translate a temporary `new` relation to a RAM relation for semi-naive evaluation */
     std::unique_ptr<RamRelationReference> translateNewRelation(const AstRelation* rel);
 
+    /** translate a temporary `added` relation, holding the tuples added since the last evaluation */
+    std::unique_ptr<RamRelationReference> translateAddedRelation(const AstRelation* rel);
+
+    /** translate a temporary `deleted` relation, holding the tuples deleted since the last evaluation */
+    std::unique_ptr<RamRelationReference> translateDeletedRelation(const AstRelation* rel);
+
     /** translate an AST argument to a RAM value */
     std::unique_ptr<RamExpression> translateValue(const AstArgument* arg, const ValueIndex& index);
 
@@ -356,6 +371,13 @@ private:
 
         std::unique_ptr<RamStatement> translateClause(
                 const AstClause& clause, const AstClause& originalClause, const int version = 0);
+
+        /**
+         * translate a rule to a multi-way join binding one variable per nesting level to the
+         * values common to all atoms containing it, the variables of delta atoms coming first.
+         */
+        std::unique_ptr<RamStatement> translateGenericJoin(
+                const AstClause& clause, const AstClause& originalClause);
     };
 
     class ProvenanceClauseTranslator : public ClauseTranslator {
@@ -363,10 +385,32 @@ private:
         std::unique_ptr<RamOperation> createOperation(const AstClause& clause) override;
         std::unique_ptr<RamCondition> createCondition(const AstClause& originalClause) override;
 
+        /**
+         * the number of leading body literals whose values are returned for each derivation, followed by a
+         * separator, for the search of lazy provenance; -1 for the values of all literals
+         */
+        int literals;
+
     public:
-        ProvenanceClauseTranslator(AstTranslator& translator) : ClauseTranslator(translator) {}
+        ProvenanceClauseTranslator(AstTranslator& translator, int literals = -1)
+                : ClauseTranslator(translator), literals(literals) {}
     };
 
+    /**
+     * determine whether a rule is translated to a multi-way join rather than to nested scans of its
+     * atoms, as selected by the generic-join option for rules with plain atoms over b-trees.
+     */
+    bool useGenericJoin(const AstClause& clause) const;
+
+    /**
+     * determine the number of tuples after which the rules deriving the given atom may stop, as the
+     * relation is not read by any rule and all its outputs are limited to fewer; 0 if unlimited.
+     */
+    size_t getOutputLimit(const AstAtom* head) const;
+
+    /** collect the limits of the outputs of relations that no rule reads */
+    void computeOutputLimits();
+
     /**
      * translate RAM code for the non-recursive clauses of the given relation.
      *
@@ -375,10 +419,95 @@ private:
     std::unique_ptr<RamStatement> translateNonRecursiveRelation(
             const AstRelation& rel, const RecursiveClauses* recursiveClauses);
 
+    /**
+     * translate a version of a recursive clause, reading the atom at the given position from a delta
+     * relation, to a switch between alternative join orders for the interpreter to choose from.
+     */
+    std::unique_ptr<RamStatement> translateAdaptiveClause(const AstClause& clause,
+            const AstClause& originalClause, const int version, const unsigned int deltaAtom);
+
+    /**
+     * translate RAM code for a clause copying the tuples of a subsumptive relation from the source to
+     * the target relation, keeping those that exactly the given number of tuples of each relation
+     * named as dominating dominate or equal.
+     */
+    std::unique_ptr<RamStatement> translateDominanceFilter(const AstRelation& rel,
+            const AstRelationIdentifier& source, const AstRelationIdentifier& target,
+            const std::vector<std::pair<AstRelationIdentifier, AstDomain>>& dominating);
+
+    /** translate RAM code dropping the tuples of a subsumptive relation that others dominate */
+    std::unique_ptr<RamStatement> translateSubsumption(const AstRelation& rel);
+
+    /**
+     * translate RAM code for the update of a subsumptive relation in a fixpoint loop, turning only the
+     * new tuples no other tuple dominates into its delta.
+     */
+    std::unique_ptr<RamStatement> translateSubsumptiveUpdate(const AstRelation& rel);
+
+#ifdef USE_MPI
+    /**
+     * determine whether a recursive strongly-connected component is evaluated by several ranks of the
+     * mpi engine, each over a hash-partition of the delta relations, as selected by the mpi-partitions
+     * option for components without equivalence relations.
+     */
+    bool isPartitioned(const std::set<const AstRelation*>& scc) const;
+#endif
+
     /** translate RAM code for recursive relations in a strongly-connected component */
     std::unique_ptr<RamStatement> translateRecursiveRelation(
             const std::set<const AstRelation*>& scc, const RecursiveClauses* recursiveClauses);
 
+    /**
+     * determine the relation whose transitive closure a recursive strongly-connected component computes,
+     * as selected by the transitive-closure option for a single binary relation with one rule copying
+     * the other relation and rules joining either of them with the relation itself; null otherwise.
+     */
+    const AstRelation* getClosureSource(const std::set<const AstRelation*>& scc) const;
+
+    /** translate RAM code computing a relation as the transitive closure of another */
+    std::unique_ptr<RamStatement> translateTransitiveClosure(
+            const AstRelation& rel, const AstRelation& source);
+
+    /** a version of a clause of a relation reading the atom at a position from the relation named */
+    using IncrementalVersion = std::function<std::unique_ptr<RamStatement>(
+            const AstClause&, const AstRelation*, size_t, const std::string&)>;
+
+    /** the relations that the new tuples of a relation are merged into */
+    using IncrementalTargets =
+            std::function<std::vector<std::unique_ptr<RamRelationReference>>(const AstRelation*)>;
+
+    /** translate RAM code for a version of a clause maintaining relations incrementally */
+    std::unique_ptr<RamStatement> translateIncrementalClause(AstClause& version, const AstClause& clause);
+
+    /**
+     * translate RAM code for the semi-naive loop of an incremental update of a recursive component,
+     * evaluating the versions of its recursive clauses reading an atom of the component from its delta
+     * relation, and merging the new tuples of each relation into the target relations given.
+     */
+    std::unique_ptr<RamStatement> translateIncrementalLoop(const std::set<const AstRelation*>& scc,
+            const RecursiveClauses* recursiveClauses, const IncrementalVersion& translateVersion,
+            const IncrementalTargets& targets);
+
+    /**
+     * translate RAM code collecting the tuples of the relations of a strongly-connected component
+     * derivable from the tuples deleted from them and from the relations they depend on since the last
+     * evaluation, the over-deletion of delete-and-rederive (--incremental).
+     *
+     * @return a corresponding statement or null if no tuples of the component derive others.
+     */
+    std::unique_ptr<RamStatement> translateOverDeletion(const std::set<const AstRelation*>& scc,
+            bool isRecursive, const RecursiveClauses* recursiveClauses);
+
+    /**
+     * translate RAM code updating the relations of a strongly-connected component once the preceding
+     * components are updated (--incremental): removing the tuples over-deleted, rederiving those still
+     * derivable, and adding the tuples derived from the ones added to the component and the relations
+     * it depends on since the last evaluation. With recompute set, as the component negates or
+     * aggregates relations that may change, its relations are computed from scratch instead.
+     */
+    std::unique_ptr<RamStatement> translateIncrementalRelation(const std::set<const AstRelation*>& scc,
+            bool isRecursive, bool recompute, const RecursiveClauses* recursiveClauses);
+
     /** translate RAM code for subroutine to get subproofs */
     std::unique_ptr<RamStatement> makeSubproofSubroutine(const AstClause& clause);
 
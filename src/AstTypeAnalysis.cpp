@@ -40,6 +40,7 @@
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace souffle {
 
@@ -134,6 +135,10 @@ TypeConstraint isSubtypeOf(const TypeVar& a, const Type& b) {
             return true;
         }
 
+        std::vector<TypeVar> getVariables() const override {
+            return {a};
+        }
+
         void print(std::ostream& out) const override {
             out << a << " <: " << b.getName();
         }
@@ -183,6 +188,10 @@ TypeConstraint isSupertypeOf(const TypeVar& a, const Type& b) {
             return true;
         }
 
+        std::vector<TypeVar> getVariables() const override {
+            return {a};
+        }
+
         void print(std::ostream& out) const override {
             out << a << " >: " << b.getName();
         }
@@ -251,6 +260,10 @@ TypeConstraint isSubtypeOfComponent(const TypeVar& a, const TypeVar& b, int inde
             return changed;
         }
 
+        std::vector<TypeVar> getVariables() const override {
+            return {a, b};
+        }
+
         void print(std::ostream& out) const override {
             out << a << " <: " << b << "::" << index;
         }
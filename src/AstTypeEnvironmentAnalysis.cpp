@@ -106,6 +106,9 @@ void TypeEnvironmentAnalysis::updateTypeEnvironment(const AstProgram& program) {
             assert(false && "Unsupported Type Construct!");
         }
     }
+
+    // precompute the subtype lattice for the type analysis
+    env.finalise();
 }
 
 }  // end of namespace souffle
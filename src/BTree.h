@@ -20,15 +20,40 @@
 #include "ParallelUtils.h"
 #include "Util.h"
 
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace souffle {
 
+/**
+ * An allocator tag for b-trees requesting their nodes to be taken from a
+ * node pool owned by the tree. The pool obtains memory in slabs which are
+ * handed out through per-thread bump pointers, and releases all of them at
+ * once when the tree is cleared, or keeps them for the nodes inserted next
+ * when the tree is reset.
+ */
+struct btree_node_pool {};
+
 namespace detail {
 
 // ---------- comparators --------------
@@ -197,6 +222,274 @@ struct binary_search : public search_strategy {
     }
 };
 
+// ---------- vectorised search kernels --------------
+
+/**
+ * A trait exposing the column a comparator on tuple keys orders by first,
+ * or -1 if there is no such column. Comparators specialising this trait
+ * allow vectorised search strategies to locate keys by that column alone.
+ * The keys are required to be arrays of their component type, such that
+ * k[c] is stored at offset c within key k.
+ */
+template <typename Comp>
+struct leading_column {
+    enum { value = -1 };
+};
+
+/**
+ * A trait providing an order-preserving integer encoding of the leading
+ * columns of the keys compared by a comparator, or none if columns is 0.
+ * Comparators specialising this trait allow normalised search strategies to
+ * compare keys by a single integer comparison. The specialisations provide
+ *
+ *  - type: the signed or unsigned integer type of the normalised keys
+ *  - columns: the number of leading columns encoded
+ *  - complete: whether all compared columns are encoded, such that keys are
+ *              equivalent iff their normalised keys are equal
+ *  - get(k): the normalised key of key k
+ */
+template <typename Comp, typename Key>
+struct normalised_key {
+    enum { columns = 0, complete = false };
+};
+
+namespace simd_utils {
+
+/**
+ * Counts the elements of the given range that are less than the given value,
+ * with the elements being stride components apart.
+ */
+template <typename T>
+inline std::size_t count_less(const T* data, std::size_t n, T x, std::size_t stride = 1) {
+    std::size_t c = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        c += data[i * stride] < x;
+    }
+    return c;
+}
+
+inline std::size_t count_less(const int32_t* data, std::size_t n, int32_t x, std::size_t stride = 1) {
+    std::size_t i = 0;
+    std::size_t c = 0;
+#if defined(__AVX2__)
+    const __m256i key = _mm256_set1_epi32(x);
+    if (stride == 1) {
+        for (; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            c += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(key, v))));
+        }
+    } else {
+        const __m256i offsets = _mm256_mullo_epi32(
+                _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int>(stride)));
+        for (; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_i32gather_epi32(reinterpret_cast<const int*>(data + i * stride), offsets, 4);
+            c += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(key, v))));
+        }
+    }
+#elif defined(__SSE2__)
+    if (stride == 1) {
+        const __m128i key = _mm_set1_epi32(x);
+        for (; i + 4 <= n; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            c += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(key, v))));
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if (stride == 1) {
+        const int32x4_t key = vdupq_n_s32(x);
+        for (; i + 4 <= n; i += 4) {
+            uint32x4_t m = vcltq_s32(vld1q_s32(data + i), key);
+            c += vaddvq_u32(vshrq_n_u32(m, 31));
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        c += data[i * stride] < x;
+    }
+    return c;
+}
+
+inline std::size_t count_less(const int64_t* data, std::size_t n, int64_t x, std::size_t stride = 1) {
+    std::size_t i = 0;
+    std::size_t c = 0;
+#if defined(__AVX2__)
+    if (stride == 1) {
+        const __m256i key = _mm256_set1_epi64x(x);
+        for (; i + 4 <= n; i += 4) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            c += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(key, v))));
+        }
+    }
+#elif defined(__SSE4_2__)
+    if (stride == 1) {
+        const __m128i key = _mm_set1_epi64x(x);
+        for (; i + 2 <= n; i += 2) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            c += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(key, v))));
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if (stride == 1) {
+        const int64x2_t key = vdupq_n_s64(x);
+        for (; i + 2 <= n; i += 2) {
+            uint64x2_t m = vcltq_s64(vld1q_s64(data + i), key);
+            c += vaddvq_u64(vshrq_n_u64(m, 63));
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        c += data[i * stride] < x;
+    }
+    return c;
+}
+
+}  // end namespace simd_utils
+
+/**
+ * A vectorised search strategy for looking up keys in b-tree nodes.
+ *
+ * Integer keys ordered naturally are located by comparing the key against
+ * all keys of a node at once. Tuple keys whose comparator exposes a
+ * leading_column are first located by that column, skipping all keys of
+ * a smaller leading value; the remaining candidates are compared using the
+ * comparator. Any other keys are searched linearly.
+ */
+struct simd_search : public search_strategy {
+    /**
+     * Required user-defined default constructor.
+     */
+    simd_search() = default;
+
+    /**
+     * Obtains an iterator referencing an element equivalent to the
+     * given key in the given range. If no such element is present,
+     * a reference to the first element not less than the given key
+     * is returned.
+     */
+    template <typename Key, typename Iter, typename Comp>
+    inline Iter operator()(const Key& k, Iter a, Iter b, Comp& comp) const {
+        return lower_bound(k, a, b, comp);
+    }
+
+    /**
+     * Obtains a reference to the first element in the given range that
+     * is not less than the given key.
+     */
+    template <typename Key, typename Iter, typename Comp>
+    inline Iter lower_bound(const Key& k, Iter a, Iter b, Comp& comp) const {
+        return search<false>(k, a, b, comp, kind<Key, Comp>());
+    }
+
+    /**
+     * Obtains a reference to the first element in the given range that
+     * such that the given key is less than the referenced element.
+     */
+    template <typename Key, typename Iter, typename Comp>
+    inline Iter upper_bound(const Key& k, Iter a, Iter b, Comp& comp) const {
+        return search<true>(k, a, b, comp, kind<Key, Comp>());
+    }
+
+    /**
+     * The same as lower_bound, utilizing the given contiguous copy
+     * of the leading column of the elements in the given range.
+     */
+    template <typename Key, typename Iter, typename Head, typename Comp>
+    inline Iter lower_bound(const Key& k, Iter a, Iter b, const Head* heads, Comp& comp) const {
+        const Head x = k[leading_column<Comp>::value];
+        return scan<false>(k, a + simd_utils::count_less(heads, b - a, x), b, comp);
+    }
+
+    /**
+     * The same as upper_bound, utilizing the given contiguous copy
+     * of the leading column of the elements in the given range.
+     */
+    template <typename Key, typename Iter, typename Head, typename Comp>
+    inline Iter upper_bound(const Key& k, Iter a, Iter b, const Head* heads, Comp& comp) const {
+        const Head x = k[leading_column<Comp>::value];
+        return scan<true>(k, a + simd_utils::count_less(heads, b - a, x), b, comp);
+    }
+
+private:
+    using generic_keys = std::integral_constant<int, 0>;
+    using integer_keys = std::integral_constant<int, 1>;
+    using tuple_keys = std::integral_constant<int, 2>;
+
+    /** Classifies the given key type and comparator by the supported search method. */
+    template <typename Key, typename Comp>
+    using kind = std::integral_constant<int,
+            (std::is_integral<Key>::value && std::is_same<Comp, comparator<Key>>::value)
+                    ? integer_keys::value
+                    : (leading_column<Comp>::value >= 0) ? tuple_keys::value : generic_keys::value>;
+
+    /** Obtains the first element in the given range that is greater than (or not less than) the key. */
+    template <bool upper, typename Key, typename Iter, typename Comp>
+    static inline Iter scan(const Key& k, Iter c, Iter b, Comp& comp) {
+        while (c < b) {
+            if (comp(*c, k) >= (upper ? 1 : 0)) {
+                return c;
+            }
+            ++c;
+        }
+        return b;
+    }
+
+    template <bool upper, typename Key, typename Iter, typename Comp>
+    static inline Iter search(const Key& k, Iter a, Iter b, Comp& comp, generic_keys) {
+        return scan<upper>(k, a, b, comp);
+    }
+
+    template <bool upper, typename Key, typename Iter, typename Comp>
+    static inline Iter search(const Key& k, Iter a, Iter b, Comp&, integer_keys) {
+        if (upper) {
+            // the elements not greater than the key are the ones less than its successor
+            if (k == std::numeric_limits<Key>::max()) {
+                return b;
+            }
+            return a + simd_utils::count_less(&*a, b - a, Key(k + 1));
+        }
+        return a + simd_utils::count_less(&*a, b - a, k);
+    }
+
+    template <bool upper, typename Key, typename Iter, typename Comp>
+    static inline Iter search(const Key& k, Iter a, Iter b, Comp& comp, tuple_keys) {
+        if (a == b) {
+            return b;
+        }
+        enum { column = leading_column<Comp>::value };
+        using value_type = typename std::decay<decltype(k[column])>::type;
+        static_assert(sizeof(Key) % sizeof(value_type) == 0, "keys must be arrays of their components");
+        const std::size_t stride = sizeof(Key) / sizeof(value_type);
+        return scan<upper>(k, a + simd_utils::count_less(&(*a)[column], b - a, k[column], stride), b, comp);
+    }
+};
+
+/**
+ * A vectorised search strategy requesting b-tree nodes to store the leading
+ * column of their keys contiguously. Nodes of trees with tuple keys whose
+ * comparator exposes a leading_column keep a copy of this column next to
+ * their keys, which is searched in place of the keys themselves.
+ */
+struct simd_columnar_search : public simd_search {
+    /**
+     * Required user-defined default constructor.
+     */
+    simd_columnar_search() = default;
+};
+
+/**
+ * A vectorised search strategy requesting b-tree nodes to store the
+ * normalised keys of their keys. Nodes of trees whose comparator provides a
+ * normalised_key keep these next to their keys and locate keys by counting
+ * the smaller normalised keys, comparing several columns at once; only keys
+ * agreeing on all encoded columns are compared using the comparator.
+ */
+struct simd_normalised_search : public simd_search {
+    /**
+     * Required user-defined default constructor.
+     */
+    simd_normalised_search() = default;
+};
+
 // ---------- search strategies selection --------------
 
 /**
@@ -210,6 +503,8 @@ struct strategy_selection {
 
 struct linear : public strategy_selection<linear_search> {};
 struct binary : public strategy_selection<binary_search> {};
+struct simd : public strategy_selection<simd_search> {};
+struct simd_columnar : public strategy_selection<simd_columnar_search> {};
 
 // by default every key utilizes binary search
 template <typename Key>
@@ -221,6 +516,385 @@ struct default_strategy<int> : public linear {};
 template <typename... Ts>
 struct default_strategy<std::tuple<Ts...>> : public linear {};
 
+// ---------- node layout --------------
+
+/**
+ * A trait determining whether a search strategy requests nodes to store
+ * the leading column of their keys contiguously.
+ */
+template <typename S>
+struct columnar_layout : public std::false_type {};
+
+template <>
+struct columnar_layout<simd_columnar_search> : public std::true_type {};
+
+/**
+ * A trait determining whether a search strategy requests nodes to store
+ * the normalised keys of their keys.
+ */
+template <typename S>
+struct normalised_layout : public std::false_type {};
+
+template <>
+struct normalised_layout<simd_normalised_search> : public std::true_type {};
+
+/**
+ * A contiguous copy of the given column of the keys of a b-tree node,
+ * searched by columnar search strategies in place of the keys.
+ */
+template <typename Key, int Column, unsigned N>
+struct node_heads {
+    using value_type = typename std::decay<decltype(std::declval<const Key&>()[Column])>::type;
+
+    enum { bytes_per_key = sizeof(value_type) };
+
+    value_type heads[N];
+
+    void setHead(std::size_t i, const Key& k) {
+        heads[i] = k[Column];
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter searchFind(const S& search, const Key& k, Iter a, Iter b, Comp& comp) const {
+        return lowerBound(search, k, a, b, comp, covers<Comp>());
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter searchLowerBound(const S& search, const Key& k, Iter a, Iter b, Comp& comp) const {
+        return lowerBound(search, k, a, b, comp, covers<Comp>());
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter searchUpperBound(const S& search, const Key& k, Iter a, Iter b, Comp& comp) const {
+        return upperBound(search, k, a, b, comp, covers<Comp>());
+    }
+
+private:
+    // whether the heads may be utilized for searching with the given comparator
+    template <typename Comp>
+    using covers = std::integral_constant<bool, leading_column<Comp>::value == Column>;
+
+    template <typename S, typename Iter, typename Comp>
+    Iter lowerBound(const S& search, const Key& k, Iter a, Iter b, Comp& comp, std::true_type) const {
+        return search.lower_bound(k, a, b, heads, comp);
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter lowerBound(const S& search, const Key& k, Iter a, Iter b, Comp& comp, std::false_type) const {
+        return search.lower_bound(k, a, b, comp);
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter upperBound(const S& search, const Key& k, Iter a, Iter b, Comp& comp, std::true_type) const {
+        return search.upper_bound(k, a, b, heads, comp);
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter upperBound(const S& search, const Key& k, Iter a, Iter b, Comp& comp, std::false_type) const {
+        return search.upper_bound(k, a, b, comp);
+    }
+};
+
+/**
+ * The node layout without a copy of any column, keeping keys only.
+ */
+template <typename Key, unsigned N>
+struct node_heads<Key, -1, N> {
+    enum { bytes_per_key = 0 };
+
+    void setHead(std::size_t, const Key&) {}
+
+    template <typename S, typename Iter, typename Comp>
+    Iter searchFind(const S& search, const Key& k, Iter a, Iter b, Comp& comp) const {
+        return search(k, a, b, comp);
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter searchLowerBound(const S& search, const Key& k, Iter a, Iter b, Comp& comp) const {
+        return search.lower_bound(k, a, b, comp);
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter searchUpperBound(const S& search, const Key& k, Iter a, Iter b, Comp& comp) const {
+        return search.upper_bound(k, a, b, comp);
+    }
+};
+
+/**
+ * The node layout keeping the normalised keys of the keys of a b-tree node
+ * ordered by the given comparator, searched in place of the keys.
+ */
+template <typename Key, typename Comparator, unsigned N>
+struct node_normalised {
+    using normalised = normalised_key<Comparator, Key>;
+    using value_type = typename normalised::type;
+
+    enum { bytes_per_key = sizeof(value_type) };
+
+    value_type heads[N];
+
+    void setHead(std::size_t i, const Key& k) {
+        heads[i] = normalised::get(k);
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter searchFind(const S& search, const Key& k, Iter a, Iter b, Comp& comp) const {
+        return lowerBound(search, k, a, b, comp, std::is_same<Comp, Comparator>());
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter searchLowerBound(const S& search, const Key& k, Iter a, Iter b, Comp& comp) const {
+        return lowerBound(search, k, a, b, comp, std::is_same<Comp, Comparator>());
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter searchUpperBound(const S& search, const Key& k, Iter a, Iter b, Comp& comp) const {
+        return upperBound(search, k, a, b, comp, std::is_same<Comp, Comparator>());
+    }
+
+private:
+    // the largest normalised key; limits do not cover 128-bit integers in strict standard modes
+    static constexpr value_type maximum() {
+        return std::is_signed<value_type>::value ? std::numeric_limits<value_type>::max()
+                                                 : value_type(~value_type(0));
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter lowerBound(const S&, const Key& k, Iter a, Iter b, Comp& comp, std::true_type) const {
+        Iter c = a + simd_utils::count_less(heads, b - a, normalised::get(k));
+        if (normalised::complete) {
+            return c;
+        }
+        // keys agreeing on the encoded columns are ordered by the remaining ones
+        while (c < b && comp(*c, k) < 0) {
+            ++c;
+        }
+        return c;
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter lowerBound(const S& search, const Key& k, Iter a, Iter b, Comp& comp, std::false_type) const {
+        return search.lower_bound(k, a, b, comp);
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter upperBound(const S&, const Key& k, Iter a, Iter b, Comp& comp, std::true_type) const {
+        const value_type x = normalised::get(k);
+        if (normalised::complete) {
+            // the keys not greater than the key are the ones less than its successor
+            if (x == maximum()) {
+                return b;
+            }
+            return a + simd_utils::count_less(heads, b - a, value_type(x + 1));
+        }
+        Iter c = a + simd_utils::count_less(heads, b - a, x);
+        while (c < b && comp(*c, k) <= 0) {
+            ++c;
+        }
+        return c;
+    }
+
+    template <typename S, typename Iter, typename Comp>
+    Iter upperBound(const S& search, const Key& k, Iter a, Iter b, Comp& comp, std::false_type) const {
+        return search.upper_bound(k, a, b, comp);
+    }
+};
+
+// ---------- node allocation --------------
+
+/**
+ * The node allocation policy of b-trees based on a standard allocator:
+ * nodes are allocated and freed one by one.
+ */
+template <typename Allocator>
+struct node_allocator {
+    using byte_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<char>;
+    using traits = std::allocator_traits<byte_allocator>;
+
+    // whether all nodes are freed by release() without being deallocated one by one
+    static constexpr bool bulk_release = false;
+
+    byte_allocator alloc;
+
+    void* allocate(std::size_t size) {
+        return traits::allocate(alloc, size);
+    }
+
+    void deallocate(void* ptr, std::size_t size) {
+        traits::deallocate(alloc, static_cast<char*>(ptr), size);
+    }
+
+    void release() {}
+
+    void recycle() {}
+
+    // nodes are obtained one by one, hence nothing is allocated in advance
+    void reserve(std::size_t /* size */) {}
+
+    void swap(node_allocator& other) {
+        std::swap(alloc, other.alloc);
+    }
+};
+
+/**
+ * The node allocation policy of b-trees utilizing a node pool.
+ */
+template <>
+struct node_allocator<btree_node_pool> {
+    static constexpr bool bulk_release = true;
+
+    node_allocator() = default;
+    node_allocator(const node_allocator&) = delete;
+    node_allocator& operator=(const node_allocator&) = delete;
+
+    ~node_allocator() {
+        release();
+    }
+
+    void* allocate(std::size_t size) {
+        // keep all nodes suitably aligned
+        size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+        cursor& cur = cursors[getCursor()];
+        cur.lock.lock();
+        if (static_cast<std::size_t>(cur.end - cur.next) < size) {
+            newSlab(cur, size);
+        }
+        void* res = cur.next;
+        cur.next += size;
+        cur.lock.unlock();
+        return res;
+    }
+
+    // nodes are only freed in bulk
+    void deallocate(void* /* ptr */, std::size_t /* size */) {}
+
+    void release() {
+        slab_lock.lock();
+        for (const auto& slab : slabs) {
+            std::free(slab.first);
+        }
+        slabs.clear();
+        spare.clear();
+        slab_lock.unlock();
+        for (auto& cur : cursors) {
+            cur.next = nullptr;
+            cur.end = nullptr;
+            cur.slab_size = MIN_SLAB_SIZE;
+        }
+    }
+
+    // allocates slabs of the given total size in advance, handed out before any new slab is allocated
+    void reserve(std::size_t size) {
+        const std::size_t slab_size = MAX_SLAB_SIZE;
+        std::vector<std::pair<char*, std::size_t>> reserved;
+        for (std::size_t total = 0; total < size; total += slab_size) {
+            char* slab = static_cast<char*>(std::malloc(slab_size));
+            if (slab == nullptr) {
+                throw std::bad_alloc();
+            }
+            reserved.emplace_back(slab, slab_size);
+        }
+        slab_lock.lock();
+        slabs.insert(slabs.end(), reserved.begin(), reserved.end());
+        spare.insert(spare.end(), reserved.begin(), reserved.end());
+        slab_lock.unlock();
+    }
+
+    // all slabs are handed out again, the nodes allocated from them are no longer in use
+    void recycle() {
+        slab_lock.lock();
+        spare = slabs;
+        slab_lock.unlock();
+        for (auto& cur : cursors) {
+            cur.next = nullptr;
+            cur.end = nullptr;
+        }
+    }
+
+    void swap(node_allocator& other) {
+        slabs.swap(other.slabs);
+        spare.swap(other.spare);
+        for (int i = 0; i < NUM_CURSORS; ++i) {
+            std::swap(cursors[i].next, other.cursors[i].next);
+            std::swap(cursors[i].end, other.cursors[i].end);
+            std::swap(cursors[i].slab_size, other.cursors[i].slab_size);
+        }
+    }
+
+private:
+    static constexpr std::size_t ALIGNMENT = 16;
+
+    // slabs grow from small ones, such that small trees stay small, to large ones
+    static constexpr std::size_t MIN_SLAB_SIZE = 1 << 12;
+    static constexpr std::size_t MAX_SLAB_SIZE = 1 << 20;
+
+#ifdef _OPENMP
+    static constexpr int NUM_CURSORS = 64;
+#else
+    static constexpr int NUM_CURSORS = 1;
+#endif
+
+    // a bump-pointer into the current slab of a thread, padded to a cache line
+    struct cursor {
+        AdaptiveLock lock;
+        char* next = nullptr;
+        char* end = nullptr;
+        std::size_t slab_size = MIN_SLAB_SIZE;
+        char padding[64 - sizeof(AdaptiveLock) - 2 * sizeof(char*) - sizeof(std::size_t)];
+    };
+
+    cursor cursors[NUM_CURSORS];
+
+    // all slabs allocated so far, and those of them not handed out since the last recycle, with their sizes
+    std::vector<std::pair<char*, std::size_t>> slabs;
+    std::vector<std::pair<char*, std::size_t>> spare;
+    AdaptiveLock slab_lock;
+
+    static int getCursor() {
+#ifdef _OPENMP
+        // threads of nested teams may share numbers with others, the lock of the cursor keeps this safe
+        return omp_get_thread_num() % NUM_CURSORS;
+#else
+        return 0;
+#endif
+    }
+
+    void newSlab(cursor& cur, std::size_t size) {
+        slab_lock.lock();
+        while (!spare.empty()) {
+            const auto slab = spare.back();
+            spare.pop_back();
+            if (slab.second >= size) {
+                slab_lock.unlock();
+                cur.next = slab.first;
+                cur.end = slab.first + slab.second;
+                return;
+            }
+        }
+        slab_lock.unlock();
+
+        std::size_t slab_size = cur.slab_size;
+        while (slab_size < size) {
+            slab_size <<= 1;
+        }
+        if (cur.slab_size < MAX_SLAB_SIZE) {
+            cur.slab_size <<= 1;
+        }
+
+        char* slab = static_cast<char*>(std::malloc(slab_size));
+        if (slab == nullptr) {
+            throw std::bad_alloc();
+        }
+        slab_lock.lock();
+        slabs.emplace_back(slab, slab_size);
+        slab_lock.unlock();
+
+        cur.next = slab;
+        cur.end = slab + slab_size;
+    }
+};
+
 /**
  * The default non-updater
  */
@@ -239,10 +913,8 @@ struct updater {
  * @tparam SearchStrategy .. enables switching between linear, binary or any other search strategy
  * @tparam isSet        .. true = set, false = multiset
  */
-template <typename Key, typename Comparator,
-        typename Allocator,  // is ignored so far - TODO: add support
-        unsigned blockSize, typename SearchStrategy, bool isSet, typename WeakComparator = Comparator,
-        typename Updater = detail::updater<Key>>
+template <typename Key, typename Comparator, typename Allocator, unsigned blockSize, typename SearchStrategy,
+        bool isSet, typename WeakComparator = Comparator, typename Updater = detail::updater<Key>>
 class btree {
 public:
     class iterator;
@@ -257,6 +929,14 @@ protected:
 
     const static SearchStrategy search;
 
+    enum {
+        // the maximal ratio between the sizes of two trees for insertAll to merge them
+        MERGE_RATIO = 4,
+
+        // the minimal number of elements for bulk-building sub-trees in parallel
+        PARALLEL_BUILD_SIZE = 1 << 16
+    };
+
     /* ---------- comparison utilities ---------------- */
 
     mutable Comparator comp;
@@ -282,8 +962,10 @@ protected:
     /* -------------- updater utilities ------------- */
 
     mutable Updater upd;
-    void update(Key& old_k, const Key& new_k) {
-        upd.update(old_k, new_k);
+    template <typename Node>
+    void update(Node* cur, Key* old_k, const Key& new_k) {
+        upd.update(*old_k, new_k);
+        cur->setHead(old_k - cur->keys, *old_k);
     }
 
     /* -------------- the node type ----------------- */
@@ -291,6 +973,7 @@ protected:
     using size_type = std::size_t;
     using field_index_type = uint8_t;
     using lock_type = OptimisticReadWriteLock;
+    using allocator_type = node_allocator<Allocator>;
 
     struct node;
 
@@ -355,22 +1038,45 @@ protected:
     struct inner_node;
 
     /**
-     * The actual, generic node implementation covering the operations
-     * for both, inner and leaf nodes.
+     * The layout of nodes, determining the number of keys stored per node.
      */
-    struct node : public base {
+    struct node_layout {
+        /**
+         * The column of the keys copied contiguously into nodes, -1 if there is none.
+         */
+        enum {
+            head_column = columnar_layout<SearchStrategy>::value ? leading_column<Comparator>::value : -1
+        };
+
+        /**
+         * The copies of the keys stored in nodes of the given capacity next to the keys.
+         */
+        template <unsigned N>
+        using heads = typename std::conditional<normalised_layout<SearchStrategy>::value &&
+                                                        (normalised_key<Comparator, Key>::columns > 0),
+                node_normalised<Key, Comparator, N>, node_heads<Key, head_column, N>>::type;
+
         enum {
 
             /**
              * The number of keys/node desired by the user.
              */
-            desiredNumKeys = ((blockSize > sizeof(base)) ? blockSize - sizeof(base) : 0) / sizeof(Key),
+            desiredNumKeys = ((blockSize > sizeof(base)) ? blockSize - sizeof(base) : 0) /
+                             (sizeof(Key) + heads<1>::bytes_per_key),
 
             /**
              * The actual number of keys/node corrected by functional requirements.
              */
             maxKeys = (desiredNumKeys > 3) ? desiredNumKeys : 3
         };
+    };
+
+    /**
+     * The actual, generic node implementation covering the operations
+     * for both, inner and leaf nodes.
+     */
+    struct node : public base, public node_layout::template heads<node_layout::maxKeys> {
+        enum { maxKeys = node_layout::maxKeys };
 
         // the keys stored in this node
         Key keys[maxKeys];
@@ -378,27 +1084,27 @@ protected:
         // a simple constructor
         node(bool inner) : base(inner) {}
 
-        // a destructor cleaning up nodes
-        ~node() {
-            if (this->inner) {
-                asInnerNode().cleanup();
-            }
+        /**
+         * Stores the given key at the given position of this node.
+         */
+        void setKey(size_type i, const Key& k) {
+            keys[i] = k;
+            this->setHead(i, k);
         }
 
         /**
          * A deep-copy operation creating a clone of this node.
          */
-        node* clone() const {
+        node* clone(allocator_type& alloc) const {
             // create a clone of this node
-            node* res = (this->isInner()) ? static_cast<node*>(new inner_node())
-                                          : static_cast<node*>(new leaf_node());
+            node* res = newNode(alloc, this->isInner());
 
             // copy basic fields
             res->position = this->position;
             res->numElements = this->numElements;
 
             for (size_type i = 0; i < this->numElements; ++i) {
-                res->keys[i] = this->keys[i];
+                res->setKey(i, this->keys[i]);
             }
 
             // if this is a leaf we are done
@@ -409,7 +1115,7 @@ protected:
             // copy child nodes recursively
             auto* ires = (inner_node*)res;
             for (size_type i = 0; i <= this->numElements; ++i) {
-                ires->children[i] = this->getChild(i)->clone();
+                ires->children[i] = this->getChild(i)->clone(alloc);
                 ires->children[i]->parent = res;
             }
 
@@ -547,14 +1253,15 @@ protected:
          * @param idx  .. the position of the insert causing the split
          */
 #ifdef IS_PARALLEL
-        void split(node** root, lock_type& root_lock, int idx, std::vector<node*>& locked_nodes) {
+        void split(node** root, lock_type& root_lock, allocator_type& alloc, int idx,
+                std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(!this->parent || this->parent->lock.is_write_locked());
             assert((this->parent != nullptr) || root_lock.is_write_locked());
             assert(this->isLeaf() || souffle::contains(locked_nodes, this));
             assert(!this->parent || souffle::contains(locked_nodes, const_cast<node*>(this->parent)));
 #else
-        void split(node** root, lock_type& root_lock, int idx) {
+        void split(node** root, lock_type& root_lock, allocator_type& alloc, int idx) {
 #endif
             assert(this->numElements == maxKeys);
 
@@ -562,8 +1269,7 @@ protected:
             int split_point = getSplitPoint(idx);
 
             // create a new sibling node
-            node* sibling = (this->inner) ? static_cast<node*>(new inner_node())
-                                          : static_cast<node*>(new leaf_node());
+            node* sibling = newNode(alloc, this->inner);
 
 #ifdef IS_PARALLEL
             // lock sibling
@@ -573,7 +1279,7 @@ protected:
 
             // move data over to the new node
             for (unsigned i = split_point + 1, j = 0; i < maxKeys; ++i, ++j) {
-                sibling->keys[j] = keys[i];
+                sibling->setKey(j, keys[i]);
             }
 
             // move child pointers
@@ -593,9 +1299,9 @@ protected:
 
             // update parent
 #ifdef IS_PARALLEL
-            grow_parent(root, root_lock, sibling, locked_nodes);
+            grow_parent(root, root_lock, alloc, sibling, locked_nodes);
 #else
-            grow_parent(root, root_lock, sibling);
+            grow_parent(root, root_lock, alloc, sibling);
 #endif
         }
 
@@ -612,14 +1318,15 @@ protected:
          */
         // TODO: remove root_lock ... no longer needed
 #ifdef IS_PARALLEL
-        int rebalance_or_split(node** root, lock_type& root_lock, int idx, std::vector<node*>& locked_nodes) {
+        int rebalance_or_split(node** root, lock_type& root_lock, allocator_type& alloc, int idx,
+                std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(!this->parent || this->parent->lock.is_write_locked());
             assert((this->parent != nullptr) || root_lock.is_write_locked());
             assert(this->isLeaf() || souffle::contains(locked_nodes, this));
             assert(!this->parent || souffle::contains(locked_nodes, const_cast<node*>(this->parent)));
 #else
-        int rebalance_or_split(node** root, lock_type& root_lock, int idx) {
+        int rebalance_or_split(node** root, lock_type& root_lock, allocator_type& alloc, int idx) {
 #endif
 
             // this node is full ... and needs some space
@@ -637,7 +1344,7 @@ protected:
                 // lock access to left sibling
                 if (!left->lock.try_start_write()) {
                     // left node is currently updated => skip balancing and split
-                    split(root, root_lock, idx, locked_nodes);
+                    split(root, root_lock, alloc, idx, locked_nodes);
                     return 0;
                 }
 #endif
@@ -651,15 +1358,15 @@ protected:
                     Key* splitter = &(parent->keys[this->position - 1]);
 
                     // .. move keys to left node
-                    left->keys[left->numElements] = *splitter;
+                    left->setKey(left->numElements, *splitter);
                     for (size_type i = 0; i < num - 1; ++i) {
-                        left->keys[left->numElements + 1 + i] = keys[i];
+                        left->setKey(left->numElements + 1 + i, keys[i]);
                     }
-                    *splitter = keys[num - 1];
+                    parent->setKey(this->position - 1, keys[num - 1]);
 
                     // shift keys in this node to the left
                     for (size_type i = 0; i < this->numElements - num; ++i) {
-                        keys[i] = keys[i + num];
+                        this->setKey(i, keys[i + num]);
                     }
 
                     // .. and children if necessary
@@ -708,9 +1415,9 @@ protected:
 
             // Option B) split node
 #ifdef IS_PARALLEL
-            split(root, root_lock, idx, locked_nodes);
+            split(root, root_lock, alloc, idx, locked_nodes);
 #else
-            split(root, root_lock, idx);
+            split(root, root_lock, alloc, idx);
 #endif
             return 0;  // = no re-balancing
         }
@@ -725,23 +1432,24 @@ protected:
          * @param sibling .. the new right-sibling to be add to the parent node
          */
 #ifdef IS_PARALLEL
-        void grow_parent(node** root, lock_type& root_lock, node* sibling, std::vector<node*>& locked_nodes) {
+        void grow_parent(node** root, lock_type& root_lock, allocator_type& alloc, node* sibling,
+                std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(!this->parent || this->parent->lock.is_write_locked());
             assert((this->parent != nullptr) || root_lock.is_write_locked());
             assert(this->isLeaf() || souffle::contains(locked_nodes, this));
             assert(!this->parent || souffle::contains(locked_nodes, const_cast<node*>(this->parent)));
 #else
-        void grow_parent(node** root, lock_type& root_lock, node* sibling) {
+        void grow_parent(node** root, lock_type& root_lock, allocator_type& alloc, node* sibling) {
 #endif
 
             if (this->parent == nullptr) {
                 assert(*root == this);
 
                 // create a new root node
-                auto* new_root = new inner_node();
+                auto* new_root = static_cast<inner_node*>(newNode(alloc, true));
                 new_root->numElements = 1;
-                new_root->keys[0] = keys[this->numElements];
+                new_root->setKey(0, keys[this->numElements]);
 
                 new_root->children[0] = this;
                 new_root->children[1] = sibling;
@@ -761,9 +1469,9 @@ protected:
 
 #ifdef IS_PARALLEL
                 parent->insert_inner(
-                        root, root_lock, pos, this, keys[this->numElements], sibling, locked_nodes);
+                        root, root_lock, alloc, pos, this, keys[this->numElements], sibling, locked_nodes);
 #else
-                parent->insert_inner(root, root_lock, pos, this, keys[this->numElements], sibling);
+                parent->insert_inner(root, root_lock, alloc, pos, this, keys[this->numElements], sibling);
 #endif
             }
         }
@@ -772,18 +1480,19 @@ protected:
          * Inserts a new element into an inner node (for internal use only).
          *
          * @param root .. a pointer to the root-pointer of the containing tree
+         * @param alloc .. the allocator of the nodes of the containing tree
          * @param pos  .. the position to insert the new key
          * @param key  .. the key to insert
          * @param newNode .. the new right-child of the inserted key
          */
 #ifdef IS_PARALLEL
-        void insert_inner(node** root, lock_type& root_lock, unsigned pos, node* predecessor, const Key& key,
-                node* newNode, std::vector<node*>& locked_nodes) {
+        void insert_inner(node** root, lock_type& root_lock, allocator_type& alloc, unsigned pos,
+                node* predecessor, const Key& key, node* newNode, std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(souffle::contains(locked_nodes, this));
 #else
-        void insert_inner(node** root, lock_type& root_lock, unsigned pos, node* predecessor, const Key& key,
-                node* newNode) {
+        void insert_inner(node** root, lock_type& root_lock, allocator_type& alloc, unsigned pos,
+                node* predecessor, const Key& key, node* newNode) {
 #endif
 
             // check capacity
@@ -796,9 +1505,9 @@ protected:
 
                 // split this node
 #ifdef IS_PARALLEL
-                pos -= rebalance_or_split(root, root_lock, pos, locked_nodes);
+                pos -= rebalance_or_split(root, root_lock, alloc, pos, locked_nodes);
 #else
-                pos -= rebalance_or_split(root, root_lock, pos);
+                pos -= rebalance_or_split(root, root_lock, alloc, pos);
 #endif
 
                 // complete insertion within new sibling if necessary
@@ -820,9 +1529,10 @@ protected:
                         if (other->getChild(i) == predecessor) break;
 
                     pos = (i > other->numElements) ? 0 : i;
-                    other->insert_inner(root, root_lock, pos, predecessor, key, newNode, locked_nodes);
+                    other->insert_inner(
+                            root, root_lock, alloc, pos, predecessor, key, newNode, locked_nodes);
 #else
-                    other->insert_inner(root, root_lock, pos, predecessor, key, newNode);
+                    other->insert_inner(root, root_lock, alloc, pos, predecessor, key, newNode);
 #endif
                     return;
                 }
@@ -830,7 +1540,7 @@ protected:
 
             // move bigger keys one forward
             for (int i = this->numElements - 1; i >= (int)pos; --i) {
-                keys[i + 1] = keys[i];
+                this->setKey(i + 1, keys[i]);
                 getChildren()[i + 2] = getChildren()[i + 1];
                 ++getChildren()[i + 2]->position;
             }
@@ -839,7 +1549,7 @@ protected:
             assert(getChild(pos) == predecessor);
 
             // insert new element
-            keys[pos] = key;
+            this->setKey(pos, key);
             getChildren()[pos + 1] = newNode;
             newNode->parent = this;
             newNode->position = pos + 1;
@@ -1060,15 +1770,11 @@ protected:
         // references to child nodes owned by this node
         node* children[node::maxKeys + 1];
 
+        // the number of entries in the sub-tree rooted by this node, as of the last update of the counts
+        size_type numEntries = 0;
+
         // a simple default constructor initializing member fields
         inner_node() : node(true) {}
-
-        // a destruction operation clearing up child nodes recursively
-        void cleanup() {
-            for (unsigned i = 0; i <= this->numElements; ++i) {
-                delete children[i];
-            }
-        }
     };
 
     /**
@@ -1080,6 +1786,30 @@ protected:
         leaf_node() : node(false) {}
     };
 
+    // creates a new inner or leaf node utilizing the given allocator
+    static node* newNode(allocator_type& alloc, bool inner) {
+        if (inner) {
+            return new (alloc.allocate(sizeof(inner_node))) inner_node();
+        }
+        return new (alloc.allocate(sizeof(leaf_node))) leaf_node();
+    }
+
+    // frees the given node and all its child nodes
+    static void deleteNode(allocator_type& alloc, node* cur) {
+        if (cur->isInner()) {
+            auto* inner = static_cast<inner_node*>(cur);
+            for (unsigned i = 0; i <= inner->numElements; ++i) {
+                deleteNode(alloc, inner->children[i]);
+            }
+            inner->~inner_node();
+            alloc.deallocate(inner, sizeof(inner_node));
+        } else {
+            auto* leaf = static_cast<leaf_node*>(cur);
+            leaf->~leaf_node();
+            alloc.deallocate(leaf, sizeof(leaf_node));
+        }
+    }
+
     // ------------------- iterators ------------------------
 
 public:
@@ -1087,6 +1817,8 @@ public:
      * The iterator type to be utilized for scanning through btree instances.
      */
     class iterator : public std::iterator<std::forward_iterator_tag, Key> {
+        friend class btree;
+
         // a pointer to the node currently referred to
         node const* cur;
 
@@ -1217,6 +1949,15 @@ protected:
     // a pointer to the left-most node of this tree (initial note for iteration)
     leaf_node* leftmost;
 
+    // the allocator providing the nodes of this tree
+    allocator_type alloc;
+
+    // whether the entry counts of the inner nodes are up to date
+    mutable std::atomic<bool> counted{false};
+
+    // a lock to synchronize updates of the entry counts
+    mutable Lock countLock;
+
     /* -------------- operator hint statistics ----------------- */
 
     // an aggregation of statistical values of the hint utilization
@@ -1258,6 +1999,7 @@ public:
     // a move constructor
     btree(btree&& other)
             : comp(other.comp), weak_comp(other.weak_comp), root(other.root), leftmost(other.leftmost) {
+        alloc.swap(other.alloc);
         other.root = nullptr;
         other.leftmost = nullptr;
     }
@@ -1268,14 +2010,6 @@ public:
         *this = set;
     }
 
-protected:
-    /**
-     * An internal constructor enabling the specific creation of a tree
-     * based on internal parameters.
-     */
-    btree(size_type size, node* root, leaf_node* leftmost) : root(root), leftmost(leftmost) {}
-
-public:
     // the destructor freeing all contained nodes
     ~btree() {
         clear();
@@ -1290,7 +2024,24 @@ public:
 
     // determines the number of elements in this tree
     size_type size() const {
-        return (root) ? root->countEntries() : 0;
+        if (root == nullptr) {
+            return 0;
+        }
+        return counted.load(std::memory_order_acquire) ? getCount(root) : root->countEntries();
+    }
+
+    /**
+     * Determines the number of elements in the range between two iterators of this
+     * tree. The entry counts of the sub-trees are recounted once after the tree has
+     * been modified, such that following counts take logarithmic time instead of
+     * iterating through the range. The tree must not be modified concurrently.
+     */
+    size_type countRange(const iterator& a, const iterator& b) const {
+        if (a == b) {
+            return 0;
+        }
+        updateCounts();
+        return getRank(b) - getRank(a);
     }
 
     /**
@@ -1305,6 +2056,8 @@ public:
      * Inserts the given key into this tree.
      */
     bool insert(const Key& k, operation_hints& hints) {
+        LockSiteScope lockSite(LockSite::BTREE);
+        invalidateCounts();
 #ifdef IS_PARALLEL
 
         // special handling for inserting first element
@@ -1323,9 +2076,9 @@ public:
             }
 
             // create new node
-            leftmost = new leaf_node();
+            leftmost = static_cast<leaf_node*>(newNode(alloc, false));
             leftmost->numElements = 1;
-            leftmost->keys[0] = k;
+            leftmost->setKey(0, k);
             root = leftmost;
 
             // operation complete => we can release the root lock
@@ -1392,7 +2145,7 @@ public:
                 auto a = &(cur->keys[0]);
                 auto b = &(cur->keys[cur->numElements]);
 
-                auto pos = search.lower_bound(k, a, b, weak_comp);
+                auto pos = cur->searchLowerBound(search, k, a, b, weak_comp);
                 auto idx = pos - a;
 
                 // early exit for sets
@@ -1409,7 +2162,7 @@ public:
                             // start again
                             return insert(k, hints);
                         }
-                        update(*pos, k);
+                        update(cur, pos, k);
                         cur->lock.end_write();
                         return true;
                     }
@@ -1447,7 +2200,7 @@ public:
             auto a = &(cur->keys[0]);
             auto b = &(cur->keys[cur->numElements]);
 
-            auto pos = search.upper_bound(k, a, b, weak_comp);
+            auto pos = cur->searchUpperBound(search, k, a, b, weak_comp);
             auto idx = pos - a;
 
             // early exit for sets
@@ -1464,7 +2217,7 @@ public:
                         // start again
                         return insert(k, hints);
                     }
-                    update(*(pos - 1), k);
+                    update(cur, pos - 1, k);
                     cur->lock.end_write();
                     return true;
                 }
@@ -1515,7 +2268,7 @@ public:
 
                 // split this node
                 auto old_root = root;
-                idx -= cur->rebalance_or_split(const_cast<node**>(&root), root_lock, idx, parents);
+                idx -= cur->rebalance_or_split(const_cast<node**>(&root), root_lock, alloc, idx, parents);
 
                 // release parent lock
                 for (auto it = parents.rbegin(); it != parents.rend(); ++it) {
@@ -1548,11 +2301,11 @@ public:
 
             // move keys
             for (int j = cur->numElements; j > idx; --j) {
-                cur->keys[j] = cur->keys[j - 1];
+                cur->setKey(j, cur->keys[j - 1]);
             }
 
             // insert new element
-            cur->keys[idx] = k;
+            cur->setKey(idx, k);
             cur->numElements++;
 
             // release lock on current node
@@ -1567,9 +2320,9 @@ public:
         // special handling for inserting first element
         if (empty()) {
             // create new node
-            leftmost = new leaf_node();
+            leftmost = static_cast<leaf_node*>(newNode(alloc, false));
             leftmost->numElements = 1;
-            leftmost->keys[0] = k;
+            leftmost->setKey(0, k);
             root = leftmost;
 
             hints.last_insert.access(leftmost);
@@ -1600,14 +2353,14 @@ public:
                 auto a = &(cur->keys[0]);
                 auto b = &(cur->keys[cur->numElements]);
 
-                auto pos = search.lower_bound(k, a, b, weak_comp);
+                auto pos = cur->searchLowerBound(search, k, a, b, weak_comp);
                 auto idx = pos - a;
 
                 // early exit for sets
                 if (isSet && pos != b && weak_equal(*pos, k)) {
                     // update provenance information
                     if (typeid(Comparator) != typeid(WeakComparator) && less(k, *pos)) {
-                        update(*pos, k);
+                        update(cur, pos, k);
                         return true;
                     }
 
@@ -1626,14 +2379,14 @@ public:
             auto a = &(cur->keys[0]);
             auto b = &(cur->keys[cur->numElements]);
 
-            auto pos = search.upper_bound(k, a, b, weak_comp);
+            auto pos = cur->searchUpperBound(search, k, a, b, weak_comp);
             auto idx = pos - a;
 
             // early exit for sets
             if (isSet && pos != a && weak_equal(*(pos - 1), k)) {
                 // update provenance information
                 if (typeid(Comparator) != typeid(WeakComparator) && less(k, *(pos - 1))) {
-                    update(*(pos - 1), k);
+                    update(cur, pos - 1, k);
                     return true;
                 }
 
@@ -1642,7 +2395,7 @@ public:
 
             if (cur->numElements >= node::maxKeys) {
                 // split this node
-                idx -= cur->rebalance_or_split(&root, root_lock, idx);
+                idx -= cur->rebalance_or_split(&root, root_lock, alloc, idx);
 
                 // insert element in right fragment
                 if (((size_type)idx) > cur->numElements) {
@@ -1656,11 +2409,11 @@ public:
 
             // move keys
             for (int j = cur->numElements; j > idx; --j) {
-                cur->keys[j] = cur->keys[j - 1];
+                cur->setKey(j, cur->keys[j - 1]);
             }
 
             // insert new element
-            cur->keys[idx] = k;
+            cur->setKey(idx, k);
             cur->numElements++;
 
             // remember last insertion position
@@ -1696,12 +2449,9 @@ public:
             return;
         }
 
-        // make sure bigger tree is inserted in smaller tree
-        if ((size() + 10000) < other.size()) {
-            // switch sides
-            btree tmp = other;
-            tmp.insertAll(*this);
-            swap(tmp);
+        // merge trees of comparable size in a single pass
+        if (size() < other.size() * MERGE_RATIO) {
+            merge(other);
             return;
         }
 
@@ -1709,6 +2459,55 @@ public:
         insert(other.begin(), other.end());
     }
 
+    /**
+     * Merges all elements of the given b-tree into this tree. Both trees are
+     * traversed once in order and this tree is rebuilt from the merged sequence,
+     * so the cost is linear in the size of both trees instead of requiring a
+     * descent from the root for every inserted element. Iterators and operation
+     * hints referencing this tree are invalidated.
+     */
+    void merge(const btree& other) {
+        // shortcut for non-sense operations
+        if (this == &other || other.empty()) {
+            return;
+        }
+
+        // merge the ordered sequences of elements
+        std::vector<Key> buffer;
+        buffer.reserve(size() + other.size());
+        auto a = begin();
+        auto b = other.begin();
+        while (a != end() && b != other.end()) {
+            int r = weak_comp(*a, *b);
+            if (r < 0) {
+                buffer.push_back(*a);
+                ++a;
+            } else if (r > 0 || !isSet) {
+                buffer.push_back(*b);
+                ++b;
+            } else {
+                // sets keep one of the elements, updated like by inserting the other
+                buffer.push_back(*a);
+                if (typeid(Comparator) != typeid(WeakComparator) && less(*b, *a)) {
+                    upd.update(buffer.back(), *b);
+                }
+                ++a;
+                ++b;
+            }
+        }
+        for (; a != end(); ++a) {
+            buffer.push_back(*a);
+        }
+        for (; b != other.end(); ++b) {
+            buffer.push_back(*b);
+        }
+
+        // rebuild this tree
+        clear();
+        root = buildSubTree(alloc, buffer.begin(), buffer.end() - 1);
+        leftmost = getLeftmost(root);
+    }
+
     // Obtains an iterator referencing the first element of the tree.
     iterator begin() const {
         return iterator(leftmost, 0);
@@ -1792,7 +2591,7 @@ public:
             auto a = &(cur->keys[0]);
             auto b = &(cur->keys[cur->numElements]);
 
-            auto pos = search(k, a, b, comp);
+            auto pos = cur->searchFind(search, k, a, b, comp);
 
             if (pos < b && equal(*pos, k)) {
                 hints.last_find_end.access(cur);
@@ -1850,7 +2649,7 @@ public:
             auto a = &(cur->keys[0]);
             auto b = &(cur->keys[cur->numElements]);
 
-            auto pos = search.lower_bound(k, a, b, comp);
+            auto pos = cur->searchLowerBound(search, k, a, b, comp);
             auto idx = pos - a;
 
             if (!cur->inner) {
@@ -1870,6 +2669,57 @@ public:
         }
     }
 
+    /**
+     * The number of lower boundaries a batched search descends to at once.
+     */
+    static constexpr size_type PROBE_BATCH = 8;
+
+    /**
+     * Obtains the lower boundaries of the given number of keys, as lower_bound would,
+     * storing them into the given array. The searches of a batch descend the tree level
+     * by level in turns, prefetching the nodes they continue with, such that the cache
+     * misses of independent searches overlap instead of being waited for one by one.
+     */
+    void lower_bounds(const Key* keys, size_type n, iterator* res) const {
+        for (size_type first = 0; first < n; first += PROBE_BATCH) {
+            const size_type count = (n - first < PROBE_BATCH) ? n - first : size_type(PROBE_BATCH);
+            node* cur[PROBE_BATCH];
+            for (size_type i = 0; i < count; i++) {
+                cur[i] = root;
+                res[first + i] = end();
+            }
+
+            // all leaves are at the same depth, hence the searches of a batch proceed in step
+            bool pending = !empty();
+            while (pending) {
+                pending = false;
+                for (size_type i = 0; i < count; i++) {
+                    if (cur[i] == nullptr) {
+                        continue;
+                    }
+                    const Key& k = keys[first + i];
+                    auto a = &(cur[i]->keys[0]);
+                    auto b = &(cur[i]->keys[cur[i]->numElements]);
+
+                    auto pos = cur[i]->searchLowerBound(search, k, a, b, comp);
+                    auto idx = pos - a;
+
+                    if (pos != b) {
+                        res[first + i] = iterator(cur[i], idx);
+                    }
+                    if (!cur[i]->inner || (isSet && pos != b && equal(*pos, k))) {
+                        cur[i] = nullptr;
+                        continue;
+                    }
+
+                    cur[i] = cur[i]->getChild(idx);
+                    prefetch(cur[i]);
+                    pending = true;
+                }
+            }
+        }
+    }
+
     /**
      * Obtains an upper boundary for the given key -- hence an iterator referencing
      * the first element that the given key is less than the referenced value. If
@@ -1911,7 +2761,7 @@ public:
             auto a = &(cur->keys[0]);
             auto b = &(cur->keys[cur->numElements]);
 
-            auto pos = search.upper_bound(k, a, b, comp);
+            auto pos = cur->searchUpperBound(search, k, a, b, comp);
             auto idx = pos - a;
 
             if (!cur->inner) {
@@ -1931,7 +2781,40 @@ public:
      * Clears this tree.
      */
     void clear() {
-        delete root;
+        // nodes of pools holding trivially destructible keys do not need to be visited
+        const bool visit = !(allocator_type::bulk_release && std::is_trivially_destructible<Key>::value);
+        if (root != nullptr && visit) {
+            deleteNode(alloc, root);
+        }
+        invalidateCounts();
+        alloc.release();
+        root = nullptr;
+        leftmost = nullptr;
+    }
+
+    /**
+     * Prepares this tree for holding the given number of elements: a tree
+     * taking its nodes from a node pool obtains their memory in advance.
+     */
+    void reserve(size_type n) {
+        // nodes are about two thirds full on average
+        const size_type perNode = std::max<size_type>(1, 2 * node::maxKeys / 3);
+        const size_type leaves = n / perNode + 1;
+        const size_type inners = leaves / perNode + 1;
+        alloc.reserve(leaves * sizeof(leaf_node) + inners * sizeof(inner_node));
+    }
+
+    /**
+     * Clears this tree, keeping the memory of its nodes for those inserted
+     * next if they are taken from a node pool.
+     */
+    void reset() {
+        if (!(allocator_type::bulk_release && std::is_trivially_destructible<Key>::value)) {
+            clear();
+            return;
+        }
+        invalidateCounts();
+        alloc.recycle();
         root = nullptr;
         leftmost = nullptr;
     }
@@ -1945,6 +2828,9 @@ public:
         // swap the content
         std::swap(root, other.root);
         std::swap(leftmost, other.leftmost);
+        alloc.swap(other.alloc);
+        invalidateCounts();
+        other.invalidateCounts();
     }
 
     // Implementation of the assignment operation for trees.
@@ -1954,6 +2840,9 @@ public:
             return *this;
         }
 
+        // drop the current content
+        clear();
+
         // create a deep-copy of the content of the other tree
         // shortcut for empty sets
         if (other.empty()) {
@@ -1961,7 +2850,7 @@ public:
         }
 
         // clone content (deep copy)
-        root = other.root->clone();
+        root = other.root->clone(alloc);
 
         // update leftmost reference
         auto tmp = root;
@@ -2097,25 +2986,34 @@ public:
                                            std::random_access_iterator_tag>::value,
             R>::type
     load(const Iter& a, const Iter& b) {
+        R res;
+
         // quick exit - empty range
         if (a == b) {
-            return R();
+            return res;
         }
 
         // resolve tree recursively
-        auto root = buildSubTree(a, b - 1);
+        res.root = buildSubTree(res.alloc, a, b - 1);
 
         // find leftmost node
-        node* leftmost = root;
-        while (!leftmost->isLeaf()) {
-            leftmost = leftmost->getChild(0);
-        }
+        res.leftmost = getLeftmost(res.root);
 
-        // build result
-        return R(b - a, root, static_cast<leaf_node*>(leftmost));
+        // done
+        return res;
     }
 
 protected:
+    /**
+     * Requests the cache lines of the given node ahead of its use.
+     */
+    static void prefetch(const node* n) {
+        const char* begin = reinterpret_cast<const char*>(n);
+        for (size_t offset = 0; offset < sizeof(node); offset += 64) {
+            __builtin_prefetch(begin + offset);
+        }
+    }
+
     /**
      * Determines whether the range covered by the given node is also
      * covering the given key value.
@@ -2154,9 +3052,85 @@ private:
         return !node->isEmpty() && !less(k, node->keys[0]) && less(k, node->keys[node->numElements - 1]);
     }
 
-    // Utility function for the load operation above.
+    // Obtains the leftmost leaf of the given sub-tree.
+    // marks the entry counts of the inner nodes as outdated
+    void invalidateCounts() {
+        if (counted.load(std::memory_order_relaxed)) {
+            counted.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // the number of entries in the given sub-tree, as of the last update of the counts
+    static size_type getCount(const node* cur) {
+        return cur->isLeaf() ? cur->numElements : static_cast<const inner_node*>(cur)->numEntries;
+    }
+
+    // recounts the entries of the given sub-tree and all of its sub-trees
+    static size_type updateCount(node* cur) {
+        if (cur->isLeaf()) {
+            return cur->numElements;
+        }
+        auto* inner = static_cast<inner_node*>(cur);
+        size_type sum = inner->numElements;
+        for (unsigned i = 0; i <= inner->numElements; ++i) {
+            sum += updateCount(inner->children[i]);
+        }
+        inner->numEntries = sum;
+        return sum;
+    }
+
+    // brings the entry counts of the inner nodes up to date
+    void updateCounts() const {
+        if (counted.load(std::memory_order_acquire)) {
+            return;
+        }
+        auto lease = countLock.acquire();
+        (void)lease;
+        if (!counted.load(std::memory_order_relaxed)) {
+            if (root != nullptr) {
+                updateCount(root);
+            }
+            counted.store(true, std::memory_order_release);
+        }
+    }
+
+    // the number of elements preceding the one referenced by an iterator, based on the entry counts
+    size_type getRank(const iterator& pos) const {
+        if (pos.cur == nullptr) {
+            return getCount(root);
+        }
+        const node* cur = pos.cur;
+        size_type idx = pos.pos;
+        size_type rank = idx;
+        if (cur->isInner()) {
+            for (size_type i = 0; i <= idx; ++i) {
+                rank += getCount(cur->getChild(i));
+            }
+        }
+        while (cur->getParent() != nullptr) {
+            idx = cur->getPositionInParent();
+            cur = cur->getParent();
+            rank += idx;
+            for (size_type i = 0; i < idx; ++i) {
+                rank += getCount(cur->getChild(i));
+            }
+        }
+        return rank;
+    }
+
+    static leaf_node* getLeftmost(node* cur) {
+        while (!cur->isLeaf()) {
+            cur = cur->getChild(0);
+        }
+        return static_cast<leaf_node*>(cur);
+    }
+
+    /**
+     * Utility function for the load operation above. The sub-trees of ranges
+     * of at least PARALLEL_BUILD_SIZE elements are built in parallel.
+     */
     template <typename Iter>
-    static node* buildSubTree(const Iter& a, const Iter& b) {
+    static node* buildSubTree(allocator_type& alloc, const Iter& a, const Iter& b) {
         const int N = node::maxKeys;
 
         // divide range in N+1 sub-ranges
@@ -2165,11 +3139,11 @@ private:
         // terminal case: length is less then maxKeys
         if (length <= N) {
             // create a leaf node
-            node* res = new leaf_node();
+            node* res = newNode(alloc, false);
             res->numElements = length;
 
             for (int i = 0; i < length; ++i) {
-                res->keys[i] = a[i];
+                res->setKey(i, a[i]);
             }
 
             return res;
@@ -2185,29 +3159,26 @@ private:
         }
 
         // create inner node
-        node* res = new inner_node();
+        node* res = newNode(alloc, true);
         res->numElements = numKeys;
 
-        Iter c = a;
-        for (int i = 0; i < numKeys; i++) {
+        // build the sub-trees, the last one covering the remaining part
+#pragma omp parallel for schedule(dynamic) if (length >= PARALLEL_BUILD_SIZE)
+        for (int i = 0; i <= numKeys; i++) {
+            Iter c = a + i * (step + 1);
+
             // get dividing key
-            res->keys[i] = c[step];
+            if (i < numKeys) {
+                res->setKey(i, c[step]);
+            }
 
             // get sub-tree
-            auto child = buildSubTree(c, c + (step - 1));
+            auto child = buildSubTree(alloc, c, (i < numKeys) ? c + (step - 1) : b);
             child->parent = res;
             child->position = i;
             res->getChildren()[i] = child;
-
-            c = c + (step + 1);
         }
 
-        // and the remaining part
-        auto child = buildSubTree(c, b);
-        child->parent = res;
-        child->position = numKeys;
-        res->getChildren()[numKeys] = child;
-
         // done
         return res;
     }
@@ -2231,7 +3202,7 @@ const SearchStrategy
  * @tparam SearchStrategy .. enables switching between linear, binary or any other search strategy
  */
 template <typename Key, typename Comparator = detail::comparator<Key>,
-        typename Allocator = std::allocator<Key>,  // is ignored so far
+        typename Allocator = std::allocator<Key>,
         unsigned blockSize = 256, typename SearchStrategy = typename detail::default_strategy<Key>::type,
         typename WeakComparator = Comparator, typename Updater = detail::updater<Key>>
 class btree_set : public detail::btree<Key, Comparator, Allocator, blockSize, SearchStrategy, true,
@@ -2263,12 +3234,6 @@ public:
     // A move constructor.
     btree_set(btree_set&& other) : super(std::move(other)) {}
 
-private:
-    // A constructor required by the bulk-load facility.
-    template <typename s, typename n, typename l>
-    btree_set(s size, n* root, l* leftmost) : super(size, root, leftmost) {}
-
-public:
     // Support for the assignment operator.
     btree_set& operator=(const btree_set& other) {
         super::operator=(other);
@@ -2292,7 +3257,7 @@ public:
  * @tparam SearchStrategy .. enables switching between linear, binary or any other search strategy
  */
 template <typename Key, typename Comparator = detail::comparator<Key>,
-        typename Allocator = std::allocator<Key>,  // is ignored so far
+        typename Allocator = std::allocator<Key>,
         unsigned blockSize = 256, typename SearchStrategy = typename detail::default_strategy<Key>::type,
         typename WeakComparator = Comparator, typename Updater = detail::updater<Key>>
 class btree_multiset : public detail::btree<Key, Comparator, Allocator, blockSize, SearchStrategy, false,
@@ -2324,12 +3289,6 @@ public:
     // A move constructor.
     btree_multiset(btree_multiset&& other) : super(std::move(other)) {}
 
-private:
-    // A constructor required by the bulk-load facility.
-    template <typename s, typename n, typename l>
-    btree_multiset(s size, n* root, l* leftmost) : super(size, root, leftmost) {}
-
-public:
     // Support for the assignment operator.
     btree_multiset& operator=(const btree_multiset& other) {
         super::operator=(other);
@@ -0,0 +1,114 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file BinaryFormat.h
+ *
+ * The layout of relations stored in binary files, read and written with
+ * IO=binary.
+ *
+ * A file starts with a header, followed by the type of each column, a
+ * dictionary of the symbols occurring in the relation and the columns of
+ * the relation, each a sequence of fixed-width values. Values of symbol
+ * columns are the positions of their symbols in the dictionary, such that
+ * each symbol is interned once when the file is read. The tuples are kept
+ * in the order of the relation written, i.e. ordered by its master index,
+ * and every part is aligned to 8 bytes, such that the columns may be read
+ * in place from a memory mapping of the file. Values are stored in the
+ * byte order of the machine, which the header records.
+ *
+ * Written with symbols=indices, symbol columns rather hold the indices of
+ * the symbols in the symbol table of the writer, which only a program
+ * sharing its symbol dictionary reads (--symbols-in and --symbols-out).
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace souffle {
+
+namespace binary {
+
+/** The header of a binary relation file */
+struct Header {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t domainBits;
+    uint64_t arity;
+    uint64_t tuples;
+    uint64_t symbols;
+    uint64_t symbolBytes;
+};
+
+/** the marker of the byte order of the machine writing a file */
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+/** the type of a column holding numbers, symbols or indices of the symbol table of the writer */
+enum ColumnType : uint8_t { NUMBER = 0, SYMBOL = 1, INDEX = 2 };
+
+/** Create the header of a file of the given content */
+inline Header makeHeader(uint64_t arity, uint64_t tuples, uint64_t symbols, uint64_t symbolBytes) {
+    Header header;
+    std::memcpy(header.magic, "SOUFFLEB", sizeof(header.magic));
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.domainBits = RAM_DOMAIN_SIZE;
+    header.arity = arity;
+    header.tuples = tuples;
+    header.symbols = symbols;
+    header.symbolBytes = symbolBytes;
+    return header;
+}
+
+/** Whether a header is the one of a binary relation file */
+inline bool hasMagic(const Header& header) {
+    return std::memcmp(header.magic, "SOUFFLEB", sizeof(header.magic)) == 0;
+}
+
+/** Round a number of bytes up to the alignment of the parts of a file */
+inline uint64_t pad(uint64_t bytes) {
+    return (bytes + 7) & ~uint64_t(7);
+}
+
+/** The offsets of the parts of a file, derived from its header */
+struct Layout {
+    explicit Layout(const Header& header)
+            : types(sizeof(Header)), offsets(types + pad(header.arity)),
+              symbolData(offsets + (header.symbols + 1) * sizeof(uint64_t)),
+              columns(symbolData + pad(header.symbolBytes)),
+              columnBytes(pad(header.tuples * sizeof(RamDomain))),
+              size(columns + header.arity * columnBytes) {}
+
+    /** the types of the columns, one byte each */
+    uint64_t types;
+
+    /** the offsets of the symbols into the symbol data, one more than symbols */
+    uint64_t offsets;
+
+    /** the characters of the symbols, one after the other */
+    uint64_t symbolData;
+
+    /** the columns, one after the other */
+    uint64_t columns;
+
+    /** the space taken by a column */
+    uint64_t columnBytes;
+
+    /** the size of the file */
+    uint64_t size;
+};
+
+}  // end of namespace binary
+
+}  // end of namespace souffle
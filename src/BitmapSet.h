@@ -0,0 +1,756 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file BitmapSet.h
+ *
+ * An ordered set of pairs of integers storing the second values of each
+ * first value in a compressed bitmap, for binary relations over small and
+ * dense domains.
+ *
+ * The rows of the set, one per first value, are addressed through pages of
+ * PAGE_SIZE consecutive first values. A row splits the second values by
+ * their upper bits into containers of 2^16 values each, which are sorted
+ * arrays while they hold at most ARRAY_LIMIT values and bitmaps of 2^16 bits
+ * otherwise. Membership tests thus take a bit test once a row is dense,
+ * unions of rows are word-level disjunctions and the values of a row are
+ * counted without iterating through them.
+ *
+ * Multiple insert operations can be conducted concurrently on a set, as can
+ * read-only operations. However, inserts and read operations may not be
+ * conducted at the same time.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "CompiledTuple.h"
+#include "ParallelUtils.h"
+#include "RamTypes.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+namespace detail {
+
+/** The values of the set, mapped to unsigned integers of the same order */
+using BitmapValue = std::make_unsigned<RamDomain>::type;
+
+inline BitmapValue encodeBitmapValue(RamDomain value) {
+    return static_cast<BitmapValue>(value) ^ (BitmapValue(1) << (sizeof(BitmapValue) * 8 - 1));
+}
+
+inline RamDomain decodeBitmapValue(BitmapValue value) {
+    return static_cast<RamDomain>(value ^ (BitmapValue(1) << (sizeof(BitmapValue) * 8 - 1)));
+}
+
+/**
+ * A set of 16-bit values, stored in a sorted array while it is sparse and
+ * in a bitmap once it is dense.
+ */
+class BitmapContainer {
+public:
+    // the largest number of values stored in an array
+    enum { ARRAY_LIMIT = 4096 };
+
+    // the number of words of a bitmap
+    enum { WORDS = (1 << 16) / 64 };
+
+    bool insert(uint16_t value) {
+        if (!words.empty()) {
+            const uint64_t bit = uint64_t(1) << (value & 63);
+            if ((words[value >> 6] & bit) != 0) {
+                return false;
+            }
+            words[value >> 6] |= bit;
+            ++count;
+            return true;
+        }
+        auto pos = std::lower_bound(array.begin(), array.end(), value);
+        if (pos != array.end() && *pos == value) {
+            return false;
+        }
+        array.insert(pos, value);
+        ++count;
+        if (array.size() > ARRAY_LIMIT) {
+            toBitmap();
+        }
+        return true;
+    }
+
+    bool contains(uint16_t value) const {
+        if (!words.empty()) {
+            return ((words[value >> 6] >> (value & 63)) & 1) != 0;
+        }
+        return std::binary_search(array.begin(), array.end(), value);
+    }
+
+    /** Obtains the least value not less than the given one, which may exceed all 16-bit values */
+    bool next(uint32_t value, uint16_t& res) const {
+        if (value > 0xFFFF) {
+            return false;
+        }
+        if (words.empty()) {
+            auto pos = std::lower_bound(array.begin(), array.end(), static_cast<uint16_t>(value));
+            if (pos == array.end()) {
+                return false;
+            }
+            res = *pos;
+            return true;
+        }
+        std::size_t word = value >> 6;
+        uint64_t bits = words[word] & (~uint64_t(0) << (value & 63));
+        while (bits == 0) {
+            if (++word == WORDS) {
+                return false;
+            }
+            bits = words[word];
+        }
+        res = static_cast<uint16_t>(word * 64 + __builtin_ctzll(bits));
+        return true;
+    }
+
+    /** Adds the values of the given container, returning the number of values added */
+    std::size_t merge(const BitmapContainer& other) {
+        const std::size_t before = count;
+        if (words.empty() && other.words.empty()) {
+            std::vector<uint16_t> merged;
+            merged.reserve(array.size() + other.array.size());
+            std::set_union(array.begin(), array.end(), other.array.begin(), other.array.end(),
+                    std::back_inserter(merged));
+            array.swap(merged);
+            count = array.size();
+            if (array.size() > ARRAY_LIMIT) {
+                toBitmap();
+            }
+            return count - before;
+        }
+        if (words.empty()) {
+            toBitmap();
+        }
+        if (other.words.empty()) {
+            for (uint16_t value : other.array) {
+                insert(value);
+            }
+            return count - before;
+        }
+        // a disjunction of the words, counting the bits set by the way
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            words[i] |= other.words[i];
+            total += __builtin_popcountll(words[i]);
+        }
+        count = total;
+        return count - before;
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) + array.capacity() * sizeof(uint16_t) + words.capacity() * sizeof(uint64_t);
+    }
+
+private:
+    // the sorted values, while this container is an array
+    std::vector<uint16_t> array;
+
+    // the bits of the values, once this container is a bitmap
+    std::vector<uint64_t> words;
+
+    // the number of values
+    std::size_t count = 0;
+
+    void toBitmap() {
+        words.assign(WORDS, 0);
+        for (uint16_t value : array) {
+            words[value >> 6] |= uint64_t(1) << (value & 63);
+        }
+        std::vector<uint16_t>().swap(array);
+    }
+};
+
+/**
+ * The second values of the pairs sharing a first value, in containers
+ * ordered by the upper bits of the values they hold.
+ */
+class BitmapRow {
+public:
+    // inserts into a row are serialised by its lock
+    SpinLock lock;
+
+    bool insert(BitmapValue value) {
+        auto pos = findContainer(value >> 16);
+        if (pos == containers.end() || pos->first != (value >> 16)) {
+            pos = containers.insert(pos, std::make_pair(value >> 16, BitmapContainer()));
+        }
+        if (!pos->second.insert(static_cast<uint16_t>(value & 0xFFFF))) {
+            return false;
+        }
+        ++count;
+        return true;
+    }
+
+    bool contains(BitmapValue value) const {
+        auto pos = findContainer(value >> 16);
+        return pos != containers.end() && pos->first == (value >> 16) &&
+               pos->second.contains(static_cast<uint16_t>(value & 0xFFFF));
+    }
+
+    /**
+     * Obtains the least value not less than the given one, searching from the container at the given
+     * position, which is updated to the container of the value found.
+     */
+    bool next(BitmapValue value, std::size_t& container, BitmapValue& res) const {
+        const BitmapValue key = value >> 16;
+        if (container >= containers.size() || containers[container].first > key) {
+            container = findContainer(key) - containers.begin();
+        }
+        for (; container < containers.size(); ++container) {
+            const auto& cur = containers[container];
+            const uint32_t low = (cur.first == key) ? static_cast<uint32_t>(value & 0xFFFF) : 0;
+            uint16_t found;
+            if (cur.first >= key && cur.second.next(low, found)) {
+                res = (cur.first << 16) | found;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Adds the values of the given row, returning the number of values added */
+    std::size_t merge(const BitmapRow& other) {
+        std::size_t added = 0;
+        for (const auto& cur : other.containers) {
+            auto pos = findContainer(cur.first);
+            if (pos == containers.end() || pos->first != cur.first) {
+                pos = containers.insert(pos, std::make_pair(cur.first, BitmapContainer()));
+            }
+            added += pos->second.merge(cur.second);
+        }
+        count += added;
+        return added;
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    std::size_t getMemoryUsage() const {
+        std::size_t res = sizeof(*this);
+        for (const auto& cur : containers) {
+            res += sizeof(cur.first) + cur.second.getMemoryUsage();
+        }
+        return res;
+    }
+
+private:
+    using Containers = std::vector<std::pair<BitmapValue, BitmapContainer>>;
+
+    // the containers, ordered by the upper bits of their values
+    Containers containers;
+
+    // the number of values
+    std::size_t count = 0;
+
+    Containers::iterator findContainer(BitmapValue key) {
+        return std::lower_bound(containers.begin(), containers.end(), key,
+                [](const Containers::value_type& cur, BitmapValue k) { return cur.first < k; });
+    }
+
+    Containers::const_iterator findContainer(BitmapValue key) const {
+        return std::lower_bound(containers.begin(), containers.end(), key,
+                [](const Containers::value_type& cur, BitmapValue k) { return cur.first < k; });
+    }
+};
+
+}  // end namespace detail
+
+/**
+ * A set of pairs in lexicographical order, storing the second values of
+ * each first value in a compressed bitmap.
+ *
+ * @tparam N the arity of the stored tuples, which must be 2
+ */
+template <unsigned N>
+class BitmapSet {
+    static_assert(N == 2, "bitmap sets store pairs");
+
+    using Value = detail::BitmapValue;
+    using Row = detail::BitmapRow;
+
+    // the number of rows of a page
+    enum { PAGE_BITS = 12, PAGE_SIZE = 1 << PAGE_BITS };
+
+    /**
+     * The rows of consecutive first values, created on their first insert.
+     */
+    struct Page {
+        std::array<std::atomic<Row*>, PAGE_SIZE> rows;
+
+        Page() {
+            for (auto& cur : rows) {
+                cur.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        ~Page() {
+            for (auto& cur : rows) {
+                delete cur.load(std::memory_order_relaxed);
+            }
+        }
+    };
+
+    using Pages = std::map<Value, std::unique_ptr<Page>>;
+
+public:
+    using entry_type = ram::Tuple<RamDomain, N>;
+    using element_type = entry_type;
+
+    /**
+     * The hints for operations on a set, caching the page of the last row accessed.
+     */
+    struct op_context {
+        Value key = 0;
+        Page* page = nullptr;
+    };
+
+    /**
+     * The statistics on the effectiveness of hints.
+     */
+    struct hint_statistics {
+        CacheAccessCounter inserts;
+        CacheAccessCounter contains;
+        CacheAccessCounter get_boundaries;
+    };
+
+    /**
+     * An iterator through the pairs of a set, in lexicographical order.
+     */
+    class iterator : public std::iterator<std::forward_iterator_tag, entry_type> {
+        friend class BitmapSet;
+
+        typename Pages::const_iterator page;
+        typename Pages::const_iterator pagesEnd;
+
+        // the position of the current row within its page
+        std::size_t row = 0;
+
+        // the position of the container of the current value within its row
+        std::size_t container = 0;
+
+        // the current second value
+        Value value = 0;
+
+        entry_type current;
+
+        iterator(typename Pages::const_iterator page, typename Pages::const_iterator pagesEnd)
+                : page(page), pagesEnd(pagesEnd), current() {}
+
+        /** Moves to the first value not less than the given one of the current row, or to a later row */
+        void seek(Value min) {
+            while (page != pagesEnd) {
+                for (; row < PAGE_SIZE; ++row, min = 0, container = 0) {
+                    const Row* cur = page->second->rows[row].load(std::memory_order_acquire);
+                    if (cur != nullptr && cur->next(min, container, value)) {
+                        current[0] = detail::decodeBitmapValue((page->first << PAGE_BITS) | row);
+                        current[1] = detail::decodeBitmapValue(value);
+                        return;
+                    }
+                }
+                ++page;
+                row = 0;
+            }
+            container = 0;
+            value = 0;
+        }
+
+    public:
+        iterator() = default;
+
+        bool operator==(const iterator& other) const {
+            return page == other.page && row == other.row && value == other.value;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+        const entry_type& operator*() const {
+            return current;
+        }
+
+        const entry_type* operator->() const {
+            return &current;
+        }
+
+        iterator& operator++() {
+            if (value == ~Value(0)) {
+                ++row;
+                container = 0;
+                seek(0);
+            } else {
+                seek(value + 1);
+            }
+            return *this;
+        }
+    };
+
+    using const_iterator = iterator;
+
+    BitmapSet() = default;
+
+    BitmapSet(const BitmapSet&) = delete;
+    BitmapSet& operator=(const BitmapSet&) = delete;
+
+    /**
+     * Inserts the given tuple into this set.
+     *
+     * @return true if the tuple was not present before, false otherwise
+     */
+    bool insert(const entry_type& t) {
+        op_context ctxt;
+        return insert(t, ctxt);
+    }
+
+    bool insert(const entry_type& t, op_context& ctxt) {
+        Row& row = getRow(detail::encodeBitmapValue(t[0]), ctxt);
+        bool added;
+        {
+            std::lock_guard<SpinLock> guard(row.lock);
+            added = row.insert(detail::encodeBitmapValue(t[1]));
+        }
+        if (added) {
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+        return added;
+    }
+
+    /**
+     * Inserts all tuples of the given set into this set, by a union of their rows.
+     */
+    void insertAll(const BitmapSet& other) {
+        if (this == &other) {
+            return;
+        }
+        op_context ctxt;
+        for (const auto& page : other.pages) {
+            for (std::size_t i = 0; i < PAGE_SIZE; ++i) {
+                const Row* src = page.second->rows[i].load(std::memory_order_acquire);
+                if (src == nullptr) {
+                    continue;
+                }
+                Row& row = getRow((page.first << PAGE_BITS) | i, ctxt);
+                std::lock_guard<SpinLock> guard(row.lock);
+                count.fetch_add(row.merge(*src), std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Determines whether the given tuple is present in this set.
+     */
+    bool contains(const entry_type& t) const {
+        op_context ctxt;
+        return contains(t, ctxt);
+    }
+
+    bool contains(const entry_type& t, op_context& ctxt) const {
+        const Row* row = findRow(detail::encodeBitmapValue(t[0]), ctxt, hint_stats.contains);
+        return row != nullptr && row->contains(detail::encodeBitmapValue(t[1]));
+    }
+
+    /**
+     * Obtains an iterator referencing the given tuple, or the end of this set if it is not present.
+     */
+    iterator find(const entry_type& t) const {
+        op_context ctxt;
+        return find(t, ctxt);
+    }
+
+    iterator find(const entry_type& t, op_context& ctxt) const {
+        if (!contains(t, ctxt)) {
+            return end();
+        }
+        return seek(detail::encodeBitmapValue(t[0]), detail::encodeBitmapValue(t[1]));
+    }
+
+    /**
+     * Obtains an iterator referencing the first tuple not less than the given tuple.
+     */
+    iterator lower_bound(const entry_type& t) const {
+        return seek(detail::encodeBitmapValue(t[0]), detail::encodeBitmapValue(t[1]));
+    }
+
+    iterator lower_bound(const entry_type& t, op_context& /* ctxt */) const {
+        return lower_bound(t);
+    }
+
+    /**
+     * Obtains an iterator referencing the first tuple greater than the given tuple.
+     */
+    iterator upper_bound(const entry_type& t) const {
+        iterator res = lower_bound(t);
+        if (res != end() && *res == t) {
+            ++res;
+        }
+        return res;
+    }
+
+    iterator upper_bound(const entry_type& t, op_context& /* ctxt */) const {
+        return upper_bound(t);
+    }
+
+    /**
+     * Obtains the range of tuples sharing the first levels columns with the given tuple.
+     */
+    template <unsigned levels>
+    range<iterator> getBoundaries(const entry_type& t) const {
+        op_context ctxt;
+        return getBoundaries<levels>(t, ctxt);
+    }
+
+    template <unsigned levels>
+    range<iterator> getBoundaries(const entry_type& t, op_context& ctxt) const {
+        if (levels == 0) {
+            return range<iterator>(begin(), end());
+        }
+        const Value first = detail::encodeBitmapValue(t[0]);
+        const Row* row = findRow(first, ctxt, hint_stats.get_boundaries);
+        if (row == nullptr) {
+            return range<iterator>(end(), end());
+        }
+        if (levels == 1) {
+            return range<iterator>(
+                    seek(first, 0), first == ~Value(0) ? end() : seek(first + 1, 0));
+        }
+        if (!row->contains(detail::encodeBitmapValue(t[1]))) {
+            return range<iterator>(end(), end());
+        }
+        iterator a = seek(first, detail::encodeBitmapValue(t[1]));
+        iterator b = a;
+        ++b;
+        return range<iterator>(a, b);
+    }
+
+    /**
+     * Counts the tuples sharing the first levels columns with the given tuple, without iterating
+     * through them.
+     */
+    template <unsigned levels>
+    std::size_t countBoundaries(const entry_type& t, op_context& ctxt) const {
+        if (levels == 0) {
+            return size();
+        }
+        const Row* row = findRow(detail::encodeBitmapValue(t[0]), ctxt, hint_stats.get_boundaries);
+        if (row == nullptr) {
+            return 0;
+        }
+        if (levels == 1) {
+            return row->size();
+        }
+        return row->contains(detail::encodeBitmapValue(t[1])) ? 1 : 0;
+    }
+
+    /**
+     * Counts the tuples of the given range, summing up the sizes of the rows it covers entirely.
+     */
+    std::size_t countRange(const iterator& a, const iterator& b) const {
+        std::size_t res = 0;
+        iterator cur = a;
+        while (cur != b) {
+            const Row* row = cur.page->second->rows[cur.row].load(std::memory_order_acquire);
+            std::size_t container = 0;
+            Value first;
+            row->next(0, container, first);
+            iterator next = cur;
+            next.row++;
+            next.container = 0;
+            next.seek(0);
+            if (cur.value != first || !(b == next || isBefore(next, b))) {
+                // the range starts or ends within the row
+                ++cur;
+                ++res;
+                continue;
+            }
+            res += row->size();
+            cur = next;
+        }
+        return res;
+    }
+
+    /**
+     * Partitions this set into approximately the given number of ranges of whole rows.
+     */
+    std::vector<range<iterator>> partition(std::size_t num) const {
+        std::vector<range<iterator>> res;
+        const std::size_t step = std::max<std::size_t>(1, size() / std::max<std::size_t>(1, num));
+        iterator first = begin();
+        std::size_t taken = 0;
+        for (auto page = pages.begin(); page != pages.end(); ++page) {
+            for (std::size_t i = 0; i < PAGE_SIZE; ++i) {
+                const Row* row = page->second->rows[i].load(std::memory_order_acquire);
+                if (row == nullptr) {
+                    continue;
+                }
+                if (taken >= step) {
+                    iterator cur(page, pages.end());
+                    cur.row = i;
+                    cur.seek(0);
+                    res.push_back(range<iterator>(first, cur));
+                    first = cur;
+                    taken = 0;
+                }
+                taken += row->size();
+            }
+        }
+        if (first != end()) {
+            res.push_back(range<iterator>(first, end()));
+        }
+        return res;
+    }
+
+    iterator begin() const {
+        iterator res(pages.begin(), pages.end());
+        res.seek(0);
+        return res;
+    }
+
+    iterator end() const {
+        return iterator(pages.end(), pages.end());
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    std::size_t size() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    std::size_t getMemoryUsage() const {
+        std::size_t res = sizeof(*this);
+        for (const auto& page : pages) {
+            res += sizeof(Page);
+            for (const auto& row : page.second->rows) {
+                const Row* cur = row.load(std::memory_order_relaxed);
+                if (cur != nullptr) {
+                    res += cur->getMemoryUsage();
+                }
+            }
+        }
+        return res;
+    }
+
+    /**
+     * Removes all tuples from this set.
+     */
+    void clear() {
+        auto lease = lock.acquire();
+        (void)lease;
+        pages.clear();
+        count.store(0, std::memory_order_relaxed);
+    }
+
+    const hint_statistics& getHintStatistics() const {
+        return hint_stats;
+    }
+
+private:
+    // the pages of rows, by the upper bits of their first values
+    Pages pages;
+
+    // serialises the creation of pages
+    Lock lock;
+
+    // the number of tuples
+    std::atomic<std::size_t> count{0};
+
+    mutable hint_statistics hint_stats;
+
+    /** Determines whether the first iterator references a tuple before the tuple of the second one */
+    static bool isBefore(const iterator& a, const iterator& b) {
+        return a.page != a.pagesEnd && (b.page == b.pagesEnd || *a < *b);
+    }
+
+    /** Obtains an iterator to the first value not less than the given one of the given row or later rows */
+    iterator seek(Value first, Value min) const {
+        auto page = pages.lower_bound(first >> PAGE_BITS);
+        iterator res(page, pages.end());
+        if (page != pages.end() && page->first == (first >> PAGE_BITS)) {
+            res.row = first & (PAGE_SIZE - 1);
+            res.seek(min);
+        } else {
+            res.seek(0);
+        }
+        return res;
+    }
+
+    /** Obtains the row of a first value, or null if there is none */
+    const Row* findRow(Value first, op_context& ctxt, CacheAccessCounter& counter) const {
+        const Value key = first >> PAGE_BITS;
+        if (ctxt.page == nullptr || ctxt.key != key) {
+            counter.addMiss();
+            auto pos = pages.find(key);
+            if (pos == pages.end()) {
+                return nullptr;
+            }
+            ctxt.key = key;
+            ctxt.page = pos->second.get();
+        } else {
+            counter.addHit();
+        }
+        return ctxt.page->rows[first & (PAGE_SIZE - 1)].load(std::memory_order_acquire);
+    }
+
+    /** Obtains the row of a first value, creating it if there is none */
+    Row& getRow(Value first, op_context& ctxt) {
+        const Value key = first >> PAGE_BITS;
+        if (ctxt.page == nullptr || ctxt.key != key) {
+            hint_stats.inserts.addMiss();
+            auto lease = lock.acquire();
+            (void)lease;
+            auto& page = pages[key];
+            if (!page) {
+                page = std::make_unique<Page>();
+            }
+            ctxt.key = key;
+            ctxt.page = page.get();
+        } else {
+            hint_stats.inserts.addHit();
+        }
+        std::atomic<Row*>& slot = ctxt.page->rows[first & (PAGE_SIZE - 1)];
+        Row* row = slot.load(std::memory_order_acquire);
+        if (row == nullptr) {
+            Row* created = new Row();
+            if (slot.compare_exchange_strong(row, created, std::memory_order_acq_rel)) {
+                row = created;
+            } else {
+                delete created;
+            }
+        }
+        return *row;
+    }
+};
+
+}  // end namespace souffle
@@ -0,0 +1,125 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file BloomFilter.h
+ *
+ * A Bloom filter over the keys of the tuples of a relation, answering
+ * existence checks that find no tuple without searching an index.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A blocked Bloom filter over the values of some columns of tuples. Each key
+ * sets a few bits of a single word, such that a test reads one word only; with
+ * the number of words chosen by the number of tuples, about one in a hundred
+ * keys not in the filter is reported as contained.
+ *
+ * The filter is built from the tuples of a relation that does not change while
+ * the filter is used, and may be read by many threads at once.
+ */
+class BloomFilter {
+public:
+    /** Create an empty filter over the keys formed by the given columns */
+    explicit BloomFilter(SearchSignature columns = 0) : columns(columns) {}
+
+    /** Fill the filter with the keys of the given tuples, given the number of tuples */
+    template <typename Tuples>
+    void build(Tuples&& tuples, size_t size) {
+        size_t numWords = 1;
+        while (numWords * KEYS_PER_WORD < size) {
+            numWords *= 2;
+        }
+        words.assign(numWords, 0);
+        mask = numWords - 1;
+        for (const auto& tuple : tuples) {
+            uint64_t h = hash(tuple);
+            words[(h >> 32) & mask] |= bits(h);
+        }
+    }
+
+    /** Remove all keys from the filter, releasing its memory */
+    void clear() {
+        std::vector<uint64_t>().swap(words);
+        mask = 0;
+    }
+
+    /** Whether the filter has been built */
+    bool empty() const {
+        return words.empty();
+    }
+
+    /** Whether a tuple whose key columns equal those of the given tuple may have been added */
+    template <typename Tuple>
+    bool mayContain(const Tuple& tuple) const {
+        uint64_t h = hash(tuple);
+        uint64_t b = bits(h);
+        return (words[(h >> 32) & mask] & b) == b;
+    }
+
+    /** The columns forming the keys of the filter */
+    SearchSignature getColumns() const {
+        return columns;
+    }
+
+    /** The memory occupied by the filter in bytes */
+    size_t getMemoryUsage() const {
+        return words.capacity() * sizeof(uint64_t);
+    }
+
+private:
+    /** the number of keys per word of a filter of the size of its relation, i.e., 16 bits per key */
+    static constexpr size_t KEYS_PER_WORD = 4;
+
+    /** Hash the key columns of a tuple */
+    template <typename Tuple>
+    uint64_t hash(const Tuple& tuple) const {
+        uint64_t h = 0;
+        for (size_t i = 0; (columns >> i) != 0; i++) {
+            if ((columns >> i) & 1) {
+                h = mix(h + static_cast<uint64_t>(tuple[i]) + 0x9e3779b97f4a7c15ULL);
+            }
+        }
+        return h;
+    }
+
+    /** The finaliser of splitmix64, spreading the bits of a value over the whole word */
+    static uint64_t mix(uint64_t h) {
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+    /** The bits of a word set by a hash, taken from its lower half */
+    static uint64_t bits(uint64_t h) {
+        return (1ULL << (h & 63)) | (1ULL << ((h >> 6) & 63)) | (1ULL << ((h >> 12) & 63)) |
+               (1ULL << ((h >> 18) & 63));
+    }
+
+    /** the columns forming the keys */
+    SearchSignature columns;
+
+    /** the words of the filter, a power of two of them */
+    std::vector<uint64_t> words;
+
+    /** the mask selecting a word from a hash */
+    uint64_t mask = 0;
+};
+
+}  // end of namespace souffle
@@ -20,21 +20,28 @@
  *
  * Multiple insert operations can be be conducted concurrently on trie
  * structures. So can read-only operations. However, inserts and read
- * operations may not be conducted at the same time.
+ * operations may not be conducted at the same time. For heavily parallel
+ * insertions, a TrieInsertBuffer collects the insertions of a single thread
+ * in a private trie and transfers them to the shared trie in one step.
  *
  ***********************************************************************/
 
 #pragma once
 
 #include "CompiledTuple.h"
+#include "ParallelUtils.h"
 #include "RamTypes.h"
 #include "Util.h"
 
 #include <atomic>
 #include <bitset>
+#include <cstdlib>
 #include <cstring>
 #include <iterator>
+#include <memory>
+#include <new>
 #include <utility>
+#include <vector>
 
 namespace souffle {
 
@@ -77,6 +84,122 @@ struct default_merge {
     }
 };
 
+/**
+ * A pool of memory blocks of a fixed size, shared by all sparse arrays
+ * requesting blocks of this size. Blocks are cut from larger slabs and
+ * recycled through a free list, saving the bookkeeping overhead of the
+ * general purpose allocator on the many small nodes of sparse arrays.
+ * Slabs are kept for the lifetime of the process.
+ */
+template <std::size_t Size>
+class block_pool {
+    // the recycled blocks, linked through their first word
+    struct free_block {
+        free_block* next;
+    };
+
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    // blocks up to the size of a cache line are rounded to a power of two, such that
+    // none of them spans two cache lines; larger blocks are kept pointer-aligned
+    static constexpr std::size_t roundUp(std::size_t size, std::size_t pow2 = sizeof(free_block)) {
+        return (size <= pow2) ? pow2
+                              : (pow2 < CACHE_LINE) ? roundUp(size, pow2 * 2)
+                                                    : (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    }
+
+    static constexpr std::size_t SLAB_SIZE = 1 << 16;
+
+#ifdef _OPENMP
+    static constexpr int NUM_CURSORS = 64;
+#else
+    static constexpr int NUM_CURSORS = 1;
+#endif
+
+    // a bump-pointer into the current slab of a thread, padded to a cache line
+    struct cursor {
+        AdaptiveLock lock;
+        char* next = nullptr;
+        char* end = nullptr;
+        char padding[64 - sizeof(AdaptiveLock) - 2 * sizeof(char*)];
+    };
+
+    cursor cursors[NUM_CURSORS];
+
+    // the list of recycled blocks
+    std::atomic<free_block*> free_list{nullptr};
+    AdaptiveLock free_lock;
+
+    block_pool() = default;
+
+public:
+    block_pool(const block_pool&) = delete;
+    block_pool& operator=(const block_pool&) = delete;
+
+    /**
+     * Obtains the pool of this block size. It is never destroyed, such that
+     * sparse arrays with static storage duration may safely outlive it.
+     */
+    static block_pool& instance() {
+        static block_pool* pool = new block_pool();
+        return *pool;
+    }
+
+    // the number of bytes occupied by each block
+    static constexpr std::size_t BLOCK_SIZE = roundUp(Size);
+
+    void* allocate() {
+        // prefer recycled blocks
+        if (free_list.load(std::memory_order_relaxed) != nullptr) {
+            free_lock.lock();
+            free_block* res = free_list.load(std::memory_order_relaxed);
+            if (res != nullptr) {
+                free_list.store(res->next, std::memory_order_relaxed);
+            }
+            free_lock.unlock();
+            if (res != nullptr) {
+                return res;
+            }
+        }
+
+        // cut a block from the slab of this thread
+        cursor& cur = cursors[getCursor()];
+        cur.lock.lock();
+        if (static_cast<std::size_t>(cur.end - cur.next) < BLOCK_SIZE) {
+            auto* slab = static_cast<char*>(std::malloc(SLAB_SIZE + CACHE_LINE));
+            if (slab == nullptr) {
+                cur.lock.unlock();
+                throw std::bad_alloc();
+            }
+            // start the slab at a cache line boundary
+            cur.next = slab + (CACHE_LINE - reinterpret_cast<uintptr_t>(slab) % CACHE_LINE);
+            cur.end = cur.next + SLAB_SIZE;
+        }
+        void* res = cur.next;
+        cur.next += BLOCK_SIZE;
+        cur.lock.unlock();
+        return res;
+    }
+
+    void deallocate(void* ptr) {
+        auto* block = static_cast<free_block*>(ptr);
+        free_lock.lock();
+        block->next = free_list.load(std::memory_order_relaxed);
+        free_list.store(block, std::memory_order_relaxed);
+        free_lock.unlock();
+    }
+
+private:
+    static int getCursor() {
+#ifdef _OPENMP
+        // threads of nested teams may share numbers with others, the lock of the cursor keeps this safe
+        return omp_get_thread_num() % NUM_CURSORS;
+#else
+        return 0;
+#endif
+    }
+};
+
 }  // end namespace detail
 
 /**
@@ -92,7 +215,9 @@ struct default_merge {
  * to cover all non-null / non-default values stored in the array is
  * maintained. Furthermore, several levels of nodes are aggreated in a
  * B-tree like fashion to inprove cache utilization and reduce the number
- * of steps required for lookup and insert operations.
+ * of steps required for lookup and insert operations. Nodes only reserve
+ * space for a few cells up-front and obtain the full array of cells once
+ * those are exhausted, to keep sparsely populated levels small.
  *
  * @tparam T the type of the stored elements
  * @tparam BITS the number of bits consumed per node-level
@@ -116,6 +241,12 @@ class SparseArray {
     static const int NUM_CELLS = 1 << BIT_PER_STEP;
     static const key_type INDEX_MASK = NUM_CELLS - 1;
 
+    // the number of cells stored within a node before the full array is allocated
+    static const int NUM_SLOTS = 4;
+
+    // the bits of the key of a slot, all keys are packed into a single word
+    static const int SLOT_KEY_BITS = 16;
+
 public:
     // the type utilized for indexing contained elements
     using index_type = key_type;
@@ -128,6 +259,7 @@ public:
 
 private:
     struct Node;
+    struct CellArray;
 
     /**
      * The value stored in a single cell of a inner
@@ -148,12 +280,33 @@ private:
     };
 
     /**
-     * The node type of the internally maintained tree.
+     * The node type of the internally maintained tree. The first cells requested
+     * within a node are stored in slots along with their index, all others in an
+     * array of cells allocated once all slots are in use. Cells never move, such
+     * that references to them remain valid while other threads are inserting.
      */
     struct Node {
         // a pointer to the parent node (for efficient iteration)
         const Node* parent;
+        // the indices of the cells stored in the slots, offset by one (0 = unused slot)
+        std::atomic<uint64_t> keys;
         // the pointers to the child nodes (inner nodes) or the stored values (leaf nodes)
+        Cell slot[NUM_SLOTS];
+        // the cells of all indices not covered by a slot
+        std::atomic<CellArray*> cells;
+    };
+
+    /**
+     * The full array of cells of a node. Parent nodes reference a child having
+     * such an array through a tagged pointer to the array instead of the node,
+     * such that lookups in densely populated levels only need a single step.
+     */
+    struct CellArray {
+        // the node owning this array
+        Node* node;
+        // the indices held by the slots of the owning node (if there are at most 64 cells)
+        uint64_t inSlots;
+        // the cells, indexed by their position
         Cell cell[NUM_CELLS];
     };
 
@@ -301,13 +454,16 @@ private:
         if (!node) return 0;
 
         // add size of current node
-        std::size_t res = sizeof(Node);
+        std::size_t res = node_pool::BLOCK_SIZE;
+        if (node->cells.load(std::memory_order_relaxed)) {
+            res += cells_pool::BLOCK_SIZE;
+        }
 
         // sum up memory usage of child nodes
         if (level > 0) {
-            for (int i = 0; i < NUM_CELLS; i++) {
-                res += getMemoryUsage(node->cell[i].ptr, level - 1);
-            }
+            forEachCell(node, [&](index_type, const Cell& cell) {
+                res += getMemoryUsage(getNode(cell.ptr), level - 1);
+            });
         }
 
         // done
@@ -349,6 +505,7 @@ public:
      */
     struct op_context {
         index_type lastIndex{0};
+        // the (potentially tagged) reference to the last leaf node accessed
         Node* lastNode{nullptr};
         op_context() = default;
     };
@@ -558,7 +715,7 @@ private:
         // check context
         if (ctxt.lastNode && (ctxt.lastIndex == (i & ~INDEX_MASK))) {
             // return reference to referenced
-            return ctxt.lastNode->cell[i & INDEX_MASK];
+            return getCell(getNode(ctxt.lastNode), i & INDEX_MASK);
         }
 
         // get snapshot of root
@@ -589,11 +746,11 @@ private:
                 }
 
                 // return reference to proper cell
-                return info.root->cell[i & INDEX_MASK];
+                return getCell(info.root, i & INDEX_MASK);
             }
 
             // somebody else was faster => use standard insertion procedure
-            delete info.root;
+            freeNode(info.root);
 
             // retrieve new root info
             info = getRootInfo();
@@ -626,9 +783,17 @@ private:
             --level;
 
             // check next node
-            std::atomic<Node*>& aNext = node->cell[x].aptr;
+            std::atomic<Node*>& aNext = getCell(node, x).aptr;
             Node* next = aNext;
-            if (!next) {
+            if (isArray(next)) {
+                next = getNode(next);
+            } else if (next) {
+                // reference the array of cells of the child directly once it got one
+                if (CellArray* cells = next->cells.load(std::memory_order_acquire)) {
+                    Node* cur = next;
+                    aNext.compare_exchange_strong(cur, toRef(cells));
+                }
+            } else {
                 // create new sub-tree
                 Node* newNext = newNode();
                 newNext->parent = node;
@@ -636,7 +801,7 @@ private:
                 // try to update next
                 if (!aNext.compare_exchange_strong(next, newNext)) {
                     // some other thread was faster => use updated next
-                    delete newNext;
+                    freeNode(newNext);
                 } else {
                     // the locally created next is the new next
                     next = newNext;
@@ -675,7 +840,7 @@ private:
         ctxt.lastNode = node;
 
         // return reference to cell
-        return node->cell[i & INDEX_MASK];
+        return getCell(node, i & INDEX_MASK);
     }
 
 public:
@@ -729,11 +894,11 @@ public:
 
         // check context
         if (ctxt.lastNode && ctxt.lastIndex == (i & ~INDEX_MASK)) {
-            return ctxt.lastNode->cell[i & INDEX_MASK].value;
+            return getValue(ctxt.lastNode, i & INDEX_MASK);
         }
 
         // navigate to value
-        Node* node = unsynced.root;
+        const Node* node = unsynced.root;
         unsigned level = unsynced.levels;
         while (level != 0) {
             // get X coordinate
@@ -743,7 +908,7 @@ public:
             --level;
 
             // check next node
-            Node* next = node->cell[x].ptr;
+            const Node* next = getChildRef(node, x);
 
             // check next step
             if (!next) return detail::default_factory<value_type>()();
@@ -754,13 +919,22 @@ public:
 
         // remember context
         ctxt.lastIndex = (i & ~INDEX_MASK);
-        ctxt.lastNode = node;
+        ctxt.lastNode = const_cast<Node*>(node);
 
         // return reference to cell
-        return node->cell[i & INDEX_MASK].value;
+        return getValue(node, i & INDEX_MASK);
     }
 
 private:
+    /**
+     * Obtains the indices of all cells created within the given node.
+     */
+    static std::vector<index_type> getCellIndices(const Node* node) {
+        std::vector<index_type> res;
+        forEachCell(node, [&](index_type i, const Cell&) { res.push_back(i); });
+        return res;
+    }
+
     /**
      * A static operation utilized internally for merging sub-trees recursively.
      *
@@ -768,61 +942,141 @@ private:
      * @param trg a reference to the pointer the cloned node should be stored to
      * @param src the node to be cloned
      * @param levels the height of the cloned node
+     * @param parallel whether the children of the node may be merged by a team of threads
      */
-    static void merge(const Node* parent, Node*& trg, const Node* src, int levels) {
+    static void merge(const Node* parent, Node*& trg, const Node* src, int levels, bool parallel = false) {
         // if other side is null => done
         if (!src) return;
+        src = getNode(src);
 
         // if the trg sub-tree is empty, clone the corresponding branch
         if (trg == nullptr) {
             trg = clone(src, levels);
-            if (trg) trg->parent = parent;
-            return;  // done
+            trg->parent = parent;
+        } else {
+            // otherwise merge recursively
+            Node* node = getNode(trg);
+
+            // the children are merged independently, cells of a node may be created concurrently
+            const std::vector<index_type> indices = getCellIndices(src);
+            const int numIndices = indices.size();
+            if (levels == 0) {
+                // the leaf-node step (merging with a default value retains the original value)
+                merge_op merg;
+#pragma omp parallel for schedule(dynamic) if (parallel && numIndices > 1 && !omp_in_parallel())
+                for (int k = 0; k < numIndices; ++k) {
+                    const Cell& cell = *findCell(src, indices[k]);
+                    if (cell.value != value_type()) {
+                        Cell& cur = getCell(node, indices[k]);
+                        cur.value = merg(cur.value, cell.value);
+                    }
+                }
+            } else {
+                // the recursive step
+#pragma omp parallel for schedule(dynamic) if (parallel && numIndices > 1 && !omp_in_parallel())
+                for (int k = 0; k < numIndices; ++k) {
+                    const Cell& cell = *findCell(src, indices[k]);
+                    if (cell.ptr) {
+                        merge(node, getCell(node, indices[k]).ptr, cell.ptr, levels - 1);
+                    }
+                }
+            }
+            trg = node;
         }
 
-        // otherwise merge recursively
+        // the root is always referenced directly
+        if (parent) trg = getRef(trg);
+    }
+
+    /**
+     * A static operation utilized internally for moving sub-trees into another tree
+     * recursively. Sub-trees absent in the target are adopted, values present in both
+     * trees are merged. All values of the source sub-tree are reset, such that the
+     * nodes left in it may be freed without affecting the target.
+     *
+     * @param parent the parent node of the current merge operation
+     * @param trg a reference to the pointer the adopted node should be stored to
+     * @param src a reference to the node to be moved, reset if it is adopted
+     * @param levels the height of the moved node
+     * @param parallel whether the children of the node may be moved by a team of threads
+     */
+    static void absorb(const Node* parent, Node*& trg, Node*& src, int levels, bool parallel = false) {
+        // if other side is null => done
+        if (!src) return;
+        Node* from = getNode(src);
 
-        // the leaf-node step
-        if (levels == 0) {
-            merge_op merg;
-            for (int i = 0; i < NUM_CELLS; ++i) {
-                trg->cell[i].value = merg(trg->cell[i].value, src->cell[i].value);
+        // if the trg sub-tree is empty, adopt the corresponding branch
+        if (trg == nullptr) {
+            trg = from;
+            trg->parent = parent;
+            src = nullptr;
+        } else {
+            Node* node = getNode(trg);
+            const std::vector<index_type> indices = getCellIndices(from);
+            const int numIndices = indices.size();
+            if (levels == 0) {
+                // the leaf-node step, taking over the values of the source
+                merge_op merg;
+#pragma omp parallel for schedule(dynamic) if (parallel && numIndices > 1 && !omp_in_parallel())
+                for (int k = 0; k < numIndices; ++k) {
+                    Cell& cell = getCell(from, indices[k]);
+                    if (cell.value != value_type()) {
+                        absorbValue(merg, getCell(node, indices[k]).value, cell.value, 0);
+                    }
+                }
+            } else {
+                // the recursive step
+#pragma omp parallel for schedule(dynamic) if (parallel && numIndices > 1 && !omp_in_parallel())
+                for (int k = 0; k < numIndices; ++k) {
+                    Cell& cell = getCell(from, indices[k]);
+                    if (cell.ptr) {
+                        absorb(node, getCell(node, indices[k]).ptr, cell.ptr, levels - 1);
+                    }
+                }
             }
-            return;
+            trg = node;
         }
 
-        // the recursive step
-        for (int i = 0; i < NUM_CELLS; ++i) {
-            merge(trg, trg->cell[i].ptr, src->cell[i].ptr, levels - 1);
-        }
+        // the root is always referenced directly
+        if (parent) trg = getRef(trg);
     }
 
-public:
     /**
-     * Adds all the values stored in the given array to this array.
+     * Moves the value b into the value a, for merge operations able to take over values.
      */
-    void addAll(const SparseArray& other) {
-        // skip if other is empty
-        if (other.empty()) {
-            return;
-        }
+    template <typename M>
+    static auto absorbValue(M& merg, value_type& a, value_type& b, int)
+            -> decltype(merg.absorb(a, b), void()) {
+        merg.absorb(a, b);
+    }
 
-        // special case: emptiness
-        if (empty()) {
-            // use assignment operator
-            *this = other;
-            return;
-        }
+    /**
+     * Merges the value b into the value a and resets b, for all other merge operations.
+     */
+    template <typename M>
+    static void absorbValue(M& merg, value_type& a, value_type& b, long) {
+        a = merg(a, b);
+        b = value_type();
+    }
 
+    /**
+     * Raises the level of this tree until it covers the tree of the given array and
+     * obtains the node of this tree at the position of the root of the other tree,
+     * creating it if necessary.
+     *
+     * @param other the array whose root is to be located in this tree
+     * @param level set to the level of the obtained node
+     */
+    Node** getEquivalentNode(const SparseArray& other, int& level) {
         // adjust levels
         while (unsynced.levels < other.unsynced.levels || !inBoundaries(other.unsynced.offset)) {
             raiseLevel();
         }
 
         // navigate to root node equivalent of the other node in this tree
-        auto level = unsynced.levels;
+        level = unsynced.levels;
         Node** node = &unsynced.root;
-        while (level > other.unsynced.levels) {
+        while (level > (int)other.unsynced.levels) {
             // get X coordinate
             auto x = getIndex(other.unsynced.offset, level);
 
@@ -830,25 +1084,88 @@ public:
             --level;
 
             // check next node
-            Node*& next = (*node)->cell[x].ptr;
+            Node* cur = getNode(*node);
+            Node*& next = getCell(cur, x).ptr;
             if (!next) {
                 // create new sub-tree
                 next = newNode();
-                next->parent = *node;
+                next->parent = cur;
             }
 
             // continue one level below
             node = &next;
         }
+        return node;
+    }
+
+public:
+    /**
+     * Adds all the values stored in the given array to this array.
+     *
+     * @param other the array whose values are to be added
+     * @param parallel whether the top-level branches may be merged by a team of threads,
+     *              which is only formed outside of parallel regions
+     */
+    void addAll(const SparseArray& other, bool parallel = false) {
+        // skip if other is empty
+        if (other.empty()) {
+            return;
+        }
+
+        // special case: emptiness
+        if (empty()) {
+            // use assignment operator
+            *this = other;
+            return;
+        }
+
+        // merge sub-branches from the root node equivalent of the other node in this tree
+        int level;
+        Node** node = getEquivalentNode(other, level);
+        merge(getNode(*node)->parent, *node, other.unsynced.root, level, parallel);
+
+        // update first
+        if (unsynced.firstOffset > other.unsynced.firstOffset) {
+            unsynced.first = findFirst(getNode(*node), level);
+            unsynced.firstOffset = other.unsynced.firstOffset;
+        }
+    }
+
+    /**
+     * Moves all the values stored in the given array to this array, leaving the
+     * given array empty. Sub-trees not present in this array are taken over as a
+     * whole instead of being cloned, such that the cost is proportional to the
+     * overlap of both arrays rather than the number of values moved.
+     *
+     * @param other the array whose values are to be moved
+     * @param parallel whether the top-level branches may be moved by a team of threads,
+     *              which is only formed outside of parallel regions
+     */
+    void absorb(SparseArray& other, bool parallel = false) {
+        // skip if other is empty or this array
+        if (this == &other || other.empty()) {
+            return;
+        }
 
-        // merge sub-branches from here
-        merge((*node)->parent, *node, other.unsynced.root, level);
+        // special case: emptiness
+        if (empty()) {
+            *this = std::move(other);
+            return;
+        }
+
+        // move sub-branches from the root node equivalent of the other node in this tree
+        int level;
+        Node** node = getEquivalentNode(other, level);
+        absorb(getNode(*node)->parent, *node, other.unsynced.root, level, parallel);
 
         // update first
         if (unsynced.firstOffset > other.unsynced.firstOffset) {
-            unsynced.first = findFirst(*node, level);
+            unsynced.first = findFirst(getNode(*node), level);
             unsynced.firstOffset = other.unsynced.firstOffset;
         }
+
+        // the nodes left in the other array only hold default values
+        other.clear();
     }
 
     // ---------------------------------------------------------------------
@@ -878,10 +1195,9 @@ public:
             if (!first) return;
 
             // load the value
-            if (first->cell[0].value == value_type()) {
+            value.second = getValue(first, 0);
+            if (value.second == value_type()) {
                 ++(*this);  // walk to first element
-            } else {
-                value.second = first->cell[0].value;
             }
         }
 
@@ -919,15 +1235,13 @@ public:
             index_type x = value.first & INDEX_MASK;
 
             // go to next non-empty value in current node
-            do {
-                x++;
-            } while (x < NUM_CELLS && node->cell[x].value == value_type());
+            x = nextCell(node, x + 1, true);
 
             // check whether one has been found
             if (x < NUM_CELLS) {
                 // update value and be done
                 value.first = (value.first & ~INDEX_MASK) | x;
-                value.second = node->cell[x].value;
+                value.second = getValue(node, x);
                 return *this;  // done
             }
 
@@ -941,15 +1255,12 @@ public:
 
             while (level > 0 && node) {
                 // search for next child
-                while (x < NUM_CELLS) {
-                    if (node->cell[x].ptr) break;
-                    x++;
-                }
+                x = nextCell(node, x, false);
 
                 // pick next step
                 if (x < NUM_CELLS) {
                     // going down
-                    node = node->cell[x].ptr;
+                    node = getChild(node, x);
                     value.first &= getLevelMask(level + 1);
                     value.first |= x << (BIT_PER_STEP * level);
                     level--;
@@ -969,14 +1280,11 @@ public:
             if (!node) return *this;
 
             // search the first value in this node
-            x = 0;
-            while (node->cell[x].value == value_type()) {
-                x++;
-            }
+            x = nextCell(node, 0, true);
 
             // update value
             value.first |= x;
-            value.second = node->cell[x].value;
+            value.second = getValue(node, x);
 
             // done
             return *this;
@@ -1041,16 +1349,16 @@ public:
             Node* node = ctxt.lastNode;
 
             // check whether there is a proper entry
-            value_type value = node->cell[i & INDEX_MASK].value;
+            value_type value = getValue(node, i & INDEX_MASK);
             if (value == 0) {
                 return end();
             }
             // return iterator pointing to value
-            return iterator(node, std::make_pair(i, value));
+            return iterator(getNode(node), std::make_pair(i, value));
         }
 
         // navigate to value
-        Node* node = unsynced.root;
+        const Node* node = unsynced.root;
         unsigned level = unsynced.levels;
         while (level != 0) {
             // get X coordinate
@@ -1060,7 +1368,7 @@ public:
             --level;
 
             // check next node
-            Node* next = node->cell[x].ptr;
+            const Node* next = getChildRef(node, x);
 
             // check next step
             if (!next) return end();
@@ -1070,17 +1378,17 @@ public:
         }
 
         // register in context
-        ctxt.lastNode = node;
+        ctxt.lastNode = const_cast<Node*>(node);
         ctxt.lastIndex = (i & ~INDEX_MASK);
 
         // check whether there is a proper entry
-        value_type value = node->cell[i & INDEX_MASK].value;
+        value_type value = getValue(node, i & INDEX_MASK);
         if (value == 0) {
             return end();
         }
 
         // return iterator pointing to cell
-        return iterator(node, std::make_pair(i, value));
+        return iterator(getNode(node), std::make_pair(i, value));
     }
 
     /**
@@ -1110,11 +1418,12 @@ public:
             // get X coordinate
             auto x = getIndex(i, level);
 
-            // check next node
-            Node* next = node->cell[x].ptr;
+            // check next node, or value on the leaf level
+            const Cell* cell = findCell(node, x);
+            bool present = cell && ((level == 0) ? cell->value != value_type() : cell->ptr != nullptr);
 
             // check next step
-            if (!next) {
+            if (!present) {
                 if (x == NUM_CELLS - 1) {
                     ++level;
                     node = const_cast<Node*>(node->parent);
@@ -1130,14 +1439,14 @@ public:
             } else {
                 if (level == 0) {
                     // found boundary
-                    return iterator(node, std::make_pair(i, node->cell[x].value));
+                    return iterator(node, std::make_pair(i, cell->value));
                 }
 
                 // decrease level counter
                 --level;
 
                 // continue one level below
-                node = next;
+                node = getNode(cell->ptr);
             }
         }
     }
@@ -1156,15 +1465,15 @@ private:
 
         if (level == 0) {
             for (int i = 0; i < NUM_CELLS; i++) {
-                if (detailed || node.cell[i].value != value_type()) {
-                    out << times("\t", indent + 1) << i << ": [" << (offset + i) << "] " << node.cell[i].value
+                if (detailed || getValue(&node, i) != value_type()) {
+                    out << times("\t", indent + 1) << i << ": [" << (offset + i) << "] " << getValue(&node, i)
                         << "\n";
                 }
             }
         } else {
             for (int i = 0; i < NUM_CELLS; i++) {
-                if (node.cell[i].ptr) {
-                    dump(detailed, out, *node.cell[i].ptr, level - 1,
+                if (const Node* child = getChild(&node, i)) {
+                    dump(detailed, out, *child, level - 1,
                             offset + (i * (index_type(1) << (level * BIT_PER_STEP))), indent + 1);
                 } else if (detailed) {
                     auto low = offset + (i * (1 << (level * BIT_PER_STEP)));
@@ -1197,26 +1506,229 @@ private:
     //                                 Utilities
     // --------------------------------------------------------------------------
 
+    using node_pool = detail::block_pool<sizeof(Node)>;
+    using cells_pool = detail::block_pool<sizeof(CellArray)>;
+
+    static_assert(NUM_CELLS < (1 << SLOT_KEY_BITS), "Slot keys can not address all cells");
+    static_assert(NUM_SLOTS * SLOT_KEY_BITS == 64, "Slot keys have to fill a single word");
+
     /**
      * Creates new nodes and initializes them with 0.
      */
     static Node* newNode() {
-        auto* res = new Node();
-        std::memset(res->cell, 0, sizeof(Cell) * NUM_CELLS);
+        return new (node_pool::instance().allocate()) Node();
+    }
+
+    /**
+     * Destroys a single node, not including its sub-nodes.
+     */
+    static void freeNode(Node* node) {
+        if (CellArray* cells = node->cells.load(std::memory_order_relaxed)) {
+            cells_pool::instance().deallocate(cells);
+        }
+        node_pool::instance().deallocate(node);
+    }
+
+    /**
+     * Tests whether the given reference to a node is a tagged reference to its array of cells.
+     */
+    static bool isArray(const Node* ref) {
+        return reinterpret_cast<uintptr_t>(ref) & 1;
+    }
+
+    /**
+     * Obtains the array of cells of the given tagged reference.
+     */
+    static CellArray* toArray(const Node* ref) {
+        return reinterpret_cast<CellArray*>(reinterpret_cast<uintptr_t>(ref) & ~uintptr_t(1));
+    }
+
+    /**
+     * Obtains the tagged reference of the given array of cells.
+     */
+    static Node* toRef(CellArray* cells) {
+        return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t>(cells) | 1);
+    }
+
+    /**
+     * Obtains the node referenced by the given, potentially tagged, reference.
+     */
+    static Node* getNode(const Node* ref) {
+        return (isArray(ref)) ? toArray(ref)->node : const_cast<Node*>(ref);
+    }
+
+    /**
+     * Obtains the preferred reference to the given node to be stored in its parent.
+     */
+    static Node* getRef(Node* node) {
+        CellArray* cells = node->cells.load(std::memory_order_relaxed);
+        return (cells) ? toRef(cells) : node;
+    }
+
+    /**
+     * Obtains the slot holding the given key within the given packed keys or -1 if
+     * there is none. All keys of a node are distinct, such that the first lane
+     * flagged by the zero-lane test is an exact match.
+     */
+    static int findSlot(uint64_t keys, uint64_t key) {
+        const uint64_t ones = 0x0001000100010001ull;
+        uint64_t x = keys ^ (key * ones);
+        uint64_t match = (x - ones) & ~x & (ones << (SLOT_KEY_BITS - 1));
+        return (match) ? __builtin_ctzll(match) / SLOT_KEY_BITS : -1;
+    }
+
+    /**
+     * Obtains the key stored in the given slot of the given packed keys.
+     */
+    static index_type getSlotKey(uint64_t keys, int k) {
+        return (keys >> (k * SLOT_KEY_BITS)) & ((1 << SLOT_KEY_BITS) - 1);
+    }
+
+    /**
+     * Tests whether the cell of the given index might be held by a slot of the
+     * node owning the given array of cells.
+     */
+    static bool mayBeInSlot(const CellArray* cells, index_type i) {
+        return NUM_CELLS > 64 || ((cells->inSlots >> i) & 1);
+    }
+
+    /**
+     * Obtains the cell of the given index within the given node, creating it if
+     * necessary. This operation may be conducted concurrently.
+     */
+    static Cell& getCell(Node* node, index_type i) {
+        // search the slots, claiming the first free one if the index is not present
+        const uint64_t key = i + 1;
+        uint64_t keys = node->keys.load(std::memory_order_acquire);
+        while (true) {
+            int k = findSlot(keys, key);
+            if (k >= 0) return node->slot[k];
+
+            // slots are claimed in order, the first empty one is the next to use
+            int used = findSlot(keys, 0);
+            if (used < 0) break;
+            if (node->keys.compare_exchange_weak(keys, keys | (key << (used * SLOT_KEY_BITS)))) {
+                return node->slot[used];
+            }
+        }
+
+        // all slots are in use => use the full array of cells
+        CellArray* cells = node->cells.load(std::memory_order_acquire);
+        if (!cells) {
+            auto* fresh = static_cast<CellArray*>(cells_pool::instance().allocate());
+            std::memset(static_cast<void*>(fresh), 0, sizeof(CellArray));
+            fresh->node = node;
+            for (int k = 0; k < NUM_SLOTS && NUM_CELLS <= 64; ++k) {
+                fresh->inSlots |= uint64_t(1) << (getSlotKey(keys, k) - 1);
+            }
+            if (node->cells.compare_exchange_strong(cells, fresh)) {
+                cells = fresh;
+            } else {
+                // some other thread was faster => use its array
+                cells_pool::instance().deallocate(fresh);
+            }
+        }
+        return cells->cell[i];
+    }
+
+    /**
+     * Obtains the cell of the given index within the node of the given reference
+     * or null if it has not been created.
+     */
+    static const Cell* findCell(const Node* ref, index_type i) {
+        const CellArray* cells =
+                (isArray(ref)) ? toArray(ref) : ref->cells.load(std::memory_order_relaxed);
+        if (cells && !mayBeInSlot(cells, i)) return &cells->cell[i];
+
+        const Node* node = (cells) ? cells->node : ref;
+        int k = findSlot(node->keys.load(std::memory_order_relaxed), i + 1);
+        if (k >= 0) return &node->slot[k];
+        return (cells) ? &cells->cell[i] : nullptr;
+    }
+
+    /**
+     * Obtains the reference to the child of an inner node at the given index or
+     * null if there is none.
+     */
+    static const Node* getChildRef(const Node* ref, index_type i) {
+        // present cells of an array are never held by a slot
+        if (isArray(ref) && toArray(ref)->cell[i].ptr) return toArray(ref)->cell[i].ptr;
+        const Cell* cell = findCell(ref, i);
+        return (cell) ? cell->ptr : nullptr;
+    }
+
+    /**
+     * Obtains the child of an inner node at the given index or null if there is none.
+     */
+    static Node* getChild(const Node* ref, index_type i) {
+        const Cell* cell = findCell(ref, i);
+        return (cell && cell->ptr) ? getNode(cell->ptr) : nullptr;
+    }
+
+    /**
+     * Obtains the value of a leaf node at the given index.
+     */
+    static value_type getValue(const Node* ref, index_type i) {
+        // present cells of an array are never held by a slot
+        if (isArray(ref) && toArray(ref)->cell[i].value != value_type()) return toArray(ref)->cell[i].value;
+        const Cell* cell = findCell(ref, i);
+        return (cell) ? cell->value : detail::default_factory<value_type>()();
+    }
+
+    /**
+     * Obtains the smallest index >= i of a non-empty cell within the given node,
+     * or NUM_CELLS if there is none.
+     */
+    static index_type nextCell(const Node* node, index_type i, bool leaf) {
+        auto isEmpty = [&](const Cell& cell) { return (leaf) ? cell.value == value_type() : !cell.ptr; };
+
+        index_type res = NUM_CELLS;
+        uint64_t keys = node->keys.load(std::memory_order_relaxed);
+        for (int k = 0; k < NUM_SLOTS; ++k) {
+            index_type key = getSlotKey(keys, k);
+            if (key == 0) return res;
+            if (key - 1 >= i && key - 1 < res && !isEmpty(node->slot[k])) {
+                res = key - 1;
+            }
+        }
+
+        if (const CellArray* cells = node->cells.load(std::memory_order_relaxed)) {
+            for (index_type x = i; x < res; ++x) {
+                if (!isEmpty(cells->cell[x])) return x;
+            }
+        }
         return res;
     }
 
+    /**
+     * Applies the given operation to the index and content of every cell created
+     * within the given node, in no particular order.
+     */
+    template <typename Op>
+    static void forEachCell(const Node* node, const Op& op) {
+        uint64_t keys = node->keys.load(std::memory_order_relaxed);
+        for (int k = 0; k < NUM_SLOTS; ++k) {
+            index_type key = getSlotKey(keys, k);
+            if (key == 0) return;
+            op(key - 1, node->slot[k]);
+        }
+        if (const CellArray* cells = node->cells.load(std::memory_order_relaxed)) {
+            // cells held by slots remain empty in the array
+            for (index_type i = 0; i < NUM_CELLS; ++i) {
+                op(i, cells->cell[i]);
+            }
+        }
+    }
+
     /**
      * Destroys a node and all its sub-nodes recursively.
      */
     static void freeNodes(Node* node, int level) {
         if (!node) return;
         if (level != 0) {
-            for (int i = 0; i < NUM_CELLS; i++) {
-                freeNodes(node->cell[i].ptr, level - 1);
-            }
+            forEachCell(node, [&](index_type, const Cell& cell) { freeNodes(getNode(cell.ptr), level - 1); });
         }
-        delete node;
+        freeNode(node);
     }
 
     /**
@@ -1236,23 +1748,27 @@ private:
         if (!node) return nullptr;
 
         // create a clone
-        auto* res = new Node();
+        auto* res = newNode();
 
         // handle leaf level
         if (level == 0) {
             copy_op copy;
-            for (int i = 0; i < NUM_CELLS; i++) {
-                res->cell[i].value = copy(node->cell[i].value);
-            }
+            forEachCell(node, [&](index_type i, const Cell& cell) {
+                if (cell.value != value_type()) {
+                    getCell(res, i).value = copy(cell.value);
+                }
+            });
             return res;
         }
 
         // for inner nodes clone each child
-        for (int i = 0; i < NUM_CELLS; i++) {
-            auto cur = clone(node->cell[i].ptr, level - 1);
-            if (cur) cur->parent = res;
-            res->cell[i].ptr = cur;
-        }
+        forEachCell(node, [&](index_type i, const Cell& cell) {
+            if (cell.ptr) {
+                auto cur = clone(getNode(cell.ptr), level - 1);
+                cur->parent = res;
+                getCell(res, i).ptr = getRef(cur);
+            }
+        });
 
         // done
         return res;
@@ -1264,17 +1780,10 @@ private:
      */
     static Node* findFirst(Node* node, int level) {
         while (level > 0) {
-            bool found = false;
-            for (int i = 0; i < NUM_CELLS; i++) {
-                Node* cur = node->cell[i].ptr;
-                if (cur) {
-                    node = cur;
-                    --level;
-                    found = true;
-                    break;
-                }
-            }
-            assert(found && "No first node!");
+            auto x = nextCell(node, 0, false);
+            assert(x < NUM_CELLS && "No first node!");
+            node = getChild(node, x);
+            --level;
         }
 
         return node;
@@ -1294,7 +1803,7 @@ private:
 
         // insert existing root as child
         auto x = getIndex(unsynced.offset, unsynced.levels + 1);
-        node->cell[x].ptr = unsynced.root;
+        getCell(node, x).ptr = getRef(unsynced.root);
 
         // swap the root
         unsynced.root->parent = node;
@@ -1321,7 +1830,7 @@ private:
 
         // insert existing root as child
         auto x = getIndex(info.offset, info.levels + 1);
-        newRoot->cell[x].ptr = info.root;
+        getCell(newRoot, x).ptr = getRef(info.root);
 
         // exchange the root in the info struct
         auto oldRoot = info.root;
@@ -1339,7 +1848,7 @@ private:
             oldRoot->parent = info.root;
         } else {
             // throw away temporary new node
-            delete newRoot;
+            freeNode(newRoot);
         }
     }
 
@@ -1483,6 +1992,35 @@ public:
         return !(old & bit);
     }
 
+    /**
+     * Sets the bits addressed by the indices of the given range to 1. Indices
+     * sharing a word are collected and set at once as long as they are adjacent,
+     * as they are in a sorted range. This operation must not run concurrently
+     * with other updates of this bit-map.
+     *
+     * @param a the begin of the range
+     * @param b the end of the range
+     * @param index the function obtaining the index of an element of the range
+     */
+    template <typename Iter, typename Index>
+    void setAll(const Iter& a, const Iter& b, const Index& index) {
+        op_context ctxt;
+        index_type word = 0;
+        value_t bits = 0;
+        for (Iter cur = a; cur != b; ++cur) {
+            index_type i = index(*cur);
+            if (bits && (i >> LEAF_INDEX_WIDTH) != word) {
+                store.get(word, ctxt) |= bits;
+                bits = 0;
+            }
+            word = i >> LEAF_INDEX_WIDTH;
+            bits |= (1ull << (i & LEAF_INDEX_MASK));
+        }
+        if (bits) {
+            store.get(word, ctxt) |= bits;
+        }
+    }
+
     /**
      * Determines the whether the bit addressed by i is set or not.
      */
@@ -1545,6 +2083,17 @@ public:
         store.addAll(other.store);
     }
 
+    /**
+     * Moves all bits set in other into this bit map, leaving other empty.
+     */
+    void absorb(SparseBitMap& other) {
+        // nothing to do if it is a self-assignment
+        if (this == &other) return;
+
+        // move the sparse store
+        store.absorb(other.store);
+    }
+
     // ---------------------------------------------------------------------
     //                           Iterator
     // ---------------------------------------------------------------------
@@ -2139,6 +2688,16 @@ class Trie : public detail::TrieBase<Dim, Trie<Dim>> {
             a->insertAll(*b);
             return a;
         }
+
+        void absorb(nested_trie_type*& a, nested_trie_type*& b) const {
+            if (!a) {
+                a = b;
+            } else {
+                a->absorb(*b);
+                delete b;
+            }
+            b = nullptr;
+        }
     };
 
     // the operation capable of cloning a nested trie
@@ -2376,7 +2935,33 @@ public:
      * @param other the elements to be inserted into this trie
      */
     void insertAll(const Trie& other) {
-        store.addAll(other.store);
+        store.addAll(other.store, true);
+    }
+
+    /**
+     * Moves all elements stored within the given trie into this trie, leaving
+     * the given trie empty. Nested tries only present in the given trie are
+     * taken over instead of being copied.
+     *
+     * @param other the trie whose elements are to be moved into this trie
+     */
+    void absorb(Trie& other) {
+        store.absorb(other.store, true);
+    }
+
+    /**
+     * Inserts the entries of the given range, sorted lexicographically, into this
+     * trie. Instead of inserting them one by one, the levels of the trie are filled
+     * group by group, and the groups of entries sharing their first element are
+     * loaded in parallel. This operation must not run concurrently with other
+     * updates of this trie.
+     *
+     * @param a the begin of the range of sorted entries
+     * @param b the end of the range of sorted entries
+     */
+    template <typename Iter>
+    void load(const Iter& a, const Iter& b) {
+        load_internal<0>(a, b);
     }
 
     /**
@@ -2593,6 +3178,51 @@ private:
         return nextPtr->template insert_internal<I + 1>(tuple, ctxt.nestedCtxt);
     }
 
+    /**
+     * The internally utilized implementation of the load operation, inserting
+     * the sorted entries of the given range into this sub-trie.
+     *
+     * @tparam I the component index associated to this level
+     * @tparam Iter the type of iterator over the sorted entries
+     * @param a the begin of the range of sorted entries
+     * @param b the end of the range of sorted entries
+     */
+    template <unsigned I, typename Iter>
+    void load_internal(const Iter& a, const Iter& b) {
+        // the number of entries worth loading groups in parallel
+        const std::size_t PARALLEL_LOAD_SIZE = 1 << 14;
+
+        // split the range into groups sharing the component of this level, and
+        // obtain the nested trie of each of them
+        std::vector<Iter> starts;
+        std::vector<nested_trie_type*> nested;
+        std::size_t count = 0;
+        op_context ctxt;
+        for (Iter cur = a; cur != b;) {
+            const auto value = (*cur)[I];
+            starts.push_back(cur);
+            do {
+                ++cur;
+                ++count;
+            } while (cur != b && (*cur)[I] == value);
+
+            auto& next = store.get(value, ctxt.local);
+            if (!next) {
+                next = new nested_trie_type();
+            }
+            nested.push_back(next);
+        }
+        starts.push_back(b);
+
+        // fill the nested tries independently of each other
+        const int numGroups = nested.size();
+        const bool parallel = numGroups > 1 && count >= PARALLEL_LOAD_SIZE;
+#pragma omp parallel for schedule(dynamic) if (parallel && !omp_in_parallel())
+        for (int i = 0; i < numGroups; i++) {
+            nested[i]->template load_internal<I + 1>(starts[i], starts[i + 1]);
+        }
+    }
+
     /**
      * An internal implementation of the contains member function determining
      * whether a given tuple is present within this sub-trie or not.
@@ -2716,6 +3346,14 @@ public:
         present = present || other.present;
     }
 
+    /**
+     * Moves all elements of the given trie to this trie.
+     */
+    void absorb(Trie& other) {
+        insertAll(other);
+        other.clear();
+    }
+
     /**
      * Determines whether the given 0-ary tuple is present within this trie.
      */
@@ -2844,6 +3482,15 @@ private:
         return insert(tuple);
     }
 
+    /**
+     * The internal implementation of the load operation on this level
+     * as it is utilized by the Trie class.
+     */
+    template <unsigned I, typename Iter>
+    void load_internal(const Iter& a, const Iter& b) {
+        present = present || a != b;
+    }
+
     /**
      * The internal implementation of the contains operation on this level
      * as it is utilized by the TrieBase class.
@@ -2968,6 +3615,24 @@ public:
         map.addAll(other.map);
     }
 
+    /**
+     * Moves all tuples stored within the given trie into this trie, leaving the
+     * given trie empty.
+     */
+    void absorb(Trie& other) {
+        map.absorb(other.map);
+    }
+
+    /**
+     * Inserts the tuples of the given sorted range into this trie, setting the
+     * bits of neighbouring values at once. This operation must not run
+     * concurrently with other updates of this trie.
+     */
+    template <typename Iter>
+    void load(const Iter& a, const Iter& b) {
+        load_internal<0>(a, b);
+    }
+
     // ---------------------------------------------------------------------
     //                           Iterator
     // ---------------------------------------------------------------------
@@ -3157,6 +3822,23 @@ private:
         return map.set(tuple[I], ctxt);
     }
 
+    /**
+     * The internally utilized implementation of the load operation inserting
+     * the sorted entries of the given range into this sub-trie.
+     *
+     * @tparam I the component index associated to this level
+     * @tparam Iter the type of iterator over the sorted entries
+     * @param a the begin of the range of sorted entries
+     * @param b the end of the range of sorted entries
+     */
+    template <unsigned I, typename Iter>
+    void load_internal(const Iter& a, const Iter& b) {
+        using index_type = typename map_type::index_type;
+        map.setAll(a, b, [](const typename std::iterator_traits<Iter>::value_type& entry) -> index_type {
+            return entry[I];
+        });
+    }
+
     /**
      * An internal implementation of the contains member function determining
      * whether a given tuple is present within this sub-trie or not.
@@ -3173,4 +3855,99 @@ private:
     }
 };
 
+/**
+ * A thread-private buffer for insertions into a shared trie. Concurrent
+ * insertions into the same trie contend on the root and first-node
+ * information of its sparse arrays; a buffer instead collects the
+ * insertions of a single thread in a private trie and merges it into the
+ * shared trie when flushed or destroyed. Buffered elements only become
+ * visible in the target once they have been flushed.
+ *
+ * @tparam TrieType the type of trie to be filled
+ */
+template <typename TrieType>
+class TrieInsertBuffer {
+    using entry_type = typename TrieType::entry_type;
+    using op_context = typename TrieType::op_context;
+
+    // the shared trie to be filled
+    TrieType* target = nullptr;
+
+    // the thread-private trie collecting insertions
+    std::unique_ptr<TrieType> buffer;
+
+    // the operation context of the private trie
+    op_context ctxt;
+
+public:
+    /**
+     * Creates an inactive buffer, not associated to any trie.
+     */
+    TrieInsertBuffer() = default;
+
+    /**
+     * Creates a buffer for insertions into the given trie.
+     */
+    explicit TrieInsertBuffer(TrieType& target) : target(&target), buffer(new TrieType()) {}
+
+    TrieInsertBuffer(const TrieInsertBuffer&) = delete;
+
+    TrieInsertBuffer(TrieInsertBuffer&& other) : target(other.target), buffer(std::move(other.buffer)) {}
+
+    /**
+     * Flushes all buffered elements into the target trie.
+     */
+    ~TrieInsertBuffer() {
+        flush();
+    }
+
+    TrieInsertBuffer& operator=(const TrieInsertBuffer&) = delete;
+
+    TrieInsertBuffer& operator=(TrieInsertBuffer&& other) {
+        if (this == &other) return *this;
+        flush();
+        target = other.target;
+        buffer = std::move(other.buffer);
+        ctxt = op_context();
+        return *this;
+    }
+
+    /**
+     * Determines whether this buffer is associated to a target trie.
+     */
+    bool isActive() const {
+        return buffer != nullptr;
+    }
+
+    /**
+     * Adds an entry to this buffer.
+     *
+     * @param tuple the entry to be added
+     * @return true if the entry hasn't been buffered before, false otherwise
+     */
+    bool insert(const entry_type& tuple) {
+        return buffer->insert(tuple, ctxt);
+    }
+
+    /**
+     * Transfers all buffered entries to the target trie. Flushes of
+     * different threads are serialized.
+     */
+    void flush() {
+        if (!buffer || buffer->empty()) return;
+        {
+            auto lease = getLock().acquire();
+            target->insertAll(*buffer);
+        }
+        buffer->clear();
+        ctxt = op_context();
+    }
+
+private:
+    static Lock& getLock() {
+        static Lock lock;
+        return lock;
+    }
+};
+
 }  // end namespace souffle
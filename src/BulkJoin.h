@@ -0,0 +1,223 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file BulkJoin.h
+ *
+ * A partitioned hash join of two large relations on equal keys, for the
+ * non-recursive strata of synthesised programs.
+ *
+ * Joining two large relations by searching an index of the inner relation
+ * for each tuple of the outer one costs a descent of the index per tuple,
+ * touching memory all over the index. The bulk join instead copies the keys
+ * of both relations into columns partitioned by the hash of the keys, such
+ * that the partitions of the inner relation fit into the caches, and joins
+ * each pair of partitions by a hash table of its own. Partitions are joined
+ * independently of each other, by as many threads as there are.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace souffle {
+
+/**
+ * The join of the tuples of two relations agreeing on their keys.
+ *
+ * The tuples are referenced by the join, hence the relations must not be
+ * modified while it is in use.
+ *
+ * @tparam Key the type of the keys, an array of the values of the key columns
+ * @tparam Outer the type of the tuples of the outer relation
+ * @tparam Inner the type of the tuples of the inner relation
+ */
+template <typename Key, typename Outer, typename Inner>
+class BulkJoin {
+public:
+    /** The number of tuples both relations need to have for the bulk join to pay off over index searches */
+    static constexpr std::size_t MIN_SIZE = std::size_t(1) << 20;
+
+    /**
+     * Partitions the tuples of both relations by their keys.
+     *
+     * @param outer the outer relation, providing size() and partition()
+     * @param inner the inner relation
+     * @param outerKey the key of a tuple of the outer relation
+     * @param innerKey the key of a tuple of the inner relation
+     * @param outerFilter whether a tuple of the outer relation takes part in the join
+     * @param innerFilter whether a tuple of the inner relation takes part in the join
+     */
+    template <typename OuterRel, typename InnerRel, typename OuterKey, typename InnerKey, typename OuterFilter,
+            typename InnerFilter>
+    BulkJoin(const OuterRel& outer, const InnerRel& inner, OuterKey outerKey, InnerKey innerKey,
+            OuterFilter outerFilter, InnerFilter innerFilter) {
+        // partitions of the inner relation of a few thousand tuples fit into the caches
+        std::size_t size = inner.size() / PARTITION_SIZE;
+        shift = 64 - MIN_BITS;
+        while (shift > 64 - MAX_BITS && (std::size_t(1) << (64 - shift)) < size) {
+            shift--;
+        }
+        gather(outer, outerKey, outerFilter, outerSide);
+        gather(inner, innerKey, innerFilter, innerSide);
+    }
+
+    /** Obtains the number of partitions, which may be joined concurrently */
+    std::size_t getNumPartitions() const {
+        return std::size_t(1) << (64 - shift);
+    }
+
+    /**
+     * Calls the given function for each pair of tuples of the given partition agreeing on their keys.
+     */
+    template <typename Emit>
+    void forEachMatch(std::size_t part, Emit emit) const {
+        const std::size_t a = innerSide.offsets[part];
+        const std::size_t n = innerSide.offsets[part + 1] - a;
+        const std::size_t b = outerSide.offsets[part];
+        const std::size_t m = outerSide.offsets[part + 1] - b;
+        if (n == 0 || m == 0) {
+            return;
+        }
+
+        // chain the tuples of the inner partition by their buckets
+        std::size_t mask = 1;
+        while (mask < 2 * n) {
+            mask <<= 1;
+        }
+        mask--;
+        std::vector<std::size_t> heads(mask + 1, NONE);
+        std::vector<std::size_t> next(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            std::size_t& head = heads[hash(innerSide.keys[a + i]) & mask];
+            next[i] = head;
+            head = i;
+        }
+
+        // probe the buckets by the tuples of the outer partition
+        for (std::size_t j = b; j < b + m; ++j) {
+            const Key& key = outerSide.keys[j];
+            for (std::size_t i = heads[hash(key) & mask]; i != NONE; i = next[i]) {
+                if (innerSide.keys[a + i] == key) {
+                    emit(*outerSide.tuples[j], *innerSide.tuples[a + i]);
+                }
+            }
+        }
+    }
+
+    /** Obtains the number of tuples of the outer relation taking part in the join */
+    std::size_t getOuterSize() const {
+        return outerSide.keys.size();
+    }
+
+    /** Obtains the number of tuples of the inner relation taking part in the join */
+    std::size_t getInnerSize() const {
+        return innerSide.keys.size();
+    }
+
+private:
+    enum { MIN_BITS = 6, MAX_BITS = 20, PARTITION_SIZE = 4096 };
+
+    static constexpr std::size_t NONE = ~std::size_t(0);
+
+    /** The keys and tuples of a relation as columns, grouped by partitions */
+    template <typename T>
+    struct Side {
+        std::vector<Key> keys;
+        std::vector<const T*> tuples;
+
+        // the start of each partition, followed by the end of the last one
+        std::vector<std::size_t> offsets;
+    };
+
+    /** Hashes a key such that its top bits select the partition and its low bits the bucket */
+    static uint64_t hash(const Key& key) {
+        uint64_t res = 0;
+        for (std::size_t i = 0; i < sizeof(Key) / sizeof(key[0]); ++i) {
+            res = (res ^ static_cast<uint64_t>(key[i])) * 0x9E3779B97F4A7C15ull;
+        }
+        return res ^ (res >> 32);
+    }
+
+    std::size_t partitionOf(const Key& key) const {
+        return (hash(key) * 0xC2B2AE3D27D4EB4Full) >> shift;
+    }
+
+    /** Copies the keys of the tuples of a relation into the partitions of a side, in parallel */
+    template <typename Rel, typename KeyFun, typename Filter, typename T>
+    void gather(const Rel& rel, KeyFun keyOf, Filter filter, Side<T>& side) {
+        auto chunks = rel.partition();
+        const int numChunks = chunks.size();
+        const std::size_t numParts = getNumPartitions();
+
+        // count the tuples of each chunk per partition
+        std::vector<std::size_t> starts(numChunks * numParts, 0);
+#pragma omp parallel for schedule(dynamic)
+        for (int c = 0; c < numChunks; ++c) {
+            std::size_t* counts = &starts[c * numParts];
+            for (const auto& cur : chunks[c]) {
+                if (filter(cur)) {
+                    counts[partitionOf(keyOf(cur))]++;
+                }
+            }
+        }
+
+        // lay out the partitions one after another, each one holding the chunks in order
+        side.offsets.assign(numParts + 1, 0);
+        std::size_t total = 0;
+        for (std::size_t p = 0; p < numParts; ++p) {
+            side.offsets[p] = total;
+            for (int c = 0; c < numChunks; ++c) {
+                std::size_t count = starts[c * numParts + p];
+                starts[c * numParts + p] = total;
+                total += count;
+            }
+        }
+        side.offsets[numParts] = total;
+        side.keys.resize(total);
+        side.tuples.resize(total);
+
+        // scatter the keys and tuples into their partitions
+#pragma omp parallel for schedule(dynamic)
+        for (int c = 0; c < numChunks; ++c) {
+            std::size_t* pos = &starts[c * numParts];
+            for (const auto& cur : chunks[c]) {
+                if (filter(cur)) {
+                    const Key key = keyOf(cur);
+                    std::size_t& dst = pos[partitionOf(key)];
+                    side.keys[dst] = key;
+                    side.tuples[dst] = &cur;
+                    dst++;
+                }
+            }
+        }
+    }
+
+    // the number of bits of the hashes not selecting the partition
+    unsigned shift;
+
+    Side<Outer> outerSide;
+    Side<Inner> innerSide;
+};
+
+template <typename Key, typename Outer, typename Inner>
+constexpr std::size_t BulkJoin<Key, Outer, Inner>::MIN_SIZE;
+
+template <typename Key, typename Outer, typename Inner>
+constexpr std::size_t BulkJoin<Key, Outer, Inner>::NONE;
+
+}  // end of namespace souffle
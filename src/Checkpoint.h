@@ -0,0 +1,275 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Checkpoint.h
+ *
+ * Checkpoints of the evaluation of compiled programs (--checkpoints),
+ * saving their state into a directory at the end of each stratum, such
+ * that an evaluation interrupted is resumed after its last completed
+ * stratum.
+ *
+ * A checkpoint directory holds a binary relation file, see BinaryFormat.h,
+ * of each live relation, the symbols of the symbol table in the order of
+ * their indices, the records of all record maps, and a manifest naming
+ * the completed strata and the files and number of symbols belonging to
+ * them. The values of the relations are stored as they are, including
+ * symbols and records, whose indices are reproduced when restoring the
+ * symbols and records in order. The symbols are appended to their file by
+ * each stratum, the manifest replaced once the other files are written,
+ * such that the directory holds the state of the last completed stratum
+ * even if the evaluation is interrupted while writing.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "CompiledRecord.h"
+#include "IODirectives.h"
+#include "RamTypes.h"
+#include "ReadStreamBinary.h"
+#include "SymbolTable.h"
+#include "WriteStreamBinary.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace souffle {
+
+class Checkpoint {
+public:
+    /** Use a directory for the checkpoint, created once the first relation or stratum is saved */
+    explicit Checkpoint(std::string directory) : directory(std::move(directory)) {}
+
+    Checkpoint(const Checkpoint&) = delete;
+
+    /** Read the manifest of the checkpoint in the directory, returning false if there is none */
+    bool read() {
+        std::ifstream in(path("manifest"));
+        if (!in) {
+            return false;
+        }
+        std::string header;
+        std::getline(in, header);
+        if (header != magic()) {
+            throw std::runtime_error("Not a checkpoint: " + path("manifest"));
+        }
+        std::string key;
+        while (in >> key) {
+            if (key == "counter") {
+                in >> counter;
+            } else if (key == "symbols") {
+                in >> symbols >> symbolBytes;
+            } else if (key == "stratum") {
+                size_t stratum;
+                in >> stratum;
+                completed.insert(stratum);
+            } else if (key == "relation") {
+                std::string name;
+                in >> name;
+                relations.insert(name);
+            } else {
+                throw std::runtime_error("Corrupt checkpoint: " + path("manifest"));
+            }
+        }
+        if (in.bad() || !in.eof()) {
+            throw std::runtime_error("Corrupt checkpoint: " + path("manifest"));
+        }
+        return true;
+    }
+
+    /** Whether the checkpoint records the completion of a stratum */
+    bool isCompleted(size_t stratum) const {
+        return completed.count(stratum) > 0;
+    }
+
+    /** The value of the counter after the completed strata */
+    RamDomain getCounter() const {
+        return counter;
+    }
+
+    /** The names of the relations saved and not dropped by the completed strata */
+    const std::set<std::string>& getRelations() const {
+        return relations;
+    }
+
+    /**
+     * Restore the symbols and records of the checkpoint, assigning them their
+     * saved indices; the symbols and records existing already must agree.
+     */
+    void restoreSymbols(SymbolTable& symbolTable) const {
+        std::ifstream in(path("symbols"), std::ios::binary);
+        for (size_t i = 0; i < symbols; ++i) {
+            uint64_t length = 0;
+            in.read(reinterpret_cast<char*>(&length), sizeof(length));
+            std::string symbol(in ? length : 0, '\0');
+            in.read(&symbol[0], symbol.size());
+            if (!in) {
+                throw std::runtime_error("Corrupt checkpoint: " + path("symbols"));
+            }
+            const bool known = i < symbolTable.size();
+            if ((known && symbolTable.resolve(i) != symbol) ||
+                    (!known && static_cast<size_t>(symbolTable.lookup(symbol)) != i)) {
+                throw std::runtime_error("The symbols of the checkpoint disagree with the program");
+            }
+        }
+
+        std::ifstream records(path("records"), std::ios::binary);
+        if (records) {
+            detail::RecordMapBase::restoreAll(records);
+        }
+    }
+
+    /** Insert the tuples of a relation saved by the checkpoint into a relation of the given width */
+    template <typename T>
+    void restoreRelation(const std::string& name, T& relation, size_t width, SymbolTable& symbolTable) const {
+        const std::vector<bool> mask(width, false);
+        ReadFileBinary(mask, symbolTable, directives(name)).readAll(relation);
+    }
+
+    /** Save a relation of the given width, to be committed by the stratum computing it */
+    template <typename T>
+    void saveRelation(
+            const std::string& name, const T& relation, size_t width, const SymbolTable& symbolTable) const {
+        createDirectory();
+        const std::vector<bool> mask(width, false);
+        WriteFileBinary(mask, symbolTable, directives(name)).writeAll(relation);
+        if (!std::ifstream(path(name + ".bin")).good()) {
+            throw std::runtime_error("Cannot write checkpoint file " + path(name + ".bin"));
+        }
+    }
+
+    /**
+     * Record the completion of the given strata, after the relations they
+     * computed are saved, by saving the symbols and records added since the
+     * last commit and replacing the manifest. The files of the dropped
+     * relations are removed once the manifest no longer names them.
+     */
+    void commit(const std::vector<size_t>& strata, const SymbolTable& symbolTable, RamDomain ctr,
+            const std::vector<std::string>& saved, const std::vector<std::string>& dropped) {
+        createDirectory();
+        saveSymbols(symbolTable);
+        {
+            std::ofstream records(path("records.tmp"), std::ios::binary);
+            detail::RecordMapBase::saveAll(records);
+            check(records, "records.tmp");
+        }
+        replace("records.tmp", "records");
+
+        completed.insert(strata.begin(), strata.end());
+        counter = ctr;
+        relations.insert(saved.begin(), saved.end());
+        for (const auto& name : dropped) {
+            relations.erase(name);
+        }
+        {
+            std::ofstream manifest(path("manifest.tmp"));
+            manifest << magic() << "\n";
+            manifest << "counter " << counter << "\n";
+            manifest << "symbols " << symbols << " " << symbolBytes << "\n";
+            for (size_t stratum : completed) {
+                manifest << "stratum " << stratum << "\n";
+            }
+            for (const auto& name : relations) {
+                manifest << "relation " << name << "\n";
+            }
+            manifest.flush();
+            check(manifest, "manifest.tmp");
+        }
+        replace("manifest.tmp", "manifest");
+
+        for (const auto& name : dropped) {
+            std::remove(path(name + ".bin").c_str());
+        }
+    }
+
+private:
+    /** the first line of a manifest */
+    static std::string magic() {
+        return "souffle-checkpoint 1";
+    }
+
+    std::string path(const std::string& file) const {
+        return directory + "/" + file;
+    }
+
+    void createDirectory() const {
+        if (mkdir(directory.c_str(), 0777) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Cannot create checkpoint directory " + directory);
+        }
+    }
+
+    IODirectives directives(const std::string& name) const {
+        std::map<std::string, std::string> directiveMap = {
+                {"IO", "binary"}, {"filename", path(name + ".bin")}, {"name", name}};
+        return IODirectives(directiveMap);
+    }
+
+    void check(const std::ostream& out, const std::string& file) const {
+        if (!out) {
+            throw std::runtime_error("Cannot write checkpoint file " + path(file));
+        }
+    }
+
+    void replace(const std::string& from, const std::string& to) const {
+        if (std::rename(path(from).c_str(), path(to).c_str()) != 0) {
+            throw std::runtime_error("Cannot write checkpoint file " + path(to));
+        }
+    }
+
+    /** Append the symbols added since the last commit, dropping any appended by an unfinished one */
+    void saveSymbols(const SymbolTable& symbolTable) {
+        const size_t size = symbolTable.size();
+        if (!appending) {
+            std::ofstream(path("symbols"), std::ios::binary | std::ios::app).flush();
+            if (truncate(path("symbols").c_str(), symbolBytes) != 0) {
+                throw std::runtime_error("Cannot write checkpoint file " + path("symbols"));
+            }
+            appending = true;
+        }
+        if (size == symbols) {
+            return;
+        }
+        std::ofstream out(path("symbols"), std::ios::binary | std::ios::app);
+        for (size_t i = symbols; i < size; ++i) {
+            const std::string& symbol = symbolTable.unsafeResolve(i);
+            const uint64_t length = symbol.size();
+            out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            out.write(symbol.data(), symbol.size());
+            symbolBytes += sizeof(length) + symbol.size();
+        }
+        out.flush();
+        check(out, "symbols");
+        symbols = size;
+    }
+
+    std::string directory;
+
+    /** the state recorded by the manifest */
+    std::set<size_t> completed;
+    std::set<std::string> relations;
+    RamDomain counter = 0;
+    size_t symbols = 0;
+    uint64_t symbolBytes = 0;
+
+    /** whether the symbols file was cut back to the symbols of the manifest */
+    bool appending = false;
+};
+
+}  // end of namespace souffle
@@ -137,6 +137,35 @@ struct deref_compare {
     }
 };
 
+// ----- an order-preserving integer encoding of tuples ----------
+//         (required for searching by normalised keys)
+
+template <unsigned... Columns>
+struct normaliser;
+
+template <>
+struct normaliser<> {
+    template <typename Word, typename T>
+    static Word pack(const T& /* t */, Word res) {
+        return res;
+    }
+};
+
+template <unsigned First, unsigned... Rest>
+struct normaliser<First, Rest...> {
+    // appends the given columns of the tuple to the word, the first one being most significant
+    template <typename Word, typename T>
+    static Word pack(const T& t, Word res) {
+        using value_type = typename std::decay<decltype(t[First])>::type;
+        using unsigned_type = typename std::make_unsigned<value_type>::type;
+        enum { bits = 8 * sizeof(value_type) };
+        // flipping the sign bit maps the order of signed values onto the one of unsigned values
+        const unsigned_type value = static_cast<unsigned_type>(t[First]) ^ (unsigned_type(1) << (bits - 1));
+        // shifting in two steps is defined for values as wide as the word
+        return normaliser<Rest...>::pack(t, Word(((res << (bits - 1)) << 1) | value));
+    }
+};
+
 // ----- a utility for printing lists of parameters -------
 //    (required for printing descriptions of relations)
 
@@ -181,6 +210,9 @@ struct index {
     // the comparator associated to this index
     using comparator = index_utils::comparator<Columns...>;
 
+    // the encoding of tuples into integers ordered as by the comparator
+    using normaliser = index_utils::normaliser<Columns...>;
+
     // enables to check whether the given column is covered by this index or not
     template <unsigned Col>
     struct covers {
@@ -572,6 +604,18 @@ T raise(T tuple) {
 // 					     Index Container
 // -------------------------------------------------------------
 
+/**
+ * The search strategy of the b-trees of indices over the given number of
+ * columns: nodes of multi-column indices keep the normalised keys of their
+ * elements, comparing several columns by a single integer comparison.
+ *
+ * @tparam Key .. the type of the elements of the b-tree
+ * @tparam columns .. the number of columns of the index
+ */
+template <typename Key, unsigned columns>
+using btree_strategy = typename std::conditional<(columns >= 3), souffle::detail::simd_normalised_search,
+        typename souffle::detail::default_strategy<Key>::type>::type;
+
 /**
  * A direct index storing the indexed elements directly within the maintained
  * index structure.
@@ -581,7 +625,8 @@ T raise(T tuple) {
  */
 template <typename Tuple, typename Index>
 struct DirectIndex {
-    using data_structure = btree_set<Tuple, typename Index::comparator>;
+    using data_structure = btree_set<Tuple, typename Index::comparator, btree_node_pool, 256,
+            btree_strategy<Tuple, Index::size>>;
 
     using key_type = typename data_structure::key_type;
 
@@ -685,8 +730,10 @@ public:
 template <typename Tuple, typename Index>
 struct IndirectIndex {
     using data_structure = typename std::conditional<(int)(Tuple::arity) == (int)(Index::size),
-            btree_set<const Tuple*, index_utils::deref_compare<typename Index::comparator>>,
-            btree_multiset<const Tuple*, index_utils::deref_compare<typename Index::comparator>>>::type;
+            btree_set<const Tuple*, index_utils::deref_compare<typename Index::comparator>, btree_node_pool,
+                    256, btree_strategy<const Tuple*, Index::size>>,
+            btree_multiset<const Tuple*, index_utils::deref_compare<typename Index::comparator>,
+                    btree_node_pool>>::type;
 
     using key_type = typename std::remove_cv<
             typename std::remove_pointer<typename data_structure::key_type>::type>::type;
@@ -1547,4 +1594,59 @@ private:
 
 }  // end namespace ram
 
+namespace detail {
+
+// tuples compared by an index comparator are ordered by the first column of the index
+template <unsigned First, unsigned... Rest>
+struct leading_column<ram::index_utils::comparator<First, Rest...>> {
+    enum { value = First };
+};
+
+/**
+ * Tuples compared by an index comparator are normalised by packing as many
+ * leading columns of the index as fit into a 128-bit integer, or into a
+ * 64-bit one where they fit that, to be searched by the vectorised kernels.
+ */
+template <unsigned... Columns, typename Domain, std::size_t arity>
+struct normalised_key<ram::index_utils::comparator<Columns...>, ram::Tuple<Domain, arity>> {
+private:
+#ifdef __SIZEOF_INT128__
+    using wide_type = unsigned __int128;
+#else
+    using wide_type = uint64_t;
+#endif
+
+    enum {
+        bits = 8 * sizeof(Domain),
+        fitting = 8 * sizeof(wide_type) / bits,
+        length = sizeof...(Columns) < fitting ? sizeof...(Columns) : fitting
+    };
+
+    // the encoded leading columns
+    using prefix = typename ram::index_utils::get_prefix<length, ram::index<Columns...>>::type;
+
+    using word_type = typename std::conditional<(length * bits <= 64), uint64_t, wide_type>::type;
+
+public:
+    enum { columns = prefix::size, complete = (int)prefix::size == (int)sizeof...(Columns) };
+
+    using type = typename std::conditional<(length * bits <= 64), int64_t, wide_type>::type;
+
+    static type get(const ram::Tuple<Domain, arity>& t) {
+        const word_type res = prefix::normaliser::template pack<word_type>(t, word_type(0));
+        // flipping the top bit maps the order of 64-bit words onto the one of signed integers
+        return std::is_signed<type>::value ? type(res ^ (word_type(1) << 63)) : type(res);
+    }
+};
+
+// pointers to tuples are normalised by the tuples they reference
+template <typename Comp, typename T>
+struct normalised_key<ram::index_utils::deref_compare<Comp>, const T*> : public normalised_key<Comp, T> {
+    static typename normalised_key<Comp, T>::type get(const T* t) {
+        return normalised_key<Comp, T>::get(*t);
+    }
+};
+
+}  // end namespace detail
+
 }  // end namespace souffle
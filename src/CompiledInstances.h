@@ -0,0 +1,61 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file CompiledInstances.h
+ *
+ * The indexes of the most common arities and orders, instantiated once in a
+ * prebuilt object rather than in every generated program.
+ *
+ * Compiled with SOUFFLE_INSTANTIATE defined, this header defines the
+ * instances. Generated programs compiled with SOUFFLE_PREBUILT_INSTANCES
+ * defined only declare them, and are linked with the object holding them.
+ * souffle-compile builds the object once for each set of compiler flags.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/BTree.h"
+#include "souffle/CompiledIndexUtils.h"
+#include "souffle/CompiledTuple.h"
+#include "souffle/RamTypes.h"
+
+#if defined(SOUFFLE_INSTANTIATE) || defined(SOUFFLE_PREBUILT_INSTANCES)
+
+#ifdef SOUFFLE_INSTANTIATE
+#define SOUFFLE_INDEX_INSTANCE template class
+#else
+#define SOUFFLE_INDEX_INSTANCE extern template class
+#endif
+
+namespace souffle {
+
+// full indexes, as generated for relations without provenance
+SOUFFLE_INDEX_INSTANCE btree_set<ram::Tuple<RamDomain, 1>, ram::index_utils::comparator<0>, btree_node_pool>;
+SOUFFLE_INDEX_INSTANCE btree_set<ram::Tuple<RamDomain, 2>, ram::index_utils::comparator<0, 1>,
+        btree_node_pool>;
+SOUFFLE_INDEX_INSTANCE btree_set<ram::Tuple<RamDomain, 2>, ram::index_utils::comparator<1, 0>,
+        btree_node_pool>;
+SOUFFLE_INDEX_INSTANCE btree_set<ram::Tuple<RamDomain, 3>, ram::index_utils::comparator<0, 1, 2>,
+        btree_node_pool>;
+SOUFFLE_INDEX_INSTANCE btree_set<ram::Tuple<RamDomain, 4>, ram::index_utils::comparator<0, 1, 2, 3>,
+        btree_node_pool>;
+
+// partial indexes of binary relations
+SOUFFLE_INDEX_INSTANCE btree_multiset<ram::Tuple<RamDomain, 2>, ram::index_utils::comparator<0>,
+        btree_node_pool>;
+SOUFFLE_INDEX_INSTANCE btree_multiset<ram::Tuple<RamDomain, 2>, ram::index_utils::comparator<1>,
+        btree_node_pool>;
+
+}  // end of namespace souffle
+
+#undef SOUFFLE_INDEX_INSTANCE
+
+#endif
@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include "Numa.h"
+#include "ParallelUtils.h"
+#include "ResourceLimits.h"
 #include "Util.h"
 
 #include <iostream>
@@ -73,12 +76,37 @@ protected:
      */
     size_t stratumIndex;
 
+    /**
+     * memory placement of NUMA mode, or empty if disabled
+     */
+    std::string numa;
+
+    /**
+     * checkpoints flag
+     */
+    bool checkpoints;
+
+    /**
+     * checkpoint directory, or empty if no checkpoints are saved
+     */
+    std::string checkpoint_dir;
+
+    /**
+     * whether to resume from the checkpoint
+     */
+    bool resume = false;
+
+    /**
+     * port queries are served on, or 0 if the program runs once
+     */
+    int server_port = 0;
+
 public:
     // all argument constructor
     CmdOptions(const char* s, const char* id, const char* od, bool pe, const char* pfn, size_t nj,
-            size_t si = (size_t)-1)
+            size_t si = (size_t)-1, const char* nm = "", bool cp = false)
             : src(s), input_dir(id), output_dir(od), profiling(pe), profile_name(pfn), num_jobs(nj),
-              stratumIndex(si) {}
+              stratumIndex(si), numa(nm), checkpoints(cp) {}
 
     /**
      * get source code name
@@ -129,6 +157,34 @@ public:
         return stratumIndex;
     }
 
+    /**
+     * get memory placement of NUMA mode, empty if disabled
+     */
+    const std::string& getNuma() const {
+        return numa;
+    }
+
+    /**
+     * get checkpoint directory, empty if no checkpoints are saved
+     */
+    const std::string& getCheckpointDir() const {
+        return checkpoint_dir;
+    }
+
+    /**
+     * is resuming from the checkpoint requested
+     */
+    bool isResuming() const {
+        return resume;
+    }
+
+    /**
+     * get port queries are served on, 0 if the program runs once
+     */
+    int getServerPort() const {
+        return server_port;
+    }
+
     /**
      * Parses the given command line parameters, handles -h help requests or errors
      * and returns whether the parsing was successful or not.
@@ -150,6 +206,9 @@ public:
         // long options
         option longOptions[] = {{"facts", true, nullptr, 'F'}, {"output", true, nullptr, 'D'},
                 {"profile", true, nullptr, 'p'}, {"jobs", true, nullptr, 'j'}, {"index", true, nullptr, 'i'},
+                {"numa", true, nullptr, 'n'}, {"checkpoint", true, nullptr, 'c'},
+                {"resume", false, nullptr, 'r'}, {"time-limit", true, nullptr, 't'},
+                {"memory-limit", true, nullptr, 'm'}, {"serve", true, nullptr, 's'},
                 // the terminal option -- needs to be null
                 {nullptr, false, nullptr, 0}};
 #pragma GCC diagnostic pop
@@ -158,7 +217,7 @@ public:
         bool ok = true;
 
         int c; /* command-line arguments processing */
-        while ((c = getopt_long(argc, argv, "D:F:hp:j:i:", longOptions, nullptr)) != EOF) {
+        while ((c = getopt_long(argc, argv, "D:F:hp:j:i:n:c:rt:m:s:", longOptions, nullptr)) != EOF) {
             switch (c) {
                 /* Fact directories */
                 case 'F':
@@ -204,12 +263,60 @@ public:
                 case 'i':
                     stratumIndex = (size_t)std::stoull(optarg);
                     break;
+                case 'n':
+                    if (std::string(optarg) != "local" && std::string(optarg) != "interleave") {
+                        std::cerr << "Invalid memory placement [-n]: " << optarg << "\n";
+                        ok = false;
+                    }
+                    numa = optarg;
+                    break;
+                case 'c':
+                case 'r':
+                    if (!checkpoints) {
+                        std::cerr << "\nError: checkpoints were not enabled in compilation\n\n";
+                        printHelpPage(exec_name);
+                        exit(1);
+                    }
+                    if (c == 'c') {
+                        checkpoint_dir = optarg;
+                    } else {
+                        resume = true;
+                    }
+                    break;
+                case 't':
+                    if (atof(optarg) > 0) {
+                        ResourceLimits::instance().setTimeLimit(atof(optarg));
+                    } else {
+                        std::cerr << "Invalid time limit [-t]: " << optarg << "\n";
+                        ok = false;
+                    }
+                    break;
+                case 'm':
+                    if (atol(optarg) > 0) {
+                        ResourceLimits::instance().setMemoryLimit(atol(optarg));
+                    } else {
+                        std::cerr << "Invalid memory limit [-m]: " << optarg << "\n";
+                        ok = false;
+                    }
+                    break;
+                case 's':
+                    server_port = atoi(optarg);
+                    if (server_port <= 0 || server_port > 65535) {
+                        std::cerr << "Invalid port [-s]: " << optarg << "\n";
+                        ok = false;
+                    }
+                    break;
                 default:
                     printHelpPage(exec_name);
                     return false;
             }
         }
 
+        if (resume && checkpoint_dir.empty()) {
+            std::cerr << "Resuming [-r] requires a checkpoint directory [-c]\n";
+            ok = false;
+        }
+
         // update member fields
         input_dir = fact_dir;
         output_dir = out_dir;
@@ -218,7 +325,11 @@ public:
         if (num_jobs > 0) {
             omp_set_num_threads(num_jobs);
         }
+        ParallelPolicy::instance().setJobs(num_jobs);
 #endif
+        if (ok && !numa.empty()) {
+            numa::enable(numa == "interleave" ? numa::Placement::INTERLEAVE : numa::Placement::LOCAL);
+        }
 
         // return success state
         return ok;
@@ -252,6 +363,21 @@ private:
 #endif
         std::cerr << "    -i <N>, --index=<N>          -- Specify index of stratum to be executed\n";
         std::cerr << "                                    (or each in order if omitted)\n";
+        std::cerr << "    -n <MODE>, --numa=<MODE>     -- Pin threads to the nodes of a NUMA machine,\n";
+        std::cerr << "                                    placing memory [ local | interleave ]\n";
+        if (!numa.empty()) {
+            std::cerr << "                                    (default: " << numa << ")\n";
+        }
+        if (checkpoints) {
+            std::cerr << "    -c <DIR>, --checkpoint=<DIR> -- Save the state after each stratum into <DIR>\n";
+            std::cerr << "    -r, --resume                 -- Resume from the state saved into the\n";
+            std::cerr << "                                    directory of -c\n";
+        }
+        std::cerr << "    -t <SEC>, --time-limit=<SEC> -- Abort the evaluation after <SEC> seconds\n";
+        std::cerr << "    -m <MB>, --memory-limit=<MB> -- Evict the lazily built indexes once the resident\n";
+        std::cerr << "                                    set exceeds <MB> megabytes, abort next time\n";
+        std::cerr << "    -s <PORT>, --serve=<PORT>    -- Evaluate the program once, then answer queries\n";
+        std::cerr << "                                    on <PORT> (requires --incremental)\n";
         std::cerr << "    -h                           -- prints this help page.\n";
         std::cerr << "--------------------------------------------------------------------\n";
         std::cerr << " Copyright (c) 2016 Oracle and/or its affiliates.\n";
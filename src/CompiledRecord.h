@@ -18,11 +18,19 @@
 
 #include "CompiledTuple.h"
 #include "ParallelUtils.h"
+#include "RecordArena.h"
 #include "Util.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <istream>
 #include <limits>
+#include <map>
 #include <memory>
-#include <unordered_map>
+#include <ostream>
+#include <stdexcept>
 #include <vector>
 
 namespace souffle {
@@ -37,6 +45,13 @@ namespace souffle {
 template <typename Tuple>
 RamDomain pack(const Tuple& tuple);
 
+/**
+ * A function packing a tuple whose reference does not escape the current query into
+ * the given arena, unless the tuple has a global reference already.
+ */
+template <typename Tuple>
+RamDomain packLocal(RecordArena& arena, const Tuple& tuple);
+
 /**
  * A function obtaining a pointer to the tuple addressed by the given reference.
  */
@@ -56,6 +71,11 @@ RamDomain getNull();
 template <typename TupleType>
 bool isNull(RamDomain ref);
 
+/**
+ * Obtains an estimate of the number of bytes occupied by the records of all types.
+ */
+inline std::size_t getRecordMemoryUsage();
+
 // ----------------------------------------------------------------------------
 //                              Definitions
 // ----------------------------------------------------------------------------
@@ -72,73 +92,287 @@ bool isNull(RamDomain ref) {
 
 namespace detail {
 
+/**
+ * The part of the record maps common to all tuple types, keeping track of
+ * all maps for reporting their memory usage and saving their records.
+ */
+class RecordMapBase {
+public:
+    RecordMapBase() {
+        auto lease = getRegistryLock().acquire();
+        (void)lease;
+        getRegistry().push_back(this);
+    }
+
+    virtual ~RecordMapBase() {
+        auto lease = getRegistryLock().acquire();
+        (void)lease;
+        auto& registry = getRegistry();
+        registry.erase(std::find(registry.begin(), registry.end(), this));
+    }
+
+    /**
+     * Obtains an estimate of the number of bytes occupied by this map.
+     */
+    virtual std::size_t getMemoryUsage() const = 0;
+
+    /**
+     * Obtains an estimate of the number of bytes occupied by all maps.
+     */
+    static std::size_t getTotalMemoryUsage() {
+        auto lease = getRegistryLock().acquire();
+        (void)lease;
+        std::size_t res = 0;
+        for (const RecordMapBase* map : getRegistry()) {
+            res += map->getMemoryUsage();
+        }
+        return res;
+    }
+
+    /**
+     * Writes the records of all maps, each map as its arity, its number of
+     * records and their fields in the order of their references.
+     */
+    static void saveAll(std::ostream& out) {
+        auto lease = getRegistryLock().acquire();
+        (void)lease;
+        for (const RecordMapBase* map : getRegistry()) {
+            std::vector<RamDomain> fields = map->getFields();
+            const uint64_t header[2] = {map->getArity(), fields.size() / map->getArity()};
+            out.write(reinterpret_cast<const char*>(header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(fields.data()), fields.size() * sizeof(RamDomain));
+        }
+    }
+
+    /**
+     * Restores the records written by saveAll, such that they are assigned
+     * their former references; the records of maps not created yet are
+     * restored once they are.
+     */
+    static void restoreAll(std::istream& in) {
+        uint64_t header[2];
+        while (in.read(reinterpret_cast<char*>(header), sizeof(header))) {
+            std::vector<RamDomain> fields(header[0] * header[1]);
+            if (!in.read(reinterpret_cast<char*>(fields.data()), fields.size() * sizeof(RamDomain))) {
+                throw std::runtime_error("Corrupt records");
+            }
+            auto lease = getRegistryLock().acquire();
+            (void)lease;
+            auto pos = std::find_if(getRegistry().begin(), getRegistry().end(),
+                    [&](const RecordMapBase* map) { return map->getArity() == header[0]; });
+            if (pos != getRegistry().end()) {
+                (*pos)->setFields(fields);
+            } else {
+                getPending()[header[0]] = std::move(fields);
+            }
+        }
+    }
+
+protected:
+    /** Obtains the number of fields of the records of this map */
+    virtual std::size_t getArity() const = 0;
+
+    /** Obtains the fields of all records, in the order of their references */
+    virtual std::vector<RamDomain> getFields() const = 0;
+
+    /** Packs the records of the given fields, which must obtain consecutive references from the first on */
+    virtual void setFields(const std::vector<RamDomain>& fields) = 0;
+
+    /** Restores the records of this map read before it was created */
+    void restorePending() {
+        std::vector<RamDomain> fields;
+        {
+            auto lease = getRegistryLock().acquire();
+            (void)lease;
+            auto pos = getPending().find(getArity());
+            if (pos == getPending().end()) {
+                return;
+            }
+            fields = std::move(pos->second);
+            getPending().erase(pos);
+        }
+        setFields(fields);
+    }
+
+private:
+    static std::vector<RecordMapBase*>& getRegistry() {
+        static std::vector<RecordMapBase*> registry;
+        return registry;
+    }
+
+    /** the fields of the records restored for each arity whose map does not exist yet */
+    static std::map<std::size_t, std::vector<RamDomain>>& getPending() {
+        static std::map<std::size_t, std::vector<RamDomain>> pending;
+        return pending;
+    }
+
+    static Lock& getRegistryLock() {
+        static Lock lock;
+        return lock;
+    }
+};
+
 /**
  * A bidirectional mapping between tuples and reference indices.
+ *
+ * The references of the tuples are found in independently locked shards
+ * of hash tables, such that threads packing tuples at the same time rarely
+ * wait for each other, and the tuples of the references in blocks which
+ * are never moved, such that unpacking does not require any lock.
  */
 template <typename Tuple>
-class RecordMap {
-    // create blocks of a million entries
-    static const std::size_t BLOCK_SIZE = 1 << 20;
-
+class RecordMap : public RecordMapBase {
     /** The definition of the tuple type handled by this instance */
     using tuple_type = Tuple;
 
-    /** The definition of the type of a tuple block */
-    using block_type = std::array<tuple_type, BLOCK_SIZE>;
+    /** The number of independently locked shards of the tuple-to-index map */
+    static constexpr std::size_t SHARD_COUNT = 64;
 
-    /** The type utilized for the block index */
-    using block_index_type = std::vector<std::unique_ptr<block_type>>;
+    /** The size of the first block of the index-to-tuple store (log 2), each further block doubles */
+    static constexpr std::size_t BLOCK_BITS = 10;
+    static constexpr std::size_t MAX_BLOCKS = 64 - BLOCK_BITS;
 
-    /** The mapping from tuples to references/indices */
-    std::unordered_map<tuple_type, RamDomain> r2i;
+    /** The initial number of slots of a shard */
+    static constexpr std::size_t INITIAL_SLOTS = 16;
+
+    /**
+     * A shard of the tuple-to-index map, an open-addressing hash table. Each slot holds the upper half of
+     * the hash of a tuple and its index (zero marks free slots, the index of Nil), such that the tuples
+     * themselves are only stored once, in the index-to-tuple store.
+     */
+    struct Shard {
+        Lock lock;
+        std::vector<uint64_t> slots;
+        std::size_t size = 0;
+
+        Shard() : slots(INITIAL_SLOTS, 0) {}
+    };
+
+    /** The mapping from tuples to references/indices, the shard of a tuple is determined by its hash */
+    std::unique_ptr<Shard[]> shards;
 
     /** The mapping from indices to tuples */
-    block_index_type i2r;
+    std::unique_ptr<std::atomic<tuple_type*>[]> i2r;
+
+    /** The number of indices assigned, including the one of Nil */
+    std::atomic<std::size_t> numRecords;
+
+    /** The hash function for tuples, mixing each field into the state (by the finalizer of MurmurHash3) */
+    static uint64_t hash(const tuple_type& tuple) {
+        uint64_t h = 0x9e3779b97f4a7c15ull;
+        for (std::size_t i = 0; i < tuple_type::arity; ++i) {
+            h ^= static_cast<uint32_t>(tuple.data[i]);
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ull;
+            h ^= h >> 33;
+        }
+        return h;
+    }
+
+    /** Obtains the slot of the index-to-tuple store for the given index, allocating its block if required */
+    tuple_type& getSlot(std::size_t index) const {
+        std::size_t pos = index + (std::size_t(1) << BLOCK_BITS);
+        std::size_t block = (63 - __builtin_clzll(pos)) - BLOCK_BITS;
+        tuple_type* data = i2r[block].load(std::memory_order_acquire);
+        if (data == nullptr) {
+            auto* fresh = new tuple_type[std::size_t(1) << (block + BLOCK_BITS)];
+            if (i2r[block].compare_exchange_strong(data, fresh, std::memory_order_acq_rel)) {
+                data = fresh;
+            } else {
+                delete[] fresh;
+            }
+        }
+        return data[pos - (std::size_t(1) << (block + BLOCK_BITS))];
+    }
 
-    /** a lock for the pack operation */
-    Lock pack_lock;
+    /** Obtains the slot of a shard holding the given tuple, or the free slot it should be placed in; the
+     * caller holds the lock of the shard */
+    uint64_t& probe(Shard& shard, const tuple_type& tuple, uint64_t h) const {
+        uint64_t tag = h >> 32;
+        std::size_t mask = shard.slots.size() - 1;
+        for (std::size_t pos = tag & mask;; pos = (pos + 1) & mask) {
+            uint64_t& slot = shard.slots[pos];
+            if (slot == 0) {
+                return slot;
+            }
+            if ((slot >> 32) == tag && getSlot(slot & 0xffffffffull) == tuple) {
+                return slot;
+            }
+        }
+    }
+
+    /** Doubles the number of slots of a shard; the caller holds the lock of the shard */
+    static void grow(Shard& shard) {
+        std::vector<uint64_t> slots(shard.slots.size() * 2, 0);
+        std::size_t mask = slots.size() - 1;
+        for (uint64_t slot : shard.slots) {
+            if (slot == 0) {
+                continue;
+            }
+            std::size_t pos = (slot >> 32) & mask;
+            while (slots[pos] != 0) {
+                pos = (pos + 1) & mask;
+            }
+            slots[pos] = slot;
+        }
+        shard.slots.swap(slots);
+    }
 
 public:
-    RecordMap() = default;
+    RecordMap()
+            : shards(new Shard[SHARD_COUNT]), i2r(new std::atomic<tuple_type*>[MAX_BLOCKS]()),
+              numRecords(1) {
+        restorePending();
+    }
+
+    ~RecordMap() override {
+        for (std::size_t i = 0; i < MAX_BLOCKS; i++) {
+            delete[] i2r[i].load();
+        }
+    }
 
     /**
      * Packs the given tuple -- and may create a new reference if necessary.
      */
     RamDomain pack(const tuple_type& tuple) {
-        RamDomain index;
-
-        {
-            // lock pack operation
-            auto leas = pack_lock.acquire();  // lock hold till end of scope
-            (void)leas;                       // avoid warning
-
-            // try lookup
-            auto pos = r2i.find(tuple);
-            if (pos != r2i.end()) {
-                // take the previously assigned value
-                index = pos->second;
-            } else {
-                // add tuple to index
-                index = r2i.size() + 1;  // since 0 is skipped for the Nil element
-                r2i[tuple] = index;
-
-                // assert that new index is smaller than the range
-                assert(index != std::numeric_limits<RamDomain>::max());
+        uint64_t h = hash(tuple);
+        Shard& shard = shards[h % SHARD_COUNT];
+        LockSiteScope lockSite(LockSite::RECORDS);
+        auto lease = shard.lock.acquire();
+        (void)lease;  // avoid warning
+        uint64_t& slot = probe(shard, tuple, h);
+        if (slot != 0) {
+            // take the previously assigned value
+            return static_cast<RamDomain>(slot & 0xffffffffull);
+        }
 
-                if (index / BLOCK_SIZE == i2r.size()) {
-                    i2r.push_back(std::make_unique<block_type>());
-                }
+        // the index is assigned while holding the shard lock, such that every tuple gets exactly one
+        std::size_t index = numRecords.fetch_add(1, std::memory_order_relaxed);
 
-                // create entry for unpacking
-                auto& list = i2r[index / BLOCK_SIZE];
+        // assert that new index is smaller than the range
+        assert(index < static_cast<std::size_t>(std::numeric_limits<RamDomain>::max()));
 
-                // insert tuple
-                (*list)[index % BLOCK_SIZE] = tuple;
-            }
+        getSlot(index) = tuple;
+        slot = ((h >> 32) << 32) | index;
+        // keep the load factor below 3/4
+        if (++shard.size * 4 > shard.slots.size() * 3) {
+            grow(shard);
         }
+        return static_cast<RamDomain>(index);
+    }
 
-        // done
-        return index;
+    /**
+     * Looks up the reference of the given tuple without creating one; 0 if absent.
+     */
+    RamDomain find(const tuple_type& tuple) {
+        uint64_t h = hash(tuple);
+        Shard& shard = shards[h % SHARD_COUNT];
+        LockSiteScope lockSite(LockSite::RECORDS);
+        auto lease = shard.lock.acquire();
+        (void)lease;  // avoid warning
+        return static_cast<RamDomain>(probe(shard, tuple, h) & 0xffffffffull);
     }
 
     /**
@@ -146,7 +380,48 @@ public:
      */
     const tuple_type& unpack(RamDomain index) {
         // just look up the right spot
-        return (*(i2r[index / BLOCK_SIZE]))[index % BLOCK_SIZE];
+        return getSlot(static_cast<std::size_t>(index));
+    }
+
+    std::size_t getMemoryUsage() const override {
+        std::size_t res = sizeof(*this) + SHARD_COUNT * sizeof(Shard) + MAX_BLOCKS * sizeof(i2r[0]);
+        for (std::size_t i = 0; i < SHARD_COUNT; i++) {
+            auto lease = shards[i].lock.acquire();
+            (void)lease;
+            res += shards[i].slots.capacity() * sizeof(uint64_t);
+        }
+        for (std::size_t i = 0; i < MAX_BLOCKS; i++) {
+            if (i2r[i].load(std::memory_order_acquire) != nullptr) {
+                res += (std::size_t(1) << (i + BLOCK_BITS)) * sizeof(tuple_type);
+            }
+        }
+        return res;
+    }
+
+protected:
+    std::size_t getArity() const override {
+        return tuple_type::arity;
+    }
+
+    std::vector<RamDomain> getFields() const override {
+        const std::size_t count = numRecords.load();
+        std::vector<RamDomain> fields;
+        fields.reserve((count - 1) * tuple_type::arity);
+        for (std::size_t index = 1; index < count; ++index) {
+            const tuple_type& tuple = getSlot(index);
+            fields.insert(fields.end(), tuple.data, tuple.data + tuple_type::arity);
+        }
+        return fields;
+    }
+
+    void setFields(const std::vector<RamDomain>& fields) override {
+        tuple_type tuple;
+        for (std::size_t i = 0; i < fields.size(); i += tuple_type::arity) {
+            std::copy(fields.begin() + i, fields.begin() + i + tuple_type::arity, tuple.data);
+            if (static_cast<std::size_t>(pack(tuple)) != i / tuple_type::arity + 1) {
+                throw std::runtime_error("The restored records disagree with the existing ones");
+            }
+        }
     }
 };
 
@@ -159,6 +434,9 @@ public:
     RamDomain pack(const ram::Tuple<RamDomain, 0>& tuple) {
         return 1;
     }
+    RamDomain find(const ram::Tuple<RamDomain, 0>& tuple) {
+        return 1;
+    }
     const ram::Tuple<RamDomain, 0>& unpack(RamDomain index) {
         static ram::Tuple<RamDomain, 0> empty;
         return empty;
@@ -180,9 +458,19 @@ RamDomain pack(const Tuple& tuple) {
     return detail::getRecordMap<Tuple>().pack(tuple);
 }
 
+template <typename Tuple>
+RamDomain packLocal(RecordArena& arena, const Tuple& tuple) {
+    return arena.pack(tuple.data, Tuple::arity,
+            [&](const RamDomain*) { return detail::getRecordMap<Tuple>().find(tuple); });
+}
+
 template <typename Tuple>
 const Tuple& unpack(RamDomain ref) {
     return detail::getRecordMap<Tuple>().unpack(ref);
 }
 
+inline std::size_t getRecordMemoryUsage() {
+    return detail::RecordMapBase::getTotalMemoryUsage();
+}
+
 }  // end of namespace souffle
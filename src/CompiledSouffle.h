@@ -16,27 +16,51 @@
 
 #pragma once
 
+#include "souffle/AggregateGroups.h"
+#include "souffle/AppendBuffer.h"
+#include "souffle/BitmapSet.h"
+#include "souffle/BloomFilter.h"
 #include "souffle/Brie.h"
+#include "souffle/Checkpoint.h"
 #include "souffle/CompiledIndexUtils.h"
+#include "souffle/CompiledInstances.h"
 #include "souffle/CompiledOptions.h"
 #include "souffle/CompiledRecord.h"
 #include "souffle/CompiledRelation.h"
 #include "souffle/CompiledTuple.h"
+#include "souffle/CompressedSet.h"
+#include "souffle/HashSet.h"
 #include "souffle/IODirectives.h"
 #include "souffle/IOSystem.h"
+#include "souffle/InputPrefetcher.h"
+#include "souffle/InsertBuffer.h"
+#include "souffle/LeapfrogJoin.h"
 #include "souffle/Logger.h"
+#include "souffle/MappedSet.h"
 #include "souffle/ParallelUtils.h"
+#include "souffle/ProbeMemo.h"
 #include "souffle/ProfileEvent.h"
 #include "souffle/RamTypes.h"
+#include "souffle/RegexCache.h"
+#include "souffle/ResourceLimits.h"
+#include "souffle/SampleProfiler.h"
 #include "souffle/SignalHandler.h"
 #include "souffle/SouffleInterface.h"
+#include "souffle/StatisticsCatalog.h"
+#include "souffle/StorageProvider.h"
+#include "souffle/StratumCache.h"
 #include "souffle/SymbolTable.h"
+#include "souffle/TraceLog.h"
+#include "souffle/TransitiveClosure.h"
 #include "souffle/Util.h"
+#include "souffle/WriteQueue.h"
 #include "souffle/WriteStream.h"
 #ifdef USE_MPI
 #include "souffle/Mpi.h"
+#include "souffle/MpiStore.h"
 #endif
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cassert>
@@ -44,10 +68,12 @@
 #include <cstdint>
 #include <cstdlib>
 #include <exception>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <regex>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -63,6 +89,53 @@ inline souffle::SouffleProgram* getInstance(const char* p) {
 }
 }
 
+namespace detail {
+template <typename R>
+auto resetRelation(R& relation, int) -> decltype(relation.reset()) {
+    relation.reset();
+}
+template <typename R>
+void resetRelation(R& relation, long) {
+    relation.purge();
+}
+template <typename R>
+auto evictIndexes(R& relation, int) -> decltype(relation.evictIndexes()) {
+    relation.evictIndexes();
+}
+template <typename R>
+void evictIndexes(R&, long) {}
+}  // namespace detail
+
+/** Clear a relation, keeping the memory of its data structure for the tuples inserted next if it can */
+template <typename R>
+void resetRelation(R& relation) {
+    detail::resetRelation(relation, 0);
+}
+
+/** Clear the indexes of a relation that are filled on their first use, if it has any */
+template <typename R>
+void evictIndexes(R& relation) {
+    detail::evictIndexes(relation, 0);
+}
+
+/**
+ * Remove the tuples satisfying a predicate from a relation, rebuilding it
+ * since the relation representations support no erasure
+ */
+template <typename R, typename P>
+void eraseTuples(R& relation, P erased) {
+    std::vector<typename std::decay<decltype(*relation.begin())>::type> kept;
+    for (const auto& cur : relation) {
+        if (!erased(cur)) {
+            kept.push_back(cur);
+        }
+    }
+    relation.purge();
+    for (const auto& cur : kept) {
+        relation.insert(cur);
+    }
+}
+
 /**
  * Relation wrapper used internally in the generated Datalog program
  */
@@ -75,6 +148,15 @@ private:
     std::array<const char*, Arity> tupleType;
     std::array<const char*, Arity> tupleName;
 
+    /** called with the tuples inserted before inserting them and with those retracted, if set */
+    std::function<void(const TupleType&)> onInsert;
+    std::function<void(const TupleType&)> onRetract;
+
+    /** passes the tuples of the index serving the most of the columns bound by a mask to a visitor, if set */
+    using Search =
+            std::function<void(const TupleType&, uint64_t, const std::function<void(const TupleType&)>&)>;
+    Search onSearch;
+
     class iterator_wrapper : public iterator_base {
         typename RelType::iterator it;
         const Relation* relation;
@@ -120,8 +202,96 @@ public:
         for (size_t i = 0; i < Arity; i++) {
             t[i] = arg[i];
         }
+        if (onInsert) {
+            onInsert(t);
+        }
         relation.insert(t);
     }
+    void insertBatch(const RamDomain* rows, size_t n) override {
+        TupleType t;
+        for (size_t i = 0; i < n; i++, rows += Arity) {
+            for (size_t j = 0; j < Arity; j++) {
+                t[j] = rows[j];
+            }
+            if (onInsert) {
+                onInsert(t);
+            }
+            relation.insert(t);
+        }
+    }
+    void scan(const BatchVisitor& visit, size_t batchSize) const override {
+        batchSize = std::max<size_t>(batchSize, 1);
+        std::vector<RamDomain> rows(std::max<size_t>(batchSize * Arity, 1));
+        size_t count = 0;
+        for (const auto& cur : relation) {
+            for (size_t j = 0; j < Arity; j++) {
+                rows[count * Arity + j] = cur[j];
+            }
+            if (++count == batchSize) {
+                visit(rows.data(), count);
+                count = 0;
+            }
+        }
+        if (count > 0) {
+            visit(rows.data(), count);
+        }
+    }
+    void equalRange(const RamDomain* pattern, uint64_t columns, const BatchVisitor& visit,
+            size_t batchSize) const override {
+        batchSize = std::max<size_t>(batchSize, 1);
+        std::vector<RamDomain> rows(std::max<size_t>(batchSize * Arity, 1));
+        size_t count = 0;
+        TupleType key;
+        for (size_t j = 0; j < Arity; j++) {
+            key[j] = ((columns >> j) & 1) != 0 ? pattern[j] : 0;
+        }
+        const auto& add = [&](const TupleType& cur) {
+            for (size_t j = 0; j < Arity; j++) {
+                if (((columns >> j) & 1) != 0 && cur[j] != key[j]) {
+                    return;
+                }
+            }
+            for (size_t j = 0; j < Arity; j++) {
+                rows[count * Arity + j] = cur[j];
+            }
+            if (++count == batchSize) {
+                visit(rows.data(), count);
+                count = 0;
+            }
+        };
+        if (onSearch) {
+            onSearch(key, columns, add);
+        } else {
+            for (const auto& cur : relation) {
+                add(cur);
+            }
+        }
+        if (count > 0) {
+            visit(rows.data(), count);
+        }
+    }
+    /** Find the tuples matching the patterns of equalRange() through the indexes of the relation */
+    void searchIndexes(Search search) {
+        onSearch = std::move(search);
+    }
+    bool retract(const tuple& arg) override {
+        TupleType t;
+        assert(arg.size() == Arity && "wrong tuple arity");
+        for (size_t i = 0; i < Arity; i++) {
+            t[i] = arg[i];
+        }
+        if (!onRetract || !relation.contains(t)) {
+            return false;
+        }
+        onRetract(t);
+        return true;
+    }
+    /** Track the tuples inserted and retracted, for incremental updates */
+    void trackChanges(std::function<void(const TupleType&)> inserted,
+            std::function<void(const TupleType&)> retracted) {
+        onInsert = std::move(inserted);
+        onRetract = std::move(retracted);
+    }
     bool contains(const tuple& arg) const override {
         TupleType t;
         assert(arg.size() == Arity && "wrong tuple arity");
@@ -236,6 +406,9 @@ public:
         data = false;
     }
     void printHintStatistics(std::ostream& o, std::string prefix) const {}
+    std::vector<std::pair<std::string, std::size_t>> getMemoryUsage() const {
+        return {};
+    }
 };
 
 }  // namespace souffle
@@ -29,6 +29,7 @@
 #include "Util.h"
 #include <algorithm>
 #include <memory>
+#include <tuple>
 
 namespace souffle {
 
@@ -169,24 +170,58 @@ struct ComponentContent {
     void add(std::unique_ptr<AstStore>& directive, ErrorReport& report) {
         stores.push_back(std::move(directive));
     }
+
+    /** Adds clones of all the given content */
+    void addClones(const ComponentContent& other) {
+        for (const auto& cur : other.types) {
+            types.emplace_back(cur->clone());
+        }
+        for (const auto& cur : other.relations) {
+            relations.emplace_back(cur->clone());
+        }
+        for (const auto& cur : other.loads) {
+            loads.emplace_back(cur->clone());
+        }
+        for (const auto& cur : other.printSizes) {
+            printSizes.emplace_back(cur->clone());
+        }
+        for (const auto& cur : other.stores) {
+            stores.emplace_back(cur->clone());
+        }
+    }
 };
 
+/**
+ * The content of an instantiation before the renaming by the instance name, with its orphan clauses.
+ */
+struct InstantiatedContent {
+    ComponentContent content;
+    std::vector<std::unique_ptr<AstClause>> orphans;
+};
+
+/**
+ * Instantiations computed so far, by the component, the scope looked up in, the type binding and the
+ * remaining instantiation depth. Identical instantiations clone the content of the first one.
+ */
+using InstantiationKey = std::tuple<const AstComponent*, const AstComponent*, TypeBinding, unsigned int>;
+using InstantiationCache = std::map<InstantiationKey, InstantiatedContent>;
+
 /**
  * Recursively computes the set of relations (and included clauses) introduced
  * by this init statement enclosed within the given scope.
  */
 ComponentContent getInstantiatedContent(const AstComponentInit& componentInit,
         const AstComponent* enclosingComponent, const ComponentLookup& componentLookup,
-        std::vector<std::unique_ptr<AstClause>>& orphans, ErrorReport& report,
+        InstantiationCache& cache, std::vector<std::unique_ptr<AstClause>>& orphans, ErrorReport& report,
         const TypeBinding& binding = TypeBinding(), unsigned int maxDepth = MAX_INSTANTIATION_DEPTH);
 
 /**
  * Collects clones of all the content in the given component and its base components.
  */
 void collectContent(const AstComponent& component, const TypeBinding& binding,
-        const AstComponent* enclosingComponent, const ComponentLookup& componentLookup, ComponentContent& res,
-        std::vector<std::unique_ptr<AstClause>>& orphans, const std::set<std::string>& overridden,
-        ErrorReport& report, unsigned int maxInstantiationDepth) {
+        const AstComponent* enclosingComponent, const ComponentLookup& componentLookup,
+        InstantiationCache& cache, ComponentContent& res, std::vector<std::unique_ptr<AstClause>>& orphans,
+        const std::set<std::string>& overridden, ErrorReport& report, unsigned int maxInstantiationDepth) {
     // start with relations and clauses of the base components
     for (const auto& base : component.getBaseComponents()) {
         const AstComponent* comp = componentLookup.getComponent(enclosingComponent, base->getName(), binding);
@@ -201,7 +236,7 @@ void collectContent(const AstComponent& component, const TypeBinding& binding,
             for (const auto& cur : comp->getInstantiations()) {
                 // instantiate sub-component
                 ComponentContent content = getInstantiatedContent(*cur, enclosingComponent, componentLookup,
-                        orphans, report, activeBinding, maxInstantiationDepth - 1);
+                        cache, orphans, report, activeBinding, maxInstantiationDepth - 1);
 
                 // process types
                 for (auto& type : content.types) {
@@ -229,8 +264,8 @@ void collectContent(const AstComponent& component, const TypeBinding& binding,
             std::set<std::string> superOverridden;
             superOverridden.insert(overridden.begin(), overridden.end());
             superOverridden.insert(component.getOverridden().begin(), component.getOverridden().end());
-            collectContent(*comp, activeBinding, comp, componentLookup, res, orphans, superOverridden, report,
-                    maxInstantiationDepth);
+            collectContent(*comp, activeBinding, comp, componentLookup, cache, res, orphans, superOverridden,
+                    report, maxInstantiationDepth);
         }
     }
 
@@ -334,8 +369,8 @@ void collectContent(const AstComponent& component, const TypeBinding& binding,
 
 ComponentContent getInstantiatedContent(const AstComponentInit& componentInit,
         const AstComponent* enclosingComponent, const ComponentLookup& componentLookup,
-        std::vector<std::unique_ptr<AstClause>>& orphans, ErrorReport& report, const TypeBinding& binding,
-        unsigned int maxDepth) {
+        InstantiationCache& cache, std::vector<std::unique_ptr<AstClause>>& orphans, ErrorReport& report,
+        const TypeBinding& binding, unsigned int maxDepth) {
     // start with an empty list
     ComponentContent res;
 
@@ -357,39 +392,61 @@ ComponentContent getInstantiatedContent(const AstComponentInit& componentInit,
     const auto& actualParams = componentInit.getComponentType()->getTypeParameters();
     TypeBinding activeBinding = binding.extend(formalParams, actualParams);
 
-    // instantiated nested components
-    for (const auto& cur : component->getInstantiations()) {
-        // get nested content
-        ComponentContent nestedContent = getInstantiatedContent(
-                *cur, component, componentLookup, orphans, report, activeBinding, maxDepth - 1);
-
-        // add types
-        for (auto& type : nestedContent.types) {
-            res.add(type, report);
+    // reuse identical instantiations, unless orphans of other instantiations may be adopted
+    const bool memoise = orphans.empty();
+    const auto key = std::make_tuple(component, enclosingComponent, activeBinding, maxDepth);
+    auto pos = memoise ? cache.find(key) : cache.end();
+    if (pos != cache.end()) {
+        res.addClones(pos->second.content);
+        for (const auto& cur : pos->second.orphans) {
+            orphans.emplace_back(cur->clone());
         }
+    } else {
+        const unsigned errors = report.getNumErrors();
+
+        // instantiated nested components
+        for (const auto& cur : component->getInstantiations()) {
+            // get nested content
+            ComponentContent nestedContent = getInstantiatedContent(
+                    *cur, component, componentLookup, cache, orphans, report, activeBinding, maxDepth - 1);
+
+            // add types
+            for (auto& type : nestedContent.types) {
+                res.add(type, report);
+            }
 
-        // add relations
-        for (auto& rel : nestedContent.relations) {
-            res.add(rel, report);
-        }
+            // add relations
+            for (auto& rel : nestedContent.relations) {
+                res.add(rel, report);
+            }
 
-        // add IO directives
-        for (auto& io : nestedContent.loads) {
-            res.add(io, report);
-        }
-        for (auto& io : nestedContent.printSizes) {
-            res.add(io, report);
+            // add IO directives
+            for (auto& io : nestedContent.loads) {
+                res.add(io, report);
+            }
+            for (auto& io : nestedContent.printSizes) {
+                res.add(io, report);
+            }
+            for (auto& io : nestedContent.stores) {
+                res.add(io, report);
+            }
         }
-        for (auto& io : nestedContent.stores) {
-            res.add(io, report);
+
+        // collect all content in this component
+        std::set<std::string> overridden;
+        collectContent(*component, activeBinding, enclosingComponent, componentLookup, cache, res, orphans,
+                overridden, report, maxDepth);
+
+        // remember the content unless it is erroneous, keeping its diagnostics for each instance
+        if (memoise && report.getNumErrors() == errors) {
+            InstantiatedContent& instantiated = cache[key];
+            instantiated.content.addClones(res);
+            for (const auto& cur : orphans) {
+                instantiated.orphans.emplace_back(cur->clone());
+            }
         }
     }
 
-    // collect all content in this component
-    std::set<std::string> overridden;
-    collectContent(*component, activeBinding, enclosingComponent, componentLookup, res, orphans, overridden,
-            report, maxDepth);
-
     // update type names
     std::map<AstTypeIdentifier, AstTypeIdentifier> typeNameMapping;
     for (const auto& cur : res.types) {
@@ -406,74 +463,59 @@ ComponentContent getInstantiatedContent(const AstComponentInit& componentInit,
         cur->setName(newName);
     }
 
-    // create a helper function fixing type and relation references
+    // create a helper function fixing type and relation references in a single traversal
     auto fixNames = [&](const AstNode& node) {
-        // rename attribute types in headers
-        visitDepthFirst(node, [&](const AstAttribute& attr) {
-            auto pos = typeNameMapping.find(attr.getTypeName());
-            if (pos != typeNameMapping.end()) {
-                const_cast<AstAttribute&>(attr).setTypeName(pos->second);
-            }
-        });
-
-        // rename atoms in clauses
-        visitDepthFirst(node, [&](const AstAtom& atom) {
-            auto pos = relationNameMapping.find(atom.getName());
-            if (pos != relationNameMapping.end()) {
-                const_cast<AstAtom&>(atom).setName(pos->second);
-            }
-        });
-
-        // rename IO directives
-        visitDepthFirst(node, [&](const AstLoad& load) {
-            auto pos = relationNameMapping.find(load.getName());
-            if (pos != relationNameMapping.end()) {
-                const_cast<AstLoad&>(load).setName(pos->second);
-            }
-        });
-        visitDepthFirst(node, [&](const AstPrintSize& printSize) {
-            auto pos = relationNameMapping.find(printSize.getName());
-            if (pos != relationNameMapping.end()) {
-                const_cast<AstPrintSize&>(printSize).setName(pos->second);
-            }
-        });
-        visitDepthFirst(node, [&](const AstStore& store) {
-            auto pos = relationNameMapping.find(store.getName());
-            if (pos != relationNameMapping.end()) {
-                const_cast<AstStore&>(store).setName(pos->second);
-            }
-        });
-
-        // rename field types in records
-        visitDepthFirst(node, [&](const AstRecordType& recordType) {
-            auto& fields = recordType.getFields();
-            for (size_t i = 0; i < fields.size(); i++) {
-                auto& field = fields[i];
-                auto pos = typeNameMapping.find(field.type);
+        visitDepthFirst(node, [&](const AstNode& cur) {
+            if (const auto* attr = dynamic_cast<const AstAttribute*>(&cur)) {
+                // rename attribute types in headers
+                auto pos = typeNameMapping.find(attr->getTypeName());
                 if (pos != typeNameMapping.end()) {
-                    const_cast<AstRecordType&>(recordType).setFieldType(i, pos->second);
+                    const_cast<AstAttribute*>(attr)->setTypeName(pos->second);
                 }
-            }
-        });
-
-        // rename variant types in unions
-        visitDepthFirst(node, [&](const AstUnionType& unionType) {
-            auto& variants = unionType.getTypes();
-            for (size_t i = 0; i < variants.size(); i++) {
-                auto pos = typeNameMapping.find(variants[i]);
+            } else if (const auto* atom = dynamic_cast<const AstAtom*>(&cur)) {
+                // rename atoms in clauses
+                auto pos = relationNameMapping.find(atom->getName());
+                if (pos != relationNameMapping.end()) {
+                    const_cast<AstAtom*>(atom)->setName(pos->second);
+                }
+            } else if (const auto* load = dynamic_cast<const AstLoad*>(&cur)) {
+                // rename IO directives
+                auto pos = relationNameMapping.find(load->getName());
+                if (pos != relationNameMapping.end()) {
+                    const_cast<AstLoad*>(load)->setName(pos->second);
+                }
+            } else if (const auto* store = dynamic_cast<const AstStore*>(&cur)) {
+                // rename IO directives, including print sizes
+                auto pos = relationNameMapping.find(store->getName());
+                if (pos != relationNameMapping.end()) {
+                    const_cast<AstStore*>(store)->setName(pos->second);
+                }
+            } else if (const auto* recordType = dynamic_cast<const AstRecordType*>(&cur)) {
+                // rename field types in records
+                auto& fields = recordType->getFields();
+                for (size_t i = 0; i < fields.size(); i++) {
+                    auto pos = typeNameMapping.find(fields[i].type);
+                    if (pos != typeNameMapping.end()) {
+                        const_cast<AstRecordType*>(recordType)->setFieldType(i, pos->second);
+                    }
+                }
+            } else if (const auto* unionType = dynamic_cast<const AstUnionType*>(&cur)) {
+                // rename variant types in unions
+                auto& variants = unionType->getTypes();
+                for (size_t i = 0; i < variants.size(); i++) {
+                    auto pos = typeNameMapping.find(variants[i]);
+                    if (pos != typeNameMapping.end()) {
+                        const_cast<AstUnionType*>(unionType)->setVariantType(i, pos->second);
+                    }
+                }
+            } else if (const auto* cast = dynamic_cast<const AstTypeCast*>(&cur)) {
+                // rename type information in typecast
+                auto pos = typeNameMapping.find(cast->getType());
                 if (pos != typeNameMapping.end()) {
-                    const_cast<AstUnionType&>(unionType).setVariantType(i, pos->second);
+                    const_cast<AstTypeCast*>(cast)->setType(pos->second);
                 }
             }
         });
-
-        // rename type information in typecast
-        visitDepthFirst(node, [&](const AstTypeCast& cast) {
-            auto pos = typeNameMapping.find(cast.getType());
-            if (pos != typeNameMapping.end()) {
-                const_cast<AstTypeCast&>(cast).setType(pos->second);
-            }
-        });
     };
 
     // rename attribute type in headers and atoms in clauses of the relation
@@ -516,12 +558,13 @@ bool ComponentInstantiationTransformer::transform(AstTranslationUnit& translatio
     AstProgram& program = *translationUnit.getProgram();
 
     auto* componentLookup = translationUnit.getAnalysis<ComponentLookup>();
+    InstantiationCache cache;
 
     for (const auto& cur : program.instantiations) {
         std::vector<std::unique_ptr<AstClause>> orphans;
 
         ComponentContent content = getInstantiatedContent(
-                *cur, nullptr, *componentLookup, orphans, translationUnit.getErrorReport());
+                *cur, nullptr, *componentLookup, cache, orphans, translationUnit.getErrorReport());
         for (auto& type : content.types) {
             program.types.insert(std::make_pair(type->getName(), std::move(type)));
         }
@@ -65,6 +65,11 @@ public:
         return result;
     }
 
+    /** Orders type bindings, e.g. to key instantiations by them */
+    bool operator<(const TypeBinding& other) const {
+        return binding < other.binding;
+    }
+
 private:
     /**
      * Key value pair. Keys are names that should be forwarded to value,
@@ -0,0 +1,614 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file CompressedSet.h
+ *
+ * An ordered set of fixed length integer tuples storing its elements in
+ * delta-encoded blocks, trading lookup speed for a small memory footprint.
+ *
+ * Tuples are kept in lexicographical order in blocks of a bounded number
+ * of elements. The first tuple of each block is stored in full; each further
+ * tuple is encoded relative to its predecessor by the length of the common
+ * prefix, the (positive) difference in the first deviating column and the
+ * differences in all subsequent columns, using variable length integers.
+ * Tuples sharing long prefixes thus occupy only a few bytes each.
+ *
+ * Multiple insert operations can be conducted concurrently on a set, as can
+ * read-only operations. However, inserts and read operations may not be
+ * conducted at the same time.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "CompiledTuple.h"
+#include "ParallelUtils.h"
+#include "RamTypes.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace souffle {
+
+namespace detail {
+
+/**
+ * Utilities for the variable length encoding of integers: values are stored
+ * in groups of 7 bits, with the highest bit of each byte marking a continuation.
+ */
+namespace varint {
+
+inline void write(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline uint64_t read(const uint8_t*& in) {
+    uint64_t value = 0;
+    int shift = 0;
+    while (*in & 0x80) {
+        value |= uint64_t(*in++ & 0x7f) << shift;
+        shift += 7;
+    }
+    return value | (uint64_t(*in++) << shift);
+}
+
+// maps differences of small magnitude to small unsigned values
+inline uint64_t zigzag(uint64_t value) {
+    return (value << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(value) >> 63);
+}
+
+inline uint64_t unzigzag(uint64_t value) {
+    return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+}  // end namespace varint
+
+}  // end namespace detail
+
+/**
+ * A set of tuples of the given arity in lexicographical order, stored in
+ * delta-encoded blocks.
+ *
+ * @tparam N the arity of the stored tuples
+ */
+template <unsigned N>
+class CompressedSet {
+public:
+    using entry_type = ram::Tuple<RamDomain, N>;
+    using element_type = entry_type;
+
+private:
+    // the maximal number of tuples per block
+    enum { BLOCK_SIZE = 64 };
+
+    /**
+     * A block of consecutive tuples.
+     */
+    struct Block {
+        // the first tuple of the block, stored uncompressed
+        entry_type first;
+
+        // the last tuple of the block, enabling appends without decoding the block
+        entry_type last;
+
+        // the number of tuples in this block
+        uint32_t count = 1;
+
+        // the encoding of all but the first tuple, each relative to its predecessor
+        std::vector<uint8_t> data;
+
+        // the next block in order
+        Block* next = nullptr;
+
+        Block(const entry_type& t) : first(t), last(t) {}
+    };
+
+    // a lexicographical order on tuples
+    struct less {
+        bool operator()(const entry_type& a, const entry_type& b) const {
+            for (unsigned i = 0; i < N; ++i) {
+                if (a[i] != b[i]) {
+                    return a[i] < b[i];
+                }
+            }
+            return false;
+        }
+    };
+
+    // the blocks, indexed by their first tuple
+    std::map<entry_type, std::unique_ptr<Block>, less> blocks;
+
+    // the first block in order
+    Block* head = nullptr;
+
+    // the number of stored tuples
+    std::size_t numTuples = 0;
+
+    // a lock synchronizing insertions
+    Lock lock;
+
+    /* -- encoding -- */
+
+    // appends the encoding of the given tuple relative to the given predecessor
+    static void encode(std::vector<uint8_t>& out, const entry_type& prev, const entry_type& cur) {
+        // the length of the common prefix (the tuples are distinct)
+        unsigned s = 0;
+        while (prev[s] == cur[s]) {
+            ++s;
+        }
+        assert(s < N && prev[s] < cur[s] && "tuples not in order");
+        detail::varint::write(out, s);
+
+        // the difference in the first deviating column is positive
+        detail::varint::write(out, uint64_t(cur[s]) - uint64_t(prev[s]));
+
+        // all further columns are encoded by their differences
+        for (unsigned i = s + 1; i < N; ++i) {
+            detail::varint::write(out, detail::varint::zigzag(uint64_t(cur[i]) - uint64_t(prev[i])));
+        }
+    }
+
+    // decodes the tuple following the given one, advancing the given position
+    static void decode(const uint8_t*& in, entry_type& cur) {
+        unsigned s = detail::varint::read(in);
+        cur[s] = RamDomain(uint64_t(cur[s]) + detail::varint::read(in));
+        for (unsigned i = s + 1; i < N; ++i) {
+            cur[i] = RamDomain(uint64_t(cur[i]) + detail::varint::unzigzag(detail::varint::read(in)));
+        }
+    }
+
+    // obtains all tuples of the given block
+    static void decodeAll(const Block& block, std::vector<entry_type>& out) {
+        out.clear();
+        out.reserve(block.count + 1);
+        entry_type cur = block.first;
+        out.push_back(cur);
+        const uint8_t* pos = block.data.data();
+        for (uint32_t i = 1; i < block.count; ++i) {
+            decode(pos, cur);
+            out.push_back(cur);
+        }
+    }
+
+    // sets the content of the given block to the given, ordered range of tuples
+    static void encodeAll(Block& block, const entry_type* a, const entry_type* b) {
+        assert(a < b);
+        std::vector<uint8_t> data;
+        for (auto cur = a + 1; cur < b; ++cur) {
+            encode(data, *(cur - 1), *cur);
+        }
+        data.shrink_to_fit();
+        block.data.swap(data);
+        block.first = *a;
+        block.last = *(b - 1);
+        block.count = b - a;
+    }
+
+    /* -- block management -- */
+
+    // creates a new block holding the given tuple, placed after the given block (if any)
+    Block* addBlock(Block* pred, const entry_type& t) {
+        std::unique_ptr<Block> block(new Block(t));
+        Block* res = block.get();
+        if (pred == nullptr) {
+            res->next = head;
+            head = res;
+        } else {
+            res->next = pred->next;
+            pred->next = res;
+        }
+        blocks.emplace(t, std::move(block));
+        return res;
+    }
+
+    // checks whether the given tuple belongs into the given block
+    bool covers(const Block* block, const entry_type& t) const {
+        return !less()(t, block->first) && (block->next == nullptr || less()(t, block->next->first));
+    }
+
+    // obtains the block the given tuple belongs into, or null if it precedes all tuples
+    Block* findBlock(const entry_type& t) const {
+        auto pos = blocks.upper_bound(t);
+        if (pos == blocks.begin()) {
+            return nullptr;
+        }
+        return (--pos)->second.get();
+    }
+
+public:
+    /**
+     * The hints for operations on a set, caching the last accessed block.
+     * Hints are invalidated by clearing the set.
+     */
+    struct op_context {
+        Block* block = nullptr;
+    };
+
+    /**
+     * The statistics on the effectiveness of hints.
+     */
+    struct hint_statistics {
+        CacheAccessCounter inserts;
+        CacheAccessCounter contains;
+        CacheAccessCounter get_boundaries;
+    };
+
+private:
+    // the statistics of hints
+    mutable hint_statistics hint_stats;
+
+    // obtains the block the given tuple belongs into, utilizing the given hints
+    Block* findBlock(const entry_type& t, op_context& ctxt, CacheAccessCounter& counter) const {
+        if (ctxt.block != nullptr && covers(ctxt.block, t)) {
+            counter.addHit();
+            return ctxt.block;
+        }
+        counter.addMiss();
+        Block* res = findBlock(t);
+        if (res != nullptr) {
+            ctxt.block = res;
+        }
+        return res;
+    }
+
+public:
+    /**
+     * An iterator decoding the tuples of a set in order.
+     */
+    class iterator : public std::iterator<std::forward_iterator_tag, entry_type> {
+        // the current block, null for the end of the set
+        const Block* block = nullptr;
+
+        // the encoding of the next tuple in the current block
+        const uint8_t* pos = nullptr;
+
+        // the index of the current tuple in the current block
+        uint32_t index = 0;
+
+        // the current tuple
+        entry_type value;
+
+    public:
+        iterator() = default;
+
+        explicit iterator(const Block* block) : block(block) {
+            if (block != nullptr) {
+                value = block->first;
+                pos = block->data.data();
+            }
+        }
+
+        bool operator==(const iterator& other) const {
+            return block == other.block && index == other.index;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+        const entry_type& operator*() const {
+            return value;
+        }
+
+        const entry_type* operator->() const {
+            return &value;
+        }
+
+        iterator& operator++() {
+            if (++index < block->count) {
+                decode(pos, value);
+                return *this;
+            }
+            *this = iterator(block->next);
+            return *this;
+        }
+
+        iterator operator++(int) {
+            auto res = *this;
+            ++(*this);
+            return res;
+        }
+
+        // checks whether this iterator references a tuple in the given block
+        bool isIn(const Block* b) const {
+            return block == b;
+        }
+    };
+
+    using const_iterator = iterator;
+
+    CompressedSet() = default;
+
+    CompressedSet(const CompressedSet&) = delete;
+    CompressedSet& operator=(const CompressedSet&) = delete;
+
+    /**
+     * Inserts the given tuple into this set.
+     *
+     * @return true if the tuple was not present before, false otherwise
+     */
+    bool insert(const entry_type& t) {
+        op_context ctxt;
+        return insert(t, ctxt);
+    }
+
+    /**
+     * Inserts the given tuple into this set, utilizing the given hints.
+     *
+     * @return true if the tuple was not present before, false otherwise
+     */
+    bool insert(const entry_type& t, op_context& ctxt) {
+        auto lease = lock.acquire();
+        (void)lease;
+
+        // the first tuple of the set
+        if (head == nullptr) {
+            ctxt.block = addBlock(nullptr, t);
+            numTuples++;
+            return true;
+        }
+
+        Block* block = findBlock(t, ctxt, hint_stats.inserts);
+
+        // fast path: appending to a block
+        if (block != nullptr && less()(block->last, t)) {
+            if (block->count < BLOCK_SIZE) {
+                encode(block->data, block->last, t);
+                block->last = t;
+                if (++block->count == BLOCK_SIZE) {
+                    block->data.shrink_to_fit();
+                }
+            } else {
+                ctxt.block = addBlock(block, t);
+            }
+            numTuples++;
+            return true;
+        }
+
+        // the block's last tuple is already present
+        if (block != nullptr && !less()(t, block->last)) {
+            return false;
+        }
+
+        // tuples preceding all others are added to the first block
+        const bool first = (block == nullptr);
+        if (first) {
+            block = head;
+        }
+
+        // insert the tuple into the decoded content of the block
+        std::vector<entry_type> content;
+        decodeAll(*block, content);
+        auto pos = std::lower_bound(content.begin(), content.end(), t, less());
+        if (pos != content.end() && !less()(t, *pos)) {
+            return false;
+        }
+        content.insert(pos, t);
+        numTuples++;
+
+        // re-index the first block by its new first tuple
+        if (first) {
+            std::unique_ptr<Block> owner = std::move(blocks[block->first]);
+            blocks.erase(block->first);
+            blocks.emplace(t, std::move(owner));
+        }
+
+        // split full blocks into halves
+        const entry_type* a = content.data();
+        const entry_type* b = a + content.size();
+        if (content.size() <= BLOCK_SIZE) {
+            encodeAll(*block, a, b);
+            return true;
+        }
+        const entry_type* m = a + content.size() / 2;
+        encodeAll(*block, a, m);
+        encodeAll(*addBlock(block, *m), m, b);
+        return true;
+    }
+
+    /**
+     * Inserts all tuples of the given set into this set.
+     */
+    void insertAll(const CompressedSet& other) {
+        if (this == &other) {
+            return;
+        }
+        op_context ctxt;
+        for (const auto& cur : other) {
+            insert(cur, ctxt);
+        }
+    }
+
+    /**
+     * Determines whether the given tuple is present in this set.
+     */
+    bool contains(const entry_type& t) const {
+        op_context ctxt;
+        return contains(t, ctxt);
+    }
+
+    /**
+     * Determines whether the given tuple is present in this set, utilizing the given hints.
+     */
+    bool contains(const entry_type& t, op_context& ctxt) const {
+        if (head == nullptr) {
+            return false;
+        }
+        const Block* block = findBlock(t, ctxt, hint_stats.contains);
+        if (block == nullptr || less()(block->last, t)) {
+            return false;
+        }
+        for (iterator it(block); it.isIn(block); ++it) {
+            if (!less()(*it, t)) {
+                return !less()(t, *it);
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Obtains an iterator referencing the given tuple, or the end of this set if it is not present.
+     */
+    iterator find(const entry_type& t) const {
+        op_context ctxt;
+        return find(t, ctxt);
+    }
+
+    iterator find(const entry_type& t, op_context& ctxt) const {
+        auto pos = lower_bound(t, ctxt);
+        return (pos != end() && !less()(t, *pos)) ? pos : end();
+    }
+
+    /**
+     * Obtains an iterator referencing the first tuple not less than the given tuple.
+     */
+    iterator lower_bound(const entry_type& t) const {
+        op_context ctxt;
+        return lower_bound(t, ctxt);
+    }
+
+    iterator lower_bound(const entry_type& t, op_context& ctxt) const {
+        if (head == nullptr) {
+            return end();
+        }
+        const Block* block = findBlock(t, ctxt, hint_stats.get_boundaries);
+        if (block == nullptr) {
+            return begin();
+        }
+        iterator it(block);
+        while (it.isIn(block) && less()(*it, t)) {
+            ++it;
+        }
+        return it;
+    }
+
+    /**
+     * Obtains an iterator referencing the first tuple greater than the given tuple.
+     */
+    iterator upper_bound(const entry_type& t) const {
+        op_context ctxt;
+        return upper_bound(t, ctxt);
+    }
+
+    iterator upper_bound(const entry_type& t, op_context& ctxt) const {
+        if (head == nullptr) {
+            return end();
+        }
+        const Block* block = findBlock(t, ctxt, hint_stats.get_boundaries);
+        if (block == nullptr) {
+            return begin();
+        }
+        iterator it(block);
+        while (it.isIn(block) && !less()(t, *it)) {
+            ++it;
+        }
+        return it;
+    }
+
+    /**
+     * Obtains the range of tuples sharing the first levels columns with the given tuple.
+     */
+    template <unsigned levels>
+    range<iterator> getBoundaries(const entry_type& t) const {
+        op_context ctxt;
+        return getBoundaries<levels>(t, ctxt);
+    }
+
+    template <unsigned levels>
+    range<iterator> getBoundaries(const entry_type& t, op_context& ctxt) const {
+        if (levels == 0) {
+            return range<iterator>(begin(), end());
+        }
+        entry_type low = t;
+        entry_type high = t;
+        for (unsigned i = levels; i < N; ++i) {
+            low[i] = MIN_RAM_DOMAIN;
+            high[i] = MAX_RAM_DOMAIN;
+        }
+        auto a = lower_bound(low, ctxt);
+        return range<iterator>(a, upper_bound(high, ctxt));
+    }
+
+    /**
+     * Partitions this set into approximately the given number of ranges,
+     * each covering whole blocks.
+     */
+    std::vector<range<iterator>> partition(std::size_t num) const {
+        std::vector<range<iterator>> res;
+        if (head == nullptr) {
+            return res;
+        }
+        const std::size_t step = std::max<std::size_t>(1, blocks.size() / std::max<std::size_t>(1, num));
+        const Block* cur = head;
+        while (cur != nullptr) {
+            const Block* next = cur;
+            for (std::size_t i = 0; i < step && next != nullptr; ++i) {
+                next = next->next;
+            }
+            res.push_back(range<iterator>(iterator(cur), iterator(next)));
+            cur = next;
+        }
+        return res;
+    }
+
+    iterator begin() const {
+        return iterator(head);
+    }
+
+    iterator end() const {
+        return iterator();
+    }
+
+    bool empty() const {
+        return head == nullptr;
+    }
+
+    std::size_t size() const {
+        return numTuples;
+    }
+
+    /**
+     * Obtains an estimate of the number of bytes occupied by this set.
+     */
+    std::size_t getMemoryUsage() const {
+        // the size of a node of the block index
+        const std::size_t indexNode = 4 * sizeof(void*) + sizeof(entry_type) + sizeof(std::unique_ptr<Block>);
+        std::size_t res = sizeof(*this);
+        for (const Block* cur = head; cur != nullptr; cur = cur->next) {
+            res += indexNode + sizeof(Block) + cur->data.capacity();
+        }
+        return res;
+    }
+
+    /**
+     * Removes all tuples from this set.
+     */
+    void clear() {
+        blocks.clear();
+        head = nullptr;
+        numTuples = 0;
+    }
+
+    const hint_statistics& getHintStatistics() const {
+        return hint_stats;
+    }
+};
+
+}  // end namespace souffle
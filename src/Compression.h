@@ -0,0 +1,261 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Compression.h
+ *
+ * Compression of fact and output files in independent blocks, such that
+ * the blocks are compressed, and for zstd decompressed, concurrently.
+ *
+ * A gzip compressed file is a sequence of gzip members, one per block, as
+ * written by pigz; any gzip reader decompresses the concatenation. A zstd
+ * compressed file is a sequence of zstd frames, one per block, each
+ * recording the size of its content.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef USE_LIBZ
+#include <zlib.h>
+#endif
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace souffle {
+
+namespace compression {
+
+/** The formats of compressed files */
+enum class Format { GZIP, ZSTD };
+
+#ifdef USE_LIBZ
+/** Compress a block into a gzip member */
+inline std::string gzipBlock(const std::string& block) {
+    z_stream stream = {};
+    // a window of 15 bits, with 16 added for a gzip header
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("Cannot initialise gzip compression");
+    }
+    std::string out(deflateBound(&stream, block.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(block.data()));
+    stream.avail_in = block.size();
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = out.size();
+    const int result = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        throw std::runtime_error("Cannot compress a block with gzip");
+    }
+    return out;
+}
+#endif
+
+#ifdef USE_ZSTD
+/** Compress a block into a zstd frame */
+inline std::string zstdBlock(const std::string& block) {
+    std::string out(ZSTD_compressBound(block.size()), '\0');
+    const size_t size = ZSTD_compress(&out[0], out.size(), block.data(), block.size(), ZSTD_CLEVEL_DEFAULT);
+    if (ZSTD_isError(size)) {
+        throw std::runtime_error(
+                std::string("Cannot compress a block with zstd: ") + ZSTD_getErrorName(size));
+    }
+    out.resize(size);
+    return out;
+}
+
+/** Whether a file starts with the magic number of a zstd frame */
+inline bool isZstd(const char* data, size_t size) {
+    return size >= 4 && static_cast<unsigned char>(data[0]) == 0x28 &&
+           static_cast<unsigned char>(data[1]) == 0xb5 && static_cast<unsigned char>(data[2]) == 0x2f &&
+           static_cast<unsigned char>(data[3]) == 0xfd;
+}
+
+/**
+ * Decompress a sequence of zstd frames. Frames recording the size of their
+ * content, as those written by BlockCompressor, are decompressed
+ * concurrently, others with a streaming decompression of their own.
+ */
+inline std::string zstdDecompress(const char* data, size_t size) {
+    // locate the frames and the positions of their content
+    std::vector<size_t> frames(1, 0);
+    std::vector<size_t> offsets(1, 0);
+    bool knownSizes = true;
+    while (frames.back() < size) {
+        const char* frame = data + frames.back();
+        const size_t remaining = size - frames.back();
+        const size_t frameSize = ZSTD_findFrameCompressedSize(frame, remaining);
+        if (ZSTD_isError(frameSize)) {
+            throw std::invalid_argument(std::string("Corrupt zstd file: ") + ZSTD_getErrorName(frameSize));
+        }
+        const unsigned long long contentSize = ZSTD_getFrameContentSize(frame, remaining);
+        if (contentSize == ZSTD_CONTENTSIZE_ERROR || contentSize == ZSTD_CONTENTSIZE_UNKNOWN) {
+            knownSizes = false;
+        }
+        frames.push_back(frames.back() + frameSize);
+        offsets.push_back(offsets.back() + (knownSizes ? contentSize : 0));
+    }
+
+    if (!knownSizes) {
+        std::string out;
+        ZSTD_DStream* stream = ZSTD_createDStream();
+        ZSTD_initDStream(stream);
+        ZSTD_inBuffer in = {data, size, 0};
+        std::string chunk(ZSTD_DStreamOutSize(), '\0');
+        while (in.pos < in.size) {
+            ZSTD_outBuffer outBuffer = {&chunk[0], chunk.size(), 0};
+            const size_t result = ZSTD_decompressStream(stream, &outBuffer, &in);
+            if (ZSTD_isError(result)) {
+                ZSTD_freeDStream(stream);
+                throw std::invalid_argument(std::string("Corrupt zstd file: ") + ZSTD_getErrorName(result));
+            }
+            out.append(chunk.data(), outBuffer.pos);
+        }
+        ZSTD_freeDStream(stream);
+        return out;
+    }
+
+    std::string out(offsets.back(), '\0');
+    const int numFrames = frames.size() - 1;
+    bool corrupt = false;
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < numFrames; ++i) {
+        const size_t written = ZSTD_decompress(&out[0] + offsets[i], offsets[i + 1] - offsets[i],
+                data + frames[i], frames[i + 1] - frames[i]);
+        if (ZSTD_isError(written) || written != offsets[i + 1] - offsets[i]) {
+#pragma omp atomic write
+            corrupt = true;
+        }
+    }
+    if (corrupt) {
+        throw std::invalid_argument("Corrupt zstd file");
+    }
+    return out;
+}
+#endif
+
+/**
+ * Writes compressed data to a stream. The data is collected into blocks,
+ * which are compressed concurrently whenever there is a block for each
+ * thread, and written in order.
+ */
+class BlockCompressor {
+public:
+    /** the size of the uncompressed blocks */
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+    BlockCompressor(std::ostream& out, Format format) : out(out), format(format) {
+#ifdef _OPENMP
+        blocks.resize(omp_get_max_threads());
+#else
+        blocks.resize(1);
+#endif
+#ifndef USE_LIBZ
+        if (format == Format::GZIP) {
+            throw std::invalid_argument("Souffle was built without gzip compression");
+        }
+#endif
+#ifndef USE_ZSTD
+        if (format == Format::ZSTD) {
+            throw std::invalid_argument("Souffle was built without zstd compression, see --enable-zstd");
+        }
+#endif
+    }
+
+    BlockCompressor(const BlockCompressor&) = delete;
+
+    ~BlockCompressor() {
+        try {
+            flush();
+        } catch (...) {
+            // Don't throw exceptions.
+        }
+    }
+
+    void write(const char* data, size_t size) {
+        while (size > 0) {
+            std::string& block = blocks[filled];
+            const size_t space = BLOCK_SIZE - block.size();
+            const size_t part = std::min(size, space);
+            block.append(data, part);
+            data += part;
+            size -= part;
+            if (block.size() == BLOCK_SIZE && ++filled == blocks.size()) {
+                flush();
+            }
+        }
+    }
+
+    void write(const std::string& data) {
+        write(data.data(), data.size());
+    }
+
+    /** Compress and write the blocks collected so far */
+    void flush() {
+        const int count = filled + (filled < blocks.size() && !blocks[filled].empty() ? 1 : 0);
+        std::string error;
+#pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < count; ++i) {
+            try {
+                blocks[i] = compress(blocks[i]);
+            } catch (std::exception& e) {
+#pragma omp critical
+                error = e.what();
+            }
+        }
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+        for (int i = 0; i < count; ++i) {
+            out.write(blocks[i].data(), blocks[i].size());
+            blocks[i].clear();
+        }
+        filled = 0;
+    }
+
+private:
+    std::string compress(const std::string& block) const {
+#ifdef USE_ZSTD
+        if (format == Format::ZSTD) {
+            return zstdBlock(block);
+        }
+#endif
+#ifdef USE_LIBZ
+        return gzipBlock(block);
+#else
+        return block;
+#endif
+    }
+
+    std::ostream& out;
+    const Format format;
+
+    /** the blocks collected, the first filled ones full */
+    std::vector<std::string> blocks;
+    size_t filled = 0;
+};
+
+}  // end of namespace compression
+
+}  // end of namespace souffle
@@ -18,7 +18,9 @@
 
 #include "Util.h"
 
+#include <deque>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <set>
 #include <utility>
@@ -195,6 +197,13 @@ public:
      */
     virtual bool update(Assignment<Var>& ass) const = 0;
 
+    /**
+     * Obtains the variables this constraint refers to. The constraint
+     * is re-evaluated by the solver whenever the value of one of them
+     * changes.
+     */
+    virtual std::vector<Var> getVariables() const = 0;
+
     /** Adds print support for constraints (debugging) */
     virtual void print(std::ostream& out) const = 0;
 
@@ -230,6 +239,10 @@ std::shared_ptr<Constraint<Var>> sub(const Var& a, const Var& b, const std::stri
             return meet_assign(ass[b], ass[a]);
         }
 
+        std::vector<Var> getVariables() const override {
+            return {a, b};
+        }
+
         void print(std::ostream& out) const override {
             out << a << " " << symbol << " " << b;
         }
@@ -260,6 +273,10 @@ std::shared_ptr<Constraint<Var>> sub(const Val& a, const Var& b, const std::stri
             return meet_assign(ass[b], a);
         }
 
+        std::vector<Var> getVariables() const override {
+            return {b};
+        }
+
         void print(std::ostream& out) const override {
             out << a << " " << symbol << " " << b;
         }
@@ -396,15 +413,39 @@ public:
      * @return an assignment representing a solution for this problem
      */
     Assignment<Var>& solve(Assignment<Var>& ass) const {
-        // this is the most naive version of a solver, but sound and complete
-        bool change = true;
-        while (change) {
-            change = false;
-            for (const auto& cur : constraints) {
-                change = cur->update(ass) || change;
+        // index the constraints referring to each variable
+        std::vector<std::vector<Var>> variables;
+        std::map<Var, std::vector<size_t>> dependents;
+        variables.reserve(constraints.size());
+        for (size_t i = 0; i < constraints.size(); i++) {
+            variables.push_back(constraints[i]->getVariables());
+            for (const auto& var : variables.back()) {
+                dependents[var].push_back(i);
+            }
+        }
+
+        // every constraint is applied once, in order, and again whenever one of its variables changed
+        std::deque<size_t> worklist;
+        std::vector<bool> pending(constraints.size(), true);
+        for (size_t i = 0; i < constraints.size(); i++) {
+            worklist.push_back(i);
+        }
+        while (!worklist.empty()) {
+            size_t cur = worklist.front();
+            worklist.pop_front();
+            pending[cur] = false;
+            if (!constraints[cur]->update(ass)) {
+                continue;
+            }
+            for (const auto& var : variables[cur]) {
+                for (size_t dependent : dependents.find(var)->second) {
+                    if (!pending[dependent]) {
+                        pending[dependent] = true;
+                        worklist.push_back(dependent);
+                    }
+                }
             }
         }
-        // already done
         return ass;
     }
 
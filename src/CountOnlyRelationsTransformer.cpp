@@ -0,0 +1,109 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file CountOnlyRelationsTransformer.cpp
+ *
+ * Define classes and functionality related to the representation of
+ * relations whose tuples are only counted.
+ *
+ ***********************************************************************/
+
+#include "AstArgument.h"
+#include "AstClause.h"
+#include "AstIOTypeAnalysis.h"
+#include "AstLiteral.h"
+#include "AstProgram.h"
+#include "AstRelation.h"
+#include "AstRelationIdentifier.h"
+#include "AstTransforms.h"
+#include "AstTranslationUnit.h"
+#include "AstVisitor.h"
+#include "DebugReport.h"
+#include "Global.h"
+#include "RelationRepresentation.h"
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+
+namespace souffle {
+
+/**
+ * A relation is only counted if it is not read or written by IO other than
+ * .printsize and each of its atoms in a body is the only atom of a count
+ * aggregate. Such a relation is scanned for the count only, or searched by
+ * the constants and bound variables of the aggregate, such that a hash set
+ * deduplicating its tuples takes the place of the b-tree of its main index.
+ */
+bool CountOnlyRelationsTransformer::transform(AstTranslationUnit& translationUnit) {
+    AstProgram& program = *translationUnit.getProgram();
+    const auto* ioType = translationUnit.getAnalysis<IOType>();
+
+    // the counted atoms, and the relations of the atoms read otherwise
+    std::set<const AstAtom*> counted;
+    std::set<AstRelationIdentifier> read;
+    std::map<AstRelationIdentifier, size_t> counts;
+    visitDepthFirst(program, [&](const AstAggregator& aggr) {
+        if (aggr.getOperator() != AstAggregator::count) {
+            return;
+        }
+        const AstAtom* atom = nullptr;
+        size_t numAtoms = 0;
+        for (const AstLiteral* lit : aggr.getBodyLiterals()) {
+            if (const auto* cur = dynamic_cast<const AstAtom*>(lit)) {
+                atom = cur;
+                numAtoms++;
+            }
+        }
+        if (numAtoms == 1) {
+            counted.insert(atom);
+            counts[atom->getName()]++;
+        }
+    });
+    for (const AstRelation* rel : program.getRelations()) {
+        for (const AstClause* clause : rel->getClauses()) {
+            visitDepthFirst(*clause, [&](const AstAtom& atom) {
+                if (&atom != clause->getHead() && counted.count(&atom) == 0) {
+                    read.insert(atom.getName());
+                }
+            });
+        }
+    }
+
+    bool changed = false;
+    std::stringstream report;
+    for (AstRelation* rel : program.getRelations()) {
+        const AstRelationIdentifier& name = rel->getName();
+        if (rel->getArity() == 0 || rel->getRepresentation() != RelationRepresentation::DEFAULT ||
+                rel->isSubsumptive() || rel->getFactTable() != nullptr || ioType->isInput(rel) ||
+                ioType->isOutput(rel) || read.count(name) != 0) {
+            continue;
+        }
+        if (!ioType->isPrintSize(rel) && counts[name] == 0) {
+            continue;
+        }
+        rel->setRepresentation(RelationRepresentation::HASHSET);
+        changed = true;
+        report << name << ": hash set, counted by " << (ioType->isPrintSize(rel) ? ".printsize and " : "")
+               << counts[name] << " count aggregates\n";
+    }
+
+    if (Global::config().has("verbose")) {
+        std::cout << report.str();
+    }
+    if (DebugReport::isSelected("count-only-relations")) {
+        translationUnit.getDebugReport().addSection(DebugReporter::getCodeSection(
+                "count-only-relations", "Count-Only Relations", report.str()));
+    }
+    return changed;
+}
+
+}  // end of namespace souffle
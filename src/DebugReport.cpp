@@ -19,11 +19,15 @@
 #include "AstTypeAnalysis.h"
 #include "AstTypeEnvironmentAnalysis.h"
 #include "PrecedenceGraph.h"
+#include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <iomanip>
 #include <ostream>
 #include <sstream>
+#include <unordered_map>
 #include <utility>
+#include <sys/resource.h>
 
 namespace souffle {
 
@@ -67,6 +71,14 @@ static std::string toBase64(const std::string& data) {
     return result;
 }
 
+/** Escapes code to be shown in HTML */
+static std::string escapeCode(std::string code) {
+    for (size_t i = code.find('<'); i != std::string::npos; i = code.find('<', i)) {
+        code.replace(i, 1, "&lt;");
+    }
+    return code;
+}
+
 void DebugReportSection::printIndex(std::ostream& out) const {
     out << "<a href=\"#" << id << "\">" << title << "</a>\n";
     out << "<ul>\n";
@@ -100,13 +112,209 @@ void DebugReportSection::printTitle(std::ostream& out) const {
 void DebugReportSection::printContent(std::ostream& out) const {
     printTitle(out);
     out << "<div style='padding-left: 1em'>\n";
-    out << body << "\n";
+    if (render) {
+        out << render() << "\n";
+    } else {
+        out << body << "\n";
+    }
     for (const DebugReportSection& subsection : subsections) {
         subsection.printContent(out);
     }
     out << "</div>\n";
 }
 
+void DebugReport::addPassStatistics(const std::string& pass, double seconds, size_t memory, bool changed) {
+    auto pos = passPositions.find(pass);
+    if (pos == passPositions.end()) {
+        pos = passPositions.emplace(pass, passes.size()).first;
+        passes.emplace_back();
+        passes.back().pass = pass;
+    }
+    PassStatistics& statistics = passes[pos->second];
+    statistics.applications++;
+    statistics.changes += changed ? 1 : 0;
+    statistics.seconds += seconds;
+    statistics.memory += memory;
+}
+
+bool DebugReport::isSelected(const std::string& kind) {
+    const std::string& selection = Global::config().get("debug-report-sections");
+    if (selection.empty()) {
+        return true;
+    }
+    for (const std::string& selected : splitString(selection, ',')) {
+        if (selected == kind) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DebugReport::isNewVersion(const std::string& kind, const std::string& code) {
+    std::vector<std::string> lines = splitString(code, '\n');
+    std::vector<std::string>& latest = latestVersions[kind];
+    if (!latest.empty() && latest == lines) {
+        return false;
+    }
+    latest = std::move(lines);
+    return true;
+}
+
+DebugReportSection DebugReport::getCodeVersionSection(
+        const std::string& kind, const std::string& id, std::string title, const std::string& code) {
+    std::vector<std::string> lines = splitString(code, '\n');
+    auto latest = latestVersions.find(kind);
+    if (latest == latestVersions.end()) {
+        latestVersions.emplace(kind, std::move(lines));
+        return DebugReporter::getCodeSection(id, std::move(title), code);
+    }
+
+    // only the changes are kept, rendered once the report is printed
+    auto changes = std::make_shared<const std::vector<CodeChange>>(diffLines(latest->second, lines));
+    latest->second = std::move(lines);
+    if (changes->empty()) {
+        return DebugReportSection(id, std::move(title) + " (unchanged)", {}, "");
+    }
+    return DebugReportSection(id, std::move(title), {}, [changes]() {
+        std::stringstream html;
+        html << "<pre>";
+        for (const CodeChange& change : *changes) {
+            html << "<span style='color:grey'>@@ line " << change.line << " @@</span>\n";
+            for (const std::string& line : change.removed) {
+                html << "<span style='color:red'>- " << escapeCode(line) << "</span>\n";
+            }
+            for (const std::string& line : change.added) {
+                html << "<span style='color:green'>+ " << escapeCode(line) << "</span>\n";
+            }
+        }
+        html << "</pre>\n";
+        return html.str();
+    });
+}
+
+std::vector<DebugReport::CodeChange> DebugReport::diffLines(
+        const std::vector<std::string>& from, const std::vector<std::string>& to) {
+    // transformation passes change few places, hence most lines are shared at the start and at the end
+    size_t prefix = 0;
+    while (prefix < from.size() && prefix < to.size() && from[prefix] == to[prefix]) {
+        ++prefix;
+    }
+    size_t suffix = 0;
+    while (suffix < from.size() - prefix && suffix < to.size() - prefix &&
+            from[from.size() - suffix - 1] == to[to.size() - suffix - 1]) {
+        ++suffix;
+    }
+    const int n = from.size() - prefix - suffix;
+    const int m = to.size() - prefix - suffix;
+    if (n == 0 && m == 0) {
+        return {};
+    }
+
+    // number the remaining lines, such that they are compared as integers
+    std::unordered_map<std::string, int> numbers;
+    std::vector<int> a(n);
+    std::vector<int> b(m);
+    for (int i = 0; i < n; ++i) {
+        a[i] = numbers.emplace(from[prefix + i], numbers.size()).first->second;
+    }
+    for (int j = 0; j < m; ++j) {
+        b[j] = numbers.emplace(to[prefix + j], numbers.size()).first->second;
+    }
+
+    // Myers' algorithm, tracing the furthest line of each diagonal k reached with d edits,
+    // kept at trace[d][k + d]
+    const int maxEdits = std::min(n + m, 1000);
+    std::vector<std::vector<int>> trace;
+    bool reached = false;
+    for (int d = 0; d <= maxEdits && !reached; ++d) {
+        trace.emplace_back(2 * d + 1, 0);
+        for (int k = -d; k <= d && !reached; k += 2) {
+            int x = 0;
+            if (d > 0) {
+                const std::vector<int>& previous = trace[d - 1];
+                bool down = (k == -d || (k != d && previous[k - 1 + d - 1] < previous[k + 1 + d - 1]));
+                x = down ? previous[k + 1 + d - 1] : previous[k - 1 + d - 1] + 1;
+            }
+            int y = x - k;
+            while (x < n && y < m && a[x] == b[y]) {
+                ++x;
+                ++y;
+            }
+            trace[d][k + d] = x;
+            reached = (x >= n && y >= m);
+        }
+    }
+
+    // the lines kept, from the last to the first, followed by the start as a sentinel
+    std::vector<std::pair<int, int>> kept;
+    if (reached) {
+        int x = n;
+        int y = m;
+        for (int d = trace.size() - 1; d > 0; --d) {
+            const std::vector<int>& previous = trace[d - 1];
+            const int k = x - y;
+            bool down = (k == -d || (k != d && previous[k - 1 + d - 1] < previous[k + 1 + d - 1]));
+            const int previousK = down ? k + 1 : k - 1;
+            const int previousX = previous[previousK + d - 1];
+            const int previousY = previousX - previousK;
+            // the lines kept after the edit
+            while (x > previousX + (down ? 0 : 1) && y > previousY + (down ? 1 : 0)) {
+                kept.emplace_back(--x, --y);
+            }
+            x = previousX;
+            y = previousY;
+        }
+        while (x > 0 && y > 0) {
+            kept.emplace_back(--x, --y);
+        }
+    }
+    kept.emplace_back(-1, -1);
+
+    // the lines between two kept lines are changed
+    std::vector<CodeChange> changes;
+    std::pair<int, int> next(n, m);
+    for (const auto& cur : kept) {
+        if (cur.first + 1 < next.first || cur.second + 1 < next.second) {
+            changes.emplace_back();
+            CodeChange& change = changes.back();
+            change.line = prefix + cur.first + 2;
+            change.removed.assign(from.begin() + prefix + cur.first + 1, from.begin() + prefix + next.first);
+            change.added.assign(to.begin() + prefix + cur.second + 1, to.begin() + prefix + next.second);
+        }
+        next = cur;
+    }
+    std::reverse(changes.begin(), changes.end());
+    return changes;
+}
+
+size_t DebugReport::getPeakMemory() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+DebugReportSection DebugReport::getPassStatisticsSection() const {
+    std::stringstream table;
+    double totalSeconds = 0;
+    size_t totalMemory = 0;
+    table << "<table>\n";
+    table << "<tr><th align='left'>Pass</th><th>Applications</th><th>Changed</th><th>Time (s)</th>"
+             "<th>Peak Memory Growth (kB)</th></tr>\n";
+    for (const PassStatistics& cur : passes) {
+        table << "<tr><td>" << cur.pass << "</td><td align='right'>" << cur.applications
+              << "</td><td align='right'>" << cur.changes << "</td><td align='right'>" << std::fixed
+              << std::setprecision(6) << cur.seconds << "</td><td align='right'>" << cur.memory
+              << "</td></tr>\n";
+        totalSeconds += cur.seconds;
+        totalMemory += cur.memory;
+    }
+    table << "<tr><th align='left'>Total</th><td></td><td></td><th align='right'>" << std::fixed
+          << std::setprecision(6) << totalSeconds << "</th><th align='right'>" << totalMemory
+          << "</th></tr>\n";
+    table << "</table>\n";
+    return DebugReportSection("pass-statistics", "Transformation Passes", {}, table.str());
+}
+
 void DebugReport::print(std::ostream& out) const {
     out << "<!DOCTYPE html>\n";
     out << "<html>\n";
@@ -139,10 +347,14 @@ void DebugReport::print(std::ostream& out) const {
     out << "</head>\n";
     out << "<body>\n";
     out << "<div class='headerdiv'><h1>Souffle Debug Report</h1></div>\n";
-    for (const DebugReportSection& section : sections) {
+    std::vector<DebugReportSection> allSections = sections;
+    if (!passes.empty() && isSelected("passes")) {
+        allSections.push_back(getPassStatisticsSection());
+    }
+    for (const DebugReportSection& section : allSections) {
         section.printIndex(out);
     }
-    for (const DebugReportSection& section : sections) {
+    for (const DebugReportSection& section : allSections) {
         section.printContent(out);
     }
     out << "<a href='#'>(return to top)</a>\n";
@@ -152,53 +364,47 @@ void DebugReport::print(std::ostream& out) const {
 
 DebugReportSection DebugReporter::getCodeSection(const std::string& id, std::string title, std::string code) {
     std::stringstream codeHTML;
-    std::string escapedCode = std::move(code);
-    while (true) {
-        size_t i = escapedCode.find("<");
-        if (i == std::string::npos) {
-            break;
-        }
-        escapedCode.replace(i, 1, "&lt;");
-    }
-    codeHTML << "<pre>" << escapedCode << "</pre>\n";
+    codeHTML << "<pre>" << escapeCode(std::move(code)) << "</pre>\n";
     return DebugReportSection(id, std::move(title), {}, codeHTML.str());
 }
 
 DebugReportSection DebugReporter::getDotGraphSection(
         const std::string& id, std::string title, const std::string& dotSpec) {
-    std::string tempFileName = tempFile();
-    {
-        std::ofstream dotFile(tempFileName);
-        dotFile << dotSpec;
-    }
-
-    std::string cmd = "dot -Tsvg < " + tempFileName;
-    FILE* in = popen(cmd.c_str(), "r");
-    std::stringstream data;
-    while (in != nullptr) {
-        char c = fgetc(in);
-        if (feof(in)) {
-            break;
+    // running dot is costly, hence deferred until the report is printed
+    const std::string sourceId = id + "-source";
+    return DebugReportSection(id, std::move(title), {}, [sourceId, dotSpec]() {
+        std::string tempFileName = tempFile();
+        {
+            std::ofstream dotFile(tempFileName);
+            dotFile << dotSpec;
         }
-        data << c;
-    }
-    pclose(in);
-    remove(tempFileName.c_str());
 
-    std::stringstream graphHTML;
-    if (data.str().find("<svg") != std::string::npos) {
-        graphHTML << "<img alt='graph image' src='data:image/svg+xml;base64," << toBase64(data.str())
-                  << "'><br/>\n";
-    } else {
-        graphHTML << "<p>(error: unable to generate dot graph image)</p>";
-    }
-    graphHTML << "<a href=\"javascript:toggleVisibility('" << id << "-source"
-              << "')\">(show dot source)</a>\n";
-    graphHTML << "<div id='" << id << "-source"
-              << "' style='display:none'>\n";
-    graphHTML << "<pre>" << dotSpec << "</pre>\n";
-    graphHTML << "</div>\n";
-    return DebugReportSection(id, std::move(title), {}, graphHTML.str());
+        std::string cmd = "dot -Tsvg < " + tempFileName;
+        FILE* in = popen(cmd.c_str(), "r");
+        std::stringstream data;
+        while (in != nullptr) {
+            char c = fgetc(in);
+            if (feof(in)) {
+                break;
+            }
+            data << c;
+        }
+        pclose(in);
+        remove(tempFileName.c_str());
+
+        std::stringstream graphHTML;
+        if (data.str().find("<svg") != std::string::npos) {
+            graphHTML << "<img alt='graph image' src='data:image/svg+xml;base64," << toBase64(data.str())
+                      << "'><br/>\n";
+        } else {
+            graphHTML << "<p>(error: unable to generate dot graph image)</p>";
+        }
+        graphHTML << "<a href=\"javascript:toggleVisibility('" << sourceId << "')\">(show dot source)</a>\n";
+        graphHTML << "<div id='" << sourceId << "' style='display:none'>\n";
+        graphHTML << "<pre>" << dotSpec << "</pre>\n";
+        graphHTML << "</div>\n";
+        return graphHTML.str();
+    });
 }
 
 bool DebugReporter::transform(AstTranslationUnit& translationUnit) {
@@ -209,7 +415,8 @@ bool DebugReporter::transform(AstTranslationUnit& translationUnit) {
     if (changed) {
         generateDebugReport(translationUnit, wrappedTransformer->getName(),
                 "After " + wrappedTransformer->getName() + " " + runtimeStr);
-    } else {
+    } else if (DebugReport::isSelected("datalog") || DebugReport::isSelected("types") ||
+               DebugReport::isSelected("graphs")) {
         translationUnit.getDebugReport().addSection(DebugReportSection(wrappedTransformer->getName(),
                 "After " + wrappedTransformer->getName() + " " + runtimeStr + " (unchanged)", {}, ""));
     }
@@ -218,39 +425,52 @@ bool DebugReporter::transform(AstTranslationUnit& translationUnit) {
 
 void DebugReporter::generateDebugReport(
         AstTranslationUnit& translationUnit, const std::string& id, std::string title) {
-    std::stringstream datalogSpec;
-    translationUnit.getProgram()->print(datalogSpec);
-
-    DebugReportSection datalogSection = getCodeSection(id + "-dl", "Datalog", datalogSpec.str());
-
-    std::stringstream typeAnalysis;
-    translationUnit.getAnalysis<TypeAnalysis>()->print(typeAnalysis);
-    DebugReportSection typeAnalysisSection = getCodeSection(id + "-ta", "Type Analysis", typeAnalysis.str());
-
-    std::stringstream typeEnvironmentAnalysis;
-    translationUnit.getAnalysis<TypeEnvironmentAnalysis>()->print(typeEnvironmentAnalysis);
-    DebugReportSection typeEnvironmentAnalysisSection =
-            getCodeSection(id + "-tea", "Type Environment Analysis", typeEnvironmentAnalysis.str());
-
-    std::stringstream precGraphDot;
-    translationUnit.getAnalysis<PrecedenceGraph>()->print(precGraphDot);
-    DebugReportSection precedenceGraphSection =
-            getDotGraphSection(id + "-prec-graph", "Precedence Graph", precGraphDot.str());
-
-    std::stringstream sccGraphDot;
-    translationUnit.getAnalysis<SCCGraph>()->print(sccGraphDot);
-    DebugReportSection sccGraphSection =
-            getDotGraphSection(id + "-scc-graph", "SCC Graph", sccGraphDot.str());
-
-    std::stringstream topsortSCCGraph;
-    translationUnit.getAnalysis<TopologicallySortedSCCGraph>()->print(topsortSCCGraph);
-    DebugReportSection topsortSCCGraphSection =
-            getCodeSection(id + "-topsort-scc-graph", "SCC Topological Sort Order", topsortSCCGraph.str());
-
-    translationUnit.getDebugReport().addSection(DebugReportSection(id, std::move(title),
-            {datalogSection, typeAnalysisSection, typeEnvironmentAnalysisSection, precedenceGraphSection,
-                    sccGraphSection, topsortSCCGraphSection},
-            ""));
+    DebugReport& report = translationUnit.getDebugReport();
+    std::vector<DebugReportSection> subsections;
+
+    if (DebugReport::isSelected("datalog")) {
+        std::stringstream datalogSpec;
+        translationUnit.getProgram()->print(datalogSpec);
+        subsections.push_back(
+                report.getCodeVersionSection("datalog", id + "-dl", "Datalog", datalogSpec.str()));
+    }
+
+    if (DebugReport::isSelected("types")) {
+        std::stringstream typeAnalysis;
+        translationUnit.getAnalysis<TypeAnalysis>()->print(typeAnalysis);
+        subsections.push_back(report.getCodeVersionSection(
+                "type-analysis", id + "-ta", "Type Analysis", typeAnalysis.str()));
+
+        std::stringstream typeEnvironmentAnalysis;
+        translationUnit.getAnalysis<TypeEnvironmentAnalysis>()->print(typeEnvironmentAnalysis);
+        subsections.push_back(report.getCodeVersionSection("type-environment", id + "-tea",
+                "Type Environment Analysis", typeEnvironmentAnalysis.str()));
+    }
+
+    if (DebugReport::isSelected("graphs")) {
+        // graphs are only drawn again if they changed
+        std::stringstream precGraphDot;
+        translationUnit.getAnalysis<PrecedenceGraph>()->print(precGraphDot);
+        if (report.isNewVersion("precedence-graph", precGraphDot.str())) {
+            subsections.push_back(
+                    getDotGraphSection(id + "-prec-graph", "Precedence Graph", precGraphDot.str()));
+        }
+
+        std::stringstream sccGraphDot;
+        translationUnit.getAnalysis<SCCGraph>()->print(sccGraphDot);
+        if (report.isNewVersion("scc-graph", sccGraphDot.str())) {
+            subsections.push_back(getDotGraphSection(id + "-scc-graph", "SCC Graph", sccGraphDot.str()));
+        }
+
+        std::stringstream topsortSCCGraph;
+        translationUnit.getAnalysis<TopologicallySortedSCCGraph>()->print(topsortSCCGraph);
+        subsections.push_back(report.getCodeVersionSection("topsort-scc-graph", id + "-topsort-scc-graph",
+                "SCC Topological Sort Order", topsortSCCGraph.str()));
+    }
+
+    if (!subsections.empty()) {
+        report.addSection(DebugReportSection(id, std::move(title), std::move(subsections), ""));
+    }
 }
 
 }  // end of namespace souffle
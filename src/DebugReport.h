@@ -18,7 +18,10 @@
 #include "AstTransformer.h"
 #include "Global.h"
 
+#include <cstddef>
 #include <fstream>
+#include <functional>
+#include <map>
 #include <memory>
 #include <ostream>
 #include <set>
@@ -34,7 +37,8 @@ class AstTranslationUnit;
 /**
  * Class representing a section of a HTML report.
  * Consists of a unique identifier, a title, a number of subsections,
- * and the HTML code for the body of the section.
+ * and the HTML code for the body of the section, which may be rendered
+ * only once the report is printed.
  */
 class DebugReportSection {
 public:
@@ -43,6 +47,11 @@ public:
             : id(generateUniqueID(id)), title(std::move(title)), subsections(std::move(subsections)),
               body(std::move(body)) {}
 
+    DebugReportSection(const std::string& id, std::string title, std::vector<DebugReportSection> subsections,
+            std::function<std::string()> render)
+            : id(generateUniqueID(id)), title(std::move(title)), subsections(std::move(subsections)),
+              render(std::move(render)) {}
+
     /**
      * Outputs the HTML code for the index to the given stream,
      * consisting of a link to the section body followed by a list of
@@ -72,6 +81,9 @@ private:
     std::vector<DebugReportSection> subsections;
     std::string body;
 
+    /** renders the body, if it is not given */
+    std::function<std::string()> render;
+
     static std::string generateUniqueID(const std::string& id) {
         static int count = 0;
         return id + std::to_string(count++);
@@ -80,9 +92,22 @@ private:
 
 /**
  * Class representing a HTML report, consisting of a list of sections.
+ *
+ * Successive versions of the same code, such as the program after each
+ * transformation pass, are kept as their changes to the previous version
+ * only, and the report may be restricted to some kinds of sections
+ * (--debug-report-sections).
  */
 class DebugReport {
 public:
+    /** A change between two versions of code: lines replaced by others from a line of the earlier one */
+    struct CodeChange {
+        /** the first line replaced, from 1 */
+        size_t line;
+        std::vector<std::string> removed;
+        std::vector<std::string> added;
+    };
+
     ~DebugReport() {
         if (!empty()) {
             std::ofstream debugReportStream(Global::config().get("debug-report"));
@@ -90,13 +115,46 @@ public:
         }
     }
     bool empty() const {
-        return sections.empty();
+        return sections.empty() && passes.empty();
     }
 
     void addSection(const DebugReportSection& section) {
         sections.push_back(section);
     }
 
+    /**
+     * Whether sections of the given kind are reported, which are all kinds unless
+     * --debug-report-sections selects some.
+     */
+    static bool isSelected(const std::string& kind);
+
+    /**
+     * Generates a section for a version of the code of the given kind, holding its full text
+     * if it is the first version of the kind, or else only its changes to the previous version.
+     */
+    DebugReportSection getCodeVersionSection(
+            const std::string& kind, const std::string& id, std::string title, const std::string& code);
+
+    /** Records a version of the code of the given kind, returning whether it differs from the previous one */
+    bool isNewVersion(const std::string& kind, const std::string& code);
+
+    /**
+     * Computes the changes from one version of code to another, given as their lines. Larger
+     * numbers of changes are not minimised, but merged into one change.
+     */
+    static std::vector<CodeChange> diffLines(
+            const std::vector<std::string>& from, const std::vector<std::string>& to);
+
+    /**
+     * Records an application of a transformation pass, taking the given time in seconds
+     * and growing the peak memory usage of the process by the given number of kilobytes.
+     * The applications of a pass are summed up in a table of the report.
+     */
+    void addPassStatistics(const std::string& pass, double seconds, size_t memory, bool changed);
+
+    /** Returns the peak memory usage of the process in kilobytes */
+    static size_t getPeakMemory();
+
     /**
      * Outputs a complete HTML document to the given stream,
      * consisting of an index of all of the sections of the report,
@@ -110,7 +168,28 @@ public:
     }
 
 private:
+    /** The accumulated applications of a transformation pass */
+    struct PassStatistics {
+        std::string pass;
+        size_t applications = 0;
+        size_t changes = 0;
+        double seconds = 0;
+        size_t memory = 0;
+    };
+
     std::vector<DebugReportSection> sections;
+
+    /** statistics of the transformation passes, in the order of their first application */
+    std::vector<PassStatistics> passes;
+
+    /** position of the statistics of each pass */
+    std::map<std::string, size_t> passPositions;
+
+    /** the lines of the latest version of the code of each kind */
+    std::map<std::string, std::vector<std::string>> latestVersions;
+
+    /** Generates the section tabulating the statistics of the transformation passes */
+    DebugReportSection getPassStatisticsSection() const;
 };
 
 /**
@@ -161,6 +240,7 @@ public:
 
     /**
      * Generated a debug report section for a dot graph specification, with the given id and title.
+     * The graph is only rendered once the report is printed.
      */
     static DebugReportSection getDotGraphSection(
             const std::string& id, std::string title, const std::string& dotSpec);
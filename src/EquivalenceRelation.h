@@ -14,6 +14,10 @@
  * Pairs inserted into this relation implicitly store a reflexive, symmetric, and transitive relation
  * with each other.
  *
+ * The equivalence classes are cached as lists for iteration. The cache is maintained incrementally:
+ * insertions record the elements involved in structural changes, and only the classes containing
+ * those elements are rebuilt when the cache is requested next.
+ *
  ***********************************************************************/
 
 #pragma once
@@ -22,10 +26,12 @@
 #include "UnionFind.h"
 #include "Util.h"
 #include <algorithm>
+#include <atomic>
 #include <exception>
 #include <set>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace souffle {
 template <typename TupleType>
@@ -76,10 +82,10 @@ public:
      * @return true if the pair is new to the data structure
      */
     bool insert(value_type x, value_type y, operation_hints) {
-        // indicate that iterators will have to generate on request
-        this->statesMapStale.store(true, std::memory_order_relaxed);
         bool retval = contains(x, y);
-        sds.unionNodes(x, y);
+        if (!retval) {
+            unionNodes(x, y);
+        }
         return retval;
     }
 
@@ -90,19 +96,23 @@ public:
     void insertAll(const EquivalenceRelation<TupleType>& other) {
         other.genAllDisjointSetLists();
 
-        // iterate over partitions at a time
-        for (typename StatesMap::chunk it : other.equivalencePartition.getChunks(MAX_THREADS)) {
-            for (auto& p : it) {
+        // iterate over partitions at a time, in parallel as the unions are concurrent
+        std::vector<typename StatesMap::chunk> chunks = other.equivalencePartition.getChunks(MAX_THREADS * 4);
+        const int numChunks = chunks.size();
+#pragma omp parallel for schedule(dynamic) if (other.sds.ds.a_blocks.size() >= PARALLEL_SIZE)
+        for (int c = 0; c < numChunks; ++c) {
+            for (auto& p : chunks[c]) {
                 value_type rep = p.first;
                 StatesList& pl = *p.second;
                 const size_t ksize = pl.size();
                 for (size_t i = 0; i < ksize; ++i) {
-                    this->sds.unionNodes(rep, pl.get(i));
+                    const value_type cur = pl.get(i);
+                    if (!this->contains(rep, cur)) {
+                        this->unionNodes(rep, cur);
+                    }
                 }
             }
         }
-        // invalidate iterators unconditionally
-        this->statesMapStale.store(true, std::memory_order_relaxed);
     }
 
     /**
@@ -123,33 +133,33 @@ public:
         // find all the disjoint sets that need to be added to this relation
         // that exist in other (and exist in this)
         {
-            auto it = this->sds.sparseToDenseMap.begin();
-            auto end = this->sds.sparseToDenseMap.end();
-            value_type el;
-            for (; it != end; ++it) {
-                std::tie(el, std::ignore) = *it;
-                if (other.containsElement(el)) {
-                    value_type rep = other.sds.findNode(el);
-                    if (repsCovered.count(rep) == 0) {
-                        repsCovered.emplace(rep);
+            const size_t numElements = this->sds.ds.a_blocks.size();
+            std::vector<std::vector<value_type>> found(MAX_THREADS);
+            forParts(numElements, found.size(), [&](int part, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    value_type el = this->sds.toSparse(i);
+                    if (other.containsElement(el)) {
+                        found[part].push_back(other.sds.findNode(el));
                     }
                 }
+            });
+            for (const auto& reps : found) {
+                repsCovered.insert(reps.begin(), reps.end());
             }
         }
 
-        // add the intersecting dj sets into this one
+        // add the intersecting dj sets into this one, in parallel as the unions are concurrent
         {
-            value_type el;
-            value_type rep;
-            auto it = other.sds.sparseToDenseMap.begin();
-            auto end = other.sds.sparseToDenseMap.end();
-            for (; it != end; ++it) {
-                std::tie(el, std::ignore) = *it;
-                rep = other.sds.findNode(el);
-                if (repsCovered.count(rep) != 0) {
-                    this->insert(el, rep);
+            const size_t numElements = other.sds.ds.a_blocks.size();
+            forParts(numElements, MAX_THREADS * 4, [&](int, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    value_type el = other.sds.toSparse(i);
+                    value_type rep = other.sds.findNode(el);
+                    if (repsCovered.count(rep) != 0) {
+                        this->insert(el, rep);
+                    }
                 }
-            }
+            });
         }
     }
 
@@ -181,6 +191,10 @@ public:
 
         sds.clear();
         emptyPartition();
+        changedNodes.clear();
+        cachedReps.clear();
+        numCachedLists = 0;
+        numCachedClasses = 0;
 
         statesLock.unlock();
     }
@@ -222,9 +236,15 @@ public:
                 isEndVal = true;
                 return;
             }
-            // grab the pointer to the list, and make it our current list
+            // grab the pointer to the list, and make it our current list (skipping dissolved sets)
             djSetList = (*djSetMapListIt).second;
-            assert(djSetList->size() != 0);
+            while (djSetList->size() == 0) {
+                if (++djSetMapListIt == djSetMapListEnd) {
+                    isEndVal = true;
+                    return;
+                }
+                djSetList = (*djSetMapListIt).second;
+            }
 
             updateAnterior();
             updatePosterior();
@@ -322,17 +342,15 @@ public:
                         // move anterior along one
                         // see if we can't move the anterior along one
                         if (++cAnteriorIndex == djSetList->size()) {
-                            // move the djset it along one
+                            // move the djset it along one, skipping sets dissolved into others
                             // see if we can't move it along one (we're at the end)
-                            if (++djSetMapListIt == djSetMapListEnd) {
-                                isEndVal = true;
-                                return *this;
-                            }
-
-                            // we can't iterate along this djset if it is empty
-                            djSetList = (*djSetMapListIt).second;
-                            if (djSetList->size() == 0)
-                                throw std::out_of_range("error: encountered a zero size djset");
+                            do {
+                                if (++djSetMapListIt == djSetMapListEnd) {
+                                    isEndVal = true;
+                                    return *this;
+                                }
+                                djSetList = (*djSetMapListIt).second;
+                            } while (djSetList->size() == 0);
 
                             // update our cAnterior and cPosterior
                             cAnteriorIndex = 0;
@@ -553,9 +571,10 @@ public:
 
         // if there's more dj sets than requested chunks, then just return an iter per dj set
         std::vector<souffle::range<iterator>> ret;
-        if (chunks <= equivalencePartition.size()) {
+        if (chunks <= numCachedClasses) {
             for (auto& p : equivalencePartition) {
-                ret.push_back(souffle::make_range(closure(p.first), end()));
+                if (p.second->size() == 0) continue;
+                ret.push_back(souffle::make_range(iterator(this, p.second), end()));
             }
             return ret;
         }
@@ -566,18 +585,178 @@ public:
         const size_t perchunk = numPairs / chunks;
         for (const auto& itp : equivalencePartition) {
             const size_t s = itp.second->size();
+            if (s == 0) continue;
             if (s * s > perchunk) {
                 for (const auto& i : *itp.second) {
-                    ret.push_back(souffle::make_range(anteriorIt(i), end()));
+                    ret.push_back(souffle::make_range(iterator(this, i, itp.second), end()));
                 }
             } else {
-                ret.push_back(souffle::make_range(closure(itp.first), end()));
+                ret.push_back(souffle::make_range(iterator(this, itp.second), end()));
             }
         }
 
         return ret;
     }
 
+    /**
+     * The members of an equivalence class, in no particular order, valid until the relation is
+     * modified next.
+     */
+    class EquivalenceClass {
+    public:
+        class iterator : public std::iterator<std::forward_iterator_tag, value_type> {
+        public:
+            iterator(const StatesList* list, size_t pos) : list(list), pos(pos) {}
+
+            value_type operator*() const {
+                return list->get(pos);
+            }
+
+            iterator& operator++() {
+                ++pos;
+                return *this;
+            }
+
+            bool operator==(const iterator& other) const {
+                return pos == other.pos && list == other.list;
+            }
+
+            bool operator!=(const iterator& other) const {
+                return !(*this == other);
+            }
+
+        private:
+            const StatesList* list;
+            size_t pos;
+        };
+
+        explicit EquivalenceClass(const StatesList* list = nullptr) : list(list) {}
+
+        size_t size() const {
+            return list == nullptr ? 0 : list->size();
+        }
+
+        iterator begin() const {
+            return iterator(list, 0);
+        }
+
+        iterator end() const {
+            return iterator(list, size());
+        }
+
+    private:
+        const StatesList* list;
+    };
+
+    /**
+     * An iterator over the equivalence classes of the relation, one class per representative.
+     */
+    class class_iterator : public std::iterator<std::forward_iterator_tag, EquivalenceClass> {
+        using nested_iterator = typename StatesMap::iterator;
+
+    public:
+        class_iterator() = default;
+
+        class_iterator(const nested_iterator& cur, const nested_iterator& end) : cur(cur), end(end) {
+            skipDissolved();
+        }
+
+        EquivalenceClass operator*() const {
+            return EquivalenceClass((*cur).second);
+        }
+
+        class_iterator& operator++() {
+            ++cur;
+            skipDissolved();
+            return *this;
+        }
+
+        bool operator==(const class_iterator& other) const {
+            return cur == other.cur;
+        }
+
+        bool operator!=(const class_iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        // the lists of sets merged into others are left empty
+        void skipDissolved() {
+            while (cur != end && (*cur).second->size() == 0) {
+                ++cur;
+            }
+        }
+
+        nested_iterator cur;
+        nested_iterator end;
+    };
+
+    /**
+     * Obtains the equivalence classes of the relation.
+     */
+    range<class_iterator> classes() const {
+        genAllDisjointSetLists();
+        auto end = equivalencePartition.end();
+        return make_range(class_iterator(equivalencePartition.begin(), end), class_iterator(end, end));
+    }
+
+    /**
+     * Splits the equivalence classes into approximately the given number of partitions of whole
+     * classes, for iterating over the classes in parallel.
+     */
+    std::vector<range<class_iterator>> partitionClasses(size_t chunks) const {
+        genAllDisjointSetLists();
+        std::vector<range<class_iterator>> res;
+        auto end = equivalencePartition.end();
+        for (const auto& chunk : equivalencePartition.getChunks(chunks)) {
+            res.push_back(make_range(class_iterator(chunk.begin(), end), class_iterator(chunk.end(), end)));
+        }
+        return res;
+    }
+
+    /**
+     * Obtains the equivalence class of the given value, which is empty if the value is in no pair.
+     */
+    EquivalenceClass getClass(value_type x) const {
+        if (!sds.nodeExists(x)) {
+            return EquivalenceClass();
+        }
+        genAllDisjointSetLists();
+        return EquivalenceClass((*equivalencePartition.find({sds.findNode(x), nullptr})).second);
+    }
+
+    /**
+     * The number of members of the equivalence class of the given value, zero if it is in no pair.
+     */
+    size_t getClassSize(value_type x) const {
+        return getClass(x).size();
+    }
+
+    /**
+     * The representative of the equivalence class of the given value, which must be in a pair.
+     * Values have the same representative iff they are equivalent, until the relation is
+     * modified next.
+     */
+    value_type getRepresentative(value_type x) const {
+        assert(sds.nodeExists(x) && "representative of a value in no pair");
+        return sds.findNode(x);
+    }
+
+    /**
+     * Counts the pairs matching the prefix of the given entry up to levels elements, by the
+     * sizes of the classes rather than by iterating through the pairs.
+     */
+    template <unsigned levels>
+    size_t countBoundaries(const TupleType& entry) const {
+        if (levels == 0) {
+            return size();
+        }
+        if (levels == 1) {
+            return getClassSize(entry[0]);
+        }
+        return contains(entry[0], entry[1]) ? 1 : 0;
+    }
+
     iterator find(const TupleType&, operation_hints&) const {
         throw std::runtime_error("error: find() is not compatible with equivalence relations");
         return begin();
@@ -594,6 +773,9 @@ protected:
     }
 
 private:
+    // the number of elements from which merges and the regeneration of the cache run in parallel
+    static constexpr size_t PARALLEL_SIZE = 1 << 14;
+
     // marked as mutable due to difficulties with the const enforcement via the Relation API
     // const operations *may* safely change internal state (i.e. collapse djset forest)
     mutable souffle::SparseDisjointSet<value_type> sds;
@@ -605,9 +787,62 @@ private:
     // whether the cache is stale
     mutable std::atomic<bool> statesMapStale;
 
+    // elements involved in unions since the cache was generated
+    mutable StatesList changedNodes{8};
+
+    // the representative of each cached element (indexed by dense value) at the time of caching
+    mutable std::vector<value_type> cachedReps;
+
+    // the number of lists in the cache, and the number of those not dissolved into other sets
+    mutable std::atomic<size_t> numCachedLists{0};
+    mutable std::atomic<size_t> numCachedClasses{0};
+
+    /**
+     * Applies the given function to the given number of consecutive parts of the range [0, n),
+     * passing the number of each part and its bounds; in parallel if the range is large.
+     */
+    template <typename F>
+    static void forParts(size_t n, int numParts, const F& f) {
+        forParts(n, numParts, n >= PARALLEL_SIZE, f);
+    }
+
+    template <typename F>
+    static void forParts(size_t n, int numParts, bool parallel, const F& f) {
+#pragma omp parallel for schedule(dynamic) if (parallel)
+        for (int part = 0; part < numParts; ++part) {
+            f(part, n * part / numParts, n * (part + 1) / numParts);
+        }
+    }
+
+    /**
+     * Unions the sets of two values not yet in the same set, recording the change for the cache.
+     */
+    void unionNodes(value_type x, value_type y) {
+        changedNodes.append(x);
+        changedNodes.append(y);
+        // indicate that iterators will have to generate on request
+        this->statesMapStale.store(true, std::memory_order_relaxed);
+        sds.unionNodes(x, y);
+    }
+
+    /**
+     * Obtains the cached list of a set, creating it if not present.
+     */
+    StatesList* getStatesList(value_type rep) const {
+        StorePair p = {rep, nullptr};
+        return equivalencePartition.insert(p, [&](StorePair& sp) {
+            auto* r = new StatesList(1);
+            sp.second = r;
+            numCachedLists++;
+            numCachedClasses++;
+            return r;
+        });
+    }
+
     /**
      * Generate a cache of the sets such that they can be iterated over efficiently.
-     * Each set is partitioned into a PiggyList.
+     * Each set is partitioned into a PiggyList. If only a few elements have been affected by
+     * unions since the last generation, only the lists of their sets are rebuilt.
      */
     void genAllDisjointSetLists() const {
         statesLock.lock();
@@ -618,25 +853,97 @@ private:
             return;
         }
 
+        // rebuild everything if most of the elements are affected or the cache is fragmented
+        const size_t dSetSize = this->sds.ds.a_blocks.size();
+        const size_t numChanged = changedNodes.size() + dSetSize - cachedReps.size();
+        if (cachedReps.empty() || numChanged * 2 > dSetSize ||
+                numCachedClasses * 2 < numCachedLists) {
+            genAllDisjointSetListsFromScratch();
+        } else {
+            updateDisjointSetLists();
+        }
+
+        changedNodes.clear();
+        statesMapStale.store(false, std::memory_order_release);
+        statesLock.unlock();
+    }
+
+    /**
+     * Regenerate the cached lists of all sets.
+     */
+    void genAllDisjointSetListsFromScratch() const {
         // btree version
         emptyPartition();
+        numCachedLists = 0;
+        numCachedClasses = 0;
 
         size_t dSetSize = this->sds.ds.a_blocks.size();
-        for (size_t i = 0; i < dSetSize; ++i) {
-            typename TupleType::value_type sparseVal = this->sds.toSparse(i);
-            parent_t rep = this->sds.findNode(sparseVal);
-
-            StorePair p = {rep, nullptr};
-            StatesList* mapList = equivalencePartition.insert(p, [&](StorePair& sp) {
-                auto* r = new StatesList(1);
-                sp.second = r;
-                return r;
-            });
-            mapList->append(sparseVal);
+        cachedReps.resize(dSetSize);
+
+        // find the representatives of consecutive parts of the elements, bucketing the elements by
+        // the part of the representatives, and then fill the lists of each part of the representatives
+        // such that each list is filled by a single thread
+        const int numParts = MAX_THREADS;
+        std::vector<std::vector<std::vector<size_t>>> buckets(
+                numParts, std::vector<std::vector<size_t>>(numParts));
+        forParts(dSetSize, numParts, [&](int part, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                value_type rep = this->sds.findNode(this->sds.toSparse(i));
+                cachedReps[i] = rep;
+                buckets[part][static_cast<size_t>(rep) % numParts].push_back(i);
+            }
+        });
+        forParts(numParts, numParts, dSetSize >= PARALLEL_SIZE, [&](int part, size_t, size_t) {
+            for (int src = 0; src < numParts; ++src) {
+                for (size_t i : buckets[src][part]) {
+                    getStatesList(cachedReps[i])->append(this->sds.toSparse(i));
+                }
+            }
+        });
+    }
+
+    /**
+     * Update the cached lists of the sets affected by unions since the last generation.
+     */
+    void updateDisjointSetLists() const {
+        // collect the representatives of the cached sets involved in unions
+        const size_t numCached = cachedReps.size();
+        std::set<value_type> affected;
+        const size_t numChanged = changedNodes.size();
+        for (size_t i = 0; i < numChanged; ++i) {
+            const parent_t dense = this->sds.toDense(changedNodes.get(i));
+            if (static_cast<size_t>(dense) < numCached) {
+                affected.insert(cachedReps[dense]);
+            }
         }
 
-        statesMapStale.store(false, std::memory_order_release);
-        statesLock.unlock();
+        // add elements created since the last generation
+        const size_t dSetSize = this->sds.ds.a_blocks.size();
+        cachedReps.resize(dSetSize);
+        for (size_t i = numCached; i < dSetSize; ++i) {
+            value_type sparseVal = this->sds.toSparse(i);
+            value_type rep = this->sds.findNode(sparseVal);
+            getStatesList(rep)->append(sparseVal);
+            cachedReps[i] = rep;
+        }
+
+        // move the members of sets that lost their representative to their new set, the
+        // list of a set that kept its representative stays in place
+        for (value_type oldRep : affected) {
+            value_type rep = this->sds.findNode(oldRep);
+            if (rep == oldRep) continue;
+
+            StatesList* src = (*equivalencePartition.find({oldRep, nullptr})).second;
+            StatesList* trg = getStatesList(rep);
+            const size_t ksize = src->size();
+            for (size_t i = 0; i < ksize; ++i) {
+                const value_type cur = src->get(i);
+                trg->append(cur);
+                cachedReps[this->sds.toDense(cur)] = rep;
+            }
+            src->clear();
+            numCachedClasses--;
+        }
     }
 };
 }  // namespace souffle
@@ -65,6 +65,11 @@ public:
         registry[keyword] = processor;
     }
 
+    /** check whether events with the given keyword are processed */
+    bool hasEventProcessor(const std::string& keyword) const {
+        return registry.find(keyword) != registry.end();
+    }
+
     /** process a profile event */
     void process(ProfileDatabase& db, const char* txt, ...) {
         va_list args;
@@ -376,6 +381,71 @@ public:
     }
 } recursiveRelationNumberProcessor;
 
+/**
+ * Relation Column Profile Event Processor
+ */
+const class RelationColumnNumberProcessor : public EventProcessor {
+public:
+    RelationColumnNumberProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@n-relation-column", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& relation = signature[1];
+        const std::string& column = signature[2];
+        size_t number = va_arg(args, size_t);
+        db.addSizeEntry({"program", "relation", relation, "column", column, "distinct"}, number);
+    }
+} relationColumnNumberProcessor;
+
+/**
+ * Hardware Counter Profile Event Processor
+ *
+ * Stores the counters of a rule or relation next to its runtime.
+ */
+const class HardwareCounterProcessor : public EventProcessor {
+public:
+    HardwareCounterProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@h-nonrecursive-rule", this);
+        EventProcessorSingleton::instance().registerEventProcessor("@h-recursive-rule", this);
+        EventProcessorSingleton::instance().registerEventProcessor("@h-nonrecursive-relation", this);
+        EventProcessorSingleton::instance().registerEventProcessor("@h-recursive-relation", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        size_t values[4];
+        for (size_t& value : values) {
+            value = va_arg(args, size_t);
+        }
+        std::string iteration = std::to_string(va_arg(args, size_t));
+        size_t available = va_arg(args, size_t);
+
+        const std::string& keyword = signature[0];
+        const std::string& relation = signature[1];
+        std::vector<std::string> path;
+        if (keyword == "@h-nonrecursive-rule") {
+            path = {"program", "relation", relation, "non-recursive-rule", signature[3]};
+        } else if (keyword == "@h-recursive-rule") {
+            path = {"program", "relation", relation, "iteration", iteration, "recursive-rule", signature[4],
+                    signature[2]};
+        } else if (keyword == "@h-nonrecursive-relation") {
+            path = {"program", "relation", relation};
+        } else {
+            path = {"program", "relation", relation, "iteration", iteration};
+        }
+        path.push_back("counters");
+
+        const char* names[4] = {"cycles", "instructions", "cache-misses", "branch-misses"};
+        for (size_t i = 0; i < 4; i++) {
+            if ((available & (1u << i)) != 0) {
+                path.push_back(names[i]);
+                db.addSizeEntry(path, values[i]);
+                path.pop_back();
+            }
+        }
+    }
+} hardwareCounterProcessor;
+
 /**
  * Recursive Relation Copy Timing Profile Event Processor
  */
@@ -535,6 +605,98 @@ public:
 
 } relationReadsProcessor;
 
+/**
+ * Index Statistics Processor
+ */
+const class IndexStatisticsProcessor : public EventProcessor {
+public:
+    IndexStatisticsProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@index", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& relation = signature[1];
+        const std::string& index = signature[2];
+        const std::string& statistic = signature[3];
+        size_t value = va_arg(args, size_t);
+        db.addSizeEntry({"program", "relation", relation, "index", index, statistic}, value);
+    }
+} indexStatisticsProcessor;
+
+/**
+ * Memory Processor
+ *
+ * Stores the memory occupied by the index of a relation, the symbol table
+ * or the records at the end of a stratum, and the peak over all strata.
+ */
+const class MemoryProcessor : public EventProcessor {
+public:
+    MemoryProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@memory", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        size_t bytes = va_arg(args, size_t);
+        size_t stratum = va_arg(args, size_t);
+        std::vector<std::string> path = {"program", "memory", "stratum", std::to_string(stratum)};
+        path.insert(path.end(), signature.begin() + 1, signature.end());
+        addMaximum(db, path, bytes);
+        path = {"program", "memory", "peak"};
+        path.insert(path.end(), signature.begin() + 1, signature.end());
+        addMaximum(db, path, bytes);
+    }
+
+private:
+    /** Store a size unless a larger one is stored already */
+    static void addMaximum(ProfileDatabase& db, const std::vector<std::string>& path, size_t size) {
+        auto* entry = dynamic_cast<SizeEntry*>(db.lookupEntry(path));
+        if (entry == nullptr) {
+            db.addSizeEntry(path, size);
+        } else if (entry->getSize() < size) {
+            entry->setSize(size);
+        }
+    }
+} memoryProcessor;
+
+/**
+ * Sample Processor
+ *
+ * Stores the samples of the sampling profiler for each loop level of a rule.
+ */
+const class SampleProcessor : public EventProcessor {
+public:
+    SampleProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@sample", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& relation = signature[1];
+        const std::string& srcLocator = signature[2];
+        const std::string& rule = signature[3];
+        const std::string& level = signature[4];
+        size_t samples = va_arg(args, size_t);
+        db.addTextEntry({"program", "samples", "relation", relation, rule, "source-locator"}, srcLocator);
+        db.addSizeEntry({"program", "samples", "relation", relation, rule, "level", level}, samples);
+    }
+} sampleProcessor;
+
+/**
+ * Other Sample Processor
+ *
+ * Stores the samples of the sampling profiler taken outside of rules.
+ */
+const class OtherSampleProcessor : public EventProcessor {
+public:
+    OtherSampleProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@sample-other", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        size_t samples = va_arg(args, size_t);
+        db.addSizeEntry({"program", "samples", "other"}, samples);
+    }
+} otherSampleProcessor;
+
 /**
  * Config entry processor
  */
@@ -19,6 +19,7 @@
 #include "ExplainProvenanceImpl.h"
 
 #include <csignal>
+#include <fstream>
 #include <iostream>
 #include <regex>
 #include <string>
@@ -105,6 +106,35 @@ public:
             query = parseTuple(command[1]);
             label = std::stoi(query.second[0]);
             printTree(prov.explainSubproof(query.first, label, ExplainConfig::getExplainConfig().depthLimit));
+        } else if (command[0] == "explainall") {
+            if (command.size() != 2) {
+                printError("Usage: explainall <relation> [<file>]\n");
+                return true;
+            }
+            auto args = split(command[1], ' ');
+            std::vector<std::vector<std::string>> tuples;
+            if (args.size() == 2) {
+                // the file lists a tuple of the relation on each line
+                std::ifstream in(args[1]);
+                if (!in) {
+                    printError("Cannot open file " + args[1] + "\n");
+                    return true;
+                }
+                std::string line;
+                while (getline(in, line)) {
+                    if (!line.empty()) {
+                        tuples.push_back(parseTuple(args[0] + "(" + line + ")").second);
+                    }
+                }
+            }
+            std::ostream* output = &std::cout;
+            if (ExplainConfig::getExplainConfig().outputStream != nullptr) {
+                output = ExplainConfig::getExplainConfig().outputStream.get();
+            }
+            size_t depthLimit = ExplainConfig::getExplainConfig().depthLimit;
+            size_t explained = (args.size() == 2) ? prov.explainBatch(args[0], tuples, depthLimit, *output)
+                                                  : prov.explainAll(args[0], depthLimit, *output);
+            printInfo("Explained " + std::to_string(explained) + " tuples\n");
         } else if (command[0] == "explainnegation") {
             std::pair<std::string, std::vector<std::string>> query;
             if (command.size() != 2) {
@@ -202,6 +232,8 @@ public:
                     "----------\n"
                     "setdepth <depth>: Set a limit for printed derivation tree height\n"
                     "explain <relation>(<element1>, <element2>, ...): Prints derivation tree\n"
+                    "explainall <relation> [<file>]: Prints the derivation trees of all tuples of a\n"
+                    "    relation, or of those listed in a file, in JSON, one per line\n"
                     "explainnegation <relation>(<element1>, <element2>, ...): Enters an interactive\n"
                     "    interface where the non-existence of a tuple can be explained\n"
                     "subproof <relation>(<label>): Prints derivation tree for a subproof, label is\n"
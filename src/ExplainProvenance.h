@@ -60,6 +60,20 @@ public:
     virtual std::unique_ptr<TreeNode> explainSubproof(
             std::string relName, RamDomain label, size_t depthLimit) = 0;
 
+    /**
+     * Explain many tuples of a relation at once, writing the proof of each in JSON on a line of its own.
+     * Tuples that are not found are skipped.
+     *
+     * @return the number of tuples explained
+     */
+    virtual size_t explainBatch(std::string relName, const std::vector<std::vector<std::string>>& tuples,
+            size_t depthLimit, std::ostream& os) = 0;
+
+    /**
+     * Explain all tuples of a relation, as by explainBatch().
+     */
+    virtual size_t explainAll(std::string relName, size_t depthLimit, std::ostream& os) = 0;
+
     virtual std::vector<std::string> explainNegationGetVariables(
             std::string relName, std::vector<std::string> args, size_t ruleNum) = 0;
 
@@ -110,6 +124,12 @@ protected:
     SouffleProgram& prog;
     SymbolTable& symTable;
 
+    /** Check whether a relation carries the rule and level columns of provenance */
+    static bool hasProvenanceColumns(const Relation& rel) {
+        size_t arity = rel.getArity();
+        return arity >= 2 && std::string(rel.getAttrName(arity - 1)) == "@level_number";
+    }
+
     std::vector<RamDomain> argsToNums(
             const std::string& relName, const std::vector<std::string>& args) const {
         std::vector<RamDomain> nums;
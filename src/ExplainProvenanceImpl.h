@@ -22,8 +22,10 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <set>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -66,6 +68,24 @@ public:
                 rules.insert({std::make_pair(name.substr(0, name.find(".@info")), ruleNum), rule});
             }
         }
+
+        // resolve the subroutines of each rule once rather than by name for every proof step
+        for (auto& cur : info) {
+            const std::string prefix = cur.first.first + "_" + std::to_string(cur.first.second);
+            subproofIds[cur.first] = prog.getSubroutineId(prefix + "_subproof");
+            negationIds[cur.first] = prog.getSubroutineId(prefix + "_negation_subproof");
+        }
+
+        // without provenance columns in any relation, the proofs are searched when tuples are explained
+        lazy = !info.empty();
+        for (auto& rel : prog.getAllRelations()) {
+            if (hasProvenanceColumns(*rel)) {
+                lazy = false;
+            }
+        }
+        for (auto& rel : prog.getInputRelations()) {
+            inputRelations.insert(rel->getName());
+        }
     }
 
     std::unique_ptr<TreeNode> explain(
@@ -87,14 +107,12 @@ public:
             tuple.push_back(levelNum);
 
             // find if subproof exists already
-            size_t idx = 0;
-            auto it = std::find(subproofs.begin(), subproofs.end(), tuple);
-            if (it != subproofs.end()) {
-                idx = it - subproofs.begin();
-            } else {
+            auto it = subproofIndex.find(tuple);
+            if (it == subproofIndex.end()) {
+                it = subproofIndex.insert({tuple, subproofs.size()}).first;
                 subproofs.push_back(tuple);
-                idx = subproofs.size() - 1;
             }
+            size_t idx = it->second;
 
             return std::make_unique<LeafNode>("subproof " + relName + "(" + std::to_string(idx) + ")");
         }
@@ -102,15 +120,19 @@ public:
         auto internalNode = std::make_unique<InnerNode>(
                 relName + "(" + joinedArgsStr + ")", "(R" + std::to_string(ruleNum) + ")");
 
-        // make return vector pointer
-        std::vector<RamDomain> ret;
-        std::vector<bool> err;
-
         // add level number to tuple
         tuple.push_back(levelNum);
 
-        // execute subroutine to get subproofs
-        prog.executeSubroutine(relName + "_" + std::to_string(ruleNum) + "_subproof", tuple, ret, err);
+        // execute subroutine to get subproofs, unless an earlier query already did
+        auto key = std::make_pair(std::make_pair(relName, (size_t)ruleNum), tuple);
+        auto result = subproofResults.find(key);
+        if (result == subproofResults.end()) {
+            result = subproofResults.insert({key, {}}).first;
+            runSubroutine(subproofIds, relName, ruleNum, "_subproof", tuple, result->second.first,
+                    result->second.second);
+        }
+        const std::vector<RamDomain>& ret = result->second.first;
+        const std::vector<bool>& err = result->second.second;
 
         // recursively get nodes for subproofs
         size_t tupleCurInd = 0;
@@ -197,6 +219,14 @@ public:
             return std::make_unique<LeafNode>("Relation not found");
         }
 
+        if (lazy) {
+            return explainLazily(relName, tuple, depthLimit);
+        }
+
+        if (!hasProvenanceColumns(*prog.getRelation(relName))) {
+            return std::make_unique<LeafNode>("No provenance recorded for relation");
+        }
+
         std::pair<int, int> tupleInfo = findTuple(relName, tuple);
         int ruleNum = tupleInfo.first;
         int levelNum = tupleInfo.second;
@@ -220,9 +250,47 @@ public:
         RamDomain ruleNum = tup.back();
         tup.pop_back();
 
+        if (lazy) {
+            return explainLazily(relName, tup, depthLimit);
+        }
+
         return explain(relName, tup, ruleNum, levelNum, depthLimit);
     }
 
+    size_t explainBatch(std::string relName, const std::vector<std::vector<std::string>>& tuples,
+            size_t depthLimit, std::ostream& os) override {
+        std::vector<std::vector<RamDomain>> nums;
+        for (const auto& args : tuples) {
+            nums.push_back(argsToNums(relName, args));
+        }
+        return explainTuples(relName, nums, depthLimit, os);
+    }
+
+    size_t explainAll(std::string relName, size_t depthLimit, std::ostream& os) override {
+        auto rel = prog.getRelation(relName);
+        if (rel == nullptr) {
+            return 0;
+        }
+        const size_t columns = (!lazy && hasProvenanceColumns(*rel)) ? 2 : 0;
+        std::vector<std::vector<RamDomain>> tuples;
+        for (auto& tuple : *rel) {
+            std::vector<RamDomain> currentTuple;
+            for (size_t i = 0; i < rel->getArity() - columns; i++) {
+                RamDomain n;
+                if (*rel->getAttrType(i) == 's') {
+                    std::string str;
+                    tuple >> str;
+                    n = symTable.lookupExisting(str.c_str());
+                } else {
+                    tuple >> n;
+                }
+                currentTuple.push_back(n);
+            }
+            tuples.push_back(std::move(currentTuple));
+        }
+        return explainTuples(relName, tuples, depthLimit, os);
+    }
+
     std::vector<std::string> explainNegationGetVariables(
             std::string relName, std::vector<std::string> args, size_t ruleNum) override {
         std::vector<std::string> variables;
@@ -351,8 +419,7 @@ public:
         std::vector<bool> err;
 
         // execute subroutine to get subproofs
-        prog.executeSubroutine(
-                relName + "_" + std::to_string(ruleNum) + "_negation_subproof", args, ret, err);
+        runSubroutine(negationIds, relName, ruleNum, "_negation_subproof", args, ret, err);
 
         // construct tree nodes
         std::stringstream joinedArgsStr;
@@ -360,6 +427,9 @@ public:
         auto internalNode = std::make_unique<InnerNode>(
                 relName + "(" + joinedArgsStr.str() + ")", "(R" + std::to_string(ruleNum) + ")");
 
+        // the number of provenance columns of the atoms, none for lazy provenance
+        const size_t columns = lazy ? 0 : 2;
+
         // traverse return vector and construct child nodes
         // making sure we display existent and non-existent tuples correctly
         int literalCounter = 1;
@@ -394,7 +464,7 @@ public:
             if (isConstraint) {
                 // we only handle binary constraints, and assume arity is 4 to account for hidden provenance
                 // annotations
-                arity = 4;
+                arity = 2 + columns;
             } else {
                 arity = prog.getRelation(bodyRelAtomName)->getArity();
             }
@@ -403,7 +473,7 @@ public:
             std::vector<RamDomain> atomValues;
             std::vector<bool> atomErrs;
             size_t j = returnCounter;
-            for (; j < returnCounter + arity - 2; j++) {
+            for (; j < returnCounter + arity - columns; j++) {
                 atomValues.push_back(ret[j]);
                 atomErrs.push_back(err[j]);
             }
@@ -471,6 +541,11 @@ public:
             return "No relation found\n";
         }
 
+        if (!lazy && !hasProvenanceColumns(*rel)) {
+            return "No provenance recorded for relation\n";
+        }
+        const size_t columns = lazy ? 0 : 2;
+
         auto size = rel->size();
         int skip = size / 10;
 
@@ -491,7 +566,7 @@ public:
             }
 
             std::vector<RamDomain> currentTuple;
-            for (size_t i = 0; i < rel->getArity() - 2; i++) {
+            for (size_t i = 0; i < rel->getArity() - columns; i++) {
                 RamDomain n;
                 if (*rel->getAttrType(i) == 's') {
                     std::string s;
@@ -504,14 +579,20 @@ public:
                 currentTuple.push_back(n);
             }
 
-            RamDomain ruleNum;
-            tuple >> ruleNum;
+            std::unique_ptr<TreeNode> proof;
+            if (lazy) {
+                proof = explainLazily(relName, currentTuple, 20);
+            } else {
+                RamDomain ruleNum;
+                tuple >> ruleNum;
+
+                RamDomain levelNum;
+                tuple >> levelNum;
 
-            RamDomain levelNum;
-            tuple >> levelNum;
+                proof = explain(relName, currentTuple, ruleNum, levelNum, 20);
+            }
 
-            std::cout << "Tuples expanded: "
-                      << explain(relName, currentTuple, ruleNum, levelNum, 20)->getSize();
+            std::cout << "Tuples expanded: " << proof->getSize();
             numTuples++;
             proc++;
 
@@ -549,57 +630,365 @@ private:
     std::map<std::pair<std::string, size_t>, std::vector<std::string>> info;
     std::map<std::pair<std::string, size_t>, std::string> rules;
     std::vector<std::vector<RamDomain>> subproofs;
+    std::map<std::vector<RamDomain>, size_t> subproofIndex;
+
+    /** ids of the subproof and negation subroutines of each rule, -1 if the program resolves only names */
+    std::map<std::pair<std::string, size_t>, int> subproofIds;
+    std::map<std::pair<std::string, size_t>, int> negationIds;
+
+    /** a rule and the arguments of its subproof subroutine: the tuple explained and its level */
+    using SubproofKey = std::pair<std::pair<std::string, size_t>, std::vector<RamDomain>>;
+
+    /** subroutine results of each rule and arguments, as proofs of big relations revisit many tuples */
+    std::map<SubproofKey, std::pair<std::vector<RamDomain>, std::vector<bool>>> subproofResults;
     std::vector<std::string> constraintList = {
             "=", "!=", "<", "<=", ">=", ">", "match", "contains", "not_match", "not_contains"};
 
+    /** whether the relations carry no provenance columns, so that the proofs of tuples are searched */
+    bool lazy = false;
+    std::set<std::string> inputRelations;
+
+    /**
+     * a proof found by the lazy search: the rule, the derivation returned by its subroutine, and a bound
+     * of its height, 0 for tuples of relations without rules
+     */
+    struct LazyProof {
+        size_t rule;
+        size_t derivation;
+        size_t height;
+    };
+    std::map<std::pair<std::string, std::vector<RamDomain>>, LazyProof> lazyProofs;
+
+    /**
+     * the greatest height bound for which the lazy search found no proof of a tuple, and whether the
+     * search was cut off by the bound rather than exhausted
+     */
+    std::map<std::pair<std::string, std::vector<RamDomain>>, std::pair<size_t, bool>> lazyFailures;
+
+    /** the derivations of a tuple by a rule, each holding the values of the body literals */
+    const std::vector<std::vector<RamDomain>>& getDerivations(
+            const std::string& relName, size_t ruleNum, const std::vector<RamDomain>& tuple) {
+        auto key = std::make_pair(std::make_pair(relName, ruleNum), tuple);
+        auto derivations = lazyDerivations.find(key);
+        if (derivations != lazyDerivations.end()) {
+            return derivations->second;
+        }
+
+        std::vector<RamDomain> ret;
+        std::vector<bool> err;
+        runSubroutine(subproofIds, relName, ruleNum, "_subproof", tuple, ret, err);
+
+        // the derivations are separated by an undefined value
+        std::vector<std::vector<RamDomain>>& res = lazyDerivations[key];
+        std::vector<RamDomain> cur;
+        for (size_t i = 0; i < ret.size(); i++) {
+            if (err[i]) {
+                res.push_back(cur);
+                cur.clear();
+            } else {
+                cur.push_back(ret[i]);
+            }
+        }
+        return res;
+    }
+    std::map<std::pair<std::pair<std::string, size_t>, std::vector<RamDomain>>,
+            std::vector<std::vector<RamDomain>>>
+            lazyDerivations;
+
+    /** split a derivation into the values of the body literals of a rule, skipping its head */
+    std::vector<std::vector<RamDomain>> splitLiterals(
+            const std::vector<std::string>& bodyLiterals, const std::vector<RamDomain>& derivation) const {
+        std::vector<std::vector<RamDomain>> res;
+        size_t cur = 0;
+        for (auto it = bodyLiterals.begin() + 1; it < bodyLiterals.end(); it++) {
+            std::string bodyRel = splitString(*it, ',')[0];
+            size_t arity = 2;
+            if (!contains(constraintList, bodyRel)) {
+                arity = prog.getRelation(bodyRel[0] == '!' ? bodyRel.substr(1) : bodyRel)->getArity();
+            }
+            res.emplace_back(derivation.begin() + cur, derivation.begin() + cur + arity);
+            cur += arity;
+        }
+        return res;
+    }
+
+    /**
+     * search a proof of a tuple of at most the given height, whose subproofs are lower, so that proofs are
+     * well-founded even through recursive rules; sets the flag if the search was cut off by the height
+     */
+    bool proveLazily(const std::string& relName, const std::vector<RamDomain>& tuple, size_t height,
+            bool& bounded) {
+        auto key = std::make_pair(relName, tuple);
+        auto proof = lazyProofs.find(key);
+        if (proof != lazyProofs.end() && proof->second.height <= height) {
+            return true;
+        }
+
+        // tuples of relations without rules are facts, as are those of input relations
+        auto rule = info.lower_bound(std::make_pair(relName, (size_t)0));
+        if (rule == info.end() || rule->first.first != relName || inputRelations.count(relName) != 0) {
+            lazyProofs[key] = {0, 0, 0};
+            return true;
+        }
+
+        auto failure = lazyFailures.find(key);
+        if (failure != lazyFailures.end() && (!failure->second.second || failure->second.first >= height)) {
+            bounded = bounded || failure->second.second;
+            return false;
+        }
+        if (height == 0) {
+            bounded = true;
+            return false;
+        }
+
+        bool cutOff = false;
+        for (; rule != info.end() && rule->first.first == relName; rule++) {
+            const auto& derivations = getDerivations(relName, rule->first.second, tuple);
+            for (size_t i = 0; i < derivations.size(); i++) {
+                bool proven = true;
+                auto literals = splitLiterals(rule->second, derivations[i]);
+                for (size_t j = 0; j < literals.size() && proven; j++) {
+                    std::string bodyRel = splitString(rule->second[j + 1], ',')[0];
+                    if (bodyRel[0] != '!' && !contains(constraintList, bodyRel)) {
+                        proven = proveLazily(bodyRel, literals[j], height - 1, cutOff);
+                    }
+                }
+                if (proven) {
+                    lazyProofs[key] = {rule->first.second, i, height};
+                    return true;
+                }
+            }
+        }
+
+        lazyFailures[key] = std::make_pair(height, cutOff);
+        bounded = bounded || cutOff;
+        return false;
+    }
+
+    /** explain a tuple by the lowest proof found by a search of increasing height */
+    std::unique_ptr<TreeNode> explainLazily(
+            const std::string& relName, const std::vector<RamDomain>& tuple, size_t depthLimit) {
+        if (findTuple(relName, tuple) == std::make_pair(-1, -1)) {
+            return std::make_unique<LeafNode>("Tuple not found");
+        }
+        for (size_t height = 1;; height++) {
+            bool bounded = false;
+            if (proveLazily(relName, tuple, height, bounded)) {
+                break;
+            }
+            if (!bounded) {
+                return std::make_unique<LeafNode>("No proof found");
+            }
+        }
+        return makeLazyTree(relName, tuple, depthLimit);
+    }
+
+    /** build the tree of a proof found by the lazy search */
+    std::unique_ptr<TreeNode> makeLazyTree(
+            const std::string& relName, std::vector<RamDomain> tuple, size_t depthLimit) {
+        std::stringstream joinedArgs;
+        joinedArgs << join(numsToArgs(relName, tuple), ", ");
+        const std::string label = relName + "(" + joinedArgs.str() + ")";
+
+        const LazyProof proof = lazyProofs.at(std::make_pair(relName, tuple));
+        const auto& bodyLiterals = info[std::make_pair(relName, proof.rule)];
+        if (proof.rule == 0 || bodyLiterals.size() <= 1) {
+            return std::make_unique<LeafNode>(label);
+        }
+
+        // if depth limit exceeded
+        if (depthLimit <= 1) {
+            tuple.push_back(proof.rule);
+            tuple.push_back(proof.height);
+
+            // find if subproof exists already
+            auto it = subproofIndex.find(tuple);
+            if (it == subproofIndex.end()) {
+                it = subproofIndex.insert({tuple, subproofs.size()}).first;
+                subproofs.push_back(tuple);
+            }
+            return std::make_unique<LeafNode>("subproof " + relName + "(" + std::to_string(it->second) + ")");
+        }
+
+        auto internalNode = std::make_unique<InnerNode>(label, "(R" + std::to_string(proof.rule) + ")");
+        auto literals =
+                splitLiterals(bodyLiterals, getDerivations(relName, proof.rule, tuple)[proof.derivation]);
+        for (size_t i = 0; i < literals.size(); i++) {
+            std::string bodyRel = splitString(bodyLiterals[i + 1], ',')[0];
+            std::unique_ptr<TreeNode> child;
+            if (bodyRel[0] == '!') {
+                std::stringstream joinedTuple;
+                joinedTuple << join(numsToArgs(bodyRel.substr(1), literals[i]), ", ");
+                child = std::make_unique<LeafNode>(bodyRel + "(" + joinedTuple.str() + ")");
+            } else if (contains(constraintList, bodyRel)) {
+                std::stringstream joinedConstraint;
+                if (isNumericBinaryConstraintOp(toBinaryConstraintOp(bodyRel))) {
+                    joinedConstraint << literals[i][0] << " " << bodyRel << " " << literals[i][1];
+                } else {
+                    joinedConstraint << bodyRel << "(\"" << symTable.resolve(literals[i][0]) << "\", \""
+                                     << symTable.resolve(literals[i][1]) << "\")";
+                }
+                child = std::make_unique<LeafNode>(joinedConstraint.str());
+            } else {
+                child = makeLazyTree(bodyRel, literals[i], depthLimit - 1);
+            }
+            internalNode->setSize(internalNode->getSize() + child->getSize());
+            internalNode->add_child(std::move(child));
+        }
+        return std::move(internalNode);
+    }
+
     std::pair<int, int> findTuple(const std::string& relName, std::vector<RamDomain> tup) {
         auto rel = prog.getRelation(relName);
 
-        if (rel == nullptr) {
+        // without provenance columns, only the existence of the tuple is known
+        if (rel != nullptr && lazy) {
+            bool found = false;
+            tup.resize(rel->getArity(), 0);
+            rel->equalRange(tup.data(), (uint64_t(1) << rel->getArity()) - 1,
+                    [&](const RamDomain* rows, size_t n) { found = true; });
+            return found ? std::make_pair(0, 0) : std::make_pair(-1, -1);
+        }
+
+        if (rel == nullptr || !hasProvenanceColumns(*rel)) {
             return std::make_pair(-1, -1);
         }
 
-        // find correct tuple
-        for (auto& tuple : *rel) {
-            bool match = true;
-            std::vector<RamDomain> currentTuple;
+        // find the tuple through the index of its non-provenance columns
+        size_t arity = rel->getArity();
+        std::pair<int, int> found(-1, -1);
+        tup.resize(arity, 0);
+        rel->equalRange(tup.data(), (uint64_t(1) << (arity - 2)) - 1, [&](const RamDomain* rows, size_t n) {
+            if (found.first == -1) {
+                found = std::make_pair(rows[arity - 2], rows[arity - 1]);
+            }
+        });
+        return found;
+    }
 
-            for (size_t i = 0; i < rel->getArity() - 2; i++) {
-                RamDomain n;
-                if (*rel->getAttrType(i) == 's') {
-                    std::string s;
-                    tuple >> s;
-                    n = symTable.lookupExisting(s);
-                } else {
-                    tuple >> n;
-                }
+    /**
+     * Explain the given tuples of a relation, printing the proof of each on a line of its own. The
+     * subroutines of all proofs are run ahead of building them, a level of the proof trees at a time.
+     *
+     * @return the number of tuples explained
+     */
+    size_t explainTuples(const std::string& relName, const std::vector<std::vector<RamDomain>>& tuples,
+            size_t depthLimit, std::ostream& os) {
+        auto rel = prog.getRelation(relName);
+        if (rel == nullptr) {
+            return 0;
+        }
 
-                currentTuple.push_back(n);
+        // the rule and level of each tuple, which are not known to the lazy search
+        std::vector<std::pair<int, int>> found;
+        std::vector<SubproofKey> roots;
+        for (const auto& tuple : tuples) {
+            found.push_back(tuple.empty() ? std::make_pair(-1, -1) : findTuple(relName, tuple));
+            if (!lazy && found.back().second > 0) {
+                std::vector<RamDomain> args = tuple;
+                args.push_back(found.back().second);
+                roots.emplace_back(std::make_pair(relName, (size_t)found.back().first), std::move(args));
+            }
+        }
+        runSubproofs(std::move(roots), depthLimit);
 
-                if (n != tup[i]) {
-                    match = false;
-                    break;
-                }
+        size_t explained = 0;
+        for (size_t i = 0; i < tuples.size(); ++i) {
+            if (found[i].first < 0 || found[i].second == -1) {
+                continue;
+            }
+            std::unique_ptr<TreeNode> proof;
+            if (lazy) {
+                proof = explainLazily(relName, tuples[i], depthLimit);
+            } else {
+                proof = explain(relName, tuples[i], found[i].first, found[i].second, depthLimit);
             }
+            std::stringstream joinedArgs;
+            joinedArgs << join(numsToArgs(relName, tuples[i]), ", ");
+            os << R"({"tuple": ")" << stringify(relName + "(" + joinedArgs.str() + ")") << R"(", "proof": )";
+            proof->printJSONLine(os);
+            os << "}\n";
+            explained++;
+        }
+        return explained;
+    }
 
-            if (match) {
-                RamDomain ruleNum;
-                tuple >> ruleNum;
+    /**
+     * Run the subproof subroutines of the given rules and arguments and of the premises they find, down
+     * to the given depth of the proof trees, skipping those run before. The subroutines of a level are
+     * ordered by their rule, and run in parallel if the program resolves them by ids.
+     */
+    void runSubproofs(std::vector<SubproofKey> pending, size_t depthLimit) {
+        for (size_t depth = depthLimit; depth > 1 && !pending.empty(); --depth) {
+            std::set<SubproofKey> level;
+            for (auto& key : pending) {
+                if (subproofResults.find(key) == subproofResults.end()) {
+                    level.insert(std::move(key));
+                }
+            }
+            std::vector<SubproofKey> keys(level.begin(), level.end());
+            std::vector<std::pair<std::vector<RamDomain>, std::vector<bool>>> results(keys.size());
 
-                RamDomain levelNum;
-                tuple >> levelNum;
+            bool resolved = true;
+            for (const auto& key : keys) {
+                auto id = subproofIds.find(key.first);
+                resolved = resolved && id != subproofIds.end() && id->second >= 0;
+            }
+            if (resolved) {
+#pragma omp parallel for schedule(dynamic)
+                for (size_t i = 0; i < keys.size(); ++i) {
+                    prog.runSubroutine(subproofIds.at(keys[i].first), keys[i].second, results[i].first,
+                            results[i].second);
+                }
+            } else {
+                for (size_t i = 0; i < keys.size(); ++i) {
+                    runSubroutine(subproofIds, keys[i].first.first, keys[i].first.second, "_subproof",
+                            keys[i].second, results[i].first, results[i].second);
+                }
+            }
 
-                return std::make_pair(ruleNum, levelNum);
+            // the premises derived by rules are explained on the next level
+            pending.clear();
+            for (size_t i = 0; i < keys.size(); ++i) {
+                const auto& ret = results[i].first;
+                const auto& bodyLiterals = info[keys[i].first];
+                size_t pos = 0;
+                for (auto it = bodyLiterals.begin() + 1; it < bodyLiterals.end(); it++) {
+                    std::string bodyRel = splitString(*it, ',')[0];
+                    if (contains(constraintList, bodyRel)) {
+                        pos += 4;
+                        continue;
+                    }
+                    const std::string atomName = (bodyRel[0] == '!') ? bodyRel.substr(1) : bodyRel;
+                    const size_t arity = prog.getRelation(atomName)->getArity();
+                    if (bodyRel[0] != '!' && ret[pos + arity - 1] != 0) {
+                        std::vector<RamDomain> args(ret.begin() + pos, ret.begin() + pos + arity - 2);
+                        args.push_back(ret[pos + arity - 1]);
+                        pending.emplace_back(std::make_pair(atomName, (size_t)ret[pos + arity - 2]), args);
+                    }
+                    pos += arity;
+                }
+                subproofResults.emplace(std::move(keys[i]), std::move(results[i]));
             }
         }
+    }
 
-        // if no tuple exists
-        return std::make_pair(-1, -1);
+    void runSubroutine(const std::map<std::pair<std::string, size_t>, int>& ids, const std::string& relName,
+            size_t ruleNum, const std::string& suffix, const std::vector<RamDomain>& args,
+            std::vector<RamDomain>& ret, std::vector<bool>& err) {
+        auto id = ids.find(std::make_pair(relName, ruleNum));
+        if (id != ids.end() && id->second >= 0) {
+            prog.runSubroutine(id->second, args, ret, err);
+        } else {
+            prog.executeSubroutine(relName + "_" + std::to_string(ruleNum) + suffix, args, ret, err);
+        }
     }
 
     void printRelationOutput(
             const std::vector<bool>& symMask, const IODirectives& ioDir, const Relation& rel) override {
-        WriteCoutCSVFactory().getWriter(symMask, prog.getSymbolTable(), ioDir, true)->writeAll(rel);
+        WriteCoutCSVFactory()
+                .getWriter(symMask, prog.getSymbolTable(), ioDir, hasProvenanceColumns(rel))
+                ->writeAll(rel);
     }
 };
 
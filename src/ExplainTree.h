@@ -109,6 +109,9 @@ public:
 
     virtual void printJSON(std::ostream& os, int pos) = 0;
 
+    // print JSON on a single line
+    virtual void printJSONLine(std::ostream& os) = 0;
+
 protected:
     std::string txt;      // text of tree node
     uint32_t width = 0;   // width of node (including sub-trees)
@@ -186,6 +189,21 @@ public:
         os << tab << "}";
     }
 
+    // print JSON on a single line
+    void printJSONLine(std::ostream& os) override {
+        os << R"({"premises": ")" << stringify(txt) << R"(", "rule-number": ")" << label
+           << R"(", "children": [)";
+        bool first = true;
+        for (const std::unique_ptr<TreeNode>& k : children) {
+            if (first)
+                first = false;
+            else
+                os << ", ";
+            k->printJSONLine(os);
+        }
+        os << "]}";
+    }
+
 private:
     std::vector<std::unique_ptr<TreeNode>> children;
     std::string label;
@@ -216,6 +234,11 @@ public:
         std::string tab(pos, '\t');
         os << tab << R"({ "axiom": ")" << stringify(txt) << "\"}";
     }
+
+    // print JSON on a single line
+    void printJSONLine(std::ostream& os) override {
+        os << R"({"axiom": ")" << stringify(txt) << "\"}";
+    }
 };
 
 }  // end of namespace souffle
@@ -0,0 +1,229 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file FrozenSet.h
+ *
+ * A read-optimised ordered set of fixed length integer tuples, for relations
+ * that are complete and only read from then on, such as the relations of the
+ * strata that have been evaluated.
+ *
+ * The tuples are stored in a sorted vector without any slack. A search layer
+ * holding the first tuple of each block of the vector in Eytzinger (BFS) order
+ * locates the block of a tuple by a branch-free descent touching few cache
+ * lines, after which the block is searched on its own.
+ *
+ * Read operations take no locks and may be conducted concurrently. Inserts are
+ * supported for completeness only; each of them rebuilds the search layer, and
+ * they may not be conducted concurrently with any other operation.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "CompiledTuple.h"
+#include "RamTypes.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A set of tuples of the given arity in lexicographical order, stored in a
+ * sorted vector indexed by a search layer of block fences in Eytzinger order.
+ *
+ * @tparam N the arity of the stored tuples
+ * @tparam Domain the type of the stored values
+ */
+template <unsigned N, typename Domain = RamDomain>
+class FrozenSet {
+public:
+    using entry_type = ram::Tuple<Domain, N>;
+    using element_type = entry_type;
+    using iterator = typename std::vector<entry_type>::const_iterator;
+    using const_iterator = iterator;
+
+private:
+    // the number of tuples per block covered by a fence
+    enum { BLOCK_SIZE = 32 };
+
+    // the tuples, sorted and free of duplicates
+    std::vector<entry_type> content;
+
+    // the first tuple of each block in Eytzinger order, starting at position 1
+    std::vector<entry_type> fences;
+
+    // the number of the block of each fence
+    std::vector<std::size_t> blocks;
+
+    // fills the fences of the subtree rooted at the given position in order
+    void layout(std::size_t pos, std::size_t& block) {
+        if (pos >= fences.size()) {
+            return;
+        }
+        layout(2 * pos, block);
+        fences[pos] = content[block * BLOCK_SIZE];
+        blocks[pos] = block++;
+        layout(2 * pos + 1, block);
+    }
+
+    // rebuilds the search layer of the content
+    void build() {
+        const std::size_t numBlocks = (content.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        fences.assign(numBlocks + 1, entry_type());
+        blocks.assign(numBlocks + 1, 0);
+        std::size_t block = 0;
+        layout(1, block);
+    }
+
+public:
+    FrozenSet() = default;
+
+    FrozenSet(const FrozenSet&) = delete;
+    FrozenSet& operator=(const FrozenSet&) = delete;
+
+    /**
+     * Replaces the content of this set by the given tuples, which have to be
+     * sorted and free of duplicates.
+     */
+    void load(std::vector<entry_type> entries) {
+        entries.shrink_to_fit();
+        content.swap(entries);
+        build();
+    }
+
+    /**
+     * Adds the given tuple to this set, moving all larger tuples.
+     *
+     * @return true if the tuple has not been contained before
+     */
+    bool insert(const entry_type& t) {
+        auto pos = content.begin() + (lower_bound(t) - content.cbegin());
+        if (pos != content.end() && *pos == t) {
+            return false;
+        }
+        content.insert(pos, t);
+        build();
+        return true;
+    }
+
+    /**
+     * Adds all tuples of the given set to this set.
+     */
+    void insertAll(const FrozenSet& other) {
+        if (this == &other || other.empty()) {
+            return;
+        }
+        std::vector<entry_type> merged;
+        merged.reserve(content.size() + other.content.size());
+        std::set_union(content.begin(), content.end(), other.content.begin(), other.content.end(),
+                std::back_inserter(merged));
+        load(std::move(merged));
+    }
+
+    bool contains(const entry_type& t) const {
+        auto pos = lower_bound(t);
+        return pos != content.end() && *pos == t;
+    }
+
+    iterator find(const entry_type& t) const {
+        auto pos = lower_bound(t);
+        return (pos != content.end() && *pos == t) ? pos : content.end();
+    }
+
+    iterator lower_bound(const entry_type& t) const {
+        if (content.empty()) {
+            return content.end();
+        }
+
+        // descend to a leaf, going right at fences not exceeding the tuple
+        std::size_t pos = 1;
+        while (pos < fences.size()) {
+            pos = 2 * pos + !(t < fences[pos]);
+        }
+
+        // step back to the last fence exceeding the tuple, if any, by dropping
+        // the trailing right turns and the final left turn
+        pos >>= __builtin_ffsll(~static_cast<unsigned long long>(pos));
+
+        // the tuple is in the block preceding that fence, or the last one
+        const std::size_t next = (pos == 0) ? fences.size() - 1 : blocks[pos];
+        if (next == 0) {
+            return content.begin();
+        }
+        auto a = content.begin() + (next - 1) * BLOCK_SIZE;
+        auto b = content.begin() + std::min(next * BLOCK_SIZE, content.size());
+        return std::lower_bound(a, b, t);
+    }
+
+    iterator upper_bound(const entry_type& t) const {
+        auto pos = lower_bound(t);
+        return (pos != content.end() && *pos == t) ? pos + 1 : pos;
+    }
+
+    /**
+     * Counts the tuples of a range without iterating through them.
+     */
+    long countRange(const iterator& a, const iterator& b) const {
+        return b - a;
+    }
+
+    /**
+     * Partitions this set into approximately the given number of ranges of
+     * equal size.
+     */
+    std::vector<range<iterator>> partition(std::size_t num) const {
+        std::vector<range<iterator>> res;
+        const std::size_t step = std::max<std::size_t>(1, content.size() / std::max<std::size_t>(1, num));
+        for (std::size_t a = 0; a < content.size(); a += step) {
+            std::size_t b = std::min(a + step, content.size());
+            res.push_back(range<iterator>(content.begin() + a, content.begin() + b));
+        }
+        return res;
+    }
+
+    iterator begin() const {
+        return content.begin();
+    }
+
+    iterator end() const {
+        return content.end();
+    }
+
+    bool empty() const {
+        return content.empty();
+    }
+
+    std::size_t size() const {
+        return content.size();
+    }
+
+    /**
+     * Obtains an estimate of the number of bytes occupied by this set.
+     */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) + content.capacity() * sizeof(entry_type) +
+               fences.capacity() * sizeof(entry_type) + blocks.capacity() * sizeof(std::size_t);
+    }
+
+    /**
+     * Removes all tuples from this set, releasing their memory.
+     */
+    void clear() {
+        std::vector<entry_type>().swap(content);
+        std::vector<entry_type>().swap(fences);
+        std::vector<std::size_t>().swap(blocks);
+    }
+};
+
+}  // end namespace souffle
@@ -10,15 +10,22 @@
  *
  * @file GraphUtils.h
  *
- * A simple utility graph for conducting simple, graph-based operations.
+ * A simple utility graph for conducting simple, graph-based operations,
+ * and a compact graph for the analyses of large programs.
  *
  ***********************************************************************/
 
 #pragma once
 
+#include "Util.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
 #include <map>
 #include <ostream>
 #include <set>
+#include <utility>
+#include <vector>
 
 namespace souffle {
 
@@ -161,4 +168,169 @@ private:
     }
 };
 
+/**
+ * A compact graph on the vertices 0 to n-1, storing the successors and the predecessors of
+ * all vertices in sorted arrays in compressed sparse row form. Unlike the graph above, it
+ * is built at once from a list of edges and handles hundreds of thousands of vertices.
+ */
+class CompactGraph {
+public:
+    using Edge = std::pair<size_t, size_t>;
+
+    CompactGraph() = default;
+
+    /** Builds the graph of the given number of vertices from a list of edges, ignoring duplicates */
+    CompactGraph(size_t numVertices, std::vector<Edge> edges) {
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        fill(numVertices, edges, successorOffsets, successorTargets);
+        for (auto& edge : edges) {
+            std::swap(edge.first, edge.second);
+        }
+        std::sort(edges.begin(), edges.end());
+        fill(numVertices, edges, predecessorOffsets, predecessorTargets);
+    }
+
+    /** Get the number of vertices */
+    size_t size() const {
+        return successorOffsets.empty() ? 0 : successorOffsets.size() - 1;
+    }
+
+    /** Get the number of edges */
+    size_t numEdges() const {
+        return successorTargets.size();
+    }
+
+    /** Returns the sorted vertices the given vertex has edges to */
+    range<const size_t*> successors(size_t from) const {
+        assert(from < size());
+        return make_range(successorTargets.data() + successorOffsets[from],
+                successorTargets.data() + successorOffsets[from + 1]);
+    }
+
+    /** Returns the sorted vertices the given vertex has edges from */
+    range<const size_t*> predecessors(size_t to) const {
+        assert(to < size());
+        return make_range(predecessorTargets.data() + predecessorOffsets[to],
+                predecessorTargets.data() + predecessorOffsets[to + 1]);
+    }
+
+    /** Determines whether the given edge is present */
+    bool contains(size_t from, size_t to) const {
+        auto succ = successors(from);
+        return std::binary_search(succ.begin(), succ.end(), to);
+    }
+
+    /**
+     * Computes the strongly connected components with an iterative version of Tarjan's algorithm,
+     * storing the component of each vertex and returning the number of components. The roots and
+     * the edges are visited in increasing order. Following the successors, a component is numbered
+     * after all the components it reaches; following the predecessors (backwards), after all the
+     * components reaching it.
+     */
+    size_t computeSCCs(std::vector<size_t>& component, bool backwards = false) const {
+        const size_t none = (size_t)-1;
+        const size_t n = size();
+        const std::vector<size_t>& offsets = backwards ? predecessorOffsets : successorOffsets;
+        const std::vector<size_t>& targets = backwards ? predecessorTargets : successorTargets;
+
+        std::vector<size_t> index(n, none);
+        std::vector<size_t> lowLink(n);
+        // the vertices of the components not completed yet
+        std::vector<size_t> stack;
+        // the path of the depth-first search, each vertex with its next edge
+        std::vector<std::pair<size_t, size_t>> path;
+        size_t counter = 0;
+        size_t numSCCs = 0;
+        component.assign(n, none);
+
+        for (size_t root = 0; root < n; root++) {
+            if (index[root] != none) {
+                continue;
+            }
+            index[root] = lowLink[root] = counter++;
+            stack.push_back(root);
+            path.emplace_back(root, offsets[root]);
+            while (!path.empty()) {
+                const size_t v = path.back().first;
+                const size_t edge = path.back().second;
+                if (edge < offsets[v + 1]) {
+                    path.back().second++;
+                    const size_t w = targets[edge];
+                    if (index[w] == none) {
+                        index[w] = lowLink[w] = counter++;
+                        stack.push_back(w);
+                        path.emplace_back(w, offsets[w]);
+                    } else if (component[w] == none) {
+                        // w is on the stack, in a component not completed yet
+                        lowLink[v] = std::min(lowLink[v], index[w]);
+                    }
+                    continue;
+                }
+
+                // all edges of v are visited
+                path.pop_back();
+                if (!path.empty()) {
+                    size_t& parent = lowLink[path.back().first];
+                    parent = std::min(parent, lowLink[v]);
+                }
+                if (lowLink[v] == index[v]) {
+                    size_t w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        component[w] = numSCCs;
+                    } while (w != v);
+                    numSCCs++;
+                }
+            }
+        }
+        return numSCCs;
+    }
+
+    /** Enables graphs to be printed (e.g. for debugging) */
+    void print(std::ostream& out) const {
+        bool first = true;
+        out << "{";
+        for (size_t from = 0; from < size(); from++) {
+            for (size_t to : successors(from)) {
+                if (!first) {
+                    out << ",";
+                }
+                out << from << "->" << to;
+                first = false;
+            }
+        }
+        out << "}";
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const CompactGraph& g) {
+        g.print(out);
+        return out;
+    }
+
+private:
+    // the edges of vertex v are targets[offsets[v]] to targets[offsets[v + 1] - 1]
+    std::vector<size_t> successorOffsets;
+    std::vector<size_t> successorTargets;
+    std::vector<size_t> predecessorOffsets;
+    std::vector<size_t> predecessorTargets;
+
+    /** Fills the offsets and targets from edges sorted by their source */
+    static void fill(size_t numVertices, const std::vector<Edge>& edges, std::vector<size_t>& offsets,
+            std::vector<size_t>& targets) {
+        offsets.assign(numVertices + 1, 0);
+        targets.clear();
+        targets.reserve(edges.size());
+        for (const Edge& edge : edges) {
+            assert(edge.first < numVertices && edge.second < numVertices && "edge out of range");
+            offsets[edge.first + 1]++;
+            targets.push_back(edge.second);
+        }
+        for (size_t v = 0; v < numVertices; v++) {
+            offsets[v + 1] += offsets[v];
+        }
+    }
+};
+
 }  // end of namespace souffle
@@ -0,0 +1,127 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file HardwareCounters.h
+ *
+ * Declares the hardware performance counters read by the profiler
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ParallelUtils.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+namespace souffle {
+
+/**
+ * The hardware performance counters of the threads of the program, read
+ * with perf_event_open on Linux.
+ *
+ * A thread can only open counters for itself, hence the counters are opened
+ * by a parallel region on the first read, covering the threads of the
+ * parallel loops of the program. A sample sums the counters of all these
+ * threads. Counters the kernel does not permit or the processor does not
+ * provide are marked unavailable.
+ */
+class HardwareCounters {
+public:
+    /** the counted events */
+    enum Counter { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, NUM_COUNTERS };
+
+    /** the values of the counters at some point in time */
+    struct Sample {
+        uint64_t values[NUM_COUNTERS];
+
+        /** bit mask of the counters available */
+        uint32_t available;
+    };
+
+    ~HardwareCounters() {
+        for (const auto& thread : fds) {
+            for (int fd : thread) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+        }
+    }
+
+    /** get instance */
+    static HardwareCounters& instance() {
+        static HardwareCounters singleton;
+        return singleton;
+    }
+
+    /** Read the counters, summed over all threads */
+    Sample read() {
+        std::call_once(opened, [this]() {
+            PARALLEL_START {
+                openThread();
+            }
+            PARALLEL_END
+        });
+        Sample sample{};
+#ifdef __linux__
+        for (const auto& thread : fds) {
+            for (size_t i = 0; i < NUM_COUNTERS; i++) {
+                uint64_t value;
+                if (thread[i] >= 0 && ::read(thread[i], &value, sizeof(value)) == sizeof(value)) {
+                    sample.values[i] += value;
+                    sample.available |= 1u << i;
+                }
+            }
+        }
+#endif
+        return sample;
+    }
+
+private:
+    HardwareCounters() = default;
+
+    /** Open the counters of the calling thread */
+    void openThread() {
+        std::array<int, NUM_COUNTERS> thread;
+        thread.fill(-1);
+#ifdef __linux__
+        const uint64_t configs[NUM_COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (size_t i = 0; i < NUM_COUNTERS; i++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            thread[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+#endif
+        std::lock_guard<std::mutex> guard(fdsLock);
+        fds.push_back(thread);
+    }
+
+    /** the counters of each thread, -1 for those unavailable */
+    std::vector<std::array<int, NUM_COUNTERS>> fds;
+    std::mutex fdsLock;
+    std::once_flag opened;
+};
+
+}  // end of namespace souffle
@@ -0,0 +1,353 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file HashSet.h
+ *
+ * An unordered set of fixed length integer tuples based on a concurrent
+ * open-addressing hash table, for relations only accessed by point lookups.
+ *
+ * Tuples are distributed among a fixed number of independently locked
+ * shards, each an open-addressing table with linear probing. Besides the
+ * tuples, every shard keeps a tag per slot derived from the hash of its
+ * tuple, such that probing compares full tuples only in case of a likely
+ * match.
+ *
+ * Multiple insert operations can be conducted concurrently on a set, as can
+ * read-only operations. However, inserts and read operations may not be
+ * conducted at the same time.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "CompiledTuple.h"
+#include "ParallelUtils.h"
+#include "RamTypes.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A set of tuples of the given arity in no particular order, stored in a
+ * sharded hash table.
+ *
+ * @tparam N the arity of the stored tuples
+ */
+template <unsigned N>
+class HashSet {
+public:
+    using entry_type = ram::Tuple<RamDomain, N>;
+    using element_type = entry_type;
+
+private:
+    // the number of shards of the hash table (log 2)
+    enum { SHARD_BITS = 6, NUM_SHARDS = 1 << SHARD_BITS };
+
+    // the number of slots of a shard once it receives its first tuple
+    enum { INITIAL_SLOTS = 16 };
+
+    /**
+     * A shard of the table; slots are only allocated on the first insert.
+     */
+    struct Shard {
+        // the tags of the slots, 0 marking an empty slot
+        std::vector<uint32_t> tags;
+
+        // the stored tuples
+        std::vector<entry_type> slots;
+
+        // the number of occupied slots
+        std::size_t size = 0;
+
+        // a lock synchronizing insertions into this shard
+        Lock lock;
+    };
+
+    // the shards of the table
+    std::unique_ptr<Shard[]> shards;
+
+    static uint64_t hash(const entry_type& t) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (unsigned i = 0; i < N; ++i) {
+            h ^= static_cast<uint32_t>(t[i]);
+            h *= 0x100000001b3ull;
+        }
+        // final mix such that the shard, the slot, and the tag depend on all values
+        h ^= h >> 29;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 32;
+        return h;
+    }
+
+    static std::size_t getShard(uint64_t h) {
+        return static_cast<std::size_t>(h >> (64 - SHARD_BITS));
+    }
+
+    static uint32_t getTag(uint64_t h) {
+        return static_cast<uint32_t>(h >> 26) | 1;
+    }
+
+    // obtains the slot of the given tuple in the given shard, or the free slot it would occupy
+    static std::size_t probe(const Shard& shard, const entry_type& t, uint64_t h) {
+        const std::size_t mask = shard.tags.size() - 1;
+        const uint32_t tag = getTag(h);
+        std::size_t pos = h & mask;
+        while (shard.tags[pos] != 0) {
+            if (shard.tags[pos] == tag && shard.slots[pos] == t) {
+                return pos;
+            }
+            pos = (pos + 1) & mask;
+        }
+        return pos;
+    }
+
+    // resizes the slots of the given shard; the caller holds the shard's lock
+    static void grow(Shard& shard) {
+        Shard next;
+        const std::size_t capacity = shard.tags.empty() ? INITIAL_SLOTS : shard.tags.size() * 2;
+        next.tags.resize(capacity, 0);
+        next.slots.resize(capacity);
+        for (std::size_t i = 0; i < shard.tags.size(); ++i) {
+            if (shard.tags[i] != 0) {
+                std::size_t pos = probe(next, shard.slots[i], hash(shard.slots[i]));
+                next.tags[pos] = shard.tags[i];
+                next.slots[pos] = shard.slots[i];
+            }
+        }
+        shard.tags.swap(next.tags);
+        shard.slots.swap(next.slots);
+    }
+
+public:
+    /**
+     * The hints for operations on a set. Point lookups do not benefit from
+     * hints, hence there are none; the type is kept for uniformity with the
+     * other data structures.
+     */
+    struct op_context {};
+
+    /**
+     * An iterator over the tuples of a set, visiting occupied slots shard by shard.
+     */
+    class iterator : public std::iterator<std::forward_iterator_tag, entry_type> {
+        // the shards of the iterated set, null for a default-constructed iterator
+        const Shard* shards = nullptr;
+
+        // the current shard, NUM_SHARDS for the end of the set
+        std::size_t shard = NUM_SHARDS;
+
+        // the current slot within the current shard
+        std::size_t slot = 0;
+
+        // moves forward to the next occupied slot, if the current one is empty
+        void normalize() {
+            while (shard < NUM_SHARDS) {
+                const auto& tags = shards[shard].tags;
+                while (slot < tags.size() && tags[slot] == 0) {
+                    ++slot;
+                }
+                if (slot < tags.size()) {
+                    return;
+                }
+                ++shard;
+                slot = 0;
+            }
+        }
+
+    public:
+        iterator() = default;
+
+        iterator(const Shard* shards, std::size_t shard, std::size_t slot)
+                : shards(shards), shard(shard), slot(slot) {
+            normalize();
+        }
+
+        bool operator==(const iterator& other) const {
+            return shard == other.shard && slot == other.slot;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+        const entry_type& operator*() const {
+            return shards[shard].slots[slot];
+        }
+
+        const entry_type* operator->() const {
+            return &**this;
+        }
+
+        iterator& operator++() {
+            ++slot;
+            normalize();
+            return *this;
+        }
+
+        iterator operator++(int) {
+            auto res = *this;
+            ++(*this);
+            return res;
+        }
+    };
+
+    using const_iterator = iterator;
+
+    HashSet() : shards(new Shard[NUM_SHARDS]) {}
+
+    HashSet(const HashSet&) = delete;
+    HashSet& operator=(const HashSet&) = delete;
+
+    /**
+     * Inserts the given tuple into this set.
+     *
+     * @return true if the tuple was not present before, false otherwise
+     */
+    bool insert(const entry_type& t) {
+        const uint64_t h = hash(t);
+        Shard& shard = shards[getShard(h)];
+        auto lease = shard.lock.acquire();
+        (void)lease;
+
+        // keep the load factor below 3/4
+        if ((shard.size + 1) * 4 > shard.tags.size() * 3) {
+            grow(shard);
+        }
+
+        std::size_t pos = probe(shard, t, h);
+        if (shard.tags[pos] != 0) {
+            return false;
+        }
+        shard.tags[pos] = getTag(h);
+        shard.slots[pos] = t;
+        shard.size++;
+        return true;
+    }
+
+    bool insert(const entry_type& t, op_context& /* ctxt */) {
+        return insert(t);
+    }
+
+    /**
+     * Inserts all tuples of the given set into this set.
+     */
+    void insertAll(const HashSet& other) {
+        if (this == &other) {
+            return;
+        }
+        for (const auto& cur : other) {
+            insert(cur);
+        }
+    }
+
+    /**
+     * Determines whether the given tuple is present in this set.
+     */
+    bool contains(const entry_type& t) const {
+        return find(t) != end();
+    }
+
+    bool contains(const entry_type& t, op_context& /* ctxt */) const {
+        return contains(t);
+    }
+
+    /**
+     * Obtains an iterator referencing the given tuple, or the end of this set if it is not present.
+     */
+    iterator find(const entry_type& t) const {
+        const uint64_t h = hash(t);
+        const std::size_t s = getShard(h);
+        const Shard& shard = shards[s];
+        if (shard.size == 0) {
+            return end();
+        }
+        std::size_t pos = probe(shard, t, h);
+        return (shard.tags[pos] != 0) ? iterator(shards.get(), s, pos) : end();
+    }
+
+    iterator find(const entry_type& t, op_context& /* ctxt */) const {
+        return find(t);
+    }
+
+    /**
+     * Partitions this set into approximately the given number of ranges,
+     * each covering whole shards or equally sized parts of a shard.
+     */
+    std::vector<range<iterator>> partition(std::size_t num) const {
+        std::vector<range<iterator>> res;
+        const std::size_t perShard = (num + NUM_SHARDS - 1) / NUM_SHARDS;
+        for (std::size_t s = 0; s < NUM_SHARDS; ++s) {
+            const Shard& shard = shards[s];
+            if (shard.size == 0) {
+                continue;
+            }
+            const std::size_t step = std::max<std::size_t>(1, shard.tags.size() / perShard);
+            for (std::size_t a = 0; a < shard.tags.size(); a += step) {
+                iterator begin(shards.get(), s, a);
+                iterator end(shards.get(), s, a + step);
+                if (begin != end) {
+                    res.push_back(range<iterator>(begin, end));
+                }
+            }
+        }
+        return res;
+    }
+
+    iterator begin() const {
+        return iterator(shards.get(), 0, 0);
+    }
+
+    iterator end() const {
+        return iterator();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    std::size_t size() const {
+        std::size_t res = 0;
+        for (std::size_t s = 0; s < NUM_SHARDS; ++s) {
+            res += shards[s].size;
+        }
+        return res;
+    }
+
+    /**
+     * Obtains an estimate of the number of bytes occupied by this set.
+     */
+    std::size_t getMemoryUsage() const {
+        std::size_t res = sizeof(*this) + NUM_SHARDS * sizeof(Shard);
+        for (std::size_t s = 0; s < NUM_SHARDS; ++s) {
+            res += shards[s].tags.capacity() * (sizeof(uint32_t) + sizeof(entry_type));
+        }
+        return res;
+    }
+
+    /**
+     * Removes all tuples from this set.
+     */
+    void clear() {
+        for (std::size_t s = 0; s < NUM_SHARDS; ++s) {
+            Shard& shard = shards[s];
+            std::vector<uint32_t>().swap(shard.tags);
+            std::vector<entry_type>().swap(shard.slots);
+            shard.size = 0;
+        }
+    }
+};
+
+}  // end namespace souffle
@@ -63,6 +63,11 @@ public:
         directives["filename"] = filename;
     }
 
+    /** Whether relations of an IO type are stored in a file, given by the directive filename */
+    static bool isFileType(const std::string& type) {
+        return type == "file" || type == "binary" || type == "arrow" || type == "parquet";
+    }
+
     const std::string& getRelationName() const {
         return get("name");
     }
@@ -75,6 +80,10 @@ public:
         return directives.empty();
     }
 
+    const std::map<std::string, std::string>& getDirectives() const {
+        return directives;
+    }
+
     void print(std::ostream& out) const {
         auto cur = directives.begin();
         if (cur == directives.end()) {
@@ -16,9 +16,11 @@
 
 #include "IODirectives.h"
 #include "ReadStream.h"
+#include "ReadStreamBinary.h"
 #include "ReadStreamCSV.h"
 #include "SymbolTable.h"
 #include "WriteStream.h"
+#include "WriteStreamBinary.h"
 #include "WriteStreamCSV.h"
 
 #ifdef USE_SQLITE
@@ -26,6 +28,11 @@
 #include "WriteStreamSQLite.h"
 #endif
 
+#ifdef USE_ARROW
+#include "ReadStreamArrow.h"
+#include "WriteStreamArrow.h"
+#endif
+
 #include <map>
 #include <memory>
 #include <string>
@@ -56,7 +63,12 @@ public:
         if (outputFactories.count(ioType) == 0) {
             throw std::invalid_argument("Requested output type <" + ioType + "> is not supported.");
         }
-        return outputFactories.at(ioType)->getWriter(symbolMask, symbolTable, ioDirectives, provenance);
+        auto writer =
+                outputFactories.at(ioType)->getWriter(symbolMask, symbolTable, ioDirectives, provenance);
+        if (ioDirectives.has("limit")) {
+            writer->setLimit(std::stoul(ioDirectives.get("limit")));
+        }
+        return writer;
     }
     /**
      * Return a new ReadStream
@@ -78,9 +90,17 @@ private:
         registerWriteStreamFactory(std::make_shared<WriteFileCSVFactory>());
         registerWriteStreamFactory(std::make_shared<WriteCoutCSVFactory>());
         registerWriteStreamFactory(std::make_shared<WriteCoutPrintSizeFactory>());
+        registerReadStreamFactory(std::make_shared<ReadFileBinaryFactory>());
+        registerWriteStreamFactory(std::make_shared<WriteFileBinaryFactory>());
 #ifdef USE_SQLITE
         registerReadStreamFactory(std::make_shared<ReadSQLiteFactory>());
         registerWriteStreamFactory(std::make_shared<WriteSQLiteFactory>());
+#endif
+#ifdef USE_ARROW
+        registerReadStreamFactory(std::make_shared<ReadArrowFactory>());
+        registerReadStreamFactory(std::make_shared<ReadParquetFactory>());
+        registerWriteStreamFactory(std::make_shared<WriteArrowFactory>());
+        registerWriteStreamFactory(std::make_shared<WriteParquetFactory>());
 #endif
     };
     std::map<std::string, std::shared_ptr<WriteStreamFactory>> outputFactories;
@@ -16,22 +16,32 @@
 
 #include "AstArgument.h"
 #include "AstClause.h"
+#include "AstIOTypeAnalysis.h"
 #include "AstLiteral.h"
 #include "AstNode.h"
+#include "AstProfileUse.h"
 #include "AstProgram.h"
 #include "AstRelation.h"
 #include "AstRelationIdentifier.h"
 #include "AstTransforms.h"
 #include "AstTranslationUnit.h"
+#include "AstUtils.h"
 #include "AstVisitor.h"
 #include "BinaryConstraintOps.h"
+#include "DebugReport.h"
 #include "FunctorOps.h"
+#include "Global.h"
+#include "PrecedenceGraph.h"
 #include "Util.h"
 #include <cassert>
+#include <cmath>
 #include <cstddef>
+#include <iostream>
+#include <map>
 #include <memory>
 #include <ostream>
 #include <set>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -952,10 +962,154 @@ std::vector<AstClause*> getInlinedClause(AstProgram& program, const AstClause& c
     }
 }
 
+/**
+ * Marks small non-recursive relations used once or twice in the bodies of clauses for inlining.
+ * The relations are considered in topological order, and inlined as long as the number of clauses
+ * of the program is estimated to grow by at most the factor of --inline-auto, where a clause using
+ * a relation of n clauses k times is replaced by n^k clauses. With a profile, relations used twice
+ * are only inlined if evaluating their bodies again, size times the number of body atoms, is
+ * estimated to cost less than building them, size times the probe cost log2(size).
+ * Returns true if relations were marked.
+ */
+bool selectAutomaticInlining(AstTranslationUnit& translationUnit) {
+    // limits on the relations considered
+    const size_t maxClauses = 4;
+    const size_t maxBodyAtoms = 4;
+    const size_t maxUses = 2;
+
+    AstProgram& program = *translationUnit.getProgram();
+    const auto* ioType = translationUnit.getAnalysis<IOType>();
+    const auto* sccGraph = translationUnit.getAnalysis<SCCGraph>();
+    const auto* topsortSCCGraph = translationUnit.getAnalysis<TopologicallySortedSCCGraph>();
+    auto* profileUse =
+            Global::config().has("profile-use") ? translationUnit.getAnalysis<AstProfileUse>() : nullptr;
+    const double growth = std::stod(Global::config().get("inline-auto"));
+    std::stringstream report;
+
+    // the clauses using each relation once per positive body atom, and the relations used otherwise
+    // (negated, aggregated, with counters or in clauses with execution plans)
+    std::map<const AstRelation*, std::vector<const AstClause*>> uses;
+    std::set<const AstRelation*> excluded;
+    std::set<const AstAtom*> bodyAtoms;
+    size_t totalClauses = 0;
+    for (const AstRelation* rel : program.getRelations()) {
+        for (const AstClause* clause : rel->getClauses()) {
+            totalClauses++;
+            for (const AstAtom* atom : clause->getAtoms()) {
+                const AstRelation* used = getAtomRelation(atom, &program);
+                bool counter = false;
+                visitDepthFirst(*atom, [&](const AstCounter&) { counter = true; });
+                if (counter || clause->getExecutionPlan() != nullptr) {
+                    excluded.insert(used);
+                }
+                uses[used].push_back(clause);
+                bodyAtoms.insert(atom);
+            }
+        }
+    }
+    visitDepthFirst(program, [&](const AstClause& clause) {
+        const AstAtom* head = clause.getHead();
+        visitDepthFirst(clause, [&](const AstAtom& atom) {
+            if (&atom != head && bodyAtoms.count(&atom) == 0) {
+                excluded.insert(getAtomRelation(&atom, &program));
+            }
+        });
+    });
+
+    // the estimated number of clauses replacing each clause
+    std::map<const AstClause*, double> versions;
+    const double maxTotal = growth * totalClauses;
+    double total = totalClauses;
+
+    bool changed = false;
+    for (size_t scc : topsortSCCGraph->order()) {
+        if (sccGraph->isRecursive(scc)) {
+            continue;
+        }
+        for (const AstRelation* rel : sccGraph->getInternalRelations(scc)) {
+            const auto& relUses = uses[rel];
+            const auto clauses = rel->getClauses();
+            if (rel->isInline() || ioType->isIO(rel) || rel->isSubsumptive() ||
+                    rel->getRepresentation() == RelationRepresentation::EQREL ||
+                    rel->getFactTable() != nullptr || excluded.count(rel) != 0 || relUses.empty() ||
+                    relUses.size() > maxUses || clauses.empty() || clauses.size() > maxClauses) {
+                continue;
+            }
+
+            // the body of each clause must be small and free of aggregates, counters and plans
+            bool simple = true;
+            size_t atoms = 0;
+            for (const AstClause* clause : clauses) {
+                atoms = std::max(atoms, clause->getAtoms().size());
+                visitDepthFirst(*clause, [&](const AstAggregator&) { simple = false; });
+                visitDepthFirst(*clause, [&](const AstCounter&) { simple = false; });
+                simple = simple && clause->getExecutionPlan() == nullptr;
+            }
+            if (!simple || atoms > maxBodyAtoms) {
+                continue;
+            }
+
+            // the evaluation cost, by the size of the relation in the profile
+            if (profileUse != nullptr && relUses.size() > 1 && profileUse->hasRelationSize(rel->getName())) {
+                const double size = profileUse->getRelationSize(rel->getName());
+                const double inlinedCost = (relUses.size() - 1) * size * std::max<size_t>(atoms, 1);
+                const double materialisedCost = size * std::log2(size + 2);
+                if (inlinedCost > materialisedCost) {
+                    report << rel->getName() << ": not inlined, re-evaluation cost " << inlinedCost
+                           << " exceeds materialisation cost " << materialisedCost << "\n";
+                    continue;
+                }
+            }
+
+            // the clauses of the program after inlining the relation
+            double size = 0;
+            for (const AstClause* clause : clauses) {
+                size += versions.count(clause) != 0 ? versions[clause] : 1;
+            }
+            std::map<const AstClause*, size_t> occurrences;
+            for (const AstClause* clause : relUses) {
+                occurrences[clause]++;
+            }
+            double newTotal = total - size;
+            for (const auto& cur : occurrences) {
+                const double old = versions.count(cur.first) != 0 ? versions[cur.first] : 1;
+                newTotal += old * (std::pow(size, cur.second) - 1);
+            }
+            if (newTotal > maxTotal) {
+                report << rel->getName() << ": not inlined, " << newTotal << " clauses exceed the limit of "
+                       << maxTotal << "\n";
+                continue;
+            }
+
+            for (const auto& cur : occurrences) {
+                const double old = versions.count(cur.first) != 0 ? versions[cur.first] : 1;
+                versions[cur.first] = old * std::pow(size, cur.second);
+            }
+            report << rel->getName() << ": inlined into " << occurrences.size() << " clauses, " << total
+                   << " -> " << newTotal << " clauses\n";
+            total = newTotal;
+            program.getRelation(rel->getName())->setQualifier(rel->getQualifier() | INLINE_RELATION);
+            changed = true;
+        }
+    }
+
+    if (Global::config().has("verbose")) {
+        std::cout << report.str();
+    }
+    translationUnit.getDebugReport().addSection(
+            DebugReporter::getCodeSection("automatic-inlining", "Automatic Inlining", report.str()));
+    return changed;
+}
+
 bool InlineRelationsTransformer::transform(AstTranslationUnit& translationUnit) {
     bool changed = false;
     AstProgram& program = *translationUnit.getProgram();
 
+    // Select small relations to inline in addition to those marked
+    if (Global::config().has("inline-auto")) {
+        changed = selectAutomaticInlining(translationUnit);
+    }
+
     // Replace constants in the head of inlined clauses with (constrained) variables.
     // This is done to simplify atom unification, particularly when negations are involved.
     normaliseInlinedHeads(program);
@@ -0,0 +1,176 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file InputPrefetcher.h
+ *
+ * Reading the input relations of a program on background threads from
+ * its start on, such that loading overlaps with the evaluation of the
+ * strata before those loading the relations (--prefetch-input).
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamTypes.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/** The tuples of an input relation read ahead of its load, stored one after the other */
+class TupleBuffer {
+public:
+    explicit TupleBuffer(size_t width) : width(width) {}
+
+    void insert(const RamDomain* tuple) {
+        data.insert(data.end(), tuple, tuple + width);
+        ++count;
+    }
+
+    /** Insert the tuples into a relation */
+    template <typename T>
+    void insertInto(T& relation) const {
+        insertInto(relation, 0);
+    }
+
+private:
+    /** Relations built from their sorted tuples receive all of them at once */
+    template <typename T>
+    auto insertInto(T& relation, int) const -> decltype(relation.loadAll(std::vector<RamDomain>())) {
+        relation.loadAll(data);
+    }
+
+    template <typename T>
+    void insertInto(T& relation, long) const {
+        for (size_t i = 0; i < count; ++i) {
+            relation.insert(data.data() + i * width);
+        }
+    }
+
+    size_t width;
+    size_t count = 0;
+    std::vector<RamDomain> data;
+};
+
+/**
+ * Reads inputs on a few background threads, in the order of their
+ * submission, into buffers that the loads of the relations insert from.
+ *
+ * The readers share the symbol table with the evaluation, looking up
+ * their symbols while the strata before their loads are evaluated.
+ */
+class InputPrefetcher {
+public:
+    /** the number of inputs read concurrently, each of them possibly parsed by several threads */
+    static constexpr size_t READERS = 4;
+
+    using Reader = std::function<void(TupleBuffer&)>;
+
+    InputPrefetcher() = default;
+    InputPrefetcher(const InputPrefetcher&) = delete;
+
+    ~InputPrefetcher() {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            pending.clear();
+            stopped = true;
+        }
+        changed.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    /** The key of the input given by a directive of the loads of a relation */
+    static std::string key(const std::string& relation, size_t directive) {
+        return relation + "/" + std::to_string(directive);
+    }
+
+    /** Start reading an input of the given width, identified by a key */
+    void prefetch(const std::string& key, size_t width, Reader read) {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            if (results.count(key) != 0) {
+                return;
+            }
+            auto promise = std::make_shared<std::promise<TupleBuffer>>();
+            results[key] = promise->get_future();
+            pending.push_back([width, read, promise]() {
+                try {
+                    TupleBuffer tuples(width);
+                    read(tuples);
+                    promise->set_value(std::move(tuples));
+                } catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+            if (workers.size() < READERS) {
+                workers.emplace_back([this]() { run(); });
+            }
+        }
+        changed.notify_one();
+    }
+
+    /**
+     * Insert the tuples read for a key into a relation once they are read,
+     * rethrowing the errors of the read. Returns false if the key was not
+     * prefetched, or was loaded before.
+     */
+    template <typename T>
+    bool load(const std::string& key, T& relation) {
+        std::future<TupleBuffer> result;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            auto found = results.find(key);
+            if (found == results.end() || !found->second.valid()) {
+                return false;
+            }
+            result = std::move(found->second);
+        }
+        result.get().insertInto(relation);
+        return true;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> guard(mutex);
+        while (true) {
+            changed.wait(guard, [this]() { return stopped || !pending.empty(); });
+            if (pending.empty()) {
+                return;
+            }
+            std::function<void()> task = std::move(pending.front());
+            pending.pop_front();
+            guard.unlock();
+            task();
+            guard.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::function<void()>> pending;
+    std::map<std::string, std::future<TupleBuffer>> results;
+    bool stopped = false;
+    std::vector<std::thread> workers;
+};
+
+}  // end of namespace souffle
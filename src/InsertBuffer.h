@@ -0,0 +1,147 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file InsertBuffer.h
+ *
+ * A thread-private buffer of the tuples a parallel operation inserts into a
+ * shared relation.
+ *
+ * Threads inserting into the same b-tree contend on the locks of its nodes,
+ * all the more where a rule derives many duplicates of few tuples. A buffer
+ * instead collects the insertions of a single thread and hands them to the
+ * relation sorted and free of duplicates once flushed, such that the inserts
+ * follow each other in the tree and profit from the operation hints.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamTypes.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * An unordered collection of tuples of a fixed arity, compacted by sorting
+ * and removing duplicates whenever it reaches its capacity. Where compacting
+ * does not free half of the capacity, the buffer asks to be flushed, which
+ * bounds its memory.
+ */
+class InsertBuffer {
+public:
+    /** the number of tuples a buffer holds before being compacted */
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+    /**
+     * Creates an empty buffer, not accepting any tuples.
+     */
+    InsertBuffer() = default;
+
+    /**
+     * Creates a buffer for tuples of the given arity.
+     */
+    explicit InsertBuffer(size_t arity, size_t capacity = DEFAULT_CAPACITY)
+            : arity(arity), capacity(std::max<size_t>(capacity, 2)) {
+        assert(arity > 0 && "nullary tuples are not buffered");
+    }
+
+    size_t getArity() const {
+        return arity;
+    }
+
+    /** Get the number of buffered tuples, including duplicates not yet removed */
+    size_t size() const {
+        return (arity == 0) ? 0 : data.size() / arity;
+    }
+
+    bool empty() const {
+        return data.empty();
+    }
+
+    /**
+     * Adds a tuple to this buffer.
+     *
+     * @param tuple the values of the tuple to be added
+     * @return true if the buffer is to be flushed to bound its memory, false otherwise
+     */
+    bool insert(const RamDomain* tuple) {
+        data.insert(data.end(), tuple, tuple + arity);
+        compacted = false;
+        if (size() < capacity) {
+            return false;
+        }
+        compact();
+        return 2 * size() > capacity;
+    }
+
+    /**
+     * Passes the distinct buffered tuples in lexicographical order to the given
+     * function and empties the buffer.
+     *
+     * @param insert the function inserting a tuple, given by its values, into the target
+     */
+    template <typename Insert>
+    void flush(Insert insert) {
+        if (data.empty()) {
+            return;
+        }
+        compact();
+        for (size_t i = 0; i < data.size(); i += arity) {
+            insert(&data[i]);
+        }
+        data.clear();
+    }
+
+private:
+    /** Sort the buffered tuples and remove duplicates */
+    void compact() {
+        if (compacted) {
+            return;
+        }
+        const size_t n = arity;
+        std::vector<const RamDomain*> rows;
+        rows.reserve(size());
+        for (size_t i = 0; i < data.size(); i += n) {
+            rows.push_back(&data[i]);
+        }
+        std::sort(rows.begin(), rows.end(), [n](const RamDomain* a, const RamDomain* b) {
+            return std::lexicographical_compare(a, a + n, b, b + n);
+        });
+        rows.erase(std::unique(rows.begin(), rows.end(),
+                           [n](const RamDomain* a, const RamDomain* b) { return std::equal(a, a + n, b); }),
+                rows.end());
+
+        std::vector<RamDomain> res;
+        res.reserve(std::max(rows.size() * n, data.capacity()));
+        for (const RamDomain* row : rows) {
+            res.insert(res.end(), row, row + n);
+        }
+        data.swap(res);
+        compacted = true;
+    }
+
+    // the arity of the buffered tuples
+    size_t arity = 0;
+
+    // the number of tuples after which the buffer is compacted
+    size_t capacity = DEFAULT_CAPACITY;
+
+    // the values of the buffered tuples, one after the other
+    std::vector<RamDomain> data;
+
+    // whether the buffered tuples are sorted and free of duplicates
+    bool compacted = true;
+};
+
+}  // end of namespace souffle
@@ -21,10 +21,12 @@
 #include "Global.h"
 #include "IODirectives.h"
 #include "IOSystem.h"
+#include "LeapfrogJoin.h"
 #include "LVMIndex.h"
 #include "LVMRecords.h"
 #include "LVMRelation.h"
 #include "Logger.h"
+#include "Numa.h"
 #include "ParallelUtils.h"
 #include "ProfileEvent.h"
 #include "RamExpression.h"
@@ -32,13 +34,19 @@
 #include "RamNode.h"
 #include "RamOperation.h"
 #include "RamProgram.h"
+#include "RamStratumDependencyAnalysis.h"
 #include "RamVisitor.h"
 #include "ReadStream.h"
+#include "SampleProfiler.h"
+#include "Shm.h"
 #include "SignalHandler.h"
 #include "SymbolTable.h"
+#include "TraceLog.h"
+#include "TransitiveClosure.h"
 #include "Util.h"
 #include "WriteStream.h"
 #include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
@@ -47,31 +55,281 @@
 #include <functional>
 #include <iostream>
 #include <memory>
-#include <regex>
 #include <sstream>
 #include <stdexcept>
 #include <typeinfo>
 #include <utility>
 #include <ffi.h>
 
+// Direct-threaded dispatch relies on the labels-as-values extension of GCC and Clang
+#if defined(__GNUC__) && !defined(LVM_SWITCH_DISPATCH)
+#define LVM_THREADED_DISPATCH
+#endif
+
 namespace souffle {
 
+namespace {
+
+/**
+ * A source streaming the values common to a column of several relations
+ * restricted to the tuples matching a pattern, each value forming a unary tuple.
+ */
+class IntersectSource : public Stream::Source {
+    // the join of the participants
+    LeapfrogJoin join;
+
+    // an internal buffer for the enumerated values
+    std::array<RamDomain, Stream::BUFFER_SIZE> buffer{};
+
+public:
+    IntersectSource(LeapfrogJoin join) : join(std::move(join)) {}
+
+    int load(TupleRef* out, int max) override {
+        int c = 0;
+        while (c < max && join.next()) {
+            buffer[c] = join.get();
+            out[c] = TupleRef(&buffer[c], 1);
+            ++c;
+        }
+        return c;
+    }
+
+    std::unique_ptr<Stream::Source> clone() override {
+        auto* source = new IntersectSource(join);
+        source->buffer = buffer;
+        return std::unique_ptr<Stream::Source>(source);
+    }
+};
+
+/**
+ * A participant of an intersection, seeking the values of a column among the
+ * tuples of a relation matching the bound columns of a key.
+ */
+struct IntersectParticipant {
+    const LVMRelation* rel;
+    size_t indexPos;
+    size_t column;
+
+    // the bound values of the pattern, all other columns being at their minimum
+    std::vector<RamDomain> key;
+    std::vector<bool> bound;
+
+    // buffers for the searched entry and the located tuple
+    std::vector<RamDomain> low;
+    std::vector<RamDomain> res;
+
+    bool seek(RamDomain& value) {
+        low = key;
+        low[column] = value;
+        if (!rel->lowerBound(indexPos, TupleRef(low.data(), low.size()), res.data())) {
+            return false;
+        }
+        // the located tuple must still match the bound columns
+        for (size_t i = 0; i < key.size(); ++i) {
+            if (bound[i] && res[i] != key[i]) {
+                return false;
+            }
+        }
+        value = res[column];
+        return true;
+    }
+};
+
+/**
+ * The stack of values of an execution, a flat array of the depth bounded by
+ * the generator of the code, rather than a deque-backed std::stack.
+ */
+class EvalStack {
+    std::unique_ptr<RamDomain[]> values;
+    RamDomain* next;
+    RamDomain* const end;
+
+public:
+    EvalStack(size_t depth) : values(new RamDomain[depth]), next(values.get()), end(values.get() + depth) {}
+
+    void push(RamDomain value) {
+        assert(next < end && "evaluation stack overflow");
+        *next++ = value;
+    }
+
+    RamDomain top() const {
+        assert(next > values.get() && "evaluation stack underflow");
+        return next[-1];
+    }
+
+    void pop() {
+        assert(next > values.get() && "evaluation stack underflow");
+        --next;
+    }
+
+    size_t size() const {
+        return next - values.get();
+    }
+};
+
+/** The number of values fetched per batch of a scan, such that a batch of wide tuples fits the L1 cache */
+constexpr int BATCH_VALUES = 1024;
+
+/**
+ * Keeps the tuples of a batch whose value in the given column compares to an operand -- a
+ * constant, or another column of the tuple -- moving them to the front.
+ *
+ * @return the number of tuples kept
+ */
+template <typename Compare>
+int selectTuples(const RamDomain** tuples, int count, RamDomain column, bool isColumn, RamDomain operand,
+        Compare compare) {
+    int kept = 0;
+    if (isColumn) {
+        for (int i = 0; i < count; ++i) {
+            const RamDomain* tuple = tuples[i];
+            tuples[kept] = tuple;
+            kept += compare(tuple[column], tuple[operand]);
+        }
+    } else {
+        for (int i = 0; i < count; ++i) {
+            const RamDomain* tuple = tuples[i];
+            tuples[kept] = tuple;
+            kept += compare(tuple[column], operand);
+        }
+    }
+    return kept;
+}
+
+/**
+ * Fetches the next batch of tuples of a stream passing the given comparisons, each encoded
+ * by its operator, its column, whether the operand is a column and the operand.
+ *
+ * @return false if the stream is exhausted
+ */
+bool fetchBatch(Stream& stream, LVMContext::Batch& batch, size_t arity, const LVMWord* comparisons,
+        size_t numComparisons) {
+    const int max = std::min<int>(
+            Stream::BUFFER_SIZE, std::max<int>(16, BATCH_VALUES / std::max<size_t>(arity, 1)));
+    batch.pos = 0;
+    do {
+        batch.size = stream.fetch(&batch.tuples[0], max);
+        if (batch.size == 0) {
+            return false;
+        }
+        for (size_t i = 0; i < numComparisons && batch.size > 0; ++i) {
+            const LVMWord* cur = comparisons + 4 * i;
+            const RamDomain column = cur[1];
+            const bool isColumn = cur[2] != 0;
+            const RamDomain operand = cur[3];
+            const RamDomain** tuples = &batch.tuples[0];
+            switch (static_cast<BinaryConstraintOp>(cur[0])) {
+                case BinaryConstraintOp::EQ:
+                    batch.size = selectTuples(tuples, batch.size, column, isColumn, operand,
+                            [](RamDomain a, RamDomain b) { return a == b; });
+                    break;
+                case BinaryConstraintOp::NE:
+                    batch.size = selectTuples(tuples, batch.size, column, isColumn, operand,
+                            [](RamDomain a, RamDomain b) { return a != b; });
+                    break;
+                case BinaryConstraintOp::LT:
+                    batch.size = selectTuples(tuples, batch.size, column, isColumn, operand,
+                            [](RamDomain a, RamDomain b) { return a < b; });
+                    break;
+                case BinaryConstraintOp::LE:
+                    batch.size = selectTuples(tuples, batch.size, column, isColumn, operand,
+                            [](RamDomain a, RamDomain b) { return a <= b; });
+                    break;
+                case BinaryConstraintOp::GT:
+                    batch.size = selectTuples(tuples, batch.size, column, isColumn, operand,
+                            [](RamDomain a, RamDomain b) { return a > b; });
+                    break;
+                case BinaryConstraintOp::GE:
+                    batch.size = selectTuples(tuples, batch.size, column, isColumn, operand,
+                            [](RamDomain a, RamDomain b) { return a >= b; });
+                    break;
+                default:
+                    assert(false && "comparison not evaluated in batches");
+            }
+        }
+    } while (batch.size == 0);
+    return true;
+}
+
+}  // namespace
+
 void LVM::executeMain() {
     const RamStatement& main = *translationUnit.getProgram()->getMain();
-    if (mainProgram.get() == nullptr) {
-        LVMGenerator generator(translationUnit.getSymbolTable(), main, relationEncoder);
-        mainProgram = generator.getCodeStream();
+    const int jobs = std::stoi(Global::config().get("jobs"));
+    // lazy and cold indexes are built and dropped on relations other strata may read concurrently
+    const bool concurrent = translationUnit.getAnalysis<RamStratumDependencyAnalysis>()->isConcurrent() &&
+                            jobs != 1 && !Global::config().has("index-budget") &&
+                            !Global::config().has("cold-relations");
+    if (mainProgram.get() == nullptr && !concurrent && reusedStrata.empty()) {
+        mainProgram = generate(main);
     }
     LVMContext ctxt;
+#ifdef _OPENMP
+    if (jobs > 0) {
+        omp_set_num_threads(jobs);
+    }
+#endif
+    if (Global::config().has("numa")) {
+        numa::enable(Global::config().has("numa", "interleave") ? numa::Placement::INTERLEAVE
+                                                                : numa::Placement::LOCAL);
+    }
     SignalHandler::instance()->set();
     if (Global::config().has("verbose")) {
         SignalHandler::instance()->enableLogging();
     }
 
-    if (!profile) {
+    createRelationSymbols();
+    if (reusedFrom != nullptr) {
+        restoreReusedStrata();
+        reusedFrom = nullptr;
+    }
+
+    // the inputs are read in the background from the start on, and inserted into their relations by the loads
+    if (Global::config().has("prefetch-input")) {
+        visitDepthFirst(main, [&](const RamLoad& load) {
+            SymbolTable* symbolTable = &getSymbolTable(load.getRelation().getName());
+            std::vector<bool> symbolMask;
+            for (auto& cur : load.getRelation().getAttributeTypeQualifiers()) {
+                symbolMask.push_back(cur[0] == 's');
+            }
+            const bool provenance = load.getRelation().hasProvenanceColumns();
+            size_t directive = 0;
+            for (const IODirectives& io : load.getIODirectives()) {
+                auto read = [symbolMask, io, symbolTable, provenance](TupleBuffer& tuples) {
+                    IOSystem::getInstance()
+                            .getReader(symbolMask, *symbolTable, io, provenance)
+                            ->readAll(tuples);
+                };
+                inputPrefetcher.prefetch(InputPrefetcher::key(load.getRelation().getName(), directive++),
+                        symbolMask.size(), read);
+            }
+        });
+    }
+
+    traceStrata = !concurrent && TraceLog::instance().isEnabled();
+    if (concurrent || !reusedStrata.empty()) {
+        executeStrata(jobs, concurrent);
+    } else if (!profile) {
         execute(mainProgram, ctxt);
+        traceStratum();
     } else {
-        ProfileEventSingleton::instance().setOutputFile(Global::config().get("profile"));
+        ProfileEventSingleton::instance().setOutputFile(
+                Global::config().get("profile"), Global::config().has("profile-binary"));
+        if (Global::config().has("profile-stream")) {
+            ProfileEventSingleton::instance().listen(Global::config().get("profile-stream"));
+        }
+        if (Global::config().has("metrics")) {
+            ProfileEventSingleton::instance().serveMetrics(Global::config().get("metrics"));
+        }
+        ProfileEventSingleton::instance().setHardwareCounters(Global::config().has("profile-counters"));
+        indexStatistics = Global::config().has("profile-indexes");
+        if (indexStatistics) {
+            for (const auto& rel : relationEncoder.getRelationMap()) {
+                if (rel != nullptr) {
+                    rel->enableStatistics();
+                }
+            }
+        }
         // Prepare the frequency table for threaded use
         visitDepthFirst(main, [&](const RamTupleOperation& node) {
             if (!node.getProfileText().empty()) {
@@ -100,7 +358,20 @@ void LVM::executeMain() {
         visitDepthFirst(main, [&](const RamQuery& rule) { ++ruleCount; });
         ProfileEventSingleton::instance().makeConfigRecord("ruleCount", std::to_string(ruleCount));
 
+        // Store count of strata
+        size_t strataCount = 0;
+        visitDepthFirst(main, [&](const RamStratum& stratum) { ++strataCount; });
+        ProfileEventSingleton::instance().makeConfigRecord("strataCount", std::to_string(strataCount));
+
+        if (Global::config().has("profile-sampling")) {
+            SampleProfiler::instance().start(mainProgram->getSampleRules());
+        }
         execute(mainProgram, ctxt);
+        traceStratum();
+        SampleProfiler::instance().stop();
+        recordMemory();
+        ProfileEventSingleton::instance().makeNumaRecords();
+        ProfileEventSingleton::instance().makeLockRecords();
         ProfileEventSingleton::instance().stopTimer();
         for (auto const& cur : frequencies) {
             for (auto const& iter : cur.second) {
@@ -111,62 +382,228 @@ void LVM::executeMain() {
             ProfileEventSingleton::instance().makeQuantityEvent(
                     "@relation-reads;" + cur.first, cur.second, 0);
         }
+        if (indexStatistics) {
+            for (const auto& rel : relationEncoder.getRelationMap()) {
+                if (rel != nullptr) {
+                    collectIndexStatistics(*rel);
+                }
+            }
+            for (const auto& rel : indexAccesses) {
+                for (const auto& index : rel.second) {
+                    const auto& counts = index.second;
+                    ProfileEventSingleton::instance().makeIndexEvents(
+                            rel.first, index.first, counts[0], counts[1], counts[2], counts[3]);
+                }
+            }
+        }
+    }
+    if (statistics != nullptr) {
+        // relations never dropped are complete once the program ends
+        for (const auto& rel : relationEncoder.getRelationMap()) {
+            if (rel != nullptr) {
+                collectStatistics(*rel);
+            }
+        }
+        statistics->save();
     }
+    writeQueue.wait();
     SignalHandler::instance()->reset();
 }
 
+void LVM::executeStrata(size_t jobs, bool concurrent) {
+    // the code of each stratum, generated in the order of the strata
+    std::vector<std::unique_ptr<LVMCode>> strata;
+    visitDepthFirst(*translationUnit.getProgram()->getMain(), [&](const RamStratum& stratum) {
+        if (strata.size() <= (size_t)stratum.getIndex()) {
+            strata.resize(stratum.getIndex() + 1);
+        }
+        if (reusedStrata.count(stratum.getIndex()) == 0) {
+            strata[stratum.getIndex()] = generate(stratum);
+        }
+    });
+    auto evaluate = [&](int stratum) {
+        if (strata[stratum] == nullptr) {
+            return;
+        }
+        TraceLog::Span span("stratum " + std::to_string(stratum), "stratum");
+        LVMContext ctxt;
+        execute(strata[stratum], ctxt);
+    };
+    if (concurrent) {
+        const auto* dependencies = translationUnit.getAnalysis<RamStratumDependencyAnalysis>();
+        shm::runStrata(dependencies->getPredecessors(), jobs, evaluate);
+    } else {
+        for (size_t stratum = 0; stratum < strata.size(); ++stratum) {
+            evaluate(stratum);
+        }
+    }
+}
+
+void LVM::restoreReusedStrata() {
+    visitDepthFirst(*translationUnit.getProgram()->getMain(), [&](const RamStratum& stratum) {
+        if (reusedStrata.count(stratum.getIndex()) == 0) {
+            return;
+        }
+        visitDepthFirst(stratum, [&](const RamCreate& create) {
+            const RamRelation& rel = create.getRelation();
+            const LVMRelation* source = nullptr;
+            for (const auto& cur : reusedFrom->relationEncoder.getRelationMap()) {
+                if (cur != nullptr && cur->getName() == rel.getName()) {
+                    source = cur.get();
+                }
+            }
+            if (source == nullptr) {
+                return;
+            }
+            LVMRelation& target = *getRelation(relationEncoder.encodeRelation(rel));
+            target.setLevel(source->getLevel());
+
+            // the symbols are renumbered by the symbol table of the new program
+            SymbolTable& from = reusedFrom->getSymbolTable(rel.getName());
+            SymbolTable& to = getSymbolTable(rel.getName());
+            const size_t arity = rel.getArity();
+            std::vector<RamDomain> tuple(arity);
+            for (const RamDomain* cur : *source) {
+                for (size_t i = 0; i < arity; ++i) {
+                    tuple[i] = (rel.getArgTypeQualifier(i)[0] == 's') ? to.lookup(from.resolve(cur[i]))
+                                                                      : cur[i];
+                }
+                target.insert(tuple.data());
+            }
+        });
+    });
+}
+
+void LVM::recordMemory(const LVMRelation& rel) {
+    // levels count the strata from one on
+    size_t stratum = (level == 0) ? 0 : level - 1;
+    ProfileEventSingleton::instance().makeRelationMemoryEvents(stratum, rel.getName(), rel.getMemoryUsage());
+}
+
+void LVM::recordMemory() {
+    for (const auto& rel : relationEncoder.getRelationMap()) {
+        if (rel != nullptr) {
+            recordMemory(*rel);
+        }
+    }
+    size_t stratum = (level == 0) ? 0 : level - 1;
+    ProfileEventSingleton::instance().makeMemoryEvent(stratum, "symbols", getSymbolTable().getMemoryUsage());
+    ProfileEventSingleton::instance().makeMemoryEvent(stratum, "records", getRecordMemoryUsage());
+}
+
+void LVM::collectStatistics(LVMRelation& rel) {
+    // temporary relations are not planned by their sizes
+    if (rel.getArity() == 0 || rel.getName()[0] == '@') {
+        return;
+    }
+    std::vector<bool> symbolMask;
+    for (auto& cur : rel.getAttributeTypeQualifiers()) {
+        symbolMask.push_back(cur[0] == 's');
+    }
+    const RamRelation* ramRel = translationUnit.getProgram()->getRelation(rel.getName());
+    std::vector<std::vector<int>> orders;
+    if (ramRel != nullptr) {
+        orders = isa->getIndexes(*ramRel).getAllOrders();
+    }
+    auto chunks = rel.partitionScan(PARTITION_COUNT);
+    statistics->collect(
+            rel.getName(), rel.size(), chunks, orders, symbolMask, getSymbolTable(rel.getName()));
+}
+
+void LVM::collectIndexStatistics(const LVMRelation& rel) {
+    // the accesses of delta and new relations are attributed to their base relation
+    std::string name = rel.getName();
+    for (const std::string prefix : {"@delta_", "@new_"}) {
+        if (name.compare(0, prefix.size(), prefix) == 0) {
+            name = name.substr(prefix.size());
+        }
+    }
+    for (size_t i = 0; i < rel.getIndexCount(); ++i) {
+        const IndexStatistics* stats = rel.getStatistics(i);
+        if (stats == nullptr) {
+            continue;
+        }
+        auto& counts = indexAccesses[name][rel.getIndexDescription(i)];
+        counts[0] += stats->probes;
+        counts[1] += stats->emptyProbes;
+        counts[2] += stats->scans;
+        counts[3] += stats->tuples;
+    }
+}
+
 void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t ip) {
-    std::stack<RamDomain> stack;
+    EvalStack stack(codeStream->getMaxStackDepth());
     const LVMCode& code = *codeStream;
     auto& symbolTable = codeStream->getSymbolTable();
+
+    // read the operand pair of a superinstruction: (tupleId, element) or (-1, constant)
+    auto directValue = [&](size_t pos) -> RamDomain {
+        return code[pos] < 0 ? code[pos + 1] : ctxt[code[pos]][code[pos + 1]];
+    };
+
+#ifdef LVM_THREADED_DISPATCH
+#define LVM_LABEL_ADDRESS(type) &&L_##type,
+    static const void* const dispatchTable[] = {FOR_EACH_LVM_TYPE(LVM_LABEL_ADDRESS)};
+#undef LVM_LABEL_ADDRESS
+    const bool threaded = threadedDispatch;
+#define LVM_CASE(type) \
+    case type:         \
+    L_##type:
+#define LVM_DISPATCH                             \
+    if (threaded) goto* dispatchTable[code[ip]]; \
+    break
+#else
+#define LVM_CASE(type) case type:
+#define LVM_DISPATCH break
+#endif
+
     while (true) {
         switch (code[ip]) {
-            case LVM_Number:
-                stack.push(code[ip + 1]);
-                ip += 2;
-                break;
-            case LVM_TupleElement:
+            LVM_CASE(LVM_Number)
+                stack.push(code.getDomain(ip + 1));
+                ip += 1 + LVMCode::DOMAIN_WORDS;
+                LVM_DISPATCH;
+            LVM_CASE(LVM_TupleElement)
                 stack.push(ctxt[code[ip + 1]][code[ip + 2]]);
                 ip += 3;
-                break;
-            case LVM_AutoIncrement:
-                stack.push(this->counter);
-                incCounter();
+                LVM_DISPATCH;
+            LVM_CASE(LVM_AutoIncrement)
+                stack.push(incCounter());
                 ip += 1;
-                break;
-            case LVM_OP_ORD:
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_ORD)
                 // Does nothing
                 ip += 1;
-                break;
-            case LVM_OP_STRLEN: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_STRLEN) {
                 RamDomain relNameId = stack.top();
                 stack.pop();
                 stack.push(symbolTable.resolve(relNameId).size());
                 ip += 1;
-                break;
             }
-            case LVM_OP_NEG: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_NEG) {
                 RamDomain val = stack.top();
                 stack.pop();
                 stack.push(-val);
                 ip += 1;
-                break;
             }
-            case LVM_OP_BNOT: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_BNOT) {
                 RamDomain val = stack.top();
                 stack.pop();
                 stack.push(~val);
                 ip += 1;
-                break;
             }
-            case LVM_OP_LNOT: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_LNOT) {
                 RamDomain val = stack.top();
                 stack.pop();
                 stack.push(!val);
                 ip += 1;
-                break;
             }
-            case LVM_OP_TONUMBER: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_TONUMBER) {
                 RamDomain val = stack.top();
                 stack.pop();
                 RamDomain result = 0;
@@ -180,26 +617,26 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 }
                 stack.push(result);
                 ip += 1;
-                break;
             }
-            case LVM_OP_TOSTRING: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_TOSTRING) {
                 RamDomain val = stack.top();
                 RamDomain result = symbolTable.lookup(std::to_string(val));
                 stack.pop();
                 stack.push(result);
                 ip += 1;
-                break;
             }
-            case LVM_OP_ADD: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_ADD) {
                 RamDomain x = stack.top();
                 stack.pop();
                 RamDomain y = stack.top();
                 stack.pop();
                 stack.push(x + y);
                 ip += 1;
-                break;
             }
-            case LVM_OP_SUB: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_SUB) {
                 // Rhs was pushed last in the generator, so it should be on top.
                 RamDomain rhs = stack.top();
                 stack.pop();
@@ -207,90 +644,90 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 stack.pop();
                 stack.push(lhs - rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_MUL: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_MUL) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs * rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_DIV: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_DIV) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs / rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_EXP: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_EXP) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(std::pow(lhs, rhs));
                 ip += 1;
-                break;
             }
-            case LVM_OP_MOD: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_MOD) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs % rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_BAND: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_BAND) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs & rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_BOR: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_BOR) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs | rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_BXOR: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_BXOR) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs ^ rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_LAND: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_LAND) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs && rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_LOR: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_LOR) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs || rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_MAX: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_MAX) {
                 size_t size = code[ip + 1];
                 RamDomain val = MIN_RAM_DOMAIN;
                 for (size_t i = 0; i < size; ++i) {
@@ -299,9 +736,9 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 }
                 stack.push(val);
                 ip += 2;
-                break;
             }
-            case LVM_OP_MIN: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_MIN) {
                 size_t size = code[ip + 1];
                 RamDomain val = MAX_RAM_DOMAIN;
                 for (size_t i = 0; i < size; ++i) {
@@ -310,134 +747,108 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 }
                 stack.push(val);
                 ip += 2;
-                break;
             }
-            case LVM_OP_CAT: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_CAT) {
                 size_t size = code[ip + 1];
-                std::stringstream buf;
+                RamDomain args[size];
                 for (size_t i = 0; i < size; ++i) {
-                    buf << symbolTable.resolve(stack.top());
+                    args[i] = stack.top();
                     stack.pop();
                 }
-                stack.push(symbolTable.lookup(buf.str()));
+                stack.push(symbolTable.concat(args, size));
                 ip += 2;
-                break;
             }
-            case LVM_OP_SUBSTR: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_SUBSTR) {
                 RamDomain len = stack.top();
                 stack.pop();
                 RamDomain idx = stack.top();
                 stack.pop();
                 RamDomain symbol = stack.top();
                 stack.pop();
-                const std::string& str = symbolTable.resolve(symbol);
-                std::string sub_str;
-                try {
-                    sub_str = str.substr(idx, len);
-                } catch (...) {
-                    std::cerr << "warning: wrong index position provided by substr(\"";
-                    std::cerr << str << "\"," << (int32_t)idx << "," << (int32_t)len << ") functor.\n";
-                }
-                stack.push(symbolTable.lookup(sub_str));
+                stack.push(symbolTable.substr(symbol, idx, len));
 
                 ip += 1;
-                break;
             }
-            case LVM_OP_EQ: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_EQ) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs == rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_NE: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_NE) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs != rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_LT: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_LT) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs < rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_LE: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_LE) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs <= rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_GT: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_GT) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs > rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_GE: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_GE) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs >= rhs);
                 ip += 1;
-                break;
             }
-            case LVM_OP_MATCH: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_MATCH) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
 
-                const std::string& pattern = symbolTable.resolve(lhs);
-                const std::string& text = symbolTable.resolve(rhs);
-                bool result = false;
-
-                try {
-                    result = std::regex_match(text, std::regex(pattern));
-                } catch (...) {
-                    std::cerr << "warning: wrong pattern provided for match(\"" << pattern << "\",\"" << text
-                              << "\").\n";
-                }
-                stack.push(result);
+                // the pattern is compiled on its first use only
+                stack.push(regexCache.match(lhs, symbolTable.resolve(rhs), symbolTable, false));
                 ip += 1;
-                break;
             }
-            case LVM_OP_NOT_MATCH: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_NOT_MATCH) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
 
-                const std::string& pattern = symbolTable.resolve(lhs);
-                const std::string& text = symbolTable.resolve(rhs);
-                bool result = false;
-
-                try {
-                    result = !std::regex_match(text, std::regex(pattern));
-                } catch (...) {
-                    std::cerr << "warning: wrong pattern provided for match(\"" << pattern << "\",\"" << text
-                              << "\").\n";
-                }
-                stack.push(result);
+                // the pattern is compiled on its first use only
+                stack.push(regexCache.match(lhs, symbolTable.resolve(rhs), symbolTable, true));
                 ip += 1;
-                break;
             }
-            case LVM_OP_CONTAINS: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_CONTAINS) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
@@ -446,9 +857,9 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 const std::string& text = symbolTable.resolve(rhs);
                 stack.push(text.find(pattern) != std::string::npos);
                 ip += 1;
-                break;
             }
-            case LVM_OP_NOT_CONTAINS: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_OP_NOT_CONTAINS) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
@@ -457,21 +868,21 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 const std::string& text = symbolTable.resolve(rhs);
                 stack.push(text.find(pattern) == std::string::npos);
                 ip += 1;
-                break;
             }
-            case LVM_UserDefinedOperator: {
-                // get name and type
-                const std::string name = symbolTable.resolve(code[ip + 1]);
-                const std::string type = symbolTable.resolve(code[ip + 2]);
-                size_t arity = code[ip + 3];
-                auto fn = reinterpret_cast<void (*)()>(getMethodHandle(name));
-                if (fn == nullptr) {
-                    std::cerr << "Cannot find user-defined operator " << name << std::endl;
+                LVM_DISPATCH;
+            LVM_CASE(LVM_UserDefinedOperator) {
+                LVMFunctorCall& call = *codeStream->getFunctorCalls()[code[ip + 1]];
+                if (call.function == nullptr) {
+                    std::cerr << "Cannot find user-defined operator " << call.name << std::endl;
+                    exit(1);
+                }
+                if (!call.prepared) {
+                    std::cerr << "Failed to prepare CIF for user-defined operator ";
+                    std::cerr << call.name << std::endl;
                     exit(1);
                 }
 
-                ffi_cif cif;
-                ffi_type* args[arity];
+                size_t arity = call.arity;
                 void* values[arity];
                 RamDomain intVal[arity];
                 const char* strVal[arity];
@@ -481,45 +892,28 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 for (size_t i = 0; i < arity; i++) {
                     RamDomain arg = stack.top();
                     stack.pop();
-                    if (type[i] == 'S') {
-                        args[i] = &ffi_type_pointer;
+                    if (call.type[i] == 'S') {
                         strVal[i] = symbolTable.resolve(arg).c_str();
                         values[i] = &strVal[i];
                     } else {
-                        args[i] = &ffi_type_uint32;
                         intVal[i] = arg;
                         values[i] = &intVal[i];
                     }
                 }
 
                 // call external function
-                if (type[arity] == 'N') {
-                    // Initialize for numerical return value
-                    if (ffi_prep_cif(&cif, FFI_DEFAULT_ABI, arity, &ffi_type_uint32, args) != FFI_OK) {
-                        std::cerr << "Failed to prepare CIF for user-defined operator ";
-                        std::cerr << name << std::endl;
-                        exit(1);
-                    }
-                } else {
-                    // Initialize for string return value
-                    if (ffi_prep_cif(&cif, FFI_DEFAULT_ABI, arity, &ffi_type_pointer, args) != FFI_OK) {
-                        std::cerr << "Failed to prepare CIF for user-defined operator ";
-                        std::cerr << name << std::endl;
-                        exit(1);
-                    }
-                }
-                ffi_call(&cif, fn, &rc, values);
+                ffi_call(&call.cif, call.function, &rc, values);
                 RamDomain result;
-                if (type[arity] == 'N') {
+                if (!call.returnsSymbol()) {
                     result = ((RamDomain)rc);
                 } else {
                     result = symbolTable.lookup(((const char*)rc));
                 }
                 stack.push(result);
-                ip += 4;
-                break;
+                ip += 2;
             }
-            case LVM_PackRecord: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_PackRecord) {
                 RamDomain arity = code[ip + 1];
                 RamDomain data[arity];
                 for (auto i = 0; i < arity; ++i) {
@@ -528,46 +922,64 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 }
                 stack.push(pack(data, arity));
                 ip += 2;
-                break;
             }
-            case LVM_Argument: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_PackLocalRecord) {
+                RamDomain arity = code[ip + 1];
+                RamDomain data[arity];
+                for (auto i = 0; i < arity; ++i) {
+                    data[arity - i - 1] = stack.top();
+                    stack.pop();
+                }
+                stack.push(ctxt.getLocalRecords().pack(
+                        data, arity, [&](const RamDomain* tuple) { return lookup(tuple, arity); }));
+                ip += 2;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Argument) {
                 stack.push(ctxt.getArgument(code[ip + 1]));
                 ip += 2;
-                break;
             }
-            case LVM_True: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_True) {
                 stack.push(1);
                 ip += 1;
-                break;
-            };
-            case LVM_False: {
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_False) {
                 stack.push(0);
                 ip += 1;
-                break;
-            };
-            case LVM_Conjunction: {
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Conjunction) {
                 RamDomain rhs = stack.top();
                 stack.pop();
                 RamDomain lhs = stack.top();
                 stack.pop();
                 stack.push(lhs && rhs);
                 ip += 1;
-                break;
             }
-            case LVM_Negation: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Negation) {
                 RamDomain val = stack.top();
                 stack.pop();
                 stack.push(!val);
                 ip += 1;
-                break;
             }
-            case LVM_EmptinessCheck: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_EmptinessCheck) {
                 size_t relId = code[ip + 1];
                 stack.push(getRelation(relId)->empty());
                 ip += 2;
-                break;
             }
-            case LVM_ContainCheck: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_SizeCheck) {
+                size_t relId = code[ip + 1];
+                stack.push(getRelation(relId)->size() >= static_cast<size_t>(code[ip + 2]));
+                ip += 3;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ContainCheck) {
                 auto relPtr = getRelation(code[ip + 1]);
                 auto arity = relPtr->getArity();
                 RamDomain tuple[arity];
@@ -577,20 +989,20 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 }
                 stack.push(relPtr->contains(TupleRef(tuple, arity)));
                 ip += 2;
-                break;
             }
-            case LVM_ExistenceCheck: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ExistenceCheck) {
                 auto relPtr = getRelation(code[ip + 1]);
                 auto arity = relPtr->getArity();
                 auto indexPos = code[ip + 2];
 
                 RamDomain low[arity];
                 RamDomain high[arity];
-                size_t numOfTypeMasks = arity / RAM_DOMAIN_SIZE + (arity % RAM_DOMAIN_SIZE != 0);
+                size_t numOfTypeMasks = arity / LVMCode::MASK_BITS + (arity % LVMCode::MASK_BITS != 0);
                 for (size_t i = 0; i < numOfTypeMasks; ++i) {
-                    RamDomain typeMask = code[ip + 3 + i];
-                    for (auto j = 0; j < RAM_DOMAIN_SIZE; ++j) {
-                        auto projectedIndex = i * RAM_DOMAIN_SIZE + j;
+                    LVMWord typeMask = code[ip + 3 + i];
+                    for (size_t j = 0; j < LVMCode::MASK_BITS; ++j) {
+                        auto projectedIndex = i * LVMCode::MASK_BITS + j;
                         if (projectedIndex >= arity) {
                             break;
                         }
@@ -604,13 +1016,12 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                         }
                     }
                 }
-                auto range = relPtr->range(indexPos, TupleRef(low, arity), TupleRef(high, arity));
-                stack.push(range.begin() != range.end());
+                stack.push(relPtr->exists(indexPos, TupleRef(low, arity), TupleRef(high, arity)));
 
                 ip += (3 + numOfTypeMasks);
-                break;
             }
-            case LVM_ExistenceCheckOneArg: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ExistenceCheckOneArg) {
                 auto relPtr = getRelation(code[ip + 1]);
                 auto arity = relPtr->getArity();
                 auto indexPos = code[ip + 2];
@@ -629,41 +1040,141 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                         high[i] = MAX_RAM_DOMAIN;
                     }
                 }
-                auto range = relPtr->range(indexPos, TupleRef(low, arity), TupleRef(high, arity));
-                stack.push(range.begin() != range.end());
+                stack.push(relPtr->exists(indexPos, TupleRef(low, arity), TupleRef(high, arity)));
 
                 ip += 4;
-                break;
             }
-            case LVM_Constraint:
+                LVM_DISPATCH;
+            LVM_CASE(LVM_MemoExistenceCheck) {
+                auto relPtr = getRelation(code[ip + 2]);
+                auto arity = relPtr->getArity();
+                auto indexPos = code[ip + 3];
+                size_t numOfTypeMasks = code[ip + 4];
+
+                RamDomain low[arity];
+                RamDomain high[arity];
+                for (size_t i = 0; i < numOfTypeMasks; ++i) {
+                    LVMWord typeMask = code[ip + 5 + i];
+                    for (size_t j = 0; j < LVMCode::MASK_BITS; ++j) {
+                        auto projectedIndex = i * LVMCode::MASK_BITS + j;
+                        if (projectedIndex >= arity) {
+                            break;
+                        }
+                        if (1 << j & typeMask) {
+                            low[projectedIndex] = stack.top();
+                            stack.pop();
+                            high[projectedIndex] = low[projectedIndex];
+                        } else {
+                            low[projectedIndex] = MIN_RAM_DOMAIN;
+                            high[projectedIndex] = MAX_RAM_DOMAIN;
+                        }
+                    }
+                }
+
+                // consecutive checks of the same key take the result of the last one
+                auto& memo = ctxt.getMemo(code[ip + 1]);
+                if (!memo.valid || !std::equal(low, low + arity, memo.key.begin())) {
+                    memo.key.assign(low, low + arity);
+                    memo.result = relPtr->exists(indexPos, TupleRef(low, arity), TupleRef(high, arity));
+                    memo.valid = true;
+                }
+                stack.push(memo.result);
+
+                ip += (5 + numOfTypeMasks);
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Constraint)
+                /** Does nothing, just a label */
+                ip += 1;
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Scan)
                 /** Does nothing, just a label */
                 ip += 1;
-                break;
-            case LVM_Scan:
+                LVM_DISPATCH;
+            LVM_CASE(LVM_IndexScan)
                 /** Does nothing, just a label */
                 ip += 1;
-                break;
-            case LVM_IndexScan:
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Choice)
                 /** Does nothing, just a label */
                 ip += 1;
-                break;
-            case LVM_Choice:
+                LVM_DISPATCH;
+            LVM_CASE(LVM_IndexChoice)
                 /** Does nothing, just a label */
                 ip += 1;
-                break;
-            case LVM_IndexChoice:
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Intersect)
                 /** Does nothing, just a label */
                 ip += 1;
-                break;
-            case LVM_Search: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ParallelScan)
+            LVM_CASE(LVM_ParallelChoice) {
+                size_t counterLabel = code[ip + 1];
+                const auto& relPtr = getRelation(code[ip + 2]);
+                size_t endAddress = code[ip + 3];
+                auto partitions = relPtr->partitionScan(PARTITION_COUNT);
+                executeParallel(
+                        codeStream, ctxt, ip + 4, counterLabel, partitions, code[ip] == LVM_ParallelChoice);
+                ip = endAddress;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ParallelIndexScan)
+            LVM_CASE(LVM_ParallelIndexChoice) {
+                size_t counterLabel = code[ip + 1];
+                auto relPtr = getRelation(code[ip + 2]);
+                auto arity = relPtr->getArity();
+                RamDomain indexPos = code[ip + 3];
+                size_t endAddress = code[ip + 4];
+
+                // create pattern tuple for range query
+                size_t numOfTypeMasks = arity / LVMCode::MASK_BITS + (arity % LVMCode::MASK_BITS != 0);
+                RamDomain low[arity];
+                RamDomain high[arity];
+                for (size_t i = 0; i < numOfTypeMasks; ++i) {
+                    LVMWord typeMask = code[ip + 5 + i];
+                    for (size_t j = 0; j < LVMCode::MASK_BITS; ++j) {
+                        auto projectedIndex = i * LVMCode::MASK_BITS + j;
+                        if (projectedIndex >= arity) {
+                            break;
+                        }
+                        if (1 << j & typeMask) {
+                            low[projectedIndex] = stack.top();
+                            stack.pop();
+                            high[projectedIndex] = low[projectedIndex];
+                        } else {
+                            low[projectedIndex] = MIN_RAM_DOMAIN;
+                            high[projectedIndex] = MAX_RAM_DOMAIN;
+                        }
+                    }
+                }
+                // partition the iterator range
+                auto partitions = relPtr->partitionRange(
+                        indexPos, TupleRef(low, arity), TupleRef(high, arity), PARTITION_COUNT);
+                executeParallel(codeStream, ctxt, ip + 5 + numOfTypeMasks, counterLabel, partitions,
+                        code[ip] == LVM_ParallelIndexChoice);
+                ip = endAddress;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_NestedParallel) {
+                /** Refers to the nested parallel version of a partition loop, selected by executeParallel */
+                ip += 2;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Choose) {
+                // another worker of the parallel choice may have found a tuple first
+                ip = ctxt.claimChoice() ? ip + 2 : code[ip + 1];
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Search) {
                 if (profile && code[ip + 1] != 0) {
                     const std::string& msg = symbolTable.resolve(code[ip + 2]);
+#pragma omp critical(lvm_frequencies)
                     this->frequencies[msg][this->getIterationNumber()]++;
                 }
                 ip += 3;
-                break;
             }
-            case LVM_UnpackRecord: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_UnpackRecord) {
                 RamDomain arity = code[ip + 1];
                 RamDomain id = code[ip + 2];
                 RamDomain exitAddress = code[ip + 3];
@@ -678,33 +1189,51 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
 
                 ctxt[id] = TupleRef(unpack(ref, arity), arity);
                 ip += 4;
-                break;
             }
-            case LVM_Filter:
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Filter)
                 if (profile) {
                     const std::string& msg = symbolTable.resolve(code[ip + 1]);
                     if (!msg.empty()) {
+#pragma omp critical(lvm_frequencies)
                         this->frequencies[msg][this->getIterationNumber()]++;
                     }
                 }
                 ip += 2;
-                break;
-            case LVM_Project: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Project) {
+                RamDomain arity = code[ip + 1];
+                size_t relId = code[ip + 2];
+                RamDomain tuple[arity];
+                for (auto i = 0; i < arity; ++i) {
+                    tuple[i] = stack.top();
+                    stack.pop();
+                }
+                insertTuple(ctxt, relId, tuple, arity);
+                ip += 3;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_BufferedProject) {
                 RamDomain arity = code[ip + 1];
                 size_t relId = code[ip + 2];
-                LVMRelation& rel = *getRelation(relId);
                 RamDomain tuple[arity];
                 for (auto i = 0; i < arity; ++i) {
                     tuple[i] = stack.top();
                     stack.pop();
                 }
-                rel.insert(TupleRef(tuple, arity));
+                // workers of parallel operations merge their buffers when they are done
+                InsertBuffer& buffer = ctxt.getInsertBuffer(relId, arity);
+                if (buffer.insert(tuple)) {
+                    flushInsertBuffer(relId, buffer);
+                }
                 ip += 3;
-                break;
             }
-            case LVM_ReturnValue: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ReturnValue) {
                 RamDomain size = code[ip + 1];
                 const std::string& types = symbolTable.resolve(code[ip + 2]);
+                // return buffers are shared by all workers of a parallel operation
+#pragma omp critical(lvm_return_value)
                 for (auto i = 0; i < size; ++i) {
                     if (types[size - i - 1] == '_') {
                         ctxt.addReturnValue(0, true);
@@ -714,13 +1243,13 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                     }
                 }
                 ip += 3;
-                break;
             }
-            case LVM_Sequence: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Sequence) {
                 ip += 1;
-                break;
             }
-            case LVM_Parallel: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Parallel) {
                 size_t size = code[ip + 1];
                 size_t end = code[ip + 2];
                 size_t startAddresses[size];
@@ -733,28 +1262,62 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 }
 
                 ip = end;
-                break;
             }
-            case LVM_Stop_Parallel: {
-                ip += 2;
-                break;
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Stop_Parallel) {
+                // end of the code executed by a single worker
+                return;
+            }
+            LVM_CASE(LVM_PlanSwitch) {
+                // choose the join order of the least estimated cost for the current relation sizes:
+                // the sum of the number of tuples produced at every level of the join, where an
+                // access binding b out of a attributes of a relation R yields |R|^((a-b)/a) tuples
+                size_t numPlans = code[ip + 1];
+                size_t pos = ip + 2;
+                size_t target = 0;
+                double minCost = 0;
+                for (size_t i = 0; i < numPlans; ++i) {
+                    size_t address = code[pos];
+                    size_t numRels = code[pos + 1];
+                    pos += 2;
+                    double cost = 0;
+                    double tuples = 1;
+                    for (size_t j = 0; j < numRels; ++j, pos += 2) {
+                        const LVMRelation* rel = getRelation(code[pos]);
+                        size_t arity = rel->getArity();
+                        size_t bound = code[pos + 1];
+                        double size = rel->size();
+                        tuples *= (arity == 0 || size == 0) ? std::min(size, 1.0)
+                                                            : std::pow(size, (double)(arity - bound) / arity);
+                        cost += tuples;
+                    }
+                    if (i == 0 || cost < minCost) {
+                        minCost = cost;
+                        target = address;
+                    }
+                }
+                ip = target;
             }
-            case LVM_Loop: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Loop) {
                 /** Does nothing, jus a label */
                 ip += 1;
-                break;
             }
-            case LVM_IncIterationNumber: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_IncIterationNumber) {
                 incIterationNumber();
+                if (ResourceLimits::instance().check()) {
+                    evictIndexes();
+                }
                 ip += 1;
-                break;
-            };
-            case LVM_ResetIterationNumber: {
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ResetIterationNumber) {
                 resetIterationNumber();
                 ip += 1;
-                break;
-            };
-            case LVM_Exit: {
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Exit) {
                 RamDomain val = stack.top();
                 stack.pop();
                 if (val) {
@@ -762,17 +1325,17 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                     break;
                 }
                 ip += 2;
-                break;
             }
-            case LVM_LogTimer: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_LogTimer) {
                 const std::string& msg = symbolTable.resolve(code[ip + 1]);
                 size_t timerIndex = code[ip + 2];
                 Logger* logger = new Logger(msg.c_str(), this->getIterationNumber());
                 insertTimerAt(timerIndex, logger);
                 ip += 3;
-                break;
             }
-            case LVM_LogRelationTimer: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_LogRelationTimer) {
                 const std::string& msg = symbolTable.resolve(code[ip + 1]);
                 size_t timerIndex = code[ip + 2];
                 size_t relId = code[ip + 3];
@@ -781,24 +1344,39 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                         msg.c_str(), this->getIterationNumber(), std::bind(&LVMRelation::size, &rel));
                 insertTimerAt(timerIndex, logger);
                 ip += 4;
-                break;
             }
-            case LVM_StopLogTimer: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_StopLogTimer) {
                 size_t timerIndex = code[ip + 1];
                 stopTimerAt(timerIndex);
                 ip += 2;
-                break;
             }
-            case LVM_DebugInfo: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_DebugInfo) {
                 const std::string& msg = symbolTable.resolve(code[ip + 1]);
                 SignalHandler::instance()->setMsg(msg.c_str());
                 ip += 2;
-                break;
             }
-            case LVM_Stratum: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_SamplePosition) {
+                SampleProfiler::setPosition(code[ip + 1]);
+                ip += 2;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Stratum) {
+                // the previous stratum ends here
+                if (profile && this->level != 0) {
+                    recordMemory();
+                }
+                // its relations are complete, and only read from now on
+                if (freezeRelations && this->level != 0) {
+                    freezeStratum(this->level);
+                    compressColdRelations();
+                }
+                traceStratum();
                 this->level++;
                 // Record all the rleation that is created in the previous level
-                if (profile || this->level != 0) {
+                if (profile) {
                     for (const auto& rel : relationEncoder.getRelationMap()) {
                         if (rel == nullptr) {
                             continue;
@@ -812,80 +1390,155 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                     }
                 }
                 ip += 1;
-                break;
             }
-            case LVM_Create: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Create) {
                 size_t relId = code[ip + 1];
                 auto res = getRelation(relId);
                 res->setLevel(level);
                 ip += 2;
-                break;
             }
-            case LVM_Clear: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Clear) {
                 size_t relId = code[ip + 1];
                 auto relPtr = getRelation(relId);
                 relPtr->purge();
                 ip += 2;
-                break;
             }
-            case LVM_Drop: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Reset) {
+                size_t relId = code[ip + 1];
+                auto relPtr = getRelation(relId);
+                relPtr->reset();
+                ip += 2;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Drop) {
                 size_t relId = code[ip + 1];
                 dropRelation(relId);
                 ip += 2;
-                break;
             }
-            case LVM_LogSize: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_BuildIndex) {
+                size_t relId = code[ip + 1];
+                if (auto relPtr = getRelation(relId)) {
+                    relPtr->buildIndex(code[ip + 2]);
+                }
+                ip += 3;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_DropIndex) {
+                size_t relId = code[ip + 1];
+                if (auto relPtr = getRelation(relId)) {
+                    relPtr->removeIndex(code[ip + 2]);
+                }
+                ip += 3;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_BuildFilter) {
+                size_t relId = code[ip + 1];
+                if (auto relPtr = getRelation(relId)) {
+                    relPtr->buildFilter(code[ip + 2]);
+                }
+                ip += 3;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ClearFilter) {
+                size_t relId = code[ip + 1];
+                if (auto relPtr = getRelation(relId)) {
+                    relPtr->clearFilter(code[ip + 2]);
+                }
+                ip += 3;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_LogSize) {
                 size_t relId = code[ip + 1];
                 auto relPtr = getRelation(relId);
                 const std::string& msg = symbolTable.resolve(code[ip + 2]);
                 ProfileEventSingleton::instance().makeQuantityEvent(
                         msg, relPtr->size(), this->getIterationNumber());
                 ip += 3;
-                break;
             }
-            case LVM_Load: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_LogDistinctValues) {
+                size_t relId = code[ip + 1];
+                auto relPtr = getRelation(relId);
+                size_t numColumns = code[ip + 2];
+                std::vector<std::string> msgs;
+                for (size_t i = 0; i < numColumns; ++i) {
+                    msgs.push_back(symbolTable.resolve(code[ip + 3 + i]));
+                }
+                ProfileEventSingleton::instance().makeDistinctValuesEvents(
+                        msgs, *relPtr, this->getIterationNumber());
+                ip += 3 + numColumns;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Load) {
                 size_t relId = code[ip + 1];
                 auto IOs = codeStream->getIODirectives()[code[ip + 2]];
 
+                size_t directive = 0;
                 for (auto& io : IOs) {
+                    TraceLog::Span span("load " + getRelation(relId)->getName(), "io");
                     try {
                         auto relPtr = getRelation(relId);
+                        const std::string key = InputPrefetcher::key(relPtr->getName(), directive++);
+                        if (inputPrefetcher.load(key, *relPtr)) {
+                            continue;
+                        }
                         std::vector<bool> symbolMask;
                         for (auto& cur : relPtr->getAttributeTypeQualifiers()) {
                             symbolMask.push_back(cur[0] == 's');
                         }
                         IOSystem::getInstance()
-                                .getReader(symbolMask, symbolTable, io, provenance)
+                                .getReader(symbolMask, getSymbolTable(relPtr->getName()), io,
+                                        hasProvenanceColumns(relPtr->getName()))
                                 ->readAll(*relPtr);
                     } catch (std::exception& e) {
                         std::cerr << "Error loading data: " << e.what() << "\n";
                     }
+                    span.set("tuples", getRelation(relId)->size());
+                }
+                if (statistics != nullptr) {
+                    collectStatistics(*getRelation(relId));
                 }
                 ip += 3;
-                break;
             }
-            case LVM_Store: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Store) {
                 size_t relId = code[ip + 1];
                 auto IOs = codeStream->getIODirectives()[code[ip + 2]];
 
                 for (auto& io : IOs) {
-                    try {
-                        auto relPtr = getRelation(relId);
-                        std::vector<bool> symbolMask;
-                        for (auto& cur : relPtr->getAttributeTypeQualifiers()) {
-                            symbolMask.push_back(cur[0] == 's');
+                    auto relPtr = getRelation(relId);
+                    std::vector<bool> symbolMask;
+                    for (auto& cur : relPtr->getAttributeTypeQualifiers()) {
+                        symbolMask.push_back(cur[0] == 's');
+                    }
+                    SymbolTable* relationSymbols = &getSymbolTable(relPtr->getName());
+                    const bool provenance = hasProvenanceColumns(relPtr->getName());
+                    auto write = [relPtr, symbolMask, io, relationSymbols, provenance]() {
+                        TraceLog::Span span("store " + relPtr->getName(), "io");
+                        span.set("tuples", relPtr->size());
+                        try {
+                            IOSystem::getInstance()
+                                    .getWriter(symbolMask, *relationSymbols, io, provenance)
+                                    ->writeAll(*relPtr);
+                        } catch (std::exception& e) {
+                            std::cerr << "Error Storing data: " << e.what() << "\n";
                         }
-                        IOSystem::getInstance()
-                                .getWriter(symbolMask, symbolTable, io, provenance)
-                                ->writeAll(*relPtr);
-                    } catch (std::exception& e) {
-                        std::cerr << "Error Storing data: " << e.what() << "\n";
+                    };
+                    // completed strata are not modified, hence written while evaluation goes on
+                    if (Global::config().has("async-output")) {
+                        writeQueue.submit(relPtr, write);
+                    } else {
+                        write();
                     }
                 }
                 ip += 3;
-                break;
             }
-            case LVM_Fact: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Fact) {
                 size_t relId = code[ip + 1];
                 auto arity = code[ip + 2];
                 RamDomain tuple[arity];
@@ -895,9 +1548,9 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 }
                 getRelation(relId)->insert(TupleRef(tuple, arity));
                 ip += 3;
-                break;
             }
-            case LVM_Merge: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Merge) {
                 size_t sourceId = code[ip + 1];
                 size_t targetId = code[ip + 2];
                 // get involved relation
@@ -912,54 +1565,94 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 trgPtr->insert(*srcPtr);
 
                 ip += 3;
-                break;
             }
-            case LVM_Swap: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Swap) {
                 size_t firstRelId = code[ip + 1];
                 size_t secondRelId = code[ip + 2];
                 swapRelation(firstRelId, secondRelId);
                 ip += 3;
-                break;
             }
-            case LVM_Query:
-                /** Does nothing, just a label */
-                ip += 1;
-                break;
-            case LVM_Goto:
+                LVM_DISPATCH;
+            LVM_CASE(LVM_TransitiveClosure) {
+                size_t sourceId = code[ip + 1];
+                size_t targetId = code[ip + 2];
+                auto srcPtr = getRelation(sourceId);
+                auto trgPtr = getRelation(targetId);
+
+                TransitiveClosure graph;
+                for (const RamDomain* cur : *srcPtr) {
+                    graph.addEdge(cur[0], cur[1]);
+                }
+                graph.compute([&](RamDomain from, const std::vector<RamDomain>& reached) {
+                    RamDomain tuple[2] = {from, 0};
+                    for (RamDomain to : reached) {
+                        tuple[1] = to;
+                        trgPtr->insert(TupleRef(tuple, 2));
+                    }
+                });
+                ip += 3;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Query) {
+                // memoised existence checks of an earlier evaluation may be outdated
+                ctxt.clearMemos();
+                // take the native code of the query if it has been compiled
+                if (jit != nullptr && jit->enter(*codeStream->getQueries()[code[ip + 1]])) {
+                    ip = code[ip + 2];
+                    LVM_DISPATCH;
+                }
+                ip += 3;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_QueryEnd) {
+                flushInsertBuffers(ctxt);
+                ctxt.getLocalRecords().clear();
+                if (jit != nullptr) {
+                    jit->leave(*codeStream->getQueries()[code[ip + 1]]);
+                }
+                ip += 2;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Goto)
                 ip = code[ip + 1];
-                break;
-            case LVM_Jmpnz: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Jmpnz) {
                 RamDomain val = stack.top();
                 stack.pop();
                 ip = (val != 0 ? code[ip + 1] : ip + 2);
-                break;
             }
-            case LVM_Jmpez: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Jmpez) {
                 RamDomain val = stack.top();
                 stack.pop();
                 ip = (val == 0 ? code[ip + 1] : ip + 2);
-                break;
             }
-            case LVM_Aggregate: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Aggregate) {
                 ip += 1;
-                break;
-            };
-            case LVM_IndexAggregate: {
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_IndexAggregate) {
                 ip += 1;
-                break;
-            };
-            case LVM_Aggregate_COUNT: {
-                RamDomain res = 0;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Aggregate_COUNT) {
                 RamDomain idx = code[ip + 1];
-                auto& stream = streamPool[idx];
-                for (auto i = stream.begin(); i != stream.end(); ++i) {
-                    res++;
+                auto& stream = ctxt.getStream(idx);
+                // b-tree indexes count the tuples of a range without retrieving them
+                RamDomain res = stream.remaining();
+                if (res < 0) {
+                    res = 0;
+                    for (auto i = stream.begin(); i != stream.end(); ++i) {
+                        res++;
+                    }
                 }
                 stack.push(res);
                 ip += 2;
-                break;
-            };
-            case LVM_Aggregate_Return: {
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_Aggregate_Return) {
                 RamDomain id = code[ip + 1];
                 RamDomain res = stack.top();
                 stack.pop();
@@ -967,30 +1660,30 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                 tuple[0] = res;
                 ctxt[id] = TupleRef(tuple, 1);
                 ip += 2;
-                break;
-            };
-            case LVM_ITER_InitFullIndex: {
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ITER_InitFullIndex) {
                 RamDomain dest = code[ip + 1];
                 size_t relId = code[ip + 2];
                 const auto& relPtr = getRelation(relId);
-                lookUpStream(dest) = relPtr->scan();
+                ctxt.initStream(dest) = relPtr->scan();
                 ip += 3;
-                break;
-            };
-            case LVM_ITER_InitRangeIndex: {
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ITER_InitRangeIndex) {
                 RamDomain dest = code[ip + 1];
                 auto relPtr = getRelation(code[ip + 2]);
                 auto arity = relPtr->getArity();
                 RamDomain indexPos = code[ip + 3];
 
                 // create pattern tuple for range query
-                size_t numOfTypeMasks = arity / RAM_DOMAIN_SIZE + (arity % RAM_DOMAIN_SIZE != 0);
+                size_t numOfTypeMasks = arity / LVMCode::MASK_BITS + (arity % LVMCode::MASK_BITS != 0);
                 RamDomain low[arity];
                 RamDomain high[arity];
                 for (size_t i = 0; i < numOfTypeMasks; ++i) {
-                    RamDomain typeMask = code[ip + 4 + i];
-                    for (auto j = 0; j < RAM_DOMAIN_SIZE; ++j) {
-                        auto projectedIndex = i * RAM_DOMAIN_SIZE + j;
+                    LVMWord typeMask = code[ip + 4 + i];
+                    for (size_t j = 0; j < LVMCode::MASK_BITS; ++j) {
+                        auto projectedIndex = i * LVMCode::MASK_BITS + j;
                         if (projectedIndex >= arity) {
                             break;
                         }
@@ -1005,11 +1698,11 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                     }
                 }
                 // get iterator range
-                lookUpStream(dest) = relPtr->range(indexPos, TupleRef(low, arity), TupleRef(high, arity));
+                ctxt.initStream(dest) = relPtr->range(indexPos, TupleRef(low, arity), TupleRef(high, arity));
                 ip += (4 + numOfTypeMasks);
-                break;
-            };
-            case LVM_ITER_InitRangeIndexOneArg: {
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ITER_InitRangeIndexOneArg) {
                 RamDomain dest = code[ip + 1];
                 auto relPtr = getRelation(code[ip + 2]);
                 auto arity = relPtr->getArity();
@@ -1030,39 +1723,241 @@ void LVM::execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t
                     }
                 }
                 // get iterator range
-                lookUpStream(dest) = relPtr->range(indexPos, TupleRef(low, arity), TupleRef(high, arity));
+                ctxt.initStream(dest) = relPtr->range(indexPos, TupleRef(low, arity), TupleRef(high, arity));
                 ip += 5;
-                break;
-            };
-            case LVM_ITER_NotAtEnd: {
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ITER_InitBoundedRange) {
+                RamDomain dest = code[ip + 1];
+                auto relPtr = getRelation(code[ip + 2]);
+                auto arity = relPtr->getArity();
+                RamDomain indexPos = code[ip + 3];
+                size_t column = code[ip + 4];
+                LVMWord bounds = code[ip + 5];
+
+                // create pattern tuple for range query
+                size_t numOfTypeMasks = arity / LVMCode::MASK_BITS + (arity % LVMCode::MASK_BITS != 0);
+                RamDomain low[arity];
+                RamDomain high[arity];
+                for (size_t i = 0; i < numOfTypeMasks; ++i) {
+                    LVMWord typeMask = code[ip + 6 + i];
+                    for (size_t j = 0; j < LVMCode::MASK_BITS; ++j) {
+                        auto projectedIndex = i * LVMCode::MASK_BITS + j;
+                        if (projectedIndex >= arity) {
+                            break;
+                        }
+                        if (1 << j & typeMask) {
+                            low[projectedIndex] = stack.top();
+                            stack.pop();
+                            high[projectedIndex] = low[projectedIndex];
+                        } else {
+                            low[projectedIndex] = MIN_RAM_DOMAIN;
+                            high[projectedIndex] = MAX_RAM_DOMAIN;
+                        }
+                    }
+                }
+
+                // the defined bounds of the range column are below the pattern
+                if ((bounds & 1) != 0) {
+                    low[column] = stack.top();
+                    stack.pop();
+                }
+                if ((bounds & 2) != 0) {
+                    high[column] = stack.top();
+                    stack.pop();
+                }
+                ctxt.initStream(dest) = relPtr->range(indexPos, TupleRef(low, arity), TupleRef(high, arity));
+                ip += (6 + numOfTypeMasks);
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ITER_InitIntersect) {
+                RamDomain dest = code[ip + 1];
+                size_t numOfParticipants = code[ip + 2];
+                ip += 3;
+
+                // create the bound keys of the participants, the first one being on top of the stack
+                std::vector<LeapfrogJoin::Seek> seeks;
+                for (size_t p = 0; p < numOfParticipants; ++p) {
+                    auto participant = std::make_shared<IntersectParticipant>();
+                    participant->rel = getRelation(code[ip]);
+                    participant->indexPos = code[ip + 1];
+                    participant->column = code[ip + 2];
+                    size_t numOfTypeMasks = code[ip + 3];
+                    size_t arity = participant->rel->getArity();
+                    participant->key.resize(arity);
+                    participant->bound.resize(arity);
+                    participant->low.resize(arity);
+                    participant->res.resize(arity);
+                    for (size_t i = 0; i < numOfTypeMasks; ++i) {
+                        LVMWord typeMask = code[ip + 4 + i];
+                        for (size_t j = 0; j < LVMCode::MASK_BITS; ++j) {
+                            auto projectedIndex = i * LVMCode::MASK_BITS + j;
+                            if (projectedIndex >= arity) {
+                                break;
+                            }
+                            if (1 << j & typeMask) {
+                                participant->key[projectedIndex] = stack.top();
+                                participant->bound[projectedIndex] = true;
+                                stack.pop();
+                            } else {
+                                participant->key[projectedIndex] = MIN_RAM_DOMAIN;
+                            }
+                        }
+                    }
+                    seeks.push_back([participant](RamDomain& value) { return participant->seek(value); });
+                    ip += 4 + numOfTypeMasks;
+                }
+                ctxt.initStream(dest) = Stream(std::make_unique<IntersectSource>(LeapfrogJoin(seeks)));
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ITER_NotAtEnd) {
                 RamDomain idx = code[ip + 1];
-                auto& stream = lookUpStream(idx);
+                auto& stream = ctxt.getStream(idx);
                 stack.push(stream.begin() != stream.end());
                 ip += 2;
-                break;
             }
-            case LVM_ITER_Select: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ITER_Select) {
                 RamDomain idx = code[ip + 1];
                 RamDomain tupleId = code[ip + 2];
-                auto& stream = lookUpStream(idx);
+                auto& stream = ctxt.getStream(idx);
                 ctxt[tupleId] = *stream.begin();
                 ip += 3;
-                break;
             }
-            case LVM_ITER_Inc: {
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ITER_Inc) {
                 RamDomain idx = code[ip + 1];
-                ++streamPool[idx].begin();
+                ++ctxt.getStream(idx).begin();
                 ip += 2;
-                break;
             }
-            case LVM_STOP:
+                LVM_DISPATCH;
+            LVM_CASE(LVM_ITER_Next) {
+                auto& batch = ctxt.getBatch(code[ip + 1]);
+                size_t arity = code[ip + 3];
+                size_t numComparisons = code[ip + 5];
+                if (batch.pos < batch.size ||
+                        fetchBatch(ctxt.getStream(code[ip + 1]), batch, arity, &code[ip + 6], numComparisons)) {
+                    ctxt[code[ip + 2]] = TupleRef(batch.tuples[batch.pos++], arity);
+                    ip += 6 + 4 * numComparisons;
+                } else {
+                    ip = code[ip + 4];
+                }
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_FUSED_ElementEqNumber)
+                stack.push(ctxt[code[ip + 1]][code[ip + 2]] == code[ip + 3]);
+                ip += 4;
+                LVM_DISPATCH;
+            LVM_CASE(LVM_FUSED_ElementEqElement)
+                stack.push(ctxt[code[ip + 1]][code[ip + 2]] == ctxt[code[ip + 3]][code[ip + 4]]);
+                ip += 5;
+                LVM_DISPATCH;
+            LVM_CASE(LVM_FUSED_ContainCheck) {
+                auto relPtr = getRelation(code[ip + 1]);
+                RamDomain arity = code[ip + 2];
+                RamDomain tuple[arity];
+                for (auto i = 0; i < arity; ++i) {
+                    tuple[i] = directValue(ip + 3 + 2 * i);
+                }
+                stack.push(relPtr->contains(TupleRef(tuple, arity)));
+                ip += 3 + 2 * arity;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_FUSED_Project) {
+                RamDomain arity = code[ip + 1];
+                size_t relId = code[ip + 2];
+                RamDomain tuple[arity];
+                for (auto i = 0; i < arity; ++i) {
+                    tuple[i] = directValue(ip + 3 + 2 * i);
+                }
+                insertTuple(ctxt, relId, tuple, arity);
+                ip += 3 + 2 * arity;
+            }
+                LVM_DISPATCH;
+            LVM_CASE(LVM_STOP)
                 assert(stack.size() == 0);
                 return;
+            LVM_CASE(LVM_NOP)
+            LVM_CASE(LVM_BTREE)
+            LVM_CASE(LVM_BRIE)
+            LVM_CASE(LVM_EQREL)
+            LVM_CASE(LVM_DEFAULT)
+            LVM_CASE(LVM_ProvenanceExistenceCheck)
             default:
                 printf("Unknown. eval()\n");
-                break;
+                LVM_DISPATCH;
         }
     }
 }  // namespace souffle
 
+#undef LVM_CASE
+#undef LVM_DISPATCH
+
+bool LVM::isSmallPartition(const std::vector<Stream>& partitions) {
+    const size_t threads = MAX_THREADS;
+    if (threads <= 1) {
+        return false;
+    }
+    const size_t limit = NESTED_PARALLEL_THRESHOLD * threads;
+    size_t count = 0;
+    for (const auto& partition : partitions) {
+        // count the tuples of a copy, as a stream can only be traversed once
+        auto stream = partition.clone();
+        for (auto it = stream->begin(); it != stream->end(); ++it) {
+            if (++count >= limit) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void LVM::executeParallel(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t ip,
+        size_t counterLabel, std::vector<Stream>& partitions, bool choice) {
+    const LVMCode& code = *codeStream;
+    if (code[ip] == LVM_NestedParallel) {
+        // too few tuples for the workers: consume the partitions in turn, the nested loop running in parallel
+        if (isSmallPartition(partitions)) {
+            for (auto& partition : partitions) {
+                ctxt.getStream(counterLabel) = std::move(partition);
+                try {
+                    this->execute(codeStream, ctxt, code[ip + 1]);
+                } catch (std::exception& e) {
+                    SignalHandler::instance()->error(e.what());
+                }
+            }
+            return;
+        }
+        ip += 2;
+    }
+
+    int size = partitions.size();
+    std::atomic<bool> chosen(false);
+#pragma omp parallel
+    {
+        LVMContext threadCtxt(ctxt);
+        if (choice) {
+            threadCtxt.setChoice(chosen);
+        }
+        TraceLog::Span span("parallel loop", "parallel");
+        int64_t chunks = 0;
+#pragma omp for schedule(dynamic)
+        for (int i = 0; i < size; ++i) {
+            // the partitions left once a choice is made are skipped
+            if (choice && chosen.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            ++chunks;
+            threadCtxt.getStream(counterLabel) = std::move(partitions[i]);
+            try {
+                this->execute(codeStream, threadCtxt, ip);
+            } catch (std::exception& e) {
+                SignalHandler::instance()->error(e.what());
+            }
+        }
+        flushInsertBuffers(threadCtxt);
+        span.set("chunks", chunks);
+    }
+}
+
 }  // end of namespace souffle
@@ -16,22 +16,35 @@
 
 #pragma once
 
+#include "InputPrefetcher.h"
 #include "LVMCode.h"
 #include "LVMContext.h"
 #include "LVMGenerator.h"
 #include "LVMInterface.h"
+#include "LVMJit.h"
 #include "LVMRelation.h"
 #include "Logger.h"
+#include "RamPrivateSymbolAnalysis.h"
 #include "RamTranslationUnit.h"
 #include "RamTypes.h"
+#include "RegexCache.h"
 #include "RelationRepresentation.h"
-
+#include "ResourceLimits.h"
+#include "StatisticsCatalog.h"
+#include "SymbolTable.h"
+#include "TraceLog.h"
+#include "Util.h"
+#include "WriteQueue.h"
+
+#include <array>
 #include <atomic>
 #include <cassert>
 #include <cstdlib>
 #include <iostream>
+#include <limits>
 #include <map>
-#include <stack>
+#include <memory>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -51,7 +64,20 @@ class LVM : public LVMInterface {
 public:
     LVM(RamTranslationUnit& tUnit)
             : LVMInterface(tUnit), profile(Global::config().has("profile")),
-              provenance(Global::config().has("provenance")) {}
+              provenance(Global::config().has("provenance")),
+              threadedDispatch(Global::config().get("lvm-dispatch") != "switch"),
+              freezeRelations(Global::config().has("freeze-relations")) {
+        if (Global::config().has("cold-relations")) {
+            auto limits = splitString(Global::config().get("cold-relations"), ',');
+            coldStrata = std::stoul(limits[0]);
+            if (limits.size() > 1) {
+                coldTuples = std::stoul(limits[1]);
+            }
+        }
+        if (Global::config().has("statistics")) {
+            statistics = std::make_unique<StatisticsCatalog>(Global::config().get("statistics"));
+        }
+    }
 
     virtual ~LVM() {
         for (auto* timer : timers) {
@@ -62,6 +88,26 @@ public:
     /** Execute the main program */
     void executeMain() override;
 
+    /**
+     * Compile hot queries to native code in the background.
+     *
+     * @param compileCmd the command compiling a C++ file into a shared library
+     * @param threshold the evaluation time in milliseconds after which a query is compiled
+     */
+    void enableJit(const std::string& compileCmd, double threshold) {
+        jit = std::make_unique<LVMJit>(relationEncoder, compileCmd, threshold);
+    }
+
+    /**
+     * Reuse the relations the given strata of the main program computed in a previous evaluation of
+     * an earlier version of the program, such that the next execution of the main program skips them.
+     * The previous evaluation has to outlive the next execution.
+     */
+    void reuseStrata(LVM& previous, std::set<int> strata) {
+        reusedFrom = &previous;
+        reusedStrata = std::move(strata);
+    }
+
     /** Clean the cache of main Program */
     void resetMainProgram() {
         mainProgram.reset();
@@ -84,9 +130,8 @@ public:
             execute(subroutines.at(name), ctxt);
         } else {
             // Parse and cache the program
-            LVMGenerator generator(translationUnit.getSymbolTable(),
-                    translationUnit.getProgram()->getSubroutine(name), relationEncoder);
-            subroutines.emplace(std::make_pair(name, generator.getCodeStream()));
+            subroutines.emplace(
+                    std::make_pair(name, generate(translationUnit.getProgram()->getSubroutine(name))));
             execute(subroutines.at(name), ctxt);
         }
     }
@@ -94,9 +139,7 @@ public:
     /** Print out the instruction stream */
     void printMain() {
         if (mainProgram.get() == nullptr) {
-            LVMGenerator generator(translationUnit.getSymbolTable(), *translationUnit.getProgram()->getMain(),
-                    relationEncoder);
-            mainProgram = generator.getCodeStream();
+            mainProgram = generate(*translationUnit.getProgram()->getMain());
         }
         mainProgram->print();
     }
@@ -122,6 +165,19 @@ protected:
         return translationUnit.getSymbolTable();
     }
 
+    /** Get the symbol table of the symbols of a relation, which is private for pass-through relations */
+    SymbolTable& getSymbolTable(const std::string& relationName) {
+        auto pos = relationSymbols.find(relationName);
+        return pos != relationSymbols.end() ? *pos->second : getSymbolTable();
+    }
+
+    /** Create the private symbol tables of the relations, before they are used by concurrent reads */
+    void createRelationSymbols() {
+        for (const auto& name : translationUnit.getAnalysis<RamPrivateSymbolAnalysis>()->getRelations()) {
+            relationSymbols[name] = std::make_unique<SymbolTable>();
+        }
+    }
+
     /** Get Counter */
     int getCounter() {
         return counter;
@@ -137,6 +193,44 @@ protected:
         iteration++;
     }
 
+    /** Clear the indexes of all relations that are filled on their first use */
+    void evictIndexes() {
+        for (auto& rel : relationEncoder.getRelationMap()) {
+            if (rel != nullptr) {
+                rel->evictIndexes();
+            }
+        }
+    }
+
+    /** Convert the relations computed by the given stratum into their read-optimised layout */
+    void freezeStratum(size_t stratumLevel) {
+        for (auto& rel : relationEncoder.getRelationMap()) {
+            if (rel == nullptr || rel->getName()[0] == '@' || rel->getLevel() != stratumLevel) {
+                continue;
+            }
+            // relations written in the background are left as they are
+            if (!writeQueue.isWritten(rel.get())) {
+                rel->freeze();
+            }
+        }
+    }
+
+    /**
+     * Compress the frozen relations not accessed for the given number of strata, or holding the given
+     * number of tuples, at the end of a stratum
+     */
+    void compressColdRelations() {
+        for (auto& rel : relationEncoder.getRelationMap()) {
+            if (rel == nullptr || rel->getName()[0] == '@') {
+                continue;
+            }
+            size_t idle = rel->countIdleStrata();
+            if (rel->isFrozen() && (idle >= coldStrata || rel->size() >= coldTuples)) {
+                rel->compress();
+            }
+        }
+    }
+
     /** Get Iteration Number */
     size_t getIterationNumber() const {
         return iteration;
@@ -147,6 +241,11 @@ protected:
         iteration = 0;
     }
 
+    /** Whether the tuples of a relation carry the rule and level columns of provenance */
+    bool hasProvenanceColumns(const std::string& relName) const {
+        return provenance && translationUnit.getProgram()->getRelation(relName)->hasProvenanceColumns();
+    }
+
     /** Get a relation */
     LVMRelation* getRelation(size_t id) {
         return relationEncoder[id].get();
@@ -154,7 +253,27 @@ protected:
 
     /** Drop relation */
     void dropRelation(size_t id) {
-        relationEncoder[id].reset(nullptr);
+        if (profile && relationEncoder[id] != nullptr) {
+            recordMemory(*relationEncoder[id]);
+        }
+        if (indexStatistics && relationEncoder[id] != nullptr) {
+            collectIndexStatistics(*relationEncoder[id]);
+        }
+        if (statistics != nullptr && relationEncoder[id] != nullptr) {
+            collectStatistics(*relationEncoder[id]);
+        }
+        LVMRelation* rel = relationEncoder[id].release();
+        if (rel != nullptr) {
+            // the private symbols of a relation are released along with it
+            auto symbols = relationSymbols.find(rel->getName());
+            SymbolTable* symbolTable = symbols != relationSymbols.end() ? symbols->second.get() : nullptr;
+            writeQueue.release(rel, [rel, symbolTable]() {
+                delete rel;
+                if (symbolTable != nullptr) {
+                    *symbolTable = SymbolTable();
+                }
+            });
+        }
     }
 
     /** Swap relation */
@@ -162,14 +281,6 @@ protected:
         relationEncoder[relAId].swap(relationEncoder[relBId]);
     }
 
-    /** Lookup stream, resize the pool if necessary */
-    Stream& lookUpStream(size_t idx) {
-        if (idx >= streamPool.size()) {
-            streamPool.resize(idx + 1);
-        }
-        return streamPool[idx];
-    }
-
     /** Obtain the search columns */
     SearchSignature getSearchSignature(const std::string& patterns, size_t arity) {
         SearchSignature res = 0;
@@ -184,16 +295,101 @@ protected:
 private:
     friend LVMProgInterface;
 
+    /** Generate the code of a statement, looking up the functions of the functors it calls */
+    std::unique_ptr<LVMCode> generate(const RamStatement& stmt) {
+        LVMGenerator generator(translationUnit.getSymbolTable(), stmt, relationEncoder,
+                *translationUnit.getAnalysis<RamInsertBufferAnalysis>(),
+                *translationUnit.getAnalysis<RamLoopScheduleAnalysis>(),
+                *translationUnit.getAnalysis<RamRecordEscapeAnalysis>(),
+                *translationUnit.getAnalysis<RamLevelAnalysis>(),
+                [this](const std::string& name) { return getMethodHandle(name); });
+        return generator.getCodeStream();
+    }
+
+    /** Add the index accesses of a relation to those of its base relation */
+    void collectIndexStatistics(const LVMRelation& rel);
+
+    /** Add the distinct and frequent values of a relation to the statistics catalog */
+    void collectStatistics(LVMRelation& rel);
+
+    /** Record the memory of the indexes of a relation in the current stratum */
+    void recordMemory(const LVMRelation& rel);
+
+    /** Record the memory of all relations, the symbol table and the records in the current stratum */
+    void recordMemory();
+
     /** Execute given program
      *
      * @param ip the instruction pointer start position, default is 0.
      * */
     void execute(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t ip = 0);
 
+    /**
+     * Execute the strata of the main program but those reused from a previous evaluation, concurrently
+     * each once the strata it depends on finished, or in their order.
+     */
+    void executeStrata(size_t jobs, bool concurrent);
+
+    /** Copy the relations created by the reused strata from the previous evaluation */
+    void restoreReusedStrata();
+
+    /** Execute the loop body starting at ip once per stream, in parallel.
+     *  Each worker runs on its own copy of the context, with the given iterator
+     *  bound to its partition. A body starting with LVM_NestedParallel is replaced
+     *  by its nested parallel version for small partitions, run in turn on the
+     *  context itself. The workers of a choice share the flag claimed by
+     *  LVM_Choose, and skip the partitions left once it is claimed. */
+    void executeParallel(std::unique_ptr<LVMCode>& codeStream, LVMContext& ctxt, size_t ip,
+            size_t counterLabel, std::vector<Stream>& partitions, bool choice = false);
+
+    /** Insert a tuple into a relation. Workers of parallel operations buffer the tuples of relations
+     *  not supporting concurrent inserts, such that they take the lock of the relation once per buffer. */
+    void insertTuple(LVMContext& ctxt, size_t relId, const RamDomain* tuple, size_t arity) {
+        LVMRelation& rel = *getRelation(relId);
+        if (arity == 0 || !ctxt.isWorker() || rel.hasConcurrentInsert()) {
+            rel.insert(TupleRef(tuple, arity));
+            return;
+        }
+        InsertBuffer& buffer = ctxt.getInsertBuffer(relId, arity);
+        if (buffer.insert(tuple)) {
+            flushInsertBuffer(relId, buffer);
+        }
+    }
+
+    /** Merge a buffer of insertions into its relation */
+    void flushInsertBuffer(size_t relId, InsertBuffer& buffer) {
+        getRelation(relId)->insert(buffer);
+    }
+
+    /** Merge the buffers of insertions of a context into their relations */
+    void flushInsertBuffers(LVMContext& ctxt) {
+        for (auto& cur : ctxt.getInsertBuffers()) {
+            flushInsertBuffer(cur.first, cur.second);
+        }
+    }
+
+    /** Whether partitions provide too few tuples for the workers, such that a nested loop runs in parallel */
+    static bool isSmallPartition(const std::vector<Stream>& partitions);
+
+    /** Number of partitions a relation is split into by parallel operations */
+    static constexpr size_t PARTITION_COUNT = 400;
+
     bool profile;
 
     bool provenance;
 
+    /** Dispatch instructions through a table of handler addresses instead of the switch */
+    bool threadedDispatch;
+
+    /** Convert the relations of completed strata into their read-optimised layout */
+    bool freezeRelations;
+
+    /** The number of strata a frozen relation has not been accessed for, after which it is compressed */
+    size_t coldStrata = std::numeric_limits<size_t>::max();
+
+    /** The number of tuples of a frozen relation from which on it is compressed */
+    size_t coldTuples = std::numeric_limits<size_t>::max();
+
     /** subroutines */
     std::map<std::string, std::unique_ptr<LVMCode>> subroutines;
 
@@ -206,23 +402,62 @@ private:
     /** counters for non-existence check */
     std::map<std::string, std::atomic<size_t>> reads;
 
-    /** List of streams for range operation */
-    std::vector<Stream> streamPool;
+    /** whether the accesses of indexes are counted */
+    bool indexStatistics = false;
+
+    /** accesses of the indexes of collected relations by relation and index:
+     *  probes, empty probes, scans and tuples */
+    std::map<std::string, std::map<std::string, std::array<size_t, 4>>> indexAccesses;
 
     /** stratum */
-    size_t level = 0;
+    std::atomic<size_t> level{0};
+
+    /** start of the current stratum in the trace, whose strata are traced in turn unless run concurrently */
+    uint64_t stratumStart = 0;
+    bool traceStrata = false;
+
+    /** Record the end of the current stratum in the trace */
+    void traceStratum() {
+        if (traceStrata && level != 0) {
+            TraceLog::instance().record("stratum " + std::to_string(level - 1), "stratum", stratumStart,
+                    TraceLog::instance().now());
+        }
+        stratumStart = TraceLog::instance().now();
+    }
 
     /** List of loggers for logtimer */
     std::vector<Logger*> timers;
 
     /** counter for $ operator */
-    int counter = 0;
+    std::atomic<int> counter{0};
 
     /** iteration number (in a fix-point calculation) */
-    size_t iteration = 0;
+    std::atomic<size_t> iteration{0};
 
     /** Dynamic library for user-defined functors */
     void* dll = nullptr;
+
+    /** Compiler of hot queries, if enabled */
+    std::unique_ptr<LVMJit> jit;
+
+    /** the private symbol tables of pass-through relations, by relation name */
+    std::map<std::string, std::unique_ptr<SymbolTable>> relationSymbols;
+
+    /** the compiled patterns of match constraints */
+    RegexCache regexCache;
+
+    /** the relations written in the background (--async-output) */
+    WriteQueue writeQueue;
+
+    /** the inputs read in the background (--prefetch-input) */
+    InputPrefetcher inputPrefetcher;
+
+    /** the previous evaluation of the program (--watch) and the strata whose relations it provides */
+    LVM* reusedFrom = nullptr;
+    std::set<int> reusedStrata;
+
+    /** the statistics of the relations kept for later compilations (--statistics) */
+    std::unique_ptr<StatisticsCatalog> statistics;
 };
 
 }  // end of namespace souffle
@@ -25,8 +25,8 @@ void LVMCode::print() const {
     while (true) {
         switch (code[ip]) {
             case LVM_Number:
-                printf("%ld\tLVM_Number\t%d\n", ip, code[ip + 1]);
-                ip += 2;
+                printf("%ld\tLVM_Number\t%lld\n", ip, static_cast<long long>(getDomain(ip + 1)));
+                ip += 1 + DOMAIN_WORDS;
                 break;
             case LVM_TupleElement:
                 printf("%ld\tLVM_TupleElement\tId:%d\tPos:%d\n", ip, code[ip + 1], code[ip + 2]);
@@ -195,11 +195,11 @@ void LVMCode::print() const {
                 ip += 1;
                 break;
             }
-            case LVM_UserDefinedOperator: {  // TODO Later
+            case LVM_UserDefinedOperator: {
+                const LVMFunctorCall& call = *functorCallPool[code[ip + 1]];
                 printf("%ld\tLVM_UserDefinedOperator\n", ip);
-                printf("\t%s\t%s\t\n", symbolTable.resolve(code[ip + 1]).c_str(),
-                        symbolTable.resolve(code[ip + 2]).c_str());
-                ip += 4;
+                printf("\t%s\t%s\t\n", call.name.c_str(), call.type.c_str());
+                ip += 2;
                 break;
             }
             case LVM_PackRecord: {
@@ -207,6 +207,11 @@ void LVMCode::print() const {
                 ip += 2;
                 break;
             }
+            case LVM_PackLocalRecord: {
+                printf("%ld\tLVM_PackLocalRecord\tArity:%d\n", ip, code[ip + 1]);
+                ip += 2;
+                break;
+            }
             case LVM_Argument: {
                 printf("%ld\tLVM_Argument\tSize:%d\n", ip, code[ip + 1]);
                 ip += 2;
@@ -236,6 +241,12 @@ void LVMCode::print() const {
                 ip += 2;
                 break;
             }
+            case LVM_SizeCheck: {
+                printf("%ld\tLVM_SizeCheck", ip);
+                printf("\tTarget: %s\tSize: %d\n", symbolTable.resolve(code[ip + 1]).c_str(), code[ip + 2]);
+                ip += 3;
+                break;
+            }
             case LVM_ExistenceCheck: {
                 printf("%ld\tLVM_ExistenceCheck\t\n", ip);
                 printf("\tTarget: %s\tTypes: %s\n", symbolTable.resolve(code[ip + 1]).c_str(),
@@ -243,6 +254,12 @@ void LVMCode::print() const {
                 ip += 4;
                 break;
             }
+            case LVM_MemoExistenceCheck: {
+                printf("%ld\tLVM_MemoExistenceCheck\tMemo:%d\tRelID:%d\tIndex:%d\n", ip, code[ip + 1],
+                        code[ip + 2], code[ip + 3]);
+                ip += 5 + code[ip + 4];
+                break;
+            }
             case LVM_ProvenanceExistenceCheck: {
                 printf("%ld\tLVM_ProvenanceExitenceChekck\t\n", ip);
                 printf("\tTarget: %s\tTypes: %s\n", symbolTable.resolve(code[ip + 1]).c_str(),
@@ -263,6 +280,38 @@ void LVMCode::print() const {
                 printf("%ld\tLVM_IndexScan\n", ip);
                 ip += 1;
                 break;
+            case LVM_Intersect:
+                printf("%ld\tLVM_Intersect\n", ip);
+                ip += 1;
+                break;
+            case LVM_ParallelScan:
+                printf("%ld\tLVM_ParallelScan\tIterID:%d\tRelID:%d\tEnd:%d\n", ip, code[ip + 1], code[ip + 2],
+                        code[ip + 3]);
+                ip += 4;
+                break;
+            case LVM_ParallelChoice:
+                printf("%ld\tLVM_ParallelChoice\tIterID:%d\tRelID:%d\tEnd:%d\n", ip, code[ip + 1],
+                        code[ip + 2], code[ip + 3]);
+                ip += 4;
+                break;
+            case LVM_ParallelIndexScan:
+                printf("%ld\tLVM_ParallelIndexScan\tIterID:%d\tRelID:%d\tIndex:%d\tEnd:%d\n", ip,
+                        code[ip + 1], code[ip + 2], code[ip + 3], code[ip + 4]);
+                ip += 6;
+                break;
+            case LVM_ParallelIndexChoice:
+                printf("%ld\tLVM_ParallelIndexChoice\tIterID:%d\tRelID:%d\tIndex:%d\tEnd:%d\n", ip,
+                        code[ip + 1], code[ip + 2], code[ip + 3], code[ip + 4]);
+                ip += 6;
+                break;
+            case LVM_NestedParallel:
+                printf("%ld\tLVM_NestedParallel\tNested:%d\n", ip, code[ip + 1]);
+                ip += 2;
+                break;
+            case LVM_Choose:
+                printf("%ld\tLVM_Choose\tEnd:%d\n", ip, code[ip + 1]);
+                ip += 2;
+                break;
             case LVM_Search: {
                 printf("%ld\tLVM_Search\t\n", ip);
                 ip += 3;
@@ -282,6 +331,10 @@ void LVMCode::print() const {
                 printf("\tTarget: %s\t\n", symbolTable.resolve(code[ip + 2]).c_str());
                 ip += 3;
                 break;
+            case LVM_BufferedProject:
+                printf("%ld\tLVM_BufferedProject\tArity:%d\tRelID:%d\n", ip, code[ip + 1], code[ip + 2]);
+                ip += 3;
+                break;
             case LVM_ReturnValue: {
                 printf("%ld\tLVM_ReturnValue\tArity:%dTypes:%s\t\n", ip, code[ip + 1],
                         symbolTable.resolve(code[ip + 2]).c_str());
@@ -307,6 +360,20 @@ void LVMCode::print() const {
                 ip += 2;
                 break;
             }
+            case LVM_PlanSwitch: {
+                printf("%ld\tLVM_PlanSwitch\t%d\n", ip, code[ip + 1]);
+                size_t pos = ip + 2;
+                for (int i = 0; i < code[ip + 1]; ++i) {
+                    printf("\tPlan: %d\t", code[pos]);
+                    for (int j = 0; j < code[pos + 1]; ++j) {
+                        printf("%d(%d) ", code[pos + 2 + 2 * j], code[pos + 3 + 2 * j]);
+                    }
+                    printf("\n");
+                    pos += 2 + 2 * code[pos + 1];
+                }
+                ip = pos;
+                break;
+            }
             case LVM_Loop: {
                 printf("%ld\tLVM_LOOP\n", ip);
                 ip += 1;
@@ -347,6 +414,11 @@ void LVMCode::print() const {
                 ip += 2;
                 break;
             }
+            case LVM_SamplePosition: {
+                printf("%ld\tLVM_SamplePosition\tPosition:%d\n", ip, code[ip + 1]);
+                ip += 2;
+                break;
+            }
             case LVM_Stratum:
                 printf("%ld\tLVM_Stratum\t%ld\n", ip, stratumLevel++);
                 ip += 1;
@@ -367,18 +439,50 @@ void LVMCode::print() const {
                 ip += 2;
                 break;
             }
+            case LVM_Reset: {
+                printf("%ld\tLVM_Reset\t\n", ip);
+                printf("\tTarget: %s\t\n", symbolTable.resolve(code[ip + 1]).c_str());
+                ip += 2;
+                break;
+            }
             case LVM_Drop: {
                 printf("%ld\tLVM_Drop\t\n", ip);
                 printf("\tTarget: %s\t\n", symbolTable.resolve(code[ip + 1]).c_str());
                 ip += 2;
                 break;
             }
+            case LVM_BuildIndex: {
+                printf("%ld\tLVM_BuildIndex\t%d\t%d\n", ip, code[ip + 1], code[ip + 2]);
+                ip += 3;
+                break;
+            }
+            case LVM_DropIndex: {
+                printf("%ld\tLVM_DropIndex\t%d\t%d\n", ip, code[ip + 1], code[ip + 2]);
+                ip += 3;
+                break;
+            }
+            case LVM_BuildFilter: {
+                printf("%ld\tLVM_BuildFilter\t%d\t%d\n", ip, code[ip + 1], code[ip + 2]);
+                ip += 3;
+                break;
+            }
+            case LVM_ClearFilter: {
+                printf("%ld\tLVM_ClearFilter\t%d\t%d\n", ip, code[ip + 1], code[ip + 2]);
+                ip += 3;
+                break;
+            }
             case LVM_LogSize: {
                 printf("%ld\tLVM_LogSize\t\n", ip);
                 printf("\t%s\t\n", symbolTable.resolve(code[ip + 1]).c_str());
                 ip += 3;
                 break;
             }
+            case LVM_LogDistinctValues: {
+                printf("%ld\tLVM_LogDistinctValues\t\n", ip);
+                printf("\t%s\t\n", symbolTable.resolve(code[ip + 1]).c_str());
+                ip += 3 + code[ip + 2];
+                break;
+            }
             case LVM_Load: {
                 printf("%ld\tLVM_Load\t\n", ip);
                 printf("\t%s\t IODirectivesID:%d\n", symbolTable.resolve(code[ip + 1]).c_str(), code[ip + 2]);
@@ -411,9 +515,20 @@ void LVMCode::print() const {
                 ip += 3;
                 break;
             }
+            case LVM_TransitiveClosure: {
+                printf("%ld\tLVM_TransitiveClosure\t\n", ip);
+                printf("\tSource: %s\tTarget: %s\n", symbolTable.resolve(code[ip + 1]).c_str(),
+                        symbolTable.resolve(code[ip + 2]).c_str());
+                ip += 3;
+                break;
+            }
             case LVM_Query:
-                printf("%ld\tLVM_Query\t\n", ip);
-                ip += 1;
+                printf("%ld\tLVM_Query\t%d\tEnd: %d\n", ip, code[ip + 1], code[ip + 2]);
+                ip += 3;
+                break;
+            case LVM_QueryEnd:
+                printf("%ld\tLVM_QueryEnd\t%d\n", ip, code[ip + 1]);
+                ip += 2;
                 break;
             case LVM_Goto:
                 printf("%ld\tLVM_GOTO\t%d\n", ip, code[ip + 1]);
@@ -457,6 +572,22 @@ void LVMCode::print() const {
                 ip += 5;
                 break;
             };
+            case LVM_ITER_InitBoundedRange: {
+                printf("%ld\tLVM_ITER_InitBoundedRange\tIterID:%d\tRelID:%d\tIndex:%d\tColumn:%d\n", ip,
+                        code[ip + 1], code[ip + 2], code[ip + 3], code[ip + 4]);
+                ip += 7;
+                break;
+            };
+            case LVM_ITER_InitIntersect: {
+                printf("%ld\tLVM_ITER_InitIntersect\tIterID:%d\tParticipants:%d\n", ip, code[ip + 1],
+                        code[ip + 2]);
+                size_t numOfParticipants = code[ip + 2];
+                ip += 3;
+                for (size_t i = 0; i < numOfParticipants; ++i) {
+                    ip += 4 + code[ip + 3];
+                }
+                break;
+            };
             case LVM_ITER_NotAtEnd: {
                 printf("%ld\tLVM_NotAtEnd\tIterID:%d\n", ip, code[ip + 1]);
                 ip += 2;
@@ -472,6 +603,30 @@ void LVMCode::print() const {
                 ip += 2;
                 break;
             }
+            case LVM_ITER_Next: {
+                printf("%ld\tLVM_ITER_Next\tIterID:%d\tId:%d\tArity:%d\tExit:%d\tComparisons:%d\n", ip,
+                        code[ip + 1], code[ip + 2], code[ip + 3], code[ip + 4], code[ip + 5]);
+                ip += 6 + 4 * code[ip + 5];
+                break;
+            }
+            case LVM_FUSED_ElementEqNumber:
+                printf("%ld\tLVM_FUSED_ElementEqNumber\tId:%d\tPos:%d\t%d\n", ip, code[ip + 1], code[ip + 2],
+                        code[ip + 3]);
+                ip += 4;
+                break;
+            case LVM_FUSED_ElementEqElement:
+                printf("%ld\tLVM_FUSED_ElementEqElement\tId:%d\tPos:%d\tId:%d\tPos:%d\n", ip, code[ip + 1],
+                        code[ip + 2], code[ip + 3], code[ip + 4]);
+                ip += 5;
+                break;
+            case LVM_FUSED_ContainCheck:
+                printf("%ld\tLVM_FUSED_ContainCheck\tRelID:%d\tArity:%d\n", ip, code[ip + 1], code[ip + 2]);
+                ip += 3 + 2 * code[ip + 2];
+                break;
+            case LVM_FUSED_Project:
+                printf("%ld\tLVM_FUSED_Project\tArity:%d\tRelID:%d\n", ip, code[ip + 1], code[ip + 2]);
+                ip += 3 + 2 * code[ip + 1];
+                break;
             case LVM_NOP:
                 printf("%ld\tLVM_NOP\n", ip);
                 ip += 1;
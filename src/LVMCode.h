@@ -17,160 +17,275 @@
 #pragma once
 
 #include "IODirectives.h"
+#include "RamTypes.h"
 #include "SymbolTable.h"
 
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include <ffi.h>
+
 namespace souffle {
 
-enum LVM_Type {
-    // Expressions
-    LVM_Number,
-    LVM_TupleElement,
-    LVM_AutoIncrement,
-
-    // Unary Functor Operations
-    LVM_OP_ORD,
-    LVM_OP_STRLEN,
-    LVM_OP_NEG,
-    LVM_OP_BNOT,
-    LVM_OP_LNOT,
-    LVM_OP_TONUMBER,
-    LVM_OP_TOSTRING,
-
-    // Binary Functor Operators
-    LVM_OP_ADD,
-    LVM_OP_SUB,
-    LVM_OP_MUL,
-    LVM_OP_DIV,
-    LVM_OP_EXP,
-    LVM_OP_MOD,
-    LVM_OP_BAND,
-    LVM_OP_BOR,
-    LVM_OP_BXOR,
-    LVM_OP_LAND,
-    LVM_OP_LOR,
-    LVM_OP_MAX,
-    LVM_OP_MIN,
-    LVM_OP_CAT,
-
-    // Ternary Functor Operators
-    LVM_OP_SUBSTR,
-
-    // Constraint Op
-    LVM_OP_EQ,
-    LVM_OP_NE,
-    LVM_OP_LT,
-    LVM_OP_LE,
-    LVM_OP_GT,
-    LVM_OP_GE,
-    LVM_OP_MATCH,
-    LVM_OP_NOT_MATCH,
-    LVM_OP_CONTAINS,
-    LVM_OP_NOT_CONTAINS,
-
-    LVM_UserDefinedOperator,
-    LVM_PackRecord,
-    LVM_Argument,
-    LVM_Aggregate_COUNT,
-    LVM_Aggregate_Return,
-
-    // LVM Conditions
-    LVM_Conjunction,
-    LVM_Negation,
-    LVM_ContainCheck,
-    LVM_EmptinessCheck,
-    LVM_ExistenceCheck,
-    LVM_ExistenceCheckOneArg,
-    LVM_ProvenanceExistenceCheck,
-    LVM_Constraint,
-    LVM_True,
-    LVM_False,
-
-    // LVM Operations;
-    LVM_Scan,
-    LVM_IndexScan,
-    LVM_Choice,
-    LVM_IndexChoice,
-    LVM_UnpackRecord,
-    LVM_Aggregate,
-    LVM_IndexAggregate,
-    LVM_Filter,
-    LVM_Project,
-    LVM_ReturnValue,
-    LVM_Search,
-
-    // LVM Stmts
-    LVM_Sequence,
-    LVM_Parallel,
-    LVM_Stop_Parallel,
-    LVM_Loop,
-    LVM_IncIterationNumber,
-    LVM_ResetIterationNumber,
-    LVM_Exit,
-    LVM_LogTimer,
-    LVM_LogRelationTimer,
-    LVM_StopLogTimer,
-    LVM_DebugInfo,
-    LVM_Stratum,
-    LVM_Create,
-    LVM_Clear,
-    LVM_Drop,
-    LVM_LogSize,
-    LVM_Load,
-    LVM_Store,
-    LVM_Fact,
-    LVM_Merge,
-    LVM_Swap,
-    LVM_Query,
-
-    // LVM Branch
-    LVM_Goto,
-    LVM_Jmpnz,
-    LVM_Jmpez,
-    LVM_STOP,
-    LVM_NOP,
-
-    // LVM Relation Structure Representation
-    LVM_BTREE,
-    LVM_BRIE,
-    LVM_EQREL,
-    LVM_DEFAULT,
-
-    LVM_ITER_InitFullIndex,
-    LVM_ITER_InitRangeIndex,
-    LVM_ITER_InitRangeIndexOneArg,
-    LVM_ITER_Select,
-    LVM_ITER_Inc,
-    LVM_ITER_NotAtEnd,
+class RamQuery;
+
+/**
+ * A call of a user-defined functor, its function looked up and its call
+ * interface prepared once when the call is emitted, rather than on each
+ * evaluation of the call
+ */
+struct LVMFunctorCall {
+    LVMFunctorCall(std::string name, std::string type, void* handle)
+            : name(std::move(name)), type(std::move(type)), arity(this->type.size() - 1),
+              function(reinterpret_cast<void (*)()>(handle)), argTypes(arity) {
+        for (size_t i = 0; i < arity; i++) {
+            argTypes[i] = this->type[i] == 'S' ? &ffi_type_pointer : &ffi_type_uint32;
+        }
+        ffi_type* resultType = returnsSymbol() ? &ffi_type_pointer : &ffi_type_uint32;
+        prepared = ffi_prep_cif(&cif, FFI_DEFAULT_ABI, arity, resultType, argTypes.data()) == FFI_OK;
+    }
+
+    LVMFunctorCall(const LVMFunctorCall&) = delete;
+    LVMFunctorCall& operator=(const LVMFunctorCall&) = delete;
+
+    /** Whether the functor returns a symbol rather than a number */
+    bool returnsSymbol() const {
+        return type[arity] != 'N';
+    }
+
+    /** Name of the functor */
+    const std::string name;
+
+    /** Types of the arguments and the result of the functor, S for symbols and N for numbers */
+    const std::string type;
+
+    /** Number of arguments */
+    const size_t arity;
 
+    /** Function of the functor, null if not found in any of the libraries */
+    void (*const function)();
+
+    /** Types of the arguments in the call interface, which refers to them */
+    std::vector<ffi_type*> argTypes;
+
+    /** Call interface of the function */
+    ffi_cif cif;
+
+    /** Whether the call interface could be prepared */
+    bool prepared;
 };
 
+/**
+ * The list of LVM instructions, expanded by FUNC for each instruction
+ */
+#define FOR_EACH_LVM_TYPE(FUNC)                 \
+    /* Expressions */                           \
+    FUNC(LVM_Number)                            \
+    FUNC(LVM_TupleElement)                      \
+    FUNC(LVM_AutoIncrement)                     \
+    /* Unary Functor Operations */              \
+    FUNC(LVM_OP_ORD)                            \
+    FUNC(LVM_OP_STRLEN)                         \
+    FUNC(LVM_OP_NEG)                            \
+    FUNC(LVM_OP_BNOT)                           \
+    FUNC(LVM_OP_LNOT)                           \
+    FUNC(LVM_OP_TONUMBER)                       \
+    FUNC(LVM_OP_TOSTRING)                       \
+    /* Binary Functor Operators */              \
+    FUNC(LVM_OP_ADD)                            \
+    FUNC(LVM_OP_SUB)                            \
+    FUNC(LVM_OP_MUL)                            \
+    FUNC(LVM_OP_DIV)                            \
+    FUNC(LVM_OP_EXP)                            \
+    FUNC(LVM_OP_MOD)                            \
+    FUNC(LVM_OP_BAND)                           \
+    FUNC(LVM_OP_BOR)                            \
+    FUNC(LVM_OP_BXOR)                           \
+    FUNC(LVM_OP_LAND)                           \
+    FUNC(LVM_OP_LOR)                            \
+    FUNC(LVM_OP_MAX)                            \
+    FUNC(LVM_OP_MIN)                            \
+    FUNC(LVM_OP_CAT)                            \
+    /* Ternary Functor Operators */             \
+    FUNC(LVM_OP_SUBSTR)                         \
+    /* Constraint Op */                         \
+    FUNC(LVM_OP_EQ)                             \
+    FUNC(LVM_OP_NE)                             \
+    FUNC(LVM_OP_LT)                             \
+    FUNC(LVM_OP_LE)                             \
+    FUNC(LVM_OP_GT)                             \
+    FUNC(LVM_OP_GE)                             \
+    FUNC(LVM_OP_MATCH)                          \
+    FUNC(LVM_OP_NOT_MATCH)                      \
+    FUNC(LVM_OP_CONTAINS)                       \
+    FUNC(LVM_OP_NOT_CONTAINS)                   \
+    FUNC(LVM_UserDefinedOperator)               \
+    FUNC(LVM_PackRecord)                        \
+    FUNC(LVM_PackLocalRecord)                   \
+    FUNC(LVM_Argument)                          \
+    FUNC(LVM_Aggregate_COUNT)                   \
+    FUNC(LVM_Aggregate_Return)                  \
+    /* LVM Conditions */                        \
+    FUNC(LVM_Conjunction)                       \
+    FUNC(LVM_Negation)                          \
+    FUNC(LVM_ContainCheck)                      \
+    FUNC(LVM_EmptinessCheck)                    \
+    FUNC(LVM_SizeCheck)                         \
+    FUNC(LVM_ExistenceCheck)                    \
+    FUNC(LVM_ExistenceCheckOneArg)              \
+    FUNC(LVM_MemoExistenceCheck)                \
+    FUNC(LVM_ProvenanceExistenceCheck)          \
+    FUNC(LVM_Constraint)                        \
+    FUNC(LVM_True)                              \
+    FUNC(LVM_False)                             \
+    /* LVM Operations */                        \
+    FUNC(LVM_Scan)                              \
+    FUNC(LVM_IndexScan)                         \
+    FUNC(LVM_Choice)                            \
+    FUNC(LVM_IndexChoice)                       \
+    FUNC(LVM_Intersect)                         \
+    FUNC(LVM_ParallelScan)                      \
+    FUNC(LVM_ParallelIndexScan)                 \
+    FUNC(LVM_ParallelChoice)                    \
+    FUNC(LVM_ParallelIndexChoice)               \
+    FUNC(LVM_NestedParallel)                    \
+    FUNC(LVM_Choose)                            \
+    FUNC(LVM_UnpackRecord)                      \
+    FUNC(LVM_Aggregate)                         \
+    FUNC(LVM_IndexAggregate)                    \
+    FUNC(LVM_Filter)                            \
+    FUNC(LVM_Project)                           \
+    FUNC(LVM_BufferedProject)                   \
+    FUNC(LVM_ReturnValue)                       \
+    FUNC(LVM_Search)                            \
+    /* LVM Stmts */                             \
+    FUNC(LVM_Sequence)                          \
+    FUNC(LVM_Parallel)                          \
+    FUNC(LVM_Stop_Parallel)                     \
+    FUNC(LVM_PlanSwitch)                        \
+    FUNC(LVM_Loop)                              \
+    FUNC(LVM_IncIterationNumber)                \
+    FUNC(LVM_ResetIterationNumber)              \
+    FUNC(LVM_Exit)                              \
+    FUNC(LVM_LogTimer)                          \
+    FUNC(LVM_LogRelationTimer)                  \
+    FUNC(LVM_StopLogTimer)                      \
+    FUNC(LVM_DebugInfo)                         \
+    FUNC(LVM_SamplePosition)                    \
+    FUNC(LVM_Stratum)                           \
+    FUNC(LVM_Create)                            \
+    FUNC(LVM_Clear)                             \
+    FUNC(LVM_Reset)                             \
+    FUNC(LVM_Drop)                              \
+    FUNC(LVM_BuildIndex)                        \
+    FUNC(LVM_DropIndex)                         \
+    FUNC(LVM_BuildFilter)                       \
+    FUNC(LVM_ClearFilter)                       \
+    FUNC(LVM_LogSize)                           \
+    FUNC(LVM_LogDistinctValues)                 \
+    FUNC(LVM_Load)                              \
+    FUNC(LVM_Store)                             \
+    FUNC(LVM_Fact)                              \
+    FUNC(LVM_Merge)                             \
+    FUNC(LVM_Swap)                              \
+    FUNC(LVM_TransitiveClosure)                 \
+    FUNC(LVM_Query)                             \
+    FUNC(LVM_QueryEnd)                          \
+    /* LVM Branch */                            \
+    FUNC(LVM_Goto)                              \
+    FUNC(LVM_Jmpnz)                             \
+    FUNC(LVM_Jmpez)                             \
+    FUNC(LVM_STOP)                              \
+    FUNC(LVM_NOP)                               \
+    /* LVM Relation Structure Representation */ \
+    FUNC(LVM_BTREE)                             \
+    FUNC(LVM_BRIE)                              \
+    FUNC(LVM_EQREL)                             \
+    FUNC(LVM_DEFAULT)                           \
+    FUNC(LVM_ITER_InitFullIndex)                \
+    FUNC(LVM_ITER_InitRangeIndex)               \
+    FUNC(LVM_ITER_InitRangeIndexOneArg)         \
+    FUNC(LVM_ITER_InitBoundedRange)             \
+    FUNC(LVM_ITER_InitIntersect)                \
+    FUNC(LVM_ITER_Select)                       \
+    FUNC(LVM_ITER_Inc)                          \
+    FUNC(LVM_ITER_NotAtEnd)                     \
+    FUNC(LVM_ITER_Next)                         \
+    /* LVM Superinstructions */                 \
+    FUNC(LVM_FUSED_ElementEqNumber)             \
+    FUNC(LVM_FUSED_ElementEqElement)            \
+    FUNC(LVM_FUSED_ContainCheck)                \
+    FUNC(LVM_FUSED_Project)
+
+#define LVM_TYPE_ENUM_ENTRY(type) type,
+
+enum LVM_Type { FOR_EACH_LVM_TYPE(LVM_TYPE_ENUM_ENTRY) };
+
+#undef LVM_TYPE_ENUM_ENTRY
+
+/** A word of LVM code, holding an opcode or an operand */
+using LVMWord = int32_t;
+
 /**
  * LVMCode is an array of LVM Opcode and operands.
  * It also contains information (e.g. IODirectives and SymbolTable) which is necessary for it to be executed
  * by the LVM.
+ *
+ * The opcodes and operands take a word of 32 bits each, independently of the size of RamDomain, such that
+ * the code of 64-bit builds takes half the memory and cache. Number constants are stored by pushDomain()
+ * in as many words as a RamDomain takes; the superinstructions and batched comparisons holding a constant
+ * in a single word are only emitted for constants fitting a word.
  */
-class LVMCode : protected std::vector<RamDomain> {
+class LVMCode : protected std::vector<LVMWord> {
 public:
     LVMCode(SymbolTable& symbolTable) : symbolTable(symbolTable) {}
 
-    using std::vector<RamDomain>::push_back;
-    using std::vector<RamDomain>::clear;
-    using std::vector<RamDomain>::size;
-    using std::vector<RamDomain>::operator[];
-    using std::vector<RamDomain>::begin;
-    using std::vector<RamDomain>::end;
+    /** The number of words of a RamDomain value */
+    static constexpr size_t DOMAIN_WORDS = (sizeof(RamDomain) + sizeof(LVMWord) - 1) / sizeof(LVMWord);
+
+    /** The number of columns covered by each type mask of a search */
+    static constexpr size_t MASK_BITS = 8 * sizeof(LVMWord);
+
+    using std::vector<LVMWord>::push_back;
+    using std::vector<LVMWord>::clear;
+    using std::vector<LVMWord>::size;
+    using std::vector<LVMWord>::operator[];
+    using std::vector<LVMWord>::begin;
+    using std::vector<LVMWord>::end;
+
+    /** Check whether a value fits into a single word */
+    static bool fitsWord(RamDomain value) {
+        return static_cast<RamDomain>(static_cast<LVMWord>(value)) == value;
+    }
+
+    /** Append a value in DOMAIN_WORDS words, the least significant first */
+    void pushDomain(RamDomain value) {
+        for (size_t i = 0; i < DOMAIN_WORDS; i++) {
+            push_back(static_cast<LVMWord>(static_cast<uint64_t>(value) >> (32 * i)));
+        }
+    }
+
+    /** Read a value appended by pushDomain() at a position */
+    RamDomain getDomain(size_t pos) const {
+        uint64_t value = 0;
+        for (size_t i = 0; i < DOMAIN_WORDS; i++) {
+            value |= static_cast<uint64_t>(static_cast<uint32_t>((*this)[pos + i])) << (32 * i);
+        }
+        return static_cast<RamDomain>(value);
+    }
 
     /** Return reference to code stream */
-    std::vector<RamDomain>& getCode() {
+    std::vector<LVMWord>& getCode() {
         return *this;
     }
 
     /** Return code stream */
-    std::vector<RamDomain> getCode() const {
-        return std::vector<RamDomain>(begin(), end());
+    std::vector<LVMWord> getCode() const {
+        return std::vector<LVMWord>(begin(), end());
     }
 
     /** Return IODirectives pool */
@@ -183,6 +298,31 @@ public:
         return IODirectivesPool.size();
     }
 
+    /** Return the pool of queries */
+    std::vector<const RamQuery*>& getQueries() {
+        return queryPool;
+    }
+
+    /** Return the labels of the rules marked for the sampling profiler, numbered from one */
+    std::vector<std::string>& getSampleRules() {
+        return sampleRules;
+    }
+
+    /** Return the maximal number of values on the stack during an execution of the code */
+    size_t getMaxStackDepth() const {
+        return maxStackDepth;
+    }
+
+    /** Set the maximal number of values on the stack during an execution of the code */
+    void setMaxStackDepth(size_t depth) {
+        maxStackDepth = depth;
+    }
+
+    /** Return the pool of calls of user-defined functors */
+    std::vector<std::unique_ptr<LVMFunctorCall>>& getFunctorCalls() {
+        return functorCallPool;
+    }
+
     /** Return SymbolTabel */
     SymbolTable& getSymbolTable() {
         return symbolTable;
@@ -197,6 +337,18 @@ private:
     /** Store reference to IODirectives */
     std::vector<std::vector<IODirectives>> IODirectivesPool;
 
+    /** Store the queries, referenced for their native evaluation */
+    std::vector<const RamQuery*> queryPool;
+
+    /** Store the labels of the sampled rules, the first being unused */
+    std::vector<std::string> sampleRules{""};
+
+    /** Store the calls of user-defined functors */
+    std::vector<std::unique_ptr<LVMFunctorCall>> functorCallPool;
+
+    /** Bound of the number of values on the stack */
+    size_t maxStackDepth = 0;
+
     /** Class for converting string to number and vice versa */
     SymbolTable& symbolTable;
 };
@@ -16,10 +16,15 @@
 
 #pragma once
 
+#include "InsertBuffer.h"
 #include "LVMRelation.h"
 #include "RamTypes.h"
+#include "RecordArena.h"
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace souffle {
@@ -28,15 +33,49 @@ namespace souffle {
  * Evaluation context for Interpreter operations
  */
 class LVMContext {
+public:
+    /** The tuples fetched from a stream in a batch, as far as they pass the filters of their scan */
+    struct Batch {
+        std::array<const RamDomain*, Stream::BUFFER_SIZE> tuples;
+        int pos = 0;
+        int size = 0;
+    };
+
+    /** The key and the result of the last check of a memoised existence check */
+    struct Memo {
+        std::vector<RamDomain> key;
+        bool result = false;
+        bool valid = false;
+    };
+
+private:
     // std::vector<const RamDomain*> data;
     std::vector<TupleRef> data;
     std::vector<RamDomain>* returnValues = nullptr;
     std::vector<bool>* returnErrors = nullptr;
     const std::vector<RamDomain>* args = nullptr;
     std::vector<std::unique_ptr<RamDomain[]>> allocatedDataContainer;
+    std::vector<Stream> streams;
+    std::vector<Batch> batches;
+    std::vector<Memo> memos;
+    std::vector<std::pair<size_t, InsertBuffer>> insertBuffers;
+    RecordArena records;
+    bool worker = false;
+
+    /** the flag shared by the workers of a parallel choice, claimed by the first finding a tuple */
+    std::atomic<bool>* choice = nullptr;
 
 public:
     LVMContext(size_t size = 0) : data(size) {}
+
+    /** Create a context for a worker thread.
+     *  The tuple environment and the subroutine arguments and return buffers are
+     *  shared with the parent, while streams, allocated tuples, insertion buffers
+     *  and local records are owned by the copy. */
+    LVMContext(const LVMContext& parent)
+            : data(parent.data), returnValues(parent.returnValues), returnErrors(parent.returnErrors),
+              args(parent.args), worker(true) {}
+
     virtual ~LVMContext() = default;
 
     TupleRef& operator[](size_t index) {
@@ -56,6 +95,81 @@ public:
         return allocatedDataContainer.back().get();
     }
 
+    /** Lookup stream, resize the pool if necessary */
+    Stream& getStream(size_t idx) {
+        if (idx >= streams.size()) {
+            streams.resize(idx + 1);
+        }
+        return streams[idx];
+    }
+
+    /** Lookup stream to be (re)initialised, dropping the tuples of its batch left by a previous scan */
+    Stream& initStream(size_t idx) {
+        if (idx < batches.size()) {
+            batches[idx].pos = batches[idx].size = 0;
+        }
+        return getStream(idx);
+    }
+
+    /** Lookup the batch of tuples fetched from a stream, resize the pool if necessary */
+    Batch& getBatch(size_t idx) {
+        if (idx >= batches.size()) {
+            batches.resize(idx + 1);
+        }
+        return batches[idx];
+    }
+
+    /** Lookup the memo of an existence check, resize the pool if necessary */
+    Memo& getMemo(size_t idx) {
+        if (idx >= memos.size()) {
+            memos.resize(idx + 1);
+        }
+        return memos[idx];
+    }
+
+    /** Invalidate the memos of existence checks, as the relations may have changed */
+    void clearMemos() {
+        for (auto& cur : memos) {
+            cur.valid = false;
+        }
+    }
+
+    /** Share the flag of a parallel choice among the workers */
+    void setChoice(std::atomic<bool>& flag) {
+        choice = &flag;
+    }
+
+    /** Claim the choice of a parallel choice, returning whether no other worker claimed it before */
+    bool claimChoice() {
+        return choice == nullptr || !choice->exchange(true);
+    }
+
+    /** Whether this is the context of a worker thread of a parallel operation */
+    bool isWorker() const {
+        return worker;
+    }
+
+    /** Lookup the buffer of insertions into a relation, creating it if necessary */
+    InsertBuffer& getInsertBuffer(size_t relId, size_t arity) {
+        for (auto& cur : insertBuffers) {
+            if (cur.first == relId) {
+                return cur.second;
+            }
+        }
+        insertBuffers.emplace_back(relId, InsertBuffer(arity));
+        return insertBuffers.back().second;
+    }
+
+    /** Get the buffers of insertions, by the relation they belong to */
+    std::vector<std::pair<size_t, InsertBuffer>>& getInsertBuffers() {
+        return insertBuffers;
+    }
+
+    /** Get the arena of the records not escaping the current query */
+    RecordArena& getLocalRecords() {
+        return records;
+    }
+
     std::vector<RamDomain>& getReturnValues() const {
         return *returnValues;
     }
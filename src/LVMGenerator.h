@@ -15,21 +15,51 @@
  ***********************************************************************/
 #pragma once
 
+#include "Global.h"
 #include "LVMCode.h"
 #include "LVMRelation.h"
+#include "LogStatement.h"
+#include "RamBloomFilterAnalysis.h"
+#include "RamColumnWidthAnalysis.h"
 #include "RamIndexAnalysis.h"
+#include "RamInsertBufferAnalysis.h"
+#include "RamLevelAnalysis.h"
+#include "RamLoopScheduleAnalysis.h"
+#include "RamRecordEscapeAnalysis.h"
 #include "RamTranslationUnit.h"
 #include "RamVisitor.h"
+#include "SampleProfiler.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
 
 namespace souffle {
 
 /** RelationEncoder create and encode a LVMRelation into a index position for fast lookup */
 class RelationEncoder {
 public:
-    RelationEncoder(RamIndexAnalysis* isa, RamTranslationUnit& tUnit) : isa(isa) {
+    /**
+     * Create the relations of a program; the given function loads the libraries registering the
+     * storage providers of relations, called before the first relation using one is created.
+     */
+    RelationEncoder(
+            RamIndexAnalysis* isa, RamTranslationUnit& tUnit, const std::function<void()>& loadLibraries)
+            : isa(isa), widths(tUnit.getAnalysis<RamColumnWidthAnalysis>()) {
+        for (const auto& pair : tUnit.getProgram()->getAllRelations()) {
+            if (pair.second->getRepresentation() == RelationRepresentation::STORAGE) {
+                loadLibraries();
+                break;
+            }
+        }
         for (const auto& pair : tUnit.getProgram()->getAllRelations()) {
             encodeRelation(*pair.second);
         }
+        if (Global::config().has("index-budget")) {
+            removeLazyIndexes(*tUnit.getProgram());
+        }
+        addFilters(tUnit);
     }
 
     /** Encode a relation into a index Id and return the encoding result.  */
@@ -64,39 +94,205 @@ public:
         return relationMap;
     }
 
+    /** Get the indexes built on entry of a stratum and dropped on its exit, as pairs of relation and index */
+    const std::vector<std::pair<size_t, size_t>>& getLazyIndexes(int stratum) const {
+        static const std::vector<std::pair<size_t, size_t>> none;
+        auto pos = lazyIndexes.find(stratum);
+        return (pos != lazyIndexes.end()) ? pos->second : none;
+    }
+
+    /** Get the Bloom filters filled on entry of a stratum and cleared on its exit, by relation and index */
+    const std::vector<std::pair<size_t, size_t>>& getFilters(int stratum) const {
+        static const std::vector<std::pair<size_t, size_t>> none;
+        auto pos = filters.find(stratum);
+        return (pos != filters.end()) ? pos->second : none;
+    }
+
     RamIndexAnalysis* isa;
 
 private:
     constexpr static size_t MAX_DIRECT_INDEX_SIZE = 12;
 
+    /** The widths of the values inserted into the columns of relations */
+    const RamColumnWidthAnalysis* widths;
+
+    /** Indexes that are used within a single stratum only, mapped by the stratum */
+    std::map<int, std::vector<std::pair<size_t, size_t>>> lazyIndexes;
+
+    /** Indexes whose probes are answered by Bloom filters, mapped by the stratum */
+    std::map<int, std::vector<std::pair<size_t, size_t>>> filters;
+
+    /**
+     * Install Bloom filters for the indexes probed by the existence checks the analysis selects,
+     * filled with the completed relation on entry of the strata containing the checks. A filter
+     * covers the columns bound by all existence checks on its index.
+     */
+    void addFilters(const RamTranslationUnit& tUnit) {
+        const auto* filterAnalysis = tUnit.getAnalysis<RamBloomFilterAnalysis>();
+        std::map<int, std::set<std::pair<size_t, size_t>>> filtered;
+        visitDepthFirst(*tUnit.getProgram()->getMain(), [&](const RamStratum& stratum) {
+            visitDepthFirst(stratum, [&](const RamExistenceCheck& exists) {
+                const RamRelation& rel = exists.getRelation();
+                SearchSignature keys = isa->getSearchSignature(&exists);
+                if (keys == 0 || filterAnalysis->getFilteredSearches(rel).empty()) {
+                    return;
+                }
+                // entire tuples are probed on the main index
+                size_t relId = encodeRelation(rel);
+                size_t indexPos =
+                        isa->isTotalSignature(&exists) ? 0 : isa->getIndexes(rel).getLexOrderNum(keys);
+                relationMap[relId]->addFilter(indexPos, keys);
+                if (filterAnalysis->isFiltered(exists)) {
+                    filtered[stratum.getIndex()].insert(std::make_pair(relId, indexPos));
+                }
+            });
+        });
+        for (const auto& cur : filtered) {
+            filters[cur.first].assign(cur.second.begin(), cur.second.end());
+        }
+    }
+
+    /**
+     * Remove the indexes of relations that are searched within a single stratum only, such that
+     * they only occupy memory while the stratum is evaluated.
+     */
+    void removeLazyIndexes(const RamProgram& program) {
+        // count the searches of each index in the program and in each stratum
+        using IndexUses = std::map<std::pair<const RamRelation*, size_t>, size_t>;
+        auto collectUses = [&](const RamNode& root, IndexUses& uses) {
+            auto addUse = [&](const RamRelation& rel, SearchSignature signature) {
+                // a zero signature is equivalent to a full order signature
+                if (signature == 0) {
+                    signature = (1 << rel.getArity()) - 1;
+                }
+                uses[std::make_pair(&rel, isa->getIndexes(rel).getLexOrderNum(signature))]++;
+            };
+            visitDepthFirst(root, [&](const RamNode& node) {
+                if (const auto* search = dynamic_cast<const RamIndexOperation*>(&node)) {
+                    addUse(search->getRelation(), isa->getSearchSignature(search));
+                } else if (const auto* exists = dynamic_cast<const RamExistenceCheck*>(&node)) {
+                    addUse(exists->getRelation(), isa->getSearchSignature(exists));
+                } else if (const auto* provExists = dynamic_cast<const RamProvenanceExistenceCheck*>(&node)) {
+                    addUse(provExists->getRelation(), isa->getSearchSignature(provExists));
+                } else if (const auto* intersect = dynamic_cast<const RamIntersect*>(&node)) {
+                    for (size_t i = 0; i < intersect->getNumParticipants(); i++) {
+                        const RamRelation& rel = intersect->getRelation(i);
+                        uses[std::make_pair(&rel, isa->getIndexes(rel).getOrderedLexOrderNum(
+                                                          isa->getSearchSignature(intersect, i),
+                                                          intersect->getColumn(i)))]++;
+                    }
+                }
+            });
+        };
+
+        IndexUses programUses;
+        collectUses(*program.getMain(), programUses);
+        for (const auto& sub : program.getSubroutines()) {
+            collectUses(*sub.second, programUses);
+        }
+
+        visitDepthFirst(*program.getMain(), [&](const RamStratum& stratum) {
+            IndexUses stratumUses;
+            collectUses(stratum, stratumUses);
+            for (const auto& cur : stratumUses) {
+                const RamRelation& rel = *cur.first.first;
+                const size_t indexPos = cur.first.second;
+                // the main index, indexes of temporary relations, and indexes of relations
+                // with specialised representations are kept
+                if (indexPos == 0 || rel.isTemp() || rel.getArity() > MAX_DIRECT_INDEX_SIZE ||
+                        rel.getRepresentation() == RelationRepresentation::EQREL ||
+                        rel.getRepresentation() == RelationRepresentation::HASHSET) {
+                    continue;
+                }
+                if (programUses[cur.first] == cur.second) {
+                    size_t relId = encodeRelation(rel);
+                    relationMap[relId]->removeIndex(indexPos);
+                    lazyIndexes[stratum.getIndex()].push_back(std::make_pair(relId, indexPos));
+                }
+            }
+        });
+    }
+
     /** RelName to index mapping */
     std::map<std::string, size_t> relNameToIndex;
 
     /** Index to concrete relation mapping */
     std::vector<std::unique_ptr<LVMRelation>> relationMap;
 
+    /**
+     * Check whether a relation is the new or delta relation of a b-tree relation in a fixpoint
+     * loop that is only scanned in full. Its tuples are all inserted into the new relation before
+     * the loop reads them from the delta relation, so that a sorted vector filled on the first
+     * read replaces the tree.
+     */
+    static bool isScannedDelta(const RamRelation& rel, const MinIndexSelection& orderSet) {
+        const std::string& name = rel.getName();
+        if (!rel.isTemp() || rel.isNullary() || rel.hasProvenanceColumns() ||
+                (name.compare(0, 7, "@delta_") != 0 && name.compare(0, 5, "@new_") != 0)) {
+            return false;
+        }
+        if (rel.getRepresentation() != RelationRepresentation::DEFAULT &&
+                rel.getRepresentation() != RelationRepresentation::BTREE) {
+            return false;
+        }
+        return orderSet.isScannedOnly();
+    }
+
+    /**
+     * Check whether all values of a relation fit the domain of narrow indexes, if that is
+     * narrower than RamDomain, halving the memory of the tuples of 64-bit builds.
+     */
+    bool isNarrow(const RamRelation& rel) const {
+        return sizeof(NarrowDomain) < sizeof(RamDomain) && widths->getWidth(rel) <= 8 * sizeof(NarrowDomain);
+    }
+
     /** Create relation with corresponding index type */
     std::unique_ptr<LVMRelation> createRelation(const RamRelation& rel) {
         const MinIndexSelection& orderSet = isa->getIndexes(rel);
 
+        // the storage of a provider holds tuples of any arity
+        if (rel.getRepresentation() == RelationRepresentation::STORAGE) {
+            return std::make_unique<LVMStorageRelation>(rel.getArity(), rel.getName(),
+                    rel.getAttributeTypeQualifiers(), orderSet, rel.getStorage());
+        }
+
         if (rel.getArity() > MAX_DIRECT_INDEX_SIZE) {
             return std::make_unique<LVMIndirectRelation>(
                     rel.getArity(), rel.getName(), rel.getAttributeTypeQualifiers(), orderSet);
         }
 
+        if (isScannedDelta(rel, orderSet)) {
+            return std::make_unique<LVMRelation>(rel.getArity(), rel.getName(),
+                    rel.getAttributeTypeQualifiers(), orderSet, createVectorIndex);
+        }
+
         switch (rel.getRepresentation()) {
             case RelationRepresentation::BTREE:
-                return std::make_unique<LVMRelation>(
-                        rel.getArity(), rel.getName(), rel.getAttributeTypeQualifiers(), orderSet);
+                return std::make_unique<LVMRelation>(rel.getArity(), rel.getName(),
+                        rel.getAttributeTypeQualifiers(), orderSet,
+                        isNarrow(rel) ? createNarrowBTreeIndex : createBTreeIndex);
             case RelationRepresentation::BRIE:
                 return std::make_unique<LVMRelation>(rel.getArity(), rel.getName(),
                         rel.getAttributeTypeQualifiers(), orderSet, createBrieIndex);
+            case RelationRepresentation::COMPRESSED:
+                return std::make_unique<LVMRelation>(rel.getArity(), rel.getName(),
+                        rel.getAttributeTypeQualifiers(), orderSet, createCompressedIndex);
+            case RelationRepresentation::MMAP:
+                return std::make_unique<LVMRelation>(rel.getArity(), rel.getName(),
+                        rel.getAttributeTypeQualifiers(), orderSet, createMappedIndex);
+            case RelationRepresentation::BITMAP:
+                return std::make_unique<LVMRelation>(rel.getArity(), rel.getName(),
+                        rel.getAttributeTypeQualifiers(), orderSet, createBitmapIndex);
+            case RelationRepresentation::HASHSET:
+                return std::make_unique<LVMHashRelation>(
+                        rel.getArity(), rel.getName(), rel.getAttributeTypeQualifiers(), orderSet);
             case RelationRepresentation::EQREL:
                 return std::make_unique<LVMEqRelation>(
                         rel.getArity(), rel.getName(), rel.getAttributeTypeQualifiers(), orderSet);
             case RelationRepresentation::DEFAULT:
-                return std::make_unique<LVMRelation>(
-                        rel.getArity(), rel.getName(), rel.getAttributeTypeQualifiers(), orderSet);
+                return std::make_unique<LVMRelation>(rel.getArity(), rel.getName(),
+                        rel.getAttributeTypeQualifiers(), orderSet,
+                        isNarrow(rel) ? createNarrowBTreeIndex : createBTreeIndex);
             default:
                 break;
         }
@@ -114,12 +310,19 @@ public:
      * This is done by traversing the tree twice, in order to find the necessary information (Jump
      * destination) for LVM branch operations.
      */
-    LVMGenerator(SymbolTable& symbolTable, const RamStatement& entry, RelationEncoder& relationEncoder)
-            : symbolTable(symbolTable), code(new LVMCode(symbolTable)), relationEncoder(relationEncoder) {
+    LVMGenerator(SymbolTable& symbolTable, const RamStatement& entry, RelationEncoder& relationEncoder,
+            const RamInsertBufferAnalysis& insertBuffers, const RamLoopScheduleAnalysis& loopSchedule,
+            const RamRecordEscapeAnalysis& recordEscape, const RamLevelAnalysis& levels,
+            std::function<void*(const std::string&)> functorHandles)
+            : symbolTable(symbolTable), code(new LVMCode(symbolTable)), relationEncoder(relationEncoder),
+              insertBuffers(insertBuffers), loopSchedule(loopSchedule), recordEscape(recordEscape),
+              levels(levels), functorHandles(std::move(functorHandles)),
+              fusion(!Global::config().has("disable-lvm-fusion")) {
         (*this)(entry, 0);
         (*this).cleanUp();
         (*this)(entry, 0);
         code->push_back(LVM_STOP);
+        code->setMaxStackDepth(getMaxStackDepth(entry));
     }
 
     virtual std::unique_ptr<LVMCode> getCodeStream() {
@@ -127,11 +330,42 @@ public:
     }
 
 protected:
+    /**
+     * Bound the number of values on the stack executing a statement. The values of
+     * an operation are those of its expressions and conditions, at most one for each of
+     * their nodes, on top of the value of an aggregate or the end check of a loop.
+     */
+    static size_t getMaxStackDepth(const RamStatement& entry) {
+        std::function<size_t(const RamNode&)> numValues = [&](const RamNode& node) {
+            size_t res = 1;
+            for (const RamNode* child : node.getChildNodes()) {
+                res += numValues(*child);
+            }
+            return res;
+        };
+        size_t depth = 0;
+        visitDepthFirst(entry, [&](const RamNode& node) {
+            if (dynamic_cast<const RamExpression*>(&node) != nullptr ||
+                    dynamic_cast<const RamCondition*>(&node) != nullptr) {
+                return;
+            }
+            size_t values = 0;
+            for (const RamNode* child : node.getChildNodes()) {
+                if (dynamic_cast<const RamExpression*>(child) != nullptr ||
+                        dynamic_cast<const RamCondition*>(child) != nullptr) {
+                    values += numValues(*child);
+                }
+            }
+            depth = std::max(depth, values);
+        });
+        return depth + 2;
+    }
+
     // Visit RAM Expressions
 
     void visitNumber(const RamNumber& num, size_t exitAddress) override {
         code->push_back(LVM_Number);
-        code->push_back(num.getConstant());
+        code->pushDomain(num.getConstant());
     }
 
     void visitTupleElement(const RamTupleElement& access, size_t exitAddress) override {
@@ -275,9 +509,9 @@ protected:
             visit(op.getArgument(i), exitAddress);
         }
         code->push_back(LVM_UserDefinedOperator);
-        code->push_back(symbolTable.lookup(op.getName()));
-        code->push_back(symbolTable.lookup(op.getType()));
-        code->push_back(op.getArgCount());
+        code->getFunctorCalls().push_back(std::make_unique<LVMFunctorCall>(
+                op.getName(), op.getType(), functorHandles(op.getName())));
+        code->push_back(code->getFunctorCalls().size() - 1);
     }
 
     void visitPackRecord(const RamPackRecord& pack, size_t exitAddress) override {
@@ -285,7 +519,7 @@ protected:
         for (auto& value : values) {
             visit(value, exitAddress);
         }
-        code->push_back(LVM_PackRecord);
+        code->push_back(recordEscape.isLocal(pack) ? LVM_PackLocalRecord : LVM_PackRecord);
         code->push_back(values.size());
     }
 
@@ -320,10 +554,28 @@ protected:
         code->push_back(relationEncoder.encodeRelation(emptiness.getRelation()));
     }
 
+    void visitSizeCheck(const RamSizeCheck& check, size_t exitAddress) override {
+        code->push_back(LVM_SizeCheck);
+        code->push_back(relationEncoder.encodeRelation(check.getRelation()));
+        code->push_back(check.getSize());
+    }
+
     void visitExistenceCheck(const RamExistenceCheck& exists, size_t exitAddress) override {
         auto values = exists.getValues();
         auto arity = exists.getRelation().getArity();
         auto relId = relationEncoder.encodeRelation(exists.getRelation());
+
+        // A fully bound key of tuple elements and constants is read directly from the environment
+        if (fusion && arity > 0 && std::all_of(values.begin(), values.end(), isDirectValue)) {
+            code->push_back(LVM_FUSED_ContainCheck);
+            code->push_back(relId);
+            code->push_back(arity);
+            for (const auto& value : values) {
+                emitDirectValue(value);
+            }
+            return;
+        }
+
         std::vector<int> typeMask(arity);
         bool emptinessCheck = true;
         bool fullExistenceCheck = true;
@@ -345,6 +597,16 @@ protected:
             // Full type mask is equivalent to a full order existence check
             code->push_back(LVM_ContainCheck);
             code->push_back(relId);
+        } else if (isMemoised(exists)) {
+            // Checks likely to be repeated for the same key take the result of the last one
+            size_t indexPos = getIndexPos(exists);
+            size_t numOfTypeMasks = arity / LVMCode::MASK_BITS + (arity % LVMCode::MASK_BITS != 0);
+            code->push_back(LVM_MemoExistenceCheck);
+            code->push_back(memoIndex++);
+            code->push_back(relId);
+            code->push_back(indexPos);
+            code->push_back(numOfTypeMasks);
+            emitTypeMasks(arity, typeMask);
         } else {  // Otherwise we do a partial existence check.
             size_t indexPos = getIndexPos(exists);
             this->emitExistenceCheckInst(arity, relId, indexPos, typeMask);
@@ -381,6 +643,28 @@ protected:
     }
 
     void visitConstraint(const RamConstraint& relOp, size_t exitAddress) override {
+        // Equality between two directly accessible values is performed by a single instruction
+        if (fusion && relOp.getOperator() == BinaryConstraintOp::EQ && isDirectValue(&relOp.getLHS()) &&
+                isDirectValue(&relOp.getRHS())) {
+            const RamExpression* lhs = &relOp.getLHS();
+            const RamExpression* rhs = &relOp.getRHS();
+            if (dynamic_cast<const RamNumber*>(lhs) != nullptr) {
+                std::swap(lhs, rhs);
+            }
+            if (dynamic_cast<const RamNumber*>(rhs) == nullptr) {
+                code->push_back(LVM_FUSED_ElementEqElement);
+                emitDirectValue(lhs);
+                emitDirectValue(rhs);
+                return;
+            }
+            if (dynamic_cast<const RamNumber*>(lhs) == nullptr) {
+                code->push_back(LVM_FUSED_ElementEqNumber);
+                emitDirectValue(lhs);
+                code->push_back(static_cast<const RamNumber*>(rhs)->getConstant());
+                return;
+            }
+        }
+
         code->push_back(LVM_Constraint);
         visit(relOp.getLHS(), exitAddress);
         visit(relOp.getRHS(), exitAddress);
@@ -427,6 +711,16 @@ protected:
     }
 
     void visitTupleOperation(const RamTupleOperation& search, size_t exitAddress) override {
+        emitSearch(search);
+        visitNestedOperation(search, exitAddress);
+    }
+
+    /** Emit the label of a search, marking the position of the sample profiler if it is enabled */
+    void emitSearch(const RamTupleOperation& search) {
+        if (sampleRule != 0) {
+            code->push_back(LVM_SamplePosition);
+            code->push_back(SampleProfiler::getPosition(sampleRule, search.getTupleId() + 1));
+        }
         code->push_back(LVM_Search);
         if (search.getProfileText().empty()) {
             code->push_back(0);
@@ -434,10 +728,14 @@ protected:
             code->push_back(1);
         }
         code->push_back(symbolTable.lookup(search.getProfileText()));
-        visitNestedOperation(search, exitAddress);
     }
 
     void visitScan(const RamScan& scan, size_t exitAddress) override {
+        if (&scan == nestedParallel) {
+            nestedParallel = nullptr;
+            emitParallelScan(scan);
+            return;
+        }
         code->push_back(LVM_Scan);
         size_t counterLabel = getNewIterator();
         size_t L1 = getNewAddressLabel();
@@ -447,6 +745,13 @@ protected:
         code->push_back(counterLabel);
         code->push_back(relationEncoder.encodeRelation(scan.getRelation()));
 
+        // Fetch the tuples in batches by a single instruction
+        if (fusion) {
+            emitBatchedLoop(scan, counterLabel, L1);
+            setAddress(L1, code->size());
+            return;
+        }
+
         // While iterator is not at end
         size_t address_L0 = code->size();
 
@@ -512,10 +817,25 @@ protected:
     }
 
     void visitIndexScan(const RamIndexScan& scan, size_t exitAddress) override {
+        if (&scan == nestedParallel) {
+            nestedParallel = nullptr;
+            emitParallelIndexScan(scan, exitAddress);
+            return;
+        }
         code->push_back(LVM_IndexScan);
         size_t counterLabel = getNewIterator();
         size_t L1 = getNewAddressLabel();
 
+        // The bounds of the range column, below the pattern for index
+        if (scan.hasRange()) {
+            if (!isRamUndefValue(&scan.getUpperBound())) {
+                visit(scan.getUpperBound(), exitAddress);
+            }
+            if (!isRamUndefValue(&scan.getLowerBound())) {
+                visit(scan.getLowerBound(), exitAddress);
+            }
+        }
+
         // Obtain the pattern for index
         auto patterns = scan.getRangePattern();
         auto arity = scan.getRelation().getArity();
@@ -531,7 +851,9 @@ protected:
         }
 
         // Init range index based on pattern
-        if (fullIndexSearch == true) {
+        if (scan.hasRange()) {
+            this->emitBoundedRangeInst(scan, arity, relId, counterLabel, typeMask);
+        } else if (fullIndexSearch == true) {
             code->push_back(LVM_ITER_InitFullIndex);
             code->push_back(counterLabel);
             code->push_back(relId);
@@ -540,6 +862,13 @@ protected:
             this->emitRangeIndexInst(arity, relId, indexPos, counterLabel, typeMask);
         }
 
+        // Fetch the tuples in batches by a single instruction
+        if (fusion) {
+            emitBatchedLoop(scan, counterLabel, L1);
+            setAddress(L1, code->size());
+            return;
+        }
+
         // While iter is not at end
         size_t address_L0 = code->size();
         code->push_back(LVM_ITER_NotAtEnd);
@@ -562,6 +891,74 @@ protected:
         setAddress(L1, code->size());
     }
 
+    void visitIntersect(const RamIntersect& intersect, size_t exitAddress) override {
+        code->push_back(LVM_Intersect);
+        size_t counterLabel = getNewIterator();
+        size_t L1 = getNewAddressLabel();
+
+        // Push the patterns of all participants, such that the first one ends up on top
+        size_t numOfParticipants = intersect.getNumParticipants();
+        std::vector<std::vector<int>> typeMasks(numOfParticipants);
+        for (size_t p = numOfParticipants; p-- > 0;) {
+            auto patterns = intersect.getRangePattern(p);
+            auto arity = intersect.getRelation(p).getArity();
+            typeMasks[p].resize(arity);
+            for (size_t i = arity; i-- > 0;) {
+                if (!isRamUndefValue(patterns[i])) {
+                    visit(patterns[i], exitAddress);
+                    typeMasks[p][i] = 1;
+                }
+            }
+        }
+
+        // Init the intersection of the participants
+        code->push_back(LVM_ITER_InitIntersect);
+        code->push_back(counterLabel);
+        code->push_back(numOfParticipants);
+        for (size_t p = 0; p < numOfParticipants; ++p) {
+            const RamRelation& rel = intersect.getRelation(p);
+            auto arity = rel.getArity();
+            size_t numOfTypeMasks = arity / LVMCode::MASK_BITS + (arity % LVMCode::MASK_BITS != 0);
+            code->push_back(relationEncoder.encodeRelation(rel));
+            code->push_back(relationEncoder.isa->getIndexes(rel).getOrderedLexOrderNum(
+                    relationEncoder.isa->getSearchSignature(&intersect, p), intersect.getColumn(p)));
+            code->push_back(intersect.getColumn(p));
+            code->push_back(numOfTypeMasks);
+            for (size_t i = 0; i < numOfTypeMasks; ++i) {
+                LVMWord types = 0;
+                for (size_t j = 0; j < LVMCode::MASK_BITS; ++j) {
+                    auto projectedIndex = i * LVMCode::MASK_BITS + j;
+                    if (projectedIndex >= arity) {
+                        break;
+                    }
+                    types |= (typeMasks[p][projectedIndex] << j);
+                }
+                code->push_back(types);
+            }
+        }
+
+        // While iter is not at end
+        size_t address_L0 = code->size();
+        code->push_back(LVM_ITER_NotAtEnd);
+        code->push_back(counterLabel);
+        code->push_back(LVM_Jmpez);
+        code->push_back(lookupAddress(L1));
+
+        // Select the common value pointed by the iter
+        code->push_back(LVM_ITER_Select);
+        code->push_back(counterLabel);
+        code->push_back(intersect.getTupleId());
+
+        // Increment the iter and jump to the start of while loop.
+        visitTupleOperation(intersect, lookupAddress(L1));
+
+        code->push_back(LVM_ITER_Inc);
+        code->push_back(counterLabel);
+        code->push_back(LVM_Goto);
+        code->push_back(address_L0);
+        setAddress(L1, code->size());
+    }
+
     void visitIndexChoice(const RamIndexChoice& indexChoice, size_t exitAddress) override {
         code->push_back(LVM_IndexChoice);
         size_t counterLabel = getNewIterator();
@@ -619,6 +1016,130 @@ protected:
         setAddress(L2, code->size());
     }
 
+    void visitParallelScan(const RamParallelScan& scan, size_t exitAddress) override {
+        emitParallelScan(scan);
+    }
+
+    void visitParallelChoice(const RamParallelChoice& choice, size_t exitAddress) override {
+        size_t counterLabel = getNewIterator();
+        size_t L1 = getNewAddressLabel();
+        size_t L2 = getNewAddressLabel();
+        size_t L3 = getNewAddressLabel();
+        size_t address_start = code->size();
+
+        // Partition the relation, each stream is consumed by the loop below
+        code->push_back(LVM_ParallelChoice);
+        code->push_back(counterLabel);
+        code->push_back(relationEncoder.encodeRelation(choice.getRelation()));
+        code->push_back(lookupAddress(L3));
+
+        // While iterator is not at end
+        size_t address_L0 = code->size();
+        code->push_back(LVM_ITER_NotAtEnd);
+        code->push_back(counterLabel);
+        code->push_back(LVM_Jmpez);
+        code->push_back(lookupAddress(L2));
+
+        // Select the tuple pointed by iter
+        code->push_back(LVM_ITER_Select);
+        code->push_back(counterLabel);
+        code->push_back(choice.getTupleId());
+
+        // If condition is met, perform nested operation and exit.
+        visit(choice.getCondition(), exitAddress);
+        code->push_back(LVM_Jmpnz);
+        code->push_back(lookupAddress(L1));
+
+        // Else increment the iter and jump to the start of the while loop.
+        code->push_back(LVM_ITER_Inc);
+        code->push_back(counterLabel);
+        code->push_back(LVM_Goto);
+        code->push_back(address_L0);
+
+        // Only the first worker finding a tuple performs the nested operation
+        setAddress(L1, code->size());
+        code->push_back(LVM_Choose);
+        code->push_back(lookupAddress(L2));
+        visitTupleOperation(choice, lookupAddress(L2));
+
+        // End of the partition
+        setAddress(L2, code->size());
+        code->push_back(LVM_Stop_Parallel);
+        code->push_back(address_start);
+        setAddress(L3, code->size());
+    }
+
+    void visitParallelIndexScan(const RamParallelIndexScan& scan, size_t exitAddress) override {
+        emitParallelIndexScan(scan, exitAddress);
+    }
+
+    void visitParallelIndexChoice(const RamParallelIndexChoice& indexChoice, size_t exitAddress) override {
+        size_t counterLabel = getNewIterator();
+        size_t L1 = getNewAddressLabel();
+        size_t L2 = getNewAddressLabel();
+        size_t L3 = getNewAddressLabel();
+        size_t address_start = code->size();
+
+        // Obtain the pattern for index
+        auto patterns = indexChoice.getRangePattern();
+        auto arity = indexChoice.getRelation().getArity();
+        auto relId = relationEncoder.encodeRelation(indexChoice.getRelation());
+        std::vector<int> typeMask(arity);
+        bool fullIndexSearch = true;
+        for (size_t i = arity; i-- > 0;) {
+            if (!isRamUndefValue(patterns[i])) {
+                visit(patterns[i], exitAddress);
+                fullIndexSearch = false;
+                typeMask[i] = 1;
+            }
+        }
+
+        // Partition the range, each stream is consumed by the loop below
+        if (fullIndexSearch == true) {
+            code->push_back(LVM_ParallelChoice);
+            code->push_back(counterLabel);
+            code->push_back(relId);
+            code->push_back(lookupAddress(L3));
+        } else {
+            this->emitPartitionRangeInst(LVM_ParallelIndexChoice, arity, relId, getIndexPos(indexChoice),
+                    counterLabel, lookupAddress(L3), typeMask);
+        }
+
+        // While iter is not at end.
+        size_t address_L0 = code->size();
+        code->push_back(LVM_ITER_NotAtEnd);
+        code->push_back(counterLabel);
+        code->push_back(LVM_Jmpez);
+        code->push_back(lookupAddress(L2));
+
+        // Select the tuple pointed by iter
+        code->push_back(LVM_ITER_Select);
+        code->push_back(counterLabel);
+        code->push_back(indexChoice.getTupleId());
+
+        visit(indexChoice.getCondition(), exitAddress);
+        // If condition is true, perform nested operation and return.
+        code->push_back(LVM_Jmpnz);
+        code->push_back(lookupAddress(L1));
+
+        // Else increment the iter and continue
+        code->push_back(LVM_ITER_Inc);
+        code->push_back(counterLabel);
+        code->push_back(LVM_Goto);
+        code->push_back(address_L0);
+        // Only the first worker finding a tuple performs the nested operation
+        setAddress(L1, code->size());
+        code->push_back(LVM_Choose);
+        code->push_back(lookupAddress(L2));
+        visitTupleOperation(indexChoice, lookupAddress(L2));
+
+        // End of the partition
+        setAddress(L2, code->size());
+        code->push_back(LVM_Stop_Parallel);
+        code->push_back(address_start);
+        setAddress(L3, code->size());
+    }
+
     void visitUnpackRecord(const RamUnpackRecord& lookup, size_t exitAddress) override {
         // (xiaowen): In the case where reference we want to look up is null, we should return.
         // This can be expressed by the LVM instructions or delegate to CPP code.
@@ -901,6 +1422,29 @@ protected:
         size_t arity = project.getRelation().getArity();
         std::string relationName = project.getRelation().getName();
         auto values = project.getValues();
+
+        // Workers of parallel queries buffer the row, merging it into the relation when they are done
+        if (insertBuffers.isBuffered(project)) {
+            for (size_t i = values.size(); i-- > 0;) {
+                visit(values[i], exitAddress);
+            }
+            code->push_back(LVM_BufferedProject);
+            code->push_back(arity);
+            code->push_back(relationEncoder.encodeRelation(project.getRelation()));
+            return;
+        }
+
+        // A row made of tuple elements and constants is read directly from the environment
+        if (fusion && std::all_of(values.begin(), values.end(), isDirectValue)) {
+            code->push_back(LVM_FUSED_Project);
+            code->push_back(arity);
+            code->push_back(relationEncoder.encodeRelation(project.getRelation()));
+            for (const auto& value : values) {
+                emitDirectValue(value);
+            }
+            return;
+        }
+
         for (size_t i = values.size(); i-- > 0;) {
             assert(values[i]);
             visit(values[i], exitAddress);
@@ -931,7 +1475,7 @@ protected:
     void visitSequence(const RamSequence& seq, size_t exitAddress) override {
         code->push_back(LVM_Sequence);
         for (const auto& cur : seq.getStatements()) {
-            visit(cur, exitAddress);
+            visitScheduled(*cur, exitAddress);
         }
     }
 
@@ -945,7 +1489,7 @@ protected:
         // Currently all parallel is executed in sequence.
         if (size == 1 || true) {
             for (const auto& cur : parallel.getStatements()) {
-                visit(cur, exitAddress);
+                visitScheduled(*cur, exitAddress);
             }
             return;
         }
@@ -963,13 +1507,62 @@ protected:
 
         for (size_t i = 0; i < size; ++i) {
             setAddress(startAddresses[i], code->size());
-            visit(parallel.getStatements()[i], exitAddress);
+            visitScheduled(*parallel.getStatements()[i], exitAddress);
             code->push_back(LVM_Stop_Parallel);
             code->push_back(LVM_NOP);
         }
         setAddress(endAddress, code->size());
     }
 
+    /** Visit a statement of a loop body, jumping over it while all relations of its guard are empty */
+    void visitScheduled(const RamStatement& stmt, size_t exitAddress) {
+        const auto& guard = loopSchedule.getGuard(stmt);
+        if (guard.empty()) {
+            visit(stmt, exitAddress);
+            return;
+        }
+        size_t L0 = getNewAddressLabel();
+        for (size_t i = 0; i < guard.size(); ++i) {
+            code->push_back(LVM_EmptinessCheck);
+            code->push_back(relationEncoder.encodeRelation(*guard[i]));
+            if (i > 0) {
+                code->push_back(LVM_Conjunction);
+            }
+        }
+        code->push_back(LVM_Jmpnz);
+        code->push_back(lookupAddress(L0));
+        visit(stmt, exitAddress);
+        setAddress(L0, code->size());
+    }
+
+    void visitPlanSwitch(const RamPlanSwitch& planSwitch, size_t exitAddress) override {
+        const auto& stmts = planSwitch.getStatements();
+        size_t endAddress = getNewAddressLabel();
+        std::vector<size_t> startAddresses;
+
+        code->push_back(LVM_PlanSwitch);
+        code->push_back(stmts.size());
+        for (size_t i = 0; i < stmts.size(); ++i) {
+            startAddresses.push_back(getNewAddressLabel());
+            code->push_back(lookupAddress(startAddresses[i]));
+            const auto& rels = planSwitch.getJoinedRelations(i);
+            const auto& bound = planSwitch.getBoundAttributes(i);
+            code->push_back(rels.size());
+            for (size_t j = 0; j < rels.size(); ++j) {
+                code->push_back(relationEncoder.encodeRelation(*rels[j]->get()));
+                code->push_back(bound[j]);
+            }
+        }
+
+        for (size_t i = 0; i < stmts.size(); ++i) {
+            setAddress(startAddresses[i], code->size());
+            visit(stmts[i], exitAddress);
+            code->push_back(LVM_Goto);
+            code->push_back(lookupAddress(endAddress));
+        }
+        setAddress(endAddress, code->size());
+    }
+
     void visitLoop(const RamLoop& loop, size_t exitAddress) override {
         size_t address_L0 = code->size();
         code->push_back(LVM_Loop);
@@ -978,7 +1571,9 @@ protected:
         size_t address_L1 = lookupAddress(L1);
 
         // Address_L1 is the destination for LVM_Exit
+        loopDepth++;
         visit(loop.getBody(), address_L1);
+        loopDepth--;
 
         code->push_back(LVM_IncIterationNumber);
         code->push_back(LVM_Goto);
@@ -1005,6 +1600,17 @@ protected:
     }
 
     void visitLogTimer(const RamLogTimer& timer, size_t exitAddress) override {
+        // mark a rule for the sampling profiler instead of timing it
+        if (LogStatement::isSample(timer.getMessage())) {
+            sampleRule = lookupSampleRule(timer.getMessage());
+            code->push_back(LVM_SamplePosition);
+            code->push_back(SampleProfiler::getPosition(sampleRule, 0));
+            visit(timer.getStatement(), exitAddress);
+            code->push_back(LVM_SamplePosition);
+            code->push_back(0);
+            sampleRule = 0;
+            return;
+        }
         code->push_back(LVM_LogTimer);
         size_t timerIndex = getNewTimer();
         code->push_back(symbolTable.lookup(timer.getMessage()));
@@ -1021,8 +1627,30 @@ protected:
     }
 
     void visitStratum(const RamStratum& stratum, size_t exitAddress) override {
+        const auto& lazyIndexes = relationEncoder.getLazyIndexes(stratum.getIndex());
+        const auto& filters = relationEncoder.getFilters(stratum.getIndex());
         code->push_back(LVM_Stratum);
+        for (const auto& cur : lazyIndexes) {
+            code->push_back(LVM_BuildIndex);
+            code->push_back(cur.first);
+            code->push_back(cur.second);
+        }
+        for (const auto& cur : filters) {
+            code->push_back(LVM_BuildFilter);
+            code->push_back(cur.first);
+            code->push_back(cur.second);
+        }
         visit(stratum.getBody(), exitAddress);
+        for (const auto& cur : filters) {
+            code->push_back(LVM_ClearFilter);
+            code->push_back(cur.first);
+            code->push_back(cur.second);
+        }
+        for (const auto& cur : lazyIndexes) {
+            code->push_back(LVM_DropIndex);
+            code->push_back(cur.first);
+            code->push_back(cur.second);
+        }
     }
 
     void visitCreate(const RamCreate& create, size_t exitAddress) override {
@@ -1031,7 +1659,8 @@ protected:
     }
 
     void visitClear(const RamClear& clear, size_t exitAddress) override {
-        code->push_back(LVM_Clear);
+        // relations cleared in each iteration of a loop keep their memory for the next one
+        code->push_back(loopDepth > 0 ? LVM_Reset : LVM_Clear);
         code->push_back(relationEncoder.encodeRelation(clear.getRelation()));
     }
 
@@ -1046,6 +1675,15 @@ protected:
         code->push_back(symbolTable.lookup(size.getMessage()));
     }
 
+    void visitLogDistinctValues(const RamLogDistinctValues& distinct, size_t exitAddress) override {
+        code->push_back(LVM_LogDistinctValues);
+        code->push_back(relationEncoder.encodeRelation(distinct.getRelation()));
+        code->push_back(distinct.getMessages().size());
+        for (const auto& msg : distinct.getMessages()) {
+            code->push_back(symbolTable.lookup(msg));
+        }
+    }
+
     void visitLoad(const RamLoad& load, size_t exitAddress) override {
         code->push_back(LVM_Load);
         code->push_back(relationEncoder.encodeRelation(load.getRelation()));
@@ -1075,8 +1713,24 @@ protected:
     }
 
     void visitQuery(const RamQuery& insert, size_t exitAddress) override {
+        size_t L0 = getNewAddressLabel();
+        size_t L1 = getNewAddressLabel();
+        size_t queryIndex = code->getQueries().size();
+        code->getQueries().push_back(&insert);
+        currentQuery = &insert;
+
+        // the end address is taken when evaluating the query natively
         code->push_back(LVM_Query);
-        visit(insert.getOperation(), exitAddress);
+        code->push_back(queryIndex);
+        code->push_back(lookupAddress(L1));
+
+        // breaks at the top of the query leave the query
+        visit(insert.getOperation(), lookupAddress(L0));
+        setAddress(L0, code->size());
+        code->push_back(LVM_QueryEnd);
+        code->push_back(queryIndex);
+        setAddress(L1, code->size());
+        currentQuery = nullptr;
     }
 
     void visitMerge(const RamMerge& merge, size_t exitAddress) override {
@@ -1095,6 +1749,12 @@ protected:
         code->push_back(relationEncoder.encodeRelation(swap.getSecondRelation()));
     }
 
+    void visitTransitiveClosure(const RamTransitiveClosure& closure, size_t exitAddress) override {
+        code->push_back(LVM_TransitiveClosure);
+        code->push_back(relationEncoder.encodeRelation(closure.getSourceRelation()));
+        code->push_back(relationEncoder.encodeRelation(closure.getTargetRelation()));
+    }
+
     void visitUndefValue(const RamUndefValue& undef, size_t exitAddress) override {
         assert(false && "Compilation error");
     }
@@ -1126,15 +1786,332 @@ private:
     /** Relation Encoder */
     RelationEncoder& relationEncoder;
 
+    /** Projections buffered by the workers of parallel queries */
+    const RamInsertBufferAnalysis& insertBuffers;
+
+    /** Statements of loop bodies skipped while their inputs are empty */
+    const RamLoopScheduleAnalysis& loopSchedule;
+
+    /** Records kept in the arenas of their queries */
+    const RamRecordEscapeAnalysis& recordEscape;
+
+    /** The levels of the expressions of queries */
+    const RamLevelAnalysis& levels;
+
+    /** The query being generated, if any */
+    const RamQuery* currentQuery = nullptr;
+
+    /** The number of memoised existence checks */
+    size_t memoIndex = 0;
+
+    /** Lookup of the functions of user-defined functors */
+    std::function<void*(const std::string&)> functorHandles;
+
+    /** Emit superinstructions for common instruction sequences */
+    bool fusion;
+
+    /** Number of the rule marked for the sampling profiler, or 0 outside of rules */
+    size_t sampleRule = 0;
+
+    /** The nested loop evaluated in parallel as its outer loop provides too few tuples */
+    const RamRelationOperation* nestedParallel = nullptr;
+
+    /** The number of loops enclosing the statement being generated */
+    size_t loopDepth = 0;
+
+    /** Emit a scan whose partitions are consumed by parallel workers */
+    void emitParallelScan(const RamScan& scan) {
+        size_t counterLabel = getNewIterator();
+        size_t L2 = getNewAddressLabel();
+        size_t address_start = code->size();
+
+        // Partition the relation, each stream is consumed by the loops below
+        code->push_back(LVM_ParallelScan);
+        code->push_back(counterLabel);
+        code->push_back(relationEncoder.encodeRelation(scan.getRelation()));
+        code->push_back(lookupAddress(L2));
+
+        emitPartitionLoops(scan, counterLabel, address_start);
+        setAddress(L2, code->size());
+    }
+
+    /** Emit an index scan whose partitions are consumed by parallel workers */
+    void emitParallelIndexScan(const RamIndexScan& scan, size_t exitAddress) {
+        size_t counterLabel = getNewIterator();
+        size_t L2 = getNewAddressLabel();
+        size_t address_start = code->size();
+
+        // Obtain the pattern for index
+        auto patterns = scan.getRangePattern();
+        auto arity = scan.getRelation().getArity();
+        auto relId = relationEncoder.encodeRelation(scan.getRelation());
+        std::vector<int> typeMask(arity);
+        bool fullIndexSearch = true;
+        for (size_t i = arity; i-- > 0;) {
+            if (!isRamUndefValue(patterns[i])) {
+                visit(patterns[i], exitAddress);
+                fullIndexSearch = false;
+                typeMask[i] = 1;
+            }
+        }
+
+        // Partition the range, each stream is consumed by the loops below; the bounds of a range
+        // column are left to the filter of the scan
+        if (fullIndexSearch == true) {
+            code->push_back(LVM_ParallelScan);
+            code->push_back(counterLabel);
+            code->push_back(relId);
+            code->push_back(lookupAddress(L2));
+        } else {
+            this->emitPartitionRangeInst(LVM_ParallelIndexScan, arity, relId, getIndexPos(scan),
+                    counterLabel, lookupAddress(L2), typeMask);
+        }
+
+        emitPartitionLoops(scan, counterLabel, address_start);
+        setAddress(L2, code->size());
+    }
+
+    /**
+     * Emit the loop over the tuples of a partition of a parallel scan. If the nested operation
+     * is a loop, a second version follows for a scan providing too few tuples for the workers,
+     * evaluating the nested loop in parallel instead, and the loops are preceded by
+     * LVM_NestedParallel with its address.
+     */
+    void emitPartitionLoops(const RamRelationOperation& scan, size_t counterLabel, size_t address_start) {
+        const RamRelationOperation* nested = getNestedParallelLoop(scan);
+        if (nested == nullptr) {
+            emitPartitionLoop(scan, counterLabel, address_start);
+            return;
+        }
+        size_t L3 = getNewAddressLabel();
+        code->push_back(LVM_NestedParallel);
+        code->push_back(lookupAddress(L3));
+        emitPartitionLoop(scan, counterLabel, address_start);
+        setAddress(L3, code->size());
+        nestedParallel = nested;
+        emitPartitionLoop(scan, counterLabel, address_start);
+        nestedParallel = nullptr;
+    }
+
+    /** Emit a loop over the stream of a partition, ending the worker consuming it */
+    void emitPartitionLoop(const RamRelationOperation& scan, size_t counterLabel, size_t address_start) {
+        size_t L1 = getNewAddressLabel();
+
+        // While iter is not at end
+        size_t address_L0 = code->size();
+        code->push_back(LVM_ITER_NotAtEnd);
+        code->push_back(counterLabel);
+        code->push_back(LVM_Jmpez);
+        code->push_back(lookupAddress(L1));
+
+        // Select the tuple pointed by the iter
+        code->push_back(LVM_ITER_Select);
+        code->push_back(counterLabel);
+        code->push_back(scan.getTupleId());
+
+        // Perform nested operation
+        visitTupleOperation(scan, lookupAddress(L1));
+
+        // Increment the iter and jump to the start of the while loop
+        code->push_back(LVM_ITER_Inc);
+        code->push_back(counterLabel);
+        code->push_back(LVM_Goto);
+        code->push_back(address_L0);
+
+        // End of the partition
+        setAddress(L1, code->size());
+        code->push_back(LVM_Stop_Parallel);
+        code->push_back(address_start);
+    }
+
+    /**
+     * Emit the loop of a scan, fetching the tuples of its iterator in batches and leaving
+     * the loop at the given label once the iterator is exhausted. The comparisons of a filter
+     * nested in the scan between columns of its tuple and constants are evaluated over each
+     * batch before descending.
+     */
+    void emitBatchedLoop(const RamRelationOperation& scan, size_t counterLabel, size_t L1) {
+        const int tupleId = scan.getTupleId();
+        std::vector<const RamConstraint*> batched;
+        std::vector<const RamCondition*> remaining;
+        const auto* filter = dynamic_cast<const RamFilter*>(&scan.getOperation());
+        if (filter != nullptr && filter->getProfileText().empty()) {
+            std::vector<const RamCondition*> conditions;
+            collectConjuncts(filter->getCondition(), conditions);
+            for (const RamCondition* cur : conditions) {
+                if (isBatchComparison(*cur, tupleId)) {
+                    batched.push_back(static_cast<const RamConstraint*>(cur));
+                } else {
+                    remaining.push_back(cur);
+                }
+            }
+        }
+        if (batched.empty()) {
+            filter = nullptr;
+        }
+
+        // Select the next tuple passing the batched comparisons, or leave the loop
+        size_t address_L0 = code->size();
+        code->push_back(LVM_ITER_Next);
+        code->push_back(counterLabel);
+        code->push_back(tupleId);
+        code->push_back(scan.getRelation().getArity());
+        code->push_back(lookupAddress(L1));
+        code->push_back(batched.size());
+        for (const RamConstraint* cur : batched) {
+            const RamExpression* lhs = &cur->getLHS();
+            const RamExpression* rhs = &cur->getRHS();
+            BinaryConstraintOp op = cur->getOperator();
+            if (dynamic_cast<const RamNumber*>(lhs) != nullptr) {
+                std::swap(lhs, rhs);
+                op = getMirroredOp(op);
+            }
+            code->push_back(static_cast<RamDomain>(op));
+            code->push_back(static_cast<const RamTupleElement*>(lhs)->getElement());
+            if (const auto* number = dynamic_cast<const RamNumber*>(rhs)) {
+                code->push_back(0);
+                code->push_back(number->getConstant());
+            } else {
+                code->push_back(1);
+                code->push_back(static_cast<const RamTupleElement*>(rhs)->getElement());
+            }
+        }
+
+        // Perform nested operation, skipping the filter if all its comparisons are batched
+        if (filter == nullptr) {
+            visitTupleOperation(scan, lookupAddress(L1));
+        } else {
+            emitSearch(scan);
+            if (remaining.empty()) {
+                visit(filter->getOperation(), lookupAddress(L1));
+            } else {
+                code->push_back(LVM_Filter);
+                code->push_back(symbolTable.lookup(filter->getProfileText()));
+                size_t L0 = getNewAddressLabel();
+                for (size_t i = 0; i < remaining.size(); ++i) {
+                    visit(*remaining[i], lookupAddress(L1));
+                    if (i > 0) {
+                        code->push_back(LVM_Conjunction);
+                    }
+                }
+                code->push_back(LVM_Jmpez);
+                code->push_back(lookupAddress(L0));
+                visitNestedOperation(*filter, lookupAddress(L1));
+                setAddress(L0, code->size());
+            }
+        }
+
+        // Jump to the start of the loop
+        code->push_back(LVM_Goto);
+        code->push_back(address_L0);
+    }
+
+    /** Collect the terms of a conjunction */
+    static void collectConjuncts(const RamCondition& condition, std::vector<const RamCondition*>& res) {
+        if (const auto* conj = dynamic_cast<const RamConjunction*>(&condition)) {
+            collectConjuncts(conj->getLHS(), res);
+            collectConjuncts(conj->getRHS(), res);
+        } else {
+            res.push_back(&condition);
+        }
+    }
+
+    /**
+     * Check whether a condition compares a column of the given tuple with a constant or
+     * another of its columns, such that it can be evaluated over a batch of tuples
+     */
+    static bool isBatchComparison(const RamCondition& condition, int tupleId) {
+        const auto* constraint = dynamic_cast<const RamConstraint*>(&condition);
+        if (constraint == nullptr) {
+            return false;
+        }
+        switch (constraint->getOperator()) {
+            case BinaryConstraintOp::EQ:
+            case BinaryConstraintOp::NE:
+            case BinaryConstraintOp::LT:
+            case BinaryConstraintOp::LE:
+            case BinaryConstraintOp::GT:
+            case BinaryConstraintOp::GE:
+                break;
+            default:
+                return false;
+        }
+        auto isColumn = [&](const RamExpression& value) {
+            const auto* access = dynamic_cast<const RamTupleElement*>(&value);
+            return access != nullptr && access->getTupleId() == tupleId;
+        };
+        auto isConstant = [](const RamExpression& value) {
+            const auto* number = dynamic_cast<const RamNumber*>(&value);
+            return number != nullptr && LVMCode::fitsWord(number->getConstant());
+        };
+        const RamExpression& lhs = constraint->getLHS();
+        const RamExpression& rhs = constraint->getRHS();
+        return (isColumn(lhs) && (isColumn(rhs) || isConstant(rhs))) || (isConstant(lhs) && isColumn(rhs));
+    }
+
+    /** Obtain the comparison holding for swapped operands */
+    static BinaryConstraintOp getMirroredOp(BinaryConstraintOp op) {
+        switch (op) {
+            case BinaryConstraintOp::LT:
+                return BinaryConstraintOp::GT;
+            case BinaryConstraintOp::LE:
+                return BinaryConstraintOp::GE;
+            case BinaryConstraintOp::GT:
+                return BinaryConstraintOp::LT;
+            case BinaryConstraintOp::GE:
+                return BinaryConstraintOp::LE;
+            default:
+                return op;
+        }
+    }
+
+    /** Check whether a value can be read by superinstructions without the stack */
+    static bool isDirectValue(const RamExpression* value) {
+        const auto* number = dynamic_cast<const RamNumber*>(value);
+        return dynamic_cast<const RamTupleElement*>(value) != nullptr ||
+               (number != nullptr && LVMCode::fitsWord(number->getConstant()));
+    }
+
+    /** Emit the operand pair of a direct value: (tupleId, element) or (-1, constant) */
+    void emitDirectValue(const RamExpression* value) {
+        if (const auto* access = dynamic_cast<const RamTupleElement*>(value)) {
+            code->push_back(access->getTupleId());
+            code->push_back(access->getElement());
+        } else {
+            code->push_back(-1);
+            code->push_back(static_cast<const RamNumber*>(value)->getConstant());
+        }
+    }
+
     /** Clean up all the content except for addressMap
      *  This is for the double traverse when transforming from RAM -> LVM Bytecode.
      * */
     void cleanUp() {
         code->clear();
         code->getIODirectives().clear();
+        code->getQueries().clear();
+        code->getSampleRules().resize(1);
+        code->getFunctorCalls().clear();
         currentAddressLabel = 0;
         iteratorIndex = 0;
         timerIndex = 0;
+        memoIndex = 0;
+    }
+
+    /**
+     * Whether a partial existence check keeps the result of its last check, which is the case if it is
+     * likely to be repeated for the same key and the relation is not modified by its query
+     */
+    bool isMemoised(const RamExistenceCheck& exists) const {
+        if (currentQuery == nullptr || Global::config().has("profile") ||
+                Global::config().has("profile-indexes")) {
+            return false;
+        }
+        bool modified = false;
+        visitDepthFirst(*currentQuery, [&](const RamProject& project) {
+            modified = modified || &project.getRelation() == &exists.getRelation();
+        });
+        return !modified && levels.isRepeatedKey(*currentQuery, exists, exists.getValues());
     }
 
     /** Get new Address Label */
@@ -1152,6 +2129,17 @@ private:
         return timerIndex++;
     }
 
+    /** Get the number of a sampled rule, given its sample label */
+    size_t lookupSampleRule(const std::string& label) {
+        auto& rules = code->getSampleRules();
+        auto pos = std::find(rules.begin() + 1, rules.end(), label);
+        if (pos == rules.end()) {
+            rules.push_back(label);
+            return rules.size() - 1;
+        }
+        return pos - rules.begin();
+    }
+
     /* Return the value of the addressLabel.
      * Return 0 if label doesn't exits.
      */
@@ -1186,8 +2174,8 @@ private:
     /** Emit existence check instructions */
     void emitExistenceCheckInst(const size_t& arity, const size_t& relId, const size_t& indexPos,
             const std::vector<int>& typeMask) {
-        size_t numOfTypeMasks = arity / RAM_DOMAIN_SIZE + (arity % RAM_DOMAIN_SIZE != 0);
-        // Emit special instruction for relation with arity < RAM_DOMAIN_SIZE
+        size_t numOfTypeMasks = arity / LVMCode::MASK_BITS + (arity % LVMCode::MASK_BITS != 0);
+        // Emit special instruction for relation with arity < LVMCode::MASK_BITS
         // to avoid overhead of checking argument size --- as it is the most common case
         // TODO (xiaowen): benchmark suggest no noticeable difference whether we add
         // this optimization or not.
@@ -1198,10 +2186,16 @@ private:
         }
         code->push_back(relId);
         code->push_back(indexPos);
+        emitTypeMasks(arity, typeMask);
+    }
+
+    /** Emit the type masks of the bound columns of a search, a word of columns per mask */
+    void emitTypeMasks(const size_t& arity, const std::vector<int>& typeMask) {
+        size_t numOfTypeMasks = arity / LVMCode::MASK_BITS + (arity % LVMCode::MASK_BITS != 0);
         for (size_t i = 0; i < numOfTypeMasks; ++i) {
-            RamDomain types = 0;
-            for (size_t j = 0; j < RAM_DOMAIN_SIZE; ++j) {
-                auto projectedIndex = i * RAM_DOMAIN_SIZE + j;
+            LVMWord types = 0;
+            for (size_t j = 0; j < LVMCode::MASK_BITS; ++j) {
+                auto projectedIndex = i * LVMCode::MASK_BITS + j;
                 if (projectedIndex >= arity) {
                     break;
                 }
@@ -1214,8 +2208,8 @@ private:
     /** Emit range index instructions */
     void emitRangeIndexInst(const size_t& arity, const size_t& relId, const size_t& indexPos,
             const size_t& counterLabel, const std::vector<int>& typeMask) {
-        size_t numOfTypeMasks = arity / RAM_DOMAIN_SIZE + (arity % RAM_DOMAIN_SIZE != 0);
-        // Emit special instruction for relation with arity < RAM_DOMAIN_SIZE
+        size_t numOfTypeMasks = arity / LVMCode::MASK_BITS + (arity % LVMCode::MASK_BITS != 0);
+        // Emit special instruction for relation with arity < LVMCode::MASK_BITS
         // to avoid overhead of checking argumnet size --- as it is the most common case
         // TODO (xiaowen): benchmark suggest no noticeable difference whether we add
         // this optimization or not.
@@ -1228,9 +2222,58 @@ private:
         code->push_back(relId);
         code->push_back(indexPos);
         for (size_t i = 0; i < numOfTypeMasks; ++i) {
-            RamDomain types = 0;
-            for (size_t j = 0; j < RAM_DOMAIN_SIZE; ++j) {
-                auto projectedIndex = i * RAM_DOMAIN_SIZE + j;
+            LVMWord types = 0;
+            for (size_t j = 0; j < LVMCode::MASK_BITS; ++j) {
+                auto projectedIndex = i * LVMCode::MASK_BITS + j;
+                if (projectedIndex >= arity) {
+                    break;
+                }
+                types |= (typeMask[projectedIndex] << j);
+            }
+            code->push_back(types);
+        }
+    }
+
+    /** Emit instruction initialising the range of the bounded column of an index scan */
+    void emitBoundedRangeInst(const RamIndexScan& scan, const size_t& arity, const size_t& relId,
+            const size_t& counterLabel, const std::vector<int>& typeMask) {
+        const MinIndexSelection& orderSet = relationEncoder.isa->getIndexes(scan.getRelation());
+        SearchSignature signature = relationEncoder.isa->getSearchSignature(&scan);
+        size_t numOfTypeMasks = arity / LVMCode::MASK_BITS + (arity % LVMCode::MASK_BITS != 0);
+        code->push_back(LVM_ITER_InitBoundedRange);
+        code->push_back(counterLabel);
+        code->push_back(relId);
+        code->push_back(orderSet.getOrderedLexOrderNum(signature, scan.getRangeColumn()));
+        code->push_back(scan.getRangeColumn());
+        code->push_back((isRamUndefValue(&scan.getLowerBound()) ? 0 : 1) |
+                        (isRamUndefValue(&scan.getUpperBound()) ? 0 : 2));
+        for (size_t i = 0; i < numOfTypeMasks; ++i) {
+            LVMWord types = 0;
+            for (size_t j = 0; j < LVMCode::MASK_BITS; ++j) {
+                auto projectedIndex = i * LVMCode::MASK_BITS + j;
+                if (projectedIndex >= arity) {
+                    break;
+                }
+                types |= (typeMask[projectedIndex] << j);
+            }
+            code->push_back(types);
+        }
+    }
+
+    /** Emit instructions partitioning a range index for parallel execution */
+    void emitPartitionRangeInst(LVM_Type opcode, const size_t& arity, const size_t& relId,
+            const size_t& indexPos, const size_t& counterLabel, const size_t& endAddress,
+            const std::vector<int>& typeMask) {
+        size_t numOfTypeMasks = arity / LVMCode::MASK_BITS + (arity % LVMCode::MASK_BITS != 0);
+        code->push_back(opcode);
+        code->push_back(counterLabel);
+        code->push_back(relId);
+        code->push_back(indexPos);
+        code->push_back(endAddress);
+        for (size_t i = 0; i < numOfTypeMasks; ++i) {
+            LVMWord types = 0;
+            for (size_t j = 0; j < LVMCode::MASK_BITS; ++j) {
+                auto projectedIndex = i * LVMCode::MASK_BITS + j;
                 if (projectedIndex >= arity) {
                     break;
                 }
@@ -15,7 +15,20 @@
  ***********************************************************************/
 
 #include "LVMIndex.h"
+#include "BitmapSet.h"
 #include "CompiledIndexUtils.h"
+#include "CompressedSet.h"
+#include "EquivalenceRelation.h"
+#include "FrozenSet.h"
+#include "HashSet.h"
+#include "MappedSet.h"
+#include "SortedVector.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 namespace souffle {
 
@@ -119,6 +132,10 @@ public:
         return present ? 1 : 0;
     }
 
+    std::size_t getMemoryUsage() const override {
+        return sizeof(*this);
+    }
+
     bool insert(const TupleRef& tuple) override {
         assert(tuple.size() == 0);
         bool res = present;
@@ -144,32 +161,230 @@ public:
         return scan();
     }
 
+    bool lowerBound(const TupleRef& low, RamDomain* res) const override {
+        return present;
+    }
+
+    std::vector<Stream> partitionScan(size_t partitionCount) const override {
+        std::vector<Stream> res;
+        res.push_back(scan());
+        return res;
+    }
+
+    std::vector<Stream> partitionRange(
+            const TupleRef& low, const TupleRef& high, size_t partitionCount) const override {
+        return partitionScan(partitionCount);
+    }
+
     void clear() override {
         present = false;
     }
 };
 
+/**
+ * An index order fixed to the arity of the index, such that the
+ * conversion loops are unrolled. Tuples are permuted on the boundary
+ * of the index, and their values converted to those of the domain
+ * stored by the index.
+ *
+ * @tparam Arity the arity of the index
+ * @tparam Natural whether the order is the natural order, requiring no permutation
+ * @tparam Domain the domain of the stored values, a subset of RamDomain
+ */
+template <std::size_t Arity, bool Natural, typename Domain = RamDomain>
+class FixedOrder {
+    std::array<int, Arity> order;
+
+public:
+    using Tuple = ram::Tuple<RamDomain, Arity>;
+    using Entry = ram::Tuple<Domain, Arity>;
+
+    FixedOrder(const Order& order) {
+        for (std::size_t i = 0; i < Arity; ++i) {
+            this->order[i] = order.getOrder()[i];
+        }
+    }
+
+    Entry encode(const Tuple& entry) const {
+        Entry res;
+        for (std::size_t i = 0; i < Arity; ++i) {
+            assert(fits(entry[order[i]]) && "value exceeds the domain of the index");
+            res[i] = static_cast<Domain>(entry[order[i]]);
+        }
+        return res;
+    }
+
+    Tuple decode(const Entry& entry) const {
+        Tuple res;
+        for (std::size_t i = 0; i < Arity; ++i) {
+            res[order[i]] = entry[i];
+        }
+        return res;
+    }
+
+    Tuple permute(const Tuple& entry) const {
+        Tuple res;
+        for (std::size_t i = 0; i < Arity; ++i) {
+            res[i] = entry[order[i]];
+        }
+        return res;
+    }
+
+    /**
+     * Converts a permuted bound of an ordered search into a bound of the stored
+     * domain, preceding exactly the same entries. A component beyond the domain
+     * is carried into the preceding ones.
+     *
+     * @return false if all entries precede the bound
+     */
+    bool encodeBound(const Tuple& bound, Entry& res) const {
+        for (std::size_t i = 0; i < Arity; ++i) {
+            if (bound[i] < std::numeric_limits<Domain>::min()) {
+                std::fill(&res[i], &res[0] + Arity, std::numeric_limits<Domain>::min());
+                return true;
+            }
+            if (bound[i] > std::numeric_limits<Domain>::max()) {
+                for (std::size_t j = i; j-- > 0;) {
+                    if (res[j] < std::numeric_limits<Domain>::max()) {
+                        ++res[j];
+                        std::fill(&res[j + 1], &res[0] + Arity, std::numeric_limits<Domain>::min());
+                        return true;
+                    }
+                }
+                return false;
+            }
+            res[i] = static_cast<Domain>(bound[i]);
+        }
+        return true;
+    }
+
+    // determines whether all values of a tuple are in the stored domain
+    bool fits(const Tuple& entry) const {
+        for (std::size_t i = 0; i < Arity; ++i) {
+            if (!fits(entry[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator==(const FixedOrder& other) const {
+        return order == other.order;
+    }
+
+private:
+    static bool fits(RamDomain value) {
+        return std::numeric_limits<Domain>::min() <= value && value <= std::numeric_limits<Domain>::max();
+    }
+};
+
+/**
+ * The natural order of the full domain, passing tuples through unchanged.
+ */
+template <std::size_t Arity>
+class FixedOrder<Arity, true, RamDomain> {
+public:
+    using Tuple = ram::Tuple<RamDomain, Arity>;
+    using Entry = Tuple;
+
+    FixedOrder(const Order& order) {
+        assert(order == Order::create(Arity));
+    }
+
+    const Entry& encode(const Tuple& entry) const {
+        return entry;
+    }
+
+    const Tuple& decode(const Entry& entry) const {
+        return entry;
+    }
+
+    const Tuple& permute(const Tuple& entry) const {
+        return entry;
+    }
+
+    bool encodeBound(const Tuple& bound, Entry& res) const {
+        res = bound;
+        return true;
+    }
+
+    bool fits(const Tuple& /* entry */) const {
+        return true;
+    }
+
+    bool operator==(const FixedOrder&) const {
+        return true;
+    }
+};
+
+/**
+ * Fills an empty data structure with the given entries, sorted in their natural order.
+ */
+template <typename Structure>
+void loadSorted(Structure& data, const std::vector<typename Structure::element_type>& entries) {
+    for (const auto& cur : entries) {
+        data.insert(cur);
+    }
+}
+
+/**
+ * B-trees are built bottom up from the sorted entries instead.
+ */
+template <typename Key, typename Comparator, typename Allocator, unsigned blockSize, typename SearchStrategy,
+        typename WeakComparator, typename Updater>
+void loadSorted(
+        btree_set<Key, Comparator, Allocator, blockSize, SearchStrategy, WeakComparator, Updater>& data,
+        const std::vector<Key>& entries) {
+    auto res = std::remove_reference<decltype(data)>::type::load(entries.begin(), entries.end());
+    data.swap(res);
+}
+
+/**
+ * Bries fill their levels from the sorted entries, group by group.
+ */
+template <unsigned Dim>
+void loadSorted(Trie<Dim>& data, const std::vector<typename Trie<Dim>::element_type>& entries) {
+    data.load(entries.begin(), entries.end());
+}
+
+/**
+ * Frozen sets take over the sorted entries as they are.
+ */
+template <unsigned N, typename Domain>
+void loadSorted(
+        FrozenSet<N, Domain>& data, const std::vector<typename FrozenSet<N, Domain>::element_type>& entries) {
+    data.load(entries);
+}
+
 /**
  * A generic data structure index adapter handling the boundary
  * level order conversion as well as iteration through nested
  * data structures.
  *
  * @tparam Structure the structure to be utilized
+ * @tparam Natural whether the index is kept in the natural order
  */
-template <typename Structure>
+template <typename Structure, bool Natural>
 class GenericIndex : public LVMIndex {
     using Entry = typename Structure::element_type;
     static constexpr int Arity = Entry::arity;
+    using Tuple = ram::Tuple<RamDomain, Arity>;
+    using IndexOrder = FixedOrder<Arity, Natural, typename Entry::value_type>;
 
     // the order to be simulated
-    Order order;
+    IndexOrder order;
 
+protected:
     // the internal data structure
     Structure data;
 
+private:
     // a source adapter for streaming through data
     class Source : public Stream::Source {
-        const Order& order;
+        const IndexOrder& order;
+
+        // the data structure streamed through
+        const Structure& data;
 
         // the begin and end of the stream
         using iter = typename Structure::iterator;
@@ -177,10 +392,11 @@ class GenericIndex : public LVMIndex {
         iter end;
 
         // an internal buffer for re-ordered elements
-        std::array<Entry, Stream::BUFFER_SIZE> buffer;
+        std::array<Tuple, Stream::BUFFER_SIZE> buffer;
 
     public:
-        Source(const Order& order, iter begin, iter end) : order(order), cur(begin), end(end) {}
+        Source(const IndexOrder& order, const Structure& data, iter begin, iter end)
+                : order(order), data(data), cur(begin), end(end) {}
 
         int load(TupleRef* out, int max) override {
             int c = 0;
@@ -194,10 +410,14 @@ class GenericIndex : public LVMIndex {
         }
 
         std::unique_ptr<Stream::Source> clone() override {
-            Source* source = new Source(order, cur, end);
+            Source* source = new Source(order, data, cur, end);
             source->buffer = this->buffer;
             return std::unique_ptr<Stream::Source>(source);
         }
+
+        long remaining() const override {
+            return countRange(data, cur, end, 0);
+        }
     };
 
 public:
@@ -215,28 +435,90 @@ public:
         return data.size();
     }
 
+    std::size_t getMemoryUsage() const override {
+        return sizeof(*this) - sizeof(data) + data.getMemoryUsage();
+    }
+
     bool insert(const TupleRef& tuple) override {
         return data.insert(order.encode(tuple.asTuple<Arity>()));
     }
 
     void insert(const LVMIndex& src) override {
-        // TODO: make smarter
+        // indices of the same kind and order are merged directly
+        auto* other = dynamic_cast<const GenericIndex*>(&src);
+        if (other != nullptr && other->order == order) {
+            data.insertAll(other->data);
+            return;
+        }
+        // an empty index is bulk-loaded from the sorted entries
+        if (data.empty()) {
+            std::vector<Entry> entries;
+            entries.reserve(src.size());
+            for (const auto& cur : src.scan()) {
+                entries.push_back(order.encode(cur.asTuple<Arity>()));
+            }
+            std::sort(entries.begin(), entries.end());
+            entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+            loadSorted(data, entries);
+            return;
+        }
         for (const auto& cur : src.scan()) {
             insert(cur);
         }
     }
 
     bool contains(const TupleRef& tuple) const override {
-        return data.contains(order.encode(tuple.asTuple<Arity>()));
+        return order.fits(tuple.asTuple<Arity>()) && data.contains(order.encode(tuple.asTuple<Arity>()));
+    }
+
+    bool fits(const TupleRef& tuple) const override {
+        return order.fits(tuple.asTuple<Arity>());
     }
 
     Stream scan() const override {
-        return std::make_unique<Source>(order, data.begin(), data.end());
+        return std::make_unique<Source>(order, data, data.begin(), data.end());
     }
 
     Stream range(const TupleRef& low, const TupleRef& high) const override {
-        Entry a = order.encode(low.asTuple<Arity>());
-        Entry b = order.encode(high.asTuple<Arity>());
+        auto bounds = getBounds(low, high);
+        return std::make_unique<Source>(order, data, bounds.first, bounds.second);
+    }
+
+    bool lowerBound(const TupleRef& low, RamDomain* res) const override {
+        Entry key;
+        if (!order.encodeBound(order.permute(low.asTuple<Arity>()), key)) {
+            return false;
+        }
+        auto pos = data.lower_bound(key);
+        if (pos == data.end()) {
+            return false;
+        }
+        Tuple entry = order.decode(*pos);
+        std::copy(&entry[0], &entry[0] + Arity, res);
+        return true;
+    }
+
+    std::vector<Stream> partitionScan(size_t partitionCount) const override {
+        return toStreams(getChunks(data, partitionCount, 0));
+    }
+
+    std::vector<Stream> partitionRange(
+            const TupleRef& low, const TupleRef& high, size_t partitionCount) const override {
+        auto bounds = getBounds(low, high);
+        return toStreams(souffle::range<iterator>(bounds.first, bounds.second).partition(partitionCount));
+    }
+
+    void clear() override {
+        data.clear();
+    }
+
+private:
+    using iterator = typename Structure::iterator;
+
+    // converts the given bounds into a pair of lower bounds in the internal order
+    std::pair<iterator, iterator> getBounds(const TupleRef& low, const TupleRef& high) const {
+        Tuple a = order.permute(low.asTuple<Arity>());
+        Tuple b = order.permute(high.asTuple<Arity>());
         // Transfer upper_bound to a equivalent lower bound
         bool fullIndexSearch = true;
         for (size_t i = Arity; i-- > 0;) {
@@ -251,11 +533,46 @@ public:
             }
         }
         assert(fullIndexSearch == false && "Full index search is not allowed in range query\n");
-        return std::make_unique<Source>(order, data.lower_bound(a), data.lower_bound(b));
+        Entry lowKey;
+        Entry highKey;
+        return std::make_pair(order.encodeBound(a, lowKey) ? data.lower_bound(lowKey) : data.end(),
+                order.encodeBound(b, highKey) ? data.lower_bound(highKey) : data.end());
     }
 
-    void clear() override {
-        data.clear();
+    // B-trees count the entries of a range without iterating through them
+    template <typename S>
+    static auto countRange(const S& data, const iterator& a, const iterator& b, int)
+            -> decltype(data.countRange(a, b), long()) {
+        return data.countRange(a, b);
+    }
+
+    // other structures leave the entries to be counted by iterating through them
+    template <typename S>
+    static long countRange(const S& /* data */, const iterator& /* a */, const iterator& /* b */, long) {
+        return -1;
+    }
+
+    // B-trees provide balanced chunks of their content
+    template <typename S>
+    static auto getChunks(const S& data, size_t n, int) -> decltype(data.getChunks(n)) {
+        return data.getChunks(n);
+    }
+
+    // tries partition their content along the top-level elements
+    template <typename S>
+    static auto getChunks(const S& data, size_t n, long) -> decltype(data.partition(n)) {
+        return data.partition(n);
+    }
+
+    // wraps each of the given sub-ranges into a stream
+    template <typename Ranges>
+    std::vector<Stream> toStreams(Ranges&& chunks) const {
+        std::vector<Stream> res;
+        res.reserve(chunks.size());
+        for (auto& cur : chunks) {
+            res.push_back(std::make_unique<Source>(order, data, cur.begin(), cur.end()));
+        }
+        return res;
     }
 };
 
@@ -300,7 +617,7 @@ public:
 
     class Source : public Stream::Source {
         // the begin and end of the stream
-        using iter = btree_multiset<TupleRef, comparator, std::allocator<TupleRef>, 512>::iterator;
+        using iter = btree_set<TupleRef, comparator, std::allocator<TupleRef>, 512>::iterator;
         iter cur;
         iter end;
 
@@ -328,12 +645,12 @@ public:
         }
     };
 
-    /* btree for storing tuple pointers with a given lexicographical order */
-    using index_set = btree_multiset<TupleRef, comparator, std::allocator<TupleRef>, 512>;
+    /* btree for storing tuple pointers with a given lexicographical order, which is a total one */
+    using index_set = btree_set<TupleRef, comparator, std::allocator<TupleRef>, 512>;
 
     IndirectIndex(std::vector<int> order)
             : theOrder(std::move(order)), set(comparator(theOrder), comparator(theOrder)),
-              arity(order.size()) {}
+              arity(theOrder.size()) {}
 
     size_t getArity() const override {
         return arity;
@@ -347,8 +664,13 @@ public:
         return set.size();
     }
 
+    std::size_t getMemoryUsage() const override {
+        return sizeof(*this) - sizeof(set) + set.getMemoryUsage();
+    }
+
     bool insert(const TupleRef& tuple) override {
-        return set.insert(tuple, operation_hints);
+        // the hints are private to the inserting thread
+        return set.insert(tuple);
     }
 
     void insert(const LVMIndex& src) override {
@@ -369,6 +691,33 @@ public:
         return std::make_unique<Source>(set.lower_bound(low), set.upper_bound(high));
     }
 
+    bool lowerBound(const TupleRef& low, RamDomain* res) const override {
+        auto pos = set.lower_bound(low);
+        if (pos == set.end()) {
+            return false;
+        }
+        std::copy((*pos).getBase(), (*pos).getBase() + arity, res);
+        return true;
+    }
+
+    std::vector<Stream> partitionScan(size_t partitionCount) const override {
+        std::vector<Stream> res;
+        for (const auto& cur : set.getChunks(partitionCount)) {
+            res.push_back(std::make_unique<Source>(cur.begin(), cur.end()));
+        }
+        return res;
+    }
+
+    std::vector<Stream> partitionRange(
+            const TupleRef& low, const TupleRef& high, size_t partitionCount) const override {
+        std::vector<Stream> res;
+        souffle::range<index_set::iterator> full(set.lower_bound(low), set.upper_bound(high));
+        for (const auto& cur : full.partition(partitionCount)) {
+            res.push_back(std::make_unique<Source>(cur.begin(), cur.end()));
+        }
+        return res;
+    }
+
     void clear() override {
         set.clear();
     }
@@ -380,9 +729,6 @@ private:
     /** set storing tuple pointers of table */
     index_set set;
 
-    /** Operation hints */
-    index_set::btree_operation_hints<1> operation_hints;
-
     /** Arity as the relation arity, not necessary the order size in indirect index */
     size_t arity;
 };
@@ -391,86 +737,961 @@ private:
 template <std::size_t Arity>
 using comparator = typename ram::index_utils::get_full_index<Arity>::type::comparator;
 
+// The B-tree of tuples in index order, searching the nodes of multi-column orders by normalised keys.
+template <typename Domain, std::size_t Arity>
+using btree_index_set = btree_set<ram::Tuple<Domain, Arity>, comparator<Arity>, btree_node_pool, 256,
+        ram::index_utils::btree_strategy<ram::Tuple<Domain, Arity>, Arity>>;
+
 /**
  * A index adapter for B-trees, using the generic index adapter.
  */
-template <std::size_t Arity>
-class BTreeIndex : public GenericIndex<btree_set<ram::Tuple<RamDomain, Arity>, comparator<Arity>>> {
+template <std::size_t Arity, bool Natural>
+class BTreeIndex : public GenericIndex<btree_index_set<RamDomain, Arity>, Natural> {
+public:
+    using GenericIndex<btree_index_set<RamDomain, Arity>, Natural>::GenericIndex;
+
+    void reset() override {
+        this->data.reset();
+    }
+};
+
+/**
+ * A index adapter for B-trees storing the values of the narrow domain, using the generic index adapter.
+ */
+template <std::size_t Arity, bool Natural>
+class NarrowBTreeIndex : public GenericIndex<btree_index_set<NarrowDomain, Arity>, Natural> {
 public:
-    using GenericIndex<btree_set<ram::Tuple<RamDomain, Arity>, comparator<Arity>>>::GenericIndex;
+    using GenericIndex<btree_index_set<NarrowDomain, Arity>, Natural>::GenericIndex;
+
+    void reset() override {
+        this->data.reset();
+    }
 };
 
 /**
  * A index adapter for Bries, using the generic index adapter.
  */
-template <std::size_t Arity>
-class BrieIndex : public GenericIndex<Trie<Arity>> {
+template <std::size_t Arity, bool Natural>
+class BrieIndex : public GenericIndex<Trie<Arity>, Natural> {
 public:
-    using GenericIndex<Trie<Arity>>::GenericIndex;
+    using GenericIndex<Trie<Arity>, Natural>::GenericIndex;
 };
 
-std::unique_ptr<LVMIndex> createBTreeIndex(const Order& order) {
-    switch (order.size()) {
-        case 0:
-            return std::make_unique<NullaryIndex>();
-        case 1:
-            return std::make_unique<BTreeIndex<1>>(order);
-        case 2:
-            return std::make_unique<BTreeIndex<2>>(order);
-        case 3:
-            return std::make_unique<BTreeIndex<3>>(order);
-        case 4:
-            return std::make_unique<BTreeIndex<4>>(order);
-        case 5:
-            return std::make_unique<BTreeIndex<5>>(order);
-        case 6:
-            return std::make_unique<BTreeIndex<6>>(order);
-        case 7:
-            return std::make_unique<BTreeIndex<7>>(order);
-        case 8:
-            return std::make_unique<BTreeIndex<8>>(order);
-        case 9:
-            return std::make_unique<BTreeIndex<9>>(order);
-        case 10:
-            return std::make_unique<BTreeIndex<10>>(order);
-        case 11:
-            return std::make_unique<BTreeIndex<11>>(order);
-        case 12:
-            return std::make_unique<BTreeIndex<12>>(order);
+/**
+ * A index adapter for delta-encoded sets, using the generic index adapter.
+ */
+template <std::size_t Arity, bool Natural>
+class CompressedIndex : public GenericIndex<CompressedSet<Arity>, Natural> {
+public:
+    using GenericIndex<CompressedSet<Arity>, Natural>::GenericIndex;
+};
+
+/**
+ * A index adapter for sets in memory-mapped files, using the generic index adapter.
+ */
+template <std::size_t Arity, bool Natural>
+class MappedIndex : public GenericIndex<MappedSet<Arity>, Natural> {
+public:
+    using GenericIndex<MappedSet<Arity>, Natural>::GenericIndex;
+};
+
+/**
+ * A index adapter for bitmap sets of pairs, using the generic index adapter.
+ */
+template <std::size_t Arity, bool Natural>
+class BitmapIndex : public GenericIndex<BitmapSet<Arity>, Natural> {
+public:
+    using GenericIndex<BitmapSet<Arity>, Natural>::GenericIndex;
+};
+
+/**
+ * A index adapter for sorted vectors, using the generic index adapter.
+ */
+template <std::size_t Arity, bool Natural>
+class VectorIndex : public GenericIndex<SortedVector<Arity>, Natural> {
+public:
+    using GenericIndex<SortedVector<Arity>, Natural>::GenericIndex;
+};
+
+/**
+ * A index adapter for frozen sets, using the generic index adapter.
+ */
+template <std::size_t Arity, bool Natural>
+class FrozenIndex : public GenericIndex<FrozenSet<Arity>, Natural> {
+public:
+    using GenericIndex<FrozenSet<Arity>, Natural>::GenericIndex;
+
+    bool hasConcurrentInsert() const override {
+        return false;
     }
-    assert(false && "Requested arity not yet supported. Feel free to add it.");
-}
+};
 
-std::unique_ptr<LVMIndex> createBrieIndex(const Order& order) {
-    switch (order.size()) {
-        case 0:
-            return std::make_unique<NullaryIndex>();
-        case 1:
-            return std::make_unique<BrieIndex<1>>(order);
-        case 2:
-            return std::make_unique<BrieIndex<2>>(order);
-        case 3:
-            return std::make_unique<BrieIndex<3>>(order);
-        case 4:
-            return std::make_unique<BrieIndex<4>>(order);
-        case 5:
-            return std::make_unique<BrieIndex<5>>(order);
-        case 6:
-            return std::make_unique<BrieIndex<6>>(order);
-        case 7:
-            return std::make_unique<BrieIndex<7>>(order);
-        case 8:
-            return std::make_unique<BrieIndex<8>>(order);
-        case 9:
-            return std::make_unique<BrieIndex<9>>(order);
-        case 10:
-            return std::make_unique<BrieIndex<10>>(order);
-        case 11:
-            return std::make_unique<BrieIndex<11>>(order);
-        case 12:
-            return std::make_unique<BrieIndex<12>>(order);
+/**
+ * A index adapter for frozen sets storing the values of the narrow domain, using the generic index adapter.
+ */
+template <std::size_t Arity, bool Natural>
+class NarrowFrozenIndex : public GenericIndex<FrozenSet<Arity, NarrowDomain>, Natural> {
+public:
+    using GenericIndex<FrozenSet<Arity, NarrowDomain>, Natural>::GenericIndex;
+
+    bool hasConcurrentInsert() const override {
+        return false;
     }
-    assert(false && "Requested arity not yet supported. Feel free to add it.");
+};
+
+/**
+ * A index adapter for hash sets, which support point lookups but no ordered
+ * access. Hence ranges are restricted to those binding all columns.
+ */
+template <std::size_t Arity, bool Natural>
+class HashIndex : public LVMIndex {
+    using Entry = typename HashSet<Arity>::element_type;
+    using IndexOrder = FixedOrder<Arity, Natural>;
+    using iterator = typename HashSet<Arity>::iterator;
+
+    // the order to be simulated
+    IndexOrder order;
+
+    // the internal data structure
+    HashSet<Arity> data;
+
+    // a source adapter for streaming through data
+    class Source : public Stream::Source {
+        const IndexOrder& order;
+
+        // the begin and end of the stream
+        iterator cur;
+        iterator end;
+
+        // an internal buffer for re-ordered elements
+        std::array<Entry, Stream::BUFFER_SIZE> buffer;
+
+    public:
+        Source(const IndexOrder& order, iterator begin, iterator end) : order(order), cur(begin), end(end) {}
+
+        int load(TupleRef* out, int max) override {
+            int c = 0;
+            while (cur != end && c < max) {
+                buffer[c] = order.decode(*cur);
+                out[c] = buffer[c];
+                ++cur;
+                ++c;
+            }
+            return c;
+        }
+
+        std::unique_ptr<Stream::Source> clone() override {
+            Source* source = new Source(order, cur, end);
+            source->buffer = this->buffer;
+            return std::unique_ptr<Stream::Source>(source);
+        }
+    };
+
+public:
+    HashIndex(const Order& order) : order(order) {}
+
+    size_t getArity() const override {
+        return Arity;
+    }
+
+    bool empty() const override {
+        return data.empty();
+    }
+
+    std::size_t size() const override {
+        return data.size();
+    }
+
+    std::size_t getMemoryUsage() const override {
+        return sizeof(*this) - sizeof(data) + data.getMemoryUsage();
+    }
+
+    bool insert(const TupleRef& tuple) override {
+        return data.insert(order.encode(tuple.asTuple<Arity>()));
+    }
+
+    void insert(const LVMIndex& src) override {
+        // indices of the same kind and order are merged directly
+        auto* other = dynamic_cast<const HashIndex*>(&src);
+        if (other != nullptr && other->order == order) {
+            data.insertAll(other->data);
+            return;
+        }
+        for (const auto& cur : src.scan()) {
+            insert(cur);
+        }
+    }
+
+    bool contains(const TupleRef& tuple) const override {
+        return data.contains(order.encode(tuple.asTuple<Arity>()));
+    }
+
+    Stream scan() const override {
+        return std::make_unique<Source>(order, data.begin(), data.end());
+    }
+
+    Stream range(const TupleRef& low, const TupleRef& high) const override {
+        auto pos = find(low, high);
+        return std::make_unique<Source>(order, pos, (pos == data.end()) ? pos : std::next(pos));
+    }
+
+    bool lowerBound(const TupleRef& low, RamDomain* res) const override {
+        assert(false && "Hash indexes do not support ordered access\n");
+        return false;
+    }
+
+    std::vector<Stream> partitionScan(size_t partitionCount) const override {
+        std::vector<Stream> res;
+        for (const auto& cur : data.partition(partitionCount)) {
+            res.push_back(std::make_unique<Source>(order, cur.begin(), cur.end()));
+        }
+        return res;
+    }
+
+    std::vector<Stream> partitionRange(
+            const TupleRef& low, const TupleRef& high, size_t /* partitionCount */) const override {
+        std::vector<Stream> res;
+        res.push_back(range(low, high));
+        return res;
+    }
+
+    void clear() override {
+        data.clear();
+    }
+
+private:
+    // locates the single tuple covered by the given bounds
+    iterator find(const TupleRef& low, const TupleRef& high) const {
+        Entry a = order.encode(low.asTuple<Arity>());
+        assert(a == order.encode(high.asTuple<Arity>()) && "Hash indexes only support point lookups\n");
+        return data.find(a);
+    }
+};
+
+/**
+ * The equivalence classes of an equivalence relation, shared by all of its indexes.
+ *
+ * Pairs are added by unions of the classes, which may be conducted concurrently. Reads
+ * iterate through a sorted list of all pairs of the relation, which is regenerated from
+ * the classes on the first read following an insertion.
+ */
+class EqrelStore {
+public:
+    using Tuple = ram::Tuple<RamDomain, 2>;
+
+    bool insert(RamDomain a, RamDomain b) {
+        if (classes.contains(a, b)) {
+            return false;
+        }
+        classes.insert(a, b);
+        markStale();
+        return true;
+    }
+
+    bool contains(RamDomain a, RamDomain b) const {
+        return classes.contains(a, b);
+    }
+
+    // adds the pairs implied by combining the classes with the old ones of the given store
+    void extend(const EqrelStore& old) {
+        classes.extend(old.classes);
+        markStale();
+    }
+
+    // obtains all pairs in lexicographical order
+    const std::vector<Tuple>& getPairs() const {
+        if (stale.load(std::memory_order_acquire)) {
+            auto lease = lock.acquire();
+            (void)lease;
+            if (stale.load(std::memory_order_relaxed)) {
+                pairs.clear();
+                pairs.reserve(classes.size());
+                for (const auto& cur : classes) {
+                    pairs.push_back(cur);
+                }
+                std::sort(pairs.begin(), pairs.end());
+                stale.store(false, std::memory_order_release);
+            }
+        }
+        return pairs;
+    }
+
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) + pairs.capacity() * sizeof(Tuple);
+    }
+
+    void clear() {
+        classes.clear();
+        std::vector<Tuple>().swap(pairs);
+        stale.store(false, std::memory_order_relaxed);
+    }
+
+private:
+    void markStale() {
+        if (!stale.load(std::memory_order_relaxed)) {
+            stale.store(true, std::memory_order_release);
+        }
+    }
+
+    // the equivalence classes
+    EquivalenceRelation<Tuple> classes;
+
+    // the sorted pairs of the classes, valid unless marked stale
+    mutable std::vector<Tuple> pairs;
+    mutable std::atomic<bool> stale{false};
+
+    // a lock serialising the regeneration of the pairs
+    mutable Lock lock;
+};
+
+/**
+ * An index of a binary equivalence relation in one of its two orders.
+ *
+ * As the relation is symmetric, the pairs in the order (1,0) are the pairs in the natural
+ * order with their elements swapped, hence both orders list the sorted pairs of the shared
+ * store and differ only in how their entries are decoded.
+ */
+class EqrelIndex : public LVMIndex {
+    using Tuple = EqrelStore::Tuple;
+    using iterator = std::vector<Tuple>::const_iterator;
+
+    // the classes shared with the indexes of the other order
+    std::shared_ptr<EqrelStore> store;
+
+    // whether this index lists the pairs in the order (1,0)
+    bool swapped;
+
+    // a source adapter for streaming through the pairs
+    class Source : public Stream::Source {
+        iterator cur;
+        iterator end;
+        bool swapped;
+
+        // an internal buffer for decoded pairs
+        std::array<Tuple, Stream::BUFFER_SIZE> buffer;
+
+    public:
+        Source(iterator begin, iterator end, bool swapped) : cur(begin), end(end), swapped(swapped) {}
+
+        int load(TupleRef* out, int max) override {
+            int c = 0;
+            while (cur != end && c < max) {
+                buffer[c] = swapped ? Tuple({{(*cur)[1], (*cur)[0]}}) : *cur;
+                out[c] = buffer[c];
+                ++cur;
+                ++c;
+            }
+            return c;
+        }
+
+        std::unique_ptr<Stream::Source> clone() override {
+            Source* source = new Source(cur, end, swapped);
+            source->buffer = this->buffer;
+            return std::unique_ptr<Stream::Source>(source);
+        }
+
+        long remaining() const override {
+            return end - cur;
+        }
+    };
+
+public:
+    EqrelIndex(const Order& order, std::shared_ptr<EqrelStore> store)
+            : store(std::move(store)), swapped(order.getOrder()[0] == 1) {
+        assert(order.size() == 2 && "Equivalence relations are binary\n");
+    }
+
+    const std::shared_ptr<EqrelStore>& getStore() const {
+        return store;
+    }
+
+    size_t getArity() const override {
+        return 2;
+    }
+
+    bool empty() const override {
+        return store->getPairs().empty();
+    }
+
+    std::size_t size() const override {
+        return store->getPairs().size();
+    }
+
+    std::size_t getMemoryUsage() const override {
+        // the shared store is accounted for by the index in the natural order
+        return swapped ? sizeof(*this) : sizeof(*this) + store->getMemoryUsage();
+    }
+
+    bool insert(const TupleRef& tuple) override {
+        return store->insert(tuple[0], tuple[1]);
+    }
+
+    void insert(const LVMIndex& src) override {
+        // an index sharing the classes of this one holds nothing new
+        auto* other = dynamic_cast<const EqrelIndex*>(&src);
+        if (other != nullptr && other->store == store) {
+            return;
+        }
+        for (const auto& cur : src.scan()) {
+            insert(cur);
+        }
+    }
+
+    bool contains(const TupleRef& tuple) const override {
+        return store->contains(tuple[0], tuple[1]);
+    }
+
+    bool fits(const TupleRef& /* tuple */) const override {
+        return true;
+    }
+
+    Stream scan() const override {
+        const auto& pairs = store->getPairs();
+        return std::make_unique<Source>(pairs.begin(), pairs.end(), swapped);
+    }
+
+    Stream range(const TupleRef& low, const TupleRef& high) const override {
+        auto bounds = getBounds(low, high);
+        return std::make_unique<Source>(bounds.first, bounds.second, swapped);
+    }
+
+    bool lowerBound(const TupleRef& low, RamDomain* res) const override {
+        const auto& pairs = store->getPairs();
+        auto pos = std::lower_bound(pairs.begin(), pairs.end(), permute(low));
+        if (pos == pairs.end()) {
+            return false;
+        }
+        res[0] = (*pos)[swapped ? 1 : 0];
+        res[1] = (*pos)[swapped ? 0 : 1];
+        return true;
+    }
+
+    std::vector<Stream> partitionScan(size_t partitionCount) const override {
+        const auto& pairs = store->getPairs();
+        return toStreams(souffle::range<iterator>(pairs.begin(), pairs.end()).partition(partitionCount));
+    }
+
+    std::vector<Stream> partitionRange(
+            const TupleRef& low, const TupleRef& high, size_t partitionCount) const override {
+        auto bounds = getBounds(low, high);
+        return toStreams(souffle::range<iterator>(bounds.first, bounds.second).partition(partitionCount));
+    }
+
+    void clear() override {
+        store->clear();
+    }
+
+private:
+    // converts the given tuple into an entry of this index
+    Tuple permute(const TupleRef& tuple) const {
+        return swapped ? Tuple({{tuple[1], tuple[0]}}) : Tuple({{tuple[0], tuple[1]}});
+    }
+
+    // converts the given bounds into a pair of lower bounds in the order of this index
+    std::pair<iterator, iterator> getBounds(const TupleRef& low, const TupleRef& high) const {
+        Tuple a = permute(low);
+        Tuple b = permute(high);
+        // Transfer upper_bound to a equivalent lower bound
+        bool fullIndexSearch = true;
+        for (size_t i = 2; i-- > 0;) {
+            if (a[i] == MIN_RAM_DOMAIN && b[i] == MAX_RAM_DOMAIN) {
+                b[i] = MIN_RAM_DOMAIN;
+                continue;
+            }
+            if (a[i] == b[i]) {
+                b[i] += 1;
+                fullIndexSearch = false;
+                break;
+            }
+        }
+        assert(fullIndexSearch == false && "Full index search is not allowed in range query\n");
+        const auto& pairs = store->getPairs();
+        return std::make_pair(std::lower_bound(pairs.begin(), pairs.end(), a),
+                std::lower_bound(pairs.begin(), pairs.end(), b));
+    }
+
+    // wraps each of the given sub-ranges into a stream
+    std::vector<Stream> toStreams(const std::vector<souffle::range<iterator>>& chunks) const {
+        std::vector<Stream> res;
+        res.reserve(chunks.size());
+        for (const auto& cur : chunks) {
+            res.push_back(std::make_unique<Source>(cur.begin(), cur.end(), swapped));
+        }
+        return res;
+    }
+};
+
+/**
+ * An index presenting the storage of a relation, created by a registered storage provider.
+ * The indexes of the other orders of the relation are views of the storage of its main
+ * index, leaving inserts and clears to the main index. The storage delivers the tuples in
+ * an order of its own, such that ranges are only searched as sets of tuples.
+ */
+class StorageIndex : public LVMIndex {
+    // the storage shared by the indexes of the relation
+    std::shared_ptr<RelationStorage> storage;
+
+    std::size_t arity;
+
+    // whether this index is a view of the storage of another one
+    bool view;
+
+    // a source adapter for streaming through the tuples delivered by a cursor
+    class Source : public Stream::Source {
+        std::unique_ptr<StorageCursor> cursor;
+        std::size_t arity;
+
+        // an internal buffer for the delivered tuples, which are only valid until the next one
+        std::vector<RamDomain> buffer;
+
+    public:
+        Source(std::unique_ptr<StorageCursor> cursor, std::size_t arity)
+                : cursor(std::move(cursor)), arity(arity), buffer(Stream::BUFFER_SIZE * arity) {}
+
+        int load(TupleRef* out, int max) override {
+            int c = 0;
+            while (c < max) {
+                const RamDomain* tuple = cursor->next();
+                if (tuple == nullptr) {
+                    break;
+                }
+                RamDomain* trg = &buffer[c * arity];
+                std::copy(tuple, tuple + arity, trg);
+                out[c] = TupleRef(trg, arity);
+                ++c;
+            }
+            return c;
+        }
+
+        std::unique_ptr<Stream::Source> clone() override {
+            auto source = std::make_unique<Source>(cursor->clone(), arity);
+            source->buffer = this->buffer;
+            return std::move(source);
+        }
+    };
+
+public:
+    StorageIndex(std::shared_ptr<RelationStorage> storage, std::size_t arity, bool view)
+            : storage(std::move(storage)), arity(arity), view(view) {}
+
+    size_t getArity() const override {
+        return arity;
+    }
+
+    bool empty() const override {
+        return storage->size() == 0;
+    }
+
+    std::size_t size() const override {
+        return storage->size();
+    }
+
+    std::size_t getMemoryUsage() const override {
+        // the storage is accounted to the main index
+        return sizeof(*this) + (view ? 0 : storage->getMemoryUsage());
+    }
+
+    bool insert(const TupleRef& tuple) override {
+        return !view && storage->insert(tuple.getBase());
+    }
+
+    void insert(const LVMIndex& src) override {
+        auto* other = dynamic_cast<const StorageIndex*>(&src);
+        if (view || (other != nullptr && other->storage == storage)) {
+            return;
+        }
+        for (const auto& cur : src.scan()) {
+            storage->insert(cur.getBase());
+        }
+    }
+
+    bool hasConcurrentInsert() const override {
+        return false;
+    }
+
+    bool contains(const TupleRef& tuple) const override {
+        return storage->contains(tuple.getBase());
+    }
+
+    Stream scan() const override {
+        return std::make_unique<Source>(storage->scan(), arity);
+    }
+
+    Stream range(const TupleRef& low, const TupleRef& high) const override {
+        // the columns bounded by the search are those whose bounds are not the extremes of the domain
+        SearchSignature columns = 0;
+        for (std::size_t i = 0; i < arity; ++i) {
+            if (low[i] != MIN_RAM_DOMAIN || high[i] != MAX_RAM_DOMAIN) {
+                columns |= SearchSignature(1) << i;
+            }
+        }
+        return std::make_unique<Source>(storage->range(columns, low.getBase(), high.getBase()), arity);
+    }
+
+    bool lowerBound(const TupleRef& low, RamDomain* res) const override {
+        assert(false && "Storage indexes do not support ordered access\n");
+        return false;
+    }
+
+    std::vector<Stream> partitionScan(size_t partitionCount) const override {
+        std::vector<Stream> res;
+        for (auto& cursor : storage->partition(partitionCount)) {
+            res.push_back(std::make_unique<Source>(std::move(cursor), arity));
+        }
+        return res;
+    }
+
+    std::vector<Stream> partitionRange(
+            const TupleRef& low, const TupleRef& high, size_t /* partitionCount */) const override {
+        std::vector<Stream> res;
+        res.push_back(range(low, high));
+        return res;
+    }
+
+    void clear() override {
+        if (!view) {
+            storage->clear();
+        }
+    }
+
+    const std::shared_ptr<RelationStorage>& getStorage() const {
+        return storage;
+    }
+};
+
+/**
+ * Creates an index of the given kind and arity, specialised for the
+ * natural order if the requested order is the natural one.
+ */
+template <template <std::size_t, bool> class Index, std::size_t Arity>
+std::unique_ptr<LVMIndex> createIndex(const Order& order) {
+    if (order == Order::create(Arity)) {
+        return std::make_unique<Index<Arity, true>>(order);
+    }
+    return std::make_unique<Index<Arity, false>>(order);
+}
+
+std::unique_ptr<LVMIndex> createBTreeIndex(const Order& order) {
+    switch (order.size()) {
+        case 0:
+            return std::make_unique<NullaryIndex>();
+        case 1:
+            return createIndex<BTreeIndex, 1>(order);
+        case 2:
+            return createIndex<BTreeIndex, 2>(order);
+        case 3:
+            return createIndex<BTreeIndex, 3>(order);
+        case 4:
+            return createIndex<BTreeIndex, 4>(order);
+        case 5:
+            return createIndex<BTreeIndex, 5>(order);
+        case 6:
+            return createIndex<BTreeIndex, 6>(order);
+        case 7:
+            return createIndex<BTreeIndex, 7>(order);
+        case 8:
+            return createIndex<BTreeIndex, 8>(order);
+        case 9:
+            return createIndex<BTreeIndex, 9>(order);
+        case 10:
+            return createIndex<BTreeIndex, 10>(order);
+        case 11:
+            return createIndex<BTreeIndex, 11>(order);
+        case 12:
+            return createIndex<BTreeIndex, 12>(order);
+    }
+    assert(false && "Requested arity not yet supported. Feel free to add it.");
+}
+
+std::unique_ptr<LVMIndex> createNarrowBTreeIndex(const Order& order) {
+    switch (order.size()) {
+        case 0:
+            return std::make_unique<NullaryIndex>();
+        case 1:
+            return createIndex<NarrowBTreeIndex, 1>(order);
+        case 2:
+            return createIndex<NarrowBTreeIndex, 2>(order);
+        case 3:
+            return createIndex<NarrowBTreeIndex, 3>(order);
+        case 4:
+            return createIndex<NarrowBTreeIndex, 4>(order);
+        case 5:
+            return createIndex<NarrowBTreeIndex, 5>(order);
+        case 6:
+            return createIndex<NarrowBTreeIndex, 6>(order);
+        case 7:
+            return createIndex<NarrowBTreeIndex, 7>(order);
+        case 8:
+            return createIndex<NarrowBTreeIndex, 8>(order);
+        case 9:
+            return createIndex<NarrowBTreeIndex, 9>(order);
+        case 10:
+            return createIndex<NarrowBTreeIndex, 10>(order);
+        case 11:
+            return createIndex<NarrowBTreeIndex, 11>(order);
+        case 12:
+            return createIndex<NarrowBTreeIndex, 12>(order);
+    }
+    assert(false && "Requested arity not yet supported. Feel free to add it.");
+}
+
+std::unique_ptr<LVMIndex> createBrieIndex(const Order& order) {
+    switch (order.size()) {
+        case 0:
+            return std::make_unique<NullaryIndex>();
+        case 1:
+            return createIndex<BrieIndex, 1>(order);
+        case 2:
+            return createIndex<BrieIndex, 2>(order);
+        case 3:
+            return createIndex<BrieIndex, 3>(order);
+        case 4:
+            return createIndex<BrieIndex, 4>(order);
+        case 5:
+            return createIndex<BrieIndex, 5>(order);
+        case 6:
+            return createIndex<BrieIndex, 6>(order);
+        case 7:
+            return createIndex<BrieIndex, 7>(order);
+        case 8:
+            return createIndex<BrieIndex, 8>(order);
+        case 9:
+            return createIndex<BrieIndex, 9>(order);
+        case 10:
+            return createIndex<BrieIndex, 10>(order);
+        case 11:
+            return createIndex<BrieIndex, 11>(order);
+        case 12:
+            return createIndex<BrieIndex, 12>(order);
+    }
+    assert(false && "Requested arity not yet supported. Feel free to add it.");
+}
+
+std::unique_ptr<LVMIndex> createCompressedIndex(const Order& order) {
+    switch (order.size()) {
+        case 0:
+            return std::make_unique<NullaryIndex>();
+        case 1:
+            return createIndex<CompressedIndex, 1>(order);
+        case 2:
+            return createIndex<CompressedIndex, 2>(order);
+        case 3:
+            return createIndex<CompressedIndex, 3>(order);
+        case 4:
+            return createIndex<CompressedIndex, 4>(order);
+        case 5:
+            return createIndex<CompressedIndex, 5>(order);
+        case 6:
+            return createIndex<CompressedIndex, 6>(order);
+        case 7:
+            return createIndex<CompressedIndex, 7>(order);
+        case 8:
+            return createIndex<CompressedIndex, 8>(order);
+        case 9:
+            return createIndex<CompressedIndex, 9>(order);
+        case 10:
+            return createIndex<CompressedIndex, 10>(order);
+        case 11:
+            return createIndex<CompressedIndex, 11>(order);
+        case 12:
+            return createIndex<CompressedIndex, 12>(order);
+    }
+    assert(false && "Requested arity not yet supported. Feel free to add it.");
+}
+
+std::unique_ptr<LVMIndex> createMappedIndex(const Order& order) {
+    switch (order.size()) {
+        case 0:
+            return std::make_unique<NullaryIndex>();
+        case 1:
+            return createIndex<MappedIndex, 1>(order);
+        case 2:
+            return createIndex<MappedIndex, 2>(order);
+        case 3:
+            return createIndex<MappedIndex, 3>(order);
+        case 4:
+            return createIndex<MappedIndex, 4>(order);
+        case 5:
+            return createIndex<MappedIndex, 5>(order);
+        case 6:
+            return createIndex<MappedIndex, 6>(order);
+        case 7:
+            return createIndex<MappedIndex, 7>(order);
+        case 8:
+            return createIndex<MappedIndex, 8>(order);
+        case 9:
+            return createIndex<MappedIndex, 9>(order);
+        case 10:
+            return createIndex<MappedIndex, 10>(order);
+        case 11:
+            return createIndex<MappedIndex, 11>(order);
+        case 12:
+            return createIndex<MappedIndex, 12>(order);
+    }
+    assert(false && "Requested arity not yet supported. Feel free to add it.");
+}
+
+std::unique_ptr<LVMIndex> createBitmapIndex(const Order& order) {
+    // bitmap sets only store pairs, other arities are left to the brie
+    if (order.size() == 2) {
+        return createIndex<BitmapIndex, 2>(order);
+    }
+    return createBrieIndex(order);
+}
+
+std::unique_ptr<LVMIndex> createHashIndex(const Order& order) {
+    switch (order.size()) {
+        case 0:
+            return std::make_unique<NullaryIndex>();
+        case 1:
+            return createIndex<HashIndex, 1>(order);
+        case 2:
+            return createIndex<HashIndex, 2>(order);
+        case 3:
+            return createIndex<HashIndex, 3>(order);
+        case 4:
+            return createIndex<HashIndex, 4>(order);
+        case 5:
+            return createIndex<HashIndex, 5>(order);
+        case 6:
+            return createIndex<HashIndex, 6>(order);
+        case 7:
+            return createIndex<HashIndex, 7>(order);
+        case 8:
+            return createIndex<HashIndex, 8>(order);
+        case 9:
+            return createIndex<HashIndex, 9>(order);
+        case 10:
+            return createIndex<HashIndex, 10>(order);
+        case 11:
+            return createIndex<HashIndex, 11>(order);
+        case 12:
+            return createIndex<HashIndex, 12>(order);
+    }
+    assert(false && "Requested arity not yet supported. Feel free to add it.");
+}
+
+std::unique_ptr<LVMIndex> createVectorIndex(const Order& order) {
+    switch (order.size()) {
+        case 0:
+            return std::make_unique<NullaryIndex>();
+        case 1:
+            return createIndex<VectorIndex, 1>(order);
+        case 2:
+            return createIndex<VectorIndex, 2>(order);
+        case 3:
+            return createIndex<VectorIndex, 3>(order);
+        case 4:
+            return createIndex<VectorIndex, 4>(order);
+        case 5:
+            return createIndex<VectorIndex, 5>(order);
+        case 6:
+            return createIndex<VectorIndex, 6>(order);
+        case 7:
+            return createIndex<VectorIndex, 7>(order);
+        case 8:
+            return createIndex<VectorIndex, 8>(order);
+        case 9:
+            return createIndex<VectorIndex, 9>(order);
+        case 10:
+            return createIndex<VectorIndex, 10>(order);
+        case 11:
+            return createIndex<VectorIndex, 11>(order);
+        case 12:
+            return createIndex<VectorIndex, 12>(order);
+    }
+    assert(false && "Requested arity not yet supported. Feel free to add it.");
+}
+
+std::unique_ptr<LVMIndex> createFrozenIndex(const Order& order) {
+    switch (order.size()) {
+        case 0:
+            return std::make_unique<NullaryIndex>();
+        case 1:
+            return createIndex<FrozenIndex, 1>(order);
+        case 2:
+            return createIndex<FrozenIndex, 2>(order);
+        case 3:
+            return createIndex<FrozenIndex, 3>(order);
+        case 4:
+            return createIndex<FrozenIndex, 4>(order);
+        case 5:
+            return createIndex<FrozenIndex, 5>(order);
+        case 6:
+            return createIndex<FrozenIndex, 6>(order);
+        case 7:
+            return createIndex<FrozenIndex, 7>(order);
+        case 8:
+            return createIndex<FrozenIndex, 8>(order);
+        case 9:
+            return createIndex<FrozenIndex, 9>(order);
+        case 10:
+            return createIndex<FrozenIndex, 10>(order);
+        case 11:
+            return createIndex<FrozenIndex, 11>(order);
+        case 12:
+            return createIndex<FrozenIndex, 12>(order);
+    }
+    assert(false && "Requested arity not yet supported. Feel free to add it.");
+}
+
+std::unique_ptr<LVMIndex> createNarrowFrozenIndex(const Order& order) {
+    switch (order.size()) {
+        case 0:
+            return std::make_unique<NullaryIndex>();
+        case 1:
+            return createIndex<NarrowFrozenIndex, 1>(order);
+        case 2:
+            return createIndex<NarrowFrozenIndex, 2>(order);
+        case 3:
+            return createIndex<NarrowFrozenIndex, 3>(order);
+        case 4:
+            return createIndex<NarrowFrozenIndex, 4>(order);
+        case 5:
+            return createIndex<NarrowFrozenIndex, 5>(order);
+        case 6:
+            return createIndex<NarrowFrozenIndex, 6>(order);
+        case 7:
+            return createIndex<NarrowFrozenIndex, 7>(order);
+        case 8:
+            return createIndex<NarrowFrozenIndex, 8>(order);
+        case 9:
+            return createIndex<NarrowFrozenIndex, 9>(order);
+        case 10:
+            return createIndex<NarrowFrozenIndex, 10>(order);
+        case 11:
+            return createIndex<NarrowFrozenIndex, 11>(order);
+        case 12:
+            return createIndex<NarrowFrozenIndex, 12>(order);
+    }
+    assert(false && "Requested arity not yet supported. Feel free to add it.");
+}
+
+std::unique_ptr<LVMIndex> createEqrelIndex(const Order& order) {
+    return std::make_unique<EqrelIndex>(order, std::make_shared<EqrelStore>());
+}
+
+std::unique_ptr<LVMIndex> createEqrelIndex(const Order& order, const LVMIndex& shared) {
+    auto* index = dynamic_cast<const EqrelIndex*>(&shared);
+    assert(index != nullptr && "Indexes of equivalence relations share the classes of other ones\n");
+    return std::make_unique<EqrelIndex>(order, index->getStore());
+}
+
+void extendEqrelIndex(LVMIndex& index, const LVMIndex& old) {
+    auto* target = dynamic_cast<EqrelIndex*>(&index);
+    auto* source = dynamic_cast<const EqrelIndex*>(&old);
+    assert(target != nullptr && source != nullptr && "Only equivalence relations can be extended\n");
+    target->getStore()->extend(*source->getStore());
+}
+
+std::unique_ptr<LVMIndex> createStorageIndex(const Order& order, std::shared_ptr<RelationStorage> storage) {
+    return std::make_unique<StorageIndex>(std::move(storage), order.size(), false);
+}
+
+std::unique_ptr<LVMIndex> createStorageIndex(const Order& order, const LVMIndex& shared) {
+    auto* index = dynamic_cast<const StorageIndex*>(&shared);
+    assert(index != nullptr && "Indexes of stored relations present the storage of other ones\n");
+    return std::make_unique<StorageIndex>(index->getStorage(), order.size(), true);
 }
 
 std::unique_ptr<LVMIndex> createIndirectIndex(const Order& order) {
@@ -19,8 +19,10 @@
 #include "CompiledTuple.h"
 #include "ParallelUtils.h"
 #include "RamTypes.h"
+#include "StorageProvider.h"
 #include "Util.h"
 
+#include <algorithm>
 #include <array>
 #include <deque>
 #include <map>
@@ -207,6 +209,16 @@ public:
          * Clone a source with the exact same state
          */
         virtual std::unique_ptr<Source> clone() = 0;
+
+        /**
+         * Determines the number of elements left to be retrieved, if the
+         * source can do so without retrieving them.
+         *
+         * @return the number of elements left, -1 if unknown.
+         */
+        virtual long remaining() const {
+            return -1;
+        }
     };
 
 private:
@@ -297,6 +309,43 @@ public:
         }
     };
 
+    /**
+     * Obtains the base addresses of the next elements, at most the given
+     * number of them. Elements are only loaded from the source once all
+     * buffered ones have been obtained, so the obtained elements stay valid
+     * until the next call.
+     *
+     * @return the number of elements obtained, 0 if end has been reached.
+     */
+    int fetch(const RamDomain** trg, int max) {
+        if (cur >= limit) {
+            if (source == nullptr) {
+                return 0;
+            }
+            loadNext();
+        }
+        int count = std::min(max, limit - cur);
+        for (int i = 0; i < count; ++i) {
+            trg[i] = buffer[cur + i].getBase();
+        }
+        cur += count;
+        return count;
+    }
+
+    /**
+     * Determines the number of elements left in this stream, if its source
+     * can count them without retrieving them.
+     *
+     * @return the number of elements left, -1 if unknown.
+     */
+    long remaining() const {
+        if (source == nullptr) {
+            return limit - cur;
+        }
+        long rest = source->remaining();
+        return (rest < 0) ? -1 : limit - cur + rest;
+    }
+
     // support for ranged based for loops
     Iterator begin() {
         return *this;
@@ -337,6 +386,11 @@ public:
      */
     virtual std::size_t size() const = 0;
 
+    /**
+     * Obtains an estimate of the number of bytes occupied by this index.
+     */
+    virtual std::size_t getMemoryUsage() const = 0;
+
     /**
      * Inserts a tuple into this index.
      */
@@ -347,11 +401,26 @@ public:
      */
     virtual void insert(const LVMIndex& src) = 0;
 
+    /**
+     * Determines whether tuples may be inserted into this index by several threads at once.
+     * Read operations may never be conducted concurrently with insertions.
+     */
+    virtual bool hasConcurrentInsert() const {
+        return true;
+    }
+
     /**
      * Tests whether the given tuple is present in this index or not.
      */
     virtual bool contains(const TupleRef& tuple) const = 0;
 
+    /**
+     * Tests whether the values of the given tuple can be stored in this index.
+     */
+    virtual bool fits(const TupleRef& /* tuple */) const {
+        return true;
+    }
+
     /**
      * Returns a stream covering the entire index content.
      */
@@ -362,10 +431,39 @@ public:
      */
     virtual Stream range(const TupleRef& low, const TupleRef& high) const = 0;
 
+    /**
+     * Locates the least element not less than the given tuple in the order of
+     * this index, writing its components in the natural order into the given
+     * buffer of getArity() values.
+     *
+     * @return false if there is no such element
+     */
+    virtual bool lowerBound(const TupleRef& low, RamDomain* res) const = 0;
+
+    /**
+     * Returns a list of streams partitioning the entire index content, to be
+     * processed independently by parallel workers.
+     */
+    virtual std::vector<Stream> partitionScan(size_t partitionCount) const = 0;
+
+    /**
+     * Returns a list of streams partitioning the elements covered by the given range.
+     */
+    virtual std::vector<Stream> partitionRange(
+            const TupleRef& low, const TupleRef& high, size_t partitionCount) const = 0;
+
     /**
      * Clears the content of this index, turning it empty.
      */
     virtual void clear() = 0;
+
+    /**
+     * Clears the content of this index, keeping its memory for the elements inserted next
+     * where the data structure supports it.
+     */
+    virtual void reset() {
+        clear();
+    }
 };
 
 // The type of index factory functions.
@@ -374,9 +472,52 @@ using IndexFactory = std::unique_ptr<LVMIndex> (*)(const Order&);
 // A factory for BTree based index.
 std::unique_ptr<LVMIndex> createBTreeIndex(const Order&);
 
+// The domain of the values stored by narrow indexes.
+using NarrowDomain = int32_t;
+
+// A factory for BTree based index storing the values of the narrow domain.
+std::unique_ptr<LVMIndex> createNarrowBTreeIndex(const Order&);
+
 // A factory for Brie based index.
 std::unique_ptr<LVMIndex> createBrieIndex(const Order&);
 
+// A factory for delta-encoded index.
+std::unique_ptr<LVMIndex> createCompressedIndex(const Order&);
+
+// A factory for memory-mapped index.
+std::unique_ptr<LVMIndex> createMappedIndex(const Order&);
+
+// A factory for bitmap index of pairs.
+std::unique_ptr<LVMIndex> createBitmapIndex(const Order&);
+
+// A factory for hash based index, supporting point lookups only.
+std::unique_ptr<LVMIndex> createHashIndex(const Order&);
+
+// A factory for sorted vector based index, for tuples inserted before any is read.
+std::unique_ptr<LVMIndex> createVectorIndex(const Order&);
+
+// A factory for read-optimised index, for relations that are complete.
+std::unique_ptr<LVMIndex> createFrozenIndex(const Order&);
+
+// A factory for read-optimised index storing the values of the narrow domain.
+std::unique_ptr<LVMIndex> createNarrowFrozenIndex(const Order&);
+
+// A factory for the indexes of equivalence relations, storing the equivalence classes of binary tuples.
+std::unique_ptr<LVMIndex> createEqrelIndex(const Order&);
+
+// A factory for an index of an equivalence relation in another order, sharing the classes of the given one.
+std::unique_ptr<LVMIndex> createEqrelIndex(const Order&, const LVMIndex& shared);
+
+// Adds to an index of an equivalence relation, holding new knowledge, the pairs implied by combining
+// it with the old knowledge of another one.
+void extendEqrelIndex(LVMIndex& index, const LVMIndex& old);
+
+// A factory for an index presenting the storage of a relation, created by a storage provider.
+std::unique_ptr<LVMIndex> createStorageIndex(const Order&, std::shared_ptr<RelationStorage> storage);
+
+// A factory for an index of a stored relation in another order, presenting the storage of the given one.
+std::unique_ptr<LVMIndex> createStorageIndex(const Order&, const LVMIndex& shared);
+
 // A factory for indirect index.
 std::unique_ptr<LVMIndex> createIndirectIndex(const Order&);
 
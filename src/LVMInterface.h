@@ -46,7 +46,7 @@ class LVMInterface {
 public:
     LVMInterface(RamTranslationUnit& tUnit)
             : translationUnit(tUnit), isa(tUnit.getAnalysis<RamIndexAnalysis>()),
-              relationEncoder(isa, translationUnit) {}
+              relationEncoder(isa, translationUnit, [this]() { loadDLL(); }) {}
 
     virtual ~LVMInterface() = default;
 
@@ -0,0 +1,596 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file LVMJit.cpp
+ *
+ * Implementation of the compilation of hot LVM queries to native code.
+ *
+ ***********************************************************************/
+
+#include "LVMJit.h"
+#include "BinaryConstraintOps.h"
+#include "FunctorOps.h"
+#include "Global.h"
+#include "LVMIndex.h"
+#include "LVMRelation.h"
+#include "RamCondition.h"
+#include "RamExpression.h"
+#include "RamOperation.h"
+#include "RamVisitor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <utility>
+#include <dlfcn.h>
+#include <unistd.h>
+
+namespace souffle {
+
+namespace {
+
+// -- the operations on LVM relations offered to native queries --
+
+LVMRelation& asRelation(void* rel) {
+    return *static_cast<LVMRelation*>(rel);
+}
+
+void* scanRelation(void* rel) {
+    return new Stream(asRelation(rel).scan());
+}
+
+void* rangeOfRelation(void* rel, std::size_t indexPos, const RamDomain* low, const RamDomain* high) {
+    size_t arity = asRelation(rel).getArity();
+    return new Stream(asRelation(rel).range(indexPos, TupleRef(low, arity), TupleRef(high, arity)));
+}
+
+std::size_t fetchTuples(void* cursor, const RamDomain** tuples) {
+    return static_cast<Stream*>(cursor)->fetch(tuples, NATIVE_BATCH_SIZE);
+}
+
+void closeCursor(void* cursor) {
+    delete static_cast<Stream*>(cursor);
+}
+
+bool containsTuple(void* rel, const RamDomain* tuple) {
+    return asRelation(rel).contains(TupleRef(tuple, asRelation(rel).getArity()));
+}
+
+bool existsInRange(void* rel, std::size_t indexPos, const RamDomain* low, const RamDomain* high) {
+    size_t arity = asRelation(rel).getArity();
+    return asRelation(rel).exists(indexPos, TupleRef(low, arity), TupleRef(high, arity));
+}
+
+bool isEmpty(void* rel) {
+    return asRelation(rel).empty();
+}
+
+void insertTuple(void* rel, const RamDomain* tuple) {
+    asRelation(rel).insert(TupleRef(tuple, asRelation(rel).getArity()));
+}
+
+const NativeRelationAccess relationAccess = {&scanRelation, &rangeOfRelation, &fetchTuples, &closeCursor,
+        &containsTuple, &existsInRange, &isEmpty, &insertTuple};
+
+/**
+ * Generates the body of a native query. Nodes without a native translation
+ * mark the query as unsupported.
+ */
+class NativeCodeEmitter : public RamVisitor<void, std::ostream&> {
+public:
+    NativeCodeEmitter(RelationEncoder& relationEncoder, std::vector<size_t>& relIds)
+            : relationEncoder(relationEncoder), relIds(relIds) {}
+
+    /** Whether all visited nodes have a native translation */
+    bool isSupported() const {
+        return supported;
+    }
+
+    // -- operations --
+
+    void visitQuery(const RamQuery& query, std::ostream& out) override {
+        visit(query.getOperation(), out);
+    }
+
+    void visitScan(const RamScan& scan, std::ostream& out) override {
+        if (dynamic_cast<const RamAbstractParallel*>(&scan) != nullptr) {
+            supported = false;
+            return;
+        }
+        const int id = scan.getTupleId();
+        out << "{\n";
+        out << "void* cur" << id << " = access.scan(" << getRelation(scan.getRelation()) << ");\n";
+        emitLoop(scan, out);
+        out << "}\n";
+    }
+
+    void visitIndexScan(const RamIndexScan& scan, std::ostream& out) override {
+        if (dynamic_cast<const RamAbstractParallel*>(&scan) != nullptr) {
+            supported = false;
+            return;
+        }
+        const int id = scan.getTupleId();
+        const auto& rel = scan.getRelation();
+        auto patterns = scan.getRangePattern();
+        bool fullScan = std::all_of(patterns.begin(), patterns.end(), isRamUndefValue);
+
+        out << "{\n";
+        if (scan.hasRange()) {
+            // the bounded column follows the bound ones in the index serving the range
+            const MinIndexSelection& orderSet = relationEncoder.isa->getIndexes(rel);
+            size_t indexPos = orderSet.getOrderedLexOrderNum(
+                    relationEncoder.isa->getSearchSignature(&scan), scan.getRangeColumn());
+            emitBounds("low" + std::to_string(id), "high" + std::to_string(id), patterns, out, &scan);
+            out << "void* cur" << id << " = access.range(" << getRelation(rel) << ", " << indexPos << ", low"
+                << id << ", high" << id << ");\n";
+        } else if (fullScan) {
+            out << "void* cur" << id << " = access.scan(" << getRelation(rel) << ");\n";
+        } else {
+            emitBounds("low" + std::to_string(id), "high" + std::to_string(id), patterns, out);
+            out << "void* cur" << id << " = access.range(" << getRelation(rel) << ", "
+                << getIndexPos(scan, rel) << ", low" << id << ", high" << id << ");\n";
+        }
+        emitLoop(scan, out);
+        out << "}\n";
+    }
+
+    void visitFilter(const RamFilter& filter, std::ostream& out) override {
+        out << "if (";
+        visit(filter.getCondition(), out);
+        out << ") {\n";
+        visit(filter.getOperation(), out);
+        out << "}\n";
+    }
+
+    void visitBreak(const RamBreak& breakOp, std::ostream& out) override {
+        out << "if (";
+        visit(breakOp.getCondition(), out);
+        if (loops.empty()) {
+            // leave the query
+            out << ") return;\n";
+        } else {
+            // leave the innermost loop
+            out << ") goto brk" << loops.back() << ";\n";
+            breakTargets.insert(loops.back());
+        }
+        visit(breakOp.getOperation(), out);
+    }
+
+    void visitProject(const RamProject& project, std::ostream& out) override {
+        const auto& values = project.getValues();
+        out << "{\nconst RamDomain tuple[" << std::max<size_t>(values.size(), 1) << "] = {";
+        for (size_t i = 0; i < values.size(); i++) {
+            out << (i > 0 ? ", " : "");
+            visit(values[i], out);
+        }
+        if (values.empty()) {
+            out << "0";
+        }
+        out << "};\n";
+        out << "access.insert(" << getRelation(project.getRelation()) << ", tuple);\n}\n";
+    }
+
+    // -- conditions --
+
+    void visitTrue(const RamTrue&, std::ostream& out) override {
+        out << "true";
+    }
+
+    void visitFalse(const RamFalse&, std::ostream& out) override {
+        out << "false";
+    }
+
+    void visitConjunction(const RamConjunction& conj, std::ostream& out) override {
+        out << "((";
+        visit(conj.getLHS(), out);
+        out << ") && (";
+        visit(conj.getRHS(), out);
+        out << "))";
+    }
+
+    void visitNegation(const RamNegation& neg, std::ostream& out) override {
+        out << "!(";
+        visit(neg.getOperand(), out);
+        out << ")";
+    }
+
+    void visitConstraint(const RamConstraint& constraint, std::ostream& out) override {
+        switch (constraint.getOperator()) {
+            case BinaryConstraintOp::EQ:
+            case BinaryConstraintOp::NE:
+            case BinaryConstraintOp::LT:
+            case BinaryConstraintOp::LE:
+            case BinaryConstraintOp::GT:
+            case BinaryConstraintOp::GE:
+                out << "((";
+                visit(constraint.getLHS(), out);
+                out << ") " << (constraint.getOperator() == BinaryConstraintOp::EQ
+                                               ? "=="
+                                               : toBinaryConstraintSymbol(constraint.getOperator()))
+                    << " (";
+                visit(constraint.getRHS(), out);
+                out << "))";
+                break;
+            default:
+                // string constraints require the symbol table
+                supported = false;
+        }
+    }
+
+    void visitEmptinessCheck(const RamEmptinessCheck& emptiness, std::ostream& out) override {
+        out << "access.empty(" << getRelation(emptiness.getRelation()) << ")";
+    }
+
+    void visitExistenceCheck(const RamExistenceCheck& exists, std::ostream& out) override {
+        const auto& rel = exists.getRelation();
+        auto values = exists.getValues();
+        bool bound = !std::all_of(values.begin(), values.end(), isRamUndefValue);
+        bool total = std::none_of(values.begin(), values.end(), isRamUndefValue);
+
+        if (!bound) {
+            out << "!access.empty(" << getRelation(rel) << ")";
+        } else if (total) {
+            out << "[&]() {\nconst RamDomain tuple[" << values.size() << "] = {";
+            for (size_t i = 0; i < values.size(); i++) {
+                out << (i > 0 ? ", " : "");
+                visit(values[i], out);
+            }
+            out << "};\nreturn access.contains(" << getRelation(rel) << ", tuple);\n}()";
+        } else {
+            out << "[&]() {\n";
+            emitBounds("low", "high", values, out);
+            out << "return access.exists(" << getRelation(rel) << ", " << getIndexPos(exists, rel)
+                << ", low, high);\n}()";
+        }
+    }
+
+    // -- expressions --
+
+    void visitNumber(const RamNumber& num, std::ostream& out) override {
+        out << "RamDomain(" << num.getConstant() << ")";
+    }
+
+    void visitTupleElement(const RamTupleElement& access, std::ostream& out) override {
+        out << "env" << access.getTupleId() << "[" << access.getElement() << "]";
+    }
+
+    void visitIntrinsicOperator(const RamIntrinsicOperator& op, std::ostream& out) override {
+        const auto& args = op.getArguments();
+        switch (op.getOperator()) {
+            case FunctorOp::ORD:
+                visit(args[0], out);
+                return;
+            case FunctorOp::NEG:
+                emitUnary("-", args, out);
+                return;
+            case FunctorOp::BNOT:
+                emitUnary("~", args, out);
+                return;
+            case FunctorOp::LNOT:
+                emitUnary("!", args, out);
+                return;
+            case FunctorOp::ADD:
+                emitBinary("+", args, out);
+                return;
+            case FunctorOp::SUB:
+                emitBinary("-", args, out);
+                return;
+            case FunctorOp::MUL:
+                emitBinary("*", args, out);
+                return;
+            case FunctorOp::DIV:
+                emitBinary("/", args, out);
+                return;
+            case FunctorOp::MOD:
+                emitBinary("%", args, out);
+                return;
+            case FunctorOp::BAND:
+                emitBinary("&", args, out);
+                return;
+            case FunctorOp::BOR:
+                emitBinary("|", args, out);
+                return;
+            case FunctorOp::BXOR:
+                emitBinary("^", args, out);
+                return;
+            case FunctorOp::LAND:
+                emitBinary("&&", args, out);
+                return;
+            case FunctorOp::LOR:
+                emitBinary("||", args, out);
+                return;
+            case FunctorOp::EXP:
+                emitCall("std::pow", args, out);
+                return;
+            case FunctorOp::MAX:
+                emitCall("std::max<RamDomain>", args, out);
+                return;
+            case FunctorOp::MIN:
+                emitCall("std::min<RamDomain>", args, out);
+                return;
+            default:
+                // string functors require the symbol table
+                supported = false;
+        }
+    }
+
+    // -- everything else stays interpreted --
+
+    void visitNode(const RamNode&, std::ostream&) override {
+        supported = false;
+    }
+
+private:
+    /** Emit the loop over the tuples of a cursor and the nested operation of a scan */
+    void emitLoop(const RamTupleOperation& search, std::ostream& out) {
+        const int id = search.getTupleId();
+        out << "const RamDomain* buf" << id << "[souffle::NATIVE_BATCH_SIZE];\n";
+        out << "for (std::size_t n" << id << "; (n" << id << " = access.fetch(cur" << id << ", buf" << id
+            << ")) > 0;) {\n";
+        out << "for (std::size_t i" << id << " = 0; i" << id << " < n" << id << "; i" << id << "++) {\n";
+        out << "const RamDomain* env" << id << " = buf" << id << "[i" << id << "];\n";
+        loops.push_back(id);
+        visit(search.getOperation(), out);
+        loops.pop_back();
+        out << "}\n}\n";
+        if (breakTargets.count(id) > 0) {
+            out << "brk" << id << ":\n";
+        }
+        out << "access.close(cur" << id << ");\n";
+    }
+
+    /** Emit the bounds of a range query for the given pattern */
+    void emitBounds(const std::string& low, const std::string& high,
+            const std::vector<RamExpression*>& patterns, std::ostream& out,
+            const RamIndexScan* range = nullptr) {
+        const int column = (range != nullptr) ? range->getRangeColumn() : -1;
+        out << "const RamDomain " << low << "[" << patterns.size() << "] = {";
+        for (size_t i = 0; i < patterns.size(); i++) {
+            out << (i > 0 ? ", " : "");
+            if ((int)i == column && !isRamUndefValue(&range->getLowerBound())) {
+                visit(range->getLowerBound(), out);
+            } else if (isRamUndefValue(patterns[i])) {
+                out << "MIN_RAM_DOMAIN";
+            } else {
+                visit(patterns[i], out);
+            }
+        }
+        out << "};\n";
+        out << "const RamDomain " << high << "[" << patterns.size() << "] = {";
+        for (size_t i = 0; i < patterns.size(); i++) {
+            out << (i > 0 ? ", " : "");
+            if ((int)i == column && !isRamUndefValue(&range->getUpperBound())) {
+                visit(range->getUpperBound(), out);
+            } else if (isRamUndefValue(patterns[i])) {
+                out << "MAX_RAM_DOMAIN";
+            } else {
+                out << low << "[" << i << "]";
+            }
+        }
+        out << "};\n";
+    }
+
+    void emitUnary(const std::string& op, const std::vector<RamExpression*>& args, std::ostream& out) {
+        out << "RamDomain(" << op << "(";
+        visit(args[0], out);
+        out << "))";
+    }
+
+    void emitBinary(const std::string& op, const std::vector<RamExpression*>& args, std::ostream& out) {
+        out << "RamDomain((";
+        visit(args[0], out);
+        out << ") " << op << " (";
+        visit(args[1], out);
+        out << "))";
+    }
+
+    void emitCall(const std::string& fun, const std::vector<RamExpression*>& args, std::ostream& out) {
+        out << "RamDomain(" << fun << "(";
+        visit(args[0], out);
+        out << ", ";
+        visit(args[1], out);
+        out << "))";
+    }
+
+    /** Obtain the expression denoting a relation in the generated code */
+    std::string getRelation(const RamRelation& rel) {
+        size_t relId = relationEncoder.encodeRelation(rel);
+        auto pos = std::find(relIds.begin(), relIds.end(), relId);
+        size_t slot = pos - relIds.begin();
+        if (pos == relIds.end()) {
+            relIds.push_back(relId);
+        }
+        return "rel[" + std::to_string(slot) + "]";
+    }
+
+    /** Obtain the index of a range query, as chosen by the LVM generator */
+    template <class Node>
+    size_t getIndexPos(const Node& node, const RamRelation& rel) {
+        const MinIndexSelection& orderSet = relationEncoder.isa->getIndexes(rel);
+        SearchSignature signature = relationEncoder.isa->getSearchSignature(&node);
+        return orderSet.getLexOrderNum(signature);
+    }
+
+    RelationEncoder& relationEncoder;
+
+    /** the relations accessed by the query */
+    std::vector<size_t>& relIds;
+
+    /** the tuple identifiers of the enclosing loops */
+    std::vector<int> loops;
+
+    /** the loops left by a break */
+    std::set<int> breakTargets;
+
+    bool supported = true;
+};
+
+}  // namespace
+
+LVMJit::LVMJit(RelationEncoder& relationEncoder, std::string compileCmd, double threshold)
+        : relationEncoder(relationEncoder), compileCmd(std::move(compileCmd)), threshold(threshold) {}
+
+LVMJit::~LVMJit() {
+    {
+        std::lock_guard<std::mutex> guard(jobLock);
+        stopped = true;
+        jobs.clear();
+    }
+    jobAvailable.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    for (void* library : libraries) {
+        dlclose(library);
+    }
+    if (!directory.empty()) {
+        for (size_t i = 0; i < numLibraries; i++) {
+            std::string base = directory + "/query" + std::to_string(i);
+            std::remove((base + ".cpp").c_str());
+            std::remove((base + ".so").c_str());
+        }
+        rmdir(directory.c_str());
+    }
+}
+
+LVMJit::QueryState& LVMJit::getState(const RamQuery& query) {
+    std::lock_guard<std::mutex> guard(stateLock);
+    return states[&query];
+}
+
+bool LVMJit::enter(const RamQuery& query) {
+    QueryState& state = getState(query);
+    NativeQuery native = state.native.load(std::memory_order_acquire);
+    if (native == nullptr) {
+        state.start = std::chrono::steady_clock::now();
+        return false;
+    }
+
+    // the relations at the positions of the query may have been swapped since the last evaluation
+    std::vector<void*> relations;
+    for (size_t relId : state.relIds) {
+        relations.push_back(relationEncoder[relId].get());
+    }
+    NativeQueryContext ctxt{&relationAccess, relations.data()};
+    native(&ctxt);
+    return true;
+}
+
+void LVMJit::leave(const RamQuery& query) {
+    QueryState& state = getState(query);
+    state.time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - state.start)
+                          .count();
+    if (state.requested || state.time < threshold) {
+        return;
+    }
+    state.requested = true;
+
+    std::vector<size_t> relIds;
+    std::string code = generate(query, relationEncoder, relIds);
+    if (code.empty()) {
+        return;
+    }
+    state.relIds = relIds;
+
+    std::lock_guard<std::mutex> guard(jobLock);
+    jobs.push_back({&state, code});
+    if (!worker.joinable()) {
+        worker = std::thread([this]() { run(); });
+    }
+    jobAvailable.notify_one();
+}
+
+std::string LVMJit::generate(
+        const RamQuery& query, RelationEncoder& relationEncoder, std::vector<size_t>& relIds) {
+    std::stringstream body;
+    NativeCodeEmitter emitter(relationEncoder, relIds);
+    emitter.visit(query, body);
+    if (!emitter.isSupported()) {
+        relIds.clear();
+        return "";
+    }
+
+    std::stringstream code;
+    code << "#include \"souffle/NativeQuery.h\"\n";
+    code << "#include <algorithm>\n";
+    code << "#include <cmath>\n";
+    code << "#include <cstddef>\n\n";
+    code << "extern \"C\" void " << NATIVE_QUERY_SYMBOL << "(const souffle::NativeQueryContext* ctxt) {\n";
+    code << "using souffle::RamDomain;\n";
+    code << "const souffle::NativeRelationAccess& access = *ctxt->access;\n";
+    code << "void* const* rel = ctxt->relations;\n";
+    code << "(void)rel;\n";
+    code << body.str();
+    code << "}\n";
+    return code.str();
+}
+
+void LVMJit::run() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> guard(jobLock);
+            jobAvailable.wait(guard, [this]() { return stopped || !jobs.empty(); });
+            if (stopped) {
+                return;
+            }
+            job = jobs.front();
+            jobs.pop_front();
+        }
+        compile(job);
+    }
+}
+
+void LVMJit::compile(const Job& job) {
+    if (directory.empty()) {
+        const char* tmp = std::getenv("TMPDIR");
+        std::string pattern = std::string(tmp != nullptr ? tmp : "/tmp") + "/souffle-jit-XXXXXX";
+        std::vector<char> name(pattern.begin(), pattern.end());
+        name.push_back('\0');
+        if (mkdtemp(name.data()) == nullptr) {
+            return;
+        }
+        directory = name.data();
+    }
+
+    std::string base = directory + "/query" + std::to_string(numLibraries++);
+    {
+        std::ofstream os(base + ".cpp");
+        os << job.code;
+    }
+    std::string cmd = compileCmd + " -s \"" + base + ".cpp\"";
+    if (!Global::config().has("verbose")) {
+        cmd += " >/dev/null 2>&1";
+    }
+    if (std::system(cmd.c_str()) != 0) {
+        return;
+    }
+
+    void* library = dlopen((base + ".so").c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (library == nullptr) {
+        return;
+    }
+    auto native = reinterpret_cast<NativeQuery>(dlsym(library, NATIVE_QUERY_SYMBOL));
+    if (native == nullptr) {
+        dlclose(library);
+        return;
+    }
+    libraries.push_back(library);
+    job.state->native.store(native, std::memory_order_release);
+    if (Global::config().has("verbose")) {
+        std::cout << "Loaded native code of query from " << base << ".so\n";
+    }
+}
+
+}  // end of namespace souffle
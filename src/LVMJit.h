@@ -0,0 +1,141 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file LVMJit.h
+ *
+ * Declares the compilation of hot LVM queries to native code at runtime.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "LVMGenerator.h"
+#include "NativeQuery.h"
+#include "RamStatement.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * Compiles the hot queries of the LVM to native code in the background.
+ *
+ * The evaluation time of each query is accumulated. Once it exceeds the
+ * threshold, C++ code for the query is generated against the interface of
+ * NativeQuery.h, and a background thread compiles it into a shared library.
+ * As soon as the library is loaded, its code replaces the bytecode of the
+ * query in subsequent evaluations. Queries using operations without a native
+ * translation stay interpreted.
+ */
+class LVMJit {
+public:
+    /**
+     * @param compileCmd the command compiling a C++ file into a shared library
+     * @param threshold the evaluation time in milliseconds after which a query is compiled
+     */
+    LVMJit(RelationEncoder& relationEncoder, std::string compileCmd, double threshold);
+
+    ~LVMJit();
+
+    /**
+     * Enters the evaluation of a query: evaluates its native code if
+     * available, or starts timing its interpretation otherwise.
+     *
+     * @return true if the query has been evaluated natively
+     */
+    bool enter(const RamQuery& query);
+
+    /** Leaves the interpretation of a query, requesting its compilation once it is hot */
+    void leave(const RamQuery& query);
+
+    /**
+     * Generates the C++ code of a native query. The relations accessed by the
+     * query are appended to the given list, in the order they are expected by
+     * the code.
+     *
+     * @return the code, or an empty string if the query cannot be compiled
+     */
+    static std::string generate(
+            const RamQuery& query, RelationEncoder& relationEncoder, std::vector<size_t>& relIds);
+
+private:
+    /** The compilation state of a query */
+    struct QueryState {
+        /** the compiled code, if loaded */
+        std::atomic<NativeQuery> native{nullptr};
+
+        /** the relations accessed by the compiled code */
+        std::vector<size_t> relIds;
+
+        /** the accumulated interpretation time in milliseconds */
+        double time = 0;
+
+        /** the start of the current interpretation */
+        std::chrono::steady_clock::time_point start;
+
+        /** whether the query has been considered for compilation */
+        bool requested = false;
+    };
+
+    /** A compilation request for the background thread */
+    struct Job {
+        QueryState* state;
+        std::string code;
+    };
+
+    /** Obtain the state of a query */
+    QueryState& getState(const RamQuery& query);
+
+    /** Compile a query and load its code */
+    void compile(const Job& job);
+
+    /** The loop of the background thread */
+    void run();
+
+    RelationEncoder& relationEncoder;
+
+    /** command compiling a C++ file into a shared library */
+    const std::string compileCmd;
+
+    /** evaluation time after which a query is compiled */
+    const double threshold;
+
+    /** states of the queries, guarded by stateLock */
+    std::map<const RamQuery*, QueryState> states;
+    std::mutex stateLock;
+
+    /** pending compilations, guarded by jobLock */
+    std::deque<Job> jobs;
+    std::mutex jobLock;
+    std::condition_variable jobAvailable;
+    bool stopped = false;
+
+    /** the background thread, started with the first compilation */
+    std::thread worker;
+
+    /** directory holding the generated files */
+    std::string directory;
+
+    /** the number of libraries compiled so far */
+    size_t numLibraries = 0;
+
+    /** handles of the loaded libraries */
+    std::vector<void*> libraries;
+};
+
+}  // end of namespace souffle
@@ -38,7 +38,10 @@ public:
 
     /** Insert tuple */
     void insert(const tuple& t) override {
-        relation.insert(TupleRef(t.data, relation.getArity()));
+        TupleRef ref(t.data, relation.getArity());
+        // tuples inserted through the interface may exceed the inferred column widths
+        relation.widen(ref);
+        relation.insert(ref);
     }
 
     /** Check whether tuple exists */
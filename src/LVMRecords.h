@@ -17,6 +17,7 @@
 #pragma once
 
 #include "RamTypes.h"
+#include <cstddef>
 
 namespace souffle {
 
@@ -25,6 +26,12 @@ namespace souffle {
  */
 RamDomain pack(RamDomain* tuple, int arity);
 
+/**
+ * A function obtaining the reference of a tuple of the given arity if it has been packed
+ * before, or 0 otherwise, without creating a new reference.
+ */
+RamDomain lookup(const RamDomain* tuple, int arity);
+
 /**
  * A function obtaining a pointer to the tuple addressed by the given reference.
  */
@@ -41,4 +48,9 @@ RamDomain getNull();
  */
 bool isNull(RamDomain ref);
 
+/**
+ * Obtains an estimate of the number of bytes occupied by all records.
+ */
+size_t getRecordMemoryUsage();
+
 }  // end of namespace souffle
@@ -21,10 +21,40 @@
 
 namespace souffle {
 
+namespace {
+
+/**
+ * A source counting the tuples delivered by a stream.
+ */
+class CountingSource : public Stream::Source {
+public:
+    CountingSource(Stream&& stream, std::atomic<size_t>& counter)
+            : stream(std::move(stream)), counter(counter) {}
+
+    int load(TupleRef* trg, int max) override {
+        int count = 0;
+        for (auto it = stream.begin(); count < max && it != stream.end(); ++it) {
+            trg[count++] = *it;
+        }
+        counter.fetch_add(count, std::memory_order_relaxed);
+        return count;
+    }
+
+    std::unique_ptr<Stream::Source> clone() override {
+        return std::make_unique<CountingSource>(std::move(*stream.clone()), counter);
+    }
+
+private:
+    Stream stream;
+    std::atomic<size_t>& counter;
+};
+
+}  // namespace
+
 LVMRelation::LVMRelation(std::size_t arity, const std::string& name,
         const std::vector<std::string>& attributeTypes, const MinIndexSelection& orderSet,
         IndexFactory factory)
-        : relName(name), arity(arity), attributeTypes(attributeTypes) {
+        : relName(name), arity(arity), attributeTypes(attributeTypes), factory(factory) {
     for (auto order : orderSet.getAllOrders()) {
         // Expand the order to a total order
         std::set<int> set;
@@ -36,23 +66,66 @@ LVMRelation::LVMRelation(std::size_t arity, const std::string& name,
                 order.push_back(i);
             }
         }
-        indexes.push_back(factory(Order(order)));
+        orders.push_back(Order(order));
+        indexes.push_back(factory == nullptr ? nullptr : factory(orders.back()));
     }
 
     // Use the first index as default main index
     main = indexes[0].get();
+
+    // secondary indexes are filled on their first use
+    materialised = std::vector<std::atomic<bool>>(indexes.size());
+    materialised[0] = true;
+    updateConcurrentInsert();
 }
 
 void LVMRelation::removeIndex(const size_t& indexPos) {
     // All but one index can be removed, default full index can't be removed.
     assert(indexes.size() > 1 || indexPos != 0);
     indexes[indexPos].reset(nullptr);
+    if (indexPos < materialised.size()) {
+        materialised[indexPos] = false;
+    }
+}
+
+void LVMRelation::buildIndex(const size_t& indexPos) {
+    assert(indexes[indexPos] == nullptr && "index has not been removed");
+    indexes[indexPos] = factory(orders[indexPos]);
+    updateConcurrentInsert();
+}
+
+void LVMRelation::addFilter(const size_t& indexPos, SearchSignature columns) {
+    if (filters.size() < indexes.size()) {
+        filters.resize(indexes.size());
+    }
+    if (filters[indexPos].getColumns() != 0) {
+        columns &= filters[indexPos].getColumns();
+    }
+    filters[indexPos] = BloomFilter(columns);
+}
+
+void LVMRelation::buildFilter(const size_t& indexPos) {
+    filters[indexPos].build(main->scan(), main->size());
+}
+
+void LVMRelation::clearFilter(const size_t& indexPos) {
+    filters[indexPos].clear();
 }
 
 bool LVMRelation::insert(const TupleRef& tuple) {
+    if (!concurrentInsert) {
+        auto lease = insertLock.acquire();
+        (void)lease;
+        return insertIntoIndexes(tuple);
+    }
+    return insertIntoIndexes(tuple);
+}
+
+bool LVMRelation::insertIntoIndexes(const TupleRef& tuple) {
     if (!main->insert(tuple)) return false;
-    for (const auto& cur : indexes) {
-        if (cur.get() == main) continue;
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        const auto& cur = indexes[i];
+        if (cur == nullptr || cur.get() == main || !isMaterialised(i)) continue;
         cur->insert(tuple);
     }
     return true;
@@ -65,21 +138,140 @@ void LVMRelation::insert(const LVMRelation& other) {
     }
 }
 
+void LVMRelation::insert(InsertBuffer& buffer) {
+    const size_t arity = buffer.getArity();
+    if (concurrentInsert) {
+        buffer.flush([&](const RamDomain* tuple) { insert(TupleRef(tuple, arity)); });
+        return;
+    }
+    auto lease = insertLock.acquire();
+    (void)lease;
+    buffer.flush([&](const RamDomain* tuple) { insertIntoIndexes(TupleRef(tuple, arity)); });
+}
+
+void LVMRelation::widen(const TupleRef& tuple) {
+    if (main->fits(tuple)) {
+        return;
+    }
+    factory = &createBTreeIndex;
+    thawedFactory = nullptr;
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        if (indexes[i] == nullptr) {
+            continue;
+        }
+        // secondary indexes not filled yet stay empty
+        auto index = factory(orders[i]);
+        if (isMaterialised(i)) {
+            index->insert(*indexes[i]);
+        }
+        if (indexes[i].get() == main) {
+            main = index.get();
+        }
+        indexes[i] = std::move(index);
+    }
+    updateConcurrentInsert();
+}
+
 bool LVMRelation::contains(const TupleRef& tuple) const {
-    return main->contains(tuple);
+    markAccessed();
+    bool found = !isFilteredOut(mainPos, tuple) && main->contains(tuple);
+    if (statistics != nullptr) {
+        statistics[mainPos].probes.fetch_add(1, std::memory_order_relaxed);
+        if (!found) {
+            statistics[mainPos].emptyProbes.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return found;
 }
 
 Stream LVMRelation::scan() const {
+    markAccessed();
     return main->scan();
 }
 
+bool LVMRelation::exists(const size_t& indexPos, const TupleRef& low, const TupleRef& high) const {
+    bool found = false;
+    if (!isFilteredOut(indexPos, low)) {
+        auto range = getIndex(indexPos).range(low, high);
+        found = range.begin() != range.end();
+    }
+    if (statistics != nullptr) {
+        statistics[indexPos].probes.fetch_add(1, std::memory_order_relaxed);
+        if (!found) {
+            statistics[indexPos].emptyProbes.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return found;
+}
+
 Stream LVMRelation::range(const size_t& indexPos, const TupleRef& low, const TupleRef& high) const {
-    auto& pos = indexes[indexPos];
-    return pos->range(low, high);
+    if (statistics == nullptr) {
+        return getIndex(indexPos).range(low, high);
+    }
+    auto& stats = statistics[indexPos];
+    stats.scans.fetch_add(1, std::memory_order_relaxed);
+    return std::make_unique<CountingSource>(getIndex(indexPos).range(low, high), stats.tuples);
+}
+
+bool LVMRelation::lowerBound(const size_t& indexPos, const TupleRef& low, RamDomain* res) const {
+    return getIndex(indexPos).lowerBound(low, res);
+}
+
+std::vector<Stream> LVMRelation::partitionScan(size_t partitionCount) const {
+    markAccessed();
+    return main->partitionScan(partitionCount);
+}
+
+std::vector<Stream> LVMRelation::partitionRange(const size_t& indexPos, const TupleRef& low,
+        const TupleRef& high, size_t partitionCount) const {
+    auto partitions = getIndex(indexPos).partitionRange(low, high, partitionCount);
+    if (statistics == nullptr) {
+        return partitions;
+    }
+    auto& stats = statistics[indexPos];
+    stats.scans.fetch_add(1, std::memory_order_relaxed);
+    std::vector<Stream> res;
+    for (auto& partition : partitions) {
+        res.push_back(std::make_unique<CountingSource>(std::move(partition), stats.tuples));
+    }
+    return res;
 }
 
 void LVMRelation::swap(LVMRelation& other) {
     indexes.swap(other.indexes);
+    materialised.swap(other.materialised);
+    filters.swap(other.filters);
+}
+
+void LVMRelation::enableStatistics() {
+    statistics = std::make_unique<IndexStatistics[]>(indexes.size());
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        if (indexes[i].get() == main) {
+            mainPos = i;
+        }
+    }
+}
+
+std::string LVMRelation::getIndexDescription(const size_t& indexPos) const {
+    if (indexPos >= orders.size()) {
+        return "hash";
+    }
+    return toString(join(orders[indexPos].getOrder(), ","));
+}
+
+std::vector<std::pair<std::string, size_t>> LVMRelation::getMemoryUsage() const {
+    std::vector<std::pair<std::string, size_t>> res;
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        if (indexes[i] != nullptr) {
+            res.push_back(std::make_pair(getIndexDescription(i), indexes[i]->getMemoryUsage()));
+        }
+    }
+    for (size_t i = 0; i < filters.size(); ++i) {
+        if (!filters[i].empty()) {
+            res.push_back(std::make_pair("filter " + getIndexDescription(i), filters[i].getMemoryUsage()));
+        }
+    }
+    return res;
 }
 
 size_t LVMRelation::getLevel() const {
@@ -107,114 +299,272 @@ bool LVMRelation::empty() const {
 }
 
 void LVMRelation::purge() {
+    thaw();
+    for (auto& index : indexes) {
+        if (index != nullptr) {
+            index->clear();
+        }
+    }
+}
+
+void LVMRelation::reset() {
+    thaw();
     for (auto& index : indexes) {
-        index->clear();
+        if (index != nullptr) {
+            index->reset();
+        }
+    }
+}
+
+void LVMRelation::evictIndexes() {
+    for (size_t i = 0; i < materialised.size(); ++i) {
+        auto& index = indexes[i];
+        if (index != nullptr && index.get() != main && materialised[i].load(std::memory_order_relaxed)) {
+            index->clear();
+            materialised[i].store(false, std::memory_order_relaxed);
+        }
+    }
+}
+
+void LVMRelation::freeze() {
+    IndexFactory frozenFactory = nullptr;
+    if (factory == &createBTreeIndex) {
+        frozenFactory = &createFrozenIndex;
+    } else if (factory == &createNarrowBTreeIndex) {
+        frozenFactory = &createNarrowFrozenIndex;
+    } else {
+        // other kinds of indexes keep their layout
+        return;
+    }
+    thawedFactory = factory;
+    factory = frozenFactory;
+    convertIndexes();
+}
+
+void LVMRelation::compress() {
+    if (thawedFactory == nullptr || factory == &createCompressedIndex) {
+        return;
+    }
+    factory = &createCompressedIndex;
+    convertIndexes();
+}
+
+void LVMRelation::convertIndexes() {
+    // only the ordered indexes are converted, a hash index storing the tuples is kept
+    for (size_t i = 0; i < orders.size(); ++i) {
+        if (indexes[i] == nullptr) {
+            continue;
+        }
+        // secondary indexes not filled yet stay empty, to be filled from the main index on their first use
+        auto index = factory(orders[i]);
+        if (isMaterialised(i)) {
+            index->insert(*indexes[i]);
+        }
+        if (indexes[i].get() == main) {
+            main = index.get();
+        }
+        indexes[i] = std::move(index);
+    }
+    updateConcurrentInsert();
+}
+
+void LVMRelation::thaw() {
+    if (thawedFactory == nullptr) {
+        return;
+    }
+    factory = thawedFactory;
+    thawedFactory = nullptr;
+    for (size_t i = 0; i < orders.size(); ++i) {
+        if (indexes[i] == nullptr) {
+            continue;
+        }
+        auto index = factory(orders[i]);
+        if (indexes[i].get() == main) {
+            main = index.get();
+        }
+        indexes[i] = std::move(index);
+    }
+    updateConcurrentInsert();
+}
+
+void LVMRelation::updateConcurrentInsert() {
+    concurrentInsert = true;
+    for (const auto& index : indexes) {
+        if (index != nullptr && !index->hasConcurrentInsert()) {
+            concurrentInsert = false;
+        }
     }
 }
 
 bool LVMRelation::exists(const TupleRef& tuple) const {
+    markAccessed();
     return main->contains(tuple);
 }
 
 void LVMRelation::extend(const LVMRelation& rel) {}
 
-LVMEqRelation::LVMEqRelation(size_t arity, const std::string& name,
-        const std::vector<std::string>& attributeTypes, const MinIndexSelection& orderSet)
-        : LVMRelation(arity, name, attributeTypes, orderSet) {}
+const LVMIndex& LVMRelation::getIndex(const size_t& indexPos) const {
+    markAccessed();
 
-bool LVMEqRelation::insert(const TupleRef& tuple) {
-    // TODO: (pnappa) an eqrel check here is all that appears to be needed for implicit additions
-    // TODO: future optimisation would require this as a member datatype
-    // brave soul required to pass this quest
-    // // specialisation for eqrel defs
-    // std::unique_ptr<binaryrelation> eqreltuples;
-    // in addition, it requires insert functions to insert into that, and functions
-    // which allow reading of stored values must be changed to accommodate.
-    // e.g. insert =>  eqRelTuples->insert(tuple[0], tuple[1]);
-
-    // for now, we just have a naive & extremely slow version, otherwise known as a O(n^2) insertion
-    // ):
-
-    for (auto& newTuple : extend(tuple)) {
-        LVMRelation::insert(TupleRef(newTuple, arity));
-        delete[] newTuple;
+    // removed indexes are substituted by the main index
+    const auto& index = indexes[indexPos];
+    if (index == nullptr) {
+        return *main;
     }
-    return true;
+
+    // fill the index on its first use, after which inserts maintain it
+    if (indexPos < materialised.size() && !materialised[indexPos].load(std::memory_order_acquire)) {
+        auto lease = materialiseLock.acquire();
+        (void)lease;
+        if (!materialised[indexPos].load(std::memory_order_relaxed)) {
+            index->insert(*main);
+            materialised[indexPos].store(true, std::memory_order_release);
+        }
+    }
+    return *index;
 }
 
-std::vector<RamDomain*> LVMEqRelation::extend(const TupleRef& tuple) {
-    std::vector<RamDomain*> newTuples;
+LVMHashRelation::LVMHashRelation(size_t arity, const std::string& name,
+        const std::vector<std::string>& attributeTypes, const MinIndexSelection& orderSet)
+        : LVMRelation(arity, name, attributeTypes, orderSet) {
+    // only orders serving searches that bind some but not all columns remain b-trees
+    const SearchSignature full = (SearchSignature(1) << arity) - 1;
+    std::vector<bool> required(indexes.size(), false);
+    for (SearchSignature search : orderSet.getSearches()) {
+        if (search != 0 && search != full) {
+            required[orderSet.getLexOrderNum(search)] = true;
+        }
+    }
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        if (!required[i]) {
+            indexes[i].reset(nullptr);
+        }
+    }
 
-    newTuples.push_back(new RamDomain[2]{tuple[0], tuple[0]});
-    newTuples.push_back(new RamDomain[2]{tuple[0], tuple[1]});
-    newTuples.push_back(new RamDomain[2]{tuple[1], tuple[0]});
-    newTuples.push_back(new RamDomain[2]{tuple[1], tuple[1]});
+    // all tuples are stored in a hash index, answering scans and point lookups
+    indexes.push_back(createHashIndex(Order::create(arity)));
+    main = indexes.back().get();
+    materialised[0] = false;
+}
 
-    std::vector<const RamDomain*> relevantStored;
-    for (const TupleRef& vals : this->scan()) {
-        if (vals[0] == tuple[0] || vals[0] == tuple[1] || vals[1] == tuple[0] || vals[1] == tuple[1]) {
-            relevantStored.push_back(new RamDomain[2]{vals[0], vals[1]});
+LVMEqRelation::LVMEqRelation(size_t arity, const std::string& name,
+        const std::vector<std::string>& attributeTypes, const MinIndexSelection& orderSet)
+        : LVMRelation(arity, name, attributeTypes, orderSet, createEqrelIndex) {
+    // all indexes are views of the classes of the main index, hence up to date at all times
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        if (indexes[i].get() != main) {
+            indexes[i] = createEqrelIndex(orders[i], *main);
         }
+        materialised[i] = true;
     }
+}
 
-    for (auto& vals : relevantStored) {
-        newTuples.push_back(new RamDomain[2]{vals[0], tuple[0]});
-        newTuples.push_back(new RamDomain[2]{vals[0], tuple[1]});
-        newTuples.push_back(new RamDomain[2]{vals[1], tuple[0]});
-        newTuples.push_back(new RamDomain[2]{vals[1], tuple[1]});
-        newTuples.push_back(new RamDomain[2]{tuple[0], vals[0]});
-        newTuples.push_back(new RamDomain[2]{tuple[0], vals[1]});
-        newTuples.push_back(new RamDomain[2]{tuple[1], vals[0]});
-        newTuples.push_back(new RamDomain[2]{tuple[1], vals[1]});
-        delete[] vals;
-    }
-    return newTuples;
+bool LVMEqRelation::insert(const TupleRef& tuple) {
+    return main->insert(tuple);
+}
+
+void LVMEqRelation::buildIndex(const size_t& indexPos) {
+    assert(indexes[indexPos] == nullptr && "index has not been removed");
+    indexes[indexPos] = createEqrelIndex(orders[indexPos], *main);
+    materialised[indexPos] = true;
 }
 
 void LVMEqRelation::extend(const LVMRelation& rel) {
-    std::vector<RamDomain*> newTuples;
-    // store all values that will be implicitly relevant to the those that we will insert
+    if (auto* other = dynamic_cast<const LVMEqRelation*>(&rel)) {
+        extendEqrelIndex(*main, *other->main);
+        return;
+    }
+    // the old knowledge of other relations is collected into classes first
+    auto old = createEqrelIndex(Order::create(2));
     for (const auto& tuple : rel.scan()) {
-        for (auto& newTuple : extend(tuple)) {
-            newTuples.push_back(newTuple);
-        }
+        old->insert(tuple);
     }
-    for (const auto& newTuple : newTuples) {
-        LVMRelation::insert(TupleRef(newTuple, arity));
-        delete[] newTuple;
+    extendEqrelIndex(*main, *old);
+}
+
+LVMStorageRelation::LVMStorageRelation(size_t arity, const std::string& name,
+        const std::vector<std::string>& attributeTypes, const MinIndexSelection& orderSet,
+        const std::string& provider)
+        : LVMRelation(arity, name, attributeTypes, orderSet, nullptr) {
+    const auto& searches = orderSet.getSearches();
+    std::shared_ptr<RelationStorage> storage = StorageSystem::getInstance().getStorage(
+            provider, arity, std::vector<SearchSignature>(searches.begin(), searches.end()));
+
+    // all indexes are views of the storage of the main index, hence up to date at all times
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        indexes[i] = (i == 0) ? createStorageIndex(orders[i], storage)
+                              : createStorageIndex(orders[i], *indexes[0]);
+        materialised[i] = true;
     }
+    main = indexes[0].get();
+    updateConcurrentInsert();
+}
+
+void LVMStorageRelation::buildIndex(const size_t& indexPos) {
+    assert(indexes[indexPos] == nullptr && "index has not been removed");
+    indexes[indexPos] = createStorageIndex(orders[indexPos], *main);
+    materialised[indexPos] = true;
 }
 
 LVMIndirectRelation::LVMIndirectRelation(size_t arity, const std::string& name,
         const std::vector<std::string>& attributeTypes, const MinIndexSelection& orderSet)
-        : LVMRelation(arity, name, attributeTypes, orderSet, createIndirectIndex) {}
-
-bool LVMIndirectRelation::insert(const TupleRef& tuple) {
-    if (main->contains(tuple)) {
-        return false;
+        : LVMRelation(arity, name, attributeTypes, orderSet, createIndirectIndex),
+          shards(new Shard[NUM_SHARDS]) {
+    // all indexes are maintained by inserts
+    for (auto& cur : materialised) {
+        cur = true;
     }
+}
 
-    int blockIndex = num_tuples / (BLOCK_SIZE / arity);
-    int tupleIndex = (num_tuples % (BLOCK_SIZE / arity)) * arity;
-
-    if (tupleIndex == 0) {
-        blockList.push_back(std::make_unique<RamDomain[]>(BLOCK_SIZE));
+bool LVMIndirectRelation::insert(const TupleRef& tuple) {
+    // the tuple is stored before its pointer is inserted into the main index, which detects
+    // duplicates without a lock; the values of a duplicate are given back if still possible
+    Shard& shard = getShard();
+    RamDomain* newTuple;
+    {
+        auto lease = shard.lock.acquire();
+        (void)lease;
+        newTuple = allocate(shard);
     }
-
-    RamDomain* newTuple = &blockList[blockIndex][tupleIndex];
     for (size_t i = 0; i < arity; ++i) {
         newTuple[i] = tuple[i];
     }
 
-    // update all indexes with new tuple
+    if (!main->insert(TupleRef(newTuple, arity))) {
+        auto lease = shard.lock.acquire();
+        (void)lease;
+        if (newTuple + arity == shard.blocks.back().get() + shard.used) {
+            shard.used -= arity;
+        }
+        return false;
+    }
+
+    // update the other indexes with the new tuple
     for (auto& cur : indexes) {
-        cur->insert(TupleRef(newTuple, arity));
+        if (cur != nullptr && cur.get() != main) {
+            cur->insert(TupleRef(newTuple, arity));
+        }
     }
+    return true;
+}
 
-    // increment relation size
-    num_tuples++;
+RamDomain* LVMIndirectRelation::allocate(Shard& shard) {
+    if (shard.blocks.empty() || shard.used + arity > shard.blockSize) {
+        shard.blockSize = std::max<size_t>(BLOCK_SIZE, arity);
+        shard.blocks.push_back(std::make_unique<RamDomain[]>(shard.blockSize));
+        shard.used = 0;
+    }
+    RamDomain* res = shard.blocks.back().get() + shard.used;
+    shard.used += arity;
+    return res;
+}
 
-    return true;
+LVMIndirectRelation::Shard& LVMIndirectRelation::getShard() {
+#ifdef _OPENMP
+    return shards[omp_get_thread_num() % NUM_SHARDS];
+#else
+    return shards[0];
+#endif
 }
 
 bool LVMIndirectRelation::insert(const RamDomain* tuple) {
@@ -222,11 +572,29 @@ bool LVMIndirectRelation::insert(const RamDomain* tuple) {
 }
 
 void LVMIndirectRelation::purge() {
-    blockList.clear();
+    for (int i = 0; i < NUM_SHARDS; ++i) {
+        shards[i].blocks.clear();
+        shards[i].used = 0;
+    }
     for (auto& cur : indexes) {
-        cur->clear();
+        if (cur != nullptr) {
+            cur->clear();
+        }
+    }
+}
+
+void LVMIndirectRelation::reset() {
+    purge();
+}
+
+std::vector<std::pair<std::string, size_t>> LVMIndirectRelation::getMemoryUsage() const {
+    auto res = LVMRelation::getMemoryUsage();
+    size_t tuples = 0;
+    for (int i = 0; i < NUM_SHARDS; ++i) {
+        tuples += shards[i].blocks.size() * shards[i].blockSize * sizeof(RamDomain);
     }
-    num_tuples = 0;
+    res.push_back(std::make_pair("tuples", tuples));
+    return res;
 }
 
 }  // namespace souffle
@@ -16,10 +16,33 @@
 
 #pragma once
 
+#include "BloomFilter.h"
+#include "InsertBuffer.h"
 #include "LVMIndex.h"
 #include "RamIndexAnalysis.h"
 
+#include <atomic>
+#include <deque>
+#include <memory>
+
 namespace souffle {
+/**
+ * The accesses of an index, counted if index statistics are enabled.
+ */
+struct IndexStatistics {
+    // number of existence checks and membership tests answered by the index
+    std::atomic<size_t> probes{0};
+
+    // number of probes finding no tuple
+    std::atomic<size_t> emptyProbes{0};
+
+    // number of range scans
+    std::atomic<size_t> scans{0};
+
+    // number of tuples delivered by range scans
+    std::atomic<size_t> tuples{0};
+};
+
 /**
  * A relation, composed of a collection of indexes.
  */
@@ -82,6 +105,29 @@ public:
      */
     void removeIndex(const size_t& indexPos);
 
+    /**
+     * Reinstalls a removed index, to be filled from the main index on its first use.
+     */
+    virtual void buildIndex(const size_t& indexPos);
+
+    /**
+     * Installs a Bloom filter answering the probes of the index at the given position that find
+     * no tuple, over columns all of them bind; filters of an index installed repeatedly cover
+     * the columns common to all of them. Entire tuples are probed on the main index.
+     */
+    void addFilter(const size_t& indexPos, SearchSignature columns);
+
+    /**
+     * Fills the Bloom filter of the index at the given position with the tuples of the relation,
+     * which must not change until the filter is cleared.
+     */
+    void buildFilter(const size_t& indexPos);
+
+    /**
+     * Clears the Bloom filter of the index at the given position, such that probes search the index.
+     */
+    void clearFilter(const size_t& indexPos);
+
     /**
      * Add the given tuple to this relation.
      */
@@ -99,6 +145,27 @@ public:
      */
     void insert(const LVMRelation& other);
 
+    /**
+     * Add the tuples of the given buffer to this relation, emptying the buffer. Relations not
+     * supporting concurrent inserts take all of them within a single acquisition of their lock.
+     */
+    void insert(InsertBuffer& buffer);
+
+    /**
+     * Determines whether all indexes of this relation support concurrent inserts. Otherwise
+     * inserts are serialised by a lock, such that parallel operations should buffer them.
+     */
+    bool hasConcurrentInsert() const {
+        return concurrentInsert;
+    }
+
+    /**
+     * Moves the tuples of indexes storing a narrower domain than RamDomain into indexes of the
+     * full domain if the values of the given tuple do not fit the narrower one. Must not be
+     * called concurrently with any other access.
+     */
+    void widen(const TupleRef& tuple);
+
     /**
      * Tests whether this relation contains the given tuple.
      */
@@ -109,17 +176,70 @@ public:
      */
     Stream scan() const;
 
+    /**
+     * Tests whether the interval between the two given entries contains a tuple.
+     */
+    bool exists(const size_t& indexPos, const TupleRef& low, const TupleRef& high) const;
+
     /**
      * Obtains a stream covering the interval between the two given entries.
      */
     Stream range(const size_t& indexPos, const TupleRef& low, const TupleRef& high) const;
 
+    /**
+     * Locates the least entry not less than the given one in the order of the given index.
+     */
+    bool lowerBound(const size_t& indexPos, const TupleRef& low, RamDomain* res) const;
+
+    /**
+     * Obtains a list of streams partitioning the entire relation, for parallel scans.
+     */
+    std::vector<Stream> partitionScan(size_t partitionCount) const;
+
+    /**
+     * Obtains a list of streams partitioning the interval between the two given entries.
+     */
+    std::vector<Stream> partitionRange(const size_t& indexPos, const TupleRef& low, const TupleRef& high,
+            size_t partitionCount) const;
+
     /**
      * Swaps the content of this and the given relation, including the
      * installed indexes.
      */
     void swap(LVMRelation& other);
 
+    /**
+     * Starts counting the accesses of each index.
+     */
+    void enableStatistics();
+
+    /**
+     * Return the number of managed indexes.
+     */
+    size_t getIndexCount() const {
+        return indexes.size();
+    }
+
+    /**
+     * Return a description of the index at the given position: the columns
+     * of its order, or "hash" for a hash index.
+     */
+    std::string getIndexDescription(const size_t& indexPos) const;
+
+    /**
+     * Return an estimate of the number of bytes occupied by each index,
+     * labelled by its description.
+     */
+    virtual std::vector<std::pair<std::string, size_t>> getMemoryUsage() const;
+
+    /**
+     * Return the accesses of the index at the given position, or nullptr if
+     * statistics are not enabled.
+     */
+    const IndexStatistics* getStatistics(const size_t& indexPos) const {
+        return statistics == nullptr ? nullptr : &statistics[indexPos];
+    }
+
     /**
      * Set level
      */
@@ -162,6 +282,45 @@ public:
      */
     virtual void purge();
 
+    /**
+     * Clear all indexes, keeping the memory of those able to reuse it for the tuples inserted next
+     */
+    virtual void reset();
+
+    /**
+     * Clear the secondary indexes filled on their first use, to be filled again on their next use
+     */
+    virtual void evictIndexes();
+
+    /**
+     * Convert the b-tree indexes into read-optimised ones, once the relation is complete.
+     * Inserts remain possible but are slow; purging the relation restores the original indexes.
+     */
+    void freeze();
+
+    /**
+     * Convert the indexes of a frozen relation into delta-encoded blocks, decoded one at a time on
+     * access, for relations rarely read from then on. Purging the relation restores the original indexes.
+     */
+    void compress();
+
+    /**
+     * Whether the indexes of the relation have been frozen, and possibly compressed since
+     */
+    bool isFrozen() const {
+        return thawedFactory != nullptr;
+    }
+
+    /**
+     * Count the strata ending without an access to the relation since the last one.
+     *
+     * @return the number of strata the relation has not been accessed for, including the one ending now
+     */
+    size_t countIdleStrata() {
+        idleStrata = accessed.exchange(false, std::memory_order_relaxed) ? 0 : idleStrata + 1;
+        return idleStrata;
+    }
+
     /**
      * Check if a tuple exists in realtion
      */
@@ -173,6 +332,53 @@ public:
     virtual void extend(const LVMRelation& rel);
 
 protected:
+    /**
+     * Obtains the index at the given position, or the main index if it has been removed.
+     * An index that has not been used before is filled from the main index first.
+     */
+    const LVMIndex& getIndex(const size_t& indexPos) const;
+
+    /**
+     * Replaces the frozen indexes by empty ones of the kind they were converted from.
+     */
+    void thaw();
+
+    /**
+     * Replaces the indexes by ones created by the current factory holding the same tuples.
+     */
+    void convertIndexes();
+
+    /**
+     * Determines whether the installed indexes support concurrent inserts, to be called
+     * whenever indexes are replaced.
+     */
+    void updateConcurrentInsert();
+
+    /**
+     * Records an access to the relation, writing the flag only once per stratum to keep concurrent
+     * readers from contending for its cache line.
+     */
+    void markAccessed() const {
+        if (!accessed.load(std::memory_order_relaxed)) {
+            accessed.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Determines whether the index at the given position is kept up to date by inserts.
+     */
+    bool isMaterialised(const size_t& indexPos) const {
+        return indexPos >= materialised.size() || materialised[indexPos].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Determines whether the Bloom filter of the index at the given position rules out the key of a tuple.
+     */
+    bool isFilteredOut(const size_t& indexPos, const TupleRef& tuple) const {
+        return indexPos < filters.size() && !filters[indexPos].empty() &&
+               !filters[indexPos].mayContain(tuple);
+    }
+
     // Relation name
     std::string relName;
 
@@ -182,16 +388,66 @@ protected:
     // Relation attributes types
     std::vector<std::string> attributeTypes;
 
+    // the factory creating the indexes, or null if they are installed by a derived relation
+    IndexFactory factory;
+
+    // the factory of the indexes replaced by frozen ones, or null if the relation is not frozen
+    IndexFactory thawedFactory = nullptr;
+
+    // the orders of the managed indexes
+    std::vector<Order> orders;
+
     // a map of managed indexes
     std::vector<std::unique_ptr<LVMIndex>> indexes;
 
     // a pointer to the main index within the managed index
     LVMIndex* main;
 
+    // whether the secondary indexes have been filled; they are only maintained from their first use on
+    mutable std::vector<std::atomic<bool>> materialised;
+
+    // a lock serialising the filling of secondary indexes
+    mutable Lock materialiseLock;
+
+    // the Bloom filters answering the probes of the indexes, empty where there is none
+    std::vector<BloomFilter> filters;
+
     // relation level
     size_t level = 0;
+
+    // whether the relation has been searched since the last stratum ended
+    mutable std::atomic<bool> accessed{false};
+
+    // the number of strata ended since the relation has last been searched
+    size_t idleStrata = 0;
+
+    // the accesses of each index, if counted
+    std::unique_ptr<IndexStatistics[]> statistics;
+
+    // the position of the main index within the managed indexes
+    size_t mainPos = 0;
+
+    // whether all installed indexes support concurrent inserts
+    bool concurrentInsert = true;
+
+    // a lock serialising the inserts into indexes not supporting concurrent ones
+    Lock insertLock;
+
+private:
+    // adds the given tuple to the materialised indexes
+    bool insertIntoIndexes(const TupleRef& tuple);
 };  // namespace souffle
 
+/**
+ * Interpreter Hash Set Relation, storing all tuples in a hash index and
+ * maintaining b-tree indexes for range searches only.
+ */
+class LVMHashRelation : public LVMRelation {
+public:
+    LVMHashRelation(size_t arity, const std::string& relName, const std::vector<std::string>& attributeTypes,
+            const MinIndexSelection& orderSet);
+};
+
 /**
  * Interpreter Equivalence Relation
  */
@@ -200,16 +456,36 @@ public:
     LVMEqRelation(size_t arity, const std::string& relName, const std::vector<std::string>& attributeTypes,
             const MinIndexSelection& orderSet);
 
-    /** Insert tuple */
+    /** Insert tuple, by a union of the classes shared by all indexes */
     bool insert(const TupleRef& tuple) override;
 
-    /** Find the new knowledge generated by inserting a tuple */
-    std::vector<RamDomain*> extend(const TupleRef& tuple);
+    /** Reinstall a removed index as a view of the shared classes */
+    void buildIndex(const size_t& indexPos) override;
+
+    /** Keep all indexes, as they share the classes of the main index */
+    void evictIndexes() override {}
 
-    /** Extend this relation with new knowledge generated by inserting all tuples from a relation */
+    /** Extend this relation, holding new knowledge, by the pairs implied by the old knowledge of another */
     void extend(const LVMRelation& rel) override;
 };
 
+/**
+ * Interpreter relation stored by a registered storage provider, all of whose indexes
+ * present the one storage of the relation
+ */
+class LVMStorageRelation : public LVMRelation {
+public:
+    LVMStorageRelation(size_t arity, const std::string& relName,
+            const std::vector<std::string>& attributeTypes, const MinIndexSelection& orderSet,
+            const std::string& provider);
+
+    /** Reinstall a removed index as a view of the storage */
+    void buildIndex(const size_t& indexPos) override;
+
+    /** Keep all indexes, as they present the storage of the main index */
+    void evictIndexes() override {}
+};
+
 /**
  * Interpreter Indirect Relation
  */
@@ -225,13 +501,37 @@ public:
     /** Clear all indexes */
     void purge() override;
 
+    /** Clear all indexes and blocks, which are not reused */
+    void reset() override;
+
+    /** Keep all indexes, as they are maintained by inserts */
+    void evictIndexes() override {}
+
+    /** Return the memory of the indexes and of the blocks storing the tuples, labelled "tuples" */
+    std::vector<std::pair<std::string, size_t>> getMemoryUsage() const override;
+
 private:
     /** Size of blocks containing tuples */
     static const int BLOCK_SIZE = 1024;
 
-    std::deque<std::unique_ptr<RamDomain[]>> blockList;
+    /** Number of shards of blocks, among which the inserting threads are distributed */
+    static const int NUM_SHARDS = 16;
+
+    /** The blocks a group of threads stores its tuples in, filled one after the other */
+    struct Shard {
+        Lock lock;
+        std::deque<std::unique_ptr<RamDomain[]>> blocks;
+        size_t used = 0;
+        size_t blockSize = 0;
+    };
+
+    /** Reserve the values of a tuple in the given shard, whose lock is held */
+    RamDomain* allocate(Shard& shard);
+
+    /** Obtain the shard of the calling thread */
+    Shard& getShard();
 
-    size_t num_tuples = 0;
+    std::unique_ptr<Shard[]> shards;
 };
 
 }  // end of namespace souffle
@@ -174,7 +174,7 @@ public:
                             // start again
                             return insert(k, hints, f);
                         }
-                        this->update(*pos, k);
+                        this->update(cur, &*pos, k);
 
                         // get result before releasing lock
                         auto res = (*pos).second;
@@ -243,7 +243,7 @@ public:
                         // start again
                         return insert(k, hints, f);
                     }
-                    this->update(*(pos - 1), k);
+                    this->update(cur, pos - 1, k);
 
                     // retrieve result before releasing lock
                     auto res = (*(pos - 1)).second;
@@ -309,8 +309,8 @@ public:
 
                 // split this node
                 auto old_root = this->root;
-                idx -= cur->rebalance_or_split(
-                        const_cast<typename parenttype::node**>(&this->root), this->root_lock, idx, parents);
+                idx -= cur->rebalance_or_split(const_cast<typename parenttype::node**>(&this->root),
+                        this->root_lock, this->alloc, idx, parents);
 
                 // release parent lock
                 for (auto it = parents.rbegin(); it != parents.rend(); ++it) {
@@ -405,7 +405,7 @@ public:
                 if (isSet && pos != b && this->weak_equal(*pos, k)) {
                     // update provenance information
                     if (typeid(Comparator) != typeid(WeakComparator) && this->less(k, *pos)) {
-                        this->update(*pos, k);
+                        this->update(cur, &*pos, k);
                         return (*pos).second;
                     }
 
@@ -431,7 +431,7 @@ public:
             if (isSet && pos != a && this->weak_equal(*(pos - 1), k)) {
                 // update provenance information
                 if (typeid(Comparator) != typeid(WeakComparator) && this->less(k, *(pos - 1))) {
-                    this->update(*(pos - 1), k);
+                    this->update(cur, pos - 1, k);
                     return (*(pos - 1)).second;
                 }
 
@@ -440,8 +440,8 @@ public:
 
             if (cur->numElements >= parenttype::node::maxKeys) {
                 // split this node
-                idx -= cur->rebalance_or_split(
-                        const_cast<typename parenttype::node**>(&this->root), this->root_lock, idx);
+                idx -= cur->rebalance_or_split(const_cast<typename parenttype::node**>(&this->root),
+                        this->root_lock, this->alloc, idx);
 
                 // insert element in right fragment
                 if (((typename parenttype::size_type)idx) > cur->numElements) {
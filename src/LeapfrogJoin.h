@@ -0,0 +1,112 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file LeapfrogJoin.h
+ *
+ * An intersection of ordered sets of values, the building block of a
+ * leapfrog triejoin.
+ *
+ * Each set is accessed through a seek function, which moves a given value
+ * forward to the least element of the set not less than it. The sets take
+ * turns in seeking the current candidate value, such that each seek skips
+ * all values absent from one of the sets at once. Hence, the number of seeks
+ * is bounded by the size of the smallest set times the number of sets,
+ * irrespective of the size of the other sets.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamTypes.h"
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * Enumerates the values common to a list of ordered sets in ascending order.
+ */
+class LeapfrogJoin {
+public:
+    /**
+     * The access to a set: given a value, it updates the value to the least
+     * element of the set not less than the given value, returning false if
+     * there is no such element.
+     */
+    using Seek = std::function<bool(RamDomain&)>;
+
+    LeapfrogJoin(std::vector<Seek> sets) : sets(std::move(sets)) {}
+
+    /**
+     * Advances to the next value common to all sets.
+     *
+     * @return false if there is no further common value
+     */
+    bool next() {
+        if (done || sets.empty()) {
+            done = true;
+            return false;
+        }
+        if (started) {
+            if (value == MAX_RAM_DOMAIN) {
+                done = true;
+                return false;
+            }
+            ++value;
+        }
+        started = true;
+
+        // the number of sets, up to and excluding the current one, agreeing on the value
+        std::size_t agreeing = 0;
+        while (agreeing < sets.size()) {
+            RamDomain candidate = value;
+            if (!sets[cur](candidate)) {
+                done = true;
+                return false;
+            }
+            if (candidate == value) {
+                agreeing++;
+            } else {
+                value = candidate;
+                agreeing = 1;
+            }
+            cur = (cur + 1) % sets.size();
+        }
+        return true;
+    }
+
+    /**
+     * Obtains the current common value, valid after next() returned true.
+     */
+    RamDomain get() const {
+        return value;
+    }
+
+private:
+    // the intersected sets
+    std::vector<Seek> sets;
+
+    // the set to seek next
+    std::size_t cur = 0;
+
+    // the current candidate or common value
+    RamDomain value = MIN_RAM_DOMAIN;
+
+    // whether the first value has been searched for
+    bool started = false;
+
+    // whether all common values have been enumerated
+    bool done = false;
+};
+
+}  // end namespace souffle
@@ -112,6 +112,14 @@ public:
         return line.str();
     }
 
+    static const std::string nRelationColumn(
+            const std::string& relationName, const size_t column, const SrcLocation& srcLocation) {
+        const char* messageType = "@n-relation-column";
+        std::stringstream line;
+        line << messageType << ";" << relationName << ";" << column << ";" << srcLocation << ";";
+        return line.str();
+    }
+
     static const std::string pProofCounter(
             const std::string& relationName, const SrcLocation& srcLocation, const std::string& datalogText) {
         // TODO (#590): the profiler should be modified to use this type of log message, as currently these
@@ -125,6 +133,20 @@ public:
         return line.str();
     }
 
+    /** the label of the samples of a rule, completed by the loop level when writing the samples */
+    static const std::string sRule(
+            const std::string& relationName, const SrcLocation& srcLocation, const std::string& datalogText) {
+        const char* messageType = "@sample";
+        std::stringstream line;
+        line << messageType << ";" << relationName << ";" << srcLocation << ";" << datalogText << ";";
+        return line.str();
+    }
+
+    /** whether a timer label is the sample label of a rule, marking the rule instead of timing it */
+    static bool isSample(const std::string& label) {
+        return label.compare(0, 8, "@sample;") == 0;
+    }
+
     static const std::string runtime() {
         const char* messageType = "@runtime";
         std::stringstream line;
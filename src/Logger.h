@@ -17,8 +17,10 @@
 
 #pragma once
 
+#include "HardwareCounters.h"
 #include "ParallelUtils.h"
 #include "ProfileEvent.h"
+#include "TraceLog.h"
 
 #include <chrono>
 #include <functional>
@@ -44,16 +46,28 @@ public:
         struct rusage ru {};
         getrusage(RUSAGE_SELF, &ru);
         startMaxRSS = ru.ru_maxrss;
+        counted = ProfileEventSingleton::instance().hasHardwareCounters(this->label);
+        if (counted) {
+            startCounters = HardwareCounters::instance().read();
+        }
         // Assume that if we are logging the progress of an event then we care about usage during that time.
         ProfileEventSingleton::instance().resetTimerInterval();
+        traceStart = TraceLog::instance().now();
     }
 
     ~Logger() {
         struct rusage ru {};
         getrusage(RUSAGE_SELF, &ru);
         size_t endMaxRSS = ru.ru_maxrss;
+        if (counted) {
+            HardwareCounters::Sample endCounters = HardwareCounters::instance().read();
+            ProfileEventSingleton::instance().makeCountersEvent(label, startCounters, endCounters, iteration);
+        }
+        const size_t tuples = size() - preSize;
         ProfileEventSingleton::instance().makeTimingEvent(
-                label, start, now(), startMaxRSS, endMaxRSS, size() - preSize, iteration);
+                label, start, now(), startMaxRSS, endMaxRSS, tuples, iteration);
+        TraceLog::instance().record(label, "timer", traceStart, TraceLog::instance().now(),
+                {{"tuples", static_cast<int64_t>(tuples)}, {"iteration", static_cast<int64_t>(iteration)}});
     }
 
 private:
@@ -63,5 +77,8 @@ private:
     size_t iteration;
     std::function<size_t()> size;
     size_t preSize;
+    bool counted;
+    HardwareCounters::Sample startCounters{};
+    uint64_t traceStart;
 };
 }  // end of namespace souffle
@@ -18,6 +18,7 @@
 #include "AstAttribute.h"
 #include "AstIO.h"
 #include "AstIOTypeAnalysis.h"
+#include "AstProfileUse.h"
 #include "AstNode.h"
 #include "AstProgram.h"
 #include "AstRelation.h"
@@ -29,6 +30,7 @@
 #include "RelationRepresentation.h"
 #include "SrcLocation.h"
 #include "Util.h"
+#include <algorithm>
 #include <cassert>
 #include <utility>
 
@@ -189,7 +191,7 @@ SrcLocation nextSrcLoc(SrcLocation orig) {
     pos += 1;
 
     SrcLocation newLoc;
-    newLoc.filename = orig.filename + " [MAGIC_FILE]";
+    newLoc.filename = orig.filename.str() + " [MAGIC_FILE]";
     newLoc.start.line = pos;
     newLoc.end.line = pos;
     newLoc.start.column = 0;
@@ -423,6 +425,38 @@ std::set<AstRelationIdentifier> addIgnoredRelations(
     return retVal;
 }
 
+// checks whether the query of an atom with the given adornment is estimated to be at least the
+// given ratio smaller than its relation
+bool isSelectiveQuery(
+        const AstAtom* atom, const std::string& adornment, AstProfileUse* profileUse, double ratio) {
+    const AstRelationIdentifier& relName = atom->getName();
+
+    // estimate the number of queries from the distinct values of the bound arguments in the profile
+    if (profileUse->hasRelationSize(relName)) {
+        double numQueries = 1;
+        bool known = true;
+        for (size_t i = 0; i < adornment.size() && known; i++) {
+            if (adornment[i] == 'b') {
+                known = profileUse->hasDistinctValues(relName, i);
+                numQueries *= profileUse->getDistinctValues(relName, i);
+            }
+        }
+        if (known) {
+            return std::min(numQueries, double(profileUse->getRelationSize(relName))) >= ratio;
+        }
+    }
+
+    // otherwise, only a binding by a constant is known to be selective
+    std::vector<AstArgument*> arguments = atom->getArguments();
+    for (size_t i = 0; i < adornment.size(); i++) {
+        // all normalised constants begin with "+abdul" (see AstTransforms.cpp)
+        if (adornment[i] == 'b' && hasPrefix(getString(arguments[i]), "+abdul")) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /* =======================  *
  *        Adornment         *
  * =======================  */
@@ -761,6 +795,11 @@ void Adornment::run(const AstTranslationUnit& translationUnit) {
 
     // find atoms that should be ignored
     for (AstRelation* rel : program->getRelations()) {
+        // ignore subsumptive relations, as their adorned versions would keep the tuples dominated
+        if (rel->isSubsumptive()) {
+            ignoredAtoms.insert(rel->getName());
+        }
+
         for (AstClause* clause : rel->getClauses()) {
             // ignore atoms that have rules containing aggregators
             if (containsAggregators(clause)) {
@@ -781,9 +820,63 @@ void Adornment::run(const AstTranslationUnit& translationUnit) {
     // -----------------
     // --- Adornment ---
     // -----------------
-    // begin adornment algorithm
     // adornment is performed for each output query separately
-    for (auto outputQuery : outputQueries) {
+    for (const auto& outputQuery : outputQueries) {
+        adornmentClauses.push_back(adornQuery(program, outputQuery, compositeBindings));
+    }
+
+    // guard the transformation by its estimated benefit: relations which neither have a selective
+    // bound query nor depend on one are evaluated bottom-up instead of being adorned
+    if (Global::config().has("magic-guard")) {
+        auto* profileUse = translationUnit.getAnalysis<AstProfileUse>();
+        double ratio = std::stod(Global::config().get("magic-guard"));
+
+        std::set<AstRelationIdentifier> selectiveRelations;
+        for (const auto& adornedClauses : adornmentClauses) {
+            for (const AdornedClause& adornedClause : adornedClauses) {
+                std::vector<AstAtom*> atoms = adornedClause.getClause()->getAtoms();
+                std::vector<std::string> atomAdornments = adornedClause.getBodyAdornment();
+                for (size_t i = 0; i < atoms.size(); i++) {
+                    if (contains(adornmentIdb, atoms[i]->getName()) &&
+                            isSelectiveQuery(atoms[i], atomAdornments[i], profileUse, ratio)) {
+                        selectiveRelations.insert(atoms[i]->getName());
+                    }
+                }
+            }
+        }
+
+        std::set<AstRelationIdentifier> profitableRelations =
+                addBackwardDependencies(program, selectiveRelations);
+        bool pruned = false;
+        for (AstRelation* rel : program->getRelations()) {
+            if (!contains(profitableRelations, rel->getName()) && !contains(ignoredAtoms, rel->getName())) {
+                ignoredAtoms.insert(rel->getName());
+                pruned = true;
+            }
+        }
+
+        // adorn the remaining relations once more
+        if (pruned) {
+            ignoredAtoms = addForwardDependencies(program, ignoredAtoms);
+            adornmentClauses.clear();
+            for (const auto& outputQuery : outputQueries) {
+                adornmentClauses.push_back(adornQuery(program, outputQuery, compositeBindings));
+            }
+        }
+    }
+
+    this->bindings = std::move(compositeBindings);
+}
+
+std::vector<AdornedClause> Adornment::adornQuery(const AstProgram* program,
+        const AstRelationIdentifier& outputQuery, BindingStore& compositeBindings) {
+    bool subsumptive = Global::config().has("magic-subsumptive");
+
+    // the adornment demanded of each relation, only weakened if subsumptive
+    std::map<AstRelationIdentifier, std::string> demandedAdornments;
+
+    while (true) {
+        bool weakened = false;
         std::vector<AdornedPredicate> currentPredicates;
         std::set<AdornedPredicate> seenPredicates;
         std::vector<AdornedClause> adornedClauses;
@@ -794,6 +887,7 @@ void Adornment::run(const AstTranslationUnit& translationUnit) {
         AdornedPredicate outputPredicate(outputQuery, frepeat);
         currentPredicates.push_back(outputPredicate);
         seenPredicates.insert(outputPredicate);
+        demandedAdornments[outputQuery] = frepeat;
 
         // keep going through the remaining predicates that need to be adorned
         while (!currentPredicates.empty()) {
@@ -866,6 +960,26 @@ void Adornment::run(const AstTranslationUnit& translationUnit) {
                     std::string atomAdornment = result.first;
                     boundArgs = result.second;
 
+                    // weaken the demanded adornment to the arguments bound in all occurrences
+                    if (subsumptive) {
+                        auto demanded = demandedAdornments.find(atomName);
+                        if (demanded == demandedAdornments.end()) {
+                            demandedAdornments[atomName] = atomAdornment;
+                        } else {
+                            std::string common = demanded->second;
+                            for (size_t i = 0; i < common.size(); i++) {
+                                if (atomAdornment[i] == 'f') {
+                                    common[i] = 'f';
+                                }
+                            }
+                            if (common != demanded->second) {
+                                demanded->second = common;
+                                weakened = true;
+                            }
+                            atomAdornment = common;
+                        }
+                    }
+
                     // check if we've already dealt with this adornment before
                     if (!contains(seenPredicates, atomName, atomAdornment)) {
                         // not seen before, so push it onto the computation list
@@ -888,11 +1002,11 @@ void Adornment::run(const AstTranslationUnit& translationUnit) {
             }
         }
 
-        // add the list of adorned clauses matching the current output relation
-        adornmentClauses.push_back(adornedClauses);
+        // repeat until the demanded adornments of all occurrences agree
+        if (!weakened) {
+            return adornedClauses;
+        }
     }
-
-    this->bindings = std::move(compositeBindings);
 }
 
 // output the adornment analysis computed
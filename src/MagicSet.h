@@ -34,6 +34,7 @@
 
 namespace souffle {
 
+class AstProgram;
 class AstTranslationUnit;
 
 class AdornedPredicate {
@@ -176,6 +177,15 @@ private:
     std::set<AstRelationIdentifier> ignoredAtoms;
     BindingStore bindings;
 
+    /**
+     * Adorns the clauses reachable from an output query. With subsumptive
+     * demand, each relation is adorned only once, binding the arguments bound
+     * in all of its occurrences; more specific demands are answered by
+     * filtering the results of the more general one.
+     */
+    std::vector<AdornedClause> adornQuery(const AstProgram* program, const AstRelationIdentifier& outputQuery,
+            BindingStore& compositeBindings);
+
 public:
     static constexpr const char* name = "adorned-clauses";
 
@@ -0,0 +1,493 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file MappedSet.h
+ *
+ * An immutable ordered set of fixed length integer tuples, stored as a
+ * sorted array that is kept in a memory-mapped file once it outgrows a
+ * bounded amount of memory, for input relations larger than the memory
+ * of the machine.
+ *
+ * Inserted tuples are collected in memory; whenever RUN_SIZE tuples are
+ * collected, they are sorted and written to a temporary file as a run. The
+ * first read operation after insertions merges the runs, the remaining
+ * tuples and the previous content into a new sorted array, which remains
+ * in memory if it is small and is written to a temporary file and mapped
+ * otherwise. Lookups are binary searches on the array, such that only the
+ * pages of the file probed are read, and the operating system may evict
+ * them again under memory pressure. The temporary files are removed from
+ * the file system as soon as they are created, such that they vanish with
+ * the process.
+ *
+ * Multiple insert operations can be conducted concurrently on a set, as can
+ * read-only operations. However, inserts and read operations may not be
+ * conducted at the same time. Since duplicates are only eliminated when
+ * the set is sorted, inserts report every tuple as new.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "CompiledTuple.h"
+#include "ParallelUtils.h"
+#include "RamTypes.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace souffle {
+
+namespace detail {
+
+/**
+ * A temporary file, written once and then mapped for reading. The file is
+ * unlinked when created; its space is released once it is destroyed.
+ */
+class TupleFile {
+public:
+    TupleFile() {
+        const char* tmp = std::getenv("TMPDIR");
+        std::string name = std::string(tmp != nullptr ? tmp : "/tmp") + "/souffle-relation-XXXXXX";
+        fd = mkstemp(&name[0]);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot create a temporary file for a relation in " + name);
+        }
+        ::unlink(name.c_str());
+    }
+
+    TupleFile(const TupleFile&) = delete;
+    TupleFile& operator=(const TupleFile&) = delete;
+
+    ~TupleFile() {
+        if (data != nullptr) {
+            munmap(data, size);
+        }
+        ::close(fd);
+    }
+
+    /** Append bytes to the file, before it is mapped */
+    void write(const void* bytes, std::size_t length) {
+        const char* pos = static_cast<const char*>(bytes);
+        while (length > 0) {
+            ssize_t written = ::write(fd, pos, length);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                throw std::runtime_error("Cannot write a temporary file of a relation");
+            }
+            pos += written;
+            length -= written;
+            size += written;
+        }
+    }
+
+    /** Map the content written for reading, probed in random order */
+    const void* map() {
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            throw std::runtime_error("Cannot map a temporary file of a relation");
+        }
+        madvise(addr, size, MADV_RANDOM);
+        data = addr;
+        return data;
+    }
+
+private:
+    int fd = -1;
+    std::size_t size = 0;
+    void* data = nullptr;
+};
+
+}  // end namespace detail
+
+/**
+ * A set of tuples of the given arity in lexicographical order, stored in a
+ * sorted array in memory or in a memory-mapped file.
+ *
+ * @tparam N the arity of the stored tuples
+ */
+template <unsigned N>
+class MappedSet {
+public:
+    using entry_type = ram::Tuple<RamDomain, N>;
+    using element_type = entry_type;
+
+    /** Iterators are pointers into the sorted array, which is followed by a sentinel entry */
+    using iterator = const entry_type*;
+    using const_iterator = iterator;
+
+    /** the number of tuples kept in memory: the size of the runs, and of the largest array in memory */
+    enum { RUN_SIZE = 1 << 22 };
+
+    /** the number of entries after the position of a hint searched before searching the whole array */
+    enum { HINT_WINDOW = 64 };
+
+    /**
+     * The hints for operations on a set, caching the position of the last
+     * tuple found in the array it was found in.
+     */
+    struct op_context {
+        const entry_type* base = nullptr;
+        const entry_type* pos = nullptr;
+    };
+
+    /**
+     * The statistics on the effectiveness of hints.
+     */
+    struct hint_statistics {
+        CacheAccessCounter inserts;
+        CacheAccessCounter contains;
+        CacheAccessCounter get_boundaries;
+    };
+
+    MappedSet() {
+        clear();
+    }
+
+    MappedSet(const MappedSet&) = delete;
+    MappedSet& operator=(const MappedSet&) = delete;
+
+    /**
+     * Inserts the given tuple into this set.
+     *
+     * @return true, since duplicates are only recognised once the set is sorted
+     */
+    bool insert(const entry_type& t) {
+        auto lease = lock.acquire();
+        (void)lease;
+        pending.push_back(t);
+        sealed.store(false, std::memory_order_relaxed);
+        if (pending.size() >= RUN_SIZE) {
+            spill();
+        }
+        return true;
+    }
+
+    bool insert(const entry_type& t, op_context& /* ctxt */) {
+        return insert(t);
+    }
+
+    /**
+     * Inserts all tuples of the given set into this set.
+     */
+    void insertAll(const MappedSet& other) {
+        if (this == &other) {
+            return;
+        }
+        for (const auto& cur : other) {
+            insert(cur);
+        }
+    }
+
+    /**
+     * Determines whether the given tuple is present in this set.
+     */
+    bool contains(const entry_type& t) const {
+        op_context ctxt;
+        return contains(t, ctxt);
+    }
+
+    /**
+     * Determines whether the given tuple is present in this set, utilizing the given hints.
+     */
+    bool contains(const entry_type& t, op_context& ctxt) const {
+        iterator pos = search(t, ctxt, hint_stats.contains, std::less<entry_type>());
+        return pos != end() && *pos == t;
+    }
+
+    /**
+     * Obtains an iterator referencing the given tuple, or the end of this set if it is not present.
+     */
+    iterator find(const entry_type& t) const {
+        op_context ctxt;
+        return find(t, ctxt);
+    }
+
+    iterator find(const entry_type& t, op_context& ctxt) const {
+        iterator pos = search(t, ctxt, hint_stats.contains, std::less<entry_type>());
+        return (pos != end() && *pos == t) ? pos : end();
+    }
+
+    /**
+     * Obtains an iterator referencing the first tuple not less than the given tuple.
+     */
+    iterator lower_bound(const entry_type& t) const {
+        op_context ctxt;
+        return lower_bound(t, ctxt);
+    }
+
+    iterator lower_bound(const entry_type& t, op_context& ctxt) const {
+        return search(t, ctxt, hint_stats.get_boundaries, std::less<entry_type>());
+    }
+
+    /**
+     * Obtains an iterator referencing the first tuple greater than the given tuple.
+     */
+    iterator upper_bound(const entry_type& t) const {
+        op_context ctxt;
+        return upper_bound(t, ctxt);
+    }
+
+    iterator upper_bound(const entry_type& t, op_context& /* ctxt */) const {
+        ensureSealed();
+        return std::upper_bound(begin(), end(), t);
+    }
+
+    /**
+     * Obtains the range of tuples sharing the first levels columns with the given tuple.
+     */
+    template <unsigned levels>
+    range<iterator> getBoundaries(const entry_type& t) const {
+        op_context ctxt;
+        return getBoundaries<levels>(t, ctxt);
+    }
+
+    template <unsigned levels>
+    range<iterator> getBoundaries(const entry_type& t, op_context& ctxt) const {
+        ensureSealed();
+        if (levels == 0) {
+            return range<iterator>(begin(), end());
+        }
+        const auto prefixLess = [](const entry_type& a, const entry_type& b) {
+            for (unsigned i = 0; i < levels; ++i) {
+                if (a[i] != b[i]) {
+                    return a[i] < b[i];
+                }
+            }
+            return false;
+        };
+        iterator a = search(t, ctxt, hint_stats.get_boundaries, prefixLess);
+        iterator b = a;
+        while (b != end() && b - a < HINT_WINDOW && !prefixLess(t, *b)) {
+            ++b;
+        }
+        if (b != end() && !prefixLess(t, *b)) {
+            b = std::upper_bound(b, end(), t, prefixLess);
+        }
+        return range<iterator>(a, b);
+    }
+
+    /**
+     * Partitions this set into approximately the given number of ranges of equal size.
+     */
+    std::vector<range<iterator>> partition(std::size_t num) const {
+        ensureSealed();
+        std::vector<range<iterator>> res;
+        const std::size_t step = std::max<std::size_t>(1, count / std::max<std::size_t>(1, num));
+        for (std::size_t i = 0; i < count; i += step) {
+            res.push_back(range<iterator>(begin() + i, begin() + std::min(count, i + step)));
+        }
+        return res;
+    }
+
+    iterator begin() const {
+        ensureSealed();
+        return first;
+    }
+
+    iterator end() const {
+        ensureSealed();
+        return first + count;
+    }
+
+    bool empty() const {
+        ensureSealed();
+        return count == 0;
+    }
+
+    std::size_t size() const {
+        ensureSealed();
+        return count;
+    }
+
+    /**
+     * Obtains an estimate of the number of bytes of memory occupied by this
+     * set, not counting the pages of its file cached by the operating system.
+     */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) + (pending.capacity() + memory.capacity()) * sizeof(entry_type) +
+               runs.size() * sizeof(detail::TupleFile);
+    }
+
+    /**
+     * Removes all tuples from this set.
+     */
+    void clear() {
+        auto lease = lock.acquire();
+        (void)lease;
+        pending = std::vector<entry_type>();
+        runs.clear();
+        file.reset();
+        memory.assign(1, entry_type());
+        first = memory.data();
+        count = 0;
+        sealed.store(true, std::memory_order_release);
+    }
+
+    const hint_statistics& getHintStatistics() const {
+        return hint_stats;
+    }
+
+private:
+    /** A sorted sequence of tuples */
+    using Run = std::pair<const entry_type*, const entry_type*>;
+
+    /**
+     * Obtains the first tuple not less than the given one by the given order,
+     * searching the entries following the hint first.
+     */
+    template <typename Less>
+    iterator search(const entry_type& t, op_context& ctxt, CacheAccessCounter& counter, Less less) const {
+        ensureSealed();
+        if (ctxt.base == first && ctxt.pos != nullptr && !less(t, *ctxt.pos)) {
+            iterator limit = std::min(end(), ctxt.pos + HINT_WINDOW);
+            if (limit == end() || less(t, *limit)) {
+                counter.addHit();
+                ctxt.pos = std::lower_bound(ctxt.pos, limit, t, less);
+                return ctxt.pos;
+            }
+        }
+        counter.addMiss();
+        ctxt.base = first;
+        ctxt.pos = std::lower_bound(begin(), end(), t, less);
+        return ctxt.pos;
+    }
+
+    /** Sorts the collected tuples and writes them to a file of their own */
+    void spill() {
+        sortPending();
+        std::unique_ptr<detail::TupleFile> run(new detail::TupleFile());
+        run->write(pending.data(), pending.size() * sizeof(entry_type));
+        runs.push_back(std::make_pair(std::move(run), pending.size()));
+        pending = std::vector<entry_type>();
+    }
+
+    void sortPending() {
+        std::sort(pending.begin(), pending.end());
+        pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+    }
+
+    /** Merges the runs, the collected tuples and the content into the sorted array, if required */
+    void ensureSealed() const {
+        if (sealed.load(std::memory_order_acquire)) {
+            return;
+        }
+        auto lease = lock.acquire();
+        (void)lease;
+        if (!sealed.load(std::memory_order_relaxed)) {
+            const_cast<MappedSet*>(this)->seal();
+            sealed.store(true, std::memory_order_release);
+        }
+    }
+
+    void seal() {
+        sortPending();
+        std::vector<Run> sources;
+        std::size_t total = count + pending.size();
+        sources.push_back(Run(first, first + count));
+        sources.push_back(Run(pending.data(), pending.data() + pending.size()));
+        for (auto& run : runs) {
+            const auto* data = static_cast<const entry_type*>(run.first->map());
+            sources.push_back(Run(data, data + run.second));
+            total += run.second;
+        }
+
+        // small sets remain in memory
+        if (runs.empty() && file == nullptr && total <= RUN_SIZE) {
+            std::vector<entry_type> merged;
+            merged.reserve(total + 1);
+            std::set_union(first, first + count, pending.begin(), pending.end(), std::back_inserter(merged));
+            count = merged.size();
+            merged.push_back(entry_type());
+            memory.swap(merged);
+            first = memory.data();
+            pending = std::vector<entry_type>();
+            return;
+        }
+
+        // merge all sources into a new file, eliminating duplicates
+        std::unique_ptr<detail::TupleFile> merged(new detail::TupleFile());
+        const auto greater = [](const Run& a, const Run& b) { return *b.first < *a.first; };
+        std::priority_queue<Run, std::vector<Run>, decltype(greater)> queue(greater);
+        for (const auto& source : sources) {
+            if (source.first != source.second) {
+                queue.push(source);
+            }
+        }
+        std::vector<entry_type> buffer;
+        buffer.reserve(1 << 16);
+        std::size_t merged_count = 0;
+        while (!queue.empty()) {
+            Run top = queue.top();
+            queue.pop();
+            if (buffer.empty() || !(buffer.back() == *top.first)) {
+                if (buffer.size() == buffer.capacity()) {
+                    // keep the last entry for the elimination of duplicates
+                    merged->write(buffer.data(), (buffer.size() - 1) * sizeof(entry_type));
+                    merged_count += buffer.size() - 1;
+                    buffer.erase(buffer.begin(), buffer.end() - 1);
+                }
+                buffer.push_back(*top.first);
+            }
+            if (++top.first != top.second) {
+                queue.push(top);
+            }
+        }
+        merged_count += buffer.size();
+        buffer.push_back(entry_type());
+        merged->write(buffer.data(), buffer.size() * sizeof(entry_type));
+
+        first = static_cast<const entry_type*>(merged->map());
+        count = merged_count;
+        file = std::move(merged);
+        runs.clear();
+        memory = std::vector<entry_type>();
+        pending = std::vector<entry_type>();
+    }
+
+    /** a lock synchronizing insertions and the sorting of the set */
+    mutable Lock lock;
+
+    /** the tuples inserted since the set was last sorted, in the order of their insertion */
+    std::vector<entry_type> pending;
+
+    /** the files of sorted runs of tuples inserted since the set was last sorted, and their sizes */
+    std::vector<std::pair<std::unique_ptr<detail::TupleFile>, std::size_t>> runs;
+
+    /** the sorted array, in memory or in the mapped file, followed by a sentinel entry */
+    std::vector<entry_type> memory;
+    std::unique_ptr<detail::TupleFile> file;
+    const entry_type* first = nullptr;
+    std::size_t count = 0;
+
+    /** whether the array holds all tuples inserted */
+    mutable std::atomic<bool> sealed{true};
+
+    /** the statistics of hints */
+    mutable hint_statistics hint_stats;
+};
+
+}  // end namespace souffle
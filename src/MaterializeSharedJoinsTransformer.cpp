@@ -0,0 +1,309 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file MaterializeSharedJoinsTransformer.cpp
+ *
+ * Define classes and functionality related to the materialisation of
+ * join prefixes shared by several rules.
+ *
+ ***********************************************************************/
+
+#include "AstArgument.h"
+#include "AstAttribute.h"
+#include "AstClause.h"
+#include "AstLiteral.h"
+#include "AstProfileUse.h"
+#include "AstProgram.h"
+#include "AstRelation.h"
+#include "AstRelationIdentifier.h"
+#include "AstTransforms.h"
+#include "AstTranslationUnit.h"
+#include "AstVisitor.h"
+#include "PrecedenceGraph.h"
+#include "Util.h"
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace {
+
+/** A rule starting with a shared join prefix */
+struct PrefixOccurrence {
+    /** the rule */
+    const AstClause* clause;
+
+    /**
+     * the slot of each argument of the prefix, or -1 for constants; a joined
+     * variable has a single slot, every other argument a slot of its own
+     */
+    std::vector<int> slots;
+
+    /** the names of the variables of the slots in the rule, empty for unnamed variables */
+    std::vector<std::string> variables;
+
+    /** whether the variable of a slot is used by the rest of the rule */
+    std::vector<bool> used;
+};
+
+/**
+ * Computes the canonical form of the join of the first two atoms of a rule,
+ * in which the joined variables are numbered in the order of their first
+ * appearance and all other variables are unnamed. Only joins of relations
+ * computed in earlier strata than the head over plain variables and constants
+ * are considered.
+ *
+ * @return the canonical form, or an empty string if the rule has no such prefix
+ */
+std::string getJoinPrefix(const AstProgram& program, const SCCGraph& sccGraph, const AstClause& clause,
+        PrefixOccurrence& occurrence) {
+    std::vector<AstAtom*> atoms = clause.getAtoms();
+    if (atoms.size() < 2 || clause.getExecutionPlan() != nullptr) {
+        return "";
+    }
+
+    const AstRelation* head = program.getRelation(clause.getHead()->getName());
+    if (head == nullptr) {
+        return "";
+    }
+
+    // count the appearances of each variable in the prefix
+    std::map<std::string, size_t> appearances;
+    for (size_t i = 0; i < 2; i++) {
+        const AstRelation* rel = program.getRelation(atoms[i]->getName());
+        if (rel == nullptr || sccGraph.getSCC(rel) == sccGraph.getSCC(head)) {
+            return "";
+        }
+        for (const AstArgument* arg : atoms[i]->getArguments()) {
+            if (const auto* var = dynamic_cast<const AstVariable*>(arg)) {
+                appearances[var->getName()]++;
+            } else if (dynamic_cast<const AstUnnamedVariable*>(arg) == nullptr &&
+                       dynamic_cast<const AstConstant*>(arg) == nullptr) {
+                return "";
+            }
+        }
+    }
+
+    std::stringstream key;
+    std::map<std::string, int> joinSlots;
+    bool joined = false;
+    for (size_t i = 0; i < 2; i++) {
+        key << atoms[i]->getName() << "(";
+        for (const AstArgument* arg : atoms[i]->getArguments()) {
+            const auto* var = dynamic_cast<const AstVariable*>(arg);
+            if (var != nullptr && appearances[var->getName()] > 1) {
+                auto pos = joinSlots.find(var->getName());
+                if (pos == joinSlots.end()) {
+                    pos = joinSlots.insert(std::make_pair(var->getName(), occurrence.variables.size())).first;
+                    occurrence.variables.push_back(var->getName());
+                } else if (i == 1) {
+                    joined = true;
+                }
+                occurrence.slots.push_back(pos->second);
+                key << "$" << pos->second;
+            } else if (var != nullptr || dynamic_cast<const AstUnnamedVariable*>(arg) != nullptr) {
+                occurrence.slots.push_back(occurrence.variables.size());
+                occurrence.variables.push_back(var != nullptr ? var->getName() : "");
+                key << "_";
+            } else {
+                occurrence.slots.push_back(-1);
+                key << *arg;
+            }
+            key << ",";
+        }
+        key << ")";
+    }
+
+    // a cross product is never worth storing
+    if (!joined) {
+        return "";
+    }
+
+    // find the variables of the prefix needed by the rest of the rule
+    std::set<std::string> usedVariables;
+    visitDepthFirst(*clause.getHead(), [&](const AstVariable& var) { usedVariables.insert(var.getName()); });
+    for (const AstLiteral* lit : clause.getBodyLiterals()) {
+        if (lit != atoms[0] && lit != atoms[1]) {
+            visitDepthFirst(*lit, [&](const AstVariable& var) { usedVariables.insert(var.getName()); });
+        }
+    }
+    for (const std::string& var : occurrence.variables) {
+        occurrence.used.push_back(!var.empty() && contains(usedVariables, var));
+    }
+
+    occurrence.clause = &clause;
+    return key.str();
+}
+
+/**
+ * Estimates whether materialising a join shared by the given number of rules
+ * saves work. Each rule evaluating the join on its own scans the first atom and
+ * enumerates the join result; the materialised join is computed and stored once
+ * and then only its result is scanned by each rule. This pays off if twice the
+ * size of the join is smaller than the scans of the first atom saved. Without
+ * profile data, the join is assumed to be as large as its first atom.
+ */
+bool isProfitable(const AstAtom& first, const AstAtom& second, size_t numRules, AstProfileUse& profileUse) {
+    const AstRelationIdentifier& firstName = first.getName();
+    const AstRelationIdentifier& secondName = second.getName();
+    if (!profileUse.hasRelationSize(firstName) || !profileUse.hasRelationSize(secondName)) {
+        return numRules > 3;
+    }
+    double firstSize = profileUse.getRelationSize(firstName);
+    double secondSize = profileUse.getRelationSize(secondName);
+
+    // estimate the join size by the most selective pair of joined columns
+    double joinSize = firstSize * secondSize;
+    std::vector<AstArgument*> firstArgs = first.getArguments();
+    std::vector<AstArgument*> secondArgs = second.getArguments();
+    for (size_t i = 0; i < firstArgs.size(); i++) {
+        for (size_t j = 0; j < secondArgs.size(); j++) {
+            const auto* firstVar = dynamic_cast<const AstVariable*>(firstArgs[i]);
+            const auto* secondVar = dynamic_cast<const AstVariable*>(secondArgs[j]);
+            if (firstVar == nullptr || secondVar == nullptr || firstVar->getName() != secondVar->getName() ||
+                    !profileUse.hasDistinctValues(firstName, i) ||
+                    !profileUse.hasDistinctValues(secondName, j)) {
+                continue;
+            }
+            double distinct = std::max(profileUse.getDistinctValues(firstName, i),
+                    profileUse.getDistinctValues(secondName, j));
+            joinSize = std::min(joinSize, firstSize * secondSize / std::max(distinct, 1.0));
+        }
+    }
+
+    return 2 * joinSize < (numRules - 1) * firstSize;
+}
+
+}  // namespace
+
+bool MaterializeSharedJoinsTransformer::transform(AstTranslationUnit& translationUnit) {
+    AstProgram& program = *translationUnit.getProgram();
+    auto* sccGraph = translationUnit.getAnalysis<SCCGraph>();
+    auto* profileUse = translationUnit.getAnalysis<AstProfileUse>();
+
+    // group the rules by their join prefixes
+    std::map<std::string, std::vector<PrefixOccurrence>> prefixes;
+    for (const AstRelation* rel : program.getRelations()) {
+        for (const AstClause* clause : rel->getClauses()) {
+            PrefixOccurrence occurrence;
+            std::string key = getJoinPrefix(program, *sccGraph, *clause, occurrence);
+            if (!key.empty()) {
+                prefixes[key].push_back(occurrence);
+            }
+        }
+    }
+
+    bool changed = false;
+    int counter = 0;
+    for (const auto& prefix : prefixes) {
+        const std::vector<PrefixOccurrence>& occurrences = prefix.second;
+        if (occurrences.size() < 2) {
+            continue;
+        }
+        const PrefixOccurrence& representative = occurrences.front();
+        std::vector<AstAtom*> atoms = representative.clause->getAtoms();
+        if (!isProfitable(*atoms[0], *atoms[1], occurrences.size(), *profileUse)) {
+            continue;
+        }
+        changed = true;
+
+        // the materialised join keeps the variables used by any of the rules
+        std::vector<size_t> columns;
+        for (size_t i = 0; i < representative.variables.size(); i++) {
+            for (const PrefixOccurrence& occurrence : occurrences) {
+                if (occurrence.used[i]) {
+                    columns.push_back(i);
+                    break;
+                }
+            }
+        }
+
+        // -- build the relation and its rule --
+
+        std::string relName = "+shared" + toString(counter++);
+        while (program.getRelation(relName) != nullptr) {
+            relName = "+shared" + toString(counter++);
+        }
+
+        // the arguments of the prefix refer to the slots by fresh variables
+        auto* sharedClause = new AstClause();
+        sharedClause->setSrcLoc(representative.clause->getSrcLoc());
+        std::vector<AstTypeIdentifier> attributeTypes(representative.variables.size());
+        size_t pos = 0;
+        for (size_t i = 0; i < 2; i++) {
+            const AstRelation* atomRel = program.getRelation(atoms[i]->getName());
+            std::unique_ptr<AstAtom> atom(atoms[i]->clone());
+            for (size_t j = 0; j < atom->getArity(); j++, pos++) {
+                int slot = representative.slots[pos];
+                if (slot < 0) {
+                    continue;
+                }
+                const std::vector<int>& slots = representative.slots;
+                bool isJoined = std::count(slots.begin(), slots.end(), slot) > 1;
+                if (isJoined || contains(columns, size_t(slot))) {
+                    atom->setArgument(j, std::make_unique<AstVariable>("x" + toString(slot)));
+                } else {
+                    atom->setArgument(j, std::make_unique<AstUnnamedVariable>());
+                }
+                attributeTypes[slot] = atomRel->getAttribute(j)->getTypeName();
+            }
+            sharedClause->addToBody(std::move(atom));
+        }
+
+        auto* rel = new AstRelation();
+        rel->setName(relName);
+        rel->setSrcLoc(representative.clause->getSrcLoc());
+        auto* head = new AstAtom(relName);
+        for (size_t column : columns) {
+            std::string var = "x" + toString(column);
+            rel->addAttribute(std::make_unique<AstAttribute>(var, attributeTypes[column]));
+            head->addArgument(std::make_unique<AstVariable>(var));
+        }
+        sharedClause->setHead(std::unique_ptr<AstAtom>(head));
+        rel->addClause(std::unique_ptr<AstClause>(sharedClause));
+        program.appendRelation(std::unique_ptr<AstRelation>(rel));
+
+        // -- replace the prefix of each rule by the materialised join --
+
+        for (const PrefixOccurrence& occurrence : occurrences) {
+            std::unique_ptr<AstClause> newClause(occurrence.clause->cloneHead());
+            auto* sharedAtom = new AstAtom(relName);
+            for (size_t column : columns) {
+                const std::string& var = occurrence.variables[column];
+                if (var.empty()) {
+                    sharedAtom->addArgument(std::make_unique<AstUnnamedVariable>());
+                } else {
+                    sharedAtom->addArgument(std::make_unique<AstVariable>(var));
+                }
+            }
+            newClause->addToBody(std::unique_ptr<AstLiteral>(sharedAtom));
+
+            std::vector<AstAtom*> oldAtoms = occurrence.clause->getAtoms();
+            for (const AstLiteral* lit : occurrence.clause->getBodyLiterals()) {
+                if (lit != oldAtoms[0] && lit != oldAtoms[1]) {
+                    newClause->addToBody(std::unique_ptr<AstLiteral>(lit->clone()));
+                }
+            }
+
+            program.removeClause(occurrence.clause);
+            program.appendClause(std::move(newClause));
+        }
+    }
+
+    return changed;
+}
+
+}  // end of namespace souffle
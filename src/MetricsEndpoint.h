@@ -0,0 +1,272 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file MetricsEndpoint.h
+ *
+ * An HTTP endpoint exposing the progress of a running program to monitoring
+ * systems in the text exposition format of Prometheus.
+ *
+ * The metrics are gathered from the events of the profile as they are
+ * recorded: the sizes of relations from their size and timer events, the
+ * strata from the memory events at the end of each stratum, and the number
+ * of strata from the configuration. Any request is answered by the metrics,
+ * such that the endpoint may be scraped at any path.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ProfileStream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace souffle {
+
+class MetricsEndpoint {
+public:
+    static MetricsEndpoint& instance() {
+        static MetricsEndpoint endpoint;
+        return endpoint;
+    }
+
+    ~MetricsEndpoint() {
+        if (server.joinable()) {
+            stopped.store(true);
+            shutdown(listener, SHUT_RDWR);
+            server.join();
+            close(listener);
+        }
+    }
+
+    /** Serves the metrics at the given address, [HOST:]PORT or unix:PATH, from now on */
+    void listen(const std::string& address) {
+        listener = profile::openProfileSocket(address, true);
+        enabled.store(true);
+        server = std::thread([this]() {
+            while (!stopped.load()) {
+                int connection = accept(listener, nullptr, nullptr);
+                if (connection < 0) {
+                    continue;
+                }
+                respond(connection);
+                close(connection);
+            }
+        });
+    }
+
+    bool isEnabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /** Observes a timing event of the profile, carrying the number of tuples inserted in its scope */
+    void observeTiming(const std::string& txt, size_t tuples, size_t iteration) {
+        // the timers of relations cover the insertions of all their rules
+        const bool recursive = isEvent(txt, "@t-recursive-relation;");
+        if (!recursive && !isEvent(txt, "@t-nonrecursive-relation;")) {
+            return;
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        inserted += tuples;
+        if (recursive) {
+            // the tuples of an iteration are those new to the relation
+            relationSizes[getRelation(txt)] += tuples;
+            if (iteration != this->iteration) {
+                this->iteration = iteration;
+                newTuples = 0;
+            }
+            newTuples += tuples;
+            peakTuples = std::max(peakTuples, newTuples);
+        }
+    }
+
+    /** Observes a quantity event of the profile */
+    void observeQuantity(const std::string& txt, size_t number, size_t iteration) {
+        if (isEvent(txt, "@n-nonrecursive-relation;")) {
+            std::lock_guard<std::mutex> guard(lock);
+            relationSizes[getRelation(txt)] = number;
+        } else if (txt == "@memory;symbols" || txt == "@memory;records") {
+            // the memory of the program is recorded at the end of each stratum
+            std::lock_guard<std::mutex> guard(lock);
+            (txt == "@memory;symbols" ? symbolBytes : recordBytes) = number;
+            if (completed.insert(iteration).second) {
+                this->iteration = 0;
+                newTuples = 0;
+                peakTuples = 0;
+            }
+        }
+    }
+
+    /** Observes a configuration record of the profile */
+    void observeConfig(const std::string& key, const std::string& value) {
+        if (key == "strataCount") {
+            std::lock_guard<std::mutex> guard(lock);
+            numStrata = std::stoul(value);
+        }
+    }
+
+    /** Prints the metrics in the text exposition format */
+    void print(std::ostream& os) {
+        std::lock_guard<std::mutex> guard(lock);
+        const auto time = std::chrono::steady_clock::now();
+        const double cpu = getCpuSeconds();
+        const double elapsed = std::chrono::duration<double>(time - lastScrape).count();
+        const double rate = (elapsed > 0) ? (inserted - lastInserted) / elapsed : 0;
+        const double utilisation = (elapsed > 0) ? (cpu - lastCpu) / elapsed / getNumThreads() : 0;
+        lastScrape = time;
+        lastInserted = inserted;
+        lastCpu = cpu;
+
+        // the strata are completed in order unless evaluated concurrently
+        const size_t stratum = completed.empty() ? 0 : *completed.rbegin() + 1;
+        printMetric(os, "souffle_stratum", "gauge", "The stratum being evaluated.", stratum);
+        printMetric(os, "souffle_strata", "gauge", "The number of strata of the program.", numStrata);
+        printMetric(os, "souffle_strata_completed", "gauge", "The number of strata evaluated.",
+                completed.size());
+        printMetric(os, "souffle_iteration", "gauge",
+                "The iteration of the recursive stratum being evaluated.", iteration);
+
+        // the new tuples of a fixpoint grow and shrink again, their decline approximating the progress
+        printHeader(os, "souffle_stratum_progress", "gauge",
+                "The estimated progress of each stratum from 0 to 1.");
+        for (size_t i : completed) {
+            os << "souffle_stratum_progress{stratum=\"" << i << "\"} 1\n";
+        }
+        if (stratum < numStrata && completed.count(stratum) == 0) {
+            const double progress = (peakTuples > 0) ? 1.0 - double(newTuples) / peakTuples : 0;
+            os << "souffle_stratum_progress{stratum=\"" << stratum << "\"} " << progress << "\n";
+        }
+
+        printHeader(os, "souffle_relation_tuples", "gauge", "The number of tuples of each relation.");
+        for (const auto& cur : relationSizes) {
+            os << "souffle_relation_tuples{relation=\"" << escape(cur.first) << "\"} " << cur.second << "\n";
+        }
+        printMetric(
+                os, "souffle_tuples_inserted_total", "counter", "The number of tuples inserted.", inserted);
+        printMetric(os, "souffle_tuples_inserted_per_second", "gauge",
+                "The tuples inserted per second since the previous scrape.", rate);
+        printMetric(os, "souffle_symbol_table_bytes", "gauge",
+                "The memory of the symbol table at the end of the last stratum.", symbolBytes);
+        printMetric(os, "souffle_record_bytes", "gauge",
+                "The memory of the records at the end of the last stratum.", recordBytes);
+        printMetric(os, "souffle_cpu_seconds_total", "counter", "The CPU time used by all threads.", cpu);
+        printMetric(os, "souffle_thread_utilisation", "gauge",
+                "The share of the time of the threads spent computing since the previous scrape.",
+                utilisation);
+    }
+
+private:
+    MetricsEndpoint() = default;
+
+    /** Answers a request of a connection by the metrics, ignoring its path */
+    void respond(int connection) {
+        char buffer[4096];
+        if (read(connection, buffer, sizeof(buffer)) <= 0) {
+            return;
+        }
+        std::stringstream body;
+        print(body);
+        std::stringstream response;
+        response << "HTTP/1.1 200 OK\r\n"
+                 << "Content-Type: text/plain; version=0.0.4\r\n"
+                 << "Content-Length: " << body.str().size() << "\r\n"
+                 << "Connection: close\r\n\r\n"
+                 << body.str();
+        profile::sendProfileData(connection, response.str());
+    }
+
+    static bool isEvent(const std::string& txt, const char* prefix) {
+        return txt.compare(0, std::char_traits<char>::length(prefix), prefix) == 0;
+    }
+
+    /** Obtains the relation of an event, its second field */
+    static std::string getRelation(const std::string& txt) {
+        size_t begin = txt.find(';') + 1;
+        return txt.substr(begin, txt.find(';', begin) - begin);
+    }
+
+    static std::string escape(const std::string& str) {
+        std::string res;
+        for (char c : str) {
+            if (c == '"' || c == '\\') {
+                res += '\\';
+            }
+            res += c;
+        }
+        return res;
+    }
+
+    static double getCpuSeconds() {
+        struct rusage ru {};
+        getrusage(RUSAGE_SELF, &ru);
+        return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+    }
+
+    static size_t getNumThreads() {
+#ifdef _OPENMP
+        return omp_get_max_threads();
+#else
+        return 1;
+#endif
+    }
+
+    static void printHeader(std::ostream& os, const char* name, const char* type, const char* help) {
+        os << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    }
+
+    template <typename T>
+    static void printMetric(std::ostream& os, const char* name, const char* type, const char* help, T value) {
+        printHeader(os, name, type, help);
+        os << name << " " << value << "\n";
+    }
+
+    std::atomic<bool> enabled{false};
+    std::atomic<bool> stopped{false};
+    int listener{-1};
+    std::thread server;
+
+    // guards the metrics, observed by the threads of the evaluation and read by the server
+    std::mutex lock;
+
+    std::map<std::string, size_t> relationSizes;
+    size_t inserted = 0;
+    size_t numStrata = 0;
+    std::set<size_t> completed;
+    size_t symbolBytes = 0;
+    size_t recordBytes = 0;
+
+    // the current iteration of a recursive stratum, its new tuples and the most new tuples of an iteration
+    size_t iteration = 0;
+    size_t newTuples = 0;
+    size_t peakTuples = 0;
+
+    // the state of the previous scrape, for the rates since
+    std::chrono::steady_clock::time_point lastScrape = std::chrono::steady_clock::now();
+    size_t lastInserted = 0;
+    double lastCpu = 0;
+};
+
+}  // end of namespace souffle
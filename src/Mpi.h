@@ -16,14 +16,29 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
 #include <functional>
+#include <iterator>
+#include <list>
 #include <memory>
 #include <set>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include <fcntl.h>
 #include <mpi.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace souffle {
 
@@ -187,10 +202,78 @@ inline void unpack<std::vector<std::string>>(
 }
 }  // namespace
 
+/* communicators */
+namespace {
+
+/**
+ * The communicator relations are streamed on. It is separate from the one of the
+ * symbol table requests handled by the master process, such that the relations
+ * may be sent to the master process while it still handles requests.
+ */
+inline MPI_Comm& relations() {
+    static MPI_Comm comm = MPI_COMM_WORLD;
+    return comm;
+}
+
+/**
+ * The communicator of the requests to the shards of a distributed symbol table, which are
+ * served by a thread of each rank while the rank evaluates its strata.
+ */
+inline MPI_Comm& shardRequests() {
+    static MPI_Comm comm = MPI_COMM_WORLD;
+    return comm;
+}
+
+/** The communicator of the replies of the shards, such that a serving thread never receives them */
+inline MPI_Comm& shardReplies() {
+    static MPI_Comm comm = MPI_COMM_WORLD;
+    return comm;
+}
+
+/** The communicator of the ranks on the node of this rank */
+inline MPI_Comm& node() {
+    static MPI_Comm comm = MPI_COMM_SELF;
+    return comm;
+}
+
+/** The node of each rank, given by the lowest rank on it; empty unless initialized by init */
+inline std::vector<int>& nodeOfRanks() {
+    static std::vector<int> nodes;
+    return nodes;
+}
+
+/** An identifier of the run, shared by all ranks, which names its shared memory segments */
+inline uint64_t& runId() {
+    static uint64_t id = 0;
+    return id;
+}
+}  // namespace
+
 /* init */
 namespace {
 inline int init(int argc, char* argv[]) {
-    auto flag = MPI_Init(&argc, &argv);
+    // the shard of the symbol table is served by a thread of its own
+    int provided;
+    auto flag = MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    if (provided < MPI_THREAD_MULTIPLE) {
+        throw std::runtime_error("MPI implementation does not support MPI_THREAD_MULTIPLE.");
+    }
+    MPI_Comm_dup(MPI_COMM_WORLD, &relations());
+    MPI_Comm_dup(MPI_COMM_WORLD, &shardRequests());
+    MPI_Comm_dup(MPI_COMM_WORLD, &shardReplies());
+
+    // the ranks of a node are ordered by their rank in the world, the first one naming the node
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node());
+    int first = rank;
+    MPI_Bcast(&first, 1, MPI_INT, 0, node());
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    nodeOfRanks().resize(size);
+    MPI_Allgather(&first, 1, MPI_INT, nodeOfRanks().data(), 1, MPI_INT, MPI_COMM_WORLD);
+    runId() = (static_cast<uint64_t>(getpid()) << 32) ^ static_cast<uint64_t>(time(nullptr));
+    MPI_Bcast(&runId(), 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
     return flag;
 }
 }  // namespace
@@ -199,6 +282,17 @@ inline int init(int argc, char* argv[]) {
 namespace {
 
 inline void finalize() {
+    for (MPI_Comm* comm : {&relations(), &shardRequests(), &shardReplies()}) {
+        if (*comm != MPI_COMM_WORLD) {
+            MPI_Comm_free(comm);
+            *comm = MPI_COMM_WORLD;
+        }
+    }
+    if (node() != MPI_COMM_SELF) {
+        MPI_Comm_free(&node());
+        node() = MPI_COMM_SELF;
+    }
+    nodeOfRanks().clear();
     MPI_Finalize();
 }
 }  // namespace
@@ -240,6 +334,12 @@ inline Status probe() {
 inline Status probe(const Status& status) {
     return probe(status->MPI_SOURCE, status->MPI_TAG);
 }
+
+inline Status probe(const int source, const int tag, const MPI_Comm comm) {
+    auto status = Status(new MPI_Status());
+    MPI_Probe(source, tag, comm, status.get());
+    return status;
+}
 }  // namespace
 
 /* iprobe */
@@ -280,6 +380,19 @@ inline void send<std::string>(const std::vector<std::string>& data, const int de
     send(&newData[0], (int)newData.size(), MPI_PACKED, destination, tag, MPI_COMM_WORLD);
 }
 
+template <typename S>
+inline void send(const std::vector<S>& data, const int destination, const int tag, const MPI_Comm comm) {
+    send(data.data(), (int)data.size(), datatype<S>(), destination, tag, comm);
+}
+
+template <>
+inline void send<std::string>(
+        const std::vector<std::string>& data, const int destination, const int tag, const MPI_Comm comm) {
+    std::vector<char> newData;
+    pack(data, newData);
+    send(newData.data(), (int)newData.size(), MPI_PACKED, destination, tag, comm);
+}
+
 template <>
 inline void send<bool>(const std::vector<bool>& data, const int destination, const int tag) {
     // TODO (lyndonhenry): should pack vector of bools as a bitvector
@@ -387,6 +500,23 @@ inline void recv<std::string>(std::vector<std::string>& data, Status& status) {
     unpack(newData, data);
 }
 
+template <typename R>
+inline void recv(std::vector<R>& data, Status& status, const MPI_Comm comm) {
+    assert(status);
+    int count = getCount<R>(status);
+    data.resize((size_t)count);
+    recv(data.data(), count, datatype<R>(), status->MPI_SOURCE, status->MPI_TAG, comm, status.get());
+}
+
+template <>
+inline void recv<std::string>(std::vector<std::string>& data, Status& status, const MPI_Comm comm) {
+    assert(status);
+    int count = getCount<char>(status);
+    std::vector<char> newData((size_t)count);
+    recv(newData.data(), count, MPI_PACKED, status->MPI_SOURCE, status->MPI_TAG, comm, status.get());
+    unpack(newData, data);
+}
+
 template <>
 inline void recv<bool>(std::vector<bool>& data, Status& status) {
     // TODO (lyndonhenry): should pack vector of bools as a bitvector
@@ -466,5 +596,590 @@ inline void recv(T& data, const size_t length, Status& status) {
     }
 }
 }  // namespace
+
+/* streaming */
+namespace {
+
+/** The size the chunks of streamed relations are filled up to, in bytes */
+constexpr size_t STREAM_CHUNK_BYTES = 1 << 20;
+
+/** The encodings of a chunk of a streamed relation, given by its first byte */
+enum StreamEncoding : char { RAW = 0, DELTA = 1 };
+
+/** The largest number of bytes of an encoded tuple */
+template <typename S>
+inline size_t maxTupleBytes(const size_t length) {
+    // a variable-length integer carries seven bits per byte
+    return length * std::max(sizeof(S), (sizeof(S) * 8 + 6) / 7);
+}
+
+/** The capacity of the buffers receiving the chunks of a relation of the given arity */
+template <typename S>
+inline size_t streamChunkCapacity(const size_t length) {
+    return std::max(STREAM_CHUNK_BYTES, 1 + maxTupleBytes<S>(length));
+}
+
+/**
+ * Append an element to a chunk. A delta-encoded element is the difference to the same element of the
+ * previous tuple of the chunk, zig-zag mapped to an unsigned number and written as a variable-length
+ * integer, which takes a single byte for the small differences of the leading elements of sorted tuples.
+ */
+template <typename S>
+inline void encode(std::vector<char>& buffer, const S element, S& previous, const bool delta) {
+    using U = typename std::make_unsigned<S>::type;
+    if (!delta) {
+        const char* bytes = reinterpret_cast<const char*>(&element);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(S));
+        return;
+    }
+    U difference = static_cast<U>(element) - static_cast<U>(previous);
+    U value = (difference << 1) ^ static_cast<U>(-static_cast<S>(difference >> (sizeof(S) * 8 - 1)));
+    previous = element;
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+/** Read an element of a chunk, reversing encode */
+template <typename S>
+inline S decode(const char*& pos, S& previous, const bool delta) {
+    using U = typename std::make_unsigned<S>::type;
+    if (!delta) {
+        S element;
+        std::memcpy(&element, pos, sizeof(S));
+        pos += sizeof(S);
+        return element;
+    }
+    U value = 0;
+    for (size_t shift = 0;; shift += 7) {
+        auto byte = static_cast<unsigned char>(*pos++);
+        value |= static_cast<U>(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            break;
+        }
+    }
+    U difference = (value >> 1) ^ (U(0) - (value & 1));
+    previous = static_cast<S>(static_cast<U>(previous) + difference);
+    return previous;
+}
+
+/** A chunk that is still being sent by a detached stream */
+struct PendingChunk {
+    std::vector<char> buffer;
+    std::vector<MPI_Request> requests;
+};
+
+/**
+ * Whether streams are detached, i.e. return once all chunks are posted rather than
+ * once they are received. This is required if ranks evaluate several strata, whose
+ * receivers may only get to a relation after a later stratum of the sender.
+ */
+inline bool& detachSends() {
+    static bool detached = false;
+    return detached;
+}
+
+/** The chunks of detached streams still being sent */
+inline std::list<PendingChunk>& pendingChunks() {
+    static std::list<PendingChunk> chunks;
+    return chunks;
+}
+
+/** Free the chunks of detached streams that have been sent */
+inline void reapSends() {
+    auto& chunks = pendingChunks();
+    for (auto it = chunks.begin(); it != chunks.end();) {
+        int done;
+        MPI_Testall(static_cast<int>(it->requests.size()), it->requests.data(), &done, MPI_STATUSES_IGNORE);
+        it = done ? chunks.erase(it) : std::next(it);
+    }
+}
+
+/** Wait for all chunks of detached streams to be sent */
+inline void finishSends() {
+    for (auto& chunk : pendingChunks()) {
+        MPI_Waitall(static_cast<int>(chunk.requests.size()), chunk.requests.data(), MPI_STATUSES_IGNORE);
+    }
+    pendingChunks().clear();
+}
+
+/**
+ * Send the tuples of a relation to the given destinations as a stream of chunks, terminated by an empty
+ * message. Each chunk is sent without blocking while the next one is encoded, such that at most two chunks
+ * are held at a time rather than a copy of the whole relation, unless streams are detached; the chunks are
+ * delta-encoded if compressed. A nullary relation is sent as a single empty chunk if it holds the tuple.
+ */
+template <typename S, typename T>
+inline void sendStream(const T& data, const size_t length, const std::set<int>& destinations, const int tag,
+        const bool compress) {
+    const size_t capacity = streamChunkCapacity<S>(length);
+    const char encoding = compress ? DELTA : RAW;
+    const bool detached = detachSends();
+    std::vector<char> buffers[2];
+    std::vector<MPI_Request> requests[2];
+    std::vector<S> previous(length, 0);
+    int current = 0;
+    buffers[current].reserve(capacity);
+    buffers[current].push_back(encoding);
+
+    // post the current chunk, or the terminating empty message, and wait for the other one to be sent
+    auto post = [&](const bool last) {
+        const int size = last ? 0 : static_cast<int>(buffers[current].size());
+        std::vector<char>* buffer = &buffers[current];
+        std::vector<MPI_Request>* pending = &requests[current];
+        if (detached) {
+            reapSends();
+            pendingChunks().emplace_back();
+            pendingChunks().back().buffer.swap(buffers[current]);
+            buffer = &pendingChunks().back().buffer;
+            pending = &pendingChunks().back().requests;
+        }
+        for (const auto destination : destinations) {
+            pending->emplace_back();
+            MPI_Isend(buffer->data(), size, MPI_BYTE, destination, tag, relations(), &pending->back());
+        }
+        if (!detached) {
+            current ^= 1;
+            MPI_Waitall(static_cast<int>(requests[current].size()), requests[current].data(),
+                    MPI_STATUSES_IGNORE);
+            requests[current].clear();
+        }
+        buffers[current].clear();
+        buffers[current].reserve(capacity);
+        buffers[current].push_back(encoding);
+        std::fill(previous.begin(), previous.end(), 0);
+    };
+
+    if (length == 0) {
+        if (!data.empty()) {
+            post(false);
+        }
+    }
+    for (const auto& element : data) {
+        if (length == 0) {
+            break;
+        }
+        if (buffers[current].size() + maxTupleBytes<S>(length) > capacity) {
+            post(false);
+        }
+        for (size_t j = 0; j < length; ++j) {
+            encode<S>(buffers[current], element[j], previous[j], compress);
+        }
+    }
+    if (length > 0 && buffers[current].size() > 1) {
+        post(false);
+    }
+    post(true);
+    if (!detached) {
+        // wait for the terminating message
+        MPI_Waitall(static_cast<int>(requests[current ^ 1].size()), requests[current ^ 1].data(),
+                MPI_STATUSES_IGNORE);
+    }
+}
+
+template <typename S, typename T>
+inline void sendStream(
+        const T& data, const size_t length, const int destination, const int tag, const bool compress) {
+    sendStream<S>(data, length, std::set<int>({destination}), tag, compress);
+}
+
+/**
+ * Receive a relation sent by sendStream, inserting the tuples of each chunk while the next one is being
+ * received.
+ */
+template <typename R, typename T>
+inline void recvStream(T& data, const size_t length, const int source, const int tag) {
+    const size_t capacity = streamChunkCapacity<R>(length);
+    std::vector<char> buffers[2] = {std::vector<char>(capacity), std::vector<char>(capacity)};
+    MPI_Request requests[2];
+    std::unique_ptr<R[]> tuple(new R[length]());
+    std::vector<R> previous(length);
+    int current = 0;
+    MPI_Irecv(buffers[current].data(), static_cast<int>(capacity), MPI_BYTE, source, tag, relations(),
+            &requests[current]);
+    while (true) {
+        MPI_Status status;
+        MPI_Wait(&requests[current], &status);
+        int count;
+        MPI_Get_count(&status, MPI_BYTE, &count);
+        if (count == 0) {
+            break;
+        }
+        // messages of the same source and tag arrive in order, the next one is received meanwhile
+        MPI_Irecv(buffers[current ^ 1].data(), static_cast<int>(capacity), MPI_BYTE, source, tag,
+                relations(), &requests[current ^ 1]);
+        const char* pos = buffers[current].data();
+        const char* end = pos + count;
+        const bool delta = (*pos++ == DELTA);
+        std::fill(previous.begin(), previous.end(), 0);
+        if (length == 0) {
+            data.insert(tuple.get());
+        }
+        while (length > 0 && pos < end) {
+            for (size_t j = 0; j < length; ++j) {
+                tuple[j] = decode<R>(pos, previous[j], delta);
+            }
+            const auto* ptr = tuple.get();
+            data.insert(ptr);
+        }
+        current ^= 1;
+    }
+}
+}  // namespace
+
+/* relations shared within a node */
+namespace {
+
+/**
+ * The header of a shared memory segment holding the tuples of a relation sent to ranks on the node of
+ * the sender, followed by the elements of the tuples
+ */
+struct SegmentHeader {
+    std::atomic<uint32_t> ready;
+    std::atomic<uint32_t> readers;
+    uint64_t count;
+};
+
+/** Whether a rank is placed on the node of this rank */
+inline bool sameNode(const int rank) {
+    const auto& nodes = nodeOfRanks();
+    return !nodes.empty() && nodes[rank] == nodes[commRank()];
+}
+
+/**
+ * The name of the segment of a relation sent by the given rank. A rank sends a relation at most twice,
+ * to the ranks of the strata reading it and to the master process for output.
+ */
+inline std::string segmentName(const int source, const int tag, const bool toMaster) {
+    return "/souffle." + std::to_string(runId()) + "." + std::to_string(source) + "." + std::to_string(tag) +
+           (toMaster ? ".master" : "");
+}
+
+/**
+ * Write the tuples of a relation into a new shared memory segment of the given name, to be read by the
+ * given number of readers. The sender does not wait for the readers, the last one of which removes it.
+ */
+template <typename S, typename T>
+inline void sendShared(const T& data, const size_t length, const size_t readers, const std::string& name) {
+    uint64_t count = 0;
+    for (auto it = data.begin(); it != data.end(); ++it) {
+        ++count;
+    }
+    const size_t bytes = sizeof(SegmentHeader) + count * length * sizeof(S);
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        throw std::runtime_error("Cannot create shared memory segment " + name);
+    }
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("Cannot map shared memory segment " + name);
+    }
+    // the segment is zero-filled, hence not ready until the tuples are written
+    auto* header = static_cast<SegmentHeader*>(base);
+    header->count = count;
+    S* pos = reinterpret_cast<S*>(header + 1);
+    for (const auto& element : data) {
+        for (size_t j = 0; j < length; ++j) {
+            *pos++ = element[j];
+        }
+    }
+    header->readers.store(static_cast<uint32_t>(readers), std::memory_order_relaxed);
+    header->ready.store(1, std::memory_order_release);
+    munmap(base, bytes);
+}
+
+/** Insert the tuples of the shared memory segment of the given name, waiting for its sender to write it */
+template <typename R, typename T>
+inline void recvShared(T& data, const size_t length, const std::string& name) {
+    std::chrono::microseconds delay(50);
+    auto backoff = [&]() {
+        std::this_thread::sleep_for(delay);
+        delay = std::min(delay * 2, std::chrono::microseconds(10000));
+    };
+    int fd;
+    while ((fd = shm_open(name.c_str(), O_RDWR, 0600)) < 0) {
+        backoff();
+    }
+    struct stat info;
+    while (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) < sizeof(SegmentHeader)) {
+        backoff();
+    }
+    const auto bytes = static_cast<size_t>(info.st_size);
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("Cannot map shared memory segment " + name);
+    }
+    auto* header = static_cast<SegmentHeader*>(base);
+    while (header->ready.load(std::memory_order_acquire) == 0) {
+        backoff();
+    }
+    const R* pos = reinterpret_cast<const R*>(header + 1);
+    std::unique_ptr<R[]> tuple(new R[length]());
+    for (uint64_t i = 0; i < header->count; ++i) {
+        std::copy(pos, pos + length, tuple.get());
+        pos += length;
+        const auto* ptr = tuple.get();
+        data.insert(ptr);
+    }
+    if (header->readers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        shm_unlink(name.c_str());
+    }
+    munmap(base, bytes);
+}
+
+/**
+ * Send a relation to the given destinations. Those on the node of this rank read it from a single copy in
+ * shared memory rather than receiving a stream of their own, the others receive a stream.
+ */
+template <typename S, typename T>
+inline void sendRelation(const T& data, const size_t length, const std::set<int>& destinations, const int tag,
+        const bool compress) {
+    std::set<int> remote;
+    size_t local = 0;
+    for (const auto destination : destinations) {
+        if (sameNode(destination)) {
+            ++local;
+        } else {
+            remote.insert(destination);
+        }
+    }
+    if (local > 0) {
+        sendShared<S>(data, length, local, segmentName(commRank(), tag, destinations == std::set<int>({0})));
+    }
+    if (!remote.empty()) {
+        sendStream<S>(data, length, remote, tag, compress);
+    }
+}
+
+/** Receive a relation sent by sendRelation */
+template <typename R, typename T>
+inline void recvRelation(T& data, const size_t length, const int source, const int tag) {
+    if (sameNode(source)) {
+        recvShared<R>(data, length, segmentName(source, tag, commRank() == 0));
+    } else {
+        recvStream<R>(data, length, source, tag);
+    }
+}
+}  // namespace
+
+/* threads of the ranks of a node */
+namespace {
+
+/**
+ * Share the given number of threads among ranks of the given costs in proportion to their costs, where
+ * each rank keeps at least one thread.
+ */
+inline std::vector<size_t> shareThreads(const std::vector<double>& costs, const size_t threads) {
+    double total = 0;
+    for (const double cost : costs) {
+        total += cost;
+    }
+    const size_t spare = (threads > costs.size()) ? threads - costs.size() : 0;
+    std::vector<size_t> shares(costs.size(), 1);
+    for (size_t i = 0; i < costs.size(); ++i) {
+        shares[i] += (total > 0) ? static_cast<size_t>(spare * (costs[i] / total)) : spare / costs.size();
+    }
+    return shares;
+}
+
+/**
+ * Get the threads of this rank, its share of the given threads of its node by the costs of the ranks on
+ * the node; a collective operation of the ranks of the node.
+ */
+inline size_t nodeThreads(const double cost, const size_t threads) {
+    int size;
+    MPI_Comm_size(node(), &size);
+    int rank;
+    MPI_Comm_rank(node(), &rank);
+    std::vector<double> costs(size);
+    MPI_Allgather(&cost, 1, MPI_DOUBLE, costs.data(), 1, MPI_DOUBLE, node());
+    return shareThreads(costs, threads)[rank];
+}
+}  // namespace
+
+/* partitioned evaluation */
+namespace {
+
+/**
+ * The communicator of the ranks evaluating the same stratum.
+ *
+ * A stratum is evaluated by the rank owning it, and the ranks of a partitioned stratum in addition,
+ * each evaluating the rules over its partition of the delta relations. The owner is the rank of the
+ * group with the lowest rank in the world, and thus rank 0 of the group.
+ */
+inline MPI_Comm& group() {
+    static MPI_Comm comm = MPI_COMM_SELF;
+    return comm;
+}
+
+/** Form the groups of the ranks evaluating the same stratum, a collective operation of all ranks */
+inline void splitGroup(const int stratum) {
+    MPI_Comm_split(MPI_COMM_WORLD, stratum, commRank(), &group());
+}
+
+inline int groupSize() {
+    int size;
+    MPI_Comm_size(group(), &size);
+    return size;
+}
+
+inline int groupRank() {
+    int rank;
+    MPI_Comm_rank(group(), &rank);
+    return rank;
+}
+
+/** Get the rank of the group owning a tuple, by a hash of all its elements */
+template <typename T>
+inline int owner(const T& tuple, const size_t arity, const int size) {
+    uint64_t hash = 0;
+    for (size_t i = 0; i < arity; ++i) {
+        hash = (hash ^ static_cast<uint64_t>(tuple[i])) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
+    }
+    return (int)(hash % (uint64_t)size);
+}
+
+/** Insert the tuples of a flat buffer of elements into a relation */
+template <typename R, typename T>
+inline void insertAll(T& data, const std::vector<R>& buffer, const size_t arity) {
+    for (size_t i = 0; i + arity <= buffer.size(); i += arity) {
+        data.insert(&buffer[i]);
+    }
+}
+
+/** Whether any rank of the group has a tuple in a nullary relation, making it non-empty on all ranks */
+template <typename R, typename T>
+inline void exchangeNullary(T& data) {
+    int local = data.empty() ? 0 : 1;
+    int global;
+    MPI_Allreduce(&local, &global, 1, datatype<int>(), MPI_LOR, group());
+    if (global != 0 && data.empty()) {
+        auto element = std::unique_ptr<R[]>(new R[1]());
+        data.insert(element.get());
+    }
+}
+
+/**
+ * Exchange the tuples derived by the ranks of the group in an iteration.
+ *
+ * The tuples are first shuffled to the ranks owning them, which removes the tuples derived by several
+ * ranks, and the distinct tuples are then gathered by all ranks. Afterwards, the relation holds the same
+ * tuples on every rank, such that the emptiness of the relation terminates the loop on all ranks alike.
+ */
+template <typename R, typename T>
+inline void exchange(T& data, const size_t arity) {
+    const int size = groupSize();
+    if (size == 1) {
+        return;
+    }
+    if (arity == 0) {
+        exchangeNullary<R>(data);
+        return;
+    }
+
+    // shuffle the tuples to their owners
+    std::vector<std::vector<R>> outgoing((size_t)size);
+    for (const auto& element : data) {
+        auto& buffer = outgoing[(size_t)owner(element, arity, size)];
+        for (size_t j = 0; j < arity; ++j) {
+            buffer.push_back(element[j]);
+        }
+    }
+    std::vector<int> sendCounts((size_t)size);
+    std::vector<int> sendDispls((size_t)size);
+    std::vector<R> sendBuffer;
+    for (int i = 0; i < size; ++i) {
+        sendCounts[i] = (int)outgoing[i].size();
+        sendDispls[i] = (int)sendBuffer.size();
+        sendBuffer.insert(sendBuffer.end(), outgoing[i].begin(), outgoing[i].end());
+    }
+    std::vector<int> recvCounts((size_t)size);
+    MPI_Alltoall(&sendCounts[0], 1, datatype<int>(), &recvCounts[0], 1, datatype<int>(), group());
+    std::vector<int> recvDispls((size_t)size);
+    int total = 0;
+    for (int i = 0; i < size; ++i) {
+        recvDispls[i] = total;
+        total += recvCounts[i];
+    }
+    std::vector<R> recvBuffer((size_t)total);
+    MPI_Alltoallv(sendBuffer.data(), &sendCounts[0], &sendDispls[0], datatype<R>(), recvBuffer.data(),
+            &recvCounts[0], &recvDispls[0], datatype<R>(), group());
+    data.purge();
+    insertAll(data, recvBuffer, arity);
+
+    // gather the distinct tuples of all owners
+    std::vector<R> owned;
+    for (const auto& element : data) {
+        for (size_t j = 0; j < arity; ++j) {
+            owned.push_back(element[j]);
+        }
+    }
+    int count = (int)owned.size();
+    std::vector<int> counts((size_t)size);
+    MPI_Allgather(&count, 1, datatype<int>(), &counts[0], 1, datatype<int>(), group());
+    std::vector<int> displs((size_t)size);
+    total = 0;
+    for (int i = 0; i < size; ++i) {
+        displs[i] = total;
+        total += counts[i];
+    }
+    std::vector<R> gathered((size_t)total);
+    MPI_Allgatherv(owned.data(), count, datatype<R>(), gathered.data(), &counts[0], &displs[0],
+            datatype<R>(), group());
+    insertAll(data, gathered, arity);
+}
+
+/** Keep the tuples of a relation owned by the rank, the partition the rank evaluates rules over */
+template <typename R, typename T>
+inline void partition(T& data, const size_t arity) {
+    const int size = groupSize();
+    if (size == 1 || arity == 0) {
+        return;
+    }
+    const int rank = groupRank();
+    std::vector<R> owned;
+    for (const auto& element : data) {
+        if (owner(element, arity, size) == rank) {
+            for (size_t j = 0; j < arity; ++j) {
+                owned.push_back(element[j]);
+            }
+        }
+    }
+    data.purge();
+    insertAll(data, owned, arity);
+}
+
+/** Broadcast a relation received by the owner of a stratum to the other ranks of the group */
+template <typename R, typename T>
+inline void broadcast(T& data, const size_t arity) {
+    if (groupSize() == 1) {
+        return;
+    }
+    if (arity == 0) {
+        exchangeNullary<R>(data);
+        return;
+    }
+    std::vector<R> buffer;
+    if (groupRank() == 0) {
+        for (const auto& element : data) {
+            for (size_t j = 0; j < arity; ++j) {
+                buffer.push_back(element[j]);
+            }
+        }
+    }
+    int count = (int)buffer.size();
+    MPI_Bcast(&count, 1, datatype<int>(), 0, group());
+    buffer.resize((size_t)count);
+    MPI_Bcast(buffer.data(), count, datatype<R>(), 0, group());
+    if (groupRank() != 0) {
+        insertAll(data, buffer, arity);
+    }
+}
+}  // namespace
 }  // end of namespace mpi
 }  // end of namespace souffle
@@ -0,0 +1,135 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file MpiStore.h
+ *
+ * The store of the relations sent between the strata of the mpi engine
+ * (--mpi-store), such that a run restarted after a rank failed only
+ * evaluates the strata that did not complete.
+ *
+ * The store is a directory shared by all ranks. Each relation sent by a
+ * stratum is saved there as a binary relation file, see BinaryFormat.h,
+ * before it is sent, its symbols being stored as strings rather than as
+ * indices of the symbol table of the run. Once a stratum has sent all its
+ * relations, a marker file records its completion. A restarted run skips
+ * the strata completed by earlier runs, their successors reading the
+ * relations they sent from the store rather than receiving them.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "IODirectives.h"
+#include "ReadStreamBinary.h"
+#include "SymbolTable.h"
+#include "WriteStreamBinary.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace souffle {
+
+class MpiStore {
+public:
+    /** Use a directory for the store, created when it is opened */
+    explicit MpiStore(std::string directory) : directory(std::move(directory)) {}
+
+    MpiStore(const MpiStore&) = delete;
+
+    /**
+     * Read which of the given number of strata were completed by earlier runs. All ranks must open the
+     * store before any stratum of this run completes, such that they agree on the strata skipped.
+     */
+    void open(size_t numberOfStrata) {
+        if (mkdir(directory.c_str(), 0777) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Cannot create mpi store directory " + directory);
+        }
+        completed.clear();
+        for (size_t stratum = 0; stratum < numberOfStrata; ++stratum) {
+            if (std::ifstream(marker(stratum)).good()) {
+                completed.insert(stratum);
+            }
+        }
+    }
+
+    /** Whether a stratum was completed by an earlier run */
+    bool isCompleted(int stratum) const {
+        return stratum >= 0 && completed.count(static_cast<size_t>(stratum)) > 0;
+    }
+
+    /** Get the ranks of the given pairs of destination stratum and rank whose stratum is to be evaluated */
+    std::set<int> pending(const std::vector<std::pair<int, int>>& destinations) const {
+        std::set<int> ranks;
+        for (const auto& destination : destinations) {
+            if (!isCompleted(destination.first)) {
+                ranks.insert(destination.second);
+            }
+        }
+        return ranks;
+    }
+
+    /** Save a relation sent by a stratum, replacing its file only once it is written completely */
+    template <typename T>
+    void saveRelation(const std::string& name, const T& relation, const std::vector<bool>& symbolMask,
+            const SymbolTable& symbolTable) const {
+        const std::string file = path(name + ".bin");
+        WriteFileBinary(symbolMask, symbolTable, directives(name, file + ".tmp")).writeAll(relation);
+        if (std::rename((file + ".tmp").c_str(), file.c_str()) != 0) {
+            throw std::runtime_error("Cannot write mpi store file " + file);
+        }
+    }
+
+    /** Insert the tuples of a relation sent by a completed stratum */
+    template <typename T>
+    void restoreRelation(const std::string& name, T& relation, const std::vector<bool>& symbolMask,
+            SymbolTable& symbolTable) const {
+        ReadFileBinary(symbolMask, symbolTable, directives(name, path(name + ".bin"))).readAll(relation);
+    }
+
+    /** Record the completion of a stratum, after all relations it sent are saved */
+    void commit(size_t stratum) const {
+        const std::string file = marker(stratum);
+        std::ofstream(file + ".tmp").flush();
+        if (std::rename((file + ".tmp").c_str(), file.c_str()) != 0) {
+            throw std::runtime_error("Cannot write mpi store file " + file);
+        }
+    }
+
+private:
+    std::string path(const std::string& file) const {
+        return directory + "/" + file;
+    }
+
+    std::string marker(size_t stratum) const {
+        return path("stratum" + std::to_string(stratum) + ".done");
+    }
+
+    static IODirectives directives(const std::string& name, const std::string& file) {
+        std::map<std::string, std::string> directiveMap = {
+                {"IO", "binary"}, {"filename", file}, {"name", name}};
+        return IODirectives(directiveMap);
+    }
+
+    std::string directory;
+
+    /** the strata completed by earlier runs */
+    std::set<size_t> completed;
+};
+
+}  // end of namespace souffle
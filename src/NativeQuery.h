@@ -0,0 +1,84 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file NativeQuery.h
+ *
+ * The interface between an interpreter and queries compiled to native code
+ * while the interpreter is running.
+ *
+ * A native query is a function in a shared library, accessing the relations
+ * of the interpreter only through the operations given to it. Hence, the
+ * compiled code depends neither on the data structures of the interpreter
+ * nor on the remainder of the program.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamTypes.h"
+
+#include <cstddef>
+
+namespace souffle {
+
+/** The maximal number of tuples obtained from a cursor at a time */
+constexpr std::size_t NATIVE_BATCH_SIZE = 128;
+
+/** The name of the function implementing a native query */
+constexpr const char* NATIVE_QUERY_SYMBOL = "souffle_native_query";
+
+/**
+ * The operations on relations offered to native queries. Relations and
+ * cursors are opaque handles owned by the interpreter.
+ */
+struct NativeRelationAccess {
+    /** Opens a cursor over all tuples of a relation */
+    void* (*scan)(void* rel);
+
+    /** Opens a cursor over the tuples of a relation within the given bounds, using the given index */
+    void* (*range)(void* rel, std::size_t indexPos, const RamDomain* low, const RamDomain* high);
+
+    /**
+     * Obtains the next tuples of a cursor, at most NATIVE_BATCH_SIZE of them,
+     * which remain valid until the next call.
+     *
+     * @return the number of tuples obtained, 0 if the end has been reached
+     */
+    std::size_t (*fetch)(void* cursor, const RamDomain** tuples);
+
+    /** Closes a cursor */
+    void (*close)(void* cursor);
+
+    /** Checks whether a relation contains the given tuple */
+    bool (*contains)(void* rel, const RamDomain* tuple);
+
+    /** Checks whether a relation has a tuple within the given bounds, using the given index */
+    bool (*exists)(void* rel, std::size_t indexPos, const RamDomain* low, const RamDomain* high);
+
+    /** Checks whether a relation is empty */
+    bool (*empty)(void* rel);
+
+    /** Inserts a tuple into a relation */
+    void (*insert)(void* rel, const RamDomain* tuple);
+};
+
+/** The arguments of a native query */
+struct NativeQueryContext {
+    /** the operations on relations */
+    const NativeRelationAccess* access;
+
+    /** the relations accessed by the query, in the order fixed when generating it */
+    void* const* relations;
+};
+
+/** A native query */
+using NativeQuery = void (*)(const NativeQueryContext*);
+
+}  // end of namespace souffle
@@ -0,0 +1,267 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Numa.h
+ *
+ * Placement of threads and memory on the nodes of NUMA machines
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace souffle {
+
+namespace numa {
+
+/**
+ * The placement of memory in NUMA mode: either on the node of the thread allocating it,
+ * the default of Linux, or interleaved page by page over all nodes.
+ */
+enum class Placement { LOCAL, INTERLEAVE };
+
+/** a node of the machine and the cpus of the node the program may run on */
+struct Node {
+    int id;
+    std::vector<int> cpus;
+};
+
+/** Parse a list of cpus or nodes as given by sysfs, e.g. 0-3,8,10-11 */
+inline std::vector<int> parseList(const std::string& list) {
+    std::vector<int> res;
+    std::stringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        if (range.find_first_of("0123456789") == std::string::npos) {
+            continue;
+        }
+        const size_t dash = range.find('-');
+        const int first = std::atoi(range.substr(0, dash).c_str());
+        const int last = (dash == std::string::npos) ? first : std::atoi(range.substr(dash + 1).c_str());
+        for (int i = first; i <= last; ++i) {
+            res.push_back(i);
+        }
+    }
+    return res;
+}
+
+/**
+ * Get the nodes of the machine with the cpus the program may run on, skipping nodes
+ * without such cpus. If the topology is unknown, a single node 0 holds all cpus.
+ */
+inline const std::vector<Node>& getNodes() {
+    static const std::vector<Node> nodes = []() {
+        std::vector<Node> res;
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        const bool restricted = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string list;
+        std::getline(online, list);
+        for (int id : parseList(list)) {
+            std::ifstream cpuList("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+            std::string cpus;
+            std::getline(cpuList, cpus);
+            Node node{id, {}};
+            for (int cpu : parseList(cpus)) {
+                if (!restricted || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+                    node.cpus.push_back(cpu);
+                }
+            }
+            if (!node.cpus.empty()) {
+                res.push_back(node);
+            }
+        }
+#endif
+        if (res.empty()) {
+            Node node{0, {}};
+            const long count = sysconf(_SC_NPROCESSORS_ONLN);
+            for (long i = 0; i < std::max(1L, count); ++i) {
+                node.cpus.push_back(i);
+            }
+            res.push_back(node);
+        }
+        return res;
+    }();
+    return nodes;
+}
+
+namespace detail {
+
+/** the state of NUMA mode */
+struct State {
+    bool enabled = false;
+
+    /** the node each OpenMP thread is pinned to */
+    std::vector<int> threadNodes;
+
+    /** the counters of loads served by any node and by remote nodes, -1 if unavailable */
+    int loads = -1;
+    int remoteLoads = -1;
+};
+
+inline State& getState() {
+    static State state;
+    return state;
+}
+
+#ifdef __linux__
+/** Open a counter of node loads, of the calling thread and the threads it creates later */
+inline int openNodeCounter(uint64_t result) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_NODE | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+}  // namespace detail
+
+/**
+ * Enable NUMA mode: the OpenMP threads are pinned to the cpus of the nodes, consecutive
+ * threads sharing a node, and memory is placed as given. Chunks of parallel loops are
+ * then preferably processed by threads of the node holding them.
+ *
+ * To cover the OpenMP threads, NUMA mode is to be enabled before the first parallel
+ * region and after the number of threads is set. The counters of remote accesses are
+ * opened as well, as far as the kernel and the processor permit.
+ */
+inline void enable(Placement placement) {
+    detail::State& state = detail::getState();
+    if (state.enabled) {
+        return;
+    }
+    state.enabled = true;
+    const std::vector<Node>& nodes = getNodes();
+
+#ifdef __linux__
+    // the counters inherited by threads have to be opened before the threads are created
+    state.loads = detail::openNodeCounter(PERF_COUNT_HW_CACHE_RESULT_ACCESS);
+    state.remoteLoads = detail::openNodeCounter(PERF_COUNT_HW_CACHE_RESULT_MISS);
+
+    std::vector<unsigned long> mask;
+    for (const Node& node : nodes) {
+        const size_t bits = 8 * sizeof(unsigned long);
+        mask.resize(std::max(mask.size(), node.id / bits + 1), 0);
+        mask[node.id / bits] |= 1ul << (node.id % bits);
+    }
+    const bool interleave = placement == Placement::INTERLEAVE && nodes.size() > 1;
+#endif
+
+#ifdef _OPENMP
+    const size_t threads = std::max(1, omp_get_max_threads());
+#else
+    const size_t threads = 1;
+#endif
+    state.threadNodes.assign(threads, nodes.front().id);
+
+    // each thread pins itself, such that the threads of later parallel regions stay pinned
+    auto pin = [&](size_t thread) {
+        const size_t index = thread * nodes.size() / threads;
+        const size_t first = (index * threads + nodes.size() - 1) / nodes.size();
+        const Node& node = nodes[index];
+        state.threadNodes[thread] = node.id;
+#ifdef __linux__
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(node.cpus[(thread - first) % node.cpus.size()], &cpus);
+        sched_setaffinity(0, sizeof(cpus), &cpus);
+        if (interleave) {
+            syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, mask.data(), 8 * sizeof(unsigned long) * mask.size());
+        }
+#endif
+    };
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+    pin(omp_get_thread_num());
+#else
+    pin(0);
+#endif
+}
+
+/** Whether NUMA mode is enabled */
+inline bool isEnabled() {
+    return detail::getState().enabled;
+}
+
+/** Get the node the OpenMP thread of the given number is pinned to, or -1 if unknown */
+inline int getNodeOfThread(size_t thread) {
+    const detail::State& state = detail::getState();
+    return thread < state.threadNodes.size() ? state.threadNodes[thread] : -1;
+}
+
+/** Get the nodes holding the memory at the given addresses, -1 where unknown */
+inline std::vector<int> getNodesOfAddresses(const std::vector<const void*>& addresses) {
+    std::vector<int> res(addresses.size(), -1);
+#ifdef __linux__
+    if (!addresses.empty()) {
+        // without target nodes, move_pages only reports the nodes of the pages
+        std::vector<void*> pages(addresses.size());
+        for (size_t i = 0; i < addresses.size(); ++i) {
+            pages[i] = const_cast<void*>(addresses[i]);
+        }
+        if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, res.data(), 0) != 0) {
+            res.assign(addresses.size(), -1);
+        }
+        for (int& node : res) {
+            node = std::max(node, -1);
+        }
+    }
+#endif
+    return res;
+}
+
+/**
+ * Read the loads served by the nodes of the machine and those served by remote nodes,
+ * summed over the threads of NUMA mode. Returns false if the counters are unavailable.
+ */
+inline bool readNodeLoads(uint64_t& loads, uint64_t& remoteLoads) {
+    const detail::State& state = detail::getState();
+    if (state.loads < 0 || state.remoteLoads < 0) {
+        return false;
+    }
+#ifdef __linux__
+    return ::read(state.loads, &loads, sizeof(loads)) == sizeof(loads) &&
+           ::read(state.remoteLoads, &remoteLoads, sizeof(remoteLoads)) == sizeof(remoteLoads);
+#else
+    return false;
+#endif
+}
+
+}  // end of namespace numa
+
+}  // end of namespace souffle
@@ -17,7 +17,28 @@
 
 #pragma once
 
+#include "Numa.h"
+#include "TraceLog.h"
+
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #ifdef _OPENMP
 
@@ -35,6 +56,10 @@
 #define PARALLEL_START _Pragma("omp parallel") {
 #define PARALLEL_END }
 
+// support for a parallel region run by the given number of threads
+#define SOUFFLE_PRAGMA(X) _Pragma(#X)
+#define PARALLEL_START_SIZED(TEAM) SOUFFLE_PRAGMA(omp parallel num_threads(TEAM)) {
+
 // support for parallel loops
 #define pfor _Pragma("omp for schedule(dynamic)") for
 #define cilk_for for
@@ -71,6 +96,7 @@
 // support for a parallel region
 #define PARALLEL_START {
 #define PARALLEL_END }
+#define PARALLEL_START_SIZED(TEAM) {
 
 // support for parallel loops
 #define pfor cilk_for
@@ -101,6 +127,7 @@
 // support for a parallel region => sequential execution
 #define PARALLEL_START {
 #define PARALLEL_END }
+#define PARALLEL_START_SIZED(TEAM) {
 
 // support for parallel loops => simple sequential loop
 #define pfor for
@@ -137,9 +164,186 @@
 #define MAX_THREADS (1)
 #endif
 
-#ifdef IS_PARALLEL
 
-#include <mutex>
+namespace souffle {
+
+/**
+ * The sites of the locks whose use is counted in builds with lock statistics, i.e. with
+ * USE_LOCK_STATS defined. Lock operations count towards the site their thread is in, as
+ * marked by a LockSiteScope, and towards OTHER outside of any marked site.
+ */
+enum class LockSite { OTHER, BTREE, SYMBOL_TABLE, RECORDS };
+
+/** The events counted for the locks of each site */
+enum class LockEvent {
+    ACQUISITION,  // a lock is acquired for reading or writing, or a read phase is started
+    CONTENTION,   // an acquisition had to wait for another thread
+    SPIN,         // an iteration of waiting for another thread
+    PARK,         // a waiting thread is suspended by the kernel
+    RESTART       // an optimistic read is invalidated by a concurrent write
+};
+
+constexpr size_t NUM_LOCK_SITES = 4;
+constexpr size_t NUM_LOCK_EVENTS = 5;
+
+inline const char* getLockSiteName(LockSite site) {
+    static const char* names[NUM_LOCK_SITES] = {"other", "btree", "symbol-table", "records"};
+    return names[static_cast<size_t>(site)];
+}
+
+inline const char* getLockEventName(LockEvent event) {
+    static const char* names[NUM_LOCK_EVENTS] = {
+            "acquisitions", "contentions", "spins", "parks", "restarts"};
+    return names[static_cast<size_t>(event)];
+}
+
+namespace detail {
+
+/**
+ * The lock events counted by a thread, by site. The counters are only written by their
+ * thread, such that counting does not add contention of its own; they are summed up
+ * over all threads when read, and added to those of terminated threads on exit.
+ */
+class ThreadLockCounters {
+    using Counters = std::atomic<uint64_t>[NUM_LOCK_SITES][NUM_LOCK_EVENTS];
+
+    struct Registry {
+        std::mutex lock;
+        std::vector<ThreadLockCounters*> threads;
+        uint64_t retired[NUM_LOCK_SITES][NUM_LOCK_EVENTS] = {};
+    };
+
+    static Registry& getRegistry() {
+        static Registry registry;
+        return registry;
+    }
+
+    Counters counts;
+
+public:
+    /** The site the thread is currently in */
+    LockSite site = LockSite::OTHER;
+
+    ThreadLockCounters() {
+        for (auto& events : counts) {
+            for (auto& count : events) {
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        registry.threads.push_back(this);
+    }
+
+    ~ThreadLockCounters() {
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        for (size_t i = 0; i < NUM_LOCK_SITES; i++) {
+            for (size_t j = 0; j < NUM_LOCK_EVENTS; j++) {
+                registry.retired[i][j] += counts[i][j].load(std::memory_order_relaxed);
+            }
+        }
+        registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+    }
+
+    /** Counts events of the current site */
+    void add(LockEvent event, uint64_t n) {
+        auto& count = counts[static_cast<size_t>(site)][static_cast<size_t>(event)];
+        count.store(count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /** Obtains the number of events of a site counted by all threads */
+    static uint64_t getTotal(LockSite site, LockEvent event) {
+        const size_t i = static_cast<size_t>(site);
+        const size_t j = static_cast<size_t>(event);
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        uint64_t res = registry.retired[i][j];
+        for (const ThreadLockCounters* thread : registry.threads) {
+            res += thread->counts[i][j].load(std::memory_order_relaxed);
+        }
+        return res;
+    }
+
+    /** Obtains the counters of the calling thread */
+    static ThreadLockCounters& get() {
+        static thread_local ThreadLockCounters counters;
+        return counters;
+    }
+};
+
+/**
+ * Counts lock events of the current site, in builds with lock statistics.
+ */
+inline void countLockEvent(LockEvent event, uint64_t n = 1) {
+#ifdef USE_LOCK_STATS
+    if (n != 0) {
+        ThreadLockCounters::get().add(event, n);
+    }
+#else
+    (void)event;
+    (void)n;
+#endif
+}
+
+/**
+ * Locks a mutex, counting the acquisition and whether it had to wait.
+ */
+inline void lockMutex(std::mutex& mux) {
+#ifdef USE_LOCK_STATS
+    countLockEvent(LockEvent::ACQUISITION);
+    if (mux.try_lock()) {
+        return;
+    }
+    countLockEvent(LockEvent::CONTENTION);
+#endif
+    mux.lock();
+}
+
+}  // namespace detail
+
+/**
+ * Marks the lock operations of the calling thread within the scope of an instance as
+ * those of the given site; without lock statistics, it has no effect.
+ */
+class LockSiteScope {
+#ifdef USE_LOCK_STATS
+    LockSite previous;
+
+public:
+    explicit LockSiteScope(LockSite site) : previous(detail::ThreadLockCounters::get().site) {
+        detail::ThreadLockCounters::get().site = site;
+    }
+
+    ~LockSiteScope() {
+        detail::ThreadLockCounters::get().site = previous;
+    }
+#else
+public:
+    explicit LockSiteScope(LockSite /* site */) {}
+#endif
+
+    LockSiteScope(const LockSiteScope&) = delete;
+    LockSiteScope& operator=(const LockSiteScope&) = delete;
+};
+
+/**
+ * Obtains the number of lock events of a site counted by all threads so far; zero unless
+ * built with lock statistics.
+ */
+inline uint64_t getLockCount(LockSite site, LockEvent event) {
+#ifdef USE_LOCK_STATS
+    return detail::ThreadLockCounters::getTotal(site, event);
+#else
+    (void)site;
+    (void)event;
+    return 0;
+#endif
+}
+
+}  // end of namespace souffle
+
+#ifdef IS_PARALLEL
 
 namespace souffle {
 
@@ -153,7 +357,7 @@ class Lock {
 public:
     struct Lease {
         Lease(std::mutex& mux) : mux(&mux) {
-            mux.lock();
+            detail::lockMutex(mux);
         }
         Lease(Lease&& other) : mux(other.mux) {
             other.mux = nullptr;
@@ -175,7 +379,7 @@ public:
     }
 
     void lock() {
-        mux.lock();
+        detail::lockMutex(mux);
     }
 
     bool try_lock() {
@@ -207,6 +411,13 @@ class Waiter {
 public:
     Waiter() = default;
 
+    ~Waiter() {
+        if (i > 0) {
+            countLockEvent(LockEvent::CONTENTION);
+            countLockEvent(LockEvent::SPIN, i);
+        }
+    }
+
     /**
      * Conducts a wait operation.
      */
@@ -221,6 +432,31 @@ public:
         }
     }
 };
+
+/**
+ * Suspends the calling thread while the given word holds the expected value, or
+ * yields its processor where threads cannot be suspended on a word.
+ */
+inline void park(std::atomic<int>& word, int expected) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)expected;
+    pthread_yield();
+#endif
+}
+
+/**
+ * Resumes a thread suspended on the given word.
+ */
+inline void unpark(std::atomic<int>& word) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
 }  // namespace detail
 
 /* compare: http://en.cppreference.com/w/cpp/atomic/atomic_flag */
@@ -231,6 +467,7 @@ public:
     SpinLock() = default;
 
     void lock() {
+        detail::countLockEvent(LockEvent::ACQUISITION);
         detail::Waiter wait;
         while (!try_lock()) {
             wait();
@@ -247,6 +484,62 @@ public:
     }
 };
 
+/**
+ * A lock spinning for a bounded number of iterations before suspending the waiting thread,
+ * such that waiters do not keep the holder of the lock from running when there are more
+ * threads than processors. Based on the mutex of "Futexes Are Tricky" by Ulrich Drepper.
+ *
+ * Layout of the lock: 0 if it is free, 1 if it is held, and 2 if it is held and threads
+ * may be suspended on it.
+ */
+class AdaptiveLock {
+    std::atomic<int> state{0};
+
+    /** The number of iterations spun before suspending */
+    static constexpr int SPIN_LIMIT = 128;
+
+public:
+    AdaptiveLock() = default;
+
+    void lock() {
+        detail::countLockEvent(LockEvent::ACQUISITION);
+        if (try_lock()) {
+            return;
+        }
+        detail::countLockEvent(LockEvent::CONTENTION);
+
+        // spin while the holder is likely to release the lock soon
+        for (int i = 1; i <= SPIN_LIMIT; i++) {
+            cpu_relax();
+            int should = 0;
+            if (state.load(std::memory_order_relaxed) == 0 &&
+                    state.compare_exchange_weak(
+                            should, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                detail::countLockEvent(LockEvent::SPIN, i);
+                return;
+            }
+        }
+        detail::countLockEvent(LockEvent::SPIN, SPIN_LIMIT);
+
+        // announce a waiter and suspend until the lock is released
+        while (state.exchange(2, std::memory_order_acquire) != 0) {
+            detail::countLockEvent(LockEvent::PARK);
+            detail::park(state, 2);
+        }
+    }
+
+    bool try_lock() {
+        int should = 0;
+        return state.compare_exchange_strong(should, 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        if (state.exchange(0, std::memory_order_release) == 2) {
+            detail::unpark(state);
+        }
+    }
+};
+
 /**
  * A read/write lock for increased access performance on a
  * read-heavy use case.
@@ -270,6 +563,8 @@ public:
     ReadWriteLock() = default;
 
     void start_read() {
+        detail::countLockEvent(LockEvent::ACQUISITION);
+
         // add reader
         auto r = lck.fetch_add(4, std::memory_order_acquire);
 
@@ -293,6 +588,7 @@ public:
     }
 
     void start_write() {
+        detail::countLockEvent(LockEvent::ACQUISITION);
         detail::Waiter wait;
 
         // set wait-for-write bit
@@ -371,6 +667,7 @@ public:
      * concurrent modifications took place.
      */
     Lease start_read() {
+        detail::countLockEvent(LockEvent::ACQUISITION);
         detail::Waiter wait;
 
         // get a snapshot of the lease version
@@ -397,7 +694,11 @@ public:
     bool validate(const Lease& lease) {
         // check whether version number has changed in the mean-while
         std::atomic_thread_fence(std::memory_order_acquire);
-        return lease.version == version.load(std::memory_order_relaxed);
+        if (lease.version == version.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        detail::countLockEvent(LockEvent::RESTART);
+        return false;
     }
 
     /**
@@ -416,6 +717,7 @@ public:
      * and invalidating any existing read lease.
      */
     void start_write() {
+        detail::countLockEvent(LockEvent::ACQUISITION);
         detail::Waiter wait;
 
         // set last bit => make it odd
@@ -462,6 +764,7 @@ public:
 
         // if there was, undo write update
         abort_write();
+        detail::countLockEvent(LockEvent::RESTART);
 
         // operation failed
         return false;
@@ -496,6 +799,263 @@ public:
     }
 };
 
+/**
+ * A partition of the tuples of a parallel loop over the threads of a parallel region,
+ * balancing their load by work stealing.
+ *
+ * The chunks of the partition are distributed in blocks of consecutive chunks, one
+ * block for each thread. A thread processes the chunks of its own block in order and
+ * then steals chunks from the end of the blocks of other threads. Once no chunk is left
+ * to steal while a thread waits for work, the threads processing a chunk split off the
+ * second half of its remaining tuples for others to steal. Thus a partition of a few
+ * chunks, or of a few expensive ones, is still spread over all threads.
+ *
+ * Each thread of the parallel region iterates over its tuples with a cursor:
+ *
+ *     StealingRanges<decltype(part)> ranges(part);
+ *     PARALLEL_START
+ *     for (decltype(ranges)::Cursor cursor(ranges); cursor.next();) {
+ *         process(cursor.get());
+ *     }
+ *     PARALLEL_END
+ *
+ * A thread leaving the loop early drops the rest of the chunk it processes, while
+ * the remaining chunks of its block are still taken by the other threads.
+ */
+template <typename Ranges>
+class StealingRanges {
+    using Range = typename Ranges::value_type;
+    using Iter = typename std::decay<decltype(std::declval<Range&>().begin())>::type;
+
+    /** the number of tuples processed between checks for threads waiting for work */
+    static constexpr size_t SPLIT_INTERVAL = 16;
+
+    /** the counts of threads waiting for work and of finished threads, packed into a word */
+    static constexpr uint64_t IDLE = 1;
+    static constexpr uint64_t DONE = uint64_t(1) << 32;
+
+    /** the chunks of a thread */
+    struct Slot {
+        AdaptiveLock lock;
+        std::deque<Range> chunks;
+        std::atomic<size_t> size{0};
+    };
+
+public:
+    class Cursor {
+    public:
+        explicit Cursor(StealingRanges& ranges)
+                : ranges(ranges), slot(omp_get_thread_num() % ranges.numSlots),
+                  span("parallel loop", "parallel") {
+            ranges.team.store(omp_get_num_threads());
+        }
+
+        ~Cursor() {
+            if (active) {
+                ranges.state.fetch_add(DONE);
+            }
+            span.set("chunks", chunks);
+            span.set("tuples", tuples);
+        }
+
+        /** Move to the next tuple of the thread, returning false once all tuples are processed */
+        bool next() {
+            if (active) {
+                ++current->begin();
+                if (current->begin() != current->end()) {
+                    ++tuples;
+                    if (++steps % SPLIT_INTERVAL == 0) {
+                        split();
+                    }
+                    return true;
+                }
+                active = false;
+            }
+            active = acquire();
+            tuples += active;
+            return active;
+        }
+
+        /** Get the current tuple */
+        auto get() -> decltype(*std::declval<Iter&>()) {
+            return *current->begin();
+        }
+
+    private:
+        StealingRanges& ranges;
+        const size_t slot;
+        std::unique_ptr<Range> current;
+        bool active = false;
+        size_t steps = 0;
+
+        // the chunks taken and tuples processed by the thread, recorded in the trace
+        TraceLog::Span span;
+        size_t chunks = 0;
+        size_t tuples = 0;
+
+        /** take a non-empty chunk of a slot, from the front of the own slot and the back of others */
+        bool take(size_t victim, bool idle) {
+            Slot& cur = ranges.slots[victim];
+            if (cur.size.load(std::memory_order_relaxed) == 0) {
+                return false;
+            }
+            cur.lock.lock();
+            while (!cur.chunks.empty()) {
+                Range chunk = (victim == slot) ? cur.chunks.front() : cur.chunks.back();
+                if (victim == slot) {
+                    cur.chunks.pop_front();
+                } else {
+                    cur.chunks.pop_back();
+                }
+                cur.size.store(cur.chunks.size(), std::memory_order_relaxed);
+                if (chunk.begin() != chunk.end()) {
+                    current.reset(new Range(chunk));
+                    ++chunks;
+                    if (idle) {
+                        ranges.state.fetch_sub(IDLE);
+                    }
+                    cur.lock.unlock();
+                    return true;
+                }
+            }
+            cur.lock.unlock();
+            return false;
+        }
+
+        /** try taking a chunk of any slot */
+        bool steal() {
+            for (size_t i = 1; i <= ranges.numSlots; ++i) {
+                if (take((slot + i) % ranges.numSlots, true)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /** obtain the next chunk of the thread, waiting for chunks split off by others if none is left */
+        bool acquire() {
+            if (take(slot, false)) {
+                return true;
+            }
+            ranges.state.fetch_add(IDLE);
+            detail::Waiter wait;
+            while (true) {
+                if (steal()) {
+                    return true;
+                }
+                // all threads of the team wait or finished, none holds a chunk to split
+                const uint64_t state = ranges.state.load();
+                if ((state % DONE) + (state / DONE) >= ranges.team.load()) {
+                    // take up the chunks left by threads leaving their loop early
+                    if (steal()) {
+                        return true;
+                    }
+                    ranges.state.fetch_add(DONE - IDLE);
+                    return false;
+                }
+                wait();
+            }
+        }
+
+        /** split off the second half of the remaining tuples if threads wait for work */
+        void split() {
+            if (ranges.state.load(std::memory_order_relaxed) % DONE == 0 ||
+                    ranges.slots[slot].size.load(std::memory_order_relaxed) != 0) {
+                return;
+            }
+            size_t remaining = 0;
+            for (Iter it = current->begin(); it != current->end(); ++it) {
+                ++remaining;
+            }
+            if (remaining < 2) {
+                return;
+            }
+            Iter middle = current->begin();
+            for (size_t i = 0; i < remaining / 2; ++i) {
+                ++middle;
+            }
+            Slot& own = ranges.slots[slot];
+            own.lock.lock();
+            own.chunks.push_back(Range(middle, current->end()));
+            own.size.store(own.chunks.size(), std::memory_order_relaxed);
+            own.lock.unlock();
+            current.reset(new Range(current->begin(), middle));
+        }
+    };
+
+    explicit StealingRanges(const Ranges& ranges)
+            : numSlots(std::max(1, omp_get_max_threads())), slots(new Slot[numSlots]) {
+        const std::vector<size_t> owners = getOwners(ranges);
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            slots[owners[i]].chunks.push_back(ranges[i]);
+        }
+        for (size_t i = 0; i < numSlots; ++i) {
+            slots[i].size.store(slots[i].chunks.size());
+        }
+    }
+
+private:
+    /** get the address of a tuple, where tuples delivered by value are located by their copies */
+    template <typename T>
+    static const void* getAddress(const T& tuple) {
+        return &tuple;
+    }
+
+    /**
+     * Get the slots receiving the chunks. In NUMA mode, the chunks held by a node are
+     * distributed in blocks over the threads of the node, and the other chunks keep
+     * their position in the blocks of all threads.
+     */
+    std::vector<size_t> getOwners(const Ranges& ranges) const {
+        std::vector<size_t> owners(ranges.size());
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            owners[i] = i * numSlots / ranges.size();
+        }
+        if (!numa::isEnabled() || ranges.empty()) {
+            return owners;
+        }
+
+        std::vector<const void*> addresses(ranges.size(), nullptr);
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            Range chunk = ranges[i];
+            if (chunk.begin() != chunk.end()) {
+                addresses[i] = getAddress(*chunk.begin());
+            }
+        }
+        const std::vector<int> nodes = numa::getNodesOfAddresses(addresses);
+
+        std::map<int, std::vector<size_t>> threadsOfNodes;
+        for (size_t thread = 0; thread < numSlots; ++thread) {
+            threadsOfNodes[numa::getNodeOfThread(thread)].push_back(thread);
+        }
+        std::map<int, std::vector<size_t>> chunksOfNodes;
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            if (addresses[i] != nullptr && nodes[i] >= 0 && threadsOfNodes.count(nodes[i]) != 0) {
+                chunksOfNodes[nodes[i]].push_back(i);
+            }
+        }
+        for (const auto& cur : chunksOfNodes) {
+            const std::vector<size_t>& threads = threadsOfNodes[cur.first];
+            for (size_t j = 0; j < cur.second.size(); ++j) {
+                owners[cur.second[j]] = threads[j * threads.size() / cur.second.size()];
+            }
+        }
+        return owners;
+    }
+
+    const size_t numSlots;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> state{0};
+    std::atomic<size_t> team{1};
+};
+
+template <typename Ranges>
+constexpr size_t StealingRanges<Ranges>::SPLIT_INTERVAL;
+template <typename Ranges>
+constexpr uint64_t StealingRanges<Ranges>::IDLE;
+template <typename Ranges>
+constexpr uint64_t StealingRanges<Ranges>::DONE;
+
 #else
 
 namespace souffle {
@@ -536,6 +1096,22 @@ public:
     void unlock() {}
 };
 
+/**
+ * A 'sequential' non-locking implementation for an adaptive lock.
+ */
+class AdaptiveLock {
+public:
+    AdaptiveLock() = default;
+
+    void lock() {}
+
+    bool try_lock() {
+        return true;
+    }
+
+    void unlock() {}
+};
+
 class ReadWriteLock {
 public:
     ReadWriteLock() = default;
@@ -599,8 +1175,237 @@ public:
     }
 };
 
+/**
+ * A 'sequential' implementation of a partition of the tuples of a parallel loop,
+ * processing its chunks in order.
+ */
+template <typename Ranges>
+class StealingRanges {
+    using Range = typename Ranges::value_type;
+    using Iter = typename std::decay<decltype(std::declval<Range&>().begin())>::type;
+
+public:
+    class Cursor {
+    public:
+        explicit Cursor(StealingRanges& ranges) : ranges(ranges.ranges) {}
+
+        bool next() {
+            if (current) {
+                ++current->begin();
+            }
+            while (!current || current->begin() == current->end()) {
+                if (index == ranges.size()) {
+                    return false;
+                }
+                current.reset(new Range(ranges[index++]));
+            }
+            return true;
+        }
+
+        auto get() -> decltype(*std::declval<Iter&>()) {
+            return *current->begin();
+        }
+
+    private:
+        const Ranges& ranges;
+        size_t index = 0;
+        std::unique_ptr<Range> current;
+    };
+
+    explicit StealingRanges(const Ranges& ranges) : ranges(ranges) {}
+
+private:
+    const Ranges& ranges;
+};
+
 #endif
 
+/**
+ * The number of tuples for each thread an outer parallel loop has to provide, below which
+ * the outer loop runs sequentially and its nested loop in parallel instead.
+ */
+constexpr size_t NESTED_PARALLEL_THRESHOLD = 4;
+
+/**
+ * Whether a partition provides too few tuples to keep the threads of a parallel loop over
+ * it busy, such that a nested loop is to be parallelised instead. Without threads to share
+ * the work, no partition is considered small.
+ */
+template <typename Ranges>
+bool isSmallPartition(const Ranges& ranges) {
+    const size_t threads = MAX_THREADS;
+    if (threads <= 1) {
+        return false;
+    }
+    const size_t limit = NESTED_PARALLEL_THRESHOLD * threads;
+    size_t count = 0;
+    for (const auto& cur : ranges) {
+        for (auto it = cur.begin(); it != cur.end(); ++it) {
+            if (++count >= limit) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * The policy sizing the teams of threads of parallel regions by the number of tuples they
+ * process, such that small regions do not pay for starting threads they cannot keep busy.
+ *
+ * Each thread of a team processes at least a grain of tuples; regions of fewer than two
+ * grains run sequentially. With an automatic number of jobs, the grain is tuned during the
+ * first regions to the number of tuples processed in the time it takes to start a team.
+ */
+class ParallelPolicy {
+public:
+    /** The number of tuples for each thread of a parallel region, unless tuned */
+    static constexpr size_t DEFAULT_GRAIN = 64;
+
+    /** The bounds of a tuned grain */
+    static constexpr size_t MIN_GRAIN = 4;
+    static constexpr size_t MAX_GRAIN = 1 << 16;
+
+    /** The number of regions timed to tune the grain */
+    static constexpr size_t TUNING_REGIONS = 64;
+
+    static ParallelPolicy& instance() {
+        static ParallelPolicy policy;
+        return policy;
+    }
+
+    /**
+     * Sets the maximal size of the teams, or 0 to use all threads available and to tune
+     * the grain during the following regions.
+     */
+    void setJobs(size_t jobs) {
+        auto lease = lock.acquire();
+        (void)lease;
+        threads = (jobs > 0) ? jobs : MAX_THREADS;
+        grain = DEFAULT_GRAIN;
+        regions = 0;
+        work = 0;
+        tuples = 0;
+        startup = (jobs == 0 && threads > 1) ? measureStartup(threads) : 0;
+        tuning = startup > 0;
+    }
+
+    /** Whether the regions are to be timed to tune the grain */
+    bool isTuning() const {
+        return tuning.load(std::memory_order_relaxed);
+    }
+
+    /** The number of tuples from which on a region is run by the largest team */
+    size_t getSaturation() const {
+        return threads * grain.load(std::memory_order_relaxed);
+    }
+
+    /** Obtains the number of threads of a region processing the given number of tuples */
+    size_t getTeamSize(size_t count) const {
+        const size_t team = count / grain.load(std::memory_order_relaxed);
+        return (team < 2) ? 1 : std::min(team, threads);
+    }
+
+    /** Accounts for a region processing the given number of tuples in the given time */
+    void record(size_t count, size_t team, double seconds) {
+        auto lease = lock.acquire();
+        (void)lease;
+        if (!tuning || count == 0) {
+            return;
+        }
+        // the work of all threads, without the start of the team
+        work += std::max(0.0, seconds - (team > 1 ? startup : 0.0)) * team;
+        tuples += count;
+        if (work > 0) {
+            const double tuned = startup * tuples / work;
+            grain = static_cast<size_t>(std::max<double>(MIN_GRAIN, std::min<double>(MAX_GRAIN, tuned)));
+        }
+        if (++regions >= TUNING_REGIONS) {
+            tuning = false;
+        }
+    }
+
+private:
+    ParallelPolicy() : threads(MAX_THREADS) {}
+
+    /** Measures the time it takes to start a team of the given size, without creating its threads */
+    static double measureStartup(size_t team) {
+        double best = 0;
+        for (int i = 0; i < 8; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            std::atomic<size_t> started(0);
+            PARALLEL_START_SIZED(team);
+            started++;
+            PARALLEL_END;
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = (i == 0) ? seconds : std::min(best, seconds);
+        }
+        return best;
+    }
+
+    // the maximal size of the teams
+    size_t threads;
+
+    // the number of tuples for each thread
+    std::atomic<size_t> grain{DEFAULT_GRAIN};
+
+    // whether the grain is tuned, by the time of the start of a team
+    std::atomic<bool> tuning{false};
+    double startup = 0;
+
+    // the regions timed so far, with their work in seconds and their tuples
+    size_t regions = 0;
+    double work = 0;
+    size_t tuples = 0;
+
+    Lock lock;
+};
+
+/**
+ * A parallel region of synthesised code over the given partition, run by a team sized by the
+ * parallel policy. The region is timed if the policy is being tuned.
+ */
+class ParallelRegion {
+public:
+    template <typename Ranges>
+    explicit ParallelRegion(const Ranges& ranges) : policy(ParallelPolicy::instance()) {
+        timed = policy.isTuning();
+        // tuples beyond those saturating the largest team are not counted unless timed
+        const size_t limit = timed ? std::numeric_limits<size_t>::max() : policy.getSaturation();
+        for (const auto& cur : ranges) {
+            for (auto it = cur.begin(); it != cur.end() && count < limit; ++it) {
+                ++count;
+            }
+        }
+        team = policy.getTeamSize(count);
+        if (timed) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ParallelRegion(const ParallelRegion&) = delete;
+    ParallelRegion& operator=(const ParallelRegion&) = delete;
+
+    ~ParallelRegion() {
+        if (timed) {
+            policy.record(count, team,
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    /** The number of threads running the region */
+    int getTeamSize() const {
+        return static_cast<int>(team);
+    }
+
+private:
+    ParallelPolicy& policy;
+    bool timed;
+    size_t count = 0;
+    size_t team = 1;
+    std::chrono::steady_clock::time_point start;
+};
+
 /**
  * Obtains a reference to the lock synchronizing output operations.
  */
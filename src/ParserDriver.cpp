@@ -17,6 +17,7 @@
 #include "ParserDriver.h"
 #include "AstClause.h"
 #include "AstComponent.h"
+#include "AstFactTable.h"
 #include "AstFunctorDeclaration.h"
 #include "AstIO.h"
 #include "AstPragma.h"
@@ -27,6 +28,7 @@
 #include "AstType.h"
 #include "DebugReport.h"
 #include "ErrorReport.h"
+#include "Global.h"
 #include "SymbolTable.h"
 #include "Util.h"
 #include <memory>
@@ -164,8 +166,100 @@ void ParserDriver::addType(std::unique_ptr<AstType> type) {
 }
 
 void ParserDriver::addClause(std::unique_ptr<AstClause> c) {
+    if (addFact(*c)) {
+        return;
+    }
     translationUnit->getProgram()->addClause(std::move(c));
 }
+
+namespace {
+
+/** The ground facts of a relation kept as clauses before further facts go into its fact table */
+constexpr size_t factTableThreshold = 100;
+
+/**
+ * Determines whether the values of a type are symbols or numbers, failing for
+ * record types and types that are not declared yet.
+ */
+bool getTypeKind(const AstProgram& program, const AstTypeIdentifier& name, bool& symbolic, size_t depth = 0) {
+    if (name == "number" || name == "symbol") {
+        symbolic = name == "symbol";
+        return true;
+    }
+    const AstType* type = program.getType(name);
+    if (const auto* primitive = dynamic_cast<const AstPrimitiveType*>(type)) {
+        symbolic = primitive->isSymbolic();
+        return true;
+    }
+    const auto* unionType = dynamic_cast<const AstUnionType*>(type);
+    // the depth bounds the unions of cyclic definitions
+    if (unionType == nullptr || unionType->getTypes().empty() || depth > program.getTypes().size()) {
+        return false;
+    }
+    for (size_t i = 0; i < unionType->getTypes().size(); i++) {
+        bool elementSymbolic;
+        if (!getTypeKind(program, unionType->getTypes()[i], elementSymbolic, depth + 1) ||
+                (i > 0 && elementSymbolic != symbolic)) {
+            return false;
+        }
+        symbolic = elementSymbolic;
+    }
+    return true;
+}
+
+}  // namespace
+
+bool ParserDriver::addFact(const AstClause& fact) {
+    // provenance adds columns to facts and the magic-set transformation reasons on them as clauses
+    if (!fact.isFact() || Global::config().has("provenance") || Global::config().has("magic-transform")) {
+        return false;
+    }
+    const AstAtom* head = fact.getHead();
+    const AstProgram& program = *translationUnit->getProgram();
+    AstRelation* rel = program.getRelation(head->getName());
+    if (rel == nullptr || rel->isInline() || head->argSize() == 0 || head->argSize() != rel->getArity()) {
+        return false;
+    }
+
+    // the constants must be of the kinds of the columns, other facts are left to the semantic checker
+    AstFactTable* table = rel->getFactTable();
+    std::vector<bool> symbolic;
+    std::vector<RamDomain> tuple;
+    for (size_t i = 0; i < head->argSize(); i++) {
+        const AstArgument* arg = head->getArgument(i);
+        bool isSymbol = dynamic_cast<const AstStringConstant*>(arg) != nullptr;
+        if (!isSymbol && dynamic_cast<const AstNumberConstant*>(arg) == nullptr) {
+            return false;
+        }
+        AstDomain value = static_cast<const AstConstant*>(arg)->getIndex();
+        if (value < MIN_AST_DOMAIN || value > MAX_AST_DOMAIN) {
+            return false;
+        }
+        bool columnSymbolic;
+        if (table != nullptr) {
+            columnSymbolic = table->isSymbolic(i);
+        } else if (!getTypeKind(program, rel->getAttribute(i)->getTypeName(), columnSymbolic)) {
+            return false;
+        }
+        if (columnSymbolic != isSymbol) {
+            return false;
+        }
+        symbolic.push_back(isSymbol);
+        tuple.push_back(static_cast<RamDomain>(value));
+    }
+
+    // few facts are kept as clauses, as they always were
+    if (table == nullptr && ++groundFacts[head->getName()] <= factTableThreshold) {
+        return false;
+    }
+    if (table == nullptr) {
+        SymbolTable& symbolTable = translationUnit->getSymbolTable();
+        rel->setFactTable(std::make_unique<AstFactTable>(symbolic, symbolTable, fact.getSrcLoc()));
+        table = rel->getFactTable();
+    }
+    table->insert(tuple);
+    return true;
+}
 void ParserDriver::addComponent(std::unique_ptr<AstComponent> c) {
     translationUnit->getProgram()->addComponent(std::move(c));
 }
@@ -16,9 +16,11 @@
 
 #pragma once
 
+#include "AstRelationIdentifier.h"
 #include "SrcLocation.h"
 #include "parser.hh"
 #include <cstdio>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -60,6 +62,18 @@ public:
     void addLoad(std::unique_ptr<AstLoad> d);
     void addType(std::unique_ptr<AstType> type);
     void addClause(std::unique_ptr<AstClause> c);
+
+    /**
+     * Keeps a ground fact in the fact table of its relation rather than as a
+     * clause, if the relation has many facts, is declared already and the
+     * constants of the fact match the types of its attributes. Returns
+     * whether it did.
+     */
+    bool addFact(const AstClause& fact);
+
+    /** The ground facts of each relation kept as clauses */
+    std::map<AstRelationIdentifier, size_t> groundFacts;
+
     void addComponent(std::unique_ptr<AstComponent> c);
     void addInstantiation(std::unique_ptr<AstComponentInit> ci);
     void addPragma(std::unique_ptr<AstPragma> p);
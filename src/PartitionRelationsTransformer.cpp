@@ -0,0 +1,270 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file PartitionRelationsTransformer.cpp
+ *
+ * Define classes and functionality related to the horizontal partitioning
+ * of relations by a constant discriminator column.
+ *
+ ***********************************************************************/
+
+#include "AstArgument.h"
+#include "AstAttribute.h"
+#include "AstClause.h"
+#include "AstIOTypeAnalysis.h"
+#include "AstLiteral.h"
+#include "AstNode.h"
+#include "AstProgram.h"
+#include "AstRelation.h"
+#include "AstRelationIdentifier.h"
+#include "AstTransforms.h"
+#include "AstTranslationUnit.h"
+#include "AstVisitor.h"
+#include "DebugReport.h"
+#include "Global.h"
+#include "Util.h"
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+namespace {
+
+/** The partitioning of a relation by the constants of one of its columns */
+struct Partitioning {
+    /** the discriminator column */
+    size_t column;
+
+    /** the partition of each constant of the column, keyed by the printed constant */
+    std::map<std::string, AstRelationIdentifier> partitions;
+
+    /** the constant of each partition */
+    std::map<std::string, std::unique_ptr<AstArgument>> constants;
+};
+
+/** Get the argument of an atom at a column if it is a number or string constant, nullptr otherwise */
+const AstArgument* getDiscriminator(const AstAtom& atom, size_t column) {
+    const AstArgument* arg = atom.getArgument(column);
+    if (dynamic_cast<const AstNumberConstant*>(arg) != nullptr ||
+            dynamic_cast<const AstStringConstant*>(arg) != nullptr) {
+        return arg;
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+bool PartitionRelationsTransformer::transform(AstTranslationUnit& translationUnit) {
+    AstProgram& program = *translationUnit.getProgram();
+    const auto* ioType = translationUnit.getAnalysis<IOType>();
+    std::stringstream report;
+
+    // the body atoms of each relation, including those in negations and aggregates
+    std::map<AstRelationIdentifier, std::vector<const AstAtom*>> uses;
+    for (const AstRelation* rel : program.getRelations()) {
+        for (const AstClause* clause : rel->getClauses()) {
+            visitDepthFirst(*clause, [&](const AstAtom& atom) {
+                if (&atom != clause->getHead()) {
+                    uses[atom.getName()].push_back(&atom);
+                }
+            });
+        }
+    }
+
+    // -- select the discriminator column of each relation --
+
+    // a column qualifies if every rule of the relation derives a constant at it and there are at least
+    // two distinct constants; the column bound to a constant by most body atoms is chosen
+    std::map<AstRelationIdentifier, Partitioning> partitionings;
+    for (const AstRelation* rel : program.getRelations()) {
+        const auto clauses = rel->getClauses();
+        if (rel->getArity() < 2 || clauses.size() < 2 || rel->isInline() || ioType->isIO(rel) ||
+                rel->isSubsumptive() || rel->getRepresentation() == RelationRepresentation::EQREL ||
+                rel->getRepresentation() == RelationRepresentation::STORAGE ||
+                rel->getFactTable() != nullptr) {
+            continue;
+        }
+
+        size_t bestColumn = 0;
+        size_t bestBound = 0;
+        for (size_t column = 0; column < rel->getArity(); column++) {
+            std::set<std::string> keys;
+            bool constant = true;
+            for (const AstClause* clause : clauses) {
+                const AstArgument* arg = getDiscriminator(*clause->getHead(), column);
+                if (arg == nullptr) {
+                    constant = false;
+                    break;
+                }
+                keys.insert(toString(*arg));
+            }
+            if (!constant || keys.size() < 2) {
+                continue;
+            }
+            size_t bound = 0;
+            for (const AstAtom* atom : uses[rel->getName()]) {
+                if (getDiscriminator(*atom, column) != nullptr) {
+                    bound++;
+                }
+            }
+            if (bound > bestBound) {
+                bestColumn = column;
+                bestBound = bound;
+            }
+        }
+        if (bestBound == 0) {
+            continue;
+        }
+
+        // one partition per constant derived by a rule, named after the relation
+        Partitioning& partitioning = partitionings[rel->getName()];
+        partitioning.column = bestColumn;
+        for (const AstClause* clause : clauses) {
+            const AstArgument* arg = getDiscriminator(*clause->getHead(), bestColumn);
+            std::string key = toString(*arg);
+            if (partitioning.partitions.count(key) != 0) {
+                continue;
+            }
+            std::string name = toString(rel->getName()) + "+part" + toString(partitioning.partitions.size());
+            while (program.getRelation(name) != nullptr) {
+                name += "+";
+            }
+            partitioning.partitions[key] = name;
+            partitioning.constants[key] = std::unique_ptr<AstArgument>(arg->clone());
+
+            // the partition keeps the remaining attributes and the representation of the relation
+            auto* part = new AstRelation();
+            part->setName(name);
+            part->setSrcLoc(rel->getSrcLoc());
+            for (size_t i = 0; i < rel->getArity(); i++) {
+                if (i != bestColumn) {
+                    part->addAttribute(std::unique_ptr<AstAttribute>(rel->getAttribute(i)->clone()));
+                }
+            }
+            const int ioQualifiers = INPUT_RELATION | OUTPUT_RELATION | PRINTSIZE_RELATION;
+            part->setQualifier(rel->getQualifier() & ~ioQualifiers);
+            part->setRepresentation(rel->getRepresentation());
+            program.appendRelation(std::unique_ptr<AstRelation>(part));
+        }
+
+        report << rel->getName() << ": partitioned by column " << bestColumn << " into "
+               << partitioning.partitions.size() << " relations, " << bestBound << " of "
+               << uses[rel->getName()].size() << " uses bind the column\n";
+    }
+
+    if (partitionings.empty()) {
+        return false;
+    }
+
+    // -- replace the atoms binding a discriminator to a constant by atoms of the partitions --
+
+    struct partitionAtoms : public AstNodeMapper {
+        const std::map<AstRelationIdentifier, Partitioning>& partitionings;
+
+        partitionAtoms(const std::map<AstRelationIdentifier, Partitioning>& partitionings)
+                : partitionings(partitionings) {}
+
+        std::unique_ptr<AstNode> operator()(std::unique_ptr<AstNode> node) const override {
+            node->apply(*this);
+            if (auto* atom = dynamic_cast<AstAtom*>(node.get())) {
+                auto pos = partitionings.find(atom->getName());
+                if (pos == partitionings.end()) {
+                    return node;
+                }
+                const Partitioning& partitioning = pos->second;
+                const AstArgument* arg = getDiscriminator(*atom, partitioning.column);
+                if (arg == nullptr) {
+                    return node;
+                }
+                auto part = partitioning.partitions.find(toString(*arg));
+                if (part == partitioning.partitions.end()) {
+                    // no rule derives the constant, the atom is left to the (empty) union
+                    return node;
+                }
+                auto* partAtom = new AstAtom(part->second);
+                partAtom->setSrcLoc(atom->getSrcLoc());
+                for (size_t i = 0; i < atom->getArity(); i++) {
+                    if (i != partitioning.column) {
+                        partAtom->addArgument(std::unique_ptr<AstArgument>(atom->getArgument(i)->clone()));
+                    }
+                }
+                return std::unique_ptr<AstNode>(partAtom);
+            }
+            return node;
+        }
+    };
+
+    program.apply(partitionAtoms(partitionings));
+
+    // -- move the rules of the partitioned relations and union the partitions where still used --
+
+    for (const auto& cur : partitionings) {
+        AstRelation* rel = program.getRelation(cur.first);
+        for (const AstClause* clause : rel->getClauses()) {
+            std::unique_ptr<AstClause> moved(clause->clone());
+            rel->removeClause(clause);
+            program.appendClause(std::move(moved));
+        }
+    }
+
+    for (const auto& cur : partitionings) {
+        AstRelation* rel = program.getRelation(cur.first);
+        const Partitioning& partitioning = cur.second;
+        bool used = false;
+        visitDepthFirst(program, [&](const AstAtom& atom) {
+            if (atom.getName() == rel->getName()) {
+                used = true;
+            }
+        });
+        if (!used) {
+            program.removeRelation(rel->getName());
+            continue;
+        }
+
+        // R(k, x0, .., xn) :- R+part(x0, .., xn) for the constant k of each partition
+        for (const auto& part : partitioning.partitions) {
+            auto* clause = new AstClause();
+            clause->setSrcLoc(rel->getSrcLoc());
+            auto* head = new AstAtom(rel->getName());
+            auto* body = new AstAtom(part.second);
+            for (size_t i = 0; i < rel->getArity(); i++) {
+                if (i == partitioning.column) {
+                    head->addArgument(
+                            std::unique_ptr<AstArgument>(partitioning.constants.at(part.first)->clone()));
+                } else {
+                    head->addArgument(std::make_unique<AstVariable>("x" + toString(i)));
+                    body->addArgument(std::make_unique<AstVariable>("x" + toString(i)));
+                }
+            }
+            clause->setHead(std::unique_ptr<AstAtom>(head));
+            clause->addToBody(std::unique_ptr<AstLiteral>(body));
+            rel->addClause(std::unique_ptr<AstClause>(clause));
+        }
+        report << rel->getName() << ": kept as the union of its partitions\n";
+    }
+
+    if (DebugReport::isSelected("relation-partitioning")) {
+        translationUnit.getDebugReport().addSection(DebugReporter::getCodeSection(
+                "relation-partitioning", "Relation Partitioning", report.str()));
+    }
+    if (Global::config().has("verbose")) {
+        std::cout << report.str();
+    }
+    return true;
+}
+
+}  // end of namespace souffle
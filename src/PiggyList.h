@@ -3,13 +3,58 @@
 #include "ParallelUtils.h"
 #include <array>
 #include <atomic>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <list>
+#include <type_traits>
+
+#include <sys/mman.h>
 
 using std::size_t;
 namespace souffle {
 
+namespace detail {
+
+// blocks of at least this many bytes are mapped directly from the operating system
+constexpr size_t MAPPED_BLOCK_BYTES = 1ul << 21;
+
+/**
+ * Allocates a zero-initialised block of elements for a piggy list. Large blocks are mapped
+ * anonymously, such that their pages are only zeroed once touched, and are backed by huge
+ * pages where available to keep huge lists from thrashing the TLB.
+ */
+template <class T>
+T* allocateBlock(size_t numElements) {
+    static_assert(std::is_trivially_destructible<T>::value, "elements must not require destruction");
+    const size_t bytes = numElements * sizeof(T);
+    if (bytes >= MAPPED_BLOCK_BYTES) {
+        void* block = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+            madvise(block, bytes, MADV_HUGEPAGE);
+#endif
+            return static_cast<T*>(block);
+        }
+    }
+    void* block = std::calloc(numElements, sizeof(T));
+    if (block == nullptr) throw std::bad_alloc();
+    return static_cast<T*>(block);
+}
+
+/**
+ * Releases a block obtained from allocateBlock.
+ */
+template <class T>
+void freeBlock(T* block, size_t numElements) {
+    if (block == nullptr) return;
+    const size_t bytes = numElements * sizeof(T);
+    if (bytes >= MAPPED_BLOCK_BYTES && munmap(block, bytes) == 0) return;
+    std::free(block);
+}
+
+}  // namespace detail
+
 /**
  * A PiggyList that allows insertAt functionality.
  * This means we can't append, as we don't know the next available element.
@@ -34,7 +79,7 @@ public:
                 const size_t blockSize = INITIALBLOCKSIZE << i;
 
                 // allocate that in the new container
-                this->blockLookupTable[i].store(new T[blockSize]);
+                this->blockLookupTable[i].store(detail::allocateBlock<T>(blockSize));
 
                 // then copy the stuff over
                 std::memcpy(this->blockLookupTable[i].load(), other.blockLookupTable[i].load(),
@@ -65,25 +110,38 @@ public:
     inline T& get(size_t index) const {
         size_t nindex = index + INITIALBLOCKSIZE;
         size_t blockNum = (63 - __builtin_clzll(nindex));
-        size_t blockInd = (nindex) & ((1 << blockNum) - 1);
+        size_t blockInd = (nindex) & ((1ul << blockNum) - 1);
         return this->getBlock(blockNum - BLOCKBITS)[blockInd];
     }
 
-    void insertAt(size_t index, T value) {
-        // starting with an initial blocksize requires some shifting to transform into a nice powers of two
-        // series
-        size_t blockNum = (63 - __builtin_clzll(index + INITIALBLOCKSIZE)) - BLOCKBITS;
+    /**
+     * Determines whether the block holding the given index has been allocated.
+     */
+    inline bool isAllocated(size_t index) const {
+        return blockLookupTable[getBlockNum(index)].load(std::memory_order_acquire) != nullptr;
+    }
+
+    /**
+     * Obtains the element at the given index, allocating its zero-initialised block if necessary.
+     * The number of elements is not affected.
+     */
+    T& getOrCreate(size_t index) {
+        size_t blockNum = getBlockNum(index);
 
         // allocate the block if not allocated
-        if (blockLookupTable[blockNum].load() == nullptr) {
+        if (blockLookupTable[blockNum].load(std::memory_order_acquire) == nullptr) {
             slock.lock();
             if (blockLookupTable[blockNum].load() == nullptr) {
-                blockLookupTable[blockNum].store(new T[INITIALBLOCKSIZE << blockNum]);
+                blockLookupTable[blockNum].store(detail::allocateBlock<T>(INITIALBLOCKSIZE << blockNum));
             }
             slock.unlock();
         }
 
-        this->get(index) = value;
+        return this->get(index);
+    }
+
+    void insertAt(size_t index, T value) {
+        getOrCreate(index) = value;
         // we ALWAYS increment size, even if there was something there before (its impossible to tell!)
         // the onus is up to the user to not call this for an index twice
         ++numElements;
@@ -104,16 +162,22 @@ public:
     std::array<std::atomic<T*>, maxContainers> blockLookupTable = {};
 
     // for parallel node insertions
-    mutable SpinLock slock;
+    mutable AdaptiveLock slock;
+
+    // starting with an initial blocksize requires some shifting to transform into a nice powers of two
+    // series
+    inline size_t getBlockNum(size_t index) const {
+        return (63 - __builtin_clzll(index + INITIALBLOCKSIZE)) - BLOCKBITS;
+    }
 
     /**
      * Free the arrays allocated within the linked list nodes
      */
     void freeList() {
         slock.lock();
-        // delete all - deleting a nullptr is a no-op
+        // delete all - freeing a nullptr is a no-op
         for (size_t i = 0; i < maxContainers; ++i) {
-            delete[] blockLookupTable[i].load();
+            detail::freeBlock(blockLookupTable[i].load(), INITIALBLOCKSIZE << i);
             // reset the container within to be empty.
             blockLookupTable[i].store(nullptr);
         }
@@ -137,7 +201,7 @@ public:
         // the size of the next container to allocate
         size_t cSize = BLOCKSIZE;
         for (size_t i = 0; i < other.num_containers; ++i) {
-            this->blockLookupTable[i] = new T[cSize];
+            this->blockLookupTable[i] = detail::allocateBlock<T>(cSize);
             std::memcpy(this->blockLookupTable[i], other.blockLookupTable[i], cSize * sizeof(T));
             cSize <<= 1;
         }
@@ -176,7 +240,7 @@ public:
             sl.lock();
             // check and add as many containers as required
             while (container_size < new_index + 1) {
-                blockLookupTable[num_containers] = new T[allocsize];
+                blockLookupTable[num_containers] = detail::allocateBlock<T>(allocsize);
                 num_containers += 1;
                 container_size += allocsize;
                 // double the number elements that will be allocated next time
@@ -197,7 +261,7 @@ public:
             sl.lock();
             // check and add as many containers as required
             while (container_size < new_index + 1) {
-                blockLookupTable[num_containers] = new T[allocsize];
+                blockLookupTable[num_containers] = detail::allocateBlock<T>(allocsize);
                 num_containers += 1;
                 container_size += allocsize;
                 // double the number elements that will be allocated next time
@@ -218,7 +282,7 @@ public:
         // supa fast 2^16 size first block
         size_t nindex = index + BLOCKSIZE;
         size_t blockNum = (63 - __builtin_clzll(nindex));
-        size_t blockInd = (nindex) & ((1 << blockNum) - 1);
+        size_t blockInd = (nindex) & ((1ul << blockNum) - 1);
         return this->getBlock(blockNum - BLOCKBITS)[blockInd];
     }
 
@@ -294,7 +358,7 @@ public:
     std::array<T*, max_conts> blockLookupTable = {};
 
     // for parallel node insertions
-    mutable SpinLock sl;
+    mutable AdaptiveLock sl;
 
     /**
      * Free the arrays allocated within the linked list nodes
@@ -303,7 +367,7 @@ public:
         sl.lock();
         // we don't know which ones are taken up!
         for (size_t i = 0; i < num_containers; ++i) {
-            delete[] blockLookupTable[i];
+            detail::freeBlock(blockLookupTable[i], BLOCKSIZE << i);
         }
         sl.unlock();
     }
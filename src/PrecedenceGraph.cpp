@@ -20,6 +20,7 @@
 #include "AstClause.h"
 #include "AstIOTypeAnalysis.h"
 #include "AstLiteral.h"
+#include "AstProfileUse.h"
 #include "AstProgram.h"
 #include "AstRelation.h"
 #include "AstRelationIdentifier.h"
@@ -36,38 +37,42 @@
 namespace souffle {
 
 void PrecedenceGraph::run(const AstTranslationUnit& translationUnit) {
-    /* Get relations */
-    std::vector<AstRelation*> relations = translationUnit.getProgram()->getRelations();
+    /* Number relations in the order of their names */
+    relations.clear();
+    ids.clear();
+    for (const AstRelation* r : translationUnit.getProgram()->getRelations()) {
+        ids[r] = relations.size();
+        relations.push_back(r);
+    }
 
-    for (AstRelation* r : relations) {
-        backingGraph.insert(r);
+    std::vector<CompactGraph::Edge> edges;
+    for (size_t id = 0; id < relations.size(); id++) {
+        const AstRelation* r = relations[id];
         for (size_t i = 0; i < r->clauseSize(); i++) {
             AstClause* c = r->getClause(i);
             const std::set<const AstRelation*>& dependencies =
                     getBodyRelations(c, translationUnit.getProgram());
             for (auto source : dependencies) {
-                backingGraph.insert(source, r);
+                // undefined relations are reported by the semantic checker
+                if (source != nullptr) {
+                    edges.emplace_back(ids.at(source), id);
+                }
             }
         }
     }
+    backingGraph = CompactGraph(relations.size(), std::move(edges));
 }
 
 void PrecedenceGraph::print(std::ostream& os) const {
     /* Print dependency graph */
     os << "digraph {\n";
     /* Print node of dependence graph */
-    for (const AstRelation* rel : backingGraph.vertices()) {
-        if (rel) {
-            os << "\t\"" << rel->getName() << "\" [label = \"" << rel->getName() << "\"];\n";
-        }
+    for (const AstRelation* rel : relations) {
+        os << "\t\"" << rel->getName() << "\" [label = \"" << rel->getName() << "\"];\n";
     }
-    for (const AstRelation* rel : backingGraph.vertices()) {
-        if (rel) {
-            for (const AstRelation* adjRel : backingGraph.successors(rel)) {
-                if (adjRel) {
-                    os << "\t\"" << rel->getName() << "\" -> \"" << adjRel->getName() << "\";\n";
-                }
-            }
+    for (const AstRelation* rel : relations) {
+        for (const size_t adj : successors(rel)) {
+            os << "\t\"" << rel->getName() << "\" -> \"" << relations[adj]->getName() << "\";\n";
         }
     }
     os << "}\n";
@@ -76,40 +81,41 @@ void PrecedenceGraph::print(std::ostream& os) const {
 void RedundantRelations::run(const AstTranslationUnit& translationUnit) {
     precedenceGraph = translationUnit.getAnalysis<PrecedenceGraph>();
 
-    std::set<const AstRelation*> work;
-    std::set<const AstRelation*> notRedundant;
+    const size_t numRelations = precedenceGraph->getNumberOfRelations();
+    std::vector<size_t> work;
+    std::vector<bool> notRedundant(numRelations, false);
     auto* ioType = translationUnit.getAnalysis<IOType>();
 
-    const std::vector<AstRelation*>& relations = translationUnit.getProgram()->getRelations();
-    /* Add all output relations to the work set */
-    for (const AstRelation* r : relations) {
-        if (ioType->isOutput(r)) {
-            work.insert(r);
+    /* Add all output relations to the work list */
+    for (size_t id = 0; id < numRelations; id++) {
+        if (ioType->isOutput(precedenceGraph->getRelation(id))) {
+            notRedundant[id] = true;
+            work.push_back(id);
         }
     }
 
     /* Find all relations which are not redundant for the computations of the
        output relations. */
     while (!work.empty()) {
-        /* Chose one element in the work set and add it to notRedundant */
-        const AstRelation* u = *(work.begin());
-        work.erase(work.begin());
-        notRedundant.insert(u);
+        /* Chose one element in the work list */
+        const size_t u = work.back();
+        work.pop_back();
 
         /* Find all predecessors of u and add them to the worklist
             if they are not in the set notRedundant */
-        for (const AstRelation* predecessor : precedenceGraph->graph().predecessors(u)) {
-            if (!notRedundant.count(predecessor)) {
-                work.insert(predecessor);
+        for (const size_t predecessor : precedenceGraph->graph().predecessors(u)) {
+            if (!notRedundant[predecessor]) {
+                notRedundant[predecessor] = true;
+                work.push_back(predecessor);
             }
         }
     }
 
     /* All remaining relations are redundant. */
     redundantRelations.clear();
-    for (const AstRelation* r : relations) {
-        if (!notRedundant.count(r)) {
-            redundantRelations.insert(r);
+    for (size_t id = 0; id < numRelations; id++) {
+        if (!notRedundant[id]) {
+            redundantRelations.insert(precedenceGraph->getRelation(id));
         }
     }
 }
@@ -189,26 +195,15 @@ void SCCGraph::run(const AstTranslationUnit& translationUnit) {
     predecessors.clear();
     successors.clear();
 
-    /* Compute SCC */
-    std::vector<AstRelation*> relations = translationUnit.getProgram()->getRelations();
-    size_t counter = 0;
-    size_t numSCCs = 0;
-    std::stack<const AstRelation*> S, P;
-    std::map<const AstRelation*, size_t> preOrder;  // Pre-order number of a node (for Gabow's Algo)
-    for (const AstRelation* relation : relations) {
-        relationToScc[relation] = preOrder[relation] = (size_t)-1;
-    }
-    for (const AstRelation* relation : relations) {
-        if (preOrder[relation] == (size_t)-1) {
-            scR(relation, preOrder, counter, S, P, numSCCs);
-        }
-    }
+    /* Compute SCC, following the predecessors such that the SCCs of predecessors come first */
+    const CompactGraph& graph = precedenceGraph->graph();
+    const size_t numSCCs = graph.computeSCCs(relationToScc, true);
 
     /* Build SCC graph */
     successors.resize(numSCCs);
     predecessors.resize(numSCCs);
-    for (const AstRelation* u : relations) {
-        for (const AstRelation* v : precedenceGraph->graph().predecessors(u)) {
+    for (size_t u = 0; u < graph.size(); u++) {
+        for (const size_t v : graph.predecessors(u)) {
             auto scc_u = relationToScc[u];
             auto scc_v = relationToScc[v];
             assert(scc_u < numSCCs && "Wrong range");
@@ -222,41 +217,9 @@ void SCCGraph::run(const AstTranslationUnit& translationUnit) {
 
     /* Store the relations for each SCC */
     sccToRelation.resize(numSCCs);
-    for (const AstRelation* relation : relations) {
-        sccToRelation[relationToScc[relation]].insert(relation);
-    }
-}
-
-/* Compute strongly connected components using Gabow's algorithm (cf. Algorithms in
- * Java by Robert Sedgewick / Part 5 / Graph *  algorithms). The algorithm has linear
- * runtime. */
-void SCCGraph::scR(const AstRelation* w, std::map<const AstRelation*, size_t>& preOrder, size_t& counter,
-        std::stack<const AstRelation*>& S, std::stack<const AstRelation*>& P, size_t& numSCCs) {
-    preOrder[w] = counter++;
-    S.push(w);
-    P.push(w);
-    for (const AstRelation* t : precedenceGraph->graph().predecessors(w)) {
-        if (preOrder[t] == (size_t)-1) {
-            scR(t, preOrder, counter, S, P, numSCCs);
-        } else if (relationToScc[t] == (size_t)-1) {
-            while (preOrder[P.top()] > preOrder[t]) {
-                P.pop();
-            }
-        }
-    }
-    if (P.top() == w) {
-        P.pop();
-    } else {
-        return;
+    for (size_t id = 0; id < graph.size(); id++) {
+        sccToRelation[relationToScc[id]].insert(precedenceGraph->getRelation(id));
     }
-
-    const AstRelation* v;
-    do {
-        v = S.top();
-        S.pop();
-        relationToScc[v] = numSCCs;
-    } while (v != w);
-    numSCCs++;
 }
 
 void SCCGraph::print(std::ostream& os) const {
@@ -315,59 +278,57 @@ int TopologicallySortedSCCGraph::topologicalOrderingCost(const std::vector<size_
     return costOfPermutation;
 }
 
-void TopologicallySortedSCCGraph::computeTopologicalOrdering(size_t scc, std::vector<bool>& visited) {
-    // create a flag to indicate that a successor was visited (by default it hasn't been)
-    bool found = false, hasUnvisitedSuccessor = false, hasUnvisitedPredecessor = false;
-    // for each successor of the input scc
-    const auto& successorsToVisit = sccGraph->getSuccessorSCCs(scc);
-    for (const auto scc_i : successorsToVisit) {
-        if (visited[scc_i]) {
-            continue;
-        }
-        hasUnvisitedPredecessor = false;
-        const auto& successorsPredecessors = sccGraph->getPredecessorSCCs(scc_i);
-        for (const auto scc_j : successorsPredecessors) {
-            if (!visited[scc_j]) {
-                hasUnvisitedPredecessor = true;
-                break;
+void TopologicallySortedSCCGraph::computeTopologicalOrdering(size_t root, std::vector<bool>& visited) {
+    auto hasUnvisited = [&](const std::set<size_t>& sccs) {
+        for (const auto scc : sccs) {
+            if (!visited[scc]) {
+                return true;
             }
         }
-        if (!hasUnvisitedPredecessor) {
+        return false;
+    };
+
+    // the path of sccs being extended, each with its next successor and a flag to indicate that a
+    // successor was visited (by default it hasn't been)
+    struct Frame {
+        size_t scc;
+        std::set<size_t>::const_iterator next;
+        bool found;
+    };
+    std::vector<Frame> path;
+    path.push_back({root, sccGraph->getSuccessorSCCs(root).begin(), false});
+    while (!path.empty()) {
+        const size_t scc = path.back().scc;
+        const auto& successorsToVisit = sccGraph->getSuccessorSCCs(scc);
+        // find the next successor of the scc on top of the path whose predecessors are all visited
+        bool extended = false;
+        while (path.back().next != successorsToVisit.end()) {
+            const auto scc_i = *path.back().next++;
+            if (visited[scc_i] || hasUnvisited(sccGraph->getPredecessorSCCs(scc_i))) {
+                continue;
+            }
             // give it a temporary marking
             visited[scc_i] = true;
             // add it to the permanent ordering
             sccOrder.push_back(scc_i);
-            // and use it as a root node in a recursive call to this function
-            computeTopologicalOrdering(scc_i, visited);
-            // finally, indicate that a successor has been found for this node
-            found = true;
-        }
-    }
-    // return at once if no valid successors have been found; as either it has none or they all have a
-    // better predecessor
-    if (!found) {
-        return;
-    }
-    hasUnvisitedPredecessor = false;
-    const auto& predecessors = sccGraph->getPredecessorSCCs(scc);
-    for (const auto scc_j : predecessors) {
-        if (!visited[scc_j]) {
-            hasUnvisitedPredecessor = true;
+            // indicate that a successor has been found for this node
+            path.back().found = true;
+            // and use it as the root node of the path
+            path.push_back({scc_i, sccGraph->getSuccessorSCCs(scc_i).begin(), false});
+            extended = true;
             break;
         }
-    }
-    hasUnvisitedSuccessor = false;
-    const auto& successors = sccGraph->getSuccessorSCCs(scc);
-    for (const auto scc_j : successors) {
-        if (!visited[scc_j]) {
-            hasUnvisitedSuccessor = true;
-            break;
+        if (extended) {
+            continue;
         }
-    }
-    // otherwise, if more white successors remain for the current scc, use it again as the root node in a
-    // recursive call to this function
-    if (hasUnvisitedSuccessor && !hasUnvisitedPredecessor) {
-        computeTopologicalOrdering(scc, visited);
+        // if valid successors have been found, and more white successors remain for the current scc,
+        // use it again as the root node; otherwise it has none or they all have a better predecessor
+        if (path.back().found && !hasUnvisited(sccGraph->getPredecessorSCCs(scc)) &&
+                hasUnvisited(successorsToVisit)) {
+            path.back() = {scc, successorsToVisit.begin(), false};
+            continue;
+        }
+        path.pop_back();
     }
 }
 
@@ -393,6 +354,92 @@ void TopologicallySortedSCCGraph::run(const AstTranslationUnit& translationUnit)
             }
         }
     }
+    if (Global::config().get("stratum-order") == "memory") {
+        computeMemoryOrdering(translationUnit);
+    }
+}
+
+void TopologicallySortedSCCGraph::computeMemoryOrdering(const AstTranslationUnit& translationUnit) {
+    const auto* precedenceGraph = translationUnit.getAnalysis<PrecedenceGraph>();
+    auto* profileUse =
+            Global::config().has("profile-use") ? translationUnit.getAnalysis<AstProfileUse>() : nullptr;
+    const size_t numSCCs = sccGraph->getNumberOfSCCs();
+
+    // the estimated size of each relation
+    std::map<const AstRelation*, double> sizes;
+    for (size_t scc = 0; scc < numSCCs; scc++) {
+        for (const AstRelation* rel : sccGraph->getInternalRelations(scc)) {
+            double tuples = 1;
+            if (profileUse != nullptr && profileUse->hasRelationSize(rel->getName())) {
+                tuples = profileUse->getRelationSize(rel->getName());
+            }
+            sizes[rel] = tuples * std::max<size_t>(rel->getArity(), 1);
+        }
+    }
+
+    // the relations of other SCCs read by each SCC, and the number of SCCs yet to read each relation
+    std::vector<std::set<const AstRelation*>> reads(numSCCs);
+    std::map<const AstRelation*, size_t> readers;
+    for (size_t scc = 0; scc < numSCCs; scc++) {
+        for (const AstRelation* rel : sccGraph->getInternalRelations(scc)) {
+            for (const size_t id : precedenceGraph->predecessors(rel)) {
+                const AstRelation* pred = precedenceGraph->getRelation(id);
+                if (sccGraph->getSCC(pred) != scc && reads[scc].insert(pred).second) {
+                    readers[pred]++;
+                }
+            }
+        }
+    }
+
+    // the position of each SCC in the default order, breaking ties
+    std::vector<size_t> position(numSCCs);
+    for (size_t i = 0; i < sccOrder.size(); i++) {
+        position[sccOrder[i]] = i;
+    }
+
+    // schedule the SCCs one at a time, choosing the one growing the live relations the least
+    std::vector<size_t> missingPreds(numSCCs);
+    for (size_t scc = 0; scc < numSCCs; scc++) {
+        missingPreds[scc] = sccGraph->getPredecessorSCCs(scc).size();
+    }
+    std::vector<bool> scheduled(numSCCs, false);
+    std::vector<size_t> order;
+    while (order.size() < numSCCs) {
+        size_t best = numSCCs;
+        double bestGrowth = 0;
+        for (size_t scc = 0; scc < numSCCs; scc++) {
+            if (scheduled[scc] || missingPreds[scc] != 0) {
+                continue;
+            }
+            // the relations of the SCC read later on become alive, those it reads last expire
+            double growth = 0;
+            for (const AstRelation* rel : sccGraph->getInternalRelations(scc)) {
+                if (readers[rel] != 0) {
+                    growth += sizes[rel];
+                }
+            }
+            for (const AstRelation* rel : reads[scc]) {
+                if (readers[rel] == 1) {
+                    growth -= sizes[rel];
+                }
+            }
+            if (best == numSCCs || growth < bestGrowth ||
+                    (growth == bestGrowth && position[scc] < position[best])) {
+                best = scc;
+                bestGrowth = growth;
+            }
+        }
+        assert(best != numSCCs && "SCC graph is cyclic");
+        scheduled[best] = true;
+        order.push_back(best);
+        for (const AstRelation* rel : reads[best]) {
+            readers[rel]--;
+        }
+        for (size_t succ : sccGraph->getSuccessorSCCs(best)) {
+            missingPreds[succ]--;
+        }
+    }
+    sccOrder.swap(order);
 }
 
 void TopologicallySortedSCCGraph::print(std::ostream& os) const {
@@ -479,8 +526,8 @@ std::vector<std::set<const AstRelation*>> RelationSchedule::computeRelationExpir
         /* Add predecessors of relations computed in this step */
         auto scc = topsortSCCGraph->order()[numSCCs - orderedSCC];
         for (const AstRelation* r : sccGraph->getInternalRelations(scc)) {
-            for (const AstRelation* predecessor : precedenceGraph->graph().predecessors(r)) {
-                alive[orderedSCC].insert(predecessor);
+            for (const size_t predecessor : precedenceGraph->predecessors(r)) {
+                alive[orderedSCC].insert(precedenceGraph->getRelation(predecessor));
             }
         }
 
@@ -492,6 +539,17 @@ std::vector<std::set<const AstRelation*>> RelationSchedule::computeRelationExpir
                         relationExpirySchedule[numSCCs - orderedSCC].end()));
     }
 
+    /* Relations read by no step expire in the step computing them, unless kept for incremental updates */
+    if (!Global::config().has("incremental")) {
+        for (size_t i = 0; i < numSCCs; i++) {
+            for (const AstRelation* r : sccGraph->getInternalRelations(topsortSCCGraph->order()[i])) {
+                if (precedenceGraph->successors(r).empty()) {
+                    relationExpirySchedule[i].insert(r);
+                }
+            }
+        }
+    }
+
     return relationExpirySchedule;
 }
 
@@ -22,6 +22,7 @@
 #include "AstIOTypeAnalysis.h"
 #include "AstRelation.h"
 #include "GraphUtils.h"
+#include "Util.h"
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
@@ -29,7 +30,8 @@
 #include <iterator>
 #include <map>
 #include <set>
-#include <stack>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -50,13 +52,45 @@ public:
     /** Output precedence graph in graphviz format to a given stream */
     void print(std::ostream& os) const override;
 
-    const Graph<const AstRelation*, AstNameComparison>& graph() const {
+    /** The graph of the relations, numbered in the order of their names */
+    const CompactGraph& graph() const {
         return backingGraph;
     }
 
+    /** Get the number of relations in the graph */
+    size_t getNumberOfRelations() const {
+        return relations.size();
+    }
+
+    /** Get the vertex of the given relation */
+    size_t getId(const AstRelation* relation) const {
+        return ids.at(relation);
+    }
+
+    /** Get the relation of the given vertex */
+    const AstRelation* getRelation(size_t id) const {
+        return relations.at(id);
+    }
+
+    /** Get the vertices of the relations depending on the given relation */
+    range<const size_t*> successors(const AstRelation* relation) const {
+        return backingGraph.successors(getId(relation));
+    }
+
+    /** Get the vertices of the relations the given relation depends on */
+    range<const size_t*> predecessors(const AstRelation* relation) const {
+        return backingGraph.predecessors(getId(relation));
+    }
+
 private:
-    /** Adjacency list of precedence graph (determined by the dependencies of the relations) */
-    Graph<const AstRelation*, AstNameComparison> backingGraph;
+    /** The relation of each vertex */
+    std::vector<const AstRelation*> relations;
+
+    /** The vertex of each relation */
+    std::unordered_map<const AstRelation*, size_t> ids;
+
+    /** Adjacency arrays of precedence graph (determined by the dependencies of the relations) */
+    CompactGraph backingGraph;
 };
 
 /**
@@ -110,8 +144,8 @@ class SCCGraph : public AstAnalysis {
 private:
     PrecedenceGraph* precedenceGraph = nullptr;
 
-    /** Map from node number to SCC number */
-    std::map<const AstRelation*, size_t> relationToScc;
+    /** Map from the vertex of a relation in the precedence graph to SCC number */
+    std::vector<size_t> relationToScc;
 
     /** Adjacency lists for the SCC graph */
     std::vector<std::set<size_t>> successors;
@@ -122,10 +156,6 @@ private:
     /** Relations contained in a SCC */
     std::vector<std::set<const AstRelation*>> sccToRelation;
 
-    /** Recursive scR method for computing SCC */
-    void scR(const AstRelation* relation, std::map<const AstRelation*, size_t>& preOrder, size_t& counter,
-            std::stack<const AstRelation*>& S, std::stack<const AstRelation*>& P, size_t& numSCCs);
-
     IOType* ioType = nullptr;
 
 public:
@@ -140,7 +170,7 @@ public:
 
     /** Get the SCC of the given relation. */
     const size_t getSCC(const AstRelation* rel) const {
-        return relationToScc.at(rel);
+        return relationToScc.at(precedenceGraph->getId(rel));
     }
 
     /** Get all successor SCCs of a given SCC. */
@@ -156,9 +186,9 @@ public:
     /** Get all SCCs containing a successor of a given relation. */
     const std::set<size_t> getSuccessorSCCs(const AstRelation* relation) const {
         std::set<size_t> successorSccs;
-        const auto scc = relationToScc.at(relation);
-        for (const auto& successor : precedenceGraph->graph().successors(relation)) {
-            const auto successorScc = relationToScc.at(successor);
+        const auto scc = getSCC(relation);
+        for (const size_t successor : precedenceGraph->successors(relation)) {
+            const auto successorScc = relationToScc[successor];
             if (successorScc != scc) successorSccs.insert(successorScc);
         }
         return successorSccs;
@@ -167,9 +197,9 @@ public:
     /** Get all SCCs containing a predecessor of a given relation. */
     const std::set<size_t> getPredecessorSCCs(const AstRelation* relation) const {
         std::set<size_t> predecessorSccs;
-        const auto scc = relationToScc.at(relation);
-        for (const auto& predecessor : precedenceGraph->graph().predecessors(relation)) {
-            const auto predecessorScc = relationToScc.at(predecessor);
+        const auto scc = getSCC(relation);
+        for (const size_t predecessor : precedenceGraph->predecessors(relation)) {
+            const auto predecessorScc = relationToScc[predecessor];
             if (predecessorScc != scc) predecessorSccs.insert(predecessorScc);
         }
         return predecessorSccs;
@@ -184,9 +214,10 @@ public:
     const std::set<const AstRelation*> getExternalOutputPredecessorRelations(const size_t scc) const {
         std::set<const AstRelation*> externOutPreds;
         for (const auto& relation : getInternalRelations(scc)) {
-            for (const auto& predecessor : precedenceGraph->graph().predecessors(relation)) {
-                if (relationToScc.at(predecessor) != scc && ioType->isOutput(predecessor)) {
-                    externOutPreds.insert(predecessor);
+            for (const size_t predecessor : precedenceGraph->predecessors(relation)) {
+                const AstRelation* predecessorRelation = precedenceGraph->getRelation(predecessor);
+                if (relationToScc[predecessor] != scc && ioType->isOutput(predecessorRelation)) {
+                    externOutPreds.insert(predecessorRelation);
                 }
             }
         }
@@ -197,9 +228,10 @@ public:
     const std::set<const AstRelation*> getExternalNonOutputPredecessorRelations(const size_t scc) const {
         std::set<const AstRelation*> externNonOutPreds;
         for (const auto& relation : getInternalRelations(scc)) {
-            for (const auto& predecessor : precedenceGraph->graph().predecessors(relation)) {
-                if (relationToScc.at(predecessor) != scc && !ioType->isOutput(predecessor)) {
-                    externNonOutPreds.insert(predecessor);
+            for (const size_t predecessor : precedenceGraph->predecessors(relation)) {
+                const AstRelation* predecessorRelation = precedenceGraph->getRelation(predecessor);
+                if (relationToScc[predecessor] != scc && !ioType->isOutput(predecessorRelation)) {
+                    externNonOutPreds.insert(predecessorRelation);
                 }
             }
         }
@@ -210,9 +242,9 @@ public:
     const std::set<const AstRelation*> getExternalPredecessorRelations(const size_t scc) const {
         std::set<const AstRelation*> externPreds;
         for (const auto& relation : getInternalRelations(scc)) {
-            for (const auto& predecessor : precedenceGraph->graph().predecessors(relation)) {
-                if (relationToScc.at(predecessor) != scc) {
-                    externPreds.insert(predecessor);
+            for (const size_t predecessor : precedenceGraph->predecessors(relation)) {
+                if (relationToScc[predecessor] != scc) {
+                    externPreds.insert(precedenceGraph->getRelation(predecessor));
                 }
             }
         }
@@ -234,8 +266,8 @@ public:
     const std::set<const AstRelation*> getInternalRelationsWithExternalSuccessors(const size_t scc) const {
         std::set<const AstRelation*> internsWithExternSuccs;
         for (const auto& relation : getInternalRelations(scc)) {
-            for (const auto& successor : precedenceGraph->graph().successors(relation)) {
-                if (relationToScc.at(successor) != scc) {
+            for (const size_t successor : precedenceGraph->successors(relation)) {
+                if (relationToScc[successor] != scc) {
                     internsWithExternSuccs.insert(relation);
                     break;
                 }
@@ -250,8 +282,8 @@ public:
         std::set<const AstRelation*> internNonOutsWithExternSuccs;
         for (const auto& relation : getInternalRelations(scc)) {
             if (!ioType->isOutput(relation)) {
-                for (const auto& successor : precedenceGraph->graph().successors(relation)) {
-                    if (relationToScc.at(successor) != scc) {
+                for (const size_t successor : precedenceGraph->successors(relation)) {
+                    if (relationToScc[successor] != scc) {
                         internNonOutsWithExternSuccs.insert(relation);
                         break;
                     }
@@ -277,7 +309,8 @@ public:
         const std::set<const AstRelation*>& sccRelations = sccToRelation.at(scc);
         if (sccRelations.size() == 1) {
             const AstRelation* singleRelation = *sccRelations.begin();
-            if (!precedenceGraph->graph().predecessors(singleRelation).count(singleRelation)) {
+            const size_t id = precedenceGraph->getId(singleRelation);
+            if (!precedenceGraph->graph().contains(id, id)) {
                 return false;
             }
         }
@@ -290,6 +323,12 @@ public:
 
 /**
  * Analysis pass computing a topologically sorted strongly connected component (SCC) graph.
+ *
+ * With --stratum-order=memory, the SCCs are ordered to keep the size of the relations alive at
+ * any time small instead: among the SCCs whose predecessors are computed, the one increasing the
+ * size of the live relations the least is computed next, where the relations of an SCC are alive
+ * from its evaluation until their last reader. Sizes are taken from the profile of --profile-use,
+ * counting a single tuple for relations missing from it, times the arity of the relations.
  */
 class TopologicallySortedSCCGraph : public AstAnalysis {
 private:
@@ -303,9 +342,12 @@ private:
     using the ordered SCCs. Returns -1 if the given vector is not a valid topological ordering. */
     int topologicalOrderingCost(const std::vector<size_t>& permutationOfSCCs) const;
 
-    /** Recursive component for the forwards algorithm computing the topological ordering of the SCCs. */
+    /** Iterative component for the forwards algorithm computing the topological ordering of the SCCs. */
     void computeTopologicalOrdering(size_t scc, std::vector<bool>& visited);
 
+    /** Reorder the SCCs to reduce the peak size of the relations alive during the evaluation. */
+    void computeMemoryOrdering(const AstTranslationUnit& translationUnit);
+
 public:
     static constexpr const char* name = "topological-scc-graph";
 
@@ -401,4 +443,14 @@ public:
     void print(std::ostream& os) const override;
 };
 
+/**
+ * The names of the analyses derived from the relations and the dependencies among them alone.
+ * They refer to each other, and remain valid as long as no relation is added, removed or made
+ * to depend on other relations.
+ */
+inline std::set<std::string> getRelationDependencyAnalyses() {
+    return {IOType::name, PrecedenceGraph::name, RedundantRelations::name, SCCGraph::name,
+            TopologicallySortedSCCGraph::name, RelationSchedule::name};
+}
+
 }  // end of namespace souffle
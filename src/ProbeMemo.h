@@ -0,0 +1,66 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ProbeMemo.h
+ *
+ * A memo of the last probe of an index, for loops whose consecutive
+ * iterations search the index for the same key, e.g. since the outer loop
+ * enumerates its tuples ordered by the columns the key is bound to.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace souffle {
+
+/**
+ * The result of the last probe of an index, reused by the next probe for the
+ * same key. The memo is owned by a single thread, and the probed relation must
+ * not be modified while it is in use.
+ *
+ * @tparam Key the type of the searched values, comparable by ==
+ * @tparam Result the type of the result of a probe, e.g. a range or a flag
+ */
+template <typename Key, typename Result>
+class ProbeMemo {
+public:
+    /**
+     * Obtains the result of the given probe for the given key, probing the
+     * index only if the key differs from the one of the last probe.
+     */
+    template <typename Probe>
+    const Result& get(const Key& key, Probe probe) {
+        if (result == nullptr) {
+            result.reset(new Result(probe(key)));
+        } else if (!(key == last)) {
+            *result = probe(key);
+        } else {
+            hits++;
+            return *result;
+        }
+        last = key;
+        return *result;
+    }
+
+    /** Obtains the number of probes answered by the memo */
+    std::size_t getHits() const {
+        return hits;
+    }
+
+private:
+    Key last;
+    std::unique_ptr<Result> result;
+    std::size_t hits = 0;
+};
+
+}  // end of namespace souffle
@@ -1,15 +1,17 @@
 #pragma once
 
 #include "Util.h"
-#include "json11.h"
 #include <cassert>
 #include <chrono>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
@@ -150,6 +152,11 @@ public:
         return size;
     }
 
+    // set size
+    void setSize(size_t newSize) {
+        size = newSize;
+    }
+
     // accept visitor
     void accept(Visitor& v) override {
         v.visit(*this);
@@ -285,6 +292,240 @@ public:
     }
 };
 
+/**
+ * Streaming reader of a database printed as JSON
+ *
+ * The entries are written into their directories while the stream is read, so that
+ * neither the text of a profile nor a syntax tree of it is held in memory; for the
+ * profiles of long recursive runs, both are several times the size of the database.
+ */
+class JsonEntryReader {
+private:
+    std::streambuf& in;
+
+    // offset of the next character, for error messages
+    size_t offset{0};
+
+public:
+    JsonEntryReader(std::istream& is) : in(*is.rdbuf()) {}
+
+    // read the entries of the object under the key "root" into the given directory
+    void readRoot(DirectoryEntry& root) {
+        expect('{');
+        if (consume('}')) {
+            return;
+        }
+        do {
+            std::string key = readString();
+            expect(':');
+            if (key == "root" && consume('{')) {
+                readDirectory(root);
+            } else {
+                DirectoryEntry ignored(key);
+                readValue(ignored, key);
+            }
+        } while (consume(','));
+        expect('}');
+    }
+
+protected:
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::runtime_error("Parse error: " + message + " at offset " + std::to_string(offset));
+    }
+
+    // peek at the next character that is not white space
+    int peek() {
+        int c = in.sgetc();
+        while (c == ' ' || c == '\n' || c == '\t' || c == '\r') {
+            in.sbumpc();
+            offset++;
+            c = in.sgetc();
+        }
+        return c;
+    }
+
+    int get() {
+        int c = in.sbumpc();
+        if (c == std::char_traits<char>::eof()) {
+            fail("unexpected end of input");
+        }
+        offset++;
+        return c;
+    }
+
+    // skip the given character if it is next
+    bool consume(char c) {
+        if (peek() == c) {
+            get();
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            fail(std::string("expected '") + c + "'");
+        }
+    }
+
+    // read the entries of a directory up to its closing brace
+    void readDirectory(DirectoryEntry& dir) {
+        if (consume('}')) {
+            return;
+        }
+        do {
+            std::string key = readString();
+            expect(':');
+            readValue(dir, key);
+        } while (consume(','));
+        expect('}');
+    }
+
+    // read a value into an entry of the directory
+    void readValue(DirectoryEntry& dir, const std::string& key) {
+        int c = peek();
+        if (c == '{') {
+            get();
+            auto sub = std::make_unique<DirectoryEntry>(key);
+            readDirectory(*sub);
+
+            // duration and time entries are also maps
+            auto* start = dynamic_cast<SizeEntry*>(sub->readEntry("start"));
+            auto* end = dynamic_cast<SizeEntry*>(sub->readEntry("end"));
+            auto* time = dynamic_cast<SizeEntry*>(sub->readEntry("time"));
+            if (start != nullptr && end != nullptr) {
+                dir.writeEntry(std::make_unique<DurationEntry>(
+                        key, microseconds(start->getSize()), microseconds(end->getSize())));
+            } else if (time != nullptr) {
+                dir.writeEntry(std::make_unique<TimeEntry>(key, microseconds(time->getSize())));
+            } else {
+                dir.writeEntry(std::move(sub));
+            }
+        } else if (c == '"') {
+            dir.writeEntry(std::make_unique<TextEntry>(key, readString()));
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            dir.writeEntry(std::make_unique<SizeEntry>(key, readNumber()));
+        } else {
+            std::cerr << "Unknown types in profile log: " << key << std::endl;
+            skipValue();
+        }
+    }
+
+    std::string readString() {
+        expect('"');
+        std::string res;
+        for (int c = get(); c != '"'; c = get()) {
+            if (c != '\\') {
+                res += (char)c;
+                continue;
+            }
+            c = get();
+            switch (c) {
+                case 'b':
+                    res += '\b';
+                    break;
+                case 'f':
+                    res += '\f';
+                    break;
+                case 'n':
+                    res += '\n';
+                    break;
+                case 'r':
+                    res += '\r';
+                    break;
+                case 't':
+                    res += '\t';
+                    break;
+                case 'u':
+                    appendCodePoint(res, readCodePoint());
+                    break;
+                default:
+                    res += (char)c;
+            }
+        }
+        return res;
+    }
+
+    // read the code point of an escape sequence, combining surrogate pairs
+    uint32_t readCodePoint() {
+        uint32_t cp = readHex();
+        if (cp >= 0xD800 && cp < 0xDC00 && consume('\\')) {
+            if (get() != 'u') {
+                fail("expected a low surrogate");
+            }
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (readHex() - 0xDC00);
+        }
+        return cp;
+    }
+
+    uint32_t readHex() {
+        char digits[5] = {0};
+        for (size_t i = 0; i < 4; i++) {
+            digits[i] = (char)get();
+        }
+        char* end = nullptr;
+        uint32_t res = std::strtoul(digits, &end, 16);
+        if (end != digits + 4) {
+            fail("invalid escape sequence");
+        }
+        return res;
+    }
+
+    static void appendCodePoint(std::string& res, uint32_t cp) {
+        if (cp < 0x80) {
+            res += (char)cp;
+        } else if (cp < 0x800) {
+            res += (char)(0xC0 | (cp >> 6));
+            res += (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            res += (char)(0xE0 | (cp >> 12));
+            res += (char)(0x80 | ((cp >> 6) & 0x3F));
+            res += (char)(0x80 | (cp & 0x3F));
+        } else {
+            res += (char)(0xF0 | (cp >> 18));
+            res += (char)(0x80 | ((cp >> 12) & 0x3F));
+            res += (char)(0x80 | ((cp >> 6) & 0x3F));
+            res += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+
+    // read a number, truncating fractions as the entries hold integers
+    size_t readNumber() {
+        std::string text;
+        for (int c = peek(); (c >= '0' && c <= '9') || std::string("+-.eE").find(c) != std::string::npos;
+                c = in.sgetc()) {
+            text += (char)get();
+        }
+        if (text.find_first_of(".eE") != std::string::npos) {
+            return (size_t)(long long)std::strtod(text.c_str(), nullptr);
+        }
+        return (size_t)std::strtoll(text.c_str(), nullptr, 10);
+    }
+
+    // skip a value of a type without entries
+    void skipValue() {
+        int c = peek();
+        if (c == '[') {
+            get();
+            if (consume(']')) {
+                return;
+            }
+            DirectoryEntry ignored("");
+            do {
+                readValue(ignored, "");
+            } while (consume(','));
+            expect(']');
+        } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+            while ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+                get();
+                c = in.sgetc();
+            }
+        } else {
+            fail("unexpected character");
+        }
+    }
+};
+
 /**
  * Hierarchical databas
  */
@@ -311,36 +552,6 @@ protected:
         return dir;
     }
 
-    void parseJson(const json11::Json& json, std::unique_ptr<DirectoryEntry>& node) {
-        for (auto& cur : json.object_items()) {
-            if (cur.second.is_object()) {
-                std::string err;
-                // Duration entries are also maps
-                if (cur.second.has_shape(
-                            {{"start", json11::Json::NUMBER}, {"end", json11::Json::NUMBER}}, err)) {
-                    auto start = std::chrono::microseconds(cur.second["start"].long_value());
-                    auto end = std::chrono::microseconds(cur.second["end"].long_value());
-                    node->writeEntry(std::make_unique<DurationEntry>(cur.first, start, end));
-                } else if (cur.second.has_shape({{"time", json11::Json::NUMBER}}, err)) {
-                    auto time = std::chrono::microseconds(cur.second["time"].long_value());
-                    node->writeEntry(std::make_unique<TimeEntry>(cur.first, time));
-                } else {
-                    auto dir = std::make_unique<DirectoryEntry>(cur.first);
-                    parseJson(cur.second, dir);
-                    node->writeEntry(std::move(dir));
-                }
-            } else if (cur.second.is_string()) {
-                node->writeEntry(std::make_unique<TextEntry>(cur.first, cur.second.string_value()));
-            } else if (cur.second.is_number()) {
-                node->writeEntry(std::make_unique<SizeEntry>(cur.first, cur.second.long_value()));
-            } else {
-                std::string err;
-                cur.second.dump(err);
-                std::cerr << "Unknown types in profile log: " << cur.first << ": " << err << std::endl;
-            }
-        }
-    }
-
 public:
     ProfileDatabase() : root(std::make_unique<DirectoryEntry>("root")) {}
 
@@ -349,13 +560,15 @@ public:
         if (!file.is_open()) {
             throw std::runtime_error("Log file could not be opened.");
         }
-        std::string jsonString((std::istreambuf_iterator<char>(file)), (std::istreambuf_iterator<char>()));
-        std::string error;
-        json11::Json json = json11::Json::parse(jsonString, error);
-        if (!error.empty()) {
-            throw std::runtime_error("Parse error: " + error);
-        }
-        parseJson(json["root"], root);
+        JsonEntryReader(file).readRoot(*root);
+    }
+
+    // replace the contents by a database printed as JSON
+    void loadJson(const std::string& jsonString) {
+        std::istringstream in(jsonString);
+        auto newRoot = std::make_unique<DirectoryEntry>("root");
+        JsonEntryReader(in).readRoot(*newRoot);
+        root = std::move(newRoot);
     }
 
     // add size entry
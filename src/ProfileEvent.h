@@ -17,41 +17,77 @@
 #pragma once
 
 #include "EventProcessor.h"
+#include "HardwareCounters.h"
+#include "MetricsEndpoint.h"
+#include "Numa.h"
+#include "ParallelUtils.h"
 #include "ProfileDatabase.h"
+#include "ProfileEventLog.h"
+#include "ProfileStream.h"
+#include "RamTypes.h"
 #include "Util.h"
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <chrono>
 #include <ctime>
 #include <functional>
+#include <initializer_list>
 #include <iomanip>
 #include <iostream>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 #include <sys/resource.h>
+#include <sys/socket.h>
 #include <sys/time.h>
 
 namespace souffle {
 
 /**
  * Profile Event Singleton
+ *
+ * Events are recorded into a binary event log, which processes them into the
+ * profile database or writes them to a binary profile file in the background.
  */
 class ProfileEventSingleton {
     /** profile database */
     profile::ProfileDatabase database;
     std::string filename{""};
 
+    /** whether the profile is written as a binary event log */
+    bool binary{false};
+
+    /** whether hardware counters are recorded */
+    bool hardwareCounters{false};
+
+    /** log of the events */
+    profile::BinaryEventLog log{
+            [this](const std::vector<std::string>& labels, const profile::BinaryEvent& event) {
+                process(database, labels, event);
+            }};
+
+    /** the socket and thread receiving the events of an attached program */
+    int attachedSocket{-1};
+    std::thread receiver;
+
     ProfileEventSingleton() = default;
 
 public:
     ~ProfileEventSingleton() {
         stopTimer();
         ProfileEventSingleton::instance().dump();
+        if (receiver.joinable()) {
+            shutdown(attachedSocket, SHUT_RDWR);
+            receiver.join();
+        }
     }
 
     /** get instance */
@@ -62,7 +98,44 @@ public:
 
     /** create config record */
     void makeConfigRecord(const std::string& key, const std::string& value) {
-        profile::EventProcessorSingleton::instance().process(database, "@config", key.c_str(), value.c_str());
+        record(profile::BinaryEvent::CONFIG, "@config", {log.intern(key), log.intern(value)});
+        if (MetricsEndpoint::instance().isEnabled()) {
+            MetricsEndpoint::instance().observeConfig(key, value);
+        }
+    }
+
+    /**
+     * create config records of the loads served by the nodes of the machine and by
+     * remote nodes in NUMA mode, where the counters are available
+     */
+    void makeNumaRecords() {
+        uint64_t loads = 0;
+        uint64_t remoteLoads = 0;
+        if (!numa::isEnabled() || !numa::readNodeLoads(loads, remoteLoads)) {
+            return;
+        }
+        makeConfigRecord("numa-loads", std::to_string(loads));
+        makeConfigRecord("numa-remote-loads", std::to_string(remoteLoads));
+        std::stringstream ratio;
+        ratio << std::fixed << std::setprecision(4) << (loads > 0 ? double(remoteLoads) / loads : 0.0);
+        makeConfigRecord("numa-remote-ratio", ratio.str());
+    }
+
+    /**
+     * create config records of the lock events counted at each lock site, in builds
+     * with lock statistics
+     */
+    void makeLockRecords() {
+        for (LockSite site : {LockSite::OTHER, LockSite::BTREE, LockSite::SYMBOL_TABLE, LockSite::RECORDS}) {
+            if (getLockCount(site, LockEvent::ACQUISITION) == 0) {
+                continue;
+            }
+            for (LockEvent event : {LockEvent::ACQUISITION, LockEvent::CONTENTION, LockEvent::SPIN,
+                         LockEvent::PARK, LockEvent::RESTART}) {
+                makeConfigRecord(std::string("lock-") + getLockSiteName(site) + "-" + getLockEventName(event),
+                        std::to_string(getLockCount(site, event)));
+            }
+        }
     }
 
     /** create stratum record */
@@ -70,13 +143,13 @@ public:
             const std::string& key, const std::string& value) {
         std::stringstream ss;
         ss << "@text;stratum;" << index << ';' << type << ';' << relName << ';' << key;
-        profile::EventProcessorSingleton::instance().process(database, ss.str().c_str(), value.c_str());
+        record(profile::BinaryEvent::TEXT, ss.str(), {log.intern(value)});
     }
 
     /** create time event */
     void makeTimeEvent(const std::string& txt) {
-        profile::EventProcessorSingleton::instance().process(
-                database, txt.c_str(), std::chrono::duration_cast<microseconds>(now().time_since_epoch()));
+        microseconds time = std::chrono::duration_cast<microseconds>(now().time_since_epoch());
+        record(profile::BinaryEvent::TIME, txt, {uint64_t(time.count())});
     }
 
     /** create an event for recording start and end times */
@@ -84,13 +157,71 @@ public:
             size_t endMaxRSS, size_t size, size_t iteration) {
         microseconds start_ms = std::chrono::duration_cast<microseconds>(start.time_since_epoch());
         microseconds end_ms = std::chrono::duration_cast<microseconds>(end.time_since_epoch());
-        profile::EventProcessorSingleton::instance().process(
-                database, txt.c_str(), start_ms, end_ms, startMaxRSS, endMaxRSS, size, iteration);
+        record(profile::BinaryEvent::TIMING, txt, {uint64_t(start_ms.count()), uint64_t(end_ms.count()),
+                                                          startMaxRSS, endMaxRSS, size, iteration});
+        if (MetricsEndpoint::instance().isEnabled()) {
+            MetricsEndpoint::instance().observeTiming(txt, size, iteration);
+        }
+    }
+
+    /**
+     * create an event for the hardware counters of a timed scope, given the
+     * label of its timing event
+     */
+    void makeCountersEvent(const std::string& txt, const HardwareCounters::Sample& start,
+            const HardwareCounters::Sample& end, size_t iteration) {
+        uint64_t values[HardwareCounters::NUM_COUNTERS];
+        for (size_t i = 0; i < HardwareCounters::NUM_COUNTERS; i++) {
+            values[i] = end.values[i] - start.values[i];
+        }
+        uint64_t available = start.available & end.available;
+        record(profile::BinaryEvent::COUNTERS, "@h-" + txt.substr(3),
+                {values[0], values[1], values[2], values[3], iteration, available});
     }
 
     /** create quantity event */
     void makeQuantityEvent(const std::string& txt, size_t number, int iteration) {
-        profile::EventProcessorSingleton::instance().process(database, txt.c_str(), number, iteration);
+        record(profile::BinaryEvent::QUANTITY, txt, {number, uint64_t(iteration)});
+        if (MetricsEndpoint::instance().isEnabled()) {
+            MetricsEndpoint::instance().observeQuantity(txt, number, iteration);
+        }
+    }
+
+    /** create quantity events for the accesses of an index of a relation */
+    void makeIndexEvents(const std::string& relation, const std::string& index, size_t probes,
+            size_t emptyProbes, size_t scans, size_t tuples) {
+        const std::string prefix = "@index;" + relation + ";" + index + ";";
+        makeQuantityEvent(prefix + "probes", probes, 0);
+        makeQuantityEvent(prefix + "empty-probes", emptyProbes, 0);
+        makeQuantityEvent(prefix + "scans", scans, 0);
+        makeQuantityEvent(prefix + "tuples", tuples, 0);
+    }
+
+    /** create memory events for the indexes of a relation at the end of a stratum */
+    void makeRelationMemoryEvents(size_t stratum, const std::string& relation,
+            const std::vector<std::pair<std::string, size_t>>& usage) {
+        for (const auto& index : usage) {
+            makeMemoryEvent(stratum, "relation;" + relation + ";" + index.first, index.second);
+        }
+    }
+
+    /** create memory event for a component of the program, e.g. the symbol table, at the end of a stratum */
+    void makeMemoryEvent(size_t stratum, const std::string& component, size_t bytes) {
+        makeQuantityEvent("@memory;" + component, bytes, stratum);
+    }
+
+    /** create quantity events for the number of distinct values of each column of a relation */
+    template <typename Relation>
+    void makeDistinctValuesEvents(const std::vector<std::string>& txts, const Relation& rel, int iteration) {
+        std::vector<std::unordered_set<RamDomain>> values(txts.size());
+        for (const auto& tuple : rel) {
+            for (size_t i = 0; i < txts.size(); ++i) {
+                values[i].insert(tuple[i]);
+            }
+        }
+        for (size_t i = 0; i < txts.size(); ++i) {
+            makeQuantityEvent(txts[i], values[i].size(), iteration);
+        }
     }
 
     /** create utilisation event */
@@ -107,16 +238,82 @@ public:
         /* Maximum resident set size (kb) */
         size_t maxRSS = ru.ru_maxrss;
 
-        profile::EventProcessorSingleton::instance().process(
-                database, txt.c_str(), time, systemTime, userTime, maxRSS);
+        record(profile::BinaryEvent::UTILISATION, txt,
+                {uint64_t(time.count()), systemTime, userTime, maxRSS});
     }
 
-    void setOutputFile(std::string filename) {
+    /** Set the profile file, written as a binary event log or as JSON at the end */
+    void setOutputFile(std::string filename, bool binary = false) {
         this->filename = filename;
+        this->binary = binary;
+        if (binary) {
+            log.open(filename);
+        }
+    }
+    /** Record the hardware counters of timed rules and relations */
+    void setHardwareCounters(bool enable) {
+        hardwareCounters = enable;
     }
+
+    /** Check whether the hardware counters of the timing event with the given label are recorded */
+    bool hasHardwareCounters(const std::string& txt) const {
+        return hardwareCounters && txt.compare(0, 3, "@t-") == 0 &&
+               profile::EventProcessorSingleton::instance().hasEventProcessor(
+                       "@h-" + txt.substr(3, txt.find(';') - 3));
+    }
+
+    /** Stream the events to profilers attaching to the given address */
+    void listen(const std::string& address) {
+        try {
+            log.listen(address, [this]() {
+                std::stringstream ss;
+                database.print(ss);
+                return ss.str();
+            });
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    /** Serve the metrics of the program to monitoring systems at the given address */
+    void serveMetrics(const std::string& address) {
+        try {
+            MetricsEndpoint::instance().listen(address);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    /**
+     * Attach to the profile stream of a running program at the given address.
+     * The database is set to the snapshot of the program, and is updated by
+     * the events of the program in the background.
+     */
+    void attach(const std::string& address) {
+        attachedSocket = profile::openProfileSocket(address, false);
+        auto buffer = std::make_shared<profile::ProfileSocketBuffer>(attachedSocket);
+        auto in = std::make_shared<std::istream>(buffer.get());
+        auto labels = std::make_shared<std::vector<std::string>>();
+        std::string snapshot;
+        if (!profile::BinaryEventLog::readHeader(*in) ||
+                !profile::BinaryEventLog::readRecord(*in, *labels, nullptr, &snapshot)) {
+            throw std::runtime_error("Not a profile stream: " + address);
+        }
+        database.loadJson(snapshot);
+        receiver = std::thread([this, buffer, in, labels]() {
+            auto consumer = [this](const std::vector<std::string>& eventLabels,
+                                    const profile::BinaryEvent& event) {
+                process(database, eventLabels, event);
+            };
+            while (profile::BinaryEventLog::readRecord(*in, *labels, consumer, nullptr)) {
+            }
+        });
+    }
+
     /** Dump all events */
     void dump() {
-        if (!filename.empty()) {
+        log.stop();
+        if (!filename.empty() && !binary) {
             std::ofstream os(filename);
             if (!os.is_open()) {
                 std::cerr << "Cannot open profile log file <" + filename + ">";
@@ -144,10 +341,61 @@ public:
     }
 
     void setDBFromFile(const std::string& filename) {
-        database = profile::ProfileDatabase(filename);
+        if (profile::BinaryEventLog::isBinaryLog(filename)) {
+            database = profile::ProfileDatabase();
+            profile::BinaryEventLog::read(filename,
+                    [this](const std::vector<std::string>& labels, const profile::BinaryEvent& event) {
+                        process(database, labels, event);
+                    });
+        } else {
+            database = profile::ProfileDatabase(filename);
+        }
     }
 
 private:
+    /** Record an event of the given kind */
+    void record(
+            profile::BinaryEvent::Kind kind, const std::string& txt, std::initializer_list<uint64_t> values) {
+        profile::BinaryEvent event{};
+        event.kind = kind;
+        event.label = log.intern(txt);
+        std::copy(values.begin(), values.end(), event.values);
+        log.record(event);
+    }
+
+    /** Process an event into the database */
+    static void process(profile::ProfileDatabase& db, const std::vector<std::string>& labels,
+            const profile::BinaryEvent& event) {
+        auto& processor = profile::EventProcessorSingleton::instance();
+        const char* txt = labels[event.label].c_str();
+        const uint64_t* values = event.values;
+        switch (event.kind) {
+            case profile::BinaryEvent::TIME:
+                processor.process(db, txt, microseconds(values[0]));
+                break;
+            case profile::BinaryEvent::TIMING:
+                processor.process(db, txt, microseconds(values[0]), microseconds(values[1]),
+                        size_t(values[2]), size_t(values[3]), size_t(values[4]), size_t(values[5]));
+                break;
+            case profile::BinaryEvent::QUANTITY:
+                processor.process(db, txt, size_t(values[0]), size_t(values[1]));
+                break;
+            case profile::BinaryEvent::UTILISATION:
+                processor.process(db, txt, microseconds(values[0]), values[1], values[2], size_t(values[3]));
+                break;
+            case profile::BinaryEvent::CONFIG:
+                processor.process(db, txt, labels[values[0]].c_str(), labels[values[1]].c_str());
+                break;
+            case profile::BinaryEvent::TEXT:
+                processor.process(db, txt, labels[values[0]].c_str());
+                break;
+            case profile::BinaryEvent::COUNTERS:
+                processor.process(db, txt, size_t(values[0]), size_t(values[1]), size_t(values[2]),
+                        size_t(values[3]), size_t(values[4]), size_t(values[5]));
+                break;
+        }
+    }
+
     /**  Profile Timer */
     class ProfileTimer {
     private:
@@ -0,0 +1,398 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ProfileEventLog.h
+ *
+ * Declares the binary log collecting profile events of all threads
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ProfileStream.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+namespace profile {
+
+/**
+ * A profile event of fixed size, referring to its label by an interned id.
+ */
+struct BinaryEvent {
+    /** the kinds of events, determining the meaning of the values */
+    enum Kind : uint32_t { TIME, TIMING, QUANTITY, UTILISATION, CONFIG, TEXT, COUNTERS };
+
+    uint32_t kind;
+    uint32_t label;
+    uint64_t values[6];
+};
+
+/**
+ * A ring buffer of events with a single producer and a single consumer.
+ */
+class EventRing {
+public:
+    /** Append an event, failing if the ring is full */
+    bool push(const BinaryEvent& event) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == capacity) {
+            return false;
+        }
+        events[h % capacity] = event;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Whether the ring is filled by more than a half */
+    bool isFilling() const {
+        return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed) > capacity / 2;
+    }
+
+    /** Remove all events, appending them to the given list */
+    void drain(std::vector<BinaryEvent>& out) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        for (; t < h; ++t) {
+            out.push_back(events[t % capacity]);
+        }
+        tail.store(t, std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t capacity = 4096;
+
+    BinaryEvent events[capacity];
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+};
+
+/**
+ * The log of profile events.
+ *
+ * Each thread records its events into a ring buffer of its own, without
+ * locking. Labels are interned once per thread. A background thread drains
+ * the rings periodically and either writes the events to a binary file or
+ * hands them to a consumer. The events may also be streamed to attached
+ * profilers.
+ *
+ * A binary file starts with a magic number, followed by records tagged by a
+ * byte: 'L' defines a label by its 32-bit id, its 32-bit length and its
+ * characters, and 'E' holds an event as laid out in BinaryEvent. Labels are
+ * defined before their first use. Numbers are stored in native byte order.
+ * A stream has the same format, except that it starts with an 'S' record
+ * holding a snapshot of the profile database as JSON with a 64-bit length.
+ */
+class BinaryEventLog {
+public:
+    /** consumer of events, given the labels defined so far */
+    using Consumer = std::function<void(const std::vector<std::string>&, const BinaryEvent&)>;
+
+    BinaryEventLog(Consumer consumer) : consumer(std::move(consumer)) {}
+
+    ~BinaryEventLog() {
+        stop();
+    }
+
+    /** Write the events to the given binary file instead of handing them to the consumer */
+    void open(const std::string& filename) {
+        std::lock_guard<std::mutex> guard(flushLock);
+        file.open(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Cannot open profile log file <" + filename + ">";
+            return;
+        }
+        file.write(getMagic(), magicSize);
+        writtenLabels = 0;
+    }
+
+    /**
+     * Stream the events to profilers attaching to the given address. The
+     * events are handed to the consumer as well, whose state is described by
+     * the snapshot sent to each attaching profiler.
+     */
+    void listen(const std::string& address, std::function<std::string()> snapshot) {
+        std::lock_guard<std::mutex> guard(flushLock);
+        server = std::unique_ptr<ProfileStreamServer>(new ProfileStreamServer(address, [this, snapshot]() {
+            std::string greeting(getMagic(), magicSize);
+            std::string json = snapshot();
+            uint64_t length = json.size();
+            greeting += 'S';
+            greeting.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            greeting += json;
+            for (size_t id = 0; id < flushedLabels.size(); id++) {
+                encodeLabel(greeting, id, flushedLabels[id]);
+            }
+            return greeting;
+        }));
+    }
+
+    /** Obtain the id of a label */
+    uint32_t intern(const std::string& label) {
+        thread_local std::pair<size_t, std::unordered_map<std::string, uint32_t>> threadCache;
+        if (threadCache.first != serial) {
+            threadCache = std::make_pair(serial, std::unordered_map<std::string, uint32_t>());
+        }
+        auto& cache = threadCache.second;
+        auto pos = cache.find(label);
+        if (pos != cache.end()) {
+            return pos->second;
+        }
+        std::lock_guard<std::mutex> guard(labelLock);
+        auto res = labelIds.insert(std::make_pair(label, labels.size()));
+        if (res.second) {
+            labels.push_back(label);
+        }
+        cache[label] = res.first->second;
+        return res.first->second;
+    }
+
+    /** Record an event */
+    void record(const BinaryEvent& event) {
+        EventRing& ring = getRing();
+        while (!ring.push(event)) {
+            flushCondition.notify_one();
+            std::this_thread::yield();
+        }
+        if (ring.isFilling()) {
+            flushCondition.notify_one();
+        }
+    }
+
+    /** Process all events recorded so far and stop the background thread */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> guard(flushLock);
+            stopped = true;
+        }
+        flushCondition.notify_one();
+        if (flusher.joinable()) {
+            flusher.join();
+        }
+        std::lock_guard<std::mutex> guard(flushLock);
+        flush();
+        if (file.is_open()) {
+            file.close();
+        }
+        server.reset();
+    }
+
+    /** Check whether a file is a binary event log */
+    static bool isBinaryLog(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        char header[magicSize];
+        return in.read(header, magicSize) && std::memcmp(header, getMagic(), magicSize) == 0;
+    }
+
+    /**
+     * Hand the events of a binary file to a consumer. A truncated last record,
+     * as left by a program still running, is ignored.
+     */
+    static void read(const std::string& filename, const Consumer& consumer) {
+        std::ifstream in(filename, std::ios::binary);
+        if (!readHeader(in)) {
+            throw std::runtime_error("Log file is not a binary profile.");
+        }
+        std::vector<std::string> labels;
+        while (readRecord(in, labels, consumer, nullptr)) {
+        }
+    }
+
+    /** Read the magic number starting a binary file or stream */
+    static bool readHeader(std::istream& in) {
+        char header[magicSize];
+        return in.read(header, magicSize) && std::memcmp(header, getMagic(), magicSize) == 0;
+    }
+
+    /**
+     * Read a record of a binary file or stream, handing an event to the
+     * consumer and storing a snapshot in the given string.
+     *
+     * @return false at the end of the input or of a truncated record
+     */
+    static bool readRecord(std::istream& in, std::vector<std::string>& labels, const Consumer& consumer,
+            std::string* snapshot) {
+        char tag;
+        if (!in.get(tag)) {
+            return false;
+        }
+        if (tag == 'L') {
+            uint32_t id;
+            uint32_t length;
+            if (!in.read(reinterpret_cast<char*>(&id), sizeof(id)) ||
+                    !in.read(reinterpret_cast<char*>(&length), sizeof(length))) {
+                return false;
+            }
+            std::string label(length, '\0');
+            if (length > 0 && !in.read(&label[0], length)) {
+                return false;
+            }
+            if (labels.size() <= id) {
+                labels.resize(id + 1);
+            }
+            labels[id] = label;
+        } else if (tag == 'E') {
+            BinaryEvent event;
+            if (!in.read(reinterpret_cast<char*>(&event), sizeof(event))) {
+                return false;
+            }
+            consumer(labels, event);
+        } else if (tag == 'S' && snapshot != nullptr) {
+            uint64_t length;
+            if (!in.read(reinterpret_cast<char*>(&length), sizeof(length))) {
+                return false;
+            }
+            snapshot->assign(length, '\0');
+            if (length > 0 && !in.read(&(*snapshot)[0], length)) {
+                return false;
+            }
+        } else {
+            throw std::runtime_error("Corrupt binary profile.");
+        }
+        return true;
+    }
+
+private:
+    /** the magic number starting a binary file */
+    static const char* getMagic() {
+        return "SFPROF01";
+    }
+    static constexpr size_t magicSize = 8;
+
+    /** Obtain the ring of the current thread, starting the background thread with the first ring */
+    EventRing& getRing() {
+        thread_local std::pair<size_t, EventRing*> threadRing(0, nullptr);
+        EventRing*& ring = threadRing.second;
+        if (threadRing.first != serial) {
+            threadRing.first = serial;
+            {
+                std::lock_guard<std::mutex> guard(ringLock);
+                rings.push_back(std::unique_ptr<EventRing>(new EventRing()));
+                ring = rings.back().get();
+            }
+            std::lock_guard<std::mutex> guard(flushLock);
+            if (!flusher.joinable() && !stopped) {
+                flusher = std::thread([this]() { run(); });
+            }
+        }
+        return *ring;
+    }
+
+    /** The loop of the background thread */
+    void run() {
+        std::unique_lock<std::mutex> lock(flushLock);
+        while (!stopped) {
+            flushCondition.wait_for(lock, std::chrono::milliseconds(10));
+            flush();
+        }
+    }
+
+    /** Process the events of all rings; requires flushLock */
+    void flush() {
+        std::vector<BinaryEvent> events;
+        {
+            std::lock_guard<std::mutex> guard(ringLock);
+            for (auto& ring : rings) {
+                ring->drain(events);
+            }
+        }
+
+        // the labels of drained events have been interned before
+        std::vector<std::string> newLabels;
+        {
+            std::lock_guard<std::mutex> guard(labelLock);
+            newLabels.assign(labels.begin() + flushedLabels.size(), labels.end());
+        }
+        flushedLabels.insert(flushedLabels.end(), newLabels.begin(), newLabels.end());
+
+        if (!file.is_open() || server) {
+            for (const BinaryEvent& event : events) {
+                consumer(flushedLabels, event);
+            }
+        }
+        if (!file.is_open() && !server) {
+            return;
+        }
+
+        std::string records;
+        for (; writtenLabels < flushedLabels.size(); writtenLabels++) {
+            encodeLabel(records, writtenLabels, flushedLabels[writtenLabels]);
+        }
+        for (const BinaryEvent& event : events) {
+            records += 'E';
+            records.append(reinterpret_cast<const char*>(&event), sizeof(event));
+        }
+        if (file.is_open()) {
+            file.write(records.data(), records.size());
+            file.flush();
+        }
+        if (server) {
+            server->publish(records);
+        }
+    }
+
+    /** Append the record defining a label */
+    static void encodeLabel(std::string& out, uint32_t id, const std::string& label) {
+        uint32_t length = label.size();
+        out += 'L';
+        out.append(reinterpret_cast<const char*>(&id), sizeof(id));
+        out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        out += label;
+    }
+
+    /** Obtain a number identifying a new log, distinguishing it in the state of each thread */
+    static size_t nextSerial() {
+        static std::atomic<size_t> counter{0};
+        return ++counter;
+    }
+
+    /** the number of this log */
+    const size_t serial = nextSerial();
+
+    /** consumer of events not written to a file */
+    Consumer consumer;
+
+    /** interned labels, guarded by labelLock */
+    std::unordered_map<std::string, uint32_t> labelIds;
+    std::vector<std::string> labels;
+    std::mutex labelLock;
+
+    /** rings of all threads, guarded by ringLock */
+    std::vector<std::unique_ptr<EventRing>> rings;
+    std::mutex ringLock;
+
+    /** state of the background thread, guarded by flushLock */
+    std::vector<std::string> flushedLabels;
+    size_t writtenLabels = 0;
+    std::ofstream file;
+    std::unique_ptr<ProfileStreamServer> server;
+    bool stopped = false;
+    std::thread flusher;
+    std::mutex flushLock;
+    std::condition_variable flushCondition;
+};
+
+}  // namespace profile
+}  // namespace souffle
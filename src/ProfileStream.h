@@ -0,0 +1,217 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ProfileStream.h
+ *
+ * Declares the sockets streaming profile events to attached profilers
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace souffle {
+namespace profile {
+
+/**
+ * Open a socket for the given address, either listening on it or connected
+ * to it. An address of the form unix:PATH denotes a Unix domain socket, and
+ * any other address denotes a TCP socket as [HOST:]PORT. A server without a
+ * host listens on all interfaces, and a client without a host connects to
+ * the local machine.
+ *
+ * @return the socket
+ */
+inline int openProfileSocket(const std::string& address, bool server) {
+    int fd = -1;
+    if (address.compare(0, 5, "unix:") == 0) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::string path = address.substr(5);
+        if (path.size() >= sizeof(addr.sun_path)) {
+            throw std::runtime_error("Socket path too long: " + path);
+        }
+        std::strcpy(addr.sun_path, path.c_str());
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && server) {
+            unlink(path.c_str());
+            if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+                close(fd);
+                fd = -1;
+            }
+        } else if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    } else {
+        size_t colon = address.rfind(':');
+        std::string host = (colon == std::string::npos) ? "" : address.substr(0, colon);
+        std::string port = (colon == std::string::npos) ? address : address.substr(colon + 1);
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = server ? AI_PASSIVE : 0;
+        addrinfo* infos = nullptr;
+        if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &infos) != 0) {
+            throw std::runtime_error("Cannot resolve profile address " + address);
+        }
+        for (addrinfo* info = infos; info != nullptr && fd < 0; info = info->ai_next) {
+            fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+            if (fd < 0) {
+                continue;
+            }
+            bool ok;
+            if (server) {
+                int reuse = 1;
+                setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+                ok = bind(fd, info->ai_addr, info->ai_addrlen) == 0 && listen(fd, 4) == 0;
+            } else {
+                ok = connect(fd, info->ai_addr, info->ai_addrlen) == 0;
+            }
+            if (!ok) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(infos);
+    }
+    if (fd < 0) {
+        throw std::runtime_error("Cannot " + std::string(server ? "listen on" : "connect to") +
+                                 " profile address " + address + ": " + std::strerror(errno));
+    }
+    return fd;
+}
+
+/** Send data over a socket, returning false if the peer has gone */
+inline bool sendProfileData(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+/**
+ * The endpoint of a running program streaming its profile to any number of
+ * attached profilers.
+ *
+ * Each profiler attaching receives a greeting describing the state of the
+ * profile so far, followed by all data published afterwards. Profilers are
+ * accepted when data is published, so that no data is missed or duplicated.
+ */
+class ProfileStreamServer {
+public:
+    /** producer of the greeting of a newly attached profiler */
+    using Greeting = std::function<std::string()>;
+
+    ProfileStreamServer(const std::string& address, Greeting greeting)
+            : address(address), listener(openProfileSocket(address, true)), greeting(std::move(greeting)) {
+        fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+    }
+
+    ~ProfileStreamServer() {
+        for (int fd : clients) {
+            close(fd);
+        }
+        close(listener);
+        if (address.compare(0, 5, "unix:") == 0) {
+            unlink(address.substr(5).c_str());
+        }
+    }
+
+    /**
+     * Send data to the attached profilers, then greet the profilers attached
+     * since, whose greeting has to cover the data.
+     */
+    void publish(const std::string& data) {
+        std::vector<int> remaining;
+        for (int fd : clients) {
+            if (data.empty() || sendProfileData(fd, data)) {
+                remaining.push_back(fd);
+            } else {
+                close(fd);
+            }
+        }
+        int fd;
+        while ((fd = accept(listener, nullptr, nullptr)) >= 0) {
+            if (sendProfileData(fd, greeting())) {
+                remaining.push_back(fd);
+            } else {
+                close(fd);
+            }
+        }
+        clients.swap(remaining);
+    }
+
+private:
+    /** the address listened on */
+    std::string address;
+
+    /** the listening socket */
+    int listener;
+
+    /** producer of greetings */
+    Greeting greeting;
+
+    /** sockets of the attached profilers */
+    std::vector<int> clients;
+};
+
+/**
+ * A stream buffer reading from a socket, for parsing the profile stream of
+ * a running program with an std::istream.
+ */
+class ProfileSocketBuffer : public std::streambuf {
+public:
+    ProfileSocketBuffer(int fd) : fd(fd) {}
+
+    ~ProfileSocketBuffer() override {
+        close(fd);
+    }
+
+protected:
+    int_type underflow() override {
+        ssize_t n;
+        do {
+            n = recv(fd, buffer, sizeof(buffer), 0);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) {
+            return traits_type::eof();
+        }
+        setg(buffer, buffer, buffer + n);
+        return traits_type::to_int_type(buffer[0]);
+    }
+
+private:
+    int fd;
+    char buffer[1 << 16];
+};
+
+}  // namespace profile
+}  // namespace souffle
@@ -25,15 +25,19 @@
 #include "AstTransforms.h"
 #include "AstTranslationUnit.h"
 #include "AstType.h"
+#include "AstUtils.h"
 #include "AstVisitor.h"
 #include "BinaryConstraintOps.h"
+#include "ErrorReport.h"
 #include "FunctorOps.h"
+#include "Global.h"
 #include "RelationRepresentation.h"
 #include "Util.h"
 #include <cassert>
 #include <cstddef>
 #include <iosfwd>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -279,7 +283,52 @@ bool ProvenanceTransformer::transform(AstTranslationUnit& translationUnit) {
                 std::unique_ptr<AstArgument>(currentMax), std::make_unique<AstNumberConstant>(1)));
     };
 
+    // lazy provenance only records the clauses, the proofs are searched when tuples are explained
+    const bool lazy = Global::config().has("provenance-lazy");
+
+    // the relations provenance is recorded for, closed under the relations they are derived from
+    std::set<const AstRelation*> annotated;
+    if (Global::config().has("provenance-relations")) {
+        std::vector<const AstRelation*> pending;
+        for (const auto& name : splitString(Global::config().get("provenance-relations"), ',')) {
+            const AstRelation* selected = nullptr;
+            for (auto relation : program->getRelations()) {
+                if (identifierToString(relation->getName()) == name) {
+                    selected = relation;
+                }
+            }
+            if (selected == nullptr) {
+                translationUnit.getErrorReport().addError(
+                        "Unknown relation " + name + " for provenance", SrcLocation());
+                continue;
+            }
+            pending.push_back(selected);
+        }
+        while (!pending.empty()) {
+            const AstRelation* cur = pending.back();
+            pending.pop_back();
+            if (!annotated.insert(cur).second) {
+                continue;
+            }
+            for (auto clause : cur->getClauses()) {
+                visitDepthFirst(*clause, [&](const AstAtom& atom) {
+                    if (const AstRelation* rel = getAtomRelation(&atom, program)) {
+                        pending.push_back(rel);
+                    }
+                });
+            }
+        }
+    } else {
+        for (auto relation : program->getRelations()) {
+            annotated.insert(relation);
+        }
+    }
+
     for (auto relation : program->getRelations()) {
+        if (annotated.count(relation) == 0) {
+            continue;
+        }
+
         if (relation->getRepresentation() == RelationRepresentation::EQREL) {
             transformEqrelRelation(*relation);
         }
@@ -287,9 +336,10 @@ bool ProvenanceTransformer::transform(AstTranslationUnit& translationUnit) {
         // generate info relations for each clause
         // do this before all other transformations so that we record
         // the original rule without any instrumentation
+        // lazy provenance numbers the facts as well, since it cannot tell them apart by a level of 0
         size_t clauseNum = 1;
         for (auto clause : relation->getClauses()) {
-            if (!clause->isFact()) {
+            if (!clause->isFact() || lazy) {
                 clause->setClauseNum(clauseNum);
 
                 // add info relation
@@ -299,38 +349,72 @@ bool ProvenanceTransformer::transform(AstTranslationUnit& translationUnit) {
             }
         }
 
+        // lazy provenance evaluates the relations without annotations
+        if (lazy) {
+            continue;
+        }
+
         relation->addAttribute(
                 std::make_unique<AstAttribute>(std::string("@rule_number"), AstTypeIdentifier("number")));
         relation->addAttribute(
                 std::make_unique<AstAttribute>(std::string("@level_number"), AstTypeIdentifier("number")));
+    }
 
-        for (auto clause : relation->getClauses()) {
-            // mapper to add two provenance columns to atoms
-            struct M : public AstNodeMapper {
-                using AstNodeMapper::operator();
+    if (lazy) {
+        return true;
+    }
 
-                std::unique_ptr<AstNode> operator()(std::unique_ptr<AstNode> node) const override {
-                    // add provenance columns
-                    if (auto atom = dynamic_cast<AstAtom*>(node.get())) {
-                        atom->addArgument(std::make_unique<AstUnnamedVariable>());
-                        atom->addArgument(std::make_unique<AstUnnamedVariable>());
-                    } else if (auto neg = dynamic_cast<AstNegation*>(node.get())) {
-                        auto atom = neg->getAtom();
-                        atom->addArgument(std::make_unique<AstUnnamedVariable>());
-                        atom->addArgument(std::make_unique<AstUnnamedVariable>());
-                    }
+    // mapper to add two provenance columns to the atoms of annotated relations
+    struct M : public AstNodeMapper {
+        const AstProgram* program;
 
-                    // otherwise - apply mapper recursively
-                    node->apply(*this);
-                    return node;
-                }
-            };
+        M(const AstProgram* program) : program(program) {}
+
+        using AstNodeMapper::operator();
+
+        std::unique_ptr<AstNode> operator()(std::unique_ptr<AstNode> node) const override {
+            // add provenance columns
+            if (auto atom = dynamic_cast<AstAtom*>(node.get())) {
+                addColumns(atom);
+            } else if (auto neg = dynamic_cast<AstNegation*>(node.get())) {
+                addColumns(neg->getAtom());
+            }
 
+            // otherwise - apply mapper recursively
+            node->apply(*this);
+            return node;
+        }
+
+        void addColumns(AstAtom* atom) const {
+            const AstRelation* rel = getAtomRelation(atom, program);
+            if (rel != nullptr && rel->hasProvenanceColumns()) {
+                atom->addArgument(std::make_unique<AstUnnamedVariable>());
+                atom->addArgument(std::make_unique<AstUnnamedVariable>());
+            }
+        }
+    };
+
+    for (auto relation : program->getRelations()) {
+        // the info relations only record the clauses
+        if (identifierToString(relation->getName()).find("@info") != std::string::npos) {
+            continue;
+        }
+
+        for (auto clause : relation->getClauses()) {
             // add unnamed vars to each atom nested in arguments of head
-            clause->getHead()->apply(M());
+            clause->getHead()->apply(M(program));
+
+            // without provenance for the relation, only the atoms of annotated relations are extended
+            if (!relation->hasProvenanceColumns()) {
+                for (auto lit : clause->getBodyLiterals()) {
+                    lit->apply(M(program));
+                    if (auto atom = dynamic_cast<AstAtom*>(lit)) {
+                        M(program).addColumns(atom);
+                    }
+                }
 
-            // if fact, level number is 0
-            if (clause->isFact()) {
+                // if fact, level number is 0
+            } else if (clause->isFact()) {
                 clause->getHead()->addArgument(std::make_unique<AstNumberConstant>(0));
                 clause->getHead()->addArgument(std::make_unique<AstNumberConstant>(0));
             } else {
@@ -340,7 +424,7 @@ bool ProvenanceTransformer::transform(AstTranslationUnit& translationUnit) {
                     auto lit = clause->getBodyLiterals()[i];
 
                     // add unnamed vars to each atom nested in arguments of lit
-                    lit->apply(M());
+                    lit->apply(M(program));
 
                     // add two provenance columns to lit; first is rule num, second is level num
                     if (auto atom = dynamic_cast<AstAtom*>(lit)) {
@@ -0,0 +1,278 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file QueryServer.h
+ *
+ * A server answering queries over a socket against the relations of a
+ * program that stays resident between them.
+ *
+ * The input relations are loaded and all strata are evaluated once. Each
+ * query then inserts its parameters as seed tuples into input relations,
+ * updates the relations incrementally -- such that only the strata
+ * depending on the seeds are evaluated, restricted to the bindings of the
+ * seeds where the rules join with them, as after the magic-set
+ * transformation -- answers the tuples of a relation agreeing with a
+ * pattern and retracts the seeds again.
+ *
+ * The protocol is line based; fields are separated by tabs:
+ *
+ *     seed <relation> <value>...      adds a seed tuple to the next query
+ *     query <relation> <value|_>...   answers the tuples agreeing with the
+ *                                     given values, one per line, followed
+ *                                     by "ok <number of tuples>"
+ *     shutdown                        stops the server
+ *
+ * Errors are answered by "error <message>". Connections are served
+ * concurrently, while their queries are evaluated one at a time.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "SouffleInterface.h"
+#include "SymbolTable.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace souffle {
+
+class QueryServer {
+public:
+    /** The seed tuples collected by a connection for its next query */
+    struct Session {
+        std::vector<std::pair<Relation*, std::vector<RamDomain>>> seeds;
+    };
+
+    /**
+     * Creates a server for a program whose relations have been evaluated by run(); the program has
+     * to be generated with --incremental for the seeds to be retracted after each query.
+     */
+    explicit QueryServer(SouffleProgram& prog) : prog(prog) {}
+
+    /**
+     * Accepts connections on the given TCP port, serving each of them by a thread of its own,
+     * until a client requests a shutdown.
+     */
+    void serve(int port) {
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener < 0) {
+            throw std::runtime_error("cannot create socket: " + std::string(strerror(errno)));
+        }
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+                listen(listener, SOMAXCONN) < 0) {
+            close(listener);
+            throw std::runtime_error(
+                    "cannot listen on port " + std::to_string(port) + ": " + std::string(strerror(errno)));
+        }
+
+        std::vector<std::thread> connections;
+        while (!stopped.load()) {
+            int connection = accept(listener, nullptr, nullptr);
+            if (connection < 0) {
+                // the listener is shut down by a shutdown request
+                continue;
+            }
+            connections.emplace_back([this, connection, listener]() {
+                if (communicate(connection)) {
+                    stopped.store(true);
+                    shutdown(listener, SHUT_RDWR);
+                }
+                close(connection);
+            });
+        }
+        for (auto& cur : connections) {
+            cur.join();
+        }
+        close(listener);
+    }
+
+    /**
+     * Answers a request of a connection.
+     *
+     * @param session the seeds of the connection
+     * @param request the line of the request, without its line break
+     * @param out the stream the answer is written to
+     * @return true if the server is to be shut down
+     */
+    bool respond(Session& session, const std::string& request, std::ostream& out) {
+        std::vector<std::string> fields = split(request);
+        if (fields.empty() || fields[0].empty()) {
+            return false;
+        }
+        try {
+            if (fields[0] == "shutdown") {
+                out << "ok 0\n";
+                return true;
+            }
+            if (fields.size() < 2) {
+                throw std::invalid_argument("missing relation");
+            }
+            Relation* rel = prog.getRelation(fields[1]);
+            if (rel == nullptr) {
+                throw std::invalid_argument("unknown relation " + fields[1]);
+            }
+            if (fields[0] == "seed") {
+                if (fields.size() != rel->getArity() + 2) {
+                    throw std::invalid_argument("seed of wrong arity for " + fields[1]);
+                }
+                std::vector<RamDomain> values(rel->getArity());
+                for (size_t i = 0; i < rel->getArity(); ++i) {
+                    values[i] = encode(*rel, i, fields[i + 2]);
+                }
+                session.seeds.emplace_back(rel, std::move(values));
+                out << "ok 0\n";
+            } else if (fields[0] == "query") {
+                if (fields.size() > rel->getArity() + 2) {
+                    throw std::invalid_argument("pattern of wrong arity for " + fields[1]);
+                }
+                std::vector<RamDomain> pattern(rel->getArity(), 0);
+                uint64_t columns = 0;
+                for (size_t i = 0; i + 2 < fields.size(); ++i) {
+                    if (fields[i + 2] != "_") {
+                        pattern[i] = encode(*rel, i, fields[i + 2]);
+                        columns |= uint64_t(1) << i;
+                    }
+                }
+                query(session, *rel, pattern, columns, out);
+            } else {
+                throw std::invalid_argument("unknown request " + fields[0]);
+            }
+        } catch (std::exception& e) {
+            session.seeds.clear();
+            out << "error " << e.what() << "\n";
+        }
+        return false;
+    }
+
+private:
+    /** Evaluates the seeds of a session and answers the tuples agreeing with a pattern */
+    void query(Session& session, const Relation& rel, const std::vector<RamDomain>& pattern, uint64_t columns,
+            std::ostream& out) {
+        std::lock_guard<std::mutex> guard(evaluation);
+        std::vector<std::pair<Relation*, tuple>> seeds;
+        for (auto& cur : session.seeds) {
+            tuple t(cur.first);
+            std::copy(cur.second.begin(), cur.second.end(), t.begin());
+            // seeds present before are kept after the query
+            if (!cur.first->contains(t)) {
+                cur.first->insert(t);
+                seeds.emplace_back(cur.first, t);
+            }
+        }
+        session.seeds.clear();
+        if (!seeds.empty()) {
+            prog.runIncremental();
+        }
+
+        size_t count = 0;
+        rel.equalRange(pattern.data(), columns, [&](const RamDomain* rows, size_t n) {
+            for (size_t i = 0; i < n; ++i, rows += rel.getArity()) {
+                for (size_t j = 0; j < rel.getArity(); ++j) {
+                    out << (j > 0 ? "\t" : "") << decode(rel, j, rows[j]);
+                }
+                out << "\n";
+            }
+            count += n;
+        });
+        out << "ok " << count << "\n";
+
+        // restore the relations shared by all queries
+        if (!seeds.empty()) {
+            for (const auto& cur : seeds) {
+                cur.first->retract(cur.second);
+            }
+            prog.runIncremental();
+        }
+    }
+
+    /** Serves the requests of a connection until it is closed, returning true on a shutdown request */
+    bool communicate(int connection) {
+        Session session;
+        std::string pending;
+        char buffer[4096];
+        ssize_t length;
+        while ((length = read(connection, buffer, sizeof(buffer))) > 0) {
+            pending.append(buffer, length);
+            size_t end;
+            while ((end = pending.find('\n')) != std::string::npos) {
+                std::string request = pending.substr(0, end);
+                pending.erase(0, end + 1);
+                if (!request.empty() && request.back() == '\r') {
+                    request.pop_back();
+                }
+                std::ostringstream answer;
+                bool shutdown = respond(session, request, answer);
+                const std::string& text = answer.str();
+                if (write(connection, text.data(), text.size()) < 0 || shutdown) {
+                    return shutdown;
+                }
+            }
+        }
+        return false;
+    }
+
+    /** Converts a field into a value of the given column of a relation */
+    static RamDomain encode(const Relation& rel, size_t column, const std::string& field) {
+        if (*rel.getAttrType(column) == 's') {
+            return rel.getSymbolTable().lookup(field);
+        }
+        return static_cast<RamDomain>(std::stol(field));
+    }
+
+    /** Converts a value of the given column of a relation into a field */
+    static std::string decode(const Relation& rel, size_t column, RamDomain value) {
+        if (*rel.getAttrType(column) == 's') {
+            return rel.getSymbolTable().resolve(value);
+        }
+        return std::to_string(value);
+    }
+
+    /** Splits a request into its tab-separated fields, the first of which is separated by a blank */
+    static std::vector<std::string> split(const std::string& request) {
+        std::vector<std::string> res;
+        size_t begin = request.find_first_of(" \t");
+        res.push_back(request.substr(0, begin));
+        while (begin != std::string::npos) {
+            size_t end = request.find('\t', begin + 1);
+            res.push_back(request.substr(begin + 1, end == std::string::npos ? end : end - begin - 1));
+            begin = end;
+        }
+        return res;
+    }
+
+    SouffleProgram& prog;
+
+    // serialises the evaluation of queries, which update the shared relations
+    std::mutex evaluation;
+
+    // whether a shutdown has been requested
+    std::atomic<bool> stopped{false};
+};
+
+}  // end of namespace souffle
@@ -21,10 +21,11 @@
 #include "Global.h"
 #include "IODirectives.h"
 #include "IOSystem.h"
+#include "LeapfrogJoin.h"
+#include "LogStatement.h"
 #include "Logger.h"
 #include "ParallelUtils.h"
 #include "ProfileEvent.h"
-#include "RAMIIndex.h"
 #include "RAMIInterface.h"
 #include "RAMIRecords.h"
 #include "RamExpression.h"
@@ -33,8 +34,11 @@
 #include "RamProgram.h"
 #include "RamVisitor.h"
 #include "ReadStream.h"
+#include "ResourceLimits.h"
+#include "SampleProfiler.h"
 #include "SignalHandler.h"
 #include "SymbolTable.h"
+#include "TransitiveClosure.h"
 #include "Util.h"
 #include "WriteStream.h"
 #include <algorithm>
@@ -46,7 +50,6 @@
 #include <functional>
 #include <iostream>
 #include <memory>
-#include <regex>
 #include <sstream>
 #include <stdexcept>
 #include <typeinfo>
@@ -156,27 +159,19 @@ RamDomain RAMI::evalExpr(const RamExpression& expr, const RAMIContext& ctxt) {
                     return result;
                 }
                 case FunctorOp::CAT: {
-                    std::stringstream ss;
+                    std::vector<RamDomain> values;
                     for (auto& arg : args) {
-                        ss << interpreter.getSymbolTable().resolve(visit(arg));
+                        values.push_back(visit(arg));
                     }
-                    return interpreter.getSymbolTable().lookup(ss.str());
+                    return interpreter.getSymbolTable().concat(values.data(), values.size());
                 }
 
                 /** Ternary Functor Operators */
                 case FunctorOp::SUBSTR: {
                     auto symbol = visit(args[0]);
-                    const std::string& str = interpreter.getSymbolTable().resolve(symbol);
                     auto idx = visit(args[1]);
                     auto len = visit(args[2]);
-                    std::string sub_str;
-                    try {
-                        sub_str = str.substr(idx, len);
-                    } catch (...) {
-                        std::cerr << "warning: wrong index position provided by substr(\"";
-                        std::cerr << str << "\"," << (int32_t)idx << "," << (int32_t)len << ") functor.\n";
-                    }
-                    return interpreter.getSymbolTable().lookup(sub_str);
+                    return interpreter.getSymbolTable().substr(symbol, idx, len);
                 }
 
                 /** Undefined */
@@ -313,6 +308,10 @@ bool RAMI::evalCond(const RamCondition& cond, const RAMIContext& ctxt) {
             return interpreter.getRelation(emptiness.getRelation()).empty();
         }
 
+        bool visitSizeCheck(const RamSizeCheck& check) override {
+            return interpreter.getRelation(check.getRelation()).size() >= check.getSize();
+        }
+
         bool visitExistenceCheck(const RamExistenceCheck& exists) override {
             const RAMIRelation& rel = interpreter.getRelation(exists.getRelation());
 
@@ -344,8 +343,8 @@ bool RAMI::evalCond(const RamCondition& cond, const RAMIContext& ctxt) {
 
             // obtain index
             auto idx = rel.getIndex(interpreter.isa->getSearchSignature(&exists));
-            auto range = idx->lowerUpperBound(low, high);
-            return range.first != range.second;  // if there is something => done
+            Stream range = idx->range(TupleRef(low, arity), TupleRef(high, arity));
+            return range.begin() != range.end();  // if there is something => done
         }
 
         bool visitProvenanceExistenceCheck(const RamProvenanceExistenceCheck& provExists) override {
@@ -371,8 +370,8 @@ bool RAMI::evalCond(const RamCondition& cond, const RAMIContext& ctxt) {
 
             // obtain index
             auto idx = rel.getIndex(interpreter.isa->getSearchSignature(&provExists));
-            auto range = idx->lowerUpperBound(low, high);
-            return range.first != range.second;  // if there is something => done
+            Stream range = idx->range(TupleRef(low, arity), TupleRef(high, arity));
+            return range.begin() != range.end();  // if there is something => done
         }
 
         // -- comparison operators --
@@ -392,33 +391,11 @@ bool RAMI::evalCond(const RamCondition& cond, const RAMIContext& ctxt) {
                     return lhs > rhs;
                 case BinaryConstraintOp::GE:
                     return lhs >= rhs;
-                case BinaryConstraintOp::MATCH: {
-                    RamDomain l = interpreter.evalExpr(relOp.getLHS(), ctxt);
-                    RamDomain r = interpreter.evalExpr(relOp.getRHS(), ctxt);
-                    const std::string& pattern = interpreter.getSymbolTable().resolve(l);
-                    const std::string& text = interpreter.getSymbolTable().resolve(r);
-                    bool result = false;
-                    try {
-                        result = std::regex_match(text, std::regex(pattern));
-                    } catch (...) {
-                        std::cerr << "warning: wrong pattern provided for match(\"" << pattern << "\",\""
-                                  << text << "\").\n";
-                    }
-                    return result;
-                }
+                case BinaryConstraintOp::MATCH:
                 case BinaryConstraintOp::NOT_MATCH: {
-                    RamDomain l = interpreter.evalExpr(relOp.getLHS(), ctxt);
-                    RamDomain r = interpreter.evalExpr(relOp.getRHS(), ctxt);
-                    const std::string& pattern = interpreter.getSymbolTable().resolve(l);
-                    const std::string& text = interpreter.getSymbolTable().resolve(r);
-                    bool result = false;
-                    try {
-                        result = !std::regex_match(text, std::regex(pattern));
-                    } catch (...) {
-                        std::cerr << "warning: wrong pattern provided for !match(\"" << pattern << "\",\""
-                                  << text << "\").\n";
-                    }
-                    return result;
+                    const SymbolTable& symbolTable = interpreter.getSymbolTable();
+                    return interpreter.regexCache.match(lhs, symbolTable.resolve(rhs), symbolTable,
+                            relOp.getOperator() == BinaryConstraintOp::NOT_MATCH);
                 }
                 case BinaryConstraintOp::CONTAINS: {
                     RamDomain l = interpreter.evalExpr(relOp.getLHS(), ctxt);
@@ -451,6 +428,54 @@ bool RAMI::evalCond(const RamCondition& cond, const RAMIContext& ctxt) {
     return ConditionEvaluator(*this, ctxt)(cond);
 }
 
+namespace {
+
+/** A source of tuples filling a buffer of the given capacity, returning the number of tuples */
+using BatchSource = std::function<size_t(const RamDomain**, size_t)>;
+
+/** Creates a source of the tuples of a stream, each batch staying valid until the next one is obtained */
+BatchSource batchesOf(Stream&& stream) {
+    auto source = std::make_shared<Stream>(std::move(stream));
+    return [source](const RamDomain** batch, size_t capacity) {
+        size_t size = 0;
+        int count;
+        while (size < capacity && (count = source->fetch(batch + size, capacity - size)) > 0) {
+            size += count;
+        }
+        return size;
+    };
+}
+
+/** Gathers the values of an operand for the selected tuples of a batch */
+void gather(const RamDomain* const* batch, const size_t* selection, size_t size, int column, RamDomain fixed,
+        RamDomain* values) {
+    if (column < 0) {
+        std::fill(values, values + size, fixed);
+        return;
+    }
+    for (size_t i = 0; i < size; i++) {
+        values[i] = batch[selection[i]][column];
+    }
+}
+
+/**
+ * Keeps the selected tuples whose operands satisfy the comparison, preserving
+ * their order, and returns their number. The selection is compacted without
+ * branching on the outcome of the comparison.
+ */
+template <typename Compare>
+size_t keepSatisfying(
+        const RamDomain* lhs, const RamDomain* rhs, size_t* selection, size_t size, Compare compare) {
+    size_t kept = 0;
+    for (size_t i = 0; i < size; i++) {
+        selection[kept] = selection[i];
+        kept += compare(lhs[i], rhs[i]) ? 1 : 0;
+    }
+    return kept;
+}
+
+}  // namespace
+
 /** Evaluate RAM operation */
 void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
     class OperationEvaluator : public RamVisitor<bool> {
@@ -467,9 +492,14 @@ void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
         }
 
         bool visitTupleOperation(const RamTupleOperation& search) override {
+            if (interpreter.sampleRule != 0) {
+                SampleProfiler::setPosition(
+                        SampleProfiler::getPosition(interpreter.sampleRule, search.getTupleId() + 1));
+            }
             bool result = visitNestedOperation(search);
 
             if (Global::config().has("profile") && !search.getProfileText().empty()) {
+#pragma omp critical(rami_frequencies)
                 interpreter.frequencies[search.getProfileText()][interpreter.getIterationNumber()]++;
             }
             return result;
@@ -479,6 +509,11 @@ void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
             // get the targeted relation
             const RAMIRelation& rel = interpreter.getRelation(scan.getRelation());
 
+            // evaluate leading filters on batches
+            if (interpreter.batchPlans.count(&scan) > 0) {
+                return processBatches(scan, batchesOf(rel.scan()));
+            }
+
             // use simple iterator
             for (const RamDomain* cur : rel) {
                 ctxt[scan.getTupleId()] = cur;
@@ -489,6 +524,27 @@ void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
             return true;
         }
 
+        /**
+         * Get the index of an index scan, bounding the range of its bounded column, if any, which
+         * is searched in the index ordering the bound columns first and the bounded column next
+         */
+        LVMIndex* getIndex(
+                const RamIndexScan& scan, const RAMIRelation& rel, RamDomain* low, RamDomain* hig) {
+            SearchSignature signature = interpreter.isa->getSearchSignature(&scan);
+            if (!scan.hasRange()) {
+                return rel.getIndex(signature);
+            }
+            int column = scan.getRangeColumn();
+            if (!isRamUndefValue(&scan.getLowerBound())) {
+                low[column] = interpreter.evalExpr(scan.getLowerBound(), ctxt);
+            }
+            if (!isRamUndefValue(&scan.getUpperBound())) {
+                hig[column] = interpreter.evalExpr(scan.getUpperBound(), ctxt);
+            }
+            const MinIndexSelection& orderSet = interpreter.isa->getIndexes(scan.getRelation());
+            return rel.getIndexByPos(orderSet.getOrderedLexOrderNum(signature, column));
+        }
+
         bool visitIndexScan(const RamIndexScan& scan) override {
             // get the targeted relation
             const RAMIRelation& rel = interpreter.getRelation(scan.getRelation());
@@ -509,15 +565,19 @@ void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
             }
 
             // obtain index
-            auto idx = rel.getIndex(interpreter.isa->getSearchSignature(&scan));
+            auto idx = getIndex(scan, rel, low, hig);
 
             // get iterator range
-            auto range = idx->lowerUpperBound(low, hig);
+            Stream range = idx->range(TupleRef(low, arity), TupleRef(hig, arity));
+
+            // evaluate leading filters on batches
+            if (interpreter.batchPlans.count(&scan) > 0) {
+                return processBatches(scan, batchesOf(std::move(range)));
+            }
 
             // conduct range query
-            for (auto ip = range.first; ip != range.second; ++ip) {
-                const RamDomain* data = *(ip);
-                ctxt[scan.getTupleId()] = data;
+            for (const TupleRef& cur : range) {
+                ctxt[scan.getTupleId()] = cur.getBase();
                 if (!visitTupleOperation(scan)) {
                     break;
                 }
@@ -525,6 +585,59 @@ void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
             return true;
         }
 
+        bool visitIntersect(const RamIntersect& intersect) override {
+            size_t numOfParticipants = intersect.getNumParticipants();
+
+            // create the search keys of the participants, unbound columns being at their minimum
+            std::vector<std::vector<RamDomain>> keys(numOfParticipants);
+            std::vector<std::vector<bool>> bound(numOfParticipants);
+            std::vector<std::vector<RamDomain>> low(numOfParticipants);
+            std::vector<std::vector<RamDomain>> found(numOfParticipants);
+            std::vector<LeapfrogJoin::Seek> seeks;
+            for (size_t p = 0; p < numOfParticipants; p++) {
+                const RAMIRelation& rel = interpreter.getRelation(intersect.getRelation(p));
+                auto pattern = intersect.getRangePattern(p);
+                for (size_t i = 0; i < rel.getArity(); i++) {
+                    bound[p].push_back(!isRamUndefValue(pattern[i]));
+                    keys[p].push_back(bound[p][i] ? interpreter.evalExpr(*pattern[i], ctxt) : MIN_RAM_DOMAIN);
+                }
+                low[p] = keys[p];
+                found[p] = keys[p];
+
+                // obtain index
+                size_t column = intersect.getColumn(p);
+                SearchSignature signature = interpreter.isa->getSearchSignature(&intersect, p);
+                const MinIndexSelection& orderSet = interpreter.isa->getIndexes(intersect.getRelation(p));
+                LVMIndex* idx = rel.getIndexByPos(orderSet.getOrderedLexOrderNum(signature, column));
+                seeks.push_back([&, p, column, idx](RamDomain& value) {
+                    low[p][column] = value;
+                    if (!idx->lowerBound(TupleRef(low[p].data(), low[p].size()), found[p].data())) {
+                        return false;
+                    }
+                    const std::vector<RamDomain>& res = found[p];
+                    for (size_t i = 0; i < keys[p].size(); i++) {
+                        if (bound[p][i] && res[i] != keys[p][i]) {
+                            return false;
+                        }
+                    }
+                    value = res[column];
+                    return true;
+                });
+            }
+
+            // conduct the intersection
+            LeapfrogJoin join(seeks);
+            RamDomain value[1];
+            while (join.next()) {
+                value[0] = join.get();
+                ctxt[intersect.getTupleId()] = value;
+                if (!visitTupleOperation(intersect)) {
+                    break;
+                }
+            }
+            return true;
+        }
+
         bool visitChoice(const RamChoice& choice) override {
             // get the targeted relation
             const RAMIRelation& rel = interpreter.getRelation(choice.getRelation());
@@ -563,12 +676,11 @@ void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
             auto idx = rel.getIndex(interpreter.isa->getSearchSignature(&choice));
 
             // get iterator range
-            auto range = idx->lowerUpperBound(low, hig);
+            Stream range = idx->range(TupleRef(low, arity), TupleRef(hig, arity));
 
             // conduct range query
-            for (auto ip = range.first; ip != range.second; ++ip) {
-                const RamDomain* data = *(ip);
-                ctxt[choice.getTupleId()] = data;
+            for (const TupleRef& cur : range) {
+                ctxt[choice.getTupleId()] = cur.getBase();
                 if (interpreter.evalCond(choice.getCondition(), ctxt)) {
                     visitTupleOperation(choice);
                     break;
@@ -577,6 +689,88 @@ void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
             return true;
         }
 
+        bool visitParallelScan(const RamParallelScan& scan) override {
+            // get the targeted relation
+            const RAMIRelation& rel = interpreter.getRelation(scan.getRelation());
+
+            // nullary relations hold at most one tuple
+            if (rel.getArity() == 0) {
+                return visitScan(scan);
+            }
+
+            auto idx = rel.getIndex(rel.getTotalIndexKey());
+            auto chunks = idx->partitionScan(PARTITION_COUNT);
+            return processChunks(chunks, scan, nullptr);
+        }
+
+        bool visitParallelIndexScan(const RamParallelIndexScan& scan) override {
+            // get the targeted relation
+            const RAMIRelation& rel = interpreter.getRelation(scan.getRelation());
+
+            // create pattern tuple for range query
+            auto arity = rel.getArity();
+            RamDomain low[arity];
+            RamDomain hig[arity];
+            auto pattern = scan.getRangePattern();
+            for (size_t i = 0; i < arity; i++) {
+                if (!isRamUndefValue(pattern[i])) {
+                    low[i] = interpreter.evalExpr(*pattern[i], ctxt);
+                    hig[i] = low[i];
+                } else {
+                    low[i] = MIN_RAM_DOMAIN;
+                    hig[i] = MAX_RAM_DOMAIN;
+                }
+            }
+
+            // obtain index
+            auto idx = getIndex(scan, rel, low, hig);
+
+            // split the iterator range into chunks
+            auto chunks = idx->partitionRange(TupleRef(low, arity), TupleRef(hig, arity), PARTITION_COUNT);
+            return processChunks(chunks, scan, nullptr);
+        }
+
+        bool visitParallelChoice(const RamParallelChoice& choice) override {
+            // get the targeted relation
+            const RAMIRelation& rel = interpreter.getRelation(choice.getRelation());
+
+            // nullary relations hold at most one tuple
+            if (rel.getArity() == 0) {
+                return visitChoice(choice);
+            }
+
+            auto idx = rel.getIndex(rel.getTotalIndexKey());
+            auto chunks = idx->partitionScan(PARTITION_COUNT);
+            return processChunks(chunks, choice, &choice.getCondition());
+        }
+
+        bool visitParallelIndexChoice(const RamParallelIndexChoice& choice) override {
+            // get the targeted relation
+            const RAMIRelation& rel = interpreter.getRelation(choice.getRelation());
+
+            // create pattern tuple for range query
+            auto arity = rel.getArity();
+            RamDomain low[arity];
+            RamDomain hig[arity];
+            auto pattern = choice.getRangePattern();
+            for (size_t i = 0; i < arity; i++) {
+                if (!isRamUndefValue(pattern[i])) {
+                    low[i] = interpreter.evalExpr(*pattern[i], ctxt);
+                    hig[i] = low[i];
+                } else {
+                    low[i] = MIN_RAM_DOMAIN;
+                    hig[i] = MAX_RAM_DOMAIN;
+                }
+            }
+
+            // obtain index
+            auto idx = rel.getIndex(interpreter.isa->getSearchSignature(&choice));
+
+            // split the iterator range into chunks
+            auto chunks = idx->partitionRange(TupleRef(low, arity), TupleRef(hig, arity), PARTITION_COUNT);
+            return processChunks(chunks, choice, &choice.getCondition());
+        }
+
         bool visitUnpackRecord(const RamUnpackRecord& lookup) override {
             // get reference
             RamDomain ref = interpreter.evalExpr(lookup.getExpression(), ctxt);
@@ -712,13 +906,44 @@ void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
             auto idx = rel.getIndex(interpreter.isa->getSearchSignature(&aggregate));
 
             // get iterator range
-            auto range = idx->lowerUpperBound(low, hig);
+            Stream range = idx->range(TupleRef(low, arity), TupleRef(hig, arity));
 
+            // b-tree indexes and equivalence relations count the tuples of a range without retrieving them
+            long remaining = -1;
+            if (aggregate.getFunction() == souffle::COUNT &&
+                    dynamic_cast<const RamTrue*>(&aggregate.getCondition()) != nullptr) {
+                remaining = range.remaining();
+            }
+            if (remaining >= 0) {
+                res = remaining;
+            } else {
+                countOrAggregate(aggregate, range, res);
+            }
+
+            // write result to environment
+            RamDomain tuple[1];
+            tuple[0] = res;
+            ctxt[aggregate.getTupleId()] = tuple;
+
+            // run nested part - using base class visitor
+            if (aggregate.getFunction() == souffle::MAX && res == MIN_RAM_DOMAIN) {
+                // no maximum found
+                return true;
+            } else if (aggregate.getFunction() == souffle::MIN && res == MAX_RAM_DOMAIN) {
+                // no minimum found
+                return true;
+            } else {
+                // run nested part - using base class visitor
+                return visitTupleOperation(aggregate);
+            }
+        }
+
+        /** Fold the tuples of a range satisfying the condition of an aggregate into its result */
+        void countOrAggregate(const RamIndexAggregate& aggregate, Stream& range, RamDomain& res) {
             // iterate through values
-            for (auto ip = range.first; ip != range.second; ++ip) {
+            for (const TupleRef& tuple : range) {
                 // link tuple
-                const RamDomain* data = *(ip);
-                ctxt[aggregate.getTupleId()] = data;
+                ctxt[aggregate.getTupleId()] = tuple.getBase();
 
                 if (!interpreter.evalCond(aggregate.getCondition(), ctxt)) {
                     continue;
@@ -750,23 +975,6 @@ void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
                         break;
                 }
             }
-
-            // write result to environment
-            RamDomain tuple[1];
-            tuple[0] = res;
-            ctxt[aggregate.getTupleId()] = tuple;
-
-            // run nested part - using base class visitor
-            if (aggregate.getFunction() == souffle::MAX && res == MIN_RAM_DOMAIN) {
-                // no maximum found
-                return true;
-            } else if (aggregate.getFunction() == souffle::MIN && res == MAX_RAM_DOMAIN) {
-                // no minimum found
-                return true;
-            } else {
-                // run nested part - using base class visitor
-                return visitTupleOperation(aggregate);
-            }
         }
 
         bool visitBreak(const RamBreak& breakOp) override {
@@ -786,6 +994,7 @@ void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
             }
 
             if (Global::config().has("profile") && !filter.getProfileText().empty()) {
+#pragma omp critical(rami_frequencies)
                 interpreter.frequencies[filter.getProfileText()][interpreter.getIterationNumber()]++;
             }
             return result;
@@ -809,6 +1018,8 @@ void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
 
         // -- return from subroutine --
         bool visitSubroutineReturnValue(const RamSubroutineReturnValue& ret) override {
+            // return buffers are shared by all workers of a parallel operation
+#pragma omp critical(rami_return_value)
             for (auto val : ret.getValues()) {
                 if (isRamUndefValue(val)) {
                     ctxt.addReturnValue(0, true);
@@ -824,6 +1035,122 @@ void RAMI::evalOp(const RamOperation& op, const RAMIContext& args) {
             std::cerr << "Unsupported node type: " << typeid(node).name() << "\n";
             assert(false && "Unsupported Node Type!");
         }
+
+    private:
+        /**
+         * Runs the nested operation of a scan for the tuples obtained batch by batch
+         * from the given source. The leading filters of the scan are evaluated column
+         * by column on each batch, and the remaining operation is only run for the
+         * tuples passing all of them.
+         */
+        bool processBatches(const RamTupleOperation& search, const BatchSource& next) {
+            const size_t id = search.getTupleId();
+            const BatchPlan& plan = interpreter.batchPlans.at(&search);
+
+            // evaluate the operands fixed for all batches
+            size_t numConstraints = plan.constraints.size();
+            std::vector<RamDomain> lhsFixed(numConstraints);
+            std::vector<RamDomain> rhsFixed(numConstraints);
+            for (size_t i = 0; i < numConstraints; i++) {
+                const BatchConstraint& constraint = plan.constraints[i];
+                if (constraint.lhsColumn < 0) {
+                    lhsFixed[i] = interpreter.evalExpr(*constraint.lhs, ctxt);
+                }
+                if (constraint.rhsColumn < 0) {
+                    rhsFixed[i] = interpreter.evalExpr(*constraint.rhs, ctxt);
+                }
+            }
+
+            const RamDomain* batch[BATCH_SIZE];
+            size_t selection[BATCH_SIZE];
+            RamDomain lhs[BATCH_SIZE];
+            RamDomain rhs[BATCH_SIZE];
+            size_t size;
+            while ((size = next(batch, BATCH_SIZE)) > 0) {
+                for (size_t i = 0; i < size; i++) {
+                    selection[i] = i;
+                }
+
+                // narrow the selected tuples down constraint by constraint
+                for (size_t i = 0; i < numConstraints && size > 0; i++) {
+                    const BatchConstraint& constraint = plan.constraints[i];
+                    gather(batch, selection, size, constraint.lhsColumn, lhsFixed[i], lhs);
+                    gather(batch, selection, size, constraint.rhsColumn, rhsFixed[i], rhs);
+                    switch (constraint.op) {
+                        case BinaryConstraintOp::EQ:
+                            size = keepSatisfying(lhs, rhs, selection, size, std::equal_to<RamDomain>());
+                            break;
+                        case BinaryConstraintOp::NE:
+                            size = keepSatisfying(lhs, rhs, selection, size, std::not_equal_to<RamDomain>());
+                            break;
+                        case BinaryConstraintOp::LT:
+                            size = keepSatisfying(lhs, rhs, selection, size, std::less<RamDomain>());
+                            break;
+                        case BinaryConstraintOp::LE:
+                            size = keepSatisfying(lhs, rhs, selection, size, std::less_equal<RamDomain>());
+                            break;
+                        case BinaryConstraintOp::GT:
+                            size = keepSatisfying(lhs, rhs, selection, size, std::greater<RamDomain>());
+                            break;
+                        case BinaryConstraintOp::GE:
+                            size = keepSatisfying(lhs, rhs, selection, size, std::greater_equal<RamDomain>());
+                            break;
+                        default:
+                            assert(false && "unsupported operator in batch");
+                    }
+                }
+
+                // run the remaining operation for the selected tuples
+                for (size_t i = 0; i < size; i++) {
+                    ctxt[id] = batch[selection[i]];
+                    if (!visit(*plan.nested)) {
+                        return true;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Runs the nested operation of a parallel scan or choice over the given chunks.
+         * Chunks are distributed among threads, each evaluating on its own copy of the context.
+         * A choice, given by its condition, processes at most one tuple per chunk.
+         */
+        bool processChunks(std::vector<Stream>& chunks,
+                const RamTupleOperation& search, const RamCondition* condition) {
+            int size = chunks.size();
+            // a choice is made by the first worker finding a tuple, the others skip the chunks left
+            std::atomic<bool> chosen(false);
+#pragma omp parallel
+            {
+                RAMIContext threadCtxt(ctxt);
+                OperationEvaluator evaluator(interpreter, threadCtxt);
+#pragma omp for schedule(dynamic)
+                for (int i = 0; i < size; ++i) {
+                    if (condition != nullptr && chosen.load(std::memory_order_relaxed)) {
+                        continue;
+                    }
+                    if (condition == nullptr && interpreter.batchPlans.count(&search) > 0) {
+                        evaluator.processBatches(search, batchesOf(std::move(chunks[i])));
+                        continue;
+                    }
+                    for (const TupleRef& cur : chunks[i]) {
+                        threadCtxt[search.getTupleId()] = cur.getBase();
+                        if (condition == nullptr) {
+                            if (!evaluator.visitTupleOperation(search)) {
+                                break;
+                            }
+                        } else if (interpreter.evalCond(*condition, threadCtxt)) {
+                            if (!chosen.exchange(true)) {
+                                evaluator.visitTupleOperation(search);
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
     };
 
     // create and run interpreter for operations
@@ -857,6 +1184,11 @@ void RAMI::evalStmt(const RamStatement& stmt, const RAMIContext& args) {
             return true;
         }
 
+        bool visitPlanSwitch(const RamPlanSwitch& planSwitch) override {
+            // join orders are not adapted at runtime; use the statically chosen one
+            return visit(planSwitch.getStatements().front());
+        }
+
         bool visitParallel(const RamParallel& parallel) override {
             // get statements to be processed in parallel
             const auto& stmts = parallel.getStatements();
@@ -884,6 +1216,8 @@ void RAMI::evalStmt(const RamStatement& stmt, const RAMIContext& args) {
             interpreter.resetIterationNumber();
             while (visit(loop.getBody())) {
                 interpreter.incIterationNumber();
+                // the indexes of this interpreter are all maintained by inserts, none to evict
+                ResourceLimits::instance().check();
             }
             interpreter.resetIterationNumber();
             return true;
@@ -901,6 +1235,15 @@ void RAMI::evalStmt(const RamStatement& stmt, const RAMIContext& args) {
         }
 
         bool visitLogTimer(const RamLogTimer& timer) override {
+            // mark a rule for the sampling profiler instead of timing it
+            if (LogStatement::isSample(timer.getMessage())) {
+                interpreter.sampleRule = interpreter.sampleRules.at(timer.getMessage());
+                SampleProfiler::setPosition(SampleProfiler::getPosition(interpreter.sampleRule, 0));
+                bool result = visit(timer.getStatement());
+                SampleProfiler::setPosition(0);
+                interpreter.sampleRule = 0;
+                return result;
+            }
             Logger logger(timer.getMessage().c_str(), interpreter.getIterationNumber());
             return visit(timer.getStatement());
         }
@@ -955,17 +1298,29 @@ void RAMI::evalStmt(const RamStatement& stmt, const RAMIContext& args) {
             return true;
         }
 
+        bool visitLogDistinctValues(const RamLogDistinctValues& distinct) override {
+            const RAMIRelation& rel = interpreter.getRelation(distinct.getRelation());
+            ProfileEventSingleton::instance().makeDistinctValuesEvents(
+                    distinct.getMessages(), rel, interpreter.getIterationNumber());
+            return true;
+        }
+
         bool visitLoad(const RamLoad& load) override {
+            size_t directive = 0;
             for (IODirectives ioDirectives : load.getIODirectives()) {
                 try {
                     RAMIRelation& relation = interpreter.getRelation(load.getRelation());
+                    const std::string key = InputPrefetcher::key(load.getRelation().getName(), directive++);
+                    if (interpreter.inputPrefetcher.load(key, relation)) {
+                        continue;
+                    }
                     std::vector<bool> symbolMask;
                     for (auto& cur : load.getRelation().getAttributeTypeQualifiers()) {
                         symbolMask.push_back(cur[0] == 's');
                     }
                     IOSystem::getInstance()
-                            .getReader(symbolMask, interpreter.getSymbolTable(), ioDirectives,
-                                    Global::config().has("provenance"))
+                            .getReader(symbolMask, interpreter.getSymbolTable(load.getRelation()),
+                                    ioDirectives, load.getRelation().hasProvenanceColumns())
                             ->readAll(relation);
                 } catch (std::exception& e) {
                     std::cerr << "Error loading data: " << e.what() << "\n";
@@ -974,19 +1329,29 @@ void RAMI::evalStmt(const RamStatement& stmt, const RAMIContext& args) {
             return true;
         }
         bool visitStore(const RamStore& store) override {
+            std::vector<bool> symbolMask;
+            for (auto& cur : store.getRelation().getAttributeTypeQualifiers()) {
+                symbolMask.push_back(cur[0] == 's');
+            }
+            const RAMIRelation& relation = interpreter.getRelation(store.getRelation());
+            SymbolTable& symbolTable = interpreter.getSymbolTable(store.getRelation());
+            const bool provenance = store.getRelation().hasProvenanceColumns();
             for (IODirectives ioDirectives : store.getIODirectives()) {
-                try {
-                    std::vector<bool> symbolMask;
-                    for (auto& cur : store.getRelation().getAttributeTypeQualifiers()) {
-                        symbolMask.push_back(cur[0] == 's');
+                auto write = [symbolMask, ioDirectives, &relation, &symbolTable, provenance]() {
+                    try {
+                        IOSystem::getInstance()
+                                .getWriter(symbolMask, symbolTable, ioDirectives, provenance)
+                                ->writeAll(relation);
+                    } catch (std::exception& e) {
+                        std::cerr << e.what();
+                        exit(1);
                     }
-                    IOSystem::getInstance()
-                            .getWriter(symbolMask, interpreter.getSymbolTable(), ioDirectives,
-                                    Global::config().has("provenance"))
-                            ->writeAll(interpreter.getRelation(store.getRelation()));
-                } catch (std::exception& e) {
-                    std::cerr << e.what();
-                    exit(1);
+                };
+                // the relations of completed strata are not modified, and written while evaluation goes on
+                if (Global::config().has("async-output")) {
+                    interpreter.writeQueue.submit(&relation, write);
+                } else {
+                    write();
                 }
             }
             return true;
@@ -1031,6 +1396,24 @@ void RAMI::evalStmt(const RamStatement& stmt, const RAMIContext& args) {
             return true;
         }
 
+        bool visitTransitiveClosure(const RamTransitiveClosure& closure) override {
+            RAMIRelation& src = interpreter.getRelation(closure.getSourceRelation());
+            RAMIRelation& trg = interpreter.getRelation(closure.getTargetRelation());
+
+            TransitiveClosure graph;
+            for (const RamDomain* cur : src) {
+                graph.addEdge(cur[0], cur[1]);
+            }
+            graph.compute([&](RamDomain from, const std::vector<RamDomain>& reached) {
+                RamDomain tuple[2] = {from, 0};
+                for (RamDomain to : reached) {
+                    tuple[1] = to;
+                    trg.insert(tuple);
+                }
+            });
+            return true;
+        }
+
         // -- safety net --
 
         bool visitNode(const RamNode& node) override {
@@ -1055,16 +1438,50 @@ void RAMI::evalStmt(const RamStatement& stmt, const RAMIContext& args) {
 
 /** Execute main program of a translation unit */
 void RAMI::executeMain() {
+#ifdef _OPENMP
+    int jobs = std::stoi(Global::config().get("jobs"));
+    if (jobs > 0) {
+        omp_set_num_threads(jobs);
+    }
+#endif
     SignalHandler::instance()->set();
     if (Global::config().has("verbose")) {
         SignalHandler::instance()->enableLogging();
     }
     const RamStatement& main = *translationUnit.getProgram()->getMain();
+    createRelationSymbols();
+
+    // the inputs are read in the background from the start on, and inserted into their relations by the loads
+    if (Global::config().has("prefetch-input")) {
+        visitDepthFirst(main, [&](const RamLoad& load) {
+            const bool provenance = load.getRelation().hasProvenanceColumns();
+            SymbolTable* symbolTable = &getSymbolTable(load.getRelation());
+            std::vector<bool> symbolMask;
+            for (auto& cur : load.getRelation().getAttributeTypeQualifiers()) {
+                symbolMask.push_back(cur[0] == 's');
+            }
+            size_t directive = 0;
+            for (const IODirectives& ioDirectives : load.getIODirectives()) {
+                auto read = [symbolMask, ioDirectives, provenance, symbolTable](TupleBuffer& tuples) {
+                    IOSystem::getInstance()
+                            .getReader(symbolMask, *symbolTable, ioDirectives, provenance)
+                            ->readAll(tuples);
+                };
+                inputPrefetcher.prefetch(InputPrefetcher::key(load.getRelation().getName(), directive++),
+                        symbolMask.size(), read);
+            }
+        });
+    }
 
     if (!Global::config().has("profile")) {
         evalStmt(main);
     } else {
-        ProfileEventSingleton::instance().setOutputFile(Global::config().get("profile"));
+        ProfileEventSingleton::instance().setOutputFile(
+                Global::config().get("profile"), Global::config().has("profile-binary"));
+        if (Global::config().has("profile-stream")) {
+            ProfileEventSingleton::instance().listen(Global::config().get("profile-stream"));
+        }
+        ProfileEventSingleton::instance().setHardwareCounters(Global::config().has("profile-counters"));
         // Prepare the frequency table for threaded use
         visitDepthFirst(main, [&](const RamTupleOperation& node) {
             if (!node.getProfileText().empty()) {
@@ -1093,7 +1510,21 @@ void RAMI::executeMain() {
         visitDepthFirst(main, [&](const RamQuery& rule) { ++ruleCount; });
         ProfileEventSingleton::instance().makeConfigRecord("ruleCount", std::to_string(ruleCount));
 
+        // Number the rules marked for the sampling profiler
+        if (Global::config().has("profile-sampling")) {
+            std::vector<std::string> labels{""};
+            visitDepthFirst(main, [&](const RamLogTimer& timer) {
+                const std::string& label = timer.getMessage();
+                if (LogStatement::isSample(label) && sampleRules.count(label) == 0) {
+                    sampleRules[label] = labels.size();
+                    labels.push_back(label);
+                }
+            });
+            SampleProfiler::instance().start(labels);
+        }
+
         evalStmt(main);
+        SampleProfiler::instance().stop();
         ProfileEventSingleton::instance().stopTimer();
         for (auto const& cur : frequencies) {
             for (auto const& iter : cur.second) {
@@ -1105,9 +1536,81 @@ void RAMI::executeMain() {
                     "@relation-reads;" + cur.first, cur.second, 0);
         }
     }
+    writeQueue.wait();
     SignalHandler::instance()->reset();
 }
 
+/** Create batch plans */
+void RAMI::createBatchPlans() {
+    // profiling counts the tuples of every scan
+    if (Global::config().has("profile")) {
+        return;
+    }
+
+    // collects the constraints of a condition to be evaluated on batches of the given tuple
+    std::function<bool(const RamCondition&, int, std::vector<BatchConstraint>&)> collect =
+            [&](const RamCondition& cond, int id, std::vector<BatchConstraint>& res) {
+                if (const auto* conj = dynamic_cast<const RamConjunction*>(&cond)) {
+                    return collect(conj->getLHS(), id, res) && collect(conj->getRHS(), id, res);
+                }
+                const auto* constraint = dynamic_cast<const RamConstraint*>(&cond);
+                if (constraint == nullptr) {
+                    return false;
+                }
+                switch (constraint->getOperator()) {
+                    case BinaryConstraintOp::EQ:
+                    case BinaryConstraintOp::NE:
+                    case BinaryConstraintOp::LT:
+                    case BinaryConstraintOp::LE:
+                    case BinaryConstraintOp::GT:
+                    case BinaryConstraintOp::GE:
+                        break;
+                    default:
+                        return false;
+                }
+
+                // operands are constants or elements of tuples
+                auto column = [&](const RamExpression& expr, int& col) {
+                    col = -1;
+                    if (const auto* elem = dynamic_cast<const RamTupleElement*>(&expr)) {
+                        if (elem->getTupleId() == id) {
+                            col = elem->getElement();
+                        }
+                        return true;
+                    }
+                    return dynamic_cast<const RamNumber*>(&expr) != nullptr;
+                };
+                BatchConstraint batchConstraint{
+                        constraint->getOperator(), &constraint->getLHS(), &constraint->getRHS(), -1, -1};
+                if (!column(constraint->getLHS(), batchConstraint.lhsColumn) ||
+                        !column(constraint->getRHS(), batchConstraint.rhsColumn)) {
+                    return false;
+                }
+                res.push_back(batchConstraint);
+                return true;
+            };
+
+    visitDepthFirst(*translationUnit.getProgram(), [&](const RamTupleOperation& search) {
+        if (dynamic_cast<const RamScan*>(&search) == nullptr &&
+                dynamic_cast<const RamIndexScan*>(&search) == nullptr) {
+            return;
+        }
+        BatchPlan plan;
+        plan.nested = &search.getOperation();
+        while (const auto* filter = dynamic_cast<const RamFilter*>(plan.nested)) {
+            std::vector<BatchConstraint> constraints;
+            if (!collect(filter->getCondition(), search.getTupleId(), constraints)) {
+                break;
+            }
+            plan.constraints.insert(plan.constraints.end(), constraints.begin(), constraints.end());
+            plan.nested = &filter->getOperation();
+        }
+        if (!plan.constraints.empty()) {
+            batchPlans[&search] = std::move(plan);
+        }
+    });
+}
+
 /** Execute subroutine */
 void RAMI::executeSubroutine(const std::string& name, const std::vector<RamDomain>& arguments,
         std::vector<RamDomain>& returnValues, std::vector<bool>& returnErrors) {
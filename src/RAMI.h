@@ -16,21 +16,28 @@
 
 #pragma once
 
+#include "BinaryConstraintOps.h"
+#include "InputPrefetcher.h"
 #include "RAMIContext.h"
 #include "RAMIInterface.h"
 #include "RAMIRelation.h"
 #include "RamCondition.h"
+#include "RamPrivateSymbolAnalysis.h"
 #include "RamRelation.h"
 #include "RamStatement.h"
 #include "RamTranslationUnit.h"
 #include "RamTypes.h"
+#include "RegexCache.h"
 #include "RelationRepresentation.h"
+#include "SymbolTable.h"
+#include "WriteQueue.h"
 
 #include <atomic>
 #include <cassert>
 #include <cstdlib>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -41,6 +48,7 @@ namespace souffle {
 class RMAIProgInterface;
 class RamOperation;
 class RamExpression;
+class RamTupleOperation;
 class SymbolTable;
 
 /**
@@ -49,7 +57,11 @@ class SymbolTable;
 
 class RAMI : public RAMIInterface {
 public:
-    RAMI(RamTranslationUnit& tUnit) : RAMIInterface(tUnit) {}
+    RAMI(RamTranslationUnit& tUnit, bool batchMode = false) : RAMIInterface(tUnit), batchMode(batchMode) {
+        if (batchMode) {
+            createBatchPlans();
+        }
+    }
     ~RAMI() {
         for (auto& x : environment) {
             delete x.second;
@@ -81,6 +93,19 @@ protected:
         return translationUnit.getSymbolTable();
     }
 
+    /** Get the symbol table of the symbols of a relation, which is private for pass-through relations */
+    SymbolTable& getSymbolTable(const RamRelation& id) {
+        auto pos = relationSymbols.find(id.getName());
+        return pos != relationSymbols.end() ? *pos->second : getSymbolTable();
+    }
+
+    /** Create the private symbol tables of the relations, before they are used by concurrent reads */
+    void createRelationSymbols() {
+        for (const auto& name : translationUnit.getAnalysis<RamPrivateSymbolAnalysis>()->getRelations()) {
+            relationSymbols[name] = std::make_unique<SymbolTable>();
+        }
+    }
+
     /** Get counter */
     int getCounter() const {
         return counter;
@@ -111,6 +136,13 @@ protected:
         assert(environment.find(id.getName()) == environment.end());
         if (id.getRepresentation() == RelationRepresentation::EQREL) {
             res = new RAMIEqRelation(id.getArity(), orderSet, id.getName());
+        } else if (id.getRepresentation() == RelationRepresentation::STORAGE) {
+            // the libraries register the storage providers when they are loaded
+            loadDLL();
+            const auto& searches = orderSet->getSearches();
+            res = new RAMIRelation(id.getArity(), orderSet, id.getName(),
+                    StorageSystem::getInstance().getStorage(id.getStorage(), id.getArity(),
+                            std::vector<SearchSignature>(searches.begin(), searches.end())));
         } else {
             res = new RAMIRelation(id.getArity(), orderSet, id.getName());
         }
@@ -132,9 +164,17 @@ protected:
 
     /** Drop relation */
     void dropRelation(const RamRelation& id) {
-        RAMIRelation& rel = getRelation(id);
+        RAMIRelation* rel = &getRelation(id);
         environment.erase(id.getName());
-        delete &rel;
+        // the private symbols of a relation are released along with it
+        auto symbols = relationSymbols.find(id.getName());
+        SymbolTable* symbolTable = symbols != relationSymbols.end() ? symbols->second.get() : nullptr;
+        writeQueue.release(rel, [rel, symbolTable]() {
+            delete rel;
+            if (symbolTable != nullptr) {
+                *symbolTable = SymbolTable();
+            }
+        });
     }
 
     /** Swap relation */
@@ -148,6 +188,33 @@ protected:
 private:
     friend RAMIProgInterface;
 
+    /** Number of chunks a relation is split into by parallel operations */
+    static constexpr size_t PARTITION_COUNT = 400;
+
+    /** Number of tuples of a scan evaluated at a time in batch mode */
+    static constexpr size_t BATCH_SIZE = 1024;
+
+    /**
+     * A constraint evaluated on a batch of tuples of a scan. Each operand is
+     * either a column of the scanned tuple or an expression fixed for the batch.
+     */
+    struct BatchConstraint {
+        BinaryConstraintOp op;
+        const RamExpression* lhs;
+        const RamExpression* rhs;
+        int lhsColumn;
+        int rhsColumn;
+    };
+
+    /** The constraints of the leading filters of a scan, and the operation following them */
+    struct BatchPlan {
+        std::vector<BatchConstraint> constraints;
+        const RamOperation* nested;
+    };
+
+    /** Create the batch plans of all scans of the program */
+    void createBatchPlans();
+
     /** relation environment type */
     using relation_map = std::map<std::string, RAMIRelation*>;
 
@@ -162,14 +229,38 @@ private:
     /** counters for non-existence checks */
     std::map<std::string, std::atomic<size_t>> reads;
 
+    /** numbers of the rules marked for the sampling profiler, given their sample labels */
+    std::map<std::string, size_t> sampleRules;
+
+    /** number of the rule evaluated while sampling, or 0 outside of rules */
+    size_t sampleRule = 0;
+
     /** counter for $ operator */
-    int counter = 0;
+    std::atomic<int> counter{0};
 
     /** iteration number (in a fix-point calculation) */
     size_t iteration = 0;
 
     /** Relation Environment */
     relation_map environment;
+
+    /** whether scans are evaluated a batch of tuples at a time */
+    bool batchMode;
+
+    /** batch plans of scans with leading filters */
+    std::map<const RamTupleOperation*, BatchPlan> batchPlans;
+
+    /** the private symbol tables of pass-through relations, by relation name */
+    std::map<std::string, std::unique_ptr<SymbolTable>> relationSymbols;
+
+    /** the compiled patterns of match constraints */
+    RegexCache regexCache;
+
+    /** the relations written in the background (--async-output) */
+    WriteQueue writeQueue;
+
+    /** the inputs read in the background (--prefetch-input) */
+    InputPrefetcher inputPrefetcher;
 };
 
 }  // end of namespace souffle
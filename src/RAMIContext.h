@@ -35,6 +35,14 @@ class RAMIContext {
 
 public:
     RAMIContext(size_t size = 0) : data(size) {}
+
+    /** Create a context for a worker thread.
+     *  The tuple environment and the subroutine arguments and return buffers are
+     *  shared with the parent, while allocated tuples are owned by the copy. */
+    RAMIContext(const RAMIContext& parent)
+            : data(parent.data), returnValues(parent.returnValues), returnErrors(parent.returnErrors),
+              args(parent.args) {}
+
     virtual ~RAMIContext() = default;
 
     const RamDomain*& operator[](size_t index) {
@@ -16,14 +16,16 @@
 
 #pragma once
 
+#include "LVMIndex.h"
 #include "ParallelUtils.h"
-#include "RAMIIndex.h"
 #include "RamIndexAnalysis.h"
 #include "RamTypes.h"
 
+#include <algorithm>
+#include <array>
 #include <deque>
-#include <map>
 #include <memory>
+#include <set>
 #include <utility>
 #include <vector>
 
@@ -32,16 +34,40 @@ namespace souffle {
 /**
  * RAMI Relation
  *
+ * The tuples are stored in the indexes of the relation, the first of which serves as its
+ * main index. The indexes are those of the LVM, holding the tuples inline in trees
+ * specialised to the arity of the relation.
  */
 class RAMIRelation {
     using LexOrder = std::vector<int>;
 
 public:
-    RAMIRelation(size_t relArity, const MinIndexSelection* orderSet, std::string relName)
-            : arity(relArity), orderSet(orderSet), relName(std::move(relName)) {
-        // Create all necessary indices based on orderSet
-        for (auto& order : orderSet->getAllOrders()) {
-            indices.push_back(RAMIIndex(order));
+    /**
+     * Create the indexes of a relation; those of a relation held by the given storage of a
+     * storage provider present the storage instead.
+     */
+    RAMIRelation(size_t relArity, const MinIndexSelection* orderSet, std::string relName,
+            std::shared_ptr<RelationStorage> storage = nullptr)
+            : arity(relArity), orderSet(orderSet), relName(std::move(relName)),
+              ownsValues(storage == nullptr && arity > MAX_DIRECT_INDEX_SIZE) {
+        // the indexes of wide relations refer to the values of the tuples, which are kept in blocks
+        IndexFactory factory = ownsValues ? &createIndirectIndex : &createBTreeIndex;
+
+        // Create all necessary indices based on orderSet, expanded to total orders
+        for (LexOrder order : orderSet->getAllOrders()) {
+            std::set<int> covered(order.begin(), order.end());
+            for (size_t i = 0; i < arity; ++i) {
+                if (covered.count(i) == 0) {
+                    order.push_back(i);
+                }
+            }
+            if (storage == nullptr) {
+                indices.push_back(factory(Order(order)));
+            } else if (indices.empty()) {
+                indices.push_back(createStorageIndex(Order(order), storage));
+            } else {
+                indices.push_back(createStorageIndex(Order(order), *indices[0]));
+            }
         }
     }
 
@@ -85,34 +111,22 @@ public:
     /** Insert tuple */
     virtual void insert(const RamDomain* tuple) {
         assert(tuple);
+        auto lease = lock.acquire();
 
-        // make existence check
-        if (exists(tuple)) {
-            return;
-        }
-
-        // check for null-arity
-        if (arity == 0) {
-            indices[0].insert(tuple);
-            num_tuples = 1;
+        // the main index decides whether the tuple is new
+        TupleRef ref(tuple, arity);
+        if (indices[0]->contains(ref)) {
             return;
         }
 
-        int blockIndex = num_tuples / (BLOCK_SIZE / arity);
-        int tupleIndex = (num_tuples % (BLOCK_SIZE / arity)) * arity;
-
-        if (tupleIndex == 0) {
-            blockList.push_back(std::make_unique<RamDomain[]>(BLOCK_SIZE));
-        }
-
-        RamDomain* newTuple = &blockList[blockIndex][tupleIndex];
-        for (size_t i = 0; i < arity; ++i) {
-            newTuple[i] = tuple[i];
+        // the values given by the caller are not retained, hence wide relations copy them
+        if (ownsValues) {
+            ref = TupleRef(store(tuple), arity);
         }
 
         // update all indexes with new tuple
         for (auto& cur : indices) {
-            cur.insert(newTuple);
+            cur->insert(ref);
         }
 
         // increment relation size
@@ -129,15 +143,16 @@ public:
 
     /** Purge table */
     void purge() {
-        blockList.clear();
         for (auto& cur : indices) {
-            cur.purge();
+            cur->clear();
         }
+        blockList.clear();
+        used = 0;
         num_tuples = 0;
     }
 
     /** get index for a given search signature. Order are encoded as bits for each column */
-    RAMIIndex* getIndex(const SearchSignature& col) const {
+    LVMIndex* getIndex(const SearchSignature& col) const {
         // Special case in provenance program, a 0 searchSignature is considered as a full search
         if (col == 0 && arity != 0) {
             return getIndex(getTotalIndexKey());
@@ -146,8 +161,8 @@ public:
     }
 
     /** get index for a given order. Order are encoded as bits for each column */
-    RAMIIndex* getIndexByPos(int idx) const {
-        return &indices[idx];
+    LVMIndex* getIndexByPos(int idx) const {
+        return indices[idx].get();
     }
 
     /** Obtains a full index-key for this relation */
@@ -157,8 +172,12 @@ public:
 
     /** check whether a tuple exists in the relation */
     bool exists(const RamDomain* tuple) const {
-        RAMIIndex* index = getIndex(getTotalIndexKey());
-        return index->exists(tuple);
+        return indices[0]->contains(TupleRef(tuple, arity));
+    }
+
+    /** Obtains a stream of the tuples of this relation */
+    Stream scan() const {
+        return indices[0]->scan();
     }
 
     void setLevel(size_t level) {
@@ -171,61 +190,40 @@ public:
 
     // --- iterator ---
 
-    /** Iterator for relation */
+    /** Iterator for relation, valid until the next tuple is inserted */
     class iterator : public std::iterator<std::forward_iterator_tag, RamDomain*> {
     public:
-        iterator() = default;
+        iterator() : stream(std::make_unique<Stream>()) {}
+
+        iterator(const RAMIRelation* const relation) : stream(std::make_unique<Stream>(relation->scan())) {}
 
-        iterator(const RAMIRelation* const relation)
-                : relation(relation), tuple(relation->arity == 0 ? reinterpret_cast<RamDomain*>(this)
-                                                                 : &relation->blockList[0][0]) {}
+        iterator(const iterator& other) : stream(other.stream->clone()) {}
+
+        iterator(iterator&& other) : stream(std::move(other.stream)) {}
 
         const RamDomain* operator*() {
-            return tuple;
+            return (*stream->begin()).getBase();
         }
 
         bool operator==(const iterator& other) const {
-            return tuple == other.tuple;
+            return stream->begin() == other.stream->begin();
         }
 
         bool operator!=(const iterator& other) const {
-            return (tuple != other.tuple);
+            return stream->begin() != other.stream->begin();
         }
 
         iterator& operator++() {
-            // support 0-arity
-            if (relation->arity == 0) {
-                tuple = nullptr;
-                return *this;
-            }
-
-            // support all other arities
-            ++index;
-            if (index == relation->num_tuples) {
-                tuple = nullptr;
-                return *this;
-            }
-
-            int blockIndex = index / (BLOCK_SIZE / relation->arity);
-            int tupleIndex = (index % (BLOCK_SIZE / relation->arity)) * relation->arity;
-
-            tuple = &relation->blockList[blockIndex][tupleIndex];
+            ++stream->begin();
             return *this;
         }
 
     private:
-        const RAMIRelation* relation = nullptr;
-        size_t index = 0;
-        RamDomain* tuple = nullptr;
+        std::unique_ptr<Stream> stream;
     };
 
     /** get iterator begin of relation */
     inline iterator begin() const {
-        // check for emptiness
-        if (empty()) {
-            return end();
-        }
-
         return iterator(this);
     }
 
@@ -248,19 +246,33 @@ public:
     virtual void extend(const RAMIRelation& rel) {}
 
 private:
-    /** Arity of relation */
-    const size_t arity;
+    /** The largest arity of relations whose indexes store the tuples themselves */
+    static constexpr size_t MAX_DIRECT_INDEX_SIZE = 12;
 
-    /** Size of blocks containing tuples */
+    /** Size of blocks containing the values of the tuples of wide relations */
     static const int BLOCK_SIZE = 1024;
 
+    /** Copies the values of a tuple into the blocks, whose lock is held */
+    const RamDomain* store(const RamDomain* tuple) {
+        size_t blockSize = std::max<size_t>(BLOCK_SIZE, arity);
+        if (blockList.empty() || used + arity > blockSize) {
+            blockList.push_back(std::make_unique<RamDomain[]>(blockSize));
+            used = 0;
+        }
+        RamDomain* newTuple = blockList.back().get() + used;
+        std::copy(tuple, tuple + arity, newTuple);
+        used += arity;
+        return newTuple;
+    }
+
+    /** Arity of relation */
+    const size_t arity;
+
     /** Number of tuples in relation */
     size_t num_tuples = 0;
 
-    std::deque<std::unique_ptr<RamDomain[]>> blockList;
-
     /** List of indices */
-    mutable std::vector<RAMIIndex> indices;
+    std::vector<std::unique_ptr<LVMIndex>> indices;
 
     /** IndexSet */
     const MinIndexSelection* orderSet;
@@ -276,6 +288,15 @@ private:
 
     /** Relation name */
     const std::string relName;
+
+    /** Whether the indexes refer to values kept in the blocks of this relation */
+    const bool ownsValues;
+
+    /** The blocks keeping the values of the tuples of a wide relation, filled one after the other */
+    std::deque<std::unique_ptr<RamDomain[]>> blockList;
+
+    /** The number of values stored in the last block */
+    size_t used = 0;
 };
 
 /**
@@ -301,6 +322,7 @@ public:
         // for now, we just have a naive & extremely slow version, otherwise known as a O(n^2) insertion
         // ):
 
+        auto lease = eqLock.acquire();
         for (auto* newTuple : extend(tuple)) {
             RAMIRelation::insert(newTuple);
             delete[] newTuple;
@@ -316,14 +338,15 @@ public:
         newTuples.push_back(new RamDomain[2]{tuple[1], tuple[0]});
         newTuples.push_back(new RamDomain[2]{tuple[1], tuple[1]});
 
-        std::vector<const RamDomain*> relevantStored;
+        // the values are copied, as the streamed tuples are only valid while iterating
+        std::vector<std::array<RamDomain, 2>> relevantStored;
         for (const RamDomain* vals : *this) {
             if (vals[0] == tuple[0] || vals[0] == tuple[1] || vals[1] == tuple[0] || vals[1] == tuple[1]) {
-                relevantStored.push_back(vals);
+                relevantStored.push_back({{vals[0], vals[1]}});
             }
         }
 
-        for (const auto vals : relevantStored) {
+        for (const auto& vals : relevantStored) {
             newTuples.push_back(new RamDomain[2]{vals[0], tuple[0]});
             newTuples.push_back(new RamDomain[2]{vals[0], tuple[1]});
             newTuples.push_back(new RamDomain[2]{vals[1], tuple[0]});
@@ -350,6 +373,10 @@ public:
             delete[] newTuple;
         }
     }
+
+private:
+    /** Serialises concurrent inserts, which read the relation while extending it */
+    Lock eqLock;
 };
 
 }  // end of namespace souffle
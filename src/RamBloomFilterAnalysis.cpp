@@ -0,0 +1,130 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamBloomFilterAnalysis.cpp
+ *
+ * Implementation of the selection of the existence checks answered by Bloom filters first
+ *
+ ***********************************************************************/
+
+#include "RamBloomFilterAnalysis.h"
+#include "Global.h"
+#include "RamCondition.h"
+#include "RamIndexAnalysis.h"
+#include "RamOperation.h"
+#include "RamProgram.h"
+#include "RamRelation.h"
+#include "RamStatement.h"
+#include "RamTranslationUnit.h"
+#include "RamVisitor.h"
+#include "RelationRepresentation.h"
+#include "Util.h"
+#include "profile/ProgramRun.h"
+#include "profile/Reader.h"
+#include "profile/Relation.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+void RamBloomFilterAnalysis::run(const RamTranslationUnit& translationUnit) {
+    filtered.clear();
+    searches.clear();
+    if (!Global::config().has("bloom-filters") || Global::config().has("provenance")) {
+        return;
+    }
+    const bool all = Global::config().has("bloom-filters", "all");
+    auto* isa = translationUnit.getAnalysis<RamIndexAnalysis>();
+
+    auto run = std::make_shared<profile::ProgramRun>(profile::ProgramRun());
+    if (!all && Global::config().has("profile-use")) {
+        profile::Reader(Global::config().get("profile-use"), run).processFile();
+    }
+
+    // whether most probes of the index serving a check find nothing, more often than the relation has tuples
+    auto isMostlyEmpty = [&](const RamExistenceCheck& exists) {
+        const RamRelation& rel = exists.getRelation();
+        const auto* profRel = run->getRelation(rel.getName());
+        if (profRel == nullptr) {
+            return false;
+        }
+
+        // indexes are described by their orders expanded to all columns, the first serving total lookups
+        const auto& indexes = isa->getIndexes(rel);
+        auto order = isa->isTotalSignature(&exists) ? indexes.getAllOrders()[0]
+                                                    : indexes.getLexOrder(isa->getSearchSignature(&exists));
+        for (size_t i = 0; i < rel.getArity(); ++i) {
+            if (std::find(order.begin(), order.end(), i) == order.end()) {
+                order.push_back(i);
+            }
+        }
+        const auto& stats = profRel->getIndexStatistics();
+        auto pos = stats.find(toString(join(order, ",")));
+        if (pos == stats.end() || pos->second.count("probes") == 0 ||
+                pos->second.count("empty-probes") == 0) {
+            return false;
+        }
+        size_t probes = pos->second.at("probes");
+        size_t emptyProbes = pos->second.at("empty-probes");
+        return 2 * emptyProbes > probes && emptyProbes >= profRel->size();
+    };
+
+    visitDepthFirst(*translationUnit.getProgram()->getMain(), [&](const RamStratum& stratum) {
+        // the relations the stratum inserts into, whose filters would not be up to date
+        std::set<const RamRelation*> written;
+        visitDepthFirst(stratum, [&](const RamNode& node) {
+            if (const auto* project = dynamic_cast<const RamProject*>(&node)) {
+                written.insert(&project->getRelation());
+            } else if (const auto* merge = dynamic_cast<const RamMerge*>(&node)) {
+                written.insert(&merge->getTargetRelation());
+            } else if (const auto* closure = dynamic_cast<const RamTransitiveClosure*>(&node)) {
+                written.insert(&closure->getTargetRelation());
+            } else if (const auto* swap = dynamic_cast<const RamSwap*>(&node)) {
+                written.insert(&swap->getFirstRelation());
+                written.insert(&swap->getSecondRelation());
+            } else if (dynamic_cast<const RamLoad*>(&node) != nullptr ||
+                       dynamic_cast<const RamFact*>(&node) != nullptr ||
+                       dynamic_cast<const RamRecv*>(&node) != nullptr) {
+                written.insert(&dynamic_cast<const RamRelationStatement&>(node).getRelation());
+            }
+#ifdef USE_MPI
+            if (const auto* exchange = dynamic_cast<const RamExchange*>(&node)) {
+                written.insert(&exchange->getRelation());
+            }
+#endif
+        });
+
+        visitDepthFirst(stratum, [&](const RamExistenceCheck& exists) {
+            const RamRelation& rel = exists.getRelation();
+            SearchSignature keys = isa->getSearchSignature(&exists);
+            if (keys == 0 || rel.isTemp() || rel.isNullary() || written.count(&rel) != 0) {
+                return;
+            }
+            if (rel.getRepresentation() != RelationRepresentation::BTREE &&
+                    rel.getRepresentation() != RelationRepresentation::DEFAULT) {
+                return;
+            }
+            if (all || isMostlyEmpty(exists)) {
+                filtered.insert(&exists);
+                searches[&rel].insert(keys);
+            }
+        });
+    });
+}
+
+void RamBloomFilterAnalysis::print(std::ostream& os) const {
+    for (const auto& cur : searches) {
+        os << cur.first->getName() << ": filtered searches " << join(cur.second, ", ") << "\n";
+    }
+}
+
+}  // end of namespace souffle
@@ -0,0 +1,72 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamBloomFilterAnalysis.h
+ *
+ * Selection of the existence checks answered by Bloom filters first
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamAnalysis.h"
+#include "RamTypes.h"
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <set>
+
+namespace souffle {
+
+class RamExistenceCheck;
+class RamRelation;
+
+/**
+ * @class RamBloomFilterAnalysis
+ * @brief Determines the existence checks that test a Bloom filter of their relation first
+ *
+ * With the option bloom-filters, an existence check of a b-tree relation that the
+ * enclosing stratum does not insert into consults a Bloom filter over the columns it
+ * binds before searching an index; a check the filter rejects finds no tuple without
+ * touching the index. The filter is built from the completed relation on the first such
+ * check of a stratum.
+ *
+ * In the mode all, every such check is filtered. In the mode auto, the accesses of the
+ * index serving the check in the profile given by profile-use decide: filters pay off
+ * where most probes find nothing, and often enough to amortise filling the filter with
+ * all tuples of the relation. Checks without profile data are not filtered.
+ */
+class RamBloomFilterAnalysis : public RamAnalysis {
+public:
+    static constexpr const char* name = "bloom-filter-analysis";
+
+    void run(const RamTranslationUnit& translationUnit) override;
+
+    void print(std::ostream& os) const override;
+
+    /** Whether an existence check consults a Bloom filter of its relation */
+    bool isFiltered(const RamExistenceCheck& exists) const {
+        return filtered.count(&exists) != 0;
+    }
+
+    /** The searches of a relation whose existence checks consult Bloom filters */
+    const std::set<SearchSignature>& getFilteredSearches(const RamRelation& rel) const {
+        static const std::set<SearchSignature> none;
+        auto pos = searches.find(&rel);
+        return (pos != searches.end()) ? pos->second : none;
+    }
+
+private:
+    std::set<const RamExistenceCheck*> filtered;
+
+    std::map<const RamRelation*, std::set<SearchSignature>> searches;
+};
+
+}  // end of namespace souffle
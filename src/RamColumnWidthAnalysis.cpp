@@ -0,0 +1,206 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamColumnWidthAnalysis.cpp
+ *
+ * Implementation of the inference of the number of bits required by the values of
+ * relation columns
+ *
+ ***********************************************************************/
+
+#include "RamColumnWidthAnalysis.h"
+#include "FunctorOps.h"
+#include "RamExpression.h"
+#include "RamOperation.h"
+#include "RamProgram.h"
+#include "RamRelation.h"
+#include "RamStatement.h"
+#include "RamTranslationUnit.h"
+#include "RamVisitor.h"
+#include "Util.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+namespace souffle {
+
+namespace {
+
+// the widths of the columns of the tuples bound in a query, by their identifiers
+using Environment = std::map<int, std::vector<size_t>>;
+
+// the bits of the two's complement representation of a constant
+size_t getConstantWidth(RamDomain value) {
+    size_t width = 8;
+    while (width < RAM_DOMAIN_SIZE) {
+        const int64_t limit = int64_t(1) << (width - 1);
+        if (-limit <= int64_t(value) && int64_t(value) < limit) {
+            break;
+        }
+        width *= 2;
+    }
+    return width;
+}
+
+size_t getExpressionWidth(const RamExpression& expr, const Environment& env) {
+    if (const auto* number = dynamic_cast<const RamNumber*>(&expr)) {
+        return getConstantWidth(number->getConstant());
+    }
+    if (const auto* elem = dynamic_cast<const RamTupleElement*>(&expr)) {
+        auto pos = env.find(elem->getTupleId());
+        if (pos != env.end() && elem->getElement() < pos->second.size()) {
+            return pos->second[elem->getElement()];
+        }
+        return RAM_DOMAIN_SIZE;
+    }
+    if (const auto* op = dynamic_cast<const RamIntrinsicOperator*>(&expr)) {
+        switch (op->getOperator()) {
+            case FunctorOp::ORD:
+            case FunctorOp::STRLEN:
+                return RamColumnWidthAnalysis::REFERENCE_WIDTH;
+            case FunctorOp::MIN:
+            case FunctorOp::MAX: {
+                size_t width = 8;
+                for (const RamExpression* arg : op->getArguments()) {
+                    width = std::max(width, getExpressionWidth(*arg, env));
+                }
+                return width;
+            }
+            default:
+                return isSymbolicFunctorOp(op->getOperator()) ? RamColumnWidthAnalysis::REFERENCE_WIDTH
+                                                               : RAM_DOMAIN_SIZE;
+        }
+    }
+    if (const auto* op = dynamic_cast<const RamUserDefinedOperator*>(&expr)) {
+        return (op->getType().back() == 'S') ? RamColumnWidthAnalysis::REFERENCE_WIDTH : RAM_DOMAIN_SIZE;
+    }
+    if (dynamic_cast<const RamPackRecord*>(&expr) != nullptr) {
+        return RamColumnWidthAnalysis::REFERENCE_WIDTH;
+    }
+    return RAM_DOMAIN_SIZE;
+}
+
+}  // namespace
+
+void RamColumnWidthAnalysis::run(const RamTranslationUnit& translationUnit) {
+    const RamProgram& program = *translationUnit.getProgram();
+    widths.clear();
+    for (const auto& cur : program.getAllRelations()) {
+        widths[cur.second.get()] = std::vector<size_t>(cur.second->getArity(), 0);
+    }
+
+    // widens the columns of a relation to hold the given widths
+    bool changed = false;
+    auto widen = [&](const RamRelation& rel, const std::vector<size_t>& values) {
+        std::vector<size_t>& cols = widths[&rel];
+        cols.resize(rel.getArity(), 0);
+        for (size_t i = 0; i < values.size() && i < cols.size(); i++) {
+            if (cols[i] < values[i]) {
+                cols[i] = values[i];
+                changed = true;
+            }
+        }
+    };
+    auto getValueWidths = [&](const std::vector<RamExpression*>& values, const Environment& env) {
+        std::vector<size_t> res;
+        for (const RamExpression* value : values) {
+            res.push_back(getExpressionWidth(*value, env));
+        }
+        return res;
+    };
+
+    // binds the tuples of nested operations to the widths of their sources
+    std::function<void(const RamOperation&, Environment)> visitOperation;
+    visitOperation = [&](const RamOperation& op, Environment env) {
+        if (const auto* project = dynamic_cast<const RamProject*>(&op)) {
+            widen(project->getRelation(), getValueWidths(project->getValues(), env));
+            return;
+        }
+        if (const auto* aggregate = dynamic_cast<const RamAbstractAggregate*>(&op)) {
+            const auto& scan = dynamic_cast<const RamRelationOperation&>(op);
+            size_t width = RAM_DOMAIN_SIZE;
+            if (aggregate->getFunction() == MIN || aggregate->getFunction() == MAX) {
+                Environment inner = env;
+                inner[scan.getTupleId()] = widths[&scan.getRelation()];
+                width = getExpressionWidth(aggregate->getExpression(), inner);
+            }
+            env[scan.getTupleId()] = {width};
+        } else if (const auto* scan = dynamic_cast<const RamRelationOperation*>(&op)) {
+            env[scan->getTupleId()] = widths[&scan->getRelation()];
+        } else if (const auto* intersect = dynamic_cast<const RamIntersect*>(&op)) {
+            // shared values are in the narrowest of the intersected columns
+            size_t width = RAM_DOMAIN_SIZE;
+            for (size_t i = 0; i < intersect->getNumParticipants(); i++) {
+                width = std::min(width, widths[&intersect->getRelation(i)][intersect->getColumn(i)]);
+            }
+            env[intersect->getTupleId()] = {width};
+        } else if (const auto* unpack = dynamic_cast<const RamUnpackRecord*>(&op)) {
+            env[unpack->getTupleId()] = std::vector<size_t>(unpack->getArity(), RAM_DOMAIN_SIZE);
+        }
+        if (const auto* nested = dynamic_cast<const RamNestedOperation*>(&op)) {
+            visitOperation(nested->getOperation(), env);
+        }
+    };
+
+    // widen the columns to the values inserted into them until all inserted values fit
+    do {
+        changed = false;
+        visitDepthFirst(program, [&](const RamStatement& stmt) {
+            if (const auto* query = dynamic_cast<const RamQuery*>(&stmt)) {
+                visitOperation(query->getOperation(), Environment());
+            } else if (const auto* fact = dynamic_cast<const RamFact*>(&stmt)) {
+                widen(fact->getRelation(), getValueWidths(fact->getValues(), Environment()));
+            } else if (const auto* load = dynamic_cast<const RamLoad*>(&stmt)) {
+                const RamRelation& rel = load->getRelation();
+                std::vector<size_t> cols;
+                for (size_t i = 0; i < rel.getArity(); i++) {
+                    const char kind = rel.getArgTypeQualifier(i)[0];
+                    cols.push_back((kind == 's' || kind == 'r') ? REFERENCE_WIDTH : RAM_DOMAIN_SIZE);
+                }
+                widen(rel, cols);
+            } else if (const auto* merge = dynamic_cast<const RamMerge*>(&stmt)) {
+                widen(merge->getTargetRelation(), widths[&merge->getSourceRelation()]);
+            } else if (const auto* closure = dynamic_cast<const RamTransitiveClosure*>(&stmt)) {
+                widen(closure->getTargetRelation(), widths[&closure->getSourceRelation()]);
+            } else if (const auto* swap = dynamic_cast<const RamSwap*>(&stmt)) {
+                widen(swap->getFirstRelation(), widths[&swap->getSecondRelation()]);
+                widen(swap->getSecondRelation(), widths[&swap->getFirstRelation()]);
+            }
+        });
+    } while (changed);
+
+    // columns never inserted into are of the least width
+    for (auto& cur : widths) {
+        for (size_t& width : cur.second) {
+            width = std::max<size_t>(width, 8);
+        }
+    }
+}
+
+void RamColumnWidthAnalysis::print(std::ostream& os) const {
+    for (const auto& cur : widths) {
+        os << cur.first->getName() << ": [" << join(cur.second, ",") << "]\n";
+    }
+}
+
+std::vector<size_t> RamColumnWidthAnalysis::getColumnWidths(const RamRelation& rel) const {
+    auto pos = widths.find(&rel);
+    return (pos != widths.end()) ? pos->second : std::vector<size_t>(rel.getArity(), RAM_DOMAIN_SIZE);
+}
+
+size_t RamColumnWidthAnalysis::getWidth(const RamRelation& rel) const {
+    size_t width = 8;
+    for (size_t cur : getColumnWidths(rel)) {
+        width = std::max(width, cur);
+    }
+    return width;
+}
+
+}  // end of namespace souffle
@@ -0,0 +1,65 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamColumnWidthAnalysis.h
+ *
+ * Inference of the number of bits required by the values of relation columns
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamAnalysis.h"
+#include "RamTypes.h"
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace souffle {
+
+class RamRelation;
+
+/**
+ * @class RamColumnWidthAnalysis
+ * @brief Determines the number of bits sufficient for the values of each column of a relation
+ *
+ * A column is as wide as the widest value inserted into it: constants need the bits of
+ * their two's complement representation, symbols and records are referenced by indexes
+ * of 32 bits, values copied from other columns keep the width of those, and the minimum
+ * and maximum of values the width of the widest operand. Merges and swaps transfer the
+ * widths of their sources. The number columns of loaded relations, arithmetic, counters
+ * and the arguments of subroutines occupy the full width of RamDomain.
+ *
+ * Widths are powers of two from 8 to RAM_DOMAIN_SIZE, with 8 for columns that are never
+ * inserted into.
+ */
+class RamColumnWidthAnalysis : public RamAnalysis {
+public:
+    static constexpr const char* name = "column-width-analysis";
+
+    /** The width of symbol and record references */
+    static constexpr size_t REFERENCE_WIDTH = 32;
+
+    void run(const RamTranslationUnit& translationUnit) override;
+
+    void print(std::ostream& os) const override;
+
+    /** The widths of the columns of a relation */
+    std::vector<size_t> getColumnWidths(const RamRelation& rel) const;
+
+    /** The width of the widest column of a relation */
+    size_t getWidth(const RamRelation& rel) const;
+
+private:
+    std::map<const RamRelation*, std::vector<size_t>> widths;
+};
+
+}  // end of namespace souffle
@@ -443,6 +443,62 @@ protected:
     }
 };
 
+/**
+ * @class RamSizeCheck
+ * @brief Size check for a relation
+ *
+ * Evaluates to true if the given relation holds at least the given number of tuples
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * (|B| ≥ 10)
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class RamSizeCheck : public RamCondition {
+public:
+    RamSizeCheck(std::unique_ptr<RamRelationReference> relRef, size_t size)
+            : relationRef(std::move(relRef)), size(size) {}
+
+    /** @brief Get relation */
+    const RamRelation& getRelation() const {
+        return *relationRef->get();
+    }
+
+    /** @brief Get the number of tuples required */
+    size_t getSize() const {
+        return size;
+    }
+
+    void print(std::ostream& os) const override {
+        os << "(|" << getRelation().getName() << "| ≥ " << size << ")";
+    }
+
+    std::vector<const RamNode*> getChildNodes() const override {
+        return {relationRef.get()};
+    }
+
+    RamSizeCheck* clone() const override {
+        return new RamSizeCheck(std::unique_ptr<RamRelationReference>(relationRef->clone()), size);
+    }
+
+    void apply(const RamNodeMapper& map) override {
+        relationRef = map(std::move(relationRef));
+    }
+
+protected:
+    /** Relation */
+    std::unique_ptr<RamRelationReference> relationRef;
+
+    /** Number of tuples */
+    const size_t size;
+
+    bool equal(const RamNode& node) const override {
+        assert(nullptr != dynamic_cast<const RamSizeCheck*>(&node));
+        const auto& other = static_cast<const RamSizeCheck&>(node);
+        return getRelation() == other.getRelation() && size == other.size;
+    }
+};
+
 /**
  * @brief Convert terms of a conjunction to a list
  * @param A RAM condition
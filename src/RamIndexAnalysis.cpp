@@ -20,11 +20,14 @@
 #include "RamOperation.h"
 #include "RamTranslationUnit.h"
 #include "RamVisitor.h"
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <iterator>
 #include <queue>
+#include <utility>
+#include <vector>
 
 namespace souffle {
 
@@ -154,6 +157,7 @@ void MinIndexSelection::solve() {
             chainToOrder.back().insert(cur);
         }
 
+        coverOrderedSearches();
         return;
     }
 
@@ -203,6 +207,46 @@ void MinIndexSelection::solve() {
         }
         assert(k == search && "incorrect lexicographical order");
     }
+
+    coverOrderedSearches();
+}
+
+void MinIndexSelection::coverOrderedSearches() {
+    // searches binding fewer columns come first, such that orders are extended column by column
+    std::vector<std::pair<SearchSignature, int>> pending(orderedSearches.begin(), orderedSearches.end());
+    std::stable_sort(pending.begin(), pending.end(),
+            [](const std::pair<SearchSignature, int>& a, const std::pair<SearchSignature, int>& b) {
+                return card(a.first) < card(b.first);
+            });
+
+    for (const auto& search : pending) {
+        const SearchSignature bound = search.first;
+        const int column = search.second;
+        const size_t len = card(bound);
+        bool covered = std::any_of(orders.begin(), orders.end(),
+                [&](const LexOrder& order) { return isOrderedBy(order, bound, column); });
+
+        // an order ending with the bound columns is extended by the column; the columns
+        // following those of its searches are arbitrary
+        for (auto it = orders.begin(); !covered && it != orders.end(); ++it) {
+            SearchSignature prefix = 0;
+            for (int i : *it) {
+                prefix |= (1 << i);
+            }
+            if (it->size() == len && prefix == bound) {
+                it->push_back(column);
+                covered = true;
+            }
+        }
+        if (!covered) {
+            // add an order listing the bound columns first, which covers no other searches
+            LexOrder order;
+            insertIndex(order, bound);
+            order.push_back(column);
+            orders.push_back(order);
+            chainToOrder.push_back(Chain());
+        }
+    }
 }
 
 MinIndexSelection::Chain MinIndexSelection::getChain(
@@ -277,16 +321,35 @@ void RamIndexAnalysis::run(const RamTranslationUnit& translationUnit) {
     visitDepthFirst(*translationUnit.getProgram(), [&](const RamNode& node) {
         if (const auto* indexSearch = dynamic_cast<const RamIndexOperation*>(&node)) {
             MinIndexSelection& indexes = getIndexes(indexSearch->getRelation());
-            indexes.addSearch(getSearchSignature(indexSearch));
+            const auto* iscan = dynamic_cast<const RamIndexScan*>(indexSearch);
+            if (iscan != nullptr && iscan->hasRange()) {
+                // a range of the bounded column among the tuples matching the bound columns
+                SearchSignature bound = getSearchSignature(indexSearch);
+                indexes.addOrderedSearch(bound, iscan->getRangeColumn());
+                if (bound != 0) {
+                    indexes.addSearch(bound);
+                }
+            } else {
+                indexes.addSearch(getSearchSignature(indexSearch));
+            }
+            indexes.addLookup();
         } else if (const auto* exists = dynamic_cast<const RamExistenceCheck*>(&node)) {
             MinIndexSelection& indexes = getIndexes(exists->getRelation());
             indexes.addSearch(getSearchSignature(exists));
+            indexes.addLookup();
         } else if (const auto* provExists = dynamic_cast<const RamProvenanceExistenceCheck*>(&node)) {
             MinIndexSelection& indexes = getIndexes(provExists->getRelation());
             indexes.addSearch(getSearchSignature(provExists));
+            indexes.addLookup();
         } else if (const auto* ramRel = dynamic_cast<const RamRelation*>(&node)) {
             MinIndexSelection& indexes = getIndexes(*ramRel);
             indexes.addSearch(getSearchSignature(ramRel));
+        } else if (const auto* intersect = dynamic_cast<const RamIntersect*>(&node)) {
+            for (size_t i = 0; i < intersect->getNumParticipants(); i++) {
+                MinIndexSelection& indexes = getIndexes(intersect->getRelation(i));
+                indexes.addOrderedSearch(getSearchSignature(intersect, i), intersect->getColumn(i));
+                indexes.addLookup();
+            }
         }
     });
 
@@ -312,6 +375,20 @@ void RamIndexAnalysis::run(const RamTranslationUnit& translationUnit) {
         for (const auto& signature : indexesB.getSearches()) {
             indexesA.addSearch(signature);
         }
+
+        // and likewise the ordered searches
+        for (const auto& search : indexesA.getOrderedSearches()) {
+            indexesB.addOrderedSearch(search.first, search.second);
+        }
+        for (const auto& search : indexesB.getOrderedSearches()) {
+            indexesA.addOrderedSearch(search.first, search.second);
+        }
+
+        // and whether either is looked up
+        if (!indexesA.isScannedOnly() || !indexesB.isScannedOnly()) {
+            indexesA.addLookup();
+            indexesB.addLookup();
+        }
     });
 
     // find optimal indexes for relations
@@ -362,14 +439,33 @@ void RamIndexAnalysis::print(std::ostream& os) const {
             os << "\n";
         }
 
+        /* print ordered searches of intersections, the searched column following the bound ones */
+        if (!indexes.getOrderedSearches().empty()) {
+            os << "\tNumber of Ordered Search Patterns: " << indexes.getOrderedSearches().size() << "\n";
+            for (auto& search : indexes.getOrderedSearches()) {
+                os << "\t\t";
+                for (uint32_t i = 0; i < rel.getArity(); i++) {
+                    if ((1UL << i) & search.first) {
+                        os << rel.getArg(i) << " ";
+                    }
+                }
+                os << "< " << rel.getArg(search.second) << "\n";
+            }
+        }
+
+        /* print indexes, each of which stores a full copy of every tuple; the sizes only count the
+           values of the tuples, not the nodes or buckets of the data structures holding them */
+        const size_t tupleSize = rel.getArity() * sizeof(RamDomain);
         os << "\tNumber of Indexes: " << indexes.getAllOrders().size() << "\n";
         for (auto& order : indexes.getAllOrders()) {
             os << "\t\t";
             for (auto& i : order) {
                 os << rel.getArg(i) << " ";
             }
-            os << "\n";
+            os << "(at least " << tupleSize << " bytes per tuple)\n";
         }
+        os << "\tEstimated Size: at least " << indexes.getAllOrders().size() * tupleSize
+           << " bytes per tuple\n";
     }
     os << "------ End of Auto-Index-Generation Report -------\n";
 }
@@ -409,6 +505,17 @@ SearchSignature RamIndexAnalysis::getSearchSignature(const RamExistenceCheck* ex
     return res;
 }
 
+SearchSignature RamIndexAnalysis::getSearchSignature(const RamIntersect* intersect, size_t i) const {
+    SearchSignature keys = 0;
+    std::vector<RamExpression*> rangePattern = intersect->getRangePattern(i);
+    for (int j = 0; j < (int)rangePattern.size(); j++) {
+        if (!isRamUndefValue(rangePattern[j])) {
+            keys |= (1 << j);
+        }
+    }
+    return keys;
+}
+
 SearchSignature RamIndexAnalysis::getSearchSignature(const RamRelation* ramRel) const {
     SearchSignature res = (1 << ramRel->getArity()) - 1;
     return res;
@@ -156,6 +156,7 @@ public:
     using Chain = std::set<SearchSignature>;
     using ChainOrderMap = std::vector<Chain>;
     using SearchSet = std::set<SearchSignature>;
+    using OrderedSearchSet = std::set<std::pair<SearchSignature, int>>;
 
     MinIndexSelection() = default;
     ~MinIndexSelection() = default;
@@ -172,6 +173,37 @@ public:
         return searches;
     }
 
+    /** @Brief Add a search for the values of a column among the tuples matching the bound columns */
+    inline void addOrderedSearch(SearchSignature bound, int column) {
+        orderedSearches.insert(std::make_pair(bound, column));
+    }
+
+    /** @Brief Get ordered searches **/
+    const OrderedSearchSet& getOrderedSearches() const {
+        return orderedSearches;
+    }
+
+    /** @Brief Record a lookup of tuples by their values, as opposed to scanning all tuples */
+    inline void addLookup() {
+        lookedUp = true;
+    }
+
+    /** @Brief Check whether the tuples are only scanned in full, such that any order of them serves */
+    bool isScannedOnly() const {
+        return !lookedUp;
+    }
+
+    /** @Brief Get index for an ordered search, listing the bound columns first and the column next */
+    const int getOrderedLexOrderNum(SearchSignature bound, int column) const {
+        for (size_t i = 0; i < orders.size(); i++) {
+            if (isOrderedBy(orders[i], bound, column)) {
+                return i;
+            }
+        }
+        std::cerr << "Cannot find lexicographical order for ordered search" << std::endl;
+        abort();
+    }
+
     /** @Brief Get index for a search */
     const LexOrder getLexOrder(SearchSignature cols) const {
         int idx = map(cols);
@@ -238,6 +270,12 @@ protected:
     ChainOrderMap chainToOrder;  // maps order index to set of searches covered by chain
     MaxMatching matching;        // matching problem for finding minimal number of orders
 
+    /** searches for the values of a column among the tuples matching a set of bound columns */
+    OrderedSearchSet orderedSearches;
+
+    /** whether tuples are looked up; the total search of each relation is added regardless */
+    bool lookedUp = false;
+
     /** @Brief count the number of bits in key */
     static size_t card(SearchSignature cols) {
         size_t sz = 0, idx = 1;
@@ -285,6 +323,22 @@ protected:
         }
     }
 
+    /** @Brief determine whether an order lists the bound columns first, followed by the column */
+    static bool isOrderedBy(const LexOrder& order, SearchSignature bound, int column) {
+        size_t len = card(bound);
+        if (order.size() <= len || order[len] != column) {
+            return false;
+        }
+        SearchSignature prefix = 0;
+        for (size_t i = 0; i < len; i++) {
+            prefix |= (1 << order[i]);
+        }
+        return prefix == bound;
+    }
+
+    /** @Brief extend or add orders such that every ordered search is covered */
+    void coverOrderedSearches();
+
     /** @Brief get a chain from a matching
      *  @param Starting node of a chain
      *  @param Matching
@@ -359,6 +413,13 @@ public:
      */
     SearchSignature getSearchSignature(const RamProvenanceExistenceCheck* existCheck) const;
 
+    /**
+     * @Brief Get the signature of the bound columns of a participant of an intersection
+     * @param Intersection and the position of the participant
+     * @result index signature of the bound columns, to be ordered before the searched column
+     */
+    SearchSignature getSearchSignature(const RamIntersect* intersect, size_t i) const;
+
     /**
      * @Brief Get the default index signature for a relation (the total-order index)
      * @param RamCreate node
@@ -0,0 +1,121 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamInsertBufferAnalysis.cpp
+ *
+ * Implementation of the selection of the projections buffered per thread
+ *
+ ***********************************************************************/
+
+#include "RamInsertBufferAnalysis.h"
+#include "Global.h"
+#include "RamCondition.h"
+#include "RamOperation.h"
+#include "RamProgram.h"
+#include "RamRelation.h"
+#include "RamStatement.h"
+#include "RamTranslationUnit.h"
+#include "RamVisitor.h"
+#include "RelationRepresentation.h"
+#include "profile/ProgramRun.h"
+#include "profile/Reader.h"
+#include "profile/Relation.h"
+#include <map>
+#include <memory>
+#include <string>
+
+namespace souffle {
+
+constexpr size_t RamInsertBufferAnalysis::OUTPUT_LIMIT;
+
+void RamInsertBufferAnalysis::run(const RamTranslationUnit& translationUnit) {
+    buffered.clear();
+    if (!Global::config().has("insert-buffers") || Global::config().has("provenance")) {
+        return;
+    }
+    const bool all = Global::config().has("insert-buffers", "all");
+
+    auto run = std::make_shared<profile::ProgramRun>(profile::ProgramRun());
+    if (!all && Global::config().has("profile-use")) {
+        profile::Reader(Global::config().get("profile-use"), run).processFile();
+    }
+
+    // the expected output of a projection, the tuples gained per iteration for new knowledge
+    auto isSmallOutput = [&](const RamRelation& rel) {
+        const std::string prefix = "@new_";
+        const std::string& name = rel.getName();
+        const bool recursive = name.compare(0, prefix.size(), prefix) == 0;
+        const auto* profRel = run->getRelation(recursive ? name.substr(prefix.size()) : name);
+        if (profRel == nullptr) {
+            return true;
+        }
+        const auto& iterations = profRel->getIterations();
+        size_t output = profRel->size();
+        if (recursive && !iterations.empty()) {
+            size_t total = 0;
+            for (const auto& iter : iterations) {
+                total += iter->size();
+            }
+            output = (total + iterations.size() - 1) / iterations.size();
+        }
+        return output <= OUTPUT_LIMIT;
+    };
+
+    visitDepthFirst(*translationUnit.getProgram(), [&](const RamQuery& query) {
+        bool isParallel = false;
+        visitDepthFirst(query, [&](const RamAbstractParallel&) { isParallel = true; });
+        if (!isParallel) {
+            return;
+        }
+
+        std::set<const RamRelation*> readRelations;
+        visitDepthFirst(query, [&](const RamNode& node) {
+            if (const auto* scan = dynamic_cast<const RamRelationOperation*>(&node)) {
+                readRelations.insert(&scan->getRelation());
+            } else if (const auto* exists = dynamic_cast<const RamAbstractExistenceCheck*>(&node)) {
+                readRelations.insert(&exists->getRelation());
+            } else if (const auto* emptiness = dynamic_cast<const RamEmptinessCheck*>(&node)) {
+                readRelations.insert(&emptiness->getRelation());
+            } else if (const auto* check = dynamic_cast<const RamSizeCheck*>(&node)) {
+                readRelations.insert(&check->getRelation());
+            } else if (const auto* intersect = dynamic_cast<const RamIntersect*>(&node)) {
+                for (size_t i = 0; i < intersect->getNumParticipants(); i++) {
+                    readRelations.insert(&intersect->getRelation(i));
+                }
+            }
+        });
+
+        visitDepthFirst(query, [&](const RamProject& project) {
+            const RamRelation& rel = project.getRelation();
+            if (rel.isNullary() || readRelations.count(&rel) != 0) {
+                return;
+            }
+            if (rel.getRepresentation() != RelationRepresentation::BTREE &&
+                    rel.getRepresentation() != RelationRepresentation::DEFAULT) {
+                return;
+            }
+            if (all || isSmallOutput(rel)) {
+                buffered.insert(&project);
+            }
+        });
+    });
+}
+
+void RamInsertBufferAnalysis::print(std::ostream& os) const {
+    std::map<std::string, size_t> projections;
+    for (const RamProject* project : buffered) {
+        ++projections[project->getRelation().getName()];
+    }
+    for (const auto& cur : projections) {
+        os << cur.first << ": " << cur.second << " buffered projection(s)\n";
+    }
+}
+
+}  // end of namespace souffle
@@ -0,0 +1,65 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamInsertBufferAnalysis.h
+ *
+ * Selection of the projections of parallel queries buffered per thread
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "InsertBuffer.h"
+#include "RamAnalysis.h"
+#include <cstddef>
+#include <iostream>
+#include <set>
+
+namespace souffle {
+
+class RamProject;
+
+/**
+ * @class RamInsertBufferAnalysis
+ * @brief Determines the projections whose tuples the threads of a parallel query buffer
+ *
+ * With the option insert-buffers, each thread of a parallel query collects the tuples it
+ * projects into a b-tree relation in a buffer of its own, and merges them sorted and free
+ * of duplicates into the relation when the query ends. Only relations the query does not
+ * read are buffered, as the buffered tuples are not visible before.
+ *
+ * In the mode all, every such projection is buffered. In the mode auto, the expected
+ * output of the projection, as taken from the profile given by profile-use, decides:
+ * buffers pay off where the threads insert many duplicates of comparatively few tuples,
+ * while a large output of mostly new tuples spreads the inserts over the tree, where they
+ * rarely collide, and would only spill the buffers repeatedly. Projections without
+ * profile data are buffered.
+ */
+class RamInsertBufferAnalysis : public RamAnalysis {
+public:
+    static constexpr const char* name = "insert-buffer-analysis";
+
+    /** the largest expected output of a projection buffered in the mode auto, filling a buffer */
+    static constexpr size_t OUTPUT_LIMIT = InsertBuffer::DEFAULT_CAPACITY;
+
+    void run(const RamTranslationUnit& translationUnit) override;
+
+    void print(std::ostream& os) const override;
+
+    /** Whether the threads of the enclosing parallel query buffer the tuples of a projection */
+    bool isBuffered(const RamProject& project) const {
+        return buffered.count(&project) != 0;
+    }
+
+private:
+    std::set<const RamProject*> buffered;
+};
+
+}  // end of namespace souffle
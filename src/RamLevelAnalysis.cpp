@@ -15,11 +15,18 @@
  ***********************************************************************/
 
 #include "RamLevelAnalysis.h"
+#include "RamIndexAnalysis.h"
+#include "RamTranslationUnit.h"
 #include "RamVisitor.h"
 #include <algorithm>
+#include <set>
 
 namespace souffle {
 
+void RamLevelAnalysis::run(const RamTranslationUnit& translationUnit) {
+    isa = translationUnit.getAnalysis<RamIndexAnalysis>();
+}
+
 int RamLevelAnalysis::getLevel(const RamNode* node) const {
     // visitor
     class ValueLevelVisitor : public RamVisitor<int> {
@@ -57,6 +64,21 @@ int RamLevelAnalysis::getLevel(const RamNode* node) const {
                     level = std::max(level, visit(index));
                 }
             }
+            level = std::max(level, visit(indexScan.getLowerBound()));
+            level = std::max(level, visit(indexScan.getUpperBound()));
+            return level;
+        }
+
+        // intersection
+        int visitIntersect(const RamIntersect& intersect) override {
+            int level = -1;
+            for (size_t i = 0; i < intersect.getNumParticipants(); i++) {
+                for (auto& index : intersect.getRangePattern(i)) {
+                    if (index != nullptr) {
+                        level = std::max(level, visit(index));
+                    }
+                }
+            }
             return level;
         }
 
@@ -220,6 +242,11 @@ int RamLevelAnalysis::getLevel(const RamNode* node) const {
             return -1;  // can be in the top level
         }
 
+        // size check
+        int visitSizeCheck(const RamSizeCheck& check) override {
+            return -1;  // can be in the top level
+        }
+
         // default rule
         int visitNode(const RamNode& node) override {
             assert(false && "RamNode not implemented!");
@@ -234,4 +261,70 @@ int RamLevelAnalysis::getLevel(const RamNode* node) const {
     return ValueLevelVisitor().visit(node);
 }
 
+bool RamLevelAnalysis::isRepeatedKey(
+        const RamQuery& query, const RamNode& probe, const std::vector<RamExpression*>& key) const {
+    // find the innermost loop enclosing the probe
+    const RamTupleOperation* loop = nullptr;
+    visitDepthFirst(query, [&](const RamTupleOperation& op) {
+        if (&op == &probe || (loop != nullptr && loop->getTupleId() >= op.getTupleId())) {
+            return;
+        }
+        bool encloses = false;
+        visitDepthFirst(
+                op.getOperation(), [&](const RamNode& node) { encloses = encloses || &node == &probe; });
+        if (encloses) {
+            loop = &op;
+        }
+    });
+    if (loop == nullptr) {
+        return false;
+    }
+
+    // keys not depending on the tuple of the loop are the same for all of its tuples
+    const int id = loop->getTupleId();
+    int level = -1;
+    std::set<size_t> columns;
+    for (const RamExpression* value : key) {
+        if (isRamUndefValue(value)) {
+            continue;
+        }
+        level = std::max(level, getLevel(value));
+        visitDepthFirst(*value, [&](const RamTupleElement& elem) {
+            if (elem.getTupleId() == id) {
+                columns.insert(elem.getElement());
+            }
+        });
+    }
+    if (level < id) {
+        return true;
+    }
+
+    // otherwise the loop has to enumerate its tuples ordered by the columns of the key first, where the
+    // columns bound by the search of an index scan are the same for all of its tuples
+    MinIndexSelection::LexOrder order;
+    SearchSignature bound = 0;
+    if (const auto* iscan = dynamic_cast<const RamIndexScan*>(loop)) {
+        bound = isa->getSearchSignature(iscan);
+        const MinIndexSelection& indexes = isa->getIndexes(iscan->getRelation());
+        if (iscan->hasRange()) {
+            order = indexes.getAllOrders()[indexes.getOrderedLexOrderNum(bound, iscan->getRangeColumn())];
+        } else {
+            order = indexes.getLexOrder(bound);
+        }
+    } else if (const auto* scan = dynamic_cast<const RamScan*>(loop)) {
+        auto orders = isa->getIndexes(scan->getRelation()).getAllOrders();
+        if (!orders.empty()) {
+            order = orders[0];
+        }
+    } else {
+        return false;
+    }
+    for (int column : order) {
+        if (columns.erase(column) == 0 && (bound & (SearchSignature(1) << column)) == 0) {
+            break;
+        }
+    }
+    return columns.empty();
+}
+
 }  // end of namespace souffle
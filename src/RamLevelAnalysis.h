@@ -19,10 +19,15 @@
 #pragma once
 
 #include "RamAnalysis.h"
+#include "RamExpression.h"
 #include "RamNode.h"
+#include "RamStatement.h"
+#include <vector>
 
 namespace souffle {
 
+class RamIndexAnalysis;
+
 /**
  * @class RamLevelAnalysis
  * @brief A Ram Analysis for determining the level of a expression/condition
@@ -42,12 +47,30 @@ class RamLevelAnalysis : public RamAnalysis {
 public:
     static constexpr const char* name = "level-analysis";
 
-    void run(const RamTranslationUnit& translationUnit) override {}
+    void run(const RamTranslationUnit& translationUnit) override;
 
     /**
      * @brief Get level of a RAM expression/condition
      */
     int getLevel(const RamNode* value) const;
+
+    /**
+     * @brief Determine whether consecutive probes of an index by the given key are likely to search for
+     * the same values
+     *
+     * This is the case if the key depends on the loops enclosing the innermost loop of the probe only,
+     * or otherwise on the columns of the tuple of the innermost loop forming a prefix of the order in
+     * which the loop enumerates its tuples.
+     *
+     * @param query the query of the probe
+     * @param probe the index scan or existence check probing the index
+     * @param key the values of the search, undefined for unbound columns
+     */
+    bool isRepeatedKey(
+            const RamQuery& query, const RamNode& probe, const std::vector<RamExpression*>& key) const;
+
+private:
+    RamIndexAnalysis* isa = nullptr;
 };
 
 }  // end of namespace souffle
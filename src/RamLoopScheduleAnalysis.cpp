@@ -0,0 +1,121 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamLoopScheduleAnalysis.cpp
+ *
+ * Implementation of the selection of the statements of fixpoint loops skipped while their
+ * inputs are empty
+ *
+ ***********************************************************************/
+
+#include "RamLoopScheduleAnalysis.h"
+#include "RamCondition.h"
+#include "RamOperation.h"
+#include "RamProgram.h"
+#include "RamRelation.h"
+#include "RamStatement.h"
+#include "RamTranslationUnit.h"
+#include "RamVisitor.h"
+#include "Util.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+namespace souffle {
+
+void RamLoopScheduleAnalysis::run(const RamTranslationUnit& translationUnit) {
+    guards.clear();
+
+    // collect the relations that all have to be empty for a statement to do nothing
+    std::function<bool(const RamStatement&, std::vector<const RamRelation*>&)> collect;
+    collect = [&](const RamStatement& stmt, std::vector<const RamRelation*>& guard) {
+        auto add = [&](const RamRelation& rel) {
+            if (std::find(guard.begin(), guard.end(), &rel) == guard.end()) {
+                guard.push_back(&rel);
+            }
+        };
+        if (const auto* query = dynamic_cast<const RamQuery*>(&stmt)) {
+            const auto* filter = dynamic_cast<const RamFilter*>(&query->getOperation());
+            if (filter == nullptr) {
+                return false;
+            }
+            const RamRelation* required = nullptr;
+            for (const auto& cur : toConjunctionList(&filter->getCondition())) {
+                const auto* neg = dynamic_cast<const RamNegation*>(cur.get());
+                const auto* emptiness =
+                        neg != nullptr ? dynamic_cast<const RamEmptinessCheck*>(&neg->getOperand()) : nullptr;
+                if (emptiness != nullptr && (required == nullptr || !required->isTemp())) {
+                    required = &emptiness->getRelation();
+                }
+            }
+            if (required == nullptr) {
+                return false;
+            }
+            add(*required);
+            return true;
+        }
+        if (const auto* dbg = dynamic_cast<const RamDebugInfo*>(&stmt)) {
+            return collect(dbg->getStatement(), guard);
+        }
+        if (const auto* list = dynamic_cast<const RamListStatement*>(&stmt)) {
+            for (const RamStatement* cur : list->getStatements()) {
+                if (!collect(*cur, guard)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        if (const auto* merge = dynamic_cast<const RamMerge*>(&stmt)) {
+            add(merge->getSourceRelation());
+            return true;
+        }
+        if (const auto* swap = dynamic_cast<const RamSwap*>(&stmt)) {
+            add(swap->getFirstRelation());
+            add(swap->getSecondRelation());
+            return true;
+        }
+        if (const auto* clear = dynamic_cast<const RamClear*>(&stmt)) {
+            add(clear->getRelation());
+            return true;
+        }
+        return false;
+    };
+
+    // the groups of a loop body are the lists within its lists
+    visitDepthFirst(*translationUnit.getProgram(), [&](const RamLoop& loop) {
+        const auto* body = dynamic_cast<const RamListStatement*>(&loop.getBody());
+        if (body == nullptr) {
+            return;
+        }
+        for (const RamStatement* part : body->getStatements()) {
+            const auto* list = dynamic_cast<const RamListStatement*>(part);
+            if (list == nullptr) {
+                continue;
+            }
+            for (const RamStatement* group : list->getStatements()) {
+                std::vector<const RamRelation*> guard;
+                if (dynamic_cast<const RamListStatement*>(group) != nullptr && collect(*group, guard) &&
+                        !guard.empty()) {
+                    guards[group] = guard;
+                }
+            }
+        }
+    });
+}
+
+void RamLoopScheduleAnalysis::print(std::ostream& os) const {
+    for (const auto& cur : guards) {
+        os << "skipped while empty: "
+           << join(cur.second, ", ", [](std::ostream& out, const RamRelation* rel) { out << rel->getName(); })
+           << "\n";
+    }
+}
+
+}  // end of namespace souffle
@@ -0,0 +1,65 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamLoopScheduleAnalysis.h
+ *
+ * Selection of the statements of fixpoint loops skipped while their inputs are empty
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamAnalysis.h"
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace souffle {
+
+class RamRelation;
+class RamStatement;
+
+/**
+ * @class RamLoopScheduleAnalysis
+ * @brief Determines the statements of loop bodies that do nothing while some relations are empty
+ *
+ * The body of a fixpoint loop evaluates the versions of the recursive rules of each
+ * relation, every version guarded by the emptiness of the delta relation it reads, and
+ * updates the relations by merging, swapping and clearing their new and delta relations.
+ * In a stratum of many relations most deltas may stay empty for many iterations, while
+ * all versions are still entered in each iteration only to find their guard false.
+ *
+ * The guard of a group of such statements is a list of relations: as long as all of
+ * them are empty, every statement of the group does nothing, and the group is skipped
+ * as a whole. A query is guarded by a relation its outer filter requires to be non-empty,
+ * a delta relation where there is one, a merge by its source, a swap by both relations
+ * and a clear by its relation. Groups are the lists of statements within the lists
+ * forming a loop body, i.e., the rule versions and the updates of each relation.
+ */
+class RamLoopScheduleAnalysis : public RamAnalysis {
+public:
+    static constexpr const char* name = "loop-schedule-analysis";
+
+    void run(const RamTranslationUnit& translationUnit) override;
+
+    void print(std::ostream& os) const override;
+
+    /** The relations whose emptiness lets a statement be skipped, none where it is always executed */
+    const std::vector<const RamRelation*>& getGuard(const RamStatement& stmt) const {
+        static const std::vector<const RamRelation*> none;
+        auto pos = guards.find(&stmt);
+        return (pos != guards.end()) ? pos->second : none;
+    }
+
+private:
+    std::map<const RamStatement*, std::vector<const RamRelation*>> guards;
+};
+
+}  // end of namespace souffle
@@ -0,0 +1,309 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamMpiScheduleAnalysis.cpp
+ *
+ * Implementation of the assignment of strata to the processes of the mpi engine
+ *
+ ***********************************************************************/
+
+#include "RamMpiScheduleAnalysis.h"
+#include "Global.h"
+#include "RamProgram.h"
+#include "RamStatement.h"
+#include "RamTranslationUnit.h"
+#include "RamTypes.h"
+#include "RamVisitor.h"
+#include "profile/ProgramRun.h"
+#include "profile/Reader.h"
+#include "profile/Relation.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace souffle {
+
+constexpr double MpiScheduler::INTRA_NODE_COST;
+constexpr double MpiScheduler::INTER_NODE_COST;
+
+MpiScheduler::MpiScheduler(const std::vector<double>& costs, const std::vector<Transfer>& transfers,
+        const std::vector<size_t>& capacities, const std::vector<bool>& exclusive)
+        : nodeCapacities(capacities), ranks(costs.size(), 0) {
+    if (nodeCapacities.empty()) {
+        nodeCapacities.push_back(1);
+    }
+    size_t slots = 0;
+    for (size_t capacity : nodeCapacities) {
+        slots += capacity;
+    }
+    size_t remainingExclusive = std::count(exclusive.begin(), exclusive.end(), true);
+    bool hasShared = remainingExclusive < costs.size();
+
+    // the ranks available to the strata, at least one per exclusive stratum plus one for the others
+    const size_t workers =
+            std::max<size_t>((slots > 0) ? slots - 1 : 0, remainingExclusive + (hasShared ? 1 : 0));
+
+    std::vector<std::vector<const Transfer*>> incoming(costs.size());
+    for (const auto& transfer : transfers) {
+        if (transfer.source < transfer.destination && transfer.destination < costs.size()) {
+            incoming[transfer.destination].push_back(&transfer);
+        }
+    }
+
+    std::vector<double> finish(costs.size(), 0);
+    std::vector<double> rankFree(workers + 1, 0);
+    std::vector<double> nodeLoad(nodeCapacities.size(), 0);
+    std::vector<bool> used(workers + 1, false);
+    std::vector<bool> closed(workers + 1, false);
+    size_t unused = workers;
+
+    for (size_t stratum = 0; stratum < costs.size(); ++stratum) {
+        const bool isExclusive = stratum < exclusive.size() && exclusive[stratum];
+        if (isExclusive) {
+            --remainingExclusive;
+        }
+        int best = -1;
+        double bestFinish = 0;
+        double bestLoad = 0;
+        for (size_t rank = 1; rank <= workers; ++rank) {
+            if (closed[rank] || (isExclusive && used[rank])) {
+                continue;
+            }
+            // keep a fresh rank for each of the exclusive strata still to come
+            if (!isExclusive && !used[rank] && unused <= remainingExclusive) {
+                continue;
+            }
+            double start = rankFree[rank];
+            for (const Transfer* transfer : incoming[stratum]) {
+                const int source = ranks[transfer->source];
+                double cost = 0;
+                if (source != (int)rank) {
+                    cost = transfer->bytes *
+                           ((getNode(source) == getNode(rank)) ? INTRA_NODE_COST : INTER_NODE_COST);
+                }
+                start = std::max(start, finish[transfer->source] + cost);
+            }
+            const double end = start + costs[stratum];
+            const double load = nodeLoad[getNode(rank)];
+            const double epsilon = 1e-9 * std::max(1.0, std::abs(end));
+            if (best < 0 || end < bestFinish - epsilon ||
+                    (end <= bestFinish + epsilon && load < bestLoad)) {
+                best = rank;
+                bestFinish = end;
+                bestLoad = load;
+            }
+        }
+        assert(best > 0 && "no rank available for stratum");
+        ranks[stratum] = best;
+        finish[stratum] = bestFinish;
+        rankFree[best] = bestFinish;
+        nodeLoad[getNode(best)] += costs[stratum];
+        if (!used[best]) {
+            used[best] = true;
+            --unused;
+        }
+        closed[best] = isExclusive;
+        makespan = std::max(makespan, bestFinish);
+        numberOfRanks = std::max(numberOfRanks, best + 1);
+    }
+}
+
+size_t MpiScheduler::getNode(int rank) const {
+    size_t slots = 0;
+    for (size_t node = 0; node < nodeCapacities.size(); ++node) {
+        slots += nodeCapacities[node];
+        if ((size_t)rank < slots) {
+            return node;
+        }
+    }
+    return nodeCapacities.size() - 1;
+}
+
+std::vector<size_t> parseHostfile(std::istream& in) {
+    std::vector<size_t> capacities;
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream tokens(line);
+        std::string host;
+        if (!(tokens >> host)) {
+            continue;
+        }
+        size_t slots = 1;
+        auto colon = host.find(':');
+        if (colon != std::string::npos) {
+            slots = std::stoul(host.substr(colon + 1));
+        }
+        std::string setting;
+        while (tokens >> setting) {
+            if (setting.compare(0, 6, "slots=") == 0) {
+                slots = std::stoul(setting.substr(6));
+            }
+        }
+        capacities.push_back(slots);
+    }
+    return capacities;
+}
+
+void RamMpiScheduleAnalysis::run(const RamTranslationUnit& translationUnit) {
+#ifdef USE_MPI
+    if (Global::config().get("engine") != "mpi") {
+        return;
+    }
+    const RamStatement& main = *translationUnit.getProgram()->getMain();
+
+    // the strata of the program with the relations they compute and send
+    std::vector<const RamStratum*> strata;
+    visitDepthFirst(main, [&](const RamStratum& stratum) {
+        if (stratum.getIndex() != std::numeric_limits<int>::max()) {
+            if (strata.size() <= (size_t)stratum.getIndex()) {
+                strata.resize(stratum.getIndex() + 1, nullptr);
+            }
+            strata[stratum.getIndex()] = &stratum;
+        }
+    });
+    std::vector<bool> exclusive(strata.size(), false);
+    for (size_t i = 0; i < strata.size(); ++i) {
+        if (strata[i] != nullptr) {
+            visitDepthFirst(*strata[i], [&](const RamExchange&) { exclusive[i] = true; });
+        }
+    }
+
+    auto run = std::make_shared<profile::ProgramRun>(profile::ProgramRun());
+    if (Global::config().has("profile-use")) {
+        profile::Reader(Global::config().get("profile-use"), run).processFile();
+    }
+
+    std::vector<double> costs(strata.size(), 0);
+    std::vector<MpiScheduler::Transfer> transfers;
+    for (size_t i = 0; i < strata.size(); ++i) {
+        if (strata[i] == nullptr) {
+            continue;
+        }
+        // the relations of a stratum are those it creates, apart from auxiliary and received ones
+        std::set<std::string> received;
+        visitDepthFirst(
+                *strata[i], [&](const RamRecv& recv) { received.insert(recv.getRelation().getName()); });
+        visitDepthFirst(*strata[i], [&](const RamCreate& create) {
+            const std::string& name = create.getRelation().getName();
+            if (name[0] == '@' || received.count(name) != 0) {
+                return;
+            }
+            const auto* relation = run->getRelation(name);
+            costs[i] += (relation != nullptr) ? (relation->getNonRecTime() + relation->getRecTime() +
+                                                        relation->getCopyTime())
+                                                        .count()
+                                              : 0;
+        });
+        // strata without profile data count as cheap rather than free
+        costs[i] = std::max(costs[i], 1.0);
+
+        visitDepthFirst(*strata[i], [&](const RamSend& send) {
+            const auto* relation = run->getRelation(send.getRelation().getName());
+            const double size = (relation != nullptr) ? relation->size() : 1;
+            for (size_t destination : send.getDestinationStrata()) {
+                if (destination != (size_t)-1) {
+                    transfers.push_back(MpiScheduler::Transfer{
+                            i, destination, size * send.getRelation().getArity() * sizeof(RamDomain)});
+                }
+            }
+        });
+    }
+
+    ranks.assign(strata.size(), 0);
+    if (!Global::config().has("hostfile")) {
+        for (size_t i = 0; i < strata.size(); ++i) {
+            ranks[i] = i + 1;
+        }
+    } else {
+        const std::string& hostfile = Global::config().get("hostfile");
+        std::ifstream in(hostfile);
+        if (!in) {
+            throw std::invalid_argument("Error: Cannot open hostfile " + hostfile);
+        }
+        std::vector<size_t> capacities = parseHostfile(in);
+
+        MpiScheduler scheduler(costs, transfers, capacities, exclusive);
+        for (size_t i = 0; i < strata.size(); ++i) {
+            ranks[i] = scheduler.getRank(i);
+        }
+    }
+
+    // the strata of each rank in the order of evaluation, i.e. by their index
+    int numberOfRanks = 1;
+    for (int rank : ranks) {
+        numberOfRanks = std::max(numberOfRanks, rank + 1);
+    }
+    strataOfRanks.assign(numberOfRanks, std::vector<int>());
+    strataOfRanks[0].push_back(std::numeric_limits<int>::max());
+    for (size_t i = 0; i < strata.size(); ++i) {
+        if (strata[i] != nullptr) {
+            strataOfRanks[ranks[i]].push_back(i);
+            packed = packed || strataOfRanks[ranks[i]].size() > 1;
+        }
+    }
+
+    partitionStrata.clear();
+    for (size_t i = 0; i < strata.size(); ++i) {
+        if (exclusive[i]) {
+            for (int j = 1; j < std::stoi(Global::config().get("mpi-partitions")); ++j) {
+                partitionStrata.push_back(i);
+            }
+        }
+    }
+
+    // the ranks of a partitioned stratum share its cost
+    rankCosts.assign(getNumberOfProcesses(), 0);
+    const auto& config = Global::config();
+    const int partitions =
+            std::max(1, config.has("mpi-partitions") ? std::stoi(config.get("mpi-partitions")) : 1);
+    for (size_t i = 0; i < strata.size(); ++i) {
+        if (strata[i] != nullptr) {
+            rankCosts[ranks[i]] += exclusive[i] ? costs[i] / partitions : costs[i];
+        }
+    }
+    for (size_t i = 0; i < partitionStrata.size(); ++i) {
+        rankCosts[strataOfRanks.size() + i] = costs[partitionStrata[i]] / partitions;
+    }
+#endif
+}
+
+void RamMpiScheduleAnalysis::print(std::ostream& os) const {
+    for (size_t rank = 0; rank < strataOfRanks.size(); ++rank) {
+        os << "rank " << rank << ":";
+        for (int stratum : strataOfRanks[rank]) {
+            if (stratum == std::numeric_limits<int>::max()) {
+                os << " master";
+            } else {
+                os << " " << stratum;
+            }
+        }
+        os << "\n";
+    }
+    for (size_t i = 0; i < partitionStrata.size(); ++i) {
+        os << "rank " << strataOfRanks.size() + i << ": " << partitionStrata[i] << " (partition)\n";
+    }
+}
+
+int RamMpiScheduleAnalysis::getRank(int stratum) const {
+    if (stratum < 0 || stratum == std::numeric_limits<int>::max()) {
+        return 0;
+    }
+    return ranks[stratum];
+}
+
+}  // end of namespace souffle
@@ -0,0 +1,154 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamMpiScheduleAnalysis.h
+ *
+ * Assignment of the strata of a program to the processes of the mpi engine
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamAnalysis.h"
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * @class MpiScheduler
+ * @brief Packs strata onto ranks distributed over the nodes of a cluster
+ *
+ * Rank 0 is the master process on the first node. The further ranks are placed on
+ * the nodes in the order of their capacities, as mpiexec fills the slots of a
+ * hostfile. The strata are visited in the topological order of their indices and
+ * each is assigned to the rank where it finishes first, estimated from the cost of
+ * the strata, the time the preceding strata finish and the time to transfer their
+ * relations. Transfers within a node are cheaper than between nodes and transfers
+ * within a rank are free. Among ranks finishing at the same time the one on the
+ * node with the least cost assigned so far is preferred, which keeps independent
+ * expensive strata on separate nodes.
+ *
+ * Exclusive strata, i.e. the partitioned ones, are assigned a rank of their own.
+ */
+class MpiScheduler {
+public:
+    /** the relations sent from one stratum to another */
+    struct Transfer {
+        size_t source;
+        size_t destination;
+        double bytes;
+    };
+
+    /** the estimated cost of transferring a byte between ranks of the same node and of different nodes */
+    static constexpr double INTRA_NODE_COST = 1e-4;
+    static constexpr double INTER_NODE_COST = 1e-3;
+
+    /**
+     * Schedule strata of the given costs onto the slots of the given nodes, where the
+     * master process takes the first slot. If there are fewer slots than required,
+     * additional ranks are placed on the last node.
+     */
+    MpiScheduler(const std::vector<double>& costs, const std::vector<Transfer>& transfers,
+            const std::vector<size_t>& nodeCapacities, const std::vector<bool>& exclusive);
+
+    /** Get the rank evaluating a stratum */
+    int getRank(size_t stratum) const {
+        return ranks[stratum];
+    }
+
+    /** Get the number of ranks, including the master process and ranks without strata */
+    int getNumberOfRanks() const {
+        return numberOfRanks;
+    }
+
+    /** Get the node of a rank */
+    size_t getNode(int rank) const;
+
+    /** Get the estimated time all strata finish */
+    double getMakespan() const {
+        return makespan;
+    }
+
+private:
+    std::vector<size_t> nodeCapacities;
+    std::vector<int> ranks;
+    int numberOfRanks = 1;
+    double makespan = 0;
+};
+
+/**
+ * Parse the node capacities of a hostfile: each line names a host followed by
+ * optional settings, where the number of slots is given as slots=N or as in
+ * host:N, and defaults to one. Comments start with #.
+ */
+std::vector<size_t> parseHostfile(std::istream& in);
+
+/**
+ * @class RamMpiScheduleAnalysis
+ * @brief Determines the ranks evaluating the strata of the program with the mpi engine
+ *
+ * Without a hostfile each stratum has a rank of its own, rank s + 1 for stratum s.
+ * With a hostfile the strata are packed onto its slots by the MpiScheduler, costs
+ * and sizes of the transferred relations being taken from the profile given by
+ * --profile-use, or being uniform otherwise. The additional ranks of partitioned
+ * strata follow the ranks of the schedule. The same costs apportion the threads of
+ * a node to the ranks placed on it.
+ */
+class RamMpiScheduleAnalysis : public RamAnalysis {
+public:
+    static constexpr const char* name = "mpi-schedule-analysis";
+
+    void run(const RamTranslationUnit& translationUnit) override;
+
+    void print(std::ostream& os) const override;
+
+    /** Get the rank owning a stratum, where the master process of index -1 or of the max int is rank 0 */
+    int getRank(int stratum) const;
+
+    /** Get the strata evaluated by each rank, the master process being rank 0 */
+    const std::vector<std::vector<int>>& getStrataOfRanks() const {
+        return strataOfRanks;
+    }
+
+    /** Get the strata of the additional ranks of partitioned strata, which follow the scheduled ranks */
+    const std::vector<int>& getPartitionStrata() const {
+        return partitionStrata;
+    }
+
+    /** Get the number of ranks to run the program on */
+    int getNumberOfProcesses() const {
+        return strataOfRanks.size() + partitionStrata.size();
+    }
+
+    /** Whether ranks evaluate several strata */
+    bool isPacked() const {
+        return packed;
+    }
+
+    /**
+     * Get the estimated cost of the strata of each rank, including the additional ranks of partitioned
+     * strata, by which the threads of a node are shared among its ranks
+     */
+    const std::vector<double>& getRankCosts() const {
+        return rankCosts;
+    }
+
+private:
+    std::vector<int> ranks;
+    std::vector<double> rankCosts;
+    std::vector<std::vector<int>> strataOfRanks;
+    std::vector<int> partitionStrata;
+    bool packed = false;
+};
+
+}  // end of namespace souffle
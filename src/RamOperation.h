@@ -27,6 +27,7 @@
 #include <iosfwd>
 #include <memory>
 #include <string>
+#include <typeinfo>
 #include <vector>
 
 namespace souffle {
@@ -319,11 +320,17 @@ protected:
  * @class RamIndexScan
  * @brief Search for tuples of a relation matching a criteria
  *
+ * Besides the values of the bound columns, the search may bound the values of
+ * one further column from below and above, such that the tuples are taken from
+ * the range of an index listing the bound columns first and that column next.
+ * The bounds are inclusive and may be left undefined; the conditions they stem
+ * from are still checked for every tuple.
+ *
  * For example:
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
  *  QUERY
  *   ...
- *	 FOR t1 IN X ON INDEX t1.c = t0.0
+ *	 FOR t1 IN X ON INDEX t1.c = t0.0 AND t1.d IN [t0.1, ⊥]
  *	 ...
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
@@ -332,15 +339,61 @@ public:
     RamIndexScan(std::unique_ptr<RamRelationReference> r, int ident,
             std::vector<std::unique_ptr<RamExpression>> queryPattern, std::unique_ptr<RamOperation> nested,
             std::string profileText = "")
-            : RamIndexOperation(std::move(r), ident, std::move(queryPattern), std::move(nested),
+            : RamIndexScan(std::move(r), ident, std::move(queryPattern), -1,
+                      std::make_unique<RamUndefValue>(), std::make_unique<RamUndefValue>(), std::move(nested),
                       std::move(profileText)) {}
 
+    RamIndexScan(std::unique_ptr<RamRelationReference> r, int ident,
+            std::vector<std::unique_ptr<RamExpression>> queryPattern, int rangeColumn,
+            std::unique_ptr<RamExpression> lower, std::unique_ptr<RamExpression> upper,
+            std::unique_ptr<RamOperation> nested, std::string profileText = "")
+            : RamIndexOperation(std::move(r), ident, std::move(queryPattern), std::move(nested),
+                      std::move(profileText)),
+              rangeColumn(rangeColumn), lower(std::move(lower)), upper(std::move(upper)) {
+        assert(this->lower != nullptr && this->upper != nullptr);
+        assert(rangeColumn < (int)getRelation().getArity());
+    }
+
+    /** @brief Check whether the values of a column are bounded */
+    bool hasRange() const {
+        return rangeColumn >= 0;
+    }
+
+    /** @brief Get the bounded column, -1 if there is none */
+    int getRangeColumn() const {
+        return rangeColumn;
+    }
+
+    /** @brief Get the least value of the bounded column, undefined if unbounded from below */
+    const RamExpression& getLowerBound() const {
+        return *lower;
+    }
+
+    /** @brief Get the greatest value of the bounded column, undefined if unbounded from above */
+    const RamExpression& getUpperBound() const {
+        return *upper;
+    }
+
+    std::vector<const RamNode*> getChildNodes() const override {
+        auto res = RamIndexOperation::getChildNodes();
+        res.push_back(lower.get());
+        res.push_back(upper.get());
+        return res;
+    }
+
+    void apply(const RamNodeMapper& map) override {
+        RamIndexOperation::apply(map);
+        lower = map(std::move(lower));
+        upper = map(std::move(upper));
+    }
+
     void print(std::ostream& os, int tabpos) const override {
         const RamRelation& rel = getRelation();
         os << times(" ", tabpos);
         os << "FOR t" << getTupleId() << " IN ";
         os << rel.getName();
         printIndex(os);
+        printRange(os);
         os << std::endl;
         RamIndexOperation::print(os, tabpos + 1);
     }
@@ -351,8 +404,40 @@ public:
             resQueryPattern[i] = std::unique_ptr<RamExpression>(queryPattern[i]->clone());
         }
         return new RamIndexScan(std::unique_ptr<RamRelationReference>(relationRef->clone()), getTupleId(),
-                std::move(resQueryPattern), std::unique_ptr<RamOperation>(getOperation().clone()),
-                getProfileText());
+                std::move(resQueryPattern), rangeColumn, std::unique_ptr<RamExpression>(lower->clone()),
+                std::unique_ptr<RamExpression>(upper->clone()),
+                std::unique_ptr<RamOperation>(getOperation().clone()), getProfileText());
+    }
+
+protected:
+    /** Column whose values are bounded, -1 if there is none */
+    int rangeColumn;
+
+    /** Least value of the bounded column */
+    std::unique_ptr<RamExpression> lower;
+
+    /** Greatest value of the bounded column */
+    std::unique_ptr<RamExpression> upper;
+
+    /** @brief Helper method for printing the range of the bounded column */
+    void printRange(std::ostream& os) const {
+        if (!hasRange()) {
+            return;
+        }
+        bool bound = false;
+        for (const auto& cur : queryPattern) {
+            bound = bound || !isRamUndefValue(cur.get());
+        }
+        os << (bound ? " AND " : " ON INDEX ");
+        os << "t" << getTupleId() << "." << getRelation().getArg(rangeColumn) << " IN [" << *lower << ", "
+           << *upper << "]";
+    }
+
+    bool equal(const RamNode& node) const override {
+        assert(nullptr != dynamic_cast<const RamIndexScan*>(&node));
+        const auto& other = static_cast<const RamIndexScan&>(node);
+        return RamIndexOperation::equal(other) && rangeColumn == other.rangeColumn &&
+               *lower == *other.lower && *upper == *other.upper;
     }
 };
 
@@ -375,12 +460,20 @@ public:
             std::string profileText = "")
             : RamIndexScan(std::move(rel), ident, std::move(queryPattern), std::move(nested), profileText) {}
 
+    RamParallelIndexScan(std::unique_ptr<RamRelationReference> rel, int ident,
+            std::vector<std::unique_ptr<RamExpression>> queryPattern, int rangeColumn,
+            std::unique_ptr<RamExpression> lower, std::unique_ptr<RamExpression> upper,
+            std::unique_ptr<RamOperation> nested, std::string profileText = "")
+            : RamIndexScan(std::move(rel), ident, std::move(queryPattern), rangeColumn, std::move(lower),
+                      std::move(upper), std::move(nested), profileText) {}
+
     void print(std::ostream& os, int tabpos) const override {
         const RamRelation& rel = getRelation();
         os << times(" ", tabpos);
         os << "PARALLEL FOR t" << getTupleId() << " IN ";
         os << rel.getName();
         printIndex(os);
+        printRange(os);
         os << std::endl;
         RamIndexOperation::print(os, tabpos + 1);
     }
@@ -391,11 +484,147 @@ public:
             resQueryPattern[i] = std::unique_ptr<RamExpression>(queryPattern[i]->clone());
         }
         return new RamParallelIndexScan(std::unique_ptr<RamRelationReference>(relationRef->clone()),
-                getTupleId(), std::move(resQueryPattern),
+                getTupleId(), std::move(resQueryPattern), rangeColumn,
+                std::unique_ptr<RamExpression>(lower->clone()),
+                std::unique_ptr<RamExpression>(upper->clone()),
                 std::unique_ptr<RamOperation>(getOperation().clone()), getProfileText());
     }
 };
 
+/**
+ * @class RamIntersect
+ * @brief Iterate the values common to a column of several relations
+ *
+ * A step of a multi-way (leapfrog triejoin) join: each participating relation
+ * is searched for the values of one of its columns among the tuples matching a
+ * pattern of already bound values, and the values shared by all participants
+ * are bound one after another, in ascending order, to element 0 of the tuple.
+ * For every participant, an index ordering the bound columns of the pattern
+ * first and the searched column next is required.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *   FOR t2.0 IN INTERSECT E.y ON INDEX E.x = t1.0, E.x ON INDEX E.y = t0.0
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class RamIntersect : public RamTupleOperation {
+public:
+    RamIntersect(int ident, std::unique_ptr<RamOperation> nested, std::string profileText = "")
+            : RamTupleOperation(ident, std::move(nested), std::move(profileText)) {}
+
+    /** @brief Add a participating relation, searched for the given column among tuples matching a pattern */
+    void add(std::unique_ptr<RamRelationReference> relRef,
+            std::vector<std::unique_ptr<RamExpression>> queryPattern, size_t column) {
+        assert(queryPattern.size() == relRef->get()->getArity() && column < queryPattern.size());
+        assert(isRamUndefValue(queryPattern[column].get()) && "searched column must not be bound");
+        relationRefs.push_back(std::move(relRef));
+        queryPatterns.push_back(std::move(queryPattern));
+        columns.push_back(column);
+    }
+
+    /** @brief Get number of participating relations */
+    size_t getNumParticipants() const {
+        return relationRefs.size();
+    }
+
+    /** @brief Get the i-th participating relation */
+    const RamRelation& getRelation(size_t i) const {
+        return *relationRefs[i]->get();
+    }
+
+    /** @brief Get the range pattern of the i-th participating relation */
+    std::vector<RamExpression*> getRangePattern(size_t i) const {
+        return toPtrVector(queryPatterns[i]);
+    }
+
+    /** @brief Get the column of the i-th participating relation providing the values */
+    size_t getColumn(size_t i) const {
+        return columns[i];
+    }
+
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos);
+        os << "FOR t" << getTupleId() << ".0 IN INTERSECT ";
+        for (size_t i = 0; i < relationRefs.size(); i++) {
+            const RamRelation& rel = getRelation(i);
+            os << (i > 0 ? ", " : "") << rel.getName() << "." << rel.getArg(columns[i]);
+            bool first = true;
+            for (size_t j = 0; j < queryPatterns[i].size(); j++) {
+                if (!isRamUndefValue(queryPatterns[i][j].get())) {
+                    os << (first ? " ON INDEX " : " AND ");
+                    os << rel.getName() << "." << rel.getArg(j) << " = " << *queryPatterns[i][j];
+                    first = false;
+                }
+            }
+        }
+        os << std::endl;
+        RamTupleOperation::print(os, tabpos + 1);
+    }
+
+    std::vector<const RamNode*> getChildNodes() const override {
+        auto res = RamTupleOperation::getChildNodes();
+        for (size_t i = 0; i < relationRefs.size(); i++) {
+            res.push_back(relationRefs[i].get());
+            for (auto& cur : queryPatterns[i]) {
+                res.push_back(cur.get());
+            }
+        }
+        return res;
+    }
+
+    void apply(const RamNodeMapper& map) override {
+        RamTupleOperation::apply(map);
+        for (size_t i = 0; i < relationRefs.size(); i++) {
+            relationRefs[i] = map(std::move(relationRefs[i]));
+            for (auto& cur : queryPatterns[i]) {
+                cur = map(std::move(cur));
+            }
+        }
+    }
+
+    RamIntersect* clone() const override {
+        auto* res = new RamIntersect(
+                getTupleId(), std::unique_ptr<RamOperation>(getOperation().clone()), getProfileText());
+        for (size_t i = 0; i < relationRefs.size(); i++) {
+            std::vector<std::unique_ptr<RamExpression>> pattern;
+            for (auto& cur : queryPatterns[i]) {
+                pattern.emplace_back(cur->clone());
+            }
+            res->add(std::unique_ptr<RamRelationReference>(relationRefs[i]->clone()), std::move(pattern),
+                    columns[i]);
+        }
+        return res;
+    }
+
+protected:
+    /** Participating relations */
+    std::vector<std::unique_ptr<RamRelationReference>> relationRefs;
+
+    /** Values bound in the search of each participating relation */
+    std::vector<std::vector<std::unique_ptr<RamExpression>>> queryPatterns;
+
+    /** Column of each participating relation providing the values */
+    std::vector<size_t> columns;
+
+    bool equal(const RamNode& node) const override {
+        assert(nullptr != dynamic_cast<const RamIntersect*>(&node));
+        const auto& other = static_cast<const RamIntersect&>(node);
+        if (!RamTupleOperation::equal(other) || columns != other.columns ||
+                !equal_targets(relationRefs, other.relationRefs)) {
+            return false;
+        }
+        for (size_t i = 0; i < queryPatterns.size(); i++) {
+            if (!equal_targets(queryPatterns[i], other.queryPatterns[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
 /**
  * @class RamAbstractChoice
  * @brief Abstract class for a choice operation
@@ -1136,4 +1365,20 @@ protected:
     }
 };
 
+/**
+ * Get the loop nested into a parallel loop whose iterations may be evaluated in parallel
+ * instead, i.e. a scan or an index scan reached through filters only, or nullptr if there
+ * is none. The filters only depend on the tuple of the outer loop.
+ */
+inline const RamRelationOperation* getNestedParallelLoop(const RamTupleOperation& outer) {
+    const RamOperation* cur = &outer.getOperation();
+    while (const auto* filter = dynamic_cast<const RamFilter*>(cur)) {
+        cur = &filter->getOperation();
+    }
+    if (typeid(*cur) == typeid(RamScan) || typeid(*cur) == typeid(RamIndexScan)) {
+        return static_cast<const RamRelationOperation*>(cur);
+    }
+    return nullptr;
+}
+
 }  // namespace souffle
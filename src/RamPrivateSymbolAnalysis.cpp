@@ -0,0 +1,80 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamPrivateSymbolAnalysis.cpp
+ *
+ * Implementation of the selection of the relations with symbol tables of their own
+ *
+ ***********************************************************************/
+
+#include "RamPrivateSymbolAnalysis.h"
+#include "Global.h"
+#include "RamNode.h"
+#include "RamProgram.h"
+#include "RamRelation.h"
+#include "RamStatement.h"
+#include "RamTranslationUnit.h"
+#include "RamVisitor.h"
+#include <map>
+
+namespace souffle {
+
+void RamPrivateSymbolAnalysis::run(const RamTranslationUnit& translationUnit) {
+    relations.clear();
+    // a symbol dictionary shared with other programs holds the symbols of all relations
+    if (Global::config().has("provenance") || Global::config().has("checkpoints") ||
+            Global::config().has("engine") || Global::config().has("symbols-in") ||
+            Global::config().has("symbols-out")) {
+        return;
+    }
+
+    // the references to each relation, and those of statements only moving its tuples in and out
+    std::map<const RamRelation*, size_t> references;
+    std::map<const RamRelation*, size_t> passThrough;
+    std::set<const RamRelation*> loaded;
+    visitDepthFirst(*translationUnit.getProgram(),
+            [&](const RamRelationReference& ref) { ++references[ref.get()]; });
+    visitDepthFirst(*translationUnit.getProgram(), [&](const RamRelationStatement& stmt) {
+        const RamRelation* rel = &stmt.getRelation();
+        if (dynamic_cast<const RamLoad*>(&stmt) != nullptr) {
+            loaded.insert(rel);
+        } else if (dynamic_cast<const RamStore*>(&stmt) == nullptr &&
+                   dynamic_cast<const RamCreate*>(&stmt) == nullptr &&
+                   dynamic_cast<const RamClear*>(&stmt) == nullptr &&
+                   dynamic_cast<const RamDrop*>(&stmt) == nullptr &&
+                   dynamic_cast<const RamLogSize*>(&stmt) == nullptr &&
+                   dynamic_cast<const RamLogRelationTimer*>(&stmt) == nullptr) {
+            return;
+        }
+        ++passThrough[rel];
+    });
+
+    for (const RamRelation* rel : loaded) {
+        bool hasSymbols = false;
+        for (const auto& type : rel->getAttributeTypeQualifiers()) {
+            hasSymbols = hasSymbols || type[0] == 's';
+        }
+        if (hasSymbols && references[rel] == passThrough[rel]) {
+            relations.insert(rel->getName());
+        }
+    }
+}
+
+bool RamPrivateSymbolAnalysis::isPrivate(const RamRelation& rel) const {
+    return relations.count(rel.getName()) != 0;
+}
+
+void RamPrivateSymbolAnalysis::print(std::ostream& os) const {
+    for (const auto& name : relations) {
+        os << name << ": private symbol table\n";
+    }
+}
+
+}  // end of namespace souffle
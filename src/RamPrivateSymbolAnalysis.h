@@ -0,0 +1,64 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamPrivateSymbolAnalysis.h
+ *
+ * Selection of the relations passed through from their inputs to their
+ * outputs, whose symbols are kept in symbol tables of their own
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamAnalysis.h"
+#include <iostream>
+#include <set>
+#include <string>
+
+namespace souffle {
+
+class RamRelation;
+
+/**
+ * @class RamPrivateSymbolAnalysis
+ * @brief Determines the relations whose symbols do not enter the symbol table of the program
+ *
+ * A relation that is loaded and otherwise only stored, counted or dropped has its symbols
+ * never compared to symbols of other relations or of the program. Their indices therefore
+ * only need to agree among the tuples of the relation, and the relation keeps its symbols
+ * in a table of its own: the symbol table of the program does not grow by the symbols of
+ * wide pass-through relations, its lookups stay local to the symbols of the rules, and the
+ * symbols are released along with the relation once it is dropped.
+ *
+ * Relations defined by facts, whose constants are symbols of the program, do not qualify;
+ * neither do relations under provenance, checkpoints or a distributed engine, which exchange
+ * or record the symbol table of the program.
+ */
+class RamPrivateSymbolAnalysis : public RamAnalysis {
+public:
+    static constexpr const char* name = "private-symbol-analysis";
+
+    void run(const RamTranslationUnit& translationUnit) override;
+
+    void print(std::ostream& os) const override;
+
+    /** Whether a relation keeps its symbols in a symbol table of its own */
+    bool isPrivate(const RamRelation& rel) const;
+
+    /** The names of the relations keeping their symbols in symbol tables of their own */
+    const std::set<std::string>& getRelations() const {
+        return relations;
+    }
+
+private:
+    std::set<std::string> relations;
+};
+
+}  // end of namespace souffle
@@ -100,6 +100,11 @@ public:
         }
     }
 
+    /** @brief Remove a relation, which must no longer be referenced */
+    void removeRelation(const std::string& name) {
+        relations.erase(name);
+    }
+
     /** @brief Get relations map */
     const std::map<std::string, std::unique_ptr<RamRelation>>& getAllRelations() const {
         return this->relations;
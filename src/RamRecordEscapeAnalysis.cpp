@@ -0,0 +1,78 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamRecordEscapeAnalysis.cpp
+ *
+ * Implementation of the analysis of records whose references do not escape their query
+ *
+ ***********************************************************************/
+
+#include "RamRecordEscapeAnalysis.h"
+#include "BinaryConstraintOps.h"
+#include "RamCondition.h"
+#include "RamExpression.h"
+#include "RamOperation.h"
+#include "RamProgram.h"
+#include "RamStatement.h"
+#include "RamTranslationUnit.h"
+#include "RamVisitor.h"
+#include <functional>
+#include <vector>
+
+namespace souffle {
+
+void RamRecordEscapeAnalysis::run(const RamTranslationUnit& translationUnit) {
+    local.clear();
+
+    // marks the records packed by an expression in a position that is only compared
+    std::function<void(const RamExpression*)> markCompared;
+    markCompared = [&](const RamExpression* expr) {
+        if (const auto* pack = dynamic_cast<const RamPackRecord*>(expr)) {
+            local.insert(pack);
+            for (const RamExpression* arg : pack->getArguments()) {
+                markCompared(arg);
+            }
+        }
+    };
+    auto markAll = [&](const std::vector<RamExpression*>& values) {
+        for (const RamExpression* value : values) {
+            markCompared(value);
+        }
+    };
+
+    visitDepthFirst(*translationUnit.getProgram(), [&](const RamQuery& query) {
+        visitDepthFirst(query, [&](const RamNode& node) {
+            if (const auto* constraint = dynamic_cast<const RamConstraint*>(&node)) {
+                if (constraint->getOperator() == BinaryConstraintOp::EQ ||
+                        constraint->getOperator() == BinaryConstraintOp::NE) {
+                    markCompared(&constraint->getLHS());
+                    markCompared(&constraint->getRHS());
+                }
+            } else if (const auto* exists = dynamic_cast<const RamAbstractExistenceCheck*>(&node)) {
+                markAll(exists->getValues());
+            } else if (const auto* search = dynamic_cast<const RamIndexOperation*>(&node)) {
+                markAll(search->getRangePattern());
+            } else if (const auto* intersect = dynamic_cast<const RamIntersect*>(&node)) {
+                for (size_t i = 0; i < intersect->getNumParticipants(); i++) {
+                    markAll(intersect->getRangePattern(i));
+                }
+            }
+        });
+    });
+}
+
+void RamRecordEscapeAnalysis::print(std::ostream& os) const {
+    os << "Local records:\n";
+    for (const RamPackRecord* pack : local) {
+        os << "\t" << *pack << "\n";
+    }
+}
+
+}  // end of namespace souffle
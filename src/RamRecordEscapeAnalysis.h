@@ -0,0 +1,57 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamRecordEscapeAnalysis.h
+ *
+ * Determines the records whose references do not escape the query creating them
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamAnalysis.h"
+#include <iostream>
+#include <set>
+
+namespace souffle {
+
+class RamPackRecord;
+
+/**
+ * @class RamRecordEscapeAnalysis
+ * @brief Determines the packed records whose references are only compared
+ *
+ * A record packed in a query is local if its reference serves only as a value of a search
+ * pattern, an operand of an equality or inequality constraint, or a field of another local
+ * record. Such references are never stored, returned or unpacked, hence local records are
+ * kept in an arena of the evaluating thread, released when the query is complete, instead
+ * of the global record table; only records already in the global table obtain their global
+ * reference. The values compared with local references are read from relations or
+ * arguments, which do not change during a query, so a record absent from the global table
+ * when first packed equals none of them.
+ */
+class RamRecordEscapeAnalysis : public RamAnalysis {
+public:
+    static constexpr const char* name = "record-escape-analysis";
+
+    void run(const RamTranslationUnit& translationUnit) override;
+
+    void print(std::ostream& os) const override;
+
+    /** Whether the reference of a packed record does not escape its query */
+    bool isLocal(const RamPackRecord& pack) const {
+        return local.count(&pack) != 0;
+    }
+
+private:
+    std::set<const RamPackRecord*> local;
+};
+
+}  // end of namespace souffle
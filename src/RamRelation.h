@@ -53,12 +53,16 @@ protected:
     /** Data-structure representation */
     const RelationRepresentation representation;
 
+    /** Storage provider, if the representation is STORAGE */
+    const std::string storage;
+
 public:
     RamRelation(const std::string name, const size_t arity, const std::vector<std::string> attributeNames,
             const std::vector<std::string> attributeTypeQualifiers,
-            const RelationRepresentation representation)
+            const RelationRepresentation representation, const std::string storage = "")
             : RamNode(), name(std::move(name)), arity(arity), attributeNames(std::move(attributeNames)),
-              attributeTypeQualifiers(std::move(attributeTypeQualifiers)), representation(representation) {
+              attributeTypeQualifiers(std::move(attributeTypeQualifiers)), representation(representation),
+              storage(std::move(storage)) {
         assert(this->attributeNames.size() == arity || this->attributeNames.empty());
         assert(this->attributeTypeQualifiers.size() == arity || this->attributeTypeQualifiers.empty());
     }
@@ -79,6 +83,11 @@ public:
         return "c" + std::to_string(i);
     }
 
+    /** @brief Check whether the relation carries the rule and level columns of provenance */
+    bool hasProvenanceColumns() const {
+        return arity >= 2 && getArg(arity - 1) == "@level_number";
+    }
+
     /** @brief Get Argument Type Qualifier */
     const std::string getArgTypeQualifier(uint32_t i) const {
         return (i < attributeTypeQualifiers.size()) ? attributeTypeQualifiers[i] : "";
@@ -98,6 +107,11 @@ public:
         return representation;
     }
 
+    /** @brief Storage provider, empty unless the representation is STORAGE */
+    const std::string& getStorage() const {
+        return storage;
+    }
+
     /** @brief Is temporary relation (for semi-naive evaluation) */
     const bool isTemp() const {
         return name.at(0) == '@';
@@ -123,13 +137,17 @@ public:
             }
             out << ")";
             out << " " << representation;
+            if (representation == RelationRepresentation::STORAGE) {
+                out << "(" << storage << ")";
+            }
         } else {
             out << " nullary";
         }
     }
 
     RamRelation* clone() const override {
-        return new RamRelation(name, arity, attributeNames, attributeTypeQualifiers, representation);
+        return new RamRelation(
+                name, arity, attributeNames, attributeTypeQualifiers, representation, storage);
     }
 
 protected:
@@ -138,7 +156,8 @@ protected:
         const auto& other = static_cast<const RamRelation&>(node);
         return name == other.name && arity == other.arity && attributeNames == other.attributeNames &&
                attributeTypeQualifiers == other.attributeTypeQualifiers &&
-               representation == other.representation && isTemp() == other.isTemp();
+               representation == other.representation && storage == other.storage &&
+               isTemp() == other.isTemp();
     }
 };
 
@@ -0,0 +1,905 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamSerialisation.cpp
+ *
+ * Implementation of saving and loading RAM programs.
+ *
+ * A program is written as a sequence of tokens separated by white space.
+ * Each node starts with the name of its kind, followed by its attributes
+ * and its children. Strings are written as their length, a single space
+ * and their characters, such that they may hold any character. Relations
+ * are referred to by their names.
+ *
+ ***********************************************************************/
+
+#include "RamSerialisation.h"
+#include "BinaryConstraintOps.h"
+#include "FunctorOps.h"
+#include "Global.h"
+#include "IODirectives.h"
+#include "RamCondition.h"
+#include "RamExpression.h"
+#include "RamNode.h"
+#include "RamOperation.h"
+#include "RamProgram.h"
+#include "RamRelation.h"
+#include "RamStatement.h"
+#include "RamTypes.h"
+#include "RamVisitor.h"
+#include "RelationRepresentation.h"
+#include "config.h"
+
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+namespace {
+
+/** The first token of a saved program, followed by the version of souffle that wrote it */
+const std::string magic = "souffle-ram";
+
+/** Options of the run that saved a program which are not restored when loading it */
+const std::set<std::string> unrestoredOptions = {"", "save-ram", "load-ram", "debug-report", "compile",
+        "generate", "dl-program", "verbose", "version"};
+
+/** Writes the nodes of a RAM program */
+class RamWriter : public RamVisitor<void> {
+public:
+    RamWriter(std::ostream& os) : os(os) {}
+
+    void writeString(const std::string& str) {
+        os << str.size() << ' ' << str << ' ';
+    }
+
+    void writeStrings(const std::vector<std::string>& strs) {
+        os << strs.size() << ' ';
+        for (const std::string& str : strs) {
+            writeString(str);
+        }
+    }
+
+    void writeRelation(const RamRelation& rel) {
+        writeString(rel.getName());
+    }
+
+    void writeRelationDeclaration(const RamRelation& rel) {
+        writeString(rel.getName());
+        os << rel.getArity() << ' ';
+        for (size_t i = 0; i < rel.getArity(); i++) {
+            writeString(rel.getArg(i));
+            writeString(rel.getArgTypeQualifier(i));
+        }
+        os << static_cast<int>(rel.getRepresentation()) << ' ';
+        writeString(rel.getStorage());
+        os << '\n';
+    }
+
+    void writeNodes(const std::vector<RamExpression*>& nodes) {
+        os << nodes.size() << ' ';
+        for (const RamExpression* node : nodes) {
+            visit(*node);
+        }
+    }
+
+    void writeDirectives(const std::vector<IODirectives>& directives) {
+        os << directives.size() << ' ';
+        for (const IODirectives& directive : directives) {
+            os << directive.getDirectives().size() << ' ';
+            for (const auto& entry : directive.getDirectives()) {
+                writeString(entry.first);
+                writeString(entry.second);
+            }
+        }
+    }
+
+    // -- statements --
+
+    void visitCreate(const RamCreate& create) override {
+        os << "Create ";
+        writeRelation(create.getRelation());
+    }
+
+    void visitLoad(const RamLoad& load) override {
+        os << "Load ";
+        writeRelation(load.getRelation());
+        writeDirectives(load.getIODirectives());
+    }
+
+    void visitStore(const RamStore& store) override {
+        os << "Store ";
+        writeRelation(store.getRelation());
+        writeDirectives(store.getIODirectives());
+    }
+
+    void visitClear(const RamClear& clear) override {
+        os << "Clear ";
+        writeRelation(clear.getRelation());
+    }
+
+    void visitDrop(const RamDrop& drop) override {
+        os << "Drop ";
+        writeRelation(drop.getRelation());
+    }
+
+    void visitLogSize(const RamLogSize& size) override {
+        os << "LogSize ";
+        writeRelation(size.getRelation());
+        writeString(size.getMessage());
+    }
+
+    void visitLogDistinctValues(const RamLogDistinctValues& distinct) override {
+        os << "LogDistinctValues ";
+        writeRelation(distinct.getRelation());
+        writeStrings(distinct.getMessages());
+    }
+
+    void visitMerge(const RamMerge& merge) override {
+        os << "Merge ";
+        writeRelation(merge.getTargetRelation());
+        writeRelation(merge.getSourceRelation());
+    }
+
+    void visitSwap(const RamSwap& swap) override {
+        os << "Swap ";
+        writeRelation(swap.getFirstRelation());
+        writeRelation(swap.getSecondRelation());
+    }
+
+    void visitTransitiveClosure(const RamTransitiveClosure& closure) override {
+        os << "TransitiveClosure ";
+        writeRelation(closure.getTargetRelation());
+        writeRelation(closure.getSourceRelation());
+    }
+
+    void visitFact(const RamFact& fact) override {
+        os << "Fact ";
+        writeRelation(fact.getRelation());
+        writeNodes(fact.getValues());
+    }
+
+    void visitQuery(const RamQuery& query) override {
+        os << "Query ";
+        visit(query.getOperation());
+        os << '\n';
+    }
+
+    void visitSequence(const RamSequence& seq) override {
+        os << "Sequence " << seq.getStatements().size() << '\n';
+        for (const RamStatement* stmt : seq.getStatements()) {
+            visit(*stmt);
+        }
+    }
+
+    void visitParallel(const RamParallel& parallel) override {
+        os << "Parallel " << parallel.getStatements().size() << '\n';
+        for (const RamStatement* stmt : parallel.getStatements()) {
+            visit(*stmt);
+        }
+    }
+
+    void visitPlanSwitch(const RamPlanSwitch& planSwitch) override {
+        os << "PlanSwitch " << planSwitch.getStatements().size() << '\n';
+        for (size_t i = 0; i < planSwitch.getStatements().size(); i++) {
+            const std::vector<RamRelationReference*> rels = planSwitch.getJoinedRelations(i);
+            os << rels.size() << ' ';
+            for (size_t j = 0; j < rels.size(); j++) {
+                writeRelation(*rels[j]->get());
+                os << planSwitch.getBoundAttributes(i)[j] << ' ';
+            }
+            visit(*planSwitch.getStatements()[i]);
+        }
+    }
+
+    void visitLoop(const RamLoop& loop) override {
+        os << "Loop\n";
+        visit(loop.getBody());
+    }
+
+    void visitExit(const RamExit& exit) override {
+        os << "Exit ";
+        visit(exit.getCondition());
+        os << '\n';
+    }
+
+    void visitLogTimer(const RamLogTimer& timer) override {
+        os << "LogTimer ";
+        writeString(timer.getMessage());
+        visit(timer.getStatement());
+    }
+
+    void visitLogRelationTimer(const RamLogRelationTimer& timer) override {
+        os << "LogRelationTimer ";
+        writeRelation(timer.getRelation());
+        writeString(timer.getMessage());
+        visit(timer.getStatement());
+    }
+
+    void visitDebugInfo(const RamDebugInfo& dbg) override {
+        os << "DebugInfo ";
+        writeString(dbg.getMessage());
+        visit(dbg.getStatement());
+    }
+
+    void visitStratum(const RamStratum& stratum) override {
+        os << "Stratum " << stratum.getIndex() << '\n';
+        visit(stratum.getBody());
+    }
+
+    void visitRecv(const RamRecv& recv) override {
+        os << "Recv ";
+        writeRelation(recv.getRelation());
+        os << recv.getSourceStratum() << ' ';
+    }
+
+    // -- operations --
+
+    void writeNested(const RamNestedOperation& op) {
+        writeString(op.getProfileText());
+        visit(op.getOperation());
+    }
+
+    void visitScan(const RamScan& scan) override {
+        os << (dynamic_cast<const RamParallelScan*>(&scan) != nullptr ? "ParallelScan " : "Scan ");
+        writeRelation(scan.getRelation());
+        os << scan.getTupleId() << ' ';
+        writeNested(scan);
+    }
+
+    void visitIndexScan(const RamIndexScan& scan) override {
+        os << (dynamic_cast<const RamParallelIndexScan*>(&scan) != nullptr ? "ParallelIndexScan "
+                                                                            : "IndexScan ");
+        writeRelation(scan.getRelation());
+        os << scan.getTupleId() << ' ';
+        writeNodes(scan.getRangePattern());
+        os << scan.getRangeColumn() << ' ';
+        visit(scan.getLowerBound());
+        visit(scan.getUpperBound());
+        writeNested(scan);
+    }
+
+    void visitIntersect(const RamIntersect& intersect) override {
+        os << "Intersect " << intersect.getTupleId() << ' ' << intersect.getNumParticipants() << ' ';
+        for (size_t i = 0; i < intersect.getNumParticipants(); i++) {
+            writeRelation(intersect.getRelation(i));
+            writeNodes(intersect.getRangePattern(i));
+            os << intersect.getColumn(i) << ' ';
+        }
+        writeNested(intersect);
+    }
+
+    void visitChoice(const RamChoice& choice) override {
+        os << (dynamic_cast<const RamParallelChoice*>(&choice) != nullptr ? "ParallelChoice " : "Choice ");
+        writeRelation(choice.getRelation());
+        os << choice.getTupleId() << ' ';
+        visit(choice.getCondition());
+        writeNested(choice);
+    }
+
+    void visitIndexChoice(const RamIndexChoice& choice) override {
+        os << (dynamic_cast<const RamParallelIndexChoice*>(&choice) != nullptr ? "ParallelIndexChoice "
+                                                                               : "IndexChoice ");
+        writeRelation(choice.getRelation());
+        os << choice.getTupleId() << ' ';
+        visit(choice.getCondition());
+        writeNodes(choice.getRangePattern());
+        writeNested(choice);
+    }
+
+    void visitAggregate(const RamAggregate& aggregate) override {
+        os << "Aggregate ";
+        writeRelation(aggregate.getRelation());
+        os << aggregate.getTupleId() << ' ' << static_cast<int>(aggregate.getFunction()) << ' ';
+        visit(aggregate.getExpression());
+        visit(aggregate.getCondition());
+        visit(aggregate.getOperation());
+    }
+
+    void visitIndexAggregate(const RamIndexAggregate& aggregate) override {
+        os << "IndexAggregate ";
+        writeRelation(aggregate.getRelation());
+        os << aggregate.getTupleId() << ' ' << static_cast<int>(aggregate.getFunction()) << ' ';
+        visit(aggregate.getExpression());
+        visit(aggregate.getCondition());
+        writeNodes(aggregate.getRangePattern());
+        visit(aggregate.getOperation());
+    }
+
+    void visitUnpackRecord(const RamUnpackRecord& unpack) override {
+        os << "UnpackRecord " << unpack.getTupleId() << ' ' << unpack.getArity() << ' ';
+        visit(unpack.getExpression());
+        writeNested(unpack);
+    }
+
+    void visitFilter(const RamFilter& filter) override {
+        os << "Filter ";
+        visit(filter.getCondition());
+        writeNested(filter);
+    }
+
+    void visitBreak(const RamBreak& breakOp) override {
+        os << "Break ";
+        visit(breakOp.getCondition());
+        writeNested(breakOp);
+    }
+
+    void visitProject(const RamProject& project) override {
+        os << "Project ";
+        writeRelation(project.getRelation());
+        writeNodes(project.getValues());
+    }
+
+    void visitSubroutineReturnValue(const RamSubroutineReturnValue& ret) override {
+        os << "Return ";
+        writeNodes(ret.getValues());
+    }
+
+    // -- conditions --
+
+    void visitTrue(const RamTrue&) override {
+        os << "True ";
+    }
+
+    void visitFalse(const RamFalse&) override {
+        os << "False ";
+    }
+
+    void visitConjunction(const RamConjunction& conj) override {
+        os << "Conjunction ";
+        visit(conj.getLHS());
+        visit(conj.getRHS());
+    }
+
+    void visitNegation(const RamNegation& neg) override {
+        os << "Negation ";
+        visit(neg.getOperand());
+    }
+
+    void visitConstraint(const RamConstraint& constraint) override {
+        os << "Constraint " << static_cast<int>(constraint.getOperator()) << ' ';
+        visit(constraint.getLHS());
+        visit(constraint.getRHS());
+    }
+
+    void visitExistenceCheck(const RamExistenceCheck& exists) override {
+        os << "ExistenceCheck ";
+        writeRelation(exists.getRelation());
+        writeNodes(exists.getValues());
+    }
+
+    void visitProvenanceExistenceCheck(const RamProvenanceExistenceCheck& exists) override {
+        os << "ProvenanceExistenceCheck ";
+        writeRelation(exists.getRelation());
+        writeNodes(exists.getValues());
+    }
+
+    void visitEmptinessCheck(const RamEmptinessCheck& emptiness) override {
+        os << "EmptinessCheck ";
+        writeRelation(emptiness.getRelation());
+    }
+
+    void visitSizeCheck(const RamSizeCheck& check) override {
+        os << "SizeCheck ";
+        writeRelation(check.getRelation());
+        os << check.getSize() << ' ';
+    }
+
+    // -- expressions --
+
+    void visitNumber(const RamNumber& num) override {
+        os << "Number " << num.getConstant() << ' ';
+    }
+
+    void visitTupleElement(const RamTupleElement& elem) override {
+        os << "TupleElement " << elem.getTupleId() << ' ' << elem.getElement() << ' ';
+    }
+
+    void visitAutoIncrement(const RamAutoIncrement&) override {
+        os << "AutoIncrement ";
+    }
+
+    void visitUndefValue(const RamUndefValue&) override {
+        os << "UndefValue ";
+    }
+
+    void visitIntrinsicOperator(const RamIntrinsicOperator& op) override {
+        os << "IntrinsicOperator " << static_cast<int>(op.getOperator()) << ' ';
+        writeNodes(op.getArguments());
+    }
+
+    void visitUserDefinedOperator(const RamUserDefinedOperator& op) override {
+        os << "UserDefinedOperator ";
+        writeString(op.getName());
+        writeString(op.getType());
+        writeNodes(op.getArguments());
+    }
+
+    void visitPackRecord(const RamPackRecord& pack) override {
+        os << "PackRecord ";
+        writeNodes(pack.getArguments());
+    }
+
+    void visitSubroutineArgument(const RamSubroutineArgument& arg) override {
+        os << "SubroutineArgument " << arg.getArgument() << ' ';
+    }
+
+    void visitNode(const RamNode& node) override {
+        throw std::runtime_error("cannot save RAM node " + toString(node));
+    }
+
+private:
+    std::ostream& os;
+};
+
+/** Moves the file of a directive from one directory to another, if it is in the former */
+void moveFile(IODirectives& directive, const std::string& from, const std::string& to) {
+    if (from.empty() || to.empty() || from == to || !directive.has("IO") || !directive.has("filename") ||
+            !IODirectives::isFileType(directive.getIOType())) {
+        return;
+    }
+    const std::string& filename = directive.getFileName();
+    if (filename.compare(0, from.size() + 1, from + "/") == 0) {
+        directive.setFileName(to + filename.substr(from.size()));
+    }
+}
+
+/** Reads the nodes of a RAM program */
+class RamReader {
+public:
+    RamReader(std::istream& is, RamProgram& program) : is(is), program(program) {}
+
+    /** Sets the directories the files of loaded and stored relations are moved to and from */
+    void setDirectories(const std::string& savedFactDir, const std::string& savedOutputDir) {
+        factDirs = {savedFactDir, Global::config().get("fact-dir")};
+        outputDirs = {savedOutputDir, Global::config().get("output-dir")};
+    }
+
+    [[noreturn]] void fail(const std::string& what) {
+        throw std::runtime_error("malformed RAM program: " + what);
+    }
+
+    std::string readTag() {
+        std::string tag;
+        if (!(is >> tag)) {
+            fail("unexpected end of file");
+        }
+        return tag;
+    }
+
+    long long readNumber() {
+        long long num;
+        if (!(is >> num)) {
+            fail("number expected");
+        }
+        return num;
+    }
+
+    size_t readSize() {
+        long long num = readNumber();
+        if (num < 0) {
+            fail("negative count");
+        }
+        return num;
+    }
+
+    std::string readString() {
+        size_t length = readSize();
+        std::string str(length, ' ');
+        if (is.get() != ' ' || !is.read(&str[0], length)) {
+            fail("string expected");
+        }
+        return str;
+    }
+
+    std::vector<std::string> readStrings() {
+        std::vector<std::string> strs(readSize());
+        for (std::string& str : strs) {
+            str = readString();
+        }
+        return strs;
+    }
+
+    std::unique_ptr<RamRelationReference> readRelation() {
+        const std::string name = readString();
+        const RamRelation* rel = program.getRelation(name);
+        if (rel == nullptr) {
+            fail("undeclared relation " + name);
+        }
+        return std::make_unique<RamRelationReference>(rel);
+    }
+
+    std::unique_ptr<RamRelation> readRelationDeclaration() {
+        const std::string name = readString();
+        size_t arity = readSize();
+        std::vector<std::string> attributeNames;
+        std::vector<std::string> attributeTypes;
+        for (size_t i = 0; i < arity; i++) {
+            attributeNames.push_back(readString());
+            attributeTypes.push_back(readString());
+        }
+        auto representation = static_cast<RelationRepresentation>(readNumber());
+        const std::string storage = readString();
+        return std::make_unique<RamRelation>(
+                name, arity, attributeNames, attributeTypes, representation, storage);
+    }
+
+    std::vector<std::unique_ptr<RamExpression>> readExpressions() {
+        std::vector<std::unique_ptr<RamExpression>> res(readSize());
+        for (auto& cur : res) {
+            cur = readExpression();
+        }
+        return res;
+    }
+
+    std::vector<IODirectives> readDirectives(const std::pair<std::string, std::string>& dirs) {
+        std::vector<IODirectives> res(readSize());
+        for (IODirectives& directive : res) {
+            size_t entries = readSize();
+            for (size_t i = 0; i < entries; i++) {
+                std::string key = readString();
+                directive.set(key, readString());
+            }
+            moveFile(directive, dirs.first, dirs.second);
+        }
+        return res;
+    }
+
+    std::unique_ptr<RamStatement> readStatement() {
+        const std::string tag = readTag();
+        if (tag == "Create") {
+            return std::make_unique<RamCreate>(readRelation());
+        } else if (tag == "Load") {
+            auto rel = readRelation();
+            return std::make_unique<RamLoad>(std::move(rel), readDirectives(factDirs));
+        } else if (tag == "Store") {
+            auto rel = readRelation();
+            return std::make_unique<RamStore>(std::move(rel), readDirectives(outputDirs));
+        } else if (tag == "Clear") {
+            return std::make_unique<RamClear>(readRelation());
+        } else if (tag == "Drop") {
+            return std::make_unique<RamDrop>(readRelation());
+        } else if (tag == "LogSize") {
+            auto rel = readRelation();
+            return std::make_unique<RamLogSize>(std::move(rel), readString());
+        } else if (tag == "LogDistinctValues") {
+            auto rel = readRelation();
+            return std::make_unique<RamLogDistinctValues>(std::move(rel), readStrings());
+        } else if (tag == "Merge") {
+            auto target = readRelation();
+            return std::make_unique<RamMerge>(std::move(target), readRelation());
+        } else if (tag == "Swap") {
+            auto first = readRelation();
+            return std::make_unique<RamSwap>(std::move(first), readRelation());
+        } else if (tag == "TransitiveClosure") {
+            auto target = readRelation();
+            return std::make_unique<RamTransitiveClosure>(std::move(target), readRelation());
+        } else if (tag == "Fact") {
+            auto rel = readRelation();
+            return std::make_unique<RamFact>(std::move(rel), readExpressions());
+        } else if (tag == "Query") {
+            return std::make_unique<RamQuery>(readOperation());
+        } else if (tag == "Sequence" || tag == "Parallel") {
+            std::unique_ptr<RamListStatement> list;
+            if (tag == "Sequence") {
+                list = std::make_unique<RamSequence>();
+            } else {
+                list = std::make_unique<RamParallel>();
+            }
+            size_t size = readSize();
+            for (size_t i = 0; i < size; i++) {
+                list->add(readStatement());
+            }
+            return std::move(list);
+        } else if (tag == "PlanSwitch") {
+            auto planSwitch = std::make_unique<RamPlanSwitch>();
+            size_t size = readSize();
+            for (size_t i = 0; i < size; i++) {
+                std::vector<std::unique_ptr<RamRelationReference>> rels(readSize());
+                std::vector<size_t> bound;
+                for (auto& rel : rels) {
+                    rel = readRelation();
+                    bound.push_back(readSize());
+                }
+                planSwitch->add(readStatement(), std::move(rels), bound);
+            }
+            return std::move(planSwitch);
+        } else if (tag == "Loop") {
+            return std::make_unique<RamLoop>(readStatement());
+        } else if (tag == "Exit") {
+            return std::make_unique<RamExit>(readCondition());
+        } else if (tag == "LogTimer") {
+            std::string message = readString();
+            return std::make_unique<RamLogTimer>(readStatement(), message);
+        } else if (tag == "LogRelationTimer") {
+            auto rel = readRelation();
+            std::string message = readString();
+            return std::make_unique<RamLogRelationTimer>(readStatement(), message, std::move(rel));
+        } else if (tag == "DebugInfo") {
+            std::string message = readString();
+            return std::make_unique<RamDebugInfo>(readStatement(), message);
+        } else if (tag == "Stratum") {
+            int index = readNumber();
+            return std::make_unique<RamStratum>(readStatement(), index);
+        } else if (tag == "Recv") {
+            auto rel = readRelation();
+            return std::make_unique<RamRecv>(std::move(rel), readNumber());
+        }
+        fail("unknown statement " + tag);
+    }
+
+    std::unique_ptr<RamOperation> readOperation() {
+        const std::string tag = readTag();
+        if (tag == "Scan" || tag == "ParallelScan") {
+            auto rel = readRelation();
+            int ident = readNumber();
+            std::string profileText = readString();
+            auto nested = readOperation();
+            if (tag == "Scan") {
+                return std::make_unique<RamScan>(std::move(rel), ident, std::move(nested), profileText);
+            }
+            return std::make_unique<RamParallelScan>(std::move(rel), ident, std::move(nested), profileText);
+        } else if (tag == "IndexScan" || tag == "ParallelIndexScan") {
+            auto rel = readRelation();
+            int ident = readNumber();
+            auto pattern = readExpressions();
+            int rangeColumn = readNumber();
+            auto lower = readExpression();
+            auto upper = readExpression();
+            std::string profileText = readString();
+            auto nested = readOperation();
+            if (tag == "IndexScan") {
+                return std::make_unique<RamIndexScan>(std::move(rel), ident, std::move(pattern), rangeColumn,
+                        std::move(lower), std::move(upper), std::move(nested), profileText);
+            }
+            return std::make_unique<RamParallelIndexScan>(std::move(rel), ident, std::move(pattern),
+                    rangeColumn, std::move(lower), std::move(upper), std::move(nested), profileText);
+        } else if (tag == "Intersect") {
+            int ident = readNumber();
+            size_t participants = readSize();
+            std::vector<std::unique_ptr<RamRelationReference>> rels;
+            std::vector<std::vector<std::unique_ptr<RamExpression>>> patterns;
+            std::vector<size_t> columns;
+            for (size_t i = 0; i < participants; i++) {
+                rels.push_back(readRelation());
+                patterns.push_back(readExpressions());
+                columns.push_back(readSize());
+            }
+            std::string profileText = readString();
+            auto intersect = std::make_unique<RamIntersect>(ident, readOperation(), profileText);
+            for (size_t i = 0; i < participants; i++) {
+                intersect->add(std::move(rels[i]), std::move(patterns[i]), columns[i]);
+            }
+            return std::move(intersect);
+        } else if (tag == "Choice" || tag == "ParallelChoice") {
+            auto rel = readRelation();
+            int ident = readNumber();
+            auto cond = readCondition();
+            std::string profileText = readString();
+            auto nested = readOperation();
+            if (tag == "Choice") {
+                return std::make_unique<RamChoice>(
+                        std::move(rel), ident, std::move(cond), std::move(nested), profileText);
+            }
+            return std::make_unique<RamParallelChoice>(
+                    std::move(rel), ident, std::move(cond), std::move(nested), profileText);
+        } else if (tag == "IndexChoice" || tag == "ParallelIndexChoice") {
+            auto rel = readRelation();
+            int ident = readNumber();
+            auto cond = readCondition();
+            auto pattern = readExpressions();
+            std::string profileText = readString();
+            auto nested = readOperation();
+            if (tag == "IndexChoice") {
+                return std::make_unique<RamIndexChoice>(std::move(rel), ident, std::move(cond),
+                        std::move(pattern), std::move(nested), profileText);
+            }
+            return std::make_unique<RamParallelIndexChoice>(std::move(rel), ident, std::move(cond),
+                    std::move(pattern), std::move(nested), profileText);
+        } else if (tag == "Aggregate" || tag == "IndexAggregate") {
+            auto rel = readRelation();
+            int ident = readNumber();
+            auto fun = static_cast<AggregateFunction>(readNumber());
+            auto expr = readExpression();
+            auto cond = readCondition();
+            if (tag == "Aggregate") {
+                return std::make_unique<RamAggregate>(
+                        readOperation(), fun, std::move(rel), std::move(expr), std::move(cond), ident);
+            }
+            auto pattern = readExpressions();
+            return std::make_unique<RamIndexAggregate>(readOperation(), fun, std::move(rel), std::move(expr),
+                    std::move(cond), std::move(pattern), ident);
+        } else if (tag == "UnpackRecord") {
+            int ident = readNumber();
+            size_t arity = readSize();
+            auto expr = readExpression();
+            readString();
+            return std::make_unique<RamUnpackRecord>(readOperation(), ident, std::move(expr), arity);
+        } else if (tag == "Filter" || tag == "Break") {
+            auto cond = readCondition();
+            std::string profileText = readString();
+            if (tag == "Filter") {
+                return std::make_unique<RamFilter>(std::move(cond), readOperation(), profileText);
+            }
+            return std::make_unique<RamBreak>(std::move(cond), readOperation(), profileText);
+        } else if (tag == "Project") {
+            auto rel = readRelation();
+            return std::make_unique<RamProject>(std::move(rel), readExpressions());
+        } else if (tag == "Return") {
+            return std::make_unique<RamSubroutineReturnValue>(readExpressions());
+        }
+        fail("unknown operation " + tag);
+    }
+
+    std::unique_ptr<RamCondition> readCondition() {
+        const std::string tag = readTag();
+        if (tag == "True") {
+            return std::make_unique<RamTrue>();
+        } else if (tag == "False") {
+            return std::make_unique<RamFalse>();
+        } else if (tag == "Conjunction") {
+            auto lhs = readCondition();
+            return std::make_unique<RamConjunction>(std::move(lhs), readCondition());
+        } else if (tag == "Negation") {
+            return std::make_unique<RamNegation>(readCondition());
+        } else if (tag == "Constraint") {
+            auto op = static_cast<BinaryConstraintOp>(readNumber());
+            auto lhs = readExpression();
+            return std::make_unique<RamConstraint>(op, std::move(lhs), readExpression());
+        } else if (tag == "ExistenceCheck") {
+            auto rel = readRelation();
+            return std::make_unique<RamExistenceCheck>(std::move(rel), readExpressions());
+        } else if (tag == "ProvenanceExistenceCheck") {
+            auto rel = readRelation();
+            return std::make_unique<RamProvenanceExistenceCheck>(std::move(rel), readExpressions());
+        } else if (tag == "EmptinessCheck") {
+            return std::make_unique<RamEmptinessCheck>(readRelation());
+        } else if (tag == "SizeCheck") {
+            auto rel = readRelation();
+            return std::make_unique<RamSizeCheck>(std::move(rel), readSize());
+        }
+        fail("unknown condition " + tag);
+    }
+
+    std::unique_ptr<RamExpression> readExpression() {
+        const std::string tag = readTag();
+        if (tag == "Number") {
+            return std::make_unique<RamNumber>(readNumber());
+        } else if (tag == "TupleElement") {
+            size_t ident = readSize();
+            return std::make_unique<RamTupleElement>(ident, readSize());
+        } else if (tag == "AutoIncrement") {
+            return std::make_unique<RamAutoIncrement>();
+        } else if (tag == "UndefValue") {
+            return std::make_unique<RamUndefValue>();
+        } else if (tag == "IntrinsicOperator") {
+            auto op = static_cast<FunctorOp>(readNumber());
+            return std::make_unique<RamIntrinsicOperator>(op, readExpressions());
+        } else if (tag == "UserDefinedOperator") {
+            std::string name = readString();
+            std::string type = readString();
+            return std::make_unique<RamUserDefinedOperator>(name, type, readExpressions());
+        } else if (tag == "PackRecord") {
+            return std::make_unique<RamPackRecord>(readExpressions());
+        } else if (tag == "SubroutineArgument") {
+            return std::make_unique<RamSubroutineArgument>(readSize());
+        }
+        fail("unknown expression " + tag);
+    }
+
+private:
+    std::istream& is;
+
+    RamProgram& program;
+
+    /** The saved and the current fact directory */
+    std::pair<std::string, std::string> factDirs;
+
+    /** The saved and the current output directory */
+    std::pair<std::string, std::string> outputDirs;
+};
+
+}  // namespace
+
+void saveRamProgram(const RamTranslationUnit& translationUnit, std::ostream& os) {
+    const RamProgram& program = *translationUnit.getProgram();
+    RamWriter writer(os);
+    os << magic << ' ';
+    writer.writeString(PACKAGE_VERSION);
+    os << '\n';
+
+    // the options, including those set by pragmas of the program
+    const auto& options = Global::config().data();
+    os << options.size() << '\n';
+    for (const auto& option : options) {
+        writer.writeString(option.first);
+        writer.writeString(option.second);
+        os << '\n';
+    }
+
+    // the symbols, in the order of their indexes
+    SymbolTable& symbolTable = const_cast<RamTranslationUnit&>(translationUnit).getSymbolTable();
+    os << symbolTable.size() << '\n';
+    for (size_t i = 0; i < symbolTable.size(); i++) {
+        writer.writeString(symbolTable.resolve(i));
+        os << '\n';
+    }
+
+    os << program.getAllRelations().size() << '\n';
+    for (const auto& rel : program.getAllRelations()) {
+        writer.writeRelationDeclaration(*rel.second);
+    }
+    os << program.getSubroutines().size() << '\n';
+    for (const auto& subroutine : program.getSubroutines()) {
+        writer.writeString(subroutine.first);
+        writer.visit(*subroutine.second);
+    }
+    writer.visit(*program.getMain());
+    os << '\n';
+}
+
+std::unique_ptr<RamTranslationUnit> loadRamProgram(
+        std::istream& is, SymbolTable& symbolTable, ErrorReport& errorReport, DebugReport& debugReport) {
+    auto program = std::make_unique<RamProgram>();
+    RamReader reader(is, *program);
+    std::string header;
+    if (!(is >> header) || header != magic) {
+        throw std::runtime_error("not a saved RAM program");
+    }
+    const std::string version = reader.readString();
+    if (version != PACKAGE_VERSION) {
+        throw std::runtime_error("RAM program saved by souffle " + version +
+                                 ", cannot be loaded by souffle " + PACKAGE_VERSION);
+    }
+
+    // restore the options not given otherwise, keeping the directories the program saw
+    std::map<std::string, std::string> options;
+    size_t numOptions = reader.readSize();
+    for (size_t i = 0; i < numOptions; i++) {
+        std::string key = reader.readString();
+        options[key] = reader.readString();
+    }
+    for (const auto& option : options) {
+        if (unrestoredOptions.count(option.first) == 0 && !Global::config().has(option.first)) {
+            Global::config().set(option.first, option.second);
+        }
+    }
+
+    // inputs and outputs are read from and written to the current directories
+    reader.setDirectories(options["fact-dir"], options["output-dir"]);
+
+    assert(symbolTable.size() == 0 && "symbols would be renumbered");
+    size_t numSymbols = reader.readSize();
+    for (size_t i = 0; i < numSymbols; i++) {
+        symbolTable.lookup(reader.readString());
+    }
+    if (symbolTable.size() != numSymbols) {
+        reader.fail("duplicate symbols");
+    }
+
+    size_t numRelations = reader.readSize();
+    for (size_t i = 0; i < numRelations; i++) {
+        program->addRelation(reader.readRelationDeclaration());
+    }
+    size_t numSubroutines = reader.readSize();
+    for (size_t i = 0; i < numSubroutines; i++) {
+        std::string name = reader.readString();
+        program->addSubroutine(name, reader.readStatement());
+    }
+    program->setMain(reader.readStatement());
+
+    return std::make_unique<RamTranslationUnit>(std::move(program), symbolTable, errorReport, debugReport);
+}
+
+}  // end of namespace souffle
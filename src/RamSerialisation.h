@@ -0,0 +1,50 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamSerialisation.h
+ *
+ * Saves optimised RAM programs to files and loads them back, such that
+ * repeated evaluations of an unchanged program skip its parsing and its
+ * AST and RAM transformations.
+ *
+ * A saved program holds the relations and statements of the RAM program,
+ * the symbols its constants refer to, and the options it was translated
+ * with. Files are only read by the same version of souffle that wrote them.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "DebugReport.h"
+#include "ErrorReport.h"
+#include "RamTranslationUnit.h"
+#include "SymbolTable.h"
+
+#include <iostream>
+#include <memory>
+
+namespace souffle {
+
+/** Writes the program of a translation unit, with its symbols and the global options, to a stream */
+void saveRamProgram(const RamTranslationUnit& translationUnit, std::ostream& os);
+
+/**
+ * Reads a program written by saveRamProgram into a new translation unit.
+ *
+ * The symbols of the program are entered into the given, empty symbol
+ * table. The saved options are restored where not set otherwise, and the
+ * files of inputs and outputs are moved from the fact and output
+ * directories the program was translated with to the current ones.
+ * Throws a std::runtime_error on files not written by this version.
+ */
+std::unique_ptr<RamTranslationUnit> loadRamProgram(
+        std::istream& is, SymbolTable& symbolTable, ErrorReport& errorReport, DebugReport& debugReport);
+
+}  // end of namespace souffle
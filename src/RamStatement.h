@@ -390,6 +390,52 @@ protected:
     }
 };
 
+/**
+ * @class RamTransitiveClosure
+ * @brief Insert the transitive closure of a binary source relation into a target relation
+ *
+ * Takes the place of the fixpoint loop of rules computing the closure.
+ *
+ * The following example inserts the closure of edge into path:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * CLOSURE path OF edge
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class RamTransitiveClosure : public RamBinRelationStatement {
+public:
+    RamTransitiveClosure(
+            std::unique_ptr<RamRelationReference> tRef, std::unique_ptr<RamRelationReference> sRef)
+            : RamBinRelationStatement(std::move(sRef), std::move(tRef)) {
+        assert(getSourceRelation().getArity() == 2 && "closure of a non-binary relation");
+    }
+
+    /** @brief Get source relation */
+    const RamRelation& getSourceRelation() const {
+        return getFirstRelation();
+    }
+
+    /** @brief Get target relation */
+    const RamRelation& getTargetRelation() const {
+        return getSecondRelation();
+    }
+
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos);
+        os << "CLOSURE " << getTargetRelation().getName() << " OF " << getSourceRelation().getName();
+        os << std::endl;
+    }
+
+    RamTransitiveClosure* clone() const override {
+        return new RamTransitiveClosure(std::unique_ptr<RamRelationReference>(second->clone()),
+                std::unique_ptr<RamRelationReference>(first->clone()));
+    }
+
+protected:
+    bool equal(const RamNode& node) const override {
+        return RamBinRelationStatement::equal(node);
+    }
+};
+
 /**
  * @class RamFact
  * @brief Insert a fact into a relation
@@ -634,6 +680,129 @@ protected:
     }
 };
 
+/**
+ * @class RamPlanSwitch
+ * @brief Execute one out of several equivalent statements, chosen at runtime
+ *
+ * Every statement evaluates the same rule with a different join order. Each
+ * statement is accompanied by the relations it joins, in the order of the
+ * join, and the number of attributes of each relation that are bound when it
+ * is accessed; from these an interpreter may estimate the cost of each
+ * statement using the current relation sizes. The first statement is the
+ * statically chosen join order.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * PLAN SWITCH
+ *  PLAN @delta_A(0),B(1)
+ *   QUERY
+ *    ...
+ *  PLAN B(0),@delta_A(2)
+ *   QUERY
+ *    ...
+ * END PLAN SWITCH
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class RamPlanSwitch : public RamStatement {
+public:
+    RamPlanSwitch() = default;
+
+    /** @brief Add a statement together with its joined relations and their bound attributes */
+    void add(std::unique_ptr<RamStatement> stmt, std::vector<std::unique_ptr<RamRelationReference>> rels,
+            std::vector<size_t> bound) {
+        assert(rels.size() == bound.size() && "number of bound attributes must match the relations");
+        statements.push_back(std::move(stmt));
+        relations.push_back(std::move(rels));
+        boundAttributes.push_back(std::move(bound));
+    }
+
+    /** @brief Get statements */
+    std::vector<RamStatement*> getStatements() const {
+        return toPtrVector(statements);
+    }
+
+    /** @brief Get the relations joined by the i-th statement, in join order */
+    std::vector<RamRelationReference*> getJoinedRelations(size_t i) const {
+        return toPtrVector(relations[i]);
+    }
+
+    /** @brief Get the number of bound attributes of each relation joined by the i-th statement */
+    const std::vector<size_t>& getBoundAttributes(size_t i) const {
+        return boundAttributes[i];
+    }
+
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos) << "PLAN SWITCH" << std::endl;
+        for (size_t i = 0; i < statements.size(); i++) {
+            os << times(" ", tabpos + 1) << "PLAN ";
+            for (size_t j = 0; j < relations[i].size(); j++) {
+                os << (j > 0 ? "," : "") << relations[i][j]->get()->getName() << "("
+                   << boundAttributes[i][j] << ")";
+            }
+            os << std::endl;
+            statements[i]->print(os, tabpos + 2);
+        }
+        os << times(" ", tabpos) << "END PLAN SWITCH" << std::endl;
+    }
+
+    std::vector<const RamNode*> getChildNodes() const override {
+        std::vector<const RamNode*> res;
+        for (size_t i = 0; i < statements.size(); i++) {
+            res.push_back(statements[i].get());
+            for (const auto& rel : relations[i]) {
+                res.push_back(rel.get());
+            }
+        }
+        return res;
+    }
+
+    RamPlanSwitch* clone() const override {
+        auto* res = new RamPlanSwitch();
+        for (size_t i = 0; i < statements.size(); i++) {
+            std::vector<std::unique_ptr<RamRelationReference>> rels;
+            for (const auto& rel : relations[i]) {
+                rels.emplace_back(rel->clone());
+            }
+            res->add(std::unique_ptr<RamStatement>(statements[i]->clone()), std::move(rels),
+                    boundAttributes[i]);
+        }
+        return res;
+    }
+
+    void apply(const RamNodeMapper& map) override {
+        for (size_t i = 0; i < statements.size(); i++) {
+            statements[i] = map(std::move(statements[i]));
+            for (auto& rel : relations[i]) {
+                rel = map(std::move(rel));
+            }
+        }
+    }
+
+protected:
+    /** alternative statements */
+    std::vector<std::unique_ptr<RamStatement>> statements;
+
+    /** relations joined by each statement */
+    std::vector<std::vector<std::unique_ptr<RamRelationReference>>> relations;
+
+    /** number of bound attributes of the joined relations */
+    std::vector<std::vector<size_t>> boundAttributes;
+
+    bool equal(const RamNode& node) const override {
+        assert(nullptr != dynamic_cast<const RamPlanSwitch*>(&node));
+        const auto& other = static_cast<const RamPlanSwitch&>(node);
+        if (!equal_targets(statements, other.statements) || boundAttributes != other.boundAttributes) {
+            return false;
+        }
+        for (size_t i = 0; i < relations.size(); i++) {
+            if (!equal_targets(relations[i], other.relations[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
 /**
  * @class RamLoop
  * @brief Execute statement until statement terminates loop via an exit statement
@@ -928,8 +1097,8 @@ public:
 
 protected:
     bool equal(const RamNode& node) const override {
-        assert(nullptr != dynamic_cast<const RamLogTimer*>(&node));
-        const auto& other = static_cast<const RamLogTimer&>(node);
+        assert(nullptr != dynamic_cast<const RamDebugInfo*>(&node));
+        const auto& other = static_cast<const RamDebugInfo&>(node);
         return RamAbstractLog::equal(other);
     }
 };
@@ -1034,8 +1203,54 @@ protected:
     }
 };
 
-#ifdef USE_MPI
+/**
+ * @class RamLogDistinctValues
+ * @brief Log the number of distinct values of each column of a relation,
+ *        with a logging message per column.
+ */
+class RamLogDistinctValues : public RamRelationStatement {
+public:
+    RamLogDistinctValues(std::unique_ptr<RamRelationReference> relRef, std::vector<std::string> messages)
+            : RamRelationStatement(std::move(relRef)), messages(std::move(messages)) {}
+
+    /** @brief Get logging messages, indexed by column */
+    const std::vector<std::string>& getMessages() const {
+        return messages;
+    }
+
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos) << "LOGDISTINCT " << getRelation().getName();
+        os << " TEXT ";
+        os << join(messages, ",", [](std::ostream& out, const std::string& msg) {
+            out << "\"" << stringify(msg) << "\"";
+        });
+        os << std::endl;
+    }
+
+    RamLogDistinctValues* clone() const override {
+        return new RamLogDistinctValues(
+                std::unique_ptr<RamRelationReference>(relationRef->clone()), messages);
+    }
 
+protected:
+    /** logging messages */
+    std::vector<std::string> messages;
+
+    bool equal(const RamNode& node) const override {
+        assert(nullptr != dynamic_cast<const RamLogDistinctValues*>(&node));
+        const auto& other = static_cast<const RamLogDistinctValues&>(node);
+        return RamRelationStatement::equal(other) && getMessages() == other.getMessages();
+    }
+};
+
+/**
+ * @class RamRecv
+ * @brief Obtain a relation computed by another stratum
+ *
+ * With the mpi engine the relation is received from the rank evaluating the source
+ * stratum, or from the master process for a source stratum of -1. With the shm
+ * engine the relation is shared and the statement only orders the strata.
+ */
 class RamRecv : public RamRelationStatement {
 public:
     RamRecv(std::unique_ptr<RamRelationReference> r, const int s)
@@ -1068,6 +1283,8 @@ protected:
     }
 };
 
+#ifdef USE_MPI
+
 class RamSend : public RamRelationStatement {
 public:
     RamSend(std::unique_ptr<RamRelationReference> r, const std::set<size_t> s)
@@ -1107,6 +1324,42 @@ protected:
     }
 };
 
+/**
+ * @class RamExchange
+ * @brief Exchange the tuples of a relation derived by the ranks of a partitioned stratum
+ *
+ * Afterwards, every rank evaluating the stratum holds the tuples derived by all of them.
+ */
+class RamExchange : public RamRelationStatement {
+public:
+    RamExchange(std::unique_ptr<RamRelationReference> r) : RamRelationStatement(std::move(r)) {}
+
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos) << "EXCHANGE " << getRelation().getName() << std::endl;
+    }
+
+    RamExchange* clone() const override {
+        return new RamExchange(std::unique_ptr<RamRelationReference>(relationRef->clone()));
+    }
+};
+
+/**
+ * @class RamPartition
+ * @brief Keep the tuples of a relation in the partition of the rank evaluating a partitioned stratum
+ */
+class RamPartition : public RamRelationStatement {
+public:
+    RamPartition(std::unique_ptr<RamRelationReference> r) : RamRelationStatement(std::move(r)) {}
+
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos) << "PARTITION " << getRelation().getName() << std::endl;
+    }
+
+    RamPartition* clone() const override {
+        return new RamPartition(std::unique_ptr<RamRelationReference>(relationRef->clone()));
+    }
+};
+
 class RamNotify : public RamStatement {
 public:
     RamNotify() : RamStatement() {}
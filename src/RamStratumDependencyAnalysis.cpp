@@ -0,0 +1,158 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamStratumDependencyAnalysis.cpp
+ *
+ * Implementation of the dependencies between the strata of a program
+ *
+ ***********************************************************************/
+
+#include "RamStratumDependencyAnalysis.h"
+#include "Global.h"
+#include "IODirectives.h"
+#include "RamExpression.h"
+#include "RamOperation.h"
+#include "RamProgram.h"
+#include "RamRelation.h"
+#include "RamStatement.h"
+#include "RamTranslationUnit.h"
+#include "RamVisitor.h"
+#include "Util.h"
+#include <algorithm>
+#include <limits>
+
+namespace souffle {
+
+void RamStratumDependencyAnalysis::getAccesses(
+        const RamStratum& stratum, std::set<std::string>& writes, std::set<std::string>& reads) {
+    // the names of resources start with a colon, which relation names do not
+    auto addIO = [&](const RamAbstractLoadStore& io) {
+        for (const auto& directives : io.getIODirectives()) {
+            if (!directives.has("IO")) {
+                continue;
+            }
+            const std::string& type = directives.getIOType();
+            if (type == "stdin" || type == "stdout" || type == "stdoutprintsize") {
+                writes.insert(":std");
+            } else if (directives.has("filename")) {
+                writes.insert(":file:" + directives.getFileName());
+            } else if (directives.has("dbname")) {
+                writes.insert(":file:" + directives.get("dbname"));
+            }
+        }
+    };
+
+    visitDepthFirst(stratum, [&](const RamNode& node) {
+        if (const auto* ref = dynamic_cast<const RamRelationReference*>(&node)) {
+            reads.insert(ref->get()->getName());
+        } else if (const auto* project = dynamic_cast<const RamProject*>(&node)) {
+            writes.insert(project->getRelation().getName());
+        } else if (const auto* binary = dynamic_cast<const RamBinRelationStatement*>(&node)) {
+            writes.insert(binary->getFirstRelation().getName());
+            writes.insert(binary->getSecondRelation().getName());
+        } else if (const auto* load = dynamic_cast<const RamLoad*>(&node)) {
+            writes.insert(load->getRelation().getName());
+            addIO(*load);
+        } else if (const auto* store = dynamic_cast<const RamStore*>(&node)) {
+            addIO(*store);
+        } else if (dynamic_cast<const RamCreate*>(&node) != nullptr ||
+                   dynamic_cast<const RamClear*>(&node) != nullptr ||
+                   dynamic_cast<const RamDrop*>(&node) != nullptr ||
+                   dynamic_cast<const RamFact*>(&node) != nullptr) {
+            writes.insert(static_cast<const RamRelationStatement&>(node).getRelation().getName());
+        } else if (dynamic_cast<const RamAutoIncrement*>(&node) != nullptr) {
+            writes.insert(":counter");
+        } else if (dynamic_cast<const RamPackRecord*>(&node) != nullptr) {
+            writes.insert(":records");
+        }
+    });
+
+    for (const auto& cur : writes) {
+        reads.erase(cur);
+    }
+}
+
+void RamStratumDependencyAnalysis::run(const RamTranslationUnit& translationUnit) {
+    const RamStatement& main = *translationUnit.getProgram()->getMain();
+
+    // whether the main program is a sequence of strata only
+    bool onlyStrata = true;
+    if (const auto* sequence = dynamic_cast<const RamSequence*>(&main)) {
+        for (const RamStatement* statement : sequence->getStatements()) {
+            onlyStrata = onlyStrata && dynamic_cast<const RamStratum*>(statement) != nullptr;
+        }
+    } else {
+        onlyStrata = dynamic_cast<const RamStratum*>(&main) != nullptr;
+    }
+
+    std::vector<const RamStratum*> strata;
+    visitDepthFirst(main, [&](const RamStratum& stratum) {
+        if (stratum.getIndex() >= 0 && stratum.getIndex() != std::numeric_limits<int>::max()) {
+            if (strata.size() <= (size_t)stratum.getIndex()) {
+                strata.resize(stratum.getIndex() + 1, nullptr);
+            }
+            strata[stratum.getIndex()] = &stratum;
+        }
+    });
+
+    std::vector<std::set<std::string>> writes(strata.size());
+    std::vector<std::set<std::string>> reads(strata.size());
+    for (size_t i = 0; i < strata.size(); ++i) {
+        if (strata[i] != nullptr) {
+            getAccesses(*strata[i], writes[i], reads[i]);
+        }
+    }
+    auto conflicts = [&](size_t first, size_t second) {
+        for (const auto& cur : writes[first]) {
+            if (writes[second].count(cur) != 0 || reads[second].count(cur) != 0) {
+                return true;
+            }
+        }
+        for (const auto& cur : reads[first]) {
+            if (writes[second].count(cur) != 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // visiting the conflicting strata from the latest, a stratum reached through a later one is implied
+    predecessors.assign(strata.size(), std::vector<int>());
+    std::vector<std::vector<bool>> ancestors(strata.size(), std::vector<bool>(strata.size(), false));
+    bool chain = true;
+    for (size_t j = 0; j < strata.size(); ++j) {
+        for (size_t i = j; i-- > 0;) {
+            if (ancestors[j][i] || !conflicts(i, j)) {
+                continue;
+            }
+            predecessors[j].push_back(i);
+            ancestors[j][i] = true;
+            for (size_t k = 0; k < i; ++k) {
+                if (ancestors[i][k]) {
+                    ancestors[j][k] = true;
+                }
+            }
+        }
+        std::reverse(predecessors[j].begin(), predecessors[j].end());
+        chain = chain && (j == 0 || ancestors[j][j - 1]);
+    }
+
+    concurrent = onlyStrata && !chain && !Global::config().has("engine") &&
+                 !Global::config().has("profile") && !Global::config().has("provenance") &&
+                 !Global::config().has("checkpoints") && !Global::config().has("stratum-cache");
+}
+
+void RamStratumDependencyAnalysis::print(std::ostream& os) const {
+    for (size_t i = 0; i < predecessors.size(); ++i) {
+        os << "stratum " << i << ": " << join(predecessors[i], ", ") << "\n";
+    }
+}
+
+}  // end of namespace souffle
@@ -0,0 +1,71 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RamStratumDependencyAnalysis.h
+ *
+ * Dependencies between the strata of a program restricting their concurrent evaluation
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamAnalysis.h"
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+class RamStratum;
+
+/**
+ * @class RamStratumDependencyAnalysis
+ * @brief Determines the strata each stratum of the main program has to wait for
+ *
+ * A stratum depends on an earlier stratum if one of them modifies a relation the other
+ * accesses, i.e. creates, loads, inserts into, merges, swaps, clears or drops it. Strata
+ * sharing a resource whose use is order dependent depend on each other as well: the same
+ * file or the standard streams, the counter of the $ operator and the numbering of the
+ * records. The dependencies are transitively reduced, such that a stratum only waits for
+ * strata it does not reach through another dependency.
+ */
+class RamStratumDependencyAnalysis : public RamAnalysis {
+public:
+    static constexpr const char* name = "stratum-dependency-analysis";
+
+    void run(const RamTranslationUnit& translationUnit) override;
+
+    void print(std::ostream& os) const override;
+
+    /** Get the strata each stratum depends on, by the index of the stratum */
+    const std::vector<std::vector<int>>& getPredecessors() const {
+        return predecessors;
+    }
+
+    /**
+     * Whether the strata of the main program are to be evaluated concurrently without an
+     * execution engine, i.e. the main program consists of strata only, of which some are
+     * independent, and neither profiling, provenance nor checkpoints rely on their sequential order.
+     */
+    bool isConcurrent() const {
+        return concurrent;
+    }
+
+    /** Get the relations and resources a stratum modifies and those it only reads */
+    static void getAccesses(
+            const RamStratum& stratum, std::set<std::string>& writes, std::set<std::string>& reads);
+
+private:
+    std::vector<std::vector<int>> predecessors;
+    bool concurrent = false;
+};
+
+}  // end of namespace souffle
@@ -15,22 +15,41 @@
  ***********************************************************************/
 
 #include "RamTransformer.h"
+#include "DebugReport.h"
+#include "Global.h"
 #include "RamTranslationUnit.h"
+#include <chrono>
 
 namespace souffle {
 
 bool RamTransformer::apply(RamTranslationUnit& translationUnit) {
+    bool report = !Global::config().get("debug-report").empty();
+    // composite transformers are accounted for by the passes they apply
+    bool record = report && !dynamic_cast<RamTransformerSequence*>(this) &&
+                  !dynamic_cast<RamLoopTransformer*>(this) && !dynamic_cast<RamConditionalTransformer*>(this);
+    size_t memory = record ? DebugReport::getPeakMemory() : 0;
+    auto start = std::chrono::high_resolution_clock::now();
     bool changed = transform(translationUnit);
+    auto end = std::chrono::high_resolution_clock::now();
     if (changed) {
         translationUnit.invalidateAnalyses();
-        std::stringstream ramProgStr;
-        ramProgStr << *translationUnit.getProgram();
-        translationUnit.getDebugReport().addSection(
-                DebugReporter::getCodeSection(getName(), "RAM Program after " + getName(), ramProgStr.str()));
-
-    } else {
-        translationUnit.getDebugReport().addSection(
-                DebugReportSection(getName(), "After " + getName() + " " + " (unchanged)", {}, ""));
+    }
+    if (record) {
+        translationUnit.getDebugReport().addPassStatistics(getName(),
+                std::chrono::duration<double>(end - start).count(), DebugReport::getPeakMemory() - memory,
+                changed);
+    }
+    if (report && DebugReport::isSelected("ram")) {
+        if (changed) {
+            std::stringstream ramProgStr;
+            ramProgStr << *translationUnit.getProgram();
+            DebugReport& debugReport = translationUnit.getDebugReport();
+            debugReport.addSection(debugReport.getCodeVersionSection(
+                    "ram", getName(), "RAM Program after " + getName(), ramProgStr.str()));
+        } else {
+            translationUnit.getDebugReport().addSection(
+                    DebugReportSection(getName(), "After " + getName() + " " + " (unchanged)", {}, ""));
+        }
     }
     /* Abort evaluation of the program if errors were encountered */
     if (translationUnit.getErrorReport().getNumErrors() != 0) {
@@ -16,6 +16,9 @@
 
 #include "RamTransforms.h"
 #include "BinaryConstraintOps.h"
+#include "DebugReport.h"
+#include "FunctorOps.h"
+#include "Global.h"
 #include "RamCondition.h"
 #include "RamExpression.h"
 #include "RamNode.h"
@@ -25,11 +28,551 @@
 #include "RamStatement.h"
 #include "RamTypes.h"
 #include "RamVisitor.h"
+#include "SymbolTable.h"
+#include "Util.h"
+#include "profile/ProgramRun.h"
+#include "profile/Reader.h"
+#include "profile/Relation.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace souffle {
 
+std::unique_ptr<RamExpression> FoldConstantsTransformer::simplify(const RamIntrinsicOperator& op) {
+    using RamUnsigned = std::make_unsigned<RamDomain>::type;
+    const auto& args = op.getArguments();
+
+    auto isNumber = [](const RamExpression* expr, RamDomain value) {
+        const auto* number = dynamic_cast<const RamNumber*>(expr);
+        return number != nullptr && number->getConstant() == value;
+    };
+    auto clone = [](const RamExpression* expr) { return std::unique_ptr<RamExpression>(expr->clone()); };
+
+    // remove operands that do not change the value of the functor
+    if (args.size() == 2) {
+        switch (op.getOperator()) {
+            case FunctorOp::ADD:
+                if (isNumber(args[0], 0)) {
+                    return clone(args[1]);
+                }
+            // fall through
+            case FunctorOp::SUB:
+                if (isNumber(args[1], 0)) {
+                    return clone(args[0]);
+                }
+                break;
+            case FunctorOp::MUL:
+                if (isNumber(args[0], 1)) {
+                    return clone(args[1]);
+                }
+            // fall through
+            case FunctorOp::DIV:
+                if (isNumber(args[1], 1)) {
+                    return clone(args[0]);
+                }
+                break;
+            case FunctorOp::EXP:
+                if (isNumber(args[1], 1)) {
+                    return clone(args[0]);
+                }
+                if (isNumber(args[1], 2) && dynamic_cast<const RamTupleElement*>(args[0]) != nullptr) {
+                    std::vector<std::unique_ptr<RamExpression>> square;
+                    square.push_back(clone(args[0]));
+                    square.push_back(clone(args[0]));
+                    return std::make_unique<RamIntrinsicOperator>(FunctorOp::MUL, std::move(square));
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if (op.getOperator() == FunctorOp::ORD ||
+            (args.size() == 1 && (op.getOperator() == FunctorOp::MAX || op.getOperator() == FunctorOp::MIN ||
+                                         op.getOperator() == FunctorOp::CAT))) {
+        return clone(args[0]);
+    }
+
+    // evaluate functors of constants
+    std::vector<RamDomain> values;
+    for (const RamExpression* arg : args) {
+        const auto* number = dynamic_cast<const RamNumber*>(arg);
+        if (number == nullptr) {
+            return nullptr;
+        }
+        values.push_back(number->getConstant());
+    }
+    auto isSymbol = [&](RamDomain value) { return value >= 0 && (size_t)value < symbolTable->size(); };
+    auto result = [](RamDomain value) { return std::make_unique<RamNumber>(value); };
+    switch (op.getOperator()) {
+        // unary functors
+        case FunctorOp::STRLEN:
+            if (!isSymbol(values[0])) {
+                return nullptr;
+            }
+            return result(symbolTable->resolve(values[0]).size());
+        case FunctorOp::NEG:
+            return result(-(RamUnsigned)values[0]);
+        case FunctorOp::BNOT:
+            return result(~values[0]);
+        case FunctorOp::LNOT:
+            return result(!values[0]);
+        case FunctorOp::TONUMBER:
+            if (!isSymbol(values[0])) {
+                return nullptr;
+            }
+            try {
+                return result(stord(symbolTable->resolve(values[0])));
+            } catch (...) {
+                // the error is reported at run-time
+                return nullptr;
+            }
+        case FunctorOp::TOSTRING:
+            return result(symbolTable->lookup(std::to_string(values[0])));
+
+        // binary functors
+        case FunctorOp::ADD:
+            return result((RamUnsigned)values[0] + (RamUnsigned)values[1]);
+        case FunctorOp::SUB:
+            return result((RamUnsigned)values[0] - (RamUnsigned)values[1]);
+        case FunctorOp::MUL:
+            return result((RamUnsigned)values[0] * (RamUnsigned)values[1]);
+        case FunctorOp::DIV:
+        case FunctorOp::MOD:
+            if (values[1] == 0 || (values[0] == MIN_RAM_DOMAIN && values[1] == -1)) {
+                return nullptr;
+            }
+            return result(op.getOperator() == FunctorOp::DIV ? values[0] / values[1] : values[0] % values[1]);
+        case FunctorOp::EXP: {
+            double value = std::pow(values[0], values[1]);
+            if (!(value >= MIN_RAM_DOMAIN && value <= MAX_RAM_DOMAIN)) {
+                return nullptr;
+            }
+            return result(value);
+        }
+        case FunctorOp::BAND:
+            return result(values[0] & values[1]);
+        case FunctorOp::BOR:
+            return result(values[0] | values[1]);
+        case FunctorOp::BXOR:
+            return result(values[0] ^ values[1]);
+        case FunctorOp::LAND:
+            return result(values[0] && values[1]);
+        case FunctorOp::LOR:
+            return result(values[0] || values[1]);
+
+        // n-ary functors
+        case FunctorOp::MAX:
+            return result(*std::max_element(values.begin(), values.end()));
+        case FunctorOp::MIN:
+            return result(*std::min_element(values.begin(), values.end()));
+        case FunctorOp::CAT: {
+            std::string str;
+            for (RamDomain value : values) {
+                if (!isSymbol(value)) {
+                    return nullptr;
+                }
+                str += symbolTable->resolve(value);
+            }
+            return result(symbolTable->lookup(str));
+        }
+
+        // ternary functors
+        case FunctorOp::SUBSTR:
+            if (!isSymbol(values[0])) {
+                return nullptr;
+            }
+            try {
+                const std::string& str = symbolTable->resolve(values[0]);
+                return result(symbolTable->lookup(str.substr(values[1], values[2])));
+            } catch (...) {
+                // the warning is reported at run-time
+                return nullptr;
+            }
+
+        default:
+            return nullptr;
+    }
+}
+
+bool FoldConstantsTransformer::foldConstants(RamProgram& program) {
+    // flag to determine whether the RAM program has changed
+    bool changed = false;
+
+    // simplify expressions bottom-up, so that folded arguments are folded further
+    std::function<std::unique_ptr<RamNode>(std::unique_ptr<RamNode>)> simplifier =
+            [&](std::unique_ptr<RamNode> node) -> std::unique_ptr<RamNode> {
+        node->apply(makeLambdaRamMapper(simplifier));
+        if (const auto* op = dynamic_cast<RamIntrinsicOperator*>(node.get())) {
+            if (std::unique_ptr<RamExpression> expr = simplify(*op)) {
+                changed = true;
+                return std::move(expr);
+            }
+        }
+        return node;
+    };
+    program.apply(makeLambdaRamMapper(simplifier));
+
+    return changed;
+}
+
+bool FuseRelationsTransformer::fuseRelations(RamProgram& program) {
+    // the relations recorded by provenance, profiles and the strata must be kept
+    for (const char* option :
+            {"provenance", "profile", "engine", "stratum-cache", "watch", "incremental", "checkpoints"}) {
+        if (Global::config().has(option)) {
+            return false;
+        }
+    }
+
+    // fusing a relation may allow fusing the relation its reader writes
+    bool changed = false;
+    for (bool fused = true; fused;) {
+        fused = false;
+        for (const auto& cur : program.getAllRelations()) {
+            if (fuseRelation(program, *cur.second)) {
+                fused = changed = true;
+                break;
+            }
+        }
+    }
+    return changed;
+}
+
+bool FuseRelationsTransformer::fuseRelation(RamProgram& program, const RamRelation& rel) {
+    // equivalence relations close their tuples, custom storages may keep them elsewhere
+    switch (rel.getRepresentation()) {
+        case RelationRepresentation::DEFAULT:
+        case RelationRepresentation::BTREE:
+        case RelationRepresentation::BRIE:
+        case RelationRepresentation::HASHSET:
+            break;
+        default:
+            return false;
+    }
+    if (rel.isTemp() || rel.isNullary()) {
+        return false;
+    }
+    const RamStatement& main = *program.getMain();
+
+    // the single writer and reader of the relation, and the statements creating and dropping it
+    const RamQuery* producer = nullptr;
+    const RamQuery* consumer = nullptr;
+    const RamProject* projection = nullptr;
+    const RamRelationOperation* scan = nullptr;
+    size_t writes = 0;
+    size_t reads = 0;
+    std::vector<const RamStatement*> lifetime;
+    visitDepthFirst(main, [&](const RamQuery& query) {
+        visitDepthFirst(query, [&](const RamProject& project) {
+            if (&project.getRelation() == &rel) {
+                producer = &query;
+                projection = &project;
+                writes++;
+            }
+        });
+        visitDepthFirst(query, [&](const RamRelationOperation& op) {
+            if (&op.getRelation() == &rel) {
+                consumer = &query;
+                scan = &op;
+                reads++;
+            }
+        });
+    });
+    visitDepthFirst(main, [&](const RamRelationStatement& stmt) {
+        if (&stmt.getRelation() == &rel &&
+                (dynamic_cast<const RamCreate*>(&stmt) != nullptr ||
+                        dynamic_cast<const RamDrop*>(&stmt) != nullptr)) {
+            lifetime.push_back(&stmt);
+        }
+    });
+    if (writes != 1 || reads != 1 || producer == consumer ||
+            (dynamic_cast<const RamScan*>(scan) == nullptr &&
+                    dynamic_cast<const RamIndexScan*>(scan) == nullptr)) {
+        return false;
+    }
+
+    // the reader may only check whether the relation is non-empty besides scanning it
+    auto isNonEmptinessCheck = [&](const RamCondition& condition) {
+        const auto* negation = dynamic_cast<const RamNegation*>(&condition);
+        const auto* check = negation != nullptr
+                                     ? dynamic_cast<const RamEmptinessCheck*>(&negation->getOperand())
+                                     : nullptr;
+        return check != nullptr && &check->getRelation() == &rel;
+    };
+    size_t checks = 0;
+    visitDepthFirst(*consumer, [&](const RamEmptinessCheck& check) {
+        if (&check.getRelation() == &rel) {
+            checks++;
+        }
+    });
+    size_t references = 0;
+    visitDepthFirst(program, [&](const RamRelationReference& ref) {
+        if (ref.get() == &rel) {
+            references++;
+        }
+    });
+    if (references != lifetime.size() + writes + reads + checks) {
+        return false;
+    }
+
+    // the writer is evaluated once, before the reader, which must itself not be repeated
+    bool repeated = false;
+    visitDepthFirst(main, [&](const RamStatement& stmt) {
+        if (dynamic_cast<const RamLoop*>(&stmt) != nullptr ||
+                dynamic_cast<const RamPlanSwitch*>(&stmt) != nullptr) {
+            visitDepthFirst(stmt, [&](const RamQuery& query) {
+                repeated = repeated || &query == producer || &query == consumer;
+            });
+        }
+    });
+    std::vector<const RamStatement*> order;
+    visitDepthFirst(main, [&](const RamStatement& stmt) { order.push_back(&stmt); });
+    const auto producerPos = std::find(order.begin(), order.end(), producer);
+    const auto consumerPos = std::find(order.begin(), order.end(), consumer);
+    if (repeated || consumerPos < producerPos) {
+        return false;
+    }
+
+    // the relations read by the writer must not change until the reader, their drops are moved after it
+    std::set<const RamRelation*> inputs;
+    visitDepthFirst(*producer, [&](const RamRelationReference& ref) {
+        if (ref.get() != &rel) {
+            inputs.insert(ref.get());
+        }
+    });
+    std::vector<const RamDrop*> drops;
+    for (auto it = producerPos + 1; it != consumerPos; ++it) {
+        const RamStatement& stmt = **it;
+        bool modifies = false;
+        if (const auto* drop = dynamic_cast<const RamDrop*>(&stmt)) {
+            if (inputs.count(&drop->getRelation()) != 0) {
+                drops.push_back(drop);
+            }
+        } else if (const auto* query = dynamic_cast<const RamQuery*>(&stmt)) {
+            visitDepthFirst(*query, [&](const RamProject& project) {
+                modifies = modifies || inputs.count(&project.getRelation()) != 0;
+            });
+        } else if (const auto* relStmt = dynamic_cast<const RamRelationStatement*>(&stmt)) {
+            bool reading = dynamic_cast<const RamStore*>(relStmt) != nullptr ||
+                           dynamic_cast<const RamLogSize*>(relStmt) != nullptr ||
+                           dynamic_cast<const RamLogDistinctValues*>(relStmt) != nullptr ||
+                           dynamic_cast<const RamLogRelationTimer*>(relStmt) != nullptr;
+            modifies = !reading && inputs.count(&relStmt->getRelation()) != 0;
+        } else if (const auto* binStmt = dynamic_cast<const RamBinRelationStatement*>(&stmt)) {
+            modifies = inputs.count(&binStmt->getFirstRelation()) != 0 ||
+                       inputs.count(&binStmt->getSecondRelation()) != 0;
+        }
+        if (modifies) {
+            return false;
+        }
+    }
+
+    // the writer is a loop nest of scans and filters, whose projection determines the tuples it scans
+    std::vector<std::unique_ptr<RamExpression>> columns;
+    std::vector<std::pair<const RamExpression*, const RamExpression*>> equalities;
+    std::vector<std::unique_ptr<RamCondition>> conditions;
+    std::vector<const RamRelationOperation*> scans;
+    const RamOperation* op = &producer->getOperation();
+    while (op != projection) {
+        if (const auto* filter = dynamic_cast<const RamFilter*>(op)) {
+            for (auto& condition : toConjunctionList(&filter->getCondition())) {
+                const auto* constraint = dynamic_cast<const RamConstraint*>(condition.get());
+                if (constraint != nullptr && constraint->getOperator() == BinaryConstraintOp::EQ) {
+                    equalities.emplace_back(&constraint->getLHS(), &constraint->getRHS());
+                }
+                conditions.push_back(std::move(condition));
+            }
+            op = &filter->getOperation();
+        } else if (dynamic_cast<const RamScan*>(op) != nullptr ||
+                   dynamic_cast<const RamIndexScan*>(op) != nullptr) {
+            const auto* search = static_cast<const RamRelationOperation*>(op);
+            if (const auto* indexScan = dynamic_cast<const RamIndexScan*>(op)) {
+                const auto pattern = indexScan->getRangePattern();
+                for (size_t i = 0; i < pattern.size(); i++) {
+                    if (!isRamUndefValue(pattern[i])) {
+                        columns.push_back(std::make_unique<RamTupleElement>(search->getTupleId(), i));
+                        equalities.emplace_back(columns.back().get(), pattern[i]);
+                    }
+                }
+            }
+            scans.push_back(search);
+            op = &search->getOperation();
+        } else {
+            return false;
+        }
+    }
+    const auto values = projection->getValues();
+    bool pure = true;
+    for (const RamExpression* value : values) {
+        visitDepthFirst(*value, [&](const RamAutoIncrement&) { pure = false; });
+        visitDepthFirst(*value, [&](const RamUserDefinedOperator&) { pure = false; });
+    }
+    if (!pure) {
+        return false;
+    }
+
+    // the columns determined by the projection, closed under the equalities
+    std::set<std::pair<int, size_t>> determined;
+    auto isDetermined = [&](const RamExpression& expr) {
+        bool res = true;
+        visitDepthFirst(expr, [&](const RamTupleElement& element) {
+            res = res && determined.count({element.getTupleId(), element.getElement()}) != 0;
+        });
+        return res;
+    };
+    for (const RamExpression* value : values) {
+        if (const auto* element = dynamic_cast<const RamTupleElement*>(value)) {
+            determined.insert({element->getTupleId(), element->getElement()});
+        }
+    }
+    for (bool grown = true; grown;) {
+        grown = false;
+        for (const auto& equality : equalities) {
+            for (const auto& side : {equality, std::make_pair(equality.second, equality.first)}) {
+                const auto* element = dynamic_cast<const RamTupleElement*>(side.first);
+                if (element != nullptr && !isDetermined(*element) && isDetermined(*side.second)) {
+                    determined.insert({element->getTupleId(), element->getElement()});
+                    grown = true;
+                }
+            }
+        }
+    }
+    for (const RamRelationOperation* search : scans) {
+        for (size_t i = 0; i < search->getRelation().getArity(); i++) {
+            if (determined.count({search->getTupleId(), i}) == 0) {
+                return false;
+            }
+        }
+    }
+
+    // the reader scans the relation in its outermost loop, below conditions independent of its tuples
+    std::vector<const RamCondition*> outer;
+    op = &consumer->getOperation();
+    while (const auto* filter = dynamic_cast<const RamFilter*>(op)) {
+        outer.push_back(&filter->getCondition());
+        op = &filter->getOperation();
+    }
+    if (op != scan) {
+        return false;
+    }
+
+    // the tuples of the reader are numbered after those of the writer
+    int offset = 0;
+    visitDepthFirst(*producer, [&](const RamTupleOperation& tupleOp) {
+        offset = std::max(offset, tupleOp.getTupleId() + 1);
+    });
+    std::function<std::unique_ptr<RamNode>(std::unique_ptr<RamNode>)> rebind =
+            [&](std::unique_ptr<RamNode> node) -> std::unique_ptr<RamNode> {
+        if (const auto* element = dynamic_cast<RamTupleElement*>(node.get())) {
+            if (element->getTupleId() == scan->getTupleId()) {
+                return std::unique_ptr<RamExpression>(values[element->getElement()]->clone());
+            }
+            return std::make_unique<RamTupleElement>(element->getTupleId() + offset, element->getElement());
+        }
+        if (auto* tupleOp = dynamic_cast<RamTupleOperation*>(node.get())) {
+            tupleOp->setTupleId(tupleOp->getTupleId() + offset);
+        }
+        node->apply(makeLambdaRamMapper(rebind));
+        return node;
+    };
+
+    // the relation is non-empty wherever a tuple of it is read
+    std::function<std::unique_ptr<RamNode>(std::unique_ptr<RamNode>)> dropChecks =
+            [&](std::unique_ptr<RamNode> node) -> std::unique_ptr<RamNode> {
+        node->apply(makeLambdaRamMapper(dropChecks));
+        if (const auto* filter = dynamic_cast<RamFilter*>(node.get())) {
+            std::vector<const RamCondition*> kept;
+            auto list = toConjunctionList(&filter->getCondition());
+            for (const auto& condition : list) {
+                if (!isNonEmptinessCheck(*condition)) {
+                    kept.push_back(condition.get());
+                }
+            }
+            if (kept.empty()) {
+                return std::unique_ptr<RamOperation>(filter->getOperation().clone());
+            } else if (kept.size() < list.size()) {
+                return std::make_unique<RamFilter>(
+                        toCondition(kept), std::unique_ptr<RamOperation>(filter->getOperation().clone()));
+            }
+        }
+        return node;
+    };
+
+    // the operation of the reader for each tuple, checking the values searched by its index
+    auto nested = std::unique_ptr<RamOperation>(scan->getOperation().clone());
+    nested = std::unique_ptr<RamOperation>(static_cast<RamOperation*>(rebind(std::move(nested)).release()));
+    if (const auto* indexScan = dynamic_cast<const RamIndexScan*>(scan)) {
+        const auto pattern = indexScan->getRangePattern();
+        for (size_t i = pattern.size(); i-- > 0;) {
+            if (!isRamUndefValue(pattern[i])) {
+                nested = std::make_unique<RamFilter>(
+                        std::make_unique<RamConstraint>(BinaryConstraintOp::EQ,
+                                std::unique_ptr<RamExpression>(values[i]->clone()),
+                                std::unique_ptr<RamExpression>(pattern[i]->clone())),
+                        std::move(nested));
+            }
+        }
+    }
+
+    // the loop nest of the writer projecting into the reader, below the conditions of the reader
+    std::function<std::unique_ptr<RamNode>(std::unique_ptr<RamNode>)> splice =
+            [&](std::unique_ptr<RamNode> node) -> std::unique_ptr<RamNode> {
+        if (const auto* project = dynamic_cast<RamProject*>(node.get())) {
+            if (&project->getRelation() == &rel) {
+                return std::move(nested);
+            }
+        }
+        node->apply(makeLambdaRamMapper(splice));
+        return node;
+    };
+    auto fused = std::unique_ptr<RamOperation>(producer->getOperation().clone());
+    fused->apply(makeLambdaRamMapper(splice));
+    for (auto it = outer.rbegin(); it != outer.rend(); ++it) {
+        fused = std::make_unique<RamFilter>(std::unique_ptr<RamCondition>((*it)->clone()), std::move(fused));
+    }
+    fused = std::unique_ptr<RamOperation>(static_cast<RamOperation*>(dropChecks(std::move(fused)).release()));
+    bool dangling = false;
+    visitDepthFirst(
+            *fused, [&](const RamRelationReference& ref) { dangling = dangling || ref.get() == &rel; });
+    if (dangling) {
+        return false;
+    }
+
+    // replace the reader, and remove the writer and the statements of the relation
+    std::map<const RamNode*, std::unique_ptr<RamStatement>> replacements;
+    auto reader = std::make_unique<RamSequence>(std::make_unique<RamQuery>(std::move(fused)));
+    for (const RamDrop* drop : drops) {
+        reader->add(std::unique_ptr<RamStatement>(drop->clone()));
+        replacements[drop] = std::make_unique<RamSequence>();
+    }
+    replacements[consumer] = std::move(reader);
+    replacements[producer] = std::make_unique<RamSequence>();
+    for (const RamStatement* stmt : lifetime) {
+        replacements[stmt] = std::make_unique<RamSequence>();
+    }
+    std::function<std::unique_ptr<RamNode>(std::unique_ptr<RamNode>)> replace =
+            [&](std::unique_ptr<RamNode> node) -> std::unique_ptr<RamNode> {
+        auto it = replacements.find(node.get());
+        if (it != replacements.end()) {
+            return std::move(it->second);
+        }
+        node->apply(makeLambdaRamMapper(replace));
+        return node;
+    };
+    program.getMain()->apply(makeLambdaRamMapper(replace));
+    const std::string name = rel.getName();
+    program.removeRelation(name);
+    return true;
+}
+
 bool ExpandFilterTransformer::expandFilters(RamProgram& program) {
     // flag to determine whether the RAM program has changed
     bool changed = false;
@@ -187,6 +730,16 @@ bool HoistConditionsTransformer::hoistConditions(RamProgram& program) {
     return changed;
 }
 
+namespace {
+
+/** Whether the indexes of a relation are b-trees ordering the tuples by the signed values of their columns */
+bool hasSignedOrder(const RamRelation& rel) {
+    return rel.getRepresentation() == RelationRepresentation::BTREE ||
+           (rel.getRepresentation() == RelationRepresentation::DEFAULT && rel.getArity() <= 6);
+}
+
+}  // namespace
+
 std::unique_ptr<RamExpression> MakeIndexTransformer::getExpression(
         RamCondition* c, size_t& element, int identifier) {
     if (auto* binRelOp = dynamic_cast<RamConstraint*>(c)) {
@@ -252,6 +805,97 @@ std::unique_ptr<RamCondition> MakeIndexTransformer::constructPattern(
     return condition;
 }
 
+std::unique_ptr<RamExpression> MakeIndexTransformer::getBound(
+        RamCondition* c, size_t& element, bool& lower, int identifier) {
+    auto* binRelOp = dynamic_cast<RamConstraint*>(c);
+    if (binRelOp == nullptr) {
+        return nullptr;
+    }
+    const BinaryConstraintOp op = binRelOp->getOperator();
+    const bool less = op == BinaryConstraintOp::LT || op == BinaryConstraintOp::LE;
+    if (!less && op != BinaryConstraintOp::GT && op != BinaryConstraintOp::GE) {
+        return nullptr;
+    }
+    // t1.x < e bounds t1.x from above, e < t1.x from below
+    if (const auto* lhs = dynamic_cast<const RamTupleElement*>(&binRelOp->getLHS())) {
+        const RamExpression* rhs = &binRelOp->getRHS();
+        if (lhs->getTupleId() == identifier && rla->getLevel(rhs) < identifier) {
+            element = lhs->getElement();
+            lower = !less;
+            return std::unique_ptr<RamExpression>(rhs->clone());
+        }
+    }
+    if (const auto* rhs = dynamic_cast<const RamTupleElement*>(&binRelOp->getRHS())) {
+        const RamExpression* lhs = &binRelOp->getLHS();
+        if (rhs->getTupleId() == identifier && rla->getLevel(lhs) < identifier) {
+            element = rhs->getElement();
+            lower = less;
+            return std::unique_ptr<RamExpression>(lhs->clone());
+        }
+    }
+    return nullptr;
+}
+
+std::unique_ptr<RamOperation> MakeIndexTransformer::rewriteRange(const RamRelationOperation* scan) {
+    const auto* iscan = dynamic_cast<const RamIndexScan*>(scan);
+    const auto* filter = dynamic_cast<const RamFilter*>(&scan->getOperation());
+    const RamRelation& rel = scan->getRelation();
+    if (filter == nullptr || (iscan != nullptr && iscan->hasRange()) || !hasSignedOrder(rel) ||
+            dynamic_cast<const RamAbstractParallel*>(scan) != nullptr) {
+        return nullptr;
+    }
+    const int identifier = scan->getTupleId();
+
+    // the lower and upper bounds of the columns not bound by the index; strict inequalities are
+    // bounded inclusively, the filter remains in place and checks every tuple of the range
+    std::map<size_t, std::pair<std::unique_ptr<RamExpression>, std::unique_ptr<RamExpression>>> bounds;
+    for (auto& cond : toConjunctionList(&filter->getCondition())) {
+        size_t element = 0;
+        bool lower = false;
+        if (std::unique_ptr<RamExpression> value = getBound(cond.get(), element, lower, identifier)) {
+            if (iscan != nullptr && !isRamUndefValue(iscan->getRangePattern()[element])) {
+                continue;
+            }
+            auto& bound = lower ? bounds[element].first : bounds[element].second;
+            if (bound == nullptr) {
+                bound = std::move(value);
+            }
+        }
+    }
+    if (bounds.empty()) {
+        return nullptr;
+    }
+
+    // a column bounded on both sides is preferred
+    auto range = bounds.begin();
+    for (auto it = bounds.begin(); it != bounds.end(); ++it) {
+        if (it->second.first != nullptr && it->second.second != nullptr) {
+            range = it;
+            break;
+        }
+    }
+    auto lower = std::move(range->second.first);
+    auto upper = std::move(range->second.second);
+    if (lower == nullptr) {
+        lower = std::make_unique<RamUndefValue>();
+    }
+    if (upper == nullptr) {
+        upper = std::make_unique<RamUndefValue>();
+    }
+
+    std::vector<std::unique_ptr<RamExpression>> queryPattern;
+    for (size_t i = 0; i < rel.getArity(); i++) {
+        if (iscan != nullptr) {
+            queryPattern.push_back(std::unique_ptr<RamExpression>(iscan->getRangePattern()[i]->clone()));
+        } else {
+            queryPattern.push_back(std::make_unique<RamUndefValue>());
+        }
+    }
+    return std::make_unique<RamIndexScan>(std::make_unique<RamRelationReference>(&rel), identifier,
+            std::move(queryPattern), (int)range->first, std::move(lower), std::move(upper),
+            std::unique_ptr<RamOperation>(filter->clone()), scan->getProfileText());
+}
+
 std::unique_ptr<RamOperation> MakeIndexTransformer::rewriteAggregate(const RamAggregate* agg) {
     if (dynamic_cast<const RamTrue*>(&agg->getCondition()) == nullptr) {
         const RamRelation& rel = agg->getRelation();
@@ -343,11 +987,17 @@ bool MakeIndexTransformer::makeIndex(RamProgram& program) {
                 if (std::unique_ptr<RamOperation> op = rewriteScan(scan)) {
                     changed = true;
                     node = std::move(op);
+                } else if (std::unique_ptr<RamOperation> op = rewriteRange(scan)) {
+                    changed = true;
+                    node = std::move(op);
                 }
             } else if (const RamIndexScan* iscan = dynamic_cast<RamIndexScan*>(node.get())) {
                 if (std::unique_ptr<RamOperation> op = rewriteIndexScan(iscan)) {
                     changed = true;
                     node = std::move(op);
+                } else if (std::unique_ptr<RamOperation> op = rewriteRange(iscan)) {
+                    changed = true;
+                    node = std::move(op);
                 }
             } else if (const RamAggregate* agg = dynamic_cast<RamAggregate*>(node.get())) {
                 if (std::unique_ptr<RamOperation> op = rewriteAggregate(agg)) {
@@ -363,6 +1013,241 @@ bool MakeIndexTransformer::makeIndex(RamProgram& program) {
     return changed;
 }
 
+namespace {
+
+/** Get the name of the relation whose auxiliary relation is given, or of the given relation */
+std::string getBaseName(const RamRelation& rel) {
+    std::string name = rel.getName();
+    for (const std::string prefix : {"@delta_", "@new_"}) {
+        if (name.compare(0, prefix.size(), prefix) == 0) {
+            name = name.substr(prefix.size());
+        }
+    }
+    return name;
+}
+
+/** Get the attributes of a search signature */
+std::vector<int> getAttributes(SearchSignature search) {
+    std::vector<int> res;
+    for (int i = 0; search != 0; i++, search >>= 1) {
+        if ((search & 1) != 0) {
+            res.push_back(i);
+        }
+    }
+    return res;
+}
+
+}  // namespace
+
+size_t IndexBudgetTransformer::getBudget(const RamRelation& rel) const {
+    auto pos = relationBudgets.find(getBaseName(rel));
+    return (pos != relationBudgets.end()) ? pos->second : budget;
+}
+
+std::map<SearchSignature, SearchSignature> IndexBudgetTransformer::selectReplacements(
+        const RamRelation& rel, const std::set<SearchSignature>& pinned) {
+    const MinIndexSelection& indexes = isa->getIndexes(rel);
+    const auto orders = indexes.getAllOrders();
+    const auto chains = indexes.getAllChains();
+
+    // the longest non-empty prefix of an index other than the given one covered by a search
+    auto getPrefix = [&](SearchSignature search, size_t dropped) {
+        SearchSignature res = 0;
+        for (size_t i = 0; i < orders.size(); i++) {
+            if (i == dropped) {
+                continue;
+            }
+            SearchSignature prefix = 0;
+            for (int attribute : orders[i]) {
+                if ((search & (1 << attribute)) == 0) {
+                    break;
+                }
+                prefix |= (1 << attribute);
+                if (__builtin_popcount(prefix) > __builtin_popcount(res)) {
+                    res = prefix;
+                }
+            }
+        }
+        return res;
+    };
+
+    // the searches of auxiliary relations are estimated by the statistics of their relation
+    const RelationStatistics* stats =
+            (statistics != nullptr) ? statistics->getRelation(getBaseName(rel)) : nullptr;
+
+    // select the index whose searches lose the fewest bound attributes, or scan the fewest additional tuples
+    std::map<SearchSignature, SearchSignature> res;
+    double minLoss = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < chains.size(); i++) {
+        // indexes covering ordered searches of intersections only cannot be dropped
+        if (chains[i].empty()) {
+            continue;
+        }
+        std::map<SearchSignature, SearchSignature> replacements;
+        double loss = 0;
+        for (SearchSignature search : chains[i]) {
+            SearchSignature prefix = getPrefix(search, i);
+            if (pinned.find(search) != pinned.end() || prefix == 0) {
+                loss = std::numeric_limits<double>::max();
+                break;
+            }
+            replacements[search] = prefix;
+            if (stats != nullptr) {
+                loss += stats->getFanOut(getAttributes(prefix)) - stats->getFanOut(getAttributes(search));
+            } else {
+                loss += __builtin_popcount(search) - __builtin_popcount(prefix);
+            }
+        }
+        if (loss < minLoss) {
+            minLoss = loss;
+            res = std::move(replacements);
+        }
+    }
+    return res;
+}
+
+void IndexBudgetTransformer::rewriteSearches(RamProgram& program, const std::set<const RamRelation*>& rels,
+        const std::map<SearchSignature, SearchSignature>& replacements) {
+    // restrict a query pattern to the replacing signature, returning the equalities no longer searched
+    auto restrictPattern = [&](const RamIndexOperation& search,
+                                   std::vector<std::unique_ptr<RamExpression>>& queryPattern)
+            -> std::unique_ptr<RamCondition> {
+        if (rels.find(&search.getRelation()) == rels.end()) {
+            return nullptr;
+        }
+        auto pos = replacements.find(isa->getSearchSignature(&search));
+        if (pos == replacements.end()) {
+            return nullptr;
+        }
+        std::unique_ptr<RamCondition> condition;
+        const auto pattern = search.getRangePattern();
+        for (size_t i = 0; i < pattern.size(); i++) {
+            if (isRamUndefValue(pattern[i]) || (pos->second & (1 << i)) != 0) {
+                queryPattern.push_back(std::unique_ptr<RamExpression>(pattern[i]->clone()));
+                continue;
+            }
+            queryPattern.push_back(std::make_unique<RamUndefValue>());
+            auto constraint = std::make_unique<RamConstraint>(BinaryConstraintOp::EQ,
+                    std::make_unique<RamTupleElement>(search.getTupleId(), i),
+                    std::unique_ptr<RamExpression>(pattern[i]->clone()));
+            if (condition != nullptr) {
+                condition = std::make_unique<RamConjunction>(std::move(condition), std::move(constraint));
+            } else {
+                condition = std::move(constraint);
+            }
+        }
+        return condition;
+    };
+
+    visitDepthFirst(program, [&](const RamQuery& query) {
+        std::function<std::unique_ptr<RamNode>(std::unique_ptr<RamNode>)> searchRewriter =
+                [&](std::unique_ptr<RamNode> node) -> std::unique_ptr<RamNode> {
+            std::vector<std::unique_ptr<RamExpression>> queryPattern;
+            if (const auto* iscan = dynamic_cast<RamIndexScan*>(node.get())) {
+                if (std::unique_ptr<RamCondition> condition = restrictPattern(*iscan, queryPattern)) {
+                    auto op = std::make_unique<RamFilter>(std::move(condition),
+                            std::unique_ptr<RamOperation>(iscan->getOperation().clone()));
+                    // the range of a column, which requires the restricted search, is dropped as well
+                    auto relRef = std::make_unique<RamRelationReference>(&iscan->getRelation());
+                    if (dynamic_cast<const RamParallelIndexScan*>(iscan) != nullptr) {
+                        node = std::make_unique<RamParallelIndexScan>(std::move(relRef), iscan->getTupleId(),
+                                std::move(queryPattern), std::move(op), iscan->getProfileText());
+                    } else {
+                        node = std::make_unique<RamIndexScan>(std::move(relRef), iscan->getTupleId(),
+                                std::move(queryPattern), std::move(op), iscan->getProfileText());
+                    }
+                }
+            } else if (const auto* agg = dynamic_cast<RamIndexAggregate*>(node.get())) {
+                if (std::unique_ptr<RamCondition> condition = restrictPattern(*agg, queryPattern)) {
+                    if (!isRamTrue(&agg->getCondition())) {
+                        condition = std::make_unique<RamConjunction>(
+                                std::unique_ptr<RamCondition>(agg->getCondition().clone()),
+                                std::move(condition));
+                    }
+                    node = std::make_unique<RamIndexAggregate>(
+                            std::unique_ptr<RamOperation>(agg->getOperation().clone()), agg->getFunction(),
+                            std::make_unique<RamRelationReference>(&agg->getRelation()),
+                            std::unique_ptr<RamExpression>(agg->getExpression().clone()),
+                            std::move(condition), std::move(queryPattern), agg->getTupleId());
+                }
+            }
+            node->apply(makeLambdaRamMapper(searchRewriter));
+            return node;
+        };
+        const_cast<RamQuery*>(&query)->apply(makeLambdaRamMapper(searchRewriter));
+    });
+}
+
+bool IndexBudgetTransformer::reduceIndexes(RamTranslationUnit& translationUnit) {
+    RamProgram& program = *translationUnit.getProgram();
+    bool changed = false;
+    if (statistics == nullptr && Global::config().has("statistics")) {
+        statistics = std::make_unique<StatisticsCatalog>(Global::config().get("statistics"));
+    }
+
+    // relations involved in a swap share their indexes
+    std::map<const RamRelation*, const RamRelation*> swapped;
+    visitDepthFirst(program, [&](const RamSwap& swap) {
+        swapped[&swap.getFirstRelation()] = &swap.getSecondRelation();
+        swapped[&swap.getSecondRelation()] = &swap.getFirstRelation();
+    });
+
+    for (const auto& cur : program.getAllRelations()) {
+        const RamRelation& rel = *cur.second;
+        if (rel.getArity() == 0 || rel.getRepresentation() == RelationRepresentation::EQREL) {
+            continue;
+        }
+        std::set<const RamRelation*> rels = {&rel};
+        if (swapped.find(&rel) != swapped.end()) {
+            rels.insert(swapped[&rel]);
+        }
+
+        while (true) {
+            isa = translationUnit.getAnalysis<RamIndexAnalysis>();
+            if (isa->getIndexes(rel).getAllOrders().size() <= getBudget(rel)) {
+                break;
+            }
+
+            // only index scans and indexed aggregates can be rewritten to filtered searches
+            std::set<SearchSignature> pinned = {isa->getSearchSignature(&rel)};
+            visitDepthFirst(program, [&](const RamNode& node) {
+                if (const auto* search = dynamic_cast<const RamIndexOperation*>(&node)) {
+                    if (rels.find(&search->getRelation()) != rels.end() &&
+                            dynamic_cast<const RamIndexScan*>(search) == nullptr &&
+                            dynamic_cast<const RamIndexAggregate*>(search) == nullptr) {
+                        pinned.insert(isa->getSearchSignature(search));
+                    }
+                } else if (const auto* exists = dynamic_cast<const RamExistenceCheck*>(&node)) {
+                    if (rels.find(&exists->getRelation()) != rels.end()) {
+                        pinned.insert(isa->getSearchSignature(exists));
+                    }
+                } else if (const auto* provExists = dynamic_cast<const RamProvenanceExistenceCheck*>(&node)) {
+                    if (rels.find(&provExists->getRelation()) != rels.end()) {
+                        pinned.insert(isa->getSearchSignature(provExists));
+                    }
+                }
+            });
+
+            std::map<SearchSignature, SearchSignature> replacements = selectReplacements(rel, pinned);
+            if (replacements.empty()) {
+                break;
+            }
+            rewriteSearches(program, rels, replacements);
+            translationUnit.invalidateAnalyses();
+            changed = true;
+        }
+    }
+
+    // report the resulting indexes
+    if (!Global::config().get("debug-report").empty() && DebugReport::isSelected("index-selection")) {
+        std::stringstream report;
+        translationUnit.getAnalysis<RamIndexAnalysis>()->print(report);
+        translationUnit.getDebugReport().addSection(
+                DebugReporter::getCodeSection("index-selection", "Index Selection", report.str()));
+    }
+    return changed;
+}
+
 std::unique_ptr<RamOperation> IfConversionTransformer::rewriteIndexScan(const RamIndexScan* indexScan) {
     // check whether tuple is used in subsequent operations
     bool tupleNotUsed = true;
@@ -456,6 +1341,11 @@ std::unique_ptr<RamOperation> ChoiceConversionTransformer::rewriteScan(const Ram
 std::unique_ptr<RamOperation> ChoiceConversionTransformer::rewriteIndexScan(const RamIndexScan* indexScan) {
     bool transformTuple = false;
 
+    // a search of a range is kept, as the choice would search the bound columns only
+    if (indexScan->hasRange()) {
+        return nullptr;
+    }
+
     // Check that RamFilter follows the IndexScan in the loop nest
     if (const auto* filter = dynamic_cast<const RamFilter*>(&indexScan->getOperation())) {
         // Check that the Filter uses the identifier in the IndexScan
@@ -521,6 +1411,128 @@ bool ChoiceConversionTransformer::convertScans(RamProgram& program) {
     return changed;
 }
 
+bool MergeJoinTransformer::mergeJoins(RamProgram& program) {
+    bool changed = false;
+    if (Global::config().has("provenance")) {
+        return changed;
+    }
+    const bool all = Global::config().has("merge-joins", "all");
+    const size_t jobs = std::max(std::stoi(Global::config().get("jobs")), 1);
+    auto run = std::make_shared<profile::ProgramRun>(profile::ProgramRun());
+    if (!all && Global::config().has("profile-use")) {
+        profile::Reader(Global::config().get("profile-use"), run).processFile();
+    }
+
+
+    // whether merging the relations is cheaper than searching the inner one for each outer tuple
+    auto isLarge = [&](const RamRelation& outer, const RamRelation& inner) {
+        if (all) {
+            return true;
+        }
+        const auto* outerProf = run->getRelation(outer.getName());
+        const auto* innerProf = run->getRelation(inner.getName());
+        if (outerProf == nullptr || innerProf == nullptr) {
+            return false;
+        }
+        double n = outerProf->size();
+        double m = innerProf->size();
+        return n * std::log2(m + 1) > (n + m) * jobs;
+    };
+
+    // the index scan probing the tuples of an outer scan on a single column, below filters and breaks
+    std::function<const RamIndexScan*(const RamOperation&, int)> findProbe =
+            [&](const RamOperation& op, int outer) -> const RamIndexScan* {
+        if (const auto* filter = dynamic_cast<const RamFilter*>(&op)) {
+            return findProbe(filter->getOperation(), outer);
+        }
+        if (const auto* brk = dynamic_cast<const RamBreak*>(&op)) {
+            return findProbe(brk->getOperation(), outer);
+        }
+        const auto* iscan = dynamic_cast<const RamIndexScan*>(&op);
+        if (iscan == nullptr) {
+            return nullptr;
+        }
+        const RamExpression* key = nullptr;
+        for (const RamExpression* cur : iscan->getRangePattern()) {
+            if (!isRamUndefValue(cur)) {
+                if (key != nullptr) {
+                    return nullptr;
+                }
+                key = cur;
+            }
+        }
+        const auto* element = dynamic_cast<const RamTupleElement*>(key);
+        return (element != nullptr && element->getTupleId() == outer) ? iscan : nullptr;
+    };
+
+    // the column of the probed index bound to the outer tuple
+    auto getProbedColumn = [](const RamIndexScan& iscan) {
+        const auto pattern = iscan.getRangePattern();
+        size_t column = 0;
+        while (isRamUndefValue(pattern[column])) {
+            column++;
+        }
+        return column;
+    };
+
+    visitDepthFirst(program, [&](const RamQuery& query) {
+        // the intersection binds a tuple of its own, renumbered by the TupleIdTransformer
+        int freeId = 0;
+        visitDepthFirst(query, [&](const RamTupleOperation& op) {
+            freeId = std::max(freeId, op.getTupleId() + 1);
+        });
+
+        std::function<std::unique_ptr<RamNode>(std::unique_ptr<RamNode>)> joinRewriter =
+                [&](std::unique_ptr<RamNode> node) -> std::unique_ptr<RamNode> {
+            const auto* scan = dynamic_cast<const RamScan*>(node.get());
+            if (scan == nullptr || scan->getTupleId() != 0) {
+                node->apply(makeLambdaRamMapper(joinRewriter));
+                return node;
+            }
+            const RamRelation& outer = scan->getRelation();
+            const RamIndexScan* probe = findProbe(scan->getOperation(), scan->getTupleId());
+            // intersections require the signed order of b-trees
+            if (probe == nullptr || !hasSignedOrder(outer) || !hasSignedOrder(probe->getRelation()) ||
+                    !isLarge(outer, probe->getRelation())) {
+                return node;
+            }
+            const RamRelation& inner = probe->getRelation();
+            const size_t innerColumn = getProbedColumn(*probe);
+            const size_t outerColumn =
+                    dynamic_cast<const RamTupleElement*>(probe->getRangePattern()[innerColumn])->getElement();
+
+            // the outer relation is searched for each shared value, the probe remains as it is
+            std::vector<std::unique_ptr<RamExpression>> outerPattern;
+            for (size_t i = 0; i < outer.getArity(); i++) {
+                if (i == outerColumn) {
+                    outerPattern.push_back(std::make_unique<RamTupleElement>(freeId, 0));
+                } else {
+                    outerPattern.push_back(std::make_unique<RamUndefValue>());
+                }
+            }
+            auto search = std::make_unique<RamIndexScan>(std::make_unique<RamRelationReference>(&outer),
+                    scan->getTupleId(), std::move(outerPattern),
+                    std::unique_ptr<RamOperation>(scan->getOperation().clone()), scan->getProfileText());
+
+            auto intersect = std::make_unique<RamIntersect>(freeId, std::move(search));
+            auto unbound = [](const RamRelation& rel) {
+                std::vector<std::unique_ptr<RamExpression>> pattern;
+                for (size_t i = 0; i < rel.getArity(); i++) {
+                    pattern.push_back(std::make_unique<RamUndefValue>());
+                }
+                return pattern;
+            };
+            intersect->add(std::make_unique<RamRelationReference>(&outer), unbound(outer), outerColumn);
+            intersect->add(std::make_unique<RamRelationReference>(&inner), unbound(inner), innerColumn);
+            changed = true;
+            return std::move(intersect);
+        };
+        const_cast<RamQuery*>(&query)->apply(makeLambdaRamMapper(joinRewriter));
+    });
+
+    return changed;
+}
+
 bool TupleIdTransformer::reorderOperations(RamProgram& program) {
     // flag to determine whether the RAM program has changed
     bool changed = false;
@@ -785,7 +1797,9 @@ bool ParallelTransformer::parallelizeOperations(RamProgram& program) {
                     }
                     return std::make_unique<RamParallelIndexScan>(
                             std::make_unique<RamRelationReference>(&rel), indexScan->getTupleId(),
-                            std::move(queryPattern),
+                            std::move(queryPattern), indexScan->getRangeColumn(),
+                            std::unique_ptr<RamExpression>(indexScan->getLowerBound().clone()),
+                            std::unique_ptr<RamExpression>(indexScan->getUpperBound().clone()),
                             std::unique_ptr<RamOperation>(indexScan->getOperation().clone()),
                             indexScan->getProfileText());
                 }
@@ -16,16 +16,152 @@
 
 #pragma once
 
+#include "RamIndexAnalysis.h"
 #include "RamLevelAnalysis.h"
 #include "RamTransformer.h"
 #include "RamTranslationUnit.h"
+#include "StatisticsCatalog.h"
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
 
 namespace souffle {
 
+class RamExpression;
+class RamIntrinsicOperator;
 class RamProgram;
 
+/**
+ * @class FoldConstantsTransformer
+ * @brief Evaluates intrinsic functors of constants at compile time.
+ *
+ * Functors whose arguments are all constants are replaced by their value,
+ * the symbols produced by functors such as cat and to_string being added to
+ * the symbol table. Functors failing at run-time, e.g., divisions by zero,
+ * are kept so that their errors are still reported. Operands that do not
+ * change the value of a functor are removed, and squares of tuple elements
+ * are computed by multiplications.
+ *
+ * For example ..
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN A
+ *    IF (t0.1 = ((number(2)*number(3))+t0.2))
+ *     PROJECT ((t0.0 ^ number(2)) + number(0)) INTO B
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN A
+ *    IF (t0.1 = (number(6)+t0.2))
+ *     PROJECT (t0.0*t0.0) INTO B
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ */
+class FoldConstantsTransformer : public RamTransformer {
+public:
+    std::string getName() const override {
+        return "FoldConstantsTransformer";
+    }
+
+    /**
+     * @brief Simplify an intrinsic functor whose arguments have been simplified
+     * @param op functor to be simplified
+     * @return The simplified expression, or null if the functor cannot be simplified
+     */
+    std::unique_ptr<RamExpression> simplify(const RamIntrinsicOperator& op);
+
+    /**
+     * @brief Fold the constant expressions of a program
+     * @param program Program that is transformed
+     * @return Flag showing whether the program has been changed by the transformation
+     */
+    bool foldConstants(RamProgram& program);
+
+protected:
+    SymbolTable* symbolTable{nullptr};
+    bool transform(RamTranslationUnit& translationUnit) override {
+        symbolTable = &translationUnit.getSymbolTable();
+        return foldConstants(*translationUnit.getProgram());
+    }
+};
+
+/**
+ * @class FuseRelationsTransformer
+ * @brief Streams the tuples of a relation derived by a single rule into its single reader.
+ *
+ * A relation that is neither loaded nor stored, written by a single query outside of any
+ * loop and read by a single scan, the outermost operation of another query, is not
+ * materialised: the loop nest of its writer is placed at the scan of its reader, whose
+ * tuple elements are replaced by the projected values. The relation, its indexes and
+ * the insertions into them are removed.
+ *
+ * Fusion requires each tuple to reach the reader once, as the relation would have
+ * removed duplicates. Hence the writer must not lose any column it binds: every column
+ * of the tuples it scans must be projected or equal to an expression of such columns.
+ *
+ * For example ..
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN A
+ *    FOR t1 IN B
+ *     IF (t0.1 = t1.0)
+ *      PROJECT (t0.0, t1.0, t1.1) INTO R
+ *  ...
+ *  QUERY
+ *   FOR t0 IN R
+ *    IF (t0.2 = number(5))
+ *     PROJECT (t0.0) INTO S
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  ...
+ *  QUERY
+ *   FOR t0 IN A
+ *    FOR t1 IN B
+ *     IF (t0.1 = t1.0)
+ *      IF (t1.1 = number(5))
+ *       PROJECT (t0.0) INTO S
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * Relations read by the writer and dropped before the reader are dropped after it.
+ * Programs recording provenance, profiles or the relations of their strata keep all
+ * relations.
+ */
+class FuseRelationsTransformer : public RamTransformer {
+public:
+    std::string getName() const override {
+        return "FuseRelationsTransformer";
+    }
+
+    /**
+     * @brief Fuse the relations of a program into their readers
+     * @param program Program that is transformed
+     * @return Flag showing whether the program has been changed by the transformation
+     */
+    bool fuseRelations(RamProgram& program);
+
+protected:
+    /**
+     * @brief Fuse a relation into its reader, if possible
+     * @param program Program that is transformed
+     * @param rel Relation to be fused, which is removed from the program if fused
+     * @return Flag showing whether the relation has been fused
+     */
+    bool fuseRelation(RamProgram& program, const RamRelation& rel);
+
+    bool transform(RamTranslationUnit& translationUnit) override {
+        return fuseRelations(*translationUnit.getProgram());
+    }
+};
+
 /**
  * @class ExpandFilterTransformer
  * @brief Transforms RamConjunctions into consecutive filter operations.
@@ -204,6 +340,10 @@ protected:
  *     IF C
  *      ...
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * Inequalities bounding a further column of a b-tree relation, such as
+ * t1.z >= t0.0 /\ t1.z < 100, restrict the search to the range [t0.0, 100]
+ * of that column, while their filter remains in place.
  */
 
 class MakeIndexTransformer : public RamTransformer {
@@ -251,6 +391,24 @@ public:
      */
     std::unique_ptr<RamOperation> rewriteIndexScan(const RamIndexScan* iscan);
 
+    /**
+     * @brief Get the bound of a column in an inequality constraint
+     *
+     * @param Inequality constraint of the format t1.x < <expression>, <expression> <= t1.x, ...
+     * @param Element that is bounded, e.g., for t1.x this would be the index of attribute x.
+     * @param Flag that is set if the expression bounds the element from below, cleared otherwise
+     * @param Tuple identifier
+     */
+    std::unique_ptr<RamExpression> getBound(RamCondition* c, size_t& element, bool& lower, int identifier);
+
+    /**
+     * @brief Bound a column of a scan or index scan by the inequalities of its filter
+     * @param Scan or IndexScan operation whose filter may bound a column not bound by the index
+     * @result The result is null if no column is bounded or the scan has a range already;
+     *         otherwise the IndexScan searching the range of the column is returned.
+     */
+    std::unique_ptr<RamOperation> rewriteRange(const RamRelationOperation* scan);
+
     /**
      * @brief Rewrite an aggregate operation to an indexed aggregate operation
      * @param Aggregate operation that is potentially rewritten to an indexed version
@@ -274,6 +432,100 @@ protected:
     }
 };
 
+/**
+ * @class IndexBudgetTransformer
+ * @brief Limit the number of indexes of relations by replacing searches with filtered searches.
+ *
+ * Each index of a relation holds a full copy of its tuples. If the minimal index cover of a
+ * relation exceeds its budget, the searches of the index whose removal loses the fewest bound
+ * attributes are rewritten to the longest prefix of another index, and the attributes that are
+ * no longer covered are checked by a filter. For example, with a budget of one index for A
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *    SEARCH t1 IN A INDEX t1.0 = x AND t1.2 = z
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *    SEARCH t1 IN A INDEX t1.0 = x
+ *     IF t1.2 = z
+ *      ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * if A is also searched on its attributes 0 and 1. Existence checks, the total order of a
+ * relation, and searches that would degrade to full scans are never rewritten, hence the
+ * budget is a bound that may not be met for every relation. With the statistics of previous
+ * runs (--statistics), the index whose searches scan the fewest additional tuples is dropped.
+ */
+class IndexBudgetTransformer : public RamTransformer {
+public:
+    /**
+     * @param budget the maximal number of indexes of a relation
+     * @param relationBudgets budgets overriding the default for individual relations
+     */
+    IndexBudgetTransformer(size_t budget, std::map<std::string, size_t> relationBudgets = {})
+            : budget(budget), relationBudgets(std::move(relationBudgets)) {}
+
+    std::string getName() const override {
+        return "IndexBudgetTransformer";
+    }
+
+    /**
+     * @brief Get the index budget of a relation
+     *
+     * Auxiliary relations of a recursive relation share the budget of the relation.
+     */
+    size_t getBudget(const RamRelation& rel) const;
+
+    /**
+     * @brief Select the searches replacing the searches of a dropped index
+     * @param Relation whose index cover exceeds its budget
+     * @param Search signatures that must not be rewritten
+     * @result Map from the searches of the dropped index to their replacements;
+     *         empty if no index can be dropped.
+     */
+    std::map<SearchSignature, SearchSignature> selectReplacements(
+            const RamRelation& rel, const std::set<SearchSignature>& pinned);
+
+    /**
+     * @brief Rewrite the searches of a relation according to the given replacements
+     * @param Program that is transformed
+     * @param Relations whose searches are rewritten
+     * @param Map from search signatures to the signatures replacing them
+     */
+    void rewriteSearches(RamProgram& program, const std::set<const RamRelation*>& rels,
+            const std::map<SearchSignature, SearchSignature>& replacements);
+
+    /**
+     * @brief Reduce the indexes of all relations to their budget
+     * @param Translation unit that is transformed
+     * @result Flag that indicates whether the input program has changed
+     */
+    bool reduceIndexes(RamTranslationUnit& translationUnit);
+
+protected:
+    /** default budget of relations */
+    size_t budget;
+
+    /** budgets of individual relations */
+    std::map<std::string, size_t> relationBudgets;
+
+    RamIndexAnalysis* isa{nullptr};
+
+    /** statistics of previous runs, estimating the tuples a search scans */
+    std::unique_ptr<StatisticsCatalog> statistics;
+
+    bool transform(RamTranslationUnit& translationUnit) override {
+        return reduceIndexes(translationUnit);
+    }
+};
+
 /**
  * @class IfConversionTransformer
  * @brief Convert IndexScan operations to Filter/Existence Checks
@@ -407,6 +659,58 @@ protected:
     }
 };
 
+/**
+ * @class MergeJoinTransformer
+ * @brief Join two large relations by intersecting the columns of their sorted indexes
+ *
+ * An outer-most scan of a relation whose tuples are each probed in an index of another
+ * relation on a single column searches the index once per tuple. If both relations are
+ * large, intersecting the sorted values of the two columns, which advances both indexes
+ * in ascending order and visits each shared value once, is cheaper.
+ *
+ * For example,
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN A
+ *    FOR t1 IN B ON INDEX t1.x = t0.y
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0.0 IN INTERSECT A.y, B.x
+ *    FOR t1 IN A ON INDEX t1.y = t0.0
+ *     FOR t2 IN B ON INDEX t2.x = t1.y
+ *      ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * With --merge-joins=all, all such joins of b-tree relations are rewritten. With auto, a join
+ * is only rewritten if the sizes n and m of the relations in the profile of --profile-use make
+ * the n searches of log m steps each more expensive than merging n + m tuples, which is not
+ * split among the threads of a parallel evaluation.
+ */
+class MergeJoinTransformer : public RamTransformer {
+public:
+    std::string getName() const override {
+        return "MergeJoinTransformer";
+    }
+
+    /**
+     * @brief Rewrite the joins of large relations to intersections
+     * @param program Program that is transformed
+     * @return Flag showing whether the program has been changed by the transformation
+     */
+    bool mergeJoins(RamProgram& program);
+
+protected:
+    bool transform(RamTranslationUnit& translationUnit) override {
+        return mergeJoins(*translationUnit.getProgram());
+    }
+};
+
 /**
  * @class TupleIdTransformer
  * @brief Ordering tupleIds in RamTupleOperation operations correctly
@@ -94,6 +94,7 @@ struct RamVisitor : public ram_visitor_tag {
         FORWARD(True);
         FORWARD(False);
         FORWARD(EmptinessCheck);
+        FORWARD(SizeCheck);
         FORWARD(ExistenceCheck);
         FORWARD(ProvenanceExistenceCheck);
         FORWARD(Conjunction);
@@ -110,6 +111,7 @@ struct RamVisitor : public ram_visitor_tag {
         FORWARD(Scan);
         FORWARD(ParallelIndexScan);
         FORWARD(IndexScan);
+        FORWARD(Intersect);
         FORWARD(ParallelChoice);
         FORWARD(Choice);
         FORWARD(ParallelIndexChoice);
@@ -126,27 +128,32 @@ struct RamVisitor : public ram_visitor_tag {
         FORWARD(Clear);
         FORWARD(Drop);
         FORWARD(LogSize);
+        FORWARD(LogDistinctValues);
 
         FORWARD(Merge);
         FORWARD(Swap);
+        FORWARD(TransitiveClosure);
 
         // Control-flow
         FORWARD(Program);
         FORWARD(Sequence);
         FORWARD(Loop);
         FORWARD(Parallel);
+        FORWARD(PlanSwitch);
         FORWARD(Exit);
         FORWARD(LogTimer);
         FORWARD(LogRelationTimer);
         FORWARD(DebugInfo);
         FORWARD(Stratum);
+        FORWARD(Recv);
 
 #ifdef USE_MPI
         // mpi
         FORWARD(Send);
-        FORWARD(Recv);
         FORWARD(Notify);
         FORWARD(Wait);
+        FORWARD(Exchange);
+        FORWARD(Partition);
 #endif
 
 #undef FORWARD
@@ -178,17 +185,20 @@ protected:
     LINK(Clear, RelationStatement);
     LINK(Drop, RelationStatement);
     LINK(LogSize, RelationStatement);
+    LINK(LogDistinctValues, RelationStatement);
 
     LINK(RelationStatement, Statement);
 
     LINK(Merge, BinRelationStatement);
     LINK(Swap, BinRelationStatement);
+    LINK(TransitiveClosure, BinRelationStatement);
     LINK(BinRelationStatement, Statement);
 
     LINK(Sequence, ListStatement);
     LINK(Loop, Statement);
     LINK(Parallel, ListStatement);
     LINK(ListStatement, Statement);
+    LINK(PlanSwitch, Statement);
     LINK(Exit, Statement);
     LINK(LogTimer, Statement);
     LINK(LogRelationTimer, Statement);
@@ -205,6 +215,7 @@ protected:
     LINK(ParallelScan, Scan);
     LINK(IndexScan, IndexOperation);
     LINK(ParallelIndexScan, IndexScan);
+    LINK(Intersect, TupleOperation);
     LINK(Choice, RelationOperation);
     LINK(ParallelChoice, Choice);
     LINK(IndexChoice, IndexOperation);
@@ -230,6 +241,7 @@ protected:
     LINK(ExistenceCheck, AbstractExistenceCheck);
     LINK(ProvenanceExistenceCheck, AbstractExistenceCheck);
     LINK(EmptinessCheck, Condition);
+    LINK(SizeCheck, Condition);
     LINK(AbstractExistenceCheck, Condition);
 
     LINK(Condition, Node);
@@ -254,11 +266,14 @@ protected:
     LINK(Relation, Node);
     LINK(RelationReference, Node);
 
+    LINK(Recv, RelationStatement);
+
 #ifdef USE_MPI
     LINK(Send, RelationStatement);
-    LINK(Recv, RelationStatement);
     LINK(Notify, Statement);
     LINK(Wait, Statement);
+    LINK(Exchange, RelationStatement);
+    LINK(Partition, RelationStatement);
 #endif
 
 #undef LINK
@@ -31,18 +31,79 @@ public:
               arity(symbolMask.size() - (prov ? 2 : 0)) {}
     template <typename T>
     void readAll(T& relation) {
+#ifdef USE_MPI
+        // the lookups of slave processes share caches; otherwise inputs are read concurrently
         auto lease = symbolTable.acquireLock();
         (void)lease;
-        while (const auto next = readNextTuple()) {
-            const RamDomain* ramDomain = next.get();
-            relation.insert(ramDomain);
-        }
+#endif
+        readInto(relation, 0);
     }
 
     virtual ~ReadStream() = default;
 
+private:
+    /**
+     * Relations built from their sorted tuples, such as bries, receive the whole
+     * input at once instead of tuple by tuple.
+     */
+    template <typename T>
+    auto readInto(T& relation, int) -> decltype(relation.loadAll(std::vector<RamDomain>())) {
+        const size_t width = symbolMask.size();
+        std::vector<RamDomain> tuples;
+        std::vector<std::vector<RamDomain>> batches;
+        while (readBatches(batches)) {
+            for (const auto& batch : batches) {
+                tuples.insert(tuples.end(), batch.begin(), batch.end());
+            }
+        }
+        while (const RamDomain* next = readNextTupleInPlace()) {
+            tuples.insert(tuples.end(), next, next + width);
+        }
+        relation.loadAll(tuples);
+    }
+
+    template <typename T>
+    void readInto(T& relation, long) {
+        // streams that parse in parallel hand out batches of tuples, inserted in the order of the input
+        const size_t width = symbolMask.size();
+        std::vector<std::vector<RamDomain>> batches;
+        while (readBatches(batches)) {
+            for (const auto& batch : batches) {
+                for (size_t i = 0; i < batch.size(); i += width) {
+                    relation.insert(&batch[i]);
+                }
+            }
+        }
+        while (const RamDomain* next = readNextTupleInPlace()) {
+            relation.insert(next);
+        }
+    }
+
 protected:
     virtual std::unique_ptr<RamDomain[]> readNextTuple() = 0;
+
+    /**
+     * Read the next tuple into a buffer owned by the stream, which is
+     * overwritten by the following call.
+     *
+     * Returns nullptr if no tuple was readable.
+     */
+    virtual const RamDomain* readNextTupleInPlace() {
+        current = readNextTuple();
+        return current.get();
+    }
+
+    /**
+     * Read the next part of the input in parallel, as batches of consecutive
+     * tuples stored one after the other.
+     *
+     * Returns false if the stream is read tuple by tuple from here on.
+     */
+    virtual bool readBatches(std::vector<std::vector<RamDomain>>& /* batches */) {
+        return false;
+    }
+
+    std::unique_ptr<RamDomain[]> current;
     const std::vector<bool>& symbolMask;
     SymbolTable& symbolTable;
     const bool isProvenance;
@@ -0,0 +1,324 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ReadStreamArrow.h
+ *
+ * Reading relations from Apache Arrow IPC files (IO=arrow) and from
+ * Parquet files (IO=parquet).
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "IODirectives.h"
+#include "RamTypes.h"
+#include "ReadStream.h"
+#include "SymbolTable.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <parquet/arrow/reader.h>
+
+namespace souffle {
+
+namespace arrowio {
+
+/** Throw the error of a failed Arrow operation */
+inline void check(const arrow::Status& status, const std::string& fileName) {
+    if (!status.ok()) {
+        throw std::invalid_argument("Cannot read " + fileName + ": " + status.ToString() + "\n");
+    }
+}
+
+template <typename T>
+T check(arrow::Result<T> result, const std::string& fileName) {
+    check(result.status(), fileName);
+    return std::move(result).ValueOrDie();
+}
+
+}  // end of namespace arrowio
+
+/**
+ * Reads a relation from the columns of an Arrow IPC or a Parquet file.
+ *
+ * The file is memory-mapped and read as a table of record batches, each
+ * decoded column by column into a batch of tuples. Integer columns of any
+ * width are accepted for number attributes, and string columns, plain or
+ * dictionary encoded, for symbol attributes; the symbols of a dictionary,
+ * or those of a plain column in a batch, are interned together. As with
+ * fact files, the directive columns selects the columns of the file read
+ * into the attributes, e.g. columns="2:0" reads the third column into the
+ * first attribute and the first column into the second one; of Parquet
+ * files, only these columns are loaded.
+ */
+class ReadStreamArrow : public ReadStream {
+public:
+    ReadStreamArrow(bool parquet, const std::vector<bool>& symbolMask, SymbolTable& symbolTable,
+            const IODirectives& ioDirectives, const bool provenance = false)
+            : ReadStream(symbolMask, symbolTable, provenance),
+              fileName(souffle::baseName(ioDirectives.getFileName())) {
+        // the column of the file read into each attribute, and the columns read at all
+        std::vector<int> projection;
+        if (ioDirectives.has("columns")) {
+            std::istringstream iss(ioDirectives.get("columns"));
+            std::string column;
+            while (std::getline(iss, column, ':')) {
+                sourceColumns.push_back(std::stoi(column));
+            }
+            if (sourceColumns.size() != arity) {
+                throw std::invalid_argument(
+                        "Invalid column set was given: <" + ioDirectives.get("columns") + ">");
+            }
+        } else {
+            for (size_t i = 0; i < arity; ++i) {
+                sourceColumns.push_back(i);
+            }
+        }
+        projection = sourceColumns;
+        std::sort(projection.begin(), projection.end());
+        projection.erase(std::unique(projection.begin(), projection.end()), projection.end());
+
+        auto file = arrowio::check(
+                arrow::io::MemoryMappedFile::Open(ioDirectives.getFileName(), arrow::io::FileMode::READ),
+                fileName);
+        if (parquet) {
+            parquet::arrow::FileReaderBuilder builder;
+            arrowio::check(builder.Open(file), fileName);
+            std::unique_ptr<parquet::arrow::FileReader> reader;
+            arrowio::check(builder.Build(&reader), fileName);
+            checkColumns(reader->parquet_reader()->metadata()->num_columns());
+            nullary = arity == 0 && reader->parquet_reader()->metadata()->num_rows() > 0;
+            arrowio::check(reader->ReadTable(projection, &table), fileName);
+        } else {
+            auto reader = arrowio::check(arrow::ipc::RecordBatchFileReader::Open(file), fileName);
+            checkColumns(reader->schema()->num_fields());
+            std::vector<std::shared_ptr<arrow::RecordBatch>> recordBatches;
+            for (int i = 0; i < reader->num_record_batches(); ++i) {
+                recordBatches.push_back(arrowio::check(reader->ReadRecordBatch(i), fileName));
+                nullary = nullary || (arity == 0 && recordBatches.back()->num_rows() > 0);
+            }
+            auto whole = arrowio::check(
+                    arrow::Table::FromRecordBatches(reader->schema(), recordBatches), fileName);
+            table = arrowio::check(whole->SelectColumns(projection), fileName);
+        }
+
+        // the position of the column of each attribute among the columns read
+        for (int& column : sourceColumns) {
+            column = std::lower_bound(projection.begin(), projection.end(), column) - projection.begin();
+        }
+        batches = std::make_unique<arrow::TableBatchReader>(*table);
+    }
+
+    ~ReadStreamArrow() override = default;
+
+protected:
+    std::unique_ptr<RamDomain[]> readNextTuple() override {
+        const RamDomain* read = readNextTupleInPlace();
+        if (read == nullptr) {
+            return nullptr;
+        }
+        std::unique_ptr<RamDomain[]> res = std::make_unique<RamDomain[]>(symbolMask.size());
+        std::copy(read, read + symbolMask.size(), res.get());
+        return res;
+    }
+
+    const RamDomain* readNextTupleInPlace() override {
+        if (arity == 0) {
+            // the tuple of a non-empty nullary relation, kept in a buffer of at least one value
+            if (!nullary) {
+                return nullptr;
+            }
+            nullary = false;
+            tuples.assign(std::max<size_t>(symbolMask.size(), 1), 0);
+            return tuples.data();
+        }
+        while (next == rows) {
+            if (!decodeBatch()) {
+                return nullptr;
+            }
+        }
+        return &tuples[symbolMask.size() * next++];
+    }
+
+    bool readBatches(std::vector<std::vector<RamDomain>>& result) override {
+        result.clear();
+        if (arity == 0 || !decodeBatch()) {
+            return false;
+        }
+        result.push_back(std::move(tuples));
+        rows = 0;
+        next = 0;
+        return true;
+    }
+
+    /** Decode the next record batch into tuples, returning false at the end of the file */
+    bool decodeBatch() {
+        std::shared_ptr<arrow::RecordBatch> batch;
+        arrowio::check(batches->ReadNext(&batch), fileName);
+        if (batch == nullptr) {
+            return false;
+        }
+        const size_t width = symbolMask.size();
+        rows = batch->num_rows();
+        next = 0;
+        tuples.assign(rows * width, 0);
+        for (size_t attr = 0; attr < arity; ++attr) {
+            const arrow::Array& column = *batch->column(sourceColumns[attr]);
+            if (column.null_count() != 0) {
+                fail(attr, "contains null values");
+            }
+            if (symbolMask[attr]) {
+                decodeSymbols(attr, column);
+            } else {
+                decodeNumbers(attr, column);
+            }
+        }
+        return true;
+    }
+
+    void decodeSymbols(size_t attr, const arrow::Array& column) {
+        const size_t width = symbolMask.size();
+        if (column.type_id() == arrow::Type::DICTIONARY) {
+            const auto& encoded = static_cast<const arrow::DictionaryArray&>(column);
+            const std::vector<RamDomain> symbols = internAll(attr, *encoded.dictionary());
+            for (size_t row = 0; row < rows; ++row) {
+                tuples[row * width + attr] = symbols.at(encoded.GetValueIndex(row));
+            }
+        } else {
+            const std::vector<RamDomain> symbols = internAll(attr, column);
+            for (size_t row = 0; row < rows; ++row) {
+                tuples[row * width + attr] = symbols[row];
+            }
+        }
+    }
+
+    /** Intern the strings of a column in one bulk lookup */
+    std::vector<RamDomain> internAll(size_t attr, const arrow::Array& column) {
+        std::vector<std::string> strings(column.length());
+        if (column.type_id() == arrow::Type::STRING) {
+            const auto& values = static_cast<const arrow::StringArray&>(column);
+            for (int64_t i = 0; i < values.length(); ++i) {
+                strings[i] = values.GetString(i);
+            }
+        } else if (column.type_id() == arrow::Type::LARGE_STRING) {
+            const auto& values = static_cast<const arrow::LargeStringArray&>(column);
+            for (int64_t i = 0; i < values.length(); ++i) {
+                strings[i] = values.GetString(i);
+            }
+        } else {
+            fail(attr, "is not a string column");
+        }
+        return symbolTable.lookupAll(strings);
+    }
+
+    void decodeNumbers(size_t attr, const arrow::Array& column) {
+        switch (column.type_id()) {
+            case arrow::Type::INT8: return decodeIntegers<arrow::Int8Type>(attr, column);
+            case arrow::Type::INT16: return decodeIntegers<arrow::Int16Type>(attr, column);
+            case arrow::Type::INT32: return decodeIntegers<arrow::Int32Type>(attr, column);
+            case arrow::Type::INT64: return decodeIntegers<arrow::Int64Type>(attr, column);
+            case arrow::Type::UINT8: return decodeIntegers<arrow::UInt8Type>(attr, column);
+            case arrow::Type::UINT16: return decodeIntegers<arrow::UInt16Type>(attr, column);
+            case arrow::Type::UINT32: return decodeIntegers<arrow::UInt32Type>(attr, column);
+            case arrow::Type::UINT64: return decodeIntegers<arrow::UInt64Type>(attr, column);
+            default: fail(attr, "is not an integer column");
+        }
+    }
+
+    template <typename Type>
+    void decodeIntegers(size_t attr, const arrow::Array& column) {
+        using Value = typename Type::c_type;
+        const size_t width = symbolMask.size();
+        const Value* values = static_cast<const arrow::NumericArray<Type>&>(column).raw_values();
+        for (size_t row = 0; row < rows; ++row) {
+            const Value value = values[row];
+            const bool inRange =
+                    std::numeric_limits<Value>::is_signed
+                            ? static_cast<int64_t>(value) >= std::numeric_limits<RamDomain>::min() &&
+                                      static_cast<int64_t>(value) <= std::numeric_limits<RamDomain>::max()
+                            : static_cast<uint64_t>(value) <=
+                                      static_cast<uint64_t>(std::numeric_limits<RamDomain>::max());
+            if (!inRange) {
+                fail(attr, "holds a number out of the range of the domain");
+            }
+            tuples[row * width + attr] = static_cast<RamDomain>(value);
+        }
+    }
+
+    void checkColumns(int columns) const {
+        for (int column : sourceColumns) {
+            if (column < 0 || column >= columns) {
+                throw std::invalid_argument("Cannot read " + fileName + ": it has no column " +
+                                            std::to_string(column) + "\n");
+            }
+        }
+    }
+
+    [[noreturn]] void fail(size_t attr, const std::string& reason) const {
+        throw std::invalid_argument("Cannot read " + fileName + ": the column of attribute " +
+                                    std::to_string(attr + 1) + " " + reason + "\n");
+    }
+
+    const std::string fileName;
+
+    /** the column of the table read into each attribute */
+    std::vector<int> sourceColumns;
+
+    std::shared_ptr<arrow::Table> table;
+    std::unique_ptr<arrow::TableBatchReader> batches;
+
+    /** the tuples of the current batch, their number and the one of the next tuple read */
+    std::vector<RamDomain> tuples;
+    size_t rows = 0;
+    size_t next = 0;
+
+    /** whether the tuple of a non-empty nullary relation is yet to be read */
+    bool nullary = false;
+};
+
+class ReadArrowFactory : public ReadStreamFactory {
+public:
+    std::unique_ptr<ReadStream> getReader(const std::vector<bool>& symbolMask, SymbolTable& symbolTable,
+            const IODirectives& ioDirectives, const bool provenance) override {
+        return std::make_unique<ReadStreamArrow>(false, symbolMask, symbolTable, ioDirectives, provenance);
+    }
+    const std::string& getName() const override {
+        static const std::string name = "arrow";
+        return name;
+    }
+    ~ReadArrowFactory() override = default;
+};
+
+class ReadParquetFactory : public ReadStreamFactory {
+public:
+    std::unique_ptr<ReadStream> getReader(const std::vector<bool>& symbolMask, SymbolTable& symbolTable,
+            const IODirectives& ioDirectives, const bool provenance) override {
+        return std::make_unique<ReadStreamArrow>(true, symbolMask, symbolTable, ioDirectives, provenance);
+    }
+    const std::string& getName() const override {
+        static const std::string name = "parquet";
+        return name;
+    }
+    ~ReadParquetFactory() override = default;
+};
+
+} /* namespace souffle */
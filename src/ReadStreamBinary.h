@@ -0,0 +1,177 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ReadStreamBinary.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "BinaryFormat.h"
+#include "IODirectives.h"
+#include "RamTypes.h"
+#include "ReadStream.h"
+#include "ReadStreamCSV.h"
+#include "SymbolTable.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * Reads a relation from a binary file, see BinaryFormat.h. The file is
+ * memory-mapped and its columns are read in place; the symbols of the
+ * file are interned once, before the first tuple is read, and indices of
+ * the symbol table are taken as they are.
+ */
+class ReadFileBinary : public ReadStream {
+public:
+    ReadFileBinary(const std::vector<bool>& symbolMask, SymbolTable& symbolTable,
+            const IODirectives& ioDirectives, const bool provenance = false)
+            : ReadStream(symbolMask, symbolTable, provenance),
+              baseName(souffle::baseName(ioDirectives.getFileName())),
+              file(ioDirectives.getFileName()), tuple(new RamDomain[symbolMask.size()]()) {
+        if (!file.isValid()) {
+            throw std::invalid_argument("Cannot open binary file " + baseName + "\n");
+        }
+        const size_t size = file.end() - file.begin();
+        if (size < sizeof(binary::Header)) {
+            fail("is too short");
+        }
+        binary::Header header;
+        std::memcpy(&header, file.begin(), sizeof(header));
+        if (!binary::hasMagic(header)) {
+            fail("is not a binary relation file");
+        }
+        if (header.byteOrder != binary::BYTE_ORDER_MARK || header.domainBits != RAM_DOMAIN_SIZE) {
+            fail("was written with a different byte order or domain size");
+        }
+        if (header.arity != arity) {
+            fail("has arity " + std::to_string(header.arity) + " instead of " + std::to_string(arity));
+        }
+        if (header.tuples > size || header.symbols > size || header.symbolBytes > size) {
+            fail("is corrupt");
+        }
+        const binary::Layout layout(header);
+        if (layout.size != size) {
+            fail("is corrupt");
+        }
+
+        const char* data = file.begin();
+        for (size_t col = 0; col < arity; ++col) {
+            const char type = data[layout.types + col];
+            const bool isSymbol = type == binary::SYMBOL || type == binary::INDEX;
+            if (isSymbol != symbolMask.at(col)) {
+                fail("does not match the type of column " + std::to_string(col + 1));
+            }
+            indexColumns.push_back(type == binary::INDEX);
+            if (type == binary::INDEX && tableSize == 0) {
+                tableSize = symbolTable.size();
+            }
+        }
+
+        // intern the symbols of the file, giving the symbol of each position in the dictionary
+        std::vector<uint64_t> offsets(header.symbols + 1);
+        std::memcpy(offsets.data(), data + layout.offsets, offsets.size() * sizeof(uint64_t));
+        for (size_t i = 0; i < header.symbols; ++i) {
+            if (offsets[i] > offsets[i + 1] || offsets[i + 1] > header.symbolBytes) {
+                fail("is corrupt");
+            }
+            symbols.push_back(symbolTable.unsafeLookup(
+                    std::string(data + layout.symbolData + offsets[i], offsets[i + 1] - offsets[i])));
+        }
+
+        for (size_t col = 0; col < arity; ++col) {
+            const char* column = data + layout.columns + col * layout.columnBytes;
+            columns.push_back(reinterpret_cast<const RamDomain*>(column));
+        }
+        tuples = header.tuples;
+    }
+
+    ~ReadFileBinary() override = default;
+
+protected:
+    std::unique_ptr<RamDomain[]> readNextTuple() override {
+        const RamDomain* read = readNextTupleInPlace();
+        if (read == nullptr) {
+            return nullptr;
+        }
+        std::unique_ptr<RamDomain[]> res = std::make_unique<RamDomain[]>(symbolMask.size());
+        std::copy(read, read + symbolMask.size(), res.get());
+        return res;
+    }
+
+    const RamDomain* readNextTupleInPlace() override {
+        if (next == tuples) {
+            return nullptr;
+        }
+        for (size_t col = 0; col < arity; ++col) {
+            RamDomain value = columns[col][next];
+            if (indexColumns[col]) {
+                if (value < 0 || static_cast<size_t>(value) >= tableSize) {
+                    fail("refers to an index missing from the symbol table");
+                }
+            } else if (symbolMask[col]) {
+                if (value < 0 || static_cast<size_t>(value) >= symbols.size()) {
+                    fail("refers to an unknown symbol");
+                }
+                value = symbols[value];
+            }
+            tuple[col] = value;
+        }
+        ++next;
+        return tuple.get();
+    }
+
+    [[noreturn]] void fail(const std::string& reason) const {
+        throw std::invalid_argument("Binary file " + baseName + " " + reason + "\n");
+    }
+
+    std::string baseName;
+    MappedFile file;
+
+    /** the columns of the file, read in place */
+    std::vector<const RamDomain*> columns;
+
+    /** the symbol of each position in the dictionary of the file */
+    std::vector<RamDomain> symbols;
+
+    /** whether a column holds indices of the symbol table, and the size of the table if any does */
+    std::vector<bool> indexColumns;
+    size_t tableSize = 0;
+
+    /** the number of tuples in the file, and the one of the next tuple read */
+    uint64_t tuples = 0;
+    uint64_t next = 0;
+
+    std::unique_ptr<RamDomain[]> tuple;
+};
+
+class ReadFileBinaryFactory : public ReadStreamFactory {
+public:
+    std::unique_ptr<ReadStream> getReader(const std::vector<bool>& symbolMask, SymbolTable& symbolTable,
+            const IODirectives& ioDirectives, const bool provenance) override {
+        return std::make_unique<ReadFileBinary>(symbolMask, symbolTable, ioDirectives, provenance);
+    }
+    const std::string& getName() const override {
+        static const std::string name = "binary";
+        return name;
+    }
+    ~ReadFileBinaryFactory() override = default;
+};
+
+} /* namespace souffle */
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include "Compression.h"
 #include "IODirectives.h"
 #include "RamTypes.h"
 #include "ReadStream.h"
@@ -26,11 +27,29 @@
 #include <fstream>
 #endif
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace souffle {
 
@@ -202,10 +221,647 @@ protected:
 #endif
 };
 
+/**
+ * A read-only memory mapping of a whole file.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& fileName) {
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+            size = static_cast<size_t>(info.st_size);
+            if (size == 0) {
+                valid = true;
+            } else {
+                void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (addr != MAP_FAILED) {
+                    madvise(addr, size, MADV_SEQUENTIAL);
+                    data = static_cast<const char*>(addr);
+                    mapped = true;
+                    valid = true;
+                }
+            }
+        }
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        unmap();
+    }
+
+    /** Whether the file could be mapped */
+    bool isValid() const {
+        return valid;
+    }
+
+    /** Whether the file is gzip compressed, in which case it has to be read through a stream */
+    bool isCompressed() const {
+        return size >= 2 && static_cast<unsigned char>(data[0]) == 0x1f &&
+               static_cast<unsigned char>(data[1]) == 0x8b;
+    }
+
+#ifdef USE_ZSTD
+    /** Whether the file is zstd compressed, in which case its content is decompressed into memory */
+    bool isZstd() const {
+        return compression::isZstd(data, size);
+    }
+
+    /** Replace the mapping of the zstd compressed file by its decompressed content */
+    void decompress() {
+        std::string decompressed = compression::zstdDecompress(data, size);
+        unmap();
+        contents.swap(decompressed);
+        data = contents.data();
+        size = contents.size();
+    }
+#endif
+
+    const char* begin() const {
+        return data;
+    }
+
+    const char* end() const {
+        return data + size;
+    }
+
+private:
+    void unmap() {
+        if (mapped) {
+            munmap(const_cast<char*>(data), size);
+            mapped = false;
+        }
+    }
+
+    const char* data = nullptr;
+    size_t size = 0;
+    bool valid = false;
+
+    /** whether data is mapped, or else held by contents */
+    bool mapped = false;
+    std::string contents;
+};
+
+/**
+ * The parsing of fact file lines held in memory, shared by the readers
+ * locating the lines themselves: lines and delimiters are located with
+ * memchr, and numbers are parsed in place into the tuple given.
+ *
+ * The accepted input is the same as the one of ReadFileCSV.
+ */
+class ReadLinesCSV : public ReadStream {
+public:
+    ReadLinesCSV(const std::vector<bool>& symbolMask, SymbolTable& symbolTable,
+            const IODirectives& ioDirectives, std::string baseName, const bool provenance = false)
+            : ReadStream(symbolMask, symbolTable, provenance), delimiter(getDelimiter(ioDirectives)),
+              baseName(std::move(baseName)) {
+        // resolve the column mapping once
+        std::map<int, int> inputMap = getInputColumnMap(ioDirectives, arity);
+        while (inputMap.size() < arity) {
+            int size = inputMap.size();
+            inputMap[size] = size;
+        }
+        // only the columns up to the one filling the last attribute are ever looked at
+        size_t filled = 0;
+        for (uint32_t column = 0; filled < arity; column++) {
+            auto target = inputMap.find(column);
+            if (target == inputMap.end()) {
+                columns.push_back(-1);
+            } else {
+                columns.push_back(target->second);
+                filled++;
+            }
+        }
+    }
+
+    ~ReadLinesCSV() override = default;
+
+protected:
+    /** Drops a trailing carriage return of Windows line endings on non-Windows systems */
+    static const char* stripCarriageReturn(const char* line, const char* lineEnd) {
+        if (lineEnd != line && lineEnd[-1] == '\r') {
+            --lineEnd;
+        }
+        return lineEnd;
+    }
+
+    /** Parses the given line, reporting errors for the fact file, if the lines are read from one */
+    void parseLineOrFail(const char* line, const char* lineEnd, size_t lineNumber, RamDomain* target,
+            std::string& buffer) {
+        try {
+            parseLine(line, stripCarriageReturn(line, lineEnd), lineNumber, target, buffer);
+        } catch (std::exception& e) {
+            if (baseName.empty()) {
+                throw;
+            }
+            std::stringstream errorMessage;
+            errorMessage << e.what();
+            errorMessage << "cannot parse fact file " << baseName << "!\n";
+            throw std::invalid_argument(errorMessage.str());
+        }
+    }
+
+    /** Locates the next delimiter in [start,end), returning end if there is none */
+    const char* findDelimiter(const char* start, const char* end) const {
+        const size_t length = delimiter.size();
+        while (static_cast<size_t>(end - start) >= length) {
+            auto* cur = static_cast<const char*>(memchr(start, delimiter[0], end - start - length + 1));
+            if (cur == nullptr) {
+                break;
+            }
+            if (memcmp(cur, delimiter.data(), length) == 0) {
+                return cur;
+            }
+            start = cur + 1;
+        }
+        return end;
+    }
+
+    void parseLine(const char* line, const char* lineEnd, size_t lineNumber, RamDomain* tuple,
+            std::string& element) const {
+        const char* start = line;
+        for (size_t column = 0; column < columns.size(); column++) {
+            if (start > lineEnd) {
+                std::stringstream errorMessage;
+                errorMessage << "Values missing in line " << lineNumber << "; ";
+                throw std::invalid_argument(errorMessage.str());
+            }
+            const char* end = findDelimiter(start, lineEnd);
+            int target = columns[column];
+            if (target >= 0) {
+                if (symbolMask[target]) {
+                    element.assign(start, end);
+                    tuple[target] = symbolTable.unsafeLookup(element);
+                } else if (!parseNumber(start, end, tuple[target])) {
+                    std::stringstream errorMessage;
+                    errorMessage << "Error converting number <" + std::string(start, end) + "> in column "
+                                 << column + 1 << " in line " << lineNumber << "; ";
+                    throw std::invalid_argument(errorMessage.str());
+                }
+            }
+            start = end + delimiter.size();
+        }
+    }
+
+    /**
+     * Parses a number like std::stoll / std::stoi: leading white space is skipped,
+     * trailing characters are ignored, and at least one digit is required.
+     */
+    static bool parseNumber(const char* cur, const char* end, RamDomain& res) {
+        using limits = std::numeric_limits<RamDomain>;
+        while (cur != end && isspace(static_cast<unsigned char>(*cur))) {
+            ++cur;
+        }
+        bool negative = false;
+        if (cur != end && (*cur == '-' || *cur == '+')) {
+            negative = (*cur == '-');
+            ++cur;
+        }
+        if (cur == end || !isdigit(static_cast<unsigned char>(*cur))) {
+            return false;
+        }
+        // accumulate negatively, such that the minimum value can be represented
+        RamDomain value = 0;
+        for (; cur != end && isdigit(static_cast<unsigned char>(*cur)); ++cur) {
+            RamDomain digit = *cur - '0';
+            if (value < (limits::min() + digit) / 10) {
+                return false;
+            }
+            value = value * 10 - digit;
+        }
+        if (!negative) {
+            if (value == limits::min()) {
+                return false;
+            }
+            value = -value;
+        }
+        res = value;
+        return true;
+    }
+
+    std::string getDelimiter(const IODirectives& ioDirectives) const {
+        if (ioDirectives.has("delimiter")) {
+            return ioDirectives.get("delimiter");
+        }
+        return "\t";
+    }
+
+    std::map<int, int> getInputColumnMap(const IODirectives& ioDirectives, const unsigned arity) const {
+        std::string columnString = "";
+        if (ioDirectives.has("columns")) {
+            columnString = ioDirectives.get("columns");
+        }
+        std::map<int, int> inputMap;
+
+        if (!columnString.empty()) {
+            std::istringstream iss(columnString);
+            std::string mapping;
+            int index = 0;
+            while (std::getline(iss, mapping, ':')) {
+                inputMap[stoi(mapping)] = index++;
+            }
+            if (inputMap.size() < arity) {
+                throw std::invalid_argument("Invalid column set was given: <" + columnString + ">");
+            }
+        }
+        return inputMap;
+    }
+
+    const std::string delimiter;
+    std::string baseName;
+
+    /** The attribute each column of the file is stored in, -1 for skipped columns */
+    std::vector<int> columns;
+};
+
+/**
+ * A fast reader for uncompressed fact files: the file is memory-mapped and
+ * its lines are parsed in place into a tuple buffer that is reused for
+ * every line.
+ */
+class ReadFileMappedCSV : public ReadLinesCSV {
+public:
+    ReadFileMappedCSV(std::unique_ptr<MappedFile> mappedFile, const std::vector<bool>& symbolMask,
+            SymbolTable& symbolTable, const IODirectives& ioDirectives, const bool provenance = false)
+            : ReadLinesCSV(symbolMask, symbolTable, ioDirectives,
+                      souffle::baseName(getFileName(ioDirectives)), provenance),
+              parallel(ioDirectives.has("parallel") && ioDirectives.get("parallel") == "true"),
+              file(std::move(mappedFile)), pos(file->begin()), lineNumber(0),
+              tuple(new RamDomain[symbolMask.size()]()) {
+        // Strip headers if we're using them
+        if (ioDirectives.has("headers") && ioDirectives.get("headers") == "true") {
+            nextLine();
+        }
+    }
+
+    ~ReadFileMappedCSV() override = default;
+
+protected:
+    std::unique_ptr<RamDomain[]> readNextTuple() override {
+        const RamDomain* next = readNextTupleInPlace();
+        if (next == nullptr) {
+            return nullptr;
+        }
+        std::unique_ptr<RamDomain[]> res = std::make_unique<RamDomain[]>(symbolMask.size());
+        std::copy(next, next + symbolMask.size(), res.get());
+        return res;
+    }
+
+    const RamDomain* readNextTupleInPlace() override {
+        const char* line = pos;
+        const char* lineEnd = nextLine();
+        if (lineEnd == nullptr) {
+            return nullptr;
+        }
+        ++lineNumber;
+        parseLineOrFail(line, lineEnd, lineNumber, tuple.get(), element);
+        return tuple.get();
+    }
+
+    bool readBatches(std::vector<std::vector<RamDomain>>& batches) override {
+#ifdef _OPENMP
+        const size_t threads = omp_get_max_threads();
+        if (!parallel || threads < 2 || symbolMask.empty() || pos == file->end()) {
+            return false;
+        }
+
+        // split the next part of the file into chunks at line boundaries
+        std::vector<const char*> bounds{pos};
+        while (bounds.size() <= threads * CHUNKS_PER_THREAD && bounds.back() != file->end()) {
+            const char* cur = bounds.back();
+            if (static_cast<size_t>(file->end() - cur) <= CHUNK_SIZE) {
+                bounds.push_back(file->end());
+                break;
+            }
+            auto* end = static_cast<const char*>(memchr(cur + CHUNK_SIZE, '\n', file->end() - cur - CHUNK_SIZE));
+            bounds.push_back(end == nullptr ? file->end() : end + 1);
+        }
+
+        // parse the chunks in parallel, recording the first failing line of each chunk
+        const int numChunks = bounds.size() - 1;
+        batches.assign(numChunks, std::vector<RamDomain>());
+        std::vector<const char*> failed(numChunks, nullptr);
+#pragma omp parallel
+        {
+            std::string buffer;
+            std::vector<RamDomain> cur(symbolMask.size(), 0);
+#pragma omp for schedule(dynamic)
+            for (int i = 0; i < numChunks; i++) {
+                for (const char* line = bounds[i]; line != bounds[i + 1];) {
+                    auto* lineEnd = static_cast<const char*>(memchr(line, '\n', bounds[i + 1] - line));
+                    const char* next = (lineEnd == nullptr) ? bounds[i + 1] : lineEnd + 1;
+                    if (lineEnd == nullptr) {
+                        lineEnd = bounds[i + 1];
+                    }
+                    try {
+                        parseLine(line, stripCarriageReturn(line, lineEnd), 0, cur.data(), buffer);
+                    } catch (std::exception&) {
+                        failed[i] = line;
+                        break;
+                    }
+                    batches[i].insert(batches[i].end(), cur.begin(), cur.end());
+                    line = next;
+                }
+            }
+        }
+
+        for (int i = 0; i < numChunks; i++) {
+            if (failed[i] != nullptr) {
+                // parse the failing line again to report it with its line number
+                lineNumber += std::count(pos, failed[i], '\n') + 1;
+                pos = failed[i];
+                const char* line = pos;
+                const char* lineEnd = nextLine();
+                parseLineOrFail(line, lineEnd, lineNumber, tuple.get(), element);
+            }
+        }
+        lineNumber += std::count(bounds.front(), bounds.back(), '\n');
+        pos = bounds.back();
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /** Advances to the next line, returning the end of the current one or nullptr at the end of the file */
+    const char* nextLine() {
+        if (pos == file->end()) {
+            return nullptr;
+        }
+        auto* end = static_cast<const char*>(memchr(pos, '\n', file->end() - pos));
+        if (end == nullptr) {
+            end = file->end();
+            pos = end;
+        } else {
+            pos = end + 1;
+        }
+        return end;
+    }
+
+    static std::string getFileName(const IODirectives& ioDirectives) {
+        if (ioDirectives.has("filename")) {
+            return ioDirectives.get("filename");
+        }
+        return ioDirectives.getRelationName() + ".facts";
+    }
+
+    /** The amount of data parsed by one task in parallel mode, and the number of tasks per thread and round */
+    static constexpr size_t CHUNK_SIZE = 1 << 22;
+    static constexpr size_t CHUNKS_PER_THREAD = 4;
+
+    const bool parallel;
+    std::unique_ptr<MappedFile> file;
+    const char* pos;
+    size_t lineNumber;
+
+    /** The tuple buffer reused for every line */
+    std::unique_ptr<RamDomain[]> tuple;
+
+    /** A buffer for symbols */
+    std::string element;
+};
+
+/**
+ * A reader of facts streamed through the standard input in parallel mode
+ * (--parallel-load). A stream can be neither mapped nor split ahead, hence
+ * the reading is pipelined: a producer thread reads the stream in large
+ * blocks cut at line boundaries, parser threads parse the blocks as they
+ * arrive, and the consumer inserts the parsed blocks in the order of the
+ * input. Blocks are queued without bound, such that the process writing the
+ * facts is never held up by their parsing.
+ */
+class ReadCinPipelinedCSV : public ReadLinesCSV {
+public:
+    ReadCinPipelinedCSV(std::istream& in, const std::vector<bool>& symbolMask, SymbolTable& symbolTable,
+            const IODirectives& ioDirectives, const bool provenance = false)
+            : ReadLinesCSV(symbolMask, symbolTable, ioDirectives, "", provenance), in(in) {
+#ifdef _OPENMP
+        const size_t numParsers = std::max(1, omp_get_max_threads());
+#else
+        const size_t numParsers = std::max(1u, std::thread::hardware_concurrency());
+#endif
+        producer = std::thread([this]() { produce(); });
+        for (size_t i = 0; i < numParsers; ++i) {
+            parsers.emplace_back([this]() { parse(); });
+        }
+    }
+
+    ~ReadCinPipelinedCSV() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+        }
+        changed.notify_all();
+        // the producer stops once the block it is reading is complete
+        producer.join();
+        for (auto& parser : parsers) {
+            parser.join();
+        }
+    }
+
+protected:
+    /** A block of complete lines of the input, numbered in the order of the input */
+    struct Block {
+        size_t sequence;
+        std::string data;
+    };
+
+    /** The tuples of a parsed block, or the block itself if one of its lines failed to parse */
+    struct Parsed {
+        std::vector<RamDomain> tuples;
+        size_t lines = 0;
+        std::string data;
+        const char* failed = nullptr;
+    };
+
+    std::unique_ptr<RamDomain[]> readNextTuple() override {
+        const RamDomain* next = readNextTupleInPlace();
+        if (next == nullptr) {
+            return nullptr;
+        }
+        std::unique_ptr<RamDomain[]> res = std::make_unique<RamDomain[]>(symbolMask.size());
+        std::copy(next, next + symbolMask.size(), res.get());
+        return res;
+    }
+
+    const RamDomain* readNextTupleInPlace() override {
+        while (position == buffered.size() || offset == buffered[position].size()) {
+            if (position < buffered.size()) {
+                ++position;
+                offset = 0;
+            } else if (readBatches(buffered)) {
+                position = 0;
+            } else {
+                return nullptr;
+            }
+        }
+        const RamDomain* tuple = &buffered[position][offset];
+        offset += symbolMask.size();
+        return tuple;
+    }
+
+    bool readBatches(std::vector<std::vector<RamDomain>>& batches) override {
+        batches.clear();
+        std::unique_lock<std::mutex> lock(mutex);
+        // hand out every block parsed in order, waiting for at least one
+        changed.wait(lock,
+                [&]() { return parsed.count(consumed) > 0 || (endOfInput && consumed == numBlocks); });
+        for (auto it = parsed.find(consumed); it != parsed.end(); it = parsed.find(consumed)) {
+            Parsed block = std::move(it->second);
+            parsed.erase(it);
+            ++consumed;
+            if (block.failed != nullptr) {
+                lock.unlock();
+                // parse the failing line again to report it with its line number
+                const char* line = block.failed;
+                const char* begin = block.data.data();
+                const char* end = begin + block.data.size();
+                const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+                lineNumber += std::count(begin, line, '\n') + 1;
+                std::vector<RamDomain> tuple(symbolMask.size(), 0);
+                parseLineOrFail(line, lineEnd == nullptr ? end : lineEnd, lineNumber, tuple.data(), element);
+                throw std::logic_error("Line " + std::to_string(lineNumber) + " failed to parse once only");
+            }
+            lineNumber += block.lines;
+            batches.push_back(std::move(block.tuples));
+        }
+        return !batches.empty();
+    }
+
+    /** Reads the input into blocks of complete lines, until its end or until the reader is destroyed */
+    void produce() {
+        std::string carry;
+        while (true) {
+            std::string data;
+            bool end = false;
+            // extend the incomplete last line of the previous block, until a block holds a complete line
+            do {
+                data = std::move(carry);
+                carry.clear();
+                const size_t size = data.size();
+                data.resize(size + BLOCK_SIZE);
+                const std::streamsize count = in.rdbuf()->sgetn(&data[size], BLOCK_SIZE);
+                data.resize(size + std::max<std::streamsize>(count, 0));
+                end = count <= 0;
+                if (!end) {
+                    const size_t last = data.rfind('\n');
+                    if (last == std::string::npos) {
+                        carry = std::move(data);
+                        data.clear();
+                    } else {
+                        carry.assign(data, last + 1, std::string::npos);
+                        data.resize(last + 1);
+                    }
+                }
+            } while (!end && data.empty());
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!data.empty()) {
+                pending.push_back({numBlocks++, std::move(data)});
+            }
+            endOfInput = end || stopped;
+            changed.notify_all();
+            if (endOfInput) {
+                return;
+            }
+        }
+    }
+
+    /** Parses the blocks read, until there are no more blocks or until the reader is destroyed */
+    void parse() {
+        std::string buffer;
+        std::vector<RamDomain> tuple(symbolMask.size(), 0);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [&]() { return stopped || endOfInput || !pending.empty(); });
+            if (stopped || pending.empty()) {
+                return;
+            }
+            Block block = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+
+            Parsed result;
+            const char* line = block.data.data();
+            const char* end = line + block.data.size();
+            result.lines = std::count(line, end, '\n');
+            while (line != end) {
+                auto* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+                const char* next = (lineEnd == nullptr) ? end : lineEnd + 1;
+                if (lineEnd == nullptr) {
+                    lineEnd = end;
+                }
+                try {
+                    parseLine(line, stripCarriageReturn(line, lineEnd), 0, tuple.data(), buffer);
+                } catch (std::exception&) {
+                    result.failed = line;
+                    break;
+                }
+                result.tuples.insert(result.tuples.end(), tuple.begin(), tuple.end());
+                line = next;
+            }
+            if (result.failed != nullptr) {
+                // the string owning the line moves along with it
+                result.data = std::move(block.data);
+            }
+
+            lock.lock();
+            parsed.emplace(block.sequence, std::move(result));
+            changed.notify_all();
+        }
+    }
+
+    /** The amount of input read into one block */
+    static constexpr size_t BLOCK_SIZE = 1 << 22;
+
+    std::istream& in;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    /** the blocks read and not yet parsed */
+    std::deque<Block> pending;
+
+    /** the blocks parsed and not yet handed out, by their sequence number */
+    std::map<size_t, Parsed> parsed;
+
+    /** the number of blocks read, and whether all of them were */
+    size_t numBlocks = 0;
+    bool endOfInput = false;
+
+    bool stopped = false;
+
+    /** the number of blocks handed out, and the number of lines they held */
+    size_t consumed = 0;
+    size_t lineNumber = 0;
+
+    /** the batches handed out tuple by tuple */
+    std::vector<std::vector<RamDomain>> buffered;
+    size_t position = 0;
+    size_t offset = 0;
+
+    /** A buffer for symbols */
+    std::string element;
+
+    std::thread producer;
+    std::vector<std::thread> parsers;
+};
+
 class ReadCinCSVFactory : public ReadStreamFactory {
 public:
     std::unique_ptr<ReadStream> getReader(const std::vector<bool>& symbolMask, SymbolTable& symbolTable,
             const IODirectives& ioDirectives, const bool provenance) override {
+        // nullary relations have no tuples to hand out in batches
+        if (ioDirectives.has("parallel") && ioDirectives.get("parallel") == "true" && !symbolMask.empty()) {
+            return std::make_unique<ReadCinPipelinedCSV>(
+                    std::cin, symbolMask, symbolTable, ioDirectives, provenance);
+        }
         return std::make_unique<ReadStreamCSV>(std::cin, symbolMask, symbolTable, ioDirectives, provenance);
     }
     const std::string& getName() const override {
@@ -219,6 +875,20 @@ class ReadFileCSVFactory : public ReadStreamFactory {
 public:
     std::unique_ptr<ReadStream> getReader(const std::vector<bool>& symbolMask, SymbolTable& symbolTable,
             const IODirectives& ioDirectives, const bool provenance) override {
+        // use the memory-mapped reader for plain files, streams otherwise
+        std::string fileName = ioDirectives.has("filename") ? ioDirectives.get("filename")
+                                                            : ioDirectives.getRelationName() + ".facts";
+        auto mappedFile = std::make_unique<MappedFile>(fileName);
+#ifdef USE_ZSTD
+        // zstd compressed files are decompressed in parallel, and then read like plain ones
+        if (mappedFile->isValid() && mappedFile->isZstd()) {
+            mappedFile->decompress();
+        }
+#endif
+        if (mappedFile->isValid() && !mappedFile->isCompressed()) {
+            return std::make_unique<ReadFileMappedCSV>(
+                    std::move(mappedFile), symbolMask, symbolTable, ioDirectives, provenance);
+        }
         return std::make_unique<ReadFileCSV>(symbolMask, symbolTable, ioDirectives, provenance);
     }
     const std::string& getName() const override {
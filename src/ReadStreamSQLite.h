@@ -18,16 +18,22 @@
 #include "ReadStream.h"
 #include "SymbolTable.h"
 
+#include <cstdint>
 #include <fstream>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include <sqlite3.h>
 
 namespace souffle {
 
+/**
+ * Reads a relation from the view of its table in an SQLite database, in
+ * batches of rows.
+ */
 class ReadStreamSQLite : public ReadStream {
 public:
     ReadStreamSQLite(const std::string& dbFilename, const std::string& relationName,
@@ -45,6 +51,9 @@ public:
     }
 
 protected:
+    /** the number of tuples of a batch */
+    static constexpr size_t BATCH_SIZE = 1 << 16;
+
     /**
      * Read and return the next tuple.
      *
@@ -57,10 +66,52 @@ protected:
         }
 
         std::unique_ptr<RamDomain[]> tuple = std::make_unique<RamDomain[]>(arity + (isProvenance ? 2 : 0));
+        readRow(tuple.get());
+        return tuple;
+    }
+
+    /** Read the rows of the table into a single batch, a number of rows at a time */
+    bool readBatches(std::vector<std::vector<RamDomain>>& batches) override {
+        if (done) {
+            return false;
+        }
+        const size_t width = symbolMask.size();
+        batches.resize(1);
+        std::vector<RamDomain>& batch = batches[0];
+        batch.clear();
+        int result = SQLITE_ROW;
+        while (batch.size() < BATCH_SIZE * width && (result = sqlite3_step(selectStatement)) == SQLITE_ROW) {
+            batch.resize(batch.size() + width, 0);
+            readRow(&batch[batch.size() - width]);
+        }
+        if (result != SQLITE_ROW && result != SQLITE_DONE) {
+            throwError("SQLite error in sqlite3_step: ");
+        }
+        // a finished statement would start over if stepped again
+        done = result == SQLITE_DONE;
+        return !batch.empty();
+    }
 
-        uint32_t column;
-        for (column = 0; column < arity; column++) {
-            std::string element(reinterpret_cast<const char*>(sqlite3_column_text(selectStatement, column)));
+    const RamDomain* readNextTupleInPlace() override {
+        return done ? nullptr : ReadStream::readNextTupleInPlace();
+    }
+
+    /** Read the current row of the select statement into a tuple */
+    void readRow(RamDomain* tuple) {
+        for (uint32_t column = 0; column < arity; column++) {
+            // numbers are stored as integers, read without a conversion to text
+            if (!symbolMask.at(column) && sqlite3_column_type(selectStatement, column) == SQLITE_INTEGER) {
+                const int64_t value = sqlite3_column_int64(selectStatement, column);
+                tuple[column] = value;
+                if (tuple[column] != value) {
+                    std::stringstream errorMessage;
+                    errorMessage << "Error converting number in column " << (column) + 1;
+                    throw std::invalid_argument(errorMessage.str());
+                }
+                continue;
+            }
+            const char* text = reinterpret_cast<const char*>(sqlite3_column_text(selectStatement, column));
+            std::string element(text == nullptr ? "" : text);
 
             if (element.empty()) {
                 element = "n/a";
@@ -81,8 +132,6 @@ protected:
                 }
             }
         }
-
-        return tuple;
     }
 
     void executeSQL(const std::string& sql) {
@@ -146,9 +195,10 @@ protected:
         sqlite3_finalize(tableStatement);
         throw std::invalid_argument("Required table and view does not exist for relation " + relationName);
     }
-    const std::string& dbFilename;
-    const std::string& relationName;
+    const std::string dbFilename;
+    const std::string relationName;
     sqlite3_stmt* selectStatement = nullptr;
+    bool done = false;
     sqlite3* db = nullptr;
 };
 
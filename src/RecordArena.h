@@ -0,0 +1,149 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RecordArena.h
+ *
+ * Storage for records whose references do not escape the query creating them
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamTypes.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A thread-local store of the records packed by a single evaluation of a query whose
+ * references are only compared -- with other references, or with the values of relations
+ * in searches -- and never stored or unpacked.
+ *
+ * Packing a record that already exists in the global record table yields its global
+ * reference, such that comparisons with stored values remain exact; other records obtain
+ * negative references, distinct from all global references and from the null reference,
+ * without being added to the global table. The records of an arena are released in bulk
+ * by clear() once the query is complete.
+ *
+ * The arena remembers the reference given to each record, hence the references of a record
+ * agree throughout the evaluation even if the record enters the global table meanwhile.
+ */
+class RecordArena {
+    /** The records, each as its reference, its arity and its fields */
+    std::vector<RamDomain> storage;
+
+    /** An open-addressing hash table of the offsets of the records plus one (0 = free slot) */
+    std::vector<size_t> slots;
+
+    /** The number of records stored */
+    size_t size = 0;
+
+    /** The number of negative references assigned */
+    RamDomain locals = 0;
+
+    static size_t hash(const RamDomain* tuple, size_t arity) {
+        uint64_t h = 0x9e3779b97f4a7c15ull ^ arity;
+        for (size_t i = 0; i < arity; i++) {
+            h ^= static_cast<uint32_t>(tuple[i]);
+            h *= 0x100000001b3ull;
+        }
+        h ^= h >> 29;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 32;
+        return static_cast<size_t>(h);
+    }
+
+    bool matches(size_t offset, const RamDomain* tuple, size_t arity) const {
+        return static_cast<size_t>(storage[offset + 1]) == arity &&
+               std::equal(tuple, tuple + arity, storage.begin() + offset + 2);
+    }
+
+    /** Doubles the number of slots */
+    void grow() {
+        std::vector<size_t> fresh(std::max<size_t>(slots.size() * 2, 16), 0);
+        size_t mask = fresh.size() - 1;
+        for (size_t slot : slots) {
+            if (slot == 0) {
+                continue;
+            }
+            size_t offset = slot - 1;
+            size_t pos = hash(&storage[offset + 2], storage[offset + 1]) & mask;
+            while (fresh[pos] != 0) {
+                pos = (pos + 1) & mask;
+            }
+            fresh[pos] = slot;
+        }
+        slots.swap(fresh);
+    }
+
+public:
+    /**
+     * Obtains the reference of the given tuple, consulting the global table by the given
+     * lookup function -- returning the global reference of the tuple or 0 if there is none --
+     * only for records not seen by this arena before.
+     */
+    template <typename Lookup>
+    RamDomain pack(const RamDomain* tuple, size_t arity, Lookup global) {
+        if ((size + 1) * 4 > slots.size() * 3) {
+            grow();
+        }
+
+        // probe for the tuple
+        size_t mask = slots.size() - 1;
+        size_t pos = hash(tuple, arity) & mask;
+        while (size_t slot = slots[pos]) {
+            if (matches(slot - 1, tuple, arity)) {
+                return storage[slot - 1];
+            }
+            pos = (pos + 1) & mask;
+        }
+
+        // not seen before => take the global reference or create a local one
+        RamDomain ref = global(tuple);
+        if (ref == 0) {
+            ref = -(++locals);
+        }
+        slots[pos] = storage.size() + 1;
+        storage.push_back(ref);
+        storage.push_back(static_cast<RamDomain>(arity));
+        storage.insert(storage.end(), tuple, tuple + arity);
+        size++;
+        return ref;
+    }
+
+    /**
+     * Releases all records of this arena.
+     */
+    void clear() {
+        std::vector<RamDomain>().swap(storage);
+        std::vector<size_t>().swap(slots);
+        size = 0;
+        locals = 0;
+    }
+
+    /**
+     * Determines whether this arena holds no records.
+     */
+    bool empty() const {
+        return size == 0;
+    }
+
+    /**
+     * Obtains an estimate of the number of bytes occupied by this arena.
+     */
+    size_t getMemoryUsage() const {
+        return sizeof(*this) + storage.capacity() * sizeof(RamDomain) + slots.capacity() * sizeof(size_t);
+    }
+};
+
+}  // end of namespace souffle
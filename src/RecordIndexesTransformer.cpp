@@ -0,0 +1,221 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RecordIndexesTransformer.cpp
+ *
+ * Define classes and functionality related to the materialisation of the
+ * fields of record columns as columns of their relation.
+ *
+ ***********************************************************************/
+
+#include "AstArgument.h"
+#include "AstAttribute.h"
+#include "AstClause.h"
+#include "AstIOTypeAnalysis.h"
+#include "AstLiteral.h"
+#include "AstNode.h"
+#include "AstProgram.h"
+#include "AstRelation.h"
+#include "AstRelationIdentifier.h"
+#include "AstTransforms.h"
+#include "AstTranslationUnit.h"
+#include "AstType.h"
+#include "AstVisitor.h"
+#include "DebugReport.h"
+#include "Global.h"
+#include "Util.h"
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace {
+
+/** The record columns of a relation whose fields are materialised, and the number of their fields */
+using FieldColumns = std::map<size_t, size_t>;
+
+/** Get the argument of an atom at a column if it is a record, nullptr otherwise */
+const AstRecordInit* getRecord(const AstAtom& atom, size_t column) {
+    return dynamic_cast<const AstRecordInit*>(atom.getArgument(column));
+}
+
+/** Whether a body atom searches the contents of the record at a column */
+bool probesFields(const AstAtom& atom, size_t column) {
+    const AstRecordInit* record = getRecord(atom, column);
+    if (record == nullptr) {
+        return false;
+    }
+    for (const AstArgument* arg : record->getArguments()) {
+        if (dynamic_cast<const AstUnnamedVariable*>(arg) == nullptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+bool RecordIndexesTransformer::transform(AstTranslationUnit& translationUnit) {
+    AstProgram& program = *translationUnit.getProgram();
+    const auto* ioType = translationUnit.getAnalysis<IOType>();
+    std::stringstream report;
+
+    // the body atoms of each relation, including those in negations and aggregates
+    std::set<const AstAtom*> heads;
+    std::map<AstRelationIdentifier, std::vector<const AstAtom*>> uses;
+    for (const AstRelation* rel : program.getRelations()) {
+        for (const AstClause* clause : rel->getClauses()) {
+            heads.insert(clause->getHead());
+            visitDepthFirst(*clause, [&](const AstAtom& atom) {
+                if (&atom != clause->getHead()) {
+                    uses[atom.getName()].push_back(&atom);
+                }
+            });
+        }
+    }
+
+    // -- select the record columns whose fields are materialised --
+
+    // a column qualifies if every rule of the relation derives a record at it, such that its fields are
+    // known without unpacking it, and a body atom searches the fields of the record
+    std::map<AstRelationIdentifier, FieldColumns> selected;
+    for (AstRelation* rel : program.getRelations()) {
+        const auto clauses = rel->getClauses();
+        if (clauses.empty() || rel->isInline() || ioType->isIO(rel) || rel->isSubsumptive() ||
+                rel->getRepresentation() == RelationRepresentation::EQREL ||
+                rel->getRepresentation() == RelationRepresentation::STORAGE ||
+                rel->getFactTable() != nullptr) {
+            continue;
+        }
+        const size_t arity = rel->getArity();
+        for (size_t column = 0; column < arity; column++) {
+            const AstAttribute* attribute = rel->getAttribute(column);
+            const auto* type = dynamic_cast<const AstRecordType*>(program.getType(attribute->getTypeName()));
+            if (type == nullptr || type->getFields().empty()) {
+                continue;
+            }
+            bool derived = true;
+            for (const AstClause* clause : clauses) {
+                const AstRecordInit* record = getRecord(*clause->getHead(), column);
+                bool counted = false;
+                if (record != nullptr) {
+                    visitDepthFirst(*record, [&](const AstCounter&) { counted = true; });
+                }
+                derived = derived && record != nullptr && !counted;
+            }
+            size_t probes = 0;
+            for (const AstAtom* atom : uses[rel->getName()]) {
+                if (probesFields(*atom, column)) {
+                    probes++;
+                }
+            }
+            if (!derived || probes == 0) {
+                continue;
+            }
+
+            // the fields are appended as columns, named after the record column
+            for (const auto& field : type->getFields()) {
+                rel->addAttribute(std::make_unique<AstAttribute>(
+                        attribute->getAttributeName() + "." + field.name, field.type));
+            }
+            selected[rel->getName()][column] = type->getFields().size();
+            report << rel->getName() << ": fields of column " << column << " materialised, " << probes
+                   << " of " << uses[rel->getName()].size() << " uses search them\n";
+        }
+    }
+
+    if (selected.empty()) {
+        return false;
+    }
+
+    // -- let the atoms read the fields from their columns instead of the records --
+
+    struct readFields : public AstNodeMapper {
+        const std::map<AstRelationIdentifier, FieldColumns>& selected;
+        const std::set<const AstAtom*>& heads;
+
+        readFields(const std::map<AstRelationIdentifier, FieldColumns>& selected,
+                const std::set<const AstAtom*>& heads)
+                : selected(selected), heads(heads) {}
+
+        std::unique_ptr<AstNode> operator()(std::unique_ptr<AstNode> node) const override {
+            node->apply(*this);
+            auto* atom = dynamic_cast<AstAtom*>(node.get());
+            if (atom == nullptr || heads.count(atom) != 0) {
+                return node;
+            }
+            auto pos = selected.find(atom->getName());
+            if (pos == selected.end()) {
+                return node;
+            }
+
+            // a record is equal to another one with the same fields, hence its column is not read
+            auto* fieldAtom = new AstAtom(atom->getName());
+            fieldAtom->setSrcLoc(atom->getSrcLoc());
+            std::vector<std::unique_ptr<AstArgument>> fields;
+            for (size_t i = 0; i < atom->getArity(); i++) {
+                auto column = pos->second.find(i);
+                const AstRecordInit* record = getRecord(*atom, i);
+                if (column == pos->second.end()) {
+                    fieldAtom->addArgument(std::unique_ptr<AstArgument>(atom->getArgument(i)->clone()));
+                } else if (record != nullptr) {
+                    fieldAtom->addArgument(std::make_unique<AstUnnamedVariable>());
+                    for (const AstArgument* arg : record->getArguments()) {
+                        fields.emplace_back(arg->clone());
+                    }
+                } else {
+                    fieldAtom->addArgument(std::unique_ptr<AstArgument>(atom->getArgument(i)->clone()));
+                    for (size_t j = 0; j < column->second; j++) {
+                        fields.push_back(std::make_unique<AstUnnamedVariable>());
+                    }
+                }
+            }
+            for (auto& field : fields) {
+                fieldAtom->addArgument(std::move(field));
+            }
+            return std::unique_ptr<AstNode>(fieldAtom);
+        }
+    };
+
+    program.apply(readFields(selected, heads));
+
+    // -- let the rules write the fields of the records they derive --
+
+    for (const auto& cur : selected) {
+        AstRelation* rel = program.getRelation(cur.first);
+        for (AstClause* clause : rel->getClauses()) {
+            const AstAtom* head = clause->getHead();
+            auto fieldHead = std::unique_ptr<AstAtom>(head->clone());
+            for (const auto& column : cur.second) {
+                for (const AstArgument* arg : getRecord(*head, column.first)->getArguments()) {
+                    fieldHead->addArgument(std::unique_ptr<AstArgument>(arg->clone()));
+                }
+            }
+            clause->setHead(std::move(fieldHead));
+        }
+    }
+
+    if (DebugReport::isSelected("record-indexes")) {
+        translationUnit.getDebugReport().addSection(
+                DebugReporter::getCodeSection("record-indexes", "Record Indexes", report.str()));
+    }
+    if (Global::config().has("verbose")) {
+        std::cout << report.str();
+    }
+    return true;
+}
+
+}  // end of namespace souffle
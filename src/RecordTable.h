@@ -0,0 +1,323 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RecordTable.h
+ *
+ * A concurrent hash-consing table for records, shared by the interpreters
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ParallelUtils.h"
+#include "RamTypes.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A bidirectional mapping between tuples of a fixed arity and reference indices.
+ *
+ * Tuples are hash-consed in a set of independently locked open-addressing
+ * shards storing only record indices; lookups compare against the stored
+ * tuples in place, so packing does not allocate unless a new record is created.
+ * Records are kept in append-only chunks that are never moved, hence unpacking
+ * an index is lock-free. Index 0 is reserved for the null reference.
+ */
+class RecordTable {
+    /** The number of shards of the hash table (log 2) */
+    static constexpr int SHARD_BITS = 6;
+    static constexpr size_t NUM_SHARDS = size_t(1) << SHARD_BITS;
+
+    /** The initial number of slots of each shard */
+    static constexpr size_t INITIAL_SLOTS = 64;
+
+    /** The number of records per storage chunk (log 2) */
+    static constexpr int CHUNK_BITS = 16;
+    static constexpr size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+
+    /** The number of chunks required to address all non-negative indices */
+    static constexpr size_t MAX_CHUNKS =
+            (size_t(std::numeric_limits<RamDomain>::max()) >> CHUNK_BITS) + 1;
+
+    /** A shard of the hash table, mapping hashes to record indices (0 = empty slot) */
+    struct Shard {
+        Lock lock;
+        std::vector<RamDomain> slots;
+        size_t size = 0;
+
+        Shard() : slots(INITIAL_SLOTS, 0) {}
+    };
+
+    /** The arity of the stored tuples */
+    const int arity;
+
+    /** The number of values stored per record (at least one, to keep addresses distinct) */
+    const size_t stride;
+
+    /** The hash table shards */
+    std::unique_ptr<Shard[]> shards;
+
+    /** The record storage, allocated chunk by chunk on demand */
+    std::unique_ptr<std::atomic<RamDomain*>[]> chunks;
+
+    /** The next index to be assigned */
+    std::atomic<RamDomain> next{1};
+
+    size_t hash(const RamDomain* tuple) const {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (int i = 0; i < arity; i++) {
+            h ^= static_cast<uint32_t>(tuple[i]);
+            h *= 0x100000001b3ull;
+        }
+        // final mix such that both the shard and the slot bits depend on all values
+        h ^= h >> 29;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 32;
+        return static_cast<size_t>(h);
+    }
+
+    static size_t getShard(size_t h) {
+        return (h >> 7) & (NUM_SHARDS - 1);
+    }
+
+    RamDomain* getRecord(RamDomain index) const {
+        RamDomain* chunk = chunks[index >> CHUNK_BITS].load(std::memory_order_acquire);
+        assert(chunk != nullptr && "unknown record reference");
+        return chunk + (index & (CHUNK_SIZE - 1)) * stride;
+    }
+
+    bool equal(const RamDomain* a, const RamDomain* b) const {
+        return std::equal(a, a + arity, b);
+    }
+
+    /** Appends a copy of the given tuple to the storage, returning its index */
+    RamDomain append(const RamDomain* tuple) {
+        RamDomain index = next.fetch_add(1, std::memory_order_relaxed);
+
+        // assert that new index is smaller than the range
+        assert(index != std::numeric_limits<RamDomain>::max());
+
+        // make sure the chunk holding the record exists
+        std::atomic<RamDomain*>& slot = chunks[index >> CHUNK_BITS];
+        RamDomain* chunk = slot.load(std::memory_order_acquire);
+        if (chunk == nullptr) {
+            RamDomain* fresh = new RamDomain[CHUNK_SIZE * stride];
+            if (slot.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) {
+                chunk = fresh;
+            } else {
+                delete[] fresh;
+            }
+        }
+
+        std::copy(tuple, tuple + arity, chunk + (index & (CHUNK_SIZE - 1)) * stride);
+        return index;
+    }
+
+    /** Doubles the number of slots of a shard; the caller holds the shard's lock */
+    void grow(Shard& shard) {
+        std::vector<RamDomain> slots(shard.slots.size() * 2, 0);
+        size_t mask = slots.size() - 1;
+        for (RamDomain index : shard.slots) {
+            if (index == 0) {
+                continue;
+            }
+            size_t pos = hash(getRecord(index)) & mask;
+            while (slots[pos] != 0) {
+                pos = (pos + 1) & mask;
+            }
+            slots[pos] = index;
+        }
+        shard.slots.swap(slots);
+    }
+
+public:
+    explicit RecordTable(int arity)
+            : arity(arity), stride(std::max(arity, 1)), shards(new Shard[NUM_SHARDS]),
+              chunks(new std::atomic<RamDomain*>[MAX_CHUNKS]()) {}
+
+    RecordTable(const RecordTable&) = delete;
+    RecordTable& operator=(const RecordTable&) = delete;
+
+    ~RecordTable() {
+        for (size_t i = 0; i < MAX_CHUNKS; i++) {
+            delete[] chunks[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Packs the given tuple -- and may create a new reference if necessary.
+     */
+    RamDomain pack(const RamDomain* tuple) {
+        size_t h = hash(tuple);
+        Shard& shard = shards[getShard(h)];
+        LockSiteScope lockSite(LockSite::RECORDS);
+        auto lease = shard.lock.acquire();
+        (void)lease;
+
+        // probe for the tuple
+        size_t mask = shard.slots.size() - 1;
+        size_t pos = h & mask;
+        while (RamDomain index = shard.slots[pos]) {
+            if (equal(getRecord(index), tuple)) {
+                return index;
+            }
+            pos = (pos + 1) & mask;
+        }
+
+        // not present => create a new record in the free slot
+        RamDomain index = append(tuple);
+        shard.slots[pos] = index;
+
+        // keep the load factor below 3/4
+        if (++shard.size * 4 > shard.slots.size() * 3) {
+            grow(shard);
+        }
+        return index;
+    }
+
+    /**
+     * Looks up the reference of the given tuple without creating one; 0 if absent.
+     */
+    RamDomain find(const RamDomain* tuple) {
+        size_t h = hash(tuple);
+        Shard& shard = shards[getShard(h)];
+        LockSiteScope lockSite(LockSite::RECORDS);
+        auto lease = shard.lock.acquire();
+        (void)lease;
+
+        size_t mask = shard.slots.size() - 1;
+        size_t pos = h & mask;
+        while (RamDomain index = shard.slots[pos]) {
+            if (equal(getRecord(index), tuple)) {
+                return index;
+            }
+            pos = (pos + 1) & mask;
+        }
+        return 0;
+    }
+
+    /**
+     * Obtains a pointer to the tuple addressed by the given index.
+     */
+    RamDomain* unpack(RamDomain index) const {
+        return getRecord(index);
+    }
+
+    /**
+     * Obtains the number of records stored in this table.
+     */
+    size_t size() const {
+        return next.load(std::memory_order_relaxed) - 1;
+    }
+
+    /**
+     * Obtains an estimate of the number of bytes occupied by this table,
+     * not to be called while records are packed.
+     */
+    size_t getMemoryUsage() const {
+        size_t res = sizeof(*this) + NUM_SHARDS * sizeof(Shard);
+        res += MAX_CHUNKS * sizeof(std::atomic<RamDomain*>);
+        for (size_t i = 0; i < NUM_SHARDS; i++) {
+            res += shards[i].slots.capacity() * sizeof(RamDomain);
+        }
+        for (size_t i = 0; i <= (size() >> CHUNK_BITS); i++) {
+            if (chunks[i].load(std::memory_order_relaxed) != nullptr) {
+                res += CHUNK_SIZE * stride * sizeof(RamDomain);
+            }
+        }
+        return res;
+    }
+};
+
+/**
+ * A collection of record tables for all arities, created on demand.
+ */
+class RecordTableSet {
+    /** The number of arities served by a lock-free lookup */
+    static constexpr int DIRECT_ARITIES = 64;
+
+    /** Tables of small arities, installed atomically */
+    std::atomic<RecordTable*> direct[DIRECT_ARITIES];
+
+    /** Tables of larger arities */
+    std::map<int, std::unique_ptr<RecordTable>> others;
+    Lock othersLock;
+
+public:
+    RecordTableSet() {
+        for (auto& table : direct) {
+            table.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    RecordTableSet(const RecordTableSet&) = delete;
+    RecordTableSet& operator=(const RecordTableSet&) = delete;
+
+    ~RecordTableSet() {
+        for (auto& table : direct) {
+            delete table.load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Obtains the table storing records of the given arity.
+     */
+    RecordTable& getForArity(int arity) {
+        assert(arity >= 0);
+        if (arity < DIRECT_ARITIES) {
+            RecordTable* table = direct[arity].load(std::memory_order_acquire);
+            if (table == nullptr) {
+                auto* fresh = new RecordTable(arity);
+                if (direct[arity].compare_exchange_strong(table, fresh, std::memory_order_acq_rel)) {
+                    table = fresh;
+                } else {
+                    delete fresh;
+                }
+            }
+            return *table;
+        }
+
+        auto lease = othersLock.acquire();
+        (void)lease;
+        std::unique_ptr<RecordTable>& table = others[arity];
+        if (!table) {
+            table.reset(new RecordTable(arity));
+        }
+        return *table;
+    }
+
+    /**
+     * Obtains an estimate of the number of bytes occupied by the tables of all arities.
+     */
+    size_t getMemoryUsage() {
+        size_t res = sizeof(*this);
+        for (auto& cur : direct) {
+            if (RecordTable* table = cur.load(std::memory_order_acquire)) {
+                res += table->getMemoryUsage();
+            }
+        }
+        auto lease = othersLock.acquire();
+        (void)lease;
+        for (const auto& cur : others) {
+            res += cur.second->getMemoryUsage();
+        }
+        return res;
+    }
+};
+
+}  // end of namespace souffle
@@ -0,0 +1,91 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RegexCache.h
+ *
+ * The compiled regular expressions of the patterns of match constraints.
+ * Compiling a pattern costs far more than matching a text against it, so
+ * each pattern is compiled on its first use only and then shared by all
+ * threads of the evaluation.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ParallelUtils.h"
+#include "RamTypes.h"
+#include "SymbolTable.h"
+
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <string>
+#include <unordered_map>
+
+namespace souffle {
+
+class RegexCache {
+public:
+    /** Compile a pattern, giving null for invalid patterns */
+    static std::unique_ptr<const std::regex> compile(const std::string& pattern) {
+        try {
+            return std::unique_ptr<const std::regex>(new std::regex(pattern, std::regex::optimize));
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    /**
+     * Whether the text matches the compiled pattern of the given symbol, or
+     * does not match it if negated; invalid patterns give false either way
+     */
+    static bool match(const std::regex* regex, RamDomain pattern, const std::string& text,
+            const SymbolTable& symbolTable, bool negated) {
+        if (regex == nullptr) {
+            std::cerr << "warning: wrong pattern provided for " << (negated ? "!" : "") << "match(\""
+                      << symbolTable.resolve(pattern) << "\",\"" << text << "\").\n";
+            return false;
+        }
+        return std::regex_match(text, *regex) != negated;
+    }
+
+    /** Get the compiled pattern of a symbol, null for invalid patterns */
+    const std::regex* get(RamDomain pattern, const SymbolTable& symbolTable) {
+        lock.start_read();
+        auto pos = regexes.find(pattern);
+        if (pos != regexes.end()) {
+            const std::regex* regex = pos->second.get();
+            lock.end_read();
+            return regex;
+        }
+        lock.end_read();
+
+        // compile outside of the lock, keeping the pattern of the first thread to enter it
+        std::unique_ptr<const std::regex> regex = compile(symbolTable.resolve(pattern));
+        lock.start_write();
+        const std::regex* res = regexes.emplace(pattern, std::move(regex)).first->second.get();
+        lock.end_write();
+        return res;
+    }
+
+    /** Whether the text matches the pattern of the given symbol, or does not match it if negated */
+    bool match(RamDomain pattern, const std::string& text, const SymbolTable& symbolTable, bool negated) {
+        return match(get(pattern, symbolTable), pattern, text, symbolTable, negated);
+    }
+
+private:
+    /** The compiled patterns by their symbols, never removed */
+    std::unordered_map<RamDomain, std::unique_ptr<const std::regex>> regexes;
+
+    /** Lock of the patterns */
+    ReadWriteLock lock;
+};
+
+}  // end of namespace souffle
@@ -29,7 +29,17 @@ enum class RelationRepresentation {
     // btree data-structure
     BRIE,
     // equivalence relation
-    EQREL
+    EQREL,
+    // delta-encoded blocks of tuples
+    COMPRESSED,
+    // hash table of tuples
+    HASHSET,
+    // sorted array of tuples in a memory-mapped file
+    MMAP,
+    // compressed bitmaps of the second values of binary relations
+    BITMAP,
+    // storage created by a registered storage provider
+    STORAGE
 };
 
 inline std::ostream& operator<<(std::ostream& os, RelationRepresentation structure) {
@@ -43,6 +53,21 @@ inline std::ostream& operator<<(std::ostream& os, RelationRepresentation structu
         case RelationRepresentation::EQREL:
             os << "eqrel";
             break;
+        case RelationRepresentation::COMPRESSED:
+            os << "compressed";
+            break;
+        case RelationRepresentation::HASHSET:
+            os << "hashset";
+            break;
+        case RelationRepresentation::MMAP:
+            os << "mmap";
+            break;
+        case RelationRepresentation::BITMAP:
+            os << "bitmap";
+            break;
+        case RelationRepresentation::STORAGE:
+            os << "storage";
+            break;
         case RelationRepresentation::DEFAULT:
         default:
             break;
@@ -23,8 +23,13 @@
 #include "AstRelation.h"
 #include "AstTransforms.h"
 #include "AstTranslationUnit.h"
+#include "AstTypeAnalysis.h"
+#include "AstTypeEnvironmentAnalysis.h"
+#include "AstUtils.h"
 #include "AstVisitor.h"
 #include "Global.h"
+#include "PrecedenceGraph.h"
+#include <algorithm>
 #include <cmath>
 #include <set>
 #include <string>
@@ -42,6 +47,20 @@ inline bool isProposition(const AstAtom* atom) {
     return atom->getArguments().empty();
 }
 
+/**
+ * Determines whether the given argument is bound, i.e. all its variables are bound.
+ */
+bool isBoundArgument(const AstArgument* arg, const std::set<std::string>& boundVariables) {
+    bool isBound = true;
+    visitDepthFirst(*arg, [&](const AstVariable& var) {
+        if (boundVariables.find(var.getName()) == boundVariables.end()) {
+            // found an unbound variable, so argument is unbound
+            isBound = false;
+        }
+    });
+    return isBound;
+}
+
 /**
  * Counts the number of bound arguments in a given atom.
  */
@@ -49,17 +68,7 @@ unsigned int numBoundArguments(const AstAtom* atom, const std::set<std::string>&
     int count = 0;
 
     for (const AstArgument* arg : atom->getArguments()) {
-        // argument is bound iff all contained variables are bound
-        bool isBound = true;
-
-        visitDepthFirst(*arg, [&](const AstVariable& var) {
-            if (boundVariables.find(var.getName()) == boundVariables.end()) {
-                // found an unbound variable, so argument is unbound
-                isBound = false;
-            }
-        });
-
-        if (isBound) {
+        if (isBoundArgument(arg, boundVariables)) {
             count++;
         }
     }
@@ -353,6 +362,14 @@ bool reorderClauseWithSips(sips_t sipsFunction, AstClause* clause) {
     return false;
 }
 
+std::set<std::string> ReorderLiteralsTransformer::getPreservedAnalyses() const {
+    // atoms are only permuted within their clauses, keeping nodes, types and dependencies
+    auto preserved = getRelationDependencyAnalyses();
+    preserved.insert({RecursiveClauses::name, TypeEnvironmentAnalysis::name, TypeAnalysis::name,
+            AstProfileUse::name});
+    return preserved;
+}
+
 bool ReorderLiteralsTransformer::transform(AstTranslationUnit& translationUnit) {
     bool changed = false;
     AstProgram& program = *translationUnit.getProgram();
@@ -367,60 +384,130 @@ bool ReorderLiteralsTransformer::transform(AstTranslationUnit& translationUnit)
     }
     auto sipsFunction = getSipsFunction(sipsChosen);
 
-    // literal reordering is a rule-local transformation
+    // literal reordering is a rule-local transformation, hence clauses are reordered in parallel
+    std::vector<AstClause*> clauses;
     for (const AstRelation* rel : program.getRelations()) {
         for (AstClause* clause : rel->getClauses()) {
-            changed |= reorderClauseWithSips(sipsFunction, clause);
+            clauses.push_back(clause);
+        }
+    }
+    int numClauses = clauses.size();
+    int numReordered = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+ : numReordered)
+    for (int i = 0; i < numClauses; i++) {
+        if (reorderClauseWithSips(sipsFunction, clauses[i])) {
+            numReordered++;
         }
     }
+    changed = numReordered > 0;
 
-    // --- profile-guided reordering ---
-    if (Global::config().has("profile-use")) {
+    // --- profile-guided reordering, by a profile or the statistics of previous runs ---
+    if (Global::config().has("profile-use") || Global::config().has("statistics")) {
         // parse supplied profile information
         auto* profileUse = translationUnit.getAnalysis<AstProfileUse>();
-
-        auto profilerSips = [&](std::vector<AstAtom*> atoms, const std::set<std::string>& boundVariables) {
-            // Goal: reorder based on the given profiling information
-            // Metric: cost(atom_R) = log(|atom_R|) * #free/#args
-            //         - exception: propositions are prioritised
-
-            double currOptimalVal = -1;
-            unsigned int currOptimalIdx = 0U;
-            bool set = false;
-
-            for (unsigned int i = 0; i < atoms.size(); i++) {
-                const AstAtom* currAtom = atoms[i];
-
-                if (currAtom == nullptr) {
-                    // already processed - move on
+        const auto* recursiveClauses = translationUnit.getAnalysis<RecursiveClauses>();
+        const auto* sccGraph = translationUnit.getAnalysis<SCCGraph>();
+
+        // estimates the number of tuples of an atom matching a single binding of its bound arguments
+        auto estimateMatches = [&](const AstAtom* atom, const std::set<std::string>& boundVariables,
+                                       double size) {
+            const AstRelationIdentifier& name = atom->getName();
+            const auto& args = atom->getArguments();
+            double res = size;
+            for (size_t i = 0; i < args.size(); i++) {
+                if (!isBoundArgument(args[i], boundVariables)) {
                     continue;
                 }
-
-                if (isProposition(currAtom)) {
-                    // prioritise propositions
-                    return i;
+                // a constant matches the tuples holding it, frequent values many more than others
+                const auto* constant = dynamic_cast<const AstConstant*>(args[i]);
+                if (constant != nullptr && profileUse->hasValueMatches(name, i) && size > 0) {
+                    const auto* symbol = dynamic_cast<const AstStringConstant*>(constant);
+                    const std::string value = (symbol != nullptr) ? symbol->getConstant()
+                                                                  : std::to_string(constant->getIndex());
+                    res *= std::min(1.0, profileUse->getValueMatches(name, i, value) / size);
+                    continue;
                 }
+                // without column statistics, assume the values to be spread evenly over all columns
+                double distinct = profileUse->hasDistinctValues(name, i)
+                                          ? profileUse->getDistinctValues(name, i)
+                                          : std::pow(size, 1.0 / args.size());
+                res /= std::max(1.0, std::min(distinct, size));
+            }
+            return res;
+        };
 
-                // calculate log(|R|) * #free/#args
-                int numBound = numBoundArguments(currAtom, boundVariables);
-                int numArgs = currAtom->getArity();
-                int numFree = numArgs - numBound;
-                double value = log(profileUse->getRelationSize(currAtom->getName()));
-                value *= (numFree * 1.0) / numArgs;
-
-                if (!set || value < currOptimalVal) {
-                    set = true;
-                    currOptimalVal = value;
-                    currOptimalIdx = i;
+        // creates a SIPS for a version of a clause in which the given atom is read from the delta
+        auto getProfilerSips = [&](const AstAtom* deltaAtom) -> sips_t {
+            return [&, deltaAtom](std::vector<AstAtom*> atoms, const std::set<std::string>& boundVariables) {
+                // Goal: reorder based on the given profiling information
+                // Metric: cost(atom_R) = |R| * prod_{bound column c of R} 1 / #distinct(R, c)
+                //         - exception: propositions are prioritised
+                //         - the estimated number of matches per binding of the bound variables
+                //           is computed from the profiled relation size and column statistics
+
+                double currOptimalVal = -1;
+                unsigned int currOptimalIdx = 0U;
+                bool set = false;
+
+                for (unsigned int i = 0; i < atoms.size(); i++) {
+                    const AstAtom* currAtom = atoms[i];
+
+                    if (currAtom == nullptr) {
+                        // already processed - move on
+                        continue;
+                    }
+
+                    if (isProposition(currAtom)) {
+                        // prioritise propositions
+                        return i;
+                    }
+
+                    double size = (currAtom == deltaAtom) ? profileUse->getDeltaSize(currAtom->getName())
+                                                          : profileUse->getRelationSize(currAtom->getName());
+                    double value = estimateMatches(currAtom, boundVariables, size);
+
+                    if (!set || value < currOptimalVal) {
+                        set = true;
+                        currOptimalVal = value;
+                        currOptimalIdx = i;
+                    }
                 }
-            }
 
-            return currOptimalIdx;
+                return currOptimalIdx;
+            };
         };
 
         for (const AstRelation* rel : program.getRelations()) {
             for (AstClause* clause : rel->getClauses()) {
-                changed |= reorderClauseWithSips(profilerSips, clause);
+                if (!recursiveClauses->recursive(clause)) {
+                    changed |= reorderClauseWithSips(getProfilerSips(nullptr), clause);
+                    continue;
+                }
+
+                // ignore clauses with fixed execution plans
+                if (clause->getExecutionPlan() != nullptr) {
+                    continue;
+                }
+
+                // recursive clauses are evaluated in one version per atom of the same stratum,
+                // reading that atom from the delta; choose an order for each version
+                auto plan = std::make_unique<AstExecutionPlan>();
+                int version = 0;
+                for (const AstAtom* atom : clause->getAtoms()) {
+                    const AstRelation* atomRelation = getAtomRelation(atom, &program);
+                    if (atomRelation == nullptr || sccGraph->getSCC(atomRelation) != sccGraph->getSCC(rel)) {
+                        continue;
+                    }
+                    auto order = std::make_unique<AstExecutionOrder>();
+                    for (unsigned int i : applySips(getProfilerSips(atom), clause->getAtoms())) {
+                        order->appendAtomIndex(i + 1);
+                    }
+                    plan->setOrderFor(version++, std::move(order));
+                }
+                if (version > 0) {
+                    clause->setExecutionPlan(std::move(plan));
+                    changed = true;
+                }
             }
         }
     }
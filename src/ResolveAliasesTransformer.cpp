@@ -23,8 +23,10 @@
 #include "AstRelation.h"
 #include "AstTransforms.h"
 #include "AstTranslationUnit.h"
+#include "AstTypeEnvironmentAnalysis.h"
 #include "AstVisitor.h"
 #include "BinaryConstraintOps.h"
+#include "PrecedenceGraph.h"
 #include "Util.h"
 #include <cassert>
 #include <map>
@@ -431,6 +433,13 @@ std::unique_ptr<AstClause> ResolveAliasesTransformer::removeComplexTermsInAtoms(
     return res;
 }
 
+std::set<std::string> ResolveAliasesTransformer::getPreservedAnalyses() const {
+    // clauses are replaced, while their atoms and hence the dependencies among relations stay the same
+    auto preserved = getRelationDependencyAnalyses();
+    preserved.insert(TypeEnvironmentAnalysis::name);
+    return preserved;
+}
+
 bool ResolveAliasesTransformer::transform(AstTranslationUnit& translationUnit) {
     bool changed = false;
     AstProgram& program = *translationUnit.getProgram();
@@ -443,8 +452,13 @@ bool ResolveAliasesTransformer::transform(AstTranslationUnit& translationUnit) {
         }
     });
 
-    // clean all clauses
-    for (const AstClause* clause : clauses) {
+    // clean all clauses; clauses are cleaned independently of each other, hence in parallel
+    int numClauses = clauses.size();
+    std::vector<std::unique_ptr<AstClause>> normalisedClauses(numClauses);
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < numClauses; i++) {
+        const AstClause* clause = clauses[i];
+
         // -- Step 1 --
         // get rid of aliases
         std::unique_ptr<AstClause> noAlias = resolveAliases(*clause);
@@ -456,11 +470,18 @@ bool ResolveAliasesTransformer::transform(AstTranslationUnit& translationUnit) {
         // restore simple terms in atoms
         std::unique_ptr<AstClause> normalised = removeComplexTermsInAtoms(*cleaned);
 
-        // swap if changed
+        // keep if changed
         if (*normalised != *clause) {
+            normalisedClauses[i] = std::move(normalised);
+        }
+    }
+
+    // swap the changed clauses, in the order of the clauses
+    for (int i = 0; i < numClauses; i++) {
+        if (normalisedClauses[i]) {
             changed = true;
-            program.removeClause(clause);
-            program.appendClause(std::move(normalised));
+            program.removeClause(clauses[i]);
+            program.appendClause(std::move(normalisedClauses[i]));
         }
     }
 
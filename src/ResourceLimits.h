@@ -0,0 +1,118 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ResourceLimits.h
+ *
+ * Enforcement of the time and memory limits of an evaluation, shared by the
+ * interpreters and the synthesised programs
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "SignalHandler.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace souffle {
+
+/**
+ * The wall-time budget and the memory ceiling of an evaluation.
+ *
+ * The limits are checked at the iteration boundaries of fixpoint loops. Once the
+ * resident set exceeds the memory ceiling for the first time, check() reports it such
+ * that the caller may degrade to a lower-memory mode, e.g. by evicting the indexes that
+ * are built on demand; exceeding the ceiling again, or running out of time, aborts the
+ * evaluation. The outputs of the strata completed before the abort have been written.
+ */
+class ResourceLimits {
+public:
+    using clock = std::chrono::steady_clock;
+
+    static ResourceLimits& instance() {
+        static ResourceLimits limits;
+        return limits;
+    }
+
+    /** Sets the wall-time budget in seconds, counted from now; 0 for none */
+    void setTimeLimit(double seconds) {
+        deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+                                          std::chrono::duration<double>(seconds));
+        timeLimited = seconds > 0;
+    }
+
+    /** Sets the memory ceiling in megabytes; 0 for none */
+    void setMemoryLimit(std::size_t megabytes) {
+        memoryLimit = megabytes * 1024 * 1024;
+        degraded = false;
+    }
+
+    /** Determines whether any limit is set */
+    bool isSet() const {
+        return timeLimited || memoryLimit != 0;
+    }
+
+    /**
+     * Checks the limits, aborting the evaluation if they are exceeded. Returns true
+     * if the memory ceiling has been reached for the first time, in which case the
+     * caller should release memory it can recompute.
+     */
+    bool check() {
+        if (!isSet()) {
+            return false;
+        }
+        if (timeLimited && clock::now() > deadline) {
+            SignalHandler::instance()->error("Time limit exceeded");
+        }
+        if (memoryLimit != 0 && getResidentSetSize() > memoryLimit) {
+            if (degraded) {
+                SignalHandler::instance()->error("Memory limit exceeded");
+            }
+            degraded = true;
+            return true;
+        }
+        return false;
+    }
+
+    /** Obtains the current resident set size of the process in bytes */
+    static std::size_t getResidentSetSize() {
+        long pages = 0;
+        if (FILE* file = fopen("/proc/self/statm", "r")) {
+            long size = 0;
+            if (fscanf(file, "%ld %ld", &size, &pages) != 2) {
+                pages = 0;
+            }
+            fclose(file);
+        }
+        if (pages > 0) {
+            return static_cast<std::size_t>(pages) * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        }
+        // fall back to the peak, as sampled by the logger
+        struct rusage ru {};
+        getrusage(RUSAGE_SELF, &ru);
+        return static_cast<std::size_t>(ru.ru_maxrss) * 1024;
+    }
+
+private:
+    ResourceLimits() = default;
+
+    bool timeLimited = false;
+    clock::time_point deadline;
+    std::size_t memoryLimit = 0;
+
+    /** Whether the memory ceiling has been reached before */
+    bool degraded = false;
+};
+
+}  // end of namespace souffle
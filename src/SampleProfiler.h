@@ -0,0 +1,186 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SampleProfiler.h
+ *
+ * Declares the sampling profiler attributing CPU time to rules
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ProfileEvent.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <signal.h>
+#include <sys/time.h>
+
+namespace souffle {
+
+/**
+ * A profiler sampling the position of the threads of the program at a fixed
+ * frequency of consumed CPU time.
+ *
+ * The evaluation marks the position of a thread, i.e. the rule and the loop
+ * level of the rule it evaluates, by storing a number in a thread-local
+ * variable when entering a rule and in each iteration of a loop. A timer
+ * delivers SIGPROF to the thread consuming CPU time, whose handler counts
+ * a sample of the marked position. Compared to timing each rule, this has
+ * a fixed overhead independent of the number and size of the rules.
+ *
+ * The samples are written as profile events when sampling stops, labelled
+ * by the label of the rule followed by the loop level, where level 0 is the
+ * rule outside of its loops and level n its n-th nested loop.
+ */
+class SampleProfiler {
+public:
+    /** the loop levels distinguished for each rule, deeper loops counting as the deepest one */
+    static constexpr size_t LEVELS = 16;
+
+    /** the samples per second of CPU time */
+    static constexpr unsigned FREQUENCY = 1000;
+
+    ~SampleProfiler() {
+        // the profile database may be gone already, discarding the samples
+        if (running) {
+            disarm();
+        }
+    }
+
+    /** get instance */
+    static SampleProfiler& instance() {
+        static SampleProfiler profiler;
+        return profiler;
+    }
+
+    /** Get the position of a loop level of a rule, numbering rules from one */
+    static uint32_t getPosition(size_t rule, size_t level) {
+        return rule * LEVELS + std::min(level, LEVELS - 1);
+    }
+
+    /** Mark the position of the calling thread, position 0 being outside of rules */
+    static void setPosition(uint32_t position) {
+        currentPosition() = position;
+    }
+
+    /**
+     * Start sampling, given the labels of the rules by their number. The
+     * first label is unused since rules are numbered from one.
+     */
+    void start(std::vector<std::string> ruleLabels, unsigned frequency = FREQUENCY) {
+        if (running) {
+            return;
+        }
+        labels = std::move(ruleLabels);
+        size_t count = std::max<size_t>(labels.size(), 1) * LEVELS;
+        samples.reset(new std::atomic<uint64_t>[count]);
+        for (size_t i = 0; i < count; i++) {
+            samples[i].store(0, std::memory_order_relaxed);
+        }
+        capacity().store(count);
+        storage().store(samples.get());
+
+        struct sigaction action {};
+        action.sa_handler = handle;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGPROF, &action, &previousAction);
+
+        struct itimerval timer {};
+        timer.it_interval.tv_usec = 1000000 / frequency;
+        timer.it_value = timer.it_interval;
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        running = true;
+
+        ProfileEventSingleton::instance().makeConfigRecord("sampling-frequency", std::to_string(frequency));
+    }
+
+    /** Stop sampling and write the samples of each rule and loop level as profile events */
+    void stop() {
+        if (!running) {
+            return;
+        }
+        disarm();
+
+        uint64_t other = 0;
+        for (size_t level = 0; level < LEVELS; level++) {
+            other += samples[level].load();
+        }
+        ProfileEventSingleton::instance().makeQuantityEvent("@sample-other", other, 0);
+        for (size_t rule = 1; rule < labels.size(); rule++) {
+            for (size_t level = 0; level < LEVELS; level++) {
+                uint64_t count = samples[getPosition(rule, level)].load();
+                if (count > 0) {
+                    ProfileEventSingleton::instance().makeQuantityEvent(
+                            labels[rule] + std::to_string(level), count, 0);
+                }
+            }
+        }
+    }
+
+private:
+    SampleProfiler() = default;
+
+    /** stop the timer and restore the previous signal action */
+    void disarm() {
+        struct itimerval timer {};
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        sigaction(SIGPROF, &previousAction, nullptr);
+        storage().store(nullptr);
+        running = false;
+    }
+
+    /** the position of the calling thread, volatile to keep the stores observed by the signal handler */
+    static volatile uint32_t& currentPosition() {
+        static thread_local volatile uint32_t position = 0;
+        return position;
+    }
+
+    /** the samples counted by the signal handler, or null when not sampling */
+    static std::atomic<std::atomic<uint64_t>*>& storage() {
+        static std::atomic<std::atomic<uint64_t>*> samples{nullptr};
+        return samples;
+    }
+
+    /** the number of positions counted */
+    static std::atomic<size_t>& capacity() {
+        static std::atomic<size_t> count{0};
+        return count;
+    }
+
+    /** count a sample of the position of the interrupted thread */
+    static void handle(int /* signal */) {
+        std::atomic<uint64_t>* samples = storage().load(std::memory_order_relaxed);
+        uint32_t position = currentPosition();
+        if (samples != nullptr && position < capacity().load(std::memory_order_relaxed)) {
+            samples[position].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /** the labels of the rules */
+    std::vector<std::string> labels;
+
+    /** the samples of each position */
+    std::unique_ptr<std::atomic<uint64_t>[]> samples;
+
+    /** the signal action replaced while sampling */
+    struct sigaction previousAction {};
+
+    bool running = false;
+};
+
+}  // end of namespace souffle
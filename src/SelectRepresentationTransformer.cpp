@@ -0,0 +1,171 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SelectRepresentationTransformer.cpp
+ *
+ * Define classes and functionality related to the selection of relation
+ * representations from the index accesses and memory of a profile.
+ *
+ ***********************************************************************/
+
+#include "AstClause.h"
+#include "AstIO.h"
+#include "AstProfileUse.h"
+#include "AstProgram.h"
+#include "AstRelation.h"
+#include "AstRelationIdentifier.h"
+#include "AstTransforms.h"
+#include "AstTranslationUnit.h"
+#include "DebugReport.h"
+#include "Global.h"
+#include "RamTypes.h"
+#include "RelationRepresentation.h"
+#include "Util.h"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace souffle {
+
+namespace {
+
+/** the fraction of the possible tuples above which a relation is dense */
+constexpr double denseFraction = 0.05;
+
+/** the fraction of the possible tuples below which a relation is sparse */
+constexpr double sparseFraction = 0.001;
+
+/** the bytes of the indexes of an input above which it is kept in memory-mapped files */
+constexpr size_t mappedBytes = size_t(1) << 32;
+
+/** Whether a relation is loaded and defined by facts only, such that it is never written after its load */
+bool isLoadedOnly(const AstRelation& rel) {
+    if (rel.getLoads().empty()) {
+        return false;
+    }
+    for (const AstClause* clause : rel.getClauses()) {
+        if (!clause->isFact()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Estimates the fraction of the tuples over the observed values of each
+ * column a relation holds, or a negative number if the distinct values of
+ * some column are not in the profile.
+ */
+double getDensity(const AstRelation& rel, AstProfileUse& profileUse) {
+    const AstRelationIdentifier& name = rel.getName();
+    double possible = 1;
+    for (size_t i = 0; i < rel.getArity(); i++) {
+        if (!profileUse.hasDistinctValues(name, i)) {
+            return -1;
+        }
+        possible *= std::max<size_t>(profileUse.getDistinctValues(name, i), 1);
+    }
+    return profileUse.getRelationSize(name) / possible;
+}
+
+}  // namespace
+
+/**
+ * Selects a brie for dense relations whose range scans deliver more tuples
+ * than they are probed for single tuples, and a b-tree for sparse relations
+ * mostly probed for single tuples. A brie is also considered sparse if it
+ * occupies more memory than b-trees of the same indexes would. Inputs whose
+ * indexes occupy more than mappedBytes are kept in memory-mapped files.
+ */
+bool SelectRepresentationTransformer::transform(AstTranslationUnit& translationUnit) {
+    AstProgram& program = *translationUnit.getProgram();
+    auto* profileUse = translationUnit.getAnalysis<AstProfileUse>();
+
+    bool changed = false;
+    std::stringstream report;
+    for (AstRelation* rel : program.getRelations()) {
+        const AstRelationIdentifier& name = rel->getName();
+        RelationRepresentation current = rel->getRepresentation();
+        if (rel->getArity() == 0 || !profileUse->hasIndexStatistics(name) ||
+                !(current == RelationRepresentation::DEFAULT || current == RelationRepresentation::BTREE ||
+                        current == RelationRepresentation::BRIE)) {
+            continue;
+        }
+        size_t size = profileUse->getRelationSize(name);
+        size_t probes = profileUse->getIndexStatistic(name, "probes");
+        size_t scans = profileUse->getIndexStatistic(name, "scans");
+        size_t tuples = profileUse->getIndexStatistic(name, "tuples");
+        double density = getDensity(*rel, *profileUse);
+
+        // the bytes of each tuple in each index, a b-tree filling three quarters of its nodes
+        size_t tupleBytes = rel->getArity() * sizeof(RamDomain);
+        bool isLargeBrie = false;
+        if (current == RelationRepresentation::BRIE && profileUse->hasMemoryUsage(name) && size > 0) {
+            size_t btreeBytes = size * profileUse->getIndexCount(name) * tupleBytes * 4 / 3;
+            isLargeBrie = profileUse->getMemoryUsage(name) > btreeBytes;
+        }
+
+        bool isRangeHeavy = scans > 0 && tuples > 2 * probes;
+        bool isPointHeavy = probes > 2 * scans;
+        bool isDense = density >= denseFraction;
+        bool isSparse = (density >= 0 && density <= sparseFraction) || isLargeBrie;
+
+        // the bytes of the indexes, as measured or as b-trees of them would occupy
+        size_t indexBytes = profileUse->hasMemoryUsage(name)
+                                    ? profileUse->getMemoryUsage(name)
+                                    : size * profileUse->getIndexCount(name) * tupleBytes * 4 / 3;
+        bool isMapped = indexBytes > mappedBytes && isLoadedOnly(*rel);
+
+        RelationRepresentation selected = current;
+        if (isMapped) {
+            selected = RelationRepresentation::MMAP;
+        } else if (isDense && isRangeHeavy) {
+            selected = RelationRepresentation::BRIE;
+        } else if (isSparse && isPointHeavy) {
+            selected = RelationRepresentation::BTREE;
+        }
+
+        // a default representation of a small arity is a b-tree already
+        bool isBtree = current == RelationRepresentation::BTREE ||
+                       (current == RelationRepresentation::DEFAULT && rel->getArity() <= 6);
+        if (selected == current || (selected == RelationRepresentation::BTREE && isBtree)) {
+            continue;
+        }
+        rel->setRepresentation(selected);
+        changed = true;
+
+        report << name << ": " << selected << " instead of "
+               << (current == RelationRepresentation::DEFAULT ? std::string("default") : toString(current))
+               << " (tuples " << size << ", density ";
+        if (density < 0) {
+            report << "unknown";
+        } else {
+            report << density;
+        }
+        report << ", probes " << probes << ", scans " << scans << ", scanned tuples " << tuples;
+        if (profileUse->hasMemoryUsage(name)) {
+            report << ", bytes " << profileUse->getMemoryUsage(name);
+        }
+        report << ")\n";
+    }
+
+    if (Global::config().has("verbose")) {
+        std::cout << report.str();
+    }
+    if (DebugReport::isSelected("representation-selection")) {
+        translationUnit.getDebugReport().addSection(DebugReporter::getCodeSection(
+                "representation-selection", "Representation Selection", report.str()));
+    }
+    return changed;
+}
+
+}  // end of namespace souffle
@@ -0,0 +1,329 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SemiJoinReductionTransformer.cpp
+ *
+ * Define classes and functionality related to the reduction of large
+ * relations joined by a rule to the tuples agreeing with a small relation
+ * of the same rule.
+ *
+ ***********************************************************************/
+
+#include "AstArgument.h"
+#include "AstAttribute.h"
+#include "AstClause.h"
+#include "AstIOTypeAnalysis.h"
+#include "AstLiteral.h"
+#include "AstProfileUse.h"
+#include "AstProgram.h"
+#include "AstRelation.h"
+#include "AstRelationIdentifier.h"
+#include "AstTransforms.h"
+#include "AstTranslationUnit.h"
+#include "AstVisitor.h"
+#include "PrecedenceGraph.h"
+#include "Util.h"
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace {
+
+/** The number of facts below which a relation consisting of facts only is considered small */
+constexpr size_t SMALL_FACTS = 1000;
+
+/** The factor by which a reduced relation has to shrink for the reduction to pay off */
+constexpr double MIN_REDUCTION = 0.5;
+
+/** The number of tuples below which scanning a relation is cheap anyway */
+constexpr double MIN_PROFILED_SIZE = 1000;
+
+/**
+ * Estimates the number of tuples of a relation: its profiled size if there is a
+ * profile, the number of its facts if it consists of facts only, and -1 otherwise.
+ */
+double estimateSize(const AstProgram& program, const IOType& ioTypes, const AstRelationIdentifier& name,
+        AstProfileUse& profileUse) {
+    if (profileUse.hasRelationSize(name)) {
+        return profileUse.getRelationSize(name);
+    }
+    const AstRelation* rel = program.getRelation(name);
+    if (rel == nullptr || ioTypes.isInput(rel)) {
+        return -1;
+    }
+    for (const AstClause* clause : rel->getClauses()) {
+        if (!clause->isFact()) {
+            return -1;
+        }
+    }
+    return rel->getClauses().size();
+}
+
+/** Whether all arguments of an atom are variables, unnamed variables or constants */
+bool hasPlainArguments(const AstAtom& atom) {
+    for (const AstArgument* arg : atom.getArguments()) {
+        if (dynamic_cast<const AstVariable*>(arg) == nullptr &&
+                dynamic_cast<const AstUnnamedVariable*>(arg) == nullptr &&
+                dynamic_cast<const AstConstant*>(arg) == nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** The names of the variables of an atom */
+std::set<std::string> getVariables(const AstAtom& atom) {
+    std::set<std::string> res;
+    for (const AstArgument* arg : atom.getArguments()) {
+        if (const auto* var = dynamic_cast<const AstVariable*>(arg)) {
+            res.insert(var->getName());
+        }
+    }
+    return res;
+}
+
+/**
+ * Estimates whether reducing a large atom to the tuples agreeing with a small
+ * one pays off. The reduction scans the large relation once and searches the
+ * small one for each tuple; it pays off if the reduced relation is estimated to
+ * hold at most half of the tuples, such that the join of the rule with the other
+ * large atoms enumerates at most half of the combinations. The reduction is
+ * estimated by the most selective shared column, as the share of the distinct
+ * values of the large relation occurring in the small one, if profiled, or by
+ * the ratio of the sizes otherwise. Without a profile, only small relations
+ * consisting of facts reduce relations whose size is unknown.
+ */
+bool isProfitable(const AstProgram& program, const IOType& ioTypes, const AstAtom& large,
+        const AstAtom& small, AstProfileUse& profileUse) {
+    const AstRelationIdentifier& largeName = large.getName();
+    const AstRelationIdentifier& smallName = small.getName();
+    double largeSize = estimateSize(program, ioTypes, largeName, profileUse);
+    double smallSize = estimateSize(program, ioTypes, smallName, profileUse);
+    if (smallSize < 0) {
+        return false;
+    }
+    if (largeSize < 0) {
+        return !profileUse.hasRelationSize(smallName) && smallSize <= SMALL_FACTS;
+    }
+    if (largeSize < MIN_PROFILED_SIZE) {
+        return false;
+    }
+
+    double reduction = smallSize / largeSize;
+    std::vector<AstArgument*> largeArgs = large.getArguments();
+    std::vector<AstArgument*> smallArgs = small.getArguments();
+    for (size_t i = 0; i < largeArgs.size(); i++) {
+        for (size_t j = 0; j < smallArgs.size(); j++) {
+            const auto* largeVar = dynamic_cast<const AstVariable*>(largeArgs[i]);
+            const auto* smallVar = dynamic_cast<const AstVariable*>(smallArgs[j]);
+            if (largeVar == nullptr || smallVar == nullptr || largeVar->getName() != smallVar->getName() ||
+                    !profileUse.hasDistinctValues(largeName, i) ||
+                    !profileUse.hasDistinctValues(smallName, j)) {
+                continue;
+            }
+            double distinct = std::max<double>(profileUse.getDistinctValues(largeName, i), 1.0);
+            reduction = std::min(reduction, profileUse.getDistinctValues(smallName, j) / distinct);
+        }
+    }
+    return reduction <= MIN_REDUCTION;
+}
+
+/**
+ * Finds the smallest atom of a rule sharing a variable with the given atom
+ * that is profitable to reduce it by, if any.
+ */
+const AstAtom* getReducer(const AstProgram& program, const IOType& ioTypes,
+        const std::vector<AstAtom*>& atoms, const AstAtom& large, AstProfileUse& profileUse) {
+    const std::set<std::string> largeVars = getVariables(large);
+    const AstAtom* res = nullptr;
+    double resSize = 0;
+    for (const AstAtom* atom : atoms) {
+        if (atom == &large || atom->getName() == large.getName() || !hasPlainArguments(*atom)) {
+            continue;
+        }
+        std::set<std::string> vars = getVariables(*atom);
+        if (std::none_of(vars.begin(), vars.end(), [&](const std::string& var) {
+                return contains(largeVars, var);
+            })) {
+            continue;
+        }
+        double size = estimateSize(program, ioTypes, atom->getName(), profileUse);
+        if (size >= 0 && (res == nullptr || size < resSize) &&
+                isProfitable(program, ioTypes, large, *atom, profileUse)) {
+            res = atom;
+            resSize = size;
+        }
+    }
+    return res;
+}
+
+}  // namespace
+
+bool SemiJoinReductionTransformer::transform(AstTranslationUnit& translationUnit) {
+    AstProgram& program = *translationUnit.getProgram();
+    auto* sccGraph = translationUnit.getAnalysis<SCCGraph>();
+    auto* profileUse = translationUnit.getAnalysis<AstProfileUse>();
+    auto* ioTypes = translationUnit.getAnalysis<IOType>();
+
+    // the reduced relations by the canonical form of their rules, shared by all rules reducing alike
+    std::map<std::string, std::string> reductions;
+    int counter = 0;
+
+    bool changed = false;
+    std::vector<const AstClause*> clauses;
+    for (const AstRelation* rel : program.getRelations()) {
+        for (const AstClause* clause : rel->getClauses()) {
+            clauses.push_back(clause);
+        }
+    }
+    for (const AstClause* clause : clauses) {
+        // reductions pay off for joins of at least two large atoms besides the small one
+        std::vector<AstAtom*> atoms = clause->getAtoms();
+        if (atoms.size() < 3 || clause->getExecutionPlan() != nullptr) {
+            continue;
+        }
+        const AstRelation* head = program.getRelation(clause->getHead()->getName());
+        if (head == nullptr) {
+            continue;
+        }
+
+        // only relations of earlier strata are complete when the reduced copies are computed
+        bool complete = true;
+        for (const AstAtom* atom : atoms) {
+            const AstRelation* rel = program.getRelation(atom->getName());
+            complete = complete && rel != nullptr && sccGraph->getSCC(rel) != sccGraph->getSCC(head);
+        }
+        if (!complete) {
+            continue;
+        }
+
+        std::map<const AstAtom*, std::string> reduced;
+        for (const AstAtom* large : atoms) {
+            if (!hasPlainArguments(*large) || getVariables(*large).empty()) {
+                continue;
+            }
+            const AstAtom* small = getReducer(program, *ioTypes, atoms, *large, *profileUse);
+            if (small == nullptr) {
+                continue;
+            }
+
+            // -- build the rule of the reduced relation: large(...) semi-joined with small(...) --
+
+            // the columns of the reduced relation are the distinct variables of the large atom
+            const AstRelation* largeRel = program.getRelation(large->getName());
+            std::map<std::string, std::string> renaming;
+            std::vector<AstTypeIdentifier> attributeTypes;
+            std::unique_ptr<AstAtom> largeAtom(large->clone());
+            for (size_t i = 0; i < largeAtom->getArity(); i++) {
+                const auto* var = dynamic_cast<const AstVariable*>(largeAtom->getArgument(i));
+                if (var == nullptr) {
+                    continue;
+                }
+                auto pos = renaming.find(var->getName());
+                if (pos == renaming.end()) {
+                    pos = renaming.insert(std::make_pair(var->getName(), "x" + toString(renaming.size())))
+                                  .first;
+                    attributeTypes.push_back(largeRel->getAttribute(i)->getTypeName());
+                }
+                largeAtom->setArgument(i, std::make_unique<AstVariable>(pos->second));
+            }
+
+            // variables of the small atom not shared with the large one only matter if repeated
+            std::map<std::string, size_t> appearances;
+            for (const AstArgument* arg : small->getArguments()) {
+                if (const auto* var = dynamic_cast<const AstVariable*>(arg)) {
+                    appearances[var->getName()]++;
+                }
+            }
+            std::unique_ptr<AstAtom> smallAtom(small->clone());
+            for (size_t i = 0; i < smallAtom->getArity(); i++) {
+                const auto* var = dynamic_cast<const AstVariable*>(smallAtom->getArgument(i));
+                if (var == nullptr) {
+                    continue;
+                }
+                auto pos = renaming.find(var->getName());
+                if (pos != renaming.end()) {
+                    smallAtom->setArgument(i, std::make_unique<AstVariable>(pos->second));
+                } else if (appearances[var->getName()] > 1) {
+                    smallAtom->setArgument(i, std::make_unique<AstVariable>("y" + var->getName()));
+                } else {
+                    smallAtom->setArgument(i, std::make_unique<AstUnnamedVariable>());
+                }
+            }
+
+            // rules reducing the same relation by the same small atom share the reduced relation
+            std::stringstream key;
+            key << *largeAtom << "," << *smallAtom;
+            auto pos = reductions.find(key.str());
+            if (pos == reductions.end()) {
+                std::string relName = "+semijoin" + toString(counter++);
+                while (program.getRelation(relName) != nullptr) {
+                    relName = "+semijoin" + toString(counter++);
+                }
+
+                auto* rel = new AstRelation();
+                rel->setName(relName);
+                rel->setSrcLoc(clause->getSrcLoc());
+                auto* reduction = new AstClause();
+                reduction->setSrcLoc(clause->getSrcLoc());
+                auto* reductionHead = new AstAtom(relName);
+                for (size_t i = 0; i < renaming.size(); i++) {
+                    std::string var = "x" + toString(i);
+                    rel->addAttribute(std::make_unique<AstAttribute>(var, attributeTypes[i]));
+                    reductionHead->addArgument(std::make_unique<AstVariable>(var));
+                }
+                reduction->setHead(std::unique_ptr<AstAtom>(reductionHead));
+                reduction->addToBody(std::move(largeAtom));
+                reduction->addToBody(std::move(smallAtom));
+                rel->addClause(std::unique_ptr<AstClause>(reduction));
+                program.appendRelation(std::unique_ptr<AstRelation>(rel));
+                pos = reductions.insert(std::make_pair(key.str(), relName)).first;
+            }
+            reduced[large] = pos->second;
+        }
+        if (reduced.empty()) {
+            continue;
+        }
+        changed = true;
+
+        // -- replace the large atoms of the rule by their reduced relations --
+
+        std::unique_ptr<AstClause> newClause(clause->cloneHead());
+        for (const AstLiteral* lit : clause->getBodyLiterals()) {
+            auto pos = reduced.find(dynamic_cast<const AstAtom*>(lit));
+            if (pos == reduced.end()) {
+                newClause->addToBody(std::unique_ptr<AstLiteral>(lit->clone()));
+                continue;
+            }
+            auto* reducedAtom = new AstAtom(pos->second);
+            std::set<std::string> seen;
+            for (const AstArgument* arg : pos->first->getArguments()) {
+                const auto* var = dynamic_cast<const AstVariable*>(arg);
+                if (var != nullptr && seen.insert(var->getName()).second) {
+                    reducedAtom->addArgument(std::make_unique<AstVariable>(var->getName()));
+                }
+            }
+            newClause->addToBody(std::unique_ptr<AstLiteral>(reducedAtom));
+        }
+        program.removeClause(clause);
+        program.appendClause(std::move(newClause));
+    }
+
+    return changed;
+}
+
+}  // end of namespace souffle
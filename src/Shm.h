@@ -0,0 +1,137 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Shm.h
+ *
+ * Concurrent evaluation of the strata of a program
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace souffle {
+
+namespace shm {
+
+/**
+ * Evaluate strata on a pool of threads sharing the relations of the program, where a
+ * stratum is started once all of its predecessors finished.
+ *
+ * Predecessors of a stratum must have a smaller index, which the topological order of
+ * the strata guarantees. Among the ready strata the one of the smallest index is started
+ * first, such that a single job evaluates the strata in their sequential order. Each
+ * stratum started is given an equal share of the jobs among the running and the ready
+ * strata as the threads of its parallel loops. A number of jobs of zero stands for the
+ * number of hardware threads.
+ *
+ * An exception thrown by the evaluation of a stratum stops further strata from being
+ * started and is rethrown once the running strata finished.
+ */
+inline void runStrata(const std::vector<std::vector<int>>& predecessors, size_t jobs,
+        const std::function<void(int)>& evaluate) {
+    const size_t count = predecessors.size();
+    if (jobs == 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<std::vector<int>> successors(count);
+    std::vector<size_t> pending(count, 0);
+    for (size_t stratum = 0; stratum < count; ++stratum) {
+        for (int predecessor : std::set<int>(predecessors[stratum].begin(), predecessors[stratum].end())) {
+            if (predecessor >= 0 && (size_t)predecessor < stratum) {
+                successors[predecessor].push_back(stratum);
+                ++pending[stratum];
+            }
+        }
+    }
+    std::set<int> ready;
+    for (size_t stratum = 0; stratum < count; ++stratum) {
+        if (pending[stratum] == 0) {
+            ready.insert(stratum);
+        }
+    }
+
+    std::mutex lock;
+    std::condition_variable changed;
+    size_t running = 0;
+    size_t finished = 0;
+    std::exception_ptr error;
+
+    auto work = [&]() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            changed.wait(guard, [&]() { return !ready.empty() || finished == count || error; });
+            if (finished == count || error) {
+                return;
+            }
+            const int stratum = *ready.begin();
+            ready.erase(ready.begin());
+            ++running;
+#ifdef _OPENMP
+            const size_t threads = std::max<size_t>(1, jobs / (running + ready.size()));
+#endif
+            guard.unlock();
+
+            std::exception_ptr failure;
+            try {
+#ifdef _OPENMP
+                omp_set_num_threads(threads);
+#endif
+                evaluate(stratum);
+            } catch (...) {
+                failure = std::current_exception();
+            }
+
+            guard.lock();
+            --running;
+            ++finished;
+            if (failure && !error) {
+                error = failure;
+            }
+            for (int successor : successors[stratum]) {
+                if (--pending[successor] == 0) {
+                    ready.insert(successor);
+                }
+            }
+            changed.notify_all();
+        }
+    };
+
+    // the calling thread is one of the workers
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < std::min(jobs, count); ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // end of namespace shm
+
+}  // end of namespace souffle
@@ -0,0 +1,241 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SortedVector.h
+ *
+ * An ordered set of fixed length integer tuples kept in a sorted vector,
+ * for relations whose tuples are all inserted before any of them is read,
+ * such as the new and delta relations of fixpoint loops.
+ *
+ * Insertions append to one of a fixed number of independently locked
+ * shards, selected by the inserting thread, without detecting duplicates.
+ * The first read operation after insertions sorts the appended tuples into
+ * the vector and removes duplicates, such that each tuple is copied a few
+ * times instead of descending a tree and splitting its nodes.
+ *
+ * Multiple insert operations can be conducted concurrently on a set, as can
+ * read-only operations. However, inserts and read operations may not be
+ * conducted at the same time.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "CompiledTuple.h"
+#include "ParallelUtils.h"
+#include "RamTypes.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A set of tuples of the given arity in lexicographical order, stored in a
+ * sorted vector filled from per-thread buffers on its first read.
+ *
+ * @tparam N the arity of the stored tuples
+ */
+template <unsigned N>
+class SortedVector {
+public:
+    using entry_type = ram::Tuple<RamDomain, N>;
+    using element_type = entry_type;
+    using iterator = typename std::vector<entry_type>::const_iterator;
+    using const_iterator = iterator;
+
+private:
+    // the number of shards buffering insertions
+    enum { NUM_SHARDS = 16 };
+
+    /**
+     * A buffer of the tuples inserted by some threads since the last read.
+     */
+    struct Shard {
+        Lock lock;
+        std::vector<entry_type> entries;
+    };
+
+    // the tuples read so far, sorted and free of duplicates
+    mutable std::vector<entry_type> content;
+
+    // the tuples inserted since the last read
+    mutable std::unique_ptr<Shard[]> shards;
+
+    // whether some shard holds tuples not yet in the content
+    mutable std::atomic<bool> pending{false};
+
+    // a lock synchronizing readers sorting the buffered tuples into the content
+    mutable Lock lock;
+
+    // the shard of the current thread
+    static std::size_t getShard() {
+#ifdef _OPENMP
+        return omp_get_thread_num() % NUM_SHARDS;
+#else
+        return 0;
+#endif
+    }
+
+    // sorts the buffered tuples into the content, once for all threads reading concurrently
+    void flush() const {
+        if (!pending.load(std::memory_order_acquire)) {
+            return;
+        }
+        auto lease = lock.acquire();
+        (void)lease;
+        if (!pending.load(std::memory_order_relaxed)) {
+            return;
+        }
+        const std::size_t sorted = content.size();
+        for (std::size_t s = 0; s < NUM_SHARDS; ++s) {
+            auto& entries = shards[s].entries;
+            content.insert(content.end(), entries.begin(), entries.end());
+            entries.clear();
+        }
+        std::sort(content.begin() + sorted, content.end());
+        std::inplace_merge(content.begin(), content.begin() + sorted, content.end());
+        content.erase(std::unique(content.begin(), content.end()), content.end());
+        pending.store(false, std::memory_order_release);
+    }
+
+public:
+    SortedVector() : shards(new Shard[NUM_SHARDS]) {}
+
+    SortedVector(const SortedVector&) = delete;
+    SortedVector& operator=(const SortedVector&) = delete;
+
+    /**
+     * Adds the given tuple to this set.
+     *
+     * @return true, since duplicates are only removed by the next read
+     */
+    bool insert(const entry_type& t) {
+        Shard& shard = shards[getShard()];
+        {
+            auto lease = shard.lock.acquire();
+            (void)lease;
+            shard.entries.push_back(t);
+        }
+        if (!pending.load(std::memory_order_relaxed)) {
+            pending.store(true, std::memory_order_release);
+        }
+        return true;
+    }
+
+    /**
+     * Adds all tuples of the given set to this set, taking them over in order
+     * if this set is empty.
+     */
+    void insertAll(const SortedVector& other) {
+        if (this == &other) {
+            return;
+        }
+        other.flush();
+        if (empty()) {
+            content = other.content;
+            return;
+        }
+        Shard& shard = shards[getShard()];
+        shard.entries.insert(shard.entries.end(), other.content.begin(), other.content.end());
+        if (!other.content.empty()) {
+            pending.store(true, std::memory_order_release);
+        }
+    }
+
+    bool contains(const entry_type& t) const {
+        flush();
+        return std::binary_search(content.begin(), content.end(), t);
+    }
+
+    iterator find(const entry_type& t) const {
+        auto pos = lower_bound(t);
+        return (pos != content.end() && *pos == t) ? pos : content.end();
+    }
+
+    iterator lower_bound(const entry_type& t) const {
+        flush();
+        return std::lower_bound(content.begin(), content.end(), t);
+    }
+
+    iterator upper_bound(const entry_type& t) const {
+        flush();
+        return std::upper_bound(content.begin(), content.end(), t);
+    }
+
+    /**
+     * Counts the tuples of a range without iterating through them.
+     */
+    long countRange(const iterator& a, const iterator& b) const {
+        return b - a;
+    }
+
+    /**
+     * Partitions this set into approximately the given number of ranges of
+     * equal size.
+     */
+    std::vector<range<iterator>> partition(std::size_t num) const {
+        flush();
+        std::vector<range<iterator>> res;
+        const std::size_t step = std::max<std::size_t>(1, content.size() / std::max<std::size_t>(1, num));
+        for (std::size_t a = 0; a < content.size(); a += step) {
+            std::size_t b = std::min(a + step, content.size());
+            res.push_back(range<iterator>(content.begin() + a, content.begin() + b));
+        }
+        return res;
+    }
+
+    iterator begin() const {
+        flush();
+        return content.begin();
+    }
+
+    iterator end() const {
+        flush();
+        return content.end();
+    }
+
+    bool empty() const {
+        return content.empty() && !pending.load(std::memory_order_acquire);
+    }
+
+    std::size_t size() const {
+        flush();
+        return content.size();
+    }
+
+    /**
+     * Obtains an estimate of the number of bytes occupied by this set.
+     */
+    std::size_t getMemoryUsage() const {
+        std::size_t res = sizeof(*this) + content.capacity() * sizeof(entry_type);
+        for (std::size_t s = 0; s < NUM_SHARDS; ++s) {
+            res += sizeof(Shard) + shards[s].entries.capacity() * sizeof(entry_type);
+        }
+        return res;
+    }
+
+    /**
+     * Removes all tuples from this set, retaining the memory for the tuples
+     * inserted next.
+     */
+    void clear() {
+        content.clear();
+        for (std::size_t s = 0; s < NUM_SHARDS; ++s) {
+            shards[s].entries.clear();
+        }
+        pending.store(false, std::memory_order_relaxed);
+    }
+};
+
+}  // end namespace souffle
@@ -19,9 +19,13 @@
 #include "RamTypes.h"
 #include "SymbolTable.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <initializer_list>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -99,9 +103,38 @@ public:
     // insert a new tuple into the relation
     virtual void insert(const tuple& t) = 0;
 
+    // retract a tuple of the relation, taking effect with the next runIncremental() of programs generated
+    // with --incremental, or their first run; returns false if the tuple is not in the relation or cannot
+    // be retracted
+    virtual bool retract(const tuple& t) {
+        return false;
+    }
+
     // check whether a tuple exists in the relation
     virtual bool contains(const tuple& t) const = 0;
 
+    // insert n tuples given one after the other, each by getArity() values; symbols are given by their
+    // indices, as obtained for many of them at once by SymbolTable::lookupAll()
+    virtual void insertBatch(const RamDomain* rows, size_t n);
+
+    // a consumer of n tuples stored one after the other, each by getArity() values, valid during the call
+    using BatchVisitor = std::function<void(const RamDomain* rows, size_t n)>;
+
+    // pass all tuples of the relation to a visitor in batches of at most the given number of tuples, in
+    // the order of the iterators
+    virtual void scan(const BatchVisitor& visit, size_t batchSize = 1024) const;
+
+    // pass the tuples agreeing with a pattern of getArity() values on the columns set in a mask, bit i for
+    // column i, to a visitor as by scan(); the relations of generated programs find them by the index of
+    // the search covering most of the columns among those of the program
+    virtual void equalRange(const RamDomain* pattern, uint64_t columns, const BatchVisitor& visit,
+            size_t batchSize = 1024) const;
+
+    // a read-only copy of the tuples of the relation, unaffected by later changes of the relation; it is
+    // taken while the relation is not modified, e.g. between the runs of strata by run(stratumIndex), and
+    // may then be read by any number of threads without locks while the program carries on
+    virtual std::shared_ptr<const Relation> snapshot() const;
+
     // begin and end iterator
     virtual iterator begin() const = 0;
     virtual iterator end() const = 0;
@@ -235,6 +268,261 @@ public:
     }
 };
 
+/**
+ * A read-only copy of the tuples of a relation, as taken by Relation::snapshot().
+ * The tuples are stored one after the other in lexicographical order, such that
+ * scans pass them on without copying and searches bound on a prefix of the
+ * columns take a binary search.
+ */
+class RelationSnapshot : public Relation {
+private:
+    std::string name;
+    std::vector<std::string> attrTypes;
+    std::vector<std::string> attrNames;
+    SymbolTable& symTable;
+    size_t arity;
+
+    /** the number of tuples and their values */
+    size_t count = 0;
+    std::vector<RamDomain> rows;
+
+    class iterator_snapshot : public iterator_base {
+        const RelationSnapshot& snapshot;
+        size_t pos;
+        tuple t;
+
+    public:
+        iterator_snapshot(const RelationSnapshot& snapshot, size_t pos)
+                : iterator_base(0), snapshot(snapshot), pos(pos), t(&snapshot) {}
+        void operator++() override {
+            ++pos;
+        }
+        tuple& operator*() override {
+            t.rewind();
+            for (size_t i = 0; i < snapshot.arity; i++) {
+                t[i] = snapshot.rows[pos * snapshot.arity + i];
+            }
+            return t;
+        }
+        iterator_base* clone() const override {
+            return new iterator_snapshot(*this);
+        }
+
+    protected:
+        bool equal(const iterator_base& o) const override {
+            return pos == static_cast<const iterator_snapshot&>(o).pos;
+        }
+    };
+
+    /** Compare the first n values of the tuple at a position with the given values */
+    int compare(size_t pos, const RamDomain* values, size_t n) const {
+        const RamDomain* cur = rows.data() + pos * arity;
+        for (size_t i = 0; i < n; i++) {
+            if (cur[i] != values[i]) {
+                return cur[i] < values[i] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    /** Get the position of the first tuple whose first n values are not less (or, if upper, greater) */
+    size_t bound(const RamDomain* values, size_t n, bool upper) const {
+        size_t low = 0;
+        size_t high = count;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            int cmp = compare(mid, values, n);
+            if (cmp < 0 || (upper && cmp == 0)) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+public:
+    /** Copy the tuples of a relation, which may not be modified meanwhile */
+    explicit RelationSnapshot(const Relation& relation)
+            : name(relation.getName()), symTable(relation.getSymbolTable()), arity(relation.getArity()) {
+        for (size_t i = 0; i < arity; i++) {
+            attrTypes.push_back(relation.getAttrType(i));
+            attrNames.push_back(relation.getAttrName(i));
+        }
+        rows.reserve(relation.size() * arity);
+        relation.scan([&](const RamDomain* batch, size_t n) {
+            rows.insert(rows.end(), batch, batch + n * arity);
+            count += n;
+        });
+
+        // sort the tuples by their positions, unless they already come in lexicographical order
+        bool sorted = true;
+        for (size_t i = 1; i < count && sorted; i++) {
+            sorted = compare(i - 1, rows.data() + i * arity, arity) < 0;
+        }
+        if (!sorted) {
+            std::vector<size_t> order(count);
+            for (size_t i = 0; i < count; i++) {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(),
+                    [&](size_t a, size_t b) { return compare(a, rows.data() + b * arity, arity) < 0; });
+            std::vector<RamDomain> sortedRows(rows.size());
+            for (size_t i = 0; i < count; i++) {
+                std::copy(rows.begin() + order[i] * arity, rows.begin() + (order[i] + 1) * arity,
+                        sortedRows.begin() + i * arity);
+            }
+            rows.swap(sortedRows);
+        }
+    }
+
+    void insert(const tuple& /* t */) override {
+        assert(false && "snapshots are read-only");
+    }
+    bool contains(const tuple& t) const override {
+        std::vector<RamDomain> values(arity);
+        for (size_t i = 0; i < arity; i++) {
+            values[i] = t[i];
+        }
+        size_t pos = bound(values.data(), arity, false);
+        return pos < count && compare(pos, values.data(), arity) == 0;
+    }
+    void scan(const BatchVisitor& visit, size_t batchSize = 1024) const override {
+        batchSize = std::max<size_t>(batchSize, 1);
+        for (size_t pos = 0; pos < count; pos += batchSize) {
+            visit(rows.data() + pos * arity, std::min(batchSize, count - pos));
+        }
+    }
+    void equalRange(const RamDomain* pattern, uint64_t columns, const BatchVisitor& visit,
+            size_t batchSize = 1024) const override {
+        batchSize = std::max<size_t>(batchSize, 1);
+
+        // the tuples agreeing on the bound prefix of the columns form a range, filtered on the others
+        size_t prefix = 0;
+        while (prefix < arity && ((columns >> prefix) & 1) != 0) {
+            prefix++;
+        }
+        bool filtered = false;
+        for (size_t i = prefix; i < arity; i++) {
+            filtered = filtered || ((columns >> i) & 1) != 0;
+        }
+        size_t first = bound(pattern, prefix, false);
+        size_t last = bound(pattern, prefix, true);
+        if (!filtered) {
+            for (size_t pos = first; pos < last; pos += batchSize) {
+                visit(rows.data() + pos * arity, std::min(batchSize, last - pos));
+            }
+            return;
+        }
+        std::vector<RamDomain> batch;
+        size_t n = 0;
+        for (size_t pos = first; pos < last; pos++) {
+            const RamDomain* cur = rows.data() + pos * arity;
+            bool matches = true;
+            for (size_t i = prefix; i < arity && matches; i++) {
+                matches = ((columns >> i) & 1) == 0 || cur[i] == pattern[i];
+            }
+            if (!matches) {
+                continue;
+            }
+            batch.insert(batch.end(), cur, cur + arity);
+            if (++n == batchSize) {
+                visit(batch.data(), n);
+                batch.clear();
+                n = 0;
+            }
+        }
+        if (n > 0) {
+            visit(batch.data(), n);
+        }
+    }
+    std::shared_ptr<const Relation> snapshot() const override {
+        return std::make_shared<RelationSnapshot>(*this);
+    }
+    iterator begin() const override {
+        return iterator(new iterator_snapshot(*this, 0));
+    }
+    iterator end() const override {
+        return iterator(new iterator_snapshot(*this, count));
+    }
+    std::size_t size() const override {
+        return count;
+    }
+    std::string getName() const override {
+        return name;
+    }
+    const char* getAttrType(size_t i) const override {
+        return attrTypes[i].c_str();
+    }
+    const char* getAttrName(size_t i) const override {
+        return attrNames[i].c_str();
+    }
+    size_t getArity() const override {
+        return arity;
+    }
+    SymbolTable& getSymbolTable() const override {
+        return symTable;
+    }
+    void purge() override {
+        assert(false && "snapshots are read-only");
+    }
+};
+
+inline std::shared_ptr<const Relation> Relation::snapshot() const {
+    return std::make_shared<RelationSnapshot>(*this);
+}
+
+inline void Relation::insertBatch(const RamDomain* rows, size_t n) {
+    const size_t arity = getArity();
+    for (size_t i = 0; i < n; i++, rows += arity) {
+        tuple t(this);
+        std::copy(rows, rows + arity, t.begin());
+        insert(t);
+    }
+}
+
+inline void Relation::scan(const BatchVisitor& visit, size_t batchSize) const {
+    const size_t arity = getArity();
+    batchSize = std::max<size_t>(batchSize, 1);
+    std::vector<RamDomain> rows(std::max<size_t>(batchSize * arity, 1));
+    size_t count = 0;
+    for (const auto& cur : *this) {
+        std::copy(cur.data, cur.data + arity, rows.data() + count * arity);
+        if (++count == batchSize) {
+            visit(rows.data(), count);
+            count = 0;
+        }
+    }
+    if (count > 0) {
+        visit(rows.data(), count);
+    }
+}
+
+inline void Relation::equalRange(
+        const RamDomain* pattern, uint64_t columns, const BatchVisitor& visit, size_t batchSize) const {
+    const size_t arity = getArity();
+    batchSize = std::max<size_t>(batchSize, 1);
+    std::vector<RamDomain> rows(std::max<size_t>(batchSize * arity, 1));
+    size_t count = 0;
+    for (const auto& cur : *this) {
+        bool matches = true;
+        for (size_t i = 0; i < arity && matches; i++) {
+            matches = ((columns >> i) & 1) == 0 || cur[i] == pattern[i];
+        }
+        if (!matches) {
+            continue;
+        }
+        std::copy(cur.data, cur.data + arity, rows.data() + count * arity);
+        if (++count == batchSize) {
+            visit(rows.data(), count);
+            count = 0;
+        }
+    }
+    if (count > 0) {
+        visit(rows.data(), count);
+    }
+}
+
 /**
  * Abstract base class for generated Datalog programs
  */
@@ -269,6 +557,23 @@ public:
     // execute program, without any loads or stores
     virtual void run(size_t stratumIndex = -1) {}
 
+    // update the relations computed by a previous run with the tuples inserted and retracted since, only
+    // evaluating the strata affected by them (programs generated with --incremental, running from
+    // scratch otherwise). Strata negating or aggregating relations that changed are recomputed, and the
+    // tuples derived from retracted ones removed unless rederived, either losing the tuples inserted
+    // into derived relations.
+    virtual void runIncremental() {
+        run();
+    }
+
+    // clear all relations, such that the program runs again as a new instance would; the symbols of the
+    // symbol table are kept, as are the nodes of the relations of generated programs for their next tuples
+    virtual void reset() {
+        for (Relation* rel : allRelations) {
+            rel->purge();
+        }
+    }
+
     // execute program, loading inputs and storing outputs as requires
     virtual void runAll(std::string inputDirectory = ".", std::string outputDirectory = ".",
             size_t stratumIndex = -1) = 0;
@@ -285,6 +590,23 @@ public:
     // dump output relations (for debug purposes)
     virtual void dumpOutputs(std::ostream& out = std::cout) = 0;
 
+    // save the state of the evaluation into a directory after each stratum, first restoring the state
+    // saved there if resuming; the strata the restored state completed are skipped by the runs that
+    // follow. Returns false if the program was compiled without --checkpoints.
+    virtual bool setCheckpoint(const std::string& directory, bool resume = false) {
+        return false;
+    }
+
+    // save all relations, the symbols and the records into a directory
+    virtual bool saveCheckpoint(const std::string& directory) {
+        return false;
+    }
+
+    // restore the relations, symbols and records saved into a directory, returning false if there are none
+    virtual bool restoreCheckpoint(const std::string& directory) {
+        return false;
+    }
+
     // get Relation
     Relation* getRelation(const std::string& name) const {
         auto it = relationMap.find(name);
@@ -313,6 +635,15 @@ public:
 
     virtual void executeSubroutine(std::string name, const std::vector<RamDomain>& args,
             std::vector<RamDomain>& ret, std::vector<bool>& retErr) {}
+
+    /** Resolve the name of a subroutine to an id for runSubroutine(), or -1 if it takes no ids */
+    virtual int getSubroutineId(const std::string& name) const {
+        return -1;
+    }
+
+    /** Execute a subroutine by an id from getSubroutineId(), sparing the lookup of its name */
+    virtual void runSubroutine(size_t id, const std::vector<RamDomain>& args, std::vector<RamDomain>& ret,
+            std::vector<bool>& retErr) {}
     virtual SymbolTable& getSymbolTable() = 0;
 
     // remove all the facts from the output relations
@@ -20,10 +20,28 @@
 #include <cstdio>
 #include <fstream>
 #include <limits>
+#include <mutex>
+#include <set>
 #include <sstream>
 
 namespace souffle {
 
+const std::string& SrcLocation::FileName::intern(const std::string& name) {
+    if (name.empty()) {
+        return none();
+    }
+    // the scanner names each token by the file it is in
+    static thread_local const std::string* last = nullptr;
+    if (last != nullptr && *last == name) {
+        return *last;
+    }
+    static std::mutex lock;
+    static std::set<std::string> names;
+    std::lock_guard<std::mutex> guard(lock);
+    last = &*names.insert(name).first;
+    return *last;
+}
+
 std::string SrcLocation::extloc() const {
     std::ifstream in(filename);
     std::stringstream s;
@@ -24,6 +24,65 @@ namespace souffle {
 /** A class describing a range in an input file */
 class SrcLocation {
 public:
+    /**
+     * The name of an input file, shared by all locations in the file.
+     *
+     * Every AST node holds a location, such that names are interned rather
+     * than copied with each node and each of its clones.
+     */
+    class FileName {
+    public:
+        FileName() : name(&none()) {}
+
+        FileName(const std::string& name) : name(&intern(name)) {}
+
+        FileName(const char* name) : FileName(std::string(name)) {}
+
+        const std::string& str() const {
+            return *name;
+        }
+
+        operator const std::string&() const {
+            return *name;
+        }
+
+        bool empty() const {
+            return name->empty();
+        }
+
+        bool operator==(const FileName& other) const {
+            return name == other.name;
+        }
+
+        bool operator!=(const FileName& other) const {
+            return name != other.name;
+        }
+
+        bool operator<(const FileName& other) const {
+            return name != other.name && *name < *other.name;
+        }
+
+        bool operator>(const FileName& other) const {
+            return other < *this;
+        }
+
+        friend std::ostream& operator<<(std::ostream& out, const FileName& name) {
+            return out << *name.name;
+        }
+
+    private:
+        /** Returns the unique copy of the given name */
+        static const std::string& intern(const std::string& name);
+
+        /** Returns the empty name */
+        static const std::string& none() {
+            static const std::string name;
+            return name;
+        }
+
+        const std::string* name;
+    };
+
     /** A class locating a single point in an input file */
     struct Point {
         /** The line in the source file */
@@ -53,7 +112,7 @@ public:
     };
 
     /** The file referred to */
-    std::string filename;
+    FileName filename;
 
     /** The start location */
     Point start = {};
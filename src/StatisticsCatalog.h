@@ -0,0 +1,458 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file StatisticsCatalog.h
+ *
+ * A catalog of the statistics of the relations of a program (--statistics),
+ * collected when the program runs and kept in a file for the planning of
+ * later compilations of the program.
+ *
+ * The statistics of a relation are its size, the number of distinct values
+ * and the most frequent values of each column, and the number of distinct
+ * prefixes of each index. They are collected once a relation is loaded, at
+ * the end of the stratum computing it and before it is dropped, by a single
+ * parallel scan of the relation: distinct values are estimated by HyperLogLog
+ * sketches of all tuples, the most frequent values by the summary of Misra and
+ * Gries of a sample of the tuples. The file holds the statistics of all
+ * relations seen by any run, each relation by its last collection.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamTypes.h"
+#include "SymbolTable.h"
+#include "json11.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace souffle {
+
+/**
+ * A HyperLogLog sketch estimating the number of distinct hashes added to it, within about 2% by
+ * 4096 registers of a byte, each holding the longest run of leading zeros among the hashes it selects.
+ */
+class HyperLogLog {
+public:
+    HyperLogLog() : registers(SIZE, 0) {}
+
+    void add(uint64_t hash) {
+        const size_t reg = hash >> (64 - BITS);
+        const uint64_t rest = hash << BITS;
+        const uint8_t rank = (rest == 0) ? 64 - BITS + 1 : __builtin_clzll(rest) + 1;
+        if (rank > registers[reg]) {
+            registers[reg] = rank;
+        }
+    }
+
+    /** Add the hashes of another sketch */
+    void merge(const HyperLogLog& other) {
+        for (size_t i = 0; i < registers.size(); ++i) {
+            registers[i] = std::max(registers[i], other.registers[i]);
+        }
+    }
+
+    double estimate() const {
+        double sum = 0;
+        size_t empty = 0;
+        for (uint8_t rank : registers) {
+            sum += std::ldexp(1.0, -rank);
+            empty += (rank == 0) ? 1 : 0;
+        }
+        const double m = SIZE;
+        double res = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+        // small numbers are estimated by the registers left empty
+        if (res <= 2.5 * m && empty > 0) {
+            res = m * std::log(m / empty);
+        }
+        return res;
+    }
+
+private:
+    enum { BITS = 12, SIZE = 1 << BITS };
+
+    std::vector<uint8_t> registers;
+};
+
+/**
+ * The most frequent values of a stream by the summary of Misra and Gries, whose counters undercount
+ * the occurrences of a value by at most a share of 1/(capacity+1) of the stream. Each value occurring
+ * more often than that is kept.
+ */
+class HeavyHitters {
+public:
+    explicit HeavyHitters(size_t capacity = 32) : capacity(capacity) {}
+
+    void add(RamDomain value) {
+        for (auto& cur : counters) {
+            if (cur.first == value) {
+                cur.second++;
+                return;
+            }
+        }
+        if (counters.size() < capacity) {
+            counters.emplace_back(value, 1);
+            return;
+        }
+        // a value without a counter cancels one occurrence of each counted value
+        for (auto& cur : counters) {
+            cur.second--;
+        }
+        evictEmpty();
+    }
+
+    /** Add the counters of another summary, keeping those above the largest one exceeding the capacity */
+    void merge(const HeavyHitters& other) {
+        for (const auto& cur : other.counters) {
+            auto pos = std::find_if(counters.begin(), counters.end(),
+                    [&](const std::pair<RamDomain, size_t>& counter) { return counter.first == cur.first; });
+            if (pos != counters.end()) {
+                pos->second += cur.second;
+            } else {
+                counters.push_back(cur);
+            }
+        }
+        if (counters.size() > capacity) {
+            std::sort(counters.begin(), counters.end(),
+                    [](const std::pair<RamDomain, size_t>& a, const std::pair<RamDomain, size_t>& b) {
+                        return a.second > b.second;
+                    });
+            const size_t cut = counters[capacity].second;
+            counters.resize(capacity);
+            for (auto& cur : counters) {
+                cur.second -= cut;
+            }
+            evictEmpty();
+        }
+    }
+
+    /** Get the counted values with their counts */
+    const std::vector<std::pair<RamDomain, size_t>>& getCounters() const {
+        return counters;
+    }
+
+private:
+    void evictEmpty() {
+        counters.erase(std::remove_if(counters.begin(), counters.end(),
+                               [](const std::pair<RamDomain, size_t>& cur) { return cur.second == 0; }),
+                counters.end());
+    }
+
+    size_t capacity;
+    std::vector<std::pair<RamDomain, size_t>> counters;
+};
+
+/**
+ * The statistics of a relation.
+ */
+struct RelationStatistics {
+    struct Column {
+        /** the estimated number of distinct values */
+        double distinct = 0;
+
+        /** the most frequent values, as symbols or numbers, with their estimated occurrences */
+        std::vector<std::pair<std::string, double>> frequent;
+    };
+
+    double size = 0;
+    std::vector<Column> columns;
+
+    /** the estimated number of distinct prefixes of the indexes, by their columns as in "0,2" */
+    std::map<std::string, double> prefixes;
+
+    /** Get the key of a set of columns */
+    static std::string getKey(std::vector<int> columns) {
+        std::sort(columns.begin(), columns.end());
+        std::stringstream res;
+        for (size_t i = 0; i < columns.size(); ++i) {
+            res << (i > 0 ? "," : "") << columns[i];
+        }
+        return res.str();
+    }
+
+    /**
+     * Estimate the number of tuples agreeing with a tuple on the given columns, from the distinct
+     * prefixes of an index on the columns, or from the distinct values of the columns assumed to be
+     * independent of each other.
+     */
+    double getFanOut(const std::vector<int>& cols) const {
+        double distinct = 1;
+        if (cols.size() == 1 && (size_t)cols[0] < columns.size()) {
+            distinct = columns[cols[0]].distinct;
+        } else if (prefixes.find(getKey(cols)) != prefixes.end()) {
+            distinct = prefixes.at(getKey(cols));
+        } else {
+            for (int col : cols) {
+                if ((size_t)col < columns.size()) {
+                    distinct *= std::max(1.0, columns[col].distinct);
+                }
+            }
+        }
+        return size / std::max(1.0, std::min(distinct, size));
+    }
+
+    /** Estimate the number of tuples holding a value, a symbol or a number, in a column */
+    double getMatches(size_t column, const std::string& value) const {
+        if (column >= columns.size()) {
+            return size;
+        }
+        const Column& col = columns[column];
+        double rest = size;
+        for (const auto& cur : col.frequent) {
+            if (cur.first == value) {
+                return cur.second;
+            }
+            rest -= cur.second;
+        }
+        // the other values share the tuples not holding a frequent value
+        return std::max(0.0, rest) / std::max(1.0, col.distinct - col.frequent.size());
+    }
+};
+
+class StatisticsCatalog {
+public:
+    /** Use the statistics of the given file, if it exists, saving the collected ones into it */
+    explicit StatisticsCatalog(std::string filename) : filename(std::move(filename)) {
+        load();
+    }
+
+    StatisticsCatalog(const StatisticsCatalog&) = delete;
+
+    /** Whether the file held statistics */
+    bool isLoaded() const {
+        return loaded;
+    }
+
+    /** Get the statistics of a relation, or nullptr if none were collected */
+    const RelationStatistics* getRelation(const std::string& name) const {
+        std::lock_guard<std::mutex> guard(lock);
+        auto pos = relations.find(name);
+        return (pos != relations.end()) ? &pos->second : nullptr;
+    }
+
+    /**
+     * Collect the statistics of a relation, unless collected before at the same size.
+     *
+     * @param name the name of the relation
+     * @param size the number of tuples of the relation
+     * @param chunks the partition of the relation, traversed in parallel
+     * @param orders the orders of the columns of the indexes of the relation
+     * @param symbolMask the columns holding symbols
+     * @param symbolTable the symbol table of the relation
+     */
+    template <typename Chunks>
+    void collect(const std::string& name, size_t size, Chunks& chunks,
+            const std::vector<std::vector<int>>& orders, const std::vector<bool>& symbolMask,
+            const SymbolTable& symbolTable) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto pos = collected.find(name);
+            if (pos != collected.end() && pos->second == size) {
+                return;
+            }
+        }
+        const size_t arity = symbolMask.size();
+
+        // the prefixes of two or more columns, single columns being counted as such and full tuples distinct
+        std::vector<std::vector<int>> prefixes;
+        std::set<std::string> keys;
+        for (const auto& order : orders) {
+            for (size_t length = 2; length < order.size(); ++length) {
+                std::vector<int> prefix(order.begin(), order.begin() + length);
+                if (keys.insert(RelationStatistics::getKey(prefix)).second) {
+                    prefixes.push_back(prefix);
+                }
+            }
+        }
+
+        // the frequent values are counted on a sample of the tuples
+        const size_t stride = std::max<size_t>(1, size / SAMPLE_SIZE);
+        Sketches merged(arity, prefixes.size());
+        const int numChunks = chunks.size();
+#pragma omp parallel
+        {
+            Sketches local(arity, prefixes.size());
+            size_t position = 0;
+#pragma omp for schedule(dynamic)
+            for (int c = 0; c < numChunks; ++c) {
+                for (const auto& cur : chunks[c]) {
+                    for (size_t i = 0; i < arity; ++i) {
+                        local.columns[i].add(mix(static_cast<uint32_t>(cur[i])));
+                    }
+                    for (size_t j = 0; j < prefixes.size(); ++j) {
+                        uint64_t hash = 0;
+                        for (int col : prefixes[j]) {
+                            hash = mix(hash ^ static_cast<uint32_t>(cur[col]));
+                        }
+                        local.prefixes[j].add(hash);
+                    }
+                    if (position++ % stride == 0) {
+                        for (size_t i = 0; i < arity; ++i) {
+                            local.frequent[i].add(cur[i]);
+                        }
+                    }
+                }
+            }
+#pragma omp critical
+            merged.merge(local);
+        }
+
+        RelationStatistics res;
+        res.size = size;
+        for (size_t i = 0; i < arity; ++i) {
+            RelationStatistics::Column column;
+            column.distinct = std::min<double>(std::round(merged.columns[i].estimate()), size);
+            for (const auto& cur : merged.frequent[i].getCounters()) {
+                const double count = double(cur.second) * stride;
+                if (count * FREQUENT_SHARE >= size) {
+                    const std::string value =
+                            symbolMask[i] ? symbolTable.resolve(cur.first) : std::to_string(cur.first);
+                    column.frequent.emplace_back(value, count);
+                }
+            }
+            std::sort(column.frequent.begin(), column.frequent.end(),
+                    [](const std::pair<std::string, double>& a, const std::pair<std::string, double>& b) {
+                        return a.second > b.second;
+                    });
+            res.columns.push_back(column);
+        }
+        for (size_t j = 0; j < prefixes.size(); ++j) {
+            res.prefixes[RelationStatistics::getKey(prefixes[j])] =
+                    std::min<double>(std::round(merged.prefixes[j].estimate()), size);
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        relations[name] = std::move(res);
+        collected[name] = size;
+    }
+
+    /** Write the statistics into the file, replacing it at once */
+    void save() const {
+        std::lock_guard<std::mutex> guard(lock);
+        json11::Json::object rels;
+        for (const auto& rel : relations) {
+            json11::Json::array columns;
+            for (const auto& column : rel.second.columns) {
+                json11::Json::array frequent;
+                for (const auto& cur : column.frequent) {
+                    frequent.push_back(json11::Json::array{cur.first, cur.second});
+                }
+                columns.push_back(
+                        json11::Json::object{{"distinct", column.distinct}, {"frequent", frequent}});
+            }
+            json11::Json::object prefixes;
+            for (const auto& cur : rel.second.prefixes) {
+                prefixes[cur.first] = cur.second;
+            }
+            rels[rel.first] = json11::Json::object{
+                    {"size", rel.second.size}, {"columns", columns}, {"prefixes", prefixes}};
+        }
+        const std::string tempName = filename + ".tmp." + std::to_string(getpid());
+        {
+            std::ofstream os(tempName);
+            os << json11::Json(json11::Json::object{{"relations", rels}}).dump() << "\n";
+            if (!os) {
+                std::cerr << "Cannot write statistics file <" << filename << ">\n";
+                std::remove(tempName.c_str());
+                return;
+            }
+        }
+        std::rename(tempName.c_str(), filename.c_str());
+    }
+
+private:
+    /** the tuples sampled for the frequent values, and the least share of tuples of a frequent value */
+    enum { SAMPLE_SIZE = 1 << 16, FREQUENT_SHARE = 100 };
+
+    /** The sketches of the columns and prefixes of a relation */
+    struct Sketches {
+        std::vector<HyperLogLog> columns;
+        std::vector<HyperLogLog> prefixes;
+        std::vector<HeavyHitters> frequent;
+
+        Sketches(size_t arity, size_t numPrefixes)
+                : columns(arity), prefixes(numPrefixes), frequent(arity) {}
+
+        void merge(const Sketches& other) {
+            for (size_t i = 0; i < columns.size(); ++i) {
+                columns[i].merge(other.columns[i]);
+                frequent[i].merge(other.frequent[i]);
+            }
+            for (size_t j = 0; j < prefixes.size(); ++j) {
+                prefixes[j].merge(other.prefixes[j]);
+            }
+        }
+    };
+
+    /** Spread the bits of a value over a hash */
+    static uint64_t mix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    void load() {
+        std::ifstream is(filename);
+        if (!is) {
+            return;
+        }
+        std::stringstream content;
+        content << is.rdbuf();
+        std::string error;
+        json11::Json json = json11::Json::parse(content.str(), error);
+        if (!error.empty()) {
+            std::cerr << "Ignoring statistics file <" << filename << ">: " << error << "\n";
+            return;
+        }
+        for (const auto& rel : json["relations"].object_items()) {
+            RelationStatistics res;
+            res.size = rel.second["size"].number_value();
+            for (const auto& cur : rel.second["columns"].array_items()) {
+                RelationStatistics::Column column;
+                column.distinct = cur["distinct"].number_value();
+                for (const auto& value : cur["frequent"].array_items()) {
+                    column.frequent.emplace_back(value[0].string_value(), value[1].number_value());
+                }
+                res.columns.push_back(column);
+            }
+            for (const auto& cur : rel.second["prefixes"].object_items()) {
+                res.prefixes[cur.first] = cur.second.number_value();
+            }
+            relations[rel.first] = std::move(res);
+        }
+        loaded = true;
+    }
+
+    std::string filename;
+    bool loaded = false;
+    std::map<std::string, RelationStatistics> relations;
+
+    /** the relations collected by this run, by their sizes when collected */
+    std::map<std::string, size_t> collected;
+
+    mutable std::mutex lock;
+};
+
+}  // end of namespace souffle
@@ -0,0 +1,461 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file StorageProvider.h
+ *
+ * The interface of custom data structures storing the tuples of relations
+ * declared with the storage qualifier, as in
+ *
+ *     .decl edge(x:number, y:number) storage(intervals)
+ *
+ * A storage provider is registered with the storage system under its name
+ * and creates the storage of each relation naming it. All back ends use the
+ * same storage: the interpreters present it as the indexes of the relation
+ * and the synthesiser wraps it into a StorageSet. A provider is registered
+ * before the relations using it are created, e.g. by a static initialiser of
+ * a library linked with a generated program or loaded by the interpreters
+ * (-l), in the way custom input and output streams are registered with the
+ * IOSystem.
+ *
+ * Inserts into a storage are serialised by the back ends; reads may be
+ * conducted concurrently with each other, but not with inserts.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "CompiledTuple.h"
+#include "ParallelUtils.h"
+#include "RamTypes.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A cursor delivering tuples of a relation storage one after the other.
+ */
+class StorageCursor {
+public:
+    virtual ~StorageCursor() = default;
+
+    /**
+     * Obtains the next tuple, valid until the next call, or nullptr once all
+     * tuples have been delivered.
+     */
+    virtual const RamDomain* next() = 0;
+
+    /**
+     * Creates a cursor delivering the same remaining tuples as this one.
+     */
+    virtual std::unique_ptr<StorageCursor> clone() const = 0;
+};
+
+/**
+ * The tuples of a relation, stored by a custom data structure. The tuples
+ * are sets of values in the natural order of the columns; the storage may
+ * deliver them in any order.
+ */
+class RelationStorage {
+public:
+    virtual ~RelationStorage() = default;
+
+    /**
+     * Adds a tuple, returning false if it is already stored.
+     */
+    virtual bool insert(const RamDomain* tuple) = 0;
+
+    /**
+     * Tests whether a tuple is stored.
+     */
+    virtual bool contains(const RamDomain* tuple) const = 0;
+
+    /**
+     * Obtains the number of stored tuples.
+     */
+    virtual std::size_t size() const = 0;
+
+    /**
+     * Removes all tuples.
+     */
+    virtual void clear() = 0;
+
+    /**
+     * Obtains a cursor over all tuples.
+     */
+    virtual std::unique_ptr<StorageCursor> scan() const = 0;
+
+    /**
+     * Obtains a cursor over the tuples t with low[i] <= t[i] <= high[i] for every
+     * column i. The search signature has a bit for each column bounded by the search,
+     * such that the bounds of the other columns are the extremes of the domain; it
+     * is one of those the storage was created for, or a narrower one.
+     */
+    virtual std::unique_ptr<StorageCursor> range(
+            SearchSignature columns, const RamDomain* low, const RamDomain* high) const = 0;
+
+    /**
+     * Obtains cursors partitioning all tuples, at most the given number, to be
+     * read by parallel workers. By default, all tuples are left to a single one.
+     */
+    virtual std::vector<std::unique_ptr<StorageCursor>> partition(std::size_t /* count */) const {
+        std::vector<std::unique_ptr<StorageCursor>> res;
+        res.push_back(scan());
+        return res;
+    }
+
+    /**
+     * Obtains an estimate of the number of bytes occupied by the storage.
+     */
+    virtual std::size_t getMemoryUsage() const {
+        return 0;
+    }
+};
+
+/**
+ * A provider of the storage of relations, registered under its name.
+ */
+class StorageProvider {
+public:
+    virtual ~StorageProvider() = default;
+
+    /**
+     * Creates the empty storage of a relation of the given arity, which is
+     * searched by the given search signatures.
+     */
+    virtual std::unique_ptr<RelationStorage> getStorage(
+            std::size_t arity, const std::vector<SearchSignature>& searches) const = 0;
+
+    virtual const std::string& getName() const = 0;
+};
+
+/**
+ * The storage of the provider "stdset", an ordered set of tuples, which
+ * serves as the reference implementation of the interface. Ranges are
+ * located by the least and greatest tuple of their bounds, as the tuples
+ * between them include all tuples of a range.
+ */
+class OrderedStorage : public RelationStorage {
+    using Tuples = std::set<std::vector<RamDomain>>;
+
+    /**
+     * A cursor over consecutive tuples of the set, skipping those outside the
+     * bounds of a range, if any.
+     */
+    class Cursor : public StorageCursor {
+    public:
+        Cursor(Tuples::const_iterator cur, Tuples::const_iterator end, std::vector<RamDomain> low = {},
+                std::vector<RamDomain> high = {})
+                : cur(cur), end(end), low(std::move(low)), high(std::move(high)) {}
+
+        const RamDomain* next() override {
+            while (cur != end) {
+                const std::vector<RamDomain>& tuple = *cur++;
+                if (covers(tuple)) {
+                    return tuple.data();
+                }
+            }
+            return nullptr;
+        }
+
+        std::unique_ptr<StorageCursor> clone() const override {
+            return std::make_unique<Cursor>(*this);
+        }
+
+    private:
+        bool covers(const std::vector<RamDomain>& tuple) const {
+            for (std::size_t i = 0; i < low.size(); ++i) {
+                if (tuple[i] < low[i] || high[i] < tuple[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        Tuples::const_iterator cur;
+        Tuples::const_iterator end;
+        std::vector<RamDomain> low;
+        std::vector<RamDomain> high;
+    };
+
+public:
+    explicit OrderedStorage(std::size_t arity) : arity(arity) {}
+
+    bool insert(const RamDomain* tuple) override {
+        return tuples.insert(std::vector<RamDomain>(tuple, tuple + arity)).second;
+    }
+
+    bool contains(const RamDomain* tuple) const override {
+        return tuples.count(std::vector<RamDomain>(tuple, tuple + arity)) != 0;
+    }
+
+    std::size_t size() const override {
+        return tuples.size();
+    }
+
+    void clear() override {
+        tuples.clear();
+    }
+
+    std::unique_ptr<StorageCursor> scan() const override {
+        return std::make_unique<Cursor>(tuples.begin(), tuples.end());
+    }
+
+    std::unique_ptr<StorageCursor> range(
+            SearchSignature /* columns */, const RamDomain* low, const RamDomain* high) const override {
+        std::vector<RamDomain> lowTuple(low, low + arity);
+        std::vector<RamDomain> highTuple(high, high + arity);
+        auto begin = tuples.lower_bound(lowTuple);
+        auto end = tuples.upper_bound(highTuple);
+        return std::make_unique<Cursor>(begin, end, std::move(lowTuple), std::move(highTuple));
+    }
+
+    std::vector<std::unique_ptr<StorageCursor>> partition(std::size_t count) const override {
+        std::vector<std::unique_ptr<StorageCursor>> res;
+        const std::size_t step = std::max<std::size_t>(1, tuples.size() / std::max<std::size_t>(1, count));
+        auto begin = tuples.begin();
+        while (begin != tuples.end()) {
+            auto end = begin;
+            for (std::size_t i = 0; i < step && end != tuples.end(); ++i) {
+                ++end;
+            }
+            res.push_back(std::make_unique<Cursor>(begin, end));
+            begin = end;
+        }
+        return res;
+    }
+
+    std::size_t getMemoryUsage() const override {
+        // each node of the set holds its links and a vector of the values of its tuple
+        const std::size_t node = 4 * sizeof(void*) + sizeof(std::vector<RamDomain>);
+        return tuples.size() * (node + arity * sizeof(RamDomain));
+    }
+
+private:
+    const std::size_t arity;
+    Tuples tuples;
+};
+
+class OrderedStorageProvider : public StorageProvider {
+public:
+    std::unique_ptr<RelationStorage> getStorage(
+            std::size_t arity, const std::vector<SearchSignature>& /* searches */) const override {
+        return std::make_unique<OrderedStorage>(arity);
+    }
+
+    const std::string& getName() const override {
+        static const std::string name = "stdset";
+        return name;
+    }
+};
+
+class StorageSystem {
+public:
+    static StorageSystem& getInstance() {
+        static StorageSystem singleton;
+        return singleton;
+    }
+
+    void registerStorageProvider(const std::shared_ptr<StorageProvider>& provider) {
+        providers[provider->getName()] = provider;
+    }
+
+    /**
+     * Return whether a provider of the given name is registered
+     */
+    bool hasProvider(const std::string& name) const {
+        return providers.count(name) != 0;
+    }
+
+    /**
+     * Return a new RelationStorage of the given provider
+     */
+    std::unique_ptr<RelationStorage> getStorage(const std::string& name, std::size_t arity,
+            const std::vector<SearchSignature>& searches) const {
+        if (providers.count(name) == 0) {
+            throw std::invalid_argument("Requested storage <" + name + "> is not supported.");
+        }
+        return providers.at(name)->getStorage(arity, searches);
+    }
+    ~StorageSystem() = default;
+
+private:
+    StorageSystem() {
+        registerStorageProvider(std::make_shared<OrderedStorageProvider>());
+    }
+    std::map<std::string, std::shared_ptr<StorageProvider>> providers;
+};
+
+/**
+ * A set of tuples of the given arity held by the storage of a registered
+ * provider, presenting the interface of the data structures of generated
+ * programs. Inserts are serialised by a lock, as storages need not support
+ * concurrent ones.
+ *
+ * @tparam N the arity of the stored tuples
+ */
+template <unsigned N>
+class StorageSet {
+public:
+    using entry_type = ram::Tuple<RamDomain, N>;
+    using element_type = entry_type;
+
+    /**
+     * An iterator over the tuples delivered by a cursor. Iterators obtained from the
+     * same one by advancing it are equal if they are advanced equally often.
+     */
+    class iterator : public std::iterator<std::forward_iterator_tag, entry_type> {
+    public:
+        iterator() = default;
+
+        explicit iterator(std::unique_ptr<StorageCursor> cursor) : cursor(std::move(cursor)) {
+            advance();
+        }
+
+        iterator(const iterator& other)
+                : cursor(other.cursor == nullptr ? nullptr : other.cursor->clone()), cur(other.cur),
+                  pos(other.pos) {}
+
+        iterator(iterator&& other) = default;
+
+        iterator& operator=(const iterator& other) {
+            cursor = (other.cursor == nullptr) ? nullptr : other.cursor->clone();
+            cur = other.cur;
+            pos = other.pos;
+            return *this;
+        }
+
+        iterator& operator=(iterator&& other) = default;
+
+        bool operator==(const iterator& other) const {
+            return (cursor == nullptr) == (other.cursor == nullptr) &&
+                   (cursor == nullptr || pos == other.pos);
+        }
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+        const entry_type& operator*() const {
+            return cur;
+        }
+
+        const entry_type* operator->() const {
+            return &cur;
+        }
+
+        iterator& operator++() {
+            advance();
+            return *this;
+        }
+
+    private:
+        void advance() {
+            const RamDomain* tuple = cursor->next();
+            if (tuple == nullptr) {
+                cursor.reset();
+                return;
+            }
+            std::copy(tuple, tuple + N, &cur[0]);
+            ++pos;
+        }
+
+        // the cursor delivering the following tuples, null at the end
+        std::unique_ptr<StorageCursor> cursor;
+
+        // the current tuple
+        entry_type cur{};
+
+        // the number of tuples delivered so far
+        std::size_t pos = 0;
+    };
+
+    StorageSet(const std::string& provider, const std::vector<SearchSignature>& searches)
+            : storage(StorageSystem::getInstance().getStorage(provider, N, searches)) {}
+
+    bool insert(const entry_type& tuple) {
+        auto lease = lock.acquire();
+        (void)lease;
+        return storage->insert(&tuple[0]);
+    }
+
+    void insertAll(const StorageSet& other) {
+        for (const auto& tuple : other) {
+            insert(tuple);
+        }
+    }
+
+    bool contains(const entry_type& tuple) const {
+        return storage->contains(&tuple[0]);
+    }
+
+    std::size_t size() const {
+        return storage->size();
+    }
+
+    bool empty() const {
+        return storage->size() == 0;
+    }
+
+    void clear() {
+        storage->clear();
+    }
+
+    iterator begin() const {
+        return iterator(storage->scan());
+    }
+
+    iterator end() const {
+        return iterator();
+    }
+
+    /**
+     * Obtains the tuples agreeing with the given one on the columns of the search.
+     */
+    range<iterator> equalRange(SearchSignature columns, const entry_type& key) const {
+        entry_type low = key;
+        entry_type high = key;
+        for (unsigned i = 0; i < N; ++i) {
+            if (!((columns >> i) & 1)) {
+                low[i] = MIN_RAM_DOMAIN;
+                high[i] = MAX_RAM_DOMAIN;
+            }
+        }
+        return range<iterator>(iterator(storage->range(columns, &low[0], &high[0])), iterator());
+    }
+
+    std::vector<range<iterator>> partition(std::size_t num) const {
+        std::vector<range<iterator>> res;
+        for (auto& cursor : storage->partition(num)) {
+            res.push_back(range<iterator>(iterator(std::move(cursor)), iterator()));
+        }
+        return res;
+    }
+
+    std::size_t getMemoryUsage() const {
+        return storage->getMemoryUsage();
+    }
+
+private:
+    std::unique_ptr<RelationStorage> storage;
+
+    // a lock serialising inserts
+    Lock lock;
+};
+
+}  // end of namespace souffle
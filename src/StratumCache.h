@@ -0,0 +1,208 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file StratumCache.h
+ *
+ * A cache of the relations computed by the strata of compiled programs
+ * (--stratum-cache), shared by the runs of a program, such that a stratum
+ * whose inputs are unchanged since a previous run restores its relations
+ * instead of evaluating its rules.
+ *
+ * The results of a stratum are addressed by a key hashing the code of the
+ * stratum, the contents of the files it loads and the keys of the strata it
+ * depends on, such that a changed input changes the keys of all strata
+ * downstream of it. Each key names a directory holding a binary relation
+ * file, see BinaryFormat.h, of each relation the stratum computes. Symbols
+ * are stored by the dictionaries of the files, such that results are
+ * restored into the symbol tables of other runs. The directory of a key is
+ * written under a temporary name and renamed once complete, such that an
+ * interrupted run leaves no partial results.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "IODirectives.h"
+#include "ReadStreamBinary.h"
+#include "SymbolTable.h"
+#include "WriteStreamBinary.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace souffle {
+
+class StratumCache {
+public:
+    /** Use a directory for the cache of the given number of strata, created once results are saved */
+    StratumCache(std::string directory, size_t numStrata)
+            : directory(std::move(directory)), keys(numStrata), pending(numStrata) {}
+
+    StratumCache(const StratumCache&) = delete;
+
+    /** Hash data by FNV-1a, continuing the hash of the data before it */
+    static uint64_t hash(const char* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull) {
+        uint64_t res = seed;
+        for (size_t i = 0; i < size; ++i) {
+            res = (res ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ull;
+        }
+        return res;
+    }
+
+    static uint64_t hash(const std::string& data, uint64_t seed = 0xcbf29ce484222325ull) {
+        return hash(data.data(), data.size(), seed);
+    }
+
+    /** The path of an input file, relative to the input directory unless absolute */
+    static std::string inputPath(const std::string& inputDirectory, const std::string& filename) {
+        if (inputDirectory.empty() || filename.empty() || filename.front() == '/') {
+            return filename;
+        }
+        return inputDirectory + "/" + filename;
+    }
+
+    /**
+     * Compute the key of a stratum and check whether its results are cached.
+     * A stratum has no key, and is evaluated, if one of the strata it depends
+     * on has none or one of its input files cannot be read.
+     *
+     * @param stratum the index of the stratum
+     * @param code the hash of the code of the stratum
+     * @param predecessors the strata the stratum depends on
+     * @param files the files the stratum loads
+     * @return whether the results of the stratum are cached
+     */
+    bool lookup(size_t stratum, uint64_t code, const std::vector<size_t>& predecessors,
+            const std::vector<std::string>& files) {
+        uint64_t key = hash(reinterpret_cast<const char*>(&code), sizeof(code));
+        for (size_t pred : predecessors) {
+            if (keys[pred].empty()) {
+                return false;
+            }
+            key = hash(keys[pred], key);
+        }
+        for (const auto& file : files) {
+            std::ifstream in(file, std::ios::binary);
+            if (!in) {
+                return false;
+            }
+            // the contents of the files are delimited by their lengths, their paths may vary between runs
+            char buffer[1 << 16];
+            uint64_t length = 0;
+            while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+                key = hash(buffer, in.gcount(), key);
+                length += in.gcount();
+            }
+            key = hash(reinterpret_cast<const char*>(&length), sizeof(length), key);
+        }
+        std::stringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << key;
+        keys[stratum] = name.str();
+        struct stat info {};
+        return stat(path(keys[stratum]).c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+    }
+
+    /** Insert the tuples of a relation cached for a stratum into a relation */
+    template <typename T>
+    void restoreRelation(size_t stratum, const std::string& name, T& relation,
+            const std::vector<bool>& symbolMask, SymbolTable& symbolTable) const {
+        ReadFileBinary(symbolMask, symbolTable, directives(path(keys[stratum]), name)).readAll(relation);
+    }
+
+    /** Save a relation computed by a stratum with a key, to be committed once all are saved */
+    template <typename T>
+    void saveRelation(size_t stratum, const std::string& name, const T& relation,
+            const std::vector<bool>& symbolMask, const SymbolTable& symbolTable) {
+        if (keys[stratum].empty()) {
+            return;
+        }
+        if (pending[stratum].empty()) {
+            createDirectory(directory);
+            pending[stratum] = path(keys[stratum] + ".tmp." + std::to_string(getpid()));
+            createDirectory(pending[stratum]);
+        }
+        const std::string file = pending[stratum] + "/" + name + ".bin";
+        WriteFileBinary(symbolMask, symbolTable, directives(pending[stratum], name)).writeAll(relation);
+        if (!std::ifstream(file).good()) {
+            throw std::runtime_error("Cannot write stratum cache file " + file);
+        }
+    }
+
+    /** Publish the relations saved for a stratum under its key, unless another run did so already */
+    void commit(size_t stratum) {
+        if (keys[stratum].empty()) {
+            return;
+        }
+        if (pending[stratum].empty()) {
+            // a stratum computing no relations is cached by an empty directory
+            createDirectory(directory);
+            createDirectory(path(keys[stratum]));
+            return;
+        }
+        if (std::rename(pending[stratum].c_str(), path(keys[stratum]).c_str()) != 0) {
+            removeDirectory(pending[stratum]);
+        }
+        pending[stratum].clear();
+    }
+
+private:
+    std::string path(const std::string& file) const {
+        return directory + "/" + file;
+    }
+
+    static void createDirectory(const std::string& name) {
+        if (mkdir(name.c_str(), 0777) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Cannot create stratum cache directory " + name);
+        }
+    }
+
+    /** Remove a directory of relation files written by this run */
+    static void removeDirectory(const std::string& name) {
+        DIR* dir = opendir(name.c_str());
+        if (dir != nullptr) {
+            while (dirent* entry = readdir(dir)) {
+                const std::string file = entry->d_name;
+                if (file != "." && file != "..") {
+                    std::remove((name + "/" + file).c_str());
+                }
+            }
+            closedir(dir);
+        }
+        rmdir(name.c_str());
+    }
+
+    static IODirectives directives(const std::string& dir, const std::string& name) {
+        std::map<std::string, std::string> directiveMap = {
+                {"IO", "binary"}, {"filename", dir + "/" + name + ".bin"}, {"name", name}};
+        return IODirectives(directiveMap);
+    }
+
+    std::string directory;
+
+    /** the keys of the strata evaluated or restored so far, empty for those without a key */
+    std::vector<std::string> keys;
+
+    /** the temporary directories of the strata whose relations are being saved */
+    std::vector<std::string> pending;
+};
+
+}  // end of namespace souffle
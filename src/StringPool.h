@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <vector>
 
 #define HASH_SIZE (1048583)
 
@@ -27,6 +28,51 @@ namespace souffle {
 
 #define SLOOKUP(s) StringPool::instance()->lookup(s)
 
+/**
+ * An append-only arena for strings. Strings are copied into large slabs and stay
+ * at their address until the arena is destroyed.
+ */
+class StringArena {
+public:
+    StringArena() = default;
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    ~StringArena() {
+        for (char* slab : slabs) {
+            free(slab);
+        }
+    }
+
+    /* copy the given string into the arena */
+    const char* copy(const char* str, size_t len) {
+        if (len + 1 > remaining) {
+            // strings larger than a slab get a slab of their own
+            size_t size = (len + 1 > SLAB_SIZE) ? len + 1 : SLAB_SIZE;
+            char* slab = static_cast<char*>(malloc(size));
+            slabs.push_back(slab);
+            if (size != SLAB_SIZE) {
+                memcpy(slab, str, len + 1);
+                return slab;
+            }
+            next = slab;
+            remaining = SLAB_SIZE;
+        }
+        char* res = next;
+        memcpy(res, str, len + 1);
+        next += len + 1;
+        remaining -= len + 1;
+        return res;
+    }
+
+private:
+    static constexpr size_t SLAB_SIZE = 1 << 20;
+
+    std::vector<char*> slabs;
+    char* next = nullptr;
+    size_t remaining = 0;
+};
+
 class StringPool {
 public:
     static StringPool* instance() {
@@ -38,36 +84,28 @@ public:
     inline const char* lookup(const char* str) {
         size_t i = hash(str);
 
-        const char* res = nullptr;
-
-        {
-            if (hashtab[i] == nullptr) {
-                char* nstr = strdup(str);
-                hashtab[i] = new hashentry(nstr);
-                res = nstr;
-            } else {
-                for (hashentry* p = hashtab[i]; p != nullptr && res == NULL; p = p->next) {
-                    if (!strcmp(p->str, str)) {
-                        res = p->str;
-                    }
-                }
-                char* nstr = strdup(str);
-                hashtab[i] = new hashentry(nstr, hashtab[i]);
-                res = nstr;
+        for (hashentry* p = hashtab[i]; p != nullptr; p = p->next) {
+            if (!strcmp(p->str, str)) {
+                return p->str;
             }
         }
 
-        return res;
+        const char* nstr = arena.copy(str, strlen(str));
+        hashtab[i] = new hashentry(nstr, hashtab[i]);
+        return nstr;
     }
 
 private:
     /* Hash table */
     struct hashentry {
-        char* str;
+        const char* str;
         hashentry* next;
-        hashentry(char* s = nullptr, struct hashentry* n = NULL) : str(s), next(n) {}
+        hashentry(const char* s = nullptr, struct hashentry* n = nullptr) : str(s), next(n) {}
     };
-    static hashentry* hashtab[HASH_SIZE];
+    hashentry* hashtab[HASH_SIZE] = {};
+
+    /* Storage of the strings */
+    StringArena arena;
 
     /* Hash function */
     inline size_t hash(const char* str) {
@@ -79,12 +117,13 @@ private:
         return hash % HASH_SIZE;
     }
 
+    StringPool() = default;
+
     ~StringPool() {
         for (size_t i = 0; i < HASH_SIZE; i++) {
             hashentry* q;
             for (hashentry* p = hashtab[i]; p != nullptr; p = q) {
                 q = p->next;
-                free(p->str);
                 delete p;
             }
         }
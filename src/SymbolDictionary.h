@@ -0,0 +1,236 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SymbolDictionary.h
+ *
+ * Read-only segments of symbols, held in static storage or in a symbol
+ * dictionary file mapped into memory.
+ *
+ * A dictionary file holds the symbols of a symbol table under their
+ * indices (--symbols-out), such that a later program starts from the same
+ * symbols under the same indices (--symbols-in) and may exchange relations
+ * whose symbols are stored as indices. The file starts with a header,
+ * followed by the length of each symbol, the displacements and slots of
+ * the perfect hash of the symbols, see SymbolSegment, and the characters
+ * of the symbols, one after the other. Every part is aligned to 8 bytes and
+ * values are stored in the byte order of the machine, which the header
+ * records, such that the file is used in place once mapped into memory.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace souffle {
+
+/**
+ * A read-only segment of symbols in static storage, such as the literals of a generated
+ * program. The symbols are found through a perfect hash: the displacement of the bucket
+ * of a symbol selects its slot, which holds its index plus one (zero marks free slots).
+ * All members are constant, hence a segment needs no initialisation at run time.
+ */
+struct SymbolSegment {
+    /** the number of symbols, indexed from zero */
+    size_t size;
+    const char* const* symbols;
+    const uint32_t* lengths;
+    size_t numBuckets;
+    const uint32_t* displacements;
+    size_t numSlots;
+    const uint32_t* slots;
+};
+
+namespace dictionary {
+
+/** The header of a symbol dictionary file */
+struct Header {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t reserved;
+    uint64_t symbols;
+    uint64_t numBuckets;
+    uint64_t numSlots;
+    uint64_t symbolBytes;
+    /** identifies the symbols of the file and their order, never zero */
+    uint64_t checksum;
+};
+
+/** the marker of the byte order of the machine writing a file */
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+/** Create the header of a file of the given content */
+inline Header makeHeader(
+        uint64_t symbols, uint64_t numBuckets, uint64_t numSlots, uint64_t symbolBytes, uint64_t checksum) {
+    Header header;
+    std::memcpy(header.magic, "SOUFFLED", sizeof(header.magic));
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.reserved = 0;
+    header.symbols = symbols;
+    header.numBuckets = numBuckets;
+    header.numSlots = numSlots;
+    header.symbolBytes = symbolBytes;
+    header.checksum = checksum;
+    return header;
+}
+
+/** Round a number of bytes up to the alignment of the parts of a file */
+inline uint64_t pad(uint64_t bytes) {
+    return (bytes + 7) & ~uint64_t(7);
+}
+
+/** The offsets of the parts of a file, derived from its header */
+struct Layout {
+    explicit Layout(const Header& header)
+            : lengths(sizeof(Header)), displacements(lengths + pad(header.symbols * sizeof(uint32_t))),
+              slots(displacements + pad(header.numBuckets * sizeof(uint32_t))),
+              symbolData(slots + pad(header.numSlots * sizeof(uint32_t))),
+              size(symbolData + pad(header.symbolBytes)) {}
+
+    /** the lengths of the symbols */
+    uint64_t lengths;
+
+    /** the displacements of the buckets of the perfect hash */
+    uint64_t displacements;
+
+    /** the slots of the perfect hash, see SymbolSegment */
+    uint64_t slots;
+
+    /** the characters of the symbols, one after the other */
+    uint64_t symbolData;
+
+    /** the size of the file */
+    uint64_t size;
+};
+
+}  // end of namespace dictionary
+
+/**
+ * A symbol dictionary file mapped into memory, presenting its symbols as a segment. Only
+ * the addresses of the symbols are computed when the file is opened; its symbols are
+ * neither copied nor hashed.
+ */
+class SymbolDictionary {
+public:
+    /** Map a dictionary file, throwing std::runtime_error if it cannot be read */
+    explicit SymbolDictionary(const std::string& fileName) : fileName(fileName) {
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) {
+            fail("cannot be opened");
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(dictionary::Header)) {
+            ::close(fd);
+            fail("is too short");
+        }
+        size = static_cast<size_t>(info.st_size);
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            fail("cannot be mapped");
+        }
+        data = static_cast<const char*>(addr);
+
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, "SOUFFLED", sizeof(header.magic)) != 0) {
+            unmapAndFail("is not a symbol dictionary");
+        }
+        if (header.byteOrder != dictionary::BYTE_ORDER_MARK) {
+            unmapAndFail("was written with a different byte order");
+        }
+        if (header.symbols > size || header.numBuckets > size || header.numSlots > size ||
+                header.symbolBytes > size || dictionary::Layout(header).size != size) {
+            unmapAndFail("is corrupt");
+        }
+        const dictionary::Layout layout(header);
+
+        // the symbols are placed one after the other, hence their addresses follow from their lengths
+        const auto* lengths = reinterpret_cast<const uint32_t*>(data + layout.lengths);
+        addresses.resize(header.symbols);
+        uint64_t offset = 0;
+        for (size_t i = 0; i < header.symbols; ++i) {
+            addresses[i] = data + layout.symbolData + offset;
+            offset += lengths[i];
+        }
+        if (offset != header.symbolBytes) {
+            unmapAndFail("is corrupt");
+        }
+        segment = SymbolSegment{header.symbols, addresses.data(), lengths, header.numBuckets,
+                reinterpret_cast<const uint32_t*>(data + layout.displacements), header.numSlots,
+                reinterpret_cast<const uint32_t*>(data + layout.slots)};
+    }
+
+    SymbolDictionary(const SymbolDictionary&) = delete;
+    SymbolDictionary& operator=(const SymbolDictionary&) = delete;
+
+    ~SymbolDictionary() {
+        munmap(const_cast<char*>(data), size);
+    }
+
+    /** The symbols of the dictionary */
+    const SymbolSegment& getSegment() const {
+        return segment;
+    }
+
+    /** Whether the symbols of the dictionary can be found through their perfect hash; a file lacks it
+     * only if no perfect hash could be built when it was written */
+    bool isHashed() const {
+        return header.numBuckets > 0 && header.numSlots > 0;
+    }
+
+    /** The number of symbols of the dictionary */
+    size_t getSize() const {
+        return header.symbols;
+    }
+
+    /** The checksum of the symbols of the dictionary and their order */
+    uint64_t getChecksum() const {
+        return header.checksum;
+    }
+
+    const std::string& getFileName() const {
+        return fileName;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& reason) const {
+        throw std::runtime_error("Symbol dictionary " + fileName + " " + reason);
+    }
+
+    [[noreturn]] void unmapAndFail(const std::string& reason) {
+        munmap(const_cast<char*>(data), size);
+        fail(reason);
+    }
+
+    std::string fileName;
+
+    /** the mapping of the file */
+    const char* data = nullptr;
+    size_t size = 0;
+
+    dictionary::Header header;
+
+    /** the address of each symbol in the mapping */
+    std::vector<const char*> addresses;
+
+    SymbolSegment segment;
+};
+
+}  // end of namespace souffle
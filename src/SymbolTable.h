@@ -18,6 +18,7 @@
 
 #include "ParallelUtils.h"
 #include "RamTypes.h"
+#include "SymbolDictionary.h"
 #include "Util.h"
 
 #ifdef USE_MPI
@@ -25,12 +26,20 @@
 #include <thread>
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <deque>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <initializer_list>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace souffle {
 
@@ -45,127 +54,277 @@ class SymbolTable {
 #ifdef USE_MPI
 
 private:
-    enum {
-        EXIT = 0,
-        INSERT_STRING = 1,
-        INSERT_VECTOR_STRING = 2,
-        LOOKUP = 3,
-        LOOKUP_EXISTING = 4,
-        PRINT = 5,
-        RESOLVE = 6,
-        SIZE = 7,
-        UNSAFE_LOOKUP = 8,
-        UNSAFE_RESOLVE = 9
-    };
+    enum { EXIT = 0, LOOKUP_VECTOR = 1, LOOKUP_EXISTING = 2, RESOLVE_VECTOR = 3, SIZE = 4 };
 
     mutable std::unordered_map<std::string, size_t> strToNumCache;
     mutable std::unordered_map<size_t, std::string> numToStrCache;
 
-    RamDomain cacheLookup(const std::string& symbol, const int tag) const {
+    /*
+     * A distributed table is sharded across all processes, no process holding or serving all symbols.
+     * The symbols the table was constructed with are common to all shards and keep their indices. Any
+     * other symbol is owned by the shard its hash is mapped to, whose indices are interleaved with those
+     * of the other shards, such that the index of a symbol encodes its owner. The symbols of other shards
+     * are cached once they were received from their owners.
+     */
+
+    /** The number of shards of a distributed table, one per process, or zero if the table is not
+     * distributed */
+    int numShards = 0;
+
+    /** The shard of this process */
+    int shardRank = 0;
+
+    /** The number of symbols common to all shards */
+    size_t common = 0;
+
+    /** The thread serving the requests of other processes to the shard of this process */
+    std::thread server;
+
+    bool distributed() const {
+        return numShards != 0;
+    }
+
+    /** Obtains the shard owning a symbol that is not common to all shards; the bits of the hash differ
+     * from those selecting the shard of the string-to-index map and the slots within it */
+    int ownerOf(const std::string& symbol) const {
+        return static_cast<int>((hash(symbol) >> 16) % static_cast<uint64_t>(numShards));
+    }
+
+    /** Obtains the shard owning the symbol of an index that is not common to all shards */
+    int ownerOf(const RamDomain index) const {
+        return static_cast<int>((static_cast<size_t>(index) - common) % numShards);
+    }
+
+    /** Converts the index of a symbol held by this process into its index in the distributed table */
+    RamDomain toGlobal(const size_t local) const {
+        if (local < common) {
+            return static_cast<RamDomain>(local);
+        }
+        return static_cast<RamDomain>(common + (local - common) * numShards + shardRank);
+    }
+
+    /** Converts the index of a symbol in the distributed table into its index in the owning process */
+    size_t toLocal(const RamDomain index) const {
+        auto pos = static_cast<size_t>(index);
+        if (pos < common) {
+            return pos;
+        }
+        return common + (pos - common) / numShards;
+    }
+
+    /** Whether the symbol of an index is held by this process */
+    bool isLocal(const RamDomain index) const {
+        return static_cast<size_t>(index) < common || ownerOf(index) == shardRank;
+    }
+
+    /** Resolves an index held by this process */
+    const std::string& resolveLocal(const RamDomain index) const {
+        size_t pos = toLocal(index);
+        if (index < 0 || pos >= numPublished.load(std::memory_order_acquire)) {
+            unknownIndex();
+        }
+        return symbolOf(pos);
+    }
+
+    /** Caches a symbol received from its owner */
+    const std::string& cache(const std::string& symbol, const RamDomain index) const {
+        strToNumCache.insert(std::pair<std::string, size_t>(symbol, index));
+        return numToStrCache.insert(std::pair<size_t, std::string>(index, symbol)).first->second;
+    }
+
+    /**
+     * Finds the indices of symbols, inserting the missing ones into their shards for LOOKUP_VECTOR and
+     * giving a negative index for LOOKUP_EXISTING. The symbols of other shards are obtained in one round
+     * trip per shard.
+     */
+    std::vector<RamDomain> lookupShards(const std::vector<std::string>& symbols, const int tag) {
+        std::vector<RamDomain> indices(symbols.size());
+        std::vector<std::vector<size_t>> misses(numShards);
+        bool remote = false;
+        for (size_t i = 0; i < symbols.size(); i++) {
+            // the symbols of other shards are not held by this process, but for the common ones
+            RamDomain local = findSymbol(symbols[i]);
+            int owner = ownerOf(symbols[i]);
+            if (local >= 0) {
+                indices[i] = toGlobal(local);
+            } else if (owner != shardRank) {
+                misses[owner].push_back(i);
+                remote = true;
+            } else if (tag == LOOKUP_VECTOR) {
+                indices[i] = toGlobal(newSymbolOfIndex(symbols[i]));
+            } else {
+                indices[i] = -1;
+            }
+        }
+        // the serving thread never takes the lock of the caches, held by a requesting thread while waiting
+        if (remote) {
+            requestIndices(symbols, misses, indices, tag);
+        }
+        return indices;
+    }
+
+    /** Obtains the indices of the symbols of other shards missing from the caches */
+    void requestIndices(const std::vector<std::string>& symbols,
+            const std::vector<std::vector<size_t>>& misses, std::vector<RamDomain>& indices,
+            const int tag) const {
+        LockSiteScope lockSite(LockSite::SYMBOL_TABLE);
         auto lease = access.acquire();
         (void)lease;  // avoid warning;
-        auto it = strToNumCache.find(symbol);
-        if (it != strToNumCache.end()) {
-            return it->second;
+        for (int owner = 0; owner < numShards; owner++) {
+            std::vector<std::string> request;
+            std::vector<size_t> positions;
+            for (size_t i : misses[owner]) {
+                auto it = strToNumCache.find(symbols[i]);
+                if (it != strToNumCache.end()) {
+                    indices[i] = static_cast<RamDomain>(it->second);
+                } else {
+                    request.push_back(symbols[i]);
+                    positions.push_back(i);
+                }
+            }
+            if (request.empty()) {
+                continue;
+            }
+            // a process has a single request outstanding, hence the serving threads never wait on each other
+            mpi::send(request, owner, tag, mpi::shardRequests());
+            auto status = mpi::probe(owner, tag, mpi::shardReplies());
+            std::vector<RamDomain> found;
+            mpi::recv(found, status, mpi::shardReplies());
+            for (size_t i = 0; i < positions.size(); i++) {
+                indices[positions[i]] = found[i];
+                if (found[i] >= 0) {
+                    cache(request[i], found[i]);
+                }
+            }
         }
-        mpi::send(symbol, 0, tag);
-        RamDomain index;
-        mpi::recv(index, 0, tag);
-        strToNumCache.insert(std::pair<std::string, size_t>(symbol, index));
-        return numToStrCache.insert(std::pair<size_t, std::string>(index, symbol)).first->first;
     }
-    const std::string& cacheResolve(const RamDomain index, const int tag) const {
+
+    /** Obtains the symbols of indices of other shards missing from the caches, in one round trip per shard */
+    void requestSymbols(const std::vector<RamDomain>& indices) const {
+        LockSiteScope lockSite(LockSite::SYMBOL_TABLE);
         auto lease = access.acquire();
         (void)lease;  // avoid warning;
-        auto it = numToStrCache.find(index);
-        if (it != numToStrCache.end()) {
-            return it->second;
+        std::vector<std::vector<RamDomain>> misses(numShards);
+        for (RamDomain index : indices) {
+            if (!isLocal(index) && numToStrCache.find(index) == numToStrCache.end()) {
+                misses[ownerOf(index)].push_back(index);
+            }
+        }
+        for (int owner = 0; owner < numShards; owner++) {
+            auto& request = misses[owner];
+            if (request.empty()) {
+                continue;
+            }
+            std::sort(request.begin(), request.end());
+            request.erase(std::unique(request.begin(), request.end()), request.end());
+            mpi::send(request, owner, RESOLVE_VECTOR, mpi::shardRequests());
+            auto status = mpi::probe(owner, RESOLVE_VECTOR, mpi::shardReplies());
+            std::vector<std::string> found;
+            mpi::recv(found, status, mpi::shardReplies());
+            for (size_t i = 0; i < request.size(); i++) {
+                cache(found[i], request[i]);
+            }
         }
-        mpi::send(index, 0, tag);
-        std::string symbol;
-        mpi::recv(symbol, 0, tag);
-        numToStrCache.insert(std::pair<size_t, std::string>(index, symbol));
-        return strToNumCache.insert(std::pair<std::string, size_t>(symbol, index)).first->first;
     }
 
-public:
-    void handleMpiMessages(const size_t count) {
-        assert(mpi::commRank() == 0);
-        auto semaphor = count;
-        while (semaphor) {
-            auto status = mpi::probe();
-            switch (status->MPI_TAG) {
+    /** Resolves an index of another shard, from the caches or by a round trip to its owner */
+    const std::string& resolveRemote(const RamDomain index) const {
+        {
+            LockSiteScope lockSite(LockSite::SYMBOL_TABLE);
+            auto lease = access.acquire();
+            (void)lease;  // avoid warning;
+            auto it = numToStrCache.find(index);
+            if (it != numToStrCache.end()) {
+                return it->second;
+            }
+        }
+        requestSymbols({index});
+        // cached strings are never removed, hence the reference stays valid
+        auto lease = access.acquire();
+        (void)lease;  // avoid warning;
+        return numToStrCache.find(index)->second;
+    }
+
+    /** Serves the requests of other processes to the shard of this process, until this process exits */
+    void serve() {
+        while (true) {
+            auto status = mpi::probe(MPI_ANY_SOURCE, MPI_ANY_TAG, mpi::shardRequests());
+            const int source = status->MPI_SOURCE;
+            const int tag = status->MPI_TAG;
+            switch (tag) {
                 case EXIT: {
-                    mpi::recv(status->MPI_SOURCE, EXIT);
-                    --semaphor;
-                    break;
-                }
-                case LOOKUP: {
-                    std::string symbol;
-                    mpi::recv(symbol, status);
-                    mpi::send(lookup(symbol), status);
-                    break;
+                    std::vector<char> none;
+                    mpi::recv(none, status, mpi::shardRequests());
+                    return;
                 }
+                case LOOKUP_VECTOR:
                 case LOOKUP_EXISTING: {
-                    std::string symbol;
-                    mpi::recv(symbol, status);
-                    mpi::send(lookupExisting(symbol), status);
-                    break;
-                }
-                case UNSAFE_LOOKUP: {
-                    std::string symbol;
-                    mpi::recv(symbol, status);
-                    mpi::send(unsafeLookup(symbol), status);
-                    break;
-                }
-                case RESOLVE: {
-                    RamDomain index;
-                    mpi::recv(index, status);
-                    mpi::send(resolve(index), status);
+                    // all requested symbols are owned by this shard
+                    std::vector<std::string> symbols;
+                    mpi::recv(symbols, status, mpi::shardRequests());
+                    mpi::send(lookupShards(symbols, tag), source, tag, mpi::shardReplies());
                     break;
                 }
-                case UNSAFE_RESOLVE: {
-                    RamDomain index;
-                    mpi::recv(index, status);
-                    mpi::send(unsafeResolve(index), status);
+                case RESOLVE_VECTOR: {
+                    std::vector<RamDomain> indices;
+                    mpi::recv(indices, status, mpi::shardRequests());
+                    std::vector<std::string> symbols;
+                    for (RamDomain index : indices) {
+                        symbols.push_back(resolveLocal(index));
+                    }
+                    mpi::send(symbols, source, tag, mpi::shardReplies());
                     break;
                 }
                 case SIZE: {
-                    mpi::recv(status);
-                    mpi::send(size(), status);
-                    break;
-                }
-                case PRINT: {
-                    mpi::recv(status);
-                    print(std::cout);
-                    break;
-                }
-                case INSERT_STRING: {
-                    std::string symbol;
-                    mpi::recv(symbol, status);
-                    insert(symbol);
-                    break;
-                }
-                case INSERT_VECTOR_STRING: {
-                    std::vector<std::string> symbols;
-                    mpi::recv(symbols, status);
-                    insert(symbols);
+                    std::vector<char> none;
+                    mpi::recv(none, status, mpi::shardRequests());
+                    std::vector<size_t> count = {numPublished.load(std::memory_order_acquire) - common};
+                    mpi::send(count, source, tag, mpi::shardReplies());
                     break;
                 }
                 default: {
-                    throw std::runtime_error("Invalid parameter in SymbolTable::handleMpiMessages.");
+                    throw std::runtime_error("Invalid parameter in SymbolTable::serve.");
                     break;
                 }
             }
         }
-        for (size_t i = 0; i < count; ++i) {
-            mpi::send(i + 1, EXIT);
+    }
+
+public:
+    /**
+     * Distributes the table across all processes, each holding and serving the shard of the symbols mapped
+     * to it; a collective operation. The symbols held so far, which must be the same on all processes,
+     * become common to all shards. Note that the indices of the other symbols grow with the number of
+     * processes.
+     */
+    void distribute() {
+        assert(!distributed() && "table distributed already");
+        numShards = mpi::commSize();
+        shardRank = mpi::commRank();
+        common = numPublished.load(std::memory_order_acquire);
+        server = std::thread([this]() { serve(); });
+    }
+
+    /** Stops serving the shard of this process once no process looks up symbols anymore; a collective
+     * operation. The symbols held by this process may still be resolved afterwards. */
+    void stopServing() {
+        MPI_Barrier(MPI_COMM_WORLD);
+        mpi::send(std::vector<char>(), shardRank, EXIT, mpi::shardRequests());
+        server.join();
+    }
+
+    /** Waits for the given number of processes to notify the completion of their strata */
+    void handleMpiMessages(const size_t count) {
+        assert(mpi::commRank() == 0);
+        for (size_t i = 0; i < count; i++) {
+            auto status = mpi::probe(MPI_ANY_SOURCE, EXIT);
+            mpi::recv(status);
         }
     }
 
     static int numberOfTags() {
         // ok, so this looks stupid, but it just gives the size of the enum at the top
-        return 10;
+        return 5;
     }
 
     static int exitTag() {
@@ -175,75 +334,434 @@ public:
 #endif
 
 private:
-    /** A lock to synchronize parallel accesses */
+    /** A lock to synchronize parallel accesses to the MPI caches and the I/O streams */
     mutable Lock access;
 
-    /** Map indices to strings. */
-    std::deque<std::string> numToStr;
+    /** The number of independently locked shards of the string-to-index map */
+    static constexpr size_t SHARD_COUNT = 64;
+
+    /** The size of the first block of the index-to-string store (log 2), each further block doubles */
+    static constexpr size_t BLOCK_BITS = 10;
+    static constexpr size_t MAX_BLOCKS = 64 - BLOCK_BITS;
+
+    /** The initial number of slots of a shard */
+    static constexpr size_t INITIAL_SLOTS = 16;
+
+    /**
+     * A shard of the string-to-index map, an open-addressing hash table. Each slot holds the upper half of
+     * the hash of a symbol and its index plus one (zero marks free slots), such that the strings themselves
+     * are only stored once, in the index-to-string store.
+     */
+    struct Shard {
+        Lock lock;
+        std::vector<uint64_t> slots;
+        size_t size = 0;
+
+        Shard() : slots(INITIAL_SLOTS, 0) {}
+    };
+
+    /** Map strings to indices, the shard of a string is determined by its hash. */
+    std::unique_ptr<Shard[]> shards;
+
+    /** Map indices to strings. Blocks are never moved, hence reading does not require any lock. */
+    std::unique_ptr<std::atomic<std::string*>[]> numToStr;
+
+    /** The number of indices assigned to symbols */
+    std::atomic<size_t> numSymbols;
+
+    /**
+     * The number of symbols whose strings are stored. Symbols are published in the order of their
+     * indices, hence a thread observing the count may resolve all smaller indices without any lock.
+     */
+    std::atomic<size_t> numPublished;
+
+    /** The hash function for symbols (FNV-1a) */
+    static uint64_t hash(const char* data, size_t length) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < length; i++) {
+            h ^= static_cast<unsigned char>(data[i]);
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    static uint64_t hash(const std::string& symbol) {
+        return hash(symbol.data(), symbol.size());
+    }
+
+    /** The symbols of the static segment, preceding the symbols of the table */
+    const SymbolSegment* segment = nullptr;
+
+    /** The dictionary file holding the static segment, if the table was loaded from one */
+    std::shared_ptr<const SymbolDictionary> dictionary;
+
+    /** The strings of the symbols of the static segment, created on their first resolution */
+    std::unique_ptr<std::atomic<const std::string*>[]> segmentStrings;
+
+    /** The number of symbols of the static segment */
+    size_t base = 0;
+
+    /** The largest displacement tried for a bucket of a static segment */
+    static constexpr uint32_t MAX_DISPLACEMENT = 1 << 16;
+
+    /** Obtains the slot of a static segment for a hash and the displacement of its bucket */
+    static size_t getSegmentSlot(uint64_t h, uint32_t displacement, size_t numSlots) {
+        uint64_t x = h + displacement * 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return (x ^ (x >> 31)) % numSlots;
+    }
+
+    /** Obtains the index of a symbol of the static segment, or a negative value if it is not in it */
+    RamDomain findStatic(const char* data, size_t length, uint64_t h) const {
+        if (segment == nullptr) {
+            return -1;
+        }
+        uint32_t displacement = segment->displacements[h % segment->numBuckets];
+        uint32_t slot = segment->slots[getSegmentSlot(h, displacement, segment->numSlots)];
+        if (slot == 0) {
+            return -1;
+        }
+        size_t index = slot - 1;
+        if (segment->lengths[index] != length || std::memcmp(segment->symbols[index], data, length) != 0) {
+            return -1;
+        }
+        return static_cast<RamDomain>(index);
+    }
+
+    /** Places the symbols of a static segment at the start of the empty table */
+    void attach(const SymbolSegment& symbols) {
+        segment = &symbols;
+        base = symbols.size;
+        segmentStrings.reset(new std::atomic<const std::string*>[base]());
+        numSymbols.store(base);
+        numPublished.store(base);
+    }
+
+    /** Obtains the symbol of the given index, creating the string of a symbol of the static segment */
+    const std::string& symbolOf(size_t index) const {
+        if (index >= base) {
+            return readSlot(index - base);
+        }
+        const std::string* str = segmentStrings[index].load(std::memory_order_acquire);
+        if (str == nullptr) {
+            auto* fresh = new std::string(segment->symbols[index], segment->lengths[index]);
+            if (segmentStrings[index].compare_exchange_strong(str, fresh, std::memory_order_acq_rel)) {
+                str = fresh;
+            } else {
+                delete fresh;
+            }
+        }
+        return *str;
+    }
+
+    /**
+     * Obtains the slot of the index-to-string store for the given position, counted from the first symbol
+     * after the static segment, allocating its block if required
+     */
+    std::string& getSlot(size_t index) const {
+        size_t pos = index + (size_t(1) << BLOCK_BITS);
+        size_t block = (63 - __builtin_clzll(pos)) - BLOCK_BITS;
+        std::string* data = numToStr[block].load(std::memory_order_acquire);
+        if (data == nullptr) {
+            auto* fresh = new std::string[size_t(1) << (block + BLOCK_BITS)];
+            if (numToStr[block].compare_exchange_strong(data, fresh, std::memory_order_acq_rel)) {
+                data = fresh;
+            } else {
+                delete[] fresh;
+            }
+        }
+        return data[pos - (size_t(1) << (block + BLOCK_BITS))];
+    }
 
-    /** Map strings to indices. */
-    std::unordered_map<std::string, size_t> strToNum;
+    /** Obtains the stored slot of the index-to-string store for the given position, as getSlot */
+    const std::string& readSlot(size_t index) const {
+        size_t pos = index + (size_t(1) << BLOCK_BITS);
+        size_t block = (63 - __builtin_clzll(pos)) - BLOCK_BITS;
+        const std::string* data = numToStr[block].load(std::memory_order_acquire);
+        assert(data != nullptr && "symbol not stored");
+        return data[pos - (size_t(1) << (block + BLOCK_BITS))];
+    }
+
+    /** Reports the resolution of an unknown index and terminates */
+    [[noreturn]] static void unknownIndex() {
+        // TODO: use different error reporting here!!
+        std::cerr << "Error index out of bounds in call to SymbolTable::resolve.\n";
+        exit(1);
+    }
+
+    /** Obtains the shard responsible for the given hash */
+    Shard& getShard(uint64_t h) const {
+        return shards[h % SHARD_COUNT];
+    }
+
+    /** Obtains the slot of the shard holding the given symbol, or the free slot it should be placed in; the
+     * caller holds the lock of the shard */
+    uint64_t& probe(Shard& shard, const char* data, size_t length, uint64_t h) const {
+        uint64_t tag = h >> 32;
+        size_t mask = shard.slots.size() - 1;
+        for (size_t pos = tag & mask;; pos = (pos + 1) & mask) {
+            uint64_t& slot = shard.slots[pos];
+            if (slot == 0) {
+                return slot;
+            }
+            if ((slot >> 32) == tag) {
+                const std::string& known = symbolOf((slot & 0xffffffffull) - 1);
+                if (known.size() == length && std::memcmp(known.data(), data, length) == 0) {
+                    return slot;
+                }
+            }
+        }
+    }
+
+    /** Doubles the number of slots of a shard; the caller holds the lock of the shard */
+    static void grow(Shard& shard) {
+        std::vector<uint64_t> slots(shard.slots.size() * 2, 0);
+        size_t mask = slots.size() - 1;
+        for (uint64_t slot : shard.slots) {
+            if (slot == 0) {
+                continue;
+            }
+            size_t pos = (slot >> 32) & mask;
+            while (slots[pos] != 0) {
+                pos = (pos + 1) & mask;
+            }
+            slots[pos] = slot;
+        }
+        shard.slots.swap(slots);
+    }
 
     /** Convenience method to place a new symbol in the table, if it does not exist, and return the index of
      * it. */
-    inline size_t newSymbolOfIndex(const std::string& symbol) {
-        size_t index;
-        auto it = strToNum.find(symbol);
-        if (it == strToNum.end()) {
-            index = numToStr.size();
-            strToNum[symbol] = index;
-            numToStr.push_back(symbol);
-        } else {
-            index = it->second;
+    inline size_t newSymbolOfIndex(const char* data, size_t length) {
+        uint64_t h = hash(data, length);
+        RamDomain known = findStatic(data, length, h);
+        if (known >= 0) {
+            return static_cast<size_t>(known);
+        }
+        Shard& shard = getShard(h);
+        LockSiteScope lockSite(LockSite::SYMBOL_TABLE);
+        auto lease = shard.lock.acquire();
+        (void)lease;  // avoid warning;
+        uint64_t& slot = probe(shard, data, length, h);
+        if (slot != 0) {
+            return (slot & 0xffffffffull) - 1;
+        }
+        // the index is assigned while holding the shard lock, such that every symbol gets exactly one
+        size_t index = numSymbols.fetch_add(1, std::memory_order_relaxed);
+        getSlot(index - base).assign(data, length);
+
+        // publish after the symbols of all smaller indices, before others may find the symbol in the shard
+#ifdef IS_PARALLEL
+        detail::Waiter wait;
+        while (numPublished.load(std::memory_order_acquire) != index) {
+            wait();
+        }
+#endif
+        numPublished.store(index + 1, std::memory_order_release);
+
+        slot = ((h >> 32) << 32) | (index + 1);
+        // keep the load factor below 3/4
+        if (++shard.size * 4 > shard.slots.size() * 3) {
+            grow(shard);
         }
         return index;
     }
 
+    /** Convenience method to place a new symbol in the table, see above */
+    inline size_t newSymbolOfIndex(const std::string& symbol) {
+        return newSymbolOfIndex(symbol.data(), symbol.size());
+    }
+
+    /** Obtains the index of the given symbol, or a negative value if it is not in the table */
+    RamDomain findSymbol(const std::string& symbol) const {
+        uint64_t h = hash(symbol);
+        RamDomain known = findStatic(symbol.data(), symbol.size(), h);
+        if (known >= 0) {
+            return known;
+        }
+        Shard& shard = getShard(h);
+        LockSiteScope lockSite(LockSite::SYMBOL_TABLE);
+        auto lease = shard.lock.acquire();
+        (void)lease;  // avoid warning;
+        uint64_t slot = probe(shard, symbol.data(), symbol.size(), h);
+        return static_cast<RamDomain>(slot & 0xffffffffull) - 1;
+    }
+
     /** Convenience method to place a new symbol in the table, if it does not exist. */
     inline void newSymbol(const std::string& symbol) {
-        if (strToNum.find(symbol) == strToNum.end()) {
-            strToNum[symbol] = numToStr.size();
-            numToStr.push_back(symbol);
+        newSymbolOfIndex(symbol);
+    }
+
+    /** Frees the blocks of the index-to-string store and the strings of the static segment */
+    void freeBlocks() {
+        for (size_t i = 0; i < MAX_BLOCKS; i++) {
+            delete[] numToStr[i].load(std::memory_order_relaxed);
+            numToStr[i].store(nullptr, std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < base; i++) {
+            delete segmentStrings[i].load(std::memory_order_relaxed);
+            segmentStrings[i].store(nullptr, std::memory_order_relaxed);
         }
     }
 
+    /** Exchanges the content of this table with the given one. */
+    void swap(SymbolTable& other) {
+        shards.swap(other.shards);
+        numToStr.swap(other.numToStr);
+        numSymbols.store(other.numSymbols.exchange(numSymbols.load()));
+        numPublished.store(other.numPublished.exchange(numPublished.load()));
+        std::swap(segment, other.segment);
+        dictionary.swap(other.dictionary);
+        segmentStrings.swap(other.segmentStrings);
+        std::swap(base, other.base);
+    }
+
 public:
     /** Empty constructor. */
-    SymbolTable() = default;
+    SymbolTable()
+            : shards(new Shard[SHARD_COUNT]), numToStr(new std::atomic<std::string*>[MAX_BLOCKS]()),
+              numSymbols(0), numPublished(0) {}
 
     /** Copy constructor, performs a deep copy. */
-    SymbolTable(const SymbolTable& other) : numToStr(other.numToStr), strToNum(other.strToNum) {}
+    SymbolTable(const SymbolTable& other) : SymbolTable() {
+        if (other.segment != nullptr) {
+            attach(*other.segment);
+            dictionary = other.dictionary;
+        }
+        size_t count = other.numPublished.load(std::memory_order_acquire);
+        for (size_t i = base; i < count; i++) {
+            newSymbol(other.readSlot(i - base));
+        }
+    }
 
     /** Copy constructor for r-value reference. */
-    SymbolTable(SymbolTable&& other) noexcept {
-        numToStr.swap(other.numToStr);
-        strToNum.swap(other.strToNum);
+    SymbolTable(SymbolTable&& other) noexcept : SymbolTable() {
+        swap(other);
     }
 
-    SymbolTable(std::initializer_list<std::string> symbols) {
-        strToNum.reserve(symbols.size());
+    SymbolTable(std::initializer_list<std::string> symbols) : SymbolTable() {
         for (const auto& symbol : symbols) {
             newSymbol(symbol);
         }
     }
 
+    /** Constructs a table starting with the symbols of a static segment, without copying or hashing them. */
+    explicit SymbolTable(const SymbolSegment& symbols) : SymbolTable() {
+        attach(symbols);
+    }
+
+    /**
+     * Constructs a table starting with the symbols of a dictionary file written by save, under their
+     * indices in it, followed by the given symbols. The file is mapped rather than its symbols hashed.
+     * A non-zero checksum must be the one of the dictionary, such as the one of the dictionary a
+     * program was compiled with.
+     */
+    static SymbolTable load(const std::string& fileName, uint64_t checksum = 0,
+            std::initializer_list<std::string> symbols = {}) {
+        auto symbolDictionary = std::make_shared<const SymbolDictionary>(fileName);
+        if (checksum != 0 && symbolDictionary->getChecksum() != checksum) {
+            throw std::runtime_error(
+                    "Symbol dictionary " + fileName + " differs from the one of the program");
+        }
+        SymbolTable table;
+        const SymbolSegment& dictionarySymbols = symbolDictionary->getSegment();
+        if (symbolDictionary->isHashed()) {
+            table.attach(dictionarySymbols);
+        } else {
+            for (size_t i = 0; i < dictionarySymbols.size; i++) {
+                table.newSymbol(std::string(dictionarySymbols.symbols[i], dictionarySymbols.lengths[i]));
+            }
+        }
+        table.dictionary = std::move(symbolDictionary);
+        for (const auto& symbol : symbols) {
+            table.newSymbol(symbol);
+        }
+        return table;
+    }
+
+    /**
+     * Computes the perfect hash of a static segment holding the given distinct symbols under their
+     * positions. Returns false if no displacement separates the symbols of some bucket.
+     */
+    static bool buildSegment(const std::vector<std::string>& symbols, std::vector<uint32_t>& displacements,
+            std::vector<uint32_t>& slots) {
+        std::vector<uint64_t> hashes(symbols.size());
+        for (size_t i = 0; i < symbols.size(); i++) {
+            hashes[i] = hash(symbols[i]);
+        }
+        return buildSegment(hashes, displacements, slots);
+    }
+
+    /** Computes the perfect hash of a static segment from the hashes of its symbols, see above. */
+    static bool buildSegment(const std::vector<uint64_t>& hashes, std::vector<uint32_t>& displacements,
+            std::vector<uint32_t>& slots) {
+        const size_t numBuckets = hashes.size() / 2 + 1;
+        const size_t numSlots = hashes.size() + hashes.size() / 4 + 1;
+        std::vector<std::vector<uint32_t>> buckets(numBuckets);
+        for (size_t i = 0; i < hashes.size(); i++) {
+            buckets[hashes[i] % numBuckets].push_back(static_cast<uint32_t>(i));
+        }
+
+        // the largest buckets are placed first, while most slots are still free
+        std::vector<size_t> order(numBuckets);
+        for (size_t i = 0; i < numBuckets; i++) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                [&](size_t a, size_t b) { return buckets[a].size() > buckets[b].size(); });
+
+        displacements.assign(numBuckets, 0);
+        slots.assign(numSlots, 0);
+        std::vector<size_t> positions;
+        for (size_t cur : order) {
+            const auto& bucket = buckets[cur];
+            if (bucket.empty()) {
+                break;
+            }
+            for (uint32_t displacement = 0;; displacement++) {
+                if (displacement == MAX_DISPLACEMENT) {
+                    return false;
+                }
+                positions.clear();
+                for (uint32_t index : bucket) {
+                    size_t pos = getSegmentSlot(hashes[index], displacement, numSlots);
+                    if (slots[pos] != 0 ||
+                            std::find(positions.begin(), positions.end(), pos) != positions.end()) {
+                        break;
+                    }
+                    positions.push_back(pos);
+                }
+                if (positions.size() == bucket.size()) {
+                    for (size_t i = 0; i < bucket.size(); i++) {
+                        slots[positions[i]] = bucket[i] + 1;
+                    }
+                    displacements[cur] = displacement;
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
     /** Destructor, frees memory allocated for all strings. */
-    virtual ~SymbolTable() = default;
+    virtual ~SymbolTable() {
+        freeBlocks();
+    }
 
     /** Assignment operator, performs a deep copy and frees memory allocated for all strings. */
     SymbolTable& operator=(const SymbolTable& other) {
         if (this == &other) {
             return *this;
         }
-        numToStr = other.numToStr;
-        strToNum = other.strToNum;
+        SymbolTable copy(other);
+        swap(copy);
         return *this;
     }
 
     /** Assignment operator for r-value references. */
     SymbolTable& operator=(SymbolTable&& other) noexcept {
-        numToStr.swap(other.numToStr);
-        strToNum.swap(other.strToNum);
+        swap(other);
         return *this;
     }
 
@@ -251,42 +769,107 @@ public:
      * already. */
     RamDomain lookup(const std::string& symbol) {
 #ifdef USE_MPI
-        if (mpi::commRank() != 0) {
-            return cacheLookup(symbol, LOOKUP);
+        if (distributed()) {
+            return lookupShards({symbol}, LOOKUP_VECTOR)[0];
         } else
 #endif
-        {
-            auto lease = access.acquire();
-            (void)lease;  // avoid warning;
             return static_cast<RamDomain>(newSymbolOfIndex(symbol));
+    }
+
+    /** Find the index of the symbol of the given characters, inserting a new symbol if it does not exist
+     * there already. The characters are only copied for a new symbol. */
+    RamDomain lookup(const char* data, size_t length) {
+#ifdef USE_MPI
+        if (distributed()) {
+            return lookupShards({std::string(data, length)}, LOOKUP_VECTOR)[0];
+        } else
+#endif
+            return static_cast<RamDomain>(newSymbolOfIndex(data, length));
+    }
+
+    /** Find the index of the concatenation of the symbols of the given indices, inserting it if it does not
+     * exist already. The concatenation is assembled in a buffer of the calling thread, such that no memory
+     * is allocated for an existing result. */
+    RamDomain concat(const RamDomain* indices, size_t count) {
+        static thread_local std::string scratch;
+        scratch.clear();
+        for (size_t i = 0; i < count; i++) {
+            scratch += resolve(indices[i]);
         }
+        return lookup(scratch.data(), scratch.size());
     }
 
-    /** Finds the index of a symbol in the table, giving an error if it's not found */
-    RamDomain lookupExisting(const std::string& symbol) const {
+    RamDomain concat(std::initializer_list<RamDomain> indices) {
+        return concat(indices.begin(), indices.size());
+    }
+
+    /** Find the index of the substring of the symbol of the given index at the given position and of at most
+     * the given length, inserting it if it does not exist already; the substring is not copied for an
+     * existing result. A position past the end of the symbol gives the empty symbol and a warning. */
+    RamDomain substr(RamDomain index, RamDomain pos, RamDomain len) {
+        const std::string& str = resolve(index);
+        const auto first = static_cast<size_t>(pos);
+        if (first > str.size()) {
+            std::cerr << "warning: wrong index position provided by substr(\"";
+            std::cerr << str << "\"," << (int32_t)pos << "," << (int32_t)len << ") functor.\n";
+            return lookup("", 0);
+        }
+        return lookup(str.data() + first, std::min(static_cast<size_t>(len), str.size() - first));
+    }
+
+    /** Find the indices of the given symbols, inserting those that do not exist in the table already; a
+     * distributed table obtains those of each other shard in one round trip. */
+    std::vector<RamDomain> lookupAll(const std::vector<std::string>& symbols) {
 #ifdef USE_MPI
-        if (mpi::commRank() != 0) {
-            return cacheLookup(symbol, LOOKUP_EXISTING);
+        if (distributed()) {
+            return lookupShards(symbols, LOOKUP_VECTOR);
         } else
 #endif
         {
-            auto lease = access.acquire();
-            (void)lease;  // avoid warning;
-            auto result = strToNum.find(symbol);
-            if (result == strToNum.end()) {
-                std::cerr << "Error string not found in call to SymbolTable::lookupExisting.\n";
-                exit(1);
+            std::vector<RamDomain> indices;
+            indices.reserve(symbols.size());
+            for (const auto& symbol : symbols) {
+                indices.push_back(static_cast<RamDomain>(newSymbolOfIndex(symbol)));
             }
-            return static_cast<RamDomain>(result->second);
+            return indices;
+        }
+    }
+
+    /** Makes the symbols of the given indices available for resolving them; a distributed table obtains
+     * those of each other shard it has not seen yet in one round trip. */
+    void prefetch(const std::vector<RamDomain>& indices) const {
+#ifdef USE_MPI
+        if (distributed()) {
+            requestSymbols(indices);
+        }
+#else
+        (void)indices;
+#endif
+    }
+
+    /** Finds the index of a symbol in the table, giving an error if it's not found */
+    RamDomain lookupExisting(const std::string& symbol) const {
+        RamDomain result;
+#ifdef USE_MPI
+        if (distributed()) {
+            // looking up existing symbols does not modify the table
+            result = const_cast<SymbolTable*>(this)->lookupShards({symbol}, LOOKUP_EXISTING)[0];
+        } else
+#endif
+            result = findSymbol(symbol);
+        if (result < 0) {
+            std::cerr << "Error string not found in call to SymbolTable::lookupExisting.\n";
+            exit(1);
         }
+        return result;
     }
 
     /** Find the index of a symbol in the table, inserting a new symbol if it does not exist there
      * already. */
     RamDomain unsafeLookup(const std::string& symbol) {
 #ifdef USE_MPI
-        if (mpi::commRank() != 0) {
-            return cacheLookup(symbol, UNSAFE_LOOKUP);
+        if (distributed()) {
+            return lookupShards({symbol}, LOOKUP_VECTOR)[0];
         } else
 #endif
             return newSymbolOfIndex(symbol);
@@ -294,46 +877,56 @@ public:
 
     /** Find a symbol in the table by its index, note that this gives an error if the index is out of
      * bounds.
+     *
+     * Resolution takes no lock and performs no atomic read-modify-write, but for the first resolution
+     * of a symbol of the static segment: the published count orders the read of the string after
+     * its store.
      */
     const std::string& resolve(const RamDomain index) const {
 #ifdef USE_MPI
-        if (mpi::commRank() != 0) {
-            return cacheResolve(index, RESOLVE);
+        if (distributed()) {
+            return isLocal(index) ? resolveLocal(index) : resolveRemote(index);
         } else
 #endif
         {
-            auto lease = access.acquire();
-            (void)lease;  // avoid warning;
             auto pos = static_cast<size_t>(index);
-            if (pos >= size()) {
-                // TODO: use different error reporting here!!
-                std::cerr << "Error index out of bounds in call to SymbolTable::resolve.\n";
-                exit(1);
+            if (pos >= numPublished.load(std::memory_order_acquire)) {
+                unknownIndex();
             }
-            return numToStr[pos];
+            return symbolOf(pos);
         }
     }
 
     const std::string& unsafeResolve(const RamDomain index) const {
 #ifdef USE_MPI
-        if (mpi::commRank() != 0) {
-            return cacheResolve(index, UNSAFE_RESOLVE);
+        if (distributed()) {
+            return isLocal(index) ? symbolOf(toLocal(index)) : resolveRemote(index);
         } else
 #endif
-            return numToStr[static_cast<size_t>(index)];
+            return symbolOf(static_cast<size_t>(index));
     }
 
     /* Return the size of the symbol table, being the number of symbols it currently holds. */
     size_t size() const {
 #ifdef USE_MPI
-        if (mpi::commRank() != 0) {
-            mpi::send(0, SIZE);
-            size_t size;
-            mpi::recv(size, 0, SIZE);
+        if (distributed()) {
+            size_t size = numPublished.load(std::memory_order_acquire);
+            LockSiteScope lockSite(LockSite::SYMBOL_TABLE);
+            auto lease = access.acquire();
+            (void)lease;  // avoid warning;
+            for (int owner = 0; owner < numShards; owner++) {
+                if (owner != shardRank) {
+                    mpi::send(std::vector<char>(), owner, SIZE, mpi::shardRequests());
+                    auto status = mpi::probe(owner, SIZE, mpi::shardReplies());
+                    std::vector<size_t> count;
+                    mpi::recv(count, status, mpi::shardReplies());
+                    size += count[0];
+                }
+            }
             return size;
         } else
 #endif
-            return numToStr.size();
+            return numPublished.load(std::memory_order_acquire);
     }
 
     /** Bulk insert symbols into the table, note that this operation is more efficient than repeated
@@ -341,14 +934,11 @@ public:
      * of single symbols. */
     void insert(const std::vector<std::string>& symbols) {
 #ifdef USE_MPI
-        if (mpi::commRank() != 0) {
-            mpi::send(symbols, 0, INSERT_VECTOR_STRING);
+        if (distributed()) {
+            lookupShards(symbols, LOOKUP_VECTOR);
         } else
 #endif
         {
-            auto lease = access.acquire();
-            (void)lease;  // avoid warning;
-            strToNum.reserve(size() + symbols.size());
             for (auto& symbol : symbols) {
                 newSymbol(symbol);
             }
@@ -360,51 +950,128 @@ public:
      * in bulk. */
     void insert(const std::string& symbol) {
 #ifdef USE_MPI
-        if (mpi::commRank() != 0) {
-            mpi::send(symbol, 0, INSERT_STRING);
+        if (distributed()) {
+            lookupShards({symbol}, LOOKUP_VECTOR);
         } else
 #endif
-        {
-            auto lease = access.acquire();
-            (void)lease;  // avoid warning;
             newSymbol(symbol);
-        }
     }
 
-    /** Print the symbol table to the given stream. */
+    /** Print the symbol table to the given stream; a distributed table prints the symbols of the shard of
+     * this process, the common ones by the first process only. */
     void print(std::ostream& out) const {
 #ifdef USE_MPI
-        if (mpi::commRank() != 0) {
-            mpi::send(0, PRINT);
+        if (distributed()) {
+            out << "SymbolTable: {\n\t";
+            size_t first = (shardRank == 0) ? 0 : common;
+            for (size_t i = first; i < numPublished.load(std::memory_order_acquire); i++) {
+                if (i != first) {
+                    out << "\n\t";
+                }
+                out << symbolOf(i) << "\t => " << toGlobal(i);
+            }
+            out << "\n";
+            out << "}\n";
         } else
 #endif
         {
             out << "SymbolTable: {\n\t";
-            out << join(strToNum, "\n\t",
-                           [](std::ostream& out, const std::pair<std::string, std::size_t>& entry) {
-                               out << entry.first << "\t => " << entry.second;
-                           })
-                << "\n";
+            for (size_t i = 0; i < size(); i++) {
+                if (i != 0) {
+                    out << "\n\t";
+                }
+                out << unsafeResolve(i) << "\t => " << i;
+            }
+            out << "\n";
             out << "}\n";
         }
     }
 
+    /**
+     * Writes the symbols of the table into a dictionary file under their indices, see load; the table
+     * must not be distributed. The file is replaced once it is written completely, such that programs
+     * mapping it are not disturbed.
+     */
+    void save(const std::string& fileName) const {
+        // the characters of a symbol, without creating the string of a symbol of the static segment
+        auto symbolData = [&](size_t index) {
+            if (index < base) {
+                return std::make_pair(segment->symbols[index], static_cast<size_t>(segment->lengths[index]));
+            }
+            const std::string& symbol = readSlot(index - base);
+            return std::make_pair(symbol.data(), symbol.size());
+        };
+
+        const size_t count = numPublished.load(std::memory_order_acquire);
+        std::vector<uint64_t> hashes(count);
+        std::vector<uint32_t> lengths(count);
+        uint64_t symbolBytes = 0;
+        uint64_t checksum = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < count; i++) {
+            auto symbol = symbolData(i);
+            hashes[i] = hash(symbol.first, symbol.second);
+            lengths[i] = static_cast<uint32_t>(symbol.second);
+            symbolBytes += symbol.second;
+            checksum = (checksum ^ hashes[i]) * 0x100000001b3ull;
+        }
+        // without a perfect hash, a program loading the dictionary inserts its symbols one by one
+        std::vector<uint32_t> displacements;
+        std::vector<uint32_t> slots;
+        if (!buildSegment(hashes, displacements, slots)) {
+            displacements.clear();
+            slots.clear();
+        }
+        const dictionary::Header header = dictionary::makeHeader(
+                count, displacements.size(), slots.size(), symbolBytes, (checksum == 0) ? 1 : checksum);
+
+        const std::string tmpName = fileName + ".tmp";
+        std::ofstream file(tmpName, std::ios::out | std::ios::binary);
+        auto writePadding = [&](uint64_t size) {
+            static const char zeros[8] = {};
+            file.write(zeros, dictionary::pad(size) - size);
+        };
+        auto write = [&](const void* data, size_t size) {
+            file.write(static_cast<const char*>(data), size);
+            writePadding(size);
+        };
+        write(&header, sizeof(header));
+        write(lengths.data(), lengths.size() * sizeof(uint32_t));
+        write(displacements.data(), displacements.size() * sizeof(uint32_t));
+        write(slots.data(), slots.size() * sizeof(uint32_t));
+        for (size_t i = 0; i < count; i++) {
+            auto symbol = symbolData(i);
+            file.write(symbol.first, symbol.second);
+        }
+        writePadding(symbolBytes);
+        file.close();
+        if (!file || std::rename(tmpName.c_str(), fileName.c_str()) != 0) {
+            throw std::runtime_error("Cannot write symbol dictionary " + fileName);
+        }
+    }
+
+    /** The dictionary file the table was loaded from, or null */
+    const SymbolDictionary* getDictionary() const {
+        return dictionary.get();
+    }
+
     /** Check if the symbol table contains a string */
     bool contains(const std::string& symbol) const {
-        auto lease = access.acquire();
-        (void)lease;  // avoid warning;
-        auto result = strToNum.find(symbol);
-        if (result == strToNum.end()) {
-            return false;
-        } else {
-            return true;
-        }
+        return findSymbol(symbol) >= 0;
     }
 
-    /** Check if the symbol table contains an index */
+    /** Check if the symbol table contains an index; a distributed table only knows the indices of the
+     * shard of this process and those it has cached */
     bool contains(const RamDomain index) const {
-        auto lease = access.acquire();
-        (void)lease;  // avoid warning;
+#ifdef USE_MPI
+        if (distributed()) {
+            if (isLocal(index)) {
+                return index >= 0 && toLocal(index) < numPublished.load(std::memory_order_acquire);
+            }
+            auto lease = access.acquire();
+            (void)lease;  // avoid warning;
+            return numToStrCache.find(index) != numToStrCache.end();
+        }
+#endif
         auto pos = static_cast<size_t>(index);
         if (pos >= size()) {
             return false;
@@ -413,6 +1080,38 @@ public:
         }
     }
 
+    /** Obtains an estimate of the number of bytes occupied by the symbols held by this process. */
+    size_t getMemoryUsage() const {
+        size_t res = sizeof(*this) + SHARD_COUNT * sizeof(Shard);
+        res += MAX_BLOCKS * sizeof(std::atomic<std::string*>);
+        for (size_t i = 0; i < SHARD_COUNT; i++) {
+            auto lease = shards[i].lock.acquire();
+            (void)lease;  // avoid warning;
+            res += shards[i].slots.capacity() * sizeof(uint64_t);
+        }
+        for (size_t i = 0; i < MAX_BLOCKS; i++) {
+            if (numToStr[i].load(std::memory_order_acquire) != nullptr) {
+                res += (size_t(1) << (i + BLOCK_BITS)) * sizeof(std::string);
+            }
+        }
+        // the symbols of the static segment are in static storage, only those resolved have strings
+        res += base * sizeof(std::atomic<const std::string*>);
+        for (size_t i = 0; i < base; i++) {
+            if (segmentStrings[i].load(std::memory_order_acquire) != nullptr) {
+                res += sizeof(std::string) + segment->lengths[i] + 1;
+            }
+        }
+        // long symbols are stored outside of their string objects
+        for (size_t i = base; i < numPublished.load(std::memory_order_acquire); i++) {
+            const std::string& symbol = readSlot(i - base);
+            const char* object = reinterpret_cast<const char*>(&symbol);
+            if (symbol.data() < object || symbol.data() >= object + sizeof(std::string)) {
+                res += symbol.capacity() + 1;
+            }
+        }
+        return res;
+    }
+
     Lock::Lease acquireLock() const {
         return access.acquire();
     }
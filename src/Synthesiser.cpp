@@ -19,25 +19,42 @@
 #include "FunctorOps.h"
 #include "Global.h"
 #include "IODirectives.h"
+#include "InputPrefetcher.h"
+#include "LogStatement.h"
+#include "RamBloomFilterAnalysis.h"
 #include "RamCondition.h"
 #include "RamExpression.h"
 #include "RamIndexAnalysis.h"
+#include "RamInsertBufferAnalysis.h"
+#include "RamLevelAnalysis.h"
+#include "RamLoopScheduleAnalysis.h"
+#include "RamMpiScheduleAnalysis.h"
 #include "RamNode.h"
 #include "RamOperation.h"
+#include "RamPrivateSymbolAnalysis.h"
+#include "RamRecordEscapeAnalysis.h"
 #include "RamProgram.h"
 #include "RamRelation.h"
+#include "RamStratumDependencyAnalysis.h"
 #include "RamTranslationUnit.h"
 #include "RamVisitor.h"
+#include "RegexCache.h"
 #include "RelationRepresentation.h"
+#include "StratumCache.h"
 #include "SymbolTable.h"
 #include "SynthesiserRelation.h"
 #include "Util.h"
+#include "profile/ProgramRun.h"
+#include "profile/Reader.h"
+#include "profile/Relation.h"
 #include <algorithm>
 #include <cassert>
 #include <cctype>
 #include <cstdlib>
 #include <functional>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <sstream>
 #include <typeinfo>
 #include <utility>
@@ -73,6 +90,46 @@ size_t Synthesiser::lookupReadIdx(const std::string& txt) {
     }
 }
 
+/** Lookup the number of a sampled rule */
+size_t Synthesiser::lookupSampleIdx(const std::string& label) {
+    auto pos = sampleIdxMap.find(label);
+    if (pos == sampleIdxMap.end()) {
+        size_t idx = sampleIdxMap.size() + 1;
+        return sampleIdxMap[label] = idx;
+    } else {
+        return pos->second;
+    }
+}
+
+/** Lookup access counters of an index */
+size_t Synthesiser::lookupIndexStatsIdx(const RamRelation& rel, SearchSignature keys) {
+    // the accesses of delta and new relations are attributed to their base relation
+    std::string name = rel.getName();
+    for (const std::string prefix : {"@delta_", "@new_"}) {
+        if (name.compare(0, prefix.size(), prefix) == 0) {
+            name = name.substr(prefix.size());
+        }
+    }
+
+    // describe the index by its order, expanded to all columns; lookups of entire tuples use the first
+    const auto& indexes = translationUnit.getAnalysis<RamIndexAnalysis>()->getIndexes(rel);
+    auto order = (keys == 0) ? indexes.getAllOrders()[0] : indexes.getLexOrder(keys);
+    for (size_t i = 0; i < rel.getArity(); ++i) {
+        if (std::find(order.begin(), order.end(), i) == order.end()) {
+            order.push_back(i);
+        }
+    }
+
+    std::string txt = name + ";" + toString(join(order, ","));
+    auto pos = indexStatsIdxMap.find(txt);
+    if (pos == indexStatsIdxMap.end()) {
+        size_t idx = indexStatsIdxMap.size();
+        return indexStatsIdxMap[txt] = idx;
+    } else {
+        return pos->second;
+    }
+}
+
 /** Convert RAM identifier */
 const std::string Synthesiser::convertRamIdent(const std::string& name) {
     auto it = identifiers.find(name);
@@ -122,6 +179,35 @@ const std::string Synthesiser::getRelationName(const RamRelation& rel) {
     return "rel_" + convertRamIdent(rel.getName());
 }
 
+/** Get the symbol table of a relation, which is a table of its own for pass-through relations */
+const std::string Synthesiser::getSymbolTableName(const RamRelation& rel) {
+    if (translationUnit.getAnalysis<RamPrivateSymbolAnalysis>()->isPrivate(rel)) {
+        return "symTable_" + getRelationName(rel);
+    }
+    return "symTable";
+}
+
+/** Generate code collecting the statistics of a relation by the partition of its tuples */
+void Synthesiser::emitCollectStatistics(std::ostream& out, const RamRelation& rel) {
+    if (rel.getArity() == 0) {
+        return;
+    }
+    std::vector<bool> symbolMask;
+    for (const auto& type : rel.getAttributeTypeQualifiers()) {
+        symbolMask.push_back(type[0] == 's');
+    }
+    std::vector<std::string> orders;
+    auto* isa = translationUnit.getAnalysis<RamIndexAnalysis>();
+    for (const auto& order : isa->getIndexes(rel).getAllOrders()) {
+        orders.push_back("{" + toString(join(order, ",")) + "}");
+    }
+    const std::string relName = getRelationName(rel);
+    out << "{auto chunks = " << relName << "->partition();\n";
+    out << "statistics.collect(R\"_(" << rel.getName() << ")_\", " << relName << "->size(), chunks, {"
+        << join(orders, ",") << "}, std::vector<bool>({" << join(symbolMask) << "}), "
+        << getSymbolTableName(rel) << ");}\n";
+}
+
 /** Get relation name via string */
 const std::string Synthesiser::getRelationName(const std::string& relName) {
     return "rel_" + convertRamIdent(relName);
@@ -132,17 +218,23 @@ const std::string Synthesiser::getOpContextName(const RamRelation& rel) {
     return getRelationName(rel) + "_op_ctxt";
 }
 
-/** Get relation type struct */
-void Synthesiser::generateRelationTypeStruct(
-        std::ostream& out, std::unique_ptr<SynthesiserRelation> relationType) {
-    // If this type has been generated already, use the cached version
-    if (typeCache.find(relationType->getTypeName()) != typeCache.end()) {
-        return;
+/** Compute the state the emission of statements shares, such that statements can be emitted in parallel */
+void Synthesiser::prepareParallelEmission() {
+    // identifiers are numbered in the order the relations are first named
+    for (const auto& cur : translationUnit.getProgram()->getAllRelations()) {
+        getRelationName(*cur.second);
     }
-    typeCache.insert(relationType->getTypeName());
-
-    // Generate the type struct for the relation
-    relationType->generateTypeStruct(out);
+    translationUnit.getAnalysis<RamIndexAnalysis>();
+    translationUnit.getAnalysis<RamBloomFilterAnalysis>();
+    translationUnit.getAnalysis<RamInsertBufferAnalysis>();
+    translationUnit.getAnalysis<RamLoopScheduleAnalysis>();
+    translationUnit.getAnalysis<RamPrivateSymbolAnalysis>();
+    translationUnit.getAnalysis<RamRecordEscapeAnalysis>();
+#ifdef USE_MPI
+    if (Global::config().get("engine") == "mpi") {
+        translationUnit.getAnalysis<RamMpiScheduleAnalysis>();
+    }
+#endif
 }
 
 /* Convert SearchColums to a template index */
@@ -179,11 +271,58 @@ std::set<const RamRelation*> Synthesiser::getReferencedRelations(const RamOperat
             res.insert(&provExists->getRelation());
         } else if (auto project = dynamic_cast<const RamProject*>(&node)) {
             res.insert(&project->getRelation());
+        } else if (auto intersect = dynamic_cast<const RamIntersect*>(&node)) {
+            for (size_t i = 0; i < intersect->getNumParticipants(); i++) {
+                res.insert(&intersect->getRelation(i));
+            }
         }
     });
     return res;
 }
 
+void Synthesiser::emitLoad(std::ostream& out, const RamLoad& load, LoadMode mode) {
+    std::vector<bool> symbolMask;
+    for (auto& cur : load.getRelation().getAttributeTypeQualifiers()) {
+        symbolMask.push_back(cur[0] == 's');
+    }
+    std::stringstream reader;
+    reader << "IOSystem::getInstance().getReader(";
+    reader << "std::vector<bool>({" << join(symbolMask) << "})";
+    reader << ", " << getSymbolTableName(load.getRelation()) << ", ioDirectives";
+    reader << ", " << (load.getRelation().hasProvenanceColumns() ? "true" : "false") << ")";
+    const std::string relName = getRelationName(load.getRelation());
+
+    // get some table details
+    size_t directive = 0;
+    for (IODirectives ioDirectives : load.getIODirectives()) {
+        const std::string key = InputPrefetcher::key(load.getRelation().getName(), directive++);
+        out << "try {";
+        out << "std::map<std::string, std::string> directiveMap(";
+        out << ioDirectives << ");\n";
+        out << R"_(if (!inputDirectory.empty() && IODirectives::isFileType(directiveMap["IO"]) && )_";
+        out << "directiveMap[\"filename\"].front() != '/') {";
+        out << R"_(directiveMap["filename"] = inputDirectory + "/" + directiveMap["filename"];)_";
+        out << "}\n";
+        out << "IODirectives ioDirectives(directiveMap);\n";
+        switch (mode) {
+            case LoadMode::READ:
+                out << reader.str() << "->readAll(*" << relName << ");\n";
+                break;
+            case LoadMode::PREFETCH:
+                out << "inputPrefetcher.prefetch(R\"_(" << key << ")_\", " << symbolMask.size();
+                out << ", [this, ioDirectives](TupleBuffer& tuples) {";
+                out << reader.str() << "->readAll(tuples);});\n";
+                break;
+            case LoadMode::INSERT_PREFETCHED:
+                out << "if (!inputPrefetcher.load(R\"_(" << key << ")_\", *" << relName << ")) {";
+                out << reader.str() << "->readAll(*" << relName << ");}\n";
+                break;
+        }
+        out << "} catch (std::exception& e) {std::cerr << \"Error loading data: \" << e.what() << "
+               "'\\n';}\n";
+    }
+}
+
 void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
     class CodeEmitter : public RamVisitor<void, std::ostream&> {
     private:
@@ -207,6 +346,808 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
         std::ostringstream preamble;
         bool preambleIssued = false;
 
+        /** whether the preamble of a parallel operation opens a condition on its contexts */
+        bool preambleConditional = false;
+
+        /** whether the current query keeps its local records in an arena */
+        bool localRecords = false;
+
+        /** the nested loop evaluated in parallel as its outer loop provides too few tuples */
+        const RamRelationOperation* nestedParallel = nullptr;
+
+        /** the number of the rule marked for the sampling profiler, or 0 outside of rules */
+        size_t sampleRule = 0;
+
+        /** the number of loops enclosing the statement being emitted */
+        size_t loopDepth = 0;
+
+        /** the memos of the index probes of the current query, by the probes */
+        std::map<const RamNode*, std::string> probeMemos;
+
+        /** Get the expression of the mask of the symbol columns of a relation */
+        static std::string getSymbolMask(const RamRelation& rel) {
+            std::vector<bool> symbolMask;
+            for (const auto& cur : rel.getAttributeTypeQualifiers()) {
+                symbolMask.push_back(cur[0] == 's');
+            }
+            return "std::vector<bool>({" + toString(join(symbolMask)) + "})";
+        }
+
+        /** Whether the program resolves symbols of tuples in functors or constraints */
+        bool resolvesSymbols() const {
+            bool res = false;
+            visitDepthFirst(*synthesiser.translationUnit.getProgram(), [&](const RamNode& node) {
+                if (const auto* op = dynamic_cast<const RamIntrinsicOperator*>(&node)) {
+                    for (size_t i = 0; i < op->getArgCount(); i++) {
+                        res = res || functorOpAcceptsSymbols(i, op->getOperator());
+                    }
+                } else if (const auto* op = dynamic_cast<const RamUserDefinedOperator*>(&node)) {
+                    res = res || op->getType().find('S') != std::string::npos;
+                } else if (const auto* constraint = dynamic_cast<const RamConstraint*>(&node)) {
+                    res = res || isSymbolicBinaryConstraintOp(constraint->getOperator());
+                }
+            });
+            return res;
+        }
+
+        /** Print the marking of a loop level of the current rule for the sampling profiler */
+        void printSamplePosition(size_t level, std::ostream& out) {
+            out << "SampleProfiler::setPosition(SampleProfiler::getPosition(" << sampleRule << "," << level
+                << "));\n";
+        }
+
+        /**
+         * Check whether the threads of a parallel query buffer the tuples they project into a b-tree
+         * relation, which wide relations stored indirectly and deltas kept in append buffers do not
+         */
+        bool hasBufferedProjection(const RamQuery& query, const RamRelation& rel) {
+            const auto* buffers = synthesiser.getTranslationUnit().getAnalysis<RamInsertBufferAnalysis>();
+            bool buffered = false;
+            visitDepthFirst(query, [&](const RamProject& project) {
+                buffered = buffered || (&project.getRelation() == &rel && buffers->isBuffered(project));
+            });
+            if (!buffered) {
+                return false;
+            }
+            auto relationType = SynthesiserRelation::getSynthesiserRelation(
+                    rel, isa->getIndexes(rel), rel.hasProvenanceColumns());
+            return dynamic_cast<const SynthesiserDirectRelation*>(relationType.get()) != nullptr;
+        }
+
+        /** Check whether a relation is stored in b-trees, whose types provide bounded existence checks */
+        bool isDirect(const RamRelation& rel) {
+            auto relationType = SynthesiserRelation::getSynthesiserRelation(
+                    rel, isa->getIndexes(rel), rel.hasProvenanceColumns());
+            return dynamic_cast<const SynthesiserDirectRelation*>(relationType.get()) != nullptr;
+        }
+
+        /**
+         * Obtain the index scan nested directly into a scan whose searches are probed in batches, if
+         * --batch-probes is set and both relations are stored in b-trees; its search values must be
+         * plain values of the enclosing tuples, and the loops must be neither parallel nor profiled
+         */
+        const RamIndexScan* getBatchedProbe(const RamScan& scan) {
+            const auto* iscan = dynamic_cast<const RamIndexScan*>(&scan.getOperation());
+            if (!Global::config().has("batch-probes") || iscan == nullptr || &scan == nestedParallel ||
+                    iscan == nestedParallel || sampleRule != 0 || Global::config().has("profile")) {
+                return nullptr;
+            }
+            auto keys = isa->getSearchSignature(iscan);
+            const auto& rel = iscan->getRelation();
+            if (keys == 0 || keys == (SearchSignature(1) << rel.getArity()) - 1 || iscan->hasRange() ||
+                    !isDirect(scan.getRelation()) || !isDirect(rel)) {
+                return nullptr;
+            }
+            for (const RamExpression* value : iscan->getRangePattern()) {
+                if (!isRamUndefValue(value) && dynamic_cast<const RamNumber*>(value) == nullptr &&
+                        dynamic_cast<const RamTupleElement*>(value) == nullptr) {
+                    return nullptr;
+                }
+            }
+            return iscan;
+        }
+
+        /**
+         * Print a scan gathering its tuples in batches, whose searches of the nested index scan descend
+         * the index together, and then running the nested loop for each tuple of the batch
+         */
+        void printBatchedProbe(const RamScan& scan, const RamIndexScan& iscan, std::ostream& out) {
+            const auto& rel = iscan.getRelation();
+            auto relName = synthesiser.getRelationName(rel);
+            auto outerName = synthesiser.getRelationName(scan.getRelation());
+            auto keys = isa->getSearchSignature(&iscan);
+            auto arity = rel.getArity();
+            const auto& rangePattern = iscan.getRangePattern();
+            const std::string id = std::to_string(scan.getTupleId());
+            const std::string outer = "outer" + id;
+            const std::string probes = "probes" + id;
+            const std::string lows = "lows" + id;
+
+            out << "{\n";
+            out << "Tuple<RamDomain," << scan.getRelation().getArity() << "> " << outer << "[8];\n";
+            out << "Tuple<RamDomain," << arity << "> " << probes << "[8];\n";
+            out << "std::decay<decltype(" << relName << "->equalRange_" << keys << "(" << probes
+                << "[0]).begin())>::type " << lows << "[8];\n";
+            out << "auto cur" << id << " = " << outerName << "->begin();\n";
+            out << "const auto fin" << id << " = " << outerName << "->end();\n";
+            out << "while (cur" << id << " != fin" << id << ") {\n";
+
+            // gather a batch of tuples with the lower bounds of their searches
+            out << "std::size_t num" << id << " = 0;\n";
+            out << "for (; cur" << id << " != fin" << id << " && num" << id << " < 8; ++cur" << id
+                << ", ++num" << id << ") {\n";
+            out << outer << "[num" << id << "] = *cur" << id << ";\n";
+            out << "const auto& env" << id << " = " << outer << "[num" << id << "];\n";
+            out << probes << "[num" << id << "] = Tuple<RamDomain," << arity << ">({{";
+            out << join(rangePattern, ",", [&](std::ostream& out, RamExpression* value) {
+                if (!isRamUndefValue(value)) {
+                    visit(*value, out);
+                } else {
+                    out << "MIN_RAM_DOMAIN";
+                }
+            });
+            out << "}});\n";
+            out << "}\n";
+            out << relName << "->lowerBounds_" << keys << "(" << probes << ", num" << id << ", " << lows
+                << ");\n";
+
+            // scan the tuples agreeing with the searched values from each lower bound
+            std::vector<std::string> matches;
+            for (size_t column = 0; column < arity; column++) {
+                if (!isRamUndefValue(rangePattern[column])) {
+                    matches.push_back("(*pos)[" + std::to_string(column) + "] == " + probes + "[i" + id +
+                                      "][" + std::to_string(column) + "]");
+                }
+            }
+            out << "for (std::size_t i" << id << " = 0; i" << id << " < num" << id << "; ++i" << id
+                << ") {\n";
+            out << "const auto& env" << id << " = " << outer << "[i" << id << "];\n";
+            out << "(void)env" << id << ";\n";
+            out << "for (auto pos = " << lows << "[i" << id << "]; pos != decltype(pos)() && "
+                << join(matches, " && ") << "; ++pos) {\n";
+            out << "const auto& env" << iscan.getTupleId() << " = *pos;\n";
+            visitNestedOperation(iscan, out);
+            out << "}\n";
+            out << "}\n";
+            out << "}\n";
+            out << "}\n";
+        }
+
+        /**
+         * Obtain the index scan of a query joining the tuples of an outer scan with those of another
+         * relation on equal values, which is evaluated by a bulk join if the bulk-joins option is set.
+         * The query has to belong to a non-recursive stratum, filtering the joined tuples and projecting
+         * them into a third relation by numbers computed from their values only.
+         */
+        const RamIndexScan* getBulkJoin(const RamQuery& query) {
+            if (!Global::config().has("bulk-joins") || loopDepth > 0 || sampleRule != 0 ||
+                    Global::config().has("profile") || Global::config().has("provenance")) {
+                return nullptr;
+            }
+
+            // an outer filter may only check conditions not depending on any tuple
+            const RamOperation* op = &query.getOperation();
+            if (const auto* filter = dynamic_cast<const RamFilter*>(op)) {
+                op = &filter->getOperation();
+            }
+            const auto* scan = dynamic_cast<const RamScan*>(op);
+            if (scan == nullptr || !isDirect(scan->getRelation())) {
+                return nullptr;
+            }
+
+            // the outer tuples are filtered before the index scan probing the other relation
+            op = &scan->getOperation();
+            while (const auto* filter = dynamic_cast<const RamFilter*>(op)) {
+                op = &filter->getOperation();
+            }
+            const auto* iscan = dynamic_cast<const RamIndexScan*>(op);
+            if (iscan == nullptr || !isDirect(iscan->getRelation()) || iscan->hasRange()) {
+                return nullptr;
+            }
+            bool keyed = false;
+            for (const RamExpression* value : iscan->getRangePattern()) {
+                if (const auto* element = dynamic_cast<const RamTupleElement*>(value)) {
+                    keyed = keyed || element->getTupleId() == scan->getTupleId();
+                } else if (!isRamUndefValue(value) && dynamic_cast<const RamNumber*>(value) == nullptr) {
+                    return nullptr;
+                }
+            }
+
+            // the joined tuples are filtered before their projection into a third relation
+            op = &iscan->getOperation();
+            while (const auto* filter = dynamic_cast<const RamFilter*>(op)) {
+                op = &filter->getOperation();
+            }
+            const auto* project = dynamic_cast<const RamProject*>(op);
+            if (!keyed || project == nullptr || project->getRelation() == scan->getRelation() ||
+                    project->getRelation() == iscan->getRelation()) {
+                return nullptr;
+            }
+
+            // nothing but numbers computed from the values of the tuples
+            bool numeric = true;
+            visitDepthFirst(query.getOperation(), [&](const RamNode& node) {
+                if (const auto* op = dynamic_cast<const RamIntrinsicOperator*>(&node)) {
+                    numeric = numeric && isNumericFunctorOp(op->getOperator());
+                    for (size_t i = 0; i < op->getArguments().size(); i++) {
+                        numeric = numeric && functorOpAcceptsNumbers(i, op->getOperator());
+                    }
+                } else if (const auto* constraint = dynamic_cast<const RamConstraint*>(&node)) {
+                    numeric = numeric && isNumericBinaryConstraintOp(constraint->getOperator());
+                } else if (const auto* element = dynamic_cast<const RamTupleElement*>(&node)) {
+                    numeric = numeric && (element->getTupleId() == scan->getTupleId() ||
+                                                 element->getTupleId() == iscan->getTupleId());
+                } else if (dynamic_cast<const RamExpression*>(&node) != nullptr) {
+                    numeric = numeric && (dynamic_cast<const RamNumber*>(&node) != nullptr ||
+                                                 dynamic_cast<const RamUndefValue*>(&node) != nullptr);
+                } else if (dynamic_cast<const RamCondition*>(&node) != nullptr) {
+                    numeric = numeric && (dynamic_cast<const RamConjunction*>(&node) != nullptr ||
+                                                 dynamic_cast<const RamNegation*>(&node) != nullptr ||
+                                                 dynamic_cast<const RamTrue*>(&node) != nullptr ||
+                                                 dynamic_cast<const RamFalse*>(&node) != nullptr ||
+                                                 dynamic_cast<const RamEmptinessCheck*>(&node) != nullptr);
+                }
+            });
+            return numeric ? iscan : nullptr;
+        }
+
+        /**
+         * Print the evaluation of a query by a bulk join of the relations of its outer scan and the
+         * index scan nested into it, if they are large enough, opening the block of its evaluation by
+         * the loop nest otherwise
+         */
+        void printBulkJoin(const RamQuery& query, const RamIndexScan& iscan, std::ostream& out) {
+            const RamOperation* op = &query.getOperation();
+            const RamCondition* guard = nullptr;
+            if (const auto* filter = dynamic_cast<const RamFilter*>(op)) {
+                guard = &filter->getCondition();
+                op = &filter->getOperation();
+            }
+            const auto& scan = dynamic_cast<const RamScan&>(*op);
+            const auto& outer = scan.getRelation();
+            const auto& inner = iscan.getRelation();
+            const std::string outerType = "Tuple<RamDomain," + std::to_string(outer.getArity()) + ">";
+            const std::string innerType = "Tuple<RamDomain," + std::to_string(inner.getArity()) + ">";
+            const std::string outerEnv = "env" + std::to_string(scan.getTupleId());
+            const std::string innerEnv = "env" + std::to_string(iscan.getTupleId());
+
+            // the keys agreeing in both relations, and the constants of the inner one
+            std::vector<std::string> outerKey;
+            std::vector<std::string> innerKey;
+            std::vector<std::string> innerFilter;
+            const auto& rangePattern = iscan.getRangePattern();
+            for (size_t i = 0; i < rangePattern.size(); i++) {
+                const std::string column = innerEnv + "[" + std::to_string(i) + "]";
+                if (const auto* element = dynamic_cast<const RamTupleElement*>(rangePattern[i])) {
+                    if (element->getTupleId() == scan.getTupleId()) {
+                        outerKey.push_back(outerEnv + "[" + std::to_string(element->getElement()) + "]");
+                        innerKey.push_back(column);
+                        continue;
+                    }
+                }
+                if (!isRamUndefValue(rangePattern[i])) {
+                    std::stringstream value;
+                    visit(*rangePattern[i], value);
+                    innerFilter.push_back(column + " == " + value.str());
+                }
+            }
+
+            // the conditions of the outer tuples
+            std::vector<const RamCondition*> outerFilter;
+            op = &scan.getOperation();
+            while (const auto* filter = dynamic_cast<const RamFilter*>(op)) {
+                outerFilter.push_back(&filter->getCondition());
+                op = &filter->getOperation();
+            }
+
+            const std::string keyType = "Tuple<RamDomain," + std::to_string(outerKey.size()) + ">";
+            const std::string joinType =
+                    "souffle::BulkJoin<" + keyType + "," + outerType + "," + innerType + ">";
+            const auto outerName = synthesiser.getRelationName(outer);
+            const auto innerName = synthesiser.getRelationName(inner);
+            out << "if (";
+            if (Global::config().get("bulk-joins") == "all") {
+                out << "true";
+            } else {
+                out << outerName << "->size() >= " << joinType << "::MIN_SIZE && " << innerName
+                    << "->size() >= " << joinType << "::MIN_SIZE";
+            }
+            out << ") {\n";
+            if (guard != nullptr) {
+                out << "if(";
+                visit(*guard, out);
+                out << ") {\n";
+            }
+            out << joinType << " join(*" << outerName << ", *" << innerName << ",\n";
+            out << "[&](const " << outerType << "& " << outerEnv << ") { return " << keyType << "({{"
+                << join(outerKey, ",") << "}}); },\n";
+            out << "[&](const " << innerType << "& " << innerEnv << ") { return " << keyType << "({{"
+                << join(innerKey, ",") << "}}); },\n";
+            out << "[&](const " << outerType << "& " << outerEnv << ") { return (void)" << outerEnv;
+            out << ", ";
+            for (const RamCondition* cond : outerFilter) {
+                out << "(";
+                visit(*cond, out);
+                out << ") && ";
+            }
+            out << "true; },\n";
+            out << "[&](const " << innerType << "& " << innerEnv << ") { return (void)" << innerEnv << ", ";
+            if (innerFilter.empty()) {
+                innerFilter.push_back("true");
+            }
+            out << join(innerFilter, " && ") << "; });\n";
+
+            // the partitions are joined in parallel, each thread projecting into contexts of its own
+            out << "PARALLEL_START;\n";
+            for (const RamRelation* rel : synthesiser.getReferencedRelations(query.getOperation())) {
+                out << "CREATE_OP_CONTEXT(" << synthesiser.getOpContextName(*rel) << ","
+                    << synthesiser.getRelationName(*rel);
+                if (rel->getRepresentation() == RelationRepresentation::BRIE ||
+                        rel->getRepresentation() == RelationRepresentation::COMPRESSED ||
+                        hasBufferedProjection(query, *rel)) {
+                    out << "->createBufferedContext());\n";
+                } else {
+                    out << "->createContext());\n";
+                }
+            }
+            out << "pfor(int part = 0; part < int(join.getNumPartitions()); ++part) {\n";
+            out << "try{\n";
+            out << "join.forEachMatch(part, [&](const " << outerType << "& " << outerEnv << ", const "
+                << innerType << "& " << innerEnv << ") {\n";
+            out << "(void)" << outerEnv << ";\n";
+            out << "(void)" << innerEnv << ";\n";
+            visitNestedOperation(iscan, out);
+            out << "});\n";
+            out << "} catch(std::exception &e) { SignalHandler::instance()->error(e.what());}\n";
+            out << "}\n";
+            out << "PARALLEL_END;\n";
+            if (guard != nullptr) {
+                out << "}\n";
+            }
+            out << "} else {\n";
+        }
+
+        /** the aggregates of the current query whose groups are computed ahead of its loop nest */
+        std::set<const RamIndexAggregate*> groupedAggregates;
+
+        /** Print the initial value of the result of an aggregate */
+        static std::string getAggregateInit(const RamAbstractAggregate& aggregate) {
+            switch (aggregate.getFunction()) {
+                case souffle::MIN:
+                    return "MAX_RAM_DOMAIN";
+                case souffle::MAX:
+                    return "MIN_RAM_DOMAIN";
+                case souffle::COUNT:
+                case souffle::SUM:
+                    return "0";
+                default:
+                    abort();
+            }
+        }
+
+        /**
+         * Check whether an aggregate counts a range of a b-tree index or of the classes of an equivalence
+         * relation, which the index counts itself
+         */
+        bool isCountedRange(const RamIndexAggregate& aggregate, SearchSignature keys) {
+            if (aggregate.getFunction() != souffle::COUNT || keys == 0 ||
+                    dynamic_cast<const RamTrue*>(&aggregate.getCondition()) == nullptr) {
+                return false;
+            }
+            const auto& rel = aggregate.getRelation();
+            auto relationType = SynthesiserRelation::getSynthesiserRelation(
+                    rel, isa->getIndexes(rel), rel.hasProvenanceColumns());
+            if (dynamic_cast<const SynthesiserDirectRelation*>(relationType.get()) != nullptr ||
+                    dynamic_cast<const SynthesiserEqrelRelation*>(relationType.get()) != nullptr) {
+                return true;
+            }
+            const auto* brie = dynamic_cast<const SynthesiserBrieRelation*>(relationType.get());
+            return brie != nullptr && brie->countsRanges();
+        }
+
+        /**
+         * Check whether the groups of an aggregate can be computed by a single pass over its relation,
+         * which requires its condition and expression to depend on nothing but the aggregated tuple and
+         * to be safe to evaluate for tuples of groups never looked up
+         */
+        static bool isGroupable(const RamIndexAggregate& aggregate, SearchSignature keys) {
+            if (keys == 0) {
+                return false;
+            }
+            bool groupable = true;
+            auto check = [&](const RamNode& node) {
+                if (const auto* elem = dynamic_cast<const RamTupleElement*>(&node)) {
+                    groupable = groupable && elem->getTupleId() == aggregate.getTupleId();
+                } else if (const auto* op = dynamic_cast<const RamIntrinsicOperator*>(&node)) {
+                    auto fun = op->getOperator();
+                    groupable = groupable && fun != FunctorOp::DIV && fun != FunctorOp::MOD &&
+                                fun != FunctorOp::TONUMBER && fun != FunctorOp::SUBSTR;
+                } else if (const auto* constraint = dynamic_cast<const RamConstraint*>(&node)) {
+                    auto cop = constraint->getOperator();
+                    groupable = groupable && cop != BinaryConstraintOp::MATCH &&
+                                cop != BinaryConstraintOp::NOT_MATCH;
+                } else if (dynamic_cast<const RamNumber*>(&node) == nullptr &&
+                           dynamic_cast<const RamUndefValue*>(&node) == nullptr &&
+                           dynamic_cast<const RamTrue*>(&node) == nullptr &&
+                           dynamic_cast<const RamConjunction*>(&node) == nullptr &&
+                           dynamic_cast<const RamNegation*>(&node) == nullptr) {
+                    groupable = false;
+                }
+            };
+            visitDepthFirst(aggregate.getCondition(), check);
+            visitDepthFirst(aggregate.getExpression(), check);
+            return groupable;
+        }
+
+        /**
+         * Print the computation of the groups of the aggregates nested in the loop nest of a query,
+         * in parallel and only where the outer loop iterates over at least as many tuples as the
+         * aggregated relation holds, such that the pass over the relation pays off
+         */
+        void printAggregateGroups(const RamOperation& op, std::ostream& out) {
+            groupedAggregates.clear();
+            const RamRelationOperation* outer = nullptr;
+            visitDepthFirst(op, [&](const RamRelationOperation& cur) {
+                if (outer == nullptr) {
+                    outer = &cur;
+                }
+            });
+            visitDepthFirst(op, [&](const RamIndexAggregate& aggregate) {
+                auto keys = isa->getSearchSignature(&aggregate);
+                if (&aggregate == outer || !isGroupable(aggregate, keys) || isCountedRange(aggregate, keys)) {
+                    return;
+                }
+                groupedAggregates.insert(&aggregate);
+
+                const auto& rel = aggregate.getRelation();
+                auto relName = synthesiser.getRelationName(rel);
+                auto identifier = aggregate.getTupleId();
+                auto init = getAggregateInit(aggregate);
+                std::vector<size_t> columns;
+                for (size_t i = 0; i < rel.getArity(); i++) {
+                    if (!isRamUndefValue(aggregate.getRangePattern()[i])) {
+                        columns.push_back(i);
+                    }
+                }
+
+                out << "AggregateGroups<" << columns.size() << "> groups" << identifier << ";\n";
+                out << "if(" << synthesiser.getRelationName(outer->getRelation()) << "->size() >= " << relName
+                    << "->size()) {\n";
+                out << "auto part = " << relName << "->partition();\n";
+                out << "souffle::StealingRanges<decltype(part)> ranges(part);\n";
+                out << "souffle::ParallelRegion parallelRegion(part);\n";
+                out << "PARALLEL_START_SIZED(parallelRegion.getTeamSize());\n";
+                out << "AggregateGroups<" << columns.size() << "> partial;\n";
+                out << "for(decltype(ranges)::Cursor cursor(ranges); cursor.next();) {\n";
+                out << "const auto& env" << identifier << " = cursor.get();\n";
+                out << "if( ";
+                visit(aggregate.getCondition(), out);
+                out << ") {\n";
+                out << "RamDomain& res = partial.get({{";
+                for (size_t i = 0; i < columns.size(); i++) {
+                    out << (i > 0 ? "," : "") << "env" << identifier << "[" << columns[i] << "]";
+                }
+                out << "}}, " << init << ");\n";
+                switch (aggregate.getFunction()) {
+                    case souffle::MIN:
+                        out << "res = std::min(res, (RamDomain)(";
+                        visit(aggregate.getExpression(), out);
+                        out << "));\n";
+                        break;
+                    case souffle::MAX:
+                        out << "res = std::max(res, (RamDomain)(";
+                        visit(aggregate.getExpression(), out);
+                        out << "));\n";
+                        break;
+                    case souffle::COUNT:
+                        out << "++res;\n";
+                        break;
+                    case souffle::SUM:
+                        out << "res += ";
+                        visit(aggregate.getExpression(), out);
+                        out << ";\n";
+                        break;
+                    default:
+                        abort();
+                }
+                out << "}\n";
+                out << "}\n";
+                // the partial counts of a group add up just like its partial sums
+                out << "groups" << identifier << ".merge(partial, [](RamDomain a, RamDomain b) { return ";
+                switch (aggregate.getFunction()) {
+                    case souffle::MIN:
+                        out << "std::min(a, b)";
+                        break;
+                    case souffle::MAX:
+                        out << "std::max(a, b)";
+                        break;
+                    default:
+                        out << "a + b";
+                }
+                out << "; });\n";
+                out << "PARALLEL_END;\n";
+                out << "groups" << identifier << ".complete();\n";
+                out << "}\n";
+            });
+        }
+
+        /**
+         * A scan over the pairs of an equivalence relation whose filters directly below the scan test
+         * at most one column of the pairs, the key column, while the rest of its loop nest refers only
+         * to the other column. It is evaluated through the classes of the relation: the members of a
+         * class are tested once each, and if one passes, the rest is run once per member of the class,
+         * rather than once per pair of the class.
+         */
+        struct ClassJoin {
+            /** the filters testing the key column */
+            std::vector<const RamFilter*> keyFilters;
+        };
+
+        /** the filters of the class joins being printed, tested ahead of the members of the classes */
+        std::set<const RamFilter*> classKeyFilters;
+
+        /** Check whether a scan is evaluated as a class join, obtaining its key filters if so */
+        bool getClassJoin(const RamRelationOperation& loop, ClassJoin& join) {
+            const auto* scan = dynamic_cast<const RamScan*>(&loop);
+            const auto& rel = loop.getRelation();
+            if (scan == nullptr || rel.getRepresentation() != RelationRepresentation::EQREL ||
+                    rel.getArity() != 2 || sampleRule != 0) {
+                return false;
+            }
+            auto relationType = SynthesiserRelation::getSynthesiserRelation(
+                    rel, isa->getIndexes(rel), rel.hasProvenanceColumns());
+            if (dynamic_cast<const SynthesiserEqrelRelation*>(relationType.get()) == nullptr) {
+                return false;
+            }
+
+            // the columns of the scanned pairs a node refers to
+            auto getColumns = [&](const RamNode& node) {
+                std::set<size_t> res;
+                visitDepthFirst(node, [&](const RamTupleElement& elem) {
+                    if (elem.getTupleId() == scan->getTupleId()) {
+                        res.insert(elem.getElement());
+                    }
+                });
+                return res;
+            };
+
+            // the filters directly below the scan, and the rest of the loop nest, which must not leave
+            // the loop over the pairs early as the loop over the members of a class takes its place
+            std::vector<const RamFilter*> filters;
+            const RamOperation* rest = &scan->getOperation();
+            while (const auto* filter = dynamic_cast<const RamFilter*>(rest)) {
+                filters.push_back(filter);
+                rest = &filter->getOperation();
+            }
+            bool breaks = false;
+            visitDepthFirst(*rest, [&](const RamBreak&) { breaks = true; });
+            if (breaks) {
+                return false;
+            }
+
+            // as the relation is symmetric, either column may serve as the key
+            const std::set<size_t> restColumns = getColumns(*rest);
+            for (size_t key : {1, 0}) {
+                if (restColumns.count(key) != 0) {
+                    continue;
+                }
+                join.keyFilters.clear();
+                bool separable = true;
+                for (const RamFilter* filter : filters) {
+                    const std::set<size_t> columns = getColumns(filter->getCondition());
+                    if (columns.count(key) != 0) {
+                        separable = separable && columns.count(1 - key) == 0;
+                        join.keyFilters.push_back(filter);
+                    }
+                }
+                if (separable) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Print the body of a class join for the class <cls>, binding the scanned pair to a member
+         * paired with itself; the key filters see the members tested and the rest the members visited
+         */
+        void printClassJoin(const RamRelationOperation& loop, const ClassJoin& classJoin,
+                const std::string& cls, std::ostream& out) {
+            auto id = loop.getTupleId();
+            const auto& keyFilters = classJoin.keyFilters;
+            if (!keyFilters.empty()) {
+                out << "bool found" << id << " = false;\n";
+                out << "for(RamDomain key" << id << " : " << cls << ") {\n";
+                out << "const Tuple<RamDomain,2> env" << id << "({{key" << id << ",key" << id << "}});\n";
+                out << "if(";
+                out << join(keyFilters, " && ", [&](std::ostream& out, const RamFilter* filter) {
+                    out << "(";
+                    visit(filter->getCondition(), out);
+                    out << ")";
+                });
+                out << ") {\n";
+                out << "found" << id << " = true;\n";
+                out << "break;\n";
+                out << "}\n";
+                out << "}\n";
+                out << "if(found" << id << ") {\n";
+            }
+            out << "for(RamDomain member" << id << " : " << cls << ") {\n";
+            out << "const Tuple<RamDomain,2> env" << id << "({{member" << id << ",member" << id << "}});\n";
+            classKeyFilters.insert(keyFilters.begin(), keyFilters.end());
+            visitTupleOperation(loop, out);
+            out << "}\n";
+            if (!keyFilters.empty()) {
+                out << "}\n";
+            }
+        }
+
+        /** Print the loop over the chunks of partition <part> shared by the threads of a parallel region */
+        void printParallelLoop(const RamRelationOperation& loop, std::ostream& out) {
+            out << "souffle::StealingRanges<decltype(part)> ranges(part);\n";
+            out << "souffle::ParallelRegion parallelRegion(part);\n";
+            out << "PARALLEL_START_SIZED(parallelRegion.getTeamSize());\n";
+            out << preamble.str();
+            out << "try{\n";
+            out << "for(decltype(ranges)::Cursor cursor(ranges); cursor.next();) {\n";
+
+            // the chunks of class joins hold classes
+            ClassJoin classJoin;
+            if (getClassJoin(loop, classJoin)) {
+                out << "const auto& cls" << loop.getTupleId() << " = cursor.get();\n";
+                printClassJoin(loop, classJoin, "cls" + std::to_string(loop.getTupleId()), out);
+                out << "}\n";
+                out << "} catch(std::exception &e) { SignalHandler::instance()->error(e.what());}\n";
+                return;
+            }
+
+            out << "const auto& env" << loop.getTupleId() << " = cursor.get();\n";
+            if (const auto* iscan = dynamic_cast<const RamIndexScan*>(&loop)) {
+                printIndexScanCount(loop.getRelation(), isa->getSearchSignature(iscan), true, out);
+            }
+
+            visitTupleOperation(loop, out);
+
+            out << "}\n";
+            out << "} catch(std::exception &e) { SignalHandler::instance()->error(e.what());}\n";
+        }
+
+        /**
+         * Print the evaluation of an outer parallel loop providing too few tuples for the threads,
+         * iterating over the tuples sequentially and over those of the nested loop in parallel. The
+         * partition <part> of the outer loop is cleared, leaving no work to the parallel loop over it.
+         */
+        void printNestedParallel(
+                const RamRelationOperation& loop, const std::string& tuples, std::ostream& out) {
+            const RamRelationOperation* nested = getNestedParallelLoop(loop);
+            if (nested == nullptr) {
+                return;
+            }
+            out << "if (souffle::isSmallPartition(part)) {\n";
+            out << preamble.str();
+            out << "for(const auto& env" << loop.getTupleId() << " : " << tuples << ") {\n";
+            if (const auto* iscan = dynamic_cast<const RamIndexScan*>(&loop)) {
+                printIndexScanCount(loop.getRelation(), isa->getSearchSignature(iscan), true, out);
+            }
+
+            nestedParallel = nested;
+            visitTupleOperation(loop, out);
+            nestedParallel = nullptr;
+
+            out << "}\n";
+            if (preambleConditional) {
+                out << "}\n";
+            }
+            out << "part.clear();\n";
+            out << "}\n";
+        }
+
+        /**
+         * Print the range of an index scan bounding a column, taken from the index ordering the bound
+         * columns of its key first and the bounded column next, with the given context if any
+         */
+        void printBoundedRange(const RamIndexScan& iscan, const std::string& ctxName, std::ostream& out) {
+            const auto& rel = iscan.getRelation();
+            const auto& rangePattern = iscan.getRangePattern();
+            const int column = iscan.getRangeColumn();
+            auto indNum = isa->getIndexes(rel).getOrderedLexOrderNum(
+                    isa->getSearchSignature(&iscan), column);
+            out << "Tuple<RamDomain," << rel.getArity() << "> low(key);\n";
+            out << "Tuple<RamDomain," << rel.getArity() << "> high(key);\n";
+            for (size_t i = 0; i < rel.getArity(); i++) {
+                if (isRamUndefValue(rangePattern[i])) {
+                    out << "low[" << i << "] = MIN_RAM_DOMAIN;\n";
+                    out << "high[" << i << "] = MAX_RAM_DOMAIN;\n";
+                }
+            }
+            if (!isRamUndefValue(&iscan.getLowerBound())) {
+                out << "low[" << column << "] = ";
+                visit(iscan.getLowerBound(), out);
+                out << ";\n";
+            }
+            if (!isRamUndefValue(&iscan.getUpperBound())) {
+                out << "high[" << column << "] = ";
+                visit(iscan.getUpperBound(), out);
+                out << ";\n";
+            }
+            out << "auto range = " << synthesiser.getRelationName(rel) << "->boundedRange_" << indNum
+                << "(low,high" << (ctxName.empty() ? "" : "," + ctxName) << ");\n";
+        }
+
+        /** Print the counting of a range scan, or of a tuple delivered by it, if indexes are profiled */
+        /**
+         * Declare memos in the preamble of a query for its index probes likely to search for the same
+         * key as their predecessor, which reuse its result then; the probed relations must be stored in
+         * b-trees and not be modified by the query
+         */
+        void printProbeMemos(const RamQuery& query) {
+            probeMemos.clear();
+            if (Global::config().has("profile") || Global::config().has("profile-indexes")) {
+                return;
+            }
+            std::set<const RamRelation*> modified;
+            visitDepthFirst(
+                    query, [&](const RamProject& project) { modified.insert(&project.getRelation()); });
+            const auto* level = synthesiser.getTranslationUnit().getAnalysis<RamLevelAnalysis>();
+            auto declare = [&](const RamNode& probe, const RamRelation& rel,
+                                   const std::vector<RamExpression*>& key, SearchSignature keys,
+                                   bool isRange) {
+                if (keys == 0 || !isDirect(rel) || modified.count(&rel) > 0 ||
+                        !level->isRepeatedKey(query, probe, key)) {
+                    return;
+                }
+                const std::string name = "probeMemo" + std::to_string(probeMemos.size());
+                const std::string tuple = "Tuple<RamDomain," + std::to_string(rel.getArity()) + ">";
+                preamble << "ProbeMemo<" << tuple << ",";
+                if (isRange) {
+                    preamble << "decltype(" << synthesiser.getRelationName(rel) << "->equalRange_" << keys
+                             << "(std::declval<const " << tuple << "&>()))";
+                } else {
+                    preamble << "bool";
+                }
+                preamble << "> " << name << ";\n";
+                probeMemos[&probe] = name;
+            };
+            visitDepthFirst(query, [&](const RamIndexScan& iscan) {
+                if (dynamic_cast<const RamAbstractParallel*>(&iscan) == nullptr && !iscan.hasRange()) {
+                    declare(iscan, iscan.getRelation(), iscan.getRangePattern(),
+                            isa->getSearchSignature(&iscan), true);
+                }
+            });
+            visitDepthFirst(query, [&](const RamExistenceCheck& exists) {
+                declare(exists, exists.getRelation(), exists.getValues(), isa->getSearchSignature(&exists),
+                        false);
+            });
+        }
+
+        /**
+         * A parallel choice needs a single qualifying tuple, hence its workers share a flag claimed
+         * by the first worker finding one, which the others check before each chunk of their loop.
+         */
+        void printChoiceFlag(std::ostream& out) {
+            out << "std::atomic<bool> chosen(false);\n";
+        }
+
+        void printChoiceCheck(std::ostream& out) {
+            out << "if (chosen.load(std::memory_order_relaxed)) continue;\n";
+        }
+
+        /** Evaluate the nested operation of a parallel choice for the tuple of the worker claiming it */
+        void printChoiceClaim(const RamTupleOperation& choice, std::ostream& out) {
+            out << "if (!chosen.exchange(true)) {\n";
+            visitTupleOperation(choice, out);
+            out << "}\n";
+        }
+
+        void printIndexScanCount(
+                const RamRelation& rel, SearchSignature keys, bool tuple, std::ostream& out) {
+            if (Global::config().has("profile-indexes")) {
+                // the counters of an index are its probes, empty probes, scans and tuples
+                out << "indexStats[" << synthesiser.lookupIndexStatsIdx(rel, keys) << "][" << (tuple ? 3 : 2)
+                    << "]++;\n";
+            }
+        }
+
     public:
         CodeEmitter(Synthesiser& syn)
                 : synthesiser(syn), isa(syn.getTranslationUnit().getAnalysis<RamIndexAnalysis>()) {
@@ -230,28 +1171,17 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
         void visitLoad(const RamLoad& load, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
             out << "if (performIO) {\n";
-            std::vector<bool> symbolMask;
-            for (auto& cur : load.getRelation().getAttributeTypeQualifiers()) {
-                symbolMask.push_back(cur[0] == 's');
+            if (Global::config().has("trace")) {
+                out << "TraceLog::Span span(R\"_(load " << load.getRelation().getName() << ")_\", \"io\");\n";
             }
-            // get some table details
-            for (IODirectives ioDirectives : load.getIODirectives()) {
-                out << "try {";
-                out << "std::map<std::string, std::string> directiveMap(";
-                out << ioDirectives << ");\n";
-                out << R"_(if (!inputDirectory.empty() && directiveMap["IO"] == "file" && )_";
-                out << "directiveMap[\"filename\"].front() != '/') {";
-                out << R"_(directiveMap["filename"] = inputDirectory + "/" + directiveMap["filename"];)_";
-                out << "}\n";
-                out << "IODirectives ioDirectives(directiveMap);\n";
-                out << "IOSystem::getInstance().getReader(";
-                out << "std::vector<bool>({" << join(symbolMask) << "})";
-                out << ", symTable, ioDirectives";
-                out << ", " << (Global::config().has("provenance") ? "true" : "false");
-                out << ")->readAll(*" << synthesiser.getRelationName(load.getRelation());
-                out << ");\n";
-                out << "} catch (std::exception& e) {std::cerr << \"Error loading data: \" << e.what() << "
-                       "'\\n';}\n";
+            synthesiser.emitLoad(out, load,
+                    Global::config().has("prefetch-input") ? LoadMode::INSERT_PREFETCHED : LoadMode::READ);
+            if (Global::config().has("trace")) {
+                out << "span.set(\"tuples\", " << synthesiser.getRelationName(load.getRelation())
+                    << "->size());\n";
+            }
+            if (Global::config().has("statistics")) {
+                synthesiser.emitCollectStatistics(out, load.getRelation());
             }
             out << "}\n";
             PRINT_END_COMMENT(out);
@@ -259,7 +1189,14 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
         void visitStore(const RamStore& store, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
+            const bool async = Global::config().has("async-output");
+            const std::string relName = synthesiser.getRelationName(store.getRelation());
             out << "if (performIO) {\n";
+            if (Global::config().has("trace")) {
+                out << "TraceLog::Span span(R\"_(store " << store.getRelation().getName()
+                    << ")_\", \"io\");\n";
+                out << "span.set(\"tuples\", " << relName << "->size());\n";
+            }
             std::vector<bool> symbolMask;
             for (auto& cur : store.getRelation().getAttributeTypeQualifiers()) {
                 symbolMask.push_back(cur[0] == 's');
@@ -267,17 +1204,27 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
             for (IODirectives ioDirectives : store.getIODirectives()) {
                 out << "try {";
                 out << "std::map<std::string, std::string> directiveMap(" << ioDirectives << ");\n";
-                out << R"_(if (!outputDirectory.empty() && directiveMap["IO"] == "file" && )_";
+                out << R"_(if (!outputDirectory.empty() && )_";
+                out << R"_(IODirectives::isFileType(directiveMap["IO"]) && )_";
                 out << "directiveMap[\"filename\"].front() != '/') {";
                 out << R"_(directiveMap["filename"] = outputDirectory + "/" + directiveMap["filename"];)_";
                 out << "}\n";
                 out << "IODirectives ioDirectives(directiveMap);\n";
+                // the relations of completed strata are not modified, and written while evaluation goes on
+                if (async) {
+                    out << "writeQueue.submit(&*" << relName << ", [this, ioDirectives]() {\n";
+                    out << "try {";
+                }
                 out << "IOSystem::getInstance().getWriter(";
                 out << "std::vector<bool>({" << join(symbolMask) << "})";
-                out << ", symTable, ioDirectives";
-                out << ", " << (Global::config().has("provenance") ? "true" : "false");
-                out << ")->writeAll(*" << synthesiser.getRelationName(store.getRelation()) << ");\n";
+                out << ", " << synthesiser.getSymbolTableName(store.getRelation()) << ", ioDirectives";
+                out << ", " << (store.getRelation().hasProvenanceColumns() ? "true" : "false");
+                out << ")->writeAll(*" << relName << ");\n";
                 out << "} catch (std::exception& e) {std::cerr << e.what();exit(1);}\n";
+                if (async) {
+                    out << "});\n";
+                    out << "} catch (std::exception& e) {std::cerr << e.what();exit(1);}\n";
+                }
             }
             out << "}\n";
             PRINT_END_COMMENT(out);
@@ -286,6 +1233,13 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
         void visitQuery(const RamQuery& query, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
 
+            // large relations are joined in bulk, falling back to the loop nest for small ones
+            probeMemos.clear();
+            const RamIndexScan* bulkJoin = getBulkJoin(query);
+            if (bulkJoin != nullptr) {
+                printBulkJoin(query, *bulkJoin, out);
+            }
+
             // split terms of conditions of outer filter operation
             // into terms that require a context and terms that
             // do not require a context
@@ -325,21 +1279,63 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
             // enclose operation in its own scope
             out << "{\n";
 
+            printAggregateGroups(*next, out);
+
             // check whether loop nest can be parallelized
             bool isParallel = false;
             visitDepthFirst(*next, [&](const RamAbstractParallel& node) { isParallel = true; });
 
+            // keep the local records of sequential queries in an arena released with the scope
+            const auto* escape = synthesiser.getTranslationUnit().getAnalysis<RamRecordEscapeAnalysis>();
+            localRecords = false;
+            if (!isParallel) {
+                visitDepthFirst(*next, [&](const RamPackRecord& pack) {
+                    localRecords = localRecords || escape->isLocal(pack);
+                });
+            }
+            if (localRecords) {
+                out << "RecordArena localRecords;\n";
+            }
+
             // reset preamble
             preamble.str("");
             preamble.clear();
             preambleIssued = false;
+            preambleConditional = isParallel && requireCtx.size() > 0;
+
+            // determine relations read by this operation
+            std::set<const RamRelation*> readRelations;
+            visitDepthFirst(query, [&](const RamNode& node) {
+                if (auto scan = dynamic_cast<const RamRelationOperation*>(&node)) {
+                    readRelations.insert(&scan->getRelation());
+                } else if (auto exists = dynamic_cast<const RamAbstractExistenceCheck*>(&node)) {
+                    readRelations.insert(&exists->getRelation());
+                } else if (auto emptiness = dynamic_cast<const RamEmptinessCheck*>(&node)) {
+                    readRelations.insert(&emptiness->getRelation());
+                } else if (auto check = dynamic_cast<const RamSizeCheck*>(&node)) {
+                    readRelations.insert(&check->getRelation());
+                } else if (auto intersect = dynamic_cast<const RamIntersect*>(&node)) {
+                    for (size_t i = 0; i < intersect->getNumParticipants(); i++) {
+                        readRelations.insert(&intersect->getRelation(i));
+                    }
+                }
+            });
 
             // create operation contexts for this operation
             for (const RamRelation* rel : synthesiser.getReferencedRelations(query.getOperation())) {
                 preamble << "CREATE_OP_CONTEXT(" << synthesiser.getOpContextName(*rel);
                 preamble << "," << synthesiser.getRelationName(*rel);
-                preamble << "->createContext());\n";
+                // threads of parallel operations buffer insertions into relations they do not read
+                if (isParallel && readRelations.count(rel) == 0 &&
+                        (rel->getRepresentation() == RelationRepresentation::BRIE ||
+                                rel->getRepresentation() == RelationRepresentation::COMPRESSED ||
+                                hasBufferedProjection(query, *rel))) {
+                    preamble << "->createBufferedContext());\n";
+                } else {
+                    preamble << "->createContext());\n";
+                }
             }
+            printProbeMemos(query);
 
             // discharge conditions that require a context
             if (isParallel) {
@@ -380,6 +1376,10 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
             if (freeOfCtx.size() > 0) {
                 out << "}\n";
             }
+            if (bulkJoin != nullptr) {
+                out << "}\n";
+            }
+            localRecords = false;
 
             PRINT_END_COMMENT(out);
         }
@@ -391,26 +1391,78 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
                     << "extend("
                     << "*" << synthesiser.getRelationName(merge.getTargetRelation()) << ");\n";
             }
+            // append buffers are sorted and freed of duplicates before being merged
+            if (synthesiser.appendBuffers.count(merge.getSourceRelation().getName()) != 0) {
+                out << synthesiser.getRelationName(merge.getSourceRelation()) << "->consolidate();\n";
+            }
+            // the source is cleared next, thus its nodes may be moved instead of being copied
+            const bool absorbs = synthesiser.absorbingMerges.count(&merge) != 0;
             out << synthesiser.getRelationName(merge.getTargetRelation()) << "->"
-                << "insertAll("
-                << "*" << synthesiser.getRelationName(merge.getSourceRelation()) << ");\n";
+                << (absorbs ? "absorb(" : "insertAll(") << "*"
+                << synthesiser.getRelationName(merge.getSourceRelation()) << ");\n";
+            PRINT_END_COMMENT(out);
+        }
+
+        void visitTransitiveClosure(const RamTransitiveClosure& closure, std::ostream& out) override {
+            PRINT_BEGIN_COMMENT(out);
+            const auto& target = closure.getTargetRelation();
+            const std::string trgName = synthesiser.getRelationName(target);
+            out << "{\n";
+            out << "souffle::TransitiveClosure closure;\n";
+            out << "for(const auto& env0 : *" << synthesiser.getRelationName(closure.getSourceRelation())
+                << ") {\n";
+            out << "closure.addEdge(env0[0],env0[1]);\n";
+            out << "}\n";
+            // the closure is inserted in the order of the tuples, such that the hints of the context apply
+            out << "CREATE_OP_CONTEXT(" << synthesiser.getOpContextName(target) << "," << trgName
+                << "->createContext());\n";
+            out << "closure.compute([&](RamDomain from, const std::vector<RamDomain>& reached) {\n";
+            out << "for(RamDomain to : reached) {\n";
+            out << "Tuple<RamDomain,2> tuple({{from,to}});\n";
+            out << trgName << "->insert(tuple,READ_OP_CONTEXT(" << synthesiser.getOpContextName(target)
+                << "));\n";
+            out << "}\n";
+            out << "});\n";
+            out << "}\n";
             PRINT_END_COMMENT(out);
         }
 
         void visitClear(const RamClear& clear, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
+            // b-trees cleared in each iteration of a loop keep their nodes for the next one
+            const bool recycle = loopDepth > 0 && isDirect(clear.getRelation());
             out << synthesiser.getRelationName(clear.getRelation()) << "->"
-                << "purge();\n";
+                << (recycle ? "reset();\n" : "purge();\n");
             PRINT_END_COMMENT(out);
         }
 
         void visitDrop(const RamDrop& drop, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
 
+            if (Global::config().has("profile")) {
+                out << "ProfileEventSingleton::instance().makeRelationMemoryEvents(memoryStratum, R\"_("
+                    << drop.getRelation().getName() << ")_\", "
+                    << synthesiser.getRelationName(drop.getRelation()) << "->getMemoryUsage());\n";
+            }
+            const std::string relName = synthesiser.getRelationName(drop.getRelation());
             out << "if (!isHintsProfilingEnabled()"
                 << (drop.getRelation().isTemp() ? ") " : "&& performIO) ");
-            out << synthesiser.getRelationName(drop.getRelation()) << "->"
-                << "purge();\n";
+            // the private symbols of a relation are released along with it
+            std::string purge = relName + "->purge();";
+            if (Global::config().has("statistics") && !drop.getRelation().isTemp()) {
+                std::stringstream collect;
+                synthesiser.emitCollectStatistics(collect, drop.getRelation());
+                purge = collect.str() + purge;
+            }
+            if (synthesiser.getSymbolTableName(drop.getRelation()) != "symTable") {
+                purge += synthesiser.getSymbolTableName(drop.getRelation()) + " = SymbolTable();";
+            }
+            if (Global::config().has("async-output")) {
+                // a relation being written is purged once written
+                out << "writeQueue.release(&*" << relName << ", [this]() {" << purge << "});\n";
+            } else {
+                out << "{" << purge << "}\n";
+            }
 
             PRINT_END_COMMENT(out);
         }
@@ -423,16 +1475,50 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
             PRINT_END_COMMENT(out);
         }
 
+        void visitLogDistinctValues(const RamLogDistinctValues& distinct, std::ostream& out) override {
+            PRINT_BEGIN_COMMENT(out);
+            out << "ProfileEventSingleton::instance().makeDistinctValuesEvents({";
+            out << join(distinct.getMessages(), ",", [](std::ostream& os, const std::string& msg) {
+                os << "R\"(" << msg << ")\"";
+            });
+            out << "},*" << synthesiser.getRelationName(distinct.getRelation()) << ",iter);";
+            PRINT_END_COMMENT(out);
+        }
+
         // -- control flow statements --
 
         void visitSequence(const RamSequence& seq, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
             for (const auto& cur : seq.getStatements()) {
-                visit(cur, out);
+                visitScheduled(*cur, out);
             }
             PRINT_END_COMMENT(out);
         }
 
+        /** Emit a statement of a loop body, skipped while all relations of its guard are empty */
+        void visitScheduled(const RamStatement& stmt, std::ostream& out) {
+            const auto& guard =
+                    synthesiser.getTranslationUnit().getAnalysis<RamLoopScheduleAnalysis>()->getGuard(stmt);
+            if (guard.empty()) {
+                visit(stmt, out);
+                return;
+            }
+            out << "if(!(";
+            out << join(guard, " && ", [&](std::ostream& os, const RamRelation* rel) {
+                os << synthesiser.getRelationName(*rel) << "->empty()";
+            });
+            out << ")) {\n";
+            visit(stmt, out);
+            out << "}\n";
+        }
+
+        void visitPlanSwitch(const RamPlanSwitch& planSwitch, std::ostream& out) override {
+            // join orders are not adapted at runtime; use the statically chosen one
+            PRINT_BEGIN_COMMENT(out);
+            visit(planSwitch.getStatements().front(), out);
+            PRINT_END_COMMENT(out);
+        }
+
         void visitParallel(const RamParallel& parallel, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
             auto stmts = parallel.getStatements();
@@ -445,7 +1531,7 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
             // a single statement => save the overhead
             if (stmts.size() == 1) {
-                visit(stmts[0], out);
+                visitScheduled(*stmts[0], out);
                 PRINT_END_COMMENT(out);
                 return;
             }
@@ -458,7 +1544,7 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
             // put each thread in another section
             for (const auto& cur : stmts) {
                 out << "SECTION_START;\n";
-                visit(cur, out);
+                visitScheduled(*cur, out);
                 out << "SECTION_END\n";
             }
 
@@ -471,8 +1557,11 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
             PRINT_BEGIN_COMMENT(out);
             out << "iter = 0;\n";
             out << "for(;;) {\n";
+            loopDepth++;
             visit(loop.getBody(), out);
+            loopDepth--;
             out << "iter++;\n";
+            out << "if (ResourceLimits::instance().check()) evictIndexes();\n";
             out << "}\n";
             out << "iter = 0;\n";
             PRINT_END_COMMENT(out);
@@ -522,10 +1611,19 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
             const std::string ext = fileExtension(Global::config().get("profile"));
 
-            // create local timer
-            out << "\tLogger logger(R\"_(" << timer.getMessage() << ")_\",iter);\n";
-            // insert statement to be measured
-            visit(timer.getStatement(), out);
+            if (LogStatement::isSample(timer.getMessage())) {
+                // mark the rule for the sampling profiler instead of timing it
+                sampleRule = synthesiser.lookupSampleIdx(timer.getMessage());
+                printSamplePosition(0, out);
+                visit(timer.getStatement(), out);
+                out << "SampleProfiler::setPosition(0);\n";
+                sampleRule = 0;
+            } else {
+                // create local timer
+                out << "\tLogger logger(R\"_(" << timer.getMessage() << ")_\",iter);\n";
+                // insert statement to be measured
+                visit(timer.getStatement(), out);
+            }
 
             // done
             out << "}\n";
@@ -559,6 +1657,9 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
         void visitTupleOperation(const RamTupleOperation& search, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
+            if (sampleRule != 0) {
+                printSamplePosition(search.getTupleId() + 1, out);
+            }
             visitNestedOperation(search, out);
             PRINT_END_COMMENT(out);
         }
@@ -576,18 +1677,17 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
             PRINT_BEGIN_COMMENT(out);
 
-            out << "auto part = " << relName << "->partition();\n";
-            out << "PARALLEL_START;\n";
-            out << preamble.str();
-            out << "pfor(auto it = part.begin(); it<part.end();++it){\n";
-            out << "try{\n";
-            out << "for(const auto& env0 : *it) {\n";
-
-            visitTupleOperation(pscan, out);
+            ClassJoin classJoin;
+            if (getClassJoin(pscan, classJoin)) {
+                out << "auto part = " << relName << "->partitionClasses();\n";
+                printParallelLoop(pscan, out);
+                PRINT_END_COMMENT(out);
+                return;
+            }
 
-            out << "}\n";
-            out << "} catch(std::exception &e) { SignalHandler::instance()->error(e.what());}\n";
-            out << "}\n";
+            out << "auto part = " << relName << "->partition();\n";
+            printNestedParallel(pscan, "*" + relName, out);
+            printParallelLoop(pscan, out);
 
             PRINT_END_COMMENT(out);
         }
@@ -601,6 +1701,36 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
             assert(rel.getArity() > 0 && "AstTranslator failed/no scans for nullaries");
 
+            ClassJoin classJoin;
+            const bool joinsClasses = getClassJoin(scan, classJoin);
+
+            if (&scan == nestedParallel) {
+                nestedParallel = nullptr;
+                out << "auto part = " << relName << "->" << (joinsClasses ? "partitionClasses" : "partition")
+                    << "();\n";
+                printParallelLoop(scan, out);
+                if (preambleConditional) {
+                    out << "}\n";
+                }
+                out << "PARALLEL_END;\n";
+                PRINT_END_COMMENT(out);
+                return;
+            }
+
+            if (const RamIndexScan* iscan = getBatchedProbe(scan)) {
+                printBatchedProbe(scan, *iscan, out);
+                PRINT_END_COMMENT(out);
+                return;
+            }
+
+            if (joinsClasses) {
+                out << "for(const auto& cls" << id << " : " << relName << "->classes()) {\n";
+                printClassJoin(scan, classJoin, "cls" + std::to_string(id), out);
+                out << "}\n";
+                PRINT_END_COMMENT(out);
+                return;
+            }
+
             out << "for(const auto& env" << id << " : "
                 << "*" << relName << ") {\n";
 
@@ -651,9 +1781,12 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
             PRINT_BEGIN_COMMENT(out);
 
             out << "auto part = " << relName << "->partition();\n";
-            out << "PARALLEL_START;\n";
+            out << "souffle::ParallelRegion parallelRegion(part);\n";
+            printChoiceFlag(out);
+            out << "PARALLEL_START_SIZED(parallelRegion.getTeamSize());\n";
             out << preamble.str();
             out << "pfor(auto it = part.begin(); it<part.end();++it){\n";
+            printChoiceCheck(out);
             out << "try{\n";
             out << "for(const auto& env0 : *it) {\n";
             out << "if( ";
@@ -662,7 +1795,7 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
             out << ") {\n";
 
-            visitTupleOperation(pchoice, out);
+            printChoiceClaim(pchoice, out);
 
             out << "break;\n";
             out << "}\n";
@@ -700,9 +1833,35 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
             auto ctxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(rel) + ")";
 
-            out << "auto range = " << relName << "->"
-                << "equalRange_" << keys << "(key," << ctxName << ");\n";
+            // consecutive searches for the same key take the range of the last one
+            auto memo = probeMemos.find(&iscan);
+            if (iscan.hasRange()) {
+                printBoundedRange(iscan, ctxName, out);
+            } else if (memo != probeMemos.end()) {
+                out << "auto range = " << memo->second << ".get(key,[&](const Tuple<RamDomain," << arity
+                    << ">& probed) {\n";
+                out << "return " << relName << "->equalRange_" << keys << "(probed," << ctxName << ");\n";
+                out << "});\n";
+            } else {
+                out << "auto range = " << relName << "->"
+                    << "equalRange_" << keys << "(key," << ctxName << ");\n";
+            }
+            printIndexScanCount(rel, keys, false, out);
+
+            if (&iscan == nestedParallel) {
+                nestedParallel = nullptr;
+                out << "auto part = range.partition();\n";
+                printParallelLoop(iscan, out);
+                if (preambleConditional) {
+                    out << "}\n";
+                }
+                out << "PARALLEL_END;\n";
+                PRINT_END_COMMENT(out);
+                return;
+            }
+
             out << "for(const auto& env" << identifier << " : range) {\n";
+            printIndexScanCount(rel, keys, true, out);
 
             visitTupleOperation(iscan, out);
 
@@ -710,6 +1869,67 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
             PRINT_END_COMMENT(out);
         }
 
+        void visitIntersect(const RamIntersect& intersect, std::ostream& out) override {
+            auto identifier = intersect.getTupleId();
+            size_t numParticipants = intersect.getNumParticipants();
+
+            PRINT_BEGIN_COMMENT(out);
+
+            // the keys of the participants, unbound columns being at their minimum
+            for (size_t p = 0; p < numParticipants; p++) {
+                const auto& rangePattern = intersect.getRangePattern(p);
+                auto arity = intersect.getRelation(p).getArity();
+                out << "const Tuple<RamDomain," << arity << "> key" << identifier << "_" << p << "({{";
+                for (size_t i = 0; i < arity; i++) {
+                    if (!isRamUndefValue(rangePattern[i])) {
+                        visit(rangePattern[i], out);
+                    } else {
+                        out << "MIN_RAM_DOMAIN";
+                    }
+                    if (i + 1 < arity) {
+                        out << ",";
+                    }
+                }
+                out << "}});\n";
+            }
+
+            // each participant seeks the least value of its column not less than the given one
+            out << "souffle::LeapfrogJoin join" << identifier << "({\n";
+            for (size_t p = 0; p < numParticipants; p++) {
+                const auto& rel = intersect.getRelation(p);
+                const auto& rangePattern = intersect.getRangePattern(p);
+                auto column = intersect.getColumn(p);
+                auto key = "key" + std::to_string(identifier) + "_" + std::to_string(p);
+                auto indNum = isa->getIndexes(rel).getOrderedLexOrderNum(
+                        isa->getSearchSignature(&intersect, p), column);
+                auto ctxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(rel) + ")";
+
+                out << "[&](RamDomain& value) {\n";
+                out << "auto low = " << key << ";\n";
+                out << "low[" << column << "] = value;\n";
+                out << "Tuple<RamDomain," << rel.getArity() << "> res;\n";
+                out << "if (!" << synthesiser.getRelationName(rel) << "->lowerBound_" << indNum << "(low,res,"
+                    << ctxName << ")) return false;\n";
+                for (size_t i = 0; i < rel.getArity(); i++) {
+                    if (!isRamUndefValue(rangePattern[i])) {
+                        out << "if (res[" << i << "] != " << key << "[" << i << "]) return false;\n";
+                    }
+                }
+                out << "value = res[" << column << "];\n";
+                out << "return true;\n";
+                out << "}" << (p + 1 < numParticipants ? ",\n" : "\n");
+            }
+            out << "});\n";
+
+            out << "while (join" << identifier << ".next()) {\n";
+            out << "const Tuple<RamDomain,1> env" << identifier << "({{join" << identifier << ".get()}});\n";
+
+            visitTupleOperation(intersect, out);
+
+            out << "}\n";
+            PRINT_END_COMMENT(out);
+        }
+
         void visitParallelIndexScan(const RamParallelIndexScan& piscan, std::ostream& out) override {
             const auto& rel = piscan.getRelation();
             auto relName = synthesiser.getRelationName(rel);
@@ -738,22 +1958,18 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
                 }
             }
             out << "}});\n";
-            out << "auto range = " << relName
-                << "->"
-                // TODO (b-scholz): context may be missing here?
-                << "equalRange_" << keys << "(key);\n";
+            if (piscan.hasRange()) {
+                printBoundedRange(piscan, "", out);
+            } else {
+                out << "auto range = " << relName
+                    << "->"
+                    // TODO (b-scholz): context may be missing here?
+                    << "equalRange_" << keys << "(key);\n";
+            }
+            printIndexScanCount(rel, keys, false, out);
             out << "auto part = range.partition();\n";
-            out << "PARALLEL_START;\n";
-            out << preamble.str();
-            out << "pfor(auto it = part.begin(); it<part.end(); ++it) { \n";
-            out << "try{\n";
-            out << "for(const auto& env0 : *it) {\n";
-
-            visitTupleOperation(piscan, out);
-
-            out << "}\n";
-            out << "} catch(std::exception &e) { SignalHandler::instance()->error(e.what());}\n";
-            out << "}\n";
+            printNestedParallel(piscan, "range", out);
+            printParallelLoop(piscan, out);
 
             PRINT_END_COMMENT(out);
         }
@@ -787,7 +2003,9 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
             out << "auto range = " << relName << "->"
                 << "equalRange_" << keys << "(key," << ctxName << ");\n";
+            printIndexScanCount(rel, keys, false, out);
             out << "for(const auto& env" << identifier << " : range) {\n";
+            printIndexScanCount(rel, keys, true, out);
             out << "if( ";
 
             visit(ichoice.getCondition(), out);
@@ -836,19 +2054,24 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
                 << "->"
                 // TODO (b-scholz): context may be missing here?
                 << "equalRange_" << keys << "(key);\n";
+            printIndexScanCount(rel, keys, false, out);
             out << "auto part = range.partition();\n";
-            out << "PARALLEL_START;\n";
+            out << "souffle::ParallelRegion parallelRegion(part);\n";
+            printChoiceFlag(out);
+            out << "PARALLEL_START_SIZED(parallelRegion.getTeamSize());\n";
             out << preamble.str();
             out << "pfor(auto it = part.begin(); it<part.end(); ++it) { \n";
+            printChoiceCheck(out);
             out << "try{";
             out << "for(const auto& env0 : *it) {\n";
+            printIndexScanCount(rel, keys, true, out);
             out << "if( ";
 
             visit(pichoice.getCondition(), out);
 
             out << ") {\n";
 
-            visitTupleOperation(pichoice, out);
+            printChoiceClaim(pichoice, out);
 
             out << "break;\n";
             out << "}\n";
@@ -912,26 +2135,49 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
                 return;
             }
 
-            // init result
-            std::string init;
-            switch (aggregate.getFunction()) {
-                case souffle::MIN:
-                    init = "MAX_RAM_DOMAIN";
-                    break;
-                case souffle::MAX:
-                    init = "MIN_RAM_DOMAIN";
-                    break;
-                case souffle::COUNT:
-                    init = "0";
-                    break;
-                case souffle::SUM:
-                    init = "0";
-                    break;
-                default:
-                    abort();
+            // special case: counting the tuples of a range, which b-trees and bitmaps do without iterating
+            if (isCountedRange(aggregate, keys)) {
+                out << "const " << tuple_type << " key({{";
+                for (size_t i = 0; i < arity; i++) {
+                    if (!isRamUndefValue(aggregate.getRangePattern()[i])) {
+                        visit(aggregate.getRangePattern()[i], out);
+                    } else {
+                        out << "0";
+                    }
+                    if (i + 1 < arity) {
+                        out << ",";
+                    }
+                }
+                out << "}});\n";
+                printIndexScanCount(rel, keys, false, out);
+                out << "env" << identifier << "[0] = " << relName << "->countRange_" << keys << "(key,"
+                    << ctxName << ");\n";
+                visitTupleOperation(aggregate, out);
+                PRINT_END_COMMENT(out);
+                return;
             }
+
+            // init result
+            std::string init = getAggregateInit(aggregate);
             out << "RamDomain res" << identifier << " = " << init << ";\n";
 
+            // look up the result among the groups computed ahead of the query, if they are
+            bool grouped = groupedAggregates.count(&aggregate) != 0;
+            if (grouped) {
+                out << "if(groups" << identifier << ".isComplete()) {\n";
+                out << "res" << identifier << " = groups" << identifier << ".find({{";
+                bool first = true;
+                for (size_t i = 0; i < arity; i++) {
+                    if (!isRamUndefValue(aggregate.getRangePattern()[i])) {
+                        out << (first ? "" : ",");
+                        visit(aggregate.getRangePattern()[i], out);
+                        first = false;
+                    }
+                }
+                out << "}}, " << init << ");\n";
+                out << "} else {\n";
+            }
+
             // check whether there is an index to use
             if (keys == 0) {
                 out << "for(const auto& env" << identifier << " : "
@@ -958,9 +2204,11 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
                 out << "}});\n";
                 out << "auto range = " << relName << "->"
                     << "equalRange_" << keys << "(key," << ctxName << ");\n";
+                printIndexScanCount(rel, keys, false, out);
 
                 // aggregate result
                 out << "for(const auto& env" << identifier << " : range) {\n";
+                printIndexScanCount(rel, keys, true, out);
             }
 
             // produce condition inside the loop
@@ -996,6 +2244,9 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
             // end aggregator loop
             out << "}\n";
+            if (grouped) {
+                out << "}\n";
+            }
 
             // write result into environment tuple
             out << "env" << identifier << "[0] = res" << identifier << ";\n";
@@ -1109,6 +2360,12 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
         void visitFilter(const RamFilter& filter, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
+            // the key filters of class joins are tested ahead of the loops over the members
+            if (classKeyFilters.count(&filter) != 0) {
+                visitNestedOperation(filter, out);
+                PRINT_END_COMMENT(out);
+                return;
+            }
             out << "if( ";
             visit(filter.getCondition(), out);
             out << ") {\n";
@@ -1228,20 +2485,22 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
                     break;
 
                 // strings
-                case BinaryConstraintOp::MATCH: {
-                    out << "regex_wrapper(symTable.resolve(";
-                    visit(rel.getLHS(), out);
-                    out << "),symTable.resolve(";
-                    visit(rel.getRHS(), out);
-                    out << "))";
-                    break;
-                }
+                case BinaryConstraintOp::MATCH:
                 case BinaryConstraintOp::NOT_MATCH: {
-                    out << "!regex_wrapper(symTable.resolve(";
-                    visit(rel.getLHS(), out);
-                    out << "),symTable.resolve(";
-                    visit(rel.getRHS(), out);
-                    out << "))";
+                    // constant patterns are compiled with the program, others on their first use
+                    bool negated = rel.getOperator() == BinaryConstraintOp::NOT_MATCH;
+                    const auto* pattern = dynamic_cast<const RamNumber*>(&rel.getLHS());
+                    if (pattern != nullptr && synthesiser.regexPatterns.count(pattern->getConstant()) > 0) {
+                        out << (negated ? "!" : "") << "std::regex_match(symTable.resolve(";
+                        visit(rel.getRHS(), out);
+                        out << "),regex_" << pattern->getConstant() << ")";
+                    } else {
+                        out << "regexCache.match(";
+                        visit(rel.getLHS(), out);
+                        out << ",symTable.resolve(";
+                        visit(rel.getRHS(), out);
+                        out << "),symTable," << (negated ? "true" : "false") << ")";
+                    }
                     break;
                 }
                 case BinaryConstraintOp::CONTAINS: {
@@ -1274,6 +2533,13 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
             PRINT_END_COMMENT(out);
         }
 
+        void visitSizeCheck(const RamSizeCheck& check, std::ostream& out) override {
+            PRINT_BEGIN_COMMENT(out);
+            out << "(" << synthesiser.getRelationName(check.getRelation()) << "->size() >= "
+                << check.getSize() << ")";
+            PRINT_END_COMMENT(out);
+        }
+
         void visitExistenceCheck(const RamExistenceCheck& exists, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
             // get some details
@@ -1287,29 +2553,51 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
                 out << R"_((reads[)_" << synthesiser.lookupReadIdx(rel.getName()) << R"_(]++,)_";
                 after = ")";
             }
-
-            // if it is total we use the contains function
-            if (isa->isTotalSignature(&exists)) {
-                out << relName << "->"
-                    << "contains(Tuple<RamDomain," << arity << ">({{" << join(exists.getValues(), ",", rec)
-                    << "}})," << ctxName << ")" << after;
-                PRINT_END_COMMENT(out);
-                return;
+            if (Global::config().has("profile-indexes")) {
+                auto keys = isa->isTotalSignature(&exists) ? 0 : isa->getSearchSignature(&exists);
+                out << "countProbe(indexStats[" << synthesiser.lookupIndexStatsIdx(rel, keys) << "],";
+                after = ")" + after;
             }
 
-            // else we conduct a range query
-            out << "!" << relName << "->"
-                << "equalRange";
-            out << "_" << isa->getSearchSignature(&exists);
-            out << "(Tuple<RamDomain," << arity << ">({{";
-            out << join(exists.getValues(), ",", [&](std::ostream& out, RamExpression* value) {
+            // b-tree relations answer partial searches by a single lower-bound descent of their
+            // index, and searches with a Bloom filter by consulting it before the index; total searches
+            // use the contains function, and others a range query
+            const auto* filters = synthesiser.getTranslationUnit().getAnalysis<RamBloomFilterAnalysis>();
+            bool bounded = !isa->isTotalSignature(&exists) && isa->getSearchSignature(&exists) != 0;
+            auto probe = [&](const std::string& key) {
+                std::stringstream res;
+                if (filters->isFiltered(exists) || (bounded && isDirect(rel))) {
+                    res << relName << "->exists_" << isa->getSearchSignature(&exists) << "(" << key << ","
+                        << ctxName << ")";
+                } else if (isa->isTotalSignature(&exists)) {
+                    res << relName << "->contains(" << key << "," << ctxName << ")";
+                } else {
+                    res << "!" << relName << "->equalRange_" << isa->getSearchSignature(&exists) << "(" << key
+                        << "," << ctxName << ").empty()";
+                }
+                return res.str();
+            };
+            std::stringstream key;
+            key << "Tuple<RamDomain," << arity << ">({{";
+            key << join(exists.getValues(), ",", [&](std::ostream& out, RamExpression* value) {
                 if (!isRamUndefValue(value)) {
                     visit(*value, out);
                 } else {
                     out << "0";
                 }
             });
-            out << "}})," << ctxName << ").empty()" << after;
+            key << "}})";
+
+            // consecutive checks of the same key take the result of the last one
+            auto memo = probeMemos.find(&exists);
+            if (memo != probeMemos.end()) {
+                out << memo->second << ".get(" << key.str() << ",[&](const Tuple<RamDomain," << arity
+                    << ">& probed) {\n";
+                out << "return " << probe("probed") << ";\n";
+                out << "})" << after;
+            } else {
+                out << probe(key.str()) << after;
+            }
             PRINT_END_COMMENT(out);
         }
 
@@ -1527,28 +2815,28 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
                 // strings
                 case FunctorOp::CAT: {
-                    out << "symTable.lookup(";
-                    for (size_t i = 0; i < op.getArgCount() - 1; i++) {
-                        out << "symTable.resolve(";
+                    out << "symTable.concat({";
+                    for (size_t i = 0; i < op.getArgCount(); i++) {
+                        if (i > 0) {
+                            out << ",";
+                        }
+                        out << "static_cast<RamDomain>(";
                         visit(op.getArgument(i), out);
-                        out << ") + ";
+                        out << ")";
                     }
-                    out << "symTable.resolve(";
-                    visit(op.getArgument(op.getArgCount() - 1), out);
-                    out << "))";
+                    out << "})";
                     break;
                 }
 
                 /** Ternary Functor Operators */
                 case FunctorOp::SUBSTR: {
-                    out << "symTable.lookup(";
-                    out << "substr_wrapper(symTable.resolve(";
+                    out << "symTable.substr(";
                     visit(op.getArgument(0), out);
-                    out << "),(";
+                    out << ",(";
                     visit(op.getArgument(1), out);
                     out << "),(";
                     visit(op.getArgument(2), out);
-                    out << ")))";
+                    out << "))";
                     break;
                 }
 
@@ -1595,8 +2883,13 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
 
         void visitPackRecord(const RamPackRecord& pack, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
-            out << "pack("
-                << "ram::Tuple<RamDomain," << pack.getArguments().size() << ">({"
+            if (localRecords &&
+                    synthesiser.getTranslationUnit().getAnalysis<RamRecordEscapeAnalysis>()->isLocal(pack)) {
+                out << "packLocal(localRecords,";
+            } else {
+                out << "pack(";
+            }
+            out << "ram::Tuple<RamDomain," << pack.getArguments().size() << ">({"
                 << join(pack.getArguments(), ",", rec) << "})"
                 << ")";
             PRINT_END_COMMENT(out);
@@ -1625,99 +2918,374 @@ void Synthesiser::emitCode(std::ostream& out, const RamStatement& stmt) {
             }
         }
 
-#ifdef USE_MPI
-
-        // -- mpi statements --
+        // -- inter-stratum statements --
 
         void visitRecv(const RamRecv& recv, std::ostream& os) override {
+            // the shm engine shares the relation and only starts the stratum once its source finished
+            if (Global::config().get("engine") != "mpi") {
+                return;
+            }
             os << "\n#ifdef USE_MPI\n";
-            os << "{";
-            os << "auto status = souffle::mpi::probe(";
-            // source
-            os << recv.getSourceStratum() + 1 << ", ";
-            // tag
-            os << "tag_" << synthesiser.getRelationName(recv.getRelation());
-            os << ");";
-            os << "souffle::mpi::recv<RamDomain>(";
+            // the owner of a stratum receives the relation for all ranks evaluating the stratum
+            os << "if (souffle::mpi::groupRank() == 0) {";
+            // a relation sent by a stratum completed by an earlier run is read from the store instead
+            const bool stored = Global::config().has("mpi-store") && recv.getSourceStratum() >= 0;
+            if (stored) {
+                os << "if (mpiStore.isCompleted(" << recv.getSourceStratum() << ")) {";
+                os << "mpiStore.restoreRelation(R\"_(" << recv.getRelation().getName() << ")_\", *"
+                   << synthesiser.getRelationName(recv.getRelation()) << ", "
+                   << getSymbolMask(recv.getRelation()) << ", "
+                   << synthesiser.getSymbolTableName(recv.getRelation()) << ");";
+                os << "} else {";
+            }
+            os << "souffle::mpi::recvRelation<RamDomain>(";
             // data
             os << "*" << synthesiser.getRelationName(recv.getRelation()) << ", ";
             // arity
             os << recv.getRelation().getArity() << ", ";
-            // status
-            os << "status";
+            // source
+            os << synthesiser.translationUnit.getAnalysis<RamMpiScheduleAnalysis>()->getRank(
+                          recv.getSourceStratum())
+               << ", ";
+            // tag
+            os << "tag_" << synthesiser.getRelationName(recv.getRelation());
             os << ");";
+            if (stored) {
+                os << "}";
+            }
             os << "}";
+            os << "souffle::mpi::broadcast<RamDomain>(*" << synthesiser.getRelationName(recv.getRelation())
+               << ", " << recv.getRelation().getArity() << ");";
+            // obtain the symbols of the received tuples in a single round trip, rather than one per symbol
+            std::vector<size_t> symbolColumns;
+            const auto& qualifiers = recv.getRelation().getAttributeTypeQualifiers();
+            for (size_t i = 0; i < qualifiers.size(); i++) {
+                if (qualifiers[i][0] == 's') {
+                    symbolColumns.push_back(i);
+                }
+            }
+            if (!symbolColumns.empty() && resolvesSymbols()) {
+                os << "{std::vector<RamDomain> symbols;";
+                os << "for (const auto& env0 : *" << synthesiser.getRelationName(recv.getRelation()) << ") {";
+                for (size_t column : symbolColumns) {
+                    os << "symbols.push_back(env0[" << column << "]);";
+                }
+                os << "}";
+                os << "symTable.prefetch(symbols);}";
+            }
             os << "\n#endif\n";
         }
 
+#ifdef USE_MPI
+
+        // -- mpi statements --
+
         void visitSend(const RamSend& send, std::ostream& os) override {
             os << "\n#ifdef USE_MPI\n";
-            os << "{";
-            os << "souffle::mpi::send<RamDomain>(";
+            // all ranks evaluating a stratum hold the relation, sent by the owner
+            os << "if (souffle::mpi::groupRank() == 0) {";
+            const auto* schedule = synthesiser.translationUnit.getAnalysis<RamMpiScheduleAnalysis>();
+            const bool stored = Global::config().has("mpi-store") && !send.getDestinationStrata().empty();
+            // the relations of the strata are saved before they are sent, those of the master reloaded
+            if (stored) {
+                os << "if (souffle::mpi::commRank() != 0) {";
+                os << "mpiStore.saveRelation(R\"_(" << send.getRelation().getName() << ")_\", *"
+                   << synthesiser.getRelationName(send.getRelation()) << ", "
+                   << getSymbolMask(send.getRelation()) << ", "
+                   << synthesiser.getSymbolTableName(send.getRelation()) << ");";
+                os << "}";
+            }
+            os << "souffle::mpi::sendRelation<RamDomain>(";
             // data
             os << "*" << synthesiser.getRelationName(send.getRelation()) << ", ";
             // arity
             os << send.getRelation().getArity() << ", ";
-            // destinations
-            const auto& destinationStrata = send.getDestinationStrata();
-            auto it = destinationStrata.begin();
-            os << "std::set<int>(";
-            if (it != destinationStrata.end()) {
-                os << "{" << *it + 1;
-                ++it;
-                while (it != destinationStrata.end()) {
-                    os << ", " << *it + 1;
-                    ++it;
-                }
-                os << "}";
+            // destinations, but for the strata completed by an earlier run
+            std::set<int> destinations;
+            std::vector<std::string> pending;
+            for (size_t stratum : send.getDestinationStrata()) {
+                destinations.insert(schedule->getRank((int)stratum));
+                pending.push_back("{" + std::to_string((int)stratum) + ", " +
+                                  std::to_string(schedule->getRank((int)stratum)) + "}");
+            }
+            if (stored) {
+                os << "mpiStore.pending({" << join(pending, ", ") << "}), ";
             } else {
-                os << "0";
+                os << "std::set<int>(";
+                if (!destinations.empty()) {
+                    os << "{" << join(destinations, ", ") << "}";
+                } else {
+                    os << "0";
+                }
+                os << "), ";
             }
-            os << "), ";
             // tag
-            os << "tag_" << synthesiser.getRelationName(send.getRelation());
+            os << "tag_" << synthesiser.getRelationName(send.getRelation()) << ", ";
+            // compression
+            os << (Global::config().has("mpi-compress") ? "true" : "false");
             os << ");";
             os << "}";
             os << "\n#endif\n";
         }
 
+        void visitExchange(const RamExchange& exchange, std::ostream& os) override {
+            os << "\n#ifdef USE_MPI\n";
+            os << "souffle::mpi::exchange<RamDomain>(*" << synthesiser.getRelationName(exchange.getRelation())
+               << ", " << exchange.getRelation().getArity() << ");";
+            os << "\n#endif\n";
+        }
+
+        void visitPartition(const RamPartition& partition, std::ostream& os) override {
+            os << "\n#ifdef USE_MPI\n";
+            os << "souffle::mpi::partition<RamDomain>(*"
+               << synthesiser.getRelationName(partition.getRelation()) << ", "
+               << partition.getRelation().getArity() << ");";
+            os << "\n#endif\n";
+        }
+
         void visitNotify(const RamNotify&, std::ostream& os) override {
             os << "\n#ifdef USE_MPI\n";
+            // relations are streamed on a communicator of their own, the master need not acknowledge
             os << "mpi::send(0, SymbolTable::exitTag());";
-            os << "mpi::recv(0, SymbolTable::exitTag());";
             os << "\n#endif\n";
         }
 
-        void visitWait(const RamWait& wait, std::ostream& os) override {
-            os << "\n#ifdef USE_MPI\n";
-            os << "symTable.handleMpiMessages(" << wait.getCount() << ");";
-            os << "\n#endif\n";
+        void visitWait(const RamWait& wait, std::ostream& os) override {
+            os << "\n#ifdef USE_MPI\n";
+            os << "symTable.handleMpiMessages(" << wait.getCount() << ");";
+            os << "\n#endif\n";
+        }
+
+#endif
+        // -- safety net --
+
+        void visitUndefValue(const RamUndefValue& undef, std::ostream& /*out*/) override {
+            assert(false && "Compilation error");
+        }
+
+        void visitNode(const RamNode& node, std::ostream& /*out*/) override {
+            std::cerr << "Unsupported node type: " << typeid(node).name() << "\n";
+            assert(false && "Unsupported Node Type!");
+        }
+    };
+
+    // emit code
+    CodeEmitter(*this).visit(stmt, out);
+}
+
+void Synthesiser::emitCheckpoints(std::ostream& decl, std::ostream& os, const std::string& classname) {
+    const RamProgram& prog = *translationUnit.getProgram();
+
+    // the relations a stratum computes are those it creates, unless they expire in the stratum already
+    std::map<int, std::vector<const RamRelation*>> saved;
+    std::map<int, std::set<std::string>> dropped;
+    std::map<std::string, const RamRelation*> relations;
+    visitDepthFirst(*(prog.getMain()), [&](const RamStratum& stratum) {
+        visitDepthFirst(stratum, [&](const RamDrop& drop) {
+            if (!drop.getRelation().isTemp()) {
+                dropped[stratum.getIndex()].insert(drop.getRelation().getName());
+            }
+        });
+        visitDepthFirst(stratum, [&](const RamCreate& create) {
+            const RamRelation& rel = create.getRelation();
+            if (!rel.isTemp() && relations.insert(std::make_pair(rel.getName(), &rel)).second &&
+                    dropped[stratum.getIndex()].count(rel.getName()) == 0) {
+                saved[stratum.getIndex()].push_back(&rel);
+            }
+        });
+    });
+
+    const auto& emitSave = [&](const std::string& checkpoint, const RamRelation& rel) {
+        os << checkpoint << "saveRelation(R\"_(" << rel.getName() << ")_\", *" << getRelationName(rel)
+           << ", " << rel.getArity() << ", symTable);\n";
+    };
+    const auto& quoted = [](const std::string& name) { return "R\"_(" + name + ")_\""; };
+
+    decl << "public:\n";
+    decl << "bool setCheckpoint(const std::string& directory, bool resume = false) override;\n";
+    decl << "bool saveCheckpoint(const std::string& directory) override;\n";
+    decl << "bool restoreCheckpoint(const std::string& directory) override;\n";
+    decl << "private:\n";
+    decl << "void restoreState(const Checkpoint& state);\n";
+    decl << "void checkpointStratum(size_t stratum, RamDomain counter);\n";
+
+    os << "bool " << classname << "::setCheckpoint(const std::string& directory, bool resume) {\n";
+    os << "checkpoint = std::make_unique<Checkpoint>(directory);\n";
+    os << "if (resume && checkpoint->read()) {\n";
+    os << "restoreState(*checkpoint);\n";
+    os << "}\n";
+    os << "return true;\n";
+    os << "}\n";
+
+    std::vector<std::string> names;
+    os << "bool " << classname << "::saveCheckpoint(const std::string& directory) {\n";
+    os << "Checkpoint snapshot(directory);\n";
+    for (const auto& cur : relations) {
+        emitSave("snapshot.", *cur.second);
+        names.push_back(quoted(cur.first));
+    }
+    os << "snapshot.commit({}, symTable, 0, {" << join(names, ", ") << "}, {});\n";
+    os << "return true;\n";
+    os << "}\n";
+
+    os << "bool " << classname << "::restoreCheckpoint(const std::string& directory) {\n";
+    os << "Checkpoint state(directory);\n";
+    os << "if (!state.read()) {\n";
+    os << "return false;\n";
+    os << "}\n";
+    os << "restoreState(state);\n";
+    os << "return true;\n";
+    os << "}\n";
+
+    os << "void " << classname << "::restoreState(const Checkpoint& state) {\n";
+    os << "state.restoreSymbols(symTable);\n";
+    for (const auto& cur : relations) {
+        os << "if (state.getRelations().count(" << quoted(cur.first) << ") > 0) {\n";
+        os << "state.restoreRelation(" << quoted(cur.first) << ", *" << getRelationName(*cur.second) << ", "
+           << cur.second->getArity() << ", symTable);\n";
+        os << "}\n";
+    }
+    os << "}\n";
+
+    // the outputs of a stratum are written before the checkpoint records it as completed
+    os << "void " << classname << "::checkpointStratum(size_t stratum, RamDomain counter) {\n";
+    if (Global::config().has("async-output")) {
+        os << "writeQueue.wait();\n";
+    }
+    os << "switch (stratum) {\n";
+    visitDepthFirst(*(prog.getMain()), [&](const RamStratum& stratum) {
+        std::vector<std::string> savedNames;
+        std::vector<std::string> droppedNames;
+        os << "case " << stratum.getIndex() << ": {\n";
+        for (const RamRelation* rel : saved[stratum.getIndex()]) {
+            emitSave("checkpoint->", *rel);
+            savedNames.push_back(quoted(rel->getName()));
+        }
+        for (const auto& name : dropped[stratum.getIndex()]) {
+            droppedNames.push_back(quoted(name));
+        }
+        os << "checkpoint->commit({" << stratum.getIndex() << "}, symTable, counter, {"
+           << join(savedNames, ", ") << "}, {" << join(droppedNames, ", ") << "});\n";
+        os << "break;\n";
+        os << "}\n";
+    });
+    os << "}\n";
+    os << "}\n";
+}
+
+std::vector<const RamRelation*> Synthesiser::getCachedRelations(const RamStratum& stratum) {
+    std::vector<const RamRelation*> res;
+    visitDepthFirst(stratum, [&](const RamCreate& create) {
+        if (!create.getRelation().isTemp()) {
+            res.push_back(&create.getRelation());
+        }
+    });
+    return res;
+}
+
+std::string Synthesiser::getStratumCacheLookup(const RamStratum& stratum) {
+    // records and the counter are not reproduced by restoring the relations of a stratum
+    bool cacheable = true;
+    visitDepthFirst(stratum, [&](const RamAutoIncrement&) { cacheable = false; });
+    std::stringstream code;
+    code << Global::config().get("version") << "\n" << stratum;
+    for (const RamRelation* rel : getCachedRelations(stratum)) {
+        for (const auto& type : rel->getAttributeTypeQualifiers()) {
+            cacheable = cacheable && type[0] != 'r';
+        }
+        code << rel->getName() << "(" << join(rel->getAttributeTypeQualifiers()) << ")\n";
+    }
+
+    // the inputs of a stratum are identified by their contents, hence need to be files
+    std::vector<std::string> files;
+    visitDepthFirst(stratum, [&](const RamLoad& load) {
+        for (const IODirectives& io : load.getIODirectives()) {
+            if (IODirectives::isFileType(io.getIOType()) && io.has("filename")) {
+                files.push_back("StratumCache::inputPath(inputDirectory, R\"_(" + io.getFileName() + ")_\")");
+            } else {
+                cacheable = false;
+            }
         }
+    });
+    if (!cacheable) {
+        return "";
+    }
 
-#endif
-        // -- safety net --
+    const auto* dependencies = translationUnit.getAnalysis<RamStratumDependencyAnalysis>();
+    std::stringstream res;
+    res << "performIO && stratumCache.lookup(" << stratum.getIndex() << ", " << StratumCache::hash(code.str())
+        << "ull, {" << join(dependencies->getPredecessors()[stratum.getIndex()], ", ") << "}, {"
+        << join(files, ", ") << "})";
+    return res.str();
+}
 
-        void visitUndefValue(const RamUndefValue& undef, std::ostream& /*out*/) override {
-            assert(false && "Compilation error");
+void Synthesiser::emitStratumCache(std::ostream& decl, std::ostream& os, const std::string& classname) {
+    const RamProgram& prog = *translationUnit.getProgram();
+    const auto& emitMask = [&](const RamRelation& rel) {
+        std::vector<bool> symbolMask;
+        for (const auto& type : rel.getAttributeTypeQualifiers()) {
+            symbolMask.push_back(type[0] == 's');
         }
+        os << "std::vector<bool>({" << join(symbolMask) << "}), " << getSymbolTableName(rel);
+    };
 
-        void visitNode(const RamNode& node, std::ostream& /*out*/) override {
-            std::cerr << "Unsupported node type: " << typeid(node).name() << "\n";
-            assert(false && "Unsupported Node Type!");
+    decl << "private:\n";
+    decl << "void restoreStratum(size_t stratum, std::string outputDirectory, bool performIO);\n";
+    decl << "void cacheStratum(size_t stratum);\n";
+
+    // a restored stratum writes its outputs as if evaluated
+    os << "void " << classname
+       << "::restoreStratum(size_t stratum, std::string outputDirectory, bool performIO) {\n";
+    os << "switch (stratum) {\n";
+    visitDepthFirst(*(prog.getMain()), [&](const RamStratum& stratum) {
+        os << "case " << stratum.getIndex() << ":\n";
+        for (const RamRelation* rel : getCachedRelations(stratum)) {
+            os << "stratumCache.restoreRelation(" << stratum.getIndex() << ", R\"_(" << rel->getName()
+               << ")_\", *" << getRelationName(*rel) << ", ";
+            emitMask(*rel);
+            os << ");\n";
         }
-    };
+        visitDepthFirst(stratum, [&](const RamStore& store) { emitCode(os, store); });
+        os << "break;\n";
+    });
+    os << "}\n";
+    os << "}\n";
 
-    // emit code
-    CodeEmitter(*this).visit(stmt, out);
+    os << "void " << classname << "::cacheStratum(size_t stratum) {\n";
+    os << "switch (stratum) {\n";
+    visitDepthFirst(*(prog.getMain()), [&](const RamStratum& stratum) {
+        os << "case " << stratum.getIndex() << ":\n";
+        for (const RamRelation* rel : getCachedRelations(stratum)) {
+            os << "stratumCache.saveRelation(" << stratum.getIndex() << ", R\"_(" << rel->getName()
+               << ")_\", *" << getRelationName(*rel) << ", ";
+            emitMask(*rel);
+            os << ");\n";
+        }
+        os << "break;\n";
+    });
+    os << "}\n";
+    os << "stratumCache.commit(stratum);\n";
+    os << "}\n";
 }
 
 void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& withSharedLibrary) {
+    generateProgram(os, id, withSharedLibrary, nullptr, nullptr);
+}
+
+void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& withSharedLibrary,
+        std::ostream& header, std::vector<std::string>& strata) {
+    generateProgram(os, id, withSharedLibrary, &header, &strata);
+}
+
+void Synthesiser::generateProgram(std::ostream& out, const std::string& id, bool& withSharedLibrary,
+        std::ostream* header, std::vector<std::string>* strata) {
     // ---------------------------------------------------------------
     //                      Auto-Index Generation
     // ---------------------------------------------------------------
     const SymbolTable& symTable = translationUnit.getSymbolTable();
     const RamProgram& prog = *translationUnit.getProgram();
     auto* idxAnalysis = translationUnit.getAnalysis<RamIndexAnalysis>();
+    const auto* filterAnalysis = translationUnit.getAnalysis<RamBloomFilterAnalysis>();
 
     // ---------------------------------------------------------------
     //                      Code Generation
@@ -1727,25 +3295,42 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
 
     std::string classname = "Sf_" + id;
 
+    // the declarations of the program, preceding the definitions of its members in os
+    std::stringstream decl;
+    std::stringstream os;
+
 #ifdef USE_MPI
     // turn off mpi support if not enabled as the execution engine
     if (Global::config().get("engine") != "mpi") {
-        os << "#undef USE_MPI\n";
+        decl << "#undef USE_MPI\n";
     }
 #endif
 
     // generate C++ program
-    os << "\n#include \"souffle/CompiledSouffle.h\"\n";
+    decl << "\n#include \"souffle/CompiledSouffle.h\"\n";
     if (Global::config().has("provenance")) {
-        os << "#include <mutex>\n";
-        os << "#include \"souffle/Explain.h\"\n";
+        decl << "#include <mutex>\n";
+        decl << "#include \"souffle/Explain.h\"\n";
+    }
+
+    const auto* dependencies = translationUnit.getAnalysis<RamStratumDependencyAnalysis>();
+    if (Global::config().get("engine") == "shm" || dependencies->isConcurrent()) {
+        decl << "#include \"souffle/Shm.h\"\n";
+    }
+
+    if (Global::config().has("incremental")) {
+        decl << "#include \"souffle/QueryServer.h\"\n";
+    }
+
+    if (Global::config().has("bulk-joins")) {
+        decl << "#include \"souffle/BulkJoin.h\"\n";
     }
 
     if (Global::config().has("live-profile")) {
-        os << "#include <thread>\n";
-        os << "#include \"souffle/profile/Tui.h\"\n";
+        decl << "#include <thread>\n";
+        decl << "#include \"souffle/profile/Tui.h\"\n";
     }
-    os << "\n";
+    decl << "\n";
     // produce external definitions for user-defined functors
     std::map<std::string, std::string> functors;
     visitDepthFirst(prog, [&](const RamUserDefinedOperator& op) {
@@ -1753,17 +3338,17 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
             functors.insert(std::make_pair(op.getName(), op.getType()));
         withSharedLibrary = true;
     });
-    os << "extern \"C\" {\n";
+    decl << "extern \"C\" {\n";
     for (const auto& f : functors) {
         size_t arity = f.second.length() - 1;
         const std::string& type = f.second;
         const std::string& name = f.first;
         if (type[arity] == 'N') {
-            os << "souffle::RamDomain ";
+            decl << "souffle::RamDomain ";
         } else if (type[arity] == 'S') {
-            os << "const char * ";
+            decl << "const char * ";
         }
-        os << name << "(";
+        decl << name << "(";
         std::vector<std::string> args;
         for (size_t i = 0; i < arity; i++) {
             if (type[i] == 'N') {
@@ -1772,116 +3357,122 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
                 args.push_back("const char *");
             }
         }
-        os << join(args, ",");
-        os << ");\n";
+        decl << join(args, ",");
+        decl << ");\n";
     }
-    os << "}\n";
-    os << "\n";
-    os << "namespace souffle {\n";
-    os << "using namespace ram;\n";
-
+    decl << "}\n";
+    decl << "\n";
+    decl << "namespace souffle {\n";
+    decl << "using namespace ram;\n";
+
+    // each type of relation is generated once, serving the searches of all relations of the type,
+    // and all of them in parallel into buffers of their own
+    std::vector<std::unique_ptr<SynthesiserRelation>> relationTypes;
+    std::map<std::string, size_t> typeNums;
     visitDepthFirst(*(prog.getMain()), [&](const RamCreate& create) {
         // get some table details
         const RamRelation& rel = create.getRelation();
-        const std::string& raw_name = rel.getName();
-
-        bool isProvInfo = raw_name.find("@info") != std::string::npos;
-        auto relationType = SynthesiserRelation::getSynthesiserRelation(
-                rel, idxAnalysis->getIndexes(rel), Global::config().has("provenance") && !isProvInfo);
-
-        generateRelationTypeStruct(os, std::move(relationType));
+        auto relationType = SynthesiserRelation::getSynthesiserRelation(rel, idxAnalysis->getIndexes(rel),
+                rel.hasProvenanceColumns(), filterAnalysis->getFilteredSearches(rel));
+        auto typeNum = typeNums.insert(std::make_pair(relationType->getTypeName(), relationTypes.size()));
+        if (typeNum.second) {
+            relationTypes.push_back(std::move(relationType));
+        } else {
+            relationTypes[typeNum.first->second]->merge(*relationType);
+        }
     });
-    os << '\n';
-
-    os << "class " << classname << " : public SouffleProgram {\n";
-
-    // regex wrapper
-    os << "private:\n";
-    os << "static inline bool regex_wrapper(const std::string& pattern, const std::string& text) {\n";
-    os << "   bool result = false; \n";
-    os << "   try { result = std::regex_match(text, std::regex(pattern)); } catch(...) { \n";
-    os << "     std::cerr << \"warning: wrong pattern provided for match(\\\"\" << pattern << \"\\\",\\\"\" "
-          "<< text << \"\\\").\\n\";\n}\n";
-    os << "   return result;\n";
-    os << "}\n";
-
-    // substring wrapper
-    os << "private:\n";
-    os << "static inline std::string substr_wrapper(const std::string& str, size_t idx, size_t len) {\n";
-    os << "   std::string result; \n";
-    os << "   try { result = str.substr(idx,len); } catch(...) { \n";
-    os << "     std::cerr << \"warning: wrong index position provided by substr(\\\"\";\n";
-    os << "     std::cerr << str << \"\\\",\" << (int32_t)idx << \",\" << (int32_t)len << \") "
-          "functor.\\n\";\n";
-    os << "   } return result;\n";
-    os << "}\n";
+    int numTypes = relationTypes.size();
+    std::vector<std::string> typeStructs(numTypes);
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < numTypes; i++) {
+        std::stringstream typeStruct;
+        relationTypes[i]->generateTypeStruct(typeStruct);
+        typeStructs[i] = typeStruct.str();
+    }
+    for (const std::string& typeStruct : typeStructs) {
+        decl << typeStruct;
+    }
+    decl << '\n';
+
+    decl << "class " << classname << " : public SouffleProgram {\n";
+
+    // the patterns of match constraints, constant ones compiled with the program unless invalid, for
+    // which the warnings of evaluations are kept
+    decl << "private:\n";
+    visitDepthFirst(prog, [&](const RamConstraint& constraint) {
+        const auto* pattern = dynamic_cast<const RamNumber*>(&constraint.getLHS());
+        if (pattern == nullptr || (constraint.getOperator() != BinaryConstraintOp::MATCH &&
+                                          constraint.getOperator() != BinaryConstraintOp::NOT_MATCH)) {
+            return;
+        }
+        RamDomain symbol = pattern->getConstant();
+        if (RegexCache::compile(symTable.resolve(symbol)) != nullptr && regexPatterns.insert(symbol).second) {
+            decl << "const std::regex regex_" << symbol << "{R\"_(" << symTable.resolve(symbol)
+                 << ")_\", std::regex::optimize};\n";
+        }
+    });
+    decl << "RegexCache regexCache;\n";
 
     // to number wrapper
-    os << "private:\n";
-    os << "static inline RamDomain wrapper_tonumber(const std::string& str) {\n";
-    os << "   RamDomain result=0; \n";
-    os << "   try { result = stord(str); } catch(...) { \n";
-    os << "     std::cerr << \"error: wrong string provided by to_number(\\\"\";\n";
-    os << R"(     std::cerr << str << "\") )";
-    os << "functor.\\n\";\n";
-    os << "     raise(SIGFPE);\n";
-    os << "   } return result;\n";
-    os << "}\n";
+    decl << "private:\n";
+    decl << "static inline RamDomain wrapper_tonumber(const std::string& str) {\n";
+    decl << "   RamDomain result=0; \n";
+    decl << "   try { result = stord(str); } catch(...) { \n";
+    decl << "     std::cerr << \"error: wrong string provided by to_number(\\\"\";\n";
+    decl << R"(     std::cerr << str << "\") )";
+    decl << "functor.\\n\";\n";
+    decl << "     raise(SIGFPE);\n";
+    decl << "   } return result;\n";
+    decl << "}\n";
 
 // if using mpi...
 #ifdef USE_MPI
     if (Global::config().get("engine") == "mpi") {
-        os << "\n#ifdef USE_MPI\n";
+        decl << "\n#ifdef USE_MPI\n";
 
         // create an enum of message tags, one for each relation
         {
-            os << "private:\n";
-            os << "enum {";
+            decl << "private:\n";
+            decl << "enum {";
             {
                 int tag = SymbolTable::numberOfTags();
                 visitDepthFirst(*(prog.getMain()), [&](const RamCreate& create) {
                     if (tag != SymbolTable::numberOfTags()) {
-                        os << ", ";
+                        decl << ", ";
                     }
-                    os << "tag_" << getRelationName(create.getRelation()) << " = " << tag;
+                    decl << "tag_" << getRelationName(create.getRelation()) << " = " << tag;
                     ++tag;
                 });
             }
-            os << "};";
+            decl << "};";
         }
-        os << "\n#endif\n";
+        if (Global::config().has("mpi-store")) {
+            decl << "public:\n";
+            decl << "souffle::MpiStore mpiStore{R\"_(" << Global::config().get("mpi-store") << ")_\"};\n";
+            decl << "private:\n";
+        }
+        decl << "\n#endif\n";
     }
 #endif
 
     if (Global::config().has("profile")) {
-        os << "std::string profiling_fname;\n";
+        decl << "std::string profiling_fname;\n";
     }
 
-    os << "public:\n";
+    decl << "public:\n";
 
-    // declare symbol table
-    os << "// -- initialize symbol table --\n";
-    {
-        os << "SymbolTable symTable\n";
-        if (symTable.size() > 0) {
-            os << "{\n";
-            for (size_t i = 0; i < symTable.size(); i++) {
-                os << "\tR\"_(" << symTable.resolve(i) << ")_\",\n";
-            }
-            os << "}";
-        }
-        os << ";";
-    }
+    // declare symbol table, which is initialized by the constructor
+    decl << "SymbolTable symTable;\n";
     if (Global::config().has("profile")) {
-        os << "private:\n";
+        decl << "private:\n";
         size_t numFreq = 0;
         visitDepthFirst(*(prog.getMain()), [&](const RamStatement& node) { numFreq++; });
-        os << "  size_t freqs[" << numFreq << "]{};\n";
+        decl << "  size_t freqs[" << numFreq << "]{};\n";
         size_t numRead = 0;
         visitDepthFirst(*(prog.getMain()), [&](const RamCreate& node) {
             if (!node.getRelation().isTemp()) numRead++;
         });
-        os << "  size_t reads[" << numRead << "]{};\n";
+        decl << "  size_t reads[" << numRead << "]{};\n";
     }
 
     // print relation definitions
@@ -1889,12 +3480,21 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
     std::string registerRel;  // registration of relations
     int relCtr = 0;
     std::string tempType;  // string to hold the type of the temporary relations
+    bool tempIsBuffer = false;  // whether the temporary relations are append buffers
+    bool tempAdoptsNodes = false;  // whether the temporary relations are tries
+    std::map<std::string, std::string> adoptingTypes;  // the types of relations stored in tries
     std::set<std::string> storeRelations;
     std::set<std::string> loadRelations;
     visitDepthFirst(*(prog.getMain()),
             [&](const RamStore& store) { storeRelations.insert(store.getRelation().getName()); });
     visitDepthFirst(*(prog.getMain()),
             [&](const RamLoad& load) { loadRelations.insert(load.getRelation().getName()); });
+    // relations reaching a large size in the profile given by profile-use obtain their nodes in advance
+    auto profile = std::make_shared<profile::ProgramRun>(profile::ProgramRun());
+    if (Global::config().has("profile-use")) {
+        profile::Reader(Global::config().get("profile-use"), profile).processFile();
+    }
+    const size_t minReservedSize = 1 << 16;
     visitDepthFirst(*(prog.getMain()), [&](const RamCreate& create) {
         // get some table details
         const auto& rel = create.getRelation();
@@ -1905,23 +3505,42 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
         // TODO: make this correct
         // ensure that the type of the new knowledge is the same as that of the delta knowledge
         bool isDelta = rel.isTemp() && raw_name.find("@delta") != std::string::npos;
-        bool isProvInfo = raw_name.find("@info") != std::string::npos;
-        auto relationType = SynthesiserRelation::getSynthesiserRelation(
-                rel, idxAnalysis->getIndexes(rel), Global::config().has("provenance") && !isProvInfo);
+        auto relationType = SynthesiserRelation::getSynthesiserRelation(rel, idxAnalysis->getIndexes(rel),
+                rel.hasProvenanceColumns(), filterAnalysis->getFilteredSearches(rel));
         tempType = isDelta ? relationType->getTypeName() : tempType;
-        const std::string& type = (rel.isTemp()) ? tempType : relationType->getTypeName();
+        // the tuples added and deleted for incremental updates are kept in relations of their own type
+        const bool isChange =
+                rel.isTemp() && (raw_name.find("@added_") == 0 || raw_name.find("@deleted_") == 0);
+        const std::string& type = (rel.isTemp() && !isChange) ? tempType : relationType->getTypeName();
+        if (isDelta) {
+            tempIsBuffer = dynamic_cast<const SynthesiserBufferRelation*>(relationType.get()) != nullptr;
+        }
+        if (rel.isTemp() && !isChange && tempIsBuffer) {
+            appendBuffers.insert(raw_name);
+        }
+        // tries take over the nodes of other tries of the same type
+        const auto* brie = dynamic_cast<const SynthesiserBrieRelation*>(relationType.get());
+        if (isDelta) {
+            tempAdoptsNodes = brie != nullptr && brie->adoptsNodes();
+        }
+        if ((rel.isTemp() && !isChange) ? tempAdoptsNodes : (brie != nullptr && brie->adoptsNodes())) {
+            adoptingTypes[raw_name] = type;
+        }
 
         // defining table
-        os << "// -- Table: " << raw_name << "\n";
+        decl << "// -- Table: " << raw_name << "\n";
 
-        os << "std::unique_ptr<" << type << "> " << name << " = std::make_unique<" << type << ">();\n";
+        decl << "std::unique_ptr<" << type << "> " << name << " = std::make_unique<" << type << ">();\n";
         if (!rel.isTemp()) {
-            os << "souffle::RelationWrapper<";
-            os << relCtr++ << ",";
-            os << type << ",";
-            os << "Tuple<RamDomain," << arity << ">,";
-            os << arity;
-            os << "> wrapper_" << name << ";\n";
+            if (getSymbolTableName(rel) != "symTable") {
+                decl << "SymbolTable " << getSymbolTableName(rel) << ";\n";
+            }
+            decl << "souffle::RelationWrapper<";
+            decl << relCtr++ << ",";
+            decl << type << ",";
+            decl << "Tuple<RamDomain," << arity << ">,";
+            decl << arity;
+            decl << "> wrapper_" << name << ";\n";
 
             // construct types
             std::string tupleType = "std::array<const char *," + std::to_string(arity) + ">{{";
@@ -1944,27 +3563,169 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
             if (!initCons.empty()) {
                 initCons += ",\n";
             }
-            initCons += "\nwrapper_" + name + "(" + "*" + name + ",symTable,\"" + raw_name + "\"," +
-                        tupleType + "," + tupleName + ")";
+            initCons += "\nwrapper_" + name + "(" + "*" + name + "," + getSymbolTableName(rel) + ",\"" +
+                        raw_name + "\"," + tupleType + "," + tupleName + ")";
             registerRel += "addRelation(\"" + raw_name + "\",&wrapper_" + name + ",";
             registerRel += (loadRelations.count(rel.getName()) > 0) ? "true" : "false";
             registerRel += ",";
             registerRel += (storeRelations.count(rel.getName()) > 0) ? "true" : "false";
             registerRel += ");\n";
+
+            const auto* profRel = profile->getRelation(raw_name);
+            if (profRel != nullptr && profRel->size() >= minReservedSize &&
+                    dynamic_cast<const SynthesiserDirectRelation*>(relationType.get()) != nullptr) {
+                registerRel += name + "->reserve(" + std::to_string(profRel->size()) + ");\n";
+            }
+
+            // the tuples inserted and retracted through the interface seed the next incremental update
+            if (Global::config().has("incremental")) {
+                // a tuple retracted and inserted again, or inserted and retracted again, is no longer
+                // recorded by its first change
+                const std::string tupleType = "Tuple<RamDomain," + std::to_string(arity) + ">";
+                const std::string added = getRelationName("@added_" + raw_name);
+                const std::string deleted = getRelationName("@deleted_" + raw_name);
+                const auto& erase = [&](const std::string& changes) {
+                    return "eraseTuples(*" + changes + ", [&](const " + tupleType +
+                           "& cur) { return cur == t; });";
+                };
+                registerRel += "wrapper_" + name + ".trackChanges([this](const " + tupleType + "& t) {\n";
+                registerRel += "if (!" + name + "->contains(t)) " + added + "->insert(t.data);\n";
+                registerRel += "else if (" + deleted + "->contains(t)) " + erase(deleted) + "\n";
+                registerRel += "}, [this](const " + tupleType + "& t) {\n";
+                registerRel += "if (" + added + "->contains(t)) " + erase(added) + "\n";
+                registerRel += deleted + "->insert(t.data);\n";
+                registerRel += "});\n";
+            }
+
+            // the patterns searched through the interface are served by the index of the search binding
+            // the most of their columns, or by a full scan
+            std::vector<SearchSignature> searches(idxAnalysis->getIndexes(rel).getSearches().begin(),
+                    idxAnalysis->getIndexes(rel).getSearches().end());
+            std::stable_sort(searches.begin(), searches.end(), [](SearchSignature a, SearchSignature b) {
+                return __builtin_popcountll(a) > __builtin_popcountll(b);
+            });
+            if (arity > 0 && !searches.empty()) {
+                const std::string tupleType = "Tuple<RamDomain," + std::to_string(arity) + ">";
+                registerRel += "wrapper_" + name + ".searchIndexes([this](const " + tupleType +
+                               "& t, uint64_t columns, const std::function<void(const " + tupleType +
+                               "&)>& visit) {\n";
+                for (SearchSignature search : searches) {
+                    registerRel += "if ((columns & " + std::to_string(search) + "ull) == " +
+                                   std::to_string(search) + "ull) {\n";
+                    registerRel += "for (const auto& cur : " + name + "->equalRange_" +
+                                   std::to_string(search) + "(t)) visit(cur);\n";
+                    registerRel += "return;\n";
+                    registerRel += "}\n";
+                }
+                registerRel += "for (const auto& cur : *" + name + ") visit(cur);\n";
+                registerRel += "});\n";
+            }
         }
     });
 
-    os << "public:\n";
+    // a merge followed by the clearing of its source moves the nodes of the source into the target
+    visitDepthFirst(*(prog.getMain()), [&](const RamSequence& seq) {
+        const auto stmts = seq.getStatements();
+        for (size_t i = 0; i + 1 < stmts.size(); i++) {
+            const auto* merge = dynamic_cast<const RamMerge*>(stmts[i]);
+            const auto* clear = dynamic_cast<const RamClear*>(stmts[i + 1]);
+            if (merge == nullptr || clear == nullptr) {
+                continue;
+            }
+            const std::string& src = merge->getSourceRelation().getName();
+            const std::string& trg = merge->getTargetRelation().getName();
+            if (clear->getRelation().getName() != src || src == trg || adoptingTypes.count(src) == 0 ||
+                    adoptingTypes.count(trg) == 0 || adoptingTypes[src] != adoptingTypes[trg]) {
+                continue;
+            }
+            absorbingMerges.insert(merge);
+        }
+    });
+
+    // the queue is declared after the relations, hence destroyed, waiting for pending writes, first
+    if (Global::config().has("async-output")) {
+        decl << "WriteQueue writeQueue;\n";
+    }
+    if (Global::config().has("prefetch-input")) {
+        decl << "InputPrefetcher inputPrefetcher;\n";
+    }
+    if (Global::config().has("checkpoints")) {
+        decl << "std::unique_ptr<Checkpoint> checkpoint;\n";
+    }
+    if (Global::config().has("stratum-cache")) {
+        size_t numStrata = 0;
+        visitDepthFirst(*(prog.getMain()), [&](const RamStratum&) { ++numStrata; });
+        decl << "StratumCache stratumCache{R\"_(" << Global::config().get("stratum-cache") << ")_\", "
+             << numStrata << "};\n";
+    }
+    if (Global::config().has("statistics")) {
+        decl << "StatisticsCatalog statistics{R\"_(" << Global::config().get("statistics") << ")_\"};\n";
+    }
+    if (Global::config().has("incremental")) {
+        decl << "bool evaluated = false;\n";
+        decl << "RamDomain counter = 0;\n";
+    }
+
+    decl << "public:\n";
 
     // -- constructor --
 
-    os << classname;
+    // the symbol table is declared before the relations, hence initialized first
+    if (const SymbolDictionary* dictionary = symTable.getDictionary()) {
+        // the program maps the dictionary it was compiled with, followed by the literals missing from it
+        std::string initSymbols = "\nsymTable(SymbolTable::load(R\"_(" + dictionary->getFileName() +
+                                  ")_\", " + std::to_string(dictionary->getChecksum()) + "ull, {\n";
+        for (size_t i = dictionary->getSize(); i < symTable.size(); i++) {
+            initSymbols += "\tR\"_(" + symTable.resolve(i) + ")_\",\n";
+        }
+        initSymbols += "}))";
+        initCons = initCons.empty() ? initSymbols : initSymbols + ",\n" + initCons;
+    } else if (symTable.size() > 0) {
+        std::vector<std::string> symbols;
+        for (size_t i = 0; i < symTable.size(); i++) {
+            symbols.push_back(symTable.resolve(i));
+        }
+        // the symbols are placed in a perfect-hashed segment in static storage, the table
+        // of the program starting with them without any work at startup
+        std::vector<uint32_t> displacements;
+        std::vector<uint32_t> slots;
+        std::string initSymbols;
+        if (SymbolTable::buildSegment(symbols, displacements, slots)) {
+            const std::string prefix = classname + "_symbol";
+            std::vector<std::string> lengths;
+            os << "static const char* const " << prefix << "s[] = {\n";
+            for (const auto& symbol : symbols) {
+                os << "\tR\"_(" << symbol << ")_\",\n";
+                lengths.push_back(std::to_string(symbol.size()));
+            }
+            os << "};\n";
+            os << "static const uint32_t " << prefix << "Lengths[] = {" << join(lengths, ",") << "};\n";
+            os << "static const uint32_t " << prefix << "Displacements[] = {" << join(displacements, ",")
+               << "};\n";
+            os << "static const uint32_t " << prefix << "Slots[] = {" << join(slots, ",") << "};\n";
+            os << "static const SymbolSegment " << prefix << "Segment{" << symbols.size() << ", " << prefix
+               << "s, " << prefix << "Lengths, " << displacements.size() << ", " << prefix
+               << "Displacements, " << slots.size() << ", " << prefix << "Slots};\n";
+            initSymbols = "\nsymTable(" + prefix + "Segment)";
+        } else {
+            initSymbols = "\nsymTable{\n";
+            for (const auto& symbol : symbols) {
+                initSymbols += "\tR\"_(" + symbol + ")_\",\n";
+            }
+            initSymbols += "}";
+        }
+        initCons = initCons.empty() ? initSymbols : initSymbols + ",\n" + initCons;
+    }
+
+    os << classname << "::" << classname;
     if (Global::config().has("profile")) {
-        os << "(std::string pf=\"profile.log\") : profiling_fname(pf)";
+        decl << classname << "(std::string pf=\"profile.log\");\n";
+        os << "(std::string pf) : profiling_fname(pf)";
         if (!initCons.empty()) {
             os << ",\n" << initCons;
         }
     } else {
+        decl << classname << "();\n";
         os << "()";
         if (!initCons.empty()) {
             os << " : " << initCons;
@@ -1972,30 +3733,120 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
     }
     os << "{\n";
     if (Global::config().has("profile")) {
-        os << "ProfileEventSingleton::instance().setOutputFile(profiling_fname);\n";
+        os << "ProfileEventSingleton::instance().setOutputFile(profiling_fname, "
+           << (Global::config().has("profile-binary") ? "true" : "false") << ");\n";
+        if (Global::config().has("profile-stream")) {
+            os << "ProfileEventSingleton::instance().listen(R\"_(" << Global::config().get("profile-stream")
+               << ")_\");\n";
+        }
+        if (Global::config().has("metrics")) {
+            os << "ProfileEventSingleton::instance().serveMetrics(R\"_(" << Global::config().get("metrics")
+               << ")_\");\n";
+        }
+        if (Global::config().has("profile-counters")) {
+            os << "ProfileEventSingleton::instance().setHardwareCounters(true);\n";
+        }
+    }
+    if (Global::config().has("trace")) {
+        os << "TraceLog::instance().open(R\"_(" << Global::config().get("trace") << ")_\");\n";
     }
     os << registerRel;
     os << "}\n";
     // -- destructor --
 
-    os << "~" << classname << "() {\n";
+    decl << "~" << classname << "();\n";
+    os << classname << "::~" << classname << "() {\n";
     os << "}\n";
 
+    // -- strata --
+
+    // Each stratum is a specialization of a member template, keyed by the hash of its code. Hence, the
+    // declarations do not depend on the strata, and the unit of a stratum only changes with its code.
+    const std::string stratumParams =
+            "(const std::string& inputDirectory, const std::string& outputDirectory, bool performIO, "
+            "std::atomic<RamDomain>& ctr, std::atomic<size_t>& iter)";
+    decl << "private:\ntemplate <unsigned long long key>\nvoid runStratum" << stratumParams << ";\n";
+
+    // the strata are emitted in parallel into buffers of their own, unless profiled, as the counters of
+    // a profile are numbered in the order of their emission
+    prepareParallelEmission();
+    std::vector<const RamStratum*> strataList;
+    visitDepthFirst(*(prog.getMain()), [&](const RamStratum& stratum) { strataList.push_back(&stratum); });
+    int numStrata = strataList.size();
+    std::vector<std::string> bodies(numStrata);
+#pragma omp parallel for schedule(dynamic) if (!Global::config().has("profile"))
+    for (int i = 0; i < numStrata; i++) {
+        std::stringstream body;
+        emitCode(body, strataList[i]->getBody());
+        bodies[i] = body.str();
+    }
+
+    std::map<size_t, std::string> stratumKeys;
+    std::set<std::string> emittedKeys;
+    for (int i = 0; i < numStrata; i++) {
+        const RamStratum& stratum = *strataList[i];
+        const std::string& body = bodies[i];
+        const std::string key = "0x" + contentHash(body) + "ull";
+        stratumKeys[stratum.getIndex()] = key;
+        // identical strata share their code
+        if (!emittedKeys.insert(key).second) {
+            continue;
+        }
+
+        std::stringstream code;
+        code << "template <>\nvoid " << classname << "::runStratum<" << key << ">" << stratumParams;
+        if (strata != nullptr) {
+            os << code.str() << ";\n";
+            code << " {\n" << body << "}\n";
+            strata->push_back("namespace souffle {\nusing namespace ram;\n" + code.str() + "}\n");
+        } else {
+            code << " {\n" << body << "}\n";
+            os << code.str();
+        }
+    }
+
     // -- run function --
-    os << "private:\nvoid runFunction(std::string inputDirectory = \".\", "
-          "std::string outputDirectory = \".\", size_t stratumIndex = (size_t) -1, bool performIO = false) "
-          "{\n";
+    decl << "void runFunction(std::string inputDirectory = \".\", std::string outputDirectory = \".\", "
+            "size_t stratumIndex = (size_t) -1, bool performIO = false);\n";
+    os << "void " << classname << "::runFunction(std::string inputDirectory, "
+          "std::string outputDirectory, size_t stratumIndex, bool performIO) {\n";
+
+    // strata evaluated concurrently by the shm engine share the signal handler set up by main
+    const bool concurrentStrata = Global::config().get("engine") == "shm";
+    if (!concurrentStrata) {
+        os << "SignalHandler::instance()->set();\n";
+        if (Global::config().has("verbose")) {
+            os << "SignalHandler::instance()->enableLogging();\n";
+        }
+    }
+
+    // the inputs are read in the background from the start on, and inserted into their relations by the loads
+    if (Global::config().has("prefetch-input")) {
+        os << "if (performIO) {\n";
+        visitDepthFirst(
+                *(prog.getMain()), [&](const RamLoad& load) { emitLoad(os, load, LoadMode::PREFETCH); });
+        os << "}\n";
+    }
 
-    os << "SignalHandler::instance()->set();\n";
-    if (Global::config().has("verbose")) {
-        os << "SignalHandler::instance()->enableLogging();\n";
+    // the tuples retracted before the first evaluation are removed from their relations
+    if (Global::config().has("incremental")) {
+        for (const auto& cur : prog.getAllRelations()) {
+            if (cur.first.find("@deleted_") == 0) {
+                const std::string deleted = getRelationName(*cur.second);
+                os << "if (!evaluated && !" << deleted << "->empty()) {\n";
+                os << "eraseTuples(*" << getRelationName(cur.first.substr(9))
+                   << ", [&](const Tuple<RamDomain," << cur.second->getArity() << ">& cur) { return "
+                   << deleted << "->contains(cur); });\n";
+                os << "}\n";
+            }
+        }
     }
 
-    bool hasIncrement = false;
-    visitDepthFirst(*(prog.getMain()), [&](const RamAutoIncrement& inc) { hasIncrement = true; });
     // initialize counter
-    if (hasIncrement) {
-        os << "// -- initialize counter --\n";
+    os << "// -- initialize counter --\n";
+    if (Global::config().has("checkpoints")) {
+        os << "std::atomic<RamDomain> ctr(checkpoint ? checkpoint->getCounter() : 0);\n\n";
+    } else {
         os << "std::atomic<RamDomain> ctr(0);\n\n";
     }
     os << "std::atomic<size_t> iter(0);\n\n";
@@ -2006,12 +3857,20 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
         os << "omp_set_num_threads(" << std::stoi(Global::config().get("jobs")) << ");\n";
         os << "#endif\n\n";
     }
+    if (std::stoi(Global::config().get("jobs")) != 1) {
+        os << "#ifdef __EMBEDDED_SOUFFLE__\n";
+        os << "souffle::ParallelPolicy::instance().setJobs(" << Global::config().get("jobs") << ");\n";
+        os << "#endif\n\n";
+    }
 
     // add actual program body
     os << "// -- query evaluation --\n";
     if (Global::config().has("profile")) {
         os << "ProfileEventSingleton::instance().startTimer();\n";
         os << R"_(ProfileEventSingleton::instance().makeTimeEvent("@time;starttime");)_" << '\n';
+        if (Global::config().has("profile-sampling")) {
+            os << "SampleProfiler::instance().start(getSampleRules());\n";
+        }
         os << "{\n"
            << R"_(Logger logger("@runtime;", 0);)_" << '\n';
         // Store count of relations
@@ -2065,17 +3924,103 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
         }
     }
 
+    // run independent strata concurrently, each calling its unit
+    if (dependencies->isConcurrent()) {
+        os << "{static const std::vector<std::vector<int>> predecessors = {";
+        for (const auto& cur : dependencies->getPredecessors()) {
+            os << "{" << join(cur, ",") << "},";
+        }
+        os << "};\n";
+        os << "size_t jobs = 1;\n";
+        os << "#ifdef _OPENMP\n";
+        os << "jobs = omp_get_max_threads();\n";
+        os << "#endif\n";
+        os << "souffle::shm::runStrata(predecessors, jobs, [&](int stratum) {\n";
+        os << "switch (stratum) {\n";
+        visitDepthFirst(*(prog.getMain()), [&](const RamStratum& stratum) {
+            os << "case " << stratum.getIndex() << ":\n";
+            if (Global::config().has("trace")) {
+                os << "{TraceLog::Span span(\"stratum " << stratum.getIndex() << "\", \"stratum\");\n";
+            }
+            os << "runStratum<" << stratumKeys[stratum.getIndex()]
+               << ">(inputDirectory, outputDirectory, performIO, ctr, iter);\n";
+            if (Global::config().has("trace")) {
+                os << "}\n";
+            }
+            os << "break;\n";
+        });
+        os << "}\n";
+        os << "});}\n";
+    }
+
     // Set up stratum
     visitDepthFirst(*(prog.getMain()), [&](const RamStratum& stratum) {
+        if (dependencies->isConcurrent()) {
+            return;
+        }
         os << "/* BEGIN STRATUM " << stratum.getIndex() << " */\n";
         if (Global::config().has("engine")) {
             // go to the stratum with the max value for int as a suffix if calling the master stratum
             auto i = stratum.getIndex();
             os << "STRATUM_" << i << ":\n";
         }
-        os << "[&]() {\n";
-        emitCode(os, stratum.getBody());
-        os << "}();\n";
+        // the strata completed by an earlier run of the mpi engine only notify the master process
+        const bool stored =
+                Global::config().has("mpi-store") && stratum.getIndex() != std::numeric_limits<int>::max();
+        if (stored) {
+            os << "\n#ifdef USE_MPI\n";
+            os << "if (mpiStore.isCompleted(" << stratum.getIndex() << ")) {\n";
+            os << "souffle::mpi::send(0, SymbolTable::exitTag());\n";
+            os << "} else\n";
+            os << "#endif\n";
+            os << "{\n";
+        }
+        // the strata completed by a resumed checkpoint are skipped, the others saved once completed
+        if (Global::config().has("checkpoints")) {
+            os << "if (!checkpoint || !checkpoint->isCompleted(" << stratum.getIndex() << ")) {\n";
+        }
+        if (Global::config().has("profile")) {
+            os << "memoryStratum = " << stratum.getIndex() << ";\n";
+        }
+        // the strata whose inputs are unchanged since a cached run restore their relations instead
+        const std::string cacheLookup =
+                Global::config().has("stratum-cache") ? getStratumCacheLookup(stratum) : "";
+        if (!cacheLookup.empty()) {
+            os << "if (" << cacheLookup << ") {\n";
+            os << "restoreStratum(" << stratum.getIndex() << ", outputDirectory, performIO);\n";
+            os << "} else {\n";
+        }
+        if (Global::config().has("trace")) {
+            os << "{TraceLog::Span span(\"stratum " << stratum.getIndex() << "\", \"stratum\");\n";
+        }
+        os << "runStratum<" << stratumKeys[stratum.getIndex()]
+           << ">(inputDirectory, outputDirectory, performIO, ctr, iter);\n";
+        if (Global::config().has("trace")) {
+            os << "}\n";
+        }
+        if (!cacheLookup.empty()) {
+            os << "if (performIO) {\n";
+            os << "cacheStratum(" << stratum.getIndex() << ");\n";
+            os << "}\n";
+            os << "}\n";
+        }
+        if (Global::config().has("profile")) {
+            os << "recordMemory(" << stratum.getIndex() << ");\n";
+        }
+        if (Global::config().has("checkpoints")) {
+            os << "if (checkpoint) {\n";
+            os << "checkpointStratum(" << stratum.getIndex() << ", ctr);\n";
+            os << "}\n";
+            os << "}\n";
+        }
+        if (stored) {
+            os << "\n#ifdef USE_MPI\n";
+            os << "if (souffle::mpi::groupRank() == 0) {\n";
+            os << "mpiStore.commit(" << stratum.getIndex() << ");\n";
+            os << "}\n";
+            os << "#endif\n";
+            os << "}\n";
+        }
         if (Global::config().has("engine")) {
             os << "if (stratumIndex != (size_t) -1) goto EXIT;\n";
         }
@@ -2086,9 +4031,35 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
         os << "EXIT:{}";
     }
 
+    if (Global::config().has("async-output")) {
+        os << "writeQueue.wait();\n";
+    }
+
+    if (Global::config().has("statistics")) {
+        // the relations never dropped are complete once the program ends, the others collected before
+        std::set<std::string> dropped;
+        visitDepthFirst(*(prog.getMain()), [&](const RamDrop& drop) {
+            dropped.insert(drop.getRelation().getName());
+        });
+        os << "if (performIO) {\n";
+        visitDepthFirst(*(prog.getMain()), [&](const RamCreate& create) {
+            const RamRelation& rel = create.getRelation();
+            if (!rel.isTemp() && dropped.count(rel.getName()) == 0) {
+                emitCollectStatistics(os, rel);
+            }
+        });
+        os << "statistics.save();\n";
+        os << "}\n";
+    }
+
     if (Global::config().has("profile")) {
         os << "}\n";
+        os << "ProfileEventSingleton::instance().makeNumaRecords();\n";
+        os << "ProfileEventSingleton::instance().makeLockRecords();\n";
         os << "ProfileEventSingleton::instance().stopTimer();\n";
+        if (Global::config().has("profile-sampling")) {
+            os << "SampleProfiler::instance().stop();\n";
+        }
         os << "dumpFreqs();\n";
     }
 
@@ -2104,16 +4075,35 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
     });
     os << "}\n";
 
-    os << "SignalHandler::instance()->reset();\n";
+    // the tuples inserted and retracted before are part of the evaluation, which the incremental updates
+    // continue from unless the relations were dropped by performing IO
+    const auto& purgeChanges = [&]() {
+        for (const auto& cur : prog.getAllRelations()) {
+            if (cur.first.find("@added_") == 0 || cur.first.find("@deleted_") == 0) {
+                os << getRelationName(*cur.second) << "->purge();\n";
+            }
+        }
+    };
+    if (Global::config().has("incremental")) {
+        purgeChanges();
+        os << "counter = ctr;\n";
+        os << "evaluated = !performIO;\n";
+    }
+
+    if (!concurrentStrata) {
+        os << "SignalHandler::instance()->reset();\n";
+    }
 
     os << "}\n";  // end of runFunction() method
 
     // add methods to run with and without performing IO (mainly for the interface)
-    os << "public:\nvoid run(size_t stratumIndex = (size_t) -1) override { runFunction(\".\", \".\", "
+    decl << "public:\nvoid run(size_t stratumIndex = (size_t) -1) override;\n";
+    os << "void " << classname << "::run(size_t stratumIndex) { runFunction(\".\", \".\", "
           "stratumIndex, false); }\n";
-    os << "public:\nvoid runAll(std::string inputDirectory = \".\", std::string outputDirectory = \".\", "
-          "size_t stratumIndex = (size_t) -1) "
-          "override { ";
+    decl << "public:\nvoid runAll(std::string inputDirectory = \".\", std::string outputDirectory = \".\", "
+            "size_t stratumIndex = (size_t) -1) override;\n";
+    os << "void " << classname << "::runAll(std::string inputDirectory, std::string outputDirectory, "
+          "size_t stratumIndex) { ";
     if (Global::config().has("live-profile")) {
         os << "std::thread profiler([]() { profile::Tui().runProf(); });\n";
     }
@@ -2123,9 +4113,72 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
     }
     os << "}\n";
 
+    // issue the incremental update, over-deleting the tuples derived from those deleted in all strata
+    // before updating them in turn, and skipping the strata none of whose relations changed
+    if (Global::config().has("incremental")) {
+        decl << "public:\nvoid runIncremental() override;\n";
+        os << "void " << classname << "::runIncremental() {\n";
+        os << "if (!evaluated) {\n";
+        os << "run();\n";
+        os << "return;\n";
+        os << "}\n";
+        os << "SignalHandler::instance()->set();\n";
+        os << "std::atomic<RamDomain> ctr(counter);\n";
+        os << "std::atomic<size_t> iter(0);\n";
+        const auto& subroutines = prog.getSubroutines();
+        for (const std::string phase : {"incremental_delete_", "incremental_"}) {
+            visitDepthFirst(*(prog.getMain()), [&](const RamStratum& stratum) {
+                auto update = subroutines.find(phase + std::to_string(stratum.getIndex()));
+                if (update == subroutines.end()) {
+                    return;
+                }
+                std::set<std::string> changed;
+                visitDepthFirst(*update->second, [&](const RamRelationReference& ref) {
+                    const std::string& name = ref.get()->getName();
+                    for (const std::string prefix : {"@added_", "@deleted_"}) {
+                        if (name.find(prefix) == 0) {
+                            changed.insert("!" + getRelationName(name) + "->empty()");
+                        } else if (!ref.get()->isTemp() && prog.getRelation(prefix + name) != nullptr) {
+                            changed.insert("!" + getRelationName(prefix + name) + "->empty()");
+                        }
+                    }
+                });
+                os << "/* BEGIN STRATUM " << stratum.getIndex() << " */\n";
+                os << "if (" << join(changed, " || ") << ") {\n";
+                emitCode(os, *update->second);
+                os << "}\n";
+                os << "/* END STRATUM " << stratum.getIndex() << " */\n";
+            });
+        }
+        purgeChanges();
+        os << "counter = ctr;\n";
+        os << "SignalHandler::instance()->reset();\n";
+        os << "}\n";
+    }
+
+    // issue the reset, clearing the relations while keeping their memory
+    decl << "public:\nvoid reset() override;\n";
+    os << "void " << classname << "::reset() {\n";
+    visitDepthFirst(*(prog.getMain()), [&](const RamCreate& create) {
+        os << "resetRelation(*" << getRelationName(create.getRelation()) << ");\n";
+    });
+    if (Global::config().has("incremental")) {
+        os << "evaluated = false;\n";
+    }
+    os << "}\n";
+
+    // issue the eviction of the lazy indexes, releasing memory once the memory limit is reached
+    decl << "private:\nvoid evictIndexes();\n";
+    os << "void " << classname << "::evictIndexes() {\n";
+    visitDepthFirst(*(prog.getMain()), [&](const RamCreate& create) {
+        os << "souffle::evictIndexes(*" << getRelationName(create.getRelation()) << ");\n";
+    });
+    os << "}\n";
+
     // issue printAll method
-    os << "public:\n";
-    os << "void printAll(std::string outputDirectory = \".\") override {\n";
+    decl << "public:\n";
+    decl << "void printAll(std::string outputDirectory = \".\") override;\n";
+    os << "void " << classname << "::printAll(std::string outputDirectory) {\n";
     visitDepthFirst(*(prog.getMain()), [&](const RamStatement& node) {
         if (auto store = dynamic_cast<const RamStore*>(&node)) {
             std::vector<bool> symbolMask;
@@ -2135,14 +4188,15 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
             for (IODirectives ioDirectives : store->getIODirectives()) {
                 os << "try {";
                 os << "std::map<std::string, std::string> directiveMap(" << ioDirectives << ");\n";
-                os << R"_(if (!outputDirectory.empty() && directiveMap["IO"] == "file" && )_";
+                os << R"_(if (!outputDirectory.empty() && IODirectives::isFileType(directiveMap["IO"]) && )_";
                 os << "directiveMap[\"filename\"].front() != '/') {";
                 os << R"_(directiveMap["filename"] = outputDirectory + "/" + directiveMap["filename"];)_";
                 os << "}\n";
                 os << "IODirectives ioDirectives(directiveMap);\n";
                 os << "IOSystem::getInstance().getWriter(";
                 os << "std::vector<bool>({" << join(symbolMask) << "})";
-                os << ", symTable, ioDirectives, " << (Global::config().has("provenance") ? "true" : "false");
+                os << ", " << getSymbolTableName(store->getRelation()) << ", ioDirectives, "
+                   << (store->getRelation().hasProvenanceColumns() ? "true" : "false");
                 os << ")->writeAll(*" << getRelationName(store->getRelation()) << ");\n";
 
                 os << "} catch (std::exception& e) {std::cerr << e.what();exit(1);}\n";
@@ -2151,10 +4205,26 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
     });
     os << "}\n";  // end of printAll() method
 
+    if (Global::config().has("checkpoints")) {
+        emitCheckpoints(decl, os, classname);
+    }
+
+    if (Global::config().has("stratum-cache")) {
+        emitStratumCache(decl, os, classname);
+    }
+
     // dumpFreqs method
     if (Global::config().has("profile")) {
-        os << "private:\n";
-        os << "void dumpFreqs() {\n";
+        decl << "private:\n";
+        decl << "void dumpFreqs();\n";
+        if (Global::config().has("profile-indexes")) {
+            decl << "static bool countProbe(size_t* counts, bool found) {\n";
+            decl << "counts[0]++;\n";
+            decl << "if (!found) counts[1]++;\n";
+            decl << "return found;\n";
+            decl << "}\n";
+        }
+        os << "void " << classname << "::dumpFreqs() {\n";
         for (auto const& cur : idxMap) {
             os << "\tProfileEventSingleton::instance().makeQuantityEvent(R\"_(" << cur.first << ")_\", freqs["
                << cur.second << "],0);\n";
@@ -2163,41 +4233,66 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
             os << "\tProfileEventSingleton::instance().makeQuantityEvent(R\"_(@relation-reads;" << cur.first
                << ")_\", reads[" << cur.second << "],0);\n";
         }
+        for (auto const& cur : indexStatsIdxMap) {
+            auto sep = cur.first.find(';');
+            os << "\tProfileEventSingleton::instance().makeIndexEvents(R\"_(" << cur.first.substr(0, sep)
+               << ")_\",\"" << cur.first.substr(sep + 1) << "\",";
+            for (size_t i = 0; i < 4; i++) {
+                os << "indexStats[" << cur.second << "][" << i << "]" << (i < 3 ? "," : ");\n");
+            }
+        }
         os << "}\n";  // end of dumpFreqs() method
+
+        // the labels of the sampled rules by their number
+        if (Global::config().has("profile-sampling")) {
+            decl << "static std::vector<std::string> getSampleRules();\n";
+            std::vector<std::string> labels(sampleIdxMap.size() + 1);
+            for (const auto& cur : sampleIdxMap) {
+                labels[cur.second] = cur.first;
+            }
+            os << "std::vector<std::string> " << classname << "::getSampleRules() {\n";
+            os << "return {\n";
+            for (const auto& label : labels) {
+                os << "\tR\"_(" << label << ")_\",\n";
+            }
+            os << "};\n";
+            os << "}\n";  // end of getSampleRules() method
+        }
+
+        // the memory of relations at the end of strata and before their drop
+        decl << "void recordMemory(size_t stratum);\n";
+        decl << "size_t memoryStratum = 0;\n";
+        os << "void " << classname << "::recordMemory(size_t stratum) {\n";
+        visitDepthFirst(*(prog.getMain()), [&](const RamCreate& create) {
+            os << "ProfileEventSingleton::instance().makeRelationMemoryEvents(stratum, R\"_("
+               << create.getRelation().getName() << ")_\", " << getRelationName(create.getRelation())
+               << "->getMemoryUsage());\n";
+        });
+        os << "ProfileEventSingleton::instance().makeMemoryEvent(stratum, \"symbols\", "
+              "symTable.getMemoryUsage());\n";
+        os << "ProfileEventSingleton::instance().makeMemoryEvent(stratum, \"records\", "
+              "getRecordMemoryUsage());\n";
+        os << "}\n";  // end of recordMemory() method
     }
 
     // issue loadAll method
-    os << "public:\n";
-    os << "void loadAll(std::string inputDirectory = \".\") override {\n";
-    visitDepthFirst(*(prog.getMain()), [&](const RamLoad& load) {
-        // get some table details
-        std::vector<bool> symbolMask;
-        for (auto& cur : load.getRelation().getAttributeTypeQualifiers()) {
-            symbolMask.push_back(cur[0] == 's');
-        }
-        for (IODirectives ioDirectives : load.getIODirectives()) {
-            os << "try {";
-            os << "std::map<std::string, std::string> directiveMap(";
-            os << ioDirectives << ");\n";
-            os << R"_(if (!inputDirectory.empty() && directiveMap["IO"] == "file" && )_";
-            os << "directiveMap[\"filename\"].front() != '/') {";
-            os << R"_(directiveMap["filename"] = inputDirectory + "/" + directiveMap["filename"];)_";
-            os << "}\n";
-            os << "IODirectives ioDirectives(directiveMap);\n";
-            os << "IOSystem::getInstance().getReader(";
-            os << "std::vector<bool>({" << join(symbolMask) << "})";
-            os << ", symTable, ioDirectives";
-            os << ", " << (Global::config().has("provenance") ? "true" : "false");
-            os << ")->readAll(*" << getRelationName(load.getRelation());
-            os << ");\n";
-            os << "} catch (std::exception& e) {std::cerr << \"Error loading data: \" << e.what() << "
-                  "'\\n';}\n";
-        }
-    });
+    decl << "public:\n";
+    decl << "void loadAll(std::string inputDirectory = \".\") override;\n";
+    os << "void " << classname << "::loadAll(std::string inputDirectory) {\n";
+    if (Global::config().has("prefetch-input")) {
+        // all inputs are read concurrently, and inserted in turn
+        visitDepthFirst(*(prog.getMain()),
+                [&](const RamLoad& load) { emitLoad(os, load, LoadMode::PREFETCH); });
+        visitDepthFirst(*(prog.getMain()),
+                [&](const RamLoad& load) { emitLoad(os, load, LoadMode::INSERT_PREFETCHED); });
+    } else {
+        visitDepthFirst(*(prog.getMain()), [&](const RamLoad& load) { emitLoad(os, load, LoadMode::READ); });
+    }
     os << "}\n";  // end of loadAll() method
 
     // issue dump methods
-    auto dumpRelation = [&](const std::string& name, const std::vector<std::string>& mask, size_t arity) {
+    auto dumpRelation = [&](const std::string& name, const std::string& symbols,
+                                const std::vector<std::string>& mask, bool provenance) {
         auto relName = name;
         std::vector<bool> symbolMask;
         for (auto& cur : mask) {
@@ -2210,77 +4305,125 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
         os << "ioDirectives.setRelationName(\"" << name << "\");\n";
         os << "IOSystem::getInstance().getWriter(";
         os << "std::vector<bool>({" << join(symbolMask) << "})";
-        os << ", symTable, ioDirectives, " << (Global::config().has("provenance") ? "true" : "false");
+        os << ", " << symbols << ", ioDirectives, " << (provenance ? "true" : "false");
         os << ")->writeAll(*" << relName << ");\n";
         os << "} catch (std::exception& e) {std::cerr << e.what();exit(1);}\n";
     };
 
     // dump inputs
-    os << "public:\n";
-    os << "void dumpInputs(std::ostream& out = std::cout) override {\n";
+    decl << "public:\n";
+    decl << "void dumpInputs(std::ostream& out = std::cout) override;\n";
+    os << "void " << classname << "::dumpInputs(std::ostream& out) {\n";
     visitDepthFirst(*(prog.getMain()), [&](const RamLoad& load) {
         auto& name = getRelationName(load.getRelation());
         auto& mask = load.getRelation().getAttributeTypeQualifiers();
-        size_t arity = load.getRelation().getArity();
-        dumpRelation(name, mask, arity);
+        dumpRelation(name, getSymbolTableName(load.getRelation()), mask,
+                load.getRelation().hasProvenanceColumns());
     });
     os << "}\n";  // end of dumpInputs() method
 
     // dump outputs
-    os << "public:\n";
-    os << "void dumpOutputs(std::ostream& out = std::cout) override {\n";
+    decl << "public:\n";
+    decl << "void dumpOutputs(std::ostream& out = std::cout) override;\n";
+    os << "void " << classname << "::dumpOutputs(std::ostream& out) {\n";
     visitDepthFirst(*(prog.getMain()), [&](const RamStore& store) {
         auto& name = getRelationName(store.getRelation());
         auto& mask = store.getRelation().getAttributeTypeQualifiers();
-        size_t arity = store.getRelation().getArity();
-        dumpRelation(name, mask, arity);
+        dumpRelation(name, getSymbolTableName(store.getRelation()), mask,
+                store.getRelation().hasProvenanceColumns());
     });
     os << "}\n";  // end of dumpOutputs() method
 
-    os << "public:\n";
-    os << "SymbolTable& getSymbolTable() override {\n";
+    decl << "public:\n";
+    decl << "SymbolTable& getSymbolTable() override;\n";
+    os << "SymbolTable& " << classname << "::getSymbolTable() {\n";
     os << "return symTable;\n";
     os << "}\n";  // end of getSymbolTable() method
 
     // TODO: generate code for subroutines
     if (Global::config().has("provenance")) {
         // generate subroutine adapter
-        os << "void executeSubroutine(std::string name, const std::vector<RamDomain>& args, "
-              "std::vector<RamDomain>& ret, std::vector<bool>& err) override {\n";
-
-        // subroutine number
-        size_t subroutineNum = 0;
-        for (auto& sub : prog.getSubroutines()) {
-            os << "if (name == \"" << sub.first << "\") {\n"
-               << "subproof_" << subroutineNum
-               << "(args, ret, err);\n"  // subproof_i to deal with special characters in relation names
-               << "}\n";
-            subroutineNum++;
-        }
+        const std::string subroutineParams =
+                "(std::string name, const std::vector<RamDomain>& args, std::vector<RamDomain>& ret, "
+                "std::vector<bool>& err)";
+        decl << "void executeSubroutine" << subroutineParams << " override;\n";
+        os << "void " << classname << "::executeSubroutine" << subroutineParams << " {\n";
+        os << "int id = getSubroutineId(name);\n";
+        os << "if (id >= 0) {\n";
+        os << "runSubroutine(id, args, ret, err);\n";
+        os << "}\n";
         os << "}\n";  // end of executeSubroutine
 
+        // ids are the positions of the subroutines in the sorted list of their names
+        decl << "int getSubroutineId(const std::string& name) const override;\n";
+        os << "int " << classname << "::getSubroutineId(const std::string& name) const {\n";
+        os << "static const std::vector<std::string> names = {";
+        os << join(prog.getSubroutines(), ", ",
+                [](std::ostream& out, const std::pair<const std::string, RamStatement*>& sub) {
+                    out << "\"" << sub.first << "\"";
+                });
+        os << "};\n";
+        os << "auto pos = std::lower_bound(names.begin(), names.end(), name);\n";
+        os << "return pos != names.end() && *pos == name ? static_cast<int>(pos - names.begin()) : -1;\n";
+        os << "}\n";  // end of getSubroutineId
+
+        const std::string runParams =
+                "(size_t id, const std::vector<RamDomain>& args, std::vector<RamDomain>& ret, "
+                "std::vector<bool>& err)";
+        decl << "void runSubroutine" << runParams << " override;\n";
+        os << "void " << classname << "::runSubroutine" << runParams << " {\n";
+        os << "switch (id) {\n";
+
+        for (size_t i = 0; i < prog.getSubroutines().size(); i++) {
+            // subproof_i to deal with special characters in relation names
+            os << "case " << i << ": subproof_" << i << "(args, ret, err); break;\n";
+        }
+        os << "default: break;\n";
+        os << "}\n";
+        os << "}\n";  // end of runSubroutine
+
+        // emit the bodies of the subroutines in parallel, as the strata
+        std::vector<const RamStatement*> subroutines;
+        for (const auto& sub : prog.getSubroutines()) {
+            subroutines.push_back(sub.second);
+        }
+        int numSubroutines = subroutines.size();
+        std::vector<std::string> subroutineBodies(numSubroutines);
+#pragma omp parallel for schedule(dynamic) if (!Global::config().has("profile"))
+        for (int i = 0; i < numSubroutines; i++) {
+            std::stringstream body;
+            emitCode(body, *subroutines[i]);
+            subroutineBodies[i] = body.str();
+        }
+
         // generate method for each subroutine
-        subroutineNum = 0;
-        for (auto& sub : prog.getSubroutines()) {
+        for (size_t i = 0; i < subroutines.size(); i++) {
             // method header
-            os << "void "
-               << "subproof_" << subroutineNum
-               << "(const std::vector<RamDomain>& args, "
-                  "std::vector<RamDomain>& ret, std::vector<bool>& err) {\n";
+            const std::string params =
+                    "(const std::vector<RamDomain>& args, std::vector<RamDomain>& ret, "
+                    "std::vector<bool>& err)";
+            decl << "void subproof_" << i << params << ";\n";
+            os << "void " << classname << "::subproof_" << i << params << " {\n";
 
             // a lock is needed when filling the subroutine return vectors
             os << "std::mutex lock;\n";
 
             // generate code for body
-            emitCode(os, *sub.second);
+            os << subroutineBodies[i];
 
             os << "return;\n";
             os << "}\n";  // end of subroutine
-            subroutineNum++;
         }
     }
 
-    os << "};\n";  // end of class declaration
+    // the counters of each index: probes, empty probes, scans and tuples, sized once all code is emitted
+    if (Global::config().has("profile") && Global::config().has("profile-indexes")) {
+        decl << "private:\n";
+        decl << "size_t indexStats[" << std::max<size_t>(indexStatsIdxMap.size(), 1) << "][4]{};\n";
+    }
+
+    decl << "};\n";  // end of class declaration
+    decl << "}\n";
 
     // hidden hooks
     os << "SouffleProgram *newInstance_" << id << "(){return new " << classname << ";}\n";
@@ -2316,6 +4459,12 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
     }
     os << std::stoi(Global::config().get("jobs")) << ",\n";
     os << "-1";
+    if (Global::config().has("numa") || Global::config().has("checkpoints")) {
+        os << ",\nR\"(" << Global::config().get("numa") << ")\"";
+    }
+    if (Global::config().has("checkpoints")) {
+        os << ",\ntrue";
+    }
     os << ");\n";
 
     os << "if (!opt.parse(argc,argv)) return 1;\n";
@@ -2342,22 +4491,107 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
            << '\n';
         os << R"_(souffle::ProfileEventSingleton::instance().makeConfigRecord("version", ")_"
            << Global::config().get("version") << R"_(");)_" << '\n';
+        size_t strataCount = 0;
+        visitDepthFirst(*(prog.getMain()), [&](const RamStratum& stratum) { ++strataCount; });
+        os << R"_(souffle::ProfileEventSingleton::instance().makeConfigRecord("strataCount", ")_"
+           << strataCount << R"_(");)_" << '\n';
     }
 #ifdef USE_MPI
     if (Global::config().get("engine") == "mpi") {
         os << "\n#ifdef USE_MPI\n";
         os << "souffle::mpi::init(argc, argv);";
         os << "int rank = souffle::mpi::commRank();";
-        os << "int stratum = (rank == 0) ? " << std::numeric_limits<int>::max() << " : rank - 1;";
+        // the strata of each rank, followed by the additional ranks of partitioned strata
+        const auto* schedule = translationUnit.getAnalysis<RamMpiScheduleAnalysis>();
+        os << "static const std::vector<std::vector<int>> strataOfRanks = {";
+        for (const auto& strata : schedule->getStrataOfRanks()) {
+            os << "{" << join(strata, ",") << "},";
+        }
+        for (int stratum : schedule->getPartitionStrata()) {
+            os << "{" << stratum << "},";
+        }
+        os << "};";
+        // the threads of a node, all hardware threads unless given by -j, are shared among its ranks by
+        // the costs of their strata, such that ranks placed on the same node do not oversubscribe it
+        os << "static const std::vector<double> costsOfRanks = {" << join(schedule->getRankCosts(), ",")
+           << "};";
+        os << "#ifdef _OPENMP\n";
+        os << "{size_t jobs = souffle::mpi::nodeThreads(rank < (int)costsOfRanks.size() ? costsOfRanks[rank] "
+              ": 0, opt.getNumJobs() > 0 ? opt.getNumJobs() : std::thread::hardware_concurrency());";
+        os << "omp_set_num_threads(jobs);";
+        os << "souffle::ParallelPolicy::instance().setJobs(jobs);}\n";
+        os << "#endif\n";
+        os << "if (rank >= (int)strataOfRanks.size()) {";
+        os << R"(std::cerr << "Error: too many MPI processes.\n"; souffle::mpi::finalize(); return 1;)";
+        os << "}";
+        os << "const std::vector<int>& strata = strataOfRanks[rank];";
+        // ranks of a hostfile without a stratum take part in forming the groups only
+        os << "souffle::mpi::splitGroup(strata.empty() ? MPI_UNDEFINED : strata.front());";
+        if (schedule->isPacked()) {
+            os << "souffle::mpi::detachSends() = true;";
+        }
+        // all ranks learn the strata completed by earlier runs before any stratum of this run completes
+        if (Global::config().has("mpi-store")) {
+            int numberOfStrata = 0;
+            visitDepthFirst(*(prog.getMain()), [&](const RamStratum& stratum) {
+                if (stratum.getIndex() != std::numeric_limits<int>::max()) {
+                    numberOfStrata = std::max(numberOfStrata, stratum.getIndex() + 1);
+                }
+            });
+            os << "obj.mpiStore.open(" << numberOfStrata << ");";
+            os << "MPI_Barrier(MPI_COMM_WORLD);";
+        }
+        // each rank holds and serves a shard of the symbols, rather than the master process all of them
+        os << "obj.getSymbolTable().distribute();";
+        os << "for (int stratum : strata) {";
         os << "obj.runAll(opt.getInputFileDir(), opt.getOutputFileDir(), stratum);\n";
+        os << "}";
+        os << "souffle::mpi::finishSends();";
+        os << "obj.getSymbolTable().stopServing();";
         os << "souffle::mpi::finalize();";
         os << "\n#endif\n";
     } else
 #endif
-    {
+            if (Global::config().get("engine") == "shm") {
+        // the strata each stratum waits for, which include the sources of the relations it receives
+        os << "static const std::vector<std::vector<int>> predecessors = {";
+        for (const auto& cur : dependencies->getPredecessors()) {
+            os << "{" << join(cur, ",") << "},";
+        }
+        os << "};";
+        os << "souffle::SignalHandler::instance()->set();";
+        if (Global::config().has("verbose")) {
+            os << "souffle::SignalHandler::instance()->enableLogging();";
+        }
+        os << "souffle::shm::runStrata(predecessors, opt.getNumJobs(), [&](int stratum) {";
+        os << "obj.runAll(opt.getInputFileDir(), opt.getOutputFileDir(), stratum);";
+        os << "});\n";
+        os << "souffle::SignalHandler::instance()->reset();\n";
+    } else {
+        if (Global::config().has("checkpoints")) {
+            os << "if (!opt.getCheckpointDir().empty()) {\n";
+            os << "obj.setCheckpoint(opt.getCheckpointDir(), opt.isResuming());\n";
+            os << "}\n";
+        }
+        // a resident program loads its inputs once and answers queries by incremental updates
+        os << "if (opt.getServerPort() != 0) {\n";
+        if (Global::config().has("incremental")) {
+            os << "obj.loadAll(opt.getInputFileDir());\n";
+            os << "obj.run();\n";
+            os << "souffle::QueryServer(obj).serve(opt.getServerPort());\n";
+            os << "return 0;\n";
+        } else {
+            os << R"(std::cerr << "Error: serving queries requires a program compiled with --incremental\n";)";
+            os << "\nreturn 1;\n";
+        }
+        os << "}\n";
         os << "obj.runAll(opt.getInputFileDir(), opt.getOutputFileDir(), opt.getStratumIndex());\n";
     }
 
+    if (Global::config().has("symbols-out")) {
+        os << "obj.getSymbolTable().save(R\"_(" << Global::config().get("symbols-out") << ")_\");\n";
+    }
+
     if (Global::config().get("provenance") == "explain") {
         os << "explain(obj, false);\n";
     } else if (Global::config().get("provenance") == "explore") {
@@ -2367,6 +4601,14 @@ void Synthesiser::generateCode(std::ostream& os, const std::string& id, bool& wi
     os << "} catch(std::exception &e) { souffle::SignalHandler::instance()->error(e.what());}\n";
     os << "}\n";
     os << "\n#endif\n";
+
+    if (header != nullptr) {
+        *header << decl.str();
+    }
+    out << decl.str();
+    out << "namespace souffle {\n";
+    out << "using namespace ram;\n";
+    out << os.str();
 }
 
 }  // end of namespace souffle
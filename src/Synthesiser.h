@@ -23,9 +23,11 @@
 #include <ostream>
 #include <set>
 #include <string>
+#include <vector>
 
 namespace souffle {
 
+class RamLoad;
 class RamOperation;
 class RamTranslationUnit;
 class SynthesiserRelation;
@@ -48,8 +50,20 @@ private:
     /** Frequency profiling of non-existence checks */
     std::map<std::string, size_t> neIdxMap;
 
-    /** Cache for generated types for relations */
-    std::set<std::string> typeCache;
+    /** Access profiling of indexes */
+    std::map<std::string, size_t> indexStatsIdxMap;
+
+    /** Rules attributed samples by the sampling profiler, numbered from one */
+    std::map<std::string, size_t> sampleIdxMap;
+
+    /** Relations stored in append buffers */
+    std::set<std::string> appendBuffers;
+
+    /** Merges moving the nodes of their source, which is cleared right after them */
+    std::set<const RamMerge*> absorbingMerges;
+
+    /** Constant patterns of match constraints, compiled by members of the program */
+    std::set<RamDomain> regexPatterns;
 
 protected:
     /** Convert RAM identifier */
@@ -64,11 +78,14 @@ protected:
     /** Get relation name */
     const std::string getRelationName(const std::string& relName);
 
+    /** Get the name of the symbol table holding the symbols of a relation */
+    const std::string getSymbolTableName(const RamRelation& rel);
+
     /** Get context name */
     const std::string getOpContextName(const RamRelation& rel);
 
-    /** Get relation struct definition */
-    void generateRelationTypeStruct(std::ostream& out, std::unique_ptr<SynthesiserRelation> relationType);
+    /** Compute the names and analyses the emission of statements shares ahead of emitting them */
+    void prepareParallelEmission();
 
     /* Convert SearchColums to a template index */
     std::string toIndex(SearchSignature key);
@@ -79,12 +96,43 @@ protected:
     /** Generate code */
     void emitCode(std::ostream& out, const RamStatement& stmt);
 
+    /** The ways the inputs of a load are read by the generated code */
+    enum class LoadMode { READ, PREFETCH, INSERT_PREFETCHED };
+
+    /** Generate code reading the inputs of a load, starting to read them, or inserting them once read */
+    void emitLoad(std::ostream& out, const RamLoad& load, LoadMode mode);
+
+    /** Generate the members saving the state of the program after each stratum, and restoring it */
+    void emitCheckpoints(std::ostream& decl, std::ostream& os, const std::string& classname);
+
+    /** Generate the members restoring the relations of strata from the cache, and saving them into it */
+    void emitStratumCache(std::ostream& decl, std::ostream& os, const std::string& classname);
+
+    /** Get the condition looking up the results of a stratum in the cache, empty if they are not cached */
+    std::string getStratumCacheLookup(const RamStratum& stratum);
+
+    /** Get the relations a stratum computes, saved into the stratum cache */
+    std::vector<const RamRelation*> getCachedRelations(const RamStratum& stratum);
+
+    /** Generate code adding the distinct and frequent values of a relation to the statistics catalog */
+    void emitCollectStatistics(std::ostream& out, const RamRelation& rel);
+
     /** Lookup frequency counter */
     unsigned lookupFreqIdx(const std::string& txt);
 
     /** Lookup read counter */
     size_t lookupReadIdx(const std::string& txt);
 
+    /** Lookup access counters of the index of a relation serving the given search */
+    size_t lookupIndexStatsIdx(const RamRelation& rel, SearchSignature keys);
+
+    /** Lookup the number of a rule attributed samples, given its sample label */
+    size_t lookupSampleIdx(const std::string& label);
+
+    /** Generate code, emitting the strata into separate translation units if a header is given */
+    void generateProgram(std::ostream& os, const std::string& id, bool& withSharedLibrary,
+            std::ostream* header, std::vector<std::string>* strata);
+
 public:
     Synthesiser(RamTranslationUnit& tUnit) : translationUnit(tUnit) {}
     virtual ~Synthesiser() = default;
@@ -96,5 +144,15 @@ public:
 
     /** Generate code */
     void generateCode(std::ostream& os, const std::string& id, bool& withSharedLibrary);
+
+    /**
+     * Generate code whose strata are compiled separately. The declarations
+     * shared by all translation units are written to the header as well as
+     * to the main unit, and the definition of each stratum is appended to the
+     * given list. The code of a stratum has to be preceded by an inclusion of
+     * the header to form a translation unit.
+     */
+    void generateCode(std::ostream& os, const std::string& id, bool& withSharedLibrary, std::ostream& header,
+            std::vector<std::string>& strata);
 };
 }  // end of namespace souffle
@@ -17,8 +17,9 @@
 
 namespace souffle {
 
-std::unique_ptr<SynthesiserRelation> SynthesiserRelation::getSynthesiserRelation(
-        const RamRelation& ramRel, const MinIndexSelection& indexSet, bool isProvenance) {
+std::unique_ptr<SynthesiserRelation> SynthesiserRelation::getSynthesiserRelation(const RamRelation& ramRel,
+        const MinIndexSelection& indexSet, bool isProvenance,
+        const std::set<SearchSignature>& filteredSearches) {
     SynthesiserRelation* rel;
 
     // Handle the qualifier in souffle code
@@ -26,18 +27,35 @@ std::unique_ptr<SynthesiserRelation> SynthesiserRelation::getSynthesiserRelation
         rel = new SynthesiserDirectRelation(ramRel, indexSet, isProvenance);
     } else if (ramRel.isNullary()) {
         rel = new SynthesiserNullaryRelation(ramRel, indexSet, isProvenance);
+    } else if (SynthesiserBufferRelation::isApplicable(ramRel, indexSet, isProvenance)) {
+        rel = new SynthesiserBufferRelation(ramRel, indexSet, isProvenance);
+    } else if (ramRel.getRepresentation() == RelationRepresentation::STORAGE) {
+        rel = new SynthesiserStorageRelation(ramRel, indexSet, isProvenance);
     } else if (ramRel.getRepresentation() == RelationRepresentation::BTREE) {
-        rel = new SynthesiserDirectRelation(ramRel, indexSet, isProvenance);
+        rel = new SynthesiserDirectRelation(ramRel, indexSet, isProvenance, filteredSearches);
     } else if (ramRel.getRepresentation() == RelationRepresentation::BRIE) {
         rel = new SynthesiserBrieRelation(ramRel, indexSet, isProvenance);
     } else if (ramRel.getRepresentation() == RelationRepresentation::EQREL) {
         rel = new SynthesiserEqrelRelation(ramRel, indexSet, isProvenance);
+    } else if (ramRel.getRepresentation() == RelationRepresentation::COMPRESSED) {
+        rel = new SynthesiserCompressedRelation(ramRel, indexSet, isProvenance);
+    } else if (ramRel.getRepresentation() == RelationRepresentation::HASHSET) {
+        rel = new SynthesiserHashRelation(ramRel, indexSet, isProvenance);
+    } else if (ramRel.getRepresentation() == RelationRepresentation::MMAP) {
+        rel = new SynthesiserMappedRelation(ramRel, indexSet, isProvenance);
+    } else if (ramRel.getRepresentation() == RelationRepresentation::BITMAP) {
+        // bitmap sets only store pairs, other arities (e.g. with provenance columns) are left to the brie
+        if (ramRel.getArity() == 2) {
+            rel = new SynthesiserBitmapRelation(ramRel, indexSet, isProvenance);
+        } else {
+            rel = new SynthesiserBrieRelation(ramRel, indexSet, isProvenance);
+        }
     } else {
         // Handle the data structure command line flag
         if (ramRel.getArity() > 6) {
             rel = new SynthesiserIndirectRelation(ramRel, indexSet, isProvenance);
         } else {
-            rel = new SynthesiserDirectRelation(ramRel, indexSet, isProvenance);
+            rel = new SynthesiserDirectRelation(ramRel, indexSet, isProvenance, filteredSearches);
         }
     }
 
@@ -49,6 +67,27 @@ std::unique_ptr<SynthesiserRelation> SynthesiserRelation::getSynthesiserRelation
     return std::unique_ptr<SynthesiserRelation>(rel);
 }
 
+void SynthesiserRelation::generateMemoryUsage(std::ostream& out, bool withIndexes,
+        const std::vector<std::pair<std::string, std::string>>& members) const {
+    std::vector<std::pair<std::string, std::string>> parts;
+    if (withIndexes) {
+        const auto& inds = getIndices();
+        for (size_t i = 0; i < inds.size(); i++) {
+            parts.push_back(std::make_pair(toString(join(inds[i], ",")), "ind_" + std::to_string(i)));
+        }
+    }
+    parts.insert(parts.end(), members.begin(), members.end());
+
+    out << "std::vector<std::pair<std::string, std::size_t>> getMemoryUsage() const {\n";
+    out << "return {";
+    for (size_t i = 0; i < parts.size(); i++) {
+        out << (i == 0 ? "" : ", ") << "{\"" << parts[i].first << "\", " << parts[i].second
+            << ".getMemoryUsage()}";
+    }
+    out << "};\n";
+    out << "}\n";
+}
+
 // -------- Nullary Relation --------
 
 /** Generate index set for a nullary relation, which should be empty */
@@ -122,15 +161,683 @@ void SynthesiserDirectRelation::computeIndices() {
         }
     }
 
-    masterIndex = 0;
-
+    masterIndex = 0;
+
+    computedIndices = inds;
+
+    // number the indexes serving the searches
+    std::map<MinIndexSelection::LexOrder, int> indexToNumMap;
+    for (size_t i = 0; i < indices.getAllOrders().size(); i++) {
+        indexToNumMap[indices.getAllOrders()[i]] = i;
+    }
+    for (SearchSignature search : indices.getSearches()) {
+        searchIndexes[search] = indexToNumMap[indices.getLexOrder(search)];
+    }
+    for (const auto& search : indices.getOrderedSearches()) {
+        orderedIndexes.insert(indices.getOrderedLexOrderNum(search.first, search.second));
+    }
+}
+
+/**
+ * Generate type name of a direct indexed relation
+ *
+ * The name is given by the arity, the indexes and the filtered searches alone, such
+ * that relations differing only in their other searches share a type serving all of them.
+ */
+std::string SynthesiserDirectRelation::getTypeName() {
+    std::stringstream res;
+    res << "t_btree_" << getArity();
+
+    for (auto& ind : getIndices()) {
+        res << "__" << join(ind, "_");
+    }
+    if (!filteredSearches.empty()) {
+        res << "__f" << join(filteredSearches, "_");
+    }
+
+    return res.str();
+}
+
+/** Extend the searches of a direct indexed relation by those of a relation of the same type */
+void SynthesiserDirectRelation::merge(const SynthesiserRelation& other) {
+    const auto& direct = dynamic_cast<const SynthesiserDirectRelation&>(other);
+    searchIndexes.insert(direct.searchIndexes.begin(), direct.searchIndexes.end());
+    orderedIndexes.insert(direct.orderedIndexes.begin(), direct.orderedIndexes.end());
+}
+
+/** Generate type struct of a direct indexed relation */
+void SynthesiserDirectRelation::generateTypeStruct(std::ostream& out) {
+    size_t arity = getArity();
+    const auto& inds = getIndices();
+    size_t numIndexes = inds.size();
+
+    // struct definition
+    out << "struct " << getTypeName() << " {\n";
+
+    // stored tuple type
+    out << "using t_tuple = Tuple<RamDomain, " << arity << ">;\n";
+
+    // generate an updater class for provenance
+    if (isProvenance) {
+        out << "struct updater_" << getTypeName() << " {\n";
+        out << "void update(t_tuple& old_t, const t_tuple& new_t) {\n";
+        out << "old_t[" << arity - 2 << "] = new_t[" << arity - 2 << "];\n";
+        out << "old_t[" << arity - 1 << "] = new_t[" << arity - 1 << "];\n";
+        out << "}\n";
+        out << "};\n";
+    }
+
+    // generate the btree type for each relation
+    for (size_t i = 0; i < inds.size(); i++) {
+        auto& ind = inds[i];
+
+        // for provenance, all indices must be full so we use btree_set
+        // also strong/weak comparators and updater methods
+        if (isProvenance) {
+            out << "using t_ind_" << i << " = btree_set<t_tuple, index_utils::comparator<" << join(ind);
+            out << ">, std::allocator<t_tuple>, 256, typename "
+                   "souffle::detail::default_strategy<t_tuple>::type, index_utils::comparator<";
+            out << join(ind.begin(), ind.end() - 2) << ">, updater_" << getTypeName() << ">;\n";
+
+            // without provenance, some indices may be not full, so we use btree_multiset for those
+        } else {
+            // the nodes are taken from pools, kept for the tuples inserted after a reset
+            if (ind.size() == arity) {
+                out << "using t_ind_" << i << " = btree_set<t_tuple, index_utils::comparator<" << join(ind)
+                    << ">, btree_node_pool, 256, index_utils::btree_strategy<t_tuple, " << ind.size()
+                    << ">>;\n";
+            } else {
+                out << "using t_ind_" << i << " = btree_multiset<t_tuple, index_utils::comparator<"
+                    << join(ind) << ">, btree_node_pool>;\n";
+            }
+        }
+        if (isLazy(i)) {
+            out << "mutable t_ind_" << i << " ind_" << i << ";\n";
+            out << "mutable std::atomic<bool> materialised_" << i << "{false};\n";
+        } else {
+            out << "t_ind_" << i << " ind_" << i << ";\n";
+        }
+    }
+
+    // typedef master index iterator to be struct iterator
+    out << "using iterator = t_ind_" << masterIndex << "::iterator;\n";
+
+    // create a struct storing hints for each btree, optionally buffering insertions of a single thread
+    out << "struct context {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        out << "t_ind_" << i << "::operation_hints hints_" << i << ";\n";
+    }
+    out << "InsertBuffer buffer;\n";
+    out << getTypeName() << "* target = nullptr;\n";
+    out << "context() = default;\n";
+    out << "context(context&&) = default;\n";
+    out << "~context() { if (target != nullptr) target->flushBuffer(*this); }\n";
+    out << "};\n";
+    out << "context createContext() { return context(); }\n";
+    out << "context createBufferedContext() {\n";
+    out << "context h;\n";
+    out << "h.buffer = InsertBuffer(" << arity << ");\n";
+    out << "h.target = this;\n";
+    out << "return h;\n";
+    out << "}\n";
+
+    // secondary indexes are bulk-loaded from the master index on their first use, and
+    // maintained by inserts from then on
+    if (numIndexes > 1 && !isProvenance) {
+        out << "mutable Lock materialiseLock;\n";
+    }
+    for (size_t i = 0; i < numIndexes; i++) {
+        if (!isLazy(i)) {
+            continue;
+        }
+        out << "void materialise_" << i << "() const {\n";
+        out << "if (materialised_" << i << ".load(std::memory_order_acquire)) return;\n";
+        out << "auto lease = materialiseLock.acquire();\n";
+        out << "(void)lease;\n";
+        out << "if (materialised_" << i << ".load(std::memory_order_relaxed)) return;\n";
+        out << "std::vector<t_tuple> buffer(ind_" << masterIndex << ".begin(), ind_" << masterIndex
+            << ".end());\n";
+        out << "index_utils::comparator<" << join(inds[i]) << "> comp;\n";
+        out << "std::sort(buffer.begin(), buffer.end(), [&](const t_tuple& a, const t_tuple& b) { "
+               "return comp.less(a, b); });\n";
+        out << "t_ind_" << i << " loaded = t_ind_" << i << "::load(buffer.begin(), buffer.end());\n";
+        out << "ind_" << i << ".swap(loaded);\n";
+        out << "materialised_" << i << ".store(true, std::memory_order_release);\n";
+        out << "}\n";
+    }
+
+    // Bloom filters of searches are built from the master index on their first use, and
+    // invalidated by inserts
+    for (SearchSignature search : filteredSearches) {
+        out << "mutable BloomFilter filter_" << search << "{" << search << "};\n";
+        out << "mutable std::atomic<bool> filled_" << search << "{false};\n";
+    }
+    if (!filteredSearches.empty()) {
+        out << "mutable Lock filterLock;\n";
+    }
+    auto invalidateFilters = [&]() {
+        for (SearchSignature search : filteredSearches) {
+            out << "if (filled_" << search << ".load(std::memory_order_relaxed)) filled_" << search
+                << ".store(false, std::memory_order_relaxed);\n";
+        }
+    };
+
+    // insert methods
+    out << "bool insert(const t_tuple& t) {\n";
+    out << "context h;\n";
+    out << "return insert(t, h);\n";
+    out << "}\n";  // end of insert(t_tuple&)
+
+    // buffered tuples count as new, as they are only merged into the indexes when flushed
+    out << "bool insert(const t_tuple& t, context& h) {\n";
+    out << "if (h.target != nullptr) {\n";
+    out << "if (h.buffer.insert(&t[0])) flushBuffer(h);\n";
+    out << "return true;\n";
+    out << "}\n";
+    out << "if (ind_" << masterIndex << ".insert(t, h.hints_" << masterIndex << ")) {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        if (isLazy(i)) {
+            out << "if (materialised_" << i << ".load(std::memory_order_relaxed)) ";
+            out << "ind_" << i << ".insert(t, h.hints_" << i << ");\n";
+        } else if (i != masterIndex) {
+            out << "ind_" << i << ".insert(t, h.hints_" << i << ");\n";
+        }
+    }
+    invalidateFilters();
+    out << "return true;\n";
+    out << "} else return false;\n";
+    out << "}\n";  // end of insert(t_tuple&, context&)
+
+    out << "void flushBuffer(context& h) {\n";
+    out << "context hints;\n";
+    out << "h.buffer.flush([&](const RamDomain* row) {\n";
+    out << "insert(reinterpret_cast<const t_tuple&>(*row), hints);\n";
+    out << "});\n";
+    out << "}\n";  // end of flushBuffer(context&)
+
+    out << "bool insert(const RamDomain* ramDomain) {\n";
+    out << "RamDomain data[" << arity << "];\n";
+    out << "std::copy(ramDomain, ramDomain + " << arity << ", data);\n";
+    out << "const t_tuple& tuple = reinterpret_cast<const t_tuple&>(data);\n";
+    out << "context h;\n";
+    out << "return insert(tuple, h);\n";
+    out << "}\n";  // end of insert(RamDomain*)
+
+    std::vector<std::string> decls, params;
+    for (size_t i = 0; i < arity; i++) {
+        decls.push_back("RamDomain a" + std::to_string(i));
+        params.push_back("a" + std::to_string(i));
+    }
+    out << "bool insert(" << join(decls, ",") << ") {\n";
+    out << "RamDomain data[" << arity << "] = {" << join(params, ",") << "};\n";
+    out << "return insert(data);\n";
+    out << "}\n";  // end of insert(RamDomain x1, RamDomain x2, ...)
+
+    // insertAll methods
+    out << "template <typename T>\n";
+    out << "void insertAll(T& other) {\n";
+    out << "context h;\n";
+    out << "for (auto const& cur : other) {\n";
+    out << "insert(cur, h);\n";
+    out << "}\n";
+    out << "}\n";  // end of insertAll<T>
+
+    out << "void insertAll(" << getTypeName() << "& other) {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        if (isLazy(i)) {
+            out << "if (!materialised_" << i << ".load(std::memory_order_relaxed)) {\n";
+            out << "} else if (other.materialised_" << i << ".load(std::memory_order_relaxed)) {\n";
+            out << "ind_" << i << ".insertAll(other.ind_" << i << ");\n";
+            out << "} else {\n";
+            out << "t_ind_" << i << "::operation_hints hints;\n";
+            out << "for (const auto& cur : other.ind_" << masterIndex << ") ind_" << i
+                << ".insert(cur, hints);\n";
+            out << "}\n";
+        } else {
+            out << "ind_" << i << ".insertAll(other.ind_" << i << ");\n";
+        }
+    }
+    invalidateFilters();
+    out << "}\n";  // end of insertAll(relationType& other)
+
+    // contains methods
+    out << "bool contains(const t_tuple& t, context& h) const {\n";
+    out << "return ind_" << masterIndex << ".contains(t, h.hints_" << masterIndex << ");\n";
+    out << "}\n";
+
+    out << "bool contains(const t_tuple& t) const {\n";
+    out << "context h;\n";
+    out << "return contains(t, h);\n";
+    out << "}\n";
+
+    // size method
+    out << "std::size_t size() const {\n";
+    out << "return ind_" << masterIndex << ".size();\n";
+    out << "}\n";
+
+    // find methods
+    out << "iterator find(const t_tuple& t, context& h) const {\n";
+    out << "return ind_" << masterIndex << ".find(t, h.hints_" << masterIndex << ");\n";
+    out << "}\n";
+
+    out << "iterator find(const t_tuple& t) const {\n";
+    out << "context h;\n";
+    out << "return find(t, h);\n";
+    out << "}\n";
+
+    // empty equalRange method
+    out << "range<iterator> equalRange_0(const t_tuple& t, context& h) const {\n";
+    out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
+    out << "}\n";
+
+    out << "range<iterator> equalRange_0(const t_tuple& t) const {\n";
+    out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
+    out << "}\n";
+
+    // equalRange methods for each pattern which is used to search this relation
+    for (const auto& searchIndex : searchIndexes) {
+        SearchSignature search = searchIndex.first;
+        size_t indNum = searchIndex.second;
+
+        out << "range<t_ind_" << indNum << "::iterator> equalRange_" << search;
+        out << "(const t_tuple& t, context& h) const {\n";
+        if (isLazy(indNum)) {
+            out << "materialise_" << indNum << "();\n";
+        }
+
+        // count size of search pattern
+        size_t indSize = 0;
+        for (size_t column = 0; column < arity; column++) {
+            if ((search >> column) & 1) {
+                indSize++;
+            }
+        }
+
+        // use the more efficient find() method if the search pattern is full
+        if (indSize == arity) {
+            out << "auto pos = ind_" << indNum << ".find(t, h.hints_" << indNum << ");\n";
+            out << "auto fin = ind_" << indNum << ".end();\n";
+            out << "if (pos != fin) {fin = pos; ++fin;}\n";
+            out << "return make_range(pos, fin);\n";
+        } else {
+            // generate lower and upper bounds for range search
+            out << "t_tuple low(t); t_tuple high(t);\n";
+            // check which indices to pad out
+            for (size_t column = 0; column < arity; column++) {
+                // if bit number column is set
+                if (!((search >> column) & 1)) {
+                    out << "low[" << column << "] = MIN_RAM_DOMAIN;\n";
+                    out << "high[" << column << "] = MAX_RAM_DOMAIN;\n";
+                }
+            }
+            out << "return make_range(ind_" << indNum << ".lower_bound(low, h.hints_" << indNum << "), ind_"
+                << indNum << ".upper_bound(high, h.hints_" << indNum << "));\n";
+        }
+        out << "}\n";
+
+        out << "range<t_ind_" << indNum << "::iterator> equalRange_" << search;
+        out << "(const t_tuple& t) const {\n";
+        out << "context h;\n";
+        out << "return equalRange_" << search << "(t, h);\n";
+        out << "}\n";
+
+        // the b-tree counts the tuples of a range without iterating through them
+        out << "std::size_t countRange_" << search << "(const t_tuple& t, context& h) const {\n";
+        out << "auto range = equalRange_" << search << "(t, h);\n";
+        out << "return ind_" << indNum << ".countRange(range.begin(), range.end());\n";
+        out << "}\n";
+
+        // lower bounds of a batch of searches, whose unbound columns hold MIN_RAM_DOMAIN already
+        if (indSize < arity) {
+            out << "void lowerBounds_" << search << "(const t_tuple* t, std::size_t n, t_ind_" << indNum
+                << "::iterator* res) const {\n";
+            if (isLazy(indNum)) {
+                out << "materialise_" << indNum << "();\n";
+            }
+            out << "ind_" << indNum << ".lower_bounds(t, n, res);\n";
+            out << "}\n";
+        }
+    }
+
+    // existence checks descending the index of their search once to the first tuple not below the
+    // bound values, consulting the Bloom filter of the search before the index if it has one
+    std::set<SearchSignature> existenceSearches(filteredSearches);
+    for (const auto& searchIndex : searchIndexes) {
+        existenceSearches.insert(searchIndex.first);
+    }
+    for (SearchSignature search : existenceSearches) {
+        if (search == 0) {
+            continue;
+        }
+        out << "bool exists_" << search << "(const t_tuple& t, context& h) const {\n";
+        if (isFiltered(search)) {
+            out << "if (!filled_" << search << ".load(std::memory_order_acquire)) {\n";
+            out << "auto lease = filterLock.acquire();\n";
+            out << "(void)lease;\n";
+            out << "if (!filled_" << search << ".load(std::memory_order_relaxed)) {\n";
+            out << "filter_" << search << ".build(ind_" << masterIndex << ", ind_" << masterIndex
+                << ".size());\n";
+            out << "filled_" << search << ".store(true, std::memory_order_release);\n";
+            out << "}\n";
+            out << "}\n";
+            out << "if (!filter_" << search << ".mayContain(t)) return false;\n";
+        }
+        if (search == (SearchSignature(1) << arity) - 1) {
+            out << "return contains(t, h);\n";
+        } else {
+            size_t indNum = searchIndexes.at(search);
+            if (isLazy(indNum)) {
+                out << "materialise_" << indNum << "();\n";
+            }
+            out << "t_tuple low(t);\n";
+            std::vector<std::string> matches;
+            for (size_t column = 0; column < arity; column++) {
+                if ((search >> column) & 1) {
+                    matches.push_back("(*pos)[" + std::to_string(column) + "] == t[" +
+                                      std::to_string(column) + "]");
+                } else {
+                    out << "low[" << column << "] = MIN_RAM_DOMAIN;\n";
+                }
+            }
+            out << "auto pos = ind_" << indNum << ".lower_bound(low, h.hints_" << indNum << ");\n";
+            out << "return pos != ind_" << indNum << ".end() && " << join(matches, " && ") << ";\n";
+        }
+        out << "}\n";
+    }
+
+    // lowerBound and boundedRange methods for each index serving the ordered searches of intersections
+    // and range scans
+    for (int indNum : orderedIndexes) {
+        out << "bool lowerBound_" << indNum << "(const t_tuple& low, t_tuple& res, context& h) const {\n";
+        if (isLazy(indNum)) {
+            out << "materialise_" << indNum << "();\n";
+        }
+        out << "auto pos = ind_" << indNum << ".lower_bound(low, h.hints_" << indNum << ");\n";
+        out << "if (pos == ind_" << indNum << ".end()) return false;\n";
+        out << "res = *pos;\n";
+        out << "return true;\n";
+        out << "}\n";
+
+        // the tuples between the bounds, bounding the column following the bound ones of a search
+        out << "range<t_ind_" << indNum << "::iterator> boundedRange_" << indNum
+            << "(const t_tuple& low, const t_tuple& high, context& h) const {\n";
+        if (isLazy(indNum)) {
+            out << "materialise_" << indNum << "();\n";
+        }
+        out << "return make_range(ind_" << indNum << ".lower_bound(low, h.hints_" << indNum << "), ind_"
+            << indNum << ".upper_bound(high, h.hints_" << indNum << "));\n";
+        out << "}\n";
+        out << "range<t_ind_" << indNum << "::iterator> boundedRange_" << indNum
+            << "(const t_tuple& low, const t_tuple& high) const {\n";
+        out << "context h;\n";
+        out << "return boundedRange_" << indNum << "(low, high, h);\n";
+        out << "}\n";
+    }
+
+    // empty method
+    out << "bool empty() const {\n";
+    out << "return ind_" << masterIndex << ".empty();\n";
+    out << "}\n";
+
+    // partition method for parallelism
+    out << "std::vector<range<iterator>> partition() const {\n";
+    out << "return ind_" << masterIndex << ".getChunks(400);\n";
+    out << "}\n";
+
+    // purge method
+    out << "void purge() {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".clear();\n";
+    }
+    invalidateFilters();
+    out << "}\n";
+
+    // reset method, keeping the nodes of the indexes
+    out << "void reset() {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".reset();\n";
+    }
+    invalidateFilters();
+    out << "}\n";
+
+    // evictIndexes method, releasing the lazy indexes to be bulk-loaded again on their next use
+    bool hasLazy = false;
+    for (size_t i = 0; i < numIndexes; i++) {
+        hasLazy = hasLazy || isLazy(i);
+    }
+    if (hasLazy) {
+        out << "void evictIndexes() {\n";
+        for (size_t i = 0; i < numIndexes; i++) {
+            if (isLazy(i)) {
+                out << "ind_" << i << ".clear();\n";
+                out << "materialised_" << i << ".store(false, std::memory_order_relaxed);\n";
+            }
+        }
+        out << "}\n";
+    }
+
+    // reserve method, obtaining the nodes of the indexes for the expected number of tuples in advance;
+    // lazy indexes are bulk-loaded into trees of their own
+    out << "void reserve(size_t n) {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        if (!isLazy(i)) {
+            out << "ind_" << i << ".reserve(n);\n";
+        }
+    }
+    out << "}\n";
+
+    // begin and end iterators
+    out << "iterator begin() const {\n";
+    out << "return ind_" << masterIndex << ".begin();\n";
+    out << "}\n";
+
+    out << "iterator end() const {\n";
+    out << "return ind_" << masterIndex << ".end();\n";
+    out << "}\n";
+
+    // printHintStatistics method
+    out << "void printHintStatistics(std::ostream& o, const std::string prefix) const {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        out << "const auto& stats_" << i << " = ind_" << i << ".getHintStatistics();\n";
+        out << "o << prefix << \"arity " << getArity() << " direct b-tree index " << inds[i]
+            << ": (hits/misses/total)\\n\";\n";
+        out << "o << prefix << \"Insert: \" << stats_" << i << ".inserts.getHits() << \"/\" << stats_" << i
+            << ".inserts.getMisses() << \"/\" << stats_" << i << ".inserts.getAccesses() << \"\\n\";\n";
+        out << "o << prefix << \"Contains: \" << stats_" << i << ".contains.getHits() << \"/\" << stats_" << i
+            << ".contains.getMisses() << \"/\" << stats_" << i << ".contains.getAccesses() << \"\\n\";\n";
+        out << "o << prefix << \"Lower-bound: \" << stats_" << i
+            << ".lower_bound.getHits() << \"/\" << stats_" << i
+            << ".lower_bound.getMisses() << \"/\" << stats_" << i
+            << ".lower_bound.getAccesses() << \"\\n\";\n";
+        out << "o << prefix << \"Upper-bound: \" << stats_" << i
+            << ".upper_bound.getHits() << \"/\" << stats_" << i
+            << ".upper_bound.getMisses() << \"/\" << stats_" << i
+            << ".upper_bound.getAccesses() << \"\\n\";\n";
+    }
+    out << "}\n";
+
+    // getMemoryUsage method
+    std::vector<std::pair<std::string, std::string>> filters;
+    for (SearchSignature search : filteredSearches) {
+        filters.push_back(
+                std::make_pair("filter " + std::to_string(search), "filter_" + std::to_string(search)));
+    }
+    generateMemoryUsage(out, true, filters);
+
+    // end struct
+    out << "};\n";
+}
+
+// -------- Append Buffer Relation --------
+
+/**
+ * Delta relations of b-tree relations which are only scanned entirely are
+ * collected in append buffers; their new knowledge is of the same type, and
+ * its only other use is the merge into the full relation.
+ */
+bool SynthesiserBufferRelation::isApplicable(
+        const RamRelation& ramRel, const MinIndexSelection& indexSet, bool isProvenance) {
+    if (isProvenance || !ramRel.isTemp() || ramRel.getName().find("@delta") == std::string::npos) {
+        return false;
+    }
+    if (ramRel.getRepresentation() != RelationRepresentation::DEFAULT &&
+            ramRel.getRepresentation() != RelationRepresentation::BTREE) {
+        return false;
+    }
+    return indexSet.isScannedOnly();
+}
+
+/** Generate index set for an append buffer, which is not indexed */
+void SynthesiserBufferRelation::computeIndices() {
+    computedIndices = {};
+}
+
+/** Generate type name of an append buffer relation */
+std::string SynthesiserBufferRelation::getTypeName() {
+    return "t_buffer_" + std::to_string(getArity());
+}
+
+/** Generate type struct of an append buffer relation */
+void SynthesiserBufferRelation::generateTypeStruct(std::ostream& out) {
+    size_t arity = getArity();
+
+    // struct definition
+    out << "struct " << getTypeName() << " {\n";
+
+    // stored tuple type
+    out << "using t_tuple = Tuple<RamDomain, " << arity << ">;\n";
+
+    out << "using t_buffer = AppendBuffer<" << arity << ">;\n";
+    out << "t_buffer buffer;\n";
+    out << "using iterator = t_buffer::iterator;\n";
+
+    // each context appends to a block of its own
+    out << "struct context {\n";
+    out << "t_buffer::op_context hints;\n";
+    out << "};\n";
+    out << "context createContext() { return context(); }\n";
+
+    // insert methods
+    out << "bool insert(const t_tuple& t) {\n";
+    out << "return buffer.insert(t);\n";
+    out << "}\n";
+
+    out << "bool insert(const t_tuple& t, context& h) {\n";
+    out << "return buffer.insert(t, h.hints);\n";
+    out << "}\n";
+
+    out << "bool insert(const RamDomain* ramDomain) {\n";
+    out << "RamDomain data[" << arity << "];\n";
+    out << "std::copy(ramDomain, ramDomain + " << arity << ", data);\n";
+    out << "const t_tuple& tuple = reinterpret_cast<const t_tuple&>(data);\n";
+    out << "return insert(tuple);\n";
+    out << "}\n";  // end of insert(RamDomain*)
+
+    std::vector<std::string> decls, params;
+    for (size_t i = 0; i < arity; i++) {
+        decls.push_back("RamDomain a" + std::to_string(i));
+        params.push_back("a" + std::to_string(i));
+    }
+    out << "bool insert(" << join(decls, ",") << ") {\n";
+    out << "RamDomain data[" << arity << "] = {" << join(params, ",") << "};\n";
+    out << "return insert(data);\n";
+    out << "}\n";  // end of insert(RamDomain x1, RamDomain x2, ...)
+
+    // insertAll methods
+    out << "template <typename T>\n";
+    out << "void insertAll(T& other) {\n";
+    out << "context h;\n";
+    out << "for (auto const& cur : other) {\n";
+    out << "insert(cur, h);\n";
+    out << "}\n";
+    out << "}\n";  // end of insertAll<T>
+
+    out << "void insertAll(" << getTypeName() << "& other) {\n";
+    out << "buffer.insertAll(other.buffer);\n";
+    out << "}\n";  // end of insertAll(relationType& other)
+
+    // sorts the content and removes duplicates, in preparation of a merge
+    out << "void consolidate() {\n";
+    out << "buffer.consolidate();\n";
+    out << "}\n";
+
+    out << "std::size_t size() const {\n";
+    out << "return buffer.size();\n";
+    out << "}\n";
+
+    out << "bool empty() const {\n";
+    out << "return buffer.empty();\n";
+    out << "}\n";
+
+    // empty equalRange method
+    out << "range<iterator> equalRange_0(const t_tuple& t, context& h) const {\n";
+    out << "return range<iterator>(buffer.begin(),buffer.end());\n";
+    out << "}\n";
+
+    out << "range<iterator> equalRange_0(const t_tuple& t) const {\n";
+    out << "return range<iterator>(buffer.begin(),buffer.end());\n";
+    out << "}\n";
+
+    // partition method for parallelism
+    out << "std::vector<range<iterator>> partition() const {\n";
+    out << "return buffer.partition(400);\n";
+    out << "}\n";
+
+    out << "void purge() {\n";
+    out << "buffer.clear();\n";
+    out << "}\n";
+
+    // begin and end iterators
+    out << "iterator begin() const {\n";
+    out << "return buffer.begin();\n";
+    out << "}\n";
+
+    out << "iterator end() const {\n";
+    out << "return buffer.end();\n";
+    out << "}\n";
+
+    // printHintStatistics method
+    out << "void printHintStatistics(std::ostream& o, const std::string prefix) const {\n";
+    out << "o << prefix << \"arity " << arity << " append buffer: \" << buffer.size() << \" tuples, \" "
+           "<< buffer.getMemoryUsage() << \" bytes\\n\";\n";
+    out << "}\n";
+
+    // getMemoryUsage method
+    generateMemoryUsage(out, false, {{"buffer", "buffer"}});
+
+    // end struct
+    out << "};\n";
+}
+
+// -------- Hash Set Relation --------
+
+/** Generate index set for a hash set relation, only ordering tuples for range searches */
+void SynthesiserHashRelation::computeIndices() {
+    MinIndexSelection::OrderCollection inds;
+    for (int64_t search : getMinIndexSelection().getSearches()) {
+        if (!isRangeSearch(search)) {
+            continue;
+        }
+        // expand the search order to be full
+        auto ind = getMinIndexSelection().getLexOrder(search);
+        std::set<int> curIndexElems(ind.begin(), ind.end());
+        for (size_t i = 0; i < getArity(); i++) {
+            if (curIndexElems.find(i) == curIndexElems.end()) {
+                ind.push_back(i);
+            }
+        }
+        if (std::find(inds.begin(), inds.end(), ind) == inds.end()) {
+            inds.push_back(ind);
+        }
+    }
+
     computedIndices = inds;
 }
 
-/** Generate type name of a direct indexed relation */
-std::string SynthesiserDirectRelation::getTypeName() {
+/** Generate type name of a hash set relation */
+std::string SynthesiserHashRelation::getTypeName() {
     std::stringstream res;
-    res << "t_btree_" << getArity();
+    res << "t_hashset_" << getArity();
 
     for (auto& ind : getIndices()) {
         res << "__" << join(ind, "_");
@@ -143,12 +850,11 @@ std::string SynthesiserDirectRelation::getTypeName() {
     return res.str();
 }
 
-/** Generate type struct of a direct indexed relation */
-void SynthesiserDirectRelation::generateTypeStruct(std::ostream& out) {
+/** Generate type struct of a hash set relation */
+void SynthesiserHashRelation::generateTypeStruct(std::ostream& out) {
     size_t arity = getArity();
     const auto& inds = getIndices();
     size_t numIndexes = inds.size();
-    std::map<MinIndexSelection::LexOrder, int> indexToNumMap;
 
     // struct definition
     out << "struct " << getTypeName() << " {\n";
@@ -156,50 +862,23 @@ void SynthesiserDirectRelation::generateTypeStruct(std::ostream& out) {
     // stored tuple type
     out << "using t_tuple = Tuple<RamDomain, " << arity << ">;\n";
 
-    // generate an updater class for provenance
-    if (isProvenance) {
-        out << "struct updater_" << getTypeName() << " {\n";
-        out << "void update(t_tuple& old_t, const t_tuple& new_t) {\n";
-        out << "old_t[" << arity - 2 << "] = new_t[" << arity - 2 << "];\n";
-        out << "old_t[" << arity - 1 << "] = new_t[" << arity - 1 << "];\n";
-        out << "}\n";
-        out << "};\n";
-    }
-
-    // generate the btree type for each relation
-    for (size_t i = 0; i < inds.size(); i++) {
-        auto& ind = inds[i];
-
-        if (i < getMinIndexSelection().getAllOrders().size()) {
-            indexToNumMap[getMinIndexSelection().getAllOrders()[i]] = i;
-        }
-
-        // for provenance, all indices must be full so we use btree_set
-        // also strong/weak comparators and updater methods
-        if (isProvenance) {
-            out << "using t_ind_" << i << " = btree_set<t_tuple, index_utils::comparator<" << join(ind);
-            out << ">, std::allocator<t_tuple>, 256, typename "
-                   "souffle::detail::default_strategy<t_tuple>::type, index_utils::comparator<";
-            out << join(ind.begin(), ind.end() - 2) << ">, updater_" << getTypeName() << ">;\n";
+    // the hash set holding all tuples
+    out << "using t_hash = HashSet<" << arity << ">;\n";
+    out << "t_hash hash;\n";
 
-            // without provenance, some indices may be not full, so we use btree_multiset for those
-        } else {
-            if (ind.size() == arity) {
-                out << "using t_ind_" << i << " = btree_set<t_tuple, index_utils::comparator<" << join(ind)
-                    << ">>;\n";
-            } else {
-                out << "using t_ind_" << i << " = btree_multiset<t_tuple, index_utils::comparator<"
-                    << join(ind) << ">>;\n";
-            }
-        }
+    // the btree types of the orders required by range searches
+    for (size_t i = 0; i < numIndexes; i++) {
+        out << "using t_ind_" << i << " = btree_set<t_tuple, index_utils::comparator<" << join(inds[i])
+            << ">>;\n";
         out << "t_ind_" << i << " ind_" << i << ";\n";
     }
 
-    // typedef master index iterator to be struct iterator
-    out << "using iterator = t_ind_" << masterIndex << "::iterator;\n";
+    // typedef hash set iterator to be struct iterator
+    out << "using iterator = t_hash::iterator;\n";
 
-    // create a struct storing hints for each btree
+    // create a struct storing hints for each data structure
     out << "struct context {\n";
+    out << "t_hash::op_context hash_hints;\n";
     for (size_t i = 0; i < numIndexes; i++) {
         out << "t_ind_" << i << "::operation_hints hints_" << i << ";\n";
     }
@@ -213,11 +892,9 @@ void SynthesiserDirectRelation::generateTypeStruct(std::ostream& out) {
     out << "}\n";  // end of insert(t_tuple&)
 
     out << "bool insert(const t_tuple& t, context& h) {\n";
-    out << "if (ind_" << masterIndex << ".insert(t, h.hints_" << masterIndex << ")) {\n";
+    out << "if (hash.insert(t, h.hash_hints)) {\n";
     for (size_t i = 0; i < numIndexes; i++) {
-        if (i != masterIndex) {
-            out << "ind_" << i << ".insert(t, h.hints_" << i << ");\n";
-        }
+        out << "ind_" << i << ".insert(t, h.hints_" << i << ");\n";
     }
     out << "return true;\n";
     out << "} else return false;\n";
@@ -244,12 +921,14 @@ void SynthesiserDirectRelation::generateTypeStruct(std::ostream& out) {
     // insertAll methods
     out << "template <typename T>\n";
     out << "void insertAll(T& other) {\n";
+    out << "context h;\n";
     out << "for (auto const& cur : other) {\n";
-    out << "insert(cur);\n";
+    out << "insert(cur, h);\n";
     out << "}\n";
     out << "}\n";  // end of insertAll<T>
 
     out << "void insertAll(" << getTypeName() << "& other) {\n";
+    out << "hash.insertAll(other.hash);\n";
     for (size_t i = 0; i < numIndexes; i++) {
         out << "ind_" << i << ".insertAll(other.ind_" << i << ");\n";
     }
@@ -257,7 +936,7 @@ void SynthesiserDirectRelation::generateTypeStruct(std::ostream& out) {
 
     // contains methods
     out << "bool contains(const t_tuple& t, context& h) const {\n";
-    out << "return ind_" << masterIndex << ".contains(t, h.hints_" << masterIndex << ");\n";
+    out << "return hash.contains(t, h.hash_hints);\n";
     out << "}\n";
 
     out << "bool contains(const t_tuple& t) const {\n";
@@ -267,12 +946,12 @@ void SynthesiserDirectRelation::generateTypeStruct(std::ostream& out) {
 
     // size method
     out << "std::size_t size() const {\n";
-    out << "return ind_" << masterIndex << ".size();\n";
+    out << "return hash.size();\n";
     out << "}\n";
 
     // find methods
     out << "iterator find(const t_tuple& t, context& h) const {\n";
-    out << "return ind_" << masterIndex << ".find(t, h.hints_" << masterIndex << ");\n";
+    out << "return hash.find(t, h.hash_hints);\n";
     out << "}\n";
 
     out << "iterator find(const t_tuple& t) const {\n";
@@ -282,49 +961,55 @@ void SynthesiserDirectRelation::generateTypeStruct(std::ostream& out) {
 
     // empty equalRange method
     out << "range<iterator> equalRange_0(const t_tuple& t, context& h) const {\n";
-    out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
+    out << "return range<iterator>(hash.begin(),hash.end());\n";
     out << "}\n";
 
     out << "range<iterator> equalRange_0(const t_tuple& t) const {\n";
-    out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
+    out << "return range<iterator>(hash.begin(),hash.end());\n";
     out << "}\n";
 
     // equalRange methods for each pattern which is used to search this relation
     for (int64_t search : getMinIndexSelection().getSearches()) {
-        auto lexOrder = getMinIndexSelection().getLexOrder(search);
-        size_t indNum = indexToNumMap[lexOrder];
+        if (search == 0) {
+            continue;
+        }
+
+        // full searches are answered by the hash set
+        if (!isRangeSearch(search)) {
+            out << "range<iterator> equalRange_" << search << "(const t_tuple& t, context& h) const {\n";
+            out << "auto pos = hash.find(t, h.hash_hints);\n";
+            out << "auto fin = hash.end();\n";
+            out << "if (pos != fin) {fin = pos; ++fin;}\n";
+            out << "return make_range(pos, fin);\n";
+            out << "}\n";
+
+            out << "range<iterator> equalRange_" << search << "(const t_tuple& t) const {\n";
+            out << "context h;\n";
+            out << "return equalRange_" << search << "(t, h);\n";
+            out << "}\n";
+            continue;
+        }
+
+        // locate the ordered index of the search
+        auto ind = getMinIndexSelection().getLexOrder(search);
+        size_t indNum = 0;
+        while (!std::equal(ind.begin(), ind.end(), inds[indNum].begin())) {
+            indNum++;
+        }
 
         out << "range<t_ind_" << indNum << "::iterator> equalRange_" << search;
         out << "(const t_tuple& t, context& h) const {\n";
 
-        // count size of search pattern
-        size_t indSize = 0;
+        // generate lower and upper bounds for range search
+        out << "t_tuple low(t); t_tuple high(t);\n";
         for (size_t column = 0; column < arity; column++) {
-            if ((search >> column) & 1) {
-                indSize++;
-            }
-        }
-
-        // use the more efficient find() method if the search pattern is full
-        if (indSize == arity) {
-            out << "auto pos = ind_" << indNum << ".find(t, h.hints_" << indNum << ");\n";
-            out << "auto fin = ind_" << indNum << ".end();\n";
-            out << "if (pos != fin) {fin = pos; ++fin;}\n";
-            out << "return make_range(pos, fin);\n";
-        } else {
-            // generate lower and upper bounds for range search
-            out << "t_tuple low(t); t_tuple high(t);\n";
-            // check which indices to pad out
-            for (size_t column = 0; column < arity; column++) {
-                // if bit number column is set
-                if (!((search >> column) & 1)) {
-                    out << "low[" << column << "] = MIN_RAM_DOMAIN;\n";
-                    out << "high[" << column << "] = MAX_RAM_DOMAIN;\n";
-                }
+            if (!((search >> column) & 1)) {
+                out << "low[" << column << "] = MIN_RAM_DOMAIN;\n";
+                out << "high[" << column << "] = MAX_RAM_DOMAIN;\n";
             }
-            out << "return make_range(ind_" << indNum << ".lower_bound(low, h.hints_" << indNum << "), ind_"
-                << indNum << ".upper_bound(high, h.hints_" << indNum << "));\n";
         }
+        out << "return make_range(ind_" << indNum << ".lower_bound(low, h.hints_" << indNum << "), ind_"
+            << indNum << ".upper_bound(high, h.hints_" << indNum << "));\n";
         out << "}\n";
 
         out << "range<t_ind_" << indNum << "::iterator> equalRange_" << search;
@@ -336,16 +1021,17 @@ void SynthesiserDirectRelation::generateTypeStruct(std::ostream& out) {
 
     // empty method
     out << "bool empty() const {\n";
-    out << "return ind_" << masterIndex << ".empty();\n";
+    out << "return hash.empty();\n";
     out << "}\n";
 
     // partition method for parallelism
     out << "std::vector<range<iterator>> partition() const {\n";
-    out << "return ind_" << masterIndex << ".getChunks(400);\n";
+    out << "return hash.partition(400);\n";
     out << "}\n";
 
     // purge method
     out << "void purge() {\n";
+    out << "hash.clear();\n";
     for (size_t i = 0; i < numIndexes; i++) {
         out << "ind_" << i << ".clear();\n";
     }
@@ -353,23 +1039,23 @@ void SynthesiserDirectRelation::generateTypeStruct(std::ostream& out) {
 
     // begin and end iterators
     out << "iterator begin() const {\n";
-    out << "return ind_" << masterIndex << ".begin();\n";
+    out << "return hash.begin();\n";
     out << "}\n";
 
     out << "iterator end() const {\n";
-    out << "return ind_" << masterIndex << ".end();\n";
+    out << "return hash.end();\n";
     out << "}\n";
 
     // printHintStatistics method
     out << "void printHintStatistics(std::ostream& o, const std::string prefix) const {\n";
+    out << "o << prefix << \"arity " << arity << " hash set: \" << hash.size() << \" tuples, \" "
+           "<< hash.getMemoryUsage() << \" bytes\\n\";\n";
     for (size_t i = 0; i < numIndexes; i++) {
         out << "const auto& stats_" << i << " = ind_" << i << ".getHintStatistics();\n";
-        out << "o << prefix << \"arity " << getArity() << " direct b-tree index " << inds[i]
+        out << "o << prefix << \"arity " << arity << " direct b-tree index " << inds[i]
             << ": (hits/misses/total)\\n\";\n";
         out << "o << prefix << \"Insert: \" << stats_" << i << ".inserts.getHits() << \"/\" << stats_" << i
             << ".inserts.getMisses() << \"/\" << stats_" << i << ".inserts.getAccesses() << \"\\n\";\n";
-        out << "o << prefix << \"Contains: \" << stats_" << i << ".contains.getHits() << \"/\" << stats_" << i
-            << ".contains.getMisses() << \"/\" << stats_" << i << ".contains.getAccesses() << \"\\n\";\n";
         out << "o << prefix << \"Lower-bound: \" << stats_" << i
             << ".lower_bound.getHits() << \"/\" << stats_" << i
             << ".lower_bound.getMisses() << \"/\" << stats_" << i
@@ -381,6 +1067,9 @@ void SynthesiserDirectRelation::generateTypeStruct(std::ostream& out) {
     }
     out << "}\n";
 
+    // getMemoryUsage method
+    generateMemoryUsage(out, true, {{"hash", "hash"}});
+
     // end struct
     out << "};\n";
 }
@@ -477,7 +1166,8 @@ void SynthesiserIndirectRelation::generateTypeStruct(std::ostream& out) {
             out << "using t_ind_" << i
                 << " = btree_set<const t_tuple*, index_utils::deref_compare<typename "
                    "index_utils::comparator<"
-                << join(ind) << ">>>;\n";
+                << join(ind) << ">>, std::allocator<const t_tuple*>, 256, "
+                << "index_utils::btree_strategy<const t_tuple*, " << ind.size() << ">>;\n";
         } else {
             out << "using t_ind_" << i
                 << " = btree_multiset<const t_tuple*, index_utils::deref_compare<typename "
@@ -546,8 +1236,9 @@ void SynthesiserIndirectRelation::generateTypeStruct(std::ostream& out) {
     // do not use the specialized insertAll as it will copy references rather than tuples
     out << "template <typename T>\n";
     out << "void insertAll(T& other) {\n";
+    out << "context h;\n";
     out << "for (auto const& cur : other) {\n";
-    out << "insert(cur);\n";
+    out << "insert(cur, h);\n";
     out << "}\n";
     out << "}\n";
 
@@ -679,6 +1370,9 @@ void SynthesiserIndirectRelation::generateTypeStruct(std::ostream& out) {
     }
     out << "}\n";
 
+    // getMemoryUsage method
+    generateMemoryUsage(out, true, {{"tuples", "dataTable"}});
+
     // end struct
     out << "};\n";
 }
@@ -723,7 +1417,7 @@ void SynthesiserBrieRelation::computeIndices() {
 /** Generate type name of a brie relation */
 std::string SynthesiserBrieRelation::getTypeName() {
     std::stringstream res;
-    res << "t_brie_" << getArity();
+    res << "t_" << getStructureName() << "_" << getArity();
 
     for (auto& ind : getIndices()) {
         res << "__" << join(ind, "_");
@@ -751,7 +1445,7 @@ void SynthesiserBrieRelation::generateTypeStruct(std::ostream& out) {
         if (i < getMinIndexSelection().getAllOrders().size()) {
             indexToNumMap[getMinIndexSelection().getAllOrders()[i]] = i;
         }
-        out << "using t_ind_" << i << " = Trie<" << inds[i].size() << ">;\n";
+        out << "using t_ind_" << i << " = " << getIndexType(inds[i].size()) << ";\n";
         out << "t_ind_" << i << " ind_" << i << ";\n";
     }
     out << "using t_tuple = t_ind_" << masterIndex << "::entry_type;\n";
@@ -796,13 +1490,21 @@ void SynthesiserBrieRelation::generateTypeStruct(std::ostream& out) {
     }
     out << "using iterator = iterator_" << masterIndex << ";\n";
 
-    // hints struct
+    // hints struct, optionally buffering insertions of a single thread
     out << "struct context {\n";
     for (size_t i = 0; i < numIndexes; i++) {
         out << "t_ind_" << i << "::op_context hints_" << i << ";\n";
+        out << "TrieInsertBuffer<t_ind_" << i << "> buffer_" << i << ";\n";
     }
     out << "};\n";
     out << "context createContext() { return context(); }\n";
+    out << "context createBufferedContext() {\n";
+    out << "context h;\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        out << "h.buffer_" << i << " = TrieInsertBuffer<t_ind_" << i << ">(ind_" << i << ");\n";
+    }
+    out << "return h;\n";
+    out << "}\n";
 
     // insert methods
     out << "bool insert(const t_tuple& t) {\n";
@@ -811,6 +1513,16 @@ void SynthesiserBrieRelation::generateTypeStruct(std::ostream& out) {
     out << "}\n";
 
     out << "bool insert(const t_tuple& t, context& h) {\n";
+    out << "if (h.buffer_" << masterIndex << ".isActive()) {\n";
+    out << "if (h.buffer_" << masterIndex << ".insert(orderIn_" << masterIndex << "(t))) {\n";
+    for (size_t i = 0; i < numIndexes; i++) {
+        if (i != masterIndex) {
+            out << "h.buffer_" << i << ".insert(orderIn_" << i << "(t));\n";
+        }
+    }
+    out << "return true;\n";
+    out << "} else return false;\n";
+    out << "}\n";
     out << "if (ind_" << masterIndex << ".insert(orderIn_" << masterIndex << "(t), h.hints_" << masterIndex
         << ")) {\n";
     for (size_t i = 0; i < numIndexes; i++) {
@@ -833,8 +1545,9 @@ void SynthesiserBrieRelation::generateTypeStruct(std::ostream& out) {
     // insertAll method
     out << "template <typename T>\n";
     out << "void insertAll(T& other) {\n";
+    out << "context h;\n";
     out << "for (auto const& cur : other) {\n";
-    out << "insert(cur);\n";
+    out << "insert(cur, h);\n";
     out << "}\n";
     out << "}\n";
 
@@ -845,6 +1558,30 @@ void SynthesiserBrieRelation::generateTypeStruct(std::ostream& out) {
     }
     out << "}\n";
 
+    // absorb method, taking over the nodes of a relation about to be cleared
+    if (adoptsNodes()) {
+        out << "void absorb(" << getTypeName() << "& other) {\n";
+        for (size_t i = 0; i < numIndexes; i++) {
+            out << "ind_" << i << ".absorb(other.ind_" << i << ");\n";
+        }
+        out << "}\n";
+    }
+
+    // loadAll method, building each index from the sorted input tuples stored one after the other
+    if (loadsSorted()) {
+        out << "void loadAll(const std::vector<RamDomain>& data) {\n";
+        out << "const t_tuple* tuples = reinterpret_cast<const t_tuple*>(data.data());\n";
+        out << "std::vector<t_tuple> entries(data.size() / " << arity << ");\n";
+        for (size_t i = 0; i < numIndexes; i++) {
+            out << "for (std::size_t k = 0; k < entries.size(); k++) {\n";
+            out << "entries[k] = orderIn_" << i << "(tuples[k]);\n";
+            out << "}\n";
+            out << "std::sort(entries.begin(), entries.end());\n";
+            out << "ind_" << i << ".load(entries.begin(), entries.end());\n";
+        }
+        out << "}\n";
+    }
+
     // insert method
     std::vector<std::string> decls, params;
     for (size_t i = 0; i < arity; i++) {
@@ -920,6 +1657,13 @@ void SynthesiserBrieRelation::generateTypeStruct(std::ostream& out) {
         out << "(const t_tuple& t) const {\n";
         out << "context h; return equalRange_" << search << "(t, h);\n";
         out << "}\n";
+
+        if (countsRanges()) {
+            out << "std::size_t countRange_" << search << "(const t_tuple& t, context& h) const {\n";
+            out << "return ind_" << indNum << ".template countBoundaries<" << indSize << ">(orderIn_"
+                << indNum << "(t), h.hints_" << indNum << ");\n";
+            out << "}\n";
+        }
     }
 
     // empty method
@@ -956,7 +1700,7 @@ void SynthesiserBrieRelation::generateTypeStruct(std::ostream& out) {
     out << "void printHintStatistics(std::ostream& o, const std::string prefix) const {\n";
     for (size_t i = 0; i < numIndexes; i++) {
         out << "const auto& stats_" << i << " = ind_" << i << ".getHintStatistics();\n";
-        out << "o << prefix << \"arity " << arity << " brie index " << inds[i]
+        out << "o << prefix << \"arity " << arity << " " << getStructureName() << " index " << inds[i]
             << ": (hits/misses/total)\\n\";\n";
         out << "o << prefix << \"Insert: \" << stats_" << i << ".inserts.getHits() << \"/\" << stats_" << i
             << ".inserts.getMisses() << \"/\" << stats_" << i << ".inserts.getAccesses() << \"\\n\";\n";
@@ -989,6 +1733,9 @@ void SynthesiserBrieRelation::generateTypeStruct(std::ostream& out) {
         out << "}\n";
     }
 
+    // getMemoryUsage method
+    generateMemoryUsage(out, true);
+
     // end class
     out << "};\n";
 }
@@ -1024,15 +1771,21 @@ void SynthesiserEqrelRelation::generateTypeStruct(std::ostream& out) {
     out << "t_ind_" << masterIndex << " ind_" << masterIndex << ";\n";
 
     // generate auxiliary iterators that reorder tuples according to index orders
-    // generate auxiliary iterators which orderOut
+    // generate auxiliary iterators which orderOut, swapping the pairs of searches on the second element
     out << "class iterator_0 : public std::iterator<std::forward_iterator_tag, t_tuple> {\n";
     out << "    using nested_iterator = typename t_ind_0::iterator;\n";
     out << "    nested_iterator nested;\n";
+    out << "    bool swapped = false;\n";
     out << "    t_tuple value;\n";
 
+    out << "    t_tuple decode(const t_tuple& t) const {\n";
+    out << "        return swapped ? t_tuple({{t[1], t[0]}}) : orderOut_0(t);\n";
+    out << "    }\n";
+
     out << "public:\n";
     out << "    iterator_0() = default;\n";
-    out << "    iterator_0(const nested_iterator& iter) : nested(iter), value(orderOut_0(*iter)) {}\n";
+    out << "    iterator_0(const nested_iterator& iter, bool swapped = false)\n";
+    out << "            : nested(iter), swapped(swapped), value(decode(*iter)) {}\n";
     out << "    iterator_0(const iterator_0& other) = default;\n";
     out << "    iterator_0& operator=(const iterator_0& other) = default;\n";
 
@@ -1054,7 +1807,7 @@ void SynthesiserEqrelRelation::generateTypeStruct(std::ostream& out) {
 
     out << "    iterator_0& operator++() {\n";
     out << "        ++nested;\n";
-    out << "        value = orderOut_0(*nested);\n";
+    out << "        value = decode(*nested);\n";
     out << "        return *this;\n";
     out << "    }\n";
     out << "};\n";
@@ -1099,8 +1852,9 @@ void SynthesiserEqrelRelation::generateTypeStruct(std::ostream& out) {
     // insertAll method
     out << "template <typename T>\n";
     out << "void insertAll(T& other) {\n";
+    out << "context h;\n";
     out << "for (auto const& cur : other) {\n";
-    out << "insert(cur);\n";
+    out << "insert(cur, h);\n";
     out << "}\n";
     out << "}\n";
 
@@ -1132,7 +1886,8 @@ void SynthesiserEqrelRelation::generateTypeStruct(std::ostream& out) {
     out << "return ind_" << masterIndex << ".find(orderIn_" << masterIndex << "(t));\n";
     out << "}\n";
 
-    // equalRange methods, one for each of the 4 possible search patterns
+    // equalRange methods, one for each of the 4 possible search patterns; as the relation is
+    // symmetric, the pairs of a search on the second element are those of the first one swapped
     for (int i = 1; i < 4; i++) {
         out << "range<iterator> equalRange_" << i;
         out << "(const t_tuple& t, context& h) const {\n";
@@ -1143,17 +1898,41 @@ void SynthesiserEqrelRelation::generateTypeStruct(std::ostream& out) {
                 indSize++;
             }
         }
-        out << "auto r = ind_" << masterIndex << ".template getBoundaries<" << indSize << ">(orderIn_"
-            << masterIndex << "(t), h.hints_" << masterIndex << ");\n";
-        out << "return make_range(iterator(r.begin()), iterator(r.end()));\n";
+        if (i == 2) {
+            out << "auto r = ind_" << masterIndex
+                << ".template getBoundaries<1>(t_tuple({{t[1], t[0]}}), h.hints_" << masterIndex << ");\n";
+            out << "return make_range(iterator(r.begin(), true), iterator(r.end(), true));\n";
+        } else {
+            out << "auto r = ind_" << masterIndex << ".template getBoundaries<" << indSize << ">(orderIn_"
+                << masterIndex << "(t), h.hints_" << masterIndex << ");\n";
+            out << "return make_range(iterator(r.begin()), iterator(r.end()));\n";
+        }
         out << "}\n";
 
         out << "range<iterator> equalRange_" << i;
         out << "(const t_tuple& t) const {\n";
         out << "context h; return equalRange_" << i << "(t, h);\n";
         out << "}\n";
+
+        // the classes count their pairs without iterating through them
+        out << "std::size_t countRange_" << i << "(const t_tuple& t, context& h) const {\n";
+        if (i == 2) {
+            out << "return ind_" << masterIndex << ".template countBoundaries<1>(t_tuple({{t[1], t[0]}}));\n";
+        } else {
+            out << "return ind_" << masterIndex << ".template countBoundaries<" << indSize << ">(t);\n";
+        }
+        out << "}\n";
     }
 
+    // the equivalence classes, for joins through the classes rather than through their pairs
+    out << "range<t_ind_" << masterIndex << "::class_iterator> classes() const {\n";
+    out << "return ind_" << masterIndex << ".classes();\n";
+    out << "}\n";
+
+    out << "std::vector<range<t_ind_" << masterIndex << "::class_iterator>> partitionClasses() const {\n";
+    out << "return ind_" << masterIndex << ".partitionClasses(400);\n";
+    out << "}\n";
+
     // empty method
     out << "bool empty() const {\n";
     out << "return ind_" << masterIndex << ".size() == 0;\n";
@@ -1210,10 +1989,166 @@ void SynthesiserEqrelRelation::generateTypeStruct(std::ostream& out) {
         out << "}\n";
     }
 
+    // getMemoryUsage method, the memory of equivalence relations is not accounted
+    generateMemoryUsage(out, false);
+
     // end class
     out << "};\n";
 }
 
+// -------- Storage Relation --------
+
+/** Generate index set for a relation of a storage provider, whose storage has no orders */
+void SynthesiserStorageRelation::computeIndices() {
+    const auto& sigs = getMinIndexSelection().getSearches();
+    searches.insert(sigs.begin(), sigs.end());
+    computedIndices = {};
+}
+
+/** Generate type name of a relation of a storage provider, shared by the relations of the same arity */
+std::string SynthesiserStorageRelation::getTypeName() {
+    return "t_storage_" + std::to_string(getArity()) + "__" + getRamRelation().getStorage();
+}
+
+void SynthesiserStorageRelation::merge(const SynthesiserRelation& other) {
+    const auto& storage = dynamic_cast<const SynthesiserStorageRelation&>(other);
+    searches.insert(storage.searches.begin(), storage.searches.end());
+}
+
+/** Generate type struct of a relation of a storage provider */
+void SynthesiserStorageRelation::generateTypeStruct(std::ostream& out) {
+    size_t arity = getArity();
+
+    // struct definition
+    out << "struct " << getTypeName() << " {\n";
+
+    // stored tuple type
+    out << "using t_tuple = Tuple<RamDomain, " << arity << ">;\n";
+
+    // the storage obtained from the provider, which is told the searches of the relation
+    std::vector<std::string> sigs;
+    for (SearchSignature search : searches) {
+        if (search != 0) {
+            sigs.push_back(std::to_string(search));
+        }
+    }
+    out << "using t_set = StorageSet<" << arity << ">;\n";
+    out << "t_set set{\"" << getRamRelation().getStorage() << "\", {" << join(sigs, ",") << "}};\n";
+    out << "using iterator = t_set::iterator;\n";
+
+    // the storage keeps no operation hints
+    out << "struct context {};\n";
+    out << "context createContext() { return context(); }\n";
+
+    // insert methods
+    out << "bool insert(const t_tuple& t) {\n";
+    out << "return set.insert(t);\n";
+    out << "}\n";
+
+    out << "bool insert(const t_tuple& t, context& h) {\n";
+    out << "return set.insert(t);\n";
+    out << "}\n";
+
+    out << "bool insert(const RamDomain* ramDomain) {\n";
+    out << "RamDomain data[" << arity << "];\n";
+    out << "std::copy(ramDomain, ramDomain + " << arity << ", data);\n";
+    out << "const t_tuple& tuple = reinterpret_cast<const t_tuple&>(data);\n";
+    out << "return insert(tuple);\n";
+    out << "}\n";  // end of insert(RamDomain*)
+
+    std::vector<std::string> decls, params;
+    for (size_t i = 0; i < arity; i++) {
+        decls.push_back("RamDomain a" + std::to_string(i));
+        params.push_back("a" + std::to_string(i));
+    }
+    out << "bool insert(" << join(decls, ",") << ") {\n";
+    out << "RamDomain data[" << arity << "] = {" << join(params, ",") << "};\n";
+    out << "return insert(data);\n";
+    out << "}\n";  // end of insert(RamDomain x1, RamDomain x2, ...)
+
+    // insertAll methods
+    out << "template <typename T>\n";
+    out << "void insertAll(T& other) {\n";
+    out << "for (auto const& cur : other) {\n";
+    out << "insert(cur);\n";
+    out << "}\n";
+    out << "}\n";
+
+    out << "void insertAll(" << getTypeName() << "& other) {\n";
+    out << "set.insertAll(other.set);\n";
+    out << "}\n";
+
+    // contains methods
+    out << "bool contains(const t_tuple& t, context& h) const {\n";
+    out << "return set.contains(t);\n";
+    out << "}\n";
+
+    out << "bool contains(const t_tuple& t) const {\n";
+    out << "return set.contains(t);\n";
+    out << "}\n";
+
+    // size and empty methods
+    out << "std::size_t size() const {\n";
+    out << "return set.size();\n";
+    out << "}\n";
+
+    out << "bool empty() const {\n";
+    out << "return set.empty();\n";
+    out << "}\n";
+
+    // equalRange methods, answered by the storage; the tuples of a range come in no particular order
+    out << "range<iterator> equalRange_0(const t_tuple& t, context& h) const {\n";
+    out << "return range<iterator>(set.begin(), set.end());\n";
+    out << "}\n";
+
+    out << "range<iterator> equalRange_0(const t_tuple& t) const {\n";
+    out << "return range<iterator>(set.begin(), set.end());\n";
+    out << "}\n";
+
+    for (SearchSignature search : searches) {
+        if (search == 0) {
+            continue;
+        }
+        out << "range<iterator> equalRange_" << search << "(const t_tuple& t, context& h) const {\n";
+        out << "return set.equalRange(" << search << ", t);\n";
+        out << "}\n";
+
+        out << "range<iterator> equalRange_" << search << "(const t_tuple& t) const {\n";
+        out << "return set.equalRange(" << search << ", t);\n";
+        out << "}\n";
+    }
+
+    // partition method
+    out << "std::vector<range<iterator>> partition() const {\n";
+    out << "return set.partition(400);\n";
+    out << "}\n";
+
+    // purge method
+    out << "void purge() {\n";
+    out << "set.clear();\n";
+    out << "}\n";
+
+    // begin and end iterators
+    out << "iterator begin() const {\n";
+    out << "return set.begin();\n";
+    out << "}\n";
+
+    out << "iterator end() const {\n";
+    out << "return set.end();\n";
+    out << "}\n";
+
+    // printHintStatistics method
+    out << "void printHintStatistics(std::ostream& o, const std::string prefix) const {\n";
+    out << "o << \"storage " << getRamRelation().getStorage() << ": no hint statistics supported\\n\";\n";
+    out << "}\n";
+
+    // getMemoryUsage method, as far as the provider reports it
+    generateMemoryUsage(out, false, {{"storage", "set"}});
+
+    // end struct
+    out << "};\n";
+}
+
 // -------- Rbtset Relation --------
 
 }  // end of namespace souffle
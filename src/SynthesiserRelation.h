@@ -11,9 +11,13 @@
 #include "RamIndexAnalysis.h"
 #include "RamRelation.h"
 
+#include <map>
 #include <memory>
 #include <ostream>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace souffle {
 
@@ -61,11 +65,33 @@ public:
     /** Generate relation type struct */
     virtual void generateTypeStruct(std::ostream& out) = 0;
 
-    /** Factory method to generate a SynthesiserRelation */
-    static std::unique_ptr<SynthesiserRelation> getSynthesiserRelation(
-            const RamRelation& ramRel, const MinIndexSelection& indexSet, bool isProvenance);
+    /**
+     * Extend the type by the searches of another relation of the same type name, such that one
+     * struct serves both; types naming their searches are already the same
+     */
+    virtual void merge(const SynthesiserRelation& other) {}
+
+    /**
+     * Factory method to generate a SynthesiserRelation, with Bloom filters answering
+     * the existence checks of the given searches where the data structure has them
+     */
+    static std::unique_ptr<SynthesiserRelation> getSynthesiserRelation(const RamRelation& ramRel,
+            const MinIndexSelection& indexSet, bool isProvenance,
+            const std::set<SearchSignature>& filteredSearches = {});
+
+    /** Whether the existence checks of a search consult a Bloom filter of the relation first */
+    virtual bool isFiltered(SearchSignature search) const {
+        return false;
+    }
 
 protected:
+    /**
+     * Generate the method reporting the memory occupied by the indexes and
+     * the given further members, as pairs of labels and member names
+     */
+    void generateMemoryUsage(std::ostream& out, bool withIndexes,
+            const std::vector<std::pair<std::string, std::string>>& members = {}) const;
+
     /** Ram relation referred to by this */
     const RamRelation& relation;
 
@@ -98,12 +124,64 @@ public:
 
 class SynthesiserDirectRelation : public SynthesiserRelation {
 public:
-    SynthesiserDirectRelation(const RamRelation& ramRel, const MinIndexSelection& indexSet, bool isProvenance)
+    SynthesiserDirectRelation(const RamRelation& ramRel, const MinIndexSelection& indexSet,
+            bool isProvenance, std::set<SearchSignature> filteredSearches = {})
+            : SynthesiserRelation(ramRel, indexSet, isProvenance),
+              filteredSearches(std::move(filteredSearches)) {}
+
+    void computeIndices() override;
+    std::string getTypeName() override;
+    void generateTypeStruct(std::ostream& out) override;
+    void merge(const SynthesiserRelation& other) override;
+
+    bool isFiltered(SearchSignature search) const override {
+        return filteredSearches.count(search) != 0;
+    }
+
+protected:
+    /** Whether the index at the given position is only filled on its first use */
+    bool isLazy(size_t index) const {
+        return !isProvenance && index != masterIndex;
+    }
+
+    /** The searches of the relations of this type, with the numbers of the indexes serving them */
+    std::map<SearchSignature, size_t> searchIndexes;
+
+    /** The numbers of the indexes serving the ordered searches of the relations of this type */
+    std::set<int> orderedIndexes;
+
+    /** The searches whose existence checks consult Bloom filters, built on their first use */
+    std::set<SearchSignature> filteredSearches;
+};
+
+class SynthesiserBufferRelation : public SynthesiserRelation {
+public:
+    SynthesiserBufferRelation(
+            const RamRelation& ramRel, const MinIndexSelection& indexSet, bool isProvenance)
             : SynthesiserRelation(ramRel, indexSet, isProvenance) {}
 
     void computeIndices() override;
     std::string getTypeName() override;
     void generateTypeStruct(std::ostream& out) override;
+
+    /** Check whether the given relation can be stored in an append buffer */
+    static bool isApplicable(const RamRelation& ramRel, const MinIndexSelection& indexSet, bool isProvenance);
+};
+
+class SynthesiserHashRelation : public SynthesiserRelation {
+public:
+    SynthesiserHashRelation(const RamRelation& ramRel, const MinIndexSelection& indexSet, bool isProvenance)
+            : SynthesiserRelation(ramRel, indexSet, isProvenance) {}
+
+    void computeIndices() override;
+    std::string getTypeName() override;
+    void generateTypeStruct(std::ostream& out) override;
+
+private:
+    /** Check whether the given search requires an ordered index, i.e. binds only some columns */
+    bool isRangeSearch(int64_t search) const {
+        return search != 0 && search != (int64_t(1) << getArity()) - 1;
+    }
 };
 
 class SynthesiserIndirectRelation : public SynthesiserRelation {
@@ -125,6 +203,107 @@ public:
     void computeIndices() override;
     std::string getTypeName() override;
     void generateTypeStruct(std::ostream& out) override;
+
+protected:
+    /** Name of the data structure, used in type names and statistics */
+    virtual std::string getStructureName() const {
+        return "brie";
+    }
+
+    /** Type of the data structure holding an index of the given arity */
+    virtual std::string getIndexType(size_t arity) const {
+        return "Trie<" + std::to_string(arity) + ">";
+    }
+
+public:
+    /** Whether the data structure counts the tuples of a range without iterating through them */
+    virtual bool countsRanges() const {
+        return false;
+    }
+
+    /** Whether the data structure takes over the nodes of another one instead of copying them */
+    virtual bool adoptsNodes() const {
+        return true;
+    }
+
+    /** Whether the data structure is built level by level from sorted tuples instead of by single inserts */
+    virtual bool loadsSorted() const {
+        return true;
+    }
+};
+
+class SynthesiserCompressedRelation : public SynthesiserBrieRelation {
+public:
+    SynthesiserCompressedRelation(
+            const RamRelation& ramRel, const MinIndexSelection& indexSet, bool isProvenance)
+            : SynthesiserBrieRelation(ramRel, indexSet, isProvenance) {}
+
+    bool adoptsNodes() const override {
+        return false;
+    }
+
+    bool loadsSorted() const override {
+        return false;
+    }
+
+protected:
+    std::string getStructureName() const override {
+        return "compressed";
+    }
+
+    std::string getIndexType(size_t arity) const override {
+        return "CompressedSet<" + std::to_string(arity) + ">";
+    }
+};
+
+class SynthesiserMappedRelation : public SynthesiserBrieRelation {
+public:
+    SynthesiserMappedRelation(const RamRelation& ramRel, const MinIndexSelection& indexSet, bool isProvenance)
+            : SynthesiserBrieRelation(ramRel, indexSet, isProvenance) {}
+
+    bool adoptsNodes() const override {
+        return false;
+    }
+
+    bool loadsSorted() const override {
+        return false;
+    }
+
+protected:
+    std::string getStructureName() const override {
+        return "mmap";
+    }
+
+    std::string getIndexType(size_t arity) const override {
+        return "MappedSet<" + std::to_string(arity) + ">";
+    }
+};
+
+class SynthesiserBitmapRelation : public SynthesiserBrieRelation {
+public:
+    SynthesiserBitmapRelation(const RamRelation& ramRel, const MinIndexSelection& indexSet, bool isProvenance)
+            : SynthesiserBrieRelation(ramRel, indexSet, isProvenance) {}
+
+    bool countsRanges() const override {
+        return true;
+    }
+
+    bool adoptsNodes() const override {
+        return false;
+    }
+
+    bool loadsSorted() const override {
+        return false;
+    }
+
+protected:
+    std::string getStructureName() const override {
+        return "bitmap";
+    }
+
+    std::string getIndexType(size_t arity) const override {
+        return "BitmapSet<" + std::to_string(arity) + ">";
+    }
 };
 
 class SynthesiserEqrelRelation : public SynthesiserRelation {
@@ -137,4 +316,20 @@ public:
     void generateTypeStruct(std::ostream& out) override;
 };
 
+class SynthesiserStorageRelation : public SynthesiserRelation {
+public:
+    SynthesiserStorageRelation(
+            const RamRelation& ramRel, const MinIndexSelection& indexSet, bool isProvenance)
+            : SynthesiserRelation(ramRel, indexSet, isProvenance) {}
+
+    void computeIndices() override;
+    std::string getTypeName() override;
+    void generateTypeStruct(std::ostream& out) override;
+    void merge(const SynthesiserRelation& other) override;
+
+private:
+    /** The searches of the relations of this type, announced to the storage provider */
+    std::set<SearchSignature> searches;
+};
+
 }  // end of namespace souffle
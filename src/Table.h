@@ -101,6 +101,11 @@ public:
         return count;
     }
 
+    /** The memory occupied by this table, allocated blocks included */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) + (count + blockSize - 1) / blockSize * sizeof(Block);
+    }
+
     const T& insert(const T& element) {
         // check whether the head is initialized
         if (!head) {
@@ -0,0 +1,188 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file TraceLog.h
+ *
+ * A timeline of the strata, timed rules and iterations, parallel loops and
+ * I/O of an evaluation, by the threads conducting them, exported in the
+ * trace event format of Chrome, which Perfetto and chrome://tracing load.
+ *
+ * Each event is a span of time of a thread, with integer arguments such as
+ * the number of tuples produced or the number of chunks of a parallel loop
+ * taken by the thread. Events are recorded only once a trace file is opened,
+ * and written when the program ends.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+class TraceLog {
+public:
+    using Args = std::vector<std::pair<const char*, int64_t>>;
+
+    /**
+     * A span of time of the current thread, recorded as an event once it ends,
+     * unless the trace is disabled at its start.
+     */
+    class Span {
+    public:
+        Span(std::string name, const char* category)
+                : name(std::move(name)), category(category), active(TraceLog::instance().isEnabled()),
+                  start(active ? TraceLog::instance().now() : 0) {}
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        ~Span() {
+            if (active) {
+                TraceLog::instance().record(name, category, start, TraceLog::instance().now(), args);
+            }
+        }
+
+        /** Sets an argument of the event */
+        void set(const char* key, int64_t value) {
+            if (active) {
+                args.emplace_back(key, value);
+            }
+        }
+
+    private:
+        std::string name;
+        const char* category;
+        bool active;
+        uint64_t start;
+        Args args;
+    };
+
+    static TraceLog& instance() {
+        static TraceLog log;
+        return log;
+    }
+
+    ~TraceLog() {
+        write();
+    }
+
+    /** Records events from now on, to be written to the given file */
+    void open(const std::string& name) {
+        std::lock_guard<std::mutex> guard(lock);
+        filename = name;
+        enabled.store(true);
+    }
+
+    bool isEnabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /** Obtains the time since the trace has been created in microseconds */
+    uint64_t now() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - origin).count();
+    }
+
+    /** Records an event of the current thread between the given times */
+    void record(const std::string& name, const char* category, uint64_t start, uint64_t end,
+            const Args& args = {}) {
+        if (!isEnabled()) {
+            return;
+        }
+        const size_t thread = getThreadId();
+        std::lock_guard<std::mutex> guard(lock);
+        events.push_back(Event{name, category, thread, start, end - start, args});
+    }
+
+    /** Writes the events recorded so far to the trace file */
+    void write() {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!isEnabled() || filename.empty()) {
+            return;
+        }
+        std::ofstream os(filename);
+        if (!os.is_open()) {
+            std::cerr << "Cannot open trace file <" << filename << ">\n";
+            return;
+        }
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        for (size_t i = 0; i < numThreads.load(); ++i) {
+            os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+               << ",\"args\":{\"name\":\"thread " << i << "\"}},\n";
+        }
+        for (size_t i = 0; i < events.size(); ++i) {
+            const Event& event = events[i];
+            os << "{\"name\":\"" << escape(event.name) << "\",\"cat\":\"" << event.category
+               << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << event.start
+               << ",\"dur\":" << event.duration << ",\"args\":{";
+            for (size_t j = 0; j < event.args.size(); ++j) {
+                os << (j > 0 ? "," : "") << "\"" << event.args[j].first << "\":" << event.args[j].second;
+            }
+            os << "}}" << (i + 1 < events.size() ? ",\n" : "\n");
+        }
+        os << "]}\n";
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct Event {
+        std::string name;
+        const char* category;
+        size_t thread;
+        uint64_t start;
+        uint64_t duration;
+        Args args;
+    };
+
+    TraceLog() : origin(clock::now()) {}
+
+    /** Obtains the number of the current thread, counting threads in the order of their first event */
+    size_t getThreadId() {
+        static thread_local size_t id = numThreads.fetch_add(1);
+        return id;
+    }
+
+    /** Escapes a string for a JSON string literal */
+    static std::string escape(const std::string& str) {
+        std::string res;
+        for (char c : str) {
+            if (c == '"' || c == '\\') {
+                res += '\\';
+                res += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                res += buf;
+            } else {
+                res += c;
+            }
+        }
+        return res;
+    }
+
+    const clock::time_point origin;
+    std::atomic<bool> enabled{false};
+    std::atomic<size_t> numThreads{0};
+    std::string filename;
+    std::vector<Event> events;
+    std::mutex lock;
+};
+
+}  // end of namespace souffle
@@ -0,0 +1,316 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file TransitiveClosure.h
+ *
+ * The transitive closure of a binary relation, computed outside of the
+ * semi-naive evaluation of the rules defining it.
+ *
+ * The values of the edges are numbered densely and the edges are stored in
+ * compressed sparse rows. The strongly connected components of the graph are
+ * condensed into a directed acyclic graph, such that all values of a
+ * component share the values they reach. These are found by a search of the
+ * condensed graph per component, marking visited components in a bitset of
+ * the searching thread, for the components of a block of values in parallel.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RamTypes.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace souffle {
+
+/**
+ * The pairs of values connected by a path of one or more edges.
+ */
+class TransitiveClosure {
+public:
+    /** Add an edge */
+    void addEdge(RamDomain from, RamDomain to) {
+        edges.emplace_back(from, to);
+    }
+
+    /** Get the number of edges added */
+    std::size_t getNumEdges() const {
+        return edges.size();
+    }
+
+    /**
+     * Compute the closure, calling the consumer with each value having a successor and the
+     * sorted values it reaches, in ascending order of the values. The consumer is called by
+     * one thread at a time.
+     */
+    template <typename Consumer>
+    void compute(Consumer consumer) {
+        if (edges.empty()) {
+            return;
+        }
+        number();
+        condense();
+
+        // the sources of the blocks are processed in the order of their values; the reached values
+        // of the components of a block are computed in parallel
+        std::vector<std::vector<RamDomain>> reached(numComponents);
+        std::vector<std::size_t> pending;
+        std::vector<bool> isPending(numComponents, false);
+        for (std::size_t begin = 0; begin < values.size(); begin += BLOCK_SIZE) {
+            const std::size_t end = std::min(values.size(), begin + BLOCK_SIZE);
+            pending.clear();
+            for (std::size_t v = begin; v < end; v++) {
+                std::size_t c = component[v];
+                if (offsets[v] != offsets[v + 1] && !isPending[c] && reached[c].empty()) {
+                    isPending[c] = true;
+                    pending.push_back(c);
+                }
+            }
+
+#pragma omp parallel
+            {
+                std::vector<std::uint64_t> visited((numComponents + 63) / 64, 0);
+                std::vector<std::size_t> stack;
+                std::vector<std::size_t> touched;
+#pragma omp for schedule(dynamic, 1)
+                for (std::size_t i = 0; i < pending.size(); i++) {
+                    search(pending[i], visited, stack, touched, reached[pending[i]]);
+                }
+            }
+
+            for (std::size_t c : pending) {
+                isPending[c] = false;
+            }
+
+            // the values reached from a component are released after its greatest member
+            for (std::size_t v = begin; v < end; v++) {
+                std::vector<RamDomain>& cur = reached[component[v]];
+                if (!cur.empty()) {
+                    consumer(values[v], static_cast<const std::vector<RamDomain>&>(cur));
+                }
+                if (lastValue[component[v]] == v) {
+                    std::vector<RamDomain>().swap(cur);
+                }
+            }
+        }
+    }
+
+private:
+    /** The number of values whose reached values are computed at a time */
+    static constexpr std::size_t BLOCK_SIZE = 4096;
+
+    /** The edges, by value */
+    std::vector<std::pair<RamDomain, RamDomain>> edges;
+
+    /** The values, sorted, numbered by their position */
+    std::vector<RamDomain> values;
+
+    /** The successors of each number, from offsets[v] to offsets[v + 1] */
+    std::vector<std::size_t> offsets;
+    std::vector<std::size_t> targets;
+
+    /** The component of each number */
+    std::vector<std::size_t> component;
+
+    /** The number of components */
+    std::size_t numComponents = 0;
+
+    /** The members of each component, from memberOffsets[c] to memberOffsets[c + 1] */
+    std::vector<std::size_t> memberOffsets;
+    std::vector<std::size_t> members;
+
+    /** The greatest member of each component */
+    std::vector<std::size_t> lastValue;
+
+    /** Whether a component reaches itself, being a cycle of more than one value or a self-loop */
+    std::vector<bool> cyclic;
+
+    /** The successor components of each component, from succOffsets[c] to succOffsets[c + 1] */
+    std::vector<std::size_t> succOffsets;
+    std::vector<std::size_t> successors;
+
+    /** Number the values and store the edges in compressed sparse rows */
+    void number() {
+        values.reserve(2 * edges.size());
+        for (const auto& edge : edges) {
+            values.push_back(edge.first);
+            values.push_back(edge.second);
+        }
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+        auto numberOf = [&](RamDomain value) {
+            return static_cast<std::size_t>(
+                    std::lower_bound(values.begin(), values.end(), value) - values.begin());
+        };
+
+        std::vector<std::pair<std::size_t, std::size_t>> numbered;
+        numbered.reserve(edges.size());
+        for (const auto& edge : edges) {
+            numbered.emplace_back(numberOf(edge.first), numberOf(edge.second));
+        }
+        std::vector<std::pair<RamDomain, RamDomain>>().swap(edges);
+        std::sort(numbered.begin(), numbered.end());
+        numbered.erase(std::unique(numbered.begin(), numbered.end()), numbered.end());
+
+        offsets.assign(values.size() + 1, 0);
+        for (const auto& edge : numbered) {
+            offsets[edge.first + 1]++;
+        }
+        for (std::size_t v = 0; v < values.size(); v++) {
+            offsets[v + 1] += offsets[v];
+        }
+        targets.reserve(numbered.size());
+        for (const auto& edge : numbered) {
+            targets.push_back(edge.second);
+        }
+    }
+
+    /** Find the strongly connected components by an iterative Tarjan search and condense them */
+    void condense() {
+        const std::size_t n = values.size();
+        const std::size_t unvisited = static_cast<std::size_t>(-1);
+        std::vector<std::size_t> index(n, unvisited);
+        std::vector<std::size_t> low(n, 0);
+        std::vector<bool> onStack(n, false);
+        std::vector<std::size_t> sccStack;
+        std::vector<std::pair<std::size_t, std::size_t>> callStack;
+        component.assign(n, 0);
+        std::size_t counter = 0;
+
+        for (std::size_t root = 0; root < n; root++) {
+            if (index[root] != unvisited) {
+                continue;
+            }
+            callStack.emplace_back(root, offsets[root]);
+            index[root] = low[root] = counter++;
+            sccStack.push_back(root);
+            onStack[root] = true;
+            while (!callStack.empty()) {
+                std::size_t v = callStack.back().first;
+                std::size_t& next = callStack.back().second;
+                if (next < offsets[v + 1]) {
+                    std::size_t w = targets[next++];
+                    if (index[w] == unvisited) {
+                        index[w] = low[w] = counter++;
+                        sccStack.push_back(w);
+                        onStack[w] = true;
+                        callStack.emplace_back(w, offsets[w]);
+                    } else if (onStack[w]) {
+                        low[v] = std::min(low[v], index[w]);
+                    }
+                    continue;
+                }
+                callStack.pop_back();
+                if (!callStack.empty()) {
+                    std::size_t parent = callStack.back().first;
+                    low[parent] = std::min(low[parent], low[v]);
+                }
+                if (low[v] == index[v]) {
+                    std::size_t w;
+                    do {
+                        w = sccStack.back();
+                        sccStack.pop_back();
+                        onStack[w] = false;
+                        component[w] = numComponents;
+                    } while (w != v);
+                    numComponents++;
+                }
+            }
+        }
+
+        // the members of the components, in ascending order
+        memberOffsets.assign(numComponents + 1, 0);
+        lastValue.assign(numComponents, 0);
+        for (std::size_t v = 0; v < n; v++) {
+            memberOffsets[component[v] + 1]++;
+            lastValue[component[v]] = v;
+        }
+        for (std::size_t c = 0; c < numComponents; c++) {
+            memberOffsets[c + 1] += memberOffsets[c];
+        }
+        members.resize(n);
+        std::vector<std::size_t> fill(memberOffsets.begin(), memberOffsets.end() - 1);
+        for (std::size_t v = 0; v < n; v++) {
+            members[fill[component[v]]++] = v;
+        }
+
+        // the distinct successors of the components
+        cyclic.assign(numComponents, false);
+        std::vector<std::pair<std::size_t, std::size_t>> condensed;
+        for (std::size_t v = 0; v < n; v++) {
+            for (std::size_t i = offsets[v]; i < offsets[v + 1]; i++) {
+                std::size_t c = component[v];
+                std::size_t d = component[targets[i]];
+                if (c == d) {
+                    cyclic[c] = true;
+                } else {
+                    condensed.emplace_back(c, d);
+                }
+            }
+        }
+        std::sort(condensed.begin(), condensed.end());
+        condensed.erase(std::unique(condensed.begin(), condensed.end()), condensed.end());
+        succOffsets.assign(numComponents + 1, 0);
+        for (const auto& edge : condensed) {
+            succOffsets[edge.first + 1]++;
+        }
+        for (std::size_t c = 0; c < numComponents; c++) {
+            succOffsets[c + 1] += succOffsets[c];
+        }
+        successors.reserve(condensed.size());
+        for (const auto& edge : condensed) {
+            successors.push_back(edge.second);
+        }
+    }
+
+    /** Collect the sorted values reached from a component, resetting the visited bits afterwards */
+    void search(std::size_t start, std::vector<std::uint64_t>& visited, std::vector<std::size_t>& stack,
+            std::vector<std::size_t>& touched, std::vector<RamDomain>& res) const {
+        auto visit = [&](std::size_t c) {
+            if ((visited[c / 64] >> (c % 64) & 1) == 0) {
+                visited[c / 64] |= std::uint64_t(1) << (c % 64);
+                touched.push_back(c);
+                stack.push_back(c);
+            }
+        };
+        if (cyclic[start]) {
+            visit(start);
+        } else {
+            for (std::size_t i = succOffsets[start]; i < succOffsets[start + 1]; i++) {
+                visit(successors[i]);
+            }
+        }
+        while (!stack.empty()) {
+            std::size_t c = stack.back();
+            stack.pop_back();
+            for (std::size_t i = memberOffsets[c]; i < memberOffsets[c + 1]; i++) {
+                res.push_back(values[members[i]]);
+            }
+            for (std::size_t i = succOffsets[c]; i < succOffsets[c + 1]; i++) {
+                visit(successors[i]);
+            }
+        }
+        for (std::size_t c : touched) {
+            visited[c / 64] = 0;
+        }
+        touched.clear();
+        std::sort(res.begin(), res.end());
+    }
+};
+
+}  // end of namespace souffle
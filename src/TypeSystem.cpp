@@ -35,6 +35,7 @@ void PrimitiveType::print(std::ostream& out) const {
 void UnionType::add(const Type& type) {
     assert(environment.isType(type));
     elementTypes.push_back(&type);
+    environment.finalised = false;
 }
 
 void UnionType::print(std::ostream& out) const {
@@ -74,6 +75,7 @@ void TypeEnvironment::clear() {
         delete cur.second;
     }
     types.clear();
+    finalised = false;
 
     // re-initialize type environment
     createType<PredefinedType>("number");
@@ -111,6 +113,7 @@ void TypeEnvironment::addType(Type& type) {
     const identifier& name = type.getName();
     assert(types.find(name) == types.end() && "Error: registering present type!");
     types[name] = &type;
+    finalised = false;
 }
 
 namespace {
@@ -307,7 +310,116 @@ std::string getTypeQualifier(const Type& type) {
     return visitor().visit(type);
 }
 
+void TypeEnvironment::finalise() {
+    // number the types in the order of their names
+    typeList.clear();
+    for (const auto& cur : types) {
+        cur.second->id = typeList.size();
+        typeList.push_back(cur.second);
+    }
+    const size_t n = typeList.size();
+    words = (n + 63) / 64;
+    supertypes.assign(n * words, 0);
+    subtypes.assign(n * words, 0);
+    leastCommonSupertypes.clear();
+
+    // a type is a sub-type of itself and number or symbol if rooted in them
+    const Type& number = getNumberType();
+    const Type& symbol = getSymbolType();
+    for (const Type* type : typeList) {
+        set(supertypes, type->id, type->id);
+        if (isOfRootType(*type, number)) {
+            set(supertypes, type->id, number.id);
+        }
+        if (isOfRootType(*type, symbol)) {
+            set(supertypes, type->id, symbol.id);
+        }
+    }
+
+    // the types in the transitive closure of the elements of a union are its sub-types
+    std::vector<bool> reached(n);
+    std::vector<const Type*> worklist;
+    for (const Type* type : typeList) {
+        if (!isA<UnionType>(*type)) {
+            continue;
+        }
+        std::fill(reached.begin(), reached.end(), false);
+        worklist.push_back(type);
+        while (!worklist.empty()) {
+            const Type* cur = worklist.back();
+            worklist.pop_back();
+            if (reached[cur->id]) {
+                continue;
+            }
+            reached[cur->id] = true;
+            set(supertypes, cur->id, type->id);
+            if (isA<UnionType>(*cur)) {
+                for (const Type* element : as<UnionType>(*cur).getElementTypes()) {
+                    worklist.push_back(element);
+                }
+            }
+        }
+    }
+
+    // primitive types inherit the super-types of their base type
+    for (const Type* type : typeList) {
+        if (isA<PrimitiveType>(*type)) {
+            const size_t base = as<PrimitiveType>(*type).getBaseType().id;
+            for (size_t w = 0; w < words; w++) {
+                supertypes[type->id * words + w] |= supertypes[base * words + w];
+            }
+        }
+    }
+
+    // transpose for the sub-types
+    for (size_t a = 0; a < n; a++) {
+        for (size_t b = 0; b < n; b++) {
+            if (test(supertypes, a, b)) {
+                set(subtypes, b, a);
+            }
+        }
+    }
+    finalised = true;
+}
+
+const TypeSet& TypeEnvironment::getFinalisedLeastCommonSupertypes(const Type& a, const Type& b) const {
+    assert(finalised && "environment not finalised");
+    auto key = std::make_pair(std::min(a.id, b.id), std::max(a.id, b.id));
+    auto pos = leastCommonSupertypes.find(key);
+    if (pos != leastCommonSupertypes.end()) {
+        return pos->second;
+    }
+
+    // the common super-types having no other common super-type as a sub-type
+    TypeSet& res = leastCommonSupertypes[key];
+    std::vector<uint64_t> common(words);
+    for (size_t w = 0; w < words; w++) {
+        common[w] = supertypes[a.id * words + w] & supertypes[b.id * words + w];
+    }
+    for (size_t w = 0; w < words; w++) {
+        for (uint64_t bits = common[w]; bits != 0; bits &= bits - 1) {
+            const size_t cur = w * 64 + __builtin_ctzll(bits);
+            bool least = true;
+            for (size_t v = 0; v < words && least; v++) {
+                uint64_t below = common[v] & subtypes[cur * words + v];
+                if (v == cur / 64) {
+                    below &= ~(uint64_t(1) << (cur % 64));
+                }
+                least = below == 0;
+            }
+            if (least) {
+                res.insert(*typeList[cur]);
+            }
+        }
+    }
+    return res;
+}
+
 bool isNumberType(const Type& type) {
+    const TypeEnvironment& environment = type.getTypeEnvironment();
+    if (environment.isFinalised()) {
+        return environment.isFinalisedSubtype(type, environment.getNumberType());
+    }
     return isOfRootType(type, type.getTypeEnvironment().getNumberType());
 }
 
@@ -316,6 +428,10 @@ bool isNumberType(const TypeSet& s) {
 }
 
 bool isSymbolType(const Type& type) {
+    const TypeEnvironment& environment = type.getTypeEnvironment();
+    if (environment.isFinalised()) {
+        return environment.isFinalisedSubtype(type, environment.getSymbolType());
+    }
     return isOfRootType(type, type.getTypeEnvironment().getSymbolType());
 }
 
@@ -366,6 +482,11 @@ bool isSubtypeOf(const Type& a, const Type& b) {
     auto& environment = a.getTypeEnvironment();
     assert(environment.isType(a) && environment.isType(b));
 
+    // a single bit of the precomputed lattice
+    if (environment.isFinalised()) {
+        return environment.isFinalisedSubtype(a, b);
+    }
+
     // first check - a type is a sub-type of itself
     if (a == b) {
         return true;
@@ -423,6 +544,11 @@ TypeSet getLeastCommonSupertypes(const Type& a, const Type& b) {
         return TypeSet(a);
     }
 
+    // look up the precomputed lattice
+    if (a.getTypeEnvironment().isFinalised()) {
+        return a.getTypeEnvironment().getFinalisedLeastCommonSupertypes(a, b);
+    }
+
     // harder: no obvious relation => hard way
     TypeSet superTypes;
     TypeSet all = a.getTypeEnvironment().getAllTypes();
@@ -20,6 +20,7 @@
 #include "IterUtils.h"
 #include "Util.h"
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <set>
@@ -84,8 +85,14 @@ protected:
     const TypeEnvironment& environment;
 
 private:
+    // only allow type environments to number types
+    friend class TypeEnvironment;
+
     /** The name of this type. */
     AstTypeIdentifier name;
+
+    /** The number of this type in the finalised environment */
+    size_t id = 0;
 };
 
 /**
@@ -371,12 +378,61 @@ public:
 
     void swap(TypeEnvironment& env) {
         types.swap(env.types);
+        finalised = env.finalised = false;
+    }
+
+    // -- precomputed subtype lattice --
+
+    /**
+     * Numbers the types and precomputes the subtype relation as a bit matrix, such that subtype
+     * queries are answered by a single bit until types are added or union types are changed.
+     */
+    void finalise();
+
+    bool isFinalised() const {
+        return finalised;
     }
 
+    /** Determines whether type a is a subtype of type b, the environment being finalised */
+    bool isFinalisedSubtype(const Type& a, const Type& b) const {
+        assert(finalised && "environment not finalised");
+        return test(supertypes, a.id, b.id);
+    }
+
+    /** Computes the least common super types of two types, the environment being finalised */
+    const TypeSet& getFinalisedLeastCommonSupertypes(const Type& a, const Type& b) const;
+
 private:
+    // only allow union types to invalidate the precomputed lattice
+    friend class UnionType;
+
     /** The list of covered types */
     std::map<identifier, Type*> types;
 
+    /** Whether the lattice below is up to date */
+    mutable bool finalised = false;
+
+    /** The types in the order of their numbers */
+    std::vector<const Type*> typeList;
+
+    /** The number of 64-bit words in a row of the bit matrices */
+    size_t words = 0;
+
+    /** Bit matrices of the super types and the sub types of each type, by type number */
+    std::vector<uint64_t> supertypes;
+    std::vector<uint64_t> subtypes;
+
+    /** The least common super types of pairs of types, filled as they are queried */
+    mutable std::map<std::pair<size_t, size_t>, TypeSet> leastCommonSupertypes;
+
+    bool test(const std::vector<uint64_t>& matrix, size_t row, size_t column) const {
+        return (matrix[row * words + column / 64] >> (column % 64)) & 1;
+    }
+
+    void set(std::vector<uint64_t>& matrix, size_t row, size_t column) {
+        matrix[row * words + column / 64] |= uint64_t(1) << (column % 64);
+    }
+
     /** Register types created by one of the factory functions */
     void addType(Type& type);
 };
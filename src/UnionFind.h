@@ -258,13 +258,25 @@ class SparseDisjointSet {
     using SparseMap =
             LambdaBTreeSet<PairStore, std::function<parent_t(PairStore&)>, EqrelMapComparator<PairStore>>;
     using DenseMap = RandomInsertPiggyList<SparseDomain>;
+    using DirectMap = RandomInsertPiggyList<std::atomic<parent_t>>;
+
+    // values in [0, DIRECT_LIMIT) are mapped through a directly indexed table instead of the btree
+    static constexpr size_t DIRECT_LIMIT = 1ul << 24;
+    // marks an entry of the direct table whose dense value is being created
+    static constexpr parent_t RESERVED = std::numeric_limits<parent_t>::max();
 
     typename SparseMap::operation_hints last_ins;
 
     SparseMap sparseToDenseMap;
+    // dense value + 1 of small sparse values, 0 if not present
+    DirectMap directToDenseMap;
     // mapping from union-find val to souffle, union-find encoded as index
     DenseMap denseToSparseMap;
 
+    static inline bool isDirect(const SparseDomain in) {
+        return !(in < SparseDomain(0)) && static_cast<size_t>(in) < DIRECT_LIMIT;
+    }
+
 public:
     /**
      * Retrieve dense encoding, adding it in if non-existent
@@ -272,6 +284,22 @@ public:
      * @return the corresponding dense value
      */
     parent_t toDense(const SparseDomain in) {
+        if (isDirect(in)) {
+            std::atomic<parent_t>& entry = directToDenseMap.getOrCreate(in);
+            while (true) {
+                parent_t cur = entry.load(std::memory_order_acquire);
+                if (likely(cur != 0 && cur != RESERVED)) return cur - 1;
+
+                // create the dense value unless another thread is doing so
+                if (cur == 0 && entry.compare_exchange_strong(cur, RESERVED)) {
+                    parent_t c2 = DisjointSet::b2p(this->ds.makeNode());
+                    this->denseToSparseMap.insertAt(c2, in);
+                    entry.store(c2 + 1, std::memory_order_release);
+                    return c2;
+                }
+            }
+        }
+
         // insert into the mapping - if the key doesn't exist (in), the function will be called
         // and a dense value will be created for it
         PairStore p = {in, -1};
@@ -331,6 +359,7 @@ public:
     void clear() {
         ds.clear();
         sparseToDenseMap.clear();
+        directToDenseMap.clear();
         denseToSparseMap.clear();
     }
 
@@ -342,6 +371,11 @@ public:
 
     /* whether we the supplied node exists */
     inline bool nodeExists(const SparseDomain val) const {
+        if (isDirect(val)) {
+            if (!directToDenseMap.isAllocated(val)) return false;
+            const parent_t cur = directToDenseMap.get(val).load(std::memory_order_acquire);
+            return cur != 0 && cur != RESERVED;
+        }
         return sparseToDenseMap.contains({val, -1});
     };
 
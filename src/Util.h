@@ -24,6 +24,7 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstdlib>
+#include <iomanip>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -833,6 +834,22 @@ inline std::vector<std::string> splitString(const std::string& str, char delimit
     return parts;
 }
 
+/**
+ * Computes the FNV-1a hash of a string as a hexadecimal string. Unlike std::hash,
+ * the result does not differ between runs or standard libraries, such that it
+ * can be used to identify files by their content.
+ */
+inline std::string contentHash(const std::string& str) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (char c : str) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    std::stringstream out;
+    out << std::hex << std::setw(16) << std::setfill('0') << h;
+    return out.str();
+}
+
 // -------------------------------------------------------------------------------
 //                              Functional Utils
 // -------------------------------------------------------------------------------
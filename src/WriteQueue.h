@@ -0,0 +1,128 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file WriteQueue.h
+ *
+ * A queue of output tasks run in order on a background thread, such that
+ * the evaluation continues while the relations of completed strata are
+ * written (--async-output).
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace souffle {
+
+/**
+ * Runs tasks on a background thread, one after the other in the order of
+ * their submission. The thread is started by the first task.
+ *
+ * A task writing a relation reads it concurrently with the evaluation,
+ * which does not modify the relations of completed strata. A relation
+ * expired while its writes are pending is therefore freed by a task of
+ * its own, submitted after the writes.
+ */
+class WriteQueue {
+public:
+    WriteQueue() = default;
+    WriteQueue(const WriteQueue&) = delete;
+
+    ~WriteQueue() {
+        wait();
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            stopped = true;
+        }
+        changed.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    /** Run a task writing the given relation after the tasks submitted before */
+    void submit(const void* relation, std::function<void()> write) {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            written.insert(relation);
+            push(std::move(write));
+        }
+        changed.notify_all();
+    }
+
+    /** Free a relation after the tasks writing it, or at once if it was not written */
+    void release(const void* relation, const std::function<void()>& free) {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            if (written.erase(relation) > 0) {
+                push(free);
+                changed.notify_all();
+                return;
+            }
+        }
+        free();
+    }
+
+    /** Determine whether some task writes the given relation, which is then read by the queue */
+    bool isWritten(const void* relation) {
+        std::lock_guard<std::mutex> guard(mutex);
+        return written.count(relation) > 0;
+    }
+
+    /** Wait until the tasks submitted are done */
+    void wait() {
+        std::unique_lock<std::mutex> guard(mutex);
+        changed.wait(guard, [this]() { return tasks.empty() && !running; });
+    }
+
+private:
+    /** Queue a task, starting the thread if required; the caller holds the mutex */
+    void push(std::function<void()> task) {
+        tasks.push_back(std::move(task));
+        if (!worker.joinable()) {
+            worker = std::thread([this]() { run(); });
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> guard(mutex);
+        while (true) {
+            changed.wait(guard, [this]() { return stopped || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            std::function<void()> task = std::move(tasks.front());
+            tasks.pop_front();
+            running = true;
+            guard.unlock();
+            task();
+            guard.lock();
+            running = false;
+            changed.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::function<void()>> tasks;
+    /** the relations written by some task */
+    std::set<const void*> written;
+    bool running = false;
+    bool stopped = false;
+    std::thread worker;
+};
+
+}  // end of namespace souffle
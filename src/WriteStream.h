@@ -19,6 +19,7 @@
 #include "SymbolTable.h"
 
 #include <cassert>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -33,7 +34,8 @@ public:
     template <typename T>
     void writeAll(const T& relation) {
         if (summary) {
-            return writeSize(relation.size());
+            const std::size_t size = relation.size();
+            return writeSize((limit > 0 && size > limit) ? limit : size);
         }
         auto lease = symbolTable.acquireLock();
         (void)lease;
@@ -43,6 +45,16 @@ public:
             }
             return;
         }
+        if (limit > 0) {
+            std::size_t count = 0;
+            for (auto it = relation.begin(); it != relation.end() && count < limit; ++it, ++count) {
+                writeNext(*it);
+            }
+            return;
+        }
+        if (writesParts() && writeAllParts(relation, 0)) {
+            return;
+        }
         for (const auto& current : relation) {
             writeNext(current);
         }
@@ -52,6 +64,11 @@ public:
         writeSize(relation.size());
     }
 
+    /** Limit the number of tuples written to the given number, if positive */
+    void setLimit(std::size_t n) {
+        limit = n;
+    }
+
     virtual ~WriteStream() = default;
 
 protected:
@@ -60,6 +77,7 @@ protected:
     const bool isProvenance;
     const bool summary;
     const size_t arity;
+    std::size_t limit = 0;
 
     virtual void writeNullary() = 0;
     virtual void writeNextTuple(const RamDomain* tuple) = 0;
@@ -70,6 +88,49 @@ protected:
     void writeNext(const Tuple tuple) {
         writeNextTuple(tuple.data);
     }
+
+    /** A part of a relation, passing each of its tuples in order to the given function */
+    using Part = std::function<void(const std::function<void(const RamDomain*)>&)>;
+
+    /** Whether the stream writes relations split into parts, which may be scanned concurrently */
+    virtual bool writesParts() const {
+        return false;
+    }
+
+    /** Write a relation split into parts, given in the order of the relation */
+    virtual void writeParts(const std::vector<Part>& /* parts */) {}
+
+private:
+    /** Split a relation into the parts of its partition, if it has one, and write them */
+    template <typename T>
+    auto writeAllParts(const T& relation, int) -> decltype(relation.partition(), bool()) {
+        auto ranges = relation.partition();
+        std::vector<Part> parts;
+        for (const auto& cur : ranges) {
+            const auto* part = &cur;
+            parts.push_back([part](const std::function<void(const RamDomain*)>& write) {
+                for (const auto& tuple : *part) {
+                    write(getData(tuple));
+                }
+            });
+        }
+        writeParts(parts);
+        return true;
+    }
+
+    template <typename T>
+    bool writeAllParts(const T& /* relation */, long) {
+        return false;
+    }
+
+    template <typename Tuple>
+    static const RamDomain* getData(const Tuple& tuple) {
+        return tuple.data;
+    }
+
+    static const RamDomain* getData(const RamDomain* tuple) {
+        return tuple;
+    }
 };
 
 class WriteStreamFactory {
@@ -0,0 +1,201 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file WriteStreamArrow.h
+ *
+ * Writing relations into Apache Arrow IPC files (IO=arrow) and into
+ * Parquet files (IO=parquet).
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "IODirectives.h"
+#include "RamTypes.h"
+#include "SymbolTable.h"
+#include "WriteStream.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <parquet/arrow/writer.h>
+
+namespace souffle {
+
+/**
+ * Writes a relation as a table of an Arrow IPC or a Parquet file, with a
+ * column for each attribute, named after it. Number attributes are stored
+ * as integers of the width of the domain, symbol attributes as dictionary
+ * encoded strings holding each symbol of the column once. The columns are
+ * collected while the relation is written, and stored once the stream is
+ * destroyed. A nullary relation is stored as a single column holding a row
+ * if the relation is not empty.
+ */
+class WriteStreamArrow : public WriteStream {
+public:
+    WriteStreamArrow(bool parquet, const std::vector<bool>& symbolMask, const SymbolTable& symbolTable,
+            const IODirectives& ioDirectives, const bool provenance = false)
+            : WriteStream(symbolMask, symbolTable, provenance), parquet(parquet),
+              fileName(ioDirectives.getFileName()), columns(arity) {
+        const std::string delimiter = ioDirectives.has("delimiter") ? ioDirectives.get("delimiter") : "\t";
+        std::string attributeNames;
+        if (ioDirectives.has("attributeNames")) {
+            attributeNames = ioDirectives.get("attributeNames");
+        }
+        for (size_t col = 0; col < arity; ++col) {
+            size_t end = attributeNames.find(delimiter);
+            columns[col].name = attributeNames.substr(0, end);
+            attributeNames = end == std::string::npos ? "" : attributeNames.substr(end + delimiter.size());
+            if (columns[col].name.empty()) {
+                columns[col].name = "column" + std::to_string(col);
+            }
+        }
+    }
+
+    ~WriteStreamArrow() override {
+        arrow::Status status = write();
+        if (!status.ok()) {
+            std::cerr << "Cannot write " << fileName << ": " << status.ToString() << "\n";
+        }
+    }
+
+protected:
+#if RAM_DOMAIN_SIZE == 64
+    using NumberType = arrow::Int64Type;
+#else
+    using NumberType = arrow::Int32Type;
+#endif
+
+    /** The values of a column, symbols given by their position in the dictionary of the column */
+    struct Column {
+        std::string name;
+        std::vector<RamDomain> values;
+        std::vector<RamDomain> dictionary;
+        std::unordered_map<RamDomain, int32_t> codes;
+    };
+
+    const bool parquet;
+    const std::string fileName;
+    std::vector<Column> columns;
+
+    /** the number of tuples written */
+    int64_t tuples = 0;
+
+    void writeNullary() override {
+        tuples = 1;
+    }
+
+    void writeNextTuple(const RamDomain* tuple) override {
+        for (size_t col = 0; col < arity; ++col) {
+            Column& column = columns[col];
+            RamDomain value = tuple[col];
+            if (symbolMask.at(col)) {
+                auto code = column.codes.find(value);
+                if (code == column.codes.end()) {
+                    const int32_t next = column.dictionary.size();
+                    code = column.codes.insert(std::make_pair(value, next)).first;
+                    column.dictionary.push_back(value);
+                }
+                value = code->second;
+            }
+            column.values.push_back(value);
+        }
+        ++tuples;
+    }
+
+    arrow::Status write() {
+        std::vector<std::shared_ptr<arrow::Field>> fields;
+        std::vector<std::shared_ptr<arrow::Array>> arrays;
+        if (arity == 0) {
+            arrow::Int8Builder builder;
+            ARROW_RETURN_NOT_OK(builder.AppendValues(std::vector<int8_t>(tuples, 1)));
+            std::shared_ptr<arrow::Array> array;
+            ARROW_RETURN_NOT_OK(builder.Finish(&array));
+            fields.push_back(arrow::field("nullary", arrow::int8(), false));
+            arrays.push_back(array);
+        }
+        for (size_t col = 0; col < arity; ++col) {
+            const Column& column = columns[col];
+            std::shared_ptr<arrow::Array> array;
+            if (symbolMask.at(col)) {
+                arrow::Int32Builder indices;
+                const std::vector<int32_t> codes(column.values.begin(), column.values.end());
+                ARROW_RETURN_NOT_OK(indices.AppendValues(codes));
+                arrow::StringBuilder dictionary;
+                for (RamDomain symbol : column.dictionary) {
+                    ARROW_RETURN_NOT_OK(dictionary.Append(symbolTable.unsafeResolve(symbol)));
+                }
+                std::shared_ptr<arrow::Array> indexArray;
+                std::shared_ptr<arrow::Array> dictionaryArray;
+                ARROW_RETURN_NOT_OK(indices.Finish(&indexArray));
+                ARROW_RETURN_NOT_OK(dictionary.Finish(&dictionaryArray));
+                auto type = arrow::dictionary(arrow::int32(), arrow::utf8());
+                ARROW_ASSIGN_OR_RAISE(
+                        array, arrow::DictionaryArray::FromArrays(type, indexArray, dictionaryArray));
+            } else {
+                arrow::NumericBuilder<NumberType> numbers;
+                ARROW_RETURN_NOT_OK(numbers.AppendValues(column.values.data(), column.values.size()));
+                ARROW_RETURN_NOT_OK(numbers.Finish(&array));
+            }
+            fields.push_back(arrow::field(column.name, array->type(), false));
+            arrays.push_back(array);
+        }
+        auto schema = arrow::schema(fields);
+        auto table = arrow::Table::Make(schema, arrays, tuples);
+
+        ARROW_ASSIGN_OR_RAISE(auto file, arrow::io::FileOutputStream::Open(fileName));
+        if (parquet) {
+            ARROW_RETURN_NOT_OK(parquet::arrow::WriteTable(
+                    *table, arrow::default_memory_pool(), file, parquet::DEFAULT_MAX_ROW_GROUP_LENGTH));
+        } else {
+            ARROW_ASSIGN_OR_RAISE(auto writer, arrow::ipc::MakeFileWriter(file, schema));
+            ARROW_RETURN_NOT_OK(writer->WriteTable(*table));
+            ARROW_RETURN_NOT_OK(writer->Close());
+        }
+        return file->Close();
+    }
+};
+
+class WriteArrowFactory : public WriteStreamFactory {
+public:
+    std::unique_ptr<WriteStream> getWriter(const std::vector<bool>& symbolMask,
+            const SymbolTable& symbolTable, const IODirectives& ioDirectives,
+            const bool provenance) override {
+        return std::make_unique<WriteStreamArrow>(false, symbolMask, symbolTable, ioDirectives, provenance);
+    }
+    const std::string& getName() const override {
+        static const std::string name = "arrow";
+        return name;
+    }
+    ~WriteArrowFactory() override = default;
+};
+
+class WriteParquetFactory : public WriteStreamFactory {
+public:
+    std::unique_ptr<WriteStream> getWriter(const std::vector<bool>& symbolMask,
+            const SymbolTable& symbolTable, const IODirectives& ioDirectives,
+            const bool provenance) override {
+        return std::make_unique<WriteStreamArrow>(true, symbolMask, symbolTable, ioDirectives, provenance);
+    }
+    const std::string& getName() const override {
+        static const std::string name = "parquet";
+        return name;
+    }
+    ~WriteParquetFactory() override = default;
+};
+
+} /* namespace souffle */
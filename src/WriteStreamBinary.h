@@ -0,0 +1,135 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file WriteStreamBinary.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "BinaryFormat.h"
+#include "IODirectives.h"
+#include "RamTypes.h"
+#include "SymbolTable.h"
+#include "WriteStream.h"
+
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * Writes a relation into a binary file, see BinaryFormat.h. The columns are
+ * collected while the relation is written, and stored once the stream is
+ * destroyed.
+ */
+class WriteFileBinary : public WriteStream {
+public:
+    WriteFileBinary(const std::vector<bool>& symbolMask, const SymbolTable& symbolTable,
+            const IODirectives& ioDirectives, const bool provenance = false)
+            : WriteStream(symbolMask, symbolTable, provenance),
+              file(ioDirectives.getFileName(), std::ios::out | std::ios::binary), columns(arity),
+              writeIndices(ioDirectives.has("symbols") && ioDirectives.get("symbols") == "indices") {}
+
+    ~WriteFileBinary() override {
+        std::vector<uint64_t> offsets(1, 0);
+        for (const auto& symbol : symbols) {
+            offsets.push_back(offsets.back() + symbol.size());
+        }
+        const binary::Header header = binary::makeHeader(arity, tuples, symbols.size(), offsets.back());
+        const binary::Layout layout(header);
+
+        std::vector<uint8_t> types(binary::pad(arity), binary::NUMBER);
+        for (size_t col = 0; col < arity; ++col) {
+            if (symbolMask.at(col)) {
+                types[col] = writeIndices ? binary::INDEX : binary::SYMBOL;
+            }
+        }
+        write(&header, sizeof(header));
+        write(types.data(), types.size());
+        write(offsets.data(), offsets.size() * sizeof(uint64_t));
+        for (const auto& symbol : symbols) {
+            write(symbol.data(), symbol.size());
+        }
+        writePadding(header.symbolBytes);
+        for (const auto& column : columns) {
+            write(column.data(), column.size() * sizeof(RamDomain));
+            writePadding(column.size() * sizeof(RamDomain));
+        }
+        assert(!file || static_cast<uint64_t>(file.tellp()) == layout.size);
+    }
+
+protected:
+    std::ofstream file;
+
+    /** the values of the columns, symbols given by their position in the dictionary */
+    std::vector<std::vector<RamDomain>> columns;
+
+    /** the number of tuples written */
+    uint64_t tuples = 0;
+
+    /** whether symbols are written as their indices in the symbol table rather than into the dictionary */
+    const bool writeIndices;
+
+    /** the dictionary of the symbols written, and the position of each symbol in it */
+    std::vector<std::string> symbols;
+    std::unordered_map<RamDomain, RamDomain> symbolPositions;
+
+    void writeNullary() override {
+        tuples = 1;
+    }
+
+    void writeNextTuple(const RamDomain* tuple) override {
+        for (size_t col = 0; col < arity; ++col) {
+            RamDomain value = tuple[col];
+            if (symbolMask.at(col) && !writeIndices) {
+                auto pos = symbolPositions.find(value);
+                if (pos == symbolPositions.end()) {
+                    pos = symbolPositions.insert(std::make_pair(value, RamDomain(symbols.size()))).first;
+                    symbols.push_back(symbolTable.unsafeResolve(value));
+                }
+                value = pos->second;
+            }
+            columns[col].push_back(value);
+        }
+        ++tuples;
+    }
+
+    void write(const void* data, size_t size) {
+        file.write(static_cast<const char*>(data), size);
+    }
+
+    /** Pad a part of the given size to the alignment of the parts of the file */
+    void writePadding(uint64_t size) {
+        static const char zeros[8] = {};
+        write(zeros, binary::pad(size) - size);
+    }
+};
+
+class WriteFileBinaryFactory : public WriteStreamFactory {
+public:
+    std::unique_ptr<WriteStream> getWriter(const std::vector<bool>& symbolMask,
+            const SymbolTable& symbolTable, const IODirectives& ioDirectives,
+            const bool provenance) override {
+        return std::make_unique<WriteFileBinary>(symbolMask, symbolTable, ioDirectives, provenance);
+    }
+    const std::string& getName() const override {
+        static const std::string name = "binary";
+        return name;
+    }
+    ~WriteFileBinaryFactory() override = default;
+};
+
+} /* namespace souffle */
@@ -14,19 +14,24 @@
 
 #pragma once
 
+#include "Compression.h"
 #include "IODirectives.h"
 #include "ParallelUtils.h"
 #include "SymbolTable.h"
 #include "WriteStream.h"
-#ifdef USE_LIBZ
-#include "gzfstream.h"
-#endif
 
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace souffle {
 
@@ -38,87 +43,206 @@ protected:
         }
         return "\t";
     }
+
+    /** Append the decimal digits of a number to a buffer */
+    static void appendNumber(std::string& out, RamDomain value) {
+        using Unsigned = std::make_unsigned<RamDomain>::type;
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* pos = end;
+        // negated in unsigned arithmetic, which covers the smallest number as well
+        Unsigned magnitude = value < 0 ? Unsigned(0) - Unsigned(value) : Unsigned(value);
+        do {
+            *--pos = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (value < 0) {
+            *--pos = '-';
+        }
+        out.append(pos, end);
+    }
+
+    /** Append the line of a tuple to a buffer */
+    static void appendTuple(std::string& out, const RamDomain* tuple, size_t arity,
+            const std::vector<bool>& symbolMask, const SymbolTable& symbolTable,
+            const std::string& delimiter) {
+        for (size_t col = 0; col < arity; ++col) {
+            if (col != 0) {
+                out += delimiter;
+            }
+            if (symbolMask[col]) {
+                out += symbolTable.unsafeResolve(tuple[col]);
+            } else {
+                appendNumber(out, tuple[col]);
+            }
+        }
+        out += '\n';
+    }
 };
 
+/**
+ * Writes a relation into a fact file. Lines are formatted into a buffer,
+ * written to the file whenever it fills up.
+ *
+ * With the directive parallel="true", relations that can be partitioned
+ * are formatted concurrently, a part per thread at a time, while the parts
+ * are written in the order of the relation. With the directive shards=<n>,
+ * the relation is instead written into n files, named by the file name of
+ * the relation followed by .0 to .<n-1>, each a fact file of a consecutive
+ * sequence of the parts of the relation, written by a thread of its own.
+ */
 class WriteFileCSV : public WriteStreamCSV, public WriteStream {
 public:
     WriteFileCSV(const std::vector<bool>& symbolMask, const SymbolTable& symbolTable,
             const IODirectives& ioDirectives, const bool provenance = false)
             : WriteStream(symbolMask, symbolTable, provenance), delimiter(getDelimiter(ioDirectives)),
-              file(ioDirectives.getFileName(), std::ios::out | std::ios::binary) {
+              fileName(ioDirectives.getFileName()),
+              parallel(ioDirectives.has("parallel") && ioDirectives.get("parallel") == "true"),
+              shards(ioDirectives.has("shards") ? std::stoul(ioDirectives.get("shards")) : 0) {
         if (ioDirectives.has("headers") && ioDirectives.get("headers") == "true") {
-            file << ioDirectives.get("attributeNames") << std::endl;
+            header = ioDirectives.get("attributeNames") + "\n";
+        }
+        if (shards == 0) {
+            file.open(fileName, std::ios::out | std::ios::binary);
+            buffer = header;
+        } else {
+            for (size_t shard = 0; shard < shards; ++shard) {
+                const std::string shardName = fileName + "." + std::to_string(shard);
+                shardFiles.emplace_back(shardName, std::ios::out | std::ios::binary);
+                shardFiles.back() << header;
+            }
         }
     }
 
-    ~WriteFileCSV() override = default;
+    ~WriteFileCSV() override {
+        flush();
+    }
 
 protected:
+    /** the size of the buffer at which it is written to the file */
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+
     const std::string delimiter;
+    const std::string fileName;
+    const bool parallel;
+    const size_t shards;
+    std::string header;
     std::ofstream file;
+    std::vector<std::ofstream> shardFiles;
+    std::string buffer;
 
     void writeNullary() override {
-        file << "()\n";
+        buffer += "()\n";
     }
 
     void writeNextTuple(const RamDomain* tuple) override {
-        if (symbolMask.at(0)) {
-            file << symbolTable.unsafeResolve(tuple[0]);
+        appendTuple(buffer, tuple, arity, symbolMask, symbolTable, delimiter);
+        if (buffer.size() >= BUFFER_SIZE) {
+            flush();
+        }
+    }
+
+    /** Write the buffer to the file, or to the first shard */
+    void flush() {
+        if (shards == 0) {
+            file.write(buffer.data(), buffer.size());
         } else {
-            file << tuple[0];
+            shardFiles.front().write(buffer.data(), buffer.size());
         }
-        for (size_t col = 1; col < arity; ++col) {
-            file << delimiter;
-            if (symbolMask.at(col)) {
-                file << symbolTable.unsafeResolve(tuple[col]);
-            } else {
-                file << tuple[col];
+        buffer.clear();
+    }
+
+    bool writesParts() const override {
+#ifdef _OPENMP
+        return (parallel || shards != 0) && omp_get_max_threads() > 1;
+#else
+        return false;
+#endif
+    }
+
+    void writeParts(const std::vector<Part>& parts) override {
+        flush();
+        const int numParts = parts.size();
+        const int numShards = shards;
+        if (numShards != 0) {
+            // each shard holds a consecutive sequence of parts, written into a buffer of its own
+#pragma omp parallel for schedule(dynamic)
+            for (int shard = 0; shard < numShards; ++shard) {
+                std::string text;
+                std::ofstream& out = shardFiles[shard];
+                for (int i = shard * numParts / numShards; i < (shard + 1) * numParts / numShards; ++i) {
+                    parts[i]([&](const RamDomain* tuple) {
+                        appendTuple(text, tuple, arity, symbolMask, symbolTable, delimiter);
+                        if (text.size() >= BUFFER_SIZE) {
+                            out.write(text.data(), text.size());
+                            text.clear();
+                        }
+                    });
+                }
+                out.write(text.data(), text.size());
+            }
+            return;
+        }
+#ifdef _OPENMP
+        const int threads = omp_get_max_threads();
+#else
+        const int threads = 1;
+#endif
+        // the parts are formatted a round of one per thread at a time, and written in order
+        std::vector<std::string> texts(threads);
+        for (int first = 0; first < numParts; first += threads) {
+            const int last = std::min(first + threads, numParts);
+#pragma omp parallel for schedule(dynamic)
+            for (int i = first; i < last; ++i) {
+                std::string& text = texts[i - first];
+                text.clear();
+                parts[i]([&](const RamDomain* tuple) {
+                    appendTuple(text, tuple, arity, symbolMask, symbolTable, delimiter);
+                });
+            }
+            for (int i = first; i < last; ++i) {
+                file.write(texts[i - first].data(), texts[i - first].size());
             }
         }
-        file << "\n";
     }
 };
 
-#ifdef USE_LIBZ
-class WriteGZipFileCSV : public WriteStreamCSV, public WriteStream {
+/**
+ * Writes a relation into a compressed fact file, with the directive
+ * compress="zstd" in the zstd format and gzip otherwise. The lines are
+ * compressed in blocks, concurrently, see Compression.h.
+ */
+class WriteCompressedFileCSV : public WriteStreamCSV, public WriteStream {
 public:
-    WriteGZipFileCSV(const std::vector<bool>& symbolMask, const SymbolTable& symbolTable,
+    WriteCompressedFileCSV(const std::vector<bool>& symbolMask, const SymbolTable& symbolTable,
             const IODirectives& ioDirectives, const bool provenance = false)
             : WriteStream(symbolMask, symbolTable, provenance), delimiter(getDelimiter(ioDirectives)),
-              file(ioDirectives.getFileName(), std::ios::out | std::ios::binary) {
+              file(ioDirectives.getFileName(), std::ios::out | std::ios::binary),
+              compressor(file, ioDirectives.get("compress") == "zstd" ? compression::Format::ZSTD
+                                                                     : compression::Format::GZIP) {
         if (ioDirectives.has("headers") && ioDirectives.get("headers") == "true") {
-            file << ioDirectives.get("attributeNames") << std::endl;
+            compressor.write(ioDirectives.get("attributeNames") + "\n");
         }
     }
 
-    ~WriteGZipFileCSV() override = default;
+    ~WriteCompressedFileCSV() override = default;
 
 protected:
     void writeNullary() override {
-        file << "()\n";
+        compressor.write("()\n");
     }
 
     void writeNextTuple(const RamDomain* tuple) override {
-        if (symbolMask.at(0)) {
-            file << symbolTable.unsafeResolve(tuple[0]);
-        } else {
-            file << tuple[0];
-        }
-        for (size_t col = 1; col < arity; ++col) {
-            file << delimiter;
-            if (symbolMask.at(col)) {
-                file << symbolTable.unsafeResolve(tuple[col]);
-            } else {
-                file << tuple[col];
-            }
-        }
-        file << "\n";
+        line.clear();
+        appendTuple(line, tuple, arity, symbolMask, symbolTable, delimiter);
+        compressor.write(line);
     }
 
     const std::string delimiter;
-    gzfstream::ogzfstream file;
+    std::ofstream file;
+    compression::BlockCompressor compressor;
+    std::string line;
 };
-#endif
 
 class WriteCoutCSV : public WriteStreamCSV, public WriteStream {
 public:
@@ -191,11 +315,10 @@ public:
     std::unique_ptr<WriteStream> getWriter(const std::vector<bool>& symbolMask,
             const SymbolTable& symbolTable, const IODirectives& ioDirectives,
             const bool provenance) override {
-#ifdef USE_LIBZ
         if (ioDirectives.has("compress")) {
-            return std::make_unique<WriteGZipFileCSV>(symbolMask, symbolTable, ioDirectives, provenance);
+            return std::make_unique<WriteCompressedFileCSV>(
+                    symbolMask, symbolTable, ioDirectives, provenance);
         }
-#endif
         return std::make_unique<WriteFileCSV>(symbolMask, symbolTable, ioDirectives, provenance);
     }
     const std::string& getName() const override {
@@ -14,64 +14,118 @@
 
 #pragma once
 
+#include "IODirectives.h"
 #include "SymbolTable.h"
 #include "WriteStream.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <sqlite3.h>
 
 namespace souffle {
 
+/**
+ * Writes a relation into a table of an SQLite database, with a view
+ * resolving its symbols through a table of symbols shared by the
+ * relations of the database.
+ *
+ * The relation is written in a single transaction, in batches of tuples:
+ * the symbols of a batch that are new to the stream are inserted and
+ * selected with one statement for many symbols, and the tuples are
+ * inserted with one statement for many rows. With the directive
+ * index="true" an index of each column is built once the relation is
+ * loaded. The directives journal_mode and synchronous set the pragmas of
+ * the same names, by default MEMORY and OFF.
+ */
 class WriteStreamSQLite : public WriteStream {
 public:
     WriteStreamSQLite(const std::string& dbFilename, const std::string& relationName,
-            const std::vector<bool>& symbolMask, const SymbolTable& symbolTable, const bool provenance)
+            const std::vector<bool>& symbolMask, const SymbolTable& symbolTable,
+            const IODirectives& ioDirectives, const bool provenance)
             : WriteStream(symbolMask, symbolTable, provenance), dbFilename(dbFilename),
-              relationName(relationName) {
-        openDB();
+              relationName(relationName),
+              index(ioDirectives.has("index") && ioDirectives.get("index") == "true") {
+        openDB(pragma(ioDirectives, "journal_mode", "MEMORY"), pragma(ioDirectives, "synchronous", "OFF"));
+        executeSQL("BEGIN TRANSACTION", db);
         createTables();
-        prepareStatements();
-        //        executeSQL("BEGIN TRANSACTION", db);
+        // the number of rows of a statement is limited by the number of its parameters
+        const int parameters = std::min(sqlite3_limit(db, SQLITE_LIMIT_VARIABLE_NUMBER, -1), 32766);
+        symbolsPerStatement = parameters;
+        rowsPerStatement = std::max<size_t>(1, parameters / std::max<size_t>(1, arity));
     }
 
     ~WriteStreamSQLite() override {
-        sqlite3_finalize(insertStatement);
-        sqlite3_finalize(symbolInsertStatement);
-        sqlite3_finalize(symbolSelectStatement);
+        try {
+            flush();
+            createIndexes();
+            executeSQL("COMMIT", db);
+        } catch (std::exception& e) {
+            std::cerr << "Cannot write relation " << relationName << " into " << dbFilename << ": "
+                      << e.what();
+        }
+        for (auto& statement : statements) {
+            sqlite3_finalize(statement.second);
+        }
         sqlite3_close(db);
     }
 
 protected:
+    /** the number of tuples collected before they are inserted */
+    static constexpr size_t BATCH_SIZE = 1 << 16;
+
     void writeNullary() override {}
 
     void writeNextTuple(const RamDomain* tuple) override {
-        for (size_t i = 0; i < arity; i++) {
-            RamDomain value;
-            if (symbolMask.at(i)) {
-                value = getSymbolTableID(tuple[i]);
-            } else {
-                value = tuple[i];
-            }
-#if RAM_DOMAIN_SIZE == 64
-            if (sqlite3_bind_int64(insertStatement, i + 1, value) != SQLITE_OK) {
-#else
-            if (sqlite3_bind_int(insertStatement, i + 1, value) != SQLITE_OK) {
-#endif
-                throwError("SQLite error in sqlite3_bind_text: ");
-            }
+        batch.insert(batch.end(), tuple, tuple + arity);
+        if (batch.size() >= BATCH_SIZE * arity) {
+            flush();
         }
-        if (sqlite3_step(insertStatement) != SQLITE_DONE) {
-            throwError("SQLite error in sqlite3_step: ");
+    }
+
+    /** Insert the tuples collected, along with their new symbols */
+    void flush() {
+        if (batch.empty()) {
+            return;
+        }
+        insertSymbols();
+
+        const size_t rows = batch.size() / arity;
+        for (size_t row = 0; row < rows; row += rowsPerStatement) {
+            const size_t count = std::min(rowsPerStatement, rows - row);
+            sqlite3_stmt* statement = getInsertStatement(count);
+            for (size_t i = 0; i < count * arity; ++i) {
+                const size_t col = i % arity;
+                RamDomain value = batch[row * arity + i];
+                bind(statement, i + 1, symbolMask.at(col) ? dbSymbolTable[value] : value);
+            }
+            step(statement, SQLITE_DONE);
         }
-        sqlite3_clear_bindings(insertStatement);
-        sqlite3_reset(insertStatement);
+        batch.clear();
     }
 
 private:
+    static std::string pragma(
+            const IODirectives& ioDirectives, const std::string& key, const std::string& value) {
+        if (!ioDirectives.has(key)) {
+            return value;
+        }
+        const std::string given = ioDirectives.get(key);
+        for (const char c : given) {
+            if (!std::isalpha(c)) {
+                throw std::invalid_argument("Invalid SQLite " + key + ": " + given);
+            }
+        }
+        return given;
+    }
+
     void executeSQL(const std::string& sql, sqlite3* db) {
         assert(db && "Database connection is closed");
 
@@ -94,97 +148,111 @@ private:
         throw std::invalid_argument(error.str());
     }
 
-    uint64_t getSymbolTableIDFromDB(int index) {
-        if (sqlite3_bind_text(symbolSelectStatement, 1, symbolTable.unsafeResolve(index).c_str(), -1,
-                    SQLITE_TRANSIENT) != SQLITE_OK) {
-            throwError("SQLite error in sqlite3_bind_text: ");
-        }
-        if (sqlite3_step(symbolSelectStatement) != SQLITE_ROW) {
-            throwError("SQLite error in sqlite3_step: ");
+    void bind(sqlite3_stmt* statement, int parameter, int64_t value) {
+        if (sqlite3_bind_int64(statement, parameter, value) != SQLITE_OK) {
+            throwError("SQLite error in sqlite3_bind_int64: ");
         }
-        uint64_t rowid = sqlite3_column_int64(symbolSelectStatement, 0);
-        sqlite3_clear_bindings(symbolSelectStatement);
-        sqlite3_reset(symbolSelectStatement);
-        return rowid;
     }
-    uint64_t getSymbolTableID(int index) {
-        if (dbSymbolTable.count(index) != 0) {
-            return dbSymbolTable[index];
-        }
 
-        if (sqlite3_bind_text(symbolInsertStatement, 1, symbolTable.unsafeResolve(index).c_str(), -1,
-                    SQLITE_TRANSIENT) != SQLITE_OK) {
+    void bind(sqlite3_stmt* statement, int parameter, const std::string& value) {
+        if (sqlite3_bind_text(statement, parameter, value.c_str(), -1, SQLITE_TRANSIENT) != SQLITE_OK) {
             throwError("SQLite error in sqlite3_bind_text: ");
         }
-        // Either the insert succeeds and we have a new row id or it already exists and a select is needed.
-        uint64_t rowid;
-        if (sqlite3_step(symbolInsertStatement) != SQLITE_DONE) {
-            // The symbol already exists so select it.
-            rowid = getSymbolTableIDFromDB(index);
-        } else {
-            rowid = sqlite3_last_insert_rowid(db);
-        }
-        sqlite3_clear_bindings(symbolInsertStatement);
-        sqlite3_reset(symbolInsertStatement);
-
-        dbSymbolTable[index] = rowid;
-        return rowid;
     }
 
-    void openDB() {
-        if (sqlite3_open(dbFilename.c_str(), &db) != SQLITE_OK) {
-            throwError("SQLite error in sqlite3_open");
+    void step(sqlite3_stmt* statement, int expected) {
+        if (sqlite3_step(statement) != expected) {
+            throwError("SQLite error in sqlite3_step: ");
         }
-        sqlite3_extended_result_codes(db, 1);
-        executeSQL("PRAGMA synchronous = OFF", db);
-        executeSQL("PRAGMA journal_mode = MEMORY", db);
+        sqlite3_reset(statement);
     }
 
-    void prepareStatements() {
-        prepareInsertStatement();
-        prepareSymbolInsertStatement();
-        prepareSymbolSelectStatement();
-    }
-    void prepareSymbolInsertStatement() {
-        std::stringstream insertSQL;
-        insertSQL << "INSERT INTO " << symbolTableName;
-        insertSQL << " VALUES(null,@V0);";
+    /** Get a statement prepared once for each text */
+    sqlite3_stmt* prepare(const std::string& sql) {
+        auto found = statements.find(sql);
+        if (found != statements.end()) {
+            return found->second;
+        }
+        sqlite3_stmt* statement = nullptr;
         const char* tail = nullptr;
-        if (sqlite3_prepare_v2(db, insertSQL.str().c_str(), -1, &symbolInsertStatement, &tail) != SQLITE_OK) {
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &statement, &tail) != SQLITE_OK) {
             throwError("SQLite error in sqlite3_prepare_v2: ");
         }
+        statements[sql] = statement;
+        return statement;
     }
 
-    void prepareSymbolSelectStatement() {
-        std::stringstream selectSQL;
-        selectSQL << "SELECT id FROM " << symbolTableName;
-        selectSQL << " WHERE symbol = @V0;";
-        const char* tail = nullptr;
-        if (sqlite3_prepare_v2(db, selectSQL.str().c_str(), -1, &symbolSelectStatement, &tail) != SQLITE_OK) {
-            throwError("SQLite error in sqlite3_prepare_v2: ");
+    /** The parameters of a number of rows of the given width, as in (?,?),(?,?) */
+    static std::string parameterRows(size_t rows, size_t width) {
+        std::string row = "(?";
+        for (size_t i = 1; i < width; ++i) {
+            row += ",?";
+        }
+        row += ")";
+        std::string result = row;
+        for (size_t i = 1; i < rows; ++i) {
+            result += "," + row;
         }
+        return result;
+    }
+
+    sqlite3_stmt* getInsertStatement(size_t rows) {
+        return prepare("INSERT INTO '_" + relationName + "' VALUES " + parameterRows(rows, arity) + ";");
     }
 
-    void prepareInsertStatement() {
-        std::stringstream insertSQL;
-        insertSQL << "INSERT INTO '_" << relationName << "' VALUES ";
-        insertSQL << "(@V0";
-        for (unsigned int i = 1; i < arity; i++) {
-            insertSQL << ",@V" << i;
+    /** Insert the symbols of the batch not inserted before, and select their row ids */
+    void insertSymbols() {
+        std::vector<RamDomain> symbols;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (symbolMask.at(i % arity) && dbSymbolTable.insert(std::make_pair(batch[i], 0)).second) {
+                symbols.push_back(batch[i]);
+            }
         }
-        insertSQL << ");";
-        const char* tail = nullptr;
-        if (sqlite3_prepare_v2(db, insertSQL.str().c_str(), -1, &insertStatement, &tail) != SQLITE_OK) {
-            throwError("SQLite error in sqlite3_prepare_v2: ");
+        for (size_t first = 0; first < symbols.size(); first += symbolsPerStatement) {
+            const size_t count = std::min(symbolsPerStatement, symbols.size() - first);
+            sqlite3_stmt* insert = prepare("INSERT OR IGNORE INTO '" + symbolTableName + "'(symbol) VALUES " +
+                                           parameterRows(count, 1) + ";");
+            sqlite3_stmt* select = prepare("SELECT id, symbol FROM '" + symbolTableName +
+                                           "' WHERE symbol IN " + parameterRows(1, count) + ";");
+            std::unordered_map<std::string, RamDomain> indices;
+            for (size_t i = 0; i < count; ++i) {
+                const std::string& symbol = symbolTable.unsafeResolve(symbols[first + i]);
+                indices[symbol] = symbols[first + i];
+                bind(insert, i + 1, symbol);
+                bind(select, i + 1, symbol);
+            }
+            step(insert, SQLITE_DONE);
+            int result;
+            while ((result = sqlite3_step(select)) == SQLITE_ROW) {
+                const std::string symbol(reinterpret_cast<const char*>(sqlite3_column_text(select, 1)));
+                dbSymbolTable[indices.at(symbol)] = sqlite3_column_int64(select, 0);
+            }
+            if (result != SQLITE_DONE) {
+                throwError("SQLite error in sqlite3_step: ");
+            }
+            sqlite3_reset(select);
         }
     }
 
+    void openDB(const std::string& journalMode, const std::string& synchronous) {
+        if (sqlite3_open(dbFilename.c_str(), &db) != SQLITE_OK) {
+            throwError("SQLite error in sqlite3_open");
+        }
+        sqlite3_extended_result_codes(db, 1);
+        executeSQL("PRAGMA synchronous = " + synchronous, db);
+        executeSQL("PRAGMA journal_mode = " + journalMode, db);
+    }
+
     void createTables() {
         createRelationTable();
         createRelationView();
         createSymbolTable();
     }
 
+    std::string indexName(size_t col) const {
+        return "'_" + relationName + "_" + std::to_string(col) + "'";
+    }
+
     void createRelationTable() {
         std::stringstream createTableText;
         createTableText << "CREATE TABLE IF NOT EXISTS '_" << relationName << "' (";
@@ -197,9 +265,24 @@ private:
         }
         createTableText << ");";
         executeSQL(createTableText.str(), db);
+        // indexes are built after the load rather than maintained during it
+        for (size_t col = 0; col < arity; ++col) {
+            executeSQL("DROP INDEX IF EXISTS " + indexName(col) + ";", db);
+        }
         executeSQL("DELETE FROM '_" + relationName + "';", db);
     }
 
+    void createIndexes() {
+        if (!index) {
+            return;
+        }
+        for (size_t col = 0; col < arity; ++col) {
+            executeSQL("CREATE INDEX " + indexName(col) + " ON '_" + relationName + "'('" +
+                               std::to_string(col) + "');",
+                    db);
+        }
+    }
+
     void createRelationView() {
         // Create view with symbol strings resolved
         std::stringstream createViewText;
@@ -242,14 +325,19 @@ private:
         executeSQL(createTableText.str(), db);
     }
 
-    const std::string& dbFilename;
-    const std::string& relationName;
+    const std::string dbFilename;
+    const std::string relationName;
     const std::string symbolTableName = "__SymbolTable";
+    const bool index;
+
+    /** the tuples collected, one after the other */
+    std::vector<RamDomain> batch;
+    size_t rowsPerStatement;
+    size_t symbolsPerStatement;
 
-    std::unordered_map<uint64_t, uint64_t> dbSymbolTable;
-    sqlite3_stmt* insertStatement = nullptr;
-    sqlite3_stmt* symbolInsertStatement = nullptr;
-    sqlite3_stmt* symbolSelectStatement = nullptr;
+    /** the row ids of the symbols inserted, by their index in the symbol table */
+    std::unordered_map<RamDomain, int64_t> dbSymbolTable;
+    std::unordered_map<std::string, sqlite3_stmt*> statements;
     sqlite3* db = nullptr;
 };
 
@@ -260,7 +348,8 @@ public:
             const bool provenance) override {
         std::string dbName = ioDirectives.get("dbname");
         std::string relationName = ioDirectives.getRelationName();
-        return std::make_unique<WriteStreamSQLite>(dbName, relationName, symbolMask, symbolTable, provenance);
+        return std::make_unique<WriteStreamSQLite>(
+                dbName, relationName, symbolMask, symbolTable, ioDirectives, provenance);
     }
     const std::string& getName() const override {
         static const std::string name = "sqlite";
@@ -0,0 +1,275 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file bench.h
+ *
+ * Simple micro-benchmark infrastructure
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace souffle {
+namespace bench {
+
+/**
+ * The state of a benchmark run, timing a number of iterations of the
+ * measured code as in
+ *
+ *     while (state.keepRunning()) { ... }
+ *
+ * Preparations within an iteration may be excluded by pausing the timer.
+ */
+class State {
+public:
+    State(size_t iterations, size_t threads) : iterations(iterations), threads(threads) {}
+
+    /** Whether to run another iteration, starting the timer with the first */
+    bool keepRunning() {
+        if (done == 0) {
+            start = clock::now();
+        }
+        if (done < iterations) {
+            done++;
+            return true;
+        }
+        elapsed += clock::now() - start;
+        return false;
+    }
+
+    /** Exclude the following code from the measured time */
+    void pauseTiming() {
+        elapsed += clock::now() - start;
+    }
+
+    /** Include the following code in the measured time again */
+    void resumeTiming() {
+        start = clock::now();
+    }
+
+    /** Set the number of items, e.g. tuples, processed by each iteration */
+    void setItems(size_t items) {
+        itemsPerIteration = items;
+    }
+
+    /** Get the number of iterations */
+    size_t getIterations() const {
+        return iterations;
+    }
+
+    /** Get the number of threads the benchmark may use */
+    size_t getThreads() const {
+        return threads;
+    }
+
+    /** Get the measured time in seconds */
+    double getSeconds() const {
+        return std::chrono::duration<double>(elapsed).count();
+    }
+
+    /** Get the items processed by each iteration */
+    size_t getItems() const {
+        return itemsPerIteration;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    size_t iterations;
+    size_t threads;
+    size_t done = 0;
+    size_t itemsPerIteration = 0;
+    clock::time_point start;
+    clock::duration elapsed{};
+};
+
+/**
+ * A registered benchmark.
+ */
+struct Benchmark {
+    std::string name;
+    std::function<void(State&)> body;
+
+    /** Whether the benchmark runs with several threads */
+    bool parallel;
+};
+
+/** Obtain the registered benchmarks */
+inline std::vector<Benchmark>& getBenchmarks() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+/** Register a benchmark under a name of the form structure/operation/... */
+inline void registerBenchmark(
+        const std::string& name, std::function<void(State&)> body, bool parallel = false) {
+    getBenchmarks().push_back(Benchmark{name, std::move(body), parallel});
+}
+
+/** Prevent the compiler from eliminating the computation of a value */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// -------- key distributions ----------
+
+/** the distributions of benchmark keys */
+enum class Distribution { UNIFORM, ZIPF, SORTED };
+
+inline const char* getDistributionName(Distribution distribution) {
+    switch (distribution) {
+        case Distribution::UNIFORM:
+            return "uniform";
+        case Distribution::ZIPF:
+            return "zipf";
+        case Distribution::SORTED:
+            return "sorted";
+    }
+    return "";
+}
+
+/**
+ * Generate tuples of the given arity whose columns are drawn from a domain
+ * large enough to make most tuples distinct; zipf keys favour small values
+ * with an exponent of 1, sorted keys are uniform keys in lexicographical
+ * order.
+ */
+template <typename Tuple, unsigned Arity>
+std::vector<Tuple> generateKeys(size_t n, Distribution distribution, unsigned seed = 42) {
+    std::mt19937 gen(seed);
+    auto domain = std::max<size_t>(4 * std::ceil(std::pow(n, 1.0 / Arity)), 16);
+
+    // the cumulated weights of the values of zipf keys
+    std::vector<double> cdf(domain);
+    double sum = 0;
+    for (size_t i = 0; i < domain; i++) {
+        sum += 1.0 / (i + 1);
+        cdf[i] = sum;
+    }
+    std::uniform_int_distribution<size_t> uniform(0, domain - 1);
+    std::uniform_real_distribution<double> real(0, sum);
+
+    std::vector<Tuple> keys(n);
+    for (auto& key : keys) {
+        for (unsigned i = 0; i < Arity; i++) {
+            if (distribution == Distribution::ZIPF) {
+                key[i] = std::lower_bound(cdf.begin(), cdf.end(), real(gen)) - cdf.begin();
+            } else {
+                key[i] = uniform(gen);
+            }
+        }
+    }
+    if (distribution == Distribution::SORTED) {
+        std::sort(keys.begin(), keys.end(), [](const Tuple& a, const Tuple& b) {
+            for (unsigned i = 0; i < Arity; i++) {
+                if (a[i] != b[i]) {
+                    return a[i] < b[i];
+                }
+            }
+            return false;
+        });
+    }
+    return keys;
+}
+
+// -------- runner ----------
+
+/**
+ * Run the registered benchmarks matching a filter, increasing the iterations
+ * of each until it runs for a minimal time, and print the time per iteration
+ * and the processed items per second as a table or as CSV.
+ *
+ * Options: --filter=REGEX, --min-time=SECONDS, --threads=N, --csv
+ */
+inline int runBenchmarks(int argc, char** argv) {
+    std::regex filter(".*");
+    double minTime = 0.5;
+    size_t threads = 1;
+    bool csv = false;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--filter=") == 0) {
+            filter = std::regex(arg.substr(9));
+        } else if (arg.compare(0, 11, "--min-time=") == 0) {
+            minTime = std::stod(arg.substr(11));
+        } else if (arg.compare(0, 10, "--threads=") == 0) {
+            threads = std::stoul(arg.substr(10));
+        } else if (arg == "--csv") {
+            csv = true;
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--filter=REGEX] [--min-time=SECONDS] [--threads=N] [--csv]\n";
+            return 1;
+        }
+    }
+
+    if (csv) {
+        std::printf("benchmark,threads,iterations,ns_per_iteration,items_per_second\n");
+    } else {
+        std::printf("%-50s %8s %10s %16s %16s\n", "BENCHMARK", "THREADS", "ITERATIONS", "NS/ITERATION",
+                "ITEMS/S");
+    }
+    for (const auto& benchmark : getBenchmarks()) {
+        if (!std::regex_search(benchmark.name, filter)) {
+            continue;
+        }
+        size_t numThreads = benchmark.parallel ? threads : 1;
+#ifdef _OPENMP
+        omp_set_num_threads(numThreads);
+#endif
+        size_t iterations = 1;
+        while (true) {
+            State state(iterations, numThreads);
+            benchmark.body(state);
+            double seconds = state.getSeconds();
+            if (seconds >= minTime || iterations >= (1ul << 30)) {
+                double perIteration = seconds / iterations;
+                double itemsPerSecond = (seconds > 0) ? state.getItems() * iterations / seconds : 0;
+                if (csv) {
+                    std::printf("%s,%zu,%zu,%.1f,%.0f\n", benchmark.name.c_str(), numThreads, iterations,
+                            perIteration * 1e9, itemsPerSecond);
+                } else {
+                    std::printf("%-50s %8zu %10zu %16.1f %16.0f\n", benchmark.name.c_str(), numThreads,
+                            iterations, perIteration * 1e9, itemsPerSecond);
+                }
+                std::fflush(stdout);
+                break;
+            }
+            // aim for the minimal time, growing by at least a factor of two
+            double factor = (seconds > 0) ? 1.4 * minTime / seconds : 10;
+            iterations = std::max<size_t>(2 * iterations, std::min(factor, 100.0) * iterations);
+        }
+    }
+    return 0;
+}
+
+}  // namespace bench
+}  // namespace souffle
@@ -0,0 +1,429 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file datastructures_bench.cpp
+ *
+ * Micro-benchmarks of the b-trees, bries, equivalence relations and the
+ * symbol table, measuring insertions, look-ups, range queries, iteration,
+ * partitioning and merging over keys of different distributions.
+ *
+ ***********************************************************************/
+
+#include "BTree.h"
+#include "Brie.h"
+#include "CompiledIndexUtils.h"
+#include "CompiledTuple.h"
+#include "EquivalenceRelation.h"
+#include "ParallelUtils.h"
+#include "RamTypes.h"
+#include "SymbolTable.h"
+#include "bench.h"
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace souffle {
+namespace bench {
+
+namespace {
+
+/** the number of keys of each benchmark */
+const size_t numKeys = 100000;
+
+/** the number of chunks requested by partitioning benchmarks */
+const size_t numChunks = 400;
+
+/** the lexicographical order of tuples of an arity */
+template <unsigned Arity>
+struct Order;
+
+template <>
+struct Order<1> {
+    using type = ram::index_utils::comparator<0>;
+};
+template <>
+struct Order<2> {
+    using type = ram::index_utils::comparator<0, 1>;
+};
+template <>
+struct Order<3> {
+    using type = ram::index_utils::comparator<0, 1, 2>;
+};
+template <>
+struct Order<4> {
+    using type = ram::index_utils::comparator<0, 1, 2, 3>;
+};
+template <>
+struct Order<5> {
+    using type = ram::index_utils::comparator<0, 1, 2, 3, 4>;
+};
+template <>
+struct Order<6> {
+    using type = ram::index_utils::comparator<0, 1, 2, 3, 4, 5>;
+};
+
+/** The operations of b-tree sets and multi-sets */
+template <unsigned Arity, bool Unique>
+struct BTreeStructure {
+    using tuple = ram::Tuple<RamDomain, Arity>;
+    using set = typename std::conditional<Unique, btree_set<tuple, typename Order<Arity>::type>,
+            btree_multiset<tuple, typename Order<Arity>::type>>::type;
+    using hints = typename set::operation_hints;
+
+    static const char* getName() {
+        return Unique ? "btree_set" : "btree_multiset";
+    }
+    static void insert(set& s, const tuple& t, hints& h) {
+        s.insert(t, h);
+    }
+    static bool contains(const set& s, const tuple& t, hints& h) {
+        return s.contains(t, h);
+    }
+    /** the tuples sharing the first column of a tuple, located by a lower and an upper bound */
+    static bool bound(const set& s, const tuple& t, hints& h) {
+        tuple low = t;
+        tuple high = t;
+        for (unsigned i = 1; i < Arity; i++) {
+            low[i] = std::numeric_limits<RamDomain>::min();
+            high[i] = std::numeric_limits<RamDomain>::max();
+        }
+        return s.lower_bound(low, h) != s.upper_bound(high, h);
+    }
+    static std::vector<typename set::chunk> partition(const set& s) {
+        return s.getChunks(numChunks);
+    }
+    static void merge(set& s, const set& other) {
+        s.insertAll(other);
+    }
+};
+
+/** The operations of bries */
+template <unsigned Arity>
+struct BrieStructure {
+    using set = Trie<Arity>;
+    using tuple = typename set::entry_type;
+    using hints = typename set::op_context;
+
+    static const char* getName() {
+        return "brie";
+    }
+    static void insert(set& s, const tuple& t, hints& h) {
+        s.insert(t, h);
+    }
+    static bool contains(const set& s, const tuple& t, hints& h) {
+        return s.contains(t, h);
+    }
+    /** the tuples sharing the first column of a tuple */
+    static bool bound(const set& s, const tuple& t, hints& h) {
+        auto r = s.template getBoundaries<1>(t, h);
+        return r.begin() != r.end();
+    }
+    static std::vector<range<typename set::iterator>> partition(const set& s) {
+        return s.partition(numChunks);
+    }
+    static void merge(set& s, const set& other) {
+        s.insertAll(other);
+    }
+};
+
+/** The operations of equivalence relations */
+struct EqrelStructure {
+    using tuple = ram::Tuple<RamDomain, 2>;
+    using set = EquivalenceRelation<tuple>;
+    using hints = set::operation_hints;
+
+    static const char* getName() {
+        return "eqrel";
+    }
+    static void insert(set& s, const tuple& t, hints& h) {
+        s.insert(t[0], t[1], h);
+    }
+    static bool contains(const set& s, const tuple& t, hints&) {
+        return s.contains(t[0], t[1]);
+    }
+    static std::vector<range<set::iterator>> partition(const set& s) {
+        return s.partition(numChunks);
+    }
+    static void merge(set& s, const set& other) {
+        s.insertAll(other);
+    }
+};
+
+template <typename Structure>
+void insertBenchmark(State& state, const std::vector<typename Structure::tuple>& keys) {
+    while (state.keepRunning()) {
+        typename Structure::set s;
+        typename Structure::hints h;
+        for (const auto& key : keys) {
+            Structure::insert(s, key, h);
+        }
+        doNotOptimize(s);
+    }
+    state.setItems(keys.size());
+}
+
+template <typename Structure>
+void parallelInsertBenchmark(State& state, const std::vector<typename Structure::tuple>& keys) {
+    while (state.keepRunning()) {
+        typename Structure::set s;
+        PARALLEL_START {
+            typename Structure::hints h;
+            pfor(size_t i = 0; i < keys.size(); i++) {
+                Structure::insert(s, keys[i], h);
+            }
+        }
+        PARALLEL_END
+        doNotOptimize(s);
+    }
+    state.setItems(keys.size());
+}
+
+template <typename Structure, typename Set>
+void fill(Set& s, const std::vector<typename Structure::tuple>& keys) {
+    typename Structure::hints h;
+    for (const auto& key : keys) {
+        Structure::insert(s, key, h);
+    }
+}
+
+template <typename Structure>
+void containsBenchmark(State& state, const std::vector<typename Structure::tuple>& keys) {
+    typename Structure::set s;
+    fill<Structure>(s, keys);
+    while (state.keepRunning()) {
+        typename Structure::hints h;
+        size_t found = 0;
+        for (const auto& key : keys) {
+            found += Structure::contains(s, key, h);
+        }
+        doNotOptimize(found);
+    }
+    state.setItems(keys.size());
+}
+
+template <typename Structure>
+void parallelContainsBenchmark(State& state, const std::vector<typename Structure::tuple>& keys) {
+    typename Structure::set s;
+    fill<Structure>(s, keys);
+    while (state.keepRunning()) {
+        PARALLEL_START {
+            typename Structure::hints h;
+            size_t found = 0;
+            pfor(size_t i = 0; i < keys.size(); i++) {
+                found += Structure::contains(s, keys[i], h);
+            }
+            doNotOptimize(found);
+        }
+        PARALLEL_END
+    }
+    state.setItems(keys.size());
+}
+
+template <typename Structure>
+void boundBenchmark(State& state, const std::vector<typename Structure::tuple>& keys) {
+    typename Structure::set s;
+    fill<Structure>(s, keys);
+    while (state.keepRunning()) {
+        typename Structure::hints h;
+        size_t found = 0;
+        for (const auto& key : keys) {
+            found += Structure::bound(s, key, h);
+        }
+        doNotOptimize(found);
+    }
+    state.setItems(keys.size());
+}
+
+template <typename Structure>
+void iterateBenchmark(State& state, const std::vector<typename Structure::tuple>& keys) {
+    typename Structure::set s;
+    fill<Structure>(s, keys);
+    size_t count = 0;
+    while (state.keepRunning()) {
+        count = 0;
+        for (const auto& t : s) {
+            count++;
+            doNotOptimize(t);
+        }
+    }
+    state.setItems(count);
+}
+
+/** partition and iterate over the chunks in parallel */
+template <typename Structure>
+void partitionBenchmark(State& state, const std::vector<typename Structure::tuple>& keys) {
+    typename Structure::set s;
+    fill<Structure>(s, keys);
+    size_t count = 0;
+    while (state.keepRunning()) {
+        auto chunks = Structure::partition(s);
+        count = 0;
+        PARALLEL_START {
+            size_t local = 0;
+            pfor(size_t i = 0; i < chunks.size(); i++) {
+                for (const auto& t : chunks[i]) {
+                    local++;
+                    doNotOptimize(t);
+                }
+            }
+#pragma omp atomic
+            count += local;
+        }
+        PARALLEL_END
+    }
+    state.setItems(count);
+}
+
+/** merge a set holding the second half of the keys into a set holding the first half */
+template <typename Structure>
+void mergeBenchmark(State& state, const std::vector<typename Structure::tuple>& keys) {
+    std::vector<typename Structure::tuple> first(keys.begin(), keys.begin() + keys.size() / 2);
+    std::vector<typename Structure::tuple> second(keys.begin() + keys.size() / 2, keys.end());
+    typename Structure::set other;
+    fill<Structure>(other, second);
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        typename Structure::set s;
+        fill<Structure>(s, first);
+        state.resumeTiming();
+        Structure::merge(s, other);
+        doNotOptimize(s);
+    }
+    state.setItems(second.size());
+}
+
+/** register a benchmark of an operation over keys of a distribution, generating the keys on first use */
+template <typename Structure, unsigned Arity>
+void registerOperation(const std::string& operation,
+        void (*body)(State&, const std::vector<typename Structure::tuple>&), Distribution distribution,
+        bool parallel = false) {
+    using tuple = typename Structure::tuple;
+    auto keys = std::make_shared<std::vector<tuple>>();
+    registerBenchmark(std::string(Structure::getName()) + "/" + operation + "/" +
+                              getDistributionName(distribution) + "/" + std::to_string(Arity),
+            [keys, body, distribution](State& state) {
+                if (keys->empty()) {
+                    *keys = generateKeys<tuple, Arity>(numKeys, distribution);
+                }
+                body(state, *keys);
+            },
+            parallel);
+}
+
+/** register the benchmarks of a set structure of an arity */
+template <typename Structure, unsigned Arity>
+void registerSet() {
+    for (Distribution distribution : {Distribution::UNIFORM, Distribution::ZIPF, Distribution::SORTED}) {
+        registerOperation<Structure, Arity>("insert", insertBenchmark<Structure>, distribution);
+        registerOperation<Structure, Arity>(
+                "parallel-insert", parallelInsertBenchmark<Structure>, distribution, true);
+        registerOperation<Structure, Arity>("contains", containsBenchmark<Structure>, distribution);
+        registerOperation<Structure, Arity>(
+                "parallel-contains", parallelContainsBenchmark<Structure>, distribution, true);
+        registerOperation<Structure, Arity>("bound", boundBenchmark<Structure>, distribution);
+        registerOperation<Structure, Arity>("iterate", iterateBenchmark<Structure>, distribution);
+        registerOperation<Structure, Arity>("partition", partitionBenchmark<Structure>, distribution, true);
+        registerOperation<Structure, Arity>("merge", mergeBenchmark<Structure>, distribution);
+    }
+}
+
+template <unsigned Arity>
+void registerArity() {
+    registerSet<BTreeStructure<Arity, true>, Arity>();
+    registerSet<BTreeStructure<Arity, false>, Arity>();
+    registerSet<BrieStructure<Arity>, Arity>();
+}
+
+/** register the benchmarks of equivalence relations, which have no range queries */
+void registerEqrel() {
+    for (Distribution distribution : {Distribution::UNIFORM, Distribution::ZIPF, Distribution::SORTED}) {
+        registerOperation<EqrelStructure, 2>("insert", insertBenchmark<EqrelStructure>, distribution);
+        registerOperation<EqrelStructure, 2>(
+                "parallel-insert", parallelInsertBenchmark<EqrelStructure>, distribution, true);
+        registerOperation<EqrelStructure, 2>("contains", containsBenchmark<EqrelStructure>, distribution);
+        registerOperation<EqrelStructure, 2>("iterate", iterateBenchmark<EqrelStructure>, distribution);
+        registerOperation<EqrelStructure, 2>(
+                "partition", partitionBenchmark<EqrelStructure>, distribution, true);
+        registerOperation<EqrelStructure, 2>("merge", mergeBenchmark<EqrelStructure>, distribution);
+    }
+}
+
+/** register the benchmarks of interning and resolving symbols */
+void registerSymbolTable() {
+    auto symbols = std::make_shared<std::vector<std::string>>();
+    auto getSymbols = [symbols]() -> const std::vector<std::string>& {
+        if (symbols->empty()) {
+            for (const auto& key : generateKeys<ram::Tuple<RamDomain, 1>, 1>(numKeys, Distribution::ZIPF)) {
+                symbols->push_back("symbol" + std::to_string(key[0]));
+            }
+        }
+        return *symbols;
+    };
+    registerBenchmark("symbol_table/lookup/zipf/1", [getSymbols](State& state) {
+        const auto& keys = getSymbols();
+        while (state.keepRunning()) {
+            SymbolTable table;
+            for (const auto& key : keys) {
+                doNotOptimize(table.lookup(key));
+            }
+        }
+        state.setItems(keys.size());
+    });
+    registerBenchmark("symbol_table/parallel-lookup/zipf/1",
+            [getSymbols](State& state) {
+                const auto& keys = getSymbols();
+                while (state.keepRunning()) {
+                    SymbolTable table;
+                    PARALLEL_START {
+                        pfor(size_t i = 0; i < keys.size(); i++) {
+                            doNotOptimize(table.lookup(keys[i]));
+                        }
+                    }
+                    PARALLEL_END
+                }
+                state.setItems(keys.size());
+            },
+            true);
+    registerBenchmark("symbol_table/resolve/zipf/1", [getSymbols](State& state) {
+        const auto& keys = getSymbols();
+        SymbolTable table;
+        std::vector<RamDomain> indices;
+        for (const auto& key : keys) {
+            indices.push_back(table.lookup(key));
+        }
+        while (state.keepRunning()) {
+            for (RamDomain index : indices) {
+                doNotOptimize(table.resolve(index));
+            }
+        }
+        state.setItems(indices.size());
+    });
+}
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace souffle
+
+int main(int argc, char** argv) {
+    using namespace souffle::bench;
+    registerArity<1>();
+    registerArity<2>();
+    registerArity<3>();
+    registerArity<4>();
+    registerArity<5>();
+    registerArity<6>();
+    registerEqrel();
+    registerSymbolTable();
+    return runBenchmarks(argc, argv);
+}
@@ -30,12 +30,18 @@
 #include "ParserDriver.h"
 #include "RAMI.h"
 #include "RAMIProgInterface.h"
+#include "RamMpiScheduleAnalysis.h"
 #include "RamProgram.h"
 #include "RamTransformer.h"
+#include "RamSerialisation.h"
+#include "RamStratumDependencyAnalysis.h"
 #include "RamTransforms.h"
 #include "RamTranslationUnit.h"
+#include "RamVisitor.h"
+#include "ResourceLimits.h"
 #include "SymbolTable.h"
 #include "Synthesiser.h"
+#include "TraceLog.h"
 #include "Util.h"
 #include "config.h"
 #include "profile/Tui.h"
@@ -45,14 +51,20 @@
 #include "PrecedenceGraph.h"
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <memory>
 #include <set>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <thread>
@@ -99,7 +111,14 @@ void executeBinary(const std::string& binaryFilename
         std::vector<char> ldPathChars(ldPath.begin(), ldPath.end());
         putenv(&ldPathChars[0]);
 
-        exitCode = system(binaryFilename.c_str());
+        std::string command = binaryFilename;
+        if (Global::config().has("time-limit")) {
+            command += " -t " + Global::config().get("time-limit");
+        }
+        if (Global::config().has("memory-limit")) {
+            command += " -m " + Global::config().get("memory-limit");
+        }
+        exitCode = system(command.c_str());
     }
 
     if (Global::config().get("dl-program").empty()) {
@@ -114,11 +133,85 @@ void executeBinary(const std::string& binaryFilename
 }
 
 /**
- * Compiles the given source file to a binary file.
+ * Compiles the strata of a program into object files of the compilation cache,
+ * unless their object files remain from a previous compilation. The files of
+ * the cache are named by the hash of their content and of the configuration of
+ * the compiler, such that a stratum is only recompiled if its code changed.
+ *
+ * @return the object files of the strata
+ */
+std::vector<std::string> compileStrata(
+        const std::string& compileCmd, const std::string& header, const std::vector<std::string>& strata) {
+    const std::string& dir = Global::config().get("compile-cache");
+    if (!existDir(dir) && mkdir(dir.c_str(), 0755) != 0) {
+        throw std::invalid_argument("failed to create compilation cache <" + dir + ">");
+    }
+
+    // writes a file of the cache, such that concurrent compilations never read it partially
+    auto writeFile = [&](const std::string& filename, const std::string& content) {
+        std::string tempName = filename + "." + std::to_string(getpid());
+        std::ofstream(tempName) << content;
+        if (rename(tempName.c_str(), filename.c_str()) != 0) {
+            throw std::invalid_argument("failed to write <" + filename + ">");
+        }
+    };
+
+    const std::string config = std::string(PACKAGE_VERSION) + "\n" + compileCmd + "\n";
+    const std::string headerName = contentHash(config + header) + ".h";
+    if (!existFile(dir + "/" + headerName)) {
+        writeFile(dir + "/" + headerName, header);
+    }
+
+    std::vector<std::string> objects;
+    std::vector<std::string> sources;
+    for (const std::string& code : strata) {
+        const std::string unit = "#include \"" + headerName + "\"\n" + code;
+        const std::string base = dir + "/" + contentHash(unit);
+        objects.push_back(base + ".o");
+        if (!existFile(base + ".o")) {
+            writeFile(base + ".cpp", unit);
+            sources.push_back(base + ".cpp");
+        }
+    }
+    if (Global::config().has("verbose")) {
+        std::cout << "Compiling " << sources.size() << " of " << strata.size() << " strata\n";
+    }
+
+    // compile the sources in parallel
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> workers;
+    size_t numWorkers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), sources.size());
+    for (size_t i = 0; i < numWorkers; i++) {
+        workers.emplace_back([&]() {
+            for (size_t cur = next++; cur < sources.size() && !failed; cur = next++) {
+                if (system((compileCmd + "-c " + sources[cur]).c_str()) != 0) {
+                    failed = true;
+                } else {
+                    remove(sources[cur].c_str());
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (failed) {
+        throw std::invalid_argument("failed to compile C++ sources in <" + dir + ">");
+    }
+    return objects;
+}
+
+/**
+ * Compiles the given source file to a binary file, linking the given object files.
  */
-void compileToBinary(std::string compileCmd, const std::string& sourceFilename) {
+void compileToBinary(std::string compileCmd, const std::string& sourceFilename,
+        const std::vector<std::string>& objects = {}) {
     // add source code
     compileCmd += ' ';
+    if (Global::config().has("pgo")) {
+        compileCmd += "-p " + Global::config().get("pgo") + ' ';
+    }
     for (const std::string& path : splitString(Global::config().get("library-dir"), ' ')) {
         // The first entry may be blank
         if (path.empty()) {
@@ -135,6 +228,9 @@ void compileToBinary(std::string compileCmd, const std::string& sourceFilename)
     }
 
     compileCmd += sourceFilename;
+    for (const std::string& object : objects) {
+        compileCmd += ' ' + object;
+    }
 
     // run executable
     if (system(compileCmd.c_str()) != 0) {
@@ -142,6 +238,325 @@ void compileToBinary(std::string compileCmd, const std::string& sourceFilename)
     }
 }
 
+/** Parses, checks and translates the Datalog program into an optimised RAM program */
+std::unique_ptr<RamTranslationUnit> translateProgram(
+        SymbolTable& symTab, ErrorReport& errReport, DebugReport& debugReport) {
+    /* Create the pipe to establish a communication between cpp and souffle */
+    std::string cmd = ::which("mcpp");
+
+    if (!isExecutable(cmd)) {
+        throw std::runtime_error("failed to locate mcpp pre-processor");
+    }
+
+    cmd += " -e utf8 -W0 " + Global::config().get("include-dir");
+    if (Global::config().has("macro")) {
+        cmd += " " + Global::config().get("macro");
+    }
+    cmd += " " + Global::config().get("");
+    FILE* in = popen(cmd.c_str(), "r");
+
+    /* Time taking for parsing */
+    auto parser_start = std::chrono::high_resolution_clock::now();
+
+    // ------- parse program -------------
+
+    // parse file
+    std::unique_ptr<AstTranslationUnit> astTranslationUnit =
+            ParserDriver::parseTranslationUnit("<stdin>", in, symTab, errReport, debugReport);
+
+    // close input pipe
+    int preprocessor_status = pclose(in);
+    if (preprocessor_status == -1) {
+        perror(nullptr);
+        throw std::runtime_error("failed to close pre-processor pipe");
+    }
+
+    /* Report run-time of the parser if verbose flag is set */
+    if (Global::config().has("verbose")) {
+        auto parser_end = std::chrono::high_resolution_clock::now();
+        std::cout << "Parse Time: " << std::chrono::duration<double>(parser_end - parser_start).count()
+                  << "sec\n";
+    }
+
+    // ------- check for parse errors -------------
+    if (astTranslationUnit->getErrorReport().getNumErrors() != 0) {
+        std::cerr << astTranslationUnit->getErrorReport();
+        std::cerr << std::to_string(astTranslationUnit->getErrorReport().getNumErrors()) +
+                             " errors generated, evaluation aborted"
+                  << std::endl;
+        exit(1);
+    }
+
+    // ------- rewriting / optimizations -------------
+
+    /* set up additional global options based on pragma declaratives */
+    (std::make_unique<AstPragmaChecker>())->apply(*astTranslationUnit);
+
+    /* construct the transformation pipeline */
+
+    // Magic-Set pipeline
+    auto magicPipeline = std::make_unique<ConditionalTransformer>(Global::config().has("magic-transform"),
+            std::make_unique<PipelineTransformer>(std::make_unique<NormaliseConstraintsTransformer>(),
+                    std::make_unique<MagicSetTransformer>(), std::make_unique<ResolveAliasesTransformer>(),
+                    std::make_unique<RemoveRelationCopiesTransformer>(),
+                    std::make_unique<RemoveEmptyRelationsTransformer>(),
+                    std::make_unique<RemoveRedundantRelationsTransformer>()));
+
+    // Equivalence pipeline
+    auto equivalencePipeline =
+            std::make_unique<PipelineTransformer>(std::make_unique<MinimiseProgramTransformer>(),
+                    std::make_unique<RemoveRelationCopiesTransformer>(),
+                    std::make_unique<RemoveEmptyRelationsTransformer>(),
+                    std::make_unique<RemoveRedundantRelationsTransformer>());
+
+    // Provenance pipeline
+    auto provenancePipeline = std::make_unique<PipelineTransformer>(std::make_unique<ConditionalTransformer>(
+            Global::config().has("provenance"), std::make_unique<ProvenanceTransformer>()));
+
+    // Main pipeline
+    auto pipeline = std::make_unique<PipelineTransformer>(std::make_unique<AstComponentChecker>(),
+            std::make_unique<ComponentInstantiationTransformer>(),
+            std::make_unique<UniqueAggregationVariablesTransformer>(), std::make_unique<AstSemanticChecker>(),
+            std::make_unique<RemoveTypecastsTransformer>(),
+            std::make_unique<RemoveBooleanConstraintsTransformer>(),
+            std::make_unique<ResolveAliasesTransformer>(), std::make_unique<MinimiseProgramTransformer>(),
+            std::make_unique<InlineRelationsTransformer>(), std::make_unique<ResolveAliasesTransformer>(),
+            std::make_unique<RemoveRedundantRelationsTransformer>(),
+            std::make_unique<RemoveRelationCopiesTransformer>(),
+            std::make_unique<RemoveEmptyRelationsTransformer>(),
+            std::make_unique<ConditionalTransformer>(
+                    Global::config().has("partition-relations") && !Global::config().has("provenance"),
+                    std::make_unique<PartitionRelationsTransformer>()),
+            std::make_unique<ConditionalTransformer>(
+                    Global::config().has("record-indexes") && !Global::config().has("provenance"),
+                    std::make_unique<RecordIndexesTransformer>()),
+            std::make_unique<ReplaceSingletonVariablesTransformer>(),
+            std::make_unique<FixpointTransformer>(
+                    std::make_unique<PipelineTransformer>(std::make_unique<ReduceExistentialsTransformer>(),
+                            std::make_unique<ConditionalTransformer>(!Global::config().has("provenance"),
+                                    std::make_unique<ProjectDeadColumnsTransformer>()),
+                            std::make_unique<RemoveRedundantRelationsTransformer>())),
+            std::make_unique<RemoveRelationCopiesTransformer>(),
+            std::make_unique<PartitionBodyLiteralsTransformer>(),
+            std::make_unique<MinimiseProgramTransformer>(),
+            std::make_unique<RemoveRelationCopiesTransformer>(),
+            std::make_unique<ReorderLiteralsTransformer>(),
+            std::make_unique<PipelineTransformer>(std::make_unique<ResolveAliasesTransformer>(),
+                    std::make_unique<MaterializeAggregationQueriesTransformer>()),
+            std::make_unique<RemoveRedundantSumsTransformer>(),
+            std::make_unique<RemoveEmptyRelationsTransformer>(),
+            std::make_unique<ReorderLiteralsTransformer>(), std::move(magicPipeline),
+            std::make_unique<ConditionalTransformer>(!Global::config().has("provenance"),
+                    std::make_unique<SemiJoinReductionTransformer>()),
+            std::make_unique<ConditionalTransformer>(!Global::config().has("provenance"),
+                    std::make_unique<MaterializeSharedJoinsTransformer>()),
+            std::make_unique<ConditionalTransformer>(
+                    Global::config().has("count-only") && !Global::config().has("provenance"),
+                    std::make_unique<CountOnlyRelationsTransformer>()),
+            std::make_unique<ConditionalTransformer>(
+                    Global::config().has("profile-use") && !Global::config().has("provenance"),
+                    std::make_unique<SelectRepresentationTransformer>()),
+            std::make_unique<AstExecutionPlanChecker>(), std::move(provenancePipeline));
+
+    // Disable unwanted transformations
+    if (Global::config().has("disable-transformers")) {
+        std::vector<std::string> givenTransformers =
+                splitString(Global::config().get("disable-transformers"), ',');
+        pipeline->disableTransformers(
+                std::set<std::string>(givenTransformers.begin(), givenTransformers.end()));
+    }
+
+    // Set up the debug report if necessary
+    if (!Global::config().get("debug-report").empty()) {
+        auto parser_end = std::chrono::high_resolution_clock::now();
+        std::string runtimeStr =
+                "(" + std::to_string(std::chrono::duration<double>(parser_end - parser_start).count()) + "s)";
+        DebugReporter::generateDebugReport(*astTranslationUnit, "Parsing", "After Parsing " + runtimeStr);
+
+        pipeline->setDebugReport();
+    }
+
+    // Toggle pipeline verbosity
+    pipeline->setVerbosity(Global::config().has("verbose"));
+
+    // Apply all the transformations
+    pipeline->apply(*astTranslationUnit);
+
+    // ------- execution -------------
+
+    /* translate AST to RAM */
+    std::unique_ptr<RamTranslationUnit> ramTranslationUnit =
+            AstTranslator().translateUnit(*astTranslationUnit);
+
+    /* the number of indexes of relations in a memory-aware index selection */
+    size_t indexBudget = std::numeric_limits<size_t>::max();
+    std::map<std::string, size_t> relationBudgets;
+    if (Global::config().has("index-budget")) {
+        for (const std::string& entry : splitString(Global::config().get("index-budget"), ',')) {
+            size_t pos = entry.find('=');
+            if (pos == std::string::npos) {
+                indexBudget = std::stoul(entry);
+            } else {
+                relationBudgets[entry.substr(0, pos)] = std::stoul(entry.substr(pos + 1));
+            }
+        }
+    }
+
+    std::unique_ptr<RamTransformer> ramTransform = std::make_unique<RamTransformerSequence>(
+            std::make_unique<FoldConstantsTransformer>(), std::make_unique<FuseRelationsTransformer>(),
+            std::make_unique<RamLoopTransformer>(
+                    std::make_unique<RamTransformerSequence>(std::make_unique<ExpandFilterTransformer>(),
+                            std::make_unique<HoistConditionsTransformer>(),
+                            std::make_unique<MakeIndexTransformer>())),
+            std::make_unique<RamConditionalTransformer>(
+                    []() -> bool { return Global::config().has("index-budget"); },
+                    std::make_unique<IndexBudgetTransformer>(indexBudget, relationBudgets)),
+            std::make_unique<IfConversionTransformer>(), std::make_unique<ChoiceConversionTransformer>(),
+            std::make_unique<RamConditionalTransformer>(
+                    []() -> bool { return Global::config().has("merge-joins"); },
+                    std::make_unique<MergeJoinTransformer>()),
+            std::make_unique<CollapseFiltersTransformer>(), std::make_unique<TupleIdTransformer>(),
+            std::make_unique<RamLoopTransformer>(std::make_unique<RamTransformerSequence>(
+                    std::make_unique<HoistAggregateTransformer>(), std::make_unique<TupleIdTransformer>())),
+            std::make_unique<RamConditionalTransformer>(
+                    []() -> bool { return std::stoi(Global::config().get("jobs")) > 1; },
+                    std::make_unique<ParallelTransformer>()));
+
+    ramTransform->apply(*ramTranslationUnit);
+    if (ramTranslationUnit->getErrorReport().getNumIssues() != 0) {
+        std::cerr << ramTranslationUnit->getErrorReport();
+    }
+
+    return ramTranslationUnit;
+}
+
+/**
+ * Describes each stratum of the main program by its code, the declarations of the relations it creates
+ * and the symbols its constants may stand for, such that a stratum of an edited program described alike
+ * computes the same relations from the same inputs. Strata numbering records or values of the $ operator,
+ * which depend on the strata evaluated before them, are described by an empty string.
+ */
+std::vector<std::string> describeStrata(RamTranslationUnit& translationUnit) {
+    SymbolTable& symbolTable = translationUnit.getSymbolTable();
+    std::vector<std::string> res;
+    visitDepthFirst(*translationUnit.getProgram()->getMain(), [&](const RamStratum& stratum) {
+        if (stratum.getIndex() < 0 || stratum.getIndex() == std::numeric_limits<int>::max()) {
+            return;
+        }
+        if (res.size() <= (size_t)stratum.getIndex()) {
+            res.resize(stratum.getIndex() + 1);
+        }
+        bool numbering = false;
+        visitDepthFirst(stratum, [&](const RamAutoIncrement&) { numbering = true; });
+        visitDepthFirst(stratum, [&](const RamPackRecord&) { numbering = true; });
+        std::stringstream text;
+        text << stratum;
+        visitDepthFirst(stratum, [&](const RamCreate& create) {
+            const RamRelation& rel = create.getRelation();
+            text << "\n" << rel.getName() << "(";
+            for (size_t i = 0; i < rel.getArity(); i++) {
+                numbering = numbering || rel.getArgTypeQualifier(i)[0] == 'r';
+                text << rel.getArg(i) << ":" << rel.getArgTypeQualifier(i) << ",";
+            }
+            text << ") " << static_cast<int>(rel.getRepresentation());
+        });
+        // symbols are numbered by the order of their appearance in the program
+        visitDepthFirst(stratum, [&](const RamNumber& number) {
+            if (number.getConstant() >= 0 && (size_t)number.getConstant() < symbolTable.size()) {
+                text << "\n" << symbolTable.resolve(number.getConstant());
+            }
+        });
+        res[stratum.getIndex()] = numbering ? "" : text.str();
+    });
+    return res;
+}
+
+/**
+ * Evaluates the program again whenever its source file changes, until interrupted (--watch). The
+ * relations of the previous evaluation are kept in memory, such that a stratum described alike in both
+ * versions of the program, see describeStrata, reuses its relations if all strata it depends on do so.
+ * Edited programs are translated by another souffle process emitting their RAM programs (--emit-ram),
+ * such that their errors are reported without ending the watch. Input files are assumed to be unchanged.
+ *
+ * @param initialUnit the translation unit evaluated by the given LVM
+ * @param lvm the LVM having evaluated the program
+ * @param createLvm creates the LVM of an edited program
+ * @param translateCommand the command translating the program, given the option --emit-ram
+ */
+void watchProgram(RamTranslationUnit& initialUnit, std::unique_ptr<LVM> lvm,
+        const std::function<std::unique_ptr<LVM>(RamTranslationUnit&)>& createLvm,
+        const std::string& translateCommand, ErrorReport& errReport, DebugReport& debugReport) {
+    const std::string& source = Global::config().get("");
+    auto readSource = [&]() {
+        std::stringstream content;
+        content << std::ifstream(source).rdbuf();
+        return content.str();
+    };
+
+    // the translation unit of the last edited program and its symbols
+    std::unique_ptr<SymbolTable> symbolTable;
+    std::unique_ptr<RamTranslationUnit> translationUnit;
+    std::vector<std::string> strata = describeStrata(initialUnit);
+    std::string content = readSource();
+
+    while (true) {
+        std::cout << "Watching " << source << " for changes" << std::endl;
+        std::string current = readSource();
+        while (current == content) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            current = readSource();
+        }
+        content = current;
+
+        // the running OpenMP threads rule out translating the program in a forked copy of this process
+        const std::string ramFile = tempFile();
+        std::cout.flush();
+        std::cerr.flush();
+        auto newSymbols = std::make_unique<SymbolTable>();
+        std::unique_ptr<RamTranslationUnit> newUnit;
+        if (std::system((translateCommand + " --emit-ram " + ramFile).c_str()) == 0) {
+            std::ifstream file(ramFile);
+            try {
+                newUnit = loadRamProgram(file, *newSymbols, errReport, debugReport);
+            } catch (std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        }
+        remove(ramFile.c_str());
+        if (newUnit == nullptr || !newUnit->getProgram()->getMain()) {
+            std::cerr << "Keeping the relations of the previous version of " << source << std::endl;
+            continue;
+        }
+
+        // a stratum is re-evaluated if it changed or one of the strata it depends on is re-evaluated
+        std::vector<std::string> newStrata = describeStrata(*newUnit);
+        const std::set<std::string> previous(strata.begin(), strata.end());
+        const auto& predecessors = newUnit->getAnalysis<RamStratumDependencyAnalysis>()->getPredecessors();
+        std::set<int> reused;
+        for (size_t i = 0; i < newStrata.size(); i++) {
+            bool reuse = !newStrata[i].empty() && previous.count(newStrata[i]) > 0;
+            for (int predecessor : (i < predecessors.size()) ? predecessors[i] : std::vector<int>()) {
+                reuse = reuse && reused.count(predecessor) > 0;
+            }
+            if (reuse) {
+                reused.insert(i);
+            }
+        }
+        std::cout << "Re-evaluating " << newStrata.size() - reused.size() << " of " << newStrata.size()
+                  << " strata" << std::endl;
+
+        std::unique_ptr<LVM> newLvm = createLvm(*newUnit);
+        newLvm->reuseStrata(*lvm, reused);
+        newLvm->executeMain();
+
+        // the previous LVM is released before the translation unit it evaluated
+        lvm = std::move(newLvm);
+        translationUnit = std::move(newUnit);
+        symbolTable = std::move(newSymbols);
+        strata = std::move(newStrata);
+    }
+}
+
 int main(int argc, char** argv) {
     /* Time taking for overall runtime */
     auto souffle_start = std::chrono::high_resolution_clock::now();
@@ -195,6 +610,29 @@ int main(int argc, char** argv) {
                 {"magic-transform", 'm', "RELATIONS", "", false,
                         "Enable magic set transformation changes on the given relations, use '*' "
                         "for all."},
+                {"magic-guard", '\15', "RATIO", "", false,
+                        "Only magic transform relations with bound queries estimated to be RATIO times "
+                        "smaller than the relation, using the profile given by --profile-use."},
+                {"magic-subsumptive", '\16', "", "", false,
+                        "Adorn each relation only once per output in the magic set transformation, "
+                        "answering more specific queries by filtering."},
+                {"inline-auto", 'i', "GROWTH", "", false,
+                        "Inline small non-recursive relations used once or twice, while the number of "
+                        "clauses grows by at most the factor GROWTH; decisions are logged to the debug "
+                        "report."},
+                {"partition-relations", 'H', "", "", false,
+                        "Partition relations whose rules all derive a constant at one column into one "
+                        "relation per constant; decisions are logged to the debug report."},
+                {"record-indexes", '\203', "", "", false,
+                        "Materialise the fields of record columns searched by rules as columns of their "
+                        "relation, such that the fields are indexed; decisions are logged to the debug "
+                        "report."},
+                {"count-only", 'k', "", "", false,
+                        "Store the relations that are only counted, by .printsize or count aggregates, "
+                        "in hash sets instead of b-trees."},
+                {"transitive-closure", 'x', "", "", false,
+                        "Compute binary relations defined as the transitive closure of another relation by "
+                        "a closure operator instead of a fixpoint loop."},
                 {"macro", 'M', "MACROS", "", false, "Set macro definitions for the pre-processor"},
                 {"disable-transformers", 'z', "TRANSFORMERS", "", false,
                         "Disable the given AST transformers."},
@@ -203,18 +641,155 @@ int main(int argc, char** argv) {
                         "binary executable (without executing it)."},
                 {"live-profile", '\4', "", "", false, "Enable live profiling."},
                 {"profile", 'p', "FILE", "", false, "Enable profiling, and write profile data to <FILE>."},
+                {"profile-binary", '\17', "", "", false,
+                        "Write the profile data as a binary event log while running."},
+                {"profile-counters", '\21', "", "", false,
+                        "Record the hardware performance counters of each rule and relation."},
+                {"profile-indexes", '\22', "", "", false,
+                        "Record the probes and range scans of each index of a relation."},
+                {"profile-sampling", '\23', "", "", false,
+                        "Sample the rules and loop levels consuming CPU time instead of timing each "
+                        "rule."},
+                {"profile-stream", '\20', "ADDRESS", "", false,
+                        "Stream the profile data to profilers attaching to <ADDRESS>, given as "
+                        "[HOST:]PORT or unix:PATH."},
+                {"metrics", 'Y', "ADDRESS", "", false,
+                        "Serve the progress of the evaluation to monitoring systems over HTTP at "
+                        "<ADDRESS>, given as [HOST:]PORT or unix:PATH, in the format of Prometheus."},
+                {"trace", 'X', "FILE", "", false,
+                        "Record a timeline of the strata, timed rules, parallel loops and I/O of each "
+                        "thread, written to <FILE> in the Chrome trace event format."},
                 {"profile-use", 'u', "FILE", "", false,
                         "Use profile log-file <FILE> for profile-guided optimization."},
+                {"statistics", 'C', "FILE", "", false,
+                        "Collect the distinct and frequent values of the columns and the distinct prefixes "
+                        "of the indexes of the relations into <FILE> when the program runs, and plan the "
+                        "joins, magic sets and index budgets of later compilations by them."},
                 {"debug-report", 'r', "FILE", "", false, "Write HTML debug report to <FILE>."},
+                {"debug-report-sections", '\202', "LIST", "", false,
+                        "Restrict the debug report to the comma-separated kinds of sections in <LIST>: "
+                        "datalog, types, graphs, ram, index-selection, relation-partitioning, "
+                        "record-indexes, representation-selection, count-only-relations and passes."},
                 {"pragma", 'P', "OPTIONS", "", false, "Set pragma options."},
                 {"provenance", 't', "[ none | explain | explore ]", "", false,
                         "Enable provenance instrumentation and interaction."},
-                {"engine", 'e', "[ file | mpi ]", "", false,
-                        "Specify communication engine for distributed execution."},
-                {"interpreter", '\1', "[ RAMI | LVM ]", "LVM", false, "Switch interpreter implementation."},
+                {"provenance-relations", '\34', "RELATIONS", "", false,
+                        "Record provenance only for the comma-separated <RELATIONS> and those they are "
+                        "derived from."},
+                {"provenance-lazy", 'y', "", "", false,
+                        "Evaluate without provenance columns and search the proofs of explained tuples "
+                        "afterwards."},
+                {"engine", 'e', "[ file | mpi | shm ]", "", false,
+                        "Specify communication engine for distributed or concurrent execution."},
+                {"interpreter", '\1', "[ RAMI | LVM | BATCH ]", "LVM", false,
+                        "Switch interpreter implementation; BATCH runs the RAM interpreter evaluating "
+                        "scans a batch of tuples at a time."},
+                {"disable-lvm-fusion", '\5', "", "", false, "Disable superinstructions in the LVM bytecode."},
+                {"disable-lvm-replanning", '\10', "", "", false,
+                        "Disable the runtime choice of join orders for recursive rules in the LVM."},
+                {"index-budget", '\11', "N[,RELATION=N...]", "", false,
+                        "Limit the number of indexes per relation to N, trading indexes for filtered "
+                        "searches; indexes used in a single stratum are built on demand in the LVM. The "
+                        "index report of the debug report gives the bytes each index stores per tuple as a "
+                        "lower bound, counting the values only."},
+                {"generic-join", '\12', "[ auto | all | off ]", "", false,
+                        "Select the rules evaluated by intersecting the values of their variables "
+                        "with a leapfrog triejoin: those with cyclic bodies (auto), all, or none."},
+                {"stratum-order", 'S', "[ memory ]", "", false,
+                        "Order the strata to keep the size of the relations alive at any time small, "
+                        "estimated from the profile of --profile-use."},
+                {"jit", '\13', "MS", "", false,
+                        "Compile each query of the LVM to native code in the background once its "
+                        "evaluation took MS milliseconds in total."},
+                {"compile-cache", '\14', "DIR", "", false,
+                        "Compile the strata of the program separately, keeping their object files in "
+                        "<DIR> to only recompile changed strata in subsequent compilations."},
+                {"pgo", 'G', "DIR", "", false,
+                        "Optimise the compiled executable by the profile of a run on the facts in "
+                        "<DIR>, keeping the profile for subsequent compilations."},
+                {"lvm-dispatch", '\6', "[ switch | threaded ]", "threaded", false,
+                        "Select the instruction dispatch of the LVM."},
+                {"parallel-load", '\7', "", "", false,
+                        "Parse fact files and facts read from standard input using multiple threads."},
+                {"async-output", '\30', "", "", false,
+                        "Write output relations on a background thread as their strata complete."},
+                {"prefetch-input", '\31', "", "", false,
+                        "Read input relations on background threads from the start of the evaluation."},
+                {"checkpoints", '\32', "", "", false,
+                        "Generate programs saving their state after each stratum into the directory of "
+                        "their -c option, resuming from it with -r."},
+                {"stratum-cache", 'K', "DIR", "", false,
+                        "Generate programs caching the relations computed by each stratum in <DIR>, "
+                        "restoring them in later runs whose inputs of the stratum are unchanged."},
+                {"watch", 'W', "", "", false,
+                        "Keep evaluating the program in the LVM whenever its source file changes, only "
+                        "re-evaluating the strata whose rules changed and those depending on them."},
+                {"incremental", '\33', "", "", false,
+                        "Generate programs whose runIncremental() updates the relations computed by a "
+                        "previous run with the tuples inserted since, only evaluating the affected strata."},
+                {"insert-buffers", '\27', "[ auto | all ]", "", false,
+                        "Buffer the tuples the threads of parallel queries insert into b-trees, merging "
+                        "them at the end of the query: where the profile of --profile-use expects a "
+                        "small output (auto), or always (all)."},
+                {"merge-joins", 'J', "[ auto | all ]", "", false,
+                        "Join two relations by intersecting the sorted columns of their indexes rather "
+                        "than searching one for each tuple of the other: where the sizes in the profile "
+                        "of --profile-use make it cheaper (auto), or always (all)."},
+                {"bulk-joins", 'b', "[ auto | all ]", "", false,
+                        "Join two relations in the non-recursive strata of compiled programs by hash "
+                        "joins of their keys, partitioned for the caches and the threads: where both "
+                        "relations hold a million tuples at run time (auto), or always (all)."},
+                {"batch-probes", '\206', "", "", false,
+                        "Search the index scans nested into scans of compiled programs for batches of "
+                        "outer tuples at once, overlapping the cache misses of their searches."},
+                {"freeze-relations", 'B', "", "", false,
+                        "Convert the b-tree indexes of the relations of completed strata into sorted "
+                        "arrays with a cache-friendly search layer in the LVM, saving memory and "
+                        "speeding up their searches in later strata."},
+                {"cold-relations", '\204', "N[,TUPLES]", "", false,
+                        "Store the frozen relations of --freeze-relations not accessed for N strata, or "
+                        "holding TUPLES tuples, in delta-encoded blocks decoded one at a time on access, "
+                        "saving memory at the cost of slower searches in the LVM."},
+                {"bloom-filters", '\37', "[ auto | all ]", "", false,
+                        "Answer existence checks of relations completed by earlier strata by Bloom "
+                        "filters first: where the profile of --profile-use shows most probes finding "
+                        "nothing (auto), or always (all)."},
+                {"numa", '\26', "[ local | interleave ]", "", false,
+                        "Pin the threads to the nodes of a NUMA machine, placing memory on the node "
+                        "allocating it (local) or interleaved over all nodes (interleave)."},
+                {"mpi-partitions", '\24', "N", "", false,
+                        "Evaluate each recursive stratum on N processes when using mpi as execution "
+                        "engine, hash-partitioning the tuples derived in each iteration."},
+                {"mpi-compress", '\25', "", "", false,
+                        "Delta-encode the relations sent between the processes when using mpi as "
+                        "execution engine."},
+                {"mpi-store", '\177', "DIR", "", false,
+                        "Save the relations sent between the strata into the directory <DIR> shared by "
+                        "all processes when using mpi as execution engine, such that a restarted run "
+                        "skips the strata completed before."},
+                {"symbols-in", '\200', "FILE", "", false,
+                        "Start from the symbols of the dictionary <FILE> written by --symbols-out, "
+                        "mapping it rather than interning its symbols; compiled programs map the "
+                        "dictionary they were compiled with."},
+                {"symbols-out", '\201', "FILE", "", false,
+                        "Write the symbols of the program into the dictionary <FILE> once it has run, "
+                        "such that later programs share them and their indices."},
+                {"save-ram", '\35', "FILE", "", false,
+                        "Save the optimised RAM program to <FILE>, to be evaluated by later runs."},
+                {"emit-ram", '\205', "FILE", "", false,
+                        "Save the optimised RAM program to <FILE> without evaluating it."},
+                {"load-ram", '\36', "FILE", "", false,
+                        "Evaluate the RAM program saved to <FILE> rather than translating a Datalog "
+                        "program."},
                 {"hostfile", '\2', "FILE", "", false,
                         "Specify --hostfile option for call to mpiexec when using mpi as "
-                        "execution engine."},
+                        "execution engine, packing the strata onto the slots of its nodes."},
+                {"time-limit", 'T', "SECONDS", "", false,
+                        "Abort the evaluation after SECONDS seconds, keeping the outputs of the "
+                        "completed strata."},
+                {"memory-limit", 'R', "MB", "", false,
+                        "Evict the indexes built on demand once the resident set exceeds MB megabytes, "
+                        "and abort the evaluation if it does so again."},
                 {"verbose", 'v', "", "", false, "Verbose output."},
                 {"version", '\3', "", "", false, "Version."},
                 {"help", 'h', "", "", false, "Display this help message."}};
@@ -232,13 +807,14 @@ int main(int argc, char** argv) {
         Global::config().set("version", PACKAGE_VERSION);
 
         /* for the help option, if given simply print the help text then exit */
-        if (!Global::config().has("") || Global::config().has("help")) {
+        if ((!Global::config().has("") && !Global::config().has("load-ram")) ||
+                Global::config().has("help")) {
             std::cout << Global::config().help();
             return 0;
         }
 
-        /* check that datalog program exists */
-        if (!existFile(Global::config().get(""))) {
+        /* check that datalog program exists, unless a translated program is loaded instead */
+        if (!Global::config().has("load-ram") && !existFile(Global::config().get(""))) {
             throw std::runtime_error("cannot open file " + std::string(Global::config().get("")));
         }
 
@@ -268,6 +844,13 @@ int main(int argc, char** argv) {
                     "Wrong parameter " + Global::config().get("jobs") + " for option -j/--jobs!");
         }
 
+        /* for the numa option, check the memory placement */
+        if (Global::config().has("numa") && !Global::config().has("numa", "local") &&
+                !Global::config().has("numa", "interleave")) {
+            throw std::runtime_error(
+                    "Wrong parameter " + Global::config().get("numa") + " for option --numa!");
+        }
+
         /* if an output directory is given, check it exists */
         if (Global::config().has("output-dir") && !Global::config().has("output-dir", "-") &&
                 !existDir(Global::config().get("output-dir")) &&
@@ -315,11 +898,132 @@ int main(int argc, char** argv) {
             Global::config().set("macro", allMacros);
         }
 
+        /* check the index budget, a default number of indexes followed by budgets of relations */
+        if (Global::config().has("index-budget")) {
+            for (const std::string& entry : splitString(Global::config().get("index-budget"), ',')) {
+                std::string value = entry.substr(entry.find('=') + 1);
+                if (!isNumber(value.c_str()) || std::stoi(value) < 1) {
+                    throw std::runtime_error("Wrong parameter " + Global::config().get("index-budget") +
+                                             " for option --index-budget!");
+                }
+            }
+        }
+
+        /* check the limits of cold relations, which are frozen ones */
+        if (Global::config().has("cold-relations")) {
+            const auto limits = splitString(Global::config().get("cold-relations"), ',');
+            if (limits.empty() || limits.size() > 2 ||
+                    !std::all_of(limits.begin(), limits.end(), [](const std::string& limit) {
+                        return isNumber(limit.c_str()) && std::stoi(limit) >= 1;
+                    })) {
+                throw std::runtime_error("Wrong parameter " + Global::config().get("cold-relations") +
+                                         " for option --cold-relations!");
+            }
+            Global::config().set("freeze-relations");
+        }
+
+        /* check the selection of rules evaluated by multi-way joins */
+        if (Global::config().has("generic-join")) {
+            const std::string& mode = Global::config().get("generic-join");
+            if (mode != "auto" && mode != "all" && mode != "off") {
+                throw std::runtime_error("Wrong parameter " + mode + " for option --generic-join!");
+            }
+        }
+
+        /* check the selection of the projections buffered per thread */
+        if (Global::config().has("insert-buffers") && !Global::config().has("insert-buffers", "auto") &&
+                !Global::config().has("insert-buffers", "all")) {
+            throw std::runtime_error("Wrong parameter " + Global::config().get("insert-buffers") +
+                                     " for option --insert-buffers!");
+        }
+
+        /* check the selection of the existence checks answered by Bloom filters */
+        if (Global::config().has("bloom-filters") && !Global::config().has("bloom-filters", "auto") &&
+                !Global::config().has("bloom-filters", "all")) {
+            throw std::runtime_error("Wrong parameter " + Global::config().get("bloom-filters") +
+                                     " for option --bloom-filters!");
+        }
+
+        /* check the order of the strata */
+        if (Global::config().has("stratum-order") && Global::config().get("stratum-order") != "memory") {
+            throw std::runtime_error("Wrong parameter " + Global::config().get("stratum-order") +
+                                     " for option --stratum-order!");
+        }
+
+        /* check the selection of merge joins */
+        if (Global::config().has("merge-joins")) {
+            const std::string& mode = Global::config().get("merge-joins");
+            if (mode != "auto" && mode != "all") {
+                throw std::runtime_error("Wrong parameter " + mode + " for option --merge-joins!");
+            }
+        }
+
+        if (Global::config().has("bulk-joins")) {
+            const std::string& mode = Global::config().get("bulk-joins");
+            if (mode != "auto" && mode != "all") {
+                throw std::runtime_error("Wrong parameter " + mode + " for option --bulk-joins!");
+            }
+        }
+
+        /* check the compilation of hot queries, which neither counts tuples nor records provenance */
+        if (Global::config().has("jit")) {
+            if (!isNumber(Global::config().get("jit").c_str())) {
+                throw std::runtime_error(
+                        "Wrong parameter " + Global::config().get("jit") + " for option --jit!");
+            }
+            if (Global::config().has("profile") || Global::config().has("provenance")) {
+                throw std::runtime_error("--jit cannot be combined with profiling or provenance.");
+            }
+        }
+
+        /* check the limits of the evaluation */
+        for (const char* limit : {"time-limit", "memory-limit"}) {
+            if (Global::config().has(limit) && (!isNumber(Global::config().get(limit).c_str()) ||
+                                                       std::stod(Global::config().get(limit)) <= 0)) {
+                throw std::runtime_error("Wrong parameter " + Global::config().get(limit) + " for option --" +
+                                         limit + "!");
+            }
+        }
+
+        /* check the guard of the magic set transformation */
+        if (Global::config().has("magic-guard")) {
+            if (!isNumber(Global::config().get("magic-guard").c_str())) {
+                throw std::runtime_error(
+                        "Wrong parameter " + Global::config().get("magic-guard") +
+                        " for option --magic-guard!");
+            }
+        }
+
+        /* check the growth limit of the automatic inlining */
+        if (Global::config().has("inline-auto")) {
+            if (!isNumber(Global::config().get("inline-auto").c_str()) ||
+                    std::stod(Global::config().get("inline-auto")) < 1) {
+                throw std::runtime_error("Wrong parameter " + Global::config().get("inline-auto") +
+                                         " for option --inline-auto!");
+            }
+        }
+
         /* turn on compilation of executables */
         if (Global::config().has("dl-program")) {
             Global::config().set("compile");
         }
 
+        /* a compilation cache requires the compilation of an executable */
+        if (Global::config().has("compile-cache") && !Global::config().has("compile")) {
+            throw std::runtime_error("--compile-cache requires the compilation of an executable.");
+        }
+
+        /* a profile-guided optimisation requires the compilation of an executable */
+        if (Global::config().has("pgo")) {
+            if (!Global::config().has("compile")) {
+                throw std::runtime_error("--pgo requires the compilation of an executable.");
+            }
+            if (!existDir(Global::config().get("pgo"))) {
+                throw std::runtime_error("sample fact directory " + Global::config().get("pgo") +
+                                         " does not exist");
+            }
+        }
+
         /* disable provenance with engine option */
         if (Global::config().has("provenance")) {
             if (Global::config().has("engine")) {
@@ -327,6 +1031,84 @@ int main(int argc, char** argv) {
             }
         }
 
+        /* provenance may be restricted to some relations only when it is enabled */
+        if (Global::config().has("provenance-relations") && !Global::config().has("provenance")) {
+            throw std::runtime_error("--provenance-relations requires --provenance.");
+        }
+
+        /* lazy provenance records no annotations, so there is nothing to restrict */
+        if (Global::config().has("provenance-lazy")) {
+            if (!Global::config().has("provenance")) {
+                throw std::runtime_error("--provenance-lazy requires --provenance.");
+            }
+            if (Global::config().has("provenance-relations")) {
+                throw std::runtime_error("--provenance-lazy cannot be combined with --provenance-relations.");
+            }
+        }
+
+        /* strata evaluated by other processes write their own outputs */
+        if (Global::config().has("async-output") && Global::config().has("engine")) {
+            throw std::runtime_error("--async-output cannot be enabled with distributed execution.");
+        }
+        if (Global::config().has("prefetch-input") && Global::config().has("engine")) {
+            throw std::runtime_error("--prefetch-input cannot be enabled with distributed execution.");
+        }
+
+        /* the symbols of a distributed evaluation are held by several processes */
+        if (Global::config().has("symbols-in") || Global::config().has("symbols-out")) {
+            if (Global::config().has("engine") || Global::config().has("watch")) {
+                throw std::runtime_error(
+                        "--symbols-in and --symbols-out cannot be combined with --engine or --watch.");
+            }
+            if (Global::config().has("symbols-in") && Global::config().has("load-ram")) {
+                throw std::runtime_error("--symbols-in cannot be combined with --load-ram.");
+            }
+        }
+
+        /* checkpoints are saved by generated programs evaluating the strata in order */
+        if (Global::config().has("checkpoints")) {
+            if (!(Global::config().has("compile") || Global::config().has("dl-program") ||
+                        Global::config().has("generate"))) {
+                throw std::runtime_error("--checkpoints requires a compiled program.");
+            }
+            if (Global::config().has("engine")) {
+                throw std::runtime_error("--checkpoints cannot be enabled with distributed execution.");
+            }
+            if (Global::config().has("prefetch-input")) {
+                throw std::runtime_error("--checkpoints cannot be combined with --prefetch-input.");
+            }
+        }
+
+        /* the stratum cache is kept by generated programs evaluating the strata in order */
+        if (Global::config().has("stratum-cache")) {
+            if (!(Global::config().has("compile") || Global::config().has("dl-program") ||
+                        Global::config().has("generate"))) {
+                throw std::runtime_error("--stratum-cache requires a compiled program.");
+            }
+            if (Global::config().has("engine")) {
+                throw std::runtime_error("--stratum-cache cannot be enabled with distributed execution.");
+            }
+            if (Global::config().has("provenance") || Global::config().has("incremental") ||
+                    Global::config().has("checkpoints")) {
+                throw std::runtime_error("--stratum-cache cannot be combined with provenance, "
+                                         "--incremental or --checkpoints.");
+            }
+        }
+
+        /* incremental updates are evaluated by generated programs keeping their relations between runs */
+        if (Global::config().has("incremental")) {
+            if (!(Global::config().has("compile") || Global::config().has("dl-program") ||
+                        Global::config().has("generate"))) {
+                throw std::runtime_error("--incremental requires a compiled program.");
+            }
+            if (Global::config().has("engine")) {
+                throw std::runtime_error("--incremental cannot be enabled with distributed execution.");
+            }
+            if (Global::config().has("provenance")) {
+                throw std::runtime_error("--incremental cannot be combined with provenance.");
+            }
+        }
+
         /* ensure that souffle has been compiled with support for the execution engine, if specified */
         if (Global::config().has("engine")) {
             if (!(Global::config().has("compile") || Global::config().has("dl-program") ||
@@ -334,9 +1116,14 @@ int main(int argc, char** argv) {
                 throw std::invalid_argument("Error: Use of engine option not yet available for interpreter.");
             }
             const auto& engine = Global::config().get("engine");
-            if (engine != "file" && engine != "mpi") {
+            if (engine != "file" && engine != "mpi" && engine != "shm") {
                 throw std::invalid_argument("Error: Use of engine '" + engine + "' is not supported.");
             }
+            /* the profile of concurrently evaluated strata would interleave their events */
+            if (engine == "shm" && Global::config().has("profile")) {
+                throw std::invalid_argument(
+                        "Error: Use of profile option not yet available for engine 'shm'.");
+            }
 #ifndef USE_MPI
             if (engine == "mpi") {
                 throw std::invalid_argument("Error: Use of engine '" + engine +
@@ -354,170 +1141,142 @@ int main(int argc, char** argv) {
 #endif
         }
 
-        if (Global::config().has("live-profile") && !Global::config().has("profile")) {
-            Global::config().set("profile");
+        /* check the number of processes evaluating each recursive stratum */
+        if (Global::config().has("mpi-partitions")) {
+            const std::string& partitions = Global::config().get("mpi-partitions");
+            if (!isNumber(partitions.c_str()) || std::stoi(partitions) < 1) {
+                throw std::runtime_error("Wrong parameter " + partitions + " for option --mpi-partitions!");
+            }
+            if (Global::config().get("engine") != "mpi") {
+                throw std::invalid_argument(
+                        "Error: Use of mpi-partitions option requires execution engine 'mpi'.");
+            }
         }
-    } catch (std::exception& e) {
-        std::cerr << e.what() << std::endl;
-        exit(1);
-    }
 
-    // ------ start souffle -------------
+        if (Global::config().has("mpi-compress") && Global::config().get("engine") != "mpi") {
+            throw std::invalid_argument("Error: Use of mpi-compress option requires execution engine 'mpi'.");
+        }
 
-    std::string souffleExecutable = which(argv[0]);
+        if (Global::config().has("mpi-store") && Global::config().get("engine") != "mpi") {
+            throw std::invalid_argument("Error: Use of mpi-store option requires execution engine 'mpi'.");
+        }
 
-    if (souffleExecutable.empty()) {
-        throw std::runtime_error("failed to determine souffle executable path");
-    }
+        if (Global::config().has("profile-binary")) {
+            if (!Global::config().has("profile")) {
+                throw std::runtime_error("Error: Option --profile-binary requires --profile.");
+            }
+            if (Global::config().has("live-profile")) {
+                throw std::runtime_error("Error: Live profiling requires the JSON profile format.");
+            }
+        }
 
-    /* Create the pipe to establish a communication between cpp and souffle */
-    std::string cmd = ::which("mcpp");
+        if (Global::config().has("profile-counters") && !Global::config().has("profile")) {
+            throw std::runtime_error("Error: Option --profile-counters requires --profile.");
+        }
 
-    if (!isExecutable(cmd)) {
-        throw std::runtime_error("failed to locate mcpp pre-processor");
-    }
+        if (Global::config().has("profile-indexes") && !Global::config().has("profile")) {
+            throw std::runtime_error("Error: Option --profile-indexes requires --profile.");
+        }
 
-    cmd += " -e utf8 -W0 " + Global::config().get("include-dir");
-    if (Global::config().has("macro")) {
-        cmd += " " + Global::config().get("macro");
-    }
-    cmd += " " + Global::config().get("");
-    FILE* in = popen(cmd.c_str(), "r");
+        if (Global::config().has("profile-sampling") && !Global::config().has("profile")) {
+            throw std::runtime_error("Error: Option --profile-sampling requires --profile.");
+        }
 
-    /* Time taking for parsing */
-    auto parser_start = std::chrono::high_resolution_clock::now();
+        if (Global::config().has("profile-stream") && !Global::config().has("profile")) {
+            Global::config().set("profile");
+        }
 
-    // ------- parse program -------------
+        if (Global::config().has("live-profile") && !Global::config().has("profile")) {
+            Global::config().set("profile");
+        }
 
-    // parse file
-    SymbolTable symTab;
-    ErrorReport errReport(Global::config().has("no-warn"));
-    DebugReport debugReport;
-    std::unique_ptr<AstTranslationUnit> astTranslationUnit =
-            ParserDriver::parseTranslationUnit("<stdin>", in, symTab, errReport, debugReport);
+        // the metrics are gathered from the events of the profile, without writing it
+        if (Global::config().has("metrics") && !Global::config().has("profile")) {
+            Global::config().set("profile");
+        }
 
-    // close input pipe
-    int preprocessor_status = pclose(in);
-    if (preprocessor_status == -1) {
-        perror(nullptr);
-        throw std::runtime_error("failed to close pre-processor pipe");
-    }
+        // the rules are traced by the timers of the profile
+        if (Global::config().has("trace") && !Global::config().has("profile")) {
+            Global::config().set("profile");
+        }
 
-    /* Report run-time of the parser if verbose flag is set */
-    if (Global::config().has("verbose")) {
-        auto parser_end = std::chrono::high_resolution_clock::now();
-        std::cout << "Parse Time: " << std::chrono::duration<double>(parser_end - parser_start).count()
-                  << "sec\n";
-    }
+        /* the statistics are collected from relations held by a single process */
+        if (Global::config().has("statistics") && Global::config().get("engine") == "mpi") {
+            throw std::runtime_error("--statistics cannot be enabled with execution engine 'mpi'.");
+        }
 
-    // ------- check for parse errors -------------
-    if (astTranslationUnit->getErrorReport().getNumErrors() != 0) {
-        std::cerr << astTranslationUnit->getErrorReport();
-        std::cerr << std::to_string(astTranslationUnit->getErrorReport().getNumErrors()) +
-                             " errors generated, evaluation aborted"
-                  << std::endl;
+        /* a program is only emitted once translated from Datalog */
+        if (Global::config().has("emit-ram") && Global::config().has("load-ram")) {
+            throw std::runtime_error("--emit-ram cannot be combined with --load-ram.");
+        }
+
+        /* the relations of a watched program are kept in the memory of the LVM between its evaluations */
+        if (Global::config().has("watch")) {
+            if (Global::config().has("compile") || Global::config().has("dl-program") ||
+                    Global::config().has("generate") || Global::config().get("interpreter") != "LVM") {
+                throw std::runtime_error("--watch requires the LVM interpreter.");
+            }
+            if (Global::config().has("load-ram")) {
+                throw std::runtime_error("--watch requires a Datalog program.");
+            }
+            if (Global::config().has("engine") || Global::config().has("provenance") ||
+                    Global::config().has("profile")) {
+                throw std::runtime_error(
+                        "--watch cannot be combined with an execution engine, provenance or profiling.");
+            }
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
         exit(1);
     }
 
-    // ------- rewriting / optimizations -------------
-
-    /* set up additional global options based on pragma declaratives */
-    (std::make_unique<AstPragmaChecker>())->apply(*astTranslationUnit);
-
-    /* construct the transformation pipeline */
-
-    // Magic-Set pipeline
-    auto magicPipeline = std::make_unique<ConditionalTransformer>(Global::config().has("magic-transform"),
-            std::make_unique<PipelineTransformer>(std::make_unique<NormaliseConstraintsTransformer>(),
-                    std::make_unique<MagicSetTransformer>(), std::make_unique<ResolveAliasesTransformer>(),
-                    std::make_unique<RemoveRelationCopiesTransformer>(),
-                    std::make_unique<RemoveEmptyRelationsTransformer>(),
-                    std::make_unique<RemoveRedundantRelationsTransformer>()));
-
-    // Equivalence pipeline
-    auto equivalencePipeline =
-            std::make_unique<PipelineTransformer>(std::make_unique<MinimiseProgramTransformer>(),
-                    std::make_unique<RemoveRelationCopiesTransformer>(),
-                    std::make_unique<RemoveEmptyRelationsTransformer>(),
-                    std::make_unique<RemoveRedundantRelationsTransformer>());
-
-    // Provenance pipeline
-    auto provenancePipeline = std::make_unique<PipelineTransformer>(std::make_unique<ConditionalTransformer>(
-            Global::config().has("provenance"), std::make_unique<ProvenanceTransformer>()));
-
-    // Main pipeline
-    auto pipeline = std::make_unique<PipelineTransformer>(std::make_unique<AstComponentChecker>(),
-            std::make_unique<ComponentInstantiationTransformer>(),
-            std::make_unique<UniqueAggregationVariablesTransformer>(), std::make_unique<AstSemanticChecker>(),
-            std::make_unique<RemoveTypecastsTransformer>(),
-            std::make_unique<RemoveBooleanConstraintsTransformer>(),
-            std::make_unique<ResolveAliasesTransformer>(), std::make_unique<MinimiseProgramTransformer>(),
-            std::make_unique<InlineRelationsTransformer>(), std::make_unique<ResolveAliasesTransformer>(),
-            std::make_unique<RemoveRedundantRelationsTransformer>(),
-            std::make_unique<RemoveRelationCopiesTransformer>(),
-            std::make_unique<RemoveEmptyRelationsTransformer>(),
-            std::make_unique<ReplaceSingletonVariablesTransformer>(),
-            std::make_unique<FixpointTransformer>(
-                    std::make_unique<PipelineTransformer>(std::make_unique<ReduceExistentialsTransformer>(),
-                            std::make_unique<RemoveRedundantRelationsTransformer>())),
-            std::make_unique<RemoveRelationCopiesTransformer>(),
-            std::make_unique<PartitionBodyLiteralsTransformer>(),
-            std::make_unique<MinimiseProgramTransformer>(),
-            std::make_unique<RemoveRelationCopiesTransformer>(),
-            std::make_unique<ReorderLiteralsTransformer>(),
-            std::make_unique<PipelineTransformer>(std::make_unique<ResolveAliasesTransformer>(),
-                    std::make_unique<MaterializeAggregationQueriesTransformer>()),
-            std::make_unique<RemoveRedundantSumsTransformer>(),
-            std::make_unique<RemoveEmptyRelationsTransformer>(),
-            std::make_unique<ReorderLiteralsTransformer>(), std::move(magicPipeline),
-            std::make_unique<AstExecutionPlanChecker>(), std::move(provenancePipeline));
-
-    // Disable unwanted transformations
-    if (Global::config().has("disable-transformers")) {
-        std::vector<std::string> givenTransformers =
-                splitString(Global::config().get("disable-transformers"), ',');
-        pipeline->disableTransformers(
-                std::set<std::string>(givenTransformers.begin(), givenTransformers.end()));
-    }
+    // ------ start souffle -------------
 
-    // Set up the debug report if necessary
-    if (!Global::config().get("debug-report").empty()) {
-        auto parser_end = std::chrono::high_resolution_clock::now();
-        std::string runtimeStr =
-                "(" + std::to_string(std::chrono::duration<double>(parser_end - parser_start).count()) + "s)";
-        DebugReporter::generateDebugReport(*astTranslationUnit, "Parsing", "After Parsing " + runtimeStr);
+    std::string souffleExecutable = which(argv[0]);
 
-        pipeline->setDebugReport();
+    if (souffleExecutable.empty()) {
+        throw std::runtime_error("failed to determine souffle executable path");
     }
 
-    // Toggle pipeline verbosity
-    pipeline->setVerbosity(Global::config().has("verbose"));
-
-    // Apply all the transformations
-    pipeline->apply(*astTranslationUnit);
-
-    // ------- execution -------------
-
-    /* translate AST to RAM */
-    std::unique_ptr<RamTranslationUnit> ramTranslationUnit =
-            AstTranslator().translateUnit(*astTranslationUnit);
-
-    std::unique_ptr<RamTransformer> ramTransform = std::make_unique<RamTransformerSequence>(
-            std::make_unique<RamLoopTransformer>(
-                    std::make_unique<RamTransformerSequence>(std::make_unique<ExpandFilterTransformer>(),
-                            std::make_unique<HoistConditionsTransformer>(),
-                            std::make_unique<MakeIndexTransformer>())),
-            std::make_unique<IfConversionTransformer>(), std::make_unique<ChoiceConversionTransformer>(),
-            std::make_unique<CollapseFiltersTransformer>(), std::make_unique<TupleIdTransformer>(),
-            std::make_unique<RamLoopTransformer>(std::make_unique<RamTransformerSequence>(
-                    std::make_unique<HoistAggregateTransformer>(), std::make_unique<TupleIdTransformer>())),
-            std::make_unique<RamConditionalTransformer>(
-                    []() -> bool { return std::stoi(Global::config().get("jobs")) > 1; },
-                    std::make_unique<ParallelTransformer>()));
-
-    ramTransform->apply(*ramTranslationUnit);
-    if (ramTranslationUnit->getErrorReport().getNumIssues() != 0) {
-        std::cerr << ramTranslationUnit->getErrorReport();
+    SymbolTable symTab;
+    ErrorReport errReport(Global::config().has("no-warn"));
+    DebugReport debugReport;
+    std::unique_ptr<RamTranslationUnit> ramTranslationUnit;
+    if (Global::config().has("load-ram")) {
+        /* skip the front end, evaluating a previously translated program */
+        std::ifstream file(Global::config().get("load-ram"));
+        try {
+            if (!file) {
+                throw std::runtime_error("cannot open RAM program " + Global::config().get("load-ram"));
+            }
+            ramTranslationUnit = loadRamProgram(file, symTab, errReport, debugReport);
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            exit(1);
+        }
+    } else {
+        // the literals of the program take the indices of the dictionary, or follow its symbols
+        if (Global::config().has("symbols-in")) {
+            try {
+                symTab = SymbolTable::load(Global::config().get("symbols-in"));
+            } catch (std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                exit(1);
+            }
+        }
+        ramTranslationUnit = translateProgram(symTab, errReport, debugReport);
+        if (Global::config().has("emit-ram")) {
+            std::ofstream file(Global::config().get("emit-ram"));
+            saveRamProgram(*ramTranslationUnit, file);
+            return file ? 0 : 1;
+        }
+        if (Global::config().has("save-ram")) {
+            std::ofstream file(Global::config().get("save-ram"));
+            saveRamProgram(*ramTranslationUnit, file);
+            if (!file) {
+                throw std::runtime_error("cannot write RAM program " + Global::config().get("save-ram"));
+            }
+        }
     }
 
     if (!ramTranslationUnit->getProgram()->getMain()) {
@@ -528,6 +1287,17 @@ int main(int argc, char** argv) {
             !Global::config().has("generate")) {
         // ------- interpreter -------------
 
+        if (Global::config().has("time-limit")) {
+            ResourceLimits::instance().setTimeLimit(std::stod(Global::config().get("time-limit")));
+        }
+        if (Global::config().has("memory-limit")) {
+            ResourceLimits::instance().setMemoryLimit(std::stoul(Global::config().get("memory-limit")));
+        }
+
+        if (Global::config().has("trace")) {
+            TraceLog::instance().open(Global::config().get("trace"));
+        }
+
         std::thread profiler;
         // Start up profiler if needed
         if (Global::config().has("live-profile") && !Global::config().has("compile")) {
@@ -536,7 +1306,18 @@ int main(int argc, char** argv) {
 
         // configure and execute interpreter
         if (Global::config().get("interpreter") == "LVM") {
-            std::unique_ptr<LVMInterface> lvm(std::make_unique<LVM>(*ramTranslationUnit));
+            auto createLvm = [&](RamTranslationUnit& translationUnit) {
+                auto lvm = std::make_unique<LVM>(translationUnit);
+                if (Global::config().has("jit")) {
+                    std::string compileCmd = ::findTool("souffle-compile", souffleExecutable, ".");
+                    if (!isExecutable(compileCmd)) {
+                        throw std::runtime_error("failed to locate souffle-compile");
+                    }
+                    lvm->enableJit(compileCmd, std::stod(Global::config().get("jit")));
+                }
+                return lvm;
+            };
+            std::unique_ptr<LVM> lvm = createLvm(*ramTranslationUnit);
             lvm->executeMain();
             // If the profiler was started, join back here once it exits.
             if (profiler.joinable()) {
@@ -551,8 +1332,22 @@ int main(int argc, char** argv) {
                     explain(interface, true);
                 }
             }
+            if (Global::config().has("watch")) {
+                // edited programs are translated by the command of this run
+                std::string translateCommand = souffleExecutable;
+                for (int i = 1; i < argc; i++) {
+                    translateCommand += " '";
+                    for (const char* c = argv[i]; *c != '\0'; c++) {
+                        translateCommand += (*c == '\'') ? std::string("'\\''") : std::string(1, *c);
+                    }
+                    translateCommand += "'";
+                }
+                watchProgram(*ramTranslationUnit, std::move(lvm), createLvm, translateCommand, errReport,
+                        debugReport);
+            }
         } else {
-            std::unique_ptr<RAMIInterface> rami(std::make_unique<RAMI>(*ramTranslationUnit));
+            std::unique_ptr<RAMIInterface> rami(std::make_unique<RAMI>(
+                    *ramTranslationUnit, Global::config().get("interpreter") == "BATCH"));
             rami->executeMain();
             // If the profiler was started, join back here once it exits.
             if (profiler.joinable()) {
@@ -568,6 +1363,9 @@ int main(int argc, char** argv) {
                 }
             }
         }
+        if (Global::config().has("symbols-out")) {
+            symTab.save(Global::config().get("symbols-out"));
+        }
     } else {
         // ------- compiler -------------
 
@@ -602,8 +1400,15 @@ int main(int argc, char** argv) {
             std::string sourceFilename = baseFilename + ".cpp";
 
             bool withSharedLibrary;
+            std::stringstream header;
+            std::vector<std::string> strata;
+            const bool splitStrata = Global::config().has("compile-cache");
             std::ofstream os(sourceFilename);
-            synthesiser->generateCode(os, baseIdentifier, withSharedLibrary);
+            if (splitStrata) {
+                synthesiser->generateCode(os, baseIdentifier, withSharedLibrary, header, strata);
+            } else {
+                synthesiser->generateCode(os, baseIdentifier, withSharedLibrary);
+            }
             os.close();
 
             if (withSharedLibrary) {
@@ -617,7 +1422,11 @@ int main(int argc, char** argv) {
 
             if (Global::config().has("compile")) {
                 auto start = std::chrono::high_resolution_clock::now();
-                compileToBinary(compileCmd, sourceFilename);
+                std::vector<std::string> objects;
+                if (splitStrata) {
+                    objects = compileStrata(compileCmd, header.str(), strata);
+                }
+                compileToBinary(compileCmd, sourceFilename, objects);
                 /* Report overall run-time in verbose mode */
                 if (Global::config().has("verbose")) {
                     auto end = std::chrono::high_resolution_clock::now();
@@ -626,10 +1435,15 @@ int main(int argc, char** argv) {
                 }
                 // run compiled C++ program if requested.
                 if (!Global::config().has("dl-program")) {
+#ifdef USE_MPI
+                    // the scheduled ranks, followed by the additional ranks of partitioned strata
+                    int numberOfProcesses =
+                            ramTranslationUnit->getAnalysis<RamMpiScheduleAnalysis>()->getNumberOfProcesses();
+#endif
                     executeBinary(baseFilename
 #ifdef USE_MPI
                             ,
-                            ((int)astTranslationUnit->getAnalysis<SCCGraph>()->getNumberOfSCCs()) + 1
+                            numberOfProcesses
 #endif
                     );
                 }
@@ -88,8 +88,14 @@
 %token BRIE_QUALIFIER            "BRIE datastructure qualifier"
 %token BTREE_QUALIFIER           "BTREE datastructure qualifier"
 %token EQREL_QUALIFIER           "equivalence relation qualifier"
+%token COMPRESSED_QUALIFIER      "compressed datastructure qualifier"
+%token HASHSET_QUALIFIER         "hashset datastructure qualifier"
+%token MMAP_QUALIFIER            "memory-mapped datastructure qualifier"
+%token BITMAP_QUALIFIER          "bitmap datastructure qualifier"
 %token OVERRIDABLE_QUALIFIER     "relation qualifier overidable"
 %token INLINE_QUALIFIER          "relation qualifier inline"
+%token SUBSUME_QUALIFIER         "relation qualifier subsume"
+%token STORAGE_QUALIFIER         "storage provider qualifier"
 %token TMATCH                    "match predicate"
 %token TCONTAINS                 "checks whether substring is contained in a string"
 %token CAT                       "concatenation of two strings"
@@ -162,6 +168,9 @@
 %type <AstComponent *>                      component
 %type <AstComponent *>                      component_body
 %type <AstComponent *>                      component_head
+%type <std::vector<AstDominance>>           dominance
+%type <AstDominance>                        dominance_column
+%type <std::vector<AstDominance>>           dominance_list
 %type <RuleBody *>                          conjunction
 %type <AstConstraint *>                     constraint
 %type <RuleBody *>                          disjunction
@@ -190,6 +199,7 @@
 %type <std::vector<AstRelation *>>          relation_list
 %type <std::vector<AstClause *>>            rule
 %type <std::vector<AstClause *>>            rule_def
+%type <std::string>                         storage
 %type <std::vector<AstStore *>>             store_head
 %type <RuleBody *>                          term
 %type <AstType *>                           type
@@ -208,6 +218,9 @@
 %destructor { delete $$; }                                  conjunction
 %destructor { delete $$; }                                  constraint
 %destructor { delete $$; }                                  disjunction
+%destructor { }                                             dominance
+%destructor { }                                             dominance_column
+%destructor { }                                             dominance_list
 %destructor { delete $$; }                                  exec_order_list
 %destructor { delete $$; }                                  exec_plan
 %destructor { delete $$; }                                  exec_plan_list
@@ -230,6 +243,7 @@
 %destructor { for (auto* cur : $$) { delete cur; } }        relation_list
 %destructor { for (auto* cur : $$) { delete cur; } }        rule
 %destructor { for (auto* cur : $$) { delete cur; } }        rule_def
+%destructor { }                                             storage
 %destructor { for (auto* cur : $$) { delete cur; } }        store_head
 %destructor { delete $$; }                                  term
 %destructor { delete $$; }                                  type
@@ -427,12 +441,34 @@ relation_decl
 
         $relation_list.clear();
     }
-  | DECL relation_list LPAREN non_empty_attributes RPAREN qualifiers {
+  | DECL relation_list LPAREN non_empty_attributes RPAREN qualifiers storage dominance {
+        if (!$storage.empty() && ($qualifiers & (BRIE_RELATION|BTREE_RELATION|EQREL_RELATION|
+                COMPRESSED_RELATION|HASHSET_RELATION|MMAP_RELATION|BITMAP_RELATION))) {
+            driver.error(@storage, "btree/brie/eqrel qualifier already set");
+        }
+        for (size_t i = 0; i < $dominance.size(); ++i) {
+            const std::string& name = $dominance[i].attribute;
+            if (std::none_of($non_empty_attributes.begin(), $non_empty_attributes.end(),
+                        [&](const AstAttribute* attr) { return attr->getAttributeName() == name; })) {
+                driver.error(@dominance, "subsumption of undefined attribute " + name);
+            }
+            for (size_t j = 0; j < i; ++j) {
+                if ($dominance[j].attribute == name) {
+                    driver.error(@dominance, "subsumption of attribute " + name + " already set");
+                }
+            }
+        }
         for (auto* rel : $relation_list) {
             rel->setQualifier($qualifiers);
+            if (!$storage.empty()) {
+                rel->setStorage($storage);
+            }
             for (auto* attr : $non_empty_attributes) {
                 rel->addAttribute(std::unique_ptr<AstAttribute>(attr->clone()));
             }
+            for (const auto& column : $dominance) {
+                rel->addDominance(column);
+            }
         }
         $$ = $relation_list;
 
@@ -511,25 +547,84 @@ qualifiers
         $$ = $1 | INLINE_RELATION;
     }
   | qualifiers BRIE_QUALIFIER {
-        if($1 & (BRIE_RELATION|BTREE_RELATION|EQREL_RELATION))
+        if($1 & (BRIE_RELATION|BTREE_RELATION|EQREL_RELATION|COMPRESSED_RELATION|HASHSET_RELATION|MMAP_RELATION|BITMAP_RELATION))
             driver.error(@2, "btree/brie/eqrel qualifier already set");
         $$ = $1 | BRIE_RELATION;
     }
   | qualifiers BTREE_QUALIFIER {
-        if($1 & (BRIE_RELATION|BTREE_RELATION|EQREL_RELATION))
+        if($1 & (BRIE_RELATION|BTREE_RELATION|EQREL_RELATION|COMPRESSED_RELATION|HASHSET_RELATION|MMAP_RELATION|BITMAP_RELATION))
             driver.error(@2, "btree/brie/eqrel qualifier already set");
         $$ = $1 | BTREE_RELATION;
     }
   | qualifiers EQREL_QUALIFIER {
-        if($1 & (BRIE_RELATION|BTREE_RELATION|EQREL_RELATION))
+        if($1 & (BRIE_RELATION|BTREE_RELATION|EQREL_RELATION|COMPRESSED_RELATION|HASHSET_RELATION|MMAP_RELATION|BITMAP_RELATION))
             driver.error(@2, "btree/brie/eqrel qualifier already set");
         $$ = $1 | EQREL_RELATION;
     }
+  | qualifiers COMPRESSED_QUALIFIER {
+        if($1 & (BRIE_RELATION|BTREE_RELATION|EQREL_RELATION|COMPRESSED_RELATION|HASHSET_RELATION|MMAP_RELATION|BITMAP_RELATION))
+            driver.error(@2, "btree/brie/eqrel qualifier already set");
+        $$ = $1 | COMPRESSED_RELATION;
+    }
+  | qualifiers HASHSET_QUALIFIER {
+        if($1 & (BRIE_RELATION|BTREE_RELATION|EQREL_RELATION|COMPRESSED_RELATION|HASHSET_RELATION|MMAP_RELATION|BITMAP_RELATION))
+            driver.error(@2, "btree/brie/eqrel qualifier already set");
+        $$ = $1 | HASHSET_RELATION;
+    }
+  | qualifiers MMAP_QUALIFIER {
+        if($1 & (BRIE_RELATION|BTREE_RELATION|EQREL_RELATION|COMPRESSED_RELATION|HASHSET_RELATION|MMAP_RELATION|BITMAP_RELATION))
+            driver.error(@2, "btree/brie/eqrel qualifier already set");
+        $$ = $1 | MMAP_RELATION;
+    }
+  | qualifiers BITMAP_QUALIFIER {
+        if($1 & (BRIE_RELATION|BTREE_RELATION|EQREL_RELATION|COMPRESSED_RELATION|HASHSET_RELATION|MMAP_RELATION|BITMAP_RELATION))
+            driver.error(@2, "btree/brie/eqrel qualifier already set");
+        $$ = $1 | BITMAP_RELATION;
+    }
   | %empty {
         $$ = 0;
     }
   ;
 
+/* Storage provider of a relation */
+storage
+  : STORAGE_QUALIFIER LPAREN IDENT RPAREN {
+        $$ = $IDENT;
+    }
+  | %empty {
+        $$ = std::string();
+    }
+  ;
+
+/* Columns in which the tuples of a subsumptive relation dominate */
+dominance
+  : SUBSUME_QUALIFIER LPAREN dominance_list RPAREN {
+        $$ = $dominance_list;
+    }
+  | %empty {
+        $$ = std::vector<AstDominance>();
+    }
+  ;
+
+dominance_list
+  : dominance_column {
+        $$.push_back($dominance_column);
+    }
+  | dominance_list[curr_list] COMMA dominance_column {
+        $$ = $curr_list;
+        $$.push_back($dominance_column);
+    }
+  ;
+
+dominance_column
+  : MIN IDENT {
+        $$ = AstDominance{$IDENT, true};
+    }
+  | MAX IDENT {
+        $$ = AstDominance{$IDENT, false};
+    }
+  ;
+
 /**
  * Datalog Rule Structure
  */
@@ -1583,6 +1678,9 @@ kvp_value
   | IDENT {
         $$ = $IDENT;
     }
+  | NUMBER {
+        $$ = std::to_string($NUMBER);
+    }
   | TRUE {
         $$ = "true";
     }
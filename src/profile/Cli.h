@@ -32,7 +32,7 @@ public:
         int c;
         option longOptions[1];
         longOptions[0] = {nullptr, 0, nullptr, 0};
-        while ((c = getopt_long(argc, argv, "c:hj::", longOptions, nullptr)) != EOF) {
+        while ((c = getopt_long(argc, argv, "a:c:d:hj::", longOptions, nullptr)) != EOF) {
             // An invalid argument was given
             if (c == '?') {
                 exit(1);
@@ -58,9 +58,23 @@ public:
             exit(1);
         }
 
+        if (args.count('a') != 0 && args.count('h') == 0) {
+            try {
+                ProfileEventSingleton::instance().attach(args['a']);
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                exit(1);
+            }
+            Tui().runProf();
+            return;
+        }
+
         if (args.count('h') != 0 || args.count('f') == 0) {
             std::cout << "Souffle Profiler" << std::endl
-                      << "Usage: souffle-profile <log-file> [ -h | -c <command> [options] | -j ]" << std::endl
+                      << "Usage: souffle-profile <log-file> [ -h | -c <command> [options] | -j ] "
+                         "[ -d <baseline-file> ]"
+                      << std::endl
+                      << "       souffle-profile -a <address>" << std::endl
                       << "<log-file>            The log file to profile." << std::endl
                       << "-c <command>          Run the given command on the log file, try with  "
                          "'-c help' for a list"
@@ -69,6 +83,13 @@ public:
                       << "-j[filename]          Generate a GUI (html/js) version of the profiler."
                       << std::endl
                       << "                      Default filename is profiler_html/[num].html" << std::endl
+                      << "-d <baseline-file>    Compare the log file with the baseline log file, see "
+                         "the diff command"
+                      << std::endl
+                      << "                      and the comparison tab of the GUI." << std::endl
+                      << "-a <address>          Attach to a program streaming its profile to <address>,"
+                      << std::endl
+                      << "                      given as [HOST:]PORT or unix:PATH." << std::endl
                       << "-h                    Print this help message." << std::endl;
             exit(0);
         }
@@ -76,17 +97,29 @@ public:
 
         if (args.count('c') != 0) {
             Tui tui(filename, false, false);
+            setBaseline(tui);
             for (auto& command : Tools::split(args['c'], ";")) {
                 tui.runCommand(Tools::split(command, " "));
             }
         } else if (args.count('j') != 0) {
+            Tui tui(filename, false, true);
+            setBaseline(tui);
             if (args['j'] == "j") {
-                Tui(filename, false, true).outputHtml();
+                tui.outputHtml();
             } else {
-                Tui(filename, false, true).outputHtml(args['j']);
+                tui.outputHtml(args['j']);
             }
         } else {
-            Tui(filename, true, false).runProf();
+            Tui tui(filename, true, false);
+            setBaseline(tui);
+            tui.runProf();
+        }
+    }
+
+    /** Load the baseline profile given by -d, if any */
+    void setBaseline(Tui& tui) {
+        if (args.count('d') != 0) {
+            tui.setBaseline(args['d']);
         }
     }
 };
@@ -29,6 +29,7 @@ private:
     size_t numTuples = 0;
     std::chrono::microseconds copytime{};
     std::string locator = "";
+    HardwareCounts counters;
 
     std::unordered_map<std::string, std::shared_ptr<Rule>> rules;
 
@@ -91,6 +92,14 @@ public:
         endtime = time;
     }
 
+    const HardwareCounts& getCounters() const {
+        return counters;
+    }
+
+    void setCounter(const std::string& counter, size_t value) {
+        counters.set(counter, value);
+    }
+
     const std::string& getLocator() const {
         return locator;
     }
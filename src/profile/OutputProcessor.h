@@ -52,6 +52,25 @@ public:
     Table getVersions(std::string strRel, std::string strRul) const;
 
     Table getVersionAtoms(std::string strRel, std::string strRul, int version) const;
+
+private:
+    /** Fill the cells of a row starting at the given column with hardware counters */
+    static void setCounterCells(Row& row, size_t column, const HardwareCounts& counters) {
+        row[column] = std::make_shared<Cell<long>>(counters.cycles);
+        row[column + 1] = std::make_shared<Cell<long>>(counters.instructions);
+        row[column + 2] = std::make_shared<Cell<long>>(counters.cacheMisses);
+        row[column + 3] = std::make_shared<Cell<long>>(counters.branchMisses);
+    }
+
+    /** Add hardware counters to the cells of a row starting at the given column */
+    static void addCounterCells(Row& row, size_t column, const HardwareCounts& counters) {
+        HardwareCounts sum = counters;
+        sum.cycles += row[column]->getLongVal();
+        sum.instructions += row[column + 1]->getLongVal();
+        sum.cacheMisses += row[column + 2]->getLongVal();
+        sum.branchMisses += row[column + 3]->getLongVal();
+        setCounterCells(row, column, sum);
+    }
 };
 
 /*
@@ -69,6 +88,10 @@ public:
  * ROW[10] = SAVETIME
  * ROW[11] = MAXRSSDIFF
  * ROW[12] = READS
+ * ROW[13] = CYCLES
+ * ROW[14] = INSTRUCTIONS
+ * ROW[15] = CACHE MISSES
+ * ROW[16] = BRANCH MISSES
  *
  */
 Table inline OutputProcessor::getRelTable() const {
@@ -77,7 +100,7 @@ Table inline OutputProcessor::getRelTable() const {
     Table table;
     for (auto& rel : relationMap) {
         std::shared_ptr<Relation> r = rel.second;
-        Row row(13);
+        Row row(17);
         auto total_time = r->getNonRecTime() + r->getRecTime() + r->getCopyTime();
         row[0] = std::make_shared<Cell<std::chrono::microseconds>>(total_time);
         row[1] = std::make_shared<Cell<std::chrono::microseconds>>(r->getNonRecTime());
@@ -96,6 +119,7 @@ Table inline OutputProcessor::getRelTable() const {
         row[10] = std::make_shared<Cell<std::chrono::microseconds>>(r->getSavetime());
         row[11] = std::make_shared<Cell<long>>(r->getMaxRSSDiff());
         row[12] = std::make_shared<Cell<long>>(r->getReads());
+        setCounterCells(row, 13, r->getCounters());
 
         table.addRow(std::make_shared<Row>(row));
     }
@@ -114,6 +138,10 @@ Table inline OutputProcessor::getRelTable() const {
  * ROW[8] = PERFOR
  * ROW[9] = VER
  * ROW[10]= REL_NAME
+ * ROW[11]= CYCLES
+ * ROW[12]= INSTRUCTIONS
+ * ROW[13]= CACHE MISSES
+ * ROW[14]= BRANCH MISSES
  */
 Table inline OutputProcessor::getRulTable() const {
     const std::unordered_map<std::string, std::shared_ptr<Relation>>& relationMap =
@@ -122,7 +150,7 @@ Table inline OutputProcessor::getRulTable() const {
 
     for (auto& rel : relationMap) {
         for (auto& current : rel.second->getRuleMap()) {
-            Row row(11);
+            Row row(15);
             std::shared_ptr<Rule> rule = current.second;
             row[0] = std::make_shared<Cell<std::chrono::microseconds>>(rule->getRuntime());
             row[1] = std::make_shared<Cell<std::chrono::microseconds>>(rule->getRuntime());
@@ -134,6 +162,7 @@ Table inline OutputProcessor::getRulTable() const {
             row[7] = std::make_shared<Cell<std::string>>(rel.second->getName());
             row[8] = std::make_shared<Cell<long>>(0);
             row[10] = std::make_shared<Cell<std::string>>(rule->getLocator());
+            setCounterCells(row, 11, rule->getCounters());
             ruleMap.emplace(rule->getName(), std::make_shared<Row>(row));
         }
         for (auto& iter : rel.second->getIterations()) {
@@ -146,9 +175,10 @@ Table inline OutputProcessor::getRulTable() const {
                     row[4] = std::make_shared<Cell<long>>(row[4]->getLongVal() + rule->size());
                     row[0] = std::make_shared<Cell<std::chrono::microseconds>>(
                             row[0]->getTimeVal() + rule->getRuntime());
+                    addCounterCells(row, 11, rule->getCounters());
                     ruleMap[rule->getName()] = std::make_shared<Row>(row);
                 } else {
-                    Row row(11);
+                    Row row(15);
                     row[0] = std::make_shared<Cell<std::chrono::microseconds>>(rule->getRuntime());
                     row[1] = std::make_shared<Cell<std::chrono::microseconds>>(std::chrono::microseconds(0));
                     row[2] = std::make_shared<Cell<std::chrono::microseconds>>(rule->getRuntime());
@@ -159,6 +189,7 @@ Table inline OutputProcessor::getRulTable() const {
                     row[7] = std::make_shared<Cell<std::string>>(rel.second->getName());
                     row[8] = std::make_shared<Cell<long>>(rule->getVersion());
                     row[10] = std::make_shared<Cell<std::string>>(rule->getLocator());
+                    setCounterCells(row, 11, rule->getCounters());
                     ruleMap[rule->getName()] = std::make_shared<Row>(row);
                 }
             }
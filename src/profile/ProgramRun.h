@@ -60,7 +60,18 @@ public:
         return relationMap;
     }
 
-    std::string getRuntime() const {
+    /** whether hardware counters were recorded */
+    bool hasCounters() const {
+        for (auto& r : relationMap) {
+            HardwareCounts counters = r.second->getCounters();
+            if (counters.cycles + counters.instructions + counters.cacheMisses + counters.branchMisses > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+        std::string getRuntime() const {
         if (startTime == endTime) {
             return "--";
         }
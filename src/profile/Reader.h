@@ -54,12 +54,33 @@ public:
             base.setNumTuples(size.getSize());
         }
     }
-    void visit(DirectoryEntry& ruleEntry) override {}
+    void visit(DirectoryEntry& directory) override {
+        if (directory.getKey() == "counters") {
+            for (const auto& key : directory.getKeys()) {
+                auto* value = dynamic_cast<SizeEntry*>(directory.readEntry(key));
+                if (value != nullptr) {
+                    base.setCounter(key, value->getSize());
+                }
+            }
+        }
+    }
 
 protected:
     T& base;
 };
 
+/**
+ * Read the resident memory of a rule before and after its evaluation.
+ * maxRSS: {pre: num, post: num}
+ */
+inline void visitMaxRSS(Rule& rule, DirectoryEntry& directory) {
+    auto* preMaxRSS = dynamic_cast<SizeEntry*>(directory.readEntry("pre"));
+    auto* postMaxRSS = dynamic_cast<SizeEntry*>(directory.readEntry("post"));
+    if (preMaxRSS != nullptr && postMaxRSS != nullptr) {
+        rule.setMaxRSS(preMaxRSS->getSize(), postMaxRSS->getSize());
+    }
+}
+
 /**
  * Visit ProfileDB atom frequencies.
  * atomrule : {atom: {num-tuples: num}}
@@ -98,6 +119,10 @@ public:
             for (auto& key : directory.getKeys()) {
                 directory.readDirectoryEntry(key)->accept(atomFrequenciesVisitor);
             }
+        } else if (directory.getKey() == "maxRSS") {
+            visitMaxRSS(base, directory);
+        } else {
+            DSNVisitor::visit(directory);
         }
     }
 };
@@ -143,6 +168,10 @@ public:
             for (auto& key : directory.getKeys()) {
                 directory.readDirectoryEntry(key)->accept(atomFrequenciesVisitor);
             }
+        } else if (directory.getKey() == "maxRSS") {
+            visitMaxRSS(base, directory);
+        } else {
+            DSNVisitor::visit(directory);
         }
     }
 };
@@ -194,6 +223,7 @@ public:
             relation.setPreMaxRSS(preMaxRSS->getSize());
             relation.setPostMaxRSS(postMaxRSS->getSize());
         }
+        DSNVisitor::visit(directory);
     }
 
 protected:
@@ -253,6 +283,29 @@ public:
             auto* postMaxRSS = dynamic_cast<SizeEntry*>(directory.readEntry("post"));
             base.setPreMaxRSS(preMaxRSS->getSize());
             base.setPostMaxRSS(postMaxRSS->getSize());
+        } else if (directory.getKey() == "column") {
+            for (const auto& key : directory.getKeys()) {
+                auto* distinct =
+                        dynamic_cast<SizeEntry*>(directory.readDirectoryEntry(key)->readEntry("distinct"));
+                if (distinct != nullptr) {
+                    base.setDistinctValues(std::stoul(key), distinct->getSize());
+                }
+            }
+        } else if (directory.getKey() == "index") {
+            for (const auto& index : directory.getKeys()) {
+                auto* statistics = directory.readDirectoryEntry(index);
+                if (statistics == nullptr) {
+                    continue;
+                }
+                for (const auto& key : statistics->getKeys()) {
+                    auto* value = dynamic_cast<SizeEntry*>(statistics->readEntry(key));
+                    if (value != nullptr) {
+                        base.setIndexStatistic(index, key, value->getSize());
+                    }
+                }
+            }
+        } else {
+            DSNVisitor::visit(directory);
         }
     }
     void visit(SizeEntry& size) override {
@@ -343,6 +396,7 @@ public:
                 }
             }
         }
+        addMemory();
         run->setRelationMap(this->relationMap);
         loaded = true;
     }
@@ -378,6 +432,33 @@ public:
     }
 
 protected:
+    /** Add the peak memory of the indexes of relations, including their delta and new relations */
+    void addMemory() {
+        auto memory =
+                dynamic_cast<DirectoryEntry*>(db.lookupEntry({"program", "memory", "peak", "relation"}));
+        if (memory == nullptr) {
+            return;
+        }
+        for (const auto& cur : memory->getKeys()) {
+            std::string name = cleanRelationName(cur);
+            for (const std::string prefix : {"@delta_", "@new_"}) {
+                if (name.compare(0, prefix.size(), prefix) == 0) {
+                    name = name.substr(prefix.size());
+                }
+            }
+            auto pos = relationMap.find(name);
+            auto* indexes = memory->readDirectoryEntry(cur);
+            if (pos == relationMap.end() || indexes == nullptr) {
+                continue;
+            }
+            for (const auto& index : indexes->getKeys()) {
+                if (auto* size = dynamic_cast<SizeEntry*>(indexes->readEntry(index))) {
+                    pos->second->addMemory(index, size->getSize());
+                }
+            }
+        }
+    }
+
     std::string cleanRelationName(const std::string& relationName) {
         std::string cleanName = relationName;
         for (auto& cur : cleanName) {
@@ -11,6 +11,7 @@
 #include "Iteration.h"
 #include "Rule.h"
 #include <chrono>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -39,9 +40,19 @@ private:
     int ruleId = 0;
     int recursiveId = 0;
     size_t tuplesRead = 0;
+    HardwareCounts nonRecCounters;
 
     std::vector<std::shared_ptr<Iteration>> iterations;
 
+    /** number of distinct values per column */
+    std::map<size_t, size_t> distinctValues;
+
+    /** accesses of each index by statistic: probes, empty-probes, scans and tuples */
+    std::map<std::string, std::map<std::string, size_t>> indexStatistics;
+
+    /** peak memory of each index in bytes */
+    std::map<std::string, size_t> memory;
+
     std::unordered_map<std::string, std::shared_ptr<Rule>> ruleMap;
 
     bool ready = true;
@@ -111,6 +122,18 @@ public:
         return nonRecTuples + result;
     }
 
+    HardwareCounts getCounters() const {
+        HardwareCounts result = nonRecCounters;
+        for (auto& iter : iterations) {
+            result += iter->getCounters();
+        }
+        return result;
+    }
+
+    void setCounter(const std::string& counter, size_t value) {
+        nonRecCounters.set(counter, value);
+    }
+
     size_t getMaxRSSDiff() const {
         return postMaxRSS - preMaxRSS;
     }
@@ -246,6 +269,35 @@ public:
     void addReads(size_t tuplesRead) {
         this->tuplesRead += tuplesRead;
     }
+
+    bool hasDistinctValues(size_t column) const {
+        return distinctValues.find(column) != distinctValues.end();
+    }
+
+    size_t getDistinctValues(size_t column) const {
+        auto pos = distinctValues.find(column);
+        return (pos != distinctValues.end()) ? pos->second : 0;
+    }
+
+    void setDistinctValues(size_t column, size_t number) {
+        distinctValues[column] = number;
+    }
+
+    const std::map<std::string, std::map<std::string, size_t>>& getIndexStatistics() const {
+        return indexStatistics;
+    }
+
+    void setIndexStatistic(const std::string& index, const std::string& statistic, size_t value) {
+        indexStatistics[index][statistic] = value;
+    }
+
+    const std::map<std::string, size_t>& getMemory() const {
+        return memory;
+    }
+
+    void addMemory(const std::string& index, size_t bytes) {
+        memory[index] += bytes;
+    }
 };
 
 }  // namespace profile
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <set>
 #include <sstream>
@@ -41,6 +42,38 @@ public:
     }
 };
 
+/*
+ * Class to hold the hardware counters of a rule, an iteration or a relation
+ */
+class HardwareCounts {
+public:
+    size_t cycles{0};
+    size_t instructions{0};
+    size_t cacheMisses{0};
+    size_t branchMisses{0};
+
+    /** set a counter by its name in the profile database */
+    void set(const std::string& counter, size_t value) {
+        if (counter == "cycles") {
+            cycles = value;
+        } else if (counter == "instructions") {
+            instructions = value;
+        } else if (counter == "cache-misses") {
+            cacheMisses = value;
+        } else if (counter == "branch-misses") {
+            branchMisses = value;
+        }
+    }
+
+    HardwareCounts& operator+=(const HardwareCounts& other) {
+        cycles += other.cycles;
+        instructions += other.instructions;
+        cacheMisses += other.cacheMisses;
+        branchMisses += other.branchMisses;
+        return *this;
+    }
+};
+
 /*
  * Class to hold information about souffle Rule profile information
  */
@@ -53,6 +86,9 @@ protected:
     std::string identifier;
     std::string locator{};
     std::set<Atom> atoms;
+    HardwareCounts counters;
+    size_t preMaxRSS = 0;
+    size_t postMaxRSS = 0;
 
 private:
     bool recursive = false;
@@ -96,6 +132,23 @@ public:
         this->numTuples = numTuples;
     }
 
+    const HardwareCounts& getCounters() const {
+        return counters;
+    }
+
+    void setCounter(const std::string& counter, size_t value) {
+        counters.set(counter, value);
+    }
+
+    size_t getMaxRSSDiff() const {
+        return postMaxRSS - preMaxRSS;
+    }
+
+    void setMaxRSS(size_t pre, size_t post) {
+        preMaxRSS = pre;
+        postMaxRSS = std::max(pre, post);
+    }
+
     void addAtomFrequency(const std::string& subruleName, std::string atom, size_t level, size_t frequency) {
         atoms.emplace(atom, subruleName, level, frequency);
     }
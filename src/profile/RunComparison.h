@@ -0,0 +1,157 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+#pragma once
+
+#include "ProgramRun.h"
+#include "Relation.h"
+#include "Rule.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace souffle {
+namespace profile {
+
+/*
+ * Compares the relations and rules of a baseline run of a program with a current run
+ *
+ * Relations are aligned by their name, rules by their relation, their clause and their
+ * version, where the iterations of a recursive rule are summed up. Entries only present
+ * in one of the runs are kept with zero measures for the other run.
+ */
+class RunComparison {
+public:
+    /** the measures of a relation or a rule in both runs */
+    struct Entry {
+        std::string relation;
+        /** the clause of a rule, empty for relations */
+        std::string rule;
+        /** the version of a recursive rule, -1 for non-recursive rules and relations */
+        int version = -1;
+        std::string locator;
+        bool inBaseline = false;
+        bool inCurrent = false;
+        std::chrono::microseconds baseTime{0};
+        std::chrono::microseconds curTime{0};
+        long baseTuples = 0;
+        long curTuples = 0;
+        /** the growth of the resident memory in kilobytes */
+        long baseRSS = 0;
+        long curRSS = 0;
+
+        std::chrono::microseconds getTimeDelta() const {
+            return curTime - baseTime;
+        }
+
+        long getTuplesDelta() const {
+            return curTuples - baseTuples;
+        }
+
+        long getRSSDelta() const {
+            return curRSS - baseRSS;
+        }
+
+        /** the change of the time in percent of the baseline, 0 without a baseline time */
+        double getTimeChange() const {
+            if (baseTime.count() == 0) {
+                return 0;
+            }
+            return 100.0 * getTimeDelta().count() / baseTime.count();
+        }
+    };
+
+    RunComparison(const ProgramRun& baseline, const ProgramRun& current) {
+        std::map<std::string, Entry> relations;
+        std::map<std::tuple<std::string, std::string, int>, Entry> rules;
+        addRun(baseline, true, relations, rules);
+        addRun(current, false, relations, rules);
+        for (auto& cur : relations) {
+            relationEntries.push_back(cur.second);
+        }
+        for (auto& cur : rules) {
+            ruleEntries.push_back(cur.second);
+        }
+        sortByTimeDelta(relationEntries);
+        sortByTimeDelta(ruleEntries);
+    }
+
+    /** the relations, by decreasing absolute time delta */
+    const std::vector<Entry>& getRelations() const {
+        return relationEntries;
+    }
+
+    /** the rules, by decreasing absolute time delta */
+    const std::vector<Entry>& getRules() const {
+        return ruleEntries;
+    }
+
+private:
+    std::vector<Entry> relationEntries;
+    std::vector<Entry> ruleEntries;
+
+    static void addRun(const ProgramRun& run, bool isBaseline, std::map<std::string, Entry>& relations,
+            std::map<std::tuple<std::string, std::string, int>, Entry>& rules) {
+        for (auto& cur : run.getRelationMap()) {
+            const Relation& relation = *cur.second;
+            Entry& entry = relations[relation.getName()];
+            entry.relation = relation.getName();
+            entry.locator = relation.getLocator();
+            record(entry, isBaseline, relation.getNonRecTime() + relation.getRecTime() + relation.getCopyTime(),
+                    relation.size(), relation.getMaxRSSDiff());
+
+            for (auto& rule : relation.getRuleMap()) {
+                addRule(relation, *rule.second, -1, isBaseline, rules);
+            }
+            for (auto& iteration : relation.getIterations()) {
+                for (auto& rule : iteration->getRules()) {
+                    addRule(relation, *rule.second, rule.second->getVersion(), isBaseline, rules);
+                }
+            }
+        }
+    }
+
+    static void addRule(const Relation& relation, Rule& rule, int version, bool isBaseline,
+            std::map<std::tuple<std::string, std::string, int>, Entry>& rules) {
+        Entry& entry = rules[std::make_tuple(relation.getName(), rule.getName(), version)];
+        entry.relation = relation.getName();
+        entry.rule = rule.getName();
+        entry.version = version;
+        entry.locator = rule.getLocator();
+        record(entry, isBaseline, rule.getRuntime(), rule.size(), rule.getMaxRSSDiff());
+    }
+
+    /** add the measures of a run, accumulating those of the iterations of recursive rules */
+    static void record(Entry& entry, bool isBaseline, std::chrono::microseconds time, long tuples, long rss) {
+        if (isBaseline) {
+            entry.inBaseline = true;
+            entry.baseTime += time;
+            entry.baseTuples += tuples;
+            entry.baseRSS += rss;
+        } else {
+            entry.inCurrent = true;
+            entry.curTime += time;
+            entry.curTuples += tuples;
+            entry.curRSS += rss;
+        }
+    }
+
+    static void sortByTimeDelta(std::vector<Entry>& entries) {
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return std::abs(a.getTimeDelta().count()) > std::abs(b.getTimeDelta().count());
+        });
+    }
+};
+
+}  // namespace profile
+}  // namespace souffle
@@ -12,13 +12,18 @@
 #include "HtmlGenerator.h"
 #include "OutputProcessor.h"
 #include "Reader.h"
+#include "RunComparison.h"
 #include "Table.h"
 #include "UserInputReader.h"
 #include <algorithm>
 #include <chrono>
+#include <cerrno>
 #include <cstdio>
+#include <functional>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
@@ -48,9 +53,17 @@ private:
     Table relationTable;
     Table ruleTable;
     std::shared_ptr<Reader> reader;
+    /// The baseline run the profile is compared with, if any
+    std::shared_ptr<ProgramRun> baseline;
     InputReader linereader;
     /// Limit results shown. Default value chosen to approximate unlimited
     size_t resultLimit = 20000;
+    /// The iteration series of reports of more iterations are split into chunk files loaded on demand
+    size_t chunkIterations = 10000;
+    size_t chunkBytes = 1 << 20;
+    /// The directory of the chunk files of the report, relative to it; empty if the series are inline
+    std::string chunkDir;
+    std::vector<std::string> seriesChunks;
 
     struct Usage {
         std::chrono::microseconds time;
@@ -165,8 +178,38 @@ public:
             } else {
                 std::cout << "Invalid parameters to graph command.\n";
             }
+        } else if (c[0].compare("index") == 0) {
+            if (c.size() == 2) {
+                indexes(c[1]);
+            } else if (c.size() == 1) {
+                indexes("");
+            } else {
+                std::cout << "Invalid parameters to index command.\n";
+            }
         } else if (c[0].compare("memory") == 0) {
-            memoryUsage();
+            if (c.size() == 2 && c[1].compare("relations") == 0) {
+                memoryRelations();
+            } else if (c.size() == 1) {
+                memoryUsage();
+            } else {
+                std::cout << "Invalid parameters to memory command.\n";
+            }
+        } else if (c[0].compare("strata") == 0) {
+            strata();
+        } else if (c[0].compare("samples") == 0) {
+            samples();
+        } else if (c[0].compare("diff") == 0) {
+            if (c.size() == 1) {
+                diffRelations();
+                std::cout << '\n';
+                diffRules();
+            } else if (c.size() == 2 && c[1].compare("rel") == 0) {
+                diffRelations();
+            } else if (c.size() == 2 && c[1].compare("rul") == 0) {
+                diffRules();
+            } else {
+                std::cout << "Invalid parameters to diff command.\n";
+            }
         } else if (c[0].compare("usage") == 0) {
             if (c.size() > 1) {
                 if (c[1][0] == 'R') {
@@ -249,7 +292,27 @@ public:
         return ss;
     }
 
-    std::stringstream& genJsonRelations(std::stringstream& ss, const std::string& name, size_t maxRows) {
+    /**
+     * Append the iteration series of a relation or rule, or append it to the current chunk file
+     * and a reference to the chunk in its place
+     */
+    void genJsonSeries(
+            std::stringstream& ss, const std::string& id, const std::string& series, bool chunked) {
+        if (!chunked || chunkDir.empty()) {
+            ss << series;
+            return;
+        }
+        if (seriesChunks.empty() || seriesChunks.back().size() > chunkBytes) {
+            seriesChunks.emplace_back();
+        } else {
+            seriesChunks.back() += ",\n";
+        }
+        seriesChunks.back() += '"' + id + "\": " + series;
+        ss << R"_({"chunk": )_" << seriesChunks.size() - 1 << "}";
+    }
+
+    std::stringstream& genJsonRelations(
+            std::stringstream& ss, const std::string& name, size_t maxRows, bool chunked = false) {
         const std::shared_ptr<ProgramRun>& run = out.getProgramRun();
 
         auto comma = [&ss](bool& first, const std::string& delimiter = ", ") {
@@ -294,32 +357,30 @@ public:
             ss << "], ";
             std::vector<std::shared_ptr<Iteration>> iter =
                     run->getRelation(row[5]->toString(0))->getIterations();
-            ss << R"_({"tot_t": [)_";
-            firstCol = true;
-            for (auto& i : iter) {
-                comma(firstCol);
-                ss << i->getRuntime().count();
-            }
-            ss << R"_(], "copy_t": [)_";
-            firstCol = true;
-            for (auto& i : iter) {
-                comma(firstCol);
-                ss << i->getCopytime().count();
-            }
-            ss << R"_(], "tuples": [)_";
-            firstCol = true;
-            for (auto& i : iter) {
-                comma(firstCol);
-                ss << i->size();
-            }
-            ss << "]}]";
+            using IterationPtr = std::shared_ptr<Iteration>;
+            std::stringstream series;
+            series << R"_({"tot_t": [)_" << join(iter, ", ", [](std::ostream& os, const IterationPtr& i) {
+                os << i->getRuntime().count();
+            });
+            series << R"_(], "copy_t": [)_" << join(iter, ", ", [](std::ostream& os, const IterationPtr& i) {
+                os << i->getCopytime().count();
+            });
+            series << R"_(], "tuples": [)_" << join(iter, ", ", [](std::ostream& os, const IterationPtr& i) {
+                os << i->size();
+            });
+            series << "]}";
+            genJsonSeries(ss, row[6]->toString(0), series.str(), chunked);
+            ss << ", ";
+            genJsonCounters(ss, row, 13);
+            ss << "]";
         }
         ss << "}";
 
         return ss;
     }
 
-    std::stringstream& genJsonRules(std::stringstream& ss, const std::string& name, size_t maxRows) {
+    std::stringstream& genJsonRules(
+            std::stringstream& ss, const std::string& name, size_t maxRows, bool chunked = false) {
         const std::shared_ptr<ProgramRun>& run = out.getProgramRun();
 
         auto comma = [&ss](bool& first, const std::string& delimiter = ", ") {
@@ -391,12 +452,13 @@ public:
             ss << "], ";
 
             if (row[6]->toString(0).at(0) != 'C') {
-                ss << "{}, {}]";
+                ss << "{}, {}, ";
             } else {
-                ss << R"_({"tot_t": [)_";
+                std::stringstream series;
+                series << R"_({"tot_t": [)_";
 
+                std::vector<long> iteration_times;
                 std::vector<uint64_t> iteration_tuples;
-                bool firstCol = true;
                 for (auto& i : run->getRelation(row[7]->toString(0))->getIterations()) {
                     bool add = false;
                     std::chrono::microseconds totalTime{};
@@ -410,19 +472,15 @@ public:
                         }
                     }
                     if (add) {
-                        comma(firstCol);
-                        ss << totalTime.count();
+                        iteration_times.push_back(totalTime.count());
                         iteration_tuples.push_back(totalSize);
                     }
                 }
-                ss << R"_(], "tuples": [)_";
-                firstCol = true;
-                for (auto& i : iteration_tuples) {
-                    comma(firstCol);
-                    ss << i;
-                }
+                series << join(iteration_times, ", ") << R"_(], "tuples": [)_" << join(iteration_tuples, ", ")
+                       << "]}";
+                genJsonSeries(ss, row[6]->toString(0), series.str(), chunked);
 
-                ss << "]}, {";
+                ss << ", {";
 
                 if (has_ver) {
                     ss << R"_("tot_t": [)_";
@@ -441,13 +499,26 @@ public:
                     }
                     ss << ']';
                 }
-                ss << "}]";
+                ss << "}, ";
             }
+            genJsonCounters(ss, row, 11);
+            ss << "]";
         }
         ss << "\n}";
         return ss;
     }
 
+    /**
+     * Append the hardware counters of a table row starting at the given column,
+     * with the instructions per cycle after the instructions
+     */
+    static void genJsonCounters(std::stringstream& ss, Row& row, size_t column) {
+        long cycles = row[column]->getLongVal();
+        long instructions = row[column + 1]->getLongVal();
+        ss << cycles << ", " << instructions << ", " << (cycles > 0 ? double(instructions) / cycles : 0.0)
+           << ", " << row[column + 2]->getLongVal() << ", " << row[column + 3]->getLongVal();
+    }
+
     std::stringstream& genJsonUsage(std::stringstream& ss) {
         const std::shared_ptr<ProgramRun>& run = out.getProgramRun();
 
@@ -591,24 +662,66 @@ public:
         return ss;
     }
 
+    static void genJsonDiffEntries(std::stringstream& ss, const std::vector<RunComparison::Entry>& entries) {
+        bool firstRow = true;
+        for (auto& entry : entries) {
+            if (!firstRow) {
+                ss << ", \n";
+            }
+            firstRow = false;
+            ss << '[';
+            ss << '"' << Tools::cleanJsonOut(entry.relation) << R"_(", )_";
+            ss << '"' << Tools::cleanJsonOut(entry.rule) << R"_(", )_";
+            ss << entry.version << ", ";
+            ss << '"' << Tools::cleanJsonOut(entry.locator) << R"_(", )_";
+            ss << (entry.inBaseline ? "true" : "false") << ", ";
+            ss << (entry.inCurrent ? "true" : "false") << ", ";
+            ss << entry.baseTime.count() / 1000000.0 << ", ";
+            ss << entry.curTime.count() / 1000000.0 << ", ";
+            ss << entry.baseTuples << ", ";
+            ss << entry.curTuples << ", ";
+            ss << entry.baseRSS * 1024 << ", ";
+            ss << entry.curRSS * 1024 << ']';
+        }
+    }
+
+    std::stringstream& genJsonDiff(std::stringstream& ss) {
+        RunComparison comparison(*baseline, *out.getProgramRun());
+        ss << R"_("diff": {"rel": [)_";
+        genJsonDiffEntries(ss, comparison.getRelations());
+        ss << R"_(], "rul": [)_";
+        genJsonDiffEntries(ss, comparison.getRules());
+        ss << "]}";
+        return ss;
+    }
+
     std::string genJson() {
         std::stringstream ss;
 
         genJsonTop(ss);
         ss << ",\n";
+        ss << R"_("counters":)_" << (out.getProgramRun()->hasCounters() ? "true" : "false");
+        ss << ",\n";
         genJsonRelations(ss, "topRel", 3);
         ss << ",\n";
         genJsonRules(ss, "topRul", 3);
         ss << ",\n";
-        genJsonRelations(ss, "rel", relationTable.rows.size());
+        genJsonRelations(ss, "rel", relationTable.rows.size(), true);
         ss << ",\n";
-        genJsonRules(ss, "rul", ruleTable.rows.size());
+        genJsonRules(ss, "rul", ruleTable.rows.size(), true);
         ss << ",\n";
+        if (!chunkDir.empty()) {
+            ss << R"_("chunks": ")_" << Tools::cleanJsonOut(chunkDir) << "\",\n";
+        }
         genJsonUsage(ss);
         ss << ",\n";
         genJsonConfiguration(ss);
         ss << ",\n";
         genJsonAtoms(ss);
+        if (baseline != nullptr) {
+            ss << ",\n";
+            genJsonDiff(ss);
+        }
         ss << '\n';
 
         ss << "};\n";
@@ -652,13 +765,52 @@ public:
             } while (Tools::file_exists(newFile));
         }
 
+        // split the iteration series of long runs into chunk files next to the report
+        size_t iterations = 0;
+        for (const auto& rel : out.getProgramRun()->getRelationMap()) {
+            iterations += rel.second->getIterations().size();
+        }
+        chunkDir.clear();
+        seriesChunks.clear();
+        if (iterations > chunkIterations) {
+            std::string dataDir = newFile.substr(0, newFile.size() - filetype.size()) + "_data";
+            if (mkdir(dataDir.c_str(), 0755) != 0 && errno != EEXIST) {
+                std::cerr << "directory " << dataDir << " could not be created, the report is not split.\n";
+            } else {
+                chunkDir = dataDir.substr(dataDir.rfind('/') + 1);
+            }
+        }
+
         std::ofstream outfile(newFile);
 
         outfile << HtmlGenerator::getHtml(genJson());
 
+        for (size_t i = 0; i < seriesChunks.size(); i++) {
+            std::string dataDir = newFile.substr(0, newFile.rfind('/') + 1) + chunkDir;
+            std::ofstream chunk(dataDir + "/chunk" + std::to_string(i) + ".js");
+            chunk << "loadedChunk(" << i << ", {" << seriesChunks[i] << "});\n";
+        }
+
         std::cout << "file output to: " << newFile << std::endl;
     }
 
+    /**
+     * Load a baseline profile to compare the profile with. The profile database only
+     * holds one profile, so the profile is reloaded after reading the baseline.
+     */
+    void setBaseline(const std::string& filename) {
+        baseline = std::make_shared<ProgramRun>();
+        Reader baselineReader(filename, baseline);
+        baselineReader.processFile();
+        try {
+            ProfileEventSingleton::instance().setDBFromFile(f_name);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            exit(1);
+        }
+        updateDB();
+    }
+
     void quit() {
         if (updater.joinable()) {
             updater.join();
@@ -685,6 +837,15 @@ public:
         std::printf("  %-30s%-5s %s\n", "usage [relation id|rule id]", "-",
                 "display CPU usage graphs for a relation or rule.");
         std::printf("  %-30s%-5s %s\n", "memory", "-", "display memory usage.");
+        std::printf("  %-30s%-5s %s\n", "memory relations", "-",
+                "display peak memory of relation indexes, symbols and records.");
+        std::printf("  %-30s%-5s %s\n", "strata", "-", "display the run time of each stratum in seconds.");
+        std::printf("  %-30s%-5s %s\n", "samples", "-",
+                "display the samples of rules and their loop levels taken by the sampling profiler.");
+        std::printf("  %-30s%-5s %s\n", "diff [rel|rul]", "-",
+                "compare relations and rules with the baseline profile given by -d.");
+        std::printf("  %-30s%-5s %s\n", "index [relation id]", "-",
+                "display index accesses of all relations or a given relation.");
         std::printf("  %-30s%-5s %s\n", "help", "-", "print this.");
 
         std::cout << "\nInteractive mode only commands:" << std::endl;
@@ -977,6 +1138,15 @@ public:
         linereader.appendTabCompletion("usage");
         linereader.appendTabCompletion("limit ");
         linereader.appendTabCompletion("memory");
+        linereader.appendTabCompletion("memory relations");
+        linereader.appendTabCompletion("index");
+        linereader.appendTabCompletion("strata");
+        linereader.appendTabCompletion("samples");
+        if (baseline != nullptr) {
+            linereader.appendTabCompletion("diff");
+            linereader.appendTabCompletion("diff rel");
+            linereader.appendTabCompletion("diff rul");
+        }
         linereader.appendTabCompletion("configuration");
 
         // add rel tab completes after the rest so users can see all commands first
@@ -1062,16 +1232,291 @@ public:
         usage(10);
     }
 
+    /** Display the accesses of the indexes of all relations, or of the relation of the given id */
+    void indexes(const std::string& id) {
+        std::cout << " ----- Index Table -----\n";
+        std::printf("%10s%8s%10s%10s%10s%6s %s\n\n", "PROBES", "EMPTY", "SCANS", "TUPLES", "TUP/SCAN", "ID",
+                "NAME/INDEX");
+        bool found = false;
+        for (auto& cur : out.getProgramRun()->getRelationMap()) {
+            const Relation& rel = *cur.second;
+            if (!id.empty() && rel.getId() != id && rel.getName() != id) {
+                continue;
+            }
+            for (auto& index : rel.getIndexStatistics()) {
+                auto stats = index.second;
+                size_t probes = stats["probes"];
+                size_t scans = stats["scans"];
+                std::string empty =
+                        probes == 0 ? "-" : std::to_string(stats["empty-probes"] * 100 / probes) + "%";
+                std::string selectivity =
+                        scans == 0 ? "-" : Tools::formatNum(precision, stats["tuples"] / scans);
+                std::printf("%10s%8s%10s%10s%10s%6s %s (%s)\n", Tools::formatNum(precision, probes).c_str(),
+                        empty.c_str(), Tools::formatNum(precision, scans).c_str(),
+                        Tools::formatNum(precision, stats["tuples"]).c_str(), selectivity.c_str(),
+                        rel.getId().c_str(), rel.getName().c_str(), index.first.c_str());
+                found = true;
+            }
+        }
+        if (!found) {
+            std::cout << "No index accesses recorded; run with --profile-indexes.\n";
+        }
+    }
+
+    void memoryRelations() {
+        auto& db = ProfileEventSingleton::instance().getDB();
+        auto* peak = dynamic_cast<DirectoryEntry*>(db.lookupEntry({"program", "memory", "peak"}));
+        if (peak == nullptr) {
+            std::cout << "No memory of relations recorded.\n";
+            return;
+        }
+
+        // the peak of each index of each relation, largest first
+        std::vector<std::pair<size_t, std::string>> parts;
+        auto* relations = peak->readDirectoryEntry("relation");
+        if (relations != nullptr) {
+            for (const auto& rel : relations->getKeys()) {
+                auto* indexes = relations->readDirectoryEntry(rel);
+                for (const auto& index : indexes->getKeys()) {
+                    auto* entry = dynamic_cast<SizeEntry*>(indexes->readEntry(index));
+                    if (entry != nullptr) {
+                        parts.push_back(std::make_pair(entry->getSize(), rel + " (" + index + ")"));
+                    }
+                }
+            }
+        }
+        for (const std::string component : {"symbols", "records"}) {
+            auto* entry = dynamic_cast<SizeEntry*>(peak->readEntry(component));
+            if (entry != nullptr) {
+                parts.push_back(std::make_pair(entry->getSize(), component));
+            }
+        }
+        std::sort(parts.begin(), parts.end(),
+                [](const std::pair<size_t, std::string>& a, const std::pair<size_t, std::string>& b) {
+                    return a.first > b.first;
+                });
+        std::cout << " ----- Peak Memory -----\n";
+        std::printf("%10s %s\n\n", "MEMORY", "COMPONENT");
+        size_t count = 0;
+        for (const auto& part : parts) {
+            if (++count > resultLimit) {
+                std::cout << (parts.size() - resultLimit) << " rows not shown\n";
+                break;
+            }
+            std::printf("%10s %s\n", Tools::formatMemory(part.first / 1024).c_str(), part.second.c_str());
+        }
+
+        // the memory held at the end of each stratum
+        auto* strata = dynamic_cast<DirectoryEntry*>(db.lookupEntry({"program", "memory", "stratum"}));
+        if (strata == nullptr) {
+            return;
+        }
+        std::vector<std::pair<size_t, size_t>> totals;
+        for (const auto& stratum : strata->getKeys()) {
+            size_t total = 0;
+            std::function<void(DirectoryEntry*)> sum = [&](DirectoryEntry* dir) {
+                for (const auto& key : dir->getKeys()) {
+                    if (auto* entry = dynamic_cast<SizeEntry*>(dir->readEntry(key))) {
+                        total += entry->getSize();
+                    } else if (auto* sub = dir->readDirectoryEntry(key)) {
+                        sum(sub);
+                    }
+                }
+            };
+            sum(strata->readDirectoryEntry(stratum));
+            totals.push_back(std::make_pair(std::stoul(stratum), total));
+        }
+        std::sort(totals.begin(), totals.end());
+        std::cout << "\n ----- Memory by Stratum -----\n";
+        std::printf("%10s %s\n\n", "MEMORY", "STRATUM");
+        for (const auto& total : totals) {
+            std::printf("%10s %zu\n", Tools::formatMemory(total.second / 1024).c_str(), total.first);
+        }
+    }
+
+    void strata() {
+        auto* strata = dynamic_cast<DirectoryEntry*>(
+                ProfileEventSingleton::instance().getDB().lookupEntry({"program", "stratum"}));
+        if (strata == nullptr) {
+            std::cout << "No strata recorded.\n";
+            return;
+        }
+        std::vector<std::pair<size_t, std::string>> keys;
+        for (const auto& key : strata->getKeys()) {
+            keys.push_back(std::make_pair(std::stoul(key), key));
+        }
+        std::sort(keys.begin(), keys.end());
+
+        // a stratum takes the time of computing its relations
+        std::cout << " ----- Stratum Table -----\n";
+        std::printf("%8s%14s %s\n\n", "STRATUM", "TIME", "RELATIONS");
+        for (const auto& key : keys) {
+            auto* relations = strata->readDirectoryEntry(key.second)->readDirectoryEntry("relation");
+            std::chrono::microseconds time{};
+            std::string names;
+            if (relations != nullptr) {
+                for (std::string name : relations->getKeys()) {
+                    std::replace(name.begin(), name.end(), '-', '.');
+                    if (const Relation* rel = out.getProgramRun()->getRelation(name)) {
+                        time += rel->getNonRecTime() + rel->getRecTime() + rel->getCopyTime();
+                    }
+                    names += (names.empty() ? "" : ",") + name;
+                }
+            }
+            std::printf("%8zu%14.6f %s\n", key.first, time.count() / 1000000.0, names.c_str());
+        }
+    }
+
+    void samples() {
+        auto& db = ProfileEventSingleton::instance().getDB();
+        auto* relations = dynamic_cast<DirectoryEntry*>(db.lookupEntry({"program", "samples", "relation"}));
+        auto* other = dynamic_cast<SizeEntry*>(db.lookupEntry({"program", "samples", "other"}));
+        if (relations == nullptr && other == nullptr) {
+            std::cout << "No samples recorded.\n";
+            return;
+        }
+        auto* frequencyEntry = dynamic_cast<TextEntry*>(
+                db.lookupEntry({"program", "configuration", "sampling-frequency"}));
+        double frequency = (frequencyEntry != nullptr) ? std::stod(frequencyEntry->getText()) : 1000;
+
+        // the samples of each rule, and of each of its loop levels
+        struct Row {
+            size_t samples;
+            std::string levels;
+            std::string relation;
+            std::string locator;
+            std::string rule;
+        };
+        std::vector<Row> rows;
+        size_t total = (other != nullptr) ? other->getSize() : 0;
+        if (relations != nullptr) {
+            for (const auto& rel : relations->getKeys()) {
+                auto* rules = relations->readDirectoryEntry(rel);
+                for (const auto& rule : rules->getKeys()) {
+                    auto* entries = rules->readDirectoryEntry(rule);
+                    auto* levels = entries->readDirectoryEntry("level");
+                    auto* locator = dynamic_cast<TextEntry*>(entries->readEntry("source-locator"));
+                    if (levels == nullptr) {
+                        continue;
+                    }
+                    std::vector<std::pair<size_t, size_t>> counts;
+                    for (const auto& level : levels->getKeys()) {
+                        if (auto* entry = dynamic_cast<SizeEntry*>(levels->readEntry(level))) {
+                            counts.push_back(std::make_pair(std::stoul(level), entry->getSize()));
+                        }
+                    }
+                    std::sort(counts.begin(), counts.end());
+                    Row row{0, "", rel, (locator != nullptr) ? locator->getText() : "", rule};
+                    for (const auto& count : counts) {
+                        row.samples += count.second;
+                        row.levels += (row.levels.empty() ? "" : " ") + std::to_string(count.first) + ":" +
+                                      std::to_string(count.second);
+                    }
+                    total += row.samples;
+                    rows.push_back(row);
+                }
+            }
+        }
+        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.samples > b.samples; });
+
+        // level 0 is a rule outside of its loops, level n its n-th nested loop
+        std::cout << " ----- Rule Samples -----\n";
+        std::printf("%8s%9s%10s  %-24s %s\n\n", "SAMPLES", "PERCENT", "TIME", "LEVEL:SAMPLES", "RULE");
+        size_t count = 0;
+        for (const auto& row : rows) {
+            if (++count > resultLimit) {
+                std::cout << (rows.size() - resultLimit) << " rows not shown\n";
+                break;
+            }
+            std::printf("%8zu%8.1f%%%10.3f  %-24s %s %s\n", row.samples,
+                    (total > 0) ? 100.0 * row.samples / total : 0.0, row.samples / frequency,
+                    row.levels.c_str(), row.relation.c_str(), row.locator.c_str());
+            std::printf("%52s%s\n", "", row.rule.c_str());
+        }
+        size_t others = (other != nullptr) ? other->getSize() : 0;
+        std::printf("\n%8zu%8.1f%%%10.3f  %s\n", others, (total > 0) ? 100.0 * others / total : 0.0,
+                others / frequency, "outside of rules");
+    }
+
+    /** print the comparison of the relations with the baseline, by decreasing absolute time delta */
+    void diffRelations() {
+        if (baseline == nullptr) {
+            std::cout << "No baseline profile given.\n";
+            return;
+        }
+        RunComparison comparison(*baseline, *out.getProgramRun());
+        std::cout << " ----- Relation Comparison -----\n";
+        printDiffHeader();
+        std::printf(" %s\n\n", "NAME");
+        size_t count = 0;
+        for (auto& entry : comparison.getRelations()) {
+            if (++count > resultLimit) {
+                std::cout << (comparison.getRelations().size() - resultLimit) << " rows not shown\n";
+                break;
+            }
+            printDiffEntry(entry);
+            std::printf(" %s\n", entry.relation.c_str());
+        }
+    }
+
+    /** print the comparison of the rules with the baseline, by decreasing absolute time delta */
+    void diffRules() {
+        if (baseline == nullptr) {
+            std::cout << "No baseline profile given.\n";
+            return;
+        }
+        RunComparison comparison(*baseline, *out.getProgramRun());
+        std::cout << " ----- Rule Comparison -----\n";
+        printDiffHeader();
+        std::printf("%5s %s\n\n", "VER", "RELATION");
+        size_t count = 0;
+        for (auto& entry : comparison.getRules()) {
+            if (++count > resultLimit) {
+                std::cout << (comparison.getRules().size() - resultLimit) << " rows not shown\n";
+                break;
+            }
+            printDiffEntry(entry);
+            std::printf("%5s %s %s\n", entry.version < 0 ? "-" : std::to_string(entry.version).c_str(),
+                    entry.relation.c_str(), entry.locator.c_str());
+            std::printf("%81s%s\n", "", entry.rule.c_str());
+        }
+    }
+
+    static void printDiffHeader() {
+        std::printf("%10s%10s%10s%9s%12s%12s%12s", "BASE_T", "CUR_T", "DELTA_T", "CHANGE", "TUPLES",
+                "DELTA_TUP", "DELTA_RSS");
+    }
+
+    /** print the measures of an entry, times in seconds and the growth of memory in kilobytes */
+    static void printDiffEntry(const RunComparison::Entry& entry) {
+        std::printf("%10.3f%10.3f%+10.3f", entry.baseTime.count() / 1000000.0,
+                entry.curTime.count() / 1000000.0, entry.getTimeDelta().count() / 1000000.0);
+        if (!entry.inBaseline) {
+            std::printf("%9s", "new");
+        } else if (!entry.inCurrent) {
+            std::printf("%9s", "gone");
+        } else {
+            std::printf("%+8.1f%%", entry.getTimeChange());
+        }
+        std::printf("%12ld%+12ld%+12ld", entry.curTuples, entry.getTuplesDelta(), entry.getRSSDelta());
+    }
+
     void setResultLimit(size_t limit) {
         resultLimit = limit;
     }
 
     void rel(size_t limit, bool showLimit = true) {
         relationTable.sort(sortColumn);
+        bool counters = out.getProgramRun()->hasCounters();
         std::cout << " ----- Relation Table -----\n";
-        std::printf("%8s%8s%8s%8s%8s%8s%8s%8s%8s%6s %s\n\n", "TOT_T", "NREC_T", "REC_T", "COPY_T", "LOAD_T",
-                "SAVE_T", "TUPLES", "READS", "TUP/s", "ID", "NAME");
+        std::printf("%8s%8s%8s%8s%8s%8s%8s%8s%8s", "TOT_T", "NREC_T", "REC_T", "COPY_T", "LOAD_T", "SAVE_T",
+                "TUPLES", "READS", "TUP/s");
+        if (counters) {
+            printCounterHeader();
+        }
+        std::printf("%6s %s\n\n", "ID", "NAME");
         size_t count = 0;
+        auto rows = relationTable.getRows();
         for (auto& row : Tools::formatTable(relationTable, precision)) {
             if (++count > limit) {
                 if (showLimit) {
@@ -1080,18 +1525,27 @@ public:
                 }
                 break;
             }
-            std::printf("%8s%8s%8s%8s%8s%8s%8s%8s%8s%6s %s\n", row[0].c_str(), row[1].c_str(), row[2].c_str(),
+            std::printf("%8s%8s%8s%8s%8s%8s%8s%8s%8s", row[0].c_str(), row[1].c_str(), row[2].c_str(),
                     row[3].c_str(), row[9].c_str(), row[10].c_str(), row[4].c_str(), row[12].c_str(),
-                    row[8].c_str(), row[6].c_str(), row[5].c_str());
+                    row[8].c_str());
+            if (counters) {
+                printCounters(*rows[count - 1], 13);
+            }
+            std::printf("%6s %s\n", row[6].c_str(), row[5].c_str());
         }
     }
 
     void rul(size_t limit, bool showLimit = true) {
         ruleTable.sort(sortColumn);
+        bool counters = out.getProgramRun()->hasCounters();
         std::cout << "  ----- Rule Table -----\n";
-        std::printf(
-                "%8s%8s%8s%8s%8s%8s %s\n\n", "TOT_T", "NREC_T", "REC_T", "TUPLES", "TUP/s", "ID", "RELATION");
+        std::printf("%8s%8s%8s%8s%8s", "TOT_T", "NREC_T", "REC_T", "TUPLES", "TUP/s");
+        if (counters) {
+            printCounterHeader();
+        }
+        std::printf("%8s %s\n\n", "ID", "RELATION");
         size_t count = 0;
+        auto rows = ruleTable.getRows();
         for (auto& row : Tools::formatTable(ruleTable, precision)) {
             if (++count > limit) {
                 if (showLimit) {
@@ -1099,11 +1553,39 @@ public:
                 }
                 break;
             }
-            std::printf("%8s%8s%8s%8s%8s%8s %s\n", row[0].c_str(), row[1].c_str(), row[2].c_str(),
-                    row[4].c_str(), row[9].c_str(), row[6].c_str(), row[7].c_str());
+            std::printf("%8s%8s%8s%8s%8s", row[0].c_str(), row[1].c_str(), row[2].c_str(), row[4].c_str(),
+                    row[9].c_str());
+            if (counters) {
+                printCounters(*rows[count - 1], 11);
+            }
+            std::printf("%8s %s\n", row[6].c_str(), row[7].c_str());
         }
     }
 
+    /** Print the headers of the hardware counter columns */
+    void printCounterHeader() {
+        std::printf("%8s%8s%6s%8s%8s", "CYCLES", "INSTR", "IPC", "LLC_M", "BR_M");
+    }
+
+    /**
+     * Print the hardware counters of a table row starting at the given column,
+     * with the instructions per cycle telling compute-bound from memory-bound
+     * rules and relations.
+     */
+    void printCounters(Row& row, size_t column) {
+        long cycles = row[column]->getLongVal();
+        long instructions = row[column + 1]->getLongVal();
+        std::string ipc = "-";
+        if (cycles > 0) {
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(2) << double(instructions) / cycles;
+            ipc = ss.str();
+        }
+        std::printf("%8s%8s%6s%8s%8s", row[column]->toString(precision).c_str(),
+                row[column + 1]->toString(precision).c_str(), ipc.c_str(),
+                row[column + 2]->toString(precision).c_str(), row[column + 3]->toString(precision).c_str());
+    }
+
     void id(std::string col) {
         ruleTable.sort(6);
         std::vector<std::vector<std::string>> table = Tools::formatTable(ruleTable, precision);
@@ -0,0 +1,413 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Tuner.h
+ *
+ * Search for the relation representations, SIPS and number of threads under
+ * which a program runs fastest on sample facts.
+ *
+ * The program is run repeatedly by souffle, or compiled once per setting of
+ * the pragmas and run as a binary, varying one knob at a time and keeping a
+ * variation if it is faster than the best configuration so far and produces
+ * the same outputs. The knobs are tried in the order of the cost of a run:
+ * the number of threads, the SIPS, and the representations of the relations
+ * taking the most time in a profile of the first run. Runs are cut off once
+ * they take twice the time of the best configuration or exceed the budget.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ProgramRun.h"
+#include "Reader.h"
+#include "Relation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace souffle {
+namespace profile {
+
+/**
+ * A setting of the knobs of a program
+ */
+class TuningConfig {
+public:
+    /** the SIPS, empty for the one of the program */
+    std::string sips;
+
+    /** the number of threads */
+    size_t jobs = 1;
+
+    /** the representations of relations differing from their declarations */
+    std::map<std::string, std::string> representations;
+
+    /** Get the pragmas of the configuration, as given to souffle by --pragma */
+    std::string getPragmas() const {
+        std::vector<std::string> res;
+        if (!sips.empty()) {
+            res.push_back("SIPS:" + sips);
+        }
+        if (!representations.empty()) {
+            res.push_back("representations:" + getRepresentations());
+        }
+        return join(res, ";");
+    }
+
+    /** Print the configuration as pragmas to be pasted into the program */
+    void print(std::ostream& os) const {
+        if (!sips.empty()) {
+            os << ".pragma \"SIPS\" \"" << sips << "\"\n";
+        }
+        if (!representations.empty()) {
+            os << ".pragma \"representations\" \"" << getRepresentations() << "\"\n";
+        }
+        os << "// run with -j" << jobs << "\n";
+    }
+
+private:
+    std::string getRepresentations() const {
+        std::vector<std::string> res;
+        for (const auto& cur : representations) {
+            res.push_back(cur.first + "=" + cur.second);
+        }
+        return join(res, ",");
+    }
+
+    static std::string join(const std::vector<std::string>& parts, const std::string& separator) {
+        std::string res;
+        for (size_t i = 0; i < parts.size(); ++i) {
+            res += (i > 0 ? separator : "") + parts[i];
+        }
+        return res;
+    }
+};
+
+class Tuner {
+public:
+    struct Options {
+        /** the souffle executable */
+        std::string souffle = "souffle";
+
+        /** the Datalog program */
+        std::string program;
+
+        /** the directory of the sample facts */
+        std::string factDir = ".";
+
+        /** further arguments of souffle */
+        std::vector<std::string> arguments;
+
+        /** whether the program is compiled rather than interpreted */
+        bool compile = false;
+
+        /** the time of the search in seconds */
+        double budget = 600;
+
+        /** the number of relations whose representations are varied, the slowest first */
+        size_t relations = 8;
+
+        /** the number of runs of each configuration, whose fastest counts */
+        size_t repeats = 1;
+    };
+
+    Tuner(Options options) : options(std::move(options)) {}
+
+    ~Tuner() {
+        if (!workDir.empty()) {
+            // the files are removed before their directories
+            auto remove = [](const char* file, const struct stat*, int, struct FTW*) {
+                return std::remove(file);
+            };
+            nftw(workDir.c_str(), remove, 16, FTW_DEPTH | FTW_PHYS);
+        }
+    }
+
+    /**
+     * Search for the fastest configuration within the budget, logging the runs.
+     *
+     * @return the fastest configuration and its time, negative if the program fails by default
+     */
+    std::pair<TuningConfig, double> tune(std::ostream& log) {
+        start = clock::now();
+        char dir[] = "/tmp/souffle-tune-XXXXXX";
+        if (mkdtemp(dir) == nullptr) {
+            throw std::runtime_error("Cannot create a temporary directory");
+        }
+        workDir = dir;
+        mkdir(path("reference").c_str(), 0777);
+        mkdir(path("output").c_str(), 0777);
+
+        // the default configuration is profiled, its outputs are those all others have to match
+        TuningConfig best;
+        std::vector<std::string> profiled = {options.souffle, "-p", path("profile.log")};
+        double bestTime = measure(best, path("reference"), profiled, remaining());
+        if (bestTime < 0) {
+            log << "The program fails in its default configuration\n";
+            return std::make_pair(best, bestTime);
+        }
+        bestTime = std::min(bestTime, measure(best, path("reference"), {}, remaining()));
+        log << "default: " << seconds(bestTime) << "\n";
+
+        auto attempt = [&](const TuningConfig& config, const std::string& knob) {
+            const double budget = std::min(2 * bestTime + 1, remaining());
+            if (budget <= 0) {
+                return;
+            }
+            const double time = measure(config, path("output"), {}, budget);
+            if (time < 0) {
+                log << knob << ": failed, timed out or changed the outputs\n";
+                return;
+            }
+            log << knob << ": " << seconds(time) << "\n";
+            // variations of a few percent are taken for noise
+            if (time < 0.95 * bestTime) {
+                best = config;
+                bestTime = time;
+            }
+        };
+
+        const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        const TuningConfig sequential = best;
+        for (size_t jobs = 2; jobs / 2 < threads; jobs *= 2) {
+            TuningConfig config = sequential;
+            config.jobs = std::min(jobs, threads);
+            attempt(config, "-j" + std::to_string(config.jobs));
+        }
+
+        const TuningConfig withoutSips = best;
+        for (const std::string sips :
+                {"naive", "all-bound", "max-bound", "max-ratio", "least-free", "least-free-vars"}) {
+            TuningConfig config = withoutSips;
+            config.sips = sips;
+            attempt(config, "SIPS " + sips);
+        }
+
+        for (const std::string& rel : getSlowestRelations()) {
+            const TuningConfig declared = best;
+            for (const std::string representation : {"btree", "brie", "eqrel"}) {
+                TuningConfig config = declared;
+                config.representations[rel] = representation;
+                attempt(config, rel + " " + representation);
+            }
+        }
+        return std::make_pair(best, bestTime);
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    std::string path(const std::string& file) const {
+        return workDir + "/" + file;
+    }
+
+    double remaining() const {
+        return options.budget - std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    static std::string seconds(double time) {
+        std::stringstream res;
+        res << std::fixed << std::setprecision(3) << time << "s";
+        return res.str();
+    }
+
+    /** Get the relations of the profile taking the most time, the slowest first */
+    std::vector<std::string> getSlowestRelations() const {
+        if (!std::ifstream(path("profile.log")).good()) {
+            return {};
+        }
+        auto run = std::make_shared<ProgramRun>(ProgramRun());
+        Reader(path("profile.log"), run).processFile();
+        std::vector<std::pair<double, std::string>> times;
+        for (const auto& cur : run->getRelationMap()) {
+            const Relation& rel = *cur.second;
+            const double time = std::chrono::duration<double>(rel.getNonRecTime() + rel.getRecTime()).count();
+            if (time > 0) {
+                times.emplace_back(time, rel.getName());
+            }
+        }
+        std::sort(times.rbegin(), times.rend());
+        std::vector<std::string> res;
+        for (size_t i = 0; i < times.size() && i < options.relations; ++i) {
+            res.push_back(times[i].second);
+        }
+        return res;
+    }
+
+    /**
+     * Measure the fastest of the runs of a configuration, writing its outputs into a directory.
+     *
+     * @param config the configuration
+     * @param outputDir the directory of the outputs, compared with the reference unless it is the reference
+     * @param interpreter the souffle command interpreting the program instead, if not empty
+     * @param timeout the time after which a run is cut off
+     * @return the time in seconds, negative if a run fails, is cut off or changes the outputs
+     */
+    double measure(const TuningConfig& config, const std::string& outputDir,
+            const std::vector<std::string>& interpreter, double timeout) {
+        std::vector<std::string> command;
+        if (options.compile && interpreter.empty()) {
+            const std::string binary = getBinary(config, timeout);
+            if (binary.empty()) {
+                return -1;
+            }
+            command = {binary};
+        } else {
+            command = interpreter.empty() ? std::vector<std::string>{options.souffle} : interpreter;
+            command.insert(command.end(), options.arguments.begin(), options.arguments.end());
+            if (!config.getPragmas().empty()) {
+                command.push_back("--pragma=" + config.getPragmas());
+            }
+            command.push_back(options.program);
+        }
+        command.insert(command.end(),
+                {"-F", options.factDir, "-D", outputDir, "-j" + std::to_string(config.jobs)});
+
+        double res = -1;
+        for (size_t i = 0; i < options.repeats; ++i) {
+            const double time = execute(command, timeout);
+            if (time < 0) {
+                return -1;
+            }
+            res = (res < 0) ? time : std::min(res, time);
+        }
+        if (outputDir != path("reference") && !haveSameOutputs(path("reference"), outputDir)) {
+            return -1;
+        }
+        return res;
+    }
+
+    /** Compile the program under the pragmas of a configuration, once for each setting of the pragmas */
+    std::string getBinary(const TuningConfig& config, double timeout) {
+        const std::string pragmas = config.getPragmas();
+        auto pos = binaries.find(pragmas);
+        if (pos != binaries.end()) {
+            return pos->second;
+        }
+        const std::string binary = path("program" + std::to_string(binaries.size()));
+        std::vector<std::string> command = {options.souffle};
+        command.insert(command.end(), options.arguments.begin(), options.arguments.end());
+        if (!pragmas.empty()) {
+            command.push_back("--pragma=" + pragmas);
+        }
+        command.insert(command.end(), {"-o", binary, options.program});
+        // the compilation does not count as time of the program, only against the budget
+        const bool compiled = execute(command, remaining()) >= 0;
+        return binaries[pragmas] = compiled ? binary : "";
+    }
+
+    /** Execute a command without its output, returning its time in seconds, negative on failure or timeout */
+    static double execute(const std::vector<std::string>& command, double timeout) {
+        const auto begin = clock::now();
+        pid_t pid = fork();
+        if (pid < 0) {
+            return -1;
+        }
+        if (pid == 0) {
+            int null = open("/dev/null", O_WRONLY);
+            dup2(null, STDOUT_FILENO);
+            dup2(null, STDERR_FILENO);
+            std::vector<char*> argv;
+            for (const std::string& arg : command) {
+                argv.push_back(const_cast<char*>(arg.c_str()));
+            }
+            argv.push_back(nullptr);
+            execvp(argv[0], argv.data());
+            _exit(127);
+        }
+        int status = 0;
+        while (waitpid(pid, &status, WNOHANG) == 0) {
+            if (std::chrono::duration<double>(clock::now() - begin).count() > timeout) {
+                kill(pid, SIGKILL);
+                waitpid(pid, &status, 0);
+                return -1;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            return -1;
+        }
+        return std::chrono::duration<double>(clock::now() - begin).count();
+    }
+
+    /** Check whether two directories hold the same files with the same lines, in any order */
+    static bool haveSameOutputs(const std::string& expected, const std::string& actual) {
+        const auto files = listFiles(expected);
+        if (files != listFiles(actual)) {
+            return false;
+        }
+        for (const std::string& file : files) {
+            if (readSorted(expected + "/" + file) != readSorted(actual + "/" + file)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static std::vector<std::string> listFiles(const std::string& dir) {
+        std::vector<std::string> res;
+        if (DIR* handle = opendir(dir.c_str())) {
+            while (dirent* entry = readdir(handle)) {
+                const std::string file = entry->d_name;
+                if (file != "." && file != "..") {
+                    res.push_back(file);
+                }
+            }
+            closedir(handle);
+        }
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
+    static std::vector<std::string> readSorted(const std::string& file) {
+        std::ifstream in(file);
+        std::vector<std::string> res;
+        std::string line;
+        while (std::getline(in, line)) {
+            res.push_back(line);
+        }
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
+    Options options;
+
+    /** the directory of the profile, outputs and binaries */
+    std::string workDir;
+
+    /** the binaries compiled so far, by their pragmas */
+    std::map<std::string, std::string> binaries;
+
+    clock::time_point start;
+};
+
+}  // namespace profile
+}  // namespace souffle
@@ -42,22 +42,59 @@ function highlightRow() {
 }
 
 
-function graphRel() {
-    if (!selected.rel) {
-        alert("please select a relation to graph");
+// the iteration series of large reports are in chunk files next to the report, loaded on demand by
+// script elements, as browsers do not fetch files of reports opened from the file system
+var loaded_series = {};
+var chunk_callbacks = {};
+
+function loadedChunk(chunk, series) {
+    var id, callbacks = chunk_callbacks[chunk];
+    for (id in series) {
+        if (series.hasOwnProperty(id)) {
+            loaded_series[id] = series[id];
+        }
+    }
+    chunk_callbacks[chunk] = [];
+    for (id = 0; id < callbacks.length; id++) {
+        callbacks[id]();
+    }
+}
+
+function withSeries(series, id, callback) {
+    var script;
+    if (!series || !series.hasOwnProperty("chunk")) {
+        callback(series);
         return;
     }
+    if (loaded_series.hasOwnProperty(id)) {
+        callback(loaded_series[id]);
+        return;
+    }
+    if (!chunk_callbacks.hasOwnProperty(series.chunk)) {
+        chunk_callbacks[series.chunk] = [];
+        script = document.createElement("script");
+        script.src = data.chunks + "/chunk" + series.chunk + ".js";
+        script.onerror = function () {
+            alert("The iterations are in " + script.src + ", which could not be loaded.");
+        };
+        document.body.appendChild(script);
+    }
+    chunk_callbacks[series.chunk].push(function () {
+        callback(loaded_series[id]);
+    });
+}
 
+function graphSeries(series) {
     graph_vals.labels = [];
     graph_vals.tot_t = [];
     graph_vals.tuples = [];
-    for (j = 0; j < data.rel[selected.rel][9].tot_t.length; j++) {
+    for (j = 0; j < series.tot_t.length; j++) {
         graph_vals.labels.push(j.toString());
         graph_vals.tot_t.push(
-            data.rel[selected.rel][9].tot_t[j]
+            series.tot_t[j]
         );
         graph_vals.tuples.push(
-            data.rel[selected.rel][9].tuples[j]
+            series.tuples[j]
         )
     }
 
@@ -65,6 +102,15 @@ function graphRel() {
     drawGraph();
 }
 
+function graphRel() {
+    if (!selected.rel) {
+        alert("please select a relation to graph");
+        return;
+    }
+
+    withSeries(data.rel[selected.rel][10], selected.rel, graphSeries);
+}
+
 function graphIterRul() {
     if (!selected.rul || selected.rul[0]!='C') {
         alert("Please select a recursive rule (ID starts with C) to graph.");
@@ -73,21 +119,7 @@ function graphIterRul() {
 
     came_from = "rul";
 
-    graph_vals.labels = [];
-    graph_vals.tot_t = [];
-    graph_vals.tuples = [];
-    for (j = 0; j < data.rul[selected.rul][9].tot_t.length; j++) {
-        graph_vals.labels.push(j.toString());
-        graph_vals.tot_t.push(
-            data.rul[selected.rul][9].tot_t[j]
-        );
-        graph_vals.tuples.push(
-            data.rul[selected.rul][9].tuples[j]
-        )
-    }
-
-    document.getElementById('chart_tab').click();
-    drawGraph();
+    withSeries(data.rul[selected.rul][8], selected.rul, graphSeries);
 }
 
 
@@ -213,6 +245,13 @@ function toggle_precision() {
     flip_table_values(document.getElementById("Rul_table"));
     flip_table_values(document.getElementById("rulesofrel_table"));
     flip_table_values(document.getElementById("rulvertable"));
+    flip_table_values(document.getElementById("diff_rel_table"));
+    flip_table_values(document.getElementById("diff_rul_table"));
+}
+
+// prefix the magnitude of a difference with its sign
+function signed(value, magnitude) {
+    return (value < 0 ? "-" : "+") + magnitude;
 }
 
 function flip_table_values(table) {
@@ -228,6 +267,12 @@ function flip_table_values(table) {
             } else if (cell.className === "int_cell") {
                 val = cell.getAttribute('data-sort');
                 cell.innerHTML = minify_numbers(parseInt(val));
+            } else if (cell.className === "delta_time_cell") {
+                val = parseFloat(cell.getAttribute('data-sort'));
+                cell.innerHTML = signed(val, humanise_time(Math.abs(val)));
+            } else if (cell.className === "delta_int_cell") {
+                val = parseInt(cell.getAttribute('data-sort'));
+                cell.innerHTML = signed(val, minify_numbers(Math.abs(val)));
             }
         }
     }
@@ -258,6 +303,22 @@ function create_cell(type, value, perc_total) {
         cell.innerHTML = minify_numbers(value);
         cell.setAttribute('data-sort', value);
         cell.className = "int_cell";
+    } else if (type === "float") {
+        cell.innerHTML = parseFloat(value).toFixed(2);
+        cell.setAttribute('data-sort', value);
+        cell.className = "float_cell";
+    } else if (type === "delta_time") {
+        cell.innerHTML = signed(value, humanise_time(Math.abs(value)));
+        cell.setAttribute('data-sort', value);
+        cell.className = "delta_time_cell";
+    } else if (type === "delta_int") {
+        cell.innerHTML = signed(value, minify_numbers(Math.abs(value)));
+        cell.setAttribute('data-sort', value);
+        cell.className = "delta_int_cell";
+    } else if (type === "change") {
+        cell.innerHTML = isNaN(value) ? value : (value < 0 ? "" : "+") + parseFloat(value).toFixed(1) + "%";
+        cell.setAttribute('data-sort', isNaN(value) ? 0 : value);
+        cell.className = "float_cell";
     } else if (type === "perc") {
         div = document.createElement("div");
         div.className = "perc_time";
@@ -301,8 +362,20 @@ function generate_table(data_format,body_id,data_key) {
 
     table_body = document.getElementById(body_id);
     table_body.innerHTML = "";
+    var items = [];
     for (item in data[data_key]) {
         if (data[data_key].hasOwnProperty(item)) {
+            items.push(item);
+        }
+    }
+
+    // large tables are rendered in batches, the most expensive rows first, so that the page stays
+    // responsive while the rest are added
+    var render = function (start) {
+        var end = Math.min(items.length, start + table_batch);
+        var fragment = document.createDocumentFragment();
+        for (var k = start; k < end; k++) {
+            item = items[k];
             row = document.createElement("tr");
             row.id = item;
 
@@ -327,43 +400,65 @@ function generate_table(data_format,body_id,data_key) {
                 }
                 row.appendChild(cell);
             }
-            table_body.appendChild(row);
+            fragment.appendChild(row);
         }
+        table_body.appendChild(fragment);
+        if (end < items.length) {
+            setTimeout(function () { render(end); }, 0);
+        }
+    };
+    render(0);
+}
+
+function with_counters(data_format, start) {
+    if (!data.counters) return data_format;
+    var counters = [["int",start],["int",start+1],["float",start+2],["int",start+3],["int",start+4]];
+    // the counters go before the source column
+    var pos = data_format.length - 1;
+    return data_format.slice(0, pos).concat(counters, data_format.slice(pos));
+}
+
+function hide_counter_columns() {
+    var i, columns;
+    if (data.counters) return;
+    columns = document.getElementsByClassName("counter_col");
+    for (i = 0; i < columns.length; i++) {
+        columns[i].style.display = "none";
     }
 }
 
 function gen_rel_table() {
-    generate_table([["text",0],["id",1],["time",2],["time",3],["time",4],
-        ["time",5],["int",6],["int", 7],["perc","float",2],["perc","int",6],["code_loc",8]],
+    generate_table(with_counters([["text",0],["id",1],["time",2],["time",3],["time",4],
+        ["time",5],["int",6],["int", 7],["perc","float",2],["perc","int",6],["code_loc",8]], 11),
         "Rel_table_body",
     "rel");
 }
 
 function gen_rul_table() {
-    generate_table([["text",0],["id",1],["time",2],["time",3],["time",4],
-            ["int",5],["perc","float",2],["perc","int",5],["code_loc",6]],
+    generate_table(with_counters([["text",0],["id",1],["time",2],["time",3],["time",4],
+            ["int",5],["perc","float",2],["perc","int",5],["code_loc",6]], 10),
         "Rul_table_body",
         "rul");
 }
 
 function gen_top_rel_table() {
-    generate_table([["text",0],["id",1],["time",2],["time",3],["time",4],
-        ["time",5],["int",6],["int",7],["perc","float",2],["perc","int",6],["code_loc",8]],
+    generate_table(with_counters([["text",0],["id",1],["time",2],["time",3],["time",4],
+        ["time",5],["int",6],["int",7],["perc","float",2],["perc","int",6],["code_loc",8]], 11),
         "top_rel_table_body",
     "topRel");
 }
 
 function gen_top_rul_table() {
-    generate_table([["text",0],["id",1],["time",2],["time",3],["time",4],
-            ["int",5],["perc","float",2],["perc","int",5],["code_loc",6]],
+    generate_table(with_counters([["text",0],["id",1],["time",2],["time",3],["time",4],
+            ["int",5],["perc","float",2],["perc","int",5],["code_loc",6]], 10),
         "top_rul_table_body",
         "topRul");
 }
 
 
 function genRulesOfRelations() {
-    var data_format = [["text",0],["id",1],["time",2],["time",3],["time",4],
-            ["int",5],["perc","float",2],["perc","int",5],["code_loc",6]];
+    var data_format = with_counters([["text",0],["id",1],["time",2],["time",3],["time",4],
+            ["int",5],["perc","float",2],["perc","int",5],["code_loc",6]], 10);
     var rules = data.rel[selected.rel][9];
     var perc_totals = [];
     var row, cell, perc_counter, table_body, i, j;
@@ -573,6 +668,7 @@ function gen_code(highlight_row) {
 var precision = !1;
 var selected = {rel: !1, rul: !1};
 var came_from = !1;
+var table_batch = 500;
 var graph_vals = {
     labels:[],
     tot_t:[],
@@ -580,11 +676,57 @@ var graph_vals = {
 };
 
 
+// a comparison entry: [relation, rule, version, source, in baseline, in current,
+// baseline time, current time, baseline tuples, current tuples, baseline memory, current memory]
+function gen_diff_table(body_id, entries, is_rule) {
+    var i, entry, row, change;
+    var table_body = document.getElementById(body_id);
+    table_body.innerHTML = "";
+    for (i = 0; i < entries.length; i++) {
+        entry = entries[i];
+        if (!entry[4]) {
+            change = "new";
+        } else if (!entry[5]) {
+            change = "gone";
+        } else {
+            change = entry[6] > 0 ? 100 * (entry[7] - entry[6]) / entry[6] : 0;
+        }
+        row = document.createElement("tr");
+        if (is_rule) {
+            row.appendChild(create_cell("text", entry[1]));
+            row.appendChild(create_cell("text", entry[0]));
+            row.appendChild(create_cell("id", entry[2] < 0 ? "-" : entry[2]));
+        } else {
+            row.appendChild(create_cell("text", entry[0]));
+        }
+        row.appendChild(create_cell("time", entry[6]));
+        row.appendChild(create_cell("time", entry[7]));
+        row.appendChild(create_cell("delta_time", entry[7] - entry[6]));
+        row.appendChild(create_cell("change", change));
+        row.appendChild(create_cell("int", entry[9]));
+        row.appendChild(create_cell("delta_int", entry[9] - entry[8]));
+        row.appendChild(create_cell("delta_int", entry[11] - entry[10]));
+        row.appendChild(create_cell("code_loc", entry[3]));
+        table_body.appendChild(row);
+    }
+}
+
+function gen_diff() {
+    if (!data.hasOwnProperty("diff")) return;
+    document.getElementById("diff-tab").style.display = "block";
+    gen_diff_table("diff_rel_table_body", data.diff.rel, false);
+    gen_diff_table("diff_rul_table_body", data.diff.rul, true);
+    Tablesort(document.getElementById('diff_rel_table'),{descending: true});
+    Tablesort(document.getElementById('diff_rul_table'),{descending: true});
+}
+
 function init() {
+    hide_counter_columns();
     gen_top();
     gen_rel_table();
     gen_rul_table();
     gen_code(-1)
+    gen_diff();
     Tablesort(document.getElementById('Rel_table'),{descending: true});
     Tablesort(document.getElementById('Rul_table'),{descending: true});
     Tablesort(document.getElementById('rulesofrel_table'),{descending: true});
@@ -29,6 +29,7 @@ std::string htmlBodyTop = R"___(
         <li><a class="tablinks" id="rel_tab" onclick="changeTab(event, 'Relations');came_from = 'rel';">Relations</a></li>
         <li><a class="tablinks" id="rul_tab" onclick="changeTab(event, 'Rules');came_from = 'rul';">Rules</a></li>
         <li id="code-tab"><a class="tablinks" id="code_tab" onclick="changeTab(event, 'Code')">Code</a></li>
+        <li id="diff-tab" style="display:none;"><a class="tablinks" onclick="changeTab(event, 'Comparison')">Comparison</a></li>
         <li><a class="tablinks" onclick="changeTab(event, 'Help')">Help</a></li>
         <li id="chart-tab" style="display:none;"><a id="chart_tab" onclick="changeTab(event, 'Chart')" class="tablinks">Chart</a></li>
     </ul>
@@ -71,6 +72,11 @@ std::string htmlBodyTop = R"___(
                     <th data-sort-method="number">Reads</th>
                     <th data-sort-method="number">% of Time</th>
                     <th data-sort-method="number">% of Tuples</th>
+                    <th data-sort-method="number" class="counter_col">Cycles</th>
+                    <th data-sort-method="number" class="counter_col">Instructions</th>
+                    <th data-sort-method="number" class="counter_col">IPC</th>
+                    <th data-sort-method="number" class="counter_col">Cache Misses</th>
+                    <th data-sort-method="number" class="counter_col">Branch Misses</th>
                     <th data-sort-method="text">Source</th>
                 </tr>
                 </thead>
@@ -91,6 +97,11 @@ std::string htmlBodyTop = R"___(
                     <th data-sort-method="number">Tuples</th>
                     <th data-sort-method="number">% of Time</th>
                     <th data-sort-method="number">% of Tuples</th>
+                    <th data-sort-method="number" class="counter_col">Cycles</th>
+                    <th data-sort-method="number" class="counter_col">Instructions</th>
+                    <th data-sort-method="number" class="counter_col">IPC</th>
+                    <th data-sort-method="number" class="counter_col">Cache Misses</th>
+                    <th data-sort-method="number" class="counter_col">Branch Misses</th>
                     <th data-sort-method="text">Source</th>
                 </tr>
                 </thead>
@@ -124,6 +135,11 @@ std::string htmlBodyTop = R"___(
                 <th data-sort-method="number">Reads</th>
                 <th data-sort-method="number">% of Time</th>
                 <th data-sort-method="number">% of Tuples</th>
+                <th data-sort-method="number" class="counter_col">Cycles</th>
+                <th data-sort-method="number" class="counter_col">Instructions</th>
+                <th data-sort-method="number" class="counter_col">IPC</th>
+                <th data-sort-method="number" class="counter_col">Cache Misses</th>
+                <th data-sort-method="number" class="counter_col">Branch Misses</th>
                 <th data-sort-method="text">Source</th>
             </tr>
             </thead>
@@ -146,6 +162,11 @@ std::string htmlBodyTop = R"___(
                     <th data-sort-method="number">Tuples</th>
                     <th data-sort-method="number">% of Time</th>
                     <th data-sort-method="number">% of Tuples</th>
+                    <th data-sort-method="number" class="counter_col">Cycles</th>
+                    <th data-sort-method="number" class="counter_col">Instructions</th>
+                    <th data-sort-method="number" class="counter_col">IPC</th>
+                    <th data-sort-method="number" class="counter_col">Cache Misses</th>
+                    <th data-sort-method="number" class="counter_col">Branch Misses</th>
                     <th data-sort-method="text" style="width:20%;">Source</th>
                 </tr>
                 </thead>
@@ -172,6 +193,11 @@ std::string htmlBodyTop = R"___(
                 <th data-sort-method="number">Tuples</th>
                 <th data-sort-method="number">% of Time</th>
                 <th data-sort-method="number">% of Tuples</th>
+                <th data-sort-method="number" class="counter_col">Cycles</th>
+                <th data-sort-method="number" class="counter_col">Instructions</th>
+                <th data-sort-method="number" class="counter_col">IPC</th>
+                <th data-sort-method="number" class="counter_col">Cache Misses</th>
+                <th data-sort-method="number" class="counter_col">Branch Misses</th>
                 <th data-sort-method="text">Source</th>
             </tr>
             </thead>
@@ -220,6 +246,52 @@ std::string htmlBodyTop = R"___(
         </div>
     </div>
 </div>
+<div id="Comparison" class="tabcontent">
+    <h3>Relation comparison with the baseline</h3>
+    <button onclick="toggle_precision();">Toggle number precision</button>
+    <div class="table_wrapper">
+        <table id='diff_rel_table'>
+            <thead>
+            <tr>
+                <th data-sort-method="text">Name</th>
+                <th data-sort-method="time">Baseline Time</th>
+                <th data-sort-method="time">Current Time</th>
+                <th data-sort-method="number">Time Delta</th>
+                <th data-sort-method="number">Time Change</th>
+                <th data-sort-method="number">Tuples</th>
+                <th data-sort-method="number">Tuples Delta</th>
+                <th data-sort-method="number">Memory Delta (B)</th>
+                <th data-sort-method="text">Source</th>
+            </tr>
+            </thead>
+            <tbody id="diff_rel_table_body">
+            </tbody>
+        </table>
+    </div>
+    <hr/>
+    <h3>Rule comparison with the baseline</h3>
+    <div class="table_wrapper">
+        <table id='diff_rul_table'>
+            <thead>
+            <tr>
+                <th data-sort-method="text">Name</th>
+                <th data-sort-method="text">Relation</th>
+                <th data-sort-method="number">Ver</th>
+                <th data-sort-method="time">Baseline Time</th>
+                <th data-sort-method="time">Current Time</th>
+                <th data-sort-method="number">Time Delta</th>
+                <th data-sort-method="number">Time Change</th>
+                <th data-sort-method="number">Tuples</th>
+                <th data-sort-method="number">Tuples Delta</th>
+                <th data-sort-method="number">Memory Delta (B)</th>
+                <th data-sort-method="text">Source</th>
+            </tr>
+            </thead>
+            <tbody id="diff_rul_table_body">
+            </tbody>
+        </table>
+    </div>
+</div>
 <div id="Chart" class="tabcontent">
     <button onclick="goBack(event)">Go Back</button>
     <button onclick="toggle_precision();">Toggle number precision</button>
@@ -100,8 +100,14 @@
 "printsize"                           { return yy::parser::make_PRINTSIZE_QUALIFIER(yylloc); }
 "eqrel"                               { return yy::parser::make_EQREL_QUALIFIER(yylloc); }
 "inline"                              { return yy::parser::make_INLINE_QUALIFIER(yylloc); }
+"subsume"                             { return yy::parser::make_SUBSUME_QUALIFIER(yylloc); }
+"storage"                             { return yy::parser::make_STORAGE_QUALIFIER(yylloc); }
 "brie"                                { return yy::parser::make_BRIE_QUALIFIER(yylloc); }
 "btree"                               { return yy::parser::make_BTREE_QUALIFIER(yylloc); }
+"compressed"                          { return yy::parser::make_COMPRESSED_QUALIFIER(yylloc); }
+"hashset"                             { return yy::parser::make_HASHSET_QUALIFIER(yylloc); }
+"mmap"                                { return yy::parser::make_MMAP_QUALIFIER(yylloc); }
+"bitmap"                              { return yy::parser::make_BITMAP_QUALIFIER(yylloc); }
 "min"                                 { return yy::parser::make_MIN(yylloc); }
 "max"                                 { return yy::parser::make_MAX(yylloc); }
 "as"                                  { return yy::parser::make_AS(yylloc); }
@@ -20,6 +20,8 @@
 #include "AstArgument.h"
 #include "AstAttribute.h"
 #include "AstClause.h"
+#include "AstComponent.h"
+#include "AstFactTable.h"
 #include "AstComponentChecker.h"
 #include "AstIOTypeAnalysis.h"
 #include "AstLiteral.h"
@@ -123,12 +125,50 @@ private:
         out << "\n";
 
         // rules
-        for (const auto& rel : program.getRelations()) {
-            for (const auto& clause : rel->getClauses()) {
-                visit(*clause, out);
+        convertClauses(program, out);
+        out << "\n";
+    }
+
+    /**
+     * Converts the clauses and facts of each relation into a section of its own, the sections in
+     * parallel, and writes the sections in the order of the relations.
+     */
+    void convertClauses(const AstProgram& program, std::ostream& out) {
+        const std::vector<AstRelation*> relations = program.getRelations();
+        int numRelations = relations.size();
+        std::vector<std::string> sections(numRelations);
+        std::vector<std::string> errors(numRelations);
+#pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < numRelations; i++) {
+            LogicbloxConverter converter(*this);
+            std::stringstream section;
+            try {
+                converter.convertRelation(*relations[i], section);
+            } catch (const UnsupportedConstructException& e) {
+                errors[i] = e.what();
+            }
+            sections[i] = section.str();
+        }
+        for (int i = 0; i < numRelations; i++) {
+            if (!errors[i].empty()) {
+                throw UnsupportedConstructException(errors[i]);
+            }
+            out << sections[i];
+        }
+    }
+
+    /**
+     * Converts the clauses of a relation, and the facts of its fact table one at a time.
+     */
+    void convertRelation(const AstRelation& rel, std::ostream& out) {
+        for (const auto& clause : rel.getClauses()) {
+            visit(*clause, out);
+        }
+        if (const AstFactTable* facts = rel.getFactTable()) {
+            for (size_t i = 0; i < facts->size(); i++) {
+                visit(*facts->getClause(rel.getName(), i), out);
             }
         }
-        out << "\n";
     }
 
     /**
@@ -323,6 +363,8 @@ int main(int argc, char** argv) {
                 {"include-dir", 'I', "DIR", ".", true, "Specify directory for include files."},
                 {"output", 'o', "FILE", "", false, "Generate bddbddb Datalog program"},
                 {"debug-report", 'r', "FILE", "", false, "Write HTML debug report to <FILE>."},
+                {"stream", 's', "", "", false,
+                        "Convert clauses and facts as parsed, without checking or transforming them."},
                 {"no-warn", 'w', "", "", false, "Disable warnings."},
                 {"verbose", 'v', "", "", false, "Verbose output."},
                 {"help", 'h', "", "", false, "Display this help message."}};
@@ -386,6 +428,14 @@ int main(int argc, char** argv) {
         std::unique_ptr<AstTranslationUnit> astTranslationUnit =
                 ParserDriver::parseTranslationUnit("<stdin>", in, symTab, errReport, debugReport);
 
+        // facts are translated as clauses, not from the fact tables of the parser, unless the facts
+        // of the tables are converted one at a time
+        if (!Global::config().has("stream")) {
+            for (AstRelation* rel : astTranslationUnit->getProgram()->getRelations()) {
+                rel->materialiseFacts();
+            }
+        }
+
         // close input pipe
         int preprocessor_status = pclose(in);
         if (preprocessor_status == -1) {
@@ -454,8 +504,19 @@ int main(int argc, char** argv) {
         // Toggle pipeline verbosity
         pipeline->setVerbosity(Global::config().has("verbose"));
 
-        // Apply all the transformations
-        pipeline->apply(*astTranslationUnit);
+        // Apply all the transformations, unless the program is converted as parsed
+        if (!Global::config().has("stream")) {
+            pipeline->apply(*astTranslationUnit);
+        } else {
+            const AstProgram& program = *astTranslationUnit->getProgram();
+            if (!program.getComponents().empty() || !program.getComponentInstantiations().empty()) {
+                throw std::runtime_error("components require instantiation, convert without --stream");
+            }
+            if (!program.getOrphanClauses().empty()) {
+                throw std::runtime_error("clause of undeclared relation " +
+                                         toString(program.getOrphanClauses()[0]->getHead()->getName()));
+            }
+        }
 
         try {
             if (Global::config().get("output") == "") {
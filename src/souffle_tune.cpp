@@ -0,0 +1,104 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file souffle_tune.cpp
+ *
+ * Main program of souffle's autotuner
+ *
+ ***********************************************************************/
+
+#include "profile/StringUtils.h"
+#include "profile/Tuner.h"
+
+#include <iostream>
+#include <string>
+#include <getopt.h>
+
+int main(int argc, char* argv[]) {
+    souffle::profile::Tuner::Options options;
+    bool help = false;
+    int c;
+    option longOptions[1];
+    longOptions[0] = {nullptr, 0, nullptr, 0};
+    try {
+        while ((c = getopt_long(argc, argv, "F:s:a:cb:r:n:h", longOptions, nullptr)) != EOF) {
+            switch (c) {
+                case 'F':
+                    options.factDir = optarg;
+                    break;
+                case 's':
+                    options.souffle = optarg;
+                    break;
+                case 'a':
+                    for (const auto& arg : souffle::profile::Tools::split(optarg, " ")) {
+                        if (!arg.empty()) {
+                            options.arguments.push_back(arg);
+                        }
+                    }
+                    break;
+                case 'c':
+                    options.compile = true;
+                    break;
+                case 'b':
+                    options.budget = std::stod(optarg);
+                    break;
+                case 'r':
+                    options.relations = std::stoul(optarg);
+                    break;
+                case 'n':
+                    options.repeats = std::max(1ul, std::stoul(optarg));
+                    break;
+                case 'h':
+                    help = true;
+                    break;
+                default:
+                    exit(1);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument of -" << (char)c << "\n";
+        exit(1);
+    }
+    if (help || optind + 1 != argc) {
+        std::cout << "Souffle Autotuner" << std::endl
+                  << "Usage: souffle-tune [options] <program.dl>" << std::endl
+                  << "-F <dir>              The directory of the sample facts, default ." << std::endl
+                  << "-s <souffle>          The souffle executable, default souffle from the path."
+                  << std::endl
+                  << "-a <arguments>        Further arguments of souffle, separated by spaces." << std::endl
+                  << "-c                    Compile the program for each setting of the pragmas, and time"
+                  << std::endl
+                  << "                      the binary instead of the interpreter." << std::endl
+                  << "-b <seconds>          The time of the search, default 600." << std::endl
+                  << "-r <count>            The number of relations whose representations are varied,"
+                  << std::endl
+                  << "                      those taking the most time first, default 8." << std::endl
+                  << "-n <count>            The runs of each configuration, the fastest of which"
+                  << std::endl
+                  << "                      counts, default 1." << std::endl
+                  << "-h                    Print this help message." << std::endl;
+        exit(help ? 0 : 1);
+    }
+    options.program = argv[optind];
+
+    try {
+        souffle::profile::Tuner tuner(options);
+        auto res = tuner.tune(std::cerr);
+        if (res.second < 0) {
+            return 1;
+        }
+        std::cout << "// the fastest configuration, " << res.second << "s on the sample facts\n";
+        res.first.print(std::cout);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file append_buffer_test.cpp
+ *
+ * A test case testing the concurrent append buffer.
+ *
+ ***********************************************************************/
+
+#include "AppendBuffer.h"
+#include "BTree.h"
+#include "test.h"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+TEST(AppendBuffer, Basic) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    AppendBuffer<2> buffer;
+
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(0, buffer.size());
+    EXPECT_TRUE(buffer.begin() == buffer.end());
+
+    EXPECT_TRUE(buffer.insert({{1, 2}}));
+    EXPECT_TRUE(buffer.insert({{1, 2}}));
+    EXPECT_TRUE(buffer.insert({{0, 5}}));
+
+    // duplicates are retained until the buffer is consolidated
+    EXPECT_FALSE(buffer.empty());
+    EXPECT_EQ(3, buffer.size());
+    std::vector<Tuple> content(buffer.begin(), buffer.end());
+    std::vector<Tuple> expected = {{{1, 2}}, {{1, 2}}, {{0, 5}}};
+    EXPECT_EQ(expected, content);
+
+    buffer.consolidate();
+    EXPECT_EQ(2, buffer.size());
+    content.assign(buffer.begin(), buffer.end());
+    expected = {{{0, 5}}, {{1, 2}}};
+    EXPECT_EQ(expected, content);
+
+    buffer.clear();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_TRUE(buffer.begin() == buffer.end());
+}
+
+TEST(AppendBuffer, Consolidate) {
+    using Tuple = ram::Tuple<RamDomain, 3>;
+    AppendBuffer<3> buffer;
+    std::set<Tuple> ref;
+
+    AppendBuffer<3>::op_context ctxt;
+    for (int i = 0; i < 10000; i++) {
+        Tuple t = {{(i * 7919) % 1000, i % 3, -i % 5}};
+        buffer.insert(t, ctxt);
+        ref.insert(t);
+    }
+    EXPECT_EQ(10000, buffer.size());
+
+    buffer.consolidate();
+    EXPECT_EQ(ref.size(), buffer.size());
+    EXPECT_TRUE(std::equal(ref.begin(), ref.end(), buffer.begin()));
+
+    // the buffer remains usable after being consolidated
+    buffer.insert({{-1, -1, -1}});
+    EXPECT_EQ(ref.size() + 1, buffer.size());
+}
+
+TEST(AppendBuffer, Partition) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    AppendBuffer<2> buffer;
+    EXPECT_TRUE(buffer.partition(10).empty());
+
+    for (int i = 0; i < 10000; i++) {
+        buffer.insert({{i, -i}});
+    }
+
+    // partitions cover all elements in order
+    for (std::size_t num : {1, 7, 40, 400}) {
+        auto parts = buffer.partition(num);
+        EXPECT_FALSE(parts.size() < std::min<std::size_t>(num, 10000 / 256));
+        std::vector<Tuple> content;
+        for (const auto& part : parts) {
+            content.insert(content.end(), part.begin(), part.end());
+        }
+        EXPECT_EQ(10000, content.size());
+        EXPECT_TRUE(std::equal(content.begin(), content.end(), buffer.begin()));
+    }
+}
+
+TEST(AppendBuffer, Parallel) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    AppendBuffer<2> buffer;
+    const int N = 100000;
+
+#pragma omp parallel
+    {
+        AppendBuffer<2>::op_context ctxt;
+#pragma omp for
+        for (int i = 0; i < N; i++) {
+            buffer.insert({{i % 317, i}}, ctxt);
+        }
+    }
+
+    EXPECT_EQ(N, buffer.size());
+    buffer.consolidate();
+    EXPECT_EQ(N, buffer.size());
+
+    std::vector<Tuple> data;
+    for (int i = 0; i < N; i++) {
+        data.push_back({{i % 317, i}});
+    }
+    std::sort(data.begin(), data.end());
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), buffer.begin()));
+}
+
+TEST(AppendBuffer, MergeIntoBTree) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    AppendBuffer<2> buffer;
+    btree_set<Tuple> set;
+    for (int i = 0; i < 1000; i++) {
+        buffer.insert({{i % 10, i / 10}});
+        buffer.insert({{i % 10, i / 10}});
+    }
+    buffer.consolidate();
+
+    btree_set<Tuple>::operation_hints hints;
+    for (const auto& cur : buffer) {
+        EXPECT_TRUE(set.insert(cur, hints));
+    }
+    EXPECT_EQ(1000, set.size());
+}
+
+}  // namespace test
+
+}  // namespace souffle
@@ -0,0 +1,149 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file arrow_io_test.cpp
+ *
+ * Tests the Arrow IPC and Parquet files written and read with IO=arrow and
+ * IO=parquet.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "IODirectives.h"
+#include "ReadStreamArrow.h"
+#include "SymbolTable.h"
+#include "WriteStreamArrow.h"
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+using Rows = std::vector<std::vector<RamDomain>>;
+
+/** A tuple of a written relation */
+struct Entry {
+    const RamDomain* data;
+};
+
+/** A relation collecting the inserted tuples */
+struct Collector {
+    size_t arity;
+    Rows tuples;
+
+    void insert(const RamDomain* tuple) {
+        tuples.emplace_back(tuple, tuple + arity);
+    }
+};
+
+const std::string fileName = "arrow_io_test.data";
+
+IODirectives directives(const std::string& type, std::map<std::string, std::string> extra = {}) {
+    extra["IO"] = type;
+    extra["filename"] = fileName;
+    extra["name"] = "test";
+    return IODirectives(extra);
+}
+
+void write(const std::string& type, const Rows& rows, const std::vector<bool>& mask,
+        const SymbolTable& symbols) {
+    std::vector<Entry> relation;
+    for (const auto& row : rows) {
+        relation.push_back(Entry{row.data()});
+    }
+    std::unique_ptr<WriteStreamFactory> factory;
+    if (type == "parquet") {
+        factory = std::make_unique<WriteParquetFactory>();
+    } else {
+        factory = std::make_unique<WriteArrowFactory>();
+    }
+    factory->getWriter(mask, symbols, directives(type, {{"attributeNames", "x\ty"}}), false)
+            ->writeAll(relation);
+}
+
+Rows read(const std::string& type, const std::vector<bool>& mask, SymbolTable& symbols,
+        std::map<std::string, std::string> extra = {}) {
+    std::unique_ptr<ReadStreamFactory> factory;
+    if (type == "parquet") {
+        factory = std::make_unique<ReadParquetFactory>();
+    } else {
+        factory = std::make_unique<ReadArrowFactory>();
+    }
+    Collector relation{mask.size(), {}};
+    factory->getReader(mask, symbols, directives(type, extra), false)->readAll(relation);
+    return relation.tuples;
+}
+
+TEST(ArrowIO, RoundTrip) {
+    for (const std::string type : {"arrow", "parquet"}) {
+        SymbolTable written;
+        const RamDomain a = written.lookup("a");
+        const RamDomain b = written.lookup("b");
+        write(type, {{1, a}, {-2, b}, {3, a}}, {false, true}, written);
+
+        SymbolTable symbols;
+        symbols.lookup("b");
+        const Rows rows = read(type, {false, true}, symbols);
+        EXPECT_EQ(3, rows.size());
+        EXPECT_EQ(2, symbols.size());
+        EXPECT_EQ(1, rows[0][0]);
+        EXPECT_EQ(-2, rows[1][0]);
+        EXPECT_EQ("a", symbols.resolve(rows[0][1]));
+        EXPECT_EQ("b", symbols.resolve(rows[1][1]));
+        EXPECT_EQ(rows[0][1], rows[2][1]);
+
+        // the columns are selected and reordered by the directive columns
+        const Rows swapped = read(type, {true, false}, symbols, {{"columns", "1:0"}});
+        EXPECT_EQ(3, swapped.size());
+        EXPECT_EQ(rows[1][1], swapped[1][0]);
+        EXPECT_EQ(-2, swapped[1][1]);
+        EXPECT_EQ(Rows({{1}, {-2}, {3}}), read(type, {false}, symbols));
+        std::remove(fileName.c_str());
+    }
+}
+
+TEST(ArrowIO, Nullary) {
+    for (const std::string type : {"arrow", "parquet"}) {
+        SymbolTable symbols;
+        write(type, {{}}, {}, symbols);
+        EXPECT_EQ(1, read(type, {}, symbols).size());
+        write(type, {}, {}, symbols);
+        EXPECT_EQ(0, read(type, {}, symbols).size());
+        std::remove(fileName.c_str());
+    }
+}
+
+TEST(ArrowIO, Mismatch) {
+    for (const std::string type : {"arrow", "parquet"}) {
+        SymbolTable symbols;
+        write(type, {{1, symbols.lookup("a")}}, {false, true}, symbols);
+        auto fails = [&](const std::vector<bool>& mask, std::map<std::string, std::string> extra) {
+            try {
+                read(type, mask, symbols, extra);
+            } catch (std::invalid_argument&) {
+                return true;
+            }
+            return false;
+        };
+        EXPECT_FALSE(fails({false, true}, {}));
+        EXPECT_TRUE(fails({true, true}, {}));
+        EXPECT_TRUE(fails({false, false}, {}));
+        EXPECT_TRUE(fails({false, false, false}, {}));
+        EXPECT_TRUE(fails({false}, {{"columns", "2"}}));
+        std::remove(fileName.c_str());
+        EXPECT_TRUE(fails({false, true}, {}));
+    }
+}
+
+}  // end namespace test
@@ -56,5 +56,37 @@ TEST(AstProgram, Parse) {
     EXPECT_FALSE(prog->getProgram()->getRelation("n"));
 }
 
+TEST(AstProgram, FactTable) {
+    SymbolTable sym;
+    ErrorReport e;
+    DebugReport d;
+
+    // many facts of a relation go into its fact table, facts not matching its types remain clauses
+    std::string code = ".type Node\n.decl e(a:number, b:Node)\n.decl f(a:number)\nf(1).\nf(2).\n";
+    for (int i = 0; i < 1000; i++) {
+        code += "e(" + std::to_string(i) + ",\"n" + std::to_string(i) + "\").\n";
+    }
+    code += "e(\"n\",1).\n";
+    std::unique_ptr<AstTranslationUnit> prog = ParserDriver::parseTranslationUnit(code, sym, e, d);
+
+    const AstRelation* rel = prog->getProgram()->getRelation("e");
+    ASSERT_TRUE(rel);
+    ASSERT_TRUE(rel->getFactTable());
+    EXPECT_EQ(1001, rel->clauseSize() + rel->getFactTable()->size());
+    EXPECT_EQ(999, (*rel->getFactTable())[rel->getFactTable()->size() - 1][0]);
+    EXPECT_EQ("n999", sym.resolve((*rel->getFactTable())[rel->getFactTable()->size() - 1][1]));
+    EXPECT_EQ("e(\"n\",1).", toString(*rel->getClause(rel->clauseSize() - 1)));
+
+    // relations of few facts keep them as clauses
+    EXPECT_FALSE(prog->getProgram()->getRelation("f")->getFactTable());
+    EXPECT_EQ(2, prog->getProgram()->getRelation("f")->clauseSize());
+
+    // cloned programs keep the facts
+    std::unique_ptr<AstProgram> clone(prog->getProgram()->clone());
+    EXPECT_EQ(*clone, *prog->getProgram());
+    clone->getRelation("e")->materialiseFacts();
+    EXPECT_EQ(1001, clone->getRelation("e")->clauseSize());
+}
+
 }  // end namespace test
 }  // end namespace souffle
@@ -501,5 +501,41 @@ TEST(AstUtils, RemoveRelationCopiesOutput) {
     EXPECT_EQ(3, program.getRelations().size());
 }
 
+TEST(AstUtils, ProjectDeadColumns) {
+    SymbolTable sym;
+    ErrorReport e;
+    DebugReport d;
+    // load some test program
+    std::unique_ptr<AstTranslationUnit> tu = ParserDriver::parseTranslationUnit(
+            R"(
+                .decl c(a:number,b:number) input
+                .decl b(a:number,b:number,c:number)
+                .decl s(a:number,b:number)
+                .decl a(a:number) output
+                .decl n(a:number) output
+
+                b(x,y,z) :- c(x,y), c(y,z).
+                a(x) :- b(x,y,_), y > 1.
+                s(x,y) :- c(x,y).
+                n(k) :- k = count : s(_,_).
+            )",
+            sym, e, d);
+
+    AstProgram& program = *tu->getProgram();
+
+    EXPECT_TRUE(std::make_unique<ProjectDeadColumnsTransformer>()->apply(*tu));
+
+    // the last column of b is never read
+    EXPECT_EQ(2, program.getRelation("b")->getArity());
+    EXPECT_EQ("b(x,y) :- \n   c(x,y),\n   c(y,z).", toString(*program.getRelation("b")->getClause(0)));
+
+    // the tuples of s are counted, and those of input and output relations kept
+    EXPECT_EQ(2, program.getRelation("s")->getArity());
+    EXPECT_EQ(2, program.getRelation("c")->getArity());
+    EXPECT_EQ(1, program.getRelation("a")->getArity());
+
+    EXPECT_FALSE(std::make_unique<ProjectDeadColumnsTransformer>()->apply(*tu));
+}
+
 }  // end namespace test
 }  // end namespace souffle
@@ -0,0 +1,184 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file binary_io_test.cpp
+ *
+ * Tests the binary fact files written and read with IO=binary.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "IODirectives.h"
+#include "ReadStreamBinary.h"
+#include "SymbolTable.h"
+#include "WriteStreamBinary.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+using Rows = std::vector<std::vector<RamDomain>>;
+
+/** A tuple of a written relation */
+struct Entry {
+    const RamDomain* data;
+};
+
+/** A relation collecting the inserted tuples */
+struct Collector {
+    size_t arity;
+    Rows tuples;
+
+    void insert(const RamDomain* tuple) {
+        tuples.emplace_back(tuple, tuple + arity);
+    }
+};
+
+const std::string fileName = "binary_io_test.bin";
+
+IODirectives directives() {
+    IODirectives ioDirectives;
+    ioDirectives.setIOType("binary");
+    ioDirectives.setFileName(fileName);
+    ioDirectives.setRelationName("test");
+    return ioDirectives;
+}
+
+/** Writes the given rows, symbols given as indices into the symbol table */
+void write(const Rows& rows, const std::vector<bool>& mask, const SymbolTable& symbols) {
+    std::vector<Entry> relation;
+    for (const auto& row : rows) {
+        relation.push_back(Entry{row.data()});
+    }
+    WriteFileBinaryFactory().getWriter(mask, symbols, directives(), false)->writeAll(relation);
+}
+
+/** Reads the rows of the written file */
+Rows read(const std::vector<bool>& mask, SymbolTable& symbols) {
+    Collector relation{mask.size(), {}};
+    ReadFileBinaryFactory().getReader(mask, symbols, directives(), false)->readAll(relation);
+    return relation.tuples;
+}
+
+TEST(BinaryIO, Numbers) {
+    const Rows rows = {{1, 2, 3}, {-4, 5, 2147483647}, {0, -2147483647 - 1, 7}};
+    SymbolTable symbols;
+    write(rows, {false, false, false}, symbols);
+    EXPECT_EQ(rows, read({false, false, false}, symbols));
+    EXPECT_EQ(0, symbols.size());
+
+    // the columns are padded to the alignment of the file
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    EXPECT_EQ(0, static_cast<size_t>(file.tellg()) % 8);
+
+    write({}, {false, false, false}, symbols);
+    EXPECT_EQ(Rows(), read({false, false, false}, symbols));
+    std::remove(fileName.c_str());
+}
+
+TEST(BinaryIO, Symbols) {
+    SymbolTable written;
+    const RamDomain a = written.lookup("a");
+    const RamDomain b = written.lookup("");
+    const RamDomain c = written.lookup("a longer symbol, with\ttabs");
+    write({{a, 1, b}, {a, 2, c}, {c, 3, c}}, {true, false, true}, written);
+
+    // the symbols are interned into the table of the reader, which may differ
+    SymbolTable symbols;
+    symbols.lookup("x");
+    const Rows rows = read({true, false, true}, symbols);
+    EXPECT_EQ(4, symbols.size());
+    EXPECT_EQ(3, rows.size());
+    EXPECT_EQ("a", symbols.resolve(rows[0][0]));
+    EXPECT_EQ("", symbols.resolve(rows[0][2]));
+    EXPECT_EQ("a longer symbol, with\ttabs", symbols.resolve(rows[1][2]));
+    EXPECT_EQ(rows[1][2], rows[2][0]);
+    EXPECT_EQ(3, rows[2][1]);
+    std::remove(fileName.c_str());
+}
+
+TEST(BinaryIO, Indices) {
+    const std::string dictionary = fileName + ".symbols";
+    SymbolTable written;
+    const RamDomain a = written.lookup("a");
+    const RamDomain b = written.lookup("b");
+    written.save(dictionary);
+    IODirectives ioDirectives = directives();
+    ioDirectives.set("symbols", "indices");
+    const std::vector<RamDomain> tuple = {b, 1};
+    std::vector<Entry> relation = {Entry{tuple.data()}};
+    WriteFileBinaryFactory().getWriter({true, false}, written, ioDirectives, false)->writeAll(relation);
+
+    // the indices are taken as they are by a reader sharing the dictionary of the writer
+    SymbolTable symbols = SymbolTable::load(dictionary);
+    const Rows rows = read({true, false}, symbols);
+    EXPECT_EQ(2, symbols.size());
+    EXPECT_EQ(1, rows.size());
+    EXPECT_EQ("b", symbols.resolve(rows[0][0]));
+    EXPECT_EQ(a, symbols.lookup("a"));
+
+    // but rejected if they are missing from the table of the reader
+    SymbolTable other;
+    bool rejected = false;
+    try {
+        read({true, false}, other);
+    } catch (std::invalid_argument&) {
+        rejected = true;
+    }
+    EXPECT_TRUE(rejected);
+    std::remove(fileName.c_str());
+    std::remove(dictionary.c_str());
+}
+
+TEST(BinaryIO, Nullary) {
+    SymbolTable symbols;
+    write({{}}, {}, symbols);
+    EXPECT_EQ(1, read({}, symbols).size());
+    write({}, {}, symbols);
+    EXPECT_EQ(0, read({}, symbols).size());
+    std::remove(fileName.c_str());
+}
+
+TEST(BinaryIO, Mismatch) {
+    SymbolTable symbols;
+    write({{1, 2}}, {false, false}, symbols);
+    auto fails = [&](const std::vector<bool>& mask) {
+        try {
+            read(mask, symbols);
+        } catch (std::invalid_argument&) {
+            return true;
+        }
+        return false;
+    };
+    EXPECT_FALSE(fails({false, false}));
+    EXPECT_TRUE(fails({false, false, false}));
+    EXPECT_TRUE(fails({false, true}));
+
+    // truncated and foreign files
+    {
+        std::ofstream out(fileName, std::ios::binary | std::ios::app);
+        out << "x";
+    }
+    EXPECT_TRUE(fails({false, false}));
+    {
+        std::ofstream out(fileName, std::ios::binary);
+        out << "1\t2\n";
+    }
+    EXPECT_TRUE(fails({false, false}));
+    std::remove(fileName.c_str());
+    EXPECT_TRUE(fails({false, false}));
+}
+
+}  // end namespace test
@@ -512,6 +512,106 @@ TEST(EqRelTest, IterPartition) {
     EXPECT_EQ(br.size(), values.size());
 }
 
+TEST(EqRelTest, IncrementalCache) {
+    // the cached sets have to follow unions between iterations
+    EqRel br;
+    const RamDomain N = 300;
+    std::vector<RamDomain> setOf(N, -1);
+
+    std::srand(7);
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 15; ++i) {
+            RamDomain a = std::rand() % N;
+            RamDomain b = (round % 4 == 0) ? a : std::rand() % N;
+            br.insert(a, b);
+
+            // maintain reference sets, the class of an element is identified by a member
+            if (setOf[a] == -1) setOf[a] = a;
+            if (setOf[b] == -1) setOf[b] = b;
+            RamDomain from = setOf[b];
+            for (auto& cur : setOf) {
+                if (cur == from) cur = setOf[a];
+            }
+        }
+
+        std::set<std::pair<RamDomain, RamDomain>> expected;
+        for (RamDomain x = 0; x < N; ++x) {
+            for (RamDomain y = 0; y < N; ++y) {
+                if (setOf[x] != -1 && setOf[x] == setOf[y]) expected.insert(std::make_pair(x, y));
+            }
+        }
+
+        std::set<std::pair<RamDomain, RamDomain>> actual;
+        for (const auto& cur : br) {
+            actual.insert(std::make_pair(cur[0], cur[1]));
+        }
+        EXPECT_EQ(expected.size(), br.size());
+        EXPECT_TRUE(expected == actual);
+
+        // partitions cover all pairs exactly once
+        std::vector<std::pair<RamDomain, RamDomain>> parts;
+        for (auto chunk : br.partition(8)) {
+            for (const auto& cur : chunk) {
+                parts.push_back(std::make_pair(cur[0], cur[1]));
+            }
+        }
+        std::set<std::pair<RamDomain, RamDomain>> covered(parts.begin(), parts.end());
+        EXPECT_EQ(expected.size(), parts.size());
+        EXPECT_TRUE(expected == covered);
+    }
+}
+
+TEST(EqRelTest, Classes) {
+    // classes {0..9}, {10, 12, 14}, {20}, joined incrementally
+    EqRel br;
+    for (RamDomain i = 1; i < 10; ++i) {
+        br.insert(0, i);
+    }
+    br.insert(10, 12);
+    br.insert(14, 12);
+    br.insert(20, 20);
+
+    EXPECT_EQ(10, br.getClassSize(3));
+    EXPECT_EQ(3, br.getClassSize(14));
+    EXPECT_EQ(1, br.getClassSize(20));
+    EXPECT_EQ(0, br.getClassSize(11));
+    EXPECT_EQ(br.getRepresentative(12), br.getRepresentative(10));
+    EXPECT_NE(br.getRepresentative(12), br.getRepresentative(20));
+
+    std::set<RamDomain> members;
+    for (RamDomain x : br.getClass(14)) {
+        members.insert(x);
+    }
+    EXPECT_EQ((std::set<RamDomain>{10, 12, 14}), members);
+    EXPECT_EQ(0, br.getClass(11).size());
+
+    // counts agree with iterating through the pairs
+    EXPECT_EQ(br.size(), br.countBoundaries<0>({{0, 0}}));
+    EXPECT_EQ(10, br.countBoundaries<1>({{7, 0}}));
+    EXPECT_EQ(1, br.countBoundaries<2>({{7, 2}}));
+    EXPECT_EQ(0, br.countBoundaries<2>({{7, 12}}));
+
+    // each class is visited once, with all of its members
+    br.insert(9, 20);
+    std::vector<size_t> sizes;
+    std::set<RamDomain> all;
+    for (const auto& cls : br.classes()) {
+        sizes.push_back(cls.size());
+        all.insert(cls.begin(), cls.end());
+    }
+    std::sort(sizes.begin(), sizes.end());
+    EXPECT_EQ((std::vector<size_t>{3, 11}), sizes);
+    EXPECT_EQ(14, all.size());
+
+    size_t covered = 0;
+    for (const auto& chunk : br.partitionClasses(4)) {
+        for (const auto& cls : chunk) {
+            covered += cls.size();
+        }
+    }
+    EXPECT_EQ(14, covered);
+}
+
 TEST(EqRelTest, Scaling) {
     const int N = 100;
 
@@ -523,6 +623,38 @@ TEST(EqRelTest, Scaling) {
     EXPECT_EQ(N, br.size());
 }
 
+TEST(EqRelTest, LargeMerge) {
+    // large enough to extend, merge and regenerate the cache in parallel
+    const int N = 100000;
+    const int K = 100;
+
+    // old knowledge: the elements below N by their remainder modulo K
+    EqRel old;
+    for (int i = 0; i < N; ++i) {
+        old.insert(i, i % K);
+    }
+    EXPECT_EQ(size_t(K) * (N / K) * (N / K), old.size());
+
+    // new knowledge: a new element for each of the first half of the classes, and a new class
+    EqRel fresh;
+    for (int j = 0; j < K / 2; ++j) {
+        fresh.insert(N + j, j);
+    }
+    fresh.insert(2 * N, 2 * N + 1);
+
+    fresh.extend(old);
+    const size_t grown = N / K + 1;
+    EXPECT_EQ(size_t(K / 2) * grown * grown + 4, fresh.size());
+    EXPECT_TRUE(fresh.contains(N + 1, K + 1));
+    EXPECT_FALSE(fresh.contains(K / 2, K / 2));
+
+    old.insertAll(fresh);
+    EXPECT_EQ(size_t(K / 2) * grown * grown + size_t(K / 2) * (N / K) * (N / K) + 4, old.size());
+    EXPECT_TRUE(old.contains(N + 3, 3 + 5 * K));
+    EXPECT_TRUE(old.contains(2 * N + 1, 2 * N));
+    EXPECT_FALSE(old.contains(N, 1));
+}
+
 #ifdef _OPENMP
 TEST(EqRelTest, ParallelScaling) {
     // use OpenMP this time
@@ -0,0 +1,162 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file bitmap_set_test.cpp
+ *
+ * A test case testing the set of pairs stored in compressed bitmaps.
+ *
+ ***********************************************************************/
+
+#include "BitmapSet.h"
+#include "test.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+using Tuple = ram::Tuple<RamDomain, 2>;
+
+TEST(BitmapSet, Basic) {
+    BitmapSet<2> set;
+
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(0, set.size());
+    EXPECT_TRUE(set.begin() == set.end());
+    EXPECT_FALSE(set.contains({{1, 2}}));
+
+    EXPECT_TRUE(set.insert({{1, 2}}));
+    EXPECT_FALSE(set.insert({{1, 2}}));
+    set.insert({{1, 3}});
+    set.insert({{0, 5}});
+    set.insert({{-4, 7}});
+    set.insert({{1, -70000}});
+
+    EXPECT_FALSE(set.empty());
+    EXPECT_EQ(5, set.size());
+    EXPECT_TRUE(set.contains({{1, 2}}));
+    EXPECT_TRUE(set.contains({{-4, 7}}));
+    EXPECT_TRUE(set.contains({{1, -70000}}));
+    EXPECT_FALSE(set.contains({{1, 4}}));
+    EXPECT_FALSE(set.contains({{-5, 7}}));
+
+    std::vector<Tuple> content(set.begin(), set.end());
+    std::vector<Tuple> expected = {{{-4, 7}}, {{0, 5}}, {{1, -70000}}, {{1, 2}}, {{1, 3}}};
+    EXPECT_EQ(expected, content);
+
+    EXPECT_EQ(Tuple({{0, 5}}), *set.find({{0, 5}}));
+    EXPECT_TRUE(set.find({{0, 6}}) == set.end());
+    EXPECT_EQ(Tuple({{1, 2}}), *set.lower_bound({{1, 0}}));
+    EXPECT_EQ(Tuple({{1, 3}}), *set.upper_bound({{1, 2}}));
+    EXPECT_TRUE(set.upper_bound({{1, 3}}) == set.end());
+
+    auto range = set.getBoundaries<1>({{1, 0}});
+    EXPECT_EQ(3, std::distance(range.begin(), range.end()));
+    EXPECT_EQ(Tuple({{1, -70000}}), *range.begin());
+    EXPECT_EQ(5, std::distance(set.getBoundaries<0>({{1, 0}}).begin(), set.end()));
+    auto point = set.getBoundaries<2>({{0, 5}});
+    EXPECT_EQ(1, std::distance(point.begin(), point.end()));
+    EXPECT_TRUE(set.getBoundaries<1>({{2, 0}}).empty());
+
+    BitmapSet<2>::op_context ctxt;
+    EXPECT_EQ(5, set.countBoundaries<0>({{0, 0}}, ctxt));
+    EXPECT_EQ(3, set.countBoundaries<1>({{1, 0}}, ctxt));
+    EXPECT_EQ(1, set.countBoundaries<2>({{1, 3}}, ctxt));
+    EXPECT_EQ(0, set.countBoundaries<2>({{1, 4}}, ctxt));
+    EXPECT_EQ(0, set.countBoundaries<1>({{2, 0}}, ctxt));
+
+    set.clear();
+    EXPECT_TRUE(set.empty());
+    EXPECT_TRUE(set.begin() == set.end());
+}
+
+TEST(BitmapSet, Dense) {
+    // rows turning into bitmaps, spread over several pages
+    BitmapSet<2> set;
+    std::set<Tuple> reference;
+    srand(3);
+    for (int i = 0; i < 100000; i++) {
+        Tuple t({{rand() % 10000 - 5000, rand() % 10000}});
+        EXPECT_EQ(reference.insert(t).second, set.insert(t));
+    }
+    for (RamDomain i = 0; i < 20000; i += 3) {
+        Tuple t({{42, i}});
+        EXPECT_EQ(reference.insert(t).second, set.insert(t));
+    }
+    EXPECT_EQ(reference.size(), set.size());
+    EXPECT_TRUE(std::equal(reference.begin(), reference.end(), set.begin()));
+
+    BitmapSet<2>::op_context ctxt;
+    for (RamDomain first : {-5000, -15, 0, 42, 982, 4999, 5000}) {
+        Tuple low({{first, MIN_RAM_DOMAIN}});
+        Tuple high({{first, MAX_RAM_DOMAIN}});
+        size_t expected = std::distance(reference.lower_bound(low), reference.upper_bound(high));
+        auto range = set.getBoundaries<1>(low, ctxt);
+        EXPECT_EQ(expected, std::distance(range.begin(), range.end()));
+        EXPECT_EQ(expected, set.countBoundaries<1>(low, ctxt));
+        EXPECT_EQ(expected, set.countRange(range.begin(), range.end()));
+    }
+    EXPECT_EQ(set.size(), set.countRange(set.begin(), set.end()));
+}
+
+TEST(BitmapSet, InsertAll) {
+    BitmapSet<2> a;
+    BitmapSet<2> b;
+    std::set<Tuple> reference;
+    for (RamDomain i = 0; i < 20000; i++) {
+        Tuple x({{i % 7, i}});
+        Tuple y({{i % 5, 3 * i}});
+        a.insert(x);
+        b.insert(y);
+        reference.insert(x);
+        reference.insert(y);
+    }
+    a.insertAll(b);
+    EXPECT_EQ(reference.size(), a.size());
+    EXPECT_TRUE(std::equal(reference.begin(), reference.end(), a.begin()));
+}
+
+TEST(BitmapSet, Partition) {
+    BitmapSet<2> set;
+    for (RamDomain i = 0; i < 10000; i++) {
+        set.insert({{i % 500, i}});
+    }
+    auto chunks = set.partition(16);
+    EXPECT_LT(1, chunks.size());
+    std::vector<Tuple> content;
+    for (const auto& chunk : chunks) {
+        content.insert(content.end(), chunk.begin(), chunk.end());
+    }
+    EXPECT_EQ(set.size(), content.size());
+    EXPECT_TRUE(std::equal(content.begin(), content.end(), set.begin()));
+}
+
+TEST(BitmapSet, ParallelInsert) {
+    BitmapSet<2> set;
+    const int n = 100000;
+#pragma omp parallel for
+    for (int i = 0; i < n; i++) {
+        BitmapSet<2>::op_context ctxt;
+        set.insert({{i % 100, i / 100}}, ctxt);
+        set.insert({{i % 100, i / 100}}, ctxt);
+    }
+    EXPECT_EQ(n, set.size());
+    for (int i = 0; i < n; i += 37) {
+        EXPECT_TRUE(set.contains({{i % 100, i / 100}}));
+    }
+}
+
+}  // end namespace test
+
+}  // end namespace souffle
@@ -324,18 +324,25 @@ TEST(SparseArray, MemoryUsage) {
         // EXPECT_EQ(56, a.getMemoryUsage());
         EXPECT_EQ(40, a.getMemoryUsage());
 
-        // a single element should have the same size as an empty one
+        // a single element requires a single compact node
         a.update(12, 15);
         EXPECT_FALSE(a.empty());
         // EXPECT_EQ(56, a.getMemoryUsage());
-        EXPECT_EQ(560, a.getMemoryUsage());
+        EXPECT_EQ(104, a.getMemoryUsage());
 
-        // more than one => there are nodes
+        // more than one => they share the node
         a.update(14, 18);
         EXPECT_FALSE(a.empty());
 
         // EXPECT_EQ(576, a.getMemoryUsage());
-        EXPECT_EQ(560, a.getMemoryUsage());
+        EXPECT_EQ(104, a.getMemoryUsage());
+
+        // once the slots of the node are exhausted, the full array of cells is added
+        a.update(16, 1);
+        a.update(18, 2);
+        EXPECT_EQ(104, a.getMemoryUsage());
+        a.update(20, 3);
+        EXPECT_EQ(632, a.getMemoryUsage());
     } else {
         SparseArray<int> a;
 
@@ -343,15 +350,15 @@ TEST(SparseArray, MemoryUsage) {
         EXPECT_TRUE(a.empty());
         EXPECT_EQ(28, a.getMemoryUsage());
 
-        // a single element should have the same size as an empty one
+        // a single element requires a single compact node
         a.update(12, 15);
         EXPECT_FALSE(a.empty());
-        EXPECT_EQ(288, a.getMemoryUsage());
+        EXPECT_EQ(60, a.getMemoryUsage());
 
-        // more than one => there are nodes
+        // more than one => they share the node
         a.update(14, 18);
         EXPECT_FALSE(a.empty());
-        EXPECT_EQ(288, a.getMemoryUsage());
+        EXPECT_EQ(60, a.getMemoryUsage());
     }
 }
 
@@ -1180,6 +1187,124 @@ TEST(Trie, Merge_Bug) {
     EXPECT_EQ(5, count);
 }
 
+TEST(Trie, Absorb_1D) {
+    Trie<1> a;
+    Trie<1> b;
+    std::set<RamDomain> ref;
+    for (RamDomain i = 0; i < 10000; i += 3) {
+        a.insert(i);
+        ref.insert(i);
+    }
+    for (RamDomain i = -5000; i < 50000; i += 7) {
+        b.insert(i);
+        ref.insert(i);
+    }
+
+    a.absorb(b);
+    EXPECT_TRUE(b.empty());
+    EXPECT_EQ(ref.size(), a.size());
+
+    std::set<RamDomain> is;
+    for (const auto& cur : a) {
+        is.insert(cur[0]);
+    }
+    EXPECT_EQ(ref, is);
+}
+
+TEST(Trie, Absorb_Stress) {
+    using entry_t = typename Trie<3>::entry_type;
+
+    const int N = 1000;
+    const int M = 50;
+
+    std::set<entry_t> ref;
+    Trie<3> a;
+
+    for (int i = 0; i < M; i++) {
+        // both overlapping and disjoint sub-tries
+        Trie<3> b;
+        for (int j = 0; j < N; j++) {
+            RamDomain x = rand() % (N * (i % 3 + 1));
+            RamDomain y = rand() % N;
+            RamDomain z = rand() % 10;
+            b.insert(x, y, z);
+            ref.insert(entry_t({{x, y, z}}));
+        }
+
+        a.absorb(b);
+        EXPECT_TRUE(b.empty());
+        EXPECT_TRUE(b.begin() == b.end());
+
+        std::set<entry_t> is(a.begin(), a.end());
+        EXPECT_EQ(ref, is);
+    }
+
+    // an absorbed trie may be filled and absorbed again
+    Trie<3> c;
+    c.insert(-1, -1, -1);
+    a.absorb(c);
+    c.insert(-2, -2, -2);
+    a.absorb(c);
+    EXPECT_EQ(ref.size() + 2, a.size());
+    EXPECT_TRUE(a.contains(-2, -2, -2));
+
+    // an empty trie takes over the other one
+    Trie<3> d;
+    d.absorb(a);
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(ref.size() + 2, d.size());
+}
+
+TEST(Trie, Load_1D) {
+    using entry_t = typename Trie<1>::entry_type;
+
+    std::vector<entry_t> entries;
+    for (RamDomain i = -200; i < 1000; i += (i % 7) + 1) {
+        entries.push_back(entry_t({{i}}));
+    }
+    std::sort(entries.begin(), entries.end());
+
+    Trie<1> a;
+    a.insert(5);
+    a.insert(100000);
+    a.load(entries.begin(), entries.end());
+
+    std::set<entry_t> ref(entries.begin(), entries.end());
+    ref.insert(entry_t({{5}}));
+    ref.insert(entry_t({{100000}}));
+    std::set<entry_t> is(a.begin(), a.end());
+    EXPECT_EQ(ref, is);
+    EXPECT_EQ(ref.size(), a.size());
+}
+
+TEST(Trie, Load_3D) {
+    using entry_t = typename Trie<3>::entry_type;
+
+    // enough entries to load the groups in parallel
+    std::set<entry_t> ref;
+    for (int i = 0; i < 50000; i++) {
+        ref.insert(entry_t({{rand() % 100 - 50, rand() % 1000, rand() % 100}}));
+    }
+    std::vector<entry_t> entries(ref.begin(), ref.end());
+
+    // loading into a non-empty trie keeps its entries
+    Trie<3> a;
+    for (int i = 0; i < 1000; i++) {
+        entry_t cur({{rand() % 100, rand() % 10, rand() % 10}});
+        a.insert(cur);
+        ref.insert(cur);
+    }
+    a.load(entries.begin(), entries.end());
+
+    std::set<entry_t> is(a.begin(), a.end());
+    EXPECT_EQ(ref, is);
+    EXPECT_EQ(ref.size(), a.size());
+
+    // loading an empty range changes nothing
+    a.load(entries.end(), entries.end());
+    EXPECT_EQ(ref.size(), a.size());
+}
+
 TEST(Trie, Size) {
     Trie<2> t;
 
@@ -1310,3 +1435,54 @@ TEST(Trie, Parallel) {
         EXPECT_EQ(should, is);
     }
 }
+
+TEST(Trie, InsertBuffer) {
+    const int N = 10000;
+    using entry_t = typename Trie<2>::entry_type;
+
+    // an inactive buffer does not refer to any trie
+    TrieInsertBuffer<Trie<2>> none;
+    EXPECT_FALSE(none.isActive());
+
+    Trie<2> res;
+    res.insert(entry_t({{0, 0}}));
+    {
+        TrieInsertBuffer<Trie<2>> buffer(res);
+        EXPECT_TRUE(buffer.isActive());
+        EXPECT_TRUE(buffer.insert(entry_t({{1, 2}})));
+        EXPECT_FALSE(buffer.insert(entry_t({{1, 2}})));
+
+        // buffered elements are not visible before flushing
+        EXPECT_EQ(1, res.size());
+        buffer.flush();
+        EXPECT_EQ(2, res.size());
+        EXPECT_TRUE(res.contains(entry_t({{1, 2}})));
+
+        EXPECT_TRUE(buffer.insert(entry_t({{3, 4}})));
+    }
+    // buffers are flushed on destruction
+    EXPECT_EQ(3, res.size());
+    EXPECT_TRUE(res.contains(entry_t({{3, 4}})));
+
+    // fill a trie from multiple threads, each using its own buffer
+    std::vector<entry_t> full;
+    for (int i = 0; i < 3 * N; i++) {
+        full.push_back(entry_t({{(RamDomain)(i % N) / 100, (RamDomain)(i % N)}}));
+    }
+    std::random_shuffle(full.begin(), full.end());
+
+    Trie<2> par;
+#pragma omp parallel
+    {
+        TrieInsertBuffer<Trie<2>> buffer(par);
+#pragma omp for
+        for (auto it = full.begin(); it < full.end(); ++it) {
+            buffer.insert(*it);
+        }
+    }
+
+    EXPECT_EQ(N, par.size());
+    std::set<entry_t> should(full.begin(), full.end());
+    std::set<entry_t> is(par.begin(), par.end());
+    EXPECT_EQ(should, is);
+}
@@ -355,6 +355,56 @@ TEST(BTreeMultiSet, Load) {
     }
 }
 
+TEST(BTreeMultiSet, Merge) {
+    using test_set = btree_multiset<int, detail::comparator<int>, std::allocator<int>, 64>;
+
+    test_set a;
+    test_set b;
+    std::multiset<int> ref;
+    for (int i = 0; i < 10000; i++) {
+        a.insert(i % 100);
+        ref.insert(i % 100);
+        b.insert(i % 150);
+        ref.insert(i % 150);
+    }
+
+    a.merge(b);
+    EXPECT_TRUE(a.check());
+    EXPECT_EQ(ref.size(), a.size());
+    EXPECT_TRUE(std::equal(ref.begin(), ref.end(), a.begin()));
+}
+
+TEST(BTreeMultiSet, CountRange) {
+    using test_set = btree_multiset<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    test_set t;
+    std::multiset<int> ref;
+    EXPECT_EQ(0, t.countRange(t.begin(), t.end()));
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 2000; i++) {
+            int x = (i * 7919 + round) % 300;
+            t.insert(x);
+            ref.insert(x);
+        }
+
+        // counts are recounted after the tree has been modified
+        for (int a = -5; a < 310; a += 3) {
+            for (int b = a; b < a + 40; b += 7) {
+                auto expected = std::distance(ref.lower_bound(a), ref.upper_bound(b));
+                EXPECT_EQ(expected, t.countRange(t.lower_bound(a), t.upper_bound(b)));
+            }
+        }
+        EXPECT_EQ(ref.size(), t.countRange(t.begin(), t.end()));
+        EXPECT_EQ(ref.size(), t.size());
+    }
+
+    t.clear();
+    EXPECT_EQ(0, t.countRange(t.begin(), t.end()));
+    t.insert(1);
+    EXPECT_EQ(1, t.countRange(t.begin(), t.end()));
+}
+
 TEST(BTreeMultiSet, Clear) {
     using test_set = btree_multiset<int, detail::comparator<int>, std::allocator<int>, 16>;
 
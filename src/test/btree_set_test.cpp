@@ -15,6 +15,8 @@
  ***********************************************************************/
 
 #include "BTree.h"
+#include "CompiledIndexUtils.h"
+#include "CompiledTuple.h"
 #include "test.h"
 
 #include <algorithm>
@@ -22,6 +24,7 @@
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <tuple>
 #include <unordered_set>
@@ -330,6 +333,87 @@ TEST(BTreeSet, Merge) {
     EXPECT_EQ(c, d);
 }
 
+TEST(BTreeSet, MergeLarge) {
+    using test_set = btree_set<int, detail::comparator<int>, btree_node_pool, 64>;
+
+    for (int n : {0, 1, 100, 10000}) {
+        for (int m : {0, 1, 100, 10000}) {
+            test_set a;
+            test_set b;
+            std::set<int> ref;
+            for (int i = 0; i < n; i++) {
+                a.insert(3 * i);
+                ref.insert(3 * i);
+            }
+            for (int i = 0; i < m; i++) {
+                b.insert(2 * i);
+                ref.insert(2 * i);
+            }
+
+            a.merge(b);
+            EXPECT_TRUE(a.check());
+            EXPECT_EQ(ref.size(), a.size());
+            EXPECT_TRUE(std::equal(ref.begin(), ref.end(), a.begin()));
+
+            // the merged tree remains a fully functional tree
+            a.insert(-1);
+            EXPECT_TRUE(a.contains(-1));
+            EXPECT_TRUE(a.check());
+        }
+    }
+}
+
+TEST(BTreeSet, Reset) {
+    using pool_set = btree_set<int, detail::comparator<int>, btree_node_pool, 64>;
+    using plain_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 64>;
+    pool_set a;
+    plain_set b;
+
+    // the trees are filled again from scratch after each reset
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 10000; i++) {
+            a.insert((i * 7919 + round) % 10007);
+            b.insert((i * 7919 + round) % 10007);
+        }
+        EXPECT_TRUE(a.check());
+        EXPECT_EQ(10000, a.size());
+        EXPECT_EQ(10000, b.size());
+        EXPECT_TRUE(std::equal(a.begin(), a.end(), b.begin()));
+
+        a.reset();
+        b.reset();
+        EXPECT_TRUE(a.empty());
+        EXPECT_TRUE(b.empty());
+        EXPECT_EQ(a.begin(), a.end());
+        EXPECT_FALSE(a.contains(round));
+    }
+}
+
+TEST(BTreeSet, Reserve) {
+    using pool_set = btree_set<int, detail::comparator<int>, btree_node_pool, 64>;
+    using plain_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 64>;
+    pool_set a;
+    plain_set b;
+
+    // the nodes of the pool are obtained in advance, the hint is ignored without a pool
+    a.reserve(100000);
+    b.reserve(100000);
+    EXPECT_TRUE(a.empty());
+    EXPECT_TRUE(b.empty());
+    for (int i = 0; i < 100000; i++) {
+        a.insert((i * 7919) % 100003);
+        b.insert((i * 7919) % 100003);
+    }
+    EXPECT_TRUE(a.check());
+    EXPECT_EQ(100000, a.size());
+    EXPECT_TRUE(std::equal(a.begin(), a.end(), b.begin()));
+
+    a.clear();
+    EXPECT_TRUE(a.empty());
+    a.insert(1);
+    EXPECT_EQ(1, a.size());
+}
+
 TEST(BTreeSet, IteratorEmpty) {
     using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
     test_set t;
@@ -450,6 +534,37 @@ TEST(BTreeSet, BoundaryEmpty) {
     EXPECT_NE(t.lower_bound(5), t.upper_bound(5));
 }
 
+TEST(BTreeSet, BatchedLowerBounds) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    test_set t;
+    std::vector<int> keys;
+    std::vector<test_set::iterator> res(keys.size());
+    t.lower_bounds(keys.data(), 0, res.data());
+
+    // probes of an empty tree end, any batch size
+    keys = {3, 1, 4};
+    res.resize(keys.size());
+    t.lower_bounds(keys.data(), keys.size(), res.data());
+    for (const auto& pos : res) {
+        EXPECT_EQ(t.end(), pos);
+    }
+
+    // the even numbers, probed by all numbers of the range and beyond, in several batches
+    for (int i = 0; i < 1000; i += 2) {
+        t.insert(i);
+    }
+    keys.clear();
+    for (int i = 1001; i >= -1; i--) {
+        keys.push_back(i);
+    }
+    res.resize(keys.size());
+    t.lower_bounds(keys.data(), keys.size(), res.data());
+    for (size_t i = 0; i < keys.size(); i++) {
+        EXPECT_EQ(t.lower_bound(keys[i]), res[i]);
+    }
+}
+
 TEST(BTreeSet, Load) {
     using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
 
@@ -476,6 +591,21 @@ TEST(BTreeSet, Load) {
     }
 }
 
+TEST(BTreeSet, LoadLarge) {
+    // large enough to build sub-trees in parallel
+    const int N = 1 << 20;
+
+    std::vector<int> data;
+    for (int i = 0; i < N; i++) {
+        data.push_back(i);
+    }
+
+    auto t = btree_set<int, detail::comparator<int>, btree_node_pool>::load(data.begin(), data.end());
+    EXPECT_TRUE(t.check());
+    EXPECT_EQ(N, t.size());
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), t.begin()));
+}
+
 TEST(BTreeSet, Clear) {
     using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
 
@@ -493,6 +623,199 @@ TEST(BTreeSet, Clear) {
     EXPECT_TRUE(t.empty());
 }
 
+TEST(BTreeSet, NodePool) {
+    using test_set = btree_set<int, detail::comparator<int>, btree_node_pool, 64>;
+
+    const int N = 100000;
+    std::vector<int> data;
+    for (int i = 0; i < N; i++) {
+        data.push_back(i);
+    }
+    std::random_shuffle(data.begin(), data.end());
+
+    test_set t;
+    for (int round = 0; round < 3; round++) {
+        // insert in parallel, nodes are taken from the pool of the set
+#pragma omp parallel for
+        for (int i = 0; i < N; i++) {
+            t.insert(data[i]);
+        }
+        EXPECT_TRUE(t.check());
+        EXPECT_EQ(N, t.size());
+
+        // copies, moves and swaps keep the nodes with their trees
+        test_set c = t;
+        test_set m = std::move(c);
+        test_set s;
+        s.swap(m);
+        EXPECT_TRUE(c.empty());
+        EXPECT_TRUE(m.empty());
+        EXPECT_EQ(t, s);
+
+        test_set a;
+        a.insert(-1);
+        a = s;
+        s.clear();
+        EXPECT_EQ(t, a);
+        EXPECT_FALSE(a.contains(-1));
+
+        // the pool is released and reused
+        t.clear();
+        EXPECT_TRUE(t.empty());
+        EXPECT_EQ(N, a.size());
+    }
+
+    std::sort(data.begin(), data.end());
+    auto l = test_set::load(data.begin(), data.end());
+    EXPECT_TRUE(l.check());
+    EXPECT_EQ(N, l.size());
+}
+
+template <typename Comp>
+struct less_by {
+    template <typename T>
+    bool operator()(const T& a, const T& b) const {
+        return Comp().less(a, b);
+    }
+};
+
+/**
+ * Checks the operations of the given set type against a std::set on keys obtained from the generator.
+ */
+template <typename Set, typename Key, typename Comp, typename Gen>
+bool checkSearch(const Gen& gen, int N) {
+    Set t;
+    std::set<Key, less_by<Comp>> ref;
+    bool ok = true;
+    for (int i = 0; i < N; i++) {
+        Key k = gen();
+        ok = (ref.insert(k).second == t.insert(k)) && ok;
+    }
+    ok = t.check() && ref.size() == t.size() && std::equal(ref.begin(), ref.end(), t.begin()) && ok;
+
+    for (int i = 0; i < N; i++) {
+        Key k = gen();
+        auto l = ref.lower_bound(k);
+        auto u = ref.upper_bound(k);
+        ok = (ref.count(k) == 1) == t.contains(k) && ok;
+        ok = ((l == ref.end()) ? t.lower_bound(k) == t.end() : *l == *t.lower_bound(k)) && ok;
+        ok = ((u == ref.end()) ? t.upper_bound(k) == t.end() : *u == *t.upper_bound(k)) && ok;
+    }
+    return ok;
+}
+
+TEST(BTreeSet, SimdSearch) {
+    const int N = 20000;
+
+    std::srand(42);
+    auto genInt = []() { return (std::rand() % 20000) - 10000; };
+    using i1 = btree_set<int, detail::comparator<int>, std::allocator<int>, 64, detail::simd_search>;
+    using i2 = btree_set<int, detail::comparator<int>, std::allocator<int>, 256, detail::simd_search>;
+    EXPECT_TRUE((checkSearch<i1, int, detail::comparator<int>>(genInt, N)));
+    EXPECT_TRUE((checkSearch<i2, int, detail::comparator<int>>(genInt, N)));
+
+    // tuples with few distinct values in the leading column
+    using Tuple = ram::Tuple<RamDomain, 3>;
+    using comp = ram::index_utils::comparator<1, 0, 2>;
+    auto genTuple = []() {
+        Tuple t = {{std::rand() % 100, std::rand() % 16, std::rand() % 100}};
+        return t;
+    };
+    using t1 = btree_set<Tuple, comp, std::allocator<Tuple>, 256, detail::simd_search>;
+    using t2 = btree_set<Tuple, comp, std::allocator<Tuple>, 256, detail::simd_columnar_search>;
+    using t3 = btree_set<Tuple, comp, btree_node_pool, 128, detail::simd_columnar_search>;
+    EXPECT_TRUE((checkSearch<t1, Tuple, comp>(genTuple, N)));
+    EXPECT_TRUE((checkSearch<t2, Tuple, comp>(genTuple, N)));
+    EXPECT_TRUE((checkSearch<t3, Tuple, comp>(genTuple, N)));
+
+    // the columnar layout stores the leading column in addition to the keys
+    EXPECT_LT(int(t2::max_keys_per_node), int(t1::max_keys_per_node));
+
+    // copies and bulk loads maintain the columnar layout
+    t2 t;
+    for (int i = 0; i < N; i++) {
+        t.insert(genTuple());
+    }
+    t2 c = t;
+    std::vector<Tuple> data(t.begin(), t.end());
+    auto l = t2::load(data.begin(), data.end());
+    for (const auto& cur : data) {
+        EXPECT_TRUE(c.contains(cur));
+        EXPECT_TRUE(l.contains(cur));
+    }
+}
+
+TEST(BTreeSet, NormalisedSearch) {
+    const int N = 20000;
+    std::srand(42);
+
+    // values of both signs, including the extremes of the domain
+    auto gen = []() -> RamDomain {
+        switch (std::rand() % 8) {
+            case 0:
+                return std::numeric_limits<RamDomain>::min();
+            case 1:
+                return std::numeric_limits<RamDomain>::max();
+            default:
+                return (std::rand() % 8) - 4;
+        }
+    };
+
+    // the normalised keys are ordered as the tuples, up to the encoded columns
+    using T4 = ram::Tuple<RamDomain, 4>;
+    using c4 = ram::index_utils::comparator<2, 0, 3, 1>;
+    using n4 = detail::normalised_key<c4, T4>;
+    EXPECT_TRUE(n4::columns > 0);
+    for (int i = 0; i < N; i++) {
+        T4 a = {{gen(), gen(), gen(), gen()}};
+        T4 b = {{gen(), gen(), gen(), gen()}};
+        if (n4::complete) {
+            EXPECT_EQ(c4().less(a, b), n4::get(a) < n4::get(b));
+            EXPECT_EQ(c4().equal(a, b), n4::get(a) == n4::get(b));
+        } else if (n4::get(a) < n4::get(b)) {
+            EXPECT_TRUE(c4().less(a, b));
+        }
+    }
+
+    // sets of keys encoded completely and partially
+    using comp = c4;
+    auto gen4 = [&]() {
+        T4 t = {{gen(), gen(), gen(), gen()}};
+        return t;
+    };
+    using s1 = btree_set<T4, comp, std::allocator<T4>, 256, detail::simd_normalised_search>;
+    using s2 = btree_set<T4, comp, btree_node_pool, 128, detail::simd_normalised_search>;
+    EXPECT_TRUE((checkSearch<s1, T4, comp>(gen4, N)));
+    EXPECT_TRUE((checkSearch<s2, T4, comp>(gen4, N)));
+
+    using T6 = ram::Tuple<RamDomain, 6>;
+    using comp6 = ram::index_utils::comparator<5, 4, 3, 2, 1, 0>;
+    auto gen6 = [&]() {
+        T6 t = {{gen(), gen(), gen(), gen(), gen(), gen()}};
+        return t;
+    };
+    using s3 = btree_set<T6, comp6, std::allocator<T6>, 256, detail::simd_normalised_search>;
+    EXPECT_FALSE(bool(detail::normalised_key<comp6, T6>::complete));
+    EXPECT_TRUE((checkSearch<s3, T6, comp6>(gen6, N)));
+
+    // the normalised keys are stored in addition to the keys
+    using s0 = btree_set<T4, comp, std::allocator<T4>, 256, detail::simd_search>;
+    EXPECT_LT(int(s1::max_keys_per_node), int(s0::max_keys_per_node));
+
+    // copies and bulk loads maintain the normalised keys
+    s1 t;
+    for (int i = 0; i < N; i++) {
+        t.insert(gen4());
+    }
+    s1 c = t;
+    std::vector<T4> data(t.begin(), t.end());
+    auto l = s1::load(data.begin(), data.end());
+    for (const auto& cur : data) {
+        EXPECT_TRUE(c.contains(cur));
+        EXPECT_TRUE(l.contains(cur));
+    }
+}
+
 TEST(BTreeSet, ChunkSplit) {
     using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
 
@@ -696,6 +1019,49 @@ TEST(Performance, Basic) {
     checkPerformance(t3, "souffle btree_set - 256 - binary", in, out);
 }
 
+TEST(Performance, SearchStrategies) {
+    int N = 1 << 18;
+
+    std::vector<int> data(2 * N);
+    for (int i = 0; i < 2 * N; i++) {
+        data[i] = i;
+    }
+    random_shuffle(data.begin(), data.end());
+    std::vector<int> in(data.begin(), data.begin() + N);
+    std::vector<int> out(data.begin() + N, data.end());
+
+    using i1 = btree_set<int, detail::comparator<int>, std::allocator<int>, 256, detail::linear_search>;
+    checkPerformance(i1, "souffle btree_set<int> - 256 - linear", in, out);
+
+    using i2 = btree_set<int, detail::comparator<int>, std::allocator<int>, 256, detail::binary_search>;
+    checkPerformance(i2, "souffle btree_set<int> - 256 - binary", in, out);
+
+    using i3 = btree_set<int, detail::comparator<int>, std::allocator<int>, 256, detail::simd_search>;
+    checkPerformance(i3, "souffle btree_set<int> - 256 - simd", in, out);
+
+    // tuples distinguished by their first column, as in relations of the LVM
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    using comp = ram::index_utils::comparator<0, 1>;
+    std::vector<Tuple> tin;
+    std::vector<Tuple> tout;
+    for (int i = 0; i < N; i++) {
+        tin.push_back({{in[i] / 4, in[i] % 4}});
+        tout.push_back({{out[i] / 4, out[i] % 4}});
+    }
+
+    using t1 = btree_set<Tuple, comp, std::allocator<Tuple>, 256, detail::linear_search>;
+    checkPerformance(t1, "souffle btree_set<tuple> - 256 - linear", tin, tout);
+
+    using t2 = btree_set<Tuple, comp, std::allocator<Tuple>, 256, detail::binary_search>;
+    checkPerformance(t2, "souffle btree_set<tuple> - 256 - binary", tin, tout);
+
+    using t3 = btree_set<Tuple, comp, std::allocator<Tuple>, 256, detail::simd_search>;
+    checkPerformance(t3, "souffle btree_set<tuple> - 256 - simd", tin, tout);
+
+    using t4 = btree_set<Tuple, comp, std::allocator<Tuple>, 256, detail::simd_columnar_search>;
+    checkPerformance(t4, "souffle btree_set<tuple> - 256 - simd columnar", tin, tout);
+}
+
 TEST(Performance, Load) {
     //        int N = 1<<24;
     int N = 1 << 20;
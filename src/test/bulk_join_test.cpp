@@ -0,0 +1,111 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file bulk_join_test.cpp
+ *
+ * A test case testing the partitioned hash join of large relations.
+ *
+ ***********************************************************************/
+
+#include "BulkJoin.h"
+#include "CompiledTuple.h"
+#include "RamTypes.h"
+#include "Util.h"
+#include "test.h"
+
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+using Pair = ram::Tuple<RamDomain, 2>;
+using Triple = ram::Tuple<RamDomain, 3>;
+using Key = ram::Tuple<RamDomain, 1>;
+
+/** A relation of the given tuples, partitioned into chunks of a fixed size */
+template <typename T>
+struct Relation {
+    using iterator = typename std::vector<T>::const_iterator;
+
+    std::vector<T> tuples;
+
+    std::size_t size() const {
+        return tuples.size();
+    }
+
+    std::vector<range<iterator>> partition() const {
+        std::vector<range<iterator>> res;
+        for (std::size_t i = 0; i < tuples.size(); i += 1000) {
+            const std::size_t end = std::min(i + 1000, tuples.size());
+            res.push_back(range<iterator>(tuples.begin() + i, tuples.begin() + end));
+        }
+        return res;
+    }
+};
+
+TEST(BulkJoin, Empty) {
+    Relation<Pair> outer;
+    Relation<Triple> inner;
+    inner.tuples.push_back({{1, 2, 3}});
+    BulkJoin<Key, Pair, Triple> join(outer, inner, [](const Pair& t) { return Key({{t[1]}}); },
+            [](const Triple& t) { return Key({{t[0]}}); }, [](const Pair&) { return true; },
+            [](const Triple&) { return true; });
+
+    int matches = 0;
+    for (std::size_t i = 0; i < join.getNumPartitions(); i++) {
+        join.forEachMatch(i, [&](const Pair&, const Triple&) { matches++; });
+    }
+    EXPECT_EQ(0, matches);
+    EXPECT_EQ(0, join.getOuterSize());
+    EXPECT_EQ(1, join.getInnerSize());
+}
+
+TEST(BulkJoin, Random) {
+    std::srand(42);
+    Relation<Pair> outer;
+    Relation<Triple> inner;
+    for (int i = 0; i < 20000; i++) {
+        outer.tuples.push_back({{i, std::rand() % 5000 - 2500}});
+        inner.tuples.push_back({{std::rand() % 5000 - 2500, i, std::rand() % 2}});
+    }
+
+    // join outer.1 = inner.0, for inner tuples of inner.2 = 1 and outer tuples of even outer.0
+    auto outerFilter = [](const Pair& t) { return t[0] % 2 == 0; };
+    auto innerFilter = [](const Triple& t) { return t[2] == 1; };
+    BulkJoin<Key, Pair, Triple> join(outer, inner, [](const Pair& t) { return Key({{t[1]}}); },
+            [](const Triple& t) { return Key({{t[0]}}); }, outerFilter, innerFilter);
+
+    std::set<std::pair<Pair, Triple>> expected;
+    for (const auto& a : outer.tuples) {
+        for (const auto& b : inner.tuples) {
+            if (a[1] == b[0] && outerFilter(a) && innerFilter(b)) {
+                expected.insert(std::make_pair(a, b));
+            }
+        }
+    }
+
+    std::set<std::pair<Pair, Triple>> res;
+    std::size_t matches = 0;
+    for (std::size_t i = 0; i < join.getNumPartitions(); i++) {
+        join.forEachMatch(i, [&](const Pair& a, const Triple& b) {
+            res.insert(std::make_pair(a, b));
+            matches++;
+        });
+    }
+    EXPECT_EQ(expected.size(), matches);
+    EXPECT_TRUE(expected == res);
+    EXPECT_EQ(10000, join.getOuterSize());
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -0,0 +1,207 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file checkpoint_test.cpp
+ *
+ * Tests the checkpoints of the evaluation state, saving and restoring
+ * relations, symbols and records, and the store of the mpi engine.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "Checkpoint.h"
+#include "CompiledRecord.h"
+#include "CompiledTuple.h"
+#include "MpiStore.h"
+#include "SymbolTable.h"
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace souffle;
+
+namespace test {
+
+/** A tuple of a saved relation */
+struct Entry {
+    const RamDomain* data;
+};
+
+/** A relation saved and restored */
+struct Relation {
+    size_t arity;
+    std::vector<std::vector<RamDomain>> rows;
+    std::vector<Entry> tuples;
+
+    void insert(const RamDomain* tuple) {
+        rows.emplace_back(tuple, tuple + arity);
+    }
+
+    /** Make the rows available for writing */
+    const Relation& entries() {
+        tuples.clear();
+        for (const auto& row : rows) {
+            tuples.push_back(Entry{row.data()});
+        }
+        return *this;
+    }
+
+    std::vector<Entry>::const_iterator begin() const {
+        return tuples.begin();
+    }
+    std::vector<Entry>::const_iterator end() const {
+        return tuples.end();
+    }
+    size_t size() const {
+        return tuples.size();
+    }
+};
+
+const std::string directory = "checkpoint_test.dir";
+
+void removeCheckpoint() {
+    for (const char* file : {"manifest", "symbols", "records", "r.bin", "s.bin"}) {
+        std::remove((directory + "/" + file).c_str());
+    }
+    rmdir(directory.c_str());
+}
+
+TEST(Checkpoint, RoundTrip) {
+    removeCheckpoint();
+    SymbolTable symbols({"a", "b"});
+    Relation r{2, {{0, 1}, {1, 42}}, {}};
+    Relation s{1, {}, {}};
+
+    // the first stratum computes r, the second s from r, dropping r
+    {
+        Checkpoint checkpoint(directory);
+        EXPECT_FALSE(checkpoint.read());
+        checkpoint.saveRelation("r", r.entries(), 2, symbols);
+        checkpoint.commit({0}, symbols, 5, {"r"}, {});
+        s.rows.push_back({symbols.lookup("c")});
+        checkpoint.saveRelation("s", s.entries(), 1, symbols);
+        checkpoint.commit({1}, symbols, 7, {"s"}, {"r"});
+    }
+
+    Checkpoint checkpoint(directory);
+    EXPECT_TRUE(checkpoint.read());
+    EXPECT_TRUE(checkpoint.isCompleted(0));
+    EXPECT_TRUE(checkpoint.isCompleted(1));
+    EXPECT_FALSE(checkpoint.isCompleted(2));
+    EXPECT_EQ(7, checkpoint.getCounter());
+    EXPECT_TRUE(checkpoint.getRelations() == std::set<std::string>({"s"}));
+    EXPECT_FALSE(std::ifstream(directory + "/r.bin").good());
+
+    // the symbols obtain their former indices in a table holding the first of them
+    SymbolTable restored({"a"});
+    checkpoint.restoreSymbols(restored);
+    EXPECT_EQ(3, restored.size());
+    EXPECT_EQ("c", restored.resolve(2));
+    Relation read{1, {}, {}};
+    checkpoint.restoreRelation("s", read, 1, restored);
+    EXPECT_TRUE(read.rows == s.rows);
+
+    // a table disagreeing with the checkpoint is rejected
+    SymbolTable other({"b"});
+    bool thrown = false;
+    try {
+        checkpoint.restoreSymbols(other);
+    } catch (std::runtime_error&) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+
+    // a later commit drops the symbols appended by an interrupted one
+    std::ofstream(directory + "/symbols", std::ios::app) << "interrupted";
+    {
+        Checkpoint resumed(directory);
+        resumed.read();
+        SymbolTable more({"a", "b", "c", "d"});
+        resumed.commit({2}, more, 9, {}, {});
+    }
+    Checkpoint last(directory);
+    last.read();
+    SymbolTable all;
+    last.restoreSymbols(all);
+    EXPECT_EQ(4, all.size());
+    EXPECT_EQ("d", all.resolve(3));
+    removeCheckpoint();
+}
+
+TEST(Checkpoint, Records) {
+    using Pair = ram::Tuple<RamDomain, 2>;
+    const RamDomain first = pack(Pair({{3, 4}}));
+    const RamDomain second = pack(Pair({{5, first}}));
+    std::stringstream saved;
+    detail::RecordMapBase::saveAll(saved);
+
+    // restoring records agreeing with the existing ones keeps their references
+    detail::RecordMapBase::restoreAll(saved);
+    EXPECT_EQ(second, pack(Pair({{5, first}})));
+
+    // the records of a map not created yet are restored once it is
+    using Triple = ram::Tuple<RamDomain, 3>;
+    std::stringstream pending;
+    const uint64_t header[2] = {3, 2};
+    const RamDomain fields[6] = {1, 2, 3, 4, 5, 6};
+    pending.write(reinterpret_cast<const char*>(header), sizeof(header));
+    pending.write(reinterpret_cast<const char*>(fields), sizeof(fields));
+    detail::RecordMapBase::restoreAll(pending);
+    EXPECT_EQ(4, unpack<Triple>(2)[0]);
+    EXPECT_EQ(2, pack(Triple({{4, 5, 6}})));
+    EXPECT_EQ(3, pack(Triple({{7, 8, 9}})));
+}
+
+TEST(MpiStore, Restart) {
+    const std::string store = "mpi_store_test.dir";
+    SymbolTable symbols({"a", "b"});
+    Relation r{2, {{0, symbols.lookup("x")}, {1, symbols.lookup("y")}}, {}};
+
+    // the first run completes stratum 0, which sends r to strata 1 and 2
+    {
+        MpiStore first(store);
+        first.open(3);
+        EXPECT_FALSE(first.isCompleted(0));
+        EXPECT_TRUE(first.pending({{1, 4}, {2, 5}}) == std::set<int>({4, 5}));
+        first.saveRelation("r", r.entries(), {false, true}, symbols);
+        first.commit(0);
+        // the run opened the store before, hence still evaluates stratum 0
+        EXPECT_FALSE(first.isCompleted(0));
+    }
+
+    // a restarted run skips stratum 0, reading r with its symbols into a table of another order
+    MpiStore second(store);
+    second.open(3);
+    EXPECT_TRUE(second.isCompleted(0));
+    EXPECT_FALSE(second.isCompleted(1));
+    EXPECT_FALSE(second.isCompleted(-1));
+    EXPECT_TRUE(second.pending({{0, 3}, {1, 4}}) == std::set<int>({4}));
+    SymbolTable restarted({"y"});
+    Relation read{2, {}, {}};
+    second.restoreRelation("r", read, {false, true}, restarted);
+    EXPECT_EQ(2, read.rows.size());
+    for (const auto& row : read.rows) {
+        EXPECT_EQ(row[0] == 0 ? "x" : "y", restarted.resolve(row[1]));
+    }
+
+    for (const char* file : {"r.bin", "stratum0.done"}) {
+        std::remove((store + "/" + file).c_str());
+    }
+    rmdir(store.c_str());
+}
+
+}  // end namespace test
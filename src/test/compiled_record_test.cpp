@@ -0,0 +1,96 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file compiled_record_test.cpp
+ *
+ * Tests the record maps of the compiled execution.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "CompiledRecord.h"
+#include "CompiledTuple.h"
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+TEST(CompiledRecord, Basic) {
+    using Pair = ram::Tuple<RamDomain, 2>;
+    RamDomain a = pack(Pair({{1, 2}}));
+    RamDomain b = pack(Pair({{2, 1}}));
+
+    EXPECT_NE(0, a);
+    EXPECT_NE(0, b);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a, pack(Pair({{1, 2}})));
+    EXPECT_EQ(b, pack(Pair({{2, 1}})));
+
+    EXPECT_EQ(1, unpack<Pair>(a)[0]);
+    EXPECT_EQ(2, unpack<Pair>(a)[1]);
+    EXPECT_EQ(2, unpack<Pair>(b)[0]);
+    EXPECT_EQ(1, unpack<Pair>(b)[1]);
+}
+
+TEST(CompiledRecord, Large) {
+    using Triple = ram::Tuple<RamDomain, 3>;
+    const int N = 200000;
+
+    // the references are assigned consecutively, over several blocks of the store
+    std::vector<RamDomain> refs;
+    for (int i = 0; i < N; i++) {
+        refs.push_back(pack(Triple({{i, i % 7, -i}})));
+        EXPECT_EQ(refs[0] + i, refs[i]);
+    }
+
+    for (int i = 0; i < N; i++) {
+        EXPECT_EQ(refs[i], pack(Triple({{i, i % 7, -i}})));
+        const Triple& t = unpack<Triple>(refs[i]);
+        EXPECT_EQ(i, t[0]);
+        EXPECT_EQ(i % 7, t[1]);
+        EXPECT_EQ(-i, t[2]);
+    }
+}
+
+TEST(CompiledRecord, Parallel) {
+    using Quad = ram::Tuple<RamDomain, 4>;
+    const int N = 100000;
+
+    // every thread packs the same tuples, unpacking those of the others, and must obtain the same references
+    std::vector<RamDomain> refs(N, 0);
+#pragma omp parallel
+    {
+        std::vector<RamDomain> mine(N);
+        for (int i = 0; i < N; i++) {
+            mine[i] = pack(Quad({{i, i * 3, 0, 1}}));
+            const Quad& t = unpack<Quad>(mine[i / 2]);
+            EXPECT_EQ(i / 2, t[0]);
+        }
+#pragma omp critical
+        {
+            for (int i = 0; i < N; i++) {
+                if (refs[i] == 0) {
+                    refs[i] = mine[i];
+                }
+                EXPECT_EQ(refs[i], mine[i]);
+            }
+        }
+    }
+
+    for (int i = 0; i < N; i++) {
+        const Quad& t = unpack<Quad>(refs[i]);
+        EXPECT_EQ(i, t[0]);
+        EXPECT_EQ(i * 3, t[1]);
+    }
+}
+
+}  // end namespace test
@@ -0,0 +1,213 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file compressed_set_test.cpp
+ *
+ * A test case testing the delta-encoded tuple set.
+ *
+ ***********************************************************************/
+
+#include "CompressedSet.h"
+#include "test.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+TEST(CompressedSet, Basic) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    CompressedSet<2> set;
+
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(0, set.size());
+    EXPECT_TRUE(set.begin() == set.end());
+    EXPECT_FALSE(set.contains({{1, 2}}));
+
+    EXPECT_TRUE(set.insert({{1, 2}}));
+    EXPECT_FALSE(set.insert({{1, 2}}));
+    EXPECT_TRUE(set.insert({{1, 3}}));
+    EXPECT_TRUE(set.insert({{0, 5}}));
+    EXPECT_TRUE(set.insert({{-4, 7}}));
+
+    EXPECT_FALSE(set.empty());
+    EXPECT_EQ(4, set.size());
+    EXPECT_TRUE(set.contains({{1, 2}}));
+    EXPECT_TRUE(set.contains({{-4, 7}}));
+    EXPECT_FALSE(set.contains({{1, 4}}));
+    EXPECT_FALSE(set.contains({{-5, 7}}));
+
+    std::vector<Tuple> content(set.begin(), set.end());
+    std::vector<Tuple> expected = {{{-4, 7}}, {{0, 5}}, {{1, 2}}, {{1, 3}}};
+    EXPECT_EQ(expected, content);
+
+    EXPECT_EQ(Tuple({{0, 5}}), *set.find({{0, 5}}));
+    EXPECT_TRUE(set.find({{0, 6}}) == set.end());
+
+    set.clear();
+    EXPECT_TRUE(set.empty());
+    EXPECT_FALSE(set.contains({{1, 2}}));
+}
+
+TEST(CompressedSet, Extremes) {
+    using Tuple = ram::Tuple<RamDomain, 3>;
+    CompressedSet<3> set;
+    std::set<Tuple> ref;
+
+    const RamDomain values[] = {MIN_RAM_DOMAIN, MIN_RAM_DOMAIN + 1, -1, 0, 1, MAX_RAM_DOMAIN - 1, MAX_RAM_DOMAIN};
+    for (RamDomain a : values) {
+        for (RamDomain b : values) {
+            for (RamDomain c : values) {
+                Tuple t = {{c, a, b}};
+                EXPECT_EQ(ref.insert(t).second, set.insert(t));
+            }
+        }
+    }
+
+    EXPECT_EQ(ref.size(), set.size());
+    EXPECT_TRUE(std::equal(ref.begin(), ref.end(), set.begin()));
+}
+
+TEST(CompressedSet, Random) {
+    using Tuple = ram::Tuple<RamDomain, 4>;
+    CompressedSet<4> set;
+    std::set<Tuple> ref;
+
+    std::srand(42);
+    auto gen = []() {
+        Tuple t = {{std::rand() % 10, std::rand() % 10, std::rand() % 1000, std::rand() - RAND_MAX / 2}};
+        return t;
+    };
+
+    CompressedSet<4>::op_context ctxt;
+    for (int i = 0; i < 50000; i++) {
+        Tuple t = gen();
+        EXPECT_EQ(ref.insert(t).second, set.insert(t, ctxt));
+    }
+    EXPECT_EQ(ref.size(), set.size());
+    EXPECT_TRUE(std::equal(ref.begin(), ref.end(), set.begin()));
+
+    for (int i = 0; i < 10000; i++) {
+        Tuple t = gen();
+        EXPECT_EQ(ref.count(t) == 1, set.contains(t, ctxt));
+
+        auto l = ref.lower_bound(t);
+        auto pos = set.lower_bound(t, ctxt);
+        EXPECT_EQ(l == ref.end(), pos == set.end());
+        if (l != ref.end() && pos != set.end()) {
+            EXPECT_EQ(*l, *pos);
+        }
+
+        auto u = ref.upper_bound(t);
+        pos = set.upper_bound(t, ctxt);
+        EXPECT_EQ(u == ref.end(), pos == set.end());
+        if (u != ref.end() && pos != set.end()) {
+            EXPECT_EQ(*u, *pos);
+        }
+    }
+}
+
+TEST(CompressedSet, Boundaries) {
+    using Tuple = ram::Tuple<RamDomain, 3>;
+    CompressedSet<3> set;
+    for (int i = 0; i < 20; i++) {
+        for (int j = 0; j < 20; j++) {
+            for (int k = 0; k < 20; k++) {
+                set.insert({{i, j, k}});
+            }
+        }
+    }
+
+    auto count = [](const range<CompressedSet<3>::iterator>& r) {
+        int res = 0;
+        for (auto it = r.begin(); it != r.end(); ++it) {
+            res++;
+        }
+        return res;
+    };
+
+    EXPECT_EQ(8000, count(set.getBoundaries<0>({{3, 4, 5}})));
+    EXPECT_EQ(400, count(set.getBoundaries<1>({{3, 4, 5}})));
+    EXPECT_EQ(20, count(set.getBoundaries<2>({{3, 4, 5}})));
+    EXPECT_EQ(1, count(set.getBoundaries<3>({{3, 4, 5}})));
+    EXPECT_EQ(0, count(set.getBoundaries<2>({{3, 40, 5}})));
+    EXPECT_EQ(0, count(set.getBoundaries<1>({{-1, 4, 5}})));
+
+    for (auto cur : set.getBoundaries<2>({{19, 19, 0}})) {
+        EXPECT_EQ(19, cur[0]);
+        EXPECT_EQ(19, cur[1]);
+    }
+
+    // partitions cover all elements in order
+    auto parts = set.partition(7);
+    EXPECT_FALSE(parts.size() < 7);
+    std::vector<Tuple> content;
+    for (const auto& part : parts) {
+        content.insert(content.end(), part.begin(), part.end());
+    }
+    EXPECT_EQ(8000, content.size());
+    EXPECT_TRUE(std::equal(content.begin(), content.end(), set.begin()));
+}
+
+TEST(CompressedSet, Memory) {
+    // tuples sharing long prefixes, as in relations of high arity
+    CompressedSet<8> set;
+    const int N = 100000;
+    for (int i = 0; i < N; i++) {
+        set.insert({{1, 2, 3, i / 1000, (i / 100) % 10, 7, 42, i % 100}});
+    }
+    EXPECT_EQ(N, set.size());
+
+    // the encoding requires a fraction of the raw size
+    EXPECT_LT(set.getMemoryUsage() * 4, N * sizeof(ram::Tuple<RamDomain, 8>));
+}
+
+TEST(CompressedSet, Parallel) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    CompressedSet<2> set;
+    const int N = 100000;
+
+    std::vector<Tuple> data;
+    for (int i = 0; i < N; i++) {
+        data.push_back({{i % 317, i}});
+    }
+    std::random_shuffle(data.begin(), data.end());
+
+#pragma omp parallel for
+    for (int i = 0; i < N; i++) {
+        set.insert(data[i]);
+    }
+
+    EXPECT_EQ(N, set.size());
+    std::sort(data.begin(), data.end());
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), set.begin()));
+}
+
+TEST(CompressedSet, InsertAll) {
+    CompressedSet<2> a;
+    CompressedSet<2> b;
+    for (int i = 0; i < 1000; i++) {
+        a.insert({{i, i}});
+        b.insert({{i, 2 * i}});
+    }
+    a.insertAll(b);
+    EXPECT_EQ(1999, a.size());
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(a.contains({{i, 2 * i}}));
+    }
+}
+
+}  // namespace test
+
+}  // namespace souffle
@@ -0,0 +1,129 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file compression_test.cpp
+ *
+ * Tests the compression of fact files in blocks, compressed concurrently.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "Compression.h"
+#include "IODirectives.h"
+#include "ReadStreamCSV.h"
+#include "SymbolTable.h"
+#include "WriteStreamCSV.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+/** A tuple of a written relation */
+struct Entry {
+    const RamDomain* data;
+};
+
+/** A relation collecting the inserted tuples */
+struct Collector {
+    size_t arity;
+    std::vector<std::vector<RamDomain>> tuples;
+
+    void insert(const RamDomain* tuple) {
+        tuples.emplace_back(tuple, tuple + arity);
+    }
+};
+
+const std::string fileName = "compression_test.facts";
+
+/** Some text of several blocks */
+std::string text() {
+    std::string text;
+    for (int i = 0; text.size() < 5 * compression::BlockCompressor::BLOCK_SIZE / 2; ++i) {
+        text += std::to_string(i * 7919 % 100003) + "\t" + std::to_string(i) + "\n";
+    }
+    return text;
+}
+
+/** Write and read back a compressed relation, giving whether it is unchanged and the compression ratio */
+double roundTrip(const std::string& format, bool& same) {
+    std::vector<std::vector<RamDomain>> rows;
+    std::vector<Entry> relation;
+    for (RamDomain i = 0; i < 500000; ++i) {
+        rows.push_back({i, i % 11});
+    }
+    for (const auto& row : rows) {
+        relation.push_back(Entry{row.data()});
+    }
+    SymbolTable symbols;
+    std::map<std::string, std::string> directives = {
+            {"IO", "file"}, {"filename", fileName}, {"name", "test"}, {"compress", format}};
+    const std::vector<bool> mask = {false, false};
+    WriteFileCSVFactory().getWriter(mask, symbols, IODirectives(directives), false)->writeAll(relation);
+
+    std::ifstream in(fileName, std::ios::binary | std::ios::ate);
+    const double size = in.tellg();
+
+    Collector read{2, {}};
+    ReadFileCSVFactory().getReader(mask, symbols, IODirectives(directives), false)->readAll(read);
+    same = rows == read.tuples;
+    std::remove(fileName.c_str());
+    return size / (rows.size() * 8);
+}
+
+#ifdef USE_LIBZ
+TEST(Compression, Gzip) {
+    const std::string content = text();
+    {
+        std::ofstream out(fileName, std::ios::binary);
+        compression::BlockCompressor compressor(out, compression::Format::GZIP);
+        compressor.write(content.substr(0, 100));
+        compressor.write(content.substr(100));
+    }
+
+    // the members of the blocks are decompressed as one file
+    gzfstream::igzfstream in(fileName);
+    std::stringstream decompressed;
+    decompressed << in.rdbuf();
+    EXPECT_EQ(content.size(), decompressed.str().size());
+    EXPECT_TRUE(content == decompressed.str());
+    std::remove(fileName.c_str());
+
+    bool same = false;
+    EXPECT_TRUE(roundTrip("true", same) < 0.5);
+    EXPECT_TRUE(same);
+}
+#endif
+
+#ifdef USE_ZSTD
+TEST(Compression, Zstd) {
+    const std::string content = text();
+    std::stringstream out;
+    {
+        compression::BlockCompressor compressor(out, compression::Format::ZSTD);
+        compressor.write(content);
+    }
+    const std::string compressed = out.str();
+    EXPECT_TRUE(compression::isZstd(compressed.data(), compressed.size()));
+    EXPECT_TRUE(content == compression::zstdDecompress(compressed.data(), compressed.size()));
+
+    bool same = false;
+    EXPECT_TRUE(roundTrip("zstd", same) < 0.5);
+    EXPECT_TRUE(same);
+}
+#endif
+
+}  // end namespace test
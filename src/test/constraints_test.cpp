@@ -18,8 +18,11 @@
 #include "Util.h"
 #include "test.h"
 
+#include <chrono>
+#include <iostream>
 #include <set>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -57,5 +60,66 @@ TEST(Constraints, Basic) {
     EXPECT_EQ("{A->{1,2},B->{1,2,3}}", toString(p.solve()));
 }
 
+TEST(Constraints, Chain) {
+    using Vars = Variable<int, set_property_space<int>>;
+
+    // constraints listed against the direction values propagate in
+    const int N = 100;
+    Problem<Vars> p;
+    for (int i = N - 1; i > 0; i--) {
+        p.add(sub(Vars(i - 1), Vars(i)));
+    }
+    p.add(sub(std::set<int>({7}), Vars(0)));
+    p.add(sub(std::set<int>({8}), Vars(N / 2)));
+
+    auto ass = p.solve();
+    for (int i = 0; i < N; i++) {
+        EXPECT_EQ(i < N / 2 ? std::set<int>({7}) : std::set<int>({7, 8}), ass[Vars(i)]);
+    }
+}
+
+TEST(Constraints, Cycle) {
+    using Vars = Variable<int, set_property_space<int>>;
+
+    // values are propagated around a cycle until it is saturated
+    const int N = 10;
+    Problem<Vars> p;
+    for (int i = 0; i < N; i++) {
+        p.add(sub(Vars(i), Vars((i + 1) % N)));
+        p.add(sub(std::set<int>({i}), Vars(i)));
+    }
+
+    auto ass = p.solve();
+    for (int i = 0; i < N; i++) {
+        EXPECT_EQ(N, ass[Vars(i)].size());
+    }
+}
+
+TEST(Performance, Constraints) {
+    using Vars = Variable<int, set_property_space<int>>;
+
+    // problems shaped like those of large clauses: many variables related by short chains, listed the
+    // wrong way round, which requires a pass over all constraints per propagation step to a naive solver
+    const int clauses = 2000;
+    const int width = 25;
+    Problem<Vars> p;
+    for (int c = 0; c < clauses; c++) {
+        for (int i = width - 1; i > 0; i--) {
+            p.add(sub(Vars(c * width + i - 1), Vars(c * width + i)));
+        }
+        p.add(sub(std::set<int>({c}), Vars(c * width)));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto ass = p.solve();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Solving " << clauses * width << " constraints: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms\n";
+
+    for (int c = 0; c < clauses; c++) {
+        EXPECT_EQ(std::set<int>({c}), ass[Vars(c * width + width - 1)]);
+    }
+}
+
 }  // end namespace test
 }  // end namespace souffle
@@ -0,0 +1,153 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file debug_report_test.cpp
+ *
+ * Tests the selection of the sections of debug reports and the versions
+ * of code they keep as changes.
+ *
+ ***********************************************************************/
+
+#include "DebugReport.h"
+#include "Global.h"
+#include "Util.h"
+#include "test.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+/** Applies the changes of a version of code to the lines of the previous version */
+std::vector<std::string> applyChanges(
+        std::vector<std::string> lines, const std::vector<DebugReport::CodeChange>& changes) {
+    // the lines of the changes refer to the previous version, hence they are applied from the last
+    for (auto it = changes.rbegin(); it != changes.rend(); ++it) {
+        auto pos = lines.begin() + (it->line - 1);
+        pos = lines.erase(pos, pos + it->removed.size());
+        lines.insert(pos, it->added.begin(), it->added.end());
+    }
+    return lines;
+}
+
+/** Reads the changes, or the full code, back from the HTML of a rendered code section */
+std::vector<std::string> readSection(const DebugReportSection& section, std::vector<std::string> previous) {
+    std::stringstream html;
+    section.printContent(html);
+    std::string content = html.str();
+    for (size_t i = content.find("&lt;"); i != std::string::npos; i = content.find("&lt;", i)) {
+        content.replace(i, 4, "<");
+    }
+    if (content.find("<pre>") == std::string::npos) {
+        return previous;
+    }
+    size_t begin = content.find("<pre>") + 5;
+    std::string code = content.substr(begin, content.find("</pre>") - begin);
+    if (code.find("<span style='color:grey'>@@ line ") == std::string::npos) {
+        return splitString(code, '\n');
+    }
+
+    std::vector<DebugReport::CodeChange> changes;
+    for (const std::string& line : splitString(code, '\n')) {
+        const std::string header = "<span style='color:grey'>@@ line ";
+        const std::string removed = "<span style='color:red'>- ";
+        const std::string added = "<span style='color:green'>+ ";
+        const std::string end = "</span>";
+        if (line.compare(0, header.size(), header) == 0) {
+            changes.emplace_back();
+            changes.back().line = std::stoul(line.substr(header.size()));
+        } else if (line.compare(0, removed.size(), removed) == 0) {
+            changes.back().removed.push_back(
+                    line.substr(removed.size(), line.size() - removed.size() - end.size()));
+        } else if (line.compare(0, added.size(), added) == 0) {
+            changes.back().added.push_back(
+                    line.substr(added.size(), line.size() - added.size() - end.size()));
+        }
+    }
+    return applyChanges(std::move(previous), changes);
+}
+
+TEST(DebugReport, SelectSections) {
+    Global::config().set("debug-report-sections", "");
+    EXPECT_TRUE(DebugReport::isSelected("datalog"));
+    EXPECT_TRUE(DebugReport::isSelected("ram"));
+    EXPECT_TRUE(DebugReport::isSelected("passes"));
+
+    Global::config().set("debug-report-sections", "ram,passes");
+    EXPECT_FALSE(DebugReport::isSelected("datalog"));
+    EXPECT_FALSE(DebugReport::isSelected("graphs"));
+    EXPECT_TRUE(DebugReport::isSelected("ram"));
+    EXPECT_TRUE(DebugReport::isSelected("passes"));
+    EXPECT_FALSE(DebugReport::isSelected("ra"));
+
+    Global::config().set("debug-report-sections", "");
+}
+
+TEST(DebugReport, DiffLines) {
+    const std::vector<std::string> empty;
+    const std::vector<std::string> base = {"a", "b", "c", "d", "e", "f"};
+    EXPECT_TRUE(DebugReport::diffLines(base, base).empty());
+
+    std::vector<std::vector<std::string>> versions = {empty, {"a", "x", "c", "d", "e", "f"},
+            {"a", "b", "c", "d", "e", "f", "g"}, {"z", "a", "b", "c", "d", "e", "f"}, {"b", "d", "f"},
+            {"a", "c", "b", "d", "f", "e"}, {"f", "e", "d", "c", "b", "a"}, {"x", "y"}};
+    for (const auto& to : versions) {
+        EXPECT_EQ(to, applyChanges(base, DebugReport::diffLines(base, to)));
+        EXPECT_EQ(base, applyChanges(to, DebugReport::diffLines(to, base)));
+    }
+
+    // random edits of a version of many repeated lines
+    srand(7);
+    for (int round = 0; round < 100; ++round) {
+        std::vector<std::string> from;
+        for (int i = 0; i < 200; ++i) {
+            from.push_back(std::to_string(rand() % 10));
+        }
+        std::vector<std::string> to = from;
+        for (int edit = rand() % 20; edit > 0; --edit) {
+            size_t pos = rand() % (to.size() + 1);
+            if (rand() % 2 == 0 && pos < to.size()) {
+                to.erase(to.begin() + pos);
+            } else {
+                to.insert(to.begin() + pos, std::to_string(rand() % 10));
+            }
+        }
+        EXPECT_EQ(to, applyChanges(from, DebugReport::diffLines(from, to)));
+    }
+}
+
+TEST(DebugReport, RenderVersions) {
+    const std::vector<std::string> versions = {".decl A(x:number)\nA(1).\nA(x+1) :- A(x), x < 10.",
+            ".decl A(x:number)\nA(1).\nA(x+1) :- A(x), x < 10.",
+            ".decl A(x:number)\n.decl B(x:number)\nA(1).\nA(x+1) :- A(x), x < 10.\nB(x) :- A(x).",
+            ".decl B(x:number)\nB(1).\nB(x+1) :- B(x), x < 10."};
+
+    DebugReport report;
+    std::vector<std::string> rendered;
+    for (size_t i = 0; i < versions.size(); ++i) {
+        DebugReportSection section = report.getCodeVersionSection(
+                "datalog", "version", "Version " + std::to_string(i), versions[i]);
+        std::stringstream html;
+        section.printIndex(html);
+        EXPECT_EQ(i == 1, html.str().find("(unchanged)") != std::string::npos);
+
+        // each version reads back as its full dump
+        rendered = readSection(section, rendered);
+        EXPECT_EQ(readSection(DebugReporter::getCodeSection("full", "Full", versions[i]), {}), rendered);
+        EXPECT_EQ(splitString(versions[i], '\n'), rendered);
+    }
+}
+
+}  // namespace test
+}  // namespace souffle
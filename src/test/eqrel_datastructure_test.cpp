@@ -399,6 +399,44 @@ TEST(SparseDjTest, SignedData) {
     EXPECT_EQ(sds.size(), 1);
 }
 
+TEST(SparseDjTest, MixedDomain) {
+    // small non-negative values are mapped directly, all others through the btree
+    souffle::SparseDisjointSet<RamDomain> sds;
+    const RamDomain values[] = {0, 1, 65535, 65536, 1 << 23, (1 << 24) - 1, 1 << 24, MAX_RAM_DOMAIN, -1,
+            MIN_RAM_DOMAIN};
+
+    for (RamDomain v : values) {
+        EXPECT_FALSE(sds.nodeExists(v));
+    }
+    for (RamDomain v : values) {
+        sds.makeNode(v);
+        EXPECT_TRUE(sds.nodeExists(v));
+    }
+    EXPECT_EQ(10, sds.size());
+
+    // dense values are distinct and map back to their sparse values
+    std::set<parent_t> dense;
+    for (RamDomain v : values) {
+        parent_t d = sds.toDense(v);
+        dense.insert(d);
+        EXPECT_EQ(v, sds.toSparse(d));
+    }
+    EXPECT_EQ(10, dense.size());
+    EXPECT_FALSE(sds.nodeExists(2));
+    EXPECT_FALSE(sds.nodeExists(-2));
+
+    sds.unionNodes(0, -1);
+    sds.unionNodes(MAX_RAM_DOMAIN, 1 << 24);
+    sds.unionNodes(-1, 1 << 24);
+    EXPECT_TRUE(sds.contains(0, MAX_RAM_DOMAIN));
+    EXPECT_FALSE(sds.contains(0, 1));
+
+    sds.clear();
+    EXPECT_EQ(0, sds.size());
+    EXPECT_FALSE(sds.nodeExists(0));
+    EXPECT_FALSE(sds.nodeExists(-1));
+}
+
 #ifdef _OPENMP
 TEST(SparseDjTest, ParallelDense) {
     souffle::SparseDisjointSet<size_t> sds;
@@ -0,0 +1,131 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file frozen_set_test.cpp
+ *
+ * A test case testing the read-optimised tuple set of complete relations.
+ *
+ ***********************************************************************/
+
+#include "FrozenSet.h"
+#include "test.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+TEST(FrozenSet, Basic) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    FrozenSet<2> set;
+
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(0, set.size());
+    EXPECT_TRUE(set.begin() == set.end());
+    EXPECT_FALSE(set.contains({{1, 2}}));
+    EXPECT_TRUE(set.lower_bound({{1, 2}}) == set.end());
+
+    set.load({{{-4, 7}}, {{0, 5}}, {{1, 2}}, {{1, 3}}});
+    EXPECT_FALSE(set.empty());
+    EXPECT_EQ(4, set.size());
+    EXPECT_TRUE(set.contains({{1, 2}}));
+    EXPECT_TRUE(set.contains({{-4, 7}}));
+    EXPECT_FALSE(set.contains({{1, 4}}));
+    EXPECT_FALSE(set.contains({{-5, 7}}));
+
+    EXPECT_EQ(Tuple({{0, 5}}), *set.find({{0, 5}}));
+    EXPECT_TRUE(set.find({{0, 6}}) == set.end());
+    EXPECT_EQ(Tuple({{-4, 7}}), *set.lower_bound({{-9, 0}}));
+    EXPECT_EQ(Tuple({{1, 2}}), *set.lower_bound({{0, 6}}));
+    EXPECT_EQ(Tuple({{1, 3}}), *set.upper_bound({{1, 2}}));
+    EXPECT_TRUE(set.lower_bound({{1, 4}}) == set.end());
+    EXPECT_EQ(2, set.countRange(set.lower_bound({{1, 0}}), set.end()));
+
+    // inserts keep the content sorted and free of duplicates
+    EXPECT_TRUE(set.insert({{0, 6}}));
+    EXPECT_FALSE(set.insert({{1, 3}}));
+    std::vector<Tuple> content(set.begin(), set.end());
+    std::vector<Tuple> expected = {{{-4, 7}}, {{0, 5}}, {{0, 6}}, {{1, 2}}, {{1, 3}}};
+    EXPECT_EQ(expected, content);
+
+    set.clear();
+    EXPECT_TRUE(set.empty());
+    EXPECT_FALSE(set.contains({{1, 2}}));
+    EXPECT_TRUE(set.begin() == set.end());
+}
+
+TEST(FrozenSet, Random) {
+    using Tuple = ram::Tuple<RamDomain, 3>;
+    std::set<Tuple> ref;
+
+    std::srand(42);
+    auto gen = []() {
+        Tuple t = {{std::rand() % 10, std::rand() % 1000, std::rand() % 100}};
+        return t;
+    };
+
+    // sets of all sizes around the block boundaries of the search layer
+    for (int n : {1, 31, 32, 33, 64, 100, 1000, 50000}) {
+        while (ref.size() < static_cast<std::size_t>(n)) {
+            ref.insert(gen());
+        }
+        FrozenSet<3> set;
+        set.load(std::vector<Tuple>(ref.begin(), ref.end()));
+        EXPECT_EQ(ref.size(), set.size());
+        EXPECT_TRUE(std::equal(ref.begin(), ref.end(), set.begin()));
+
+        for (int i = 0; i < 10000; i++) {
+            Tuple t = gen();
+            EXPECT_EQ(ref.count(t) == 1, set.contains(t));
+            auto pos = set.lower_bound(t);
+            auto expected = ref.lower_bound(t);
+            EXPECT_EQ(expected == ref.end(), pos == set.end());
+            if (expected != ref.end() && pos != set.end()) {
+                EXPECT_EQ(*expected, *pos);
+            }
+        }
+    }
+}
+
+TEST(FrozenSet, InsertAll) {
+    using Tuple = ram::Tuple<RamDomain, 1>;
+    FrozenSet<1> a;
+    FrozenSet<1> b;
+    std::vector<Tuple> even;
+    std::vector<Tuple> odd;
+    for (int i = 0; i < 1000; i++) {
+        (i % 2 == 0 ? even : odd).push_back({{i}});
+    }
+    a.load(even);
+    b.load(odd);
+
+    a.insertAll(b);
+    EXPECT_EQ(1000, a.size());
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(a.contains({{i}}));
+    }
+    EXPECT_FALSE(a.contains({{1000}}));
+
+    // partitions cover all elements exactly once, in order
+    auto parts = a.partition(7);
+    std::vector<Tuple> content;
+    for (const auto& part : parts) {
+        content.insert(content.end(), part.begin(), part.end());
+    }
+    EXPECT_EQ(1000, content.size());
+    EXPECT_TRUE(std::is_sorted(content.begin(), content.end()));
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -106,5 +106,58 @@ TEST(Graph, Basic) {
     EXPECT_EQ("{1->2,2->3,3->1}", toString(g));
 }
 
+TEST(CompactGraph, Basic) {
+    CompactGraph g(4, {{0, 1}, {1, 2}, {0, 1}, {2, 0}, {1, 3}});
+
+    EXPECT_EQ(4, g.size());
+    EXPECT_EQ(4, g.numEdges());
+
+    EXPECT_TRUE(g.contains(0, 1));
+    EXPECT_FALSE(g.contains(1, 0));
+    EXPECT_TRUE(g.contains(1, 3));
+    EXPECT_TRUE(g.successors(3).empty());
+    EXPECT_EQ(1, g.predecessors(0).end() - g.predecessors(0).begin());
+    EXPECT_EQ(2, *g.predecessors(0).begin());
+
+    EXPECT_EQ("{0->1,1->2,1->3,2->0}", toString(g));
+}
+
+TEST(CompactGraph, SCC) {
+    // two cycles {0, 1, 2} and {4, 5} with a vertex in between and a separate vertex
+    CompactGraph g(7, {{0, 1}, {1, 2}, {2, 0}, {2, 3}, {3, 4}, {4, 5}, {5, 4}});
+    std::vector<size_t> component;
+
+    // components reached come first
+    EXPECT_EQ(4, g.computeSCCs(component));
+    EXPECT_EQ(component[0], component[1]);
+    EXPECT_EQ(component[0], component[2]);
+    EXPECT_EQ(component[4], component[5]);
+    EXPECT_LT(component[4], component[3]);
+    EXPECT_LT(component[3], component[0]);
+
+    // components reaching come first
+    EXPECT_EQ(4, g.computeSCCs(component, true));
+    EXPECT_EQ(0, component[0]);
+    EXPECT_EQ(1, component[3]);
+    EXPECT_EQ(2, component[4]);
+    EXPECT_EQ(3, component[6]);
+}
+
+TEST(CompactGraph, DeepSCC) {
+    // a path too long for a recursive search, closed to a single cycle
+    const size_t n = 1000000;
+    std::vector<CompactGraph::Edge> edges;
+    for (size_t i = 0; i + 1 < n; i++) {
+        edges.emplace_back(i, i + 1);
+    }
+    std::vector<size_t> component;
+    EXPECT_EQ(n, CompactGraph(n, edges).computeSCCs(component));
+    EXPECT_EQ(n - 1, component[0]);
+
+    edges.emplace_back(n - 1, 0);
+    EXPECT_EQ(1, CompactGraph(n, edges).computeSCCs(component));
+    EXPECT_EQ(0, component[n / 2]);
+}
+
 }  // end namespace test
 }  // end namespace souffle
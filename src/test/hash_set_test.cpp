@@ -0,0 +1,157 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file hash_set_test.cpp
+ *
+ * A test case testing the hash-based tuple set.
+ *
+ ***********************************************************************/
+
+#include "HashSet.h"
+#include "test.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+TEST(HashSet, Basic) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    HashSet<2> set;
+
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(0, set.size());
+    EXPECT_TRUE(set.begin() == set.end());
+    EXPECT_FALSE(set.contains({{1, 2}}));
+
+    EXPECT_TRUE(set.insert({{1, 2}}));
+    EXPECT_FALSE(set.insert({{1, 2}}));
+    EXPECT_TRUE(set.insert({{1, 3}}));
+    EXPECT_TRUE(set.insert({{0, 5}}));
+    EXPECT_TRUE(set.insert({{-4, 7}}));
+
+    EXPECT_FALSE(set.empty());
+    EXPECT_EQ(4, set.size());
+    EXPECT_TRUE(set.contains({{1, 2}}));
+    EXPECT_TRUE(set.contains({{-4, 7}}));
+    EXPECT_FALSE(set.contains({{1, 4}}));
+    EXPECT_FALSE(set.contains({{-5, 7}}));
+
+    std::vector<Tuple> content(set.begin(), set.end());
+    std::sort(content.begin(), content.end());
+    std::vector<Tuple> expected = {{{-4, 7}}, {{0, 5}}, {{1, 2}}, {{1, 3}}};
+    EXPECT_EQ(expected, content);
+
+    EXPECT_EQ(Tuple({{0, 5}}), *set.find({{0, 5}}));
+    EXPECT_TRUE(set.find({{0, 6}}) == set.end());
+
+    set.clear();
+    EXPECT_TRUE(set.empty());
+    EXPECT_FALSE(set.contains({{1, 2}}));
+    EXPECT_TRUE(set.begin() == set.end());
+}
+
+TEST(HashSet, Random) {
+    using Tuple = ram::Tuple<RamDomain, 3>;
+    HashSet<3> set;
+    std::set<Tuple> ref;
+
+    std::srand(42);
+    auto gen = []() {
+        Tuple t = {{std::rand() % 10, std::rand() % 1000, std::rand() - RAND_MAX / 2}};
+        return t;
+    };
+
+    HashSet<3>::op_context ctxt;
+    for (int i = 0; i < 50000; i++) {
+        Tuple t = gen();
+        EXPECT_EQ(ref.insert(t).second, set.insert(t, ctxt));
+    }
+    EXPECT_EQ(ref.size(), set.size());
+
+    std::vector<Tuple> content(set.begin(), set.end());
+    std::sort(content.begin(), content.end());
+    EXPECT_TRUE(std::equal(ref.begin(), ref.end(), content.begin()));
+
+    for (int i = 0; i < 10000; i++) {
+        Tuple t = gen();
+        EXPECT_EQ(ref.count(t) == 1, set.contains(t, ctxt));
+    }
+}
+
+TEST(HashSet, Partition) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    HashSet<2> set;
+    EXPECT_TRUE(set.partition(10).empty());
+
+    for (int i = 0; i < 100; i++) {
+        for (int j = 0; j < 100; j++) {
+            set.insert({{i, j}});
+        }
+    }
+
+    // partitions cover all elements exactly once
+    for (std::size_t num : {1, 7, 64, 400, 5000}) {
+        auto parts = set.partition(num);
+        EXPECT_FALSE(parts.size() < std::min<std::size_t>(num, 64));
+        std::vector<Tuple> content;
+        for (const auto& part : parts) {
+            content.insert(content.end(), part.begin(), part.end());
+        }
+        EXPECT_EQ(10000, content.size());
+        std::sort(content.begin(), content.end());
+        EXPECT_TRUE(std::unique(content.begin(), content.end()) == content.end());
+    }
+}
+
+TEST(HashSet, Parallel) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    HashSet<2> set;
+    const int N = 100000;
+
+    std::vector<Tuple> data;
+    for (int i = 0; i < N; i++) {
+        data.push_back({{i % 317, i}});
+    }
+    std::random_shuffle(data.begin(), data.end());
+
+#pragma omp parallel for
+    for (int i = 0; i < N; i++) {
+        set.insert(data[i]);
+    }
+
+    EXPECT_EQ(N, set.size());
+    std::vector<Tuple> content(set.begin(), set.end());
+    std::sort(content.begin(), content.end());
+    std::sort(data.begin(), data.end());
+    EXPECT_EQ(data, content);
+}
+
+TEST(HashSet, InsertAll) {
+    HashSet<2> a;
+    HashSet<2> b;
+    for (int i = 0; i < 1000; i++) {
+        a.insert({{i, i}});
+        b.insert({{i, 2 * i}});
+    }
+    a.insertAll(b);
+    EXPECT_EQ(1999, a.size());
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(a.contains({{i, 2 * i}}));
+    }
+}
+
+}  // namespace test
+
+}  // namespace souffle
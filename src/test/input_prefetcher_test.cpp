@@ -0,0 +1,84 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file input_prefetcher_test.cpp
+ *
+ * Tests the inputs read on background threads ahead of their loads.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "InputPrefetcher.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+/** A relation collecting the inserted tuples */
+struct Collector {
+    size_t arity;
+    std::vector<std::vector<RamDomain>> tuples;
+
+    void insert(const RamDomain* tuple) {
+        tuples.emplace_back(tuple, tuple + arity);
+    }
+};
+
+TEST(InputPrefetcher, Load) {
+    InputPrefetcher prefetcher;
+    for (size_t input = 0; input < 10; ++input) {
+        prefetcher.prefetch(InputPrefetcher::key("a", input), 2, [input](TupleBuffer& tuples) {
+            for (RamDomain i = 0; i < 1000; ++i) {
+                RamDomain tuple[2] = {static_cast<RamDomain>(input), i};
+                tuples.insert(tuple);
+            }
+        });
+    }
+    for (size_t input = 10; input-- > 0;) {
+        Collector relation{2, {}};
+        EXPECT_TRUE(prefetcher.load(InputPrefetcher::key("a", input), relation));
+        EXPECT_EQ(1000, relation.tuples.size());
+        EXPECT_EQ(input, relation.tuples[999][0]);
+        EXPECT_EQ(999, relation.tuples[999][1]);
+    }
+
+    // inputs not prefetched, or loaded before, are read by the loads themselves
+    Collector relation{2, {}};
+    EXPECT_FALSE(prefetcher.load(InputPrefetcher::key("a", 0), relation));
+    EXPECT_FALSE(prefetcher.load(InputPrefetcher::key("b", 0), relation));
+    EXPECT_EQ(0, relation.tuples.size());
+}
+
+TEST(InputPrefetcher, Nullary) {
+    InputPrefetcher prefetcher;
+    prefetcher.prefetch("n", 0, [](TupleBuffer& tuples) { tuples.insert(nullptr); });
+    Collector relation{0, {}};
+    EXPECT_TRUE(prefetcher.load("n", relation));
+    EXPECT_EQ(1, relation.tuples.size());
+}
+
+TEST(InputPrefetcher, Error) {
+    InputPrefetcher prefetcher;
+    prefetcher.prefetch("e", 1, [](TupleBuffer&) { throw std::invalid_argument("cannot read"); });
+    Collector relation{1, {}};
+    bool thrown = false;
+    try {
+        prefetcher.load("e", relation);
+    } catch (std::invalid_argument& e) {
+        thrown = std::string(e.what()) == "cannot read";
+    }
+    EXPECT_TRUE(thrown);
+}
+
+}  // end namespace test
@@ -0,0 +1,97 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file insert_buffer_test.cpp
+ *
+ * Tests for the thread-private insertion buffers of InsertBuffer.h.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "InsertBuffer.h"
+#include "RamTypes.h"
+
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+using Row = std::vector<RamDomain>;
+
+TEST(InsertBuffer, Basic) {
+    InsertBuffer buffer(2);
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(2, buffer.getArity());
+
+    RamDomain a[] = {3, 1};
+    RamDomain b[] = {1, 2};
+    RamDomain c[] = {1, 1};
+    EXPECT_FALSE(buffer.insert(a));
+    EXPECT_FALSE(buffer.insert(b));
+    EXPECT_FALSE(buffer.insert(a));
+    EXPECT_FALSE(buffer.insert(c));
+    EXPECT_EQ(4, buffer.size());
+
+    // flushed tuples are distinct and sorted
+    std::vector<Row> rows;
+    buffer.flush([&](const RamDomain* tuple) { rows.push_back(Row(tuple, tuple + 2)); });
+    EXPECT_EQ((std::vector<Row>{{1, 1}, {1, 2}, {3, 1}}), rows);
+    EXPECT_TRUE(buffer.empty());
+
+    // an empty buffer passes nothing
+    rows.clear();
+    buffer.flush([&](const RamDomain* tuple) { rows.push_back(Row(tuple, tuple + 2)); });
+    EXPECT_TRUE(rows.empty());
+}
+
+TEST(InsertBuffer, Compaction) {
+    // duplicates are removed when the capacity is reached, keeping the buffer small
+    InsertBuffer buffer(1, 16);
+    for (RamDomain i = 0; i < 1000; ++i) {
+        RamDomain tuple[] = {i % 4};
+        EXPECT_FALSE(buffer.insert(tuple));
+        EXPECT_TRUE(buffer.size() <= 16);
+    }
+
+    std::vector<RamDomain> values;
+    buffer.flush([&](const RamDomain* tuple) { values.push_back(*tuple); });
+    EXPECT_EQ((std::vector<RamDomain>{0, 1, 2, 3}), values);
+}
+
+TEST(InsertBuffer, Spill) {
+    // distinct tuples fill the buffer, which then asks to be flushed
+    const size_t capacity = 64;
+    InsertBuffer buffer(3, capacity);
+    std::set<Row> flushed;
+    auto insert = [&](const RamDomain* tuple) { flushed.insert(Row(tuple, tuple + 3)); };
+
+    size_t spills = 0;
+    for (RamDomain i = 0; i < 1000; ++i) {
+        RamDomain tuple[] = {i % 7, i, -i};
+        if (buffer.insert(tuple)) {
+            ++spills;
+            EXPECT_EQ(capacity, buffer.size());
+            buffer.flush(insert);
+        }
+    }
+    buffer.flush(insert);
+
+    EXPECT_EQ(1000 / capacity, spills);
+    EXPECT_EQ(1000, flushed.size());
+    for (RamDomain i = 0; i < 1000; ++i) {
+        EXPECT_EQ(1, flushed.count(Row{i % 7, i, -i}));
+    }
+}
+
+}  // end namespace test
+}  // end namespace souffle
@@ -0,0 +1,141 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file leapfrog_join_test.cpp
+ *
+ * A test case testing the intersection of ordered sets of values.
+ *
+ ***********************************************************************/
+
+#include "LeapfrogJoin.h"
+#include "test.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+namespace {
+
+// creates a seek function over the given set, counting its invocations
+LeapfrogJoin::Seek seekIn(const std::set<RamDomain>& set, int& calls) {
+    return [&set, &calls](RamDomain& value) {
+        calls++;
+        auto pos = set.lower_bound(value);
+        if (pos == set.end()) {
+            return false;
+        }
+        value = *pos;
+        return true;
+    };
+}
+
+std::vector<RamDomain> enumerate(LeapfrogJoin& join) {
+    std::vector<RamDomain> res;
+    while (join.next()) {
+        res.push_back(join.get());
+    }
+    return res;
+}
+
+}  // namespace
+
+TEST(LeapfrogJoin, Basic) {
+    std::set<RamDomain> a = {1, 3, 4, 7, 8, 10};
+    std::set<RamDomain> b = {0, 3, 7, 9, 10, 12};
+    std::set<RamDomain> c = {3, 5, 7, 10};
+    int calls = 0;
+
+    LeapfrogJoin join({seekIn(a, calls), seekIn(b, calls), seekIn(c, calls)});
+    std::vector<RamDomain> expected = {3, 7, 10};
+    EXPECT_EQ(expected, enumerate(join));
+
+    // the join stays exhausted
+    EXPECT_FALSE(join.next());
+}
+
+TEST(LeapfrogJoin, Empty) {
+    std::set<RamDomain> a = {1, 2, 3};
+    std::set<RamDomain> b = {4, 5, 6};
+    std::set<RamDomain> none;
+    int calls = 0;
+
+    LeapfrogJoin disjoint({seekIn(a, calls), seekIn(b, calls)});
+    EXPECT_FALSE(disjoint.next());
+
+    LeapfrogJoin withEmpty({seekIn(a, calls), seekIn(none, calls)});
+    EXPECT_FALSE(withEmpty.next());
+
+    LeapfrogJoin noSets({});
+    EXPECT_FALSE(noSets.next());
+}
+
+TEST(LeapfrogJoin, Single) {
+    std::set<RamDomain> a = {MIN_RAM_DOMAIN, -5, 0, 42, MAX_RAM_DOMAIN};
+    int calls = 0;
+
+    // a single set is enumerated entirely, including the extreme values
+    LeapfrogJoin join({seekIn(a, calls)});
+    std::vector<RamDomain> expected(a.begin(), a.end());
+    EXPECT_EQ(expected, enumerate(join));
+}
+
+TEST(LeapfrogJoin, Skew) {
+    std::set<RamDomain> small = {500, 50000, 99999};
+    std::set<RamDomain> large;
+    for (RamDomain i = 0; i < 100000; i++) {
+        large.insert(i);
+    }
+    int calls = 0;
+
+    // the large set is only sought for the candidates of the small one
+    LeapfrogJoin join({seekIn(large, calls), seekIn(small, calls)});
+    std::vector<RamDomain> expected(small.begin(), small.end());
+    EXPECT_EQ(expected, enumerate(join));
+    EXPECT_TRUE(calls < 20);
+}
+
+TEST(LeapfrogJoin, Random) {
+    std::srand(7);
+    for (int round = 0; round < 20; round++) {
+        std::vector<std::set<RamDomain>> sets(1 + round % 4);
+        for (auto& set : sets) {
+            for (int i = 0; i < 1000; i++) {
+                set.insert(std::rand() % 2000 - 1000);
+            }
+        }
+
+        // compute the expected intersection
+        std::set<RamDomain> expected = sets[0];
+        for (const auto& set : sets) {
+            std::set<RamDomain> cur;
+            std::set_intersection(expected.begin(), expected.end(), set.begin(), set.end(),
+                    std::inserter(cur, cur.begin()));
+            expected = cur;
+        }
+
+        int calls = 0;
+        std::vector<LeapfrogJoin::Seek> seeks;
+        for (const auto& set : sets) {
+            seeks.push_back(seekIn(set, calls));
+        }
+        LeapfrogJoin join(seeks);
+        EXPECT_EQ(std::vector<RamDomain>(expected.begin(), expected.end()), enumerate(join));
+    }
+}
+
+}  // namespace test
+
+}  // namespace souffle
@@ -0,0 +1,55 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file lvm_code_test.cpp
+ *
+ * Tests the encoding of values in LVM code.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "LVMCode.h"
+#include "SymbolTable.h"
+#include <limits>
+
+using namespace souffle;
+
+namespace test {
+
+TEST(LVMCode, Words) {
+    EXPECT_EQ(4, sizeof(LVMWord));
+    EXPECT_EQ(sizeof(RamDomain) / sizeof(LVMWord), LVMCode::DOMAIN_WORDS);
+    EXPECT_EQ(32, LVMCode::MASK_BITS);
+}
+
+TEST(LVMCode, Domain) {
+    SymbolTable symbols;
+    LVMCode code(symbols);
+    const RamDomain values[] = {0, 1, -1, 42, std::numeric_limits<RamDomain>::max(),
+            std::numeric_limits<RamDomain>::min()};
+    for (RamDomain value : values) {
+        code.push_back(LVM_Number);
+        code.pushDomain(value);
+    }
+    EXPECT_EQ(6 * (1 + LVMCode::DOMAIN_WORDS), code.size());
+    size_t ip = 0;
+    for (RamDomain value : values) {
+        EXPECT_EQ(LVM_Number, code[ip]);
+        EXPECT_EQ(value, code.getDomain(ip + 1));
+        ip += 1 + LVMCode::DOMAIN_WORDS;
+    }
+
+    EXPECT_TRUE(LVMCode::fitsWord(-1));
+    EXPECT_TRUE(LVMCode::fitsWord(std::numeric_limits<LVMWord>::max()));
+    EXPECT_EQ(LVMCode::DOMAIN_WORDS == 1, LVMCode::fitsWord(std::numeric_limits<RamDomain>::max()));
+}
+
+}  // end namespace test
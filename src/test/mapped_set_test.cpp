@@ -0,0 +1,125 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file mapped_set_test.cpp
+ *
+ * A test case testing the tuple set stored in memory-mapped files.
+ *
+ ***********************************************************************/
+
+#include "MappedSet.h"
+#include "test.h"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+TEST(MappedSet, Basic) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    MappedSet<2> set;
+
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(0, set.size());
+    EXPECT_TRUE(set.begin() == set.end());
+    EXPECT_FALSE(set.contains({{1, 2}}));
+
+    set.insert({{1, 2}});
+    set.insert({{1, 2}});
+    set.insert({{1, 3}});
+    set.insert({{0, 5}});
+    set.insert({{-4, 7}});
+
+    EXPECT_FALSE(set.empty());
+    EXPECT_EQ(4, set.size());
+    EXPECT_TRUE(set.contains({{1, 2}}));
+    EXPECT_TRUE(set.contains({{-4, 7}}));
+    EXPECT_FALSE(set.contains({{1, 4}}));
+    EXPECT_FALSE(set.contains({{-5, 7}}));
+
+    std::vector<Tuple> content(set.begin(), set.end());
+    std::vector<Tuple> expected = {{{-4, 7}}, {{0, 5}}, {{1, 2}}, {{1, 3}}};
+    EXPECT_EQ(expected, content);
+
+    EXPECT_EQ(Tuple({{0, 5}}), *set.find({{0, 5}}));
+    EXPECT_TRUE(set.find({{0, 6}}) == set.end());
+
+    auto range = set.getBoundaries<1>({{1, 0}});
+    EXPECT_EQ(2, std::distance(range.begin(), range.end()));
+    EXPECT_EQ(Tuple({{1, 2}}), *range.begin());
+    EXPECT_EQ(4, std::distance(set.getBoundaries<0>({{1, 0}}).begin(), set.end()));
+    EXPECT_TRUE(set.getBoundaries<2>({{1, 4}}).empty());
+
+    // tuples inserted after reads are merged into the content
+    set.insert({{1, 1}});
+    set.insert({{0, 5}});
+    EXPECT_EQ(5, set.size());
+    EXPECT_EQ(Tuple({{1, 1}}), *set.lower_bound({{1, 0}}));
+    EXPECT_EQ(Tuple({{1, 3}}), *set.upper_bound({{1, 2}}));
+
+    set.clear();
+    EXPECT_TRUE(set.empty());
+    EXPECT_FALSE(set.contains({{1, 2}}));
+}
+
+TEST(MappedSet, Hints) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    MappedSet<2> set;
+    for (RamDomain i = 0; i < 1000; ++i) {
+        set.insert({{i / 10, i % 10}});
+    }
+
+    MappedSet<2>::op_context ctxt;
+    for (RamDomain i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(set.contains({{i / 10, i % 10}}, ctxt));
+    }
+
+    std::size_t count = 0;
+    for (const auto& part : set.partition(7)) {
+        for (const Tuple& cur : part) {
+            EXPECT_EQ(Tuple({{RamDomain(count / 10), RamDomain(count % 10)}}), cur);
+            ++count;
+        }
+    }
+    EXPECT_EQ(1000, count);
+}
+
+TEST(MappedSet, Mapped) {
+    using Tuple = ram::Tuple<RamDomain, 1>;
+    MappedSet<1> set;
+    const RamDomain n = 2 * MappedSet<1>::RUN_SIZE + 1000;
+
+    // written in several sorted runs, overlapping each other
+    for (RamDomain i = 0; i < n; ++i) {
+        set.insert({{RamDomain((int64_t(i) * 7919) % (n / 2))}});
+    }
+    EXPECT_EQ(n / 2, set.size());
+    RamDomain expected = 0;
+    for (const Tuple& cur : set) {
+        EXPECT_EQ(expected, cur[0]);
+        ++expected;
+    }
+    EXPECT_EQ(n / 2, expected);
+
+    // the content of the file is merged with new tuples
+    set.insert({{-1}});
+    set.insert({{0}});
+    EXPECT_EQ(n / 2 + 1, set.size());
+    EXPECT_TRUE(set.contains({{-1}}));
+    EXPECT_TRUE(set.contains({{n / 2 - 1}}));
+    EXPECT_FALSE(set.contains({{n / 2}}));
+    EXPECT_LT(set.getMemoryUsage(), sizeof(Tuple) * MappedSet<1>::RUN_SIZE);
+}
+
+}  // namespace test
+}  // end namespace souffle
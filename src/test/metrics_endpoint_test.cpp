@@ -0,0 +1,71 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file metrics_endpoint_test.cpp
+ *
+ * Tests the metrics of running programs gathered from profile events.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "MetricsEndpoint.h"
+#include <sstream>
+#include <string>
+
+using namespace souffle;
+
+namespace test {
+
+static bool contains(const std::string& text, const std::string& line) {
+    return text.find(line + "\n") != std::string::npos;
+}
+
+TEST(MetricsEndpoint, Print) {
+    MetricsEndpoint& metrics = MetricsEndpoint::instance();
+    metrics.observeConfig("strataCount", "3");
+
+    // a non-recursive stratum loading edge
+    metrics.observeTiming("@t-nonrecursive-relation;edge;file.dl [1:1-1:10];", 10, 0);
+    metrics.observeQuantity("@n-nonrecursive-relation;edge;file.dl [1:1-1:10];", 10, 0);
+    metrics.observeQuantity("@memory;symbols", 128, 0);
+    metrics.observeQuantity("@memory;records", 64, 0);
+
+    // two iterations of a recursive stratum computing path, the rules not counting on their own
+    metrics.observeTiming("@t-recursive-relation;path;file.dl [2:1-2:10];", 8, 0);
+    metrics.observeTiming("@t-recursive-rule;path;0;file.dl [3:1-3:30];path(x,y) :- edge(x,y).;", 8, 0);
+    metrics.observeTiming("@t-recursive-relation;path;file.dl [2:1-2:10];", 2, 1);
+
+    std::stringstream out;
+    metrics.print(out);
+    const std::string text = out.str();
+    EXPECT_TRUE(contains(text, "# TYPE souffle_stratum gauge"));
+    EXPECT_TRUE(contains(text, "souffle_stratum 1"));
+    EXPECT_TRUE(contains(text, "souffle_strata 3"));
+    EXPECT_TRUE(contains(text, "souffle_strata_completed 1"));
+    EXPECT_TRUE(contains(text, "souffle_iteration 1"));
+    EXPECT_TRUE(contains(text, "souffle_relation_tuples{relation=\"edge\"} 10"));
+    EXPECT_TRUE(contains(text, "souffle_relation_tuples{relation=\"path\"} 10"));
+    EXPECT_TRUE(contains(text, "souffle_tuples_inserted_total 20"));
+    EXPECT_TRUE(contains(text, "souffle_symbol_table_bytes 128"));
+    EXPECT_TRUE(contains(text, "souffle_record_bytes 64"));
+    EXPECT_TRUE(contains(text, "souffle_stratum_progress{stratum=\"0\"} 1"));
+    EXPECT_TRUE(contains(text, "souffle_stratum_progress{stratum=\"1\"} 0.75"));
+
+    // the end of the recursive stratum starts the next one
+    metrics.observeQuantity("@memory;symbols", 256, 1);
+    std::stringstream next;
+    metrics.print(next);
+    EXPECT_TRUE(contains(next.str(), "souffle_stratum 2"));
+    EXPECT_TRUE(contains(next.str(), "souffle_iteration 0"));
+    EXPECT_TRUE(contains(next.str(), "souffle_stratum_progress{stratum=\"2\"} 0"));
+}
+
+}  // end namespace test
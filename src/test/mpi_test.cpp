@@ -14,9 +14,14 @@
  *
  ***********************************************************************/
 
+#include <array>
+#include <cstdint>
+#include <sstream>
+#include <set>
 #include <vector>
 
 #include "Mpi.h"
+#include "RamMpiScheduleAnalysis.h"
 #include "test.h"
 
 namespace souffle {
@@ -31,5 +36,139 @@ TEST(mpi, mpi) {
         EXPECT_EQ(mpi::commSize(), 1);
     }
 }
+
+/** a relation of pairs with the interface of compiled relations used for exchanging tuples */
+struct PairRelation {
+    using tuple = std::array<int, 2>;
+    std::set<tuple> tuples;
+
+    bool insert(const int* element) {
+        return tuples.insert(tuple{{element[0], element[1]}}).second;
+    }
+    void purge() {
+        tuples.clear();
+    }
+    bool empty() const {
+        return tuples.empty();
+    }
+    std::set<tuple>::const_iterator begin() const {
+        return tuples.begin();
+    }
+    std::set<tuple>::const_iterator end() const {
+        return tuples.end();
+    }
+};
+
+TEST(mpi, owner) {
+    std::set<int> owners;
+    for (int i = 0; i < 100; ++i) {
+        const std::array<int, 2> tuple{{i, i + 1}};
+        const int owner = mpi::owner(tuple, 2, 4);
+        EXPECT_TRUE(0 <= owner && owner < 4);
+        EXPECT_EQ(owner, mpi::owner(tuple, 2, 4));
+        owners.insert(owner);
+    }
+    // the tuples are spread over all ranks
+    EXPECT_EQ(owners.size(), 4);
+}
+
+TEST(mpi, partition) {
+    mpi::splitGroup(0);
+    EXPECT_EQ(mpi::groupSize(), 1);
+    EXPECT_EQ(mpi::groupRank(), 0);
+
+    // a single rank owns all tuples
+    PairRelation relation;
+    for (int i = 0; i < 10; ++i) {
+        const int element[] = {i, i % 3};
+        relation.insert(element);
+    }
+    mpi::exchange<int>(relation, 2);
+    EXPECT_EQ(relation.tuples.size(), 10);
+    mpi::partition<int>(relation, 2);
+    EXPECT_EQ(relation.tuples.size(), 10);
+    mpi::broadcast<int>(relation, 2);
+    EXPECT_EQ(relation.tuples.size(), 10);
+}
+TEST(mpi, encode) {
+    const std::vector<int> elements = {0, 1, 2, 2, -1, 1000, -1000000, INT32_MAX, INT32_MIN, 7};
+    for (const bool delta : {false, true}) {
+        std::vector<char> buffer;
+        int previous = 0;
+        for (const int element : elements) {
+            mpi::encode<int>(buffer, element, previous, delta);
+        }
+        const char* pos = buffer.data();
+        previous = 0;
+        for (const int element : elements) {
+            EXPECT_EQ(element, mpi::decode<int>(pos, previous, delta));
+        }
+        EXPECT_EQ(pos, buffer.data() + buffer.size());
+    }
+
+    // the small differences of sorted elements take a single byte each
+    std::vector<char> buffer;
+    int previous = 0;
+    for (int i = 0; i < 100; ++i) {
+        mpi::encode<int>(buffer, 1000 + i, previous, true);
+    }
+    EXPECT_EQ(buffer.size(), 2 + 99);
+}
+TEST(mpi, shared) {
+    PairRelation relation;
+    for (int i = 0; i < 100; ++i) {
+        const int element[] = {i, -i};
+        relation.insert(element);
+    }
+    // two readers on the node of the sender read the same copy, the last one removes it
+    const std::string name = "/souffle.test." + std::to_string(getpid());
+    mpi::sendShared<int>(relation, 2, 2, name);
+    for (int reader = 0; reader < 2; ++reader) {
+        PairRelation received;
+        mpi::recvShared<int>(received, 2, name);
+        EXPECT_TRUE(received.tuples == relation.tuples);
+    }
+    EXPECT_TRUE(shm_open(name.c_str(), O_RDONLY, 0600) < 0);
+}
+
+TEST(mpi, threads) {
+    // the threads are shared by cost, each rank keeping one
+    EXPECT_EQ(mpi::shareThreads({3, 1}, 10), std::vector<size_t>({7, 3}));
+    EXPECT_EQ(mpi::shareThreads({0, 100, 0}, 8), std::vector<size_t>({1, 6, 1}));
+    EXPECT_EQ(mpi::shareThreads({5, 5, 5}, 2), std::vector<size_t>({1, 1, 1}));
+    EXPECT_EQ(mpi::shareThreads({0, 0}, 6), std::vector<size_t>({3, 3}));
+}
+
+TEST(mpi, hostfile) {
+    std::istringstream in("a slots=4\nb:2 # two slots\n# c slots=8\n\nd max_slots=3\n");
+    EXPECT_EQ(parseHostfile(in), std::vector<size_t>({4, 2, 1}));
+}
+
+TEST(mpi, schedule) {
+    // independent expensive strata are placed on separate nodes
+    {
+        MpiScheduler scheduler({100, 100, 1, 1}, {}, {3, 3}, {});
+        EXPECT_NE(scheduler.getNode(scheduler.getRank(0)), scheduler.getNode(scheduler.getRank(1)));
+        EXPECT_TRUE(scheduler.getNumberOfRanks() <= 6);
+    }
+
+    // a chain of strata sending large relations is packed onto a single rank
+    {
+        MpiScheduler scheduler({10, 10, 10}, {{0, 1, 1e6}, {1, 2, 1e6}}, {4}, {});
+        EXPECT_EQ(scheduler.getRank(0), scheduler.getRank(1));
+        EXPECT_EQ(scheduler.getRank(1), scheduler.getRank(2));
+        EXPECT_EQ(scheduler.getNumberOfRanks(), 2);
+        EXPECT_EQ(scheduler.getMakespan(), 30);
+    }
+
+    // fewer slots than strata pack the strata, exclusive strata keep a rank of their own
+    {
+        MpiScheduler scheduler({1, 1, 1, 1}, {}, {3}, {false, true, false, false});
+        for (size_t i : {0, 2, 3}) {
+            EXPECT_NE(scheduler.getRank(i), scheduler.getRank(1));
+        }
+        EXPECT_EQ(scheduler.getNumberOfRanks(), 3);
+    }
+}
 }  // namespace test
 }  // namespace souffle
@@ -0,0 +1,62 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file numa_test.cpp
+ *
+ * Tests for the placement of threads and memory in Numa.h.
+ *
+ ***********************************************************************/
+
+#include "Numa.h"
+#include "test.h"
+
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+TEST(numa, ParseList) {
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 8, 10, 11}), numa::parseList("0-3,8,10-11\n"));
+    EXPECT_EQ((std::vector<int>{5}), numa::parseList("5"));
+    EXPECT_TRUE(numa::parseList("").empty());
+}
+
+TEST(numa, Nodes) {
+    const std::vector<numa::Node>& nodes = numa::getNodes();
+    EXPECT_FALSE(nodes.empty());
+    for (const numa::Node& node : nodes) {
+        EXPECT_FALSE(node.cpus.empty());
+    }
+}
+
+TEST(numa, Enable) {
+    EXPECT_FALSE(numa::isEnabled());
+    numa::enable(numa::Placement::LOCAL);
+    EXPECT_TRUE(numa::isEnabled());
+
+    // every thread is pinned to one of the nodes, consecutive threads sharing a node
+    std::set<int> ids;
+    for (const numa::Node& node : numa::getNodes()) {
+        ids.insert(node.id);
+    }
+    EXPECT_EQ(1, ids.count(numa::getNodeOfThread(0)));
+    EXPECT_EQ(-1, numa::getNodeOfThread(1 << 20));
+
+    // the pages of memory in use are on one of the nodes if the kernel reports them
+    std::vector<int> data(1024, 1);
+    const std::vector<int> owners = numa::getNodesOfAddresses({data.data()});
+    EXPECT_EQ(1, owners.size());
+    EXPECT_TRUE(owners[0] == -1 || ids.count(owners[0]) == 1);
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -15,8 +15,12 @@
  ***********************************************************************/
 
 #include "ParallelUtils.h"
+#include "Util.h"
 #include "test.h"
 
+#include <atomic>
+#include <vector>
+
 namespace souffle {
 
 namespace test {
@@ -38,6 +42,47 @@ TEST(ParallelUtils, SpinLock) {
     EXPECT_EQ(N, c);
 }
 
+TEST(ParallelUtils, AdaptiveLock) {
+    const int N = 1000000;
+
+    AdaptiveLock lock;
+
+    volatile int c = 0;
+
+    // more threads than processors, such that waiters are suspended
+#pragma omp parallel for num_threads(16)
+    for (int i = 0; i < N; i++) {
+        lock.lock();
+        c++;
+        lock.unlock();
+    }
+
+    EXPECT_EQ(N, c);
+}
+
+TEST(ParallelUtils, LockStatistics) {
+    const int N = 1000;
+
+    const uint64_t before = getLockCount(LockSite::RECORDS, LockEvent::ACQUISITION);
+    const uint64_t others = getLockCount(LockSite::OTHER, LockEvent::ACQUISITION);
+
+    Lock lock;
+#pragma omp parallel for num_threads(4)
+    for (int i = 0; i < N; i++) {
+        LockSiteScope site(LockSite::RECORDS);
+        auto lease = lock.acquire();
+        (void)lease;
+    }
+
+#ifdef USE_LOCK_STATS
+    EXPECT_EQ(before + N, getLockCount(LockSite::RECORDS, LockEvent::ACQUISITION));
+#else
+    EXPECT_EQ(0, before);
+    EXPECT_EQ(0, getLockCount(LockSite::RECORDS, LockEvent::ACQUISITION));
+#endif
+    EXPECT_EQ(others, getLockCount(LockSite::OTHER, LockEvent::ACQUISITION));
+}
+
 TEST(ParallelUtils, ReadWriteLock) {
     const int N = 1000000;
     const int K = 10;
@@ -91,5 +136,105 @@ TEST(ParallelUtils, OptimisticReadWriteLock) {
 
     EXPECT_EQ(2 * (N / K), c);
 }
+TEST(ParallelUtils, StealingRanges) {
+    const int N = 100000;
+
+    // a single large chunk followed by a few small ones
+    std::vector<int> data(N);
+    for (int i = 0; i < N; i++) {
+        data[i] = i;
+    }
+    using iter = std::vector<int>::const_iterator;
+    std::vector<range<iter>> part;
+    part.push_back(range<iter>(data.begin(), data.begin() + N - 30));
+    for (int i = N - 30; i < N; i += 10) {
+        part.push_back(range<iter>(data.begin() + i, data.begin() + i + 10));
+    }
+    part.push_back(range<iter>(data.end(), data.end()));
+
+    std::vector<std::atomic<int>> visits(N);
+    for (auto& cur : visits) {
+        cur = 0;
+    }
+
+    StealingRanges<decltype(part)> ranges(part);
+#pragma omp parallel num_threads(4)
+    {
+        for (decltype(ranges)::Cursor cursor(ranges); cursor.next();) {
+            visits[cursor.get()]++;
+        }
+    }
+
+    int violations = 0;
+    for (auto& cur : visits) {
+        violations += (cur != 1);
+    }
+    EXPECT_EQ(0, violations);
+}
+
+TEST(ParallelUtils, ParallelPolicy) {
+    using iter = std::vector<int>::const_iterator;
+    std::vector<int> data(10000);
+    auto getTeamSize = [&](size_t n) {
+        std::vector<range<iter>> part;
+        part.push_back(range<iter>(data.begin(), data.begin() + n / 2));
+        part.push_back(range<iter>(data.begin() + n / 2, data.begin() + n));
+        return ParallelRegion(part).getTeamSize();
+    };
+
+    // regions below two grains run sequentially, larger ones by a team of one thread per grain
+    ParallelPolicy& policy = ParallelPolicy::instance();
+    policy.setJobs(4);
+    EXPECT_FALSE(policy.isTuning());
+    const size_t grain = ParallelPolicy::DEFAULT_GRAIN;
+    EXPECT_EQ(1, getTeamSize(0));
+    EXPECT_EQ(1, getTeamSize(12));
+    EXPECT_EQ(1, getTeamSize(2 * grain - 1));
+    EXPECT_EQ(2, getTeamSize(2 * grain));
+    EXPECT_EQ(3, getTeamSize(3 * grain + 1));
+    EXPECT_EQ(4, getTeamSize(10000));
+
+#ifdef _OPENMP
+    // the grain is tuned within the bounds during the first regions
+    policy.setJobs(0);
+    for (size_t i = 0; i < ParallelPolicy::TUNING_REGIONS; i++) {
+        int team = getTeamSize(1000);
+        EXPECT_TRUE(team >= 1 && team <= MAX_THREADS);
+    }
+    EXPECT_FALSE(policy.isTuning());
+    EXPECT_LT(0, getTeamSize(10000));
+#endif
+    policy.setJobs(1);
+    EXPECT_EQ(1, getTeamSize(10000));
+}
+
+#ifdef _OPENMP
+TEST(ParallelUtils, StealingRangesBreak) {
+    const int N = 10000;
+
+    std::vector<int> data(N);
+    using iter = std::vector<int>::const_iterator;
+    std::vector<range<iter>> part;
+    for (int i = 0; i < N; i += 100) {
+        part.push_back(range<iter>(data.begin() + i, data.begin() + i + 100));
+    }
+
+    // the chunks of a thread leaving its loop are taken by the others
+    std::atomic<int> count(0);
+    std::atomic<bool> left(false);
+    StealingRanges<decltype(part)> ranges(part);
+#pragma omp parallel num_threads(4)
+    {
+        for (decltype(ranges)::Cursor cursor(ranges); cursor.next();) {
+            count++;
+            if (!left.exchange(true)) {
+                break;
+            }
+        }
+    }
+
+    ASSERT_LE(N - 100, count.load());
+}
+#endif
 }  // namespace test
 }  // end namespace souffle
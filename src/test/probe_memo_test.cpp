@@ -0,0 +1,75 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file probe_memo_test.cpp
+ *
+ * A test case testing the memo of the last probe of an index.
+ *
+ ***********************************************************************/
+
+#include "BTree.h"
+#include "CompiledTuple.h"
+#include "ProbeMemo.h"
+#include "Util.h"
+#include "test.h"
+
+namespace souffle {
+
+namespace test {
+
+using Tuple = ram::Tuple<RamDomain, 2>;
+using Set = btree_set<Tuple>;
+
+TEST(ProbeMemo, Range) {
+    Set set;
+    for (int i = 0; i < 100; i++) {
+        set.insert({{i / 10, i}});
+    }
+
+    int probes = 0;
+    auto search = [&](const Tuple& key) {
+        probes++;
+        return range<Set::iterator>(set.lower_bound({{key[0], 0}}), set.lower_bound({{key[0] + 1, 0}}));
+    };
+    ProbeMemo<Tuple, range<Set::iterator>> memo;
+
+    // probes of outer tuples in order descend the index once per key
+    int count = 0;
+    for (const auto& outer : set) {
+        auto inner = memo.get({{outer[0], 0}}, search);
+        for (const auto& cur : inner) {
+            EXPECT_EQ(outer[0], cur[0]);
+            count++;
+        }
+    }
+    EXPECT_EQ(1000, count);
+    EXPECT_EQ(10, probes);
+    EXPECT_EQ(90, memo.getHits());
+}
+
+TEST(ProbeMemo, Flag) {
+    int probes = 0;
+    auto even = [&](const Tuple& key) {
+        probes++;
+        return key[0] % 2 == 0;
+    };
+    ProbeMemo<Tuple, bool> memo;
+
+    EXPECT_TRUE(memo.get({{2, 0}}, even));
+    EXPECT_TRUE(memo.get({{2, 0}}, even));
+    EXPECT_FALSE(memo.get({{3, 0}}, even));
+    EXPECT_TRUE(memo.get({{2, 0}}, even));
+    EXPECT_TRUE(memo.get({{2, 1}}, even));
+    EXPECT_EQ(4, probes);
+    EXPECT_EQ(1, memo.getHits());
+}
+
+}  // namespace test
+}  // namespace souffle
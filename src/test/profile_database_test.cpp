@@ -0,0 +1,96 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file profile_database_test.cpp
+ *
+ * A test case testing the streaming reader of profile databases.
+ *
+ ***********************************************************************/
+
+#include "ProfileDatabase.h"
+#include "test.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace souffle {
+
+namespace test {
+
+using profile::DirectoryEntry;
+using profile::DurationEntry;
+using profile::ProfileDatabase;
+using profile::SizeEntry;
+using profile::TextEntry;
+using profile::TimeEntry;
+
+TEST(ProfileDatabase, RoundTrip) {
+    ProfileDatabase db;
+    db.addTextEntry({"program", "relation", "path", "source-locator"}, "path.dl [3:1-3:20]");
+    db.addSizeEntry({"program", "relation", "path", "iteration", "1", "num-tuples"}, 42);
+    db.addDurationEntry({"program", "relation", "path", "iteration", "1", "runtime"}, microseconds(10),
+            microseconds(25));
+    db.addTimeEntry({"program", "starttime"}, microseconds(7));
+
+    std::stringstream ss;
+    db.print(ss);
+    const std::string filename = "profile_database_test.json";
+    {
+        std::ofstream out(filename);
+        out << ss.str();
+    }
+
+    ProfileDatabase loaded(filename);
+    std::remove(filename.c_str());
+    std::stringstream reprinted;
+    loaded.print(reprinted);
+    EXPECT_EQ(ss.str(), reprinted.str());
+
+    auto* size = dynamic_cast<SizeEntry*>(
+            loaded.lookupEntry({"program", "relation", "path", "iteration", "1", "num-tuples"}));
+    ASSERT_TRUE(size != nullptr);
+    EXPECT_EQ(42, size->getSize());
+    auto* duration = dynamic_cast<DurationEntry*>(
+            loaded.lookupEntry({"program", "relation", "path", "iteration", "1", "runtime"}));
+    ASSERT_TRUE(duration != nullptr);
+    EXPECT_EQ(10, duration->getStart().count());
+    EXPECT_EQ(25, duration->getEnd().count());
+    auto* time = dynamic_cast<TimeEntry*>(loaded.lookupEntry({"program", "starttime"}));
+    ASSERT_TRUE(time != nullptr);
+    EXPECT_EQ(7, time->getTime().count());
+}
+
+TEST(ProfileDatabase, Syntax) {
+    ProfileDatabase db;
+    db.loadJson(R"({"version": [1, {"major": 2}],
+            "root": {"text": "a\"b\\c\u00e9\ud83d\ude00", "frac": 2.75, "neg": -0, "empty": {}}})");
+    auto* text = dynamic_cast<TextEntry*>(db.lookupEntry({"text"}));
+    ASSERT_TRUE(text != nullptr);
+    EXPECT_EQ("a\"b\\c\xc3\xa9\xf0\x9f\x98\x80", text->getText());
+    auto* frac = dynamic_cast<SizeEntry*>(db.lookupEntry({"frac"}));
+    ASSERT_TRUE(frac != nullptr);
+    EXPECT_EQ(2, frac->getSize());
+    EXPECT_TRUE(dynamic_cast<DirectoryEntry*>(db.lookupEntry({"empty"})) != nullptr);
+
+    // a truncated profile is an error rather than a partial database
+    bool failed = false;
+    try {
+        db.loadJson(R"({"root": {"program": {"starttime": {"time": 1)");
+    } catch (const std::runtime_error& e) {
+        failed = true;
+    }
+    EXPECT_TRUE(failed);
+    EXPECT_TRUE(db.lookupEntry({"text"}) != nullptr);
+}
+
+}  // namespace test
+}  // namespace souffle
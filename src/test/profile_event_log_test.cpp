@@ -0,0 +1,151 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file profile_event_log_test.cpp
+ *
+ * A test case testing the binary log of profile events.
+ *
+ ***********************************************************************/
+
+#include "ProfileEventLog.h"
+#include "test.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+using profile::BinaryEvent;
+using profile::BinaryEventLog;
+using profile::ProfileSocketBuffer;
+using profile::openProfileSocket;
+
+/** Record an event for each of the given number of threads and iterations */
+void recordEvents(BinaryEventLog& log, size_t numThreads, size_t numEvents) {
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; t++) {
+        threads.emplace_back([&log, t, numEvents]() {
+            for (size_t i = 0; i < numEvents; i++) {
+                BinaryEvent event{};
+                event.kind = BinaryEvent::QUANTITY;
+                event.label = log.intern("@thread;" + std::to_string(t));
+                event.values[0] = i;
+                log.record(event);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+TEST(BinaryEventLog, Consumer) {
+    std::map<std::string, std::vector<uint64_t>> received;
+    BinaryEventLog log([&](const std::vector<std::string>& labels, const BinaryEvent& event) {
+        received[labels[event.label]].push_back(event.values[0]);
+    });
+
+    // exceed the capacity of the rings
+    recordEvents(log, 4, 10000);
+    log.stop();
+
+    EXPECT_EQ(4, received.size());
+    for (const auto& cur : received) {
+        EXPECT_EQ(10000, cur.second.size());
+        // the events of a thread keep their order
+        for (size_t i = 0; i < cur.second.size(); i++) {
+            EXPECT_EQ(i, cur.second[i]);
+        }
+    }
+}
+
+TEST(BinaryEventLog, File) {
+    const std::string fileName = "profile_event_log_test.log";
+    size_t numConsumed = 0;
+    {
+        BinaryEventLog log([&](const std::vector<std::string>&, const BinaryEvent&) { numConsumed++; });
+        log.open(fileName);
+        recordEvents(log, 2, 100);
+        log.stop();
+    }
+    EXPECT_EQ(0, numConsumed);
+    EXPECT_TRUE(BinaryEventLog::isBinaryLog(fileName));
+
+    size_t numEvents = 0;
+    std::map<std::string, uint64_t> sums;
+    BinaryEventLog::read(fileName, [&](const std::vector<std::string>& labels, const BinaryEvent& event) {
+        EXPECT_EQ(BinaryEvent::QUANTITY, event.kind);
+        sums[labels[event.label]] += event.values[0];
+        numEvents++;
+    });
+    EXPECT_EQ(200, numEvents);
+    EXPECT_EQ(2, sums.size());
+    EXPECT_EQ(4950, sums["@thread;0"]);
+    EXPECT_EQ(4950, sums["@thread;1"]);
+
+    // a truncated last event is ignored
+    std::string content;
+    {
+        std::ifstream in(fileName, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+        out.write(content.data(), content.size() - 1);
+    }
+    numEvents = 0;
+    BinaryEventLog::read(
+            fileName, [&](const std::vector<std::string>&, const BinaryEvent&) { numEvents++; });
+    EXPECT_EQ(199, numEvents);
+
+    std::remove(fileName.c_str());
+    EXPECT_FALSE(BinaryEventLog::isBinaryLog(fileName));
+}
+
+TEST(BinaryEventLog, Stream) {
+    const std::string address = "unix:profile_event_log_test.sock";
+    size_t numConsumed = 0;
+    BinaryEventLog log([&](const std::vector<std::string>&, const BinaryEvent&) { numConsumed++; });
+    log.listen(address, [&]() { return std::to_string(numConsumed); });
+    recordEvents(log, 1, 10);
+
+    // the profiler receives the state at the time of attaching and the events after it
+    ProfileSocketBuffer buffer(openProfileSocket(address, false));
+    std::istream in(&buffer);
+    EXPECT_TRUE(BinaryEventLog::readHeader(in));
+    std::vector<std::string> labels;
+    std::string snapshot;
+    EXPECT_TRUE(BinaryEventLog::readRecord(in, labels, nullptr, &snapshot));
+    EXPECT_EQ("10", snapshot);
+
+    recordEvents(log, 1, 10);
+    log.stop();
+    EXPECT_EQ(20, numConsumed);
+    uint64_t sum = 0;
+    size_t numEvents = 0;
+    auto consumer = [&](const std::vector<std::string>& eventLabels, const BinaryEvent& event) {
+        EXPECT_EQ("@thread;0", eventLabels[event.label]);
+        sum += event.values[0];
+        numEvents++;
+    };
+    while (BinaryEventLog::readRecord(in, labels, consumer, nullptr)) {
+    }
+    EXPECT_EQ(10, numEvents);
+    EXPECT_EQ(45, sum);
+}
+
+}  // end namespace test
+}  // end namespace souffle
@@ -0,0 +1,108 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ram_serialisation_test.cpp
+ *
+ * Tests saving and loading RAM programs.
+ *
+ ***********************************************************************/
+
+#include "AstTranslationUnit.h"
+#include "AstTranslator.h"
+#include "DebugReport.h"
+#include "ErrorReport.h"
+#include "Global.h"
+#include "ParserDriver.h"
+#include "RamProgram.h"
+#include "RamSerialisation.h"
+#include "RamTranslationUnit.h"
+#include "SymbolTable.h"
+#include "test.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace souffle {
+
+namespace test {
+
+TEST(RamSerialisation, RoundTrip) {
+    Global::config().set("fact-dir", "facts");
+    Global::config().set("output-dir", "out");
+    SymbolTable sym;
+    ErrorReport e;
+    DebugReport d;
+    std::unique_ptr<AstTranslationUnit> prog = ParserDriver::parseTranslationUnit(
+            R"(
+                   .type Node
+                   .decl e ( a : Node , b : Node )
+                   .input e
+                   .decl r ( from : Node , to : Node )
+                   .output r
+                   .decl n ( x : number )
+                   .output n
+
+                   e("a","b").
+                   r(X,Y) :- e(X,Y).
+                   r(X,Z) :- r(X,Y), r(Y,Z), X != "a \"quoted\"\tsymbol".
+                   n(C) :- C = count : r(_,_).
+            )",
+            sym, e, d);
+    ASSERT_TRUE(e.getNumErrors() == 0);
+    std::unique_ptr<RamTranslationUnit> ram = AstTranslator().translateUnit(*prog);
+
+    std::stringstream saved;
+    saveRamProgram(*ram, saved);
+
+    // load the program for other directories
+    Global::config().set("fact-dir", "other");
+    SymbolTable loadedSym;
+    ErrorReport loadedErrors;
+    DebugReport loadedDebug;
+    std::unique_ptr<RamTranslationUnit> loaded =
+            loadRamProgram(saved, loadedSym, loadedErrors, loadedDebug);
+
+    EXPECT_EQ(sym.size(), loadedSym.size());
+    for (size_t i = 0; i < sym.size(); i++) {
+        EXPECT_EQ(sym.resolve(i), loadedSym.resolve(i));
+    }
+    EXPECT_EQ(ram->getProgram()->getAllRelations().size(), loaded->getProgram()->getAllRelations().size());
+
+    std::string program = toString(*ram->getProgram());
+    std::string loadedProgram = toString(*loaded->getProgram());
+    EXPECT_EQ(std::string::npos, loadedProgram.find("facts/e.facts"));
+    EXPECT_NE(std::string::npos, loadedProgram.find("other/e.facts"));
+    size_t pos = program.find("facts/e.facts");
+    ASSERT_TRUE(pos != std::string::npos);
+    program.replace(pos, 5, "other");
+    EXPECT_EQ(program, loadedProgram);
+
+    Global::config().set("fact-dir", "facts");
+}
+
+TEST(RamSerialisation, Reject) {
+    SymbolTable sym;
+    ErrorReport e;
+    DebugReport d;
+    for (const char* file : {"not a program", "souffle-ram 3 0.0 ", "souffle-ram"}) {
+        std::stringstream in(file);
+        bool rejected = false;
+        try {
+            loadRamProgram(in, sym, e, d);
+        } catch (std::runtime_error&) {
+            rejected = true;
+        }
+        EXPECT_TRUE(rejected) << file;
+    }
+}
+
+}  // end namespace test
+}  // end namespace souffle
@@ -0,0 +1,208 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file read_stream_csv_test.cpp
+ *
+ * Tests the memory-mapped fact file reader and the pipelined standard input
+ * reader against the stream based one.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "IODirectives.h"
+#include "ReadStreamCSV.h"
+#include "SymbolTable.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+/** A relation collecting the inserted tuples */
+struct Collector {
+    size_t arity;
+    std::vector<std::vector<RamDomain>> tuples;
+
+    void insert(const RamDomain* tuple) {
+        tuples.emplace_back(tuple, tuple + arity);
+    }
+};
+
+/** The outcome of reading a fact file */
+struct Result {
+    std::string error;
+    std::vector<std::vector<RamDomain>> tuples;
+    std::vector<std::string> symbols;
+
+    bool operator==(const Result& other) const {
+        return error == other.error && tuples == other.tuples && symbols == other.symbols;
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const Result& result) {
+        out << result.tuples.size() << " tuples, " << result.symbols.size() << " symbols";
+        if (!result.error.empty()) {
+            out << ", error: " << result.error;
+        }
+        return out;
+    }
+};
+
+/** Reads the given fact file content with either the stream based or the memory-mapped reader */
+Result read(bool mapped, const std::string& content, const std::vector<bool>& mask,
+        std::map<std::string, std::string> directives = {}) {
+    const std::string fileName = "read_stream_csv_test.facts";
+    {
+        std::ofstream out(fileName, std::ios::binary);
+        out << content;
+    }
+    directives["IO"] = "file";
+    directives["filename"] = fileName;
+    directives["name"] = "test";
+    IODirectives ioDirectives(directives);
+
+    Result result;
+    SymbolTable symbols;
+    Collector relation{mask.size(), {}};
+    try {
+        std::unique_ptr<ReadStream> reader;
+        if (mapped) {
+            reader = ReadFileCSVFactory().getReader(mask, symbols, ioDirectives, false);
+        } else {
+            reader = std::make_unique<ReadFileCSV>(mask, symbols, ioDirectives);
+        }
+        reader->readAll(relation);
+    } catch (std::exception& e) {
+        result.error = e.what();
+    }
+    result.tuples = relation.tuples;
+    for (size_t i = 0; i < symbols.size(); i++) {
+        result.symbols.push_back(symbols.resolve(i));
+    }
+    std::remove(fileName.c_str());
+    return result;
+}
+
+#define EXPECT_SAME(...) EXPECT_EQ(read(false, __VA_ARGS__), read(true, __VA_ARGS__))
+
+TEST(ReadFileMappedCSV, Numbers) {
+    EXPECT_EQ(4, read(true, "1\t2\n-3\t+4\n 5\t6x\n2147483647\t-2147483648\n", {false, false}).tuples.size());
+    EXPECT_SAME("1\t2\n-3\t+4\n 5\t6x\n2147483647\t-2147483648\n", {false, false});
+    EXPECT_SAME("1\t2\n3\n", {false, false});
+    EXPECT_NE("", read(true, "1\tx\n", {false, false}).error);
+    EXPECT_SAME("1\tx\n", {false, false});
+    EXPECT_SAME("1\t\n", {false, false});
+    EXPECT_SAME("99999999999999999999\t1\n", {false, false});
+}
+
+TEST(ReadFileMappedCSV, Symbols) {
+    EXPECT_EQ(5, read(true, "a\tb\r\nc\td\n\te\nf\t\n\t\n", {true, true}).tuples.size());
+    EXPECT_SAME("a\tb\r\nc\td\n\te\nf\t\n\t\n", {true, true});
+    EXPECT_SAME("a\tb\nlast\tline", {true, true});
+    EXPECT_SAME("a\tb\n\nc\td\n", {true, true});
+    EXPECT_SAME("", {true, true});
+    EXPECT_SAME("\n", {true});
+}
+
+TEST(ReadFileMappedCSV, Directives) {
+    EXPECT_SAME("a, 1, b\nc, 2, d\n", {true, false, true}, {{"delimiter", ", "}});
+    EXPECT_SAME("a,,1,,b\nc,,2,,d,,e\n", {true, false}, {{"delimiter", ",,"}, {"columns", "2:0"}});
+    EXPECT_SAME("x\ty\n1\t2\n", {false, false}, {{"headers", "true"}});
+    EXPECT_SAME("1\t2\t3\t4\n5\t6\t7\t8\n", {false, false}, {{"columns", "3:1"}});
+}
+
+TEST(ReadFileMappedCSV, Parallel) {
+    const std::map<std::string, std::string> parallel = {{"parallel", "true"}};
+    EXPECT_SAME("a\tb\r\nc\td\n\te\nf\t\n\t\n", {true, true}, parallel);
+    EXPECT_SAME("1\tx\n", {false, false}, parallel);
+    EXPECT_SAME("x\ty\n1\t2\n3\t4", {false, false}, {{"parallel", "true"}, {"headers", "true"}});
+
+    // large enough to be split into several chunks
+    std::stringstream numbers;
+    for (int i = 0; i < 1000000; i++) {
+        numbers << i << "\t" << -i << "\n";
+    }
+    Result result = read(true, numbers.str(), {false, false}, parallel);
+    EXPECT_EQ(1000000, result.tuples.size());
+    EXPECT_SAME(numbers.str(), {false, false}, parallel);
+
+    // errors report the correct line
+    numbers << "1\tx\n";
+    for (int i = 0; i < 1000000; i++) {
+        numbers << i << "\t" << i << "\n";
+    }
+    EXPECT_EQ(read(false, numbers.str(), {false, false}).error,
+            read(true, numbers.str(), {false, false}, parallel).error);
+}
+
+/** Reads the given standard input with either the stream based or the pipelined reader */
+Result readCin(bool pipelined, const std::string& content, const std::vector<bool>& mask,
+        std::map<std::string, std::string> directives = {}) {
+    directives["IO"] = "stdin";
+    directives["name"] = "test";
+    if (pipelined) {
+        directives["parallel"] = "true";
+    }
+    IODirectives ioDirectives(directives);
+
+    std::stringbuf input(content);
+    std::streambuf* original = std::cin.rdbuf(&input);
+    Result result;
+    SymbolTable symbols;
+    Collector relation{mask.size(), {}};
+    try {
+        ReadCinCSVFactory().getReader(mask, symbols, ioDirectives, false)->readAll(relation);
+    } catch (std::exception& e) {
+        result.error = e.what();
+    }
+    std::cin.rdbuf(original);
+    result.tuples = relation.tuples;
+    for (size_t i = 0; i < symbols.size(); i++) {
+        result.symbols.push_back(symbols.resolve(i));
+    }
+    return result;
+}
+
+#define EXPECT_SAME_CIN(...) EXPECT_EQ(readCin(false, __VA_ARGS__), readCin(true, __VA_ARGS__))
+
+TEST(ReadCinPipelinedCSV, Lines) {
+    EXPECT_SAME_CIN("a\tb\r\nc\td\n\te\nf\t\n\t\n", {true, true});
+    EXPECT_SAME_CIN("1\t2\n-3\t+4\n 5\t6x\n", {false, false});
+    EXPECT_SAME_CIN("a\tb\nlast\tline", {true, true});
+    EXPECT_SAME_CIN("", {true, true});
+    EXPECT_SAME_CIN("a,,1,,b\nc,,2,,d,,e\n", {true, false}, {{"delimiter", ",,"}, {"columns", "2:0"}});
+    EXPECT_SAME_CIN("1\tx\n", {false, false});
+}
+
+TEST(ReadCinPipelinedCSV, Blocks) {
+    // large enough to be read in several blocks, with lines crossing their bounds
+    std::stringstream numbers;
+    for (int i = 0; i < 1000000; i++) {
+        numbers << i << "\t" << -i << "\n";
+    }
+    Result result = readCin(true, numbers.str(), {false, false});
+    EXPECT_EQ(1000000, result.tuples.size());
+    EXPECT_SAME_CIN(numbers.str(), {false, false});
+
+    // errors report the correct line
+    numbers << "1\tx\n";
+    for (int i = 0; i < 1000000; i++) {
+        numbers << i << "\t" << i << "\n";
+    }
+    EXPECT_EQ(readCin(false, numbers.str(), {false, false}).error,
+            readCin(true, numbers.str(), {false, false}).error);
+}
+
+}  // end namespace test
@@ -0,0 +1,185 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file record_table_test.cpp
+ *
+ * Tests the record table shared by the interpreters and the arenas of local records.
+ *
+ ***********************************************************************/
+
+#include "RecordArena.h"
+#include "RecordTable.h"
+#include "test.h"
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+TEST(RecordTable, Basic) {
+    RecordTable table(2);
+
+    RamDomain a[] = {1, 2};
+    RamDomain b[] = {2, 1};
+
+    RamDomain ra = table.pack(a);
+    RamDomain rb = table.pack(b);
+
+    EXPECT_NE(0, ra);
+    EXPECT_NE(0, rb);
+    EXPECT_NE(ra, rb);
+    EXPECT_EQ(ra, table.pack(a));
+    EXPECT_EQ(rb, table.pack(b));
+    EXPECT_EQ(2, table.size());
+
+    EXPECT_EQ(1, table.unpack(ra)[0]);
+    EXPECT_EQ(2, table.unpack(ra)[1]);
+    EXPECT_EQ(2, table.unpack(rb)[0]);
+    EXPECT_EQ(1, table.unpack(rb)[1]);
+}
+
+TEST(RecordTable, Nullary) {
+    RecordTable table(0);
+
+    RamDomain r = table.pack(nullptr);
+    EXPECT_NE(0, r);
+    EXPECT_EQ(r, table.pack(nullptr));
+    EXPECT_EQ(1, table.size());
+}
+
+TEST(RecordTable, Large) {
+    const int N = 200000;
+    RecordTable table(3);
+
+    std::vector<RamDomain> refs;
+    for (int i = 0; i < N; i++) {
+        RamDomain t[] = {i, i % 7, -i};
+        refs.push_back(table.pack(t));
+    }
+    EXPECT_EQ(N, table.size());
+
+    for (int i = 0; i < N; i++) {
+        RamDomain t[] = {i, i % 7, -i};
+        EXPECT_EQ(refs[i], table.pack(t));
+        RamDomain* r = table.unpack(refs[i]);
+        EXPECT_EQ(i, r[0]);
+        EXPECT_EQ(i % 7, r[1]);
+        EXPECT_EQ(-i, r[2]);
+    }
+}
+
+TEST(RecordTable, Parallel) {
+    const int N = 100000;
+    RecordTable table(2);
+
+    // every thread packs the same tuples and must obtain the same references
+    std::vector<RamDomain> refs(N, 0);
+#pragma omp parallel
+    {
+        std::vector<RamDomain> mine(N);
+        for (int i = 0; i < N; i++) {
+            RamDomain t[] = {i, i * 3};
+            mine[i] = table.pack(t);
+        }
+#pragma omp critical
+        {
+            for (int i = 0; i < N; i++) {
+                if (refs[i] == 0) {
+                    refs[i] = mine[i];
+                }
+                EXPECT_EQ(refs[i], mine[i]);
+            }
+        }
+    }
+    EXPECT_EQ(N, table.size());
+
+    for (int i = 0; i < N; i++) {
+        RamDomain* r = table.unpack(refs[i]);
+        EXPECT_EQ(i, r[0]);
+        EXPECT_EQ(i * 3, r[1]);
+    }
+}
+
+TEST(RecordTableSet, Arities) {
+    RecordTableSet tables;
+
+    RamDomain t[100];
+    for (int i = 0; i < 100; i++) {
+        t[i] = i;
+    }
+
+    for (int arity : {1, 2, 5, 63, 64, 100}) {
+        RecordTable& table = tables.getForArity(arity);
+        EXPECT_EQ(&table, &tables.getForArity(arity));
+        RamDomain r = table.pack(t);
+        EXPECT_EQ(arity - 1, table.unpack(r)[arity - 1]);
+    }
+}
+
+TEST(RecordTable, Find) {
+    RecordTable table(2);
+
+    RamDomain a[] = {1, 2};
+    RamDomain b[] = {2, 1};
+
+    EXPECT_EQ(0, table.find(a));
+    RamDomain ra = table.pack(a);
+    EXPECT_EQ(ra, table.find(a));
+    EXPECT_EQ(0, table.find(b));
+    EXPECT_EQ(1, table.size());
+}
+
+TEST(RecordArena, Pack) {
+    RecordTable table(2);
+    RecordArena arena;
+    auto global = [&](const RamDomain* tuple) { return table.find(tuple); };
+
+    RamDomain a[] = {1, 2};
+    RamDomain b[] = {3, 4};
+    RamDomain ra = table.pack(a);
+
+    // records of the global table keep their references, others obtain negative ones
+    EXPECT_EQ(ra, arena.pack(a, 2, global));
+    RamDomain rb = arena.pack(b, 2, global);
+    EXPECT_LT(rb, 0);
+    EXPECT_EQ(rb, arena.pack(b, 2, global));
+    EXPECT_EQ(1, table.size());
+
+    // the reference of a record is stable even if it enters the global table
+    table.pack(b);
+    EXPECT_EQ(rb, arena.pack(b, 2, global));
+
+    // records of different arities are distinct
+    RamDomain c[] = {3, 4, 5};
+    EXPECT_NE(rb, arena.pack(c, 3, [](const RamDomain*) { return 0; }));
+
+    arena.clear();
+    EXPECT_TRUE(arena.empty());
+    EXPECT_EQ(table.find(b), arena.pack(b, 2, global));
+}
+
+TEST(RecordArena, Many) {
+    const int N = 100000;
+    RecordArena arena;
+    auto none = [](const RamDomain*) { return 0; };
+
+    std::vector<RamDomain> refs(N);
+    for (int i = 0; i < N; i++) {
+        RamDomain t[] = {i, -i};
+        refs[i] = arena.pack(t, 2, none);
+        EXPECT_LT(refs[i], 0);
+    }
+    for (int i = 0; i < N; i++) {
+        RamDomain t[] = {i, -i};
+        EXPECT_EQ(refs[i], arena.pack(t, 2, none));
+    }
+}
+
+}  // namespace test
@@ -0,0 +1,75 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file regex_cache_test.cpp
+ *
+ * Tests the cache of compiled patterns of match constraints.
+ *
+ ***********************************************************************/
+
+#include "RegexCache.h"
+#include "SymbolTable.h"
+#include "test.h"
+
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+TEST(RegexCache, Match) {
+    SymbolTable symbols;
+    RegexCache cache;
+    RamDomain pattern = symbols.lookup("a.*b");
+
+    EXPECT_TRUE(cache.match(pattern, "aab", symbols, false));
+    EXPECT_FALSE(cache.match(pattern, "aba", symbols, false));
+    EXPECT_FALSE(cache.match(pattern, "aab", symbols, true));
+    EXPECT_TRUE(cache.match(pattern, "aba", symbols, true));
+
+    // each pattern is compiled once
+    EXPECT_EQ(cache.get(pattern, symbols), cache.get(pattern, symbols));
+    EXPECT_NE(cache.get(pattern, symbols), cache.get(symbols.lookup("b"), symbols));
+}
+
+TEST(RegexCache, Invalid) {
+    SymbolTable symbols;
+    RegexCache cache;
+    RamDomain pattern = symbols.lookup("a[");
+
+    EXPECT_TRUE(RegexCache::compile("a[") == nullptr);
+    EXPECT_TRUE(cache.get(pattern, symbols) == nullptr);
+
+    // invalid patterns neither match nor do not match
+    EXPECT_FALSE(cache.match(pattern, "a", symbols, false));
+    EXPECT_FALSE(cache.match(pattern, "a", symbols, true));
+}
+
+TEST(RegexCache, Parallel) {
+    SymbolTable symbols;
+    RegexCache cache;
+    std::vector<RamDomain> patterns;
+    for (int i = 0; i < 10; i++) {
+        patterns.push_back(symbols.lookup("x" + std::to_string(i) + ".*"));
+    }
+
+    int matches = 0;
+#pragma omp parallel for reduction(+ : matches)
+    for (int i = 0; i < 1000; i++) {
+        if (cache.match(patterns[i % 10], "x" + std::to_string(i % 10) + std::to_string(i), symbols, false)) {
+            matches++;
+        }
+    }
+    EXPECT_EQ(1000, matches);
+}
+
+}  // end namespace test
+}  // end namespace souffle
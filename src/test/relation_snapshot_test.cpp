@@ -0,0 +1,186 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file relation_snapshot_test.cpp
+ *
+ * Tests the read-only snapshots of the relations of the interface.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "SouffleInterface.h"
+#include "SymbolTable.h"
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+using Row = std::vector<RamDomain>;
+
+/** A relation of two numbers, iterated in the order of its second column */
+class TestRelation : public Relation {
+    struct BySecond {
+        bool operator()(const Row& a, const Row& b) const {
+            return a[1] < b[1] || (a[1] == b[1] && a[0] < b[0]);
+        }
+    };
+
+    std::set<Row, BySecond> rows;
+    SymbolTable& symTable;
+
+    class iterator_test : public iterator_base {
+        std::set<Row, BySecond>::const_iterator it;
+        tuple t;
+
+    public:
+        iterator_test(const Relation* rel, std::set<Row, BySecond>::const_iterator it)
+                : iterator_base(1), it(it), t(rel) {}
+        void operator++() override {
+            ++it;
+        }
+        tuple& operator*() override {
+            t[0] = (*it)[0];
+            t[1] = (*it)[1];
+            return t;
+        }
+        iterator_base* clone() const override {
+            return new iterator_test(*this);
+        }
+
+    protected:
+        bool equal(const iterator_base& o) const override {
+            return it == static_cast<const iterator_test&>(o).it;
+        }
+    };
+
+public:
+    TestRelation(SymbolTable& symTable) : symTable(symTable) {}
+
+    void insert(const tuple& t) override {
+        rows.insert({t[0], t[1]});
+    }
+    bool contains(const tuple& t) const override {
+        return rows.count({t[0], t[1]}) != 0;
+    }
+    iterator begin() const override {
+        return iterator(new iterator_test(this, rows.begin()));
+    }
+    iterator end() const override {
+        return iterator(new iterator_test(this, rows.end()));
+    }
+    std::size_t size() const override {
+        return rows.size();
+    }
+    std::string getName() const override {
+        return "edge";
+    }
+    const char* getAttrType(size_t) const override {
+        return "i:number";
+    }
+    const char* getAttrName(size_t i) const override {
+        return i == 0 ? "x" : "y";
+    }
+    size_t getArity() const override {
+        return 2;
+    }
+    SymbolTable& getSymbolTable() const override {
+        return symTable;
+    }
+    void purge() override {
+        rows.clear();
+    }
+};
+
+TEST(RelationSnapshot, Consistent) {
+    SymbolTable symbols;
+    TestRelation rel(symbols);
+    for (RamDomain i = 0; i < 100; i++) {
+        rel.insert(tuple(&rel, {i % 10, 99 - i}));
+    }
+
+    std::shared_ptr<const Relation> snapshot = rel.snapshot();
+    for (RamDomain i = 100; i < 200; i++) {
+        rel.insert(tuple(&rel, {i % 10, i}));
+    }
+    rel.purge();
+
+    EXPECT_EQ(100, snapshot->size());
+    EXPECT_EQ("edge", snapshot->getName());
+    EXPECT_EQ(std::string("y"), snapshot->getAttrName(1));
+
+    // the tuples come in lexicographical order
+    Row previous;
+    size_t count = 0;
+    for (const auto& cur : *snapshot) {
+        Row row = {cur[0], cur[1]};
+        EXPECT_TRUE(previous.empty() || previous < row);
+        previous = row;
+        count++;
+    }
+    EXPECT_EQ(100, count);
+    EXPECT_TRUE(snapshot->contains(tuple(&rel, {3, 96})));
+    EXPECT_FALSE(snapshot->contains(tuple(&rel, {3, 97})));
+
+    // searches on a prefix of the columns and on other columns
+    RamDomain first[] = {7, 0};
+    count = 0;
+    snapshot->equalRange(first, 1,
+            [&](const RamDomain* rows, size_t n) {
+                for (size_t i = 0; i < n; i++) {
+                    EXPECT_EQ(7, rows[2 * i]);
+                }
+                count += n;
+            },
+            3);
+    EXPECT_EQ(10, count);
+    RamDomain second[] = {0, 42};
+    count = 0;
+    snapshot->equalRange(second, 2, [&](const RamDomain* rows, size_t n) {
+        EXPECT_EQ(7, rows[0]);
+        count += n;
+    });
+    EXPECT_EQ(1, count);
+}
+
+TEST(RelationSnapshot, ConcurrentReaders) {
+    SymbolTable symbols;
+    TestRelation rel(symbols);
+    for (RamDomain i = 0; i < 1000; i++) {
+        rel.insert(tuple(&rel, {i, i}));
+    }
+    std::shared_ptr<const Relation> snapshot = rel.snapshot();
+
+    // readers scan the snapshot while the relation keeps changing
+    std::vector<size_t> counts(4, 0);
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < counts.size(); r++) {
+        readers.emplace_back([&, r]() {
+            snapshot->scan([&](const RamDomain* /* rows */, size_t n) { counts[r] += n; }, 64);
+        });
+    }
+    for (RamDomain i = 1000; i < 2000; i++) {
+        rel.insert(tuple(&rel, {i, i}));
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    for (size_t count : counts) {
+        EXPECT_EQ(1000, count);
+    }
+    EXPECT_EQ(2000, rel.size());
+}
+
+}  // end namespace test
@@ -0,0 +1,102 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file shm_test.cpp
+ *
+ * Tests for the concurrent evaluation of strata in Shm.h.
+ *
+ ***********************************************************************/
+
+#include "Shm.h"
+#include "test.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+TEST(shm, SequentialOrder) {
+    const std::vector<std::vector<int>> predecessors = {{}, {}, {0}, {1, 2}, {}};
+    std::vector<int> order;
+    shm::runStrata(predecessors, 1, [&](int stratum) { order.push_back(stratum); });
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4}), order);
+}
+
+TEST(shm, Dependencies) {
+    // a diamond of strata repeated, each depending on the last stratum of the previous one
+    std::vector<std::vector<int>> predecessors;
+    for (int i = 0; i < 100; ++i) {
+        const int base = 4 * i;
+        predecessors.push_back(i == 0 ? std::vector<int>() : std::vector<int>{base - 1});
+        predecessors.push_back({base});
+        predecessors.push_back({base});
+        predecessors.push_back({base + 1, base + 2});
+    }
+
+    std::vector<std::atomic<bool>> done(predecessors.size());
+    for (auto& cur : done) {
+        cur = false;
+    }
+    std::atomic<int> violations(0);
+    std::atomic<int> evaluated(0);
+    shm::runStrata(predecessors, 4, [&](int stratum) {
+        for (int predecessor : predecessors[stratum]) {
+            if (!done[predecessor]) {
+                ++violations;
+            }
+        }
+        if (done[stratum]) {
+            ++violations;
+        }
+        done[stratum] = true;
+        ++evaluated;
+    });
+    EXPECT_EQ(0, violations.load());
+    EXPECT_EQ(400, evaluated.load());
+}
+
+TEST(shm, Concurrency) {
+    // independent strata are evaluated at the same time, each waits until both started
+    std::mutex lock;
+    std::condition_variable started;
+    int count = 0;
+    shm::runStrata({{}, {}}, 2, [&](int) {
+        std::unique_lock<std::mutex> guard(lock);
+        ++count;
+        started.notify_all();
+        started.wait(guard, [&]() { return count == 2; });
+    });
+    EXPECT_EQ(2, count);
+}
+
+TEST(shm, Exception) {
+    std::atomic<bool> successorEvaluated(false);
+    bool caught = false;
+    try {
+        shm::runStrata({{}, {0}}, 2, [&](int stratum) {
+            if (stratum == 0) {
+                throw std::runtime_error("failure");
+            }
+            successorEvaluated = true;
+        });
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    EXPECT_TRUE(caught);
+    EXPECT_FALSE(successorEvaluated.load());
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -0,0 +1,172 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file sorted_vector_test.cpp
+ *
+ * A test case testing the tuple set kept in a sorted vector.
+ *
+ ***********************************************************************/
+
+#include "SortedVector.h"
+#include "test.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+TEST(SortedVector, Basic) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    SortedVector<2> set;
+
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(0, set.size());
+    EXPECT_TRUE(set.begin() == set.end());
+    EXPECT_FALSE(set.contains({{1, 2}}));
+
+    set.insert({{1, 3}});
+    set.insert({{1, 2}});
+    set.insert({{1, 2}});
+    EXPECT_FALSE(set.empty());
+    set.insert({{0, 5}});
+    set.insert({{-4, 7}});
+
+    EXPECT_EQ(4, set.size());
+    EXPECT_TRUE(set.contains({{1, 2}}));
+    EXPECT_TRUE(set.contains({{-4, 7}}));
+    EXPECT_FALSE(set.contains({{1, 4}}));
+    EXPECT_FALSE(set.contains({{-5, 7}}));
+
+    // the content is sorted and free of duplicates
+    std::vector<Tuple> content(set.begin(), set.end());
+    std::vector<Tuple> expected = {{{-4, 7}}, {{0, 5}}, {{1, 2}}, {{1, 3}}};
+    EXPECT_EQ(expected, content);
+
+    EXPECT_EQ(Tuple({{0, 5}}), *set.find({{0, 5}}));
+    EXPECT_TRUE(set.find({{0, 6}}) == set.end());
+    EXPECT_EQ(Tuple({{1, 2}}), *set.lower_bound({{0, 6}}));
+    EXPECT_EQ(Tuple({{1, 3}}), *set.upper_bound({{1, 2}}));
+    EXPECT_EQ(2, set.countRange(set.lower_bound({{1, 0}}), set.end()));
+
+    // later insertions are merged into the sorted content
+    set.insert({{0, 6}});
+    set.insert({{1, 3}});
+    EXPECT_EQ(5, set.size());
+    EXPECT_EQ(Tuple({{0, 6}}), *set.lower_bound({{0, 6}}));
+
+    set.clear();
+    EXPECT_TRUE(set.empty());
+    EXPECT_FALSE(set.contains({{1, 2}}));
+    EXPECT_TRUE(set.begin() == set.end());
+}
+
+TEST(SortedVector, Random) {
+    using Tuple = ram::Tuple<RamDomain, 3>;
+    SortedVector<3> set;
+    std::set<Tuple> ref;
+
+    std::srand(42);
+    auto gen = []() {
+        Tuple t = {{std::rand() % 10, std::rand() % 1000, std::rand() - RAND_MAX / 2}};
+        return t;
+    };
+
+    // insertions alternate with reads
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 10000; i++) {
+            Tuple t = gen();
+            ref.insert(t);
+            set.insert(t);
+        }
+        EXPECT_EQ(ref.size(), set.size());
+        EXPECT_TRUE(std::equal(ref.begin(), ref.end(), set.begin()));
+    }
+
+    for (int i = 0; i < 10000; i++) {
+        Tuple t = gen();
+        EXPECT_EQ(ref.count(t) == 1, set.contains(t));
+    }
+}
+
+TEST(SortedVector, Partition) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    SortedVector<2> set;
+    EXPECT_TRUE(set.partition(10).empty());
+
+    for (int i = 0; i < 100; i++) {
+        for (int j = 0; j < 100; j++) {
+            set.insert({{i, j}});
+        }
+    }
+
+    // partitions cover all elements exactly once, in order
+    for (std::size_t num : {1, 7, 64, 400, 5000}) {
+        auto parts = set.partition(num);
+        EXPECT_FALSE(parts.size() < std::min<std::size_t>(num, 10000));
+        std::vector<Tuple> content;
+        for (const auto& part : parts) {
+            content.insert(content.end(), part.begin(), part.end());
+        }
+        EXPECT_EQ(10000, content.size());
+        EXPECT_TRUE(std::is_sorted(content.begin(), content.end()));
+        EXPECT_TRUE(std::unique(content.begin(), content.end()) == content.end());
+    }
+}
+
+TEST(SortedVector, Parallel) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    SortedVector<2> set;
+    const int N = 100000;
+
+    std::vector<Tuple> data;
+    for (int i = 0; i < N; i++) {
+        data.push_back({{i % 317, i}});
+    }
+    std::random_shuffle(data.begin(), data.end());
+
+#pragma omp parallel for
+    for (int i = 0; i < N; i++) {
+        set.insert(data[i]);
+        set.insert(data[(i + 1) % N]);
+    }
+
+    EXPECT_EQ(N, set.size());
+    std::vector<Tuple> content(set.begin(), set.end());
+    std::sort(data.begin(), data.end());
+    EXPECT_EQ(data, content);
+}
+
+TEST(SortedVector, InsertAll) {
+    SortedVector<2> a;
+    SortedVector<2> b;
+    SortedVector<2> c;
+    for (int i = 0; i < 1000; i++) {
+        a.insert({{i, i}});
+        b.insert({{i, 2 * i}});
+    }
+    a.insertAll(b);
+    EXPECT_EQ(1999, a.size());
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(a.contains({{i, 2 * i}}));
+    }
+
+    // an empty set takes over the content
+    c.insertAll(b);
+    EXPECT_EQ(1000, c.size());
+    EXPECT_TRUE(std::equal(b.begin(), b.end(), c.begin()));
+}
+
+}  // namespace test
+
+}  // namespace souffle
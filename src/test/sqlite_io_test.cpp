@@ -0,0 +1,118 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file sqlite_io_test.cpp
+ *
+ * Tests the relations written into and read from SQLite databases.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "IODirectives.h"
+#include "ReadStreamSQLite.h"
+#include "SymbolTable.h"
+#include "WriteStreamSQLite.h"
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+using Rows = std::vector<std::vector<RamDomain>>;
+
+/** A tuple of a written relation */
+struct Entry {
+    const RamDomain* data;
+};
+
+/** A relation collecting the inserted tuples */
+struct Collector {
+    size_t arity;
+    Rows tuples;
+
+    void insert(const RamDomain* tuple) {
+        tuples.emplace_back(tuple, tuple + arity);
+    }
+};
+
+const std::string dbName = "sqlite_io_test.sqlite";
+
+IODirectives directives(const std::string& name, std::map<std::string, std::string> extra = {}) {
+    extra["IO"] = "sqlite";
+    extra["dbname"] = dbName;
+    extra["name"] = name;
+    return IODirectives(extra);
+}
+
+void write(const std::string& name, const Rows& rows, const std::vector<bool>& mask,
+        const SymbolTable& symbols, std::map<std::string, std::string> extra = {}) {
+    std::vector<Entry> relation;
+    for (const auto& row : rows) {
+        relation.push_back(Entry{row.data()});
+    }
+    WriteSQLiteFactory().getWriter(mask, symbols, directives(name, extra), false)->writeAll(relation);
+}
+
+Rows read(const std::string& name, const std::vector<bool>& mask, SymbolTable& symbols) {
+    Collector relation{mask.size(), {}};
+    ReadSQLiteFactory().getReader(mask, symbols, directives(name), false)->readAll(relation);
+    return relation.tuples;
+}
+
+TEST(SQLiteIO, RoundTrip) {
+    SymbolTable written;
+    Rows rows;
+    for (RamDomain i = 0; i < 200000; ++i) {
+        rows.push_back({-i, written.lookup("s" + std::to_string(i % 1001)), i % 7});
+    }
+    const std::vector<bool> mask = {false, true, false};
+    write("a", rows, mask, written, {{"journal_mode", "OFF"}, {"index", "true"}});
+    // a second relation shares the symbols of the first
+    write("b", {{written.lookup("s3"), written.lookup("new")}}, {true, true}, written);
+
+    SymbolTable symbols;
+    const Rows a = read("a", mask, symbols);
+    EXPECT_EQ(rows.size(), a.size());
+    bool same = true;
+    for (size_t i = 0; i < a.size() && i < rows.size(); ++i) {
+        same = same && a[i][0] == rows[i][0] && a[i][2] == rows[i][2] &&
+               symbols.resolve(a[i][1]) == written.resolve(rows[i][1]);
+    }
+    EXPECT_TRUE(same);
+    EXPECT_EQ(1001, symbols.size());
+
+    const Rows b = read("b", {true, true}, symbols);
+    EXPECT_EQ(1, b.size());
+    EXPECT_EQ("s3", symbols.resolve(b[0][0]));
+    EXPECT_EQ("new", symbols.resolve(b[0][1]));
+
+    // writing a relation again replaces its tuples
+    write("b", {{written.lookup("s4"), written.lookup("s5")}}, {true, true}, written);
+    EXPECT_EQ("s4", symbols.resolve(read("b", {true, true}, symbols)[0][0]));
+    std::remove(dbName.c_str());
+}
+
+TEST(SQLiteIO, Pragmas) {
+    SymbolTable symbols;
+    bool fails = false;
+    try {
+        write("a", {{1}}, {false}, symbols, {{"synchronous", "OFF; DROP TABLE x"}});
+    } catch (std::invalid_argument&) {
+        fails = true;
+    }
+    EXPECT_TRUE(fails);
+    std::remove(dbName.c_str());
+}
+
+}  // end namespace test
@@ -0,0 +1,128 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file statistics_catalog_test.cpp
+ *
+ * Tests the sketches and the catalog of the statistics of relations.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "StatisticsCatalog.h"
+#include "SymbolTable.h"
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+using Tuple = std::vector<RamDomain>;
+
+/** A hash of a number by the finaliser of SplitMix64 */
+uint64_t hash(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+TEST(HyperLogLog, Estimate) {
+    HyperLogLog small;
+    HyperLogLog large;
+    for (uint64_t i = 0; i < 100000; i++) {
+        large.add(hash(i));
+        large.add(hash(i));
+        if (i < 50) {
+            small.add(hash(i));
+        }
+    }
+    EXPECT_LT(std::abs(small.estimate() - 50), 1);
+    EXPECT_LT(std::abs(large.estimate() - 100000), 5000);
+
+    small.merge(large);
+    EXPECT_EQ(large.estimate(), small.estimate());
+}
+
+TEST(HeavyHitters, Frequent) {
+    HeavyHitters a(4);
+    HeavyHitters b(4);
+    for (RamDomain i = 0; i < 1000; i++) {
+        a.add(i % 2 == 0 ? 7 : i);
+        b.add(i % 3 == 0 ? 7 : i);
+    }
+    a.merge(b);
+    ASSERT_TRUE(!a.getCounters().empty());
+    EXPECT_EQ(7, a.getCounters()[0].first);
+    // the count of the value is at most undercounted by a fifth of the stream
+    EXPECT_LT(500 + 334 - 2000 / 5, a.getCounters()[0].second + 1);
+    EXPECT_LT(a.getCounters().size(), 5);
+}
+
+TEST(StatisticsCatalog, Collect) {
+    const std::string filename = "statistics_catalog_test.json";
+    std::remove(filename.c_str());
+
+    // a relation in four chunks with a unique column, a column of ten values, one of a thousand values
+    // and a column of symbols holding one symbol in half of the tuples
+    SymbolTable symbols({"frequent", "rare"});
+    std::vector<std::vector<Tuple>> chunks(4);
+    for (RamDomain i = 0; i < 200000; i++) {
+        chunks[i % 4].push_back({i, i % 10, i % 1000, i % 2 == 0 ? 0 : 1 + i % 5});
+    }
+    for (RamDomain i = 2; i < 6; i++) {
+        symbols.lookup("symbol" + std::to_string(i));
+    }
+    {
+        StatisticsCatalog catalog(filename);
+        EXPECT_FALSE(catalog.isLoaded());
+        catalog.collect(
+                "r", 200000, chunks, {{1, 2, 0, 3}, {0, 1, 2, 3}}, {false, false, false, true}, symbols);
+        const RelationStatistics* stats = catalog.getRelation("r");
+        ASSERT_TRUE(stats != nullptr);
+        EXPECT_EQ(200000, stats->size);
+        EXPECT_LT(std::abs(stats->columns[0].distinct - 200000), 10000);
+        EXPECT_EQ(10, stats->columns[1].distinct);
+        EXPECT_LT(std::abs(stats->columns[2].distinct - 1000), 20);
+        EXPECT_EQ(6, stats->columns[3].distinct);
+
+        // the values of the second and third column are determined by the third
+        EXPECT_LT(std::abs(stats->prefixes.at("1,2") - 1000), 20);
+        EXPECT_LT(std::abs(stats->getFanOut({2, 1}) - 200), 5);
+        EXPECT_EQ(20000, stats->getFanOut({1}));
+
+        // the symbol of half of the tuples is frequent, each value of the column of ten values as well
+        ASSERT_TRUE(!stats->columns[3].frequent.empty());
+        EXPECT_EQ("frequent", stats->columns[3].frequent[0].first);
+        EXPECT_LT(std::abs(stats->getMatches(3, "frequent") - 100000), 10000);
+        EXPECT_EQ(10, stats->columns[1].frequent.size());
+        EXPECT_TRUE(stats->columns[0].frequent.empty());
+        EXPECT_LT(std::abs(stats->getMatches(0, "42") - 1), 0.1);
+        catalog.save();
+    }
+
+    // a later run reads the statistics
+    {
+        StatisticsCatalog catalog(filename);
+        EXPECT_TRUE(catalog.isLoaded());
+        const RelationStatistics* stats = catalog.getRelation("r");
+        ASSERT_TRUE(stats != nullptr);
+        EXPECT_EQ(200000, stats->size);
+        EXPECT_EQ(10, stats->columns[1].distinct);
+        EXPECT_EQ("frequent", stats->columns[3].frequent[0].first);
+        EXPECT_EQ(1, stats->prefixes.count("1,2"));
+        EXPECT_TRUE(catalog.getRelation("s") == nullptr);
+    }
+    std::remove(filename.c_str());
+}
+
+}  // end namespace test
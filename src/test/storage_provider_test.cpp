@@ -0,0 +1,124 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file storage_provider_test.cpp
+ *
+ * A test case testing the storage providers of relations.
+ *
+ ***********************************************************************/
+
+#include "StorageProvider.h"
+#include "test.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+TEST(StorageSystem, Providers) {
+    EXPECT_TRUE(StorageSystem::getInstance().hasProvider("stdset"));
+    EXPECT_FALSE(StorageSystem::getInstance().hasProvider("unknown"));
+
+    bool failed = false;
+    try {
+        StorageSystem::getInstance().getStorage("unknown", 2, {});
+    } catch (const std::invalid_argument&) {
+        failed = true;
+    }
+    EXPECT_TRUE(failed);
+
+    auto storage = StorageSystem::getInstance().getStorage("stdset", 2, {1});
+    RamDomain a[] = {1, 2};
+    RamDomain b[] = {1, 3};
+    EXPECT_TRUE(storage->insert(a));
+    EXPECT_FALSE(storage->insert(a));
+    EXPECT_TRUE(storage->insert(b));
+    EXPECT_EQ(2, storage->size());
+    EXPECT_TRUE(storage->contains(b));
+
+    // a box search on the second column only
+    RamDomain low[] = {MIN_RAM_DOMAIN, 3};
+    RamDomain high[] = {MAX_RAM_DOMAIN, 3};
+    auto cursor = storage->range(2, low, high);
+    const RamDomain* tuple = cursor->next();
+    EXPECT_TRUE(tuple != nullptr);
+    EXPECT_EQ(3, tuple[1]);
+    EXPECT_TRUE(cursor->next() == nullptr);
+
+    storage->clear();
+    EXPECT_EQ(0, storage->size());
+}
+
+TEST(StorageSet, Basic) {
+    using Tuple = ram::Tuple<RamDomain, 2>;
+    StorageSet<2> set("stdset", {1, 2});
+
+    EXPECT_TRUE(set.empty());
+    EXPECT_TRUE(set.begin() == set.end());
+
+    for (RamDomain i = 0; i < 10; ++i) {
+        for (RamDomain j = 0; j < 10; ++j) {
+            EXPECT_TRUE(set.insert({{i, j}}));
+        }
+    }
+    EXPECT_FALSE(set.insert({{3, 4}}));
+    EXPECT_EQ(100, set.size());
+    EXPECT_TRUE(set.contains({{9, 9}}));
+    EXPECT_FALSE(set.contains({{10, 0}}));
+
+    // searches on either column
+    std::vector<Tuple> first;
+    for (const auto& cur : set.equalRange(1, {{4, 0}})) {
+        first.push_back(cur);
+    }
+    EXPECT_EQ(10, first.size());
+    for (const auto& cur : first) {
+        EXPECT_EQ(4, cur[0]);
+    }
+
+    std::vector<Tuple> second;
+    for (const auto& cur : set.equalRange(2, {{0, 7}})) {
+        second.push_back(cur);
+    }
+    EXPECT_EQ(10, second.size());
+    for (const auto& cur : second) {
+        EXPECT_EQ(7, cur[1]);
+    }
+
+    // the partitions cover each tuple once
+    std::vector<Tuple> all;
+    for (const auto& part : set.partition(7)) {
+        for (const auto& cur : part) {
+            all.push_back(cur);
+        }
+    }
+    std::sort(all.begin(), all.end());
+    EXPECT_EQ(100, all.size());
+    EXPECT_TRUE(std::unique(all.begin(), all.end()) == all.end());
+
+    // ranges split by position
+    auto parts = range<StorageSet<2>::iterator>(set.begin(), set.end()).partition(3);
+    std::size_t count = 0;
+    for (const auto& part : parts) {
+        for (auto it = part.begin(); it != part.end(); ++it) {
+            ++count;
+        }
+    }
+    EXPECT_EQ(100, count);
+
+    set.clear();
+    EXPECT_TRUE(set.empty());
+}
+
+}  // namespace test
+}  // namespace souffle
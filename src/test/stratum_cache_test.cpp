@@ -0,0 +1,119 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file stratum_cache_test.cpp
+ *
+ * Tests the cache of the relations computed by strata across runs.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "StratumCache.h"
+#include "SymbolTable.h"
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+/** A tuple of a cached relation */
+struct Entry {
+    const RamDomain* data;
+};
+
+/** A relation cached and restored */
+struct Relation {
+    size_t arity;
+    std::vector<std::vector<RamDomain>> rows;
+    std::vector<Entry> tuples;
+
+    void insert(const RamDomain* tuple) {
+        rows.emplace_back(tuple, tuple + arity);
+    }
+
+    /** Make the rows available for writing */
+    const Relation& entries() {
+        tuples.clear();
+        for (const auto& row : rows) {
+            tuples.push_back(Entry{row.data()});
+        }
+        return *this;
+    }
+
+    std::vector<Entry>::const_iterator begin() const {
+        return tuples.begin();
+    }
+    std::vector<Entry>::const_iterator end() const {
+        return tuples.end();
+    }
+    size_t size() const {
+        return tuples.size();
+    }
+};
+
+const std::string directory = "stratum_cache_test.dir";
+const std::string input = "stratum_cache_test.facts";
+
+TEST(StratumCache, Runs) {
+    std::system(("rm -rf " + directory).c_str());
+    std::ofstream(input) << "a\tb\n";
+    const std::vector<bool> mask = {true, false};
+
+    // the first run evaluates both strata, the second reading the relation of the first
+    {
+        SymbolTable symbols({"x", "a"});
+        Relation r{2, {{1, 7}}, {}};
+        StratumCache cache(directory, 2);
+        EXPECT_FALSE(cache.lookup(0, 42, {}, {input}));
+        cache.saveRelation(0, "r", r.entries(), mask, symbols);
+        cache.commit(0);
+        EXPECT_FALSE(cache.lookup(1, 43, {0}, {}));
+        cache.commit(1);
+    }
+
+    // a later run restores the relations, with symbols of other indices
+    {
+        SymbolTable symbols({"a"});
+        StratumCache cache(directory, 2);
+        EXPECT_TRUE(cache.lookup(0, 42, {}, {input}));
+        Relation r{2, {}, {}};
+        cache.restoreRelation(0, "r", r, mask, symbols);
+        EXPECT_EQ(1, r.rows.size());
+        EXPECT_EQ(0, r.rows[0][0]);
+        EXPECT_EQ(7, r.rows[0][1]);
+        EXPECT_TRUE(cache.lookup(1, 43, {0}, {}));
+
+        // changed code is evaluated again
+        EXPECT_FALSE(cache.lookup(1, 44, {0}, {}));
+    }
+
+    // a changed input changes the keys of the strata downstream of it
+    std::ofstream(input) << "a\tc\n";
+    {
+        StratumCache cache(directory, 2);
+        EXPECT_FALSE(cache.lookup(0, 42, {}, {input}));
+        EXPECT_FALSE(cache.lookup(1, 43, {0}, {}));
+    }
+
+    // a stratum without a key is neither cached nor are those downstream of it
+    {
+        StratumCache cache(directory, 2);
+        EXPECT_FALSE(cache.lookup(0, 42, {}, {"stratum_cache_test.missing"}));
+        cache.commit(0);
+        EXPECT_FALSE(cache.lookup(1, 43, {0}, {}));
+    }
+    std::system(("rm -rf " + directory + " " + input).c_str());
+}
+
+}  // end namespace test
@@ -19,6 +19,10 @@
 
 #include <functional>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 using namespace souffle;
 
 namespace test {
@@ -140,4 +144,234 @@ TEST(SymbolTable, Inserts) {
     if (ECHO_TIME) std::cout << "Time to insert " << N << " new elements: " << n << " ns" << std::endl;
 }
 
+TEST(SymbolTable, LookupAll) {
+    SymbolTable table({"A", "B"});
+
+    std::vector<RamDomain> indices = table.lookupAll({"B", "C", "A", "C"});
+    EXPECT_EQ(4, indices.size());
+    EXPECT_EQ(table.lookup("B"), indices[0]);
+    EXPECT_EQ(table.lookup("C"), indices[1]);
+    EXPECT_EQ(table.lookup("A"), indices[2]);
+    EXPECT_EQ(indices[1], indices[3]);
+    EXPECT_EQ(3, table.size());
+
+    table.prefetch(indices);
+    EXPECT_STREQ("C", table.resolve(indices[1]));
+    EXPECT_TRUE(table.lookupAll({}).empty());
+}
+
+TEST(SymbolTable, StringOperations) {
+    SymbolTable table({"ab", "cd", "abcd", "b"});
+
+    // existing results are found without adding symbols
+    EXPECT_EQ(table.lookup("abcd"), table.lookup("abcdef", 4));
+    EXPECT_EQ(table.lookup("abcd"), table.concat({table.lookup("ab"), table.lookup("cd")}));
+    EXPECT_EQ(table.lookup("b"), table.substr(table.lookup("abcd"), 1, 1));
+    EXPECT_EQ(table.lookup("cd"), table.substr(table.lookup("abcd"), 2, 10));
+    EXPECT_EQ(4, table.size());
+
+    // new results are inserted
+    RamDomain abab = table.concat({table.lookup("ab"), table.lookup("ab")});
+    EXPECT_EQ("abab", table.resolve(abab));
+    EXPECT_EQ("", table.resolve(table.concat({})));
+    EXPECT_EQ("bcd", table.resolve(table.substr(table.lookup("abcd"), 1, 3)));
+    EXPECT_EQ("", table.resolve(table.substr(table.lookup("abcd"), 4, 1)));
+    EXPECT_EQ(7, table.size());
+}
+
+TEST(SymbolTable, StaticSegment) {
+    const int N = 10000;
+
+    std::vector<std::string> symbols;
+    for (int i = 0; i < N; ++i) {
+        symbols.push_back("literal" + std::to_string(i));
+    }
+    std::vector<uint32_t> displacements;
+    std::vector<uint32_t> slots;
+    EXPECT_TRUE(SymbolTable::buildSegment(symbols, displacements, slots));
+
+    std::vector<const char*> data;
+    std::vector<uint32_t> lengths;
+    for (const auto& symbol : symbols) {
+        data.push_back(symbol.c_str());
+        lengths.push_back(symbol.size());
+    }
+    const SymbolSegment segment{symbols.size(), data.data(), lengths.data(), displacements.size(),
+            displacements.data(), slots.size(), slots.data()};
+
+    SymbolTable table(segment);
+    EXPECT_EQ(N, table.size());
+    for (int i = 0; i < N; ++i) {
+        EXPECT_EQ(i, table.lookup(symbols[i]));
+        EXPECT_EQ(symbols[i], table.resolve(i));
+    }
+
+    // symbols not in the segment follow its symbols
+    EXPECT_FALSE(table.contains("literal"));
+    EXPECT_EQ(N, table.lookup("literal"));
+    EXPECT_EQ(N, table.lookup("literal"));
+    EXPECT_EQ(N + 1, table.lookup("literal" + std::to_string(N)));
+    EXPECT_EQ(N + 2, table.size());
+
+    SymbolTable copy(table);
+    EXPECT_EQ(N + 2, copy.size());
+    EXPECT_EQ(N + 1, copy.lookup("literal" + std::to_string(N)));
+    EXPECT_EQ(7, copy.lookup(symbols[7]));
+    EXPECT_EQ("literal", copy.resolve(N));
+}
+
+TEST(SymbolTable, Dictionary) {
+    const int N = 10000;
+    const std::string file = tempFile();
+
+    SymbolTable table;
+    for (int i = 0; i < N; ++i) {
+        table.lookup("symbol" + std::to_string(i));
+    }
+    table.save(file);
+
+    // a loaded table keeps the indices of the saved one, symbols of later programs following them
+    SymbolTable loaded = SymbolTable::load(file);
+    EXPECT_TRUE(loaded.getDictionary() != nullptr);
+    EXPECT_EQ(N, loaded.size());
+    for (int i = 0; i < N; ++i) {
+        EXPECT_EQ(i, loaded.lookup("symbol" + std::to_string(i)));
+        EXPECT_EQ("symbol" + std::to_string(i), loaded.resolve(i));
+    }
+    EXPECT_EQ(N, loaded.lookup("later"));
+
+    // saving a loaded table chains the dictionary of one program into the next
+    loaded.save(file);
+    const uint64_t checksum = SymbolTable::load(file).getDictionary()->getChecksum();
+    SymbolTable chained = SymbolTable::load(file, checksum, {"literal"});
+    EXPECT_EQ(N + 2, chained.size());
+    EXPECT_EQ(N, chained.lookup("later"));
+    EXPECT_EQ(N + 1, chained.lookup("literal"));
+    EXPECT_EQ(7, chained.lookup("symbol7"));
+
+    SymbolTable copy(chained);
+    EXPECT_EQ("later", copy.resolve(N));
+
+    bool rejected = false;
+    try {
+        SymbolTable::load(file, checksum + 1);
+    } catch (std::runtime_error&) {
+        rejected = true;
+    }
+    EXPECT_TRUE(rejected);
+    remove(file.c_str());
+}
+
+#ifdef _OPENMP
+
+TEST(SymbolTable, ParallelLookup) {
+    const int N = 100000;
+
+    SymbolTable X;
+    std::vector<RamDomain> idx(N);
+
+    // all threads look up the same symbols and have to agree on their indices
+#pragma omp parallel
+    {
+        std::vector<RamDomain> mine(N);
+        for (int i = 0; i < N; ++i) {
+            mine[i] = X.lookup(std::to_string(i) + "string");
+        }
+#pragma omp single
+        idx = mine;
+#pragma omp critical
+        for (int i = 0; i < N; ++i) {
+            EXPECT_EQ(idx[i], mine[i]);
+        }
+    }
+
+    EXPECT_EQ(N, X.size());
+    for (int i = 0; i < N; ++i) {
+        EXPECT_EQ(std::to_string(i) + "string", X.resolve(idx[i]));
+    }
+}
+
+TEST(SymbolTable, ParallelResolve) {
+    const int N = 100000;
+
+    SymbolTable X;
+    std::atomic<int> mismatches(0);
+
+    // half of the tasks insert symbols while the others resolve every published index
+#pragma omp parallel for num_threads(8)
+    for (int task = 0; task < 8; ++task) {
+        if (task % 2 == 0) {
+            for (int i = task / 2; i < N; i += 4) {
+                X.lookup(std::to_string(i) + "string");
+            }
+        } else {
+            for (int round = 0; round < 10; ++round) {
+                const size_t published = X.size();
+                for (size_t i = 0; i < published; ++i) {
+                    const std::string& symbol = X.resolve(i);
+                    if (symbol.size() < 7 || symbol.compare(symbol.size() - 6, 6, "string") != 0) {
+                        mismatches++;
+                    }
+                }
+            }
+        }
+    }
+
+    EXPECT_EQ(0, mismatches.load());
+    EXPECT_EQ(N, X.size());
+}
+
+TEST(SymbolTable, ParallelScaling) {
+    // whether to print the recorded times to stdout
+    // should be false unless developing
+    const bool ECHO_TIME = false;
+
+    const int N = 200000;  // number of symbols
+    const int M = 4;       // number of resolves per lookup
+
+    std::vector<std::string> A;
+    A.reserve(N);
+    for (int i = 0; i < N; ++i) {
+        A.push_back(std::to_string(i) + "string");
+    }
+
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        omp_set_num_threads(threads);
+        SymbolTable X;
+
+        // insert new symbols
+        time_point start = now();
+#pragma omp parallel for
+        for (int i = 0; i < N; ++i) {
+            X.lookup(A[i]);
+        }
+        time_point end = now();
+        long insert = duration_in_ns(start, end);
+
+        // look up existing symbols and resolve them
+        size_t checksum = 0;
+        start = now();
+#pragma omp parallel for reduction(+ : checksum)
+        for (int i = 0; i < N; ++i) {
+            RamDomain index = X.lookup(A[i]);
+            for (int j = 0; j < M; ++j) {
+                checksum += X.resolve(index).size();
+            }
+        }
+        end = now();
+        long mixed = duration_in_ns(start, end);
+
+        EXPECT_EQ(N, X.size());
+        EXPECT_LT(0, checksum);
+
+        if (ECHO_TIME) {
+            std::cout << "Threads: " << threads << "\t"
+                      << "insert: " << (N * 1000.0 / insert) << " Msym/s\t"
+                      << "lookup+resolve: " << (N * (M + 1) * 1000.0 / mixed) << " Mop/s" << std::endl;
+        }
+    }
+}
+
+#endif
+
 }  // end namespace test
@@ -0,0 +1,69 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file trace_log_test.cpp
+ *
+ * Tests the timeline of events exported in the Chrome trace event format.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "TraceLog.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace souffle;
+
+namespace test {
+
+static std::string readFile(const std::string& name) {
+    std::ifstream in(name);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+TEST(TraceLog, Events) {
+    TraceLog& log = TraceLog::instance();
+
+    // nothing is recorded before the trace is opened
+    { TraceLog::Span span("ignored", "test"); }
+    EXPECT_FALSE(log.isEnabled());
+
+    const std::string name = "/tmp/souffle_trace_log_test.json";
+    log.open(name);
+    EXPECT_TRUE(log.isEnabled());
+    {
+        TraceLog::Span span("stratum 0", "stratum");
+        span.set("tuples", 42);
+    }
+    std::thread worker([]() { TraceLog::Span span("load \"edge\"", "io"); });
+    worker.join();
+    log.write();
+
+    const std::string trace = readFile(name);
+    EXPECT_EQ(0, trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    EXPECT_EQ(std::string::npos, trace.find("ignored"));
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"stratum 0\",\"cat\":\"stratum\",\"ph\":\"X\""));
+    EXPECT_NE(std::string::npos, trace.find("\"args\":{\"tuples\":42}"));
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"load \\\"edge\\\"\""));
+
+    // each thread is named by its own metadata event
+    EXPECT_NE(std::string::npos, trace.find("\"tid\":0,\"args\":{\"name\":\"thread 0\"}"));
+    EXPECT_NE(std::string::npos, trace.find("\"tid\":1,\"args\":{\"name\":\"thread 1\"}"));
+    EXPECT_EQ(trace.size() - 3, trace.rfind("]}\n"));
+    std::remove(name.c_str());
+}
+
+}  // end namespace test
@@ -0,0 +1,123 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file transitive_closure_test.cpp
+ *
+ * Tests the computation of the transitive closure of binary relations.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "TransitiveClosure.h"
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+using Pairs = std::set<std::pair<RamDomain, RamDomain>>;
+
+/** Compute the closure of the given edges, clearing the flag if the values are not reported in order */
+Pairs closure(const Pairs& edges, bool& ordered) {
+    TransitiveClosure graph;
+    for (const auto& edge : edges) {
+        graph.addEdge(edge.first, edge.second);
+    }
+    Pairs res;
+    bool first = true;
+    RamDomain previous = 0;
+    graph.compute([&](RamDomain from, const std::vector<RamDomain>& reached) {
+        ordered = ordered && (first || previous < from);
+        first = false;
+        previous = from;
+        for (size_t i = 0; i < reached.size(); i++) {
+            ordered = ordered && (i == 0 || reached[i - 1] < reached[i]);
+            res.insert(std::make_pair(from, reached[i]));
+        }
+    });
+    return res;
+}
+
+/** Compute the closure of the given edges by a naive fixpoint */
+Pairs naiveClosure(const Pairs& edges) {
+    Pairs res = edges;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        Pairs added;
+        for (const auto& a : res) {
+            for (auto b = res.lower_bound(std::make_pair(a.second, MIN_RAM_DOMAIN));
+                    b != res.end() && b->first == a.second; ++b) {
+                if (res.count(std::make_pair(a.first, b->second)) == 0) {
+                    added.insert(std::make_pair(a.first, b->second));
+                }
+            }
+        }
+        changed = !added.empty();
+        res.insert(added.begin(), added.end());
+    }
+    return res;
+}
+
+TEST(TransitiveClosure, Empty) {
+    bool ordered = true;
+    EXPECT_TRUE(closure(Pairs(), ordered).empty());
+}
+
+TEST(TransitiveClosure, Cycles) {
+    // a chain into a cycle, a self-loop and a negative value
+    Pairs edges = {{1, 2}, {2, 3}, {3, 4}, {4, 2}, {5, 5}, {-1, 1}};
+    bool ordered = true;
+    Pairs res = closure(edges, ordered);
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(naiveClosure(edges), res);
+    EXPECT_EQ(1, res.count(std::make_pair(2, 2)));
+    EXPECT_EQ(1, res.count(std::make_pair(5, 5)));
+    EXPECT_EQ(0, res.count(std::make_pair(1, 1)));
+    EXPECT_EQ(0, res.count(std::make_pair(-1, -1)));
+    EXPECT_EQ(1, res.count(std::make_pair(-1, 4)));
+}
+
+TEST(TransitiveClosure, Random) {
+    srand(42);
+    for (int round = 0; round < 10; round++) {
+        Pairs edges;
+        int size = 5 + round * 5;
+        for (int i = 0; i < 2 * size; i++) {
+            edges.insert(std::make_pair(rand() % size, rand() % size));
+        }
+        bool ordered = true;
+        EXPECT_EQ(naiveClosure(edges), closure(edges, ordered));
+        EXPECT_TRUE(ordered);
+    }
+}
+
+TEST(TransitiveClosure, Blocks) {
+    // a chain over more values than are computed at a time, closed into a cycle at its end
+    const RamDomain n = 10000;
+    TransitiveClosure graph;
+    for (RamDomain i = 0; i < n; i++) {
+        graph.addEdge(i, i + 1);
+    }
+    graph.addEdge(n, n - 1);
+    size_t count = 0;
+    graph.compute([&](RamDomain from, const std::vector<RamDomain>& reached) {
+        EXPECT_EQ(from < n - 1 ? n - from : 2, reached.size());
+        count += reached.size();
+    });
+    EXPECT_EQ((n - 1) * (n + 2) / 2 + 4, count);
+}
+
+}  // end namespace test
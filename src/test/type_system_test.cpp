@@ -352,5 +352,65 @@ TEST(TypeSystem, MultipleLeastCommonSupertype) {
     EXPECT_EQ("{U,V}", toString(getLeastCommonSupertypes(A, B)));
 }
 
+TEST(TypeSystem, FinalisedLattice) {
+    TypeEnvironment env;
+
+    auto& A = env.createNumericType("A");
+    auto& B = env.createNumericType("B");
+    auto& C = env.createSymbolType("C");
+
+    auto& U = env.createUnionType("U");
+    U.add(A);
+    U.add(B);
+
+    auto& V = env.createUnionType("V");
+    V.add(A);
+    V.add(B);
+
+    auto& W = env.createUnionType("W");
+    W.add(U);
+    W.add(env.getSymbolType());
+
+    // a cycle of union types
+    auto& X = env.createUnionType("X");
+    auto& Y = env.createUnionType("Y");
+    X.add(Y);
+    X.add(C);
+    Y.add(X);
+
+    auto& R = env.createRecordType("R");
+    R.add("a", A);
+
+    // the precomputed lattice answers all queries as the plain type environment does
+    TypeSet all = env.getAllTypes();
+    std::map<std::pair<const Type*, const Type*>, std::pair<bool, std::string>> expected;
+    for (const Type& a : all) {
+        for (const Type& b : all) {
+            expected[std::make_pair(&a, &b)] =
+                    std::make_pair(isSubtypeOf(a, b), toString(getLeastCommonSupertypes(a, b)));
+        }
+    }
+    env.finalise();
+    EXPECT_TRUE(env.isFinalised());
+    for (const Type& a : all) {
+        for (const Type& b : all) {
+            const auto& res = expected[std::make_pair(&a, &b)];
+            EXPECT_EQ(res.first, isSubtypeOf(a, b)) << a << " " << b;
+            EXPECT_EQ(res.second, toString(getLeastCommonSupertypes(a, b))) << a << " " << b;
+        }
+    }
+    EXPECT_EQ("{U,V}", toString(getLeastCommonSupertypes(A, B)));
+    EXPECT_EQ("{W}", toString(getLeastCommonSupertypes(U, C)));
+    EXPECT_TRUE(isNumberType(U));
+    EXPECT_TRUE(isSymbolType(C));
+    EXPECT_FALSE(isNumberType(R));
+
+    // changing a union type discards the lattice
+    V.add(C);
+    EXPECT_FALSE(env.isFinalised());
+    EXPECT_TRUE(isSubtypeOf(C, V));
+    EXPECT_EQ("{V,W}", toString(getLeastCommonSupertypes(A, C)));
+}
+
 }  // end namespace test
 }  // end namespace souffle
@@ -75,6 +75,16 @@ TEST(Util, NullStream) {
     (*out) << "Hello World!\n";
 }
 
+TEST(Util, ContentHash) {
+    // reference values of 64-bit FNV-1a
+    EXPECT_EQ("cbf29ce484222325", contentHash(""));
+    EXPECT_EQ("af63dc4c8601ec8c", contentHash("a"));
+    EXPECT_EQ("85944171f73967e8", contentHash("foobar"));
+
+    EXPECT_EQ(contentHash("stratum"), contentHash(std::string("strat") + "um"));
+    EXPECT_NE(contentHash("stratum 1"), contentHash("stratum 2"));
+}
+
 TEST(Util, LRUCache) {
     using cache = LRUCache<int, 4>;
     cache c;
@@ -0,0 +1,76 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file write_queue_test.cpp
+ *
+ * Tests the queue of output tasks run on a background thread.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "WriteQueue.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+TEST(WriteQueue, Order) {
+    std::vector<int> done;
+    {
+        WriteQueue queue;
+        for (int i = 0; i < 100; ++i) {
+            queue.submit(&done, [&done, i]() { done.push_back(i); });
+        }
+        queue.wait();
+        EXPECT_EQ(100, done.size());
+        queue.submit(&done, [&done]() { done.push_back(100); });
+    }
+    // the queue waits for its tasks once destroyed
+    EXPECT_EQ(101, done.size());
+    bool ordered = true;
+    for (size_t i = 0; i < done.size(); ++i) {
+        ordered = ordered && done[i] == static_cast<int>(i);
+    }
+    EXPECT_TRUE(ordered);
+}
+
+TEST(WriteQueue, Release) {
+    WriteQueue queue;
+
+    // a relation not written is freed at once
+    int other = 0;
+    queue.release(&other, [&other]() { other = 1; });
+    EXPECT_EQ(1, other);
+
+    // a written relation is freed after its writes
+    auto* relation = new std::vector<int>(1000, 1);
+    std::atomic<int> sum{0};
+    std::atomic<bool> freed{false};
+    queue.submit(relation, [relation, &sum]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        for (int value : *relation) {
+            sum += value;
+        }
+    });
+    queue.release(relation, [relation, &freed]() {
+        delete relation;
+        freed = true;
+    });
+    queue.wait();
+    EXPECT_EQ(1000, sum);
+    EXPECT_TRUE(freed);
+}
+
+}  // end namespace test
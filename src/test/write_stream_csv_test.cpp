@@ -0,0 +1,159 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file write_stream_csv_test.cpp
+ *
+ * Tests the fact file writer, writing relations tuple by tuple, in
+ * parallel, into shards and up to a limit.
+ *
+ ***********************************************************************/
+
+#include "test.h"
+
+#include "IODirectives.h"
+#include "IOSystem.h"
+#include "SymbolTable.h"
+#include "Util.h"
+#include "WriteStreamCSV.h"
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+namespace test {
+
+/** A tuple of a written relation */
+struct Entry {
+    const RamDomain* data;
+};
+
+/** A relation written tuple by tuple */
+struct Relation {
+    std::vector<Entry> tuples;
+
+    std::vector<Entry>::const_iterator begin() const {
+        return tuples.begin();
+    }
+    std::vector<Entry>::const_iterator end() const {
+        return tuples.end();
+    }
+    size_t size() const {
+        return tuples.size();
+    }
+};
+
+/** A relation written in parts */
+struct PartitionedRelation : public Relation {
+    std::vector<range<std::vector<Entry>::const_iterator>> partition() const {
+        std::vector<range<std::vector<Entry>::const_iterator>> parts;
+        for (size_t i = 0; i < tuples.size(); i += 7) {
+            parts.push_back(make_range(begin() + i, begin() + std::min(i + 7, tuples.size())));
+        }
+        return parts;
+    }
+};
+
+const std::string fileName = "write_stream_csv_test.csv";
+
+std::string readFile(const std::string& name) {
+    std::ifstream in(name, std::ios::binary);
+    std::stringstream content;
+    content << in.rdbuf();
+    std::remove(name.c_str());
+    return content.str();
+}
+
+template <typename R>
+std::string write(const std::vector<std::vector<RamDomain>>& rows, const std::vector<bool>& mask,
+        const SymbolTable& symbols, std::map<std::string, std::string> directives = {}) {
+    R relation;
+    for (const auto& row : rows) {
+        relation.tuples.push_back(Entry{row.data()});
+    }
+    directives["IO"] = "file";
+    directives["filename"] = fileName;
+    directives["name"] = "test";
+    WriteFileCSVFactory().getWriter(mask, symbols, IODirectives(directives), false)->writeAll(relation);
+    return readFile(fileName);
+}
+
+TEST(WriteFileCSV, Numbers) {
+    SymbolTable symbols;
+    const RamDomain min = std::numeric_limits<RamDomain>::min();
+    const RamDomain max = std::numeric_limits<RamDomain>::max();
+    std::stringstream expected;
+    expected << "0\t-1\t10\n" << min << "\t" << max << "\t-100\n";
+    EXPECT_EQ(expected.str(),
+            write<Relation>({{0, -1, 10}, {min, max, -100}}, {false, false, false}, symbols));
+}
+
+TEST(WriteFileCSV, Symbols) {
+    SymbolTable symbols;
+    const RamDomain a = symbols.lookup("a");
+    const RamDomain b = symbols.lookup("");
+    EXPECT_EQ("a,1,\n,2,a\n", write<Relation>({{a, 1, b}, {b, 2, a}}, {true, false, true}, symbols,
+                                     {{"delimiter", ","}}));
+    EXPECT_EQ("x\ty\n()\n",
+            write<Relation>({{}}, {}, symbols, {{"headers", "true"}, {"attributeNames", "x\ty"}}));
+}
+
+TEST(WriteFileCSV, Parallel) {
+    SymbolTable symbols;
+    std::vector<std::vector<RamDomain>> rows;
+    std::string expected;
+    for (RamDomain i = 0; i < 1000; ++i) {
+        rows.push_back({i, symbols.lookup("s" + std::to_string(i % 13))});
+        expected += std::to_string(i) + "\ts" + std::to_string(i % 13) + "\n";
+    }
+    const std::vector<bool> mask = {false, true};
+    EXPECT_EQ(expected, write<Relation>(rows, mask, symbols));
+    EXPECT_EQ(expected, write<PartitionedRelation>(rows, mask, symbols));
+    EXPECT_EQ(expected, write<PartitionedRelation>(rows, mask, symbols, {{"parallel", "true"}}));
+
+    // the shards hold consecutive parts of the relation
+    write<PartitionedRelation>(rows, mask, symbols, {{"shards", "3"}});
+    std::string sharded;
+    for (int shard = 0; shard < 3; ++shard) {
+        sharded += readFile(fileName + "." + std::to_string(shard));
+    }
+    EXPECT_EQ(expected, sharded);
+}
+
+TEST(WriteFileCSV, Limit) {
+    SymbolTable symbols;
+    std::vector<std::vector<RamDomain>> rows;
+    for (RamDomain i = 0; i < 100; ++i) {
+        rows.push_back({i});
+    }
+    Relation relation;
+    for (const auto& row : rows) {
+        relation.tuples.push_back(Entry{row.data()});
+    }
+
+    // writers obtained from the IO system stop after the given number of tuples
+    IODirectives directives({{"IO", "file"}, {"filename", fileName}, {"name", "test"}, {"limit", "3"}});
+    IOSystem::getInstance().getWriter({false}, symbols, directives, false)->writeAll(relation);
+    EXPECT_EQ("0\n1\n2\n", readFile(fileName));
+
+    // as do the sizes printed
+    std::stringstream out;
+    auto* buf = std::cout.rdbuf(out.rdbuf());
+    IODirectives summary({{"IO", "stdoutprintsize"}, {"name", "test"}, {"limit", "3"}});
+    IOSystem::getInstance().getWriter({false}, symbols, summary, false)->writeAll(relation);
+    std::cout.rdbuf(buf);
+    EXPECT_EQ("test\t3\n", out.str());
+}
+
+}  // end namespace test
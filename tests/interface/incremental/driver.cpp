@@ -0,0 +1,91 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file driver.cpp
+ *
+ * Driver program updating the relations of a Souffle program incrementally
+ * with the tuples inserted and retracted through the OO-interface
+ *
+ ***********************************************************************/
+
+#include "souffle/SouffleInterface.h"
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace souffle;
+
+/**
+ * Error handler
+ */
+void error(std::string txt) {
+    std::cerr << "error: " << txt << "\n";
+    exit(1);
+}
+
+/**
+ * Print the number of paths and the acyclic and cyclic nodes
+ */
+void print(SouffleProgram* prog) {
+    std::cout << "path " << prog->getRelation("path")->size() << "\n";
+    for (const char* name : {"acyclic", "cyclic"}) {
+        std::cout << name;
+        for (auto& output : *prog->getRelation(name)) {
+            std::string node;
+            output >> node;
+            std::cout << " " << node;
+        }
+        std::cout << "\n";
+    }
+}
+
+/**
+ * Main program
+ */
+int main(int argc, char** argv) {
+    // create an instance of program "incremental"
+    SouffleProgram* prog = ProgramFactory::newInstance("incremental");
+    if (prog == nullptr) {
+        error("cannot find program incremental");
+    }
+    Relation* edge = prog->getRelation("edge");
+    if (edge == nullptr) {
+        error("cannot find relation edge");
+    }
+
+    // evaluate the program with the edges of the facts directory
+    prog->loadAll(argv[1]);
+    prog->run();
+    print(prog);
+
+    // insert edges, closing a cycle with the second, then retract edges, and update the relations
+    std::vector<std::pair<std::array<std::string, 2>, bool>> updates = {
+            {{"c", "d"}, true}, {{"d", "a"}, true}, {{"d", "a"}, false}, {{"a", "b"}, false}};
+    for (const auto& update : updates) {
+        tuple t(edge);
+        t << update.first[0] << update.first[1];
+        if (update.second) {
+            edge->insert(t);
+        } else if (!edge->retract(t)) {
+            error("cannot retract edge");
+        }
+        prog->runIncremental();
+        print(prog);
+    }
+
+    // an update without changes keeps the relations
+    prog->runIncremental();
+    print(prog);
+
+    // free program analysis
+    delete prog;
+    return 0;
+}
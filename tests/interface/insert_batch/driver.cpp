@@ -0,0 +1,88 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2019, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file driver.cpp
+ *
+ * Driver program inserting into, scanning and querying the relations of a
+ * Souffle program in batches through the OO-interface
+ *
+ ***********************************************************************/
+
+#include "souffle/SouffleInterface.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace souffle;
+
+/**
+ * Error handler
+ */
+void error(std::string txt) {
+    std::cerr << "error: " << txt << "\n";
+    exit(1);
+}
+
+/**
+ * Print a batch of paths
+ */
+void print(const SymbolTable& symbols, const RamDomain* batch, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        std::cout << symbols.resolve(batch[2 * i]) << "-" << symbols.resolve(batch[2 * i + 1]) << "\n";
+    }
+}
+
+/**
+ * Main program
+ */
+int main(int argc, char** argv) {
+    // create an instance of program "insert_batch"
+    SouffleProgram* prog = ProgramFactory::newInstance("insert_batch");
+    if (prog == nullptr) {
+        error("cannot find program insert_batch");
+    }
+    Relation* edge = prog->getRelation("edge");
+    Relation* path = prog->getRelation("path");
+    if (edge == nullptr || path == nullptr) {
+        error("cannot find relations of program insert_batch");
+    }
+
+    // look up the symbols at once, and insert the edges of a chain between them in one batch
+    SymbolTable& symbols = prog->getSymbolTable();
+    const std::vector<RamDomain> nodes = symbols.lookupAll({"A", "B", "C", "D", "E"});
+    std::vector<RamDomain> rows;
+    for (size_t i = 0; i + 1 < nodes.size(); i++) {
+        rows.push_back(nodes[i]);
+        rows.push_back(nodes[i + 1]);
+    }
+    edge->insertBatch(rows.data(), rows.size() / 2);
+
+    prog->run();
+
+    // read the paths in batches of four
+    path->scan(
+            [&](const RamDomain* batch, size_t n) {
+                std::cout << "batch " << n << "\n";
+                print(symbols, batch, n);
+            },
+            4);
+
+    // query the paths from B and those to E, binding one column each
+    const std::vector<RamDomain> pattern = {nodes[1], nodes[4]};
+    for (uint64_t columns : {1, 2}) {
+        std::cout << "query " << columns << "\n";
+        path->equalRange(pattern.data(), columns,
+                [&](const RamDomain* batch, size_t n) { print(symbols, batch, n); });
+    }
+
+    delete prog;
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+#!/bin/bash
+# Souffle - A Datalog Compiler
+# Copyright (c) 2019, The Souffle Developers. All rights reserved.
+# Licensed under the Universal Permissive License v 1.0 as shown at:
+# - https://opensource.org/licenses/UPL
+# - <souffle root>/licenses/SOUFFLE-UPL.txt
+
+# Compares the switch and the direct-threaded instruction dispatch of the LVM
+# on the evaluation test programs.
+#
+# usage: benchmark-lvm-dispatch.sh [souffle binary] [repetitions]
+
+SOUFFLE=${1:-src/souffle}
+RUNS=${2:-3}
+TESTS=$(dirname "$0")/../tests/evaluation
+
+if [ ! -x "$SOUFFLE" ]; then
+    echo "souffle binary $SOUFFLE not found" >&2
+    exit 1
+fi
+
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+# prints the best wall clock time in seconds out of $RUNS runs
+best_time() {
+    local best=""
+    for ((i = 0; i < RUNS; i++)); do
+        local start=$(date +%s.%N)
+        "$SOUFFLE" "$@" >/dev/null 2>&1
+        local end=$(date +%s.%N)
+        local t=$(echo "$end - $start" | bc)
+        if [ -z "$best" ] || [ "$(echo "$t < $best" | bc)" = 1 ]; then
+            best=$t
+        fi
+    done
+    echo "$best"
+}
+
+printf "%-30s %10s %10s %8s\n" "program" "switch" "threaded" "speedup"
+total_switch=0
+total_threaded=0
+for dir in "$TESTS"/*/; do
+    name=$(basename "$dir")
+    program="$dir/$name.dl"
+    [ -f "$program" ] || continue
+    facts="$dir"
+    [ -d "$dir/facts" ] && facts="$dir/facts"
+
+    switch=$(best_time --lvm-dispatch=switch -F "$facts" -D "$OUT" "$program")
+    threaded=$(best_time --lvm-dispatch=threaded -F "$facts" -D "$OUT" "$program")
+    speedup=$(echo "scale=2; $switch / ($threaded + 0.0001)" | bc)
+    printf "%-30s %10.3f %10.3f %8s\n" "$name" "$switch" "$threaded" "$speedup"
+
+    total_switch=$(echo "$total_switch + $switch" | bc)
+    total_threaded=$(echo "$total_threaded + $threaded" | bc)
+done
+printf "%-30s %10.3f %10.3f %8s\n" "total" "$total_switch" "$total_threaded" \
+        "$(echo "scale=2; $total_switch / ($total_threaded + 0.0001)" | bc)"
@@ -0,0 +1,237 @@
+#!/bin/bash
+# Souffle - A Datalog Compiler
+# Copyright (c) 2019, The Souffle Developers. All rights reserved.
+# Licensed under the Universal Permissive License v 1.0 as shown at:
+# - https://opensource.org/licenses/UPL
+# - <souffle root>/licenses/SOUFFLE-UPL.txt
+
+# Runs the scaling benchmark programs of tests/scaling on synthetic facts of
+# increasing size at several thread counts, and records the wall time, the
+# throughput and the peak memory of each run. A record can be summarised as
+# the scaling curves of each program in the size of its input and in the
+# number of threads.
+#
+# usage: benchmark-scaling.sh [-s souffle] [-m modes] [-n sizes] [-j jobs] [-r runs]
+#                             [-f csv|json] [-o file] [program...]
+#        benchmark-scaling.sh -S record.csv
+#
+#   -s  souffle binary (src/souffle)
+#   -m  comma-separated evaluation modes: compiled, lvm and rami (lvm)
+#   -n  comma-separated sizes of the generated facts (10000,100000)
+#   -j  comma-separated thread counts (1,2,4)
+#   -r  repetitions of each run (3)
+#   -f  output format (csv)
+#   -o  output file (standard output)
+#   -S  summarise a csv record by the best of the runs of each measure
+#
+# The facts of a program are generated by utilities/generate-facts.sh with the
+# arguments of the "// generate:" line of the program, followed by the size.
+# A record has a row for each measure: the number of input tuples ("facts"),
+# the wall time in seconds ("wall"), the input tuples per second
+# ("throughput") and the peak resident memory in kilobytes ("rss", requiring
+# GNU time).
+#
+# The summary gives for each run the speedup over the fewest threads of the
+# same size, the memory per input tuple, and the exponent of the growth of
+# the time and the memory over the next smaller size, 1 being linear.
+
+SOUFFLE=src/souffle
+MODES=lvm
+SIZES=10000,100000
+JOBS=1,2,4
+RUNS=3
+FORMAT=csv
+OUTPUT=/dev/stdout
+SUMMARY=0
+
+while getopts "s:m:n:j:r:f:o:S" opt; do
+    case $opt in
+        s) SOUFFLE=$OPTARG ;;
+        m) MODES=$OPTARG ;;
+        n) SIZES=$OPTARG ;;
+        j) JOBS=$OPTARG ;;
+        r) RUNS=$OPTARG ;;
+        f) FORMAT=$OPTARG ;;
+        o) OUTPUT=$OPTARG ;;
+        S) SUMMARY=1 ;;
+        *) sed -n '/^# usage/,/^$/p' "$0" >&2; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+# summarises the best runs of a record as scaling curves
+if [ "$SUMMARY" = 1 ]; then
+    if [ $# -ne 1 ]; then
+        echo "summary requires a record" >&2
+        exit 1
+    fi
+    awk -F, '
+        FNR == 1 { next }
+        {
+            key = $1 "," $2 "," $3 "," $4
+            if (!(key in seen)) { seen[key] = 1; keys[n++] = key }
+            measure = key "," $6
+            if (!(measure in best) || ($6 == "throughput" ? $7 > best[measure] : $7 < best[measure])) {
+                best[measure] = $7
+            }
+        }
+        # the exponent of the growth of a measure from size s0 to size s1
+        function growth(m1, m0, s1, s0) {
+            return (m0 > 0 && m1 > 0 && s1 != s0) ? sprintf("%.2f", log(m1 / m0) / log(s1 / s0)) : "-"
+        }
+        END {
+            printf "%-12s %-9s %9s %5s %12s %10s %12s %8s %10s %8s %8s\n", "program", "mode", "size",
+                   "jobs", "facts", "wall", "throughput", "speedup", "rss", "B/fact", "growth"
+            for (i = 0; i < n; i++) {
+                split(keys[i], f, ",")
+                wall = best[keys[i] ",wall"]
+                facts = best[keys[i] ",facts"]
+                rss = best[keys[i] ",rss"]
+
+                # the run of the fewest threads at the same size, and of the same threads at the
+                # next smaller size
+                base = ""
+                smaller = ""
+                for (j = 0; j < n; j++) {
+                    split(keys[j], g, ",")
+                    if (g[1] != f[1] || g[2] != f[2]) continue
+                    if (g[3] == f[3] && (base == "" || g[4] + 0 < baseJobs)) {
+                        base = keys[j]
+                        baseJobs = g[4]
+                    }
+                    if (g[4] == f[4] && g[3] + 0 < f[3] + 0 && (smaller == "" || g[3] + 0 > smallerSize)) {
+                        smaller = keys[j]
+                        smallerSize = g[3]
+                    }
+                }
+                speedup = (wall > 0) ? sprintf("%.2f", best[base ",wall"] / wall) : "-"
+                perFact = (rss != "" && facts > 0) ? sprintf("%.0f", rss * 1024 / facts) : "-"
+                scaling = "-"
+                if (smaller != "") {
+                    scaling = growth(wall, best[smaller ",wall"], f[3], smallerSize)
+                    if (rss != "") scaling = scaling "/" growth(rss, best[smaller ",rss"], f[3], smallerSize)
+                }
+                printf "%-12s %-9s %9s %5s %12s %10s %12s %8s %10s %8s %8s\n", f[1], f[2], f[3], f[4],
+                       facts, wall, best[keys[i] ",throughput"], speedup, (rss != "") ? rss : "-",
+                       perFact, scaling
+            }
+        }' "$1"
+    exit $?
+fi
+
+if [ ! -x "$SOUFFLE" ]; then
+    echo "souffle binary $SOUFFLE not found" >&2
+    exit 1
+fi
+TESTS=$(dirname "$0")/../tests/scaling
+GENERATE=$(dirname "$0")/generate-facts.sh
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# the programs given, or all scaling benchmarks
+PROGRAMS=("$@")
+if [ ${#PROGRAMS[@]} -eq 0 ]; then
+    for dir in "$TESTS"/*/; do
+        PROGRAMS+=("$(basename "$dir")")
+    done
+fi
+
+# records a measure of a run
+ROWS=()
+record() {
+    ROWS+=("$1,$2,$3,$4,$5,$6,$7")
+}
+
+# runs a command, printing its wall time in seconds and its peak memory in kilobytes, the latter
+# only if GNU time is available
+measure() {
+    if [ -x /usr/bin/time ]; then
+        /usr/bin/time -f "%e %M" -o "$WORK/time" "$@" >/dev/null 2>&1 || return 1
+        cat "$WORK/time"
+    else
+        local start=$(date +%s.%N)
+        "$@" >/dev/null 2>&1 || return 1
+        local end=$(date +%s.%N)
+        awk -v start="$start" -v end="$end" 'BEGIN { printf "%.3f\n", end - start }'
+    fi
+}
+
+for name in "${PROGRAMS[@]}"; do
+    program="$TESTS/$name/$name.dl"
+    if [ ! -f "$program" ]; then
+        echo "skipping $name: no program" >&2
+        continue
+    fi
+    read -r -a generator <<< "$(sed -n 's|^// generate: *||p' "$program")"
+    if [ ${#generator[@]} -eq 0 ]; then
+        echo "skipping $name: no generate line" >&2
+        continue
+    fi
+    mkdir -p "$WORK/out"
+
+    for size in ${SIZES//,/ }; do
+        facts="$WORK/facts/$name-$size"
+        if ! "$GENERATE" "${generator[@]}" "$size" "$facts"; then
+            echo "skipping $name of size $size: generating its facts failed" >&2
+            continue
+        fi
+        tuples=$(cat "$facts"/*.facts | wc -l)
+
+        for mode in ${MODES//,/ }; do
+            # the command of a run, lacking the number of threads
+            case $mode in
+                compiled)
+                    if [ ! -x "$WORK/$name" ] &&
+                            ! "$SOUFFLE" -o "$WORK/$name" "$program" >/dev/null 2>&1; then
+                        echo "skipping $name in mode $mode: compilation failed" >&2
+                        continue
+                    fi
+                    run=("$WORK/$name" -F "$facts" -D "$WORK/out")
+                    ;;
+                lvm | rami)
+                    interpreter=$(echo "$mode" | tr '[:lower:]' '[:upper:]')
+                    run=("$SOUFFLE" --interpreter="$interpreter" -F "$facts" -D "$WORK/out" "$program")
+                    ;;
+                *)
+                    echo "unknown mode $mode" >&2
+                    exit 1
+                    ;;
+            esac
+
+            for jobs in ${JOBS//,/ }; do
+                for ((i = 1; i <= RUNS; i++)); do
+                    if ! result=$(measure "${run[@]}" -j "$jobs"); then
+                        echo "$name of size $size failed in mode $mode with $jobs threads" >&2
+                        continue 2
+                    fi
+                    read -r wall rss <<< "$result"
+                    throughput=$(awk -v t="$tuples" -v w="$wall" 'BEGIN { printf "%.0f", w > 0 ? t / w : 0 }')
+                    record "$name" "$mode" "$size" "$jobs" "$i" facts "$tuples"
+                    record "$name" "$mode" "$size" "$jobs" "$i" wall "$wall"
+                    record "$name" "$mode" "$size" "$jobs" "$i" throughput "$throughput"
+                    [ -n "$rss" ] && record "$name" "$mode" "$size" "$jobs" "$i" rss "$rss"
+                done
+            done
+        done
+        rm -rf "$facts"
+    done
+done
+
+# write the record
+{
+    if [ "$FORMAT" = json ]; then
+        echo "["
+        for ((i = 0; i < ${#ROWS[@]}; i++)); do
+            IFS=, read -r program mode size jobs run measure value <<< "${ROWS[$i]}"
+            printf '  {"program": "%s", "mode": "%s", "size": %s, "jobs": %s, "run": %s, "measure": "%s", "value": %s}%s\n' \
+                    "$program" "$mode" "$size" "$jobs" "$run" "$measure" "$value" \
+                    "$([ $i -lt $((${#ROWS[@]} - 1)) ] && echo ,)"
+        done
+        echo "]"
+    else
+        echo "program,mode,size,jobs,run,measure,value"
+        for row in "${ROWS[@]}"; do
+            echo "$row"
+        done
+    fi
+} > "$OUTPUT"
@@ -0,0 +1,205 @@
+#!/bin/bash
+# Souffle - A Datalog Compiler
+# Copyright (c) 2019, The Souffle Developers. All rights reserved.
+# Licensed under the Universal Permissive License v 1.0 as shown at:
+# - https://opensource.org/licenses/UPL
+# - <souffle root>/licenses/SOUFFLE-UPL.txt
+
+# Runs the evaluation test programs in several evaluation modes and thread
+# counts, and records the wall time and peak memory of each run as well as
+# the time of each stratum of a profiled run. Two records can be compared to
+# find regressions.
+#
+# usage: benchmark.sh [-s souffle] [-p souffleprof] [-m modes] [-j jobs] [-r runs]
+#                     [-f csv|json] [-o file] [test...]
+#        benchmark.sh -c [-t threshold] baseline.csv current.csv
+#
+#   -s  souffle binary (src/souffle)
+#   -p  souffleprof binary recording the time of strata (src/souffleprof)
+#   -m  comma-separated evaluation modes: compiled, lvm and rami (lvm,rami)
+#   -j  comma-separated thread counts (1)
+#   -r  repetitions of each run (3)
+#   -f  output format (csv)
+#   -o  output file (standard output)
+#   -c  compare two csv records by the minimum of the runs of each measure
+#   -t  threshold in percent beyond which a change is reported (5)
+#
+# A record has a row for each measure: the wall time in seconds ("wall"),
+# the peak resident memory in kilobytes ("rss", requiring GNU time) and the
+# seconds of each stratum ("stratum-N"), the latter taken from one additional
+# profiled run.
+
+SOUFFLE=src/souffle
+SOUFFLEPROF=src/souffleprof
+MODES=lvm,rami
+JOBS=1
+RUNS=3
+FORMAT=csv
+OUTPUT=/dev/stdout
+COMPARE=0
+THRESHOLD=5
+
+while getopts "s:p:m:j:r:f:o:ct:" opt; do
+    case $opt in
+        s) SOUFFLE=$OPTARG ;;
+        p) SOUFFLEPROF=$OPTARG ;;
+        m) MODES=$OPTARG ;;
+        j) JOBS=$OPTARG ;;
+        r) RUNS=$OPTARG ;;
+        f) FORMAT=$OPTARG ;;
+        o) OUTPUT=$OPTARG ;;
+        c) COMPARE=1 ;;
+        t) THRESHOLD=$OPTARG ;;
+        *) sed -n '/^# usage/,/^$/p' "$0" >&2; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+# compares the best runs of two records, failing if a measure regressed
+if [ "$COMPARE" = 1 ]; then
+    if [ $# -ne 2 ]; then
+        echo "comparison requires a baseline and a current record" >&2
+        exit 1
+    fi
+    awk -F, -v threshold="$THRESHOLD" '
+        FNR == 1 { next }
+        {
+            key = $1 "," $2 "," $3 "," $5
+            if (FILENAME == ARGV[1]) {
+                if (!(key in base) || $6 < base[key]) base[key] = $6
+            } else {
+                if (!(key in cur) || $6 < cur[key]) cur[key] = $6
+                if (!(key in seen)) { seen[key] = 1; keys[n++] = key }
+            }
+        }
+        END {
+            printf "%-40s %-10s %5s %-12s %12s %12s %8s\n", "program", "mode", "jobs", "measure",
+                   "baseline", "current", "change"
+            regressions = 0
+            for (i = 0; i < n; i++) {
+                key = keys[i]
+                if (!(key in base)) continue
+                split(key, f, ",")
+                change = (base[key] > 0) ? 100 * (cur[key] - base[key]) / base[key] : 0
+                mark = ""
+                if (change > threshold) { mark = "  REGRESSION"; regressions++ }
+                else if (change < -threshold) mark = "  improvement"
+                printf "%-40s %-10s %5s %-12s %12s %12s %7.1f%%%s\n", f[1], f[2], f[3], f[4],
+                       base[key], cur[key], change, mark
+            }
+            printf "%d regressions beyond %s%%\n", regressions, threshold
+            exit (regressions > 0)
+        }' "$1" "$2"
+    exit $?
+fi
+
+if [ ! -x "$SOUFFLE" ]; then
+    echo "souffle binary $SOUFFLE not found" >&2
+    exit 1
+fi
+TESTS=$(dirname "$0")/../tests/evaluation
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# the programs given, or all evaluation tests
+PROGRAMS=("$@")
+if [ ${#PROGRAMS[@]} -eq 0 ]; then
+    for dir in "$TESTS"/*/; do
+        PROGRAMS+=("$(basename "$dir")")
+    done
+fi
+
+# records a measure of a run
+ROWS=()
+record() {
+    ROWS+=("$1,$2,$3,$4,$5,$6")
+}
+
+# runs a command, printing its wall time in seconds and its peak memory in kilobytes, the latter
+# only if GNU time is available
+measure() {
+    if [ -x /usr/bin/time ]; then
+        /usr/bin/time -f "%e %M" -o "$WORK/time" "$@" >/dev/null 2>&1 || return 1
+        cat "$WORK/time"
+    else
+        local start=$(date +%s.%N)
+        "$@" >/dev/null 2>&1 || return 1
+        local end=$(date +%s.%N)
+        awk -v start="$start" -v end="$end" 'BEGIN { printf "%.3f\n", end - start }'
+    fi
+}
+
+for name in "${PROGRAMS[@]}"; do
+    dir="$TESTS/$name"
+    program="$dir/$name.dl"
+    if [ ! -f "$program" ]; then
+        echo "skipping $name: no program" >&2
+        continue
+    fi
+    facts="$dir"
+    [ -d "$dir/facts" ] && facts="$dir/facts"
+    mkdir -p "$WORK/out"
+
+    for mode in ${MODES//,/ }; do
+        # the commands of a run without and with profiling, lacking the number of threads
+        case $mode in
+            compiled)
+                if ! "$SOUFFLE" -o "$WORK/$name" "$program" >/dev/null 2>&1 ||
+                        ! "$SOUFFLE" -o "$WORK/$name-prof" --profile="$WORK/unused" "$program" \
+                                >/dev/null 2>&1; then
+                    echo "skipping $name in mode $mode: compilation failed" >&2
+                    continue
+                fi
+                run=("$WORK/$name" -F "$facts" -D "$WORK/out")
+                profiled=("$WORK/$name-prof" -F "$facts" -D "$WORK/out" -p "$WORK/profile")
+                ;;
+            lvm | rami)
+                interpreter=$(echo "$mode" | tr '[:lower:]' '[:upper:]')
+                run=("$SOUFFLE" --interpreter="$interpreter" -F "$facts" -D "$WORK/out" "$program")
+                profiled=("${run[@]}" --profile="$WORK/profile")
+                ;;
+            *)
+                echo "unknown mode $mode" >&2
+                exit 1
+                ;;
+        esac
+
+        for jobs in ${JOBS//,/ }; do
+            for ((i = 1; i <= RUNS; i++)); do
+                if ! result=$(measure "${run[@]}" -j "$jobs"); then
+                    echo "$name failed in mode $mode with $jobs threads" >&2
+                    continue 2
+                fi
+                read -r wall rss <<< "$result"
+                record "$name" "$mode" "$jobs" "$i" wall "$wall"
+                [ -n "$rss" ] && record "$name" "$mode" "$jobs" "$i" rss "$rss"
+            done
+
+            rm -f "$WORK/profile"
+            if [ -x "$SOUFFLEPROF" ] && "${profiled[@]}" -j "$jobs" >/dev/null 2>&1; then
+                while read -r stratum time rest; do
+                    record "$name" "$mode" "$jobs" 1 "stratum-$stratum" "$time"
+                done < <("$SOUFFLEPROF" "$WORK/profile" -c strata | awk '$1 ~ /^[0-9]+$/')
+            fi
+        done
+    done
+done
+
+# write the record
+{
+    if [ "$FORMAT" = json ]; then
+        echo "["
+        for ((i = 0; i < ${#ROWS[@]}; i++)); do
+            IFS=, read -r program mode jobs run measure value <<< "${ROWS[$i]}"
+            printf '  {"program": "%s", "mode": "%s", "jobs": %s, "run": %s, "measure": "%s", "value": %s}%s\n' \
+                    "$program" "$mode" "$jobs" "$run" "$measure" "$value" \
+                    "$([ $i -lt $((${#ROWS[@]} - 1)) ] && echo ,)"
+        done
+        echo "]"
+    else
+        echo "program,mode,jobs,run,measure,value"
+        for row in "${ROWS[@]}"; do
+            echo "$row"
+        done
+    fi
+} > "$OUTPUT"
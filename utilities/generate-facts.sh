@@ -0,0 +1,163 @@
+#!/bin/bash
+# Souffle - A Datalog Compiler
+# Copyright (c) 2019, The Souffle Developers. All rights reserved.
+# Licensed under the Universal Permissive License v 1.0 as shown at:
+# - https://opensource.org/licenses/UPL
+# - <souffle root>/licenses/SOUFFLE-UPL.txt
+
+# Generates synthetic fact files of a given size for the scaling benchmarks
+# in tests/scaling. The same seed always produces the same facts.
+#
+# usage: generate-facts.sh [-r seed] [-d degree] [-k keys] [-l length] kind size directory
+#
+#   -r  seed of the random numbers (1)
+#   -d  edges added with each node of a graph (2)
+#   -k  distinct values of the join column of the join kind (size)
+#   -l  length of the strings and lists (16)
+#
+# kinds:
+#   graph     edge(x, y): a power-law graph of size nodes built by preferential
+#             attachment, each node linking to degree earlier nodes
+#   join      left(x, y), right(y, z): two relations of size tuples joining on
+#             y, which takes keys values, such that their join has about
+#             size * size / keys tuples
+#   strings   word(w), link(v, w): size words of the given length sharing
+#             prefixes, linked as a power-law graph
+#   lists     element(l, i, v): size elements of lists of the given length
+#   pointsto  alloc(v, h), assign(v, w), load(v, w, f), store(v, f, w): the
+#             statements of a program of size variables, assigned along a
+#             power-law graph
+#   cfg       next(p, q), def(p, v), use(p, v): a control-flow graph of size
+#             program points with branches and loops, each point defining and
+#             using variables at random
+
+SEED=1
+DEGREE=2
+KEYS=
+LENGTH=16
+
+while getopts "r:d:k:l:" opt; do
+    case $opt in
+        r) SEED=$OPTARG ;;
+        d) DEGREE=$OPTARG ;;
+        k) KEYS=$OPTARG ;;
+        l) LENGTH=$OPTARG ;;
+        *) sed -n '/^# usage/,/^$/p' "$0" >&2; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 3 ]; then
+    sed -n '/^# usage/,/^$/p' "$0" >&2
+    exit 1
+fi
+KIND=$1
+SIZE=$2
+DIR=$3
+mkdir -p "$DIR" || exit 1
+
+# runs the awk program of a kind, given the random numbers and the preferential attachment
+generate() {
+    awk -v seed="$SEED" -v degree="$DEGREE" -v keys="${KEYS:-$SIZE}" -v len="$LENGTH" \
+            -v size="$SIZE" -v dir="$DIR" '
+        function random(n) { return int(rand() * n) }
+        # adds the edges from node n to degree earlier nodes, each picked with a probability
+        # proportional to its degree, as edges from source[i] to target[i]
+        function attach(n,    i, t) {
+            for (i = 0; i < degree && i < n; i++) {
+                t = (ends > 0 && rand() < 0.9) ? end[random(ends)] : random(n)
+                source[edges] = n
+                target[edges] = t
+                end[ends] = t
+                edges++
+                ends++
+            }
+            for (i = 0; i < degree && i < n; i++) {
+                end[ends] = n
+                ends++
+            }
+        }
+        BEGIN { srand(seed); edges = 0; ends = 0 }
+        '"$1"
+}
+
+case $KIND in
+    graph)
+        generate '
+        BEGIN {
+            for (n = 0; n < size; n++) attach(n)
+            for (i = 0; i < edges; i++) printf "%d\t%d\n", source[i], target[i] > (dir "/edge.facts")
+        }'
+        ;;
+    join)
+        generate '
+        BEGIN {
+            for (i = 0; i < size; i++) {
+                printf "%d\t%d\n", i, random(keys) > (dir "/left.facts")
+                printf "%d\t%d\n", random(keys), i > (dir "/right.facts")
+            }
+        }'
+        ;;
+    strings)
+        generate '
+        # a word of the given length whose prefix is one of few, such that words share prefixes
+        function word(n,    s, i) {
+            s = sprintf("p%03d_", random(int(sqrt(size)) + 1))
+            for (i = length(s); i < len; i++) {
+                s = s substr("abcdefghijklmnopqrstuvwxyz", random(26) + 1, 1)
+            }
+            return s "_" n
+        }
+        BEGIN {
+            for (n = 0; n < size; n++) {
+                words[n] = word(n)
+                print words[n] > (dir "/word.facts")
+            }
+            for (n = 0; n < size; n++) attach(n)
+            for (i = 0; i < edges; i++) {
+                printf "%s\t%s\n", words[source[i]], words[target[i]] > (dir "/link.facts")
+            }
+        }'
+        ;;
+    lists)
+        generate '
+        BEGIN {
+            for (i = 0; i < size; i++) {
+                printf "%d\t%d\t%d\n", int(i / len), i % len, random(1000) > (dir "/element.facts")
+            }
+        }'
+        ;;
+    pointsto)
+        generate '
+        BEGIN {
+            fields = 8
+            for (h = 0; h < size / 4; h++) printf "%d\t%d\n", random(size), h > (dir "/alloc.facts")
+            for (n = 0; n < size; n++) attach(n)
+            for (i = 0; i < edges; i++) printf "%d\t%d\n", source[i], target[i] > (dir "/assign.facts")
+            for (i = 0; i < size / 4; i++) {
+                printf "%d\t%d\t%d\n", random(size), random(size), random(fields) > (dir "/load.facts")
+                printf "%d\t%d\t%d\n", random(size), random(fields), random(size) > (dir "/store.facts")
+            }
+        }'
+        ;;
+    cfg)
+        generate '
+        BEGIN {
+            variables = size / 64 + 16
+            for (p = 0; p < size; p++) {
+                # blocks of about eight points end in a branch forwards or a loop backwards
+                if (p + 1 < size) printf "%d\t%d\n", p, p + 1 > (dir "/next.facts")
+                if (p % 8 == 7) {
+                    q = (rand() < 0.8) ? p + 2 + random(64) : p - random(64)
+                    if (q >= 0 && q < size) printf "%d\t%d\n", p, q > (dir "/next.facts")
+                }
+                if (rand() < 0.5) printf "%d\t%d\n", p, random(variables) > (dir "/def.facts")
+                if (rand() < 0.5) printf "%d\t%d\n", p, random(variables) > (dir "/use.facts")
+            }
+        }'
+        ;;
+    *)
+        echo "unknown kind $KIND" >&2
+        exit 1
+        ;;
+esac